@@ -32,7 +32,7 @@
  * compatible, thus CINDEX_VERSION_MAJOR is expected to remain stable.
  */
 #define CINDEX_VERSION_MAJOR 0
-#define CINDEX_VERSION_MINOR 37
+#define CINDEX_VERSION_MINOR 44
 
 #define CINDEX_VERSION_ENCODE(major, minor) ( \
       ((major) * 10000)                       \
@@ -274,6 +274,23 @@ CINDEX_LINKAGE void clang_CXIndex_setGlobalOptions(CXIndex, unsigned options);
  */
 CINDEX_LINKAGE unsigned clang_CXIndex_getGlobalOptions(CXIndex);
 
+/**
+ * \brief Sets the directory in which the precompiled preambles of the
+ * translation units parsed with \c CXTranslationUnit_PrecompiledPreamble are
+ * cached.
+ *
+ * A translation unit parsed with the same command line, from the same working
+ * directory, reuses the precompiled preamble that another translation unit,
+ * possibly in another process, stored in the directory, as long as the files
+ * of the preamble have not changed. Preambles that depend on unsaved files
+ * other than the main file, or that produce diagnostics, are not cached.
+ *
+ * \param Path The cache directory, which is created if needed. Pass NULL to
+ * stop caching the preambles of the translation units parsed afterwards.
+ */
+CINDEX_LINKAGE void clang_CXIndex_setPreambleCacheDirectory(CXIndex,
+                                                            const char *Path);
+
 /**
  * \defgroup CINDEX_FILES File manipulation routines
  *
@@ -1228,7 +1245,17 @@ enum CXTranslationUnit_Flags {
    * purposes of an IDE, this is undesirable behavior and as much information
    * as possible should be reported. Use this flag to enable this behavior.
    */
-  CXTranslationUnit_KeepGoing = 0x200
+  CXTranslationUnit_KeepGoing = 0x200,
+
+  /**
+   * \brief Used to indicate that the bodies of the functions outside the main
+   * file should be skipped while parsing.
+   *
+   * Unlike CXTranslationUnit_SkipFunctionBodies, the bodies in the main file
+   * and those needed to check it, such as the bodies of constexpr functions
+   * and templates, are still parsed.
+   */
+  CXTranslationUnit_SkipFunctionBodiesOutsideMainFile = 0x400
 };
 
 /**
@@ -1487,6 +1514,28 @@ CINDEX_LINKAGE int clang_reparseTranslationUnit(CXTranslationUnit TU,
                                           struct CXUnsavedFile *unsaved_files,
                                                 unsigned options);
 
+/**
+ * \brief Bound the memory used by the function bodies of a translation unit.
+ *
+ * Once the AST of \p TU uses more than \p budget bytes, the following calls
+ * to \c clang_reparseTranslationUnit() skip the bodies of the functions of
+ * the main file that are declared outside the file offsets
+ * [\p visible_begin, \p visible_end), keeping their declarations, so that
+ * the memory used scales with the part of the file shown to the user. After
+ * the visible range moves, reparsing makes the bodies that came into view
+ * available to cursors again.
+ *
+ * \param budget The number of bytes, or 0 to parse every body again.
+ *
+ * \returns 0 on success, or a non-zero \c CXErrorCode if \p TU is invalid or
+ * the range is empty.
+ */
+CINDEX_LINKAGE int
+clang_setTranslationUnitMemoryBudget(CXTranslationUnit TU,
+                                     unsigned long long budget,
+                                     unsigned visible_begin,
+                                     unsigned visible_end);
+
 /**
   * \brief Categorizes how memory is being used by a translation unit.
   */
@@ -3772,6 +3821,69 @@ CINDEX_LINKAGE unsigned clang_visitChildrenWithBlock(CXCursor parent,
 #  endif
 #endif
 
+/**
+ * \brief A cursor found by clang_visitChildrenBuffered().
+ */
+typedef struct {
+  /**
+   * \brief The cursor.
+   */
+  CXCursor cursor;
+
+  /**
+   * \brief The position in the traversal of the record of the parent cursor,
+   * or ~0U if the parent is the cursor whose children are visited.
+   */
+  unsigned parent;
+
+  /**
+   * \brief The extent of the cursor, as returned by clang_getCursorExtent().
+   */
+  CXSourceRange extent;
+} CXCursorRecord;
+
+/**
+ * \brief Visitor invoked by clang_visitChildrenBuffered() with the records of
+ * the cursors found by the traversal.
+ *
+ * The visitor should return a non-zero value to end the traversal.
+ */
+typedef unsigned (*CXCursorRecordsVisitor)(const CXCursorRecord *records,
+                                           unsigned num_records,
+                                           CXClientData client_data);
+
+/**
+ * \brief Visit all the descendants of a particular cursor, in depth-first
+ * order, through a buffer of records.
+ *
+ * This visits the same cursors as clang_visitChildren() with a visitor that
+ * always returns \c CXChildVisit_Recurse, but invokes \p visitor only each
+ * time \p records is full and once at the end of the traversal, so that the
+ * cost of a call from the library into the client is paid once per buffer
+ * rather than once per cursor.
+ *
+ * \param parent the cursor whose descendants are visited.
+ *
+ * \param records a buffer of \p num_records records, owned by the client, that
+ * is filled with the records of the cursors found by the traversal. Its
+ * contents are only valid during the call to \p visitor.
+ *
+ * \param num_records the number of records in \p records, which must be
+ * non-zero.
+ *
+ * \param visitor the visitor invoked with the filled records.
+ *
+ * \param client_data pointer data supplied by the client, which will
+ * be passed to the visitor each time it is invoked.
+ *
+ * \returns a non-zero value if the traversal was ended by the visitor.
+ */
+CINDEX_LINKAGE unsigned
+clang_visitChildrenBuffered(CXCursor parent, CXCursorRecord *records,
+                            unsigned num_records,
+                            CXCursorRecordsVisitor visitor,
+                            CXClientData client_data);
+
 /**
  * @}
  */
@@ -5111,6 +5223,38 @@ CXCodeCompleteResults *clang_codeCompleteAt(CXTranslationUnit TU,
                                             unsigned num_unsaved_files,
                                             unsigned options);
 
+/**
+ * \brief Perform code completion at a given location in a translation unit,
+ * keeping only the best results that match the text typed so far.
+ *
+ * This function behaves as \c clang_codeCompleteAt(), except that the
+ * results are filtered and ranked before their completion strings are
+ * created, which avoids the cost of creating and returning the results that
+ * the client would discard.
+ *
+ * \param filter If non-NULL, the text typed so far. Only the results whose
+ * typed text starts with \p filter, ignoring case, or contains the characters
+ * of \p filter in order are kept. The results that start with the filter
+ * are ranked before the others.
+ *
+ * \param max_results If non-zero, the maximum number of results to keep.
+ *
+ * When either a filter or a maximum number of results is given, the results
+ * are ordered from best to worst: by how well they match the filter, then by
+ * priority, then alphabetically. Overload candidates are never filtered.
+ *
+ * The other parameters and the return value are the same as for
+ * \c clang_codeCompleteAt().
+ */
+CINDEX_LINKAGE
+CXCodeCompleteResults *
+clang_codeCompleteAtWithFilter(CXTranslationUnit TU,
+                               const char *complete_filename,
+                               unsigned complete_line, unsigned complete_column,
+                               struct CXUnsavedFile *unsaved_files,
+                               unsigned num_unsaved_files, unsigned options,
+                               const char *filter, unsigned max_results);
+
 /**
  * \brief Sort the code-completion results in case-insensitive alphabetical 
  * order.
@@ -5904,6 +6048,24 @@ CINDEX_LINKAGE CXIndexAction clang_IndexAction_create(CXIndex CIdx);
  */
 CINDEX_LINKAGE void clang_IndexAction_dispose(CXIndexAction);
 
+/**
+ * \brief Record the function bodies parsed by the given index action in a
+ * file, so that later index actions using the same file skip them too.
+ *
+ * With \c CXIndexOpt_SkipParsedBodiesInSession, an index action skips the
+ * bodies that it already parsed for a previous translation unit. This makes
+ * the action also skip the bodies recorded in \p path by the actions that
+ * used it before, and records the bodies it parses there when it is disposed.
+ * A body is identified by its file, the modification time of the file, and
+ * the preprocessor conditional region it is in.
+ *
+ * \returns 0 on success, or a non-zero \c CXErrorCode if the arguments are
+ * invalid. A file that does not exist yet or cannot be read is treated as
+ * empty.
+ */
+CINDEX_LINKAGE int clang_IndexAction_setParsedBodiesFile(CXIndexAction,
+                                                         const char *path);
+
 typedef enum {
   /**
    * \brief Used to indicate that no special indexing options are needed.
@@ -5993,6 +6155,46 @@ CINDEX_LINKAGE int clang_indexSourceFileFullArgv(
     int num_command_line_args, struct CXUnsavedFile *unsaved_files,
     unsigned num_unsaved_files, CXTranslationUnit *out_TU, unsigned TU_options);
 
+/**
+ * \brief Index a batch of source files on a pool of worker threads, via
+ * callbacks implemented through #IndexerCallbacks.
+ *
+ * Each source file is indexed as by #clang_indexSourceFileFullArgv, with the
+ * source file given as part of its command line. All the files are indexed
+ * in the same session of the \c CXIndexAction, so with
+ * \c CXIndexOpt_SkipParsedBodiesInSession the bodies in the headers shared by
+ * the files of the batch are parsed and indexed once.
+ *
+ * The callbacks for different files may be invoked concurrently from
+ * different threads; the callbacks for one file are invoked from a single
+ * thread, in the same order as for #clang_indexSourceFile.
+ *
+ * \param client_data an array of \c num_files client data pointers; the
+ * callbacks invoked while indexing the i'th file receive \c client_data[i].
+ *
+ * \param command_lines an array of \c num_files full command lines, including
+ * argv[0]. The \c i'th command line has \c num_command_line_args[i]
+ * arguments.
+ *
+ * \param num_threads the maximum number of files indexed at the same time, or
+ * 0 to use the number of hardware threads.
+ *
+ * \param[out] results if non-null, an array of \c num_files elements that
+ * receives the result of indexing each file.
+ *
+ * \returns 0 if every file was indexed successfully or with errors from which
+ * the compiler could recover, otherwise the non-zero result of the first file
+ * of the batch that failed.
+ *
+ * The other parameters are the same as #clang_indexSourceFile.
+ */
+CINDEX_LINKAGE int clang_indexSourceFiles(
+    CXIndexAction, CXClientData *client_data, IndexerCallbacks *index_callbacks,
+    unsigned index_callbacks_size, unsigned index_options,
+    const char *const *const *command_lines, const int *num_command_line_args,
+    unsigned num_files, unsigned num_threads, unsigned TU_options,
+    int *results);
+
 /**
  * \brief Index the given translation unit via callbacks implemented through
  * #IndexerCallbacks.
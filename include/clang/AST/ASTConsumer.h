@@ -82,6 +82,12 @@ public:
   /// HandleTopLevelDecl.
   virtual void HandleCXXImplicitFunctionInstantiation(FunctionDecl *D) {}
 
+  /// \brief Invoked at the end of the translation unit, right before the
+  /// pending implicit instantiations are performed. No declaration written by
+  /// the user follows, so the instantiated definitions then passed to
+  /// HandleTopLevelDecl can no longer change linkage.
+  virtual void HandlePendingInstantiations() {}
+
   /// \brief Handle the specified top-level declaration that occurred inside
   /// and ObjC container.
   /// The default implementation ignored them.
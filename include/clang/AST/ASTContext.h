@@ -28,6 +28,7 @@
 #include "clang/AST/TemplateBase.h"
 #include "clang/AST/TemplateName.h"
 #include "clang/AST/Type.h"
+#include "clang/AST/TypeOrdering.h"
 #include "clang/Basic/AddressSpaces.h"
 #include "clang/Basic/IdentifierTable.h"
 #include "clang/Basic/LangOptions.h"
@@ -82,6 +83,7 @@ class ASTRecordLayout;
 class AtomicExpr;
 class BlockExpr;
 class CharUnits;
+class ConstexprBytecode;
 class CXXABI;
 class DiagnosticsEngine;
 class Expr;
@@ -129,11 +131,17 @@ class ASTContext : public RefCountedBase<ASTContext> {
   mutable SmallVector<Type *, 0> Types;
   mutable llvm::FoldingSet<ExtQuals> ExtQualNodes;
   mutable llvm::FoldingSet<ComplexType> ComplexTypes;
-  mutable llvm::FoldingSet<PointerType> PointerTypes;
+  /// The pointer and reference types, keyed by their pointee as written.
+  ///
+  /// These are the most frequently requested composite types, and their
+  /// pointee is the whole of their profile, so a DenseMap finds them without
+  /// building and hashing a FoldingSetNodeID.
+  mutable llvm::DenseMap<QualType, PointerType *> PointerTypes;
   mutable llvm::FoldingSet<AdjustedType> AdjustedTypes;
   mutable llvm::FoldingSet<BlockPointerType> BlockPointerTypes;
-  mutable llvm::FoldingSet<LValueReferenceType> LValueReferenceTypes;
-  mutable llvm::FoldingSet<RValueReferenceType> RValueReferenceTypes;
+  mutable llvm::DenseMap<std::pair<QualType, unsigned>,
+                         LValueReferenceType *> LValueReferenceTypes;
+  mutable llvm::DenseMap<QualType, RValueReferenceType *> RValueReferenceTypes;
   mutable llvm::FoldingSet<MemberPointerType> MemberPointerTypes;
   mutable llvm::FoldingSet<ConstantArrayType> ConstantArrayTypes;
   mutable llvm::FoldingSet<IncompleteArrayType> IncompleteArrayTypes;
@@ -222,6 +230,21 @@ class ASTContext : public RefCountedBase<ASTContext> {
   llvm::DenseMap<const MaterializeTemporaryExpr *, APValue *>
     MaterializedTemporaryValues;
 
+public:
+  /// \brief The memoized result of a call to a constexpr function, with the
+  /// number of evaluation steps and the call depth it took to compute.
+  struct ConstexprCallResult {
+    APValue Value;
+    unsigned Steps;
+    unsigned Depth;
+  };
+
+private:
+  /// \brief The results of calls to constexpr functions that did not depend
+  /// on the state of their caller, keyed by an encoding of their arguments.
+  llvm::DenseMap<const FunctionDecl *, llvm::StringMap<ConstexprCallResult>>
+    ConstexprCallResults;
+
   /// \brief Representation of a "canonical" template template parameter that
   /// is used in canonical template names.
   class CanonicalTemplateTemplateParm : public llvm::FoldingSetNode {
@@ -485,6 +508,9 @@ private:
   std::unique_ptr<CXXABI> ABI;
   CXXABI *createCXXABI(const TargetInfo &T);
 
+  /// \brief The bytecode of the constexpr functions, created on first use.
+  std::unique_ptr<ConstexprBytecode> Bytecode;
+
   /// \brief The logical -> physical address space map.
   const LangAS::Map *AddrSpaceMap;
 
@@ -587,7 +613,8 @@ public:
   /// the AST, which also avoids touching large parts of the AST.
   /// Additionally, we will want to add an interface to already give a hint
   /// where to search for the parents, for example when looking at a statement
-  /// inside a certain function.
+  /// inside a certain function. \c setParentMapScope() is a first step in
+  /// that direction.
   ///
   /// 'NodeT' can be one of Decl, Stmt, Type, TypeLoc,
   /// NestedNameSpecifier or NestedNameSpecifierLoc.
@@ -597,6 +624,23 @@ public:
 
   DynTypedNodeList getParents(const ast_type_traits::DynTypedNode &Node);
 
+  /// \brief Makes getParents() look for parents in the subtree of \p Root
+  /// first, instead of building the parent map of the whole translation unit.
+  ///
+  /// \p Root is usually a top-level declaration. The map of its subtree is
+  /// built on the first query and dropped when the scope changes, so that
+  /// visiting the translation unit one declaration at a time only holds the
+  /// parents of one declaration in memory. The parents of \p Root itself are
+  /// its lexical context; nodes outside the subtree still get their parents
+  /// from the map of the whole translation unit, which is then built as usual.
+  /// Passing null ends the scope.
+  ///
+  /// While a scope is set, a statement shared between a template and its
+  /// instantiation in another top-level declaration only reports the parents
+  /// it has under \p Root. The lists returned by getParents() in a scope are
+  /// invalidated when the scope changes.
+  void setParentMapScope(const Decl *Root);
+
   const clang::PrintingPolicy &getPrintingPolicy() const {
     return PrintingPolicy;
   }
@@ -2528,6 +2572,17 @@ public:
   APValue *getMaterializedTemporaryValue(const MaterializeTemporaryExpr *E,
                                          bool MayCreate);
 
+  /// \brief Get the memoized results of calls to the constexpr function
+  /// \p FD, keyed by an encoding of the evaluation mode and the arguments.
+  llvm::StringMap<ConstexprCallResult> &
+  getConstexprCallResults(const FunctionDecl *FD) {
+    return ConstexprCallResults[FD->getCanonicalDecl()];
+  }
+
+  /// \brief Get the bytecode interpreter used for constexpr calls with
+  /// -fexperimental-constexpr-interpreter.
+  ConstexprBytecode &getConstexprBytecode();
+
   //===--------------------------------------------------------------------===//
   //                    Statistics
   //===--------------------------------------------------------------------===//
@@ -2573,6 +2628,13 @@ public:
   /// \brief The number of implicitly-declared destructors for which 
   /// declarations were built.
   static unsigned NumImplicitDestructorsDeclared;
+
+  /// \brief The number of constexpr calls looked up in the call cache.
+  static unsigned NumConstexprCallLookups;
+
+  /// \brief The number of constexpr calls whose result was found in the call
+  /// cache.
+  static unsigned NumConstexprCallCacheHits;
   
 public:
   /// \brief Initialize built-in types.
@@ -2660,6 +2722,14 @@ private:
   std::unique_ptr<ParentMapPointers> PointerParents;
   std::unique_ptr<ParentMapOtherNodes> OtherParents;
 
+  /// \brief The root of the subtree set by setParentMapScope(), if any.
+  const Decl *ParentMapScope = nullptr;
+
+  /// \brief The parent maps of the subtree of \c ParentMapScope, built on
+  /// the first query in that scope.
+  std::unique_ptr<ParentMapPointers> ScopedPointerParents;
+  std::unique_ptr<ParentMapOtherNodes> ScopedOtherParents;
+
   std::unique_ptr<VTableContextBase> VTContext;
 
 public:
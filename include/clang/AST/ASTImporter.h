@@ -30,7 +30,9 @@ namespace clang {
   class DiagnosticsEngine;
   class Expr;
   class FileManager;
+  class FunctionDecl;
   class IdentifierInfo;
+  class NamedDecl;
   class NestedNameSpecifier;
   class Stmt;
   class TypeSourceInfo;
@@ -55,6 +57,14 @@ namespace clang {
 
     /// \brief Whether the last diagnostic came from the "from" context.
     bool LastDiagFromFrom;
+
+    /// \brief Whether to index the "to" declaration contexts by name rather
+    /// than walk them on every lookup that misses their lookup table.
+    bool IndexedLookup = false;
+
+    /// \brief Whether to defer importing the bodies of functions until
+    /// ImportFunctionBody asks for them.
+    bool LazyFunctionBodies = false;
     
     /// \brief Mapping from the already-imported types in the "from" context
     /// to the corresponding types in the "to" context.
@@ -84,6 +94,19 @@ namespace clang {
     /// \brief Declaration (from, to) pairs that are known not to be equivalent
     /// (which we have already complained about).
     NonEquivalentDeclSet NonEquivalentDecls;
+
+    /// \brief The last declaration indexed in each "to" declaration context
+    /// when the lookup is indexed.
+    llvm::DenseMap<DeclContext *, Decl *> IndexedUpTo;
+
+    /// \brief The declarations of each name in the indexed "to" declaration
+    /// contexts.
+    llvm::DenseMap<std::pair<DeclContext *, DeclarationName>,
+                   SmallVector<NamedDecl *, 2>> IndexedDecls;
+
+    /// \brief Mapping from the imported functions whose body was deferred to
+    /// the functions in the "from" context that have the body.
+    llvm::DenseMap<FunctionDecl *, FunctionDecl *> PendingFunctionBodies;
     
   public:
     /// \brief Create a new AST importer.
@@ -108,6 +131,22 @@ namespace clang {
     /// \brief Whether the importer will perform a minimal import, creating
     /// to-be-completed forward declarations when possible.
     bool isMinimalImport() const { return Minimal; }
+
+    /// \brief Index the "to" declaration contexts by name for the lookups
+    /// that would otherwise walk all of their declarations.
+    ///
+    /// This makes importing many translation units that share headers
+    /// linear rather than quadratic. Declarations must not be removed from
+    /// the "to" context while the lookup is indexed.
+    void setIndexedLookup(bool Indexed) { IndexedLookup = Indexed; }
+
+    /// \brief Defer importing the bodies of functions until
+    /// ImportFunctionBody is called for them, so that tools which only look
+    /// at a few of the imported functions do not pay for the rest.
+    void setLazyFunctionBodies(bool Lazy) { LazyFunctionBodies = Lazy; }
+
+    /// \brief Whether the bodies of functions are imported on demand.
+    bool hasLazyFunctionBodies() const { return LazyFunctionBodies; }
     
     /// \brief Import the given type from the "from" context into the "to"
     /// context.
@@ -227,6 +266,25 @@ namespace clang {
     /// "to" context.
     CXXBaseSpecifier *Import(const CXXBaseSpecifier *FromSpec);
 
+    /// \brief Import the body of the given function in the "to" context, if
+    /// its import was deferred.
+    ///
+    /// \returns the body of the function in the "to" context, or NULL if it
+    /// has none or an error occurred.
+    Stmt *ImportFunctionBody(FunctionDecl *ToFD);
+
+    /// \brief Note that the body of \p From was not imported into \p To, so
+    /// that ImportFunctionBody can import it later.
+    void DeferFunctionBody(FunctionDecl *From, FunctionDecl *To) {
+      PendingFunctionBodies[To] = From;
+    }
+
+    /// \brief Find the declarations of the given name in the given
+    /// declaration context of the "to" context, without loading any of its
+    /// external declarations.
+    void findDeclsInToContext(DeclContext *DC, DeclarationName Name,
+                              SmallVectorImpl<NamedDecl *> &Results);
+
     /// \brief Import the definition of the given declaration, including all of
     /// the declarations it contains.
     ///
@@ -1828,7 +1828,8 @@ private:
   friend class DependentDiagnostic;
   StoredDeclsMap *CreateStoredDeclsMap(ASTContext &C) const;
 
-  void buildLookupImpl(DeclContext *DCtx, bool Internal);
+  void buildLookupImpl(DeclContext *DCtx, bool Internal,
+                       Decl *End = nullptr);
   void makeDeclVisibleInContextWithFlags(NamedDecl *D, bool Internal,
                                          bool Rediscoverable);
   void makeDeclVisibleInContextImpl(NamedDecl *D, bool Internal);
@@ -458,6 +458,13 @@ class CXXRecordDecl : public RecordDecl {
     /// \brief Whether we are currently parsing base specifiers.
     unsigned IsParsingBaseSpecifiers : 1;
 
+    /// \brief Whether ODRHash has been computed or read.
+    unsigned HasODRHash : 1;
+
+    /// \brief The hash of the members and bases of this class, if
+    /// HasODRHash.
+    unsigned ODRHash;
+
     /// \brief The number of base class specifiers in Bases.
     unsigned NumBases;
 
@@ -798,6 +805,15 @@ public:
     return data().FirstFriend.isValid();
   }
 
+  /// \brief Returns a hash of the explicitly declared members and the bases
+  /// of the definition of this class.
+  ///
+  /// The hash only depends on the names, kinds and types of the members, so
+  /// definitions of the class from different modules that the ODR makes the
+  /// same have the same hash. It is computed once per definition and stored
+  /// in the module file.
+  unsigned getODRHash() const;
+
   /// \brief \c true if we know for sure that this class has a single,
   /// accessible, unambiguous move constructor that is not deleted.
   bool hasSimpleMoveConstructor() const {
@@ -2350,32 +2350,15 @@ class MemberExpr final
   /// This is the location of the -> or . in the expression.
   SourceLocation OperatorLoc;
 
-  /// IsArrow - True if this is "X->F", false if this is "X.F".
-  bool IsArrow : 1;
-
-  /// \brief True if this member expression used a nested-name-specifier to
-  /// refer to the member, e.g., "x->Base::f", or found its member via a using
-  /// declaration.  When true, a MemberExprNameQualifier
-  /// structure is allocated immediately after the MemberExpr.
-  bool HasQualifierOrFoundDecl : 1;
-
-  /// \brief True if this member expression specified a template keyword
-  /// and/or a template argument list explicitly, e.g., x->f<int>,
-  /// x->template f, x->template f<int>.
-  /// When true, an ASTTemplateKWAndArgsInfo structure and its
-  /// TemplateArguments (if any) are present.
-  bool HasTemplateKWAndArgsInfo : 1;
-
-  /// \brief True if this member expression refers to a method that
-  /// was resolved from an overloaded set having size greater than 1.
-  bool HadMultipleCandidates : 1;
+  // The flags of the member expression are kept in MemberExprBits, so that
+  // the expression ends with the two locations and needs no padding.
 
   size_t numTrailingObjects(OverloadToken<MemberExprNameQualifier>) const {
-    return HasQualifierOrFoundDecl ? 1 : 0;
+    return MemberExprBits.HasQualifierOrFoundDecl ? 1 : 0;
   }
 
   size_t numTrailingObjects(OverloadToken<ASTTemplateKWAndArgsInfo>) const {
-    return HasTemplateKWAndArgsInfo ? 1 : 0;
+    return MemberExprBits.HasTemplateKWAndArgsInfo ? 1 : 0;
   }
 
 public:
@@ -2386,10 +2369,16 @@ public:
              base->isValueDependent(), base->isInstantiationDependent(),
              base->containsUnexpandedParameterPack()),
         Base(base), MemberDecl(memberdecl), MemberDNLoc(NameInfo.getInfo()),
-        MemberLoc(NameInfo.getLoc()), OperatorLoc(operatorloc),
-        IsArrow(isarrow), HasQualifierOrFoundDecl(false),
-        HasTemplateKWAndArgsInfo(false), HadMultipleCandidates(false) {
+        MemberLoc(NameInfo.getLoc()), OperatorLoc(operatorloc) {
     assert(memberdecl->getDeclName() == NameInfo.getName());
+    static_assert(sizeof(MemberExpr) == sizeof(Expr) + 2 * sizeof(void *) +
+                                            sizeof(DeclarationNameLoc) +
+                                            2 * sizeof(SourceLocation),
+                  "MemberExpr too big");
+    MemberExprBits.IsArrow = isarrow;
+    MemberExprBits.HasQualifierOrFoundDecl = false;
+    MemberExprBits.HasTemplateKWAndArgsInfo = false;
+    MemberExprBits.HadMultipleCandidates = false;
   }
 
   // NOTE: this constructor should be used only when it is known that
@@ -2403,9 +2392,12 @@ public:
              base->isValueDependent(), base->isInstantiationDependent(),
              base->containsUnexpandedParameterPack()),
         Base(base), MemberDecl(memberdecl), MemberDNLoc(), MemberLoc(l),
-        OperatorLoc(operatorloc), IsArrow(isarrow),
-        HasQualifierOrFoundDecl(false), HasTemplateKWAndArgsInfo(false),
-        HadMultipleCandidates(false) {}
+        OperatorLoc(operatorloc) {
+    MemberExprBits.IsArrow = isarrow;
+    MemberExprBits.HasQualifierOrFoundDecl = false;
+    MemberExprBits.HasTemplateKWAndArgsInfo = false;
+    MemberExprBits.HadMultipleCandidates = false;
+  }
 
   static MemberExpr *Create(const ASTContext &C, Expr *base, bool isarrow,
                             SourceLocation OperatorLoc,
@@ -2428,7 +2420,7 @@ public:
 
   /// \brief Retrieves the declaration found by lookup.
   DeclAccessPair getFoundDecl() const {
-    if (!HasQualifierOrFoundDecl)
+    if (!MemberExprBits.HasQualifierOrFoundDecl)
       return DeclAccessPair::make(getMemberDecl(),
                                   getMemberDecl()->getAccess());
     return getTrailingObjects<MemberExprNameQualifier>()->FoundDecl;
@@ -2443,7 +2435,7 @@ public:
   /// nested-name-specifier that precedes the member name, with source-location
   /// information.
   NestedNameSpecifierLoc getQualifierLoc() const {
-    if (!HasQualifierOrFoundDecl)
+    if (!MemberExprBits.HasQualifierOrFoundDecl)
       return NestedNameSpecifierLoc();
 
     return getTrailingObjects<MemberExprNameQualifier>()->QualifierLoc;
@@ -2459,21 +2451,21 @@ public:
   /// \brief Retrieve the location of the template keyword preceding
   /// the member name, if any.
   SourceLocation getTemplateKeywordLoc() const {
-    if (!HasTemplateKWAndArgsInfo) return SourceLocation();
+    if (!MemberExprBits.HasTemplateKWAndArgsInfo) return SourceLocation();
     return getTrailingObjects<ASTTemplateKWAndArgsInfo>()->TemplateKWLoc;
   }
 
   /// \brief Retrieve the location of the left angle bracket starting the
   /// explicit template argument list following the member name, if any.
   SourceLocation getLAngleLoc() const {
-    if (!HasTemplateKWAndArgsInfo) return SourceLocation();
+    if (!MemberExprBits.HasTemplateKWAndArgsInfo) return SourceLocation();
     return getTrailingObjects<ASTTemplateKWAndArgsInfo>()->LAngleLoc;
   }
 
   /// \brief Retrieve the location of the right angle bracket ending the
   /// explicit template argument list following the member name, if any.
   SourceLocation getRAngleLoc() const {
-    if (!HasTemplateKWAndArgsInfo) return SourceLocation();
+    if (!MemberExprBits.HasTemplateKWAndArgsInfo) return SourceLocation();
     return getTrailingObjects<ASTTemplateKWAndArgsInfo>()->RAngleLoc;
   }
 
@@ -2522,8 +2514,8 @@ public:
 
   SourceLocation getOperatorLoc() const LLVM_READONLY { return OperatorLoc; }
 
-  bool isArrow() const { return IsArrow; }
-  void setArrow(bool A) { IsArrow = A; }
+  bool isArrow() const { return MemberExprBits.IsArrow; }
+  void setArrow(bool A) { MemberExprBits.IsArrow = A; }
 
   /// getMemberLoc - Return the location of the "member", in X->F, it is the
   /// location of 'F'.
@@ -2543,13 +2535,13 @@ public:
   /// \brief Returns true if this member expression refers to a method that
   /// was resolved from an overloaded set having size greater than 1.
   bool hadMultipleCandidates() const {
-    return HadMultipleCandidates;
+    return MemberExprBits.HadMultipleCandidates;
   }
   /// \brief Sets the flag telling whether this expression refers to
   /// a method that was resolved from an overloaded set having size
   /// greater than 1.
   void setHadMultipleCandidates(bool V = true) {
-    HadMultipleCandidates = V;
+    MemberExprBits.HadMultipleCandidates = V;
   }
 
   /// \brief Returns true if virtual dispatch is performed.
@@ -3959,6 +3951,90 @@ public:
   friend class ASTStmtWriter;
 };
 
+/// \brief Represents a long initializer list of integer or floating-point
+/// literals that initializes an array of numbers, e.g. a lookup table or an
+/// embedded file:
+///
+/// \code
+/// const unsigned char Asset[] = { 0x12, 0x34, 0x56, /* ... */ };
+/// \endcode
+///
+/// It replaces the semantic form of the initializer list, which would hold
+/// a converted expression per element. The values of the initialized
+/// elements are stored in a packed buffer instead, and the initializer list
+/// as written is kept as the syntactic form. The elements past the values
+/// are zero-initialized.
+class CompactArrayInitExpr : public Expr {
+  /// \brief The initializer list as written.
+  InitListExpr *SyntacticForm;
+
+  /// \brief The values of the initialized elements, with
+  /// \c ElementByteWidth bytes per element in the byte order of the host.
+  /// Floating-point values are stored as their bit patterns.
+  char *Data;
+  unsigned NumElements;
+  unsigned ElementByteWidth;
+
+  CompactArrayInitExpr(QualType T, InitListExpr *SyntacticForm)
+      : Expr(CompactArrayInitExprClass, T, VK_RValue, OK_Ordinary, false,
+             false, false, false),
+        SyntacticForm(SyntacticForm), Data(nullptr), NumElements(0),
+        ElementByteWidth(0) {}
+
+  explicit CompactArrayInitExpr(EmptyShell Empty)
+      : Expr(CompactArrayInitExprClass, Empty), SyntacticForm(nullptr),
+        Data(nullptr), NumElements(0), ElementByteWidth(0) {}
+
+  void allocateData(const ASTContext &C, unsigned NumElements,
+                    unsigned ElementByteWidth);
+
+public:
+  /// \brief Create an initializer of an array of type \p T with
+  /// \p NumElements elements of \p ElementByteWidth bytes, whose values are
+  /// then set with setElement().
+  static CompactArrayInitExpr *Create(const ASTContext &C, QualType T,
+                                      InitListExpr *SyntacticForm,
+                                      unsigned NumElements,
+                                      unsigned ElementByteWidth);
+
+  static CompactArrayInitExpr *CreateEmpty(const ASTContext &C);
+
+  InitListExpr *getSyntacticForm() const { return SyntacticForm; }
+
+  /// \brief The number of initialized elements, which may be less than the
+  /// size of the array.
+  unsigned getNumElements() const { return NumElements; }
+  unsigned getElementByteWidth() const { return ElementByteWidth; }
+
+  /// \brief The value of the element \p I, or the bit pattern of the value
+  /// of a floating-point element, zero-extended.
+  uint64_t getElement(unsigned I) const;
+  void setElement(unsigned I, uint64_t Value);
+
+  /// \brief The packed values of the initialized elements.
+  StringRef getRawData() const {
+    return StringRef(Data, NumElements * ElementByteWidth);
+  }
+
+  static bool classof(const Stmt *S) {
+    return S->getStmtClass() == CompactArrayInitExprClass;
+  }
+
+  SourceLocation getLocStart() const LLVM_READONLY {
+    return SyntacticForm->getLocStart();
+  }
+  SourceLocation getLocEnd() const LLVM_READONLY {
+    return SyntacticForm->getLocEnd();
+  }
+
+  child_range children() {
+    return child_range(child_iterator(), child_iterator());
+  }
+
+  friend class ASTStmtReader;
+  friend class ASTStmtWriter;
+};
+
 /// @brief Represents a C99 designated initializer expression.
 ///
 /// A designated initializer expression (C99 6.7.8) contains one or
@@ -169,6 +169,14 @@ public:
   /// Return a descriptor for the corresponding module, if one exists.
   virtual llvm::Optional<ASTSourceDescriptor> getSourceDescriptor(unsigned ID);
 
+  enum ExtKind { EK_Always, EK_Never, EK_ReplyHazy };
+
+  /// \brief Determine whether the definition of \p D is emitted by the
+  /// object file of the module it comes from. Returns EK_Always if another
+  /// object file provides it, EK_Never if this compilation is the one that
+  /// has to, and EK_ReplyHazy if the source does not know.
+  virtual ExtKind hasExternalDefinitions(const Decl *D);
+
   /// \brief Finds all declarations lexically contained within the given
   /// DeclContext, after applying an optional filter predicate.
   ///
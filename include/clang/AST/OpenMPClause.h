@@ -2948,27 +2948,30 @@ public:
   // associated with the field declaration 'a'. If the expression is an array
   // subscript it may not have any associated declaration. In that case the
   // associated declaration is set to nullptr.
+  //
+  // The declaration is the one referenced by the expression, so it is not
+  // stored: the components of all the mappable clauses of a translation unit
+  // only take a pointer each.
   class MappableComponent {
     // \brief Expression associated with the component.
     Expr *AssociatedExpression = nullptr;
-    // \brief Declaration associated with the declaration. If the component does
-    // not have a declaration (e.g. array subscripts or section), this is set to
-    // nullptr.
-    ValueDecl *AssociatedDeclaration = nullptr;
 
   public:
     explicit MappableComponent() {}
-    explicit MappableComponent(Expr *AssociatedExpression,
-                               ValueDecl *AssociatedDeclaration)
-        : AssociatedExpression(AssociatedExpression),
-          AssociatedDeclaration(
-              AssociatedDeclaration
-                  ? cast<ValueDecl>(AssociatedDeclaration->getCanonicalDecl())
-                  : nullptr) {}
+    explicit MappableComponent(Expr *AssociatedExpression)
+        : AssociatedExpression(AssociatedExpression) {}
 
     Expr *getAssociatedExpression() const { return AssociatedExpression; }
+    /// \brief Returns the canonical declaration referenced by a declaration
+    /// reference or member expression, nullptr for other expressions (e.g.
+    /// array subscripts or sections).
     ValueDecl *getAssociatedDeclaration() const {
-      return AssociatedDeclaration;
+      ValueDecl *D = nullptr;
+      if (auto *DRE = dyn_cast_or_null<DeclRefExpr>(AssociatedExpression))
+        D = DRE->getDecl();
+      else if (auto *ME = dyn_cast_or_null<MemberExpr>(AssociatedExpression))
+        D = ME->getMemberDecl();
+      return D ? cast<ValueDecl>(D->getCanonicalDecl()) : nullptr;
     }
   };
 
@@ -2199,6 +2199,13 @@ DEF_TRAVERSE_STMT(InitListExpr, {
   ShouldVisitChildren = false;
 })
 
+// The elements of a CompactArrayInitExpr are only written in its syntactic
+// form.
+DEF_TRAVERSE_STMT(CompactArrayInitExpr, {
+  TRY_TO_TRAVERSE_OR_ENQUEUE_STMT(S->getSyntacticForm());
+  ShouldVisitChildren = false;
+})
+
 // GenericSelectionExpr is a special case because the types and expressions
 // are interleaved.  We also need to watch out for null types (default
 // generic associations).
@@ -133,6 +133,24 @@ public:
     ///
     /// It prints a report after match.
     llvm::Optional<Profiling> CheckProfiling;
+
+    /// \brief Skips the declarations in system headers, and everything they
+    /// contain, when traversing the AST.
+    ///
+    /// The matchers are then not run on the nodes from system headers, such
+    /// as the instantiations of the templates of the standard library. Those
+    /// nodes can still be reached by traversal matchers like
+    /// \c hasDescendant() from the nodes outside system headers.
+    bool IgnoreSystemHeaders = false;
+
+    /// \brief Builds the parent map used by \c hasParent() and
+    /// \c hasAncestor() for one top-level declaration at a time in
+    /// \c matchAST().
+    ///
+    /// This avoids building the parent map of the whole translation unit, at
+    /// the cost of only reporting the parents a node has in the current
+    /// top-level declaration. See \c ASTContext::setParentMapScope().
+    bool ScopeParentMaps = false;
   };
 
   MatchFinder(MatchFinderOptions Options = MatchFinderOptions());
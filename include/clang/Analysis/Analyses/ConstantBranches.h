@@ -0,0 +1,55 @@
+//===- ConstantBranches.h - Branches with constant conditions ---*- C++ --*-==//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines ConstantBranches, a constant propagation over the CFG
+// that finds the branches whose condition has the same value on every path,
+// such as 'if (debug)' when 'debug' is a local set to 0.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_ANALYSIS_ANALYSES_CONSTANTBRANCHES_H
+#define LLVM_CLANG_ANALYSIS_ANALYSES_CONSTANTBRANCHES_H
+
+#include "clang/Analysis/AnalysisContext.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/Optional.h"
+
+namespace clang {
+
+class CFG;
+class CFGBlock;
+
+class ConstantBranches : public ManagedAnalysis {
+  /// The blocks whose branch condition is known, by block ID.
+  llvm::BitVector Known;
+
+  /// The value of the known branch conditions, by block ID.
+  llvm::BitVector Values;
+
+  ConstantBranches(AnalysisDeclContext &AC, const CFG &G);
+
+public:
+  /// \brief Returns the value that the condition of the branch terminating
+  /// \p B has whenever \p B is executed, if it is the same every time.
+  ///
+  /// Only the locals of integral type whose address is never taken are
+  /// tracked, so that nothing but the assignments in the CFG can change
+  /// them. The CFG must have all its statements in its blocks, as the
+  /// analyzer builds it.
+  Optional<bool> getBranchValue(const CFGBlock *B) const;
+
+  // Used by AnalysisDeclContext to construct this object.
+  static const void *getTag();
+
+  static ConstantBranches *create(AnalysisDeclContext &AC);
+};
+
+} // end clang namespace
+
+#endif
@@ -22,6 +22,7 @@
 #include "llvm/ADT/FoldingSet.h"
 #include "llvm/Support/Allocator.h"
 #include <memory>
+#include <vector>
 
 namespace clang {
 
@@ -61,6 +62,43 @@ public:
 };
 
 
+/// CFGCache keeps the CFGs built for the declarations of a translation unit,
+/// so that the clients asking for the CFG of the same body with compatible
+/// build options build it only once.
+///
+/// The cache only keeps the CFGs that can serve the options it is created
+/// with, up to edge pruning, as those are the ones its owner will ask for.
+/// Other clients, such as the analysis-based warnings in Sema, can then hand
+/// it the CFGs they build without growing it with CFGs nobody will reuse.
+class CFGCache {
+  struct Entry {
+    CFG::BuildOptions Options;
+    std::unique_ptr<CFG> Graph;
+  };
+  typedef std::pair<const Decl *, const Stmt *> Key;
+
+  const CFG::BuildOptions &RetainedOptions;
+  llvm::DenseMap<Key, std::vector<Entry>> CFGs;
+
+public:
+  explicit CFGCache(const CFG::BuildOptions &RetainedOptions)
+      : RetainedOptions(RetainedOptions) {}
+
+  /// Returns a CFG of the body \p Body of \p D that can be used where one
+  /// built with \p Options is expected, or null if there is none.
+  CFG *lookup(const Decl *D, const Stmt *Body,
+              const CFG::BuildOptions &Options) const;
+
+  /// Takes the ownership of \p Graph, the CFG of the body \p Body of \p D
+  /// built with \p Options, if it can serve the options of the cache.
+  /// Returns the CFG either way.
+  CFG *insert(const Decl *D, const Stmt *Body,
+              const CFG::BuildOptions &Options, std::unique_ptr<CFG> &Graph);
+
+  /// Drops all the CFGs.
+  void clear() { CFGs.clear(); }
+};
+
 /// AnalysisDeclContext contains the context data for the function or method
 /// under analysis.
 class AnalysisDeclContext {
@@ -70,9 +108,14 @@ class AnalysisDeclContext {
 
   const Decl * const D;
 
-  std::unique_ptr<CFG> cfg, completeCFG;
+  /// The CFGs, owned either by this context or by the CFG cache.
+  CFG *cfg, *completeCFG;
+  std::unique_ptr<CFG> ownedCFG, ownedCompleteCFG;
   std::unique_ptr<CFGStmtMap> cfgStmtMap;
 
+  /// The cache to take the CFGs from and to hand them to. This may be null.
+  CFGCache *Cache;
+
   CFG::BuildOptions cfgBuildOptions;
   CFG::BuildOptions::ForcedBlkExprs *forcedBlkExprs;
 
@@ -126,6 +169,11 @@ public:
   bool getAddImplicitDtors() const { return cfgBuildOptions.AddImplicitDtors; }
   bool getAddInitializers() const { return cfgBuildOptions.AddInitializers; }
 
+  /// Makes this context take its CFGs from \p C, and hand it the ones it
+  /// builds. The contexts created by an AnalysisDeclContextManager use its
+  /// cache.
+  void setCFGCache(CFGCache *C) { Cache = C; }
+
   void registerForcedBlockExpression(const Stmt *stmt);
   const CFGBlock *getBlockForRegisteredExpression(const Stmt *stmt);
 
@@ -163,6 +211,11 @@ public:
 
   void dumpCFG(bool ShowColors);
 
+private:
+  CFG *buildCFG(std::unique_ptr<CFG> &Owned);
+
+public:
+
   /// \brief Returns true if we have built a CFG for this analysis context.
   /// Note that this doesn't correspond to whether or not a valid CFG exists, it
   /// corresponds to whether we *attempted* to build one.
@@ -421,6 +474,11 @@ class AnalysisDeclContextManager {
   /// for well-known functions.
   bool SynthesizeBodies;
 
+  /// The CFGs built for the contexts. They are kept when the contexts are
+  /// discarded, so that the callees inlined from several top-level functions
+  /// get their CFGs built once.
+  CFGCache CFGs;
+
 public:
   AnalysisDeclContextManager(bool useUnoptimizedCFG = false,
                              bool addImplicitDtors = false,
@@ -442,6 +500,9 @@ public:
   CFG::BuildOptions &getCFGBuildOptions() {
     return cfgBuildOptions;
   }
+
+  /// Return the cache of the CFGs built with the options of this manager.
+  CFGCache &getCFGCache() { return CFGs; }
   
   /// Return true if faux bodies should be synthesized for well-known
   /// functions.
@@ -671,6 +671,12 @@ public:
   /// Adds a (potentially unreachable) successor block to the current block.
   void addSuccessor(AdjacentBlock Succ, BumpVectorContext &C);
 
+  /// Makes room for \p N successors, so that adding them one at a time does
+  /// not grow the successor list repeatedly.
+  void reserveSuccessors(unsigned N, BumpVectorContext &C) {
+    Succs.reserve(C, N);
+  }
+
   void appendStmt(Stmt *statement, BumpVectorContext &C) {
     Elements.push_back(CFGStmt(statement), C);
   }
@@ -772,6 +778,22 @@ public:
       return *this;
     }
 
+    /// Returns true if a CFG built with these options can be used where one
+    /// built with \p Other is expected: both add the same kinds of elements
+    /// and edges, and every statement that \p Other always adds as an element
+    /// is always added here too.
+    bool subsumes(const BuildOptions &Other) const {
+      return (alwaysAddMask | Other.alwaysAddMask) == alwaysAddMask &&
+             PruneTriviallyFalseEdges == Other.PruneTriviallyFalseEdges &&
+             AddEHEdges == Other.AddEHEdges &&
+             AddInitializers == Other.AddInitializers &&
+             AddImplicitDtors == Other.AddImplicitDtors &&
+             AddTemporaryDtors == Other.AddTemporaryDtors &&
+             AddStaticInitBranches == Other.AddStaticInitBranches &&
+             AddCXXNewAllocator == Other.AddCXXNewAllocator &&
+             AddCXXDefaultInitExprInCtors == Other.AddCXXDefaultInitExprInCtors;
+    }
+
     BuildOptions()
       : forcedBlkExprs(nullptr), Observer(nullptr),
         PruneTriviallyFalseEdges(true), AddEHEdges(false),
@@ -788,6 +810,10 @@ public:
   ///  the caller should not directly free it.
   CFGBlock *createBlock();
 
+  /// reserveBlocks - Make room for \p N more blocks, when the builder knows
+  ///  how many it is about to create.
+  void reserveBlocks(unsigned N) { Blocks.reserve(BlkBVC, Blocks.size() + N); }
+
   /// setEntry - Set the entry block of the CFG.  This is typically used
   ///  only during CFG construction.  Most CFG clients expect that the
   ///  entry block has no predecessors and contains no statements.
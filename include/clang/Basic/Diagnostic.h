@@ -894,6 +894,10 @@ class DiagnosticBuilder {
   /// call to ForceEmit.
   mutable bool IsForceEmit = false;
 
+  /// \brief Flag indicating that this diagnostic is known to be ignored, so
+  /// its string arguments, ranges and fix-it hints are not stored.
+  mutable bool IsIgnored = false;
+
   friend class DiagnosticsEngine;
 
   DiagnosticBuilder() = default;
@@ -917,6 +921,7 @@ protected:
     DiagObj = nullptr;
     IsActive = false;
     IsForceEmit = false;
+    IsIgnored = false;
   }
 
   /// \brief Determine whether this diagnostic is still active.
@@ -954,6 +959,7 @@ public:
     DiagObj = D.DiagObj;
     IsActive = D.IsActive;
     IsForceEmit = D.IsForceEmit;
+    IsIgnored = D.IsIgnored;
     D.Clear();
     NumArgs = D.NumArgs;
   }
@@ -976,6 +982,19 @@ public:
     return *this;
   }
 
+  /// \brief Record that the diagnostic is known to be ignored at its
+  /// location, so that the arguments added to it afterwards need not be
+  /// stored. This must not be used for a diagnostic whose arguments are read
+  /// even when it is ignored, such as one reported in a SFINAE context.
+  const DiagnosticBuilder &setIgnored() const {
+    IsIgnored = true;
+    return *this;
+  }
+
+  /// \brief Determine whether the diagnostic is known to be ignored, in which
+  /// case callers can skip computing expensive arguments for it.
+  bool isIgnored() const { return IsIgnored; }
+
   /// \brief Conversion of DiagnosticBuilder to bool always returns \c true.
   ///
   /// This allows is to be used in boolean error contexts (where \c true is
@@ -990,7 +1009,11 @@ public:
     assert(NumArgs < DiagnosticsEngine::MaxArguments &&
            "Too many arguments to diagnostic!");
     DiagObj->DiagArgumentsKind[NumArgs] = DiagnosticsEngine::ak_std_string;
-    DiagObj->DiagArgumentsStr[NumArgs++] = S;
+    // The arguments of ignored diagnostics are never formatted.
+    if (IsIgnored)
+      DiagObj->DiagArgumentsStr[NumArgs++].clear();
+    else
+      DiagObj->DiagArgumentsStr[NumArgs++] = S;
   }
 
   void AddTaggedVal(intptr_t V, DiagnosticsEngine::ArgumentKind Kind) const {
@@ -1003,12 +1026,13 @@ public:
 
   void AddSourceRange(const CharSourceRange &R) const {
     assert(isActive() && "Clients must not add to cleared diagnostic!");
-    DiagObj->DiagRanges.push_back(R);
+    if (!IsIgnored)
+      DiagObj->DiagRanges.push_back(R);
   }
 
   void AddFixItHint(const FixItHint &Hint) const {
     assert(isActive() && "Clients must not add to cleared diagnostic!");
-    if (!Hint.isNull())
+    if (!Hint.isNull() && !IsIgnored)
       DiagObj->DiagFixItHints.push_back(Hint);
   }
 
@@ -39,6 +39,8 @@ class MemoryBuffer;
 namespace clang {
 
 class FileSystemStatCache;
+class MissingPathSet;
+class PrefetchStatCache;
 
 /// \brief Cached information about one directory (either on disk or in
 /// the virtual file system).
@@ -164,6 +166,15 @@ class FileManager : public RefCountedBase<FileManager> {
   // Caching.
   std::unique_ptr<FileSystemStatCache> StatCache;
 
+  /// \brief The stat cache at the end of the chain that looks up paths ahead
+  /// of their use and remembers the missing ones, owned by the chain.
+  PrefetchStatCache *Prefetcher;
+
+  /// \brief The missing paths shared with other file managers, if any.
+  IntrusiveRefCntPtr<MissingPathSet> SharedMissingPaths;
+
+  PrefetchStatCache *getPrefetcher();
+
   bool getStatValue(StringRef Path, FileData &Data, bool isFile,
                     std::unique_ptr<vfs::File> *F);
 
@@ -196,6 +207,22 @@ public:
   /// \brief Removes all FileSystemStatCache objects from the manager.
   void clearStatCaches();
 
+  /// \brief Start looking up the given paths concurrently, so that the
+  /// lookups of those that do not exist are answered from the cache.
+  ///
+  /// This does nothing unless FileSystemOptions::StatPrefetchThreads is set.
+  void prefetchFiles(ArrayRef<std::string> Paths);
+
+  /// \brief Whether prefetchFiles looks paths up.
+  bool canPrefetchFiles() const {
+    return FileSystemOpts.StatPrefetchThreads != 0;
+  }
+
+  /// \brief Share the paths found not to exist with the other file managers
+  /// given the same set, e.g. those of all the compilations of a tool that
+  /// does not change the file system while it runs.
+  void setSharedMissingPaths(IntrusiveRefCntPtr<MissingPathSet> Paths);
+
   /// \brief Lookup, cache, and verify the specified directory (real or
   /// virtual).
   ///
@@ -235,9 +262,14 @@ public:
 
   /// \brief Open the specified file as a MemoryBuffer, returning a new
   /// MemoryBuffer if successful, otherwise returning null.
+  ///
+  /// \param RequiresNullTerminator Whether the buffer has to be followed by a
+  /// null character. Files that do not need it can always be mapped into
+  /// memory rather than read, whatever their size.
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
   getBufferForFile(const FileEntry *Entry, bool isVolatile = false,
-                   bool ShouldCloseOpenFile = true);
+                   bool ShouldCloseOpenFile = true,
+                   bool RequiresNullTerminator = true);
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
   getBufferForFile(StringRef Filename);
 
@@ -25,6 +25,10 @@ public:
   /// \brief If set, paths are resolved as if the working directory was
   /// set to the value of WorkingDir.
   std::string WorkingDir;
+
+  /// \brief The number of threads that look up the candidate paths of header
+  /// search ahead of their use, or 0 to look them up one at a time.
+  unsigned StatPrefetchThreads = 0;
 };
 
 } // end namespace clang
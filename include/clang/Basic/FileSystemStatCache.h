@@ -16,9 +16,16 @@
 #define LLVM_CLANG_BASIC_FILESYSTEMSTATCACHE_H
 
 #include "clang/Basic/LLVM.h"
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/Support/FileSystem.h"
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace clang {
 
@@ -126,6 +133,73 @@ public:
                        vfs::FileSystem &FS) override;
 };
 
+/// \brief A set of absolute paths known not to exist, which the file managers
+/// of the compilations that see the same file system can share, including
+/// from different threads.
+///
+/// The set is never invalidated: it must not outlive the state of the file
+/// system it was filled from.
+class MissingPathSet : public llvm::ThreadSafeRefCountedBase<MissingPathSet> {
+  mutable std::mutex Mutex;
+  llvm::StringSet<> Paths;
+
+public:
+  bool contains(StringRef Path) const {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    return Paths.count(Path);
+  }
+
+  void insert(StringRef Path) {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    Paths.insert(Path);
+  }
+};
+
+/// \brief A stat cache that remembers the paths that do not exist, and can
+/// look up batches of paths on worker threads ahead of their use.
+///
+/// This helps file systems where each lookup is slow, and header search,
+/// which probes a path in each search directory before it finds a header.
+/// Only the paths found missing are remembered; the others are looked up
+/// again when they are needed, so that they can be opened at the same time.
+class PrefetchStatCache : public FileSystemStatCache {
+  IntrusiveRefCntPtr<vfs::FileSystem> FS;
+  IntrusiveRefCntPtr<MissingPathSet> SharedMissing;
+
+  std::mutex Mutex;
+  std::condition_variable Changed;
+  /// The paths waiting for a worker, and those being looked up.
+  std::deque<std::string> Queue;
+  llvm::StringSet<> Pending;
+  /// The paths found missing, including relative ones.
+  llvm::StringSet<> Missing;
+  bool ShuttingDown = false;
+  std::vector<std::thread> Workers;
+
+  void runWorker();
+  void recordMissing(StringRef Path);
+
+public:
+  /// \brief Create a stat cache that looks up paths through \p FS with
+  /// \p NumThreads workers, and records the missing absolute paths in
+  /// \p SharedMissing if it is not null.
+  ///
+  /// \p FS must support concurrent status queries if \p NumThreads is not 0.
+  PrefetchStatCache(IntrusiveRefCntPtr<vfs::FileSystem> FS,
+                    unsigned NumThreads,
+                    IntrusiveRefCntPtr<MissingPathSet> SharedMissing);
+  ~PrefetchStatCache() override;
+
+  /// \brief Start looking up \p Paths, without waiting for the results.
+  void prefetch(ArrayRef<std::string> Paths);
+
+  bool canPrefetch() const { return !Workers.empty(); }
+
+  LookupResult getStat(StringRef Path, FileData &Data, bool isFile,
+                       std::unique_ptr<vfs::File> *F,
+                       vfs::FileSystem &FS) override;
+};
+
 } // end namespace clang
 
 #endif
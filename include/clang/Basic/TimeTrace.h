@@ -0,0 +1,117 @@
+//===--- TimeTrace.h - Trace of the time spent in the frontend --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the TimeTracer, which records the time spent in the phases
+/// of a compilation as a Chrome trace.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_BASIC_TIMETRACE_H
+#define LLVM_CLANG_BASIC_TIMETRACE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace clang {
+
+/// \brief Records the beginning and the end of events, such as the parsing of
+/// a top-level declaration or the instantiation of a template, and writes
+/// them in the Chrome trace event format.
+///
+/// Besides the events, the trace summarizes for each kind of event its total
+/// duration and the details, such as the header or the template
+/// specialization, that took the longest. Nested events of the same kind are
+/// only counted once.
+class TimeTracer {
+  typedef std::chrono::steady_clock Clock;
+
+  struct Event {
+    std::string Name;
+    std::string Detail;
+    Clock::time_point Start;
+    Clock::duration Duration;
+    bool Open;
+  };
+
+  struct Total {
+    Clock::duration Duration;
+    unsigned Count;
+    /// The number of events of this kind that are still open.
+    unsigned OpenCount;
+
+    Total() : Duration(), Count(0), OpenCount(0) {}
+  };
+
+  Clock::time_point Start;
+  std::vector<Event> Events;
+  unsigned TopN;
+
+  /// The totals of each kind of event, and of each of its details.
+  llvm::StringMap<Total> Totals;
+  llvm::StringMap<llvm::StringMap<Total>> DetailTotals;
+
+public:
+  /// \param TopN The number of details of each kind of event to summarize.
+  explicit TimeTracer(unsigned TopN = 10);
+
+  /// \brief Begin an event, and return its handle.
+  unsigned begin(StringRef Name, StringRef Detail = StringRef());
+
+  /// \brief End the event with the given handle.
+  void end(unsigned Handle);
+
+  /// \brief Write the trace as a JSON object.
+  void write(raw_ostream &OS) const;
+};
+
+/// \brief Return the trace of the current thread, if any.
+TimeTracer *getTimeTracer();
+
+/// \brief Set the trace of the current thread, or reset it when \p Tracer
+/// is null.
+void setTimeTracer(TimeTracer *Tracer);
+
+/// \brief Records an event that lasts as long as the scope, if the current
+/// thread has a trace.
+///
+/// The detail is only computed when tracing, so scopes are cheap otherwise.
+class TimeTraceScope {
+  TimeTracer *Tracer;
+  unsigned Handle;
+
+  TimeTraceScope(const TimeTraceScope &) = delete;
+  void operator=(const TimeTraceScope &) = delete;
+
+public:
+  explicit TimeTraceScope(StringRef Name) : Tracer(getTimeTracer()) {
+    if (Tracer)
+      Handle = Tracer->begin(Name);
+  }
+
+  TimeTraceScope(StringRef Name, llvm::function_ref<std::string()> Detail)
+      : Tracer(getTimeTracer()) {
+    if (Tracer)
+      Handle = Tracer->begin(Name, Detail());
+  }
+
+  ~TimeTraceScope() {
+    if (Tracer)
+      Tracer->end(Handle);
+  }
+};
+
+} // end namespace clang
+
+#endif
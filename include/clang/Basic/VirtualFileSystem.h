@@ -17,6 +17,7 @@
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/Support/Chrono.h"
@@ -29,6 +30,7 @@
 #include <cstdint>
 #include <ctime>
 #include <memory>
+#include <mutex>
 #include <stack>
 #include <string>
 #include <system_error>
@@ -343,6 +345,57 @@ public:
   std::error_code setCurrentWorkingDirectory(const Twine &Path) override;
 };
 
+/// \brief The status and contents of the files seen through a set of
+/// \p SharedCacheFileSystem, which the compilations of a multi-threaded tool
+/// share to look up and read each file once.
+///
+/// The entries are keyed by absolute path and never change once they are
+/// filled, so the files must not change while the cache is in use, and all
+/// the file systems using the cache must see the same files. The cache is
+/// safe to use from several threads.
+class SharedFileCache : public llvm::ThreadSafeRefCountedBase<SharedFileCache> {
+public:
+  struct Entry;
+
+  SharedFileCache();
+  ~SharedFileCache();
+
+  /// \brief Get the entry of the absolute path \p Path, creating an empty
+  /// one on the first request.
+  Entry &getEntry(StringRef Path);
+
+private:
+  std::mutex Mutex;
+  llvm::StringMap<std::unique_ptr<Entry>> Entries;
+};
+
+/// \brief A file system that answers the status queries and reads of regular
+/// files from a \p SharedFileCache, and forwards the cache misses and the
+/// directory iterations to another file system.
+///
+/// Each \p SharedCacheFileSystem has its own working directory and passes
+/// only absolute paths to the other file system, so that one can be used on
+/// each thread of a tool on top of the same real file system.
+class SharedCacheFileSystem : public FileSystem {
+  IntrusiveRefCntPtr<SharedFileCache> Cache;
+  IntrusiveRefCntPtr<FileSystem> ExternalFS;
+  std::string WorkingDirectory;
+
+public:
+  SharedCacheFileSystem(
+      IntrusiveRefCntPtr<SharedFileCache> Cache,
+      IntrusiveRefCntPtr<FileSystem> ExternalFS = getRealFileSystem());
+
+  llvm::ErrorOr<Status> status(const Twine &Path) override;
+  llvm::ErrorOr<std::unique_ptr<File>>
+  openFileForRead(const Twine &Path) override;
+  directory_iterator dir_begin(const Twine &Dir, std::error_code &EC) override;
+  llvm::ErrorOr<std::string> getCurrentWorkingDirectory() const override {
+    return WorkingDirectory;
+  }
+  std::error_code setCurrentWorkingDirectory(const Twine &Path) override;
+};
+
 /// \brief Get a globally unique ID for a virtual file or directory.
 llvm::sys::fs::UniqueID getNextVirtualUniqueID();
 
@@ -405,6 +458,41 @@ public:
   void write(llvm::raw_ostream &OS);
 };
 
+/// \brief Gets a read-only \p FileSystem that serves the files of an archive
+/// written by \p ArchiveFileSystemWriter directly from \p Buffer.
+///
+/// The buffers of the files point into \p Buffer, so mapping the archive
+/// from disk lets every process compiling from it share the same pages, and
+/// the files are looked up without opening or stat'ing anything. Returns
+/// null if \p Buffer is not a valid archive.
+IntrusiveRefCntPtr<FileSystem>
+getVFSFromArchive(std::unique_ptr<llvm::MemoryBuffer> Buffer);
+
+/// \brief Writes the files that \p getVFSFromArchive serves.
+///
+/// The archive holds a table of the files sorted by path, followed by their
+/// paths and contents. Each file is followed by a null byte, so that it can
+/// be used as a null-terminated buffer without being copied.
+class ArchiveFileSystemWriter {
+  struct Entry {
+    std::string Path;
+    std::string Contents;
+    time_t ModificationTime;
+    llvm::sys::fs::perms Perms;
+  };
+  std::vector<Entry> Entries;
+
+public:
+  ArchiveFileSystemWriter() = default;
+
+  /// \brief Add a regular file at the absolute path \p Path, which must not
+  /// be a directory of another file in the archive.
+  void addFile(StringRef Path, StringRef Contents, time_t ModificationTime = 0,
+               llvm::sys::fs::perms Perms = llvm::sys::fs::all_read);
+
+  void write(llvm::raw_ostream &OS);
+};
+
 } // end namespace vfs
 } // end namespace clang
 
@@ -34,11 +34,37 @@ namespace clang {
     Backend_EmitObj        ///< Emit native object files
   };
 
+  /// \brief Runs the per-function optimization passes of EmitBackendOutput
+  /// over the functions of a module while the module is still being
+  /// generated, so that they do not all wait for the end of the translation
+  /// unit.
+  class EarlyFunctionPasses {
+  public:
+    struct Implementation;
+
+    EarlyFunctionPasses(DiagnosticsEngine &Diags, const CodeGenOptions &CGOpts,
+                        const TargetOptions &TOpts, const LangOptions &LOpts,
+                        llvm::Module *M);
+    ~EarlyFunctionPasses();
+
+    /// \brief Optimize the function definitions that were added to the
+    /// module since the last call.
+    void run();
+
+    Implementation &getImplementation() { return *Impl; }
+
+  private:
+    std::unique_ptr<Implementation> Impl;
+  };
+
+  /// \param EarlyPasses If not null, the passes that have already optimized
+  /// some of the functions of \p M; they are not optimized again.
   void EmitBackendOutput(DiagnosticsEngine &Diags, const CodeGenOptions &CGOpts,
                          const TargetOptions &TOpts, const LangOptions &LOpts,
                          const llvm::DataLayout &TDesc, llvm::Module *M,
                          BackendAction Action,
-                         std::unique_ptr<raw_pwrite_stream> OS);
+                         std::unique_ptr<raw_pwrite_stream> OS,
+                         EarlyFunctionPasses *EarlyPasses = nullptr);
 
   void EmbedBitcode(llvm::Module *M, const CodeGenOptions &CGOpts,
                     llvm::MemoryBufferRef Buf);
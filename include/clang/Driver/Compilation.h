@@ -92,6 +92,10 @@ class Compilation {
   /// Temporary files which should be removed on exit.
   llvm::opt::ArgStringList TempFiles;
 
+  /// The bitcode files of the OpenMP device code, by normalized device
+  /// triple, to be embedded next to the device images.
+  std::map<std::string, llvm::opt::ArgStringList> OpenMPDeviceBitcodeFiles;
+
   /// Result files which should be removed on failure.
   ArgStringMap ResultFiles;
 
@@ -105,6 +109,24 @@ class Compilation {
   /// Whether we're compiling for diagnostic purposes.
   bool ForDiagnostics;
 
+  /// Maximum number of offloading device jobs that may run concurrently.
+  unsigned MaxParallelDeviceJobs;
+
+  /// PrintCommand - Print the command line of \p C if requested by -v or
+  /// CC_PRINT_OPTIONS.
+  ///
+  /// \return False if the output file of CC_PRINT_OPTIONS cannot be opened.
+  bool PrintCommand(const Command &C) const;
+
+  /// ExecuteDeviceJobs - Execute a sequence of offloading device jobs,
+  /// running at most MaxParallelDeviceJobs of them at a time. A job only
+  /// starts once the jobs producing its inputs have completed.
+  ///
+  /// \return True if any of the jobs failed.
+  bool ExecuteDeviceJobs(
+      ArrayRef<const Command *> Jobs,
+      SmallVectorImpl<std::pair<int, const Command *>> &FailingCommands) const;
+
 public:
   Compilation(const Driver &D, const ToolChain &DefaultToolChain,
               llvm::opt::InputArgList *Args,
@@ -162,6 +184,12 @@ public:
         std::make_pair(OffloadKind, DeviceToolChain));
   }
 
+  /// Set the maximum number of offloading device jobs that may run
+  /// concurrently.
+  void setMaxParallelDeviceJobs(unsigned N) { MaxParallelDeviceJobs = N; }
+
+  unsigned getMaxParallelDeviceJobs() const { return MaxParallelDeviceJobs; }
+
   const llvm::opt::InputArgList &getInputArgs() const { return *Args; }
 
   const llvm::opt::DerivedArgList &getArgs() const { return *TranslatedArgs; }
@@ -215,6 +243,19 @@ public:
     return Name;
   }
 
+  /// Record that \p Name holds the bitcode of some of the OpenMP device code
+  /// for \p Triple.
+  void addOpenMPDeviceBitcodeFile(StringRef Triple, const char *Name) {
+    OpenMPDeviceBitcodeFiles[Triple].push_back(Name);
+  }
+
+  /// Return the bitcode files of the OpenMP device code for \p Triple, if any.
+  const llvm::opt::ArgStringList *
+  getOpenMPDeviceBitcodeFiles(StringRef Triple) const {
+    auto I = OpenMPDeviceBitcodeFiles.find(Triple);
+    return I == OpenMPDeviceBitcodeFiles.end() ? nullptr : &I->second;
+  }
+
   /// addResultFile - Add a file to remove on failure, and returns its
   /// argument.
   const char *addResultFile(const char *Name, const JobAction *JA) {
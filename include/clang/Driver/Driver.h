@@ -200,6 +200,16 @@ public:
   /// Whether the driver is generating diagnostics for debugging purposes.
   unsigned CCGenDiagnostics : 1;
 
+  /// Whether to run the -cc1 and -cc1as jobs in the driver's process,
+  /// through CC1Main, rather than spawn a process for each.
+  unsigned CC1InProcess : 1;
+
+  /// The entry point of the integrated tools, called with the full argument
+  /// vector of a -cc1 or -cc1as job. Clients that link the tools in set it
+  /// to allow -fintegrated-cc1.
+  typedef int (*CC1ToolFunc)(ArrayRef<const char *> Argv);
+  CC1ToolFunc CC1Main;
+
 private:
   /// Default target triple.
   std::string DefaultTargetTriple;
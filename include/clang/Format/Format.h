@@ -18,6 +18,7 @@
 #include "clang/Basic/LangOptions.h"
 #include "clang/Tooling/Core/Replacement.h"
 #include "llvm/ADT/ArrayRef.h"
+#include <memory>
 #include <system_error>
 
 namespace clang {
@@ -815,10 +816,15 @@ cleanupAroundReplacements(StringRef Code, const tooling::Replacements &Replaces,
 /// If ``IncompleteFormat`` is non-null, its value will be set to true if any
 /// of the affected ranges were not formatted due to a non-recoverable syntax
 /// error.
+///
+/// If \p Threads is greater than 1, the lines are formatted on that many
+/// threads, in partitions split between top-level declarations. The result
+/// is the same.
 tooling::Replacements reformat(const FormatStyle &Style, StringRef Code,
                                ArrayRef<tooling::Range> Ranges,
                                StringRef FileName = "<stdin>",
-                               bool *IncompleteFormat = nullptr);
+                               bool *IncompleteFormat = nullptr,
+                               unsigned Threads = 1);
 
 /// \brief Clean up any erroneous/redundant code in the given \p Ranges in \p
 /// Code.
@@ -828,6 +834,39 @@ tooling::Replacements cleanup(const FormatStyle &Style, StringRef Code,
                               ArrayRef<tooling::Range> Ranges,
                               StringRef FileName = "<stdin>");
 
+/// \brief Formats ranges of a file that is being edited, e.g. by an editor
+/// that formats as the user types.
+///
+/// The session splits the code into chunks of top-level declarations that are
+/// separated by empty lines. Formatting a range only lexes, parses and
+/// annotates the chunks it touches, and an edit only analyzes again the chunks
+/// around it. The style options that adapt to the code, such as
+/// ``DerivePointerAlignment``, still adapt to the whole file.
+///
+/// Code in languages other than C++ is formatted as a whole, like
+/// ``reformat()`` does.
+class FormatSession {
+public:
+  FormatSession(const FormatStyle &Style, StringRef Code,
+                StringRef FileName = "<stdin>");
+  ~FormatSession();
+
+  /// \brief Returns the current code of the file.
+  StringRef getCode() const;
+
+  /// \brief Applies \p Edits to the code.
+  llvm::Error applyEdits(const tooling::Replacements &Edits);
+
+  /// \brief Returns the ``Replacements`` necessary to make all \p Ranges of
+  /// the current code comply with the style, like ``reformat()``.
+  tooling::Replacements format(ArrayRef<tooling::Range> Ranges,
+                               bool *IncompleteFormat = nullptr);
+
+private:
+  class Implementation;
+  std::unique_ptr<Implementation> Impl;
+};
+
 /// \brief Returns the ``LangOpts`` that the formatter expects you to set.
 ///
 /// \param Style determines specific settings for lexing mode.
@@ -865,6 +904,30 @@ FormatStyle getStyle(StringRef StyleName, StringRef FileName,
                      StringRef FallbackStyle, StringRef Code = "",
                      vfs::FileSystem *FS = nullptr);
 
+/// \brief Computes the styles of many files, like ``getStyle()``, reading and
+/// parsing each configuration file once.
+///
+/// The configuration file of each directory and the styles parsed from them
+/// are remembered, so files that are changed on disk while the cache is in
+/// use may be ignored. ``getStyle()`` can be called from several threads.
+class StyleCache {
+public:
+  /// \brief Creates a cache for the styles built from ``StyleName`` and
+  /// ``FallbackStyle``, as interpreted by ``getStyle()``.
+  StyleCache(StringRef StyleName, StringRef FallbackStyle,
+             vfs::FileSystem *FS = nullptr);
+  ~StyleCache();
+
+  /// \brief Returns the same style as
+  /// ``getStyle(StyleName, FileName, FallbackStyle, Code, FS)``.
+  FormatStyle getStyle(StringRef FileName, StringRef Code = "");
+
+  class Implementation;
+
+private:
+  std::unique_ptr<Implementation> Impl;
+};
+
 // \brief Returns a string representation of ``Language``.
 inline StringRef getLanguageName(FormatStyle::LanguageKind Language) {
   switch (Language) {
@@ -266,6 +266,32 @@ private:
   /// the preamble must be thrown away.
   llvm::StringMap<PreambleFileHash> FilesInPreamble;
 
+  /// \brief Keeps track of the files that were read by the last successful
+  /// parse, and of the files that were remapped for it.
+  ///
+  /// If none of them have changed when reparsing, the results of the last
+  /// parse are kept.
+  llvm::StringMap<PreambleFileHash> FilesInLastParse;
+  llvm::StringMap<PreambleFileHash> RemappedFilesInLastParse;
+
+  /// \brief The number of bytes that the AST may allocate before the bodies
+  /// of the functions outside the visible range of the main file are
+  /// evicted, or 0 if the AST has no memory budget.
+  uint64_t MemoryBudget = 0;
+
+  /// \brief The file offsets of the beginning and the end of the visible range
+  /// of the main file.
+  unsigned VisibleBegin = 0;
+  unsigned VisibleEnd = ~0U;
+
+  /// \brief Whether the AST went over its memory budget, so that parses skip
+  /// the bodies of the functions outside the visible range.
+  bool EvictBodies = false;
+
+  /// \brief Whether the bodies that the next parse skips differ from the ones
+  /// that the last parse skipped.
+  bool EvictedBodiesChanged = false;
+
   /// \brief When non-NULL, this is the buffer used to store the contents of
   /// the main file when it has been padded for use with the precompiled
   /// preamble.
@@ -287,6 +313,15 @@ private:
   /// \brief A list of the serialization ID numbers for each of the top-level
   /// declarations parsed within the precompiled preamble.
   std::vector<serialization::DeclID> TopLevelDeclsInPreamble;
+
+  /// \brief The directory in which precompiled preambles are shared with the
+  /// translation units of other ASTUnits and processes that are parsed with
+  /// the same command line, or empty if the preamble is not shared.
+  std::string PreambleCacheDirectory;
+
+  /// \brief The hash of the command line and of the working directory, which
+  /// identifies this translation unit in the preamble cache.
+  SmallString<32> CommandLineHash;
   
   /// \brief Whether we should be caching code-completion results.
   bool ShouldCacheCodeCompletionResults : 1;
@@ -422,6 +457,14 @@ private:
   bool Parse(std::shared_ptr<PCHContainerOperations> PCHContainerOps,
              std::unique_ptr<llvm::MemoryBuffer> OverrideMainBuffer);
 
+  /// \brief Record the files read by the parse that just completed.
+  void recordFilesInLastParse();
+
+  /// \brief Determine whether reparsing with the given remapped files could
+  /// produce different results than the last parse.
+  bool anyFileChangedSinceLastParse(
+      ArrayRef<std::pair<std::string, llvm::MemoryBuffer *>> RemappedFiles);
+
   struct ComputedPreamble {
     llvm::MemoryBuffer *Buffer;
     std::unique_ptr<llvm::MemoryBuffer> Owner;
@@ -441,6 +484,10 @@ private:
       const CompilerInvocation &PreambleInvocationIn, bool AllowRebuild = true,
       unsigned MaxLines = 0);
   void RealizeTopLevelDeclsFromPreamble();
+  void getPreambleFileIDs(SmallVectorImpl<FileID> &FIDs) const;
+
+  bool loadPreambleFromCache(StringRef Key, StringRef PreamblePCHPath);
+  void storePreambleInCache(StringRef Key, StringRef PreamblePCHPath);
 
   /// \brief Transfers ownership of the objects (like SourceManager) from
   /// \param CI to this ASTUnit.
@@ -592,6 +639,20 @@ public:
   /// Note: This is used internally by the top-level tracking action
   unsigned &getCurrentTopLevelHashValue() { return CurrentTopLevelHashValue; }
 
+  /// \brief Set the memory budget of the AST and the range of the main file
+  /// that is visible to the user.
+  ///
+  /// Once the AST allocates more than \p Budget bytes, the following parses
+  /// skip the bodies of the functions of the main file that are declared
+  /// outside the file offsets [\p Begin, \p End), keeping their
+  /// declarations. Reparsing after moving the visible range parses the bodies
+  /// that came into view. A \p Budget of 0 removes the budget.
+  void setMemoryBudget(uint64_t Budget, unsigned Begin, unsigned End);
+
+  /// \brief Whether the parser should skip the body of the given function,
+  /// when it skips function bodies.
+  bool shouldSkipFunctionBody(Decl *D);
+
   /// \brief Get the source location for the given file:line:col triplet.
   ///
   /// The difference with SourceManager::getLocation is that this method checks
@@ -824,6 +885,9 @@ public:
   ///
   /// \param ModuleFormat - If provided, uses the specific module format.
   ///
+  /// \param PreambleCacheDirectory - If non-empty, the directory in which the
+  /// precompiled preamble is looked up before building it, and stored after.
+  ///
   /// \param ErrAST - If non-null and parsing failed without any AST to return
   /// (e.g. because the PCH could not be loaded), this accepts the ASTUnit
   /// mainly to allow the caller to see the diagnostics.
@@ -844,6 +908,7 @@ public:
       bool AllowPCHWithCompilerErrors = false, bool SkipFunctionBodies = false,
       bool UserFilesAreVolatile = false, bool ForSerialization = false,
       llvm::Optional<StringRef> ModuleFormat = llvm::None,
+      StringRef PreambleCacheDirectory = StringRef(),
       std::unique_ptr<ASTUnit> *ErrAST = nullptr);
 
   /// \brief Reparse the source files using the same command-line options that
@@ -142,6 +142,11 @@ public:
   /// in the backend for setting the name in the skeleton cu.
   std::string SplitDwarfFile;
 
+  /// The files to which the object files of the partitions of the module
+  /// after the first one are written. If not empty, the module is split and
+  /// its partitions are generated in parallel.
+  std::vector<std::string> ParallelCodeGenOutputs;
+
   /// The name of the relocation model to use.
   std::string RelocationModel;
 
@@ -184,6 +189,20 @@ public:
   /// records.
   std::string OptRecordFile;
 
+  /// The name of the file to which the OpenMP host compilation writes the
+  /// offload entries info, so that device compilations do not have to read
+  /// the host IR.
+  std::string OpenMPOffloadInfoOutputFile;
+
+  /// The name of the file with the offload entries info written by the OpenMP
+  /// host compilation. It is preferred over the host IR file if it exists.
+  std::string OpenMPHostOffloadInfoFile;
+
+  /// The name of the file to which an OpenMP device compilation writes the
+  /// bitcode of the device code, so that it can be embedded next to the device
+  /// image and compiled again at run time.
+  std::string OpenMPDeviceBitcodeOutputFile;
+
   /// Regular expression to select optimizations for which we should enable
   /// optimization remarks. Transformation passes whose name matches this
   /// expression (and support this feature), will emit a diagnostic
@@ -11,6 +11,9 @@
 #define LLVM_CLANG_FRONTEND_FRONTENDACTIONS_H
 
 #include "clang/Frontend/FrontendAction.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <map>
 #include <string>
 #include <vector>
 
@@ -241,6 +244,24 @@ protected:
   void ExecuteAction() override;
 };
 
+/// \brief Preprocess only the directives of each file, which is enough to find
+/// the dependencies of the compilation.
+class DirectivesOnlyPreprocessAction : public PreprocessorFrontendAction {
+  /// \brief The minimized sources, shared by all the inputs.
+  std::map<llvm::sys::fs::UniqueID, std::unique_ptr<llvm::MemoryBuffer>>
+      MinimizedFiles;
+
+protected:
+  bool BeginSourceFileAction(CompilerInstance &CI,
+                             StringRef Filename) override;
+  void ExecuteAction() override;
+
+public:
+  /// \brief Make the source manager provide the directives of \p File
+  /// instead of its contents.
+  void minimizeFile(CompilerInstance &CI, const FileEntry *File);
+};
+
 class PrintPreprocessedAction : public PreprocessorFrontendAction {
 protected:
   void ExecuteAction() override;
@@ -58,7 +58,8 @@ namespace frontend {
     RewriteTest,            ///< Rewriter playground
     RunAnalysis,            ///< Run one or more source code analyses.
     MigrateSource,          ///< Run migrator.
-    RunPreprocessorOnly     ///< Just lex, no output.
+    RunPreprocessorOnly,    ///< Just lex, no output.
+    RunPreprocessorDirectivesOnly ///< Just lex the directives, no output.
   };
 }
 
@@ -276,6 +277,13 @@ public:
   /// Filename to write statistics to.
   std::string StatsFile;
 
+  /// Filename to write a Chrome trace of the time spent in the frontend to.
+  std::string TimeTraceFile;
+
+  /// The number of most expensive details of each kind of event, such as
+  /// headers or template specializations, to summarize in the time trace.
+  unsigned TimeTraceTopN;
+
 public:
   FrontendOptions() :
     DisableFree(false), RelocatablePCH(false), ShowHelp(false),
@@ -286,7 +294,8 @@ public:
     GenerateGlobalModuleIndex(true), ASTDumpDecls(false), ASTDumpLookups(false),
     BuildingImplicitModule(false), ModulesEmbedAllFiles(false),
     IncludeTimestamps(true), ARCMTAction(ARCMT_None),
-    ObjCMTAction(ObjCMT_None), ProgramAction(frontend::ParseSyntaxOnly)
+    ObjCMTAction(ObjCMT_None), ProgramAction(frontend::ParseSyntaxOnly),
+    TimeTraceTopN(10)
   {}
 
   /// getInputKindForExtension - Return the appropriate input kind for a file
@@ -13,6 +13,7 @@
 #include "clang/Basic/LLVM.h"
 #include "llvm/Bitcode/BitstreamReader.h"
 #include "llvm/Support/ErrorOr.h"
+#include <string>
 
 namespace clang {
 namespace serialized_diags {
@@ -30,6 +31,7 @@ enum class SDError {
   MissingVersion,
   VersionMismatch,
   UnsupportedConstruct,
+  PreambleMismatch,
   /// A generic error for subclass handlers that don't want or need to define
   /// their own error_category.
   HandlerFailed
@@ -119,6 +121,30 @@ protected:
   }
 };
 
+/// \brief Concatenates serialized diagnostics files without decoding their
+/// records.
+///
+/// The preamble of the first file, made of its BLOCKINFO and META blocks, is
+/// written once, followed by the diagnostic blocks of every file in order.
+/// The files must all have the same preamble, which is the case for files
+/// written by the same version of Clang.
+///
+/// Every file defines its file names and flags in the diagnostic block that
+/// first refers to them, so the IDs that a file reuses from an earlier one in
+/// the output are always redefined before they are referred to.
+class SerializedDiagnosticConcatenator {
+  raw_ostream &OS;
+  std::string Preamble;
+  bool WrotePreamble;
+
+public:
+  explicit SerializedDiagnosticConcatenator(raw_ostream &OS)
+      : OS(OS), WrotePreamble(false) {}
+
+  /// \brief Append the diagnostics in \c File to the output.
+  std::error_code append(StringRef File);
+};
+
 } // end serialized_diags namespace
 } // end clang namespace
 
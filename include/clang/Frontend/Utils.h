@@ -71,6 +71,15 @@ void InitializePreprocessor(Preprocessor &PP, const PreprocessorOptions &PPOpts,
 void DoPrintPreprocessedInput(Preprocessor &PP, raw_ostream* OS,
                               const PreprocessorOutputOptions &Opts);
 
+/// Reduce the source of a file to its preprocessor directives, so that its
+/// dependencies can be found without lexing the rest of the file.
+///
+/// The directives keep their lines and every other line is left empty, so
+/// that the locations in the directives do not change.
+void minimizeSourceToDependencyDirectives(StringRef Input,
+                                          const LangOptions &LangOpts,
+                                          SmallVectorImpl<char> &Output);
+
 /// An interface for collecting the dependencies of a compilation. Users should
 /// use \c attachToPreprocessor and \c attachToASTReader to get all of the
 /// dependencies.
@@ -11,7 +11,10 @@
 #define LLVM_CLANG_INDEX_USRGENERATION_H
 
 #include "clang/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/Allocator.h"
 
 namespace clang {
 class Decl;
@@ -28,6 +31,47 @@ static inline StringRef getUSRSpacePrefix() {
 /// \returns true if the results should be ignored, false otherwise.
 bool generateUSRForDecl(const Decl *D, SmallVectorImpl<char> &Buf);
 
+/// \brief A cache of the USRs of the declarations of one ASTContext.
+///
+/// The USR of a declaration starts with the USR of its context; the cached
+/// USRs of the contexts are reused as the prefixes of the USRs of the
+/// declarations they contain. The USRs are interned, so that redeclarations
+/// share their storage.
+class USRCache {
+public:
+  struct CachedUSR {
+    /// The USR, including the USR prefix, or an empty string if the results
+    /// should be ignored.
+    StringRef USR;
+
+    /// Whether the USR can be used as the prefix of the USRs of the
+    /// declarations in its context. This is not the case when generating it
+    /// introduced type substitutions or a location.
+    bool IsReusablePrefix;
+  };
+
+  /// \brief Generate the USR of \p D, or retrieve it if it was generated
+  /// already.
+  CachedUSR get(const Decl *D);
+
+  /// \brief Generate or retrieve the USR of \p D, including the USR prefix.
+  /// The USR stays valid during the lifetime of the cache.
+  /// \returns true if the results should be ignored, false otherwise.
+  bool getUSR(const Decl *D, StringRef &USR) {
+    USR = get(D).USR;
+    return USR.empty();
+  }
+
+  void clear() {
+    USRs.clear();
+    Strings.clear();
+  }
+
+private:
+  llvm::DenseMap<const Decl *, CachedUSR> USRs;
+  llvm::StringSet<llvm::BumpPtrAllocator> Strings;
+};
+
 /// \brief Generate a USR fragment for an Objective-C class.
 void generateUSRForObjCClass(StringRef Cls, raw_ostream &OS);
 
@@ -30,6 +30,7 @@ class DiagnosticsEngine;
 class ExternalPreprocessorSource;
 class FileEntry;
 class FileManager;
+class HeaderInfoCache;
 class HeaderSearchOptions;
 class IdentifierInfo;
 class Preprocessor;
@@ -199,6 +200,15 @@ class HeaderSearch {
   };
   llvm::StringMap<LookupFileCacheInfo, llvm::BumpPtrAllocator> LookupFileCache;
 
+  /// \brief The lookups and include guards recorded by earlier compilations,
+  /// loaded on first use from HeaderSearchOptions::HeaderInfoCachePath.
+  std::unique_ptr<HeaderInfoCache> InfoCache;
+  bool InfoCacheLoaded;
+
+  /// \brief Whether the lookups of InfoCache were checked against the current
+  /// search directories.
+  bool InfoCacheValidated;
+
   /// \brief Collection mapping a framework or subframework
   /// name like "Carbon" to the Carbon.framework directory.
   llvm::StringMap<FrameworkCacheEntry, llvm::BumpPtrAllocator> FrameworkMap;
@@ -269,6 +279,7 @@ public:
     AngledDirIdx = angledDirIdx;
     SystemDirIdx = systemDirIdx;
     NoCurDirSearch = noCurDirSearch;
+    InfoCacheValidated = false;
     //LookupFileCache.clear();
   }
 
@@ -279,6 +290,7 @@ public:
     if (!isAngled)
       AngledDirIdx++;
     SystemDirIdx++;
+    InfoCacheValidated = false;
   }
 
   /// \brief Set the list of system header prefixes.
@@ -662,11 +674,20 @@ public:
   std::string suggestPathToFileForDiagnostics(const FileEntry *File,
                                               bool *IsSystem = nullptr);
 
+  /// \brief Write the lookups and include guards of this compilation to the
+  /// header info cache, if there is one.
+  void writeHeaderInfoCache();
+
   void PrintStats();
   
   size_t getTotalMemory() const;
 
 private:
+  /// \brief Retrieve the header info cache, loading it and checking it
+  /// against the current search directories if needed, or null if the cache
+  /// is disabled.
+  HeaderInfoCache *getHeaderInfoCache();
+
   /// \brief Describes what happened when we tried to load a module map file.
   enum LoadModuleMapResult {
     /// \brief The module map file had already been loaded.
@@ -94,6 +94,10 @@ public:
   /// \brief The directory used for a user build.
   std::string ModuleUserBuildPath;
 
+  /// \brief The file that caches header search results and include guards
+  /// across compilations, or empty if there is none.
+  std::string HeaderInfoCachePath;
+
   /// \brief The directories used to load prebuilt module files.
   std::vector<std::string> PrebuiltModulePaths;
 
@@ -150,6 +154,10 @@ public:
   /// \brief The set of user-provided virtual filesystem overlay files.
   std::vector<std::string> VFSOverlayFiles;
 
+  /// \brief The set of user-provided archives of files, which are mapped into
+  /// memory and overlaid on the real file system below the overlay files.
+  std::vector<std::string> VFSArchiveFiles;
+
   /// Include the compiler builtin includes.
   unsigned UseBuiltinIncludes : 1;
 
@@ -170,6 +178,12 @@ public:
   /// \c BuildSessionTimestamp).
   unsigned ModulesValidateOncePerBuildSession : 1;
 
+  /// \brief If true, also skip verifying the user input files of a module
+  /// that a compilation has validated during this build session. The module
+  /// timestamp file records the signature of the module file that was
+  /// validated.
+  unsigned ModulesShareBuildSessionValidation : 1;
+
   /// \brief Whether to validate system input files when a module is loaded.
   unsigned ModulesValidateSystemHeaders : 1;
 
@@ -186,6 +200,7 @@ public:
         UseBuiltinIncludes(true), UseStandardSystemIncludes(true),
         UseStandardCXXIncludes(true), UseLibcxx(false), Verbose(false),
         ModulesValidateOncePerBuildSession(false),
+        ModulesShareBuildSessionValidation(false),
         ModulesValidateSystemHeaders(false),
         UseDebugInfo(false), ModulesValidateDiagnosticOptions(true) {}
 
@@ -206,6 +221,10 @@ public:
     VFSOverlayFiles.push_back(Name);
   }
 
+  void AddVFSArchiveFile(StringRef Name) {
+    VFSArchiveFiles.push_back(Name);
+  }
+
   void AddPrebuiltModulePath(StringRef Name) {
     PrebuiltModulePaths.push_back(Name);
   }
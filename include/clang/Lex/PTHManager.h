@@ -27,6 +27,7 @@ namespace llvm {
 namespace clang {
 
 class FileEntry;
+class LangOptions;
 class Preprocessor;
 class PTHLexer;
 class DiagnosticsEngine;
@@ -108,7 +109,7 @@ class PTHManager : public IdentifierInfoLookup {
 
 public:
   // The current PTH version.
-  enum { Version = 10 };
+  enum { Version = 11 };
 
   ~PTHManager() override;
 
@@ -125,8 +126,16 @@ public:
   IdentifierInfo *get(StringRef Name) override;
 
   /// Create - This method creates PTHManager objects.  The 'file' argument
-  ///  is the name of the PTH file.  This method returns NULL upon failure.
-  static PTHManager *Create(StringRef file, DiagnosticsEngine &Diags);
+  ///  is the name of the PTH file.  This method returns NULL upon failure,
+  ///  including when the tokens were lexed with language options that lex
+  ///  differently from 'LangOpts'.
+  static PTHManager *Create(StringRef file, DiagnosticsEngine &Diags,
+                            const LangOptions &LangOpts);
+
+  /// getLexerFingerprint - Return a hash of the language options that change
+  ///  how the raw lexer splits a file into tokens.  Cached tokens can only be
+  ///  used with the options they were lexed with.
+  static uint64_t getLexerFingerprint(const LangOptions &LangOpts);
 
   void setPreprocessor(Preprocessor *pp) { PP = pp; }
 
@@ -19,6 +19,7 @@
 #include "clang/Lex/PPCallbacks.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/PointerUnion.h"
 #include "llvm/ADT/iterator.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/Compiler.h"
@@ -155,9 +156,14 @@ namespace clang {
   
   /// \brief Records the location of a macro expansion.
   class MacroExpansion : public PreprocessedEntity {
-    /// \brief The definition of this macro or the name of the macro if it is
-    /// a builtin macro.
-    llvm::PointerUnion<IdentifierInfo *, MacroDefinitionRecord *> NameOrDef;
+  public:
+    /// \brief The definition of a macro or the name of the macro if it is a
+    /// builtin macro.
+    typedef llvm::PointerUnion<IdentifierInfo *, MacroDefinitionRecord *>
+        NameOrDefinition;
+
+  private:
+    NameOrDefinition NameOrDef;
 
   public:
     MacroExpansion(IdentifierInfo *BuiltinName, SourceRange Range)
@@ -292,9 +298,50 @@ namespace clang {
     /// \brief Allocator used to store preprocessing objects.
     llvm::BumpPtrAllocator BumpAlloc;
 
+    /// \brief A local preprocessed entity, or the index of a macro expansion
+    /// in CompactExpansions if it was not retrieved yet.
+    class LocalEntity {
+      uintptr_t Value;
+
+    public:
+      LocalEntity(PreprocessedEntity *Entity)
+          : Value(reinterpret_cast<uintptr_t>(Entity)) {}
+
+      static LocalEntity getCompactExpansion(unsigned Index) {
+        LocalEntity Result(nullptr);
+        Result.Value = (uintptr_t(Index) << 1) | 1;
+        return Result;
+      }
+
+      bool isCompactExpansion() const { return Value & 1; }
+      unsigned getCompactExpansionIndex() const { return Value >> 1; }
+      PreprocessedEntity *getEntity() const {
+        return isCompactExpansion()
+                   ? nullptr
+                   : reinterpret_cast<PreprocessedEntity *>(Value);
+      }
+    };
+
     /// \brief The set of preprocessed entities in this record, in order they
     /// were seen.
-    std::vector<PreprocessedEntity *> PreprocessedEntities;
+    std::vector<LocalEntity> PreprocessedEntities;
+
+    /// \brief A macro expansion stored without its MacroExpansion object,
+    /// which is only created when the entity is retrieved.
+    ///
+    /// Most of the entities of a large translation unit are expansions in
+    /// headers that clients such as libclang never look at.
+    struct CompactExpansion {
+      unsigned Begin;
+      unsigned End;
+      /// The index of the expanded macro in ExpandedMacros.
+      unsigned Macro;
+    };
+    std::vector<CompactExpansion> CompactExpansions;
+
+    /// \brief The macros of the compact expansions, each stored once.
+    std::vector<MacroExpansion::NameOrDefinition> ExpandedMacros;
+    llvm::DenseMap<void *, unsigned> ExpandedMacroIDs;
     
     /// \brief The set of preprocessed entities in this record that have been
     /// loaded from external sources.
@@ -338,6 +385,13 @@ namespace clang {
 
     /// \brief Retrieve the loaded preprocessed entity at the given index.
     PreprocessedEntity *getLoadedPreprocessedEntity(unsigned Index);
+
+    /// \brief Retrieve the source range of a local entity without creating
+    /// the entity of a compact macro expansion.
+    SourceRange getLocalEntityRange(LocalEntity Entity) const;
+
+    /// \brief Add a local entity that begins at \p BeginLoc to this record.
+    PPEntityID addLocalEntity(LocalEntity Entity, SourceLocation BeginLoc);
     
     /// \brief Determine the number of preprocessed entities that were
     /// loaded (or can be loaded) from an external source.
@@ -1795,6 +1795,12 @@ private:
   /// otherwise the caller should lex again.
   bool HandleMacroExpandedIdentifier(Token &Tok, const MacroDefinition &MD);
 
+  /// If the object-like macro \p MI, whose single token names another macro,
+  /// starts a chain of such macros that ends in a token that expands
+  /// trivially, expand the whole chain into 'Tok' and return true.
+  bool HandleSingleTokenMacroChain(Token &Tok, MacroInfo *MI,
+                                   SourceLocation ExpansionEnd);
+
   /// \brief Cache macro expanded tokens for TokenLexers.
   //
   /// Works like a stack; a TokenLexer adds the macro expanded tokens that is
@@ -23,6 +23,7 @@
 #include "clang/Sema/DeclSpec.h"
 #include "clang/Sema/LoopHint.h"
 #include "clang/Sema/Sema.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/PrettyStackTrace.h"
@@ -237,6 +238,36 @@ class Parser : public CodeCompletionHandler {
   /// \brief Identifiers which have been declared within a tentative parse.
   SmallVector<IdentifierInfo *, 8> TentativelyDeclaredIdentifiers;
 
+  /// \brief The kinds of disambiguation whose results are memoized.
+  enum DisambiguationKind {
+    DK_SimpleDeclaration,
+    DK_ForRangeDeclaration,
+    DK_FunctionDeclarator
+  };
+
+  /// \brief The result of a disambiguation. It can depend on the identifiers
+  /// declared by the enclosing tentative parses, so those are recorded too.
+  struct DisambiguationResult {
+    SmallVector<IdentifierInfo *, 4> TentativelyDeclared;
+    bool IsDeclaration;
+    bool IsAmbiguous;
+  };
+
+  /// \brief The results of the disambiguations performed in the current
+  /// top-level declaration, keyed on the location of the token they start at
+  /// and on the parser state they depend on.
+  ///
+  /// A nested ambiguity is disambiguated again by every enclosing tentative
+  /// parse and by the parse that follows them; without this, deeply nested
+  /// declarators take time exponential in their depth.
+  llvm::DenseMap<std::pair<unsigned, unsigned>, DisambiguationResult>
+      DisambiguationResults;
+
+  std::pair<unsigned, unsigned> getDisambiguationKey(DisambiguationKind Kind);
+  const DisambiguationResult *findDisambiguationResult(DisambiguationKind Kind);
+  void addDisambiguationResult(DisambiguationKind Kind, bool IsDeclaration,
+                               bool IsAmbiguous);
+
   IdentifierInfo *getSEHExceptKeyword();
 
   /// True if we are within an Objective-C container while parsing C-like decls.
@@ -1873,6 +1904,12 @@ private:
   /// \returns true if the function body was skipped.
   bool trySkippingFunctionBody();
 
+  /// \brief In an OpenMP device compilation, skip the function/method body
+  /// unless it contains a target directive.
+  ///
+  /// \returns true if the function body was skipped.
+  bool trySkippingOpenMPHostFunctionBody();
+
   bool ParseImplicitInt(DeclSpec &DS, CXXScopeSpec *SS,
                         const ParsedTemplateInfo &TemplateInfo,
                         AccessSpecifier AS, DeclSpecContext DSC, 
@@ -19,6 +19,7 @@
 namespace clang {
 
 class BlockExpr;
+class CFGCache;
 class Decl;
 class FunctionDecl;
 class ObjCMethodDecl;
@@ -48,6 +49,10 @@ private:
   Sema &S;
   Policy DefaultPolicy;
 
+  /// \brief The cache to hand the CFGs to, if another client such as the
+  /// static analyzer will build them again.
+  CFGCache *SharedCFGs;
+
   enum VisitFlag { NotVisited = 0, Visited = 1, Pending = 2 };
   llvm::DenseMap<const FunctionDecl*, VisitFlag> VisitedFD;
 
@@ -95,6 +100,10 @@ public:
 
   Policy getDefaultPolicy() { return DefaultPolicy; }
 
+  /// \brief Hands the CFGs built for the warnings to \p Cache, and takes the
+  /// ones it has, until it is reset to null.
+  void setCFGCache(CFGCache *Cache) { SharedCFGs = Cache; }
+
   void PrintStats() const;
 };
 
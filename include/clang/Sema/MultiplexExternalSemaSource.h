@@ -130,6 +130,10 @@ public:
   /// \brief Loads comment ranges.
   void ReadComments() override;
 
+  /// \brief Asks the sources, in order, whether another object file provides
+  /// the definition of \p D.
+  ExtKind hasExternalDefinitions(const Decl *D) override;
+
   /// \brief Notify ExternalASTSource that we started deserialization of
   /// a decl or type so until FinishedDeserializing is called there may be
   /// decls that are initializing. Must be paired with FinishedDeserializing.
@@ -728,9 +728,10 @@ namespace clang {
     SmallVector<OverloadCandidate, 16> Candidates;
     llvm::SmallPtrSet<Decl *, 16> Functions;
 
-    // Allocator for OverloadCandidate::Conversions. We store the first few
-    // elements inline to avoid allocation for small sets.
-    llvm::BumpPtrAllocator ConversionSequenceAllocator;
+    // The Sema whose allocator holds the OverloadCandidate::Conversions that
+    // do not fit in the inline space, or null if there are none. We store the
+    // first few elements inline to avoid allocation for small sets.
+    Sema *ConversionSequenceOwner;
 
     SourceLocation Loc;
     CandidateSetKind Kind;
@@ -745,10 +746,18 @@ namespace clang {
 
     void destroyCandidates();
 
+    ImplicitConversionSequence *
+    allocateConversionSequences(Sema &S, unsigned NumConversions);
+    void releaseConversionSequences();
+
   public:
     OverloadCandidateSet(SourceLocation Loc, CandidateSetKind CSK)
-        : Loc(Loc), Kind(CSK), NumInlineSequences(0) {}
-    ~OverloadCandidateSet() { destroyCandidates(); }
+        : ConversionSequenceOwner(nullptr), Loc(Loc), Kind(CSK),
+          NumInlineSequences(0) {}
+    ~OverloadCandidateSet() {
+      destroyCandidates();
+      releaseConversionSequences();
+    }
 
     SourceLocation getLocation() const { return Loc; }
     CandidateSetKind getKind() const { return Kind; }
@@ -769,9 +778,23 @@ namespace clang {
     size_t size() const { return Candidates.size(); }
     bool empty() const { return Candidates.empty(); }
 
+    /// \brief Make room for \p N more candidates, so that adding them does
+    /// not grow the candidate array one step at a time.
+    void reserve(size_t N) { Candidates.reserve(Candidates.size() + N); }
+
+    /// \brief Add a new candidate without conversion sequences to the overload
+    /// set.
+    OverloadCandidate &addCandidate() {
+      Candidates.push_back(OverloadCandidate());
+      OverloadCandidate &C = Candidates.back();
+      C.Conversions = nullptr;
+      C.NumConversions = 0;
+      return C;
+    }
+
     /// \brief Add a new candidate with NumConversions conversion sequence slots
     /// to the overload set.
-    OverloadCandidate &addCandidate(unsigned NumConversions = 0) {
+    OverloadCandidate &addCandidate(Sema &S, unsigned NumConversions) {
       Candidates.push_back(OverloadCandidate());
       OverloadCandidate &C = Candidates.back();
 
@@ -783,9 +806,8 @@ namespace clang {
         C.Conversions = &I[NumInlineSequences];
         NumInlineSequences += NumConversions;
       } else {
-        // Otherwise get memory from the allocator.
-        C.Conversions = ConversionSequenceAllocator
-                          .Allocate<ImplicitConversionSequence>(NumConversions);
+        // Otherwise get memory from the allocator in Sema.
+        C.Conversions = allocateConversionSequences(S, NumConversions);
       }
 
       // Construct the new objects.
@@ -965,6 +965,23 @@ public:
 
   llvm::BumpPtrAllocator BumpAlloc;
 
+  /// \brief The allocator for the conversion sequences of the overload
+  /// candidates that do not fit in the inline space of their candidate set.
+  ///
+  /// It is shared by all the candidate sets that are alive at the same time,
+  /// and reset when the last of them is destroyed, so that its slab is reused
+  /// by the next overload resolution.
+  llvm::BumpPtrAllocator ConversionSequenceAlloc;
+
+  /// \brief The number of candidate sets with conversion sequences in
+  /// ConversionSequenceAlloc.
+  unsigned NumConversionSequenceSets;
+
+  /// \brief The number of conversion sequences, and of the bytes for them,
+  /// allocated from ConversionSequenceAlloc.
+  unsigned NumConversionSequencesAllocated;
+  size_t NumConversionSequenceBytes;
+
   /// \brief The number of SFINAE diagnostics that have been trapped.
   unsigned NumSFINAEErrors;
 
@@ -1147,9 +1164,20 @@ public:
   /// \brief Emit a diagnostic.
   SemaDiagnosticBuilder Diag(SourceLocation Loc, unsigned DiagID) {
     DiagnosticBuilder DB = Diags.Report(Loc, DiagID);
+    if (DiagnosticIDs::isBuiltinWarningOrExtension(DiagID) &&
+        isDiagnosticIgnored(DiagID, Loc))
+      DB.setIgnored();
     return SemaDiagnosticBuilder(DB, *this, DiagID);
   }
 
+  /// \brief Determine whether the warning or extension \p DiagID, if reported
+  /// now at \p Loc, would be dropped: it is ignored there, and no enclosing
+  /// SFINAE context records it.
+  ///
+  /// Callers can use this to skip computing expensive diagnostic arguments,
+  /// or the analysis that leads to the diagnostic.
+  bool isDiagnosticIgnored(unsigned DiagID, SourceLocation Loc) const;
+
   /// \brief Emit a partial diagnostic.
   SemaDiagnosticBuilder Diag(SourceLocation Loc, const PartialDiagnostic& PD);
 
@@ -4078,6 +4106,10 @@ public:
                                    Expr *Config = nullptr,
                                    bool IsExecConfig = false);
 
+  /// Returns the name of the function that receives the configuration of a
+  /// CUDA kernel call.
+  StringRef getCudaConfigureFuncName() const;
+
   ExprResult ActOnCUDAExecConfigExpr(Scope *S, SourceLocation LLLLoc,
                                      MultiExprArg ExecConfig,
                                      SourceLocation GGGLoc);
@@ -9616,6 +9648,12 @@ public:
                                         bool IgnoreImplicitHDAttr = false);
   CUDAFunctionTarget IdentifyCUDATarget(const AttributeList *Attr);
 
+  /// The targets computed by IdentifyCUDATarget, with the number of attributes
+  /// the function had then. Attributes are only added to the functions, so the
+  /// target remains valid while that number does not change.
+  llvm::DenseMap<const FunctionDecl *, std::pair<unsigned, CUDAFunctionTarget>>
+      CUDATargetCache;
+
   /// Gets the CUDA target for the current context.
   CUDAFunctionTarget CurrentCUDATarget() {
     return IdentifyCUDATarget(dyn_cast<FunctionDecl>(CurContext));
@@ -9643,6 +9681,11 @@ public:
   /// \returns preference value for particular Caller/Callee combination.
   CUDAFunctionPreference IdentifyCUDAPreference(const FunctionDecl *Caller,
                                                 const FunctionDecl *Callee);
+  /// Same as above, for a caller of target \p CallerTarget, which is cheaper
+  /// when the preferences of several callees are compared.
+  CUDAFunctionPreference
+  IdentifyCUDAPreference(CUDAFunctionTarget CallerTarget,
+                         const FunctionDecl *Callee);
 
   /// Determines whether Caller may invoke Callee, based on their CUDA
   /// host/device attributes.  Returns false if the call is not allowed.
@@ -9931,6 +9974,7 @@ private:
   bool CheckX86BuiltinRoundingOrSAE(unsigned BuiltinID, CallExpr *TheCall);
   bool CheckX86BuiltinFunctionCall(unsigned BuiltinID, CallExpr *TheCall);
   bool CheckPPCBuiltinFunctionCall(unsigned BuiltinID, CallExpr *TheCall);
+  bool CheckNVPTXBuiltinFunctionCall(unsigned BuiltinID, CallExpr *TheCall);
 
   bool SemaBuiltinVAStartImpl(CallExpr *TheCall);
   bool SemaBuiltinVAStart(CallExpr *TheCall);
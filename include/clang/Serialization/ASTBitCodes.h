@@ -36,7 +36,7 @@ namespace clang {
     /// Version 4 of AST files also requires that the version control branch and
     /// revision match exactly, since there is no backward compatibility of
     /// AST files at this time.
-    const unsigned VERSION_MAJOR = 6;
+    const unsigned VERSION_MAJOR = 10;
 
     /// \brief AST file minor version number supported by this version of
     /// Clang.
@@ -591,6 +591,15 @@ namespace clang {
 
       /// \brief Record code for declarations associated with OpenCL extensions.
       OPENCL_EXTENSION_DECLS = 59,
+
+      /// \brief Record code for the bloom filter of the identifiers in the
+      /// IDENTIFIER_TABLE, which lets lookups skip the table for most of the
+      /// identifiers it does not contain.
+      IDENTIFIER_FILTER = 60,
+
+      /// \brief Record code for the inline functions whose definitions are
+      /// emitted once, in the object file built from the module.
+      MODULAR_CODEGEN_DECLS = 61,
     };
 
     /// \brief Record types used within a source manager block.
@@ -1525,7 +1534,9 @@ namespace clang {
       EXPR_OBJC_BRIDGED_CAST,     // ObjCBridgedCastExpr
       
       STMT_MS_DEPENDENT_EXISTS,   // MSDependentExistsStmt
-      EXPR_LAMBDA                 // LambdaExpr
+      EXPR_LAMBDA,                // LambdaExpr
+
+      EXPR_COMPACT_ARRAY_INIT     // CompactArrayInitExpr
     };
 
     /// \brief The kinds of designators that can occur in a
@@ -307,6 +307,7 @@ class ReadMethodPoolVisitor;
 
 namespace reader {
   class ASTIdentifierLookupTrait;
+  class ASTDeclContextNameLookupTrait;
   /// \brief The on-disk hash table(s) used for DeclContext name lookup.
   struct DeclContextLookupTable;
 }
@@ -365,6 +366,7 @@ public:
   friend class ASTStmtReader;
   friend class ASTIdentifierIterator;
   friend class serialization::reader::ASTIdentifierLookupTrait;
+  friend class serialization::reader::ASTDeclContextNameLookupTrait;
   friend class TypeLocReader;
   friend class ASTRecordReader;
   friend class ASTWriter;
@@ -715,6 +717,11 @@ private:
   /// the consumer eagerly.
   SmallVector<uint64_t, 16> EagerlyDeserializedDecls;
 
+  /// \brief For each function whose definition, or class whose debug info, is
+  /// emitted by the object file of its module, whether that module is the main
+  /// file, in which case this compilation is the one that emits it.
+  llvm::DenseMap<const Decl *, bool> DefinitionSource;
+
   /// \brief The IDs of all tentative definitions stored in the chain.
   ///
   /// Sema keeps track of all tentative definitions in a TU because it has to
@@ -911,6 +918,10 @@ private:
   /// \brief The number of lookups into identifier tables that succeed.
   unsigned NumIdentifierLookupHits;
 
+  /// \brief The number of identifier table lookups that the identifier filter
+  /// of the table ruled out.
+  unsigned NumIdentifierLookupsFiltered;
+
   /// \brief The number of selectors that have been read.
   unsigned NumSelectorsRead;
 
@@ -936,6 +947,14 @@ private:
   /// \brief The total number of method pool entries in the selector table.
   unsigned TotalNumMethodPoolEntries;
 
+  /// \brief The number of times the on-disk lookup tables of a DeclContext
+  /// have been merged, the number of tables and entries merged, and the time
+  /// it took.
+  unsigned NumLookupTableCondenses = 0;
+  unsigned NumLookupTablesCondensed = 0;
+  unsigned NumLookupTableEntriesCondensed = 0;
+  double LookupTableCondenseTime = 0;
+
   /// Number of lexical decl contexts read/total.
   unsigned NumLexicalDeclContextsRead, TotalLexicalDeclContexts;
 
@@ -1042,6 +1061,11 @@ private:
   /// when merging implicit instantiations of class templates across modules.
   llvm::DenseMap<DeclContext *, DeclContext *> MergedDeclContexts;
 
+  /// \brief The merged definitions in MergedDeclContexts whose ODR hash is
+  /// that of the definition they were merged into, so that their members
+  /// need no ODR merge check.
+  llvm::DenseSet<DeclContext *> MergedDeclContextsWithSameMembers;
+
   /// \brief A mapping from canonical declarations of enums to their canonical
   /// definitions. Only populated when using modules in C++.
   llvm::DenseMap<EnumDecl *, EnumDecl *> EnumDefinitions;
@@ -1968,6 +1992,8 @@ public:
   /// \brief Return a descriptor for the corresponding module.
   llvm::Optional<ASTSourceDescriptor> getSourceDescriptor(unsigned ID) override;
 
+  ExtKind hasExternalDefinitions(const Decl *D) override;
+
   /// \brief Retrieve a selector from the given module with its local ID
   /// number.
   Selector getLocalSelector(ModuleFile &M, unsigned LocalID);
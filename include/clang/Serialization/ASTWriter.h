@@ -187,7 +187,8 @@ private:
   /// the declaration's ID.
   std::vector<serialization::DeclOffset> DeclOffsets;
 
-  /// \brief Sorted (by file offset) vector of pairs of file offset/DeclID.
+  /// \brief Vector of pairs of file offset/DeclID, sorted by file offset once
+  /// all the declarations have been written.
   typedef SmallVector<std::pair<unsigned, serialization::DeclID>, 64>
     LocDeclIDsTy;
   struct DeclIDInFileInfo {
@@ -364,6 +365,12 @@ private:
   /// record.
   SmallVector<uint64_t, 16> EagerlyDeserializedDecls;
 
+  /// \brief The inline functions whose definitions are emitted into the
+  /// object file of the module being written, rather than into every
+  /// translation unit that uses them. Written to a MODULAR_CODEGEN_DECLS
+  /// record.
+  SmallVector<uint64_t, 16> ModularCodegenDecls;
+
   /// \brief DeclContexts that have received extensions since their serialized
   /// form.
   ///
@@ -268,6 +268,13 @@ public:
   /// IdentifierHashTable.
   void *IdentifierLookupTable;
 
+  /// \brief The bloom filter of the identifiers in IdentifierLookupTable, or
+  /// null if the AST file has none.
+  const uint32_t *IdentifierFilter;
+
+  /// \brief The number of bits in IdentifierFilter, a power of two.
+  unsigned IdentifierFilterBits;
+
   /// \brief Offsets of identifiers that we're going to preload within
   /// IdentifierTableData.
   std::vector<unsigned> PreloadIdentifierOffsets;
@@ -194,6 +194,22 @@ private:
     UMK_Deep = 2
   };
 
+  /// Describes the order in which the nodes of the exploded graph are
+  /// explored.
+  enum ExplorationStrategyKind {
+    /// Explore the most recently created node first.
+    ESK_DFS,
+    /// Explore the oldest node first.
+    ESK_BFS,
+    /// Explore the blocks in breadth-first order and their contents in
+    /// depth-first order.
+    ESK_BFSBlockDFSContents,
+    /// Explore first the nodes entering the blocks that were entered the
+    /// fewest times, for a better coverage of the function within the node
+    /// budget.
+    ESK_UnexploredFirst
+  };
+
   /// Controls the high-level analyzer mode, which influences the default 
   /// settings for some of the lower-level config options (such as IPAMode).
   /// \sa getUserMode
@@ -254,6 +270,9 @@ private:
   /// \sa getGraphTrimInterval
   Optional<unsigned> GraphTrimInterval;
 
+  /// \sa shouldTrimGraphAggressively
+  Optional<bool> TrimGraphAggressively;
+
   /// \sa getMaxTimesInlineLarge
   Optional<unsigned> MaxTimesInlineLarge;
 
@@ -269,9 +288,27 @@ private:
   /// \sa shouldWidenLoops
   Optional<bool> WidenLoops;
 
+  /// \sa shouldPruneConstantBranches
+  Optional<bool> PruneConstantBranches;
+
+  /// \sa shouldProfileCheckers
+  Optional<bool> ProfileCheckers;
+
+  /// \sa getPurgeStatementInterval
+  Optional<unsigned> PurgeStatementInterval;
+
   /// \sa shouldDisplayNotesAsEvents
   Optional<bool> DisplayNotesAsEvents;
 
+  /// \sa getShardCount
+  Optional<unsigned> ShardCount;
+
+  /// \sa getShardIndex
+  Optional<unsigned> ShardIndex;
+
+  /// \sa getExplorationStrategy
+  Optional<ExplorationStrategyKind> ExplorationStrategy;
+
   /// A helper function that retrieves option for a given full-qualified
   /// checker name.
   /// Options for checkers can be specified via 'analyzer-config' command-line
@@ -377,6 +414,13 @@ public:
   /// \brief Returns the inter-procedural analysis mode.
   IPAKind getIPAMode();
 
+  /// \brief Returns the order in which the exploded graph is explored.
+  ///
+  /// This is controlled by the 'exploration_strategy' config option, which
+  /// accepts the values "dfs" (the default), "bfs", "bfs_block_dfs_contents"
+  /// and "unexplored_first".
+  ExplorationStrategyKind getExplorationStrategy();
+
   /// Returns the option controlling which C++ member functions will be
   /// considered for inlining.
   ///
@@ -513,6 +557,14 @@ public:
   /// node reclamation, set the option to "0".
   unsigned getGraphTrimInterval();
 
+  /// Returns true if the nodes of the ExplodedGraph should be recycled even
+  /// when the path diagnostics might use them, trading the precision of the
+  /// diagnostics for memory.
+  ///
+  /// This is controlled by the 'graph-trim-aggressive' config option, which
+  /// defaults to false.
+  bool shouldTrimGraphAggressively();
+
   /// Returns the maximum times a large function could be inlined.
   ///
   /// This is controlled by the 'max-times-inline-large' config option.
@@ -540,6 +592,22 @@ public:
   /// This is controlled by the 'widen-loops' config option.
   bool shouldWidenLoops();
 
+  /// Returns true if the branches that a constant propagation over the CFG
+  /// proves are never taken should not be explored.
+  /// This is controlled by the 'prune-constant-branches' config option.
+  bool shouldPruneConstantBranches();
+
+  /// Returns true if the time spent in each checker callback should be
+  /// measured and printed at the end of the analysis.
+  /// This is controlled by the 'checker-profile' config option.
+  bool shouldProfileCheckers();
+
+  /// Returns how many statements apart the dead symbols are removed within
+  /// a basic block, when purging before every statement. Block entrances and
+  /// calls are always purged.
+  /// This is controlled by the 'purge-statement-interval' config option.
+  unsigned getPurgeStatementInterval();
+
   /// Returns true if the bug reporter should transparently treat extra note
   /// diagnostic pieces as event diagnostic pieces. Useful when the diagnostic
   /// consumer doesn't support the extra note pieces.
@@ -548,6 +616,45 @@ public:
   /// to false when unset.
   bool shouldDisplayNotesAsEvents();
 
+  /// Returns the number of shards that the analysis of the translation unit
+  /// is split into, so that several processes can analyze it in parallel.
+  /// Each process analyzes the functions of one shard, and reports the bugs
+  /// found in them.
+  ///
+  /// This is controlled by the 'shard-count' config option, which defaults
+  /// to 1.
+  unsigned getShardCount();
+
+  /// Returns the shard analyzed by this process, from 0 to the number of
+  /// shards minus one.
+  ///
+  /// This is controlled by the 'shard-index' config option, which defaults
+  /// to 0.
+  unsigned getShardIndex();
+
+  /// Returns the file to write the summaries of the functions defined in the
+  /// translation unit to, or an empty string.
+  ///
+  /// This is controlled by the 'call-summaries-output' config option, which
+  /// is unset by default.
+  StringRef getCallSummariesOutputFile();
+
+  /// Returns the file to read the summaries of the functions defined in
+  /// other translation units from, or an empty string. Calls to these
+  /// functions are then evaluated according to their summaries.
+  ///
+  /// This is controlled by the 'call-summaries' config option, which is
+  /// unset by default.
+  StringRef getCallSummariesFile();
+
+  /// Returns the file that remembers the functions whose analysis found no
+  /// bugs, so that they are skipped while they and their callees don't
+  /// change, or an empty string.
+  ///
+  /// This is controlled by the 'analysis-cache' config option, which is
+  /// unset by default.
+  StringRef getAnalysisCacheFile();
+
 public:
   AnalyzerOptions() :
     AnalysisStoreOpt(RegionStoreModel),
@@ -20,6 +20,7 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/Store.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallVector.h"
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -30,6 +31,7 @@ namespace clang {
 
 namespace ento {
   class CheckerBase;
+  class CheckerProfile;
   class CheckerRegistry;
   class ExprEngine;
   class AnalysisManager;
@@ -105,9 +107,11 @@ class CheckerManager {
   AnalyzerOptionsRef AOptions;
   CheckName CurrentCheckName;
 
+  /// The time spent in each callback of each checker, if profiling is on.
+  std::unique_ptr<CheckerProfile> Profile;
+
 public:
-  CheckerManager(const LangOptions &langOpts, AnalyzerOptionsRef AOptions)
-      : LangOpts(langOpts), AOptions(std::move(AOptions)) {}
+  CheckerManager(const LangOptions &langOpts, AnalyzerOptionsRef AOptions);
 
   ~CheckerManager();
 
@@ -121,6 +125,10 @@ public:
   const LangOptions &getLangOpts() const { return LangOpts; }
   AnalyzerOptions &getAnalyzerOptions() { return *AOptions; }
 
+  /// \brief Print the time spent in the callbacks of each checker, and how
+  /// many times they ran, if the 'checker-profile' option is on.
+  void printProfile(raw_ostream &OS) const;
+
   typedef CheckerBase *CheckerRef;
   typedef const void *CheckerTag;
   typedef CheckerFn<void ()> CheckerDtor;
@@ -20,6 +20,7 @@
 #include "clang/StaticAnalyzer/Core/BugReporter/BugReporter.h"
 #include "clang/StaticAnalyzer/Core/BugReporter/PathDiagnostic.h"
 #include "clang/StaticAnalyzer/Core/PathDiagnosticConsumers.h"
+#include "clang/StaticAnalyzer/Core/PathSensitive/CallSummary.h"
 
 namespace clang {
 
@@ -43,6 +44,9 @@ class AnalysisManager : public BugReporterData {
 
   CheckerManager *CheckerMgr;
 
+  /// The summaries of the functions defined in other translation units.
+  CallSummaryMap CallSummaries;
+
 public:
   AnalyzerOptions &options;
   
@@ -79,6 +83,8 @@ public:
 
   CheckerManager *getCheckerManager() const { return CheckerMgr; }
 
+  CallSummaryMap &getCallSummaries() { return CallSummaries; }
+
   ASTContext &getASTContext() override {
     return Ctx;
   }
@@ -48,6 +48,7 @@ enum CallEventKind {
 };
 
 class CallEvent;
+class CallSummary;
 class CallEventManager;
 
 /// This class represents a description of a function call using the number of
@@ -344,9 +345,11 @@ public:
   /// \brief Returns a new state with all argument regions invalidated.
   ///
   /// This accepts an alternate state in case some processing has already
-  /// occurred.
+  /// occurred. If the callee has a \p Summary, only the arguments it may
+  /// modify are invalidated, and globals only if it may modify them.
   ProgramStateRef invalidateRegions(unsigned BlockCount,
-                                    ProgramStateRef Orig = nullptr) const;
+                                    ProgramStateRef Orig = nullptr,
+                                    const CallSummary *Summary = nullptr) const;
 
   typedef std::pair<Loc, SVal> FrameBindingTy;
   typedef SmallVectorImpl<FrameBindingTy> BindingsTy;
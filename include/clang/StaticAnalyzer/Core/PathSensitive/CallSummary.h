@@ -0,0 +1,101 @@
+//== CallSummary.h - Side effects of functions of other TUs -------*- C++ -*-//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines CallSummary, a compact description of the side effects
+// and the return value of a function, which lets the analyzer evaluate calls
+// to functions defined in other translation units less conservatively.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_STATICANALYZER_CORE_PATHSENSITIVE_CALLSUMMARY_H
+#define LLVM_CLANG_STATICANALYZER_CORE_PATHSENSITIVE_CALLSUMMARY_H
+
+#include "clang/AST/Decl.h"
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
+#include <cstdint>
+
+namespace clang {
+
+namespace ento {
+
+/// \brief What a call to a function may do to the state of its caller.
+///
+/// The summary is computed from the body of the function without
+/// path-sensitive analysis, and is conservative: anything that cannot be
+/// proven harmless is assumed to happen.
+class CallSummary {
+public:
+  /// The parameters past this one are always assumed to be modified.
+  static const unsigned MaxParams = 32;
+
+  /// Bit I is set if the function may write through its I-th parameter, or
+  /// let the parameter escape.
+  uint32_t ModifiedParams;
+
+  /// Whether the function may write to memory not reachable from its
+  /// parameters, such as globals, for example by calling other functions.
+  bool ModifiesGlobals;
+
+  /// Whether the function returns a pointer that is never null.
+  bool ReturnsNonNull;
+
+  /// Whether the function returns an integer in [ReturnMin, ReturnMax].
+  bool HasReturnRange;
+  int64_t ReturnMin;
+  int64_t ReturnMax;
+
+  /// The summary of a function about which nothing is known.
+  CallSummary()
+      : ModifiedParams(~0u), ModifiesGlobals(true), ReturnsNonNull(false),
+        HasReturnRange(false), ReturnMin(0), ReturnMax(0) {}
+
+  bool mayModifyParam(unsigned Idx) const {
+    return Idx >= MaxParams || (ModifiedParams & (1u << Idx));
+  }
+
+  /// \brief Compute the summary of the definition of \p FD.
+  static CallSummary compute(const FunctionDecl *FD);
+
+  /// \brief Write the summary of the function with the given USR as a line.
+  void print(raw_ostream &OS, StringRef USR) const;
+
+  /// \brief Read the summaries written by print() from \p Buffer.
+  ///
+  /// \returns false if \p Buffer is malformed.
+  static bool parse(StringRef Buffer, llvm::StringMap<CallSummary> &Summaries);
+};
+
+/// \brief The summaries of the functions of other translation units that
+/// are called in this one.
+class CallSummaryMap {
+  llvm::DenseMap<const Decl *, CallSummary> Map;
+
+public:
+  void add(const Decl *D, const CallSummary &Summary) {
+    Map[D->getCanonicalDecl()] = Summary;
+  }
+
+  /// \brief Return the summary of \p D, or null if there is none.
+  const CallSummary *lookup(const Decl *D) const {
+    if (Map.empty())
+      return nullptr;
+    auto I = Map.find(D->getCanonicalDecl());
+    return I == Map.end() ? nullptr : &I->second;
+  }
+
+  bool empty() const { return Map.empty(); }
+};
+
+} // end GR namespace
+
+} // end clang namespace
+
+#endif
@@ -284,6 +284,9 @@ protected:
   /// Counter to determine when to reclaim nodes.
   unsigned ReclaimCounter;
 
+  /// Whether to also reclaim the nodes that path diagnostics may use.
+  bool AggressiveReclamation;
+
 public:
 
   /// \brief Retrieve the node associated with a (Location,State) pair,
@@ -386,8 +389,13 @@ public:
 
   /// Enable tracking of recently allocated nodes for potential reclamation
   /// when calling reclaimRecentlyAllocatedNodes().
-  void enableNodeReclamation(unsigned Interval) {
+  ///
+  /// If \p Aggressive is true, the nodes for lvalue and non-consumed
+  /// expressions are reclaimed too, although the path diagnostics may then
+  /// point less precisely into the code.
+  void enableNodeReclamation(unsigned Interval, bool Aggressive = false) {
     ReclaimCounter = ReclaimNodeInterval = Interval;
+    AggressiveReclamation = Aggressive;
   }
 
   /// Reclaim "uninteresting" nodes created since the last time this method
@@ -43,6 +43,7 @@ namespace ento {
 
 class AnalysisManager;
 class CallEvent;
+class CallSummary;
 class CXXConstructorCall;
 
 class ExprEngine : public SubEngine {
@@ -381,6 +382,11 @@ public:
   void VisitInitListExpr(const InitListExpr *E, ExplodedNode *Pred,
                          ExplodedNodeSet &Dst);
 
+  /// VisitCompactArrayInitExpr - Transfer function logic for the
+  /// initialization of an array by a long list of numeric literals.
+  void VisitCompactArrayInitExpr(const CompactArrayInitExpr *E,
+                                 ExplodedNode *Pred, ExplodedNodeSet &Dst);
+
   /// VisitLogicalExpr - Transfer function logic for '&&', '||'
   void VisitLogicalExpr(const BinaryOperator* B, ExplodedNode *Pred,
                         ExplodedNodeSet &Dst);
@@ -562,6 +568,13 @@ public:
                                   const LocationContext *LCtx,
                                   ProgramStateRef State);
 
+  /// \brief Constrain the return value bound by bindReturnValue() to what the
+  /// summary of the callee says it may be.
+  ProgramStateRef applyReturnSummary(const CallEvent &Call,
+                                     const CallSummary &Summary,
+                                     const LocationContext *LCtx,
+                                     ProgramStateRef State);
+
   /// Evaluate a call, running pre- and post-call checks and allowing checkers
   /// to be responsible for handling the evaluation of the call itself.
   void evalCall(ExplodedNodeSet &Dst, ExplodedNode *Pred,
@@ -25,6 +25,7 @@
 #include "clang/Basic/LLVM.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/SVals.h"
 #include "llvm/ADT/FoldingSet.h"
+#include "llvm/ADT/Optional.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/ErrorHandling.h"
 #include <string>
@@ -87,6 +88,11 @@ public:
 private:
   const Kind kind;
 
+  /// The offset within the top level memory object, computed on demand.
+  mutable Optional<RegionOffset> cachedOffset;
+
+  RegionOffset calculateOffset() const;
+
 protected:
   MemRegion(Kind k) : kind(k) {}
   virtual ~MemRegion();
@@ -503,6 +503,9 @@ public:
 
   llvm::BumpPtrAllocator& getAllocator() { return Alloc; }
 
+  /// Returns the number of distinct states that are alive.
+  unsigned getNumStates() const { return StateSet.size(); }
+
   MemRegionManager& getRegionManager() {
     return svalBuilder->getRegionManager();
   }
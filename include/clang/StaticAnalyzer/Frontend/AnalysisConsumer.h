@@ -15,8 +15,8 @@
 #ifndef LLVM_CLANG_STATICANALYZER_FRONTEND_ANALYSISCONSUMER_H
 #define LLVM_CLANG_STATICANALYZER_FRONTEND_ANALYSISCONSUMER_H
 
-#include "clang/AST/ASTConsumer.h"
 #include "clang/Basic/LLVM.h"
+#include "clang/Sema/SemaConsumer.h"
 #include <memory>
 
 namespace clang {
@@ -30,7 +30,9 @@ namespace ento {
 class PathDiagnosticConsumer;
 class CheckerManager;
 
-class AnalysisASTConsumer : public ASTConsumer {
+/// The analyzer is a SemaConsumer so that it can reuse the CFGs that Sema
+/// builds for the analysis-based warnings.
+class AnalysisASTConsumer : public SemaConsumer {
 public:
   virtual void AddDiagnosticConsumer(PathDiagnosticConsumer *Consumer) = 0;
 };
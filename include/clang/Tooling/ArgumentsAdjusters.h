@@ -44,6 +44,11 @@ ArgumentsAdjuster getClangSyntaxOnlyAdjuster();
 /// arguments.
 ArgumentsAdjuster getClangStripOutputAdjuster();
 
+/// \brief Gets an argument adjuster that makes the frontend skip the bodies of
+/// the functions outside the main file, except for those needed to check it,
+/// such as constexpr functions and templates.
+ArgumentsAdjuster getSkipFunctionBodiesOutsideMainFileAdjuster();
+
 enum class ArgumentInsertPosition { BEGIN, END };
 
 /// \brief Gets an argument adjuster which inserts \p Extra arguments in the
@@ -220,6 +220,19 @@ private:
   std::vector<CompileCommand> CompileCommands;
 };
 
+/// \brief Returns the files of \p Compilations that the shard \p ShardIndex
+/// of \p ShardCount runs over, for tools that split their run across
+/// processes or machines.
+///
+/// The shards partition \c getAllFiles(), each with about the same number of
+/// compile commands, and only depend on the contents of the database. The
+/// files are grouped by their include paths and forced includes, and then
+/// by path, so that the translation units that probably include the same
+/// headers run on the same shard.
+std::vector<std::string> getShardFiles(const CompilationDatabase &Compilations,
+                                       unsigned ShardCount,
+                                       unsigned ShardIndex);
+
 } // end namespace tooling
 } // end namespace clang
 
@@ -267,6 +267,9 @@ class Replacements {
 
   unsigned size() const { return Replaces.size(); }
 
+  /// \brief Returns true if \p R is one of the replacements.
+  bool contains(const Replacement &R) const { return Replaces.count(R); }
+
   void clear() { Replaces.clear(); }
 
   bool empty() const { return Replaces.empty(); }
@@ -317,6 +320,8 @@ bool applyAllReplacements(const Replacements &Replaces, Rewriter &Rewrite);
 
 /// \brief Applies all replacements in \p Replaces to \p Code.
 ///
+/// The result is built in one pass over \p Code.
+///
 /// This completely ignores the path stored in each replacement. If all
 /// replacements are applied successfully, this returns the code with
 /// replacements applied; otherwise, an llvm::Error carrying llvm::StringError
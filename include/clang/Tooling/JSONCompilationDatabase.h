@@ -56,6 +56,17 @@ namespace tooling {
 /// JSON compilation databases can for example be generated in CMake projects
 /// by setting the flag -DCMAKE_EXPORT_COMPILE_COMMANDS.
 enum class JSONCommandLineSyntax { Windows, Gnu, AutoDetect };
+
+/// \brief When the compile commands of a JSON compilation database are parsed.
+enum class JSONDatabaseLoading {
+  /// All the compile commands are parsed when the database is loaded.
+  Eager,
+  /// Loading the database only finds the files of its compile commands, and
+  /// the command lines of a file are parsed each time they are requested.
+  /// Databases that are not plain JSON are loaded eagerly.
+  Lazy
+};
+
 class JSONCompilationDatabase : public CompilationDatabase {
 public:
   /// \brief Loads a JSON compilation database from the specified file.
@@ -64,14 +75,16 @@ public:
   /// loaded from the given file.
   static std::unique_ptr<JSONCompilationDatabase>
   loadFromFile(StringRef FilePath, std::string &ErrorMessage,
-               JSONCommandLineSyntax Syntax);
+               JSONCommandLineSyntax Syntax,
+               JSONDatabaseLoading Loading = JSONDatabaseLoading::Eager);
 
   /// \brief Loads a JSON compilation database from a data buffer.
   ///
   /// Returns NULL and sets ErrorMessage if the database could not be loaded.
   static std::unique_ptr<JSONCompilationDatabase>
   loadFromBuffer(StringRef DatabaseString, std::string &ErrorMessage,
-                 JSONCommandLineSyntax Syntax);
+                 JSONCommandLineSyntax Syntax,
+                 JSONDatabaseLoading Loading = JSONDatabaseLoading::Eager);
 
   /// \brief Returns all compile commands in which the specified file was
   /// compiled.
@@ -103,6 +116,13 @@ private:
   /// failed.
   bool parse(std::string &ErrorMessage);
 
+  /// \brief Creates the index of the files without parsing their command
+  /// lines.
+  ///
+  /// Returns false if the database is not plain JSON, or not valid, in which
+  /// case it has to be parsed.
+  bool scan();
+
   // Tuple (directory, filename, commandline, output) where 'commandline'
   // points to the corresponding scalar nodes in the YAML stream.
   // If the command line contains a single argument, it is a shell-escaped
@@ -119,6 +139,10 @@ private:
   void getCommands(ArrayRef<CompileCommandRef> CommandsRef,
                    std::vector<CompileCommand> &Commands) const;
 
+  /// \brief Parses the given JSON objects of compile commands.
+  void getLazyCommands(ArrayRef<StringRef> Objects,
+                       std::vector<CompileCommand> &Commands) const;
+
   // Maps file paths to the compile command lines for that file.
   llvm::StringMap<std::vector<CompileCommandRef>> IndexByFile;
 
@@ -126,6 +150,16 @@ private:
   /// JSON stream.
   std::vector<CompileCommandRef> AllCommands;
 
+  /// Whether the database was scanned rather than parsed, in which case the
+  /// commands are found in the two members below instead of the two above.
+  bool IsLazy = false;
+
+  // Maps file paths to the text of the JSON objects of their compile commands.
+  llvm::StringMap<std::vector<StringRef>> LazyIndexByFile;
+
+  /// The text of all the JSON objects of compile commands, in order.
+  std::vector<StringRef> AllLazyCommands;
+
   FileMatchTrie MatchTrie;
 
   std::unique_ptr<llvm::MemoryBuffer> Database;
@@ -50,8 +50,12 @@ public:
   /// \brief Call run(), apply all generated replacements, and immediately save
   /// the results to disk.
   ///
+  /// \param Threads The number of translation units run at the same time,
+  /// and, when more than one, the number of files the replacements are
+  /// applied to at the same time with \c applyAllReplacementsToFiles().
+  ///
   /// \returns 0 upon success. Non-zero upon failure.
-  int runAndSave(FrontendActionFactory *ActionFactory);
+  int runAndSave(FrontendActionFactory *ActionFactory, unsigned Threads = 1);
 
   /// \brief Apply all stored replacements to the given Rewriter.
   ///
@@ -94,6 +98,46 @@ bool formatAndApplyAllReplacements(
     const std::map<std::string, Replacements> &FileToReplaces,
     Rewriter &Rewrite, StringRef Style = "file");
 
+/// \brief Applies \p FileToReplaces to the files on disk, without a Rewriter.
+///
+/// Each file is read with \p Files, built in one pass from its contents and
+/// its sorted replacements, and then atomically replaced. Up to \p Threads
+/// files are built and written at the same time.
+///
+/// FileToReplaces will be deduplicated with `groupReplacementsByFile` before
+/// application.
+///
+/// \returns true if all replacements applied and all the files were written.
+/// false otherwise.
+bool applyAllReplacementsToFiles(
+    FileManager &Files,
+    const std::map<std::string, Replacements> &FileToReplaces,
+    unsigned Threads = 1);
+
+/// \brief Adds \p Other, the replacements of another run of a tool such as
+/// another shard of a distributed run, to \p FileToReplaces.
+///
+/// The replacements that are in both, which the shards make in the headers
+/// they share, are only kept once.
+///
+/// \returns An error if a replacement of \p Other conflicts with those of
+/// \p FileToReplaces, which are then partially merged.
+llvm::Error
+mergeReplacements(std::map<std::string, Replacements> &FileToReplaces,
+                  const std::map<std::string, Replacements> &Other);
+
+/// \brief Writes \p FileToReplaces as the YAML of a
+/// \c TranslationUnitReplacements, which \c readReplacements() reads back.
+void writeReplacements(
+    llvm::raw_ostream &OS,
+    const std::map<std::string, Replacements> &FileToReplaces);
+
+/// \brief Reads the replacements written by \c writeReplacements() and
+/// merges them into \p FileToReplaces with \c mergeReplacements().
+llvm::Error
+readReplacements(StringRef YAML,
+                 std::map<std::string, Replacements> &FileToReplaces);
+
 } // end namespace tooling
 } // end namespace clang
 
@@ -291,10 +291,16 @@ class ClangTool {
   ///        not found in Compilations, it is skipped.
   /// \param PCHContainerOps The PCHContainerOperations for loading and creating
   /// clang modules.
+  /// \param BaseFS The file system the files are read from. Tools that run
+  /// a ClangTool on each of several threads can pass each one a
+  /// vfs::SharedCacheFileSystem over the same vfs::SharedFileCache, so that
+  /// every file is looked up and read once for all the threads.
   ClangTool(const CompilationDatabase &Compilations,
             ArrayRef<std::string> SourcePaths,
             std::shared_ptr<PCHContainerOperations> PCHContainerOps =
-                std::make_shared<PCHContainerOperations>());
+                std::make_shared<PCHContainerOperations>(),
+            IntrusiveRefCntPtr<vfs::FileSystem> BaseFS =
+                vfs::getRealFileSystem());
 
   ~ClangTool();
 
@@ -321,18 +327,36 @@ class ClangTool {
   /// Runs an action over all files specified in the command line.
   ///
   /// \param Action Tool action.
-  int run(ToolAction *Action);
+  /// \param Threads The number of translation units run at the same time.
+  /// When it is more than one, the compile commands are all computed before
+  /// the first one runs, and \p Action is called from several threads. Each
+  /// translation unit then has its own file manager, and the files are read
+  /// through a cache shared by all of them. The diagnostics are forwarded to
+  /// the \c DiagnosticConsumer one at a time, and those printed by default
+  /// are written one translation unit at a time.
+  int run(ToolAction *Action, unsigned Threads = 1);
 
   /// \brief Create an AST for each file specified in the command line and
   /// append them to ASTs.
-  int buildASTs(std::vector<std::unique_ptr<ASTUnit>> &ASTs);
+  ///
+  /// The ASTs are in the order of the files, whatever \p Threads is. See
+  /// \c run() for the meaning of \p Threads.
+  int buildASTs(std::vector<std::unique_ptr<ASTUnit>> &ASTs,
+                unsigned Threads = 1);
 
   /// \brief Returns the file manager used in the tool.
   ///
-  /// The file manager is shared between all translation units.
+  /// The file manager is shared between all translation units run on the
+  /// calling thread.
   FileManager &getFiles() { return *Files; }
 
  private:
+  /// \brief Runs the translation units on \p Threads threads, running each
+  /// with the action returned by \p NextAction, which is called for each of
+  /// them in turn before any runs.
+  int runConcurrently(const std::function<ToolAction *()> &NextAction,
+                      unsigned Threads);
+
   const CompilationDatabase &Compilations;
   std::vector<std::string> SourcePaths;
   std::shared_ptr<PCHContainerOperations> PCHContainerOps;
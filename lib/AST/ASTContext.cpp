@@ -13,6 +13,7 @@
 
 #include "clang/AST/ASTContext.h"
 #include "CXXABI.h"
+#include "ConstexprBytecode.h"
 #include "clang/AST/ASTMutationListener.h"
 #include "clang/AST/Attr.h"
 #include "clang/AST/CharUnits.h"
@@ -55,6 +56,8 @@ unsigned ASTContext::NumImplicitMoveAssignmentOperators;
 unsigned ASTContext::NumImplicitMoveAssignmentOperatorsDeclared;
 unsigned ASTContext::NumImplicitDestructors;
 unsigned ASTContext::NumImplicitDestructorsDeclared;
+unsigned ASTContext::NumConstexprCallLookups;
+unsigned ASTContext::NumConstexprCallCacheHits;
 
 enum FloatingRank {
   HalfRank, FloatRank, DoubleRank, LongDoubleRank, Float128Rank
@@ -796,24 +799,24 @@ ASTContext::~ASTContext() {
     Value.second->~PerModuleInitializers();
 }
 
-void ASTContext::ReleaseParentMapEntries() {
-  if (!PointerParents) return;
-  for (const auto &Entry : *PointerParents) {
-    if (Entry.second.is<ast_type_traits::DynTypedNode *>()) {
-      delete Entry.second.get<ast_type_traits::DynTypedNode *>();
-    } else if (Entry.second.is<ParentVector *>()) {
-      delete Entry.second.get<ParentVector *>();
-    }
-  }
-  for (const auto &Entry : *OtherParents) {
-    if (Entry.second.is<ast_type_traits::DynTypedNode *>()) {
-      delete Entry.second.get<ast_type_traits::DynTypedNode *>();
-    } else if (Entry.second.is<ParentVector *>()) {
-      delete Entry.second.get<ParentVector *>();
+template <typename MapTy> static void releaseParentMapEntries(MapTy *Map) {
+  if (!Map) return;
+  for (const auto &Entry : *Map) {
+    if (Entry.second.template is<ast_type_traits::DynTypedNode *>()) {
+      delete Entry.second.template get<ast_type_traits::DynTypedNode *>();
+    } else if (Entry.second.template is<ASTContext::ParentVector *>()) {
+      delete Entry.second.template get<ASTContext::ParentVector *>();
     }
   }
 }
 
+void ASTContext::ReleaseParentMapEntries() {
+  releaseParentMapEntries(PointerParents.get());
+  releaseParentMapEntries(OtherParents.get());
+  releaseParentMapEntries(ScopedPointerParents.get());
+  releaseParentMapEntries(ScopedOtherParents.get());
+}
+
 void ASTContext::AddDeallocation(void (*Callback)(void*), void *Data) {
   Deallocations.push_back({Callback, Data});
 }
@@ -873,6 +876,12 @@ void ASTContext::PrintStats() const {
   llvm::errs() << NumImplicitDestructorsDeclared << "/"
                << NumImplicitDestructors
                << " implicit destructors created\n";
+  if (getLangOpts().CPlusPlus11)
+    llvm::errs() << NumConstexprCallCacheHits << "/"
+                 << NumConstexprCallLookups
+                 << " constexpr calls found in the call cache\n";
+  if (Bytecode)
+    Bytecode->PrintStats();
 
   if (ExternalSource) {
     llvm::errs() << "\n";
@@ -2454,26 +2463,20 @@ QualType ASTContext::getComplexType(QualType T) const {
 QualType ASTContext::getPointerType(QualType T) const {
   // Unique pointers, to guarantee there is only one pointer of a particular
   // structure.
-  llvm::FoldingSetNodeID ID;
-  PointerType::Profile(ID, T);
-
-  void *InsertPos = nullptr;
-  if (PointerType *PT = PointerTypes.FindNodeOrInsertPos(ID, InsertPos))
-    return QualType(PT, 0);
+  auto Known = PointerTypes.find(T);
+  if (Known != PointerTypes.end())
+    return QualType(Known->second, 0);
 
   // If the pointee type isn't canonical, this won't be a canonical type either,
   // so fill in the canonical type field.
   QualType Canonical;
-  if (!T.isCanonical()) {
+  if (!T.isCanonical())
     Canonical = getPointerType(getCanonicalType(T));
 
-    // Get the new insert position for the node we care about.
-    PointerType *NewIP = PointerTypes.FindNodeOrInsertPos(ID, InsertPos);
-    assert(!NewIP && "Shouldn't be in the map!"); (void)NewIP;
-  }
+  // The recursive call may have grown the map, so insert only now.
   PointerType *New = new (*this, TypeAlignment) PointerType(T, Canonical);
   Types.push_back(New);
-  PointerTypes.InsertNode(New, InsertPos);
+  PointerTypes[T] = New;
   return QualType(New, 0);
 }
 
@@ -2578,13 +2581,10 @@ ASTContext::getLValueReferenceType(QualType T, bool SpelledAsLValue) const {
   
   // Unique pointers, to guarantee there is only one pointer of a particular
   // structure.
-  llvm::FoldingSetNodeID ID;
-  ReferenceType::Profile(ID, T, SpelledAsLValue);
-
-  void *InsertPos = nullptr;
-  if (LValueReferenceType *RT =
-        LValueReferenceTypes.FindNodeOrInsertPos(ID, InsertPos))
-    return QualType(RT, 0);
+  auto Key = std::make_pair(T, unsigned(SpelledAsLValue));
+  auto Known = LValueReferenceTypes.find(Key);
+  if (Known != LValueReferenceTypes.end())
+    return QualType(Known->second, 0);
 
   const ReferenceType *InnerRef = T->getAs<ReferenceType>();
 
@@ -2594,18 +2594,14 @@ ASTContext::getLValueReferenceType(QualType T, bool SpelledAsLValue) const {
   if (!SpelledAsLValue || InnerRef || !T.isCanonical()) {
     QualType PointeeType = (InnerRef ? InnerRef->getPointeeType() : T);
     Canonical = getLValueReferenceType(getCanonicalType(PointeeType));
-
-    // Get the new insert position for the node we care about.
-    LValueReferenceType *NewIP =
-      LValueReferenceTypes.FindNodeOrInsertPos(ID, InsertPos);
-    assert(!NewIP && "Shouldn't be in the map!"); (void)NewIP;
+    assert(!LValueReferenceTypes.count(Key) && "Shouldn't be in the map!");
   }
 
   LValueReferenceType *New
     = new (*this, TypeAlignment) LValueReferenceType(T, Canonical,
                                                      SpelledAsLValue);
   Types.push_back(New);
-  LValueReferenceTypes.InsertNode(New, InsertPos);
+  LValueReferenceTypes[Key] = New;
 
   return QualType(New, 0);
 }
@@ -2615,13 +2611,9 @@ ASTContext::getLValueReferenceType(QualType T, bool SpelledAsLValue) const {
 QualType ASTContext::getRValueReferenceType(QualType T) const {
   // Unique pointers, to guarantee there is only one pointer of a particular
   // structure.
-  llvm::FoldingSetNodeID ID;
-  ReferenceType::Profile(ID, T, false);
-
-  void *InsertPos = nullptr;
-  if (RValueReferenceType *RT =
-        RValueReferenceTypes.FindNodeOrInsertPos(ID, InsertPos))
-    return QualType(RT, 0);
+  auto Known = RValueReferenceTypes.find(T);
+  if (Known != RValueReferenceTypes.end())
+    return QualType(Known->second, 0);
 
   const ReferenceType *InnerRef = T->getAs<ReferenceType>();
 
@@ -2631,17 +2623,13 @@ QualType ASTContext::getRValueReferenceType(QualType T) const {
   if (InnerRef || !T.isCanonical()) {
     QualType PointeeType = (InnerRef ? InnerRef->getPointeeType() : T);
     Canonical = getRValueReferenceType(getCanonicalType(PointeeType));
-
-    // Get the new insert position for the node we care about.
-    RValueReferenceType *NewIP =
-      RValueReferenceTypes.FindNodeOrInsertPos(ID, InsertPos);
-    assert(!NewIP && "Shouldn't be in the map!"); (void)NewIP;
+    assert(!RValueReferenceTypes.count(T) && "Shouldn't be in the map!");
   }
 
   RValueReferenceType *New
     = new (*this, TypeAlignment) RValueReferenceType(T, Canonical);
   Types.push_back(New);
-  RValueReferenceTypes.InsertNode(New, InsertPos);
+  RValueReferenceTypes[T] = New;
   return QualType(New, 0);
 }
 
@@ -8857,9 +8845,32 @@ static GVALinkage adjustGVALinkageForAttributes(const ASTContext &Context,
   return L;
 }
 
+static GVALinkage
+adjustGVALinkageForExternalDefinitionKind(const ASTContext &Context,
+                                          GVALinkage L, const Decl *D) {
+  // An inline function of a module built with -fmodules-codegen is emitted
+  // once, by the compilation of the module itself; importers only need it
+  // for inlining.
+  ExternalASTSource *Source = Context.getExternalSource();
+  if (!Source || (L != GVA_DiscardableODR && L != GVA_StrongODR))
+    return L;
+  switch (Source->hasExternalDefinitions(D)) {
+  case ExternalASTSource::EK_Always:
+    return GVA_AvailableExternally;
+  case ExternalASTSource::EK_Never:
+    return GVA_StrongODR;
+  case ExternalASTSource::EK_ReplyHazy:
+    break;
+  }
+  return L;
+}
+
 GVALinkage ASTContext::GetGVALinkageForFunction(const FunctionDecl *FD) const {
   return adjustGVALinkageForAttributes(
-      *this, basicGVALinkageForFunction(*this, FD), FD);
+      *this,
+      adjustGVALinkageForExternalDefinitionKind(
+          *this, basicGVALinkageForFunction(*this, FD), FD),
+      FD);
 }
 
 static GVALinkage basicGVALinkageForVariable(const ASTContext &Context,
@@ -9112,6 +9123,9 @@ size_t ASTContext::getSideTableAllocatedMemory() const {
          llvm::capacity_in_bytes(InstantiatedFromUnnamedFieldDecl) +
          llvm::capacity_in_bytes(OverriddenMethods) +
          llvm::capacity_in_bytes(Types) +
+         llvm::capacity_in_bytes(PointerTypes) +
+         llvm::capacity_in_bytes(LValueReferenceTypes) +
+         llvm::capacity_in_bytes(RValueReferenceTypes) +
          llvm::capacity_in_bytes(VariableArrayTypes) +
          llvm::capacity_in_bytes(ClassScopeSpecializationPattern);
 }
@@ -9242,6 +9256,12 @@ ASTContext::getMaterializedTemporaryValue(const MaterializeTemporaryExpr *E,
   return MaterializedTemporaryValues.lookup(E);
 }
 
+ConstexprBytecode &ASTContext::getConstexprBytecode() {
+  if (!Bytecode)
+    Bytecode.reset(new ConstexprBytecode(*this));
+  return *Bytecode;
+}
+
 bool ASTContext::AtomicUsesUnsupportedLibcall(const AtomicExpr *E) const {
   const llvm::Triple &T = getTargetInfo().getTriple();
   if (!T.isOSDarwin())
@@ -9298,15 +9318,21 @@ createDynTypedNode(const NestedNameSpecifierLoc &Node) {
   /// FIXME: Currently only builds up the map using \c Stmt and \c Decl nodes.
   class ParentMapASTVisitor : public RecursiveASTVisitor<ParentMapASTVisitor> {
   public:
-    /// \brief Builds and returns the translation unit's parent map.
+    /// \brief Builds and returns the parent map of the subtree of \p Root,
+    /// usually the translation unit.
+    ///
+    /// \p Root is given the parent \p RootParent, if any.
     ///
     ///  The caller takes ownership of the returned \c ParentMap.
     static std::pair<ASTContext::ParentMapPointers *,
                      ASTContext::ParentMapOtherNodes *>
-    buildMap(TranslationUnitDecl &TU) {
+    buildMap(Decl &Root, const Decl *RootParent = nullptr) {
       ParentMapASTVisitor Visitor(new ASTContext::ParentMapPointers,
                                   new ASTContext::ParentMapOtherNodes);
-      Visitor.TraverseDecl(&TU);
+      if (RootParent)
+        Visitor.ParentStack.push_back(
+            ast_type_traits::DynTypedNode::create(*RootParent));
+      Visitor.TraverseDecl(&Root);
       return std::make_pair(Visitor.Parents, Visitor.OtherParents);
     }
 
@@ -9430,8 +9456,38 @@ static ASTContext::DynTypedNodeList getDynNodeFromMap(const NodeTy &Node,
   return getSingleDynTypedNodeFromParentMap(I->second);
 }
 
+void ASTContext::setParentMapScope(const Decl *Root) {
+  if (Root == ParentMapScope)
+    return;
+  releaseParentMapEntries(ScopedPointerParents.get());
+  releaseParentMapEntries(ScopedOtherParents.get());
+  ScopedPointerParents.reset();
+  ScopedOtherParents.reset();
+  ParentMapScope = Root;
+}
+
 ASTContext::DynTypedNodeList
 ASTContext::getParents(const ast_type_traits::DynTypedNode &Node) {
+  if (ParentMapScope) {
+    if (!ScopedPointerParents) {
+      const Decl *RootParent = nullptr;
+      if (const DeclContext *DC = ParentMapScope->getLexicalDeclContext())
+        RootParent = cast<Decl>(DC);
+      auto Maps = ParentMapASTVisitor::buildMap(
+          *const_cast<Decl *>(ParentMapScope), RootParent);
+      ScopedPointerParents.reset(Maps.first);
+      ScopedOtherParents.reset(Maps.second);
+    }
+    DynTypedNodeList Parents =
+        Node.getNodeKind().hasPointerIdentity()
+            ? getDynNodeFromMap(Node.getMemoizationData(),
+                                *ScopedPointerParents)
+            : getDynNodeFromMap(Node, *ScopedOtherParents);
+    // The translation unit has no parents, so there is no need to build the
+    // whole map to find out.
+    if (!Parents.empty() || Node.get<TranslationUnitDecl>())
+      return Parents;
+  }
   if (!PointerParents) {
     // We always need to run over the whole translation unit, as
     // hasAncestor can escape any subtree.
@@ -517,6 +517,7 @@ namespace  {
     void VisitFloatingLiteral(const FloatingLiteral *Node);
     void VisitStringLiteral(const StringLiteral *Str);
     void VisitInitListExpr(const InitListExpr *ILE);
+    void VisitCompactArrayInitExpr(const CompactArrayInitExpr *E);
     void VisitArrayInitLoopExpr(const ArrayInitLoopExpr *ILE);
     void VisitArrayInitIndexExpr(const ArrayInitIndexExpr *ILE);
     void VisitUnaryOperator(const UnaryOperator *Node);
@@ -2036,6 +2037,16 @@ void ASTDumper::VisitInitListExpr(const InitListExpr *ILE) {
   }
 }
 
+void ASTDumper::VisitCompactArrayInitExpr(const CompactArrayInitExpr *E) {
+  VisitExpr(E);
+  OS << " " << E->getNumElements() << " elements of "
+     << E->getElementByteWidth() << " bytes";
+  dumpChild([=] {
+    OS << "syntactic form";
+    dumpStmt(E->getSyntacticForm());
+  });
+}
+
 void ASTDumper::VisitArrayInitLoopExpr(const ArrayInitLoopExpr *E) {
   VisitExpr(E);
 }
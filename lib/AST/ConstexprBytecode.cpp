@@ -0,0 +1,850 @@
+//===--- ConstexprBytecode.cpp - Bytecode for constexpr functions ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the compiler from the bodies of constexpr functions to
+// bytecode, and the interpreter that evaluates it.
+//
+// Registers hold values of integer and enumeration types of up to 64 bits,
+// sign extended for signed types and zero extended for unsigned types. Every
+// instruction that produces a value normalizes it to the type of the
+// instruction, so registers always hold a canonical value.
+//
+// The compiled code takes an evaluation step wherever the AST evaluator takes
+// one, and gives up wherever the AST evaluator would produce a note, so a call
+// that the interpreter evaluates has the same result and the same cost as one
+// that the AST evaluator walks.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ConstexprBytecode.h"
+#include "clang/AST/APValue.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/AST/DeclCXX.h"
+#include "clang/AST/Expr.h"
+#include "clang/AST/ExprCXX.h"
+#include "clang/AST/Stmt.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace clang;
+
+namespace {
+enum Opcode : uint8_t {
+  /// Take an evaluation step, or give up if there are none left.
+  OP_Step,
+  /// Dst = Constants[A].
+  OP_Const,
+  /// Dst = A.
+  OP_Move,
+  /// Dst = A op B, giving up where the AST evaluator diagnoses the operation.
+  OP_Add, OP_Sub, OP_Mul, OP_Div, OP_Rem, OP_Shl, OP_Shr, OP_And, OP_Or,
+  OP_Xor, OP_LT, OP_GT, OP_LE, OP_GE, OP_EQ, OP_NE,
+  /// Dst = op A.
+  OP_Neg, OP_Not, OP_LNot, OP_Cast, OP_ToBool,
+  /// ++Dst and --Dst.
+  OP_Inc, OP_Dec,
+  /// Continue at the instruction Dst, unconditionally or depending on A.
+  OP_Jump, OP_JumpIfZero, OP_JumpIfNonZero,
+  /// Return A.
+  OP_Return,
+  /// Give up.
+  OP_Fail
+};
+
+/// The integer type an instruction operates in.
+struct IntType {
+  unsigned Width = 64;
+  bool Signed = true;
+};
+
+struct Instr {
+  Opcode Op;
+  uint8_t Width;
+  bool Signed;
+  /// For OP_Inc and OP_Dec, whether wrapping around is an overflow.
+  bool Overflows;
+  unsigned Dst;
+  unsigned A;
+  unsigned B;
+};
+} // end anonymous namespace
+
+class ConstexprBytecode::Function {
+public:
+  SmallVector<Instr, 32> Code;
+  SmallVector<int64_t, 8> Constants;
+  SmallVector<IntType, 4> Params;
+  unsigned NumRegs = 0;
+};
+
+static bool getIntType(const ASTContext &Ctx, QualType T, IntType &Result) {
+  if (T.isVolatileQualified() || !T->isIntegralOrEnumerationType())
+    return false;
+  Result.Width = Ctx.getIntWidth(T);
+  Result.Signed = T->isSignedIntegerOrEnumerationType();
+  return Result.Width && Result.Width <= 64;
+}
+
+/// Truncate \p Value to \p Width bits, and extend it back to 64 bits.
+static int64_t normalize(uint64_t Value, unsigned Width, bool Signed) {
+  if (Width == 64)
+    return Value;
+  if (Signed)
+    return llvm::SignExtend64(Value, Width);
+  return Value & ((uint64_t(1) << Width) - 1);
+}
+
+static int64_t minSigned(unsigned Width) {
+  return Width == 64 ? INT64_MIN : -(int64_t(1) << (Width - 1));
+}
+
+static int64_t maxSigned(unsigned Width) {
+  return Width == 64 ? INT64_MAX : (int64_t(1) << (Width - 1)) - 1;
+}
+
+static bool fitsSigned(int64_t Value, unsigned Width) {
+  return normalize(Value, Width, true) == Value;
+}
+
+//===----------------------------------------------------------------------===//
+// Compiler
+//===----------------------------------------------------------------------===//
+
+namespace {
+class Compiler {
+  ASTContext &Ctx;
+  ConstexprBytecode::Function &F;
+
+  /// The registers of the parameters and the local variables in scope.
+  llvm::DenseMap<const VarDecl *, unsigned> Locals;
+
+  /// The jumps out of each enclosing loop, and to its next iteration.
+  struct Loop {
+    SmallVector<unsigned, 4> Breaks;
+    SmallVector<unsigned, 4> Continues;
+  };
+  SmallVector<Loop, 4> Loops;
+
+  IntType ReturnType;
+
+public:
+  Compiler(ASTContext &Ctx, ConstexprBytecode::Function &F) : Ctx(Ctx), F(F) {}
+
+  bool compileFunction(const FunctionDecl *FD, const Stmt *Body);
+
+private:
+  unsigned newReg() { return F.NumRegs++; }
+
+  unsigned emit(Opcode Op, IntType T, unsigned Dst, unsigned A = 0,
+                unsigned B = 0, bool Overflows = false) {
+    F.Code.push_back({Op, static_cast<uint8_t>(T.Width), T.Signed, Overflows,
+                      Dst, A, B});
+    return F.Code.size() - 1;
+  }
+
+  unsigned emitJump(Opcode Op, unsigned Cond = 0) {
+    return emit(Op, IntType(), /*Dst=*/0, Cond);
+  }
+
+  /// Make the jump \p Jump continue at the next instruction.
+  void patch(unsigned Jump) { F.Code[Jump].Dst = F.Code.size(); }
+
+  void endLoop(unsigned ContinueTarget) {
+    for (unsigned Jump : Loops.back().Continues)
+      F.Code[Jump].Dst = ContinueTarget;
+    for (unsigned Jump : Loops.back().Breaks)
+      patch(Jump);
+    Loops.pop_back();
+  }
+
+  unsigned constant(uint64_t Value, IntType T) {
+    unsigned Reg = newReg();
+    F.Constants.push_back(normalize(Value, T.Width, T.Signed));
+    emit(OP_Const, T, Reg, F.Constants.size() - 1);
+    return Reg;
+  }
+
+  bool stmt(const Stmt *S);
+  bool ignored(const Expr *E);
+  bool rvalue(const Expr *E, unsigned &Reg);
+  bool lvalue(const Expr *E, unsigned &Reg);
+  bool incDec(const UnaryOperator *E, unsigned Var);
+};
+} // end anonymous namespace
+
+bool Compiler::compileFunction(const FunctionDecl *FD, const Stmt *Body) {
+  if (FD->isVariadic() || !getIntType(Ctx, FD->getReturnType(), ReturnType))
+    return false;
+  for (const ParmVarDecl *PVD : FD->parameters()) {
+    IntType T;
+    if (!getIntType(Ctx, PVD->getType(), T))
+      return false;
+    F.Params.push_back(T);
+    Locals[PVD] = newReg();
+  }
+  if (!stmt(Body))
+    return false;
+  // Leave flowing off the end of the function to the AST evaluator to
+  // diagnose.
+  emit(OP_Fail, IntType(), 0);
+  return true;
+}
+
+bool Compiler::stmt(const Stmt *S) {
+  emit(OP_Step, IntType(), 0);
+
+  switch (S->getStmtClass()) {
+  default:
+    if (const Expr *E = dyn_cast<Expr>(S))
+      return ignored(E);
+    return false;
+
+  case Stmt::NullStmtClass:
+    return true;
+
+  case Stmt::CompoundStmtClass:
+    for (const Stmt *Child : cast<CompoundStmt>(S)->body())
+      if (!stmt(Child))
+        return false;
+    return true;
+
+  case Stmt::DeclStmtClass:
+    for (const Decl *D : cast<DeclStmt>(S)->decls()) {
+      if (isa<TypedefNameDecl>(D) || isa<StaticAssertDecl>(D))
+        continue;
+      const VarDecl *VD = dyn_cast<VarDecl>(D);
+      IntType T;
+      unsigned Value;
+      if (!VD || !VD->hasLocalStorage() || !VD->getInit() ||
+          !getIntType(Ctx, VD->getType(), T) || !rvalue(VD->getInit(), Value))
+        return false;
+      // The variable only comes into scope once it is initialized, so reads
+      // of it from its own initializer are left to the AST evaluator.
+      unsigned Reg = newReg();
+      emit(OP_Move, T, Reg, Value);
+      Locals[VD] = Reg;
+    }
+    return true;
+
+  case Stmt::ReturnStmtClass: {
+    const Expr *E = cast<ReturnStmt>(S)->getRetValue();
+    unsigned Value;
+    if (!E || !rvalue(E, Value))
+      return false;
+    emit(OP_Return, ReturnType, 0, Value);
+    return true;
+  }
+
+  case Stmt::IfStmtClass: {
+    const IfStmt *IS = cast<IfStmt>(S);
+    unsigned Cond;
+    if (IS->getConditionVariable() || !IS->getThen() ||
+        (IS->getInit() && !stmt(IS->getInit())) || !rvalue(IS->getCond(), Cond))
+      return false;
+    unsigned SkipThen = emitJump(OP_JumpIfZero, Cond);
+    if (!stmt(IS->getThen()))
+      return false;
+    if (const Stmt *Else = IS->getElse()) {
+      unsigned SkipElse = emitJump(OP_Jump);
+      patch(SkipThen);
+      if (!stmt(Else))
+        return false;
+      patch(SkipElse);
+    } else {
+      patch(SkipThen);
+    }
+    return true;
+  }
+
+  case Stmt::WhileStmtClass: {
+    const WhileStmt *WS = cast<WhileStmt>(S);
+    unsigned Top = F.Code.size();
+    unsigned Cond;
+    if (WS->getConditionVariable() || !rvalue(WS->getCond(), Cond))
+      return false;
+    unsigned Exit = emitJump(OP_JumpIfZero, Cond);
+    Loops.emplace_back();
+    if (!stmt(WS->getBody()))
+      return false;
+    F.Code[emitJump(OP_Jump)].Dst = Top;
+    endLoop(Top);
+    patch(Exit);
+    return true;
+  }
+
+  case Stmt::DoStmtClass: {
+    const DoStmt *DS = cast<DoStmt>(S);
+    unsigned Top = F.Code.size();
+    Loops.emplace_back();
+    if (!stmt(DS->getBody()))
+      return false;
+    unsigned Next = F.Code.size();
+    unsigned Cond;
+    if (!rvalue(DS->getCond(), Cond))
+      return false;
+    F.Code[emitJump(OP_JumpIfNonZero, Cond)].Dst = Top;
+    endLoop(Next);
+    return true;
+  }
+
+  case Stmt::ForStmtClass: {
+    const ForStmt *FS = cast<ForStmt>(S);
+    if (FS->getConditionVariable() || (FS->getInit() && !stmt(FS->getInit())))
+      return false;
+    unsigned Top = F.Code.size();
+    unsigned Cond;
+    bool HasExit = FS->getCond() != nullptr;
+    if (HasExit && !rvalue(FS->getCond(), Cond))
+      return false;
+    unsigned Exit = HasExit ? emitJump(OP_JumpIfZero, Cond) : 0;
+    Loops.emplace_back();
+    if (!stmt(FS->getBody()))
+      return false;
+    unsigned Next = F.Code.size();
+    if (FS->getInc() && !ignored(FS->getInc()))
+      return false;
+    F.Code[emitJump(OP_Jump)].Dst = Top;
+    endLoop(Next);
+    if (HasExit)
+      patch(Exit);
+    return true;
+  }
+
+  case Stmt::BreakStmtClass:
+    if (Loops.empty())
+      return false;
+    Loops.back().Breaks.push_back(emitJump(OP_Jump));
+    return true;
+
+  case Stmt::ContinueStmtClass:
+    if (Loops.empty())
+      return false;
+    Loops.back().Continues.push_back(emitJump(OP_Jump));
+    return true;
+  }
+}
+
+bool Compiler::ignored(const Expr *E) {
+  E = E->IgnoreParens();
+  if (const CastExpr *CE = dyn_cast<CastExpr>(E))
+    if (CE->getCastKind() == CK_ToVoid)
+      return ignored(CE->getSubExpr());
+  unsigned Reg;
+  return E->isLValue() ? lvalue(E, Reg) : rvalue(E, Reg);
+}
+
+bool Compiler::rvalue(const Expr *E, unsigned &Reg) {
+  IntType T;
+  if (!E->isRValue() || !getIntType(Ctx, E->getType(), T))
+    return false;
+  E = E->IgnoreParens();
+
+  switch (E->getStmtClass()) {
+  default:
+    return false;
+
+  case Stmt::IntegerLiteralClass:
+    Reg = constant(cast<IntegerLiteral>(E)->getValue().getZExtValue(), T);
+    return true;
+
+  case Stmt::CharacterLiteralClass:
+    Reg = constant(cast<CharacterLiteral>(E)->getValue(), T);
+    return true;
+
+  case Stmt::CXXBoolLiteralExprClass:
+    Reg = constant(cast<CXXBoolLiteralExpr>(E)->getValue(), T);
+    return true;
+
+  case Stmt::DeclRefExprClass: {
+    const EnumConstantDecl *ECD =
+        dyn_cast<EnumConstantDecl>(cast<DeclRefExpr>(E)->getDecl());
+    if (!ECD || ECD->getInitVal().getBitWidth() > 64)
+      return false;
+    // Like the AST evaluator, extend the value of the enumerator as a value of
+    // the type of the expression.
+    const llvm::APSInt &Value = ECD->getInitVal();
+    Reg = constant(normalize(Value.getZExtValue(), Value.getBitWidth(),
+                             T.Signed),
+                   T);
+    return true;
+  }
+
+  case Stmt::SubstNonTypeTemplateParmExprClass:
+    return rvalue(cast<SubstNonTypeTemplateParmExpr>(E)->getReplacement(), Reg);
+
+  case Stmt::UnaryExprOrTypeTraitExprClass: {
+    // The operand of sizeof and alignof is not evaluated, so the AST
+    // evaluator takes no steps for it.
+    const UnaryExprOrTypeTraitExpr *UE = cast<UnaryExprOrTypeTraitExpr>(E);
+    llvm::APSInt Value;
+    if (UE->getTypeOfArgument()->isVariablyModifiedType() ||
+        !UE->EvaluateAsInt(Value, Ctx))
+      return false;
+    Reg = constant(Value.getZExtValue(), T);
+    return true;
+  }
+
+  case Stmt::InitListExprClass: {
+    const InitListExpr *ILE = cast<InitListExpr>(E);
+    if (ILE->getNumInits() == 0) {
+      Reg = constant(0, T);
+      return true;
+    }
+    return ILE->getNumInits() == 1 && rvalue(ILE->getInit(0), Reg);
+  }
+
+  case Stmt::ImplicitCastExprClass:
+  case Stmt::CStyleCastExprClass:
+  case Stmt::CXXFunctionalCastExprClass:
+  case Stmt::CXXStaticCastExprClass: {
+    const CastExpr *CE = cast<CastExpr>(E);
+    unsigned Src;
+    switch (CE->getCastKind()) {
+    default:
+      return false;
+    case CK_NoOp:
+      return rvalue(CE->getSubExpr(), Reg);
+    case CK_LValueToRValue:
+      // Copy the value, so that a later change to the variable in the same
+      // expression cannot affect it.
+      if (!lvalue(CE->getSubExpr(), Src))
+        return false;
+      Reg = newReg();
+      emit(OP_Move, T, Reg, Src);
+      return true;
+    case CK_IntegralCast:
+      if (!rvalue(CE->getSubExpr(), Src))
+        return false;
+      Reg = newReg();
+      emit(OP_Cast, T, Reg, Src);
+      return true;
+    case CK_IntegralToBoolean:
+      if (!rvalue(CE->getSubExpr(), Src))
+        return false;
+      Reg = newReg();
+      emit(OP_ToBool, T, Reg, Src);
+      return true;
+    }
+  }
+
+  case Stmt::UnaryOperatorClass: {
+    const UnaryOperator *UO = cast<UnaryOperator>(E);
+    unsigned Src;
+    Opcode Op;
+    switch (UO->getOpcode()) {
+    default:
+      return false;
+    case UO_Plus:
+      return rvalue(UO->getSubExpr(), Reg);
+    case UO_PostInc:
+    case UO_PostDec:
+      if (!lvalue(UO->getSubExpr(), Src))
+        return false;
+      Reg = newReg();
+      emit(OP_Move, T, Reg, Src);
+      return incDec(UO, Src);
+    case UO_Minus: Op = OP_Neg; break;
+    case UO_Not: Op = OP_Not; break;
+    case UO_LNot: Op = OP_LNot; break;
+    }
+    if (!rvalue(UO->getSubExpr(), Src))
+      return false;
+    Reg = newReg();
+    emit(Op, T, Reg, Src);
+    return true;
+  }
+
+  case Stmt::BinaryOperatorClass: {
+    const BinaryOperator *BO = cast<BinaryOperator>(E);
+    unsigned LHS, RHS;
+    Opcode Op;
+    switch (BO->getOpcode()) {
+    default:
+      return false;
+    case BO_Comma:
+      return ignored(BO->getLHS()) && rvalue(BO->getRHS(), Reg);
+    case BO_LAnd:
+    case BO_LOr: {
+      if (!rvalue(BO->getLHS(), LHS))
+        return false;
+      Reg = newReg();
+      emit(OP_ToBool, T, Reg, LHS);
+      unsigned Skip = emitJump(
+          BO->getOpcode() == BO_LAnd ? OP_JumpIfZero : OP_JumpIfNonZero, Reg);
+      if (!rvalue(BO->getRHS(), RHS))
+        return false;
+      emit(OP_ToBool, T, Reg, RHS);
+      patch(Skip);
+      return true;
+    }
+    case BO_Mul: Op = OP_Mul; break;
+    case BO_Div: Op = OP_Div; break;
+    case BO_Rem: Op = OP_Rem; break;
+    case BO_Add: Op = OP_Add; break;
+    case BO_Sub: Op = OP_Sub; break;
+    case BO_Shl: Op = OP_Shl; break;
+    case BO_Shr: Op = OP_Shr; break;
+    case BO_And: Op = OP_And; break;
+    case BO_Xor: Op = OP_Xor; break;
+    case BO_Or: Op = OP_Or; break;
+    case BO_LT: Op = OP_LT; break;
+    case BO_GT: Op = OP_GT; break;
+    case BO_LE: Op = OP_LE; break;
+    case BO_GE: Op = OP_GE; break;
+    case BO_EQ: Op = OP_EQ; break;
+    case BO_NE: Op = OP_NE; break;
+    }
+    // The operation is performed in the type of the left operand, which is
+    // the type of both operands after the usual arithmetic conversions.
+    IntType OpType;
+    if (!getIntType(Ctx, BO->getLHS()->getType(), OpType) ||
+        !rvalue(BO->getLHS(), LHS) || !rvalue(BO->getRHS(), RHS))
+      return false;
+    Reg = newReg();
+    emit(Op, OpType, Reg, LHS, RHS);
+    return true;
+  }
+
+  case Stmt::ConditionalOperatorClass: {
+    const ConditionalOperator *CO = cast<ConditionalOperator>(E);
+    unsigned Cond, Value;
+    if (!rvalue(CO->getCond(), Cond))
+      return false;
+    Reg = newReg();
+    unsigned SkipTrue = emitJump(OP_JumpIfZero, Cond);
+    if (!rvalue(CO->getTrueExpr(), Value))
+      return false;
+    emit(OP_Move, T, Reg, Value);
+    unsigned SkipFalse = emitJump(OP_Jump);
+    patch(SkipTrue);
+    if (!rvalue(CO->getFalseExpr(), Value))
+      return false;
+    emit(OP_Move, T, Reg, Value);
+    patch(SkipFalse);
+    return true;
+  }
+  }
+}
+
+bool Compiler::lvalue(const Expr *E, unsigned &Reg) {
+  IntType T;
+  if (!E->isLValue() || !getIntType(Ctx, E->getType(), T))
+    return false;
+  E = E->IgnoreParens();
+
+  switch (E->getStmtClass()) {
+  default:
+    return false;
+
+  case Stmt::DeclRefExprClass: {
+    const DeclRefExpr *DRE = cast<DeclRefExpr>(E);
+    const VarDecl *VD = dyn_cast<VarDecl>(DRE->getDecl());
+    if (!VD || DRE->refersToEnclosingVariableOrCapture())
+      return false;
+    auto Known = Locals.find(VD);
+    if (Known == Locals.end())
+      return false;
+    Reg = Known->second;
+    return true;
+  }
+
+  case Stmt::UnaryOperatorClass: {
+    const UnaryOperator *UO = cast<UnaryOperator>(E);
+    if (UO->getOpcode() != UO_PreInc && UO->getOpcode() != UO_PreDec)
+      return false;
+    return lvalue(UO->getSubExpr(), Reg) && incDec(UO, Reg);
+  }
+
+  case Stmt::BinaryOperatorClass: {
+    const BinaryOperator *BO = cast<BinaryOperator>(E);
+    unsigned Value;
+    switch (BO->getOpcode()) {
+    default:
+      return false;
+    case BO_Comma:
+      return ignored(BO->getLHS()) && lvalue(BO->getRHS(), Reg);
+    case BO_Assign:
+      if (!lvalue(BO->getLHS(), Reg) || !rvalue(BO->getRHS(), Value))
+        return false;
+      emit(OP_Move, T, Reg, Value);
+      return true;
+    }
+  }
+
+  case Stmt::CompoundAssignOperatorClass: {
+    const CompoundAssignOperator *CAO = cast<CompoundAssignOperator>(E);
+    Opcode Op;
+    switch (CAO->getOpcode()) {
+    default:
+      return false;
+    case BO_MulAssign: Op = OP_Mul; break;
+    case BO_DivAssign: Op = OP_Div; break;
+    case BO_RemAssign: Op = OP_Rem; break;
+    case BO_AddAssign: Op = OP_Add; break;
+    case BO_SubAssign: Op = OP_Sub; break;
+    case BO_ShlAssign: Op = OP_Shl; break;
+    case BO_ShrAssign: Op = OP_Shr; break;
+    case BO_AndAssign: Op = OP_And; break;
+    case BO_XorAssign: Op = OP_Xor; break;
+    case BO_OrAssign: Op = OP_Or; break;
+    }
+    // Like the AST evaluator, convert the value of the variable to the
+    // promoted type of the operation, and convert the result back.
+    IntType OpType, ResultType;
+    unsigned RHS;
+    if (!getIntType(Ctx, CAO->getComputationLHSType(), OpType) ||
+        !getIntType(Ctx, CAO->getComputationResultType(), ResultType) ||
+        !lvalue(CAO->getLHS(), Reg) || !rvalue(CAO->getRHS(), RHS))
+      return false;
+    unsigned LHS = newReg(), Value = newReg();
+    emit(OP_Cast, OpType, LHS, Reg);
+    emit(Op, OpType, Value, LHS, RHS);
+    emit(OP_Cast, T, Reg, Value);
+    return true;
+  }
+  }
+}
+
+bool Compiler::incDec(const UnaryOperator *E, unsigned Var) {
+  QualType T = E->getSubExpr()->getType();
+  IntType VarType;
+  if (!T->isIntegerType() || T->isBooleanType() ||
+      !getIntType(Ctx, T, VarType))
+    return false;
+  // Signed types narrower than int wrap around, as the AST evaluator computes
+  // the result in the promoted type and converts it back.
+  bool Overflows = VarType.Signed && VarType.Width >= Ctx.getIntWidth(Ctx.IntTy);
+  emit(E->isIncrementOp() ? OP_Inc : OP_Dec, VarType, Var, 0, 0, Overflows);
+  return true;
+}
+
+//===----------------------------------------------------------------------===//
+// Interpreter
+//===----------------------------------------------------------------------===//
+
+/// Evaluate \p F with the arguments \p Args.
+static bool interpret(const ConstexprBytecode::Function &F,
+                      ArrayRef<APValue> Args, unsigned &StepsLeft,
+                      llvm::APSInt &Result) {
+  if (Args.size() != F.Params.size())
+    return false;
+  SmallVector<int64_t, 32> Regs(F.NumRegs);
+  for (unsigned I = 0, N = Args.size(); I != N; ++I) {
+    if (!Args[I].isInt() || Args[I].getInt().getBitWidth() > 64)
+      return false;
+    const llvm::APSInt &Arg = Args[I].getInt();
+    Regs[I] = normalize(Arg.isSigned() ? Arg.getSExtValue() : Arg.getZExtValue(),
+                        F.Params[I].Width, F.Params[I].Signed);
+  }
+
+  unsigned Steps = StepsLeft;
+  unsigned PC = 0;
+  while (true) {
+    const Instr &I = F.Code[PC++];
+    unsigned W = I.Width;
+    bool S = I.Signed;
+    switch (I.Op) {
+    case OP_Step:
+      if (!Steps)
+        return false;
+      --Steps;
+      break;
+
+    case OP_Const:
+      Regs[I.Dst] = F.Constants[I.A];
+      break;
+
+    case OP_Move:
+    case OP_Cast:
+      Regs[I.Dst] = normalize(Regs[I.A], W, S);
+      break;
+
+    case OP_Add:
+    case OP_Sub: {
+      int64_t A = Regs[I.A], B = Regs[I.B];
+      uint64_t Value = I.Op == OP_Add ? uint64_t(A) + uint64_t(B)
+                                      : uint64_t(A) - uint64_t(B);
+      int64_t R = normalize(Value, W, S);
+      if (S) {
+        // Narrower values cannot overflow 64 bits, so only check the width
+        // of the type; for 64 bits, check the signs.
+        if (W < 64 ? !fitsSigned(I.Op == OP_Add ? A + B : A - B, W)
+                   : I.Op == OP_Add ? ((A ^ R) & (B ^ R)) < 0
+                                    : ((A ^ B) & (A ^ R)) < 0)
+          return false;
+      }
+      Regs[I.Dst] = R;
+      break;
+    }
+
+    case OP_Mul: {
+      int64_t A = Regs[I.A], B = Regs[I.B];
+      if (S) {
+        // Leave products that may not fit in 64 bits to the AST evaluator.
+        if (!fitsSigned(A, 32) || !fitsSigned(B, 32) || !fitsSigned(A * B, W))
+          return false;
+        Regs[I.Dst] = A * B;
+      } else {
+        Regs[I.Dst] = normalize(uint64_t(A) * uint64_t(B), W, S);
+      }
+      break;
+    }
+
+    case OP_Div:
+    case OP_Rem: {
+      int64_t A = Regs[I.A], B = Regs[I.B];
+      if (!B || (S && A == minSigned(W) && B == -1))
+        return false;
+      if (S)
+        Regs[I.Dst] = I.Op == OP_Div ? A / B : A % B;
+      else
+        Regs[I.Dst] = I.Op == OP_Div ? uint64_t(A) / uint64_t(B)
+                                     : uint64_t(A) % uint64_t(B);
+      break;
+    }
+
+    case OP_Shl:
+    case OP_Shr: {
+      int64_t A = Regs[I.A], B = Regs[I.B];
+      if (B < 0 || B >= W)
+        return false;
+      unsigned Amount = B;
+      if (I.Op == OP_Shr) {
+        Regs[I.Dst] = S ? A >> Amount : int64_t(uint64_t(A) >> Amount);
+        break;
+      }
+      // A signed left shift must not shift a negative value, or shift bits
+      // out of the corresponding unsigned type.
+      if (S && (A < 0 || (Amount && uint64_t(A) >> (W - Amount))))
+        return false;
+      Regs[I.Dst] = normalize(uint64_t(A) << Amount, W, S);
+      break;
+    }
+
+    case OP_And:
+      Regs[I.Dst] = Regs[I.A] & Regs[I.B];
+      break;
+    case OP_Or:
+      Regs[I.Dst] = Regs[I.A] | Regs[I.B];
+      break;
+    case OP_Xor:
+      Regs[I.Dst] = Regs[I.A] ^ Regs[I.B];
+      break;
+
+    case OP_LT:
+      Regs[I.Dst] = S ? Regs[I.A] < Regs[I.B]
+                      : uint64_t(Regs[I.A]) < uint64_t(Regs[I.B]);
+      break;
+    case OP_GT:
+      Regs[I.Dst] = S ? Regs[I.A] > Regs[I.B]
+                      : uint64_t(Regs[I.A]) > uint64_t(Regs[I.B]);
+      break;
+    case OP_LE:
+      Regs[I.Dst] = S ? Regs[I.A] <= Regs[I.B]
+                      : uint64_t(Regs[I.A]) <= uint64_t(Regs[I.B]);
+      break;
+    case OP_GE:
+      Regs[I.Dst] = S ? Regs[I.A] >= Regs[I.B]
+                      : uint64_t(Regs[I.A]) >= uint64_t(Regs[I.B]);
+      break;
+    case OP_EQ:
+      Regs[I.Dst] = Regs[I.A] == Regs[I.B];
+      break;
+    case OP_NE:
+      Regs[I.Dst] = Regs[I.A] != Regs[I.B];
+      break;
+
+    case OP_Neg:
+      if (S && Regs[I.A] == minSigned(W))
+        return false;
+      Regs[I.Dst] = normalize(-uint64_t(Regs[I.A]), W, S);
+      break;
+    case OP_Not:
+      Regs[I.Dst] = normalize(~uint64_t(Regs[I.A]), W, S);
+      break;
+    case OP_LNot:
+      Regs[I.Dst] = !Regs[I.A];
+      break;
+    case OP_ToBool:
+      Regs[I.Dst] = Regs[I.A] != 0;
+      break;
+
+    case OP_Inc:
+      if (I.Overflows && Regs[I.Dst] == maxSigned(W))
+        return false;
+      Regs[I.Dst] = normalize(uint64_t(Regs[I.Dst]) + 1, W, S);
+      break;
+    case OP_Dec:
+      if (I.Overflows && Regs[I.Dst] == minSigned(W))
+        return false;
+      Regs[I.Dst] = normalize(uint64_t(Regs[I.Dst]) - 1, W, S);
+      break;
+
+    case OP_Jump:
+      PC = I.Dst;
+      break;
+    case OP_JumpIfZero:
+      if (!Regs[I.A])
+        PC = I.Dst;
+      break;
+    case OP_JumpIfNonZero:
+      if (Regs[I.A])
+        PC = I.Dst;
+      break;
+
+    case OP_Return:
+      Result = llvm::APSInt(llvm::APInt(W, uint64_t(Regs[I.A])), !S);
+      StepsLeft = Steps;
+      return true;
+
+    case OP_Fail:
+      return false;
+    }
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// ConstexprBytecode
+//===----------------------------------------------------------------------===//
+
+ConstexprBytecode::ConstexprBytecode(ASTContext &Ctx) : Ctx(Ctx) {}
+
+ConstexprBytecode::~ConstexprBytecode() {}
+
+bool ConstexprBytecode::evaluateCall(const FunctionDecl *FD, const Stmt *Body,
+                                     ArrayRef<APValue> Args,
+                                     unsigned &StepsLeft, APValue &Result) {
+  ++NumCalls;
+  auto Known = Functions.find(FD);
+  if (Known == Functions.end()) {
+    std::unique_ptr<Function> F(new Function);
+    if (!Compiler(Ctx, *F).compileFunction(FD, Body))
+      F.reset();
+    Known = Functions.insert(std::make_pair(FD, std::move(F))).first;
+  }
+  llvm::APSInt Value;
+  if (!Known->second || !interpret(*Known->second, Args, StepsLeft, Value))
+    return false;
+  ++NumCallsEvaluated;
+  Result = APValue(Value);
+  return true;
+}
+
+void ConstexprBytecode::PrintStats() const {
+  unsigned NumCompiled = 0;
+  for (const auto &Entry : Functions)
+    if (Entry.second)
+      ++NumCompiled;
+  llvm::errs() << NumCompiled << "/" << Functions.size()
+               << " constexpr functions compiled to bytecode\n";
+  llvm::errs() << NumCallsEvaluated << "/" << NumCalls
+               << " constexpr calls evaluated by the bytecode interpreter\n";
+}
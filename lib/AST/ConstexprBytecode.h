@@ -0,0 +1,69 @@
+//===--- ConstexprBytecode.h - Bytecode for constexpr functions -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This provides a register-based bytecode for the bodies of constexpr
+// functions that only compute with integers in local variables, and the
+// interpreter that evaluates calls to them. A function is compiled the first
+// time it is called; anything the bytecode does not model is left to the AST
+// evaluator in ExprConstant.cpp.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LIB_AST_CONSTEXPRBYTECODE_H
+#define LLVM_CLANG_LIB_AST_CONSTEXPRBYTECODE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include <memory>
+
+namespace clang {
+
+class APValue;
+class ASTContext;
+class FunctionDecl;
+class Stmt;
+
+/// The bytecode of the constexpr functions compiled in an ASTContext.
+class ConstexprBytecode {
+public:
+  class Function;
+
+  explicit ConstexprBytecode(ASTContext &Ctx);
+  ~ConstexprBytecode();
+
+  /// Evaluate a call to the constexpr function \p FD, whose definition has the
+  /// body \p Body, with the arguments \p Args.
+  ///
+  /// \param StepsLeft The number of evaluation steps left, which is reduced by
+  /// the steps the AST evaluator would have taken for the call.
+  ///
+  /// \returns true and sets \p Result if the call was evaluated. Returns false
+  /// without changing \p StepsLeft if the function cannot be compiled, or if
+  /// the evaluation reached something the AST evaluator has to diagnose, such
+  /// as an overflow or running out of steps.
+  bool evaluateCall(const FunctionDecl *FD, const Stmt *Body,
+                    ArrayRef<APValue> Args, unsigned &StepsLeft,
+                    APValue &Result);
+
+  void PrintStats() const;
+
+private:
+  ASTContext &Ctx;
+
+  /// The compiled functions, or null for the functions that the bytecode
+  /// cannot represent.
+  llvm::DenseMap<const FunctionDecl *, std::unique_ptr<Function>> Functions;
+
+  unsigned NumCalls = 0;
+  unsigned NumCallsEvaluated = 0;
+};
+
+} // end namespace clang
+
+#endif
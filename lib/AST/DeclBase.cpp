@@ -1144,8 +1144,16 @@ void DeclContext::reconcileExternalVisibleStorage() const {
   assert(NeedToReconcileExternalVisibleStorage && LookupPtr);
   NeedToReconcileExternalVisibleStorage = false;
 
-  for (auto &Lookup : *LookupPtr)
-    Lookup.second.setHasExternalDecls();
+  // Names with no declarations only record that the external source had none
+  // for them. Dropping them has the same effect as marking them, since a name
+  // that is not in the map is looked up in the external source, and does not
+  // allocate a vector for each of the names a large context was queried for.
+  for (auto I = LookupPtr->begin(), E = LookupPtr->end(); I != E; ++I) {
+    if (I->second.isNull())
+      LookupPtr->erase(I);
+    else
+      I->second.setHasExternalDecls();
+  }
 }
 
 /// \brief Load the declarations within this lexical storage from an
@@ -1399,10 +1407,22 @@ StoredDeclsMap *DeclContext::buildLookup() {
 
   if (HasLazyExternalLexicalLookups) {
     HasLazyExternalLexicalLookups = false;
+
+    // If the lookup table already holds every local declaration, only the
+    // declarations loaded now need to be added to it. They are spliced in
+    // before the existing ones, so walk each list up to its old head rather
+    // than rebuilding the table from all the contexts.
+    bool Incremental = LookupPtr && !HasLazyLocalLexicalLookups;
     for (auto *DC : Contexts) {
-      if (DC->hasExternalLexicalStorage())
-        HasLazyLocalLexicalLookups |=
-            DC->LoadLexicalDeclsFromExternalStorage();
+      if (!DC->hasExternalLexicalStorage())
+        continue;
+      Decl *OldFirstDecl = DC->FirstDecl;
+      if (!DC->LoadLexicalDeclsFromExternalStorage())
+        continue;
+      if (Incremental)
+        buildLookupImpl(DC, hasExternalVisibleStorage(), OldFirstDecl);
+      else
+        HasLazyLocalLexicalLookups = true;
     }
 
     if (!HasLazyLocalLexicalLookups)
@@ -1420,9 +1440,11 @@ StoredDeclsMap *DeclContext::buildLookup() {
 /// buildLookupImpl - Build part of the lookup data structure for the
 /// declarations contained within DCtx, which will either be this
 /// DeclContext, a DeclContext linked to it, or a transparent context
-/// nested within it.
-void DeclContext::buildLookupImpl(DeclContext *DCtx, bool Internal) {
-  for (Decl *D : DCtx->noload_decls()) {
+/// nested within it. If End is non-null, only the declarations before it
+/// are added.
+void DeclContext::buildLookupImpl(DeclContext *DCtx, bool Internal,
+                                  Decl *End) {
+  for (Decl *D = DCtx->FirstDecl; D != End; D = D->getNextDeclInContext()) {
     // Insert this declaration into the lookup structure, but only if
     // it's semantically within its decl context. Any other decls which
     // should be found in this context are added eagerly.
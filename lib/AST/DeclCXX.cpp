@@ -71,7 +71,8 @@ CXXRecordDecl::DefinitionData::DefinitionData(CXXRecordDecl *D)
       ImplicitCopyAssignmentHasConstParam(true),
       HasDeclaredCopyConstructorWithConstParam(false),
       HasDeclaredCopyAssignmentWithConstParam(false), IsLambda(false),
-      IsParsingBaseSpecifiers(false), NumBases(0), NumVBases(0), Bases(),
+      IsParsingBaseSpecifiers(false), HasODRHash(false), ODRHash(0),
+      NumBases(0), NumVBases(0), Bases(),
       VBases(), Definition(D), FirstFriend() {}
 
 CXXBaseSpecifier *CXXRecordDecl::DefinitionData::getBasesSlowCase() const {
@@ -410,6 +411,37 @@ bool CXXRecordDecl::hasAnyDependentBases() const {
   return !forallBases([](const CXXRecordDecl *) { return true; });
 }
 
+unsigned CXXRecordDecl::getODRHash() const {
+  struct DefinitionData &Data = data();
+  if (Data.HasODRHash)
+    return Data.ODRHash;
+
+  llvm::FoldingSetNodeID ID;
+  ID.AddInteger(Data.NumBases);
+  for (const CXXBaseSpecifier &Base : Data.bases()) {
+    ID.AddBoolean(Base.isVirtual());
+    ID.AddInteger(Base.getAccessSpecifierAsWritten());
+    ID.AddString(Base.getType().getCanonicalType().getAsString());
+  }
+
+  // The implicit members depend on how the class was used, not on how it was
+  // written, so they are left out.
+  for (const Decl *Member : Data.Definition->decls()) {
+    if (Member->isImplicit())
+      continue;
+    ID.AddInteger(Member->getKind());
+    ID.AddInteger(Member->getAccess());
+    if (const auto *ND = dyn_cast<NamedDecl>(Member))
+      ID.AddString(ND->getDeclName().getAsString());
+    if (const auto *VD = dyn_cast<ValueDecl>(Member))
+      ID.AddString(VD->getType().getCanonicalType().getAsString());
+  }
+
+  Data.ODRHash = ID.ComputeHash();
+  Data.HasODRHash = true;
+  return Data.ODRHash;
+}
+
 bool CXXRecordDecl::isTriviallyCopyable() const {
   // C++0x [class]p5:
   //   A trivially copyable class is a class that:
@@ -1465,7 +1465,7 @@ MemberExpr *MemberExpr::Create(
              QualifierLoc.getNestedNameSpecifier()->isInstantiationDependent()) 
       E->setInstantiationDependent(true);
     
-    E->HasQualifierOrFoundDecl = true;
+    E->MemberExprBits.HasQualifierOrFoundDecl = true;
 
     MemberExprNameQualifier *NQ =
         E->getTrailingObjects<MemberExprNameQualifier>();
@@ -1473,7 +1473,8 @@ MemberExpr *MemberExpr::Create(
     NQ->FoundDecl = founddecl;
   }
 
-  E->HasTemplateKWAndArgsInfo = (targs || TemplateKWLoc.isValid());
+  E->MemberExprBits.HasTemplateKWAndArgsInfo =
+      (targs || TemplateKWLoc.isValid());
 
   if (targs) {
     bool Dependent = false;
@@ -1919,6 +1920,64 @@ SourceLocation InitListExpr::getLocEnd() const {
   return End;
 }
 
+CompactArrayInitExpr *
+CompactArrayInitExpr::Create(const ASTContext &C, QualType T,
+                             InitListExpr *SyntacticForm, unsigned NumElements,
+                             unsigned ElementByteWidth) {
+  auto *E = new (C) CompactArrayInitExpr(T, SyntacticForm);
+  E->allocateData(C, NumElements, ElementByteWidth);
+  return E;
+}
+
+CompactArrayInitExpr *CompactArrayInitExpr::CreateEmpty(const ASTContext &C) {
+  return new (C) CompactArrayInitExpr(EmptyShell());
+}
+
+void CompactArrayInitExpr::allocateData(const ASTContext &C,
+                                        unsigned NumElements,
+                                        unsigned ElementByteWidth) {
+  assert((ElementByteWidth == 1 || ElementByteWidth == 2 ||
+          ElementByteWidth == 4 || ElementByteWidth == 8) &&
+         "unexpected element width");
+  this->NumElements = NumElements;
+  this->ElementByteWidth = ElementByteWidth;
+  Data = new (C, ElementByteWidth) char[NumElements * ElementByteWidth];
+}
+
+uint64_t CompactArrayInitExpr::getElement(unsigned I) const {
+  assert(I < NumElements && "element out of range");
+  const char *P = Data + I * ElementByteWidth;
+  switch (ElementByteWidth) {
+  case 1:
+    return *reinterpret_cast<const uint8_t *>(P);
+  case 2:
+    return *reinterpret_cast<const uint16_t *>(P);
+  case 4:
+    return *reinterpret_cast<const uint32_t *>(P);
+  default:
+    return *reinterpret_cast<const uint64_t *>(P);
+  }
+}
+
+void CompactArrayInitExpr::setElement(unsigned I, uint64_t Value) {
+  assert(I < NumElements && "element out of range");
+  char *P = Data + I * ElementByteWidth;
+  switch (ElementByteWidth) {
+  case 1:
+    *reinterpret_cast<uint8_t *>(P) = Value;
+    break;
+  case 2:
+    *reinterpret_cast<uint16_t *>(P) = Value;
+    break;
+  case 4:
+    *reinterpret_cast<uint32_t *>(P) = Value;
+    break;
+  default:
+    *reinterpret_cast<uint64_t *>(P) = Value;
+    break;
+  }
+}
+
 /// getFunctionType - Return the underlying function type for this block.
 ///
 const FunctionProtoType *BlockExpr::getFunctionType() const {
@@ -2691,6 +2750,7 @@ bool Expr::isConstantInitializer(ASTContext &Ctx, bool IsForRef,
   default: break;
   case StringLiteralClass:
   case ObjCEncodeExprClass:
+  case CompactArrayInitExprClass:
     return true;
   case CXXTemporaryObjectExprClass:
   case CXXConstructExprClass: {
@@ -2901,6 +2961,7 @@ bool Expr::HasSideEffects(const ASTContext &Ctx,
   case AddrLabelExprClass:
   case GNUNullExprClass:
   case ArrayInitIndexExprClass:
+  case CompactArrayInitExprClass:
   case NoInitExprClass:
   case CXXBoolLiteralExprClass:
   case CXXNullPtrLiteralExprClass:
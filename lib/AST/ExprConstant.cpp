@@ -33,6 +33,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "ConstexprBytecode.h"
 #include "clang/AST/APValue.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/ASTDiagnostic.h"
@@ -44,6 +45,7 @@
 #include "clang/AST/TypeLoc.h"
 #include "clang/Basic/Builtins.h"
 #include "clang/Basic/TargetInfo.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cstring>
 #include <functional>
@@ -525,6 +527,10 @@ namespace {
     /// CallStackDepth - The number of calls in the call stack right now.
     unsigned CallStackDepth;
 
+    /// MaxCallStackDepth - The largest CallStackDepth reached while
+    /// evaluating the current memoizable call.
+    unsigned MaxCallStackDepth = 0;
+
     /// NextCallIndex - The next call index to assign.
     unsigned NextCallIndex;
 
@@ -553,6 +559,11 @@ namespace {
     /// initialization.
     uint64_t ArrayInitIndex = -1;
 
+    /// The number of times the value of EvaluatingDecl was accessed, which
+    /// makes the result of the constexpr calls that access it depend on the
+    /// state of the evaluation.
+    unsigned NumEvaluatingDeclAccesses = 0;
+
     /// HasActiveDiagnostic - Was the previous diagnostic stored? If so, further
     /// notes attached to it will also be stored, otherwise they will not be.
     bool HasActiveDiagnostic;
@@ -1070,6 +1081,8 @@ CallStackFrame::CallStackFrame(EvalInfo &Info, SourceLocation CallLoc,
       Arguments(Arguments), CallLoc(CallLoc), Index(Info.NextCallIndex++) {
   Info.CurrentCall = this;
   ++Info.CallStackDepth;
+  Info.MaxCallStackDepth = std::max(Info.MaxCallStackDepth,
+                                    Info.CallStackDepth);
 }
 
 CallStackFrame::~CallStackFrame() {
@@ -2299,6 +2312,7 @@ static bool evaluateVarDeclInit(EvalInfo &Info, const Expr *E,
   // If we're currently evaluating the initializer of this declaration, use that
   // in-flight value.
   if (Info.EvaluatingDecl.dyn_cast<const ValueDecl*>() == VD) {
+    ++Info.NumEvaluatingDeclAccesses;
     Result = Info.EvaluatingDeclValue;
     return true;
   }
@@ -3011,6 +3025,7 @@ static CompleteObject findCompleteObject(EvalInfo &Info, const Expr *E,
   // and this doesn't do quite the right thing for const subobjects of the
   // object under construction.
   if (LVal.getLValueBase() == Info.EvaluatingDecl) {
+    ++Info.NumEvaluatingDeclAccesses;
     BaseType = Info.Ctx.getCanonicalType(BaseType);
     BaseType.removeLocalConst();
   }
@@ -4094,6 +4109,78 @@ static bool EvaluateArgs(ArrayRef<const Expr*> Args, ArgVector &ArgValues,
   return Success;
 }
 
+/// Append \p Value to the key of a constexpr call in the call cache. Only
+/// integers and floating-point values can be part of a key: they cannot
+/// refer to the objects of the caller.
+static bool appendCallCacheKey(const APValue &Value,
+                               SmallVectorImpl<char> &Key) {
+  auto Append = [&](const void *Data, size_t Size) {
+    Key.append((const char *)Data, (const char *)Data + Size);
+  };
+  APInt Bits;
+  if (Value.isInt()) {
+    Key.push_back(Value.getInt().isSigned() ? 'i' : 'u');
+    Bits = Value.getInt();
+  } else if (Value.isFloat()) {
+    Key.push_back('f');
+    const llvm::fltSemantics *Semantics = &Value.getFloat().getSemantics();
+    Append(&Semantics, sizeof(Semantics));
+    Bits = Value.getFloat().bitcastToAPInt();
+  } else {
+    return false;
+  }
+  unsigned Width = Bits.getBitWidth();
+  Append(&Width, sizeof(Width));
+  Append(Bits.getRawData(), Bits.getNumWords() * sizeof(uint64_t));
+  return true;
+}
+
+/// Compute the key of a call in the call cache, if the result of the call
+/// can only depend on its arguments.
+static bool getCallCacheKey(EvalInfo &Info, const FunctionDecl *Callee,
+                            const LValue *This, ArrayRef<APValue> ArgValues,
+                            SmallVectorImpl<char> &Key) {
+  if (This || !Callee->isConstexpr() ||
+      Info.checkingPotentialConstantExpression())
+    return false;
+  QualType ReturnType = Callee->getReturnType();
+  if (!ReturnType->isIntegralOrEnumerationType() &&
+      !ReturnType->isRealFloatingType())
+    return false;
+
+  // The evaluation mode determines what the call is allowed to do.
+  Key.push_back(static_cast<char>(Info.EvalMode));
+  for (const APValue &Arg : ArgValues)
+    if (!appendCallCacheKey(Arg, Key))
+      return false;
+  return true;
+}
+
+namespace {
+/// The changes a constexpr call can make to the state of the evaluation other
+/// than through its result. A call that made none can be memoized.
+struct CallEffects {
+  size_t NumNotes;
+  bool HasSideEffects;
+  bool HasUndefinedBehavior;
+  unsigned NumEvaluatingDeclAccesses;
+
+  explicit CallEffects(const EvalInfo &Info)
+      : NumNotes(Info.EvalStatus.Diag ? Info.EvalStatus.Diag->size() : 0),
+        HasSideEffects(Info.EvalStatus.HasSideEffects),
+        HasUndefinedBehavior(Info.EvalStatus.HasUndefinedBehavior),
+        NumEvaluatingDeclAccesses(Info.NumEvaluatingDeclAccesses) {}
+
+  /// Whether the evaluation since \p Before made no changes, and produced
+  /// the notes that tell whether it did.
+  bool isUnchangedSince(const EvalInfo &Info, const CallEffects &Before) const {
+    return Info.EvalStatus.Diag && NumNotes == Before.NumNotes &&
+           !HasSideEffects && !HasUndefinedBehavior &&
+           NumEvaluatingDeclAccesses == Before.NumEvaluatingDeclAccesses;
+  }
+};
+} // end anonymous namespace
+
 /// Evaluate a function call.
 static bool HandleFunctionCall(SourceLocation CallLoc,
                                const FunctionDecl *Callee, const LValue *This,
@@ -4107,6 +4194,46 @@ static bool HandleFunctionCall(SourceLocation CallLoc,
   if (!Info.CheckCallLimit(CallLoc))
     return false;
 
+  // Reuse the result of an earlier call with the same arguments.
+  SmallString<64> CacheKey;
+  bool Cacheable = getCallCacheKey(Info, Callee, This, ArgValues, CacheKey);
+  if (Cacheable) {
+    ++ASTContext::NumConstexprCallLookups;
+    llvm::StringMap<ASTContext::ConstexprCallResult> &Results =
+        Info.Ctx.getConstexprCallResults(Callee);
+    auto Known = Results.find(CacheKey);
+    // Only reuse the result if evaluating the call would not exceed the
+    // limits from here, so that the same calls are accepted either way.
+    if (Known != Results.end() && Info.StepsLeft >= Known->second.Steps &&
+        Info.CallStackDepth + Known->second.Depth - 1 <=
+            Info.getLangOpts().ConstexprCallDepth) {
+      ++ASTContext::NumConstexprCallCacheHits;
+      Info.StepsLeft -= Known->second.Steps;
+      Info.MaxCallStackDepth =
+          std::max(Info.MaxCallStackDepth,
+                   Info.CallStackDepth + Known->second.Depth);
+      Result = Known->second.Value;
+      return true;
+    }
+  }
+  // Leave it to the bytecode interpreter if it can evaluate the call, as it
+  // does so exactly like the AST evaluator.
+  if (Info.getLangOpts().ExperimentalConstexprInterpreter && !This &&
+      !Info.checkingPotentialConstantExpression() &&
+      Info.Ctx.getConstexprBytecode().evaluateCall(Callee, Body, ArgValues,
+                                                   Info.StepsLeft, Result)) {
+    Info.MaxCallStackDepth =
+        std::max(Info.MaxCallStackDepth, Info.CallStackDepth + 1);
+    return true;
+  }
+
+  CallEffects Before(Info);
+  unsigned StepsBefore = Info.StepsLeft;
+  unsigned DepthBefore = Info.CallStackDepth;
+  unsigned CallerMaxDepth = Info.MaxCallStackDepth;
+  if (Cacheable)
+    Info.MaxCallStackDepth = DepthBefore;
+
   CallStackFrame Frame(Info, CallLoc, Callee, This, ArgValues.data());
 
   // For a trivial copy or move assignment, perform an APValue copy. This is
@@ -4141,6 +4268,15 @@ static bool HandleFunctionCall(SourceLocation CallLoc,
       return true;
     Info.FFDiag(Callee->getLocEnd(), diag::note_constexpr_no_return);
   }
+  // The calls evaluated meanwhile may have moved the results of the callee.
+  if (ESR == ESR_Returned && Cacheable &&
+      CallEffects(Info).isUnchangedSince(Info, Before) &&
+      (Result.isInt() || Result.isFloat()))
+    Info.Ctx.getConstexprCallResults(Callee)[CacheKey] = {
+        Result, StepsBefore - Info.StepsLeft,
+        Info.MaxCallStackDepth - DepthBefore};
+  if (Cacheable)
+    Info.MaxCallStackDepth = std::max(CallerMaxDepth, Info.MaxCallStackDepth);
   return ESR == ESR_Returned;
 }
 
@@ -6449,6 +6585,7 @@ namespace {
       return handleCallExpr(E, Result, &This);
     }
     bool VisitInitListExpr(const InitListExpr *E);
+    bool VisitCompactArrayInitExpr(const CompactArrayInitExpr *E);
     bool VisitArrayInitLoopExpr(const ArrayInitLoopExpr *E);
     bool VisitCXXConstructExpr(const CXXConstructExpr *E);
     bool VisitCXXConstructExpr(const CXXConstructExpr *E,
@@ -6532,6 +6669,36 @@ bool ArrayExprEvaluator::VisitInitListExpr(const InitListExpr *E) {
                          FillerExpr) && Success;
 }
 
+bool ArrayExprEvaluator::VisitCompactArrayInitExpr(
+    const CompactArrayInitExpr *E) {
+  const ConstantArrayType *CAT = Info.Ctx.getAsConstantArrayType(E->getType());
+  if (!CAT)
+    return Error(E);
+
+  QualType EltTy = CAT->getElementType();
+  unsigned BitWidth = E->getElementByteWidth() * 8;
+  unsigned NumElts = CAT->getSize().getZExtValue();
+  Result = APValue(APValue::UninitArray(), E->getNumElements(), NumElts);
+  for (unsigned I = 0, N = E->getNumElements(); I != N; ++I) {
+    llvm::APInt Bits(BitWidth, E->getElement(I));
+    if (EltTy->isRealFloatingType())
+      Result.getArrayInitializedElt(I) =
+          APValue(APFloat(Info.Ctx.getFloatTypeSemantics(EltTy), Bits));
+    else
+      Result.getArrayInitializedElt(I) =
+          APValue(APSInt(Bits, EltTy->isUnsignedIntegerType()));
+  }
+
+  if (!Result.hasArrayFiller())
+    return true;
+
+  // The elements past the initialized ones are zero-initialized.
+  LValue Subobject = This;
+  Subobject.addArray(Info, E, CAT);
+  ImplicitValueInitExpr VIE(EltTy);
+  return EvaluateInPlace(Result.getArrayFiller(), Info, Subobject, &VIE);
+}
+
 bool ArrayExprEvaluator::VisitArrayInitLoopExpr(const ArrayInitLoopExpr *E) {
   if (E->getCommonExpr() &&
       !Evaluate(Info.CurrentCall->createTemporary(E->getCommonExpr(), false),
@@ -9917,6 +10084,7 @@ static ICEDiag CheckICE(const Expr* E, const ASTContext &Ctx) {
   case Expr::DesignatedInitExprClass:
   case Expr::ArrayInitLoopExprClass:
   case Expr::ArrayInitIndexExprClass:
+  case Expr::CompactArrayInitExprClass:
   case Expr::NoInitExprClass:
   case Expr::DesignatedInitUpdateExprClass:
   case Expr::ImplicitValueInitExprClass:
@@ -3303,6 +3303,7 @@ recurse:
   case Expr::ImplicitValueInitExprClass:
   case Expr::ArrayInitLoopExprClass:
   case Expr::ArrayInitIndexExprClass:
+  case Expr::CompactArrayInitExprClass:
   case Expr::NoInitExprClass:
   case Expr::ParenListExprClass:
   case Expr::LambdaExprClass:
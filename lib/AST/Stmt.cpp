@@ -24,8 +24,11 @@
 #include "clang/Basic/CharInfo.h"
 #include "clang/Basic/TargetInfo.h"
 #include "clang/Lex/Token.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 using namespace clang;
 
 static struct StmtClassNameTable {
@@ -59,29 +62,44 @@ const char *Stmt::getStmtClassName() const {
   return getStmtInfoTableEntry((StmtClass) StmtBits.sClass).Name;
 }
 
+/// Returns the number of bytes taken by the statements of class \p i,
+/// without their trailing objects.
+static uint64_t getStmtClassBytes(unsigned i) {
+  return uint64_t(StmtClassInfo[i].Counter) * StmtClassInfo[i].Size;
+}
+
 void Stmt::PrintStats() {
   // Ensure the table is primed.
   getStmtInfoTableEntry(Stmt::NullStmtClass);
 
   unsigned sum = 0;
+  uint64_t totalBytes = 0;
+  SmallVector<unsigned, 64> classes;
   llvm::errs() << "\n*** Stmt/Expr Stats:\n";
   for (int i = 0; i != Stmt::lastStmtConstant+1; i++) {
     if (StmtClassInfo[i].Name == nullptr) continue;
     sum += StmtClassInfo[i].Counter;
+    if (StmtClassInfo[i].Counter == 0) continue;
+    totalBytes += getStmtClassBytes(i);
+    classes.push_back(i);
   }
   llvm::errs() << "  " << sum << " stmts/exprs total.\n";
-  sum = 0;
-  for (int i = 0; i != Stmt::lastStmtConstant+1; i++) {
-    if (StmtClassInfo[i].Name == nullptr) continue;
-    if (StmtClassInfo[i].Counter == 0) continue;
+
+  // List the classes that take the most memory first.
+  std::stable_sort(classes.begin(), classes.end(),
+                   [](unsigned LHS, unsigned RHS) {
+                     return getStmtClassBytes(LHS) > getStmtClassBytes(RHS);
+                   });
+  for (unsigned i : classes) {
+    uint64_t bytes = getStmtClassBytes(i);
     llvm::errs() << "    " << StmtClassInfo[i].Counter << " "
                  << StmtClassInfo[i].Name << ", " << StmtClassInfo[i].Size
-                 << " each (" << StmtClassInfo[i].Counter*StmtClassInfo[i].Size
-                 << " bytes)\n";
-    sum += StmtClassInfo[i].Counter*StmtClassInfo[i].Size;
+                 << " each (" << bytes << " bytes, "
+                 << llvm::format("%.1f", 100.0 * bytes / totalBytes)
+                 << "%)\n";
   }
 
-  llvm::errs() << "Total bytes = " << sum << "\n";
+  llvm::errs() << "Total bytes = " << totalBytes << "\n";
 }
 
 void Stmt::addStmtClass(StmtClass s) {
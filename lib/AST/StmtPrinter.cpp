@@ -1798,6 +1798,10 @@ void StmtPrinter::VisitInitListExpr(InitListExpr* Node) {
   OS << "}";
 }
 
+void StmtPrinter::VisitCompactArrayInitExpr(CompactArrayInitExpr *Node) {
+  Visit(Node->getSyntacticForm());
+}
+
 void StmtPrinter::VisitArrayInitLoopExpr(ArrayInitLoopExpr *Node) {
   // There's no way to express this expression in any of our supported
   // languages, so just emit something terse and (hopefully) clear.
@@ -21,6 +21,7 @@
 #include "clang/AST/ExprOpenMP.h"
 #include "clang/AST/StmtVisitor.h"
 #include "llvm/ADT/FoldingSet.h"
+#include "llvm/Support/raw_ostream.h"
 using namespace clang;
 
 namespace {
@@ -28,11 +29,14 @@ namespace {
     llvm::FoldingSetNodeID &ID;
     const ASTContext &Context;
     bool Canonical;
+    /// Whether to profile the declarations, types, and names by their
+    /// spelling instead of their addresses.
+    bool Stable;
 
   public:
     StmtProfiler(llvm::FoldingSetNodeID &ID, const ASTContext &Context,
-                 bool Canonical)
-      : ID(ID), Context(Context), Canonical(Canonical) { }
+                 bool Canonical, bool Stable = false)
+      : ID(ID), Context(Context), Canonical(Canonical), Stable(Stable) { }
 
     void VisitStmt(const Stmt *S);
 
@@ -50,6 +54,10 @@ namespace {
     /// \brief Visit a name that occurs within an expression or statement.
     void VisitName(DeclarationName Name);
 
+    /// \brief Visit an identifier that occurs within an expression or
+    /// statement.
+    void VisitIdentifier(const IdentifierInfo *II);
+
     /// \brief Visit a nested-name-specifier that occurs within an expression
     /// or statement.
     void VisitNestedNameSpecifier(NestedNameSpecifier *NNS);
@@ -922,7 +930,7 @@ void StmtProfiler::VisitOffsetOfExpr(const OffsetOfExpr *S) {
       break;
 
     case OffsetOfNode::Identifier:
-      ID.AddPointer(ON.getFieldName());
+      VisitIdentifier(ON.getFieldName());
       break;
 
     case OffsetOfNode::Base:
@@ -1070,6 +1078,10 @@ void StmtProfiler::VisitDesignatedInitUpdateExpr(
                    "initializer");
 }
 
+void StmtProfiler::VisitCompactArrayInitExpr(const CompactArrayInitExpr *S) {
+  VisitInitListExpr(S->getSyntacticForm());
+}
+
 void StmtProfiler::VisitArrayInitLoopExpr(const ArrayInitLoopExpr *S) {
   VisitExpr(S);
 }
@@ -1520,7 +1532,7 @@ StmtProfiler::VisitCXXPseudoDestructorExpr(const CXXPseudoDestructorExpr *S) {
   if (S->getDestroyedTypeInfo())
     VisitType(S->getDestroyedType());
   else
-    ID.AddPointer(S->getDestroyedTypeIdentifier());
+    VisitIdentifier(S->getDestroyedTypeIdentifier());
 }
 
 void StmtProfiler::VisitOverloadExpr(const OverloadExpr *S) {
@@ -1814,6 +1826,17 @@ void StmtProfiler::VisitDecl(const Decl *D) {
     }
   }
 
+  if (Stable && D) {
+    if (const NamedDecl *ND = dyn_cast<NamedDecl>(D))
+      ID.AddString(ND->getQualifiedNameAsString());
+    if (const ValueDecl *VD = dyn_cast<ValueDecl>(D))
+      VisitType(VD->getType());
+    // The value of an enumerator may change without its name.
+    if (const EnumConstantDecl *ECD = dyn_cast<EnumConstantDecl>(D))
+      ID.AddString(ECD->getInitVal().toString(10));
+    return;
+  }
+
   ID.AddPointer(D? D->getCanonicalDecl() : nullptr);
 }
 
@@ -1821,16 +1844,48 @@ void StmtProfiler::VisitType(QualType T) {
   if (Canonical)
     T = Context.getCanonicalType(T);
 
+  if (Stable) {
+    ID.AddString(T.getAsString());
+    // The spelling of a record type does not change with its fields.
+    if (const RecordType *RT = T->getAs<RecordType>())
+      if (const RecordDecl *Def = RT->getDecl()->getDefinition())
+        for (const FieldDecl *FD : Def->fields()) {
+          ID.AddString(FD->getName());
+          ID.AddString(FD->getType().getCanonicalType().getAsString());
+        }
+    return;
+  }
+
   ID.AddPointer(T.getAsOpaquePtr());
 }
 
 void StmtProfiler::VisitName(DeclarationName Name) {
+  if (Stable) {
+    ID.AddString(Name.getAsString());
+    return;
+  }
   ID.AddPointer(Name.getAsOpaquePtr());
 }
 
+void StmtProfiler::VisitIdentifier(const IdentifierInfo *II) {
+  if (Stable) {
+    ID.AddString(II ? II->getName() : StringRef());
+    return;
+  }
+  ID.AddPointer(II);
+}
+
 void StmtProfiler::VisitNestedNameSpecifier(NestedNameSpecifier *NNS) {
   if (Canonical)
     NNS = Context.getCanonicalNestedNameSpecifier(NNS);
+  if (Stable) {
+    std::string Str;
+    llvm::raw_string_ostream OS(Str);
+    if (NNS)
+      NNS->print(OS, PrintingPolicy(Context.getLangOpts()));
+    ID.AddString(OS.str());
+    return;
+  }
   ID.AddPointer(NNS);
 }
 
@@ -1838,6 +1893,13 @@ void StmtProfiler::VisitTemplateName(TemplateName Name) {
   if (Canonical)
     Name = Context.getCanonicalTemplateName(Name);
 
+  if (Stable) {
+    std::string Str;
+    llvm::raw_string_ostream OS(Str);
+    Name.print(OS, PrintingPolicy(Context.getLangOpts()));
+    ID.AddString(OS.str());
+    return;
+  }
   Name.Profile(ID);
 }
 
@@ -1893,3 +1955,9 @@ void Stmt::Profile(llvm::FoldingSetNodeID &ID, const ASTContext &Context,
   StmtProfiler Profiler(ID, Context, Canonical);
   Profiler.Visit(this);
 }
+
+void Stmt::ProfileStable(llvm::FoldingSetNodeID &ID,
+                         const ASTContext &Context) const {
+  StmtProfiler Profiler(ID, Context, /*Canonical=*/true, /*Stable=*/true);
+  Profiler.Visit(this);
+}
@@ -307,7 +307,8 @@ class MatchASTVisitor : public RecursiveASTVisitor<MatchASTVisitor>,
 public:
   MatchASTVisitor(const MatchFinder::MatchersByType *Matchers,
                   const MatchFinder::MatchFinderOptions &Options)
-      : Matchers(Matchers), Options(Options), ActiveASTContext(nullptr) {}
+      : Matchers(Matchers), Options(Options), ActiveASTContext(nullptr),
+        ParentMapRoot(nullptr) {}
 
   ~MatchASTVisitor() override {
     if (Options.CheckProfiling) {
@@ -584,6 +585,16 @@ private:
     return Filter;
   }
 
+  // Returns whether \p DeclNode was written in a system header, or is an
+  // instantiation of a template from one.
+  bool isInSystemHeader(const Decl *DeclNode) const {
+    SourceLocation Loc = DeclNode->getLocation();
+    if (Loc.isInvalid() || isa<TranslationUnitDecl>(DeclNode))
+      return false;
+    const SourceManager &SM = ActiveASTContext->getSourceManager();
+    return SM.isInSystemHeader(SM.getExpansionLoc(Loc));
+  }
+
   /// @{
   /// \brief Overloads to pair the different node types to their matchers.
   void matchDispatch(const Decl *Node) {
@@ -765,6 +776,10 @@ private:
   const MatchFinder::MatchFinderOptions &Options;
   ASTContext *ActiveASTContext;
 
+  // The top-level declaration being traversed, when the parent map is scoped
+  // to the top-level declarations.
+  const Decl *ParentMapRoot;
+
   // Maps a canonical type to its TypedefDecls.
   llvm::DenseMap<const Type*, std::set<const TypedefNameDecl*> > TypeAliases;
 
@@ -834,6 +849,20 @@ bool MatchASTVisitor::TraverseDecl(Decl *DeclNode) {
   if (!DeclNode) {
     return true;
   }
+  if (Options.IgnoreSystemHeaders && isInSystemHeader(DeclNode))
+    return true;
+  const DeclContext *DC = DeclNode->getLexicalDeclContext();
+  if (Options.ScopeParentMaps && !ParentMapRoot && DC &&
+      DC->isTranslationUnit()) {
+    // The instantiations of a top-level template are also in the translation
+    // unit, but they are visited from the template and stay in its scope.
+    ParentMapRoot = DeclNode;
+    ActiveASTContext->setParentMapScope(DeclNode);
+    match(*DeclNode);
+    bool Result = RecursiveASTVisitor<MatchASTVisitor>::TraverseDecl(DeclNode);
+    ParentMapRoot = nullptr;
+    return Result;
+  }
   match(*DeclNode);
   return RecursiveASTVisitor<MatchASTVisitor>::TraverseDecl(DeclNode);
 }
@@ -1012,6 +1041,8 @@ void MatchFinder::matchAST(ASTContext &Context) {
   Visitor.set_active_ast_context(&Context);
   Visitor.onStartOfTranslationUnit();
   Visitor.TraverseDecl(Context.getTranslationUnitDecl());
+  if (Options.ScopeParentMaps)
+    Context.setParentMapScope(nullptr);
   Visitor.onEndOfTranslationUnit();
 }
 
@@ -40,6 +40,9 @@ AnalysisDeclContext::AnalysisDeclContext(AnalysisDeclContextManager *Mgr,
                                          const CFG::BuildOptions &buildOptions)
   : Manager(Mgr),
     D(d),
+    cfg(nullptr),
+    completeCFG(nullptr),
+    Cache(Mgr ? &Mgr->getCFGCache() : nullptr),
     cfgBuildOptions(buildOptions),
     forcedBlkExprs(nullptr),
     builtCFG(false),
@@ -54,6 +57,9 @@ AnalysisDeclContext::AnalysisDeclContext(AnalysisDeclContextManager *Mgr,
                                          const Decl *d)
 : Manager(Mgr),
   D(d),
+  cfg(nullptr),
+  completeCFG(nullptr),
+  Cache(Mgr ? &Mgr->getCFGCache() : nullptr),
   forcedBlkExprs(nullptr),
   builtCFG(false),
   builtCompleteCFG(false),
@@ -71,7 +77,8 @@ AnalysisDeclContextManager::AnalysisDeclContextManager(bool useUnoptimizedCFG,
                                                        bool addStaticInitBranch,
                                                        bool addCXXNewAllocator,
                                                        CodeInjector *injector)
-  : Injector(injector), SynthesizeBodies(synthesizeBodies)
+  : Injector(injector), SynthesizeBodies(synthesizeBodies),
+    CFGs(cfgBuildOptions)
 {
   cfgBuildOptions.PruneTriviallyFalseEdges = !useUnoptimizedCFG;
   cfgBuildOptions.AddImplicitDtors = addImplicitDtors;
@@ -209,42 +216,88 @@ static void addParentsForSyntheticStmts(const CFG *TheCFG, ParentMap &PM) {
   }
 }
 
+CFG *CFGCache::lookup(const Decl *D, const Stmt *Body,
+                      const CFG::BuildOptions &Options) const {
+  auto I = CFGs.find(Key(D, Body));
+  if (I == CFGs.end())
+    return nullptr;
+  for (const Entry &E : I->second)
+    if (E.Options.subsumes(Options))
+      return E.Graph.get();
+  return nullptr;
+}
+
+CFG *CFGCache::insert(const Decl *D, const Stmt *Body,
+                      const CFG::BuildOptions &Options,
+                      std::unique_ptr<CFG> &Graph) {
+  CFG *Result = Graph.get();
+  // The cache serves both the pruned and the unoptimized CFGs.
+  CFG::BuildOptions Retained = RetainedOptions;
+  Retained.PruneTriviallyFalseEdges = Options.PruneTriviallyFalseEdges;
+  if (Result && Options.subsumes(Retained)) {
+    Entry E;
+    E.Options = Options;
+    // These belong to the client that built the CFG.
+    E.Options.forcedBlkExprs = nullptr;
+    E.Options.Observer = nullptr;
+    E.Graph = std::move(Graph);
+    CFGs[Key(D, Body)].push_back(std::move(E));
+  }
+  return Result;
+}
+
+/// Builds the CFG with the current options, or takes it from the cache.
+/// \p Owned receives the CFG if the cache does not keep it.
+CFG *AnalysisDeclContext::buildCFG(std::unique_ptr<CFG> &Owned) {
+  Stmt *Body = getBody();
+  // The forced block expressions and the observer are filled in and called
+  // while the CFG is built, so they rule out the CFGs built by others.
+  bool UseCache = Cache && !forcedBlkExprs;
+  if (UseCache && !cfgBuildOptions.Observer)
+    if (CFG *Cached = Cache->lookup(D, Body, cfgBuildOptions))
+      return Cached;
+
+  Owned = CFG::buildCFG(D, Body, &D->getASTContext(), cfgBuildOptions);
+  if (UseCache)
+    return Cache->insert(D, Body, cfgBuildOptions, Owned);
+  return Owned.get();
+}
+
 CFG *AnalysisDeclContext::getCFG() {
   if (!cfgBuildOptions.PruneTriviallyFalseEdges)
     return getUnoptimizedCFG();
 
   if (!builtCFG) {
-    cfg = CFG::buildCFG(D, getBody(), &D->getASTContext(), cfgBuildOptions);
+    cfg = buildCFG(ownedCFG);
     // Even when the cfg is not successfully built, we don't
     // want to try building it again.
     builtCFG = true;
 
     if (PM)
-      addParentsForSyntheticStmts(cfg.get(), *PM);
+      addParentsForSyntheticStmts(cfg, *PM);
 
     // The Observer should only observe one build of the CFG.
     getCFGBuildOptions().Observer = nullptr;
   }
-  return cfg.get();
+  return cfg;
 }
 
 CFG *AnalysisDeclContext::getUnoptimizedCFG() {
   if (!builtCompleteCFG) {
     SaveAndRestore<bool> NotPrune(cfgBuildOptions.PruneTriviallyFalseEdges,
                                   false);
-    completeCFG =
-        CFG::buildCFG(D, getBody(), &D->getASTContext(), cfgBuildOptions);
+    completeCFG = buildCFG(ownedCompleteCFG);
     // Even when the cfg is not successfully built, we don't
     // want to try building it again.
     builtCompleteCFG = true;
 
     if (PM)
-      addParentsForSyntheticStmts(completeCFG.get(), *PM);
+      addParentsForSyntheticStmts(completeCFG, *PM);
 
     // The Observer should only observe one build of the CFG.
     getCFGBuildOptions().Observer = nullptr;
   }
-  return completeCFG.get();
+  return completeCFG;
 }
 
 CFGStmtMap *AnalysisDeclContext::getCFGStmtMap() {
@@ -3111,6 +3111,18 @@ CFGBlock *CFGBuilder::VisitSwitchStmt(SwitchStmt *Terminator) {
   // Create a new block that will contain the switch statement.
   SwitchTerminatedBlock = createBlock(false);
 
+  // Each case gets a block and a successor of the switch, and so does the
+  // default. Make room for them up front: switches generated for state
+  // machines can have tens of thousands of cases.
+  unsigned NumCases = 0;
+  for (const SwitchCase *SC = Terminator->getSwitchCaseList(); SC;
+       SC = SC->getNextSwitchCase())
+    if (isa<CaseStmt>(SC))
+      ++NumCases;
+  cfg->reserveBlocks(NumCases);
+  SwitchTerminatedBlock->reserveSuccessors(NumCases + 1,
+                                           cfg->getBumpVectorContext());
+
   // Now process the switch body.  The code after the switch is the implicit
   // successor.
   Succ = SwitchSuccessor;
@@ -18,6 +18,8 @@
 #include "clang/AST/Stmt.h"
 #include "clang/AST/StmtVisitor.h"
 #include "clang/Lex/Lexer.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/MD5.h"
 #include "llvm/Support/raw_ostream.h"
@@ -558,27 +560,39 @@ class CloneSignatureGenerator {
     // FIXME: This function has quadratic runtime right now. Check if skipping
     // this function for too long CompoundStmts is an option.
 
+    // The signature of a sub-sequence extends the signature of the
+    // sub-sequence that starts at the same position and is one statement
+    // shorter, so we keep the unfinished hash of each start position instead
+    // of hashing all the selected children again.
+    unsigned Size = CS->size();
+    std::vector<CloneDetector::CloneSignature> SubSignatures(ChildSignatures);
+    std::vector<llvm::MD5> SubHashes(Size);
+    for (unsigned Pos = 0; Pos < Size; ++Pos) {
+      size_t ChildHash = ChildSignatures[Pos].Hash;
+      SubHashes[Pos].update(StringRef(reinterpret_cast<char *>(&ChildHash),
+                                      sizeof(ChildHash)));
+    }
+
     // The length of the sub-sequence. We don't need to handle sequences with
     // the length 1 as they are already handled in CollectData().
-    for (unsigned Length = 2; Length <= CS->size(); ++Length) {
+    for (unsigned Length = 2; Length <= Size; ++Length) {
       // The start index in the body of the CompoundStmt. We increase the
       // position until the end of the sub-sequence reaches the end of the
       // CompoundStmt body.
-      for (unsigned Pos = 0; Pos <= CS->size() - Length; ++Pos) {
-        // Create an empty signature and add the signatures of all selected
-        // child statements to it.
-        CloneDetector::CloneSignature SubSignature;
-        llvm::MD5 SubHash;
-
-        for (unsigned i = Pos; i < Pos + Length; ++i) {
-          SubSignature.Complexity += ChildSignatures[i].Complexity;
-          size_t ChildHash = ChildSignatures[i].Hash;
-
-          SubHash.update(StringRef(reinterpret_cast<char *>(&ChildHash),
-                                sizeof(ChildHash)));
-        }
-
-        // Create the final hash code for the current signature.
+      for (unsigned Pos = 0; Pos <= Size - Length; ++Pos) {
+        // Add the signature of the last selected child statement to the
+        // signature of the shorter sub-sequence.
+        const CloneDetector::CloneSignature &Last =
+            ChildSignatures[Pos + Length - 1];
+        CloneDetector::CloneSignature &SubSignature = SubSignatures[Pos];
+        SubSignature.Complexity += Last.Complexity;
+        size_t ChildHash = Last.Hash;
+        SubHashes[Pos].update(StringRef(reinterpret_cast<char *>(&ChildHash),
+                                        sizeof(ChildHash)));
+
+        // Create the final hash code for the current signature from a copy,
+        // as the longer sub-sequences still need to extend the hash.
+        llvm::MD5 SubHash = SubHashes[Pos];
         llvm::MD5::MD5Result HashResult;
         SubHash.final(HashResult);
 
@@ -615,34 +629,87 @@ void CloneDetector::add(const StmtSequence &S,
 }
 
 namespace {
-/// \brief Returns true if and only if \p Stmt contains at least one other
-/// sequence in the \p Group.
-bool containsAnyInGroup(StmtSequence &Stmt, CloneDetector::CloneGroup &Group) {
-  for (StmtSequence &GroupStmt : Group.Sequences) {
-    if (Stmt.contains(GroupStmt))
-      return true;
+/// \brief A sequence of a clone group together with the index of its group.
+struct GroupMember {
+  const StmtSequence *Seq;
+  unsigned Group;
+
+  GroupMember(const StmtSequence *Seq, unsigned Group)
+      : Seq(Seq), Group(Group) {}
+};
+
+/// \brief Orders sequences by their translation unit and their start location,
+/// so that the sequences within a sequence follow it.
+class StartsBefore {
+public:
+  bool operator()(const GroupMember &LHS, const GroupMember &RHS) const {
+    return (*this)(*LHS.Seq, *RHS.Seq);
   }
-  return false;
-}
+  bool operator()(const GroupMember &LHS, const StmtSequence &RHS) const {
+    return (*this)(*LHS.Seq, RHS);
+  }
+  bool operator()(const StmtSequence &LHS, const StmtSequence &RHS) const {
+    ASTContext *LHSContext = &LHS.getASTContext();
+    ASTContext *RHSContext = &RHS.getASTContext();
+    if (LHSContext != RHSContext)
+      return std::less<ASTContext *>()(LHSContext, RHSContext);
+    return LHSContext->getSourceManager().isBeforeInTranslationUnit(
+        LHS.getStartLoc(), RHS.getStartLoc());
+  }
+};
+} // end anonymous namespace
 
-/// \brief Returns true if and only if all sequences in \p OtherGroup are
-/// contained by a sequence in \p Group.
-bool containsGroup(CloneDetector::CloneGroup &Group,
-                   CloneDetector::CloneGroup &OtherGroup) {
-  // We have less sequences in the current group than we have in the other,
-  // so we will never fulfill the requirement for returning true. This is only
-  // possible because we know that a sequence in Group can contain at most
-  // one sequence in OtherGroup.
-  if (Group.Sequences.size() < OtherGroup.Sequences.size())
-    return false;
+/// \brief Marks in \p IsContained each group of which all sequences are
+/// contained by the sequences of another group that has at least as many
+/// sequences.
+///
+/// Instead of comparing every pair of groups, the sequences of all groups are
+/// sorted by their start location. The sequences contained by a sequence are
+/// then found in the run that follows it, up to the first sequence that starts
+/// after it ends.
+static void findContainedGroups(
+    const std::vector<CloneDetector::CloneGroup> &Groups,
+    llvm::BitVector &IsContained) {
+  std::vector<GroupMember> Members;
+  for (unsigned i = 0; i < Groups.size(); ++i)
+    for (const StmtSequence &Seq : Groups[i].Sequences)
+      Members.push_back(GroupMember(&Seq, i));
+  std::sort(Members.begin(), Members.end(), StartsBefore());
+
+  for (unsigned j = 0; j < Groups.size(); ++j) {
+    const std::vector<StmtSequence> &Outer = Groups[j].Sequences;
+
+    // The number of sequences of this group that contain a sequence of the
+    // other group, counting from the first sequence of this group.
+    llvm::DenseMap<unsigned, unsigned> NumContaining;
+
+    for (unsigned k = 0; k < Outer.size(); ++k) {
+      const StmtSequence &Seq = Outer[k];
+      const SourceManager &SM = Seq.getASTContext().getSourceManager();
+      auto I = std::lower_bound(Members.begin(), Members.end(), Seq,
+                                StartsBefore());
+      for (auto E = Members.end(); I != E; ++I) {
+        if (&I->Seq->getASTContext() != &Seq.getASTContext() ||
+            SM.isBeforeInTranslationUnit(Seq.getEndLoc(),
+                                         I->Seq->getStartLoc()))
+          break;
+        if (I->Group == j || !Seq.contains(*I->Seq))
+          continue;
+        // A group can only contain the other one if all the sequences before
+        // this one contain one of its sequences, and each sequence is only
+        // counted once.
+        unsigned &Count = NumContaining[I->Group];
+        if (Count == k)
+          ++Count;
+      }
+    }
 
-  for (StmtSequence &Stmt : Group.Sequences) {
-    if (!containsAnyInGroup(Stmt, OtherGroup))
-      return false;
+    for (const auto &Entry : NumContaining)
+      if (Entry.second == Outer.size() &&
+          Outer.size() >= Groups[Entry.first].Sequences.size())
+        IsContained[Entry.first] = true;
   }
-  return true;
 }
-} // end anonymous namespace
 
 namespace {
 /// \brief Wrapper around FoldingSetNodeID that it can be used as the template
@@ -832,31 +899,20 @@ void CloneDetector::findClones(std::vector<CloneGroup> &Result,
     createCloneGroups(Result, Group, CheckPatterns);
   }
 
-  std::vector<unsigned> IndexesToRemove;
+  // If one group contains another group, we only need to return the bigger
+  // group.
+  llvm::BitVector IsContained(Result.size());
+  findContainedGroups(Result, IsContained);
 
-  // Compare every group in the result with the rest. If one groups contains
-  // another group, we only need to return the bigger group.
-  // Note: This doesn't scale well, so if possible avoid calling any heavy
-  // function from this loop to minimize the performance impact.
+  unsigned NumKept = 0;
   for (unsigned i = 0; i < Result.size(); ++i) {
-    for (unsigned j = 0; j < Result.size(); ++j) {
-      // Don't compare a group with itself.
-      if (i == j)
-        continue;
-
-      if (containsGroup(Result[j], Result[i])) {
-        IndexesToRemove.push_back(i);
-        break;
-      }
-    }
-  }
-
-  // Erasing a list of indexes from the vector should be done with decreasing
-  // indexes. As IndexesToRemove is constructed with increasing values, we just
-  // reverse iterate over it to get the desired order.
-  for (auto I = IndexesToRemove.rbegin(); I != IndexesToRemove.rend(); ++I) {
-    Result.erase(Result.begin() + *I);
+    if (IsContained[i])
+      continue;
+    if (NumKept != i)
+      Result[NumKept] = std::move(Result[i]);
+    ++NumKept;
   }
+  Result.resize(NumKept);
 }
 
 void CloneDetector::findSuspiciousClones(
@@ -0,0 +1,385 @@
+//===- ConstantBranches.cpp - Branches with constant conditions -*- C++ --*-==//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements ConstantBranches, a constant propagation over the CFG
+// that only follows the branches that may be taken.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Analysis/Analyses/ConstantBranches.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Attr.h"
+#include "clang/AST/ParentMap.h"
+#include "clang/AST/StmtCXX.h"
+#include "clang/Analysis/CFG.h"
+#include "llvm/ADT/APSInt.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallVector.h"
+
+using namespace clang;
+
+namespace {
+/// The values of the tracked locals that are constant at a program point.
+/// The locals that are not in the map may have any value.
+typedef llvm::DenseMap<const VarDecl *, llvm::APSInt> ValueMap;
+
+class ConstantEvaluator {
+  ASTContext &Ctx;
+
+  /// The locals that may be changed by something else than an assignment,
+  /// or that are used in a way this analysis does not understand.
+  llvm::DenseSet<const VarDecl *> Escaped;
+
+  void findEscaped(const Stmt *S, ParentMap &PM);
+
+  llvm::APSInt convert(llvm::APSInt V, QualType T) const;
+  Optional<llvm::APSInt> evalBinary(const BinaryOperator *BO,
+                                    const ValueMap &Values) const;
+
+public:
+  ConstantEvaluator(AnalysisDeclContext &AC) : Ctx(AC.getASTContext()) {
+    findEscaped(AC.getBody(), AC.getParentMap());
+  }
+
+  bool isTracked(const VarDecl *VD) const;
+  const VarDecl *getTrackedVar(const Expr *E) const;
+  Optional<llvm::APSInt> eval(const Expr *E, const ValueMap &Values) const;
+  void transfer(const Stmt *S, ValueMap &Values) const;
+};
+} // end anonymous namespace
+
+void ConstantEvaluator::findEscaped(const Stmt *S, ParentMap &PM) {
+  if (!S)
+    return;
+
+  if (const auto *DRE = dyn_cast<DeclRefExpr>(S)) {
+    if (const auto *VD = dyn_cast<VarDecl>(DRE->getDecl())) {
+      const Stmt *P = PM.getParentIgnoreParens(DRE);
+      bool Understood = false;
+      if (const auto *ICE = dyn_cast_or_null<ImplicitCastExpr>(P))
+        Understood = ICE->getCastKind() == CK_LValueToRValue;
+      else if (const auto *BO = dyn_cast_or_null<BinaryOperator>(P))
+        Understood = BO->isAssignmentOp() &&
+                     BO->getLHS()->IgnoreParens() == DRE;
+      else if (const auto *UO = dyn_cast_or_null<UnaryOperator>(P))
+        Understood = UO->isIncrementDecrementOp();
+
+      // Closures may run at any time, and change the locals they capture.
+      if (!Understood || DRE->refersToEnclosingVariableOrCapture())
+        Escaped.insert(VD);
+    }
+  }
+
+  for (const Stmt *Child : S->children())
+    findEscaped(Child, PM);
+}
+
+bool ConstantEvaluator::isTracked(const VarDecl *VD) const {
+  if (!VD->hasLocalStorage() || isa<ParmVarDecl>(VD) ||
+      VD->hasAttr<BlocksAttr>())
+    return false;
+  QualType T = VD->getType();
+  return !T.isVolatileQualified() && T->isIntegralOrEnumerationType() &&
+         !Escaped.count(VD);
+}
+
+const VarDecl *ConstantEvaluator::getTrackedVar(const Expr *E) const {
+  const auto *DRE = dyn_cast<DeclRefExpr>(E->IgnoreParens());
+  if (!DRE)
+    return nullptr;
+  const auto *VD = dyn_cast<VarDecl>(DRE->getDecl());
+  return VD && isTracked(VD) ? VD : nullptr;
+}
+
+llvm::APSInt ConstantEvaluator::convert(llvm::APSInt V, QualType T) const {
+  if (T->isBooleanType())
+    return Ctx.MakeIntValue(V.getBoolValue(), T);
+  V = V.extOrTrunc(Ctx.getIntWidth(T));
+  V.setIsUnsigned(T->isUnsignedIntegerOrEnumerationType());
+  return V;
+}
+
+Optional<llvm::APSInt>
+ConstantEvaluator::evalBinary(const BinaryOperator *BO,
+                              const ValueMap &Values) const {
+  BinaryOperatorKind Op = BO->getOpcode();
+  switch (Op) {
+  case BO_Assign:
+    if (Optional<llvm::APSInt> V = eval(BO->getRHS(), Values))
+      return convert(*V, BO->getLHS()->getType());
+    return None;
+  case BO_Comma:
+    return eval(BO->getRHS(), Values);
+  case BO_LAnd:
+  case BO_LOr: {
+    Optional<llvm::APSInt> L = eval(BO->getLHS(), Values);
+    if (!L)
+      return None;
+    // The right-hand side is not evaluated when the left one decides.
+    if (L->getBoolValue() == (Op == BO_LOr))
+      return Ctx.MakeIntValue(Op == BO_LOr, BO->getType());
+    Optional<llvm::APSInt> R = eval(BO->getRHS(), Values);
+    if (!R)
+      return None;
+    return Ctx.MakeIntValue(R->getBoolValue(), BO->getType());
+  }
+  default:
+    break;
+  }
+
+  Optional<llvm::APSInt> L = eval(BO->getLHS(), Values);
+  Optional<llvm::APSInt> R = eval(BO->getRHS(), Values);
+  // The usual arithmetic conversions give both operands the same type.
+  if (!L || !R || L->getBitWidth() != R->getBitWidth() ||
+      L->isUnsigned() != R->isUnsigned())
+    return None;
+
+  switch (Op) {
+  case BO_Mul: return *L * *R;
+  case BO_Add: return *L + *R;
+  case BO_Sub: return *L - *R;
+  case BO_And: return *L & *R;
+  case BO_Or:  return *L | *R;
+  case BO_Xor: return *L ^ *R;
+  case BO_Div:
+  case BO_Rem:
+    if (*R == 0 ||
+        (L->isSigned() && L->isMinSignedValue() && R->isAllOnesValue()))
+      return None;
+    return Op == BO_Div ? *L / *R : *L % *R;
+  case BO_LT: return Ctx.MakeIntValue(*L < *R, BO->getType());
+  case BO_GT: return Ctx.MakeIntValue(*L > *R, BO->getType());
+  case BO_LE: return Ctx.MakeIntValue(*L <= *R, BO->getType());
+  case BO_GE: return Ctx.MakeIntValue(*L >= *R, BO->getType());
+  case BO_EQ: return Ctx.MakeIntValue(*L == *R, BO->getType());
+  case BO_NE: return Ctx.MakeIntValue(*L != *R, BO->getType());
+  default:
+    return None;
+  }
+}
+
+Optional<llvm::APSInt> ConstantEvaluator::eval(const Expr *E,
+                                               const ValueMap &Values) const {
+  E = E->IgnoreParens();
+  QualType T = E->getType();
+  if (E->isValueDependent() || !T->isIntegralOrEnumerationType())
+    return None;
+
+  llvm::APSInt Result;
+  if (E->EvaluateAsInt(Result, Ctx))
+    return convert(Result, T);
+
+  if (const VarDecl *VD = getTrackedVar(E)) {
+    auto I = Values.find(VD);
+    if (I == Values.end())
+      return None;
+    return I->second;
+  }
+
+  if (const auto *CE = dyn_cast<CastExpr>(E)) {
+    switch (CE->getCastKind()) {
+    case CK_LValueToRValue:
+    case CK_NoOp:
+    case CK_IntegralCast:
+    case CK_IntegralToBoolean:
+      if (Optional<llvm::APSInt> V = eval(CE->getSubExpr(), Values))
+        return convert(*V, T);
+      return None;
+    default:
+      return None;
+    }
+  }
+
+  if (const auto *UO = dyn_cast<UnaryOperator>(E)) {
+    Optional<llvm::APSInt> V = eval(UO->getSubExpr(), Values);
+    if (!V)
+      return None;
+    switch (UO->getOpcode()) {
+    case UO_LNot: return Ctx.MakeIntValue(!V->getBoolValue(), T);
+    case UO_Minus: return convert(-*V, T);
+    case UO_Not: return convert(~*V, T);
+    case UO_Plus: return convert(*V, T);
+    default:
+      return None;
+    }
+  }
+
+  if (const auto *BO = dyn_cast<BinaryOperator>(E))
+    if (Optional<llvm::APSInt> V = evalBinary(BO, Values))
+      return convert(*V, T);
+
+  return None;
+}
+
+void ConstantEvaluator::transfer(const Stmt *S, ValueMap &Values) const {
+  if (const auto *DS = dyn_cast<DeclStmt>(S)) {
+    for (const Decl *D : DS->decls()) {
+      const auto *VD = dyn_cast<VarDecl>(D);
+      if (!VD || !isTracked(VD))
+        continue;
+      Optional<llvm::APSInt> V;
+      if (const Expr *Init = VD->getInit())
+        V = eval(Init, Values);
+      if (V)
+        Values[VD] = convert(*V, VD->getType());
+      else
+        Values.erase(VD);
+    }
+    return;
+  }
+
+  if (const auto *BO = dyn_cast<BinaryOperator>(S)) {
+    if (!BO->isAssignmentOp())
+      return;
+    if (const VarDecl *VD = getTrackedVar(BO->getLHS())) {
+      Optional<llvm::APSInt> V;
+      if (BO->getOpcode() == BO_Assign)
+        V = eval(BO, Values);
+      if (V)
+        Values[VD] = *V;
+      else
+        Values.erase(VD);
+    }
+    return;
+  }
+
+  if (const auto *UO = dyn_cast<UnaryOperator>(S))
+    if (UO->isIncrementDecrementOp())
+      if (const VarDecl *VD = getTrackedVar(UO->getSubExpr()))
+        Values.erase(VD);
+}
+
+static bool hasSameValue(const ValueMap &Values, const VarDecl *VD,
+                         const llvm::APSInt &V) {
+  auto I = Values.find(VD);
+  return I != Values.end() && llvm::APSInt::isSameValue(I->second, V);
+}
+
+/// Keep the values of \p To that \p From agrees with.
+static void intersect(ValueMap &To, const ValueMap &From) {
+  SmallVector<const VarDecl *, 8> Differing;
+  for (const auto &Entry : To)
+    if (!hasSameValue(From, Entry.first, Entry.second))
+      Differing.push_back(Entry.first);
+  for (const VarDecl *VD : Differing)
+    To.erase(VD);
+}
+
+static bool isSame(const ValueMap &LHS, const ValueMap &RHS) {
+  if (LHS.size() != RHS.size())
+    return false;
+  for (const auto &Entry : LHS)
+    if (!hasSameValue(RHS, Entry.first, Entry.second))
+      return false;
+  return true;
+}
+
+static bool isBranch(const CFGBlock *B) {
+  const Stmt *Term = B->getTerminator().getStmt();
+  if (!Term || B->succ_size() != 2)
+    return false;
+  if (const auto *BO = dyn_cast<BinaryOperator>(Term))
+    return BO->isLogicalOp();
+  return isa<IfStmt>(Term) || isa<WhileStmt>(Term) || isa<DoStmt>(Term) ||
+         isa<ForStmt>(Term) || isa<ConditionalOperator>(Term);
+}
+
+ConstantBranches::ConstantBranches(AnalysisDeclContext &AC, const CFG &G)
+    : Known(G.getNumBlockIDs()), Values(G.getNumBlockIDs()) {
+  ConstantEvaluator Eval(AC);
+  unsigned NumBlocks = G.getNumBlockIDs();
+  std::vector<ValueMap> Out(NumBlocks);
+  llvm::BitVector Visited(NumBlocks), InWorklist(NumBlocks);
+
+  // An edge is executable if its source is, and its branch may be taken.
+  auto IsExecutable = [&](const CFGBlock *Pred, const CFGBlock *Succ) {
+    if (!Visited[Pred->getBlockID()])
+      return false;
+    unsigned Idx = 0;
+    for (CFGBlock::const_succ_iterator I = Pred->succ_begin(),
+                                       E = Pred->succ_end();
+         I != E; ++I, ++Idx) {
+      if (*I != Succ)
+        continue;
+      if (!Known[Pred->getBlockID()] ||
+          bool(Values[Pred->getBlockID()]) == (Idx == 0))
+        return true;
+    }
+    return false;
+  };
+
+  SmallVector<const CFGBlock *, 32> Worklist;
+  Worklist.push_back(&G.getEntry());
+  InWorklist.set(G.getEntry().getBlockID());
+
+  // Values are only ever removed from the maps, so this terminates.
+  while (!Worklist.empty()) {
+    const CFGBlock *B = Worklist.pop_back_val();
+    unsigned ID = B->getBlockID();
+    InWorklist.reset(ID);
+
+    ValueMap In;
+    bool First = true;
+    for (const CFGBlock *Pred : B->preds()) {
+      if (!Pred || !IsExecutable(Pred, B))
+        continue;
+      if (First)
+        In = Out[Pred->getBlockID()];
+      else
+        intersect(In, Out[Pred->getBlockID()]);
+      First = false;
+    }
+
+    for (const CFGElement &Elem : *B)
+      if (Optional<CFGStmt> CS = Elem.getAs<CFGStmt>())
+        Eval.transfer(CS->getStmt(), In);
+
+    bool WasKnown = Known[ID], OldValue = Values[ID];
+    Known.reset(ID);
+    if (isBranch(B))
+      if (const auto *Cond = dyn_cast_or_null<Expr>(B->getTerminatorCondition()))
+        if (Optional<llvm::APSInt> V = Eval.eval(Cond, In)) {
+          Known.set(ID);
+          Values[ID] = V->getBoolValue();
+        }
+
+    bool Changed = !Visited[ID] || WasKnown != Known[ID] ||
+                   OldValue != Values[ID] || !isSame(In, Out[ID]);
+    Visited.set(ID);
+    if (!Changed)
+      continue;
+    Out[ID] = std::move(In);
+
+    for (const CFGBlock *Succ : B->succs())
+      if (Succ && !InWorklist[Succ->getBlockID()] && IsExecutable(B, Succ)) {
+        Worklist.push_back(Succ);
+        InWorklist.set(Succ->getBlockID());
+      }
+  }
+
+  // A block that is never executed does not tell anything about its branch.
+  Known &= Visited;
+}
+
+Optional<bool> ConstantBranches::getBranchValue(const CFGBlock *B) const {
+  unsigned ID = B->getBlockID();
+  if (!Known[ID])
+    return None;
+  return Values[ID];
+}
+
+ConstantBranches *ConstantBranches::create(AnalysisDeclContext &AC) {
+  const CFG *G = AC.getCFG();
+  if (!G)
+    return nullptr;
+  return new ConstantBranches(AC, *G);
+}
+
+const void *ConstantBranches::getTag() { static int x; return &x; }
@@ -19,6 +19,7 @@
 #include "clang/AST/Attr.h"
 #include "clang/AST/DeclCXX.h"
 #include "clang/AST/ExprCXX.h"
+#include "clang/AST/ExprObjC.h"
 #include "clang/AST/StmtCXX.h"
 #include "clang/AST/StmtVisitor.h"
 #include "clang/Analysis/Analyses/PostOrderCFGView.h"
@@ -2375,6 +2376,85 @@ void ThreadSafetyAnalyzer::runAnalysis(AnalysisDeclContext &AC) {
 }
 
 
+/// \brief Returns true if \p D has one of the thread safety attributes.
+static bool hasThreadSafetyAttrs(const Decl *D) {
+  if (!D || !D->hasAttrs())
+    return false;
+  for (const Attr *A : D->attrs()) {
+    switch (A->getKind()) {
+    case attr::AcquireCapability:
+    case attr::AcquiredAfter:
+    case attr::AcquiredBefore:
+    case attr::AssertCapability:
+    case attr::AssertExclusiveLock:
+    case attr::AssertSharedLock:
+    case attr::ExclusiveTrylockFunction:
+    case attr::GuardedBy:
+    case attr::GuardedVar:
+    case attr::LockReturned:
+    case attr::LocksExcluded:
+    case attr::NoThreadSafetyAnalysis:
+    case attr::PtGuardedBy:
+    case attr::PtGuardedVar:
+    case attr::ReleaseCapability:
+    case attr::RequiresCapability:
+    case attr::SharedTrylockFunction:
+    case attr::TryAcquireCapability:
+      return true;
+    default:
+      break;
+    }
+  }
+  return false;
+}
+
+/// \brief Returns the destructor that destroys the objects of type \p T.
+static const CXXDestructorDecl *getDestructor(QualType T) {
+  if (const CXXRecordDecl *RD = T->getBaseElementTypeUnsafe()
+                                     ->getAsCXXRecordDecl())
+    return RD->hasDefinition() ? RD->getDestructor() : nullptr;
+  return nullptr;
+}
+
+/// \brief Returns true if \p S refers to a declaration with a thread safety
+/// attribute, including the destructors that are called implicitly.
+static bool usesThreadSafetyAttrs(const Stmt *S) {
+  if (!S)
+    return false;
+
+  const Decl *D = nullptr;
+  if (const auto *DRE = dyn_cast<DeclRefExpr>(S))
+    D = DRE->getDecl();
+  else if (const auto *ME = dyn_cast<MemberExpr>(S))
+    D = ME->getMemberDecl();
+  else if (const auto *CE = dyn_cast<CXXConstructExpr>(S))
+    D = CE->getConstructor();
+  else if (const auto *BTE = dyn_cast<CXXBindTemporaryExpr>(S))
+    D = BTE->getTemporary()->getDestructor();
+  else if (const auto *DE = dyn_cast<CXXDeleteExpr>(S))
+    D = getDestructor(DE->getDestroyedType());
+  else if (const auto *IRE = dyn_cast<ObjCIvarRefExpr>(S))
+    D = IRE->getDecl();
+  else if (const auto *OME = dyn_cast<ObjCMessageExpr>(S))
+    D = OME->getMethodDecl();
+  else if (const auto *DS = dyn_cast<DeclStmt>(S)) {
+    // The destructors of local variables are only in the CFG.
+    for (const Decl *Member : DS->decls())
+      if (const auto *VD = dyn_cast<VarDecl>(Member))
+        if (hasThreadSafetyAttrs(VD) ||
+            (VD->hasLocalStorage() &&
+             hasThreadSafetyAttrs(getDestructor(VD->getType()))))
+          return true;
+  }
+  if (hasThreadSafetyAttrs(D))
+    return true;
+
+  for (const Stmt *Child : S->children())
+    if (usesThreadSafetyAttrs(Child))
+      return true;
+  return false;
+}
+
 /// \brief Check a function's CFG for thread-safety violations.
 ///
 /// We traverse the blocks in the CFG, compute the set of mutexes that are held
@@ -2385,6 +2465,14 @@ void threadSafety::runThreadSafetyAnalysis(AnalysisDeclContext &AC,
                                            BeforeSet **BSet) {
   if (!*BSet)
     *BSet = new BeforeSet;
+
+  // A function that is not annotated can only hold a capability or access a
+  // guarded variable through a declaration that is, so if its body uses none
+  // of them there is nothing to check and no need to translate it.
+  if (!hasThreadSafetyAttrs(AC.getDecl()) &&
+      !usesThreadSafetyAttrs(AC.getBody()))
+    return;
+
   ThreadSafetyAnalyzer Analyzer(Handler, *BSet);
   Analyzer.runAnalysis(AC);
 }
@@ -25,6 +25,7 @@
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/PackedVector.h"
 #include "llvm/ADT/SmallBitVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/SaveAndRestore.h"
 #include <utility>
@@ -53,8 +54,10 @@ class DeclToIndex {
 public:
   DeclToIndex() {}
   
-  /// Compute the actual mapping from declarations to bits.
-  void computeMap(const DeclContext &dc);
+  /// Compute the actual mapping from declarations to bits, for the tracked
+  /// variables in \p candidates that may be used uninitialized.
+  void computeMap(const DeclContext &dc,
+                  const llvm::SmallPtrSetImpl<const VarDecl *> &candidates);
   
   /// Return the number of declarations in the map.
   unsigned size() const { return map.size(); }
@@ -64,13 +67,48 @@ public:
 };
 }
 
-void DeclToIndex::computeMap(const DeclContext &dc) {
+/// Returns true if \p S refers to \p vd anywhere, including through the
+/// captures of a block.
+static bool refersToVar(const Stmt *S, const VarDecl *vd) {
+  if (!S)
+    return false;
+  if (const DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(S))
+    return DRE->getDecl() == vd;
+  if (const BlockExpr *BE = dyn_cast<BlockExpr>(S))
+    return BE->getBlockDecl()->capturesVariable(vd);
+  for (const Stmt *Child : S->children())
+    if (refersToVar(Child, vd))
+      return true;
+  return false;
+}
+
+/// Returns true if every use of \p vd is known to see the value of its
+/// initializer, so that the variable needs no dataflow at all.
+///
+/// C++ rejects any jump that bypasses the initialization of a variable, so
+/// its declaration is executed before each use in its scope unless the use
+/// is in the initializer itself. C and the Microsoft mode only warn about
+/// such jumps.
+static bool isInitializedAtEveryUse(const VarDecl *vd) {
+  const LangOptions &LangOpts = vd->getASTContext().getLangOpts();
+  if (!LangOpts.CPlusPlus || LangOpts.MSVCCompat)
+    return false;
+  const Expr *Init = vd->getInit();
+  return Init && !refersToVar(Init, vd);
+}
+
+void DeclToIndex::computeMap(
+    const DeclContext &dc,
+    const llvm::SmallPtrSetImpl<const VarDecl *> &candidates) {
   unsigned count = 0;
   DeclContext::specific_decl_iterator<VarDecl> I(dc.decls_begin()),
                                                E(dc.decls_end());
   for ( ; I != E; ++I) {
     const VarDecl *vd = *I;
-    if (isTrackedVar(vd, &dc))
+    // The value of each variable is computed independently of the others, so
+    // the variables that are never read uninitialized can be left out.
+    if (isTrackedVar(vd, &dc) && candidates.count(vd) &&
+        !isInitializedAtEveryUse(vd))
       map[vd] = count++;
   }
 }
@@ -114,7 +152,14 @@ public:
 
   unsigned getNumEntries() const { return declToIndex.size(); }
   
-  void computeSetOfDeclarations(const DeclContext &dc);  
+  void computeSetOfDeclarations(
+      const DeclContext &dc,
+      const llvm::SmallPtrSetImpl<const VarDecl *> &candidates);
+
+  bool hasEntry(const VarDecl *vd) const {
+    return declToIndex.getValueIndex(vd).hasValue();
+  }
+
   ValueVector &getValueVector(const CFGBlock *block) {
     return vals[block->getBlockID()];
   }
@@ -142,8 +187,10 @@ public:
 
 CFGBlockValues::CFGBlockValues(const CFG &c) : cfg(c), vals(0) {}
 
-void CFGBlockValues::computeSetOfDeclarations(const DeclContext &dc) {
-  declToIndex.computeMap(dc);
+void CFGBlockValues::computeSetOfDeclarations(
+    const DeclContext &dc,
+    const llvm::SmallPtrSetImpl<const VarDecl *> &candidates) {
+  declToIndex.computeMap(dc, candidates);
   unsigned decls = declToIndex.size();
   scratch.resize(decls);
   unsigned n = cfg.getNumBlockIDs();
@@ -314,6 +361,7 @@ public:
 private:
   const DeclContext *DC;
   llvm::DenseMap<const DeclRefExpr*, Class> Classification;
+  llvm::SmallPtrSet<const VarDecl *, 16> CapturedByCopy;
 
   bool isTrackedVar(const VarDecl *VD) const {
     return ::isTrackedVar(VD, DC);
@@ -324,6 +372,7 @@ private:
 public:
   ClassifyRefs(AnalysisDeclContext &AC) : DC(cast<DeclContext>(AC.getDecl())) {}
 
+  void VisitBlockExpr(BlockExpr *BE);
   void VisitDeclStmt(DeclStmt *DS);
   void VisitUnaryOperator(UnaryOperator *UO);
   void VisitBinaryOperator(BinaryOperator *BO);
@@ -344,6 +393,16 @@ public:
 
     return Init;
   }
+
+  /// Adds to \p Vars each tracked variable that is read by a use, a
+  /// self-initialization or a block capture, and so may be used
+  /// uninitialized.
+  void collectUsedVars(llvm::SmallPtrSetImpl<const VarDecl *> &Vars) const {
+    for (const auto &I : Classification)
+      if (I.second == Use || I.second == SelfInit)
+        Vars.insert(cast<VarDecl>(I.first->getDecl()));
+    Vars.insert(CapturedByCopy.begin(), CapturedByCopy.end());
+  }
 };
 }
 
@@ -406,6 +465,14 @@ void ClassifyRefs::classify(const Expr *E, Class C) {
     Classification[DRE] = std::max(Classification[DRE], C);
 }
 
+void ClassifyRefs::VisitBlockExpr(BlockExpr *BE) {
+  for (const auto &I : BE->getBlockDecl()->captures()) {
+    const VarDecl *VD = I.getVariable();
+    if (!I.isByRef() && isTrackedVar(VD))
+      CapturedByCopy.insert(VD);
+  }
+}
+
 void ClassifyRefs::VisitDeclStmt(DeclStmt *DS) {
   for (auto *DI : DS->decls()) {
     VarDecl *VD = dyn_cast<VarDecl>(DI);
@@ -516,8 +583,10 @@ public:
   void VisitObjCForCollectionStmt(ObjCForCollectionStmt *FS);
   void VisitObjCMessageExpr(ObjCMessageExpr *ME);
 
+  /// Returns true if \p vd has a value in the dataflow, which is only the
+  /// case for the tracked variables that may be used uninitialized.
   bool isTrackedVar(const VarDecl *vd) {
-    return ::isTrackedVar(vd, cast<DeclContext>(ac.getDecl()));
+    return vals.hasEntry(vd);
   }
 
   FindVarResult findVar(const Expr *ex) {
@@ -732,10 +801,12 @@ void TransferFunctions::VisitDeclRefExpr(DeclRefExpr *dr) {
   case ClassifyRefs::Ignore:
     break;
   case ClassifyRefs::Use:
-    reportUse(dr, cast<VarDecl>(dr->getDecl()));
+    if (isTrackedVar(cast<VarDecl>(dr->getDecl())))
+      reportUse(dr, cast<VarDecl>(dr->getDecl()));
     break;
   case ClassifyRefs::Init:
-    vals[cast<VarDecl>(dr->getDecl())] = Initialized;
+    if (isTrackedVar(cast<VarDecl>(dr->getDecl())))
+      vals[cast<VarDecl>(dr->getDecl())] = Initialized;
     break;
   case ClassifyRefs::SelfInit:
       handler.handleSelfInit(cast<VarDecl>(dr->getDecl()));
@@ -746,7 +817,8 @@ void TransferFunctions::VisitDeclRefExpr(DeclRefExpr *dr) {
 void TransferFunctions::VisitBinaryOperator(BinaryOperator *BO) {
   if (BO->getOpcode() == BO_Assign) {
     FindVarResult Var = findVar(BO->getLHS());
-    if (const VarDecl *VD = Var.getDecl())
+    const VarDecl *VD = Var.getDecl();
+    if (VD && isTrackedVar(VD))
       vals[VD] = Initialized;
   }
 }
@@ -871,17 +943,21 @@ void clang::runUninitializedVariablesAnalysis(
     AnalysisDeclContext &ac,
     UninitVariablesHandler &handler,
     UninitVariablesAnalysisStats &stats) {
+  // Precompute which expressions are uses and which are initializations.
+  ClassifyRefs classification(ac);
+  cfg.VisitBlockStmts(classification);
+
+  // Only the variables that are read somewhere can be used uninitialized.
+  llvm::SmallPtrSet<const VarDecl *, 16> candidates;
+  classification.collectUsedVars(candidates);
+
   CFGBlockValues vals(cfg);
-  vals.computeSetOfDeclarations(dc);
+  vals.computeSetOfDeclarations(dc, candidates);
   if (vals.hasNoDeclarations())
     return;
 
   stats.NumVariablesAnalyzed = vals.getNumEntries();
 
-  // Precompute which expressions are uses and which are initializations.
-  ClassifyRefs classification(ac);
-  cfg.VisitBlockStmts(classification);
-
   // Mark all variables uninitialized at the entry.
   const CFGBlock &entry = cfg.getEntry();
   ValueVector &vec = vals.getValueVector(&entry);
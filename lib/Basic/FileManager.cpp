@@ -51,7 +51,8 @@ using namespace clang;
 FileManager::FileManager(const FileSystemOptions &FSO,
                          IntrusiveRefCntPtr<vfs::FileSystem> FS)
   : FS(FS), FileSystemOpts(FSO),
-    SeenDirEntries(64), SeenFileEntries(64), NextFileUID(0) {
+    SeenDirEntries(64), SeenFileEntries(64), NextFileUID(0),
+    Prefetcher(nullptr) {
   NumDirLookups = NumFileLookups = 0;
   NumDirCacheMisses = NumFileCacheMisses = 0;
 
@@ -82,6 +83,8 @@ void FileManager::addStatCache(std::unique_ptr<FileSystemStatCache> statCache,
 void FileManager::removeStatCache(FileSystemStatCache *statCache) {
   if (!statCache)
     return;
+  if (statCache == Prefetcher)
+    Prefetcher = nullptr;
   
   if (StatCache.get() == statCache) {
     // This is the first stat cache.
@@ -100,6 +103,41 @@ void FileManager::removeStatCache(FileSystemStatCache *statCache) {
 
 void FileManager::clearStatCaches() {
   StatCache.reset();
+  Prefetcher = nullptr;
+}
+
+PrefetchStatCache *FileManager::getPrefetcher() {
+  if (!Prefetcher && (canPrefetchFiles() || SharedMissingPaths)) {
+    auto Cache = llvm::make_unique<PrefetchStatCache>(
+        FS, FileSystemOpts.StatPrefetchThreads, SharedMissingPaths);
+    Prefetcher = Cache.get();
+    addStatCache(std::move(Cache));
+  }
+  return Prefetcher;
+}
+
+void FileManager::prefetchFiles(ArrayRef<std::string> Paths) {
+  if (!canPrefetchFiles())
+    return;
+  if (FileSystemOpts.WorkingDir.empty()) {
+    getPrefetcher()->prefetch(Paths);
+    return;
+  }
+
+  // Look the paths up under the names getStatValue gives them.
+  std::vector<std::string> FixedPaths;
+  for (const std::string &Path : Paths) {
+    SmallString<128> FilePath(Path);
+    FixupRelativePath(FilePath);
+    FixedPaths.push_back(FilePath.str());
+  }
+  getPrefetcher()->prefetch(FixedPaths);
+}
+
+void FileManager::setSharedMissingPaths(
+    IntrusiveRefCntPtr<MissingPathSet> Paths) {
+  assert(!Prefetcher && "missing paths were already looked up");
+  SharedMissingPaths = std::move(Paths);
 }
 
 /// \brief Retrieve the directory that the given file name resides in.
@@ -416,7 +454,8 @@ bool FileManager::makeAbsolutePath(SmallVectorImpl<char> &Path) const {
 
 llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
 FileManager::getBufferForFile(const FileEntry *Entry, bool isVolatile,
-                              bool ShouldCloseOpenFile) {
+                              bool ShouldCloseOpenFile,
+                              bool RequiresNullTerminator) {
   uint64_t FileSize = Entry->getSize();
   // If there's a high enough chance that the file have changed since we
   // got its size, force a stat before opening it.
@@ -426,9 +465,8 @@ FileManager::getBufferForFile(const FileEntry *Entry, bool isVolatile,
   StringRef Filename = Entry->getName();
   // If the file is already open, use the open file descriptor.
   if (Entry->File) {
-    auto Result =
-        Entry->File->getBuffer(Filename, FileSize,
-                               /*RequiresNullTerminator=*/true, isVolatile);
+    auto Result = Entry->File->getBuffer(Filename, FileSize,
+                                         RequiresNullTerminator, isVolatile);
     // FIXME: we need a set of APIs that can make guarantees about whether a
     // FileEntry is open or not.
     if (ShouldCloseOpenFile)
@@ -439,13 +477,13 @@ FileManager::getBufferForFile(const FileEntry *Entry, bool isVolatile,
   // Otherwise, open the file.
 
   if (FileSystemOpts.WorkingDir.empty())
-    return FS->getBufferForFile(Filename, FileSize,
-                                /*RequiresNullTerminator=*/true, isVolatile);
+    return FS->getBufferForFile(Filename, FileSize, RequiresNullTerminator,
+                                isVolatile);
 
   SmallString<128> FilePath(Entry->getName());
   FixupRelativePath(FilePath);
-  return FS->getBufferForFile(FilePath, FileSize,
-                              /*RequiresNullTerminator=*/true, isVolatile);
+  return FS->getBufferForFile(FilePath, FileSize, RequiresNullTerminator,
+                              isVolatile);
 }
 
 llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
@@ -465,6 +503,9 @@ FileManager::getBufferForFile(StringRef Filename) {
 /// do directory look-up instead of file look-up.
 bool FileManager::getStatValue(StringRef Path, FileData &Data, bool isFile,
                                std::unique_ptr<vfs::File> *F) {
+  // Make sure the missing paths are remembered from the first lookup.
+  getPrefetcher();
+
   // FIXME: FileSystemOpts shouldn't be passed in here, all paths should be
   // absolute!
   if (FileSystemOpts.WorkingDir.empty())
@@ -13,7 +13,9 @@
 
 #include "clang/Basic/FileSystemStatCache.h"
 #include "clang/Basic/VirtualFileSystem.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Support/Path.h"
+#include <algorithm>
 
 using namespace clang;
 
@@ -124,3 +126,95 @@ MemorizeStatCalls::getStat(StringRef Path, FileData &Data, bool isFile,
 
   return Result;
 }
+
+PrefetchStatCache::PrefetchStatCache(
+    IntrusiveRefCntPtr<vfs::FileSystem> FS, unsigned NumThreads,
+    IntrusiveRefCntPtr<MissingPathSet> SharedMissing)
+    : FS(std::move(FS)), SharedMissing(std::move(SharedMissing)) {
+#if LLVM_ENABLE_THREADS
+  for (unsigned I = 0; I != NumThreads; ++I)
+    Workers.emplace_back([this] { runWorker(); });
+#endif
+}
+
+PrefetchStatCache::~PrefetchStatCache() {
+  {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    ShuttingDown = true;
+  }
+  Changed.notify_all();
+  for (std::thread &Worker : Workers)
+    Worker.join();
+}
+
+void PrefetchStatCache::recordMissing(StringRef Path) {
+  Missing.insert(Path);
+  // Relative paths depend on the working directory of each compilation.
+  if (SharedMissing && llvm::sys::path::is_absolute(Path))
+    SharedMissing->insert(Path);
+}
+
+void PrefetchStatCache::runWorker() {
+  std::unique_lock<std::mutex> Lock(Mutex);
+  while (true) {
+    Changed.wait(Lock, [this] { return ShuttingDown || !Queue.empty(); });
+    if (ShuttingDown)
+      return;
+
+    std::string Path = std::move(Queue.front());
+    Queue.pop_front();
+    Lock.unlock();
+    bool Exists = bool(FS->status(Path));
+    Lock.lock();
+
+    if (!Exists)
+      recordMissing(Path);
+    Pending.erase(Path);
+    Changed.notify_all();
+  }
+}
+
+void PrefetchStatCache::prefetch(ArrayRef<std::string> Paths) {
+  if (Workers.empty())
+    return;
+
+  {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    for (const std::string &Path : Paths) {
+      if (Missing.count(Path) ||
+          (SharedMissing && SharedMissing->contains(Path)))
+        continue;
+      if (Pending.insert(Path).second)
+        Queue.push_back(Path);
+    }
+  }
+  Changed.notify_all();
+}
+
+PrefetchStatCache::LookupResult
+PrefetchStatCache::getStat(StringRef Path, FileData &Data, bool isFile,
+                           std::unique_ptr<vfs::File> *F,
+                           vfs::FileSystem &FS) {
+  {
+    // Take the path back if no worker looks it up yet, and otherwise wait
+    // for the lookup that is under way rather than repeating it.
+    std::unique_lock<std::mutex> Lock(Mutex);
+    auto Queued = std::find(Queue.begin(), Queue.end(), Path);
+    if (Queued != Queue.end()) {
+      Queue.erase(Queued);
+      Pending.erase(Path);
+    }
+    Changed.wait(Lock, [&] { return !Pending.count(Path); });
+    if (Missing.count(Path))
+      return CacheMissing;
+  }
+  if (SharedMissing && SharedMissing->contains(Path))
+    return CacheMissing;
+
+  LookupResult Result = statChained(Path, Data, isFile, F, FS);
+  if (Result == CacheMissing) {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    recordMissing(Path);
+  }
+  return Result;
+}
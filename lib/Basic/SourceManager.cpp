@@ -1140,14 +1140,28 @@ unsigned SourceManager::getColumnNumber(FileID FID, unsigned FilePos,
   // that to lookup the start of the line instead of searching for it.
   if (LastLineNoFileIDQuery == FID &&
       LastLineNoContentCache->SourceLineCache != nullptr &&
-      LastLineNoResult < LastLineNoContentCache->NumLines) {
+      LastLineNoResult <= LastLineNoContentCache->NumLines) {
     unsigned *SourceLineCache = LastLineNoContentCache->SourceLineCache;
     unsigned LineStart = SourceLineCache[LastLineNoResult - 1];
-    unsigned LineEnd = SourceLineCache[LastLineNoResult];
+    // The last line extends to the end of the buffer.
+    unsigned LineEnd = LastLineNoResult < LastLineNoContentCache->NumLines
+                           ? SourceLineCache[LastLineNoResult]
+                           : MemBuf->getBufferSize() + 1;
     if (FilePos >= LineStart && FilePos < LineEnd)
       return FilePos - LineStart + 1;
   }
 
+  // If the line offsets of the file were computed, look the start of the line
+  // up in them.  Scanning back to it costs as much as the line is long, which
+  // adds up for the long lines of generated files.
+  const ContentCache *Content = getSLocEntry(FID).getFile().getContentCache();
+  if (Content->SourceLineCache) {
+    const unsigned *LineStart =
+        std::upper_bound(Content->SourceLineCache,
+                         Content->SourceLineCache + Content->NumLines, FilePos);
+    return FilePos - LineStart[-1] + 1;
+  }
+
   const char *Buf = MemBuf->getBufferStart();
   unsigned LineStart = FilePos;
   while (LineStart && Buf[LineStart-1] != '\n' && Buf[LineStart-1] != '\r')
@@ -1188,6 +1202,8 @@ unsigned SourceManager::getPresumedColumnNumber(SourceLocation Loc,
 
 #ifdef __SSE2__
 #include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
 #endif
 
 static LLVM_ATTRIBUTE_NOINLINE void
@@ -1244,6 +1260,17 @@ static void ComputeLineNumbers(DiagnosticsEngine &Diag, ContentCache *FI,
       }
       NextBuf += 16;
     }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    // Skip the 16 byte chunks without a newline, and find the newline in the
+    // chunk that has one below.
+    const uint8x16_t CRs = vdupq_n_u8('\r');
+    const uint8x16_t LFs = vdupq_n_u8('\n');
+    while (NextBuf+16 <= End) {
+      const uint8x16_t Chunk = vld1q_u8(NextBuf);
+      if (vmaxvq_u8(vorrq_u8(vceqq_u8(Chunk, CRs), vceqq_u8(Chunk, LFs))))
+        break;
+      NextBuf += 16;
+    }
 #endif
 
     while (*NextBuf != '\n' && *NextBuf != '\r' && *NextBuf != '\0')
@@ -0,0 +1,142 @@
+//===--- TimeTrace.cpp - Trace of the time spent in the frontend ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the TimeTracer.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/TimeTrace.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace clang;
+
+static LLVM_THREAD_LOCAL TimeTracer *CurrentTracer = nullptr;
+
+TimeTracer *clang::getTimeTracer() { return CurrentTracer; }
+
+void clang::setTimeTracer(TimeTracer *Tracer) { CurrentTracer = Tracer; }
+
+TimeTracer::TimeTracer(unsigned TopN) : Start(Clock::now()), TopN(TopN) {}
+
+unsigned TimeTracer::begin(StringRef Name, StringRef Detail) {
+  Event E;
+  E.Name = Name.str();
+  E.Detail = Detail.str();
+  E.Duration = Clock::duration();
+  E.Open = true;
+  ++Totals[Name].OpenCount;
+  if (!Detail.empty())
+    ++DetailTotals[Name][Detail].OpenCount;
+  Events.push_back(std::move(E));
+  Events.back().Start = Clock::now();
+  return Events.size() - 1;
+}
+
+void TimeTracer::end(unsigned Handle) {
+  Event &E = Events[Handle];
+  if (!E.Open)
+    return;
+  E.Duration = Clock::now() - E.Start;
+  E.Open = false;
+
+  // Only count the outermost of nested events of the same kind, so that a
+  // recursive instantiation is not counted once per level.
+  auto Count = [&](Total &T) {
+    if (--T.OpenCount == 0)
+      T.Duration += E.Duration;
+    ++T.Count;
+  };
+  Count(Totals[E.Name]);
+  if (!E.Detail.empty())
+    Count(DetailTotals[E.Name][E.Detail]);
+}
+
+static void writeString(raw_ostream &OS, StringRef Str) {
+  OS << '"';
+  for (unsigned char C : Str) {
+    switch (C) {
+    case '"': OS << "\\\""; break;
+    case '\\': OS << "\\\\"; break;
+    case '\n': OS << "\\n"; break;
+    case '\t': OS << "\\t"; break;
+    default:
+      if (C < 0x20)
+        OS << llvm::format("\\u%04x", C);
+      else
+        OS << C;
+    }
+  }
+  OS << '"';
+}
+
+template <typename Duration> static long long toMicroseconds(Duration D) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(D).count();
+}
+
+void TimeTracer::write(raw_ostream &OS) const {
+  OS << "{\"traceEvents\":[";
+  bool First = true;
+  for (const Event &E : Events) {
+    if (E.Open)
+      continue;
+    OS << (First ? "\n" : ",\n") << "{\"pid\":1,\"tid\":0,\"ph\":\"X\",\"ts\":"
+       << toMicroseconds(E.Start - Start)
+       << ",\"dur\":" << toMicroseconds(E.Duration) << ",\"name\":";
+    writeString(OS, E.Name);
+    if (!E.Detail.empty()) {
+      OS << ",\"args\":{\"detail\":";
+      writeString(OS, E.Detail);
+      OS << '}';
+    }
+    OS << '}';
+    First = false;
+  }
+
+  // Summarize each kind of event, with the details that took the longest.
+  OS << "\n],\n\"summary\":[";
+  First = true;
+  for (const auto &T : Totals) {
+    OS << (First ? "\n" : ",\n") << "{\"name\":";
+    writeString(OS, T.first());
+    OS << ",\"dur\":" << toMicroseconds(T.second.Duration)
+       << ",\"count\":" << T.second.Count;
+    First = false;
+
+    auto Details = DetailTotals.find(T.first());
+    if (Details == DetailTotals.end()) {
+      OS << '}';
+      continue;
+    }
+
+    std::vector<const llvm::StringMapEntry<Total> *> Top;
+    for (const auto &D : Details->second)
+      Top.push_back(&D);
+    auto Longer = [](const llvm::StringMapEntry<Total> *LHS,
+                     const llvm::StringMapEntry<Total> *RHS) {
+      if (LHS->second.Duration != RHS->second.Duration)
+        return LHS->second.Duration > RHS->second.Duration;
+      return LHS->first() < RHS->first();
+    };
+    size_t N = std::min<size_t>(TopN, Top.size());
+    std::partial_sort(Top.begin(), Top.begin() + N, Top.end(), Longer);
+
+    OS << ",\"top\":[";
+    for (size_t I = 0; I != N; ++I) {
+      OS << (I ? "," : "") << "\n {\"detail\":";
+      writeString(OS, Top[I]->first());
+      OS << ",\"dur\":" << toMicroseconds(Top[I]->second.Duration)
+         << ",\"count\":" << Top[I]->second.Count << '}';
+    }
+    OS << "]}";
+  }
+  OS << "\n]}\n";
+}
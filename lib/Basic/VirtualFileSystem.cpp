@@ -18,6 +18,8 @@
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/Config/llvm-config.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/EndianStream.h"
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
@@ -25,6 +27,8 @@
 #include "llvm/Support/YAMLParser.h"
 #include <atomic>
 #include <memory>
+#include <mutex>
+#include <tuple>
 #include <utility>
 
 // For chdir.
@@ -695,6 +699,533 @@ std::error_code InMemoryFileSystem::setCurrentWorkingDirectory(const Twine &P) {
 }
 }
 
+//===-----------------------------------------------------------------------===/
+// SharedCacheFileSystem implementation
+//===-----------------------------------------------------------------------===/
+
+/// The status of a path, and the contents of a regular file once it was
+/// opened. Each part is filled by the first thread that needs it.
+struct SharedFileCache::Entry {
+  std::once_flag StatusOnce;
+  Status Stat;
+  std::error_code StatError;
+
+  std::once_flag ContentsOnce;
+  std::string RealName;
+  std::unique_ptr<MemoryBuffer> Buffer;
+  std::error_code ReadError;
+};
+
+SharedFileCache::SharedFileCache() {}
+SharedFileCache::~SharedFileCache() {}
+
+SharedFileCache::Entry &SharedFileCache::getEntry(StringRef Path) {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  std::unique_ptr<Entry> &E = Entries[Path];
+  if (!E)
+    E = llvm::make_unique<Entry>();
+  return *E;
+}
+
+namespace {
+/// A regular file whose contents are held by a SharedFileCache.
+class SharedCacheFile : public File {
+  SharedFileCache::Entry &E;
+  std::string RequestedName;
+  FileSystem &ExternalFS;
+
+public:
+  SharedCacheFile(SharedFileCache::Entry &E, StringRef RequestedName,
+                  FileSystem &ExternalFS)
+      : E(E), RequestedName(RequestedName), ExternalFS(ExternalFS) {}
+
+  ErrorOr<Status> status() override {
+    return Status::copyWithNewName(E.Stat, RequestedName);
+  }
+  ErrorOr<std::string> getName() override {
+    return E.RealName.empty() ? RequestedName : E.RealName;
+  }
+  ErrorOr<std::unique_ptr<MemoryBuffer>>
+  getBuffer(const Twine &Name, int64_t FileSize, bool RequiresNullTerminator,
+            bool IsVolatile) override {
+    // Files that may change as they are read are not shared.
+    if (IsVolatile)
+      return ExternalFS.getBufferForFile(E.Stat.getName(), FileSize,
+                                         RequiresNullTerminator, IsVolatile);
+    return MemoryBuffer::getMemBuffer(E.Buffer->getBuffer(), Name.str(),
+                                      RequiresNullTerminator);
+  }
+  std::error_code close() override { return std::error_code(); }
+};
+} // end anonymous namespace
+
+SharedCacheFileSystem::SharedCacheFileSystem(
+    IntrusiveRefCntPtr<SharedFileCache> Cache,
+    IntrusiveRefCntPtr<FileSystem> ExternalFS)
+    : Cache(std::move(Cache)), ExternalFS(std::move(ExternalFS)) {
+  if (auto ExternalWorkingDirectory =
+          this->ExternalFS->getCurrentWorkingDirectory())
+    WorkingDirectory = *ExternalWorkingDirectory;
+}
+
+/// Get the entry of \p Path in \p Cache, with its status filled in.
+static std::pair<SharedFileCache::Entry *, std::string>
+getStatusEntry(SharedFileCache &Cache, FileSystem &ExternalFS,
+               const FileSystem &FS, const Twine &Path) {
+  SmallString<256> AbsPath;
+  Path.toVector(AbsPath);
+  std::error_code EC = FS.makeAbsolute(AbsPath);
+  assert(!EC);
+  (void)EC;
+
+  SharedFileCache::Entry &E = Cache.getEntry(AbsPath);
+  std::call_once(E.StatusOnce, [&] {
+    ErrorOr<Status> S = ExternalFS.status(AbsPath);
+    if (S)
+      E.Stat = *S;
+    else
+      E.StatError = S.getError();
+  });
+  return std::make_pair(&E, AbsPath.str().str());
+}
+
+ErrorOr<Status> SharedCacheFileSystem::status(const Twine &Path) {
+  SharedFileCache::Entry *E =
+      getStatusEntry(*Cache, *ExternalFS, *this, Path).first;
+  if (E->StatError)
+    return E->StatError;
+  return Status::copyWithNewName(E->Stat, Path.str());
+}
+
+ErrorOr<std::unique_ptr<File>>
+SharedCacheFileSystem::openFileForRead(const Twine &Path) {
+  SharedFileCache::Entry *E;
+  std::string AbsPath;
+  std::tie(E, AbsPath) = getStatusEntry(*Cache, *ExternalFS, *this, Path);
+  if (E->StatError)
+    return E->StatError;
+  if (!E->Stat.isRegularFile())
+    return ExternalFS->openFileForRead(AbsPath);
+
+  std::call_once(E->ContentsOnce, [&] {
+    ErrorOr<std::unique_ptr<File>> F = ExternalFS->openFileForRead(AbsPath);
+    if (!F) {
+      E->ReadError = F.getError();
+      return;
+    }
+    if (auto RealName = (*F)->getName())
+      E->RealName = *RealName;
+    ErrorOr<std::unique_ptr<MemoryBuffer>> Buffer =
+        (*F)->getBuffer(AbsPath, E->Stat.getSize());
+    if (Buffer)
+      E->Buffer = std::move(*Buffer);
+    else
+      E->ReadError = Buffer.getError();
+  });
+  if (E->ReadError)
+    return E->ReadError;
+  return std::unique_ptr<File>(
+      new SharedCacheFile(*E, Path.str(), *ExternalFS));
+}
+
+directory_iterator SharedCacheFileSystem::dir_begin(const Twine &Dir,
+                                                    std::error_code &EC) {
+  SmallString<256> AbsDir;
+  Dir.toVector(AbsDir);
+  EC = makeAbsolute(AbsDir);
+  if (EC)
+    return directory_iterator();
+  return ExternalFS->dir_begin(AbsDir, EC);
+}
+
+std::error_code
+SharedCacheFileSystem::setCurrentWorkingDirectory(const Twine &P) {
+  // The external file system is shared between threads, so relative paths
+  // are resolved here instead of changing its working directory.
+  SmallString<256> Path;
+  P.toVector(Path);
+  if (std::error_code EC = makeAbsolute(Path))
+    return EC;
+  llvm::sys::path::remove_dots(Path, /*remove_dot_dot=*/false);
+
+  ErrorOr<Status> S = status(Path);
+  if (!S)
+    return S.getError();
+  if (!S->isDirectory())
+    return make_error_code(llvm::errc::not_a_directory);
+  WorkingDirectory = Path.str();
+  return std::error_code();
+}
+
+//===-----------------------------------------------------------------------===/
+// ArchiveFileSystem implementation
+//===-----------------------------------------------------------------------===/
+
+// An archive starts with a header:
+//   char Magic[8];             "CLANGVFA"
+//   uint32_t Version;
+//   uint32_t NumEntries;
+// followed by a table of NumEntries entries, sorted by path:
+//   uint64_t PathOffset;
+//   uint32_t PathSize;
+//   uint32_t Perms;
+//   uint64_t DataOffset;
+//   uint64_t DataSize;
+//   uint64_t ModificationTime;
+// The offsets are from the start of the archive, and the contents of each
+// file are followed by a null byte. All the fields are little endian.
+static const char ArchiveMagic[] = {'C', 'L', 'A', 'N', 'G', 'V', 'F', 'A'};
+static const uint32_t ArchiveVersion = 1;
+static const uint64_t ArchiveHeaderSize = 16;
+static const uint64_t ArchiveEntrySize = 40;
+
+/// Get the prefix of the paths in the directory \p Dir.
+static std::string getArchiveDirPrefix(StringRef Dir) {
+  if (Dir.endswith("/"))
+    return Dir.str();
+  return (Dir + "/").str();
+}
+
+namespace {
+/// A regular file of an archive.
+class ArchiveFile : public File {
+  Status Stat;
+  StringRef Contents;
+
+public:
+  ArchiveFile(Status Stat, StringRef Contents)
+      : Stat(std::move(Stat)), Contents(Contents) {}
+
+  ErrorOr<Status> status() override { return Stat; }
+  ErrorOr<std::unique_ptr<MemoryBuffer>>
+  getBuffer(const Twine &Name, int64_t FileSize, bool RequiresNullTerminator,
+            bool IsVolatile) override {
+    // The contents are followed by a null byte in the archive, so even a
+    // null-terminated buffer points into it.
+    return MemoryBuffer::getMemBuffer(Contents, Name.str(),
+                                      RequiresNullTerminator);
+  }
+  std::error_code close() override { return std::error_code(); }
+};
+
+/// A read-only file system over the files of an archive, whose directories
+/// are the parents of the files. Nothing is copied out of the archive, and
+/// the files are found by a binary search of its table.
+class ArchiveFileSystem : public FileSystem {
+  std::unique_ptr<MemoryBuffer> Buffer;
+  unsigned NumEntries;
+  std::string WorkingDirectory;
+
+  /// The unique IDs of the files and directories, given on first use.
+  mutable std::mutex Mutex;
+  mutable StringMap<UniqueID> UniqueIDs;
+
+  const char *getEntry(unsigned I) const {
+    return Buffer->getBufferStart() + ArchiveHeaderSize + I * ArchiveEntrySize;
+  }
+  UniqueID getUniqueID(StringRef Path) const;
+  void getAbsolutePath(const Twine &P, SmallVectorImpl<char> &Path) const;
+  bool isDirectory(StringRef Path) const;
+
+  /// Find the absolute and normalized path \p Path: get the index of its
+  /// file, or the number of files if it is a directory.
+  ErrorOr<unsigned> lookup(StringRef Path) const;
+
+public:
+  explicit ArchiveFileSystem(std::unique_ptr<MemoryBuffer> Buffer)
+      : Buffer(std::move(Buffer)), NumEntries(0), WorkingDirectory("/") {}
+
+  /// Check the archive, returning false if it is not valid.
+  bool initialize();
+
+  StringRef getPath(unsigned I) const {
+    const char *E = getEntry(I);
+    return StringRef(Buffer->getBufferStart() + support::endian::read64le(E),
+                     support::endian::read32le(E + 8));
+  }
+  StringRef getContents(unsigned I) const {
+    const char *E = getEntry(I);
+    return StringRef(Buffer->getBufferStart() +
+                         support::endian::read64le(E + 16),
+                     support::endian::read64le(E + 24));
+  }
+  Status getFileStatus(unsigned I, StringRef Name) const;
+  Status getDirectoryStatus(StringRef Path, StringRef Name) const;
+
+  /// Get the index of the first file whose path is not less than \p Path.
+  unsigned lowerBound(StringRef Path) const;
+  /// Get the index of the first file after those whose path starts with
+  /// \p Prefix.
+  unsigned endOfPrefix(StringRef Prefix) const {
+    std::string Key = Prefix.str();
+    ++Key.back();
+    return lowerBound(Key);
+  }
+
+  ErrorOr<Status> status(const Twine &Path) override;
+  ErrorOr<std::unique_ptr<File>> openFileForRead(const Twine &Path) override;
+  directory_iterator dir_begin(const Twine &Dir, std::error_code &EC) override;
+  ErrorOr<std::string> getCurrentWorkingDirectory() const override {
+    return WorkingDirectory;
+  }
+  std::error_code setCurrentWorkingDirectory(const Twine &Path) override;
+};
+
+/// Iterates over the children of a directory of an archive: the files in it,
+/// then each directory of the files below it once.
+class ArchiveDirIterator : public clang::vfs::detail::DirIterImpl {
+  const ArchiveFileSystem *FS;
+  std::string Prefix;
+  unsigned I;
+  unsigned E;
+
+  void setCurrentEntry() {
+    if (I == E) {
+      // When we're at the end, make CurrentEntry invalid and DirIterImpl
+      // will do the rest.
+      CurrentEntry = Status();
+      return;
+    }
+    StringRef Path = FS->getPath(I);
+    size_t Slash = Path.find('/', Prefix.size());
+    if (Slash == StringRef::npos)
+      CurrentEntry = FS->getFileStatus(I, Path);
+    else
+      CurrentEntry =
+          FS->getDirectoryStatus(Path.substr(0, Slash), Path.substr(0, Slash));
+  }
+
+public:
+  ArchiveDirIterator() : FS(nullptr), I(0), E(0) {}
+  ArchiveDirIterator(const ArchiveFileSystem &ArchiveFS, StringRef Dir)
+      : FS(&ArchiveFS), Prefix(getArchiveDirPrefix(Dir)),
+        I(ArchiveFS.lowerBound(Prefix)), E(ArchiveFS.endOfPrefix(Prefix)) {
+    setCurrentEntry();
+  }
+
+  std::error_code increment() override {
+    // Skip the files below the current directory.
+    if (CurrentEntry.isDirectory())
+      I = FS->endOfPrefix(getArchiveDirPrefix(CurrentEntry.getName()));
+    else
+      ++I;
+    setCurrentEntry();
+    return std::error_code();
+  }
+};
+} // end anonymous namespace
+
+bool ArchiveFileSystem::initialize() {
+  StringRef Data = Buffer->getBuffer();
+  if (Data.size() < ArchiveHeaderSize ||
+      !Data.startswith(StringRef(ArchiveMagic, sizeof(ArchiveMagic))) ||
+      support::endian::read32le(Data.data() + 8) != ArchiveVersion)
+    return false;
+  uint64_t Count = support::endian::read32le(Data.data() + 12);
+  if (Count > (Data.size() - ArchiveHeaderSize) / ArchiveEntrySize)
+    return false;
+  NumEntries = Count;
+
+  // Check that the paths and contents are in the archive, and that the paths
+  // are sorted, absolute and normalized so that the lookups can find them.
+  for (unsigned I = 0; I != NumEntries; ++I) {
+    const char *E = getEntry(I);
+    uint64_t PathOffset = support::endian::read64le(E);
+    uint64_t PathSize = support::endian::read32le(E + 8);
+    uint64_t DataOffset = support::endian::read64le(E + 16);
+    uint64_t DataSize = support::endian::read64le(E + 24);
+    if (PathOffset > Data.size() || PathSize > Data.size() - PathOffset ||
+        DataOffset > Data.size() || DataSize >= Data.size() - DataOffset ||
+        Data[DataOffset + DataSize] != '\0')
+      return false;
+
+    StringRef Path = getPath(I);
+    SmallString<128> Normalized(Path);
+    llvm::sys::path::remove_dots(Normalized, /*remove_dot_dot=*/true);
+    if (!Path.startswith("/") || Normalized != Path ||
+        (I != 0 && getPath(I - 1) >= Path))
+      return false;
+  }
+
+  // A file cannot also be a directory.
+  for (unsigned I = 0; I != NumEntries; ++I)
+    if (isDirectory(getPath(I)))
+      return false;
+  return true;
+}
+
+UniqueID ArchiveFileSystem::getUniqueID(StringRef Path) const {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  auto Insertion = UniqueIDs.insert(std::make_pair(Path, UniqueID()));
+  if (Insertion.second)
+    Insertion.first->second = getNextVirtualUniqueID();
+  return Insertion.first->second;
+}
+
+Status ArchiveFileSystem::getFileStatus(unsigned I, StringRef Name) const {
+  const char *E = getEntry(I);
+  return Status(
+      Name, getUniqueID(getPath(I)),
+      llvm::sys::toTimePoint(
+          static_cast<time_t>(support::endian::read64le(E + 32))),
+      0, 0, support::endian::read64le(E + 24),
+      llvm::sys::fs::file_type::regular_file,
+      static_cast<perms>(support::endian::read32le(E + 12) &
+                         llvm::sys::fs::all_perms));
+}
+
+Status ArchiveFileSystem::getDirectoryStatus(StringRef Path,
+                                             StringRef Name) const {
+  return Status(Name, getUniqueID(Path), llvm::sys::TimePoint<>(), 0, 0, 0,
+                llvm::sys::fs::file_type::directory_file,
+                llvm::sys::fs::all_read | llvm::sys::fs::all_exe);
+}
+
+unsigned ArchiveFileSystem::lowerBound(StringRef Path) const {
+  unsigned Low = 0, High = NumEntries;
+  while (Low != High) {
+    unsigned Mid = Low + (High - Low) / 2;
+    if (getPath(Mid) < Path)
+      Low = Mid + 1;
+    else
+      High = Mid;
+  }
+  return Low;
+}
+
+void ArchiveFileSystem::getAbsolutePath(const Twine &P,
+                                        SmallVectorImpl<char> &Path) const {
+  P.toVector(Path);
+
+  // Fix up relative paths. This just prepends the current working directory.
+  std::error_code EC = makeAbsolute(Path);
+  assert(!EC);
+  (void)EC;
+
+  llvm::sys::path::remove_dots(Path, /*remove_dot_dot=*/true);
+}
+
+bool ArchiveFileSystem::isDirectory(StringRef Path) const {
+  if (Path == "/")
+    return true;
+  std::string Prefix = getArchiveDirPrefix(Path);
+  unsigned I = lowerBound(Prefix);
+  return I != NumEntries && getPath(I).startswith(Prefix);
+}
+
+ErrorOr<unsigned> ArchiveFileSystem::lookup(StringRef Path) const {
+  unsigned I = lowerBound(Path);
+  if (I != NumEntries && getPath(I) == Path)
+    return I;
+  if (isDirectory(Path))
+    return NumEntries;
+  return make_error_code(llvm::errc::no_such_file_or_directory);
+}
+
+ErrorOr<Status> ArchiveFileSystem::status(const Twine &Path) {
+  SmallString<128> AbsPath;
+  getAbsolutePath(Path, AbsPath);
+  ErrorOr<unsigned> I = lookup(AbsPath);
+  if (!I)
+    return I.getError();
+  if (*I == NumEntries)
+    return getDirectoryStatus(AbsPath, Path.str());
+  return getFileStatus(*I, Path.str());
+}
+
+ErrorOr<std::unique_ptr<File>>
+ArchiveFileSystem::openFileForRead(const Twine &Path) {
+  SmallString<128> AbsPath;
+  getAbsolutePath(Path, AbsPath);
+  ErrorOr<unsigned> I = lookup(AbsPath);
+  if (!I)
+    return I.getError();
+
+  // FIXME: errc::not_a_file?
+  if (*I == NumEntries)
+    return make_error_code(llvm::errc::invalid_argument);
+  return std::unique_ptr<File>(
+      new ArchiveFile(getFileStatus(*I, Path.str()), getContents(*I)));
+}
+
+directory_iterator ArchiveFileSystem::dir_begin(const Twine &Dir,
+                                                std::error_code &EC) {
+  SmallString<128> AbsDir;
+  getAbsolutePath(Dir, AbsDir);
+  ErrorOr<unsigned> I = lookup(AbsDir);
+  if (!I) {
+    EC = I.getError();
+    return directory_iterator(std::make_shared<ArchiveDirIterator>());
+  }
+
+  if (*I == NumEntries)
+    return directory_iterator(
+        std::make_shared<ArchiveDirIterator>(*this, AbsDir));
+
+  EC = make_error_code(llvm::errc::not_a_directory);
+  return directory_iterator(std::make_shared<ArchiveDirIterator>());
+}
+
+std::error_code ArchiveFileSystem::setCurrentWorkingDirectory(const Twine &P) {
+  // Like the other file systems of an overlay, accept directories that are
+  // not in the archive.
+  SmallString<128> Path;
+  getAbsolutePath(P, Path);
+  if (!Path.empty())
+    WorkingDirectory = Path.str();
+  return std::error_code();
+}
+
+IntrusiveRefCntPtr<FileSystem>
+vfs::getVFSFromArchive(std::unique_ptr<MemoryBuffer> Buffer) {
+  IntrusiveRefCntPtr<ArchiveFileSystem> FS(
+      new ArchiveFileSystem(std::move(Buffer)));
+  if (!FS->initialize())
+    return nullptr;
+  return FS;
+}
+
+void ArchiveFileSystemWriter::addFile(StringRef Path, StringRef Contents,
+                                      time_t ModificationTime, perms Perms) {
+  assert(sys::path::is_absolute(Path) && "path not absolute");
+  assert(!pathHasTraversal(Path) && "path traversal is not supported");
+  Entries.push_back({Path.str(), Contents.str(), ModificationTime, Perms});
+}
+
+void ArchiveFileSystemWriter::write(llvm::raw_ostream &OS) {
+  std::sort(Entries.begin(), Entries.end(),
+            [](const Entry &LHS, const Entry &RHS) {
+              return LHS.Path < RHS.Path;
+            });
+  assert(std::adjacent_find(Entries.begin(), Entries.end(),
+                            [](const Entry &LHS, const Entry &RHS) {
+                              return LHS.Path == RHS.Path;
+                            }) == Entries.end() &&
+         "file added twice");
+
+  support::endian::Writer<support::little> LE(OS);
+  OS.write(ArchiveMagic, sizeof(ArchiveMagic));
+  LE.write<uint32_t>(ArchiveVersion);
+  LE.write<uint32_t>(Entries.size());
+
+  // The paths and contents follow the table.
+  uint64_t Offset = ArchiveHeaderSize + Entries.size() * ArchiveEntrySize;
+  for (const Entry &E : Entries) {
+    LE.write<uint64_t>(Offset);
+    LE.write<uint32_t>(E.Path.size());
+    LE.write<uint32_t>(E.Perms);
+    Offset += E.Path.size();
+    LE.write<uint64_t>(Offset);
+    LE.write<uint64_t>(E.Contents.size());
+    LE.write<uint64_t>(E.ModificationTime);
+    Offset += E.Contents.size() + 1;
+  }
+  for (const Entry &E : Entries) {
+    OS << E.Path << E.Contents;
+    OS.write('\0');
+  }
+}
+
 //===-----------------------------------------------------------------------===/
 // RedirectingFileSystem implementation
 //===-----------------------------------------------------------------------===/
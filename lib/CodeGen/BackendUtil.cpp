@@ -11,6 +11,7 @@
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/LangOptions.h"
 #include "clang/Basic/TargetOptions.h"
+#include "clang/Basic/TimeTrace.h"
 #include "clang/Frontend/CodeGenOptions.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Frontend/Utils.h"
@@ -23,6 +24,7 @@
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/Bitcode/BitcodeWriterPass.h"
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/CodeGen/RegAllocRegistry.h"
 #include "llvm/CodeGen/SchedulerRegistry.h"
 #include "llvm/IR/DataLayout.h"
@@ -30,6 +32,7 @@
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/ModuleSummaryIndex.h"
+#include "llvm/IR/ValueMap.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/LTO/LTOBackend.h"
 #include "llvm/MC/SubtargetFeature.h"
@@ -52,6 +55,7 @@
 #include "llvm/Transforms/ObjCARC.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Scalar/GVN.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 #include "llvm/Transforms/Utils/SymbolRewriter.h"
 #include <memory>
 using namespace clang;
@@ -59,6 +63,12 @@ using namespace llvm;
 
 namespace {
 
+/// Keys of a ValueMap that stay with the value they were inserted for when
+/// it is replaced.
+struct NoFollowRAUWConfig : ValueMapConfig<const Function *> {
+  enum { FollowRAUW = false };
+};
+
 class EmitAssemblyHelper {
   DiagnosticsEngine &Diags;
   const CodeGenOptions &CodeGenOpts;
@@ -70,6 +80,18 @@ class EmitAssemblyHelper {
 
   std::unique_ptr<raw_pwrite_stream> OS;
 
+  /// The per-function passes that RunEarlyPerFunctionPasses runs while the
+  /// module is being generated, if it has been called.
+  std::unique_ptr<legacy::FunctionPassManager> EarlyPerFunctionPasses;
+
+  /// The function definitions that the early per-function passes have
+  /// already optimized.
+  ValueMap<const Function *, bool, NoFollowRAUWConfig> EarlyOptimized;
+
+  /// The last function of the module when RunEarlyPerFunctionPasses was last
+  /// called; only the functions after it are new.
+  WeakVH LastEarlyVisited;
+
 private:
   TargetIRAnalysis getTargetIRAnalysis() const {
     if (TM)
@@ -93,12 +115,20 @@ private:
   /// the requested target.
   void CreateTargetMachine(bool MustCreateTM);
 
+  /// Creates a new TargetMachine for the module, as CreateTargetMachine does.
+  std::unique_ptr<TargetMachine> makeTargetMachine(bool MustCreateTM) const;
+
   /// Add passes necessary to emit assembly or LLVM IR.
   ///
   /// \return True on success.
   bool AddEmitPasses(legacy::PassManager &CodeGenPasses, BackendAction Action,
                      raw_pwrite_stream &OS);
 
+  /// Split the module and generate the object files of its partitions in
+  /// parallel, the first one to \p OS and the others to the files in
+  /// CodeGenOptions::ParallelCodeGenOutputs.
+  void EmitParallelCodeGen(raw_pwrite_stream &OS);
+
 public:
   EmitAssemblyHelper(DiagnosticsEngine &_Diags, const CodeGenOptions &CGOpts,
                      const clang::TargetOptions &TOpts,
@@ -118,6 +148,10 @@ public:
 
   void EmitAssemblyWithNewPassManager(BackendAction Action,
                                       std::unique_ptr<raw_pwrite_stream> OS);
+
+  /// Run the per-function passes of EmitAssembly over the definitions added
+  /// to the module since the last call.
+  void RunEarlyPerFunctionPasses();
 };
 
 // We need this wrapper to access LangOpts and CGOpts from extension functions
@@ -250,7 +284,8 @@ static void addEfficiencySanitizerPass(const PassManagerBuilder &Builder,
 }
 
 static TargetLibraryInfoImpl *createTLII(llvm::Triple &TargetTriple,
-                                         const CodeGenOptions &CodeGenOpts) {
+                                         const CodeGenOptions &CodeGenOpts,
+                                         const Module &M) {
   TargetLibraryInfoImpl *TLII = new TargetLibraryInfoImpl(TargetTriple);
   if (!CodeGenOpts.SimplifyLibCalls)
     TLII->disableAllFunctions();
@@ -272,6 +307,25 @@ static TargetLibraryInfoImpl *createTLII(llvm::Triple &TargetTriple,
   default:
     break;
   }
+
+  // Let the vectorizer call the vector variants of the OpenMP 'declare simd'
+  // functions that are not defined in this module. The names are kept alive
+  // by the context of the module.
+  if (NamedMDNode *Calls = M.getNamedMetadata("omp.declare_simd.calls")) {
+    std::vector<VecDesc> VecFuncs;
+    for (const MDNode *Call : Calls->operands()) {
+      auto *F = mdconst::dyn_extract_or_null<Function>(Call->getOperand(0));
+      if (!F || !F->isDeclaration())
+        continue;
+      VecFuncs.push_back(
+          {cast<MDString>(Call->getOperand(1))->getString().data(),
+           cast<MDString>(Call->getOperand(2))->getString().data(),
+           static_cast<unsigned>(
+               mdconst::extract<ConstantInt>(Call->getOperand(3))
+                   ->getZExtValue())});
+    }
+    TLII->addVectorizableFunctions(VecFuncs);
+  }
   return TLII;
 }
 
@@ -301,7 +355,7 @@ void EmitAssemblyHelper::CreatePasses(legacy::PassManager &MPM,
   // TLI with an unknown target otherwise.
   Triple TargetTriple(TheModule->getTargetTriple());
   std::unique_ptr<TargetLibraryInfoImpl> TLII(
-      createTLII(TargetTriple, CodeGenOpts));
+      createTLII(TargetTriple, CodeGenOpts, *TheModule));
 
   // At O0 and O1 we only run the always inliner which is more efficient. At
   // higher optimization levels we run the normal inliner.
@@ -478,6 +532,12 @@ void EmitAssemblyHelper::setCommandLineOpts() {
 }
 
 void EmitAssemblyHelper::CreateTargetMachine(bool MustCreateTM) {
+  if (std::unique_ptr<TargetMachine> NewTM = makeTargetMachine(MustCreateTM))
+    TM = std::move(NewTM);
+}
+
+std::unique_ptr<TargetMachine>
+EmitAssemblyHelper::makeTargetMachine(bool MustCreateTM) const {
   // Create the TargetMachine for generating code.
   std::string Error;
   std::string Triple = TheModule->getTargetTriple();
@@ -485,7 +545,7 @@ void EmitAssemblyHelper::CreateTargetMachine(bool MustCreateTM) {
   if (!TheTarget) {
     if (MustCreateTM)
       Diags.Report(diag::err_fe_unable_to_create_target) << Error;
-    return;
+    return nullptr;
   }
 
   unsigned CodeModel =
@@ -591,8 +651,8 @@ void EmitAssemblyHelper::CreateTargetMachine(bool MustCreateTM) {
   Options.MCOptions.PreserveAsmComments = CodeGenOpts.PreserveAsmComments;
   Options.MCOptions.ABIName = TargetOpts.ABI;
 
-  TM.reset(TheTarget->createTargetMachine(Triple, TargetOpts.CPU, FeaturesStr,
-                                          Options, RM, CM, OptLevel));
+  return std::unique_ptr<TargetMachine>(TheTarget->createTargetMachine(
+      Triple, TargetOpts.CPU, FeaturesStr, Options, RM, CM, OptLevel));
 }
 
 bool EmitAssemblyHelper::AddEmitPasses(legacy::PassManager &CodeGenPasses,
@@ -601,7 +661,7 @@ bool EmitAssemblyHelper::AddEmitPasses(legacy::PassManager &CodeGenPasses,
   // Add LibraryInfo.
   llvm::Triple TargetTriple(TheModule->getTargetTriple());
   std::unique_ptr<TargetLibraryInfoImpl> TLII(
-      createTLII(TargetTriple, CodeGenOpts));
+      createTLII(TargetTriple, CodeGenOpts, *TheModule));
   CodeGenPasses.add(new TargetLibraryInfoWrapperPass(*TLII));
 
   // Normal mode, emit a .s or .o file by running the code generator. Note,
@@ -629,16 +689,87 @@ bool EmitAssemblyHelper::AddEmitPasses(legacy::PassManager &CodeGenPasses,
   return true;
 }
 
+void EmitAssemblyHelper::EmitParallelCodeGen(raw_pwrite_stream &OS) {
+  std::vector<std::unique_ptr<raw_fd_ostream>> PartOSs;
+  SmallVector<raw_pwrite_stream *, 4> OSs;
+  OSs.push_back(&OS);
+  for (const std::string &File : CodeGenOpts.ParallelCodeGenOutputs) {
+    std::error_code EC;
+    PartOSs.push_back(
+        llvm::make_unique<raw_fd_ostream>(File, EC, sys::fs::F_None));
+    if (EC) {
+      Diags.Report(diag::err_fe_unable_to_open_output) << File << EC.message();
+      return;
+    }
+    OSs.push_back(PartOSs.back().get());
+  }
+
+  // The partitions are generated without the passes of AddEmitPasses, so
+  // run the ObjC ARC final cleanup here.
+  if (CodeGenOpts.OptimizationLevel > 0) {
+    legacy::PassManager ARCPasses;
+    ARCPasses.add(createObjCARCContractPass());
+    ARCPasses.run(*TheModule);
+  }
+
+  // The partitions are generated in their own contexts, each with its own
+  // TargetMachine. Split a copy of the module, which the caller still owns.
+  PrettyStackTraceString CrashInfo("Parallel code generation");
+  splitCodeGen(CloneModule(TheModule), OSs, /*BCOSs=*/{},
+               [this]() { return makeTargetMachine(/*MustCreateTM=*/true); },
+               TargetMachine::CGFT_ObjectFile, /*PreserveLocals=*/true);
+}
+
+void EmitAssemblyHelper::RunEarlyPerFunctionPasses() {
+  TimeRegion Region(llvm::TimePassesIsEnabled ? &CodeGenerationTime : nullptr);
+
+  if (!EarlyPerFunctionPasses) {
+    setCommandLineOpts();
+    CreateTargetMachine(/*MustCreateTM=*/false);
+    if (TM)
+      TheModule->setDataLayout(TM->createDataLayout());
+
+    EarlyPerFunctionPasses.reset(new legacy::FunctionPassManager(TheModule));
+    EarlyPerFunctionPasses->add(
+        createTargetTransformInfoWrapperPass(getTargetIRAnalysis()));
+    // EmitAssembly creates the module passes again along with its own
+    // function passes.
+    legacy::PassManager PerModulePasses;
+    CreatePasses(PerModulePasses, *EarlyPerFunctionPasses);
+    EarlyPerFunctionPasses->doInitialization();
+  }
+
+  // CodeGen appends the functions it creates, so the new definitions are
+  // after the last function we saw. The others, such as definitions of
+  // functions declared earlier, are left to EmitAssembly.
+  Value *LastValue = LastEarlyVisited;
+  auto *Last = dyn_cast_or_null<Function>(LastValue);
+  Module::iterator I = Last && Last->getParent() == TheModule
+                           ? std::next(Last->getIterator())
+                           : TheModule->begin();
+
+  PrettyStackTraceString CrashInfo("Early per-function optimization");
+  for (Module::iterator E = TheModule->end(); I != E; ++I)
+    if (!I->isDeclaration() && EarlyOptimized.insert({&*I, true}).second)
+      EarlyPerFunctionPasses->run(*I);
+
+  if (!TheModule->empty())
+    LastEarlyVisited = &TheModule->back();
+}
+
 void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
                                       std::unique_ptr<raw_pwrite_stream> OS) {
   TimeRegion Region(llvm::TimePassesIsEnabled ? &CodeGenerationTime : nullptr);
 
-  setCommandLineOpts();
+  // The early per-function passes already parsed the backend options.
+  if (!EarlyPerFunctionPasses)
+    setCommandLineOpts();
 
   bool UsesCodeGen = (Action != Backend_EmitNothing &&
                       Action != Backend_EmitBC &&
                       Action != Backend_EmitLL);
-  CreateTargetMachine(UsesCodeGen);
+  if (!TM)
+    CreateTargetMachine(UsesCodeGen);
 
   if (UsesCodeGen && !TM)
     return;
@@ -659,6 +790,9 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
   CodeGenPasses.add(
       createTargetTransformInfoWrapperPass(getTargetIRAnalysis()));
 
+  bool ParallelCodeGen = Action == Backend_EmitObj &&
+                         !CodeGenOpts.ParallelCodeGenOutputs.empty();
+
   switch (Action) {
   case Backend_EmitNothing:
     break;
@@ -675,6 +809,8 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
     break;
 
   default:
+    if (ParallelCodeGen)
+      break;
     if (!AddEmitPasses(CodeGenPasses, Action, *OS))
       return;
   }
@@ -690,9 +826,11 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
 
     PerFunctionPasses.doInitialization();
     for (Function &F : *TheModule)
-      if (!F.isDeclaration())
+      if (!F.isDeclaration() && !EarlyOptimized.count(&F))
         PerFunctionPasses.run(F);
     PerFunctionPasses.doFinalization();
+    if (EarlyPerFunctionPasses)
+      EarlyPerFunctionPasses->doFinalization();
   }
 
   {
@@ -700,6 +838,11 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
     PerModulePasses.run(*TheModule);
   }
 
+  if (ParallelCodeGen) {
+    EmitParallelCodeGen(*OS);
+    return;
+  }
+
   {
     PrettyStackTraceString CrashInfo("Code generation");
     CodeGenPasses.run(*TheModule);
@@ -793,6 +936,7 @@ void EmitAssemblyHelper::EmitAssemblyWithNewPassManager(
   // create that pass manager here and use it as needed below.
   legacy::PassManager CodeGenPasses;
   bool NeedCodeGen = false;
+  bool ParallelCodeGen = false;
 
   // Append any output we need to the pass manager.
   switch (Action) {
@@ -809,9 +953,14 @@ void EmitAssemblyHelper::EmitAssemblyWithNewPassManager(
     MPM.addPass(PrintModulePass(*OS, "", CodeGenOpts.EmitLLVMUseLists));
     break;
 
+  case Backend_EmitObj:
+    if (!CodeGenOpts.ParallelCodeGenOutputs.empty()) {
+      ParallelCodeGen = true;
+      break;
+    }
+    LLVM_FALLTHROUGH;
   case Backend_EmitAssembly:
   case Backend_EmitMCNull:
-  case Backend_EmitObj:
     NeedCodeGen = true;
     CodeGenPasses.add(
         createTargetTransformInfoWrapperPass(getTargetIRAnalysis()));
@@ -831,7 +980,9 @@ void EmitAssemblyHelper::EmitAssemblyWithNewPassManager(
   }
 
   // Now if needed, run the legacy PM for codegen.
-  if (NeedCodeGen) {
+  if (ParallelCodeGen) {
+    EmitParallelCodeGen(*OS);
+  } else if (NeedCodeGen) {
     PrettyStackTraceString CrashInfo("Code generation");
     CodeGenPasses.run(*TheModule);
   }
@@ -928,18 +1079,44 @@ static void runThinLTOBackend(const CodeGenOptions &CGOpts, Module *M,
   }
 }
 
+struct clang::EarlyFunctionPasses::Implementation {
+  EmitAssemblyHelper Helper;
+
+  Implementation(DiagnosticsEngine &Diags, const CodeGenOptions &CGOpts,
+                 const clang::TargetOptions &TOpts, const LangOptions &LOpts,
+                 Module *M)
+      : Helper(Diags, CGOpts, TOpts, LOpts, M) {}
+};
+
+EarlyFunctionPasses::EarlyFunctionPasses(DiagnosticsEngine &Diags,
+                                         const CodeGenOptions &CGOpts,
+                                         const clang::TargetOptions &TOpts,
+                                         const LangOptions &LOpts, Module *M)
+    : Impl(new Implementation(Diags, CGOpts, TOpts, LOpts, M)) {
+  assert(!CGOpts.ExperimentalNewPassManager &&
+         "early function passes need the legacy pass manager");
+}
+
+EarlyFunctionPasses::~EarlyFunctionPasses() {}
+
+void EarlyFunctionPasses::run() { Impl->Helper.RunEarlyPerFunctionPasses(); }
+
 void clang::EmitBackendOutput(DiagnosticsEngine &Diags,
                               const CodeGenOptions &CGOpts,
                               const clang::TargetOptions &TOpts,
                               const LangOptions &LOpts, const llvm::DataLayout &TDesc,
                               Module *M, BackendAction Action,
-                              std::unique_ptr<raw_pwrite_stream> OS) {
+                              std::unique_ptr<raw_pwrite_stream> OS,
+                              EarlyFunctionPasses *EarlyPasses) {
+  TimeTraceScope TTS("Backend");
   if (!CGOpts.ThinLTOIndexFile.empty()) {
     runThinLTOBackend(CGOpts, M, std::move(OS));
     return;
   }
 
-  EmitAssemblyHelper AsmHelper(Diags, CGOpts, TOpts, LOpts, M);
+  EmitAssemblyHelper LocalHelper(Diags, CGOpts, TOpts, LOpts, M);
+  EmitAssemblyHelper &AsmHelper =
+      EarlyPasses ? EarlyPasses->getImplementation().Helper : LocalHelper;
 
   if (CGOpts.ExperimentalNewPassManager)
     AsmHelper.EmitAssemblyWithNewPassManager(Action, std::move(OS));
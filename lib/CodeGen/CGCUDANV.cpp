@@ -45,6 +45,11 @@ private:
   /// ModuleCtorFunction() and used to create corresponding cleanup calls in
   /// ModuleDtorFunction()
   llvm::SmallVector<llvm::GlobalVariable *, 16> GpuBinaryHandles;
+  /// With -fcuda-lazy-registration, the function called by the stubs to
+  /// register the module and the state of the registration: 0 if not
+  /// started, 1 while in progress and 2 once completed.
+  llvm::Function *LazyRegisterFn = nullptr;
+  llvm::GlobalVariable *LazyRegisterState = nullptr;
 
   llvm::Constant *getSetupArgumentFn() const;
   llvm::Constant *getLaunchFn() const;
@@ -74,6 +79,17 @@ private:
  }
 
   void emitDeviceStubBody(CodeGenFunction &CGF, FunctionArgList &Args);
+  /// Registers the GPU binaries of the module, if that was not done yet,
+  /// before the launch of a kernel.
+  void emitLazyRegistration(CodeGenFunction &CGF);
+  /// Defines the function that registers the module once with the module
+  /// constructor \p ModuleCtorFunc.
+  void emitLazyRegisterFn(llvm::Function *ModuleCtorFunc);
+  /// Emits a stub that passes the addresses of its arguments to a single
+  /// cudaLaunchKernel call, instead of one cudaSetupArgument call per
+  /// argument.
+  void emitDeviceStubBodyLaunchKernel(CodeGenFunction &CGF,
+                                      FunctionArgList &Args);
 
 public:
   CGNVCUDARuntime(CodeGenModule &CGM);
@@ -123,7 +139,91 @@ llvm::Constant *CGNVCUDARuntime::getLaunchFn() const {
 void CGNVCUDARuntime::emitDeviceStub(CodeGenFunction &CGF,
                                      FunctionArgList &Args) {
   EmittedKernels.push_back(CGF.CurFn);
-  emitDeviceStubBody(CGF, Args);
+  if (CGM.getCodeGenOpts().CUDALazyRegistration &&
+      !CGM.getCodeGenOpts().CudaGpuBinaryFileNames.empty())
+    emitLazyRegistration(CGF);
+  if (CGM.getLangOpts().CUDALaunchKernel)
+    emitDeviceStubBodyLaunchKernel(CGF, Args);
+  else
+    emitDeviceStubBody(CGF, Args);
+}
+
+void CGNVCUDARuntime::emitLazyRegistration(CodeGenFunction &CGF) {
+  if (!LazyRegisterFn) {
+    LazyRegisterState = new llvm::GlobalVariable(
+        TheModule, IntTy, false, llvm::GlobalValue::InternalLinkage,
+        llvm::ConstantInt::get(IntTy, 0), "__cuda_registration_state");
+    LazyRegisterFn = llvm::Function::Create(
+        llvm::FunctionType::get(VoidTy, false),
+        llvm::GlobalValue::InternalLinkage, "__cuda_register_lazily",
+        &TheModule);
+    LazyRegisterFn->addFnAttr(llvm::Attribute::NoInline);
+    LazyRegisterFn->addFnAttr(llvm::Attribute::NoUnwind);
+  }
+
+  // Only the first launches take the call, the state is 2 afterwards.
+  llvm::LoadInst *State = CGF.Builder.CreateAlignedLoad(
+      LazyRegisterState, CharUnits::fromQuantity(4), "registration.state");
+  State->setAtomic(llvm::AtomicOrdering::Acquire);
+  llvm::BasicBlock *RegisterBB = CGF.createBasicBlock("register");
+  llvm::BasicBlock *ContBB = CGF.createBasicBlock("register.end");
+  CGF.Builder.CreateCondBr(
+      CGF.Builder.CreateICmpEQ(State, llvm::ConstantInt::get(IntTy, 2)),
+      ContBB, RegisterBB);
+  CGF.EmitBlock(RegisterBB);
+  CGF.EmitNounwindRuntimeCall(LazyRegisterFn);
+  CGF.EmitBlock(ContBB);
+}
+
+/// Defines the function called by the stubs before the module is registered:
+/// \code
+/// void __cuda_register_lazily() {
+///   if (cmpxchg(&__cuda_registration_state, 0, 1)) {
+///     __cuda_module_ctor(0);
+///     __cuda_registration_state = 2;
+///   } else
+///     while (__cuda_registration_state != 2);
+/// }
+/// \endcode
+void CGNVCUDARuntime::emitLazyRegisterFn(llvm::Function *ModuleCtorFunc) {
+  CGBuilderTy Builder(CGM, Context);
+  llvm::BasicBlock *EntryBB =
+      llvm::BasicBlock::Create(Context, "entry", LazyRegisterFn);
+  llvm::BasicBlock *RegisterBB =
+      llvm::BasicBlock::Create(Context, "register", LazyRegisterFn);
+  llvm::BasicBlock *WaitBB =
+      llvm::BasicBlock::Create(Context, "wait", LazyRegisterFn);
+  llvm::BasicBlock *ExitBB =
+      llvm::BasicBlock::Create(Context, "exit", LazyRegisterFn);
+
+  // The thread that starts the registration does it, the other ones wait for
+  // it to complete.
+  Builder.SetInsertPoint(EntryBB);
+  llvm::Value *Started = Builder.CreateAtomicCmpXchg(
+      LazyRegisterState, llvm::ConstantInt::get(IntTy, 0),
+      llvm::ConstantInt::get(IntTy, 1), llvm::AtomicOrdering::Acquire,
+      llvm::AtomicOrdering::Acquire);
+  Builder.CreateCondBr(Builder.CreateExtractValue(Started, 1), RegisterBB,
+                       WaitBB);
+
+  Builder.SetInsertPoint(RegisterBB);
+  Builder.CreateCall(ModuleCtorFunc,
+                     llvm::ConstantPointerNull::get(VoidPtrTy));
+  Builder.CreateAlignedStore(llvm::ConstantInt::get(IntTy, 2),
+                             LazyRegisterState, CharUnits::fromQuantity(4))
+      ->setAtomic(llvm::AtomicOrdering::Release);
+  Builder.CreateRetVoid();
+
+  Builder.SetInsertPoint(WaitBB);
+  llvm::LoadInst *State = Builder.CreateAlignedLoad(
+      LazyRegisterState, CharUnits::fromQuantity(4));
+  State->setAtomic(llvm::AtomicOrdering::Acquire);
+  Builder.CreateCondBr(
+      Builder.CreateICmpEQ(State, llvm::ConstantInt::get(IntTy, 2)), ExitBB,
+      WaitBB);
+
+  Builder.SetInsertPoint(ExitBB);
+  Builder.CreateRetVoid();
 }
 
 void CGNVCUDARuntime::emitDeviceStubBody(CodeGenFunction &CGF,
@@ -161,6 +261,83 @@ void CGNVCUDARuntime::emitDeviceStubBody(CodeGenFunction &CGF,
   CGF.EmitBlock(EndBlock);
 }
 
+void CGNVCUDARuntime::emitDeviceStubBodyLaunchKernel(CodeGenFunction &CGF,
+                                                     FunctionArgList &Args) {
+  // cudaError_t cudaLaunchKernel(const void *, dim3, dim3, void **, size_t,
+  //                              cudaStream_t)
+  // The dim3 arguments are passed by value, so the call is lowered from the
+  // declaration of the CUDA headers to follow the ABI of the host.
+  ASTContext &Ctx = CGM.getContext();
+  IdentifierInfo &LaunchKernelII = Ctx.Idents.get("cudaLaunchKernel");
+  const FunctionDecl *LaunchKernelFD = nullptr;
+  for (const NamedDecl *D :
+       Ctx.getTranslationUnitDecl()->lookup(&LaunchKernelII))
+    if (const auto *FD = dyn_cast<FunctionDecl>(D))
+      if (FD->getNumParams() == 6)
+        LaunchKernelFD = FD;
+  if (!LaunchKernelFD) {
+    CGM.Error(CGF.CurFuncDecl->getLocation(),
+              "cannot find the declaration of cudaLaunchKernel");
+    return;
+  }
+
+  // Store the addresses of the arguments in a single array.
+  llvm::Type *KernelArgsTy =
+      llvm::ArrayType::get(VoidPtrTy, std::max<size_t>(1, Args.size()));
+  Address KernelArgs = CGF.CreateTempAlloca(
+      KernelArgsTy, CGM.getPointerAlign(), "kernel_args");
+  for (unsigned I = 0, E = Args.size(); I < E; ++I) {
+    llvm::Value *ArgAddr = CGF.Builder.CreatePointerCast(
+        CGF.GetAddrOfLocalVar(Args[I]).getPointer(), VoidPtrTy);
+    CGF.Builder.CreateStore(
+        ArgAddr,
+        CGF.Builder.CreateConstArrayGEP(KernelArgs, I, CGM.getPointerSize()));
+  }
+
+  // Get the configuration pushed by the kernel call.
+  // cudaError_t __cudaPopCallConfiguration(dim3 *, dim3 *, size_t *, void *)
+  QualType Dim3Ty = LaunchKernelFD->getParamDecl(1)->getType();
+  Address GridDim = CGF.CreateMemTemp(Dim3Ty, "grid_dim");
+  Address BlockDim = CGF.CreateMemTemp(Dim3Ty, "block_dim");
+  Address SharedMem =
+      CGF.CreateTempAlloca(SizeTy, CGM.getSizeAlign(), "shared_mem");
+  Address Stream =
+      CGF.CreateTempAlloca(VoidPtrTy, CGM.getPointerAlign(), "stream");
+  llvm::Type *PopConfigParams[] = {GridDim.getType(), BlockDim.getType(),
+                                   SharedMem.getType(), Stream.getType()};
+  llvm::Constant *PopConfigFn = CGM.CreateRuntimeFunction(
+      llvm::FunctionType::get(IntTy, PopConfigParams, false),
+      "__cudaPopCallConfiguration");
+  llvm::Value *PopConfigArgs[] = {GridDim.getPointer(), BlockDim.getPointer(),
+                                  SharedMem.getPointer(), Stream.getPointer()};
+  CGF.EmitRuntimeCallOrInvoke(PopConfigFn, PopConfigArgs);
+
+  // Emit the call to cudaLaunchKernel.
+  CallArgList LaunchArgs;
+  LaunchArgs.add(
+      RValue::get(CGF.Builder.CreatePointerCast(CGF.CurFn, VoidPtrTy)),
+      LaunchKernelFD->getParamDecl(0)->getType());
+  LaunchArgs.add(RValue::getAggregate(GridDim), Dim3Ty);
+  LaunchArgs.add(RValue::getAggregate(BlockDim), Dim3Ty);
+  LaunchArgs.add(RValue::get(CGF.Builder.CreatePointerCast(
+                     KernelArgs.getPointer(), VoidPtrPtrTy)),
+                 LaunchKernelFD->getParamDecl(3)->getType());
+  LaunchArgs.add(RValue::get(CGF.Builder.CreateLoad(SharedMem)),
+                 LaunchKernelFD->getParamDecl(4)->getType());
+  LaunchArgs.add(RValue::get(CGF.Builder.CreatePointerCast(
+                     CGF.Builder.CreateLoad(Stream),
+                     CGM.getTypes().ConvertType(
+                         LaunchKernelFD->getParamDecl(5)->getType()))),
+                 LaunchKernelFD->getParamDecl(5)->getType());
+
+  const CGFunctionInfo &FI =
+      CGM.getTypes().arrangeFunctionDeclaration(LaunchKernelFD);
+  llvm::Constant *LaunchKernelFn = CGM.CreateRuntimeFunction(
+      CGM.getTypes().GetFunctionType(FI), "cudaLaunchKernel");
+  CGF.EmitCall(FI, CGCallee::forDirect(LaunchKernelFn), ReturnValueSlot(),
+               LaunchArgs);
+}
+
 /// Creates a function that sets up state on the host side for CUDA objects that
 /// have a presence on both the host and device sides. Specifically, registers
 /// the host side of kernel functions and device global variables with the CUDA
@@ -334,6 +511,13 @@ llvm::Function *CGNVCUDARuntime::makeModuleCtorFunction() {
   }
 
   CtorBuilder.CreateRetVoid();
+
+  // The stubs call the constructor on the first launch instead. A module
+  // without kernels is still registered at startup, for its variables.
+  if (LazyRegisterFn) {
+    emitLazyRegisterFn(ModuleCtorFunc);
+    return nullptr;
+  }
   return ModuleCtorFunc;
 }
 
@@ -367,6 +551,20 @@ llvm::Function *CGNVCUDARuntime::makeModuleDtorFunction() {
   for (llvm::GlobalVariable *GpuBinaryHandle : GpuBinaryHandles) {
     auto HandleValue =
       DtorBuilder.CreateAlignedLoad(GpuBinaryHandle, CGM.getPointerAlign());
+    // A lazily registered binary may never have been registered.
+    if (LazyRegisterFn) {
+      llvm::BasicBlock *UnregisterBB =
+          llvm::BasicBlock::Create(Context, "unregister", ModuleDtorFunc);
+      llvm::BasicBlock *NextBB =
+          llvm::BasicBlock::Create(Context, "unregister.next", ModuleDtorFunc);
+      DtorBuilder.CreateCondBr(DtorBuilder.CreateIsNull(HandleValue), NextBB,
+                               UnregisterBB);
+      DtorBuilder.SetInsertPoint(UnregisterBB);
+      DtorBuilder.CreateCall(UnregisterFatbinFunc, HandleValue);
+      DtorBuilder.CreateBr(NextBB);
+      DtorBuilder.SetInsertPoint(NextBB);
+      continue;
+    }
     DtorBuilder.CreateCall(UnregisterFatbinFunc, HandleValue);
   }
 
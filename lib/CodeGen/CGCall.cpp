@@ -20,9 +20,11 @@
 #include "CodeGenFunction.h"
 #include "CodeGenModule.h"
 #include "TargetInfo.h"
+#include "clang/AST/CXXInheritance.h"
 #include "clang/AST/Decl.h"
 #include "clang/AST/DeclCXX.h"
 #include "clang/AST/DeclObjC.h"
+#include "clang/AST/RecordLayout.h"
 #include "clang/Basic/TargetBuiltins.h"
 #include "clang/Basic/TargetInfo.h"
 #include "clang/CodeGen/CGFunctionInfo.h"
@@ -3326,6 +3328,8 @@ void CodeGenFunction::EmitCallArg(CallArgList &args, const Expr *E,
   }
 
   bool HasAggregateEvalKind = hasAggregateEvaluationKind(type);
+  if (HasAggregateEvalKind)
+    EmitAggregateCopyRemark(E, ACR_Argument);
 
   // In the Microsoft C++ ABI, aggregate arguments are destructed by the callee.
   // However, we still have to push an EH-only cleanup in case we unwind before
@@ -3550,6 +3554,45 @@ void CodeGenFunction::deferPlaceholderReplacement(llvm::Instruction *Old,
   DeferredReplacements.push_back(std::make_pair(Old, New));
 }
 
+/// Return the virtual function with the given PGO name hash if a virtual call
+/// of the callee can be speculated on it: the function must be the final
+/// overrider of the callee in its class, with the same return type and no
+/// adjustment of 'this', so that it can be called with the same arguments
+/// whenever the object has the vtable of that class.
+static const CXXMethodDecl *
+findSpeculativeVCallTarget(CodeGenFunction &CGF, const CGCallee &Callee,
+                           uint64_t TargetHash) {
+  const auto *MD =
+      dyn_cast_or_null<CXXMethodDecl>(Callee.getAbstractInfo().getCalleeDecl());
+  if (!MD || isa<CXXDestructorDecl>(MD))
+    return nullptr;
+  const CXXMethodDecl *Target = CGF.CGM.getSpeculativeVCallTarget(TargetHash);
+  if (!Target)
+    return nullptr;
+
+  ASTContext &Ctx = CGF.getContext();
+  const CXXRecordDecl *Base = MD->getParent();
+  const CXXRecordDecl *RD = Target->getParent();
+  if (RD != Base) {
+    CXXBasePaths Paths(/*FindAmbiguities=*/true, /*RecordPaths=*/true,
+                       /*DetectVirtual=*/true);
+    if (!RD->isDerivedFrom(Base, Paths) || Paths.getDetectedVirtual() ||
+        Paths.isAmbiguous(Ctx.getCanonicalType(Ctx.getRecordType(Base))))
+      return nullptr;
+    CharUnits Offset;
+    for (const CXXBasePathElement &Element : Paths.front())
+      Offset += Ctx.getASTRecordLayout(Element.Class).getBaseClassOffset(
+          Element.Base->getType()->getAsCXXRecordDecl());
+    if (!Offset.isZero())
+      return nullptr;
+  }
+
+  if (MD->getCorrespondingMethodInClass(RD) != Target ||
+      !Ctx.hasSameType(MD->getReturnType(), Target->getReturnType()))
+    return nullptr;
+  return Target;
+}
+
 RValue CodeGenFunction::EmitCall(const CGFunctionInfo &CallInfo,
                                  const CGCallee &Callee,
                                  ReturnValueSlot ReturnValue,
@@ -3996,6 +4039,13 @@ RValue CodeGenFunction::EmitCall(const CGFunctionInfo &CallInfo,
                            llvm::Attribute::AlwaysInline);
   }
 
+  // The calls on unlikely paths are cold.
+  if (InUnlikelyPath) {
+    Attrs =
+        Attrs.addAttribute(getLLVMContext(), llvm::AttributeSet::FunctionIndex,
+                           llvm::Attribute::Cold);
+  }
+
   // Disable inlining inside SEH __try blocks.
   if (isSEHTryScope()) {
     Attrs =
@@ -4047,6 +4097,16 @@ RValue CodeGenFunction::EmitCall(const CGFunctionInfo &CallInfo,
   if (!CI->getType()->isVoidTy())
     CI->setName("call");
 
+  // Look for the dominant target of a profiled virtual call in the value
+  // profile of the site, before the site is annotated.
+  const CXXMethodDecl *SpeculativeTarget = nullptr;
+  uint64_t TargetHash, TargetCount, SiteCount;
+  if (!CS.getCalledFunction() &&
+      CGM.getCodeGenOpts().SpeculativeDevirtualization &&
+      Callee.getVirtualCallVTable() && !ArgMemory.isValid() &&
+      PGO.getDominantCallTarget(TargetHash, TargetCount, SiteCount))
+    SpeculativeTarget = findSpeculativeVCallTarget(*this, Callee, TargetHash);
+
   // Insert instrumentation or attach profile metadata at indirect call sites.
   // For more details, see the comment before the definition of
   // IPVK_IndirectCallTarget in InstrProfData.inc.
@@ -4066,6 +4126,12 @@ RValue CodeGenFunction::EmitCall(const CGFunctionInfo &CallInfo,
       Call->setTailCallKind(llvm::CallInst::TCK_NoTail);
   }
 
+  // Call the dominant target directly when the object has the vtable of its
+  // class.
+  if (SpeculativeTarget)
+    CI = EmitSpeculativeVirtualCall(CI, Callee, SpeculativeTarget,
+                                    TargetCount, SiteCount);
+
   // 4. Finish the call.
 
   // If the call doesn't return, finish the basic block and clear the
@@ -4218,6 +4284,71 @@ RValue CodeGenFunction::EmitCall(const CGFunctionInfo &CallInfo,
   return Ret;
 }
 
+llvm::Instruction *
+CodeGenFunction::EmitSpeculativeVirtualCall(llvm::Instruction *CI,
+                                            const CGCallee &Callee,
+                                            const CXXMethodDecl *Target,
+                                            uint64_t Count, uint64_t Total) {
+  llvm::CallSite CS(CI);
+  const CXXRecordDecl *Base =
+      cast<CXXMethodDecl>(Callee.getAbstractInfo().getCalleeDecl())
+          ->getParent();
+  llvm::Value *VTable = Callee.getVirtualCallVTable();
+
+  llvm::Constant *AddressPoint = CGM.getCXXABI().getVTableAddressPoint(
+      BaseSubobject(Base, CharUnits::Zero()), Target->getParent());
+  llvm::Type *TargetTy = CGM.getTypes().GetFunctionType(
+      CGM.getTypes().arrangeCXXMethodDeclaration(Target));
+  llvm::Constant *TargetPtr = llvm::ConstantExpr::getBitCast(
+      CGM.GetAddrOfFunction(Target, TargetTy),
+      CS.getCalledValue()->getType());
+
+  // The direct call is a copy of the indirect one, without its value profile.
+  llvm::Instruction *Direct = CI->clone();
+  llvm::CallSite(Direct).setCalledFunction(TargetPtr);
+  Direct->setMetadata(llvm::LLVMContext::MD_prof, nullptr);
+
+  // An invoke already ends its block and continues in its normal
+  // destination, where the builder is.
+  llvm::BasicBlock *CallBB = CI->getParent();
+  auto *Invoke = dyn_cast<llvm::InvokeInst>(CI);
+  llvm::BasicBlock *ContBB =
+      Invoke ? Invoke->getNormalDest() : createBasicBlock("vcall.cont");
+  llvm::BasicBlock *DirectBB = createBasicBlock("vcall.direct");
+  llvm::BasicBlock *IndirectBB = createBasicBlock("vcall.indirect");
+  llvm::Function::BasicBlockListType &Blocks = CurFn->getBasicBlockList();
+  if (!Invoke)
+    Blocks.insertAfter(CallBB->getIterator(), ContBB);
+  Blocks.insert(ContBB->getIterator(), DirectBB);
+  Blocks.insert(ContBB->getIterator(), IndirectBB);
+
+  CI->removeFromParent();
+  Builder.SetInsertPoint(CallBB);
+  llvm::Value *IsSpeculated = Builder.CreateICmpEQ(
+      VTable, llvm::ConstantExpr::getBitCast(AddressPoint, VTable->getType()),
+      "vtable.speculated");
+  Builder.CreateCondBr(IsSpeculated, DirectBB, IndirectBB,
+                       createProfileWeights(Count, Total - Count));
+
+  Builder.SetInsertPoint(DirectBB);
+  Builder.Insert(Direct);
+  if (!Invoke)
+    Builder.CreateBr(ContBB);
+  Builder.SetInsertPoint(IndirectBB);
+  Builder.Insert(CI);
+  if (!Invoke)
+    Builder.CreateBr(ContBB);
+
+  Builder.SetInsertPoint(ContBB);
+  if (CI->getType()->isVoidTy())
+    return CI;
+  llvm::PHINode *Result = Builder.CreatePHI(CI->getType(), 2);
+  Result->takeName(CI);
+  Result->addIncoming(Direct, DirectBB);
+  Result->addIncoming(CI, IndirectBB);
+  return Result;
+}
+
 /* VarArg handling */
 
 Address CodeGenFunction::EmitVAArg(VAArgExpr *VE, Address &VAListAddr) {
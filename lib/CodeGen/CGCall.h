@@ -87,6 +87,8 @@ namespace CodeGen {
       BuiltinInfoStorage BuiltinInfo;
       PseudoDestructorInfoStorage PseudoDestructorInfo;
     };
+    /// The vtable the function pointer of a virtual call was loaded from.
+    llvm::Value *VirtualCallVTable = nullptr;
 
     explicit CGCallee(SpecialKind kind) : KindOrFunctionPointer(kind) {}
 
@@ -167,6 +169,17 @@ namespace CodeGen {
       assert(isOrdinary());
       KindOrFunctionPointer = SpecialKind(uintptr_t(functionPtr));
     }
+
+    /// The vtable of the object of a virtual call, or null if the function
+    /// pointer wasn't loaded from a vtable.
+    llvm::Value *getVirtualCallVTable() const {
+      assert(isOrdinary());
+      return VirtualCallVTable;
+    }
+    void setVirtualCallVTable(llvm::Value *vtable) {
+      assert(isOrdinary());
+      VirtualCallVTable = vtable;
+    }
   };
 
   struct CallArg {
@@ -1787,6 +1787,20 @@ static bool shouldOmitDefinition(codegenoptions::DebugInfoKind DebugKind,
   if (DebugTypeExtRefs && isDefinedInClangModule(RD->getDefinition()))
     return true;
 
+  // The classes of a module built with -fmodules-debuginfo are described in
+  // full by the object file of the module, and only declared elsewhere.
+  const RecordDecl *Def = RD->getDefinition();
+  if (Def && Def->isFromASTFile())
+    if (ExternalASTSource *Source = RD->getASTContext().getExternalSource())
+      switch (Source->hasExternalDefinitions(Def)) {
+      case ExternalASTSource::EK_Always:
+        return true;
+      case ExternalASTSource::EK_Never:
+        return false;
+      case ExternalASTSource::EK_ReplyHazy:
+        break;
+      }
+
   if (DebugKind > codegenoptions::LimitedDebugInfo)
     return false;
 
@@ -2495,6 +2509,16 @@ llvm::DIType *CGDebugInfo::getTypeOrNull(QualType Ty) {
   return nullptr;
 }
 
+void CGDebugInfo::completeUnusedClass(const CXXRecordDecl &D) {
+  if (DebugKind <= codegenoptions::DebugLineTablesOnly)
+    return;
+
+  completeClassData(&D);
+  // In case this class has no member function definitions being emitted,
+  // ensure it is retained.
+  RetainedTypes.push_back(CGM.getContext().getRecordType(&D).getAsOpaquePtr());
+}
+
 void CGDebugInfo::completeTemplateDefinition(
     const ClassTemplateSpecializationDecl &SD) {
   if (DebugKind <= codegenoptions::DebugLineTablesOnly)
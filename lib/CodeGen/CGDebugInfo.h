@@ -419,6 +419,10 @@ public:
   void completeRequiredType(const RecordDecl *RD);
   void completeClassData(const RecordDecl *RD);
 
+  /// Emit the full description of a class of the module being compiled with
+  /// -fmodules-debuginfo, whether or not this translation unit uses it.
+  void completeUnusedClass(const CXXRecordDecl &D);
+
   void completeTemplateDefinition(const ClassTemplateSpecializationDecl &SD);
 
 private:
@@ -1007,11 +1007,28 @@ CodeGenFunction::EmitAutoVarAlloca(const VarDecl &D) {
         allocaAlignment = alignment;
       }
 
+      // The private copies of OpenMP reduction and lastprivate variables may
+      // take whole cache lines, so that they do not false-share with the
+      // data around them while the threads combine them.
+      llvm::Type *paddedTy = allocaTy;
+      if (&D == OMPPaddedPrivateCopy && !isByRef) {
+        CharUnits lineSize = CharUnits::fromQuantity(
+            CGM.getCodeGenOpts().OpenMPPrivateCopyAlignment);
+        allocaAlignment = std::max(allocaAlignment, lineSize);
+        CharUnits size = CharUnits::fromQuantity(
+            CGM.getDataLayout().getTypeAllocSize(allocaTy));
+        if (!size.isMultipleOf(lineSize))
+          paddedTy = llvm::ArrayType::get(
+              Int8Ty, size.alignTo(lineSize).getQuantity());
+      }
+
       // Create the alloca.  Note that we set the name separately from
       // building the instruction so that it's there even in no-asserts
       // builds.
-      address = CreateTempAlloca(allocaTy, allocaAlignment);
+      address = CreateTempAlloca(paddedTy, allocaAlignment);
       address.getPointer()->setName(D.getName());
+      if (paddedTy != allocaTy)
+        address = Builder.CreateElementBitCast(address, allocaTy);
 
       // Don't emit lifetime markers for MSVC catch parameters. The lifetime of
       // the catch parameter starts in the catchpad instruction, and we can't
@@ -1027,7 +1044,7 @@ CodeGenFunction::EmitAutoVarAlloca(const VarDecl &D) {
         // This is rare case, but it's better just omit intrinsics than have
         // them incorrectly placed.
         if (!Bypasses.IsBypassed(&D)) {
-          uint64_t size = CGM.getDataLayout().getTypeAllocSize(allocaTy);
+          uint64_t size = CGM.getDataLayout().getTypeAllocSize(paddedTy);
           emission.SizeForLifetimeMarkers =
               EmitLifetimeStart(size, address.getPointer());
         }
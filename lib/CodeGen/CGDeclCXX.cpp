@@ -325,6 +325,92 @@ void CodeGenModule::EmitPointerToInitFunc(const VarDecl *D,
     PtrArray->setComdat(C);
 }
 
+bool CodeGenModule::isLazilyInitialized(const VarDecl *D) {
+  D = D->getCanonicalDecl();
+  auto I = LazilyInitializedVars.find(D);
+  if (I != LazilyInitializedVars.end())
+    return I->second;
+
+  bool Lazy = [&] {
+    // The guarded initialization of non-local variables is only supported by
+    // the Itanium ABI. The variables of the devices are initialized by the
+    // host.
+    if (!getTarget().getCXXABI().isItaniumFamily() ||
+        getLangOpts().OpenMPIsDevice || getLangOpts().CUDAIsDevice)
+      return false;
+    if (!D->hasGlobalStorage() || D->isStaticLocal() || D->getTLSKind() ||
+        D->hasAttr<OMPThreadPrivateDeclAttr>() ||
+        D->hasAttr<OMPDeclareTargetDeclAttr>())
+      return false;
+    if (D->getMostRecentDecl()->hasAttr<LazyInitAttr>())
+      return true;
+
+    // With -flazy-dynamic-init, the variables that are only visible in this
+    // translation unit are initialized on their first use, unless their
+    // initialization is explicitly ordered.
+    if (!CodeGenOpts.LazyDynamicInit || D->isExternallyVisible() ||
+        D->hasAttr<InitPriorityAttr>() || D->hasAttr<InitSegAttr>())
+      return false;
+    const VarDecl *InitDecl;
+    const Expr *Init = D->getAnyInitializer(InitDecl);
+    return Init && !Init->isValueDependent() &&
+           !Init->isConstantInitializer(getContext(),
+                                        D->getType()->isReferenceType());
+  }();
+  LazilyInitializedVars[D] = Lazy;
+  return Lazy;
+}
+
+llvm::Function *CodeGenModule::getLazyInitFunction(const VarDecl *D) {
+  assert(isLazilyInitialized(D) && "variable is initialized at startup");
+  SmallString<256> FnName(getMangledName(D));
+  FnName += ".lazy_init";
+  if (llvm::Function *Fn = getModule().getFunction(FnName))
+    return Fn;
+
+  // The uses of an externally visible variable in other translation units
+  // call the function emitted with its definition, which takes the linkage
+  // and visibility of the variable.
+  const CGFunctionInfo &FI = getTypes().arrangeNullaryFunction();
+  llvm::Function *Fn = llvm::Function::Create(
+      getTypes().GetFunctionType(FI),
+      D->isExternallyVisible() ? llvm::GlobalValue::ExternalLinkage
+                               : llvm::GlobalValue::InternalLinkage,
+      FnName, &getModule());
+  SetLLVMFunctionAttributes(nullptr, FI, Fn);
+  if (D->isExternallyVisible())
+    setGlobalVisibility(Fn, D);
+  if (!getLangOpts().Exceptions)
+    Fn->setDoesNotThrow();
+  return Fn;
+}
+
+/// Give the initialization function of a lazily initialized variable the
+/// linkage of the variable, for the definition of the function.
+static llvm::Function *defineLazyInitFunction(CodeGenModule &CGM,
+                                              const VarDecl *D,
+                                              llvm::GlobalVariable *Addr) {
+  llvm::Function *Fn = CGM.getLazyInitFunction(D);
+  Fn->setLinkage(Addr->getLinkage());
+  Fn->setVisibility(Addr->getVisibility());
+  Fn->setDLLStorageClass(Addr->getDLLStorageClass());
+  if (llvm::Comdat *C = Addr->getComdat())
+    Fn->setComdat(C);
+  CGM.SetLLVMFunctionAttributesForDefinition(nullptr, Fn);
+  return Fn;
+}
+
+void CodeGenModule::EmitTrivialLazyInitFunc(const VarDecl *D,
+                                            llvm::GlobalVariable *Addr) {
+  llvm::Function *Fn = getLazyInitFunction(D);
+  if (!Fn->isDeclaration())
+    return;
+  defineLazyInitFunction(*this, D, Addr);
+  CGBuilderTy Builder(*this,
+                      llvm::BasicBlock::Create(getLLVMContext(), "entry", Fn));
+  Builder.CreateRetVoid();
+}
+
 void
 CodeGenModule::EmitCXXGlobalVarDeclInitFunc(const VarDecl *D,
                                             llvm::GlobalVariable *Addr,
@@ -350,6 +436,16 @@ CodeGenModule::EmitCXXGlobalVarDeclInitFunc(const VarDecl *D,
   if (I != DelayedCXXInitPosition.end() && I->second == ~0U)
     return;
 
+  // A lazily initialized variable is initialized by its own function, which
+  // its uses call, instead of at startup.
+  if (PerformInit && isLazilyInitialized(D)) {
+    llvm::Function *Fn = defineLazyInitFunction(*this, D, Addr);
+    CodeGenFunction(*this).GenerateCXXGlobalVarDeclInitFunc(Fn, D, Addr,
+                                                            PerformInit);
+    DelayedCXXInitPosition[D] = ~0U;
+    return;
+  }
+
   llvm::FunctionType *FTy = llvm::FunctionType::get(VoidTy, false);
   SmallString<256> FnName;
   {
@@ -530,8 +626,10 @@ void CodeGenFunction::GenerateCXXGlobalVarDeclInitFunc(
 
   // Use guarded initialization if the global variable is weak. This
   // occurs for, e.g., instantiated static data members and
-  // definitions explicitly marked weak.
-  if (Addr->hasWeakLinkage() || Addr->hasLinkOnceLinkage()) {
+  // definitions explicitly marked weak. A lazily initialized variable is
+  // guarded as a function-local static variable.
+  if (Addr->hasWeakLinkage() || Addr->hasLinkOnceLinkage() ||
+      (PerformInit && CGM.isLazilyInitialized(D))) {
     EmitCXXGuardedInit(*D, Addr, PerformInit, EmitInitOnly, EmitDtorOnly);
   } else {
     EmitCXXGlobalVarDeclInit(*D, Addr, PerformInit, EmitInitOnly, EmitDtorOnly);
@@ -401,6 +401,10 @@ llvm::Value *CodeGenFunction::getSelectorFromSlot() {
 
 void CodeGenFunction::EmitCXXThrowExpr(const CXXThrowExpr *E,
                                        bool KeepInsertionPoint) {
+  // Building and throwing the exception is the unlikely path.
+  SaveAndRestore<bool> Unlikely(
+      InUnlikelyPath,
+      InUnlikelyPath || CGM.getCodeGenOpts().ColdUnlikelyCalls);
   if (const Expr *SubExpr = E->getSubExpr()) {
     QualType ThrowType = SubExpr->getType();
     if (ThrowType->isObjCObjectPointerType()) {
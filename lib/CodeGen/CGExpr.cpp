@@ -2109,6 +2109,13 @@ static LValue EmitGlobalVarDeclLValue(CodeGenFunction &CGF,
       CGF.CGM.getCXXABI().usesThreadWrapperFunction())
     return CGF.CGM.getCXXABI().EmitThreadLocalVarDeclLValue(CGF, VD, T);
 
+  // Initialize a lazily initialized variable before its first use.
+  if (CGF.CGM.isLazilyInitialized(VD)) {
+    llvm::Function *InitFn = CGF.CGM.getLazyInitFunction(VD);
+    if (InitFn != CGF.CurFn)
+      CGF.EmitRuntimeCallOrInvoke(InitFn);
+  }
+
   llvm::Value *V;
   if (CGF.getLangOpts().OpenMP && CGF.getLangOpts().OpenMPIsDevice &&
       VD->hasAttr<OMPDeclareTargetDeclAttr>() &&
@@ -3067,6 +3074,13 @@ static Address emitArraySubscriptGEP(CodeGenFunction &CGF, Address addr,
 
 LValue CodeGenFunction::EmitArraySubscriptExpr(const ArraySubscriptExpr *E,
                                                bool Accessed) {
+  // Reads of the arrays staged by a stencil loop may come from the tile.
+  if (!OMPStagedArrayReads.empty()) {
+    auto I = OMPStagedArrayReads.find(E);
+    if (I != OMPStagedArrayReads.end())
+      return EmitOMPStagedArraySubscriptExpr(E, I->second);
+  }
+
   // The index must always be an integer, which is not an aggregate.  Emit it
   // in lexical order (this complexity is, sadly, required by C++17).
   llvm::Value *IdxPre =
@@ -18,6 +18,7 @@
 #include "clang/AST/DeclCXX.h"
 #include "clang/AST/DeclTemplate.h"
 #include "clang/AST/StmtVisitor.h"
+#include "clang/Frontend/FrontendDiagnostic.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/GlobalVariable.h"
@@ -164,6 +165,7 @@ public:
   void VisitAbstractConditionalOperator(const AbstractConditionalOperator *CO);
   void VisitChooseExpr(const ChooseExpr *CE);
   void VisitInitListExpr(InitListExpr *E);
+  void VisitCompactArrayInitExpr(CompactArrayInitExpr *E);
   void VisitArrayInitLoopExpr(const ArrayInitLoopExpr *E,
                               llvm::Value *outerBegin = nullptr);
   void VisitImplicitValueInitExpr(ImplicitValueInitExpr *E);
@@ -1131,6 +1133,21 @@ void AggExprEmitter::EmitNullInitializationToLValue(LValue lv) {
   }
 }
 
+void AggExprEmitter::VisitCompactArrayInitExpr(CompactArrayInitExpr *E) {
+  // Copy the values from a constant global, as for a constant aggregate
+  // initializer of a local variable.
+  llvm::Constant *C = CGF.CGM.GetConstantArrayFromCompactArrayInit(E);
+  CharUnits Align = CGF.getContext().getTypeAlignInChars(E->getType());
+  auto *GV = new llvm::GlobalVariable(CGF.CGM.getModule(), C->getType(),
+                                      /*isConstant=*/true,
+                                      llvm::GlobalValue::PrivateLinkage, C,
+                                      ".compact.init");
+  GV->setAlignment(Align.getQuantity());
+  GV->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+  EmitFinalDestCopy(E->getType(),
+                    CGF.MakeAddrLValue(Address(GV, Align), E->getType()));
+}
+
 void AggExprEmitter::VisitInitListExpr(InitListExpr *E) {
 #if 0
   // FIXME: Assess perf here?  Figure out what cases are worth optimizing here
@@ -1543,6 +1560,67 @@ LValue CodeGenFunction::EmitAggExprToLValue(const Expr *E) {
   return LV;
 }
 
+/// Return the object that evaluating the aggregate \p E copies, or null if
+/// \p E creates a new object.
+static const Expr *getCopiedObject(const Expr *E, bool ElideConstructors) {
+  E = E->IgnoreParens();
+  if (const auto *Cleanups = dyn_cast<ExprWithCleanups>(E))
+    E = Cleanups->getSubExpr()->IgnoreParens();
+  if (const auto *BTE = dyn_cast<CXXBindTemporaryExpr>(E))
+    E = BTE->getSubExpr()->IgnoreParens();
+
+  if (const auto *CE = dyn_cast<CXXConstructExpr>(E)) {
+    if (CE->isElidable() && ElideConstructors)
+      return nullptr;
+    // A move constructor only copies the bytes of the object if it is
+    // trivial.
+    const CXXConstructorDecl *Ctor = CE->getConstructor();
+    if (!Ctor->isCopyConstructor() &&
+        !(Ctor->isMoveConstructor() && Ctor->isTrivial()))
+      return nullptr;
+    const Expr *Src = CE->getArg(0)->IgnoreParenImpCasts();
+    return isa<MaterializeTemporaryExpr>(Src) ? nullptr : Src;
+  }
+
+  if (const auto *ICE = dyn_cast<ImplicitCastExpr>(E))
+    if (ICE->getCastKind() == CK_LValueToRValue)
+      return ICE->getSubExpr();
+
+  if (const auto *AIL = dyn_cast<ArrayInitLoopExpr>(E))
+    return AIL->getCommonExpr()->getSourceExpr();
+
+  return nullptr;
+}
+
+void CodeGenFunction::EmitAggregateCopyRemark(const Expr *E,
+                                              AggregateCopyReason Reason) {
+  const auto &Pattern = CGM.getCodeGenOpts().OptimizationRemarkAnalysisPattern;
+  if (!Pattern || !Pattern->match("clang-copy") ||
+      !hasAggregateEvaluationKind(E->getType()))
+    return;
+
+  const Expr *Src = getCopiedObject(E, getLangOpts().ElideConstructors);
+  if (!Src)
+    return;
+
+  QualType Ty = E->getType();
+  uint64_t Size = getContext().getTypeSizeInChars(Ty).getQuantity();
+  if (Size < CGM.getCodeGenOpts().AggregateCopyRemarkThreshold)
+    return;
+
+  // Returning a local variable by copy means that it could not be constructed
+  // in the return slot.
+  if (Reason == ACR_Return)
+    if (const auto *DRE = dyn_cast<DeclRefExpr>(Src->IgnoreParenImpCasts()))
+      if (const auto *VD = dyn_cast<VarDecl>(DRE->getDecl()))
+        if (VD->hasLocalStorage() && !isa<ParmVarDecl>(VD))
+          Reason = ACR_MissedNRVO;
+
+  CGM.getDiags().Report(
+      E->getExprLoc(), diag::remark_fe_backend_optimization_remark_analysis_copy)
+      << (unsigned)Size << Ty << Reason;
+}
+
 void CodeGenFunction::EmitAggregateCopy(Address DestPtr,
                                         Address SrcPtr, QualType Ty,
                                         bool isVolatile,
@@ -2140,6 +2140,8 @@ void CodeGenFunction::EmitLambdaExpr(const LambdaExpr *E, AggValueSlot Slot) {
       auto VAT = CurField->getCapturedVLAType();
       EmitStoreThroughLValue(RValue::get(VLASizeMap[VAT->getSizeExpr()]), LV);
     } else {
+      if (!CurField->getType()->isReferenceType())
+        EmitAggregateCopyRemark(*i, ACR_LambdaCapture);
       EmitInitializerForField(*CurField, LV, *i);
     }
   }
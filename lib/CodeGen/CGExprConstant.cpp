@@ -970,6 +970,10 @@ public:
     return CGM.GetConstantArrayFromStringLiteral(E);
   }
 
+  llvm::Constant *VisitCompactArrayInitExpr(CompactArrayInitExpr *E) {
+    return CGM.GetConstantArrayFromCompactArrayInit(E);
+  }
+
   llvm::Constant *VisitObjCEncodeExpr(ObjCEncodeExpr *E) {
     // This must be an @encode initializing an array in a static initializer.
     // Don't emit it as the address of the string, emit the string data itself
@@ -1217,7 +1221,12 @@ llvm::Constant *CodeGenModule::EmitConstantInit(const VarDecl &D,
           return EmitNullConstant(D.getType());
       }
   }
-  
+
+  // Emit a compact array initializer directly from its values, rather than
+  // from an APValue per element.
+  if (const auto *E = dyn_cast_or_null<CompactArrayInitExpr>(D.getInit()))
+    return GetConstantArrayFromCompactArrayInit(E);
+
   if (const APValue *Value = D.evaluateValue())
     return EmitConstantValueForMemory(*Value, D.getType(), CGF);
 
@@ -1244,6 +1253,9 @@ llvm::Constant *CodeGenModule::EmitConstantInit(const VarDecl &D,
 llvm::Constant *CodeGenModule::EmitConstantExpr(const Expr *E,
                                                 QualType DestType,
                                                 CodeGenFunction *CGF) {
+  if (const auto *CAI = dyn_cast<CompactArrayInitExpr>(E))
+    return GetConstantArrayFromCompactArrayInit(CAI);
+
   Expr::EvalResult Result;
 
   bool Success = false;
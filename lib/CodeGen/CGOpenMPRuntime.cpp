@@ -22,11 +22,14 @@
 #include "clang/AST/StmtOpenMP.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/BitmaskEnum.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/CallSite.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/GlobalValue.h"
 #include "llvm/IR/Value.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cassert>
@@ -602,6 +605,10 @@ enum OpenMPRTLFunction {
   OMPRTL__kmpc_threadprivate_register,
   // Call to __kmpc_int32 kmpc_global_thread_num(ident_t *loc);
   OMPRTL__kmpc_global_thread_num,
+  // Call to kmp_int32 __kmpc_bound_thread_num(ident_t *loc);
+  OMPRTL__kmpc_bound_thread_num,
+  // Call to kmp_int32 __kmpc_bound_num_threads(ident_t *loc);
+  OMPRTL__kmpc_bound_num_threads,
   // Call to void __kmpc_critical(ident_t *loc, kmp_int32 global_tid,
   // kmp_critical_name *crit);
   OMPRTL__kmpc_critical,
@@ -647,6 +654,10 @@ enum OpenMPRTLFunction {
   // kmp_int32 flags, size_t sizeof_kmp_task_t, size_t sizeof_shareds,
   // kmp_routine_entry_t *task_entry);
   OMPRTL__kmpc_omp_task_alloc,
+  // Call to kmp_task_t * __kmpc_omp_small_task_alloc(ident_t *, kmp_int32
+  // gtid, kmp_int32 flags, size_t sizeof_kmp_task_t, size_t sizeof_shareds,
+  // kmp_routine_entry_t *task_entry);
+  OMPRTL__kmpc_omp_small_task_alloc,
   // Call to kmp_int32 __kmpc_omp_task(ident_t *, kmp_int32 gtid, kmp_task_t *
   // new_task);
   OMPRTL__kmpc_omp_task,
@@ -816,6 +827,11 @@ enum OpenMPRTLFunction {
   // kmp_int32 flags, size_t sizeof_kmp_task_t, size_t sizeof_shareds,
   // kmp_routine_entry_t *task_entry, int64_t device_id);
   OMPRTL__kmpc_tgt_target_task_alloc,
+  // Call to void __tgt_profile_begin(void *site, int64_t device_id);
+  OMPRTL__tgt_profile_begin,
+  // Call to void __tgt_profile_end(void *site, int64_t device_id, int32_t
+  // ret);
+  OMPRTL__tgt_profile_end,
 };
 
 /// A basic class for pre|post-action for advanced codegen sequence for OpenMP
@@ -845,6 +861,50 @@ void RegionCodeGenTy::operator()(CodeGenFunction &CGF) const {
   }
 }
 
+/// Emit the combiner or the initializer \a CombinerInitializer of a UDR, with
+/// \a In and \a Out mapped to \a InAddr and \a OutAddr.
+static void emitCombinerOrInitializerBody(CodeGenFunction &CGF,
+                                          const Expr *CombinerInitializer,
+                                          const VarDecl *In, const VarDecl *Out,
+                                          Address InAddr, Address OutAddr,
+                                          bool IsCombiner) {
+  CodeGenFunction::OMPPrivateScope Scope(CGF);
+  Scope.addPrivate(In, [InAddr]() -> Address { return InAddr; });
+  Scope.addPrivate(Out, [OutAddr]() -> Address { return OutAddr; });
+  (void)Scope.Privatize();
+  if (!IsCombiner && Out->hasInit() &&
+      !CGF.isTrivialInitializer(Out->getInit())) {
+    CGF.EmitAnyExprToMem(Out->getInit(), CGF.GetAddrOfLocalVar(Out),
+                         Out->getType().getQualifiers(),
+                         /*IsInitializer=*/true);
+  }
+  if (CombinerInitializer)
+    CGF.EmitIgnoredExpr(CombinerInitializer);
+  Scope.ForceCleanup();
+}
+
+/// Emit the combiner, or the initializer, of the UDR \a DRD inline instead of
+/// calling its outlined function, with 'omp_out' and 'omp_in', or 'omp_priv'
+/// and 'omp_orig', mapped to \a OutAddr and \a InAddr.
+static void emitInlinedCombinerOrInitializer(CodeGenFunction &CGF,
+                                             const OMPDeclareReductionDecl *DRD,
+                                             Address OutAddr, Address InAddr,
+                                             bool IsCombiner) {
+  auto &C = CGF.getContext();
+  auto *In = cast<VarDecl>(
+      DRD->lookup(&C.Idents.get(IsCombiner ? "omp_in" : "omp_orig")).front());
+  auto *Out = cast<VarDecl>(
+      DRD->lookup(&C.Idents.get(IsCombiner ? "omp_out" : "omp_priv")).front());
+  const Expr *CombinerInitializer = DRD->getCombiner();
+  if (!IsCombiner)
+    CombinerInitializer =
+        DRD->getInitializerKind() == OMPDeclareReductionDecl::CallInit
+            ? DRD->getInitializer()
+            : nullptr;
+  emitCombinerOrInitializerBody(CGF, CombinerInitializer, In, Out, InAddr,
+                                OutAddr, IsCombiner);
+}
+
 /// Check if the combiner is a call to UDR combiner and if it is so return the
 /// UDR decl used for reduction.
 static const OMPDeclareReductionDecl *
@@ -863,7 +923,11 @@ static void emitInitWithReductionInitializer(CodeGenFunction &CGF,
                                              const Expr *InitOp,
                                              Address Private, Address Original,
                                              QualType Ty) {
-  if (DRD->getInitializer()) {
+  if (DRD->getInitializer() &&
+      CGF.CGM.getCodeGenOpts().OpenMPInlineReductionCombiners) {
+    emitInlinedCombinerOrInitializer(CGF, DRD, Private, Original,
+                                     /*IsCombiner=*/false);
+  } else if (DRD->getInitializer()) {
     std::pair<llvm::Function *, llvm::Function *> Reduction =
         CGF.CGM.getOpenMPRuntime().getUserDefinedReduction(DRD);
     auto *CE = cast<CallExpr>(InitOp);
@@ -1327,27 +1391,16 @@ emitCombinerOrInitializer(CodeGenModule &CGM, QualType Ty,
   // Map "T omp_out;" variable to "*omp_out_parm" value in all expressions.
   CGF.StartFunction(GlobalDecl(), C.VoidTy, Fn, FnInfo, Args, In->getLocation(),
                     Out->getLocation());
-  CodeGenFunction::OMPPrivateScope Scope(CGF);
-  Address AddrIn = CGF.GetAddrOfLocalVar(&OmpInParm);
-  Scope.addPrivate(In, [&CGF, AddrIn, PtrTy]() -> Address {
-    return CGF.EmitLoadOfPointerLValue(AddrIn, PtrTy->castAs<PointerType>())
-        .getAddress();
-  });
-  Address AddrOut = CGF.GetAddrOfLocalVar(&OmpOutParm);
-  Scope.addPrivate(Out, [&CGF, AddrOut, PtrTy]() -> Address {
-    return CGF.EmitLoadOfPointerLValue(AddrOut, PtrTy->castAs<PointerType>())
-        .getAddress();
-  });
-  (void)Scope.Privatize();
-  if (!IsCombiner && Out->hasInit() &&
-      !CGF.isTrivialInitializer(Out->getInit())) {
-    CGF.EmitAnyExprToMem(Out->getInit(), CGF.GetAddrOfLocalVar(Out),
-                         Out->getType().getQualifiers(),
-                         /*IsInitializer=*/true);
-  }
-  if (CombinerInitializer)
-    CGF.EmitIgnoredExpr(CombinerInitializer);
-  Scope.ForceCleanup();
+  Address AddrIn =
+      CGF.EmitLoadOfPointerLValue(CGF.GetAddrOfLocalVar(&OmpInParm),
+                                  PtrTy->castAs<PointerType>())
+          .getAddress();
+  Address AddrOut =
+      CGF.EmitLoadOfPointerLValue(CGF.GetAddrOfLocalVar(&OmpOutParm),
+                                  PtrTy->castAs<PointerType>())
+          .getAddress();
+  emitCombinerOrInitializerBody(CGF, CombinerInitializer, In, Out, AddrIn,
+                                AddrOut, IsCombiner);
   CGF.FinishFunction();
   return Fn;
 }
@@ -1356,6 +1409,9 @@ void CGOpenMPRuntime::emitUserDefinedReduction(
     CodeGenFunction *CGF, const OMPDeclareReductionDecl *D) {
   if (UDRMap.count(D) > 0)
     return;
+  // The combiner and the initializer are emitted inline at each use.
+  if (CGM.getCodeGenOpts().OpenMPInlineReductionCombiners)
+    return;
   auto &C = CGM.getContext();
   if (!In || !Out) {
     In = &C.Idents.get("omp_in");
@@ -1682,10 +1738,36 @@ llvm::Value *CGOpenMPRuntime::getThreadID(CodeGenFunction &CGF,
   return Call;
 }
 
+std::pair<llvm::Value *, llvm::Value *>
+CGOpenMPRuntime::getTeamThreadNumAndSize(CodeGenFunction &CGF,
+                                         SourceLocation Loc) {
+  assert(CGF.CurFn && "No function in current CodeGenFunction.");
+  auto I = OpenMPLocThreadIDMap.find(CGF.CurFn);
+  if (I != OpenMPLocThreadIDMap.end() && I->second.TeamThreadNum)
+    return std::make_pair(I->second.TeamThreadNum, I->second.TeamSize);
+  // The binding team does not change during the execution of the function, so
+  // query the thread number and the team size once in the entry block and use
+  // them for all the worksharing loops of the function.
+  CGBuilderTy::InsertPointGuard IPG(CGF.Builder);
+  CGF.Builder.SetInsertPoint(CGF.AllocaInsertPt);
+  auto *UpLoc = emitUpdateLocation(CGF, Loc);
+  auto *ThreadNum = CGF.Builder.CreateCall(
+      createRuntimeFunction(OMPRTL__kmpc_bound_thread_num), UpLoc);
+  ThreadNum->setCallingConv(CGF.getRuntimeCC());
+  auto *NumThreads = CGF.Builder.CreateCall(
+      createRuntimeFunction(OMPRTL__kmpc_bound_num_threads), UpLoc);
+  NumThreads->setCallingConv(CGF.getRuntimeCC());
+  auto &Elem = OpenMPLocThreadIDMap.FindAndConstruct(CGF.CurFn);
+  Elem.second.TeamThreadNum = ThreadNum;
+  Elem.second.TeamSize = NumThreads;
+  return std::make_pair(ThreadNum, NumThreads);
+}
+
 void CGOpenMPRuntime::functionFinished(CodeGenFunction &CGF) {
   assert(CGF.CurFn && "No function in current CodeGenFunction.");
   if (OpenMPLocThreadIDMap.count(CGF.CurFn))
     OpenMPLocThreadIDMap.erase(CGF.CurFn);
+  FunctionThreadPrivateAddrMap.erase(CGF.CurFn);
   if (FunctionUDRMap.count(CGF.CurFn) > 0) {
     for(auto *D : FunctionUDRMap[CGF.CurFn]) {
       UDRMap.erase(D);
@@ -1732,6 +1814,22 @@ CGOpenMPRuntime::createRuntimeFunction(unsigned Function) {
     RTLFn = CGM.CreateRuntimeFunction(FnTy, "__kmpc_global_thread_num");
     break;
   }
+  case OMPRTL__kmpc_bound_thread_num: {
+    // Build kmp_int32 __kmpc_bound_thread_num(ident_t *loc);
+    llvm::Type *TypeParams[] = {getIdentTyPointerTy()};
+    llvm::FunctionType *FnTy =
+        llvm::FunctionType::get(CGM.Int32Ty, TypeParams, /*isVarArg*/ false);
+    RTLFn = CGM.CreateRuntimeFunction(FnTy, "__kmpc_bound_thread_num");
+    break;
+  }
+  case OMPRTL__kmpc_bound_num_threads: {
+    // Build kmp_int32 __kmpc_bound_num_threads(ident_t *loc);
+    llvm::Type *TypeParams[] = {getIdentTyPointerTy()};
+    llvm::FunctionType *FnTy =
+        llvm::FunctionType::get(CGM.Int32Ty, TypeParams, /*isVarArg*/ false);
+    RTLFn = CGM.CreateRuntimeFunction(FnTy, "__kmpc_bound_num_threads");
+    break;
+  }
   case OMPRTL__kmpc_threadprivate_cached: {
     // Build void *__kmpc_threadprivate_cached(ident_t *loc,
     // kmp_int32 global_tid, void *data, size_t size, void ***cache);
@@ -1925,6 +2023,21 @@ CGOpenMPRuntime::createRuntimeFunction(unsigned Function) {
     RTLFn = CGM.CreateRuntimeFunction(FnTy, /*Name=*/"__kmpc_omp_task_alloc");
     break;
   }
+  case OMPRTL__kmpc_omp_small_task_alloc: {
+    // Build kmp_task_t *__kmpc_omp_small_task_alloc(ident_t *, kmp_int32 gtid,
+    // kmp_int32 flags, size_t sizeof_kmp_task_t, size_t sizeof_shareds,
+    // kmp_routine_entry_t *task_entry);
+    assert(KmpRoutineEntryPtrTy != nullptr &&
+           "Type kmp_routine_entry_t must be created.");
+    llvm::Type *TypeParams[] = {getIdentTyPointerTy(), CGM.Int32Ty, CGM.Int32Ty,
+                                CGM.SizeTy, CGM.SizeTy, KmpRoutineEntryPtrTy};
+    // Return void * and then cast to particular kmp_task_t type.
+    llvm::FunctionType *FnTy =
+        llvm::FunctionType::get(CGM.VoidPtrTy, TypeParams, /*isVarArg=*/false);
+    RTLFn = CGM.CreateRuntimeFunction(FnTy,
+                                      /*Name=*/"__kmpc_omp_small_task_alloc");
+    break;
+  }
   case OMPRTL__kmpc_omp_task: {
     // Build kmp_int32 __kmpc_omp_task(ident_t *, kmp_int32 gtid, kmp_task_t
     // *new_task);
@@ -2567,6 +2680,23 @@ CGOpenMPRuntime::createRuntimeFunction(unsigned Function) {
                                       /*Name=*/"__kmpc_omp_target_task_alloc");
     break;
   }
+  case OMPRTL__tgt_profile_begin: {
+    // Build void __tgt_profile_begin(void *site, int64_t device_id);
+    llvm::Type *TypeParams[] = {CGM.VoidPtrTy, CGM.Int64Ty};
+    llvm::FunctionType *FnTy =
+        llvm::FunctionType::get(CGM.VoidTy, TypeParams, /*isVarArg=*/false);
+    RTLFn = CGM.CreateRuntimeFunction(FnTy, "__tgt_profile_begin");
+    break;
+  }
+  case OMPRTL__tgt_profile_end: {
+    // Build void __tgt_profile_end(void *site, int64_t device_id, int32_t
+    // ret);
+    llvm::Type *TypeParams[] = {CGM.VoidPtrTy, CGM.Int64Ty, CGM.Int32Ty};
+    llvm::FunctionType *FnTy =
+        llvm::FunctionType::get(CGM.VoidTy, TypeParams, /*isVarArg=*/false);
+    RTLFn = CGM.CreateRuntimeFunction(FnTy, "__tgt_profile_end");
+    break;
+  }
   }
   assert(RTLFn && "Unable to find OpenMP runtime function");
   return RTLFn;
@@ -2677,15 +2807,35 @@ Address CGOpenMPRuntime::getAddrOfThreadPrivate(CodeGenFunction &CGF,
       CGM.getContext().getTargetInfo().isTLSSupported())
     return VDAddr;
 
+  // The address of the variable does not change during the execution of the
+  // function, look it up once in the entry block and reuse it for all the
+  // accesses, including the ones in loops.
+  CGBuilderTy::InsertPointGuard IPG(CGF.Builder);
+  bool CacheAddr = false;
+  if (CGM.getCodeGenOpts().OpenMPHoistThreadPrivateLookups) {
+    auto &Addrs = FunctionThreadPrivateAddrMap[CGF.CurFn];
+    if (llvm::Value *Addr = Addrs.lookup(VD->getCanonicalDecl()))
+      return Address(Addr, VDAddr.getAlignment());
+    auto *EntryBB = CGF.AllocaInsertPt->getParent();
+    if (CGF.Builder.GetInsertBlock() == EntryBB) {
+      CacheAddr = true;
+    } else if (auto *Term = EntryBB->getTerminator()) {
+      CGF.Builder.SetInsertPoint(Term);
+      CacheAddr = true;
+    }
+  }
+
   auto VarTy = VDAddr.getElementType();
   llvm::Value *Args[] = {emitUpdateLocation(CGF, Loc), getThreadID(CGF, Loc),
                          CGF.Builder.CreatePointerCast(VDAddr.getPointer(),
                                                        CGM.Int8PtrTy),
                          CGM.getSize(CGM.GetTargetTypeStoreSize(VarTy)),
                          getOrCreateThreadPrivateCache(VD)};
-  return Address(CGF.EmitRuntimeCall(
-      createRuntimeFunction(OMPRTL__kmpc_threadprivate_cached), Args),
-                 VDAddr.getAlignment());
+  auto *Addr = CGF.EmitRuntimeCall(
+      createRuntimeFunction(OMPRTL__kmpc_threadprivate_cached), Args);
+  if (CacheAddr)
+    FunctionThreadPrivateAddrMap[CGF.CurFn][VD->getCanonicalDecl()] = Addr;
+  return Address(Addr, VDAddr.getAlignment());
 }
 
 void CGOpenMPRuntime::emitThreadPrivateVarInit(
@@ -2948,6 +3098,64 @@ void CGOpenMPRuntime::emitParallelCall(CodeGenFunction &CGF, SourceLocation Loc,
   }
 }
 
+llvm::Value *CGOpenMPRuntime::emitFusedParallelOutlinedFunction(
+    SourceLocation Loc, ArrayRef<llvm::Value *> OutlinedFns) {
+  auto &C = CGM.getContext();
+  auto KmpInt32PtrTy =
+      C.getPointerType(C.getIntTypeForBitwidth(/*DestWidth=*/32, /*Signed=*/1))
+          .withRestrict();
+  ImplicitParamDecl GtidArg(C, /*DC=*/nullptr, Loc, /*Id=*/nullptr,
+                            KmpInt32PtrTy, ImplicitParamDecl::Other);
+  ImplicitParamDecl BoundArg(C, /*DC=*/nullptr, Loc, /*Id=*/nullptr,
+                             KmpInt32PtrTy, ImplicitParamDecl::Other);
+  FunctionArgList Args;
+  Args.push_back(&GtidArg);
+  Args.push_back(&BoundArg);
+  for (auto *OutlinedFn : OutlinedFns) {
+    auto *FnTy = cast<llvm::Function>(OutlinedFn)->getFunctionType();
+    for (unsigned I = 2, E = FnTy->getNumParams(); I < E; ++I)
+      Args.push_back(ImplicitParamDecl::Create(C, C.VoidPtrTy,
+                                               ImplicitParamDecl::Other));
+  }
+  auto &FnInfo =
+      CGM.getTypes().arrangeBuiltinFunctionDeclaration(C.VoidTy, Args);
+  auto *Fn = llvm::Function::Create(CGM.getTypes().GetFunctionType(FnInfo),
+                                    llvm::GlobalValue::InternalLinkage,
+                                    ".omp_fused_outlined.", &CGM.getModule());
+  CGM.SetInternalFunctionAttributes(/*D=*/nullptr, Fn, FnInfo);
+  CodeGenFunction CGF(CGM);
+  CGF.StartFunction(GlobalDecl(), C.VoidTy, Fn, FnInfo, Args, Loc, Loc);
+
+  auto *GtidAddr = CGF.Builder.CreateLoad(CGF.GetAddrOfLocalVar(&GtidArg));
+  auto *BoundAddr = CGF.Builder.CreateLoad(CGF.GetAddrOfLocalVar(&BoundArg));
+  unsigned ArgIdx = 2;
+  for (auto *OutlinedFn : OutlinedFns) {
+    if (OutlinedFn != OutlinedFns.front()) {
+      // No thread starts a region before all of them completed the previous
+      // one, as they would at its join.
+      llvm::Value *BarrierArgs[] = {
+          emitUpdateLocation(CGF, Loc, OMP_IDENT_BARRIER_IMPL),
+          CGF.Builder.CreateLoad(
+              Address(GtidAddr, CharUnits::fromQuantity(4)))};
+      CGF.EmitRuntimeCall(createRuntimeFunction(OMPRTL__kmpc_barrier),
+                          BarrierArgs);
+    }
+    // OutlinedFn(gtid, bound_tid, captured vars of the region);
+    auto *FnTy = cast<llvm::Function>(OutlinedFn)->getFunctionType();
+    llvm::SmallVector<llvm::Value *, 16> CallArgs;
+    CallArgs.push_back(GtidAddr);
+    CallArgs.push_back(BoundAddr);
+    for (unsigned I = 2, E = FnTy->getNumParams(); I < E; ++I, ++ArgIdx) {
+      auto *Arg = CGF.Builder.CreateLoad(CGF.GetAddrOfLocalVar(Args[ArgIdx]));
+      CallArgs.push_back(CGF.Builder.CreatePointerBitCastOrAddrSpaceCast(
+          Arg, FnTy->getParamType(I)));
+    }
+    emitOutlinedFunctionCall(CGF, Loc, OutlinedFn, CallArgs);
+  }
+  CGF.FinishFunction();
+  return Fn;
+}
+
 void CGOpenMPRuntime::emitSimdCall(CodeGenFunction &CGF, SourceLocation Loc,
                                    llvm::Value *OutlinedFn,
                                    ArrayRef<llvm::Value *> CapturedVars) {}
@@ -3064,6 +3272,13 @@ void CGOpenMPRuntime::emitCriticalRegion(CodeGenFunction &CGF,
   emitInlinedDirective(CGF, OMPD_critical, CriticalOpGen);
 }
 
+bool CGOpenMPRuntime::emitCriticalRegionAsAtomicUpdate(
+    CodeGenFunction &CGF, StringRef CriticalName,
+    const RegionCodeGenTy &CriticalOpGen, const Stmt *CriticalBody,
+    SourceLocation Loc, const Expr *Hint) {
+  return false;
+}
+
 void CGOpenMPRuntime::emitMasterRegion(CodeGenFunction &CGF,
                                        const RegionCodeGenTy &MasterOpGen,
                                        SourceLocation Loc) {
@@ -3378,11 +3593,31 @@ bool CGOpenMPRuntime::generateCoalescedSchedule(
 
 bool CGOpenMPRuntime::generateCoalescedSchedule(
     OpenMPDistScheduleClauseKind DistScheduleKind,
-    OpenMPScheduleClauseKind ScheduleKind, bool DistChunked, bool ChunkSizeOne,
-    bool Ordered) const {
+    OpenMPScheduleClauseKind ScheduleKind, const Expr *DistChunkSize,
+    bool ChunkSizeOne, bool Ordered) const {
+  return false;
+}
+
+void CGOpenMPRuntime::emitUncoalescedScheduleRemark(
+    const OMPLoopDirective &S) {}
+
+bool CGOpenMPRuntime::getStencilStagingLimits(const OMPLoopDirective &S,
+                                              unsigned &TeamSize,
+                                              uint64_t &Budget) const {
   return false;
 }
 
+Address CGOpenMPRuntime::emitStencilStagingBuffer(CodeGenFunction &CGF,
+                                                  QualType EltTy,
+                                                  uint64_t NumElts) {
+  llvm_unreachable("stencil staging is not supported by the target");
+}
+
+std::pair<llvm::Value *, llvm::Value *>
+CGOpenMPRuntime::emitTeamThreadIDAndSize(CodeGenFunction &CGF) {
+  llvm_unreachable("stencil staging is not supported by the target");
+}
+
 bool CGOpenMPRuntime::isDynamic(OpenMPScheduleClauseKind ScheduleKind) const {
   auto Schedule =
       getRuntimeSchedule(ScheduleKind, /*Chunked=*/false, /*Ordered=*/false);
@@ -3545,6 +3780,50 @@ void CGOpenMPRuntime::emitForStaticInit(CodeGenFunction &CGF,
                         ScheduleNum, ScheduleKind.M1, ScheduleKind.M2, Values);
 }
 
+void CGOpenMPRuntime::emitInlinedForStaticInit(CodeGenFunction &CGF,
+                                               SourceLocation Loc,
+                                               const StaticRTInput &Values) {
+  if (!CGF.HaveInsertPoint())
+    return;
+  assert(!Values.Chunk && !Values.Ordered &&
+         "expected static non-chunked schedule");
+  // Split the iteration space the same way __kmpc_for_static_init does for the
+  // default static schedule, so that the loop can still be paired with loops
+  // scheduled by the runtime under 'nowait':
+  // Chunk = Trip / NumThreads + (Trip % NumThreads != 0);
+  // LB = LB + ThreadNum * Chunk;
+  // UB = min(LB + Chunk - 1, GlobalUB);
+  // IL = LB <= GlobalUB && LB + Chunk - 1 >= GlobalUB;
+  // ST = Trip;
+  auto &CGM = CGF.CGM;
+  auto &Builder = CGF.Builder;
+  llvm::Value *ThreadNum, *NumThreads;
+  std::tie(ThreadNum, NumThreads) = getTeamThreadNumAndSize(CGF, Loc);
+  auto *IVTy = Builder.getIntNTy(Values.IVSize);
+  ThreadNum = Builder.CreateIntCast(ThreadNum, IVTy, /*isSigned=*/false);
+  NumThreads = Builder.CreateIntCast(NumThreads, IVTy, /*isSigned=*/false);
+  auto *GlobalLB = Builder.CreateLoad(Values.LB);
+  auto *GlobalUB = Builder.CreateLoad(Values.UB);
+  auto *One = llvm::ConstantInt::get(IVTy, /*V=*/1);
+  auto *Trip = Builder.CreateAdd(Builder.CreateSub(GlobalUB, GlobalLB), One);
+  auto *HasRem = Builder.CreateIsNotNull(Builder.CreateURem(Trip, NumThreads));
+  auto *Chunk = Builder.CreateAdd(Builder.CreateUDiv(Trip, NumThreads),
+                                  Builder.CreateZExt(HasRem, IVTy));
+  auto *LB = Builder.CreateAdd(GlobalLB, Builder.CreateMul(ThreadNum, Chunk));
+  auto *UB = Builder.CreateSub(Builder.CreateAdd(LB, Chunk), One);
+  auto *IsLast = Builder.CreateAnd(
+      Values.IVSigned ? Builder.CreateICmpSLE(LB, GlobalUB)
+                      : Builder.CreateICmpULE(LB, GlobalUB),
+      Values.IVSigned ? Builder.CreateICmpSGE(UB, GlobalUB)
+                      : Builder.CreateICmpUGE(UB, GlobalUB));
+  auto *UBInRange = Values.IVSigned ? Builder.CreateICmpSLT(UB, GlobalUB)
+                                    : Builder.CreateICmpULT(UB, GlobalUB);
+  Builder.CreateStore(LB, Values.LB);
+  Builder.CreateStore(Builder.CreateSelect(UBInRange, UB, GlobalUB), Values.UB);
+  Builder.CreateStore(Builder.CreateZExt(IsLast, CGM.Int32Ty), Values.IL);
+  Builder.CreateStore(Trip, Values.ST);
+}
+
 void CGOpenMPRuntime::emitDistributeStaticInit(
     CodeGenFunction &CGF, SourceLocation Loc,
     OpenMPDistScheduleClauseKind SchedKind,
@@ -3680,6 +3959,10 @@ bool CGOpenMPRuntime::requiresBarrier(const OMPLoopDirective &S) const {
   return false;
 }
 
+bool CGOpenMPRuntime::requiresOutlinedSimd(const OMPLoopDirective &S) const {
+  return false;
+}
+
 void CGOpenMPRuntime::emitFlush(CodeGenFunction &CGF, ArrayRef<const Expr *>,
                                 SourceLocation Loc) {
   if (!CGF.HaveInsertPoint())
@@ -3733,6 +4016,7 @@ void CGOpenMPRuntime::OffloadEntriesInfoManagerTy::
   OffloadEntriesTargetRegion[DeviceID][FileID][ParentName][LineNum] =
       OffloadEntryInfoTargetRegion(Order, /*Addr=*/nullptr, /*ID=*/nullptr,
                                    /*Flags=*/0u);
+  TargetRegionParentNames.insert(ParentName);
   ++OffloadingOrderedEntriesNum;
 }
 
@@ -4066,6 +4350,22 @@ CGOpenMPRuntime::createOffloadingBinaryDescriptorRegistration() {
   return RegFn;
 }
 
+namespace {
+enum OpenMPOffloadEntryTableVersion : uint64_t {
+  /// \brief Position of the table version in the flags of each entry.
+  OMP_OFFLOAD_ENTRY_VERSION_SHIFT = 24,
+  /// \brief Entries carry the hash of their name in the reserved field and
+  /// are sorted by it, then by name, in each translation unit.
+  OMP_OFFLOAD_ENTRY_VERSION_HASHED = 1,
+};
+}
+
+/// \brief Return the hash of an entry name stored in hashed offload entry
+/// tables: h = h * 33 + c over the bytes of the name, starting from 0.
+static unsigned getOffloadEntryNameHash(StringRef Name) {
+  return llvm::HashString(Name);
+}
+
 void CGOpenMPRuntime::createOffloadEntry(llvm::Constant *ID,
                                          llvm::Constant *Addr, uint64_t Size,
                                          uint64_t Flags) {
@@ -4102,8 +4402,15 @@ void CGOpenMPRuntime::createOffloadEntry(llvm::Constant *ID,
   EntryInit.add(AddrPtr);
   EntryInit.add(StrPtr);
   EntryInit.addInt(CGM.SizeTy, Size);
-  EntryInit.addInt(CGM.Int32Ty, Flags);
-  EntryInit.addInt(CGM.Int32Ty, 0);
+  if (CGM.getCodeGenOpts().OpenMPHashedOffloadEntries) {
+    EntryInit.addInt(CGM.Int32Ty,
+                     Flags | (OMP_OFFLOAD_ENTRY_VERSION_HASHED
+                              << OMP_OFFLOAD_ENTRY_VERSION_SHIFT));
+    EntryInit.addInt(CGM.Int32Ty, getOffloadEntryNameHash(Name));
+  } else {
+    EntryInit.addInt(CGM.Int32Ty, Flags);
+    EntryInit.addInt(CGM.Int32Ty, 0);
+  }
   SmallString<128> EntryGblName(".omp_offloading.entry.");
   EntryGblName += Name;
   llvm::GlobalVariable *Entry =
@@ -4112,6 +4419,12 @@ void CGOpenMPRuntime::createOffloadEntry(llvm::Constant *ID,
 
   // The entry has to be created in the section the linker expects it to be.
   Entry->setSection(".omp_offloading.entries");
+
+  // Nothing refers to the entry. The offload linker script keeps its section,
+  // but without it the linker could drop the section when garbage collecting
+  // unused sections, so protect the entry from being discarded.
+  if (CGM.getCodeGenOpts().OpenMPOffloadWrapperObjects)
+    CGM.addUsedGlobal(Entry);
 }
 
 void CGOpenMPRuntime::createOffloadEntriesAndInfoMetadata() {
@@ -4125,8 +4438,10 @@ void CGOpenMPRuntime::createOffloadEntriesAndInfoMetadata() {
   // regions.
 
   // If we do not have entries, we dont need to do anything.
-  if (OffloadEntriesInfoManager.empty())
+  if (OffloadEntriesInfoManager.empty()) {
+    emitOffloadInfoFile(/*MD=*/nullptr);
     return;
+  }
 
   llvm::Module &M = CGM.getModule();
   llvm::LLVMContext &C = M.getContext();
@@ -4220,6 +4535,28 @@ void CGOpenMPRuntime::createOffloadEntriesAndInfoMetadata() {
   OffloadEntriesInfoManager.actOnDeviceFunctionEntriesInfo(
       DeviceFunctionMetadataEmitter);
 
+  // The offloading info is complete, so it can be written to its own file.
+  emitOffloadInfoFile(MD);
+
+  // The entries of a hashed table are emitted sorted by the hash of their
+  // names. The host and the device compilations sort the same entries, so
+  // their tables keep matching position by position.
+  struct OffloadEntryTy {
+    llvm::Constant *ID;
+    llvm::Constant *Addr;
+    uint64_t Size;
+    uint64_t Flags;
+  };
+  SmallVector<OffloadEntryTy, 16> Entries;
+  auto &&CreateOffloadEntry = [this, &Entries](llvm::Constant *ID,
+                                               llvm::Constant *Addr,
+                                               uint64_t Size, uint64_t Flags) {
+    if (CGM.getCodeGenOpts().OpenMPHashedOffloadEntries)
+      Entries.push_back({ID, Addr, Size, Flags});
+    else
+      createOffloadEntry(ID, Addr, Size, Flags);
+  };
+
   for (auto *E : OrderedEntries) {
     assert(E && "All ordered entries must exist!");
     if (auto *CE =
@@ -4227,7 +4564,7 @@ void CGOpenMPRuntime::createOffloadEntriesAndInfoMetadata() {
                 E)) {
       assert(CE->getID() && CE->getAddress() &&
              "Entry ID and Addr are invalid!");
-      createOffloadEntry(CE->getID(), CE->getAddress(), /*Size=*/0,
+      CreateOffloadEntry(CE->getID(), CE->getAddress(), /*Size=*/0,
                          CE->getFlags());
     } else if (auto *CE = dyn_cast<OffloadEntriesInfoManagerTy::
                                        OffloadEntryInfoDeviceGlobalVar>(E)) {
@@ -4241,7 +4578,7 @@ void CGOpenMPRuntime::createOffloadEntriesAndInfoMetadata() {
 
       // The global address can be used as ID.
       if (!CE->getOnlyMetadataFlag()) {
-        createOffloadEntry(
+        CreateOffloadEntry(
             CE->getAddress(), CE->getAddress(),
             CGM.getContext().getTypeSizeInChars(CE->getType()).getQuantity(),
             CE->getFlags());
@@ -4249,6 +4586,48 @@ void CGOpenMPRuntime::createOffloadEntriesAndInfoMetadata() {
     } else
       llvm_unreachable("Unsupported ordered entry kind.");
   }
+
+  std::stable_sort(Entries.begin(), Entries.end(),
+                   [](const OffloadEntryTy &LHS, const OffloadEntryTy &RHS) {
+                     StringRef LHSName = LHS.Addr->getName();
+                     StringRef RHSName = RHS.Addr->getName();
+                     unsigned LHSHash = getOffloadEntryNameHash(LHSName);
+                     unsigned RHSHash = getOffloadEntryNameHash(RHSName);
+                     if (LHSHash != RHSHash)
+                       return LHSHash < RHSHash;
+                     return LHSName < RHSName;
+                   });
+  for (auto &E : Entries)
+    createOffloadEntry(E.ID, E.Addr, E.Size, E.Flags);
+}
+
+/// \brief Writes the offloading info metadata to the file that the device
+/// compilations read instead of the host IR.
+void CGOpenMPRuntime::emitOffloadInfoFile(llvm::NamedMDNode *MD) {
+  const std::string &InfoFile =
+      CGM.getCodeGenOpts().OpenMPOffloadInfoOutputFile;
+  if (InfoFile.empty())
+    return;
+
+  // The file is a bitcode module that only holds a copy of the offloading
+  // info metadata. It is written even if there are no entries, so that the
+  // device compilations never have to fall back to the host IR.
+  llvm::Module InfoModule("omp_offload.info", CGM.getLLVMContext());
+  llvm::NamedMDNode *InfoMD =
+      InfoModule.getOrInsertNamedMetadata("omp_offload.info");
+  if (MD)
+    for (auto *I : MD->operands())
+      InfoMD->addOperand(I);
+
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(InfoFile, EC, llvm::sys::fs::F_None);
+  if (EC) {
+    unsigned DiagID = CGM.getDiags().getCustomDiagID(
+        DiagnosticsEngine::Error, "unable to open offload info file '%0': %1");
+    CGM.getDiags().Report(DiagID) << InfoFile << EC.message();
+    return;
+  }
+  llvm::WriteBitcodeToFile(&InfoModule, OS);
 }
 
 /// \brief Loads all the offload entries information from the host IR
@@ -4260,21 +4639,51 @@ void CGOpenMPRuntime::loadOffloadInfoMetadata() {
   if (!CGM.getLangOpts().OpenMPIsDevice)
     return;
 
-  if (CGM.getLangOpts().OMPHostIRFile.empty())
-    return;
-
-  auto Buf = llvm::MemoryBuffer::getFile(CGM.getLangOpts().OMPHostIRFile);
-  if (Buf.getError())
+  const std::string &InfoFile = CGM.getCodeGenOpts().OpenMPHostOffloadInfoFile;
+  const std::string &HostIRFile = CGM.getLangOpts().OMPHostIRFile;
+  if (InfoFile.empty() && HostIRFile.empty())
     return;
 
   llvm::LLVMContext C;
-  auto ME = expectedToErrorOrAndEmitErrors(
-      C, llvm::parseBitcodeFile(Buf.get()->getMemBufferRef(), C));
+  std::unique_ptr<llvm::MemoryBuffer> Buf;
+  std::unique_ptr<llvm::Module> M;
+
+  // Prefer the offloading info written by the host compilation, which only
+  // holds the metadata we need.
+  if (!InfoFile.empty()) {
+    auto BufOrErr = llvm::MemoryBuffer::getFile(InfoFile);
+    if (!BufOrErr.getError()) {
+      Buf = std::move(BufOrErr.get());
+      auto ME = expectedToErrorOrAndEmitErrors(
+          C, llvm::parseBitcodeFile(Buf->getMemBufferRef(), C));
+      if (!ME.getError())
+        M = std::move(ME.get());
+    }
+  }
 
-  if (ME.getError())
-    return;
+  // Otherwise load the host IR lazily, so that only its metadata is read and
+  // none of the function bodies are.
+  if (!M) {
+    if (HostIRFile.empty())
+      return;
+
+    auto BufOrErr = llvm::MemoryBuffer::getFile(HostIRFile);
+    if (BufOrErr.getError())
+      return;
+    Buf = std::move(BufOrErr.get());
 
-  llvm::NamedMDNode *MD = ME.get()->getNamedMetadata("omp_offload.info");
+    auto ME = expectedToErrorOrAndEmitErrors(
+        C, llvm::getLazyBitcodeModule(Buf->getMemBufferRef(), C,
+                                      /*ShouldLazyLoadMetadata=*/true));
+    if (ME.getError())
+      return;
+    M = std::move(ME.get());
+
+    if (errorToErrorCodeAndEmitErrors(C, M->materializeMetadata()))
+      return;
+  }
+
+  llvm::NamedMDNode *MD = M->getNamedMetadata("omp_offload.info");
   if (!MD)
     return;
 
@@ -5226,6 +5635,19 @@ CGOpenMPRuntime::TaskResultTy CGOpenMPRuntime::emitTaskInit(
     NewTask = CGF.EmitRuntimeCall(
         createRuntimeFunction(OMPRTL__kmpc_tgt_target_task_alloc), AllocArgs);
   } else {
+    // Tied tasks without dependences whose privates and shareds fit in a
+    // cache line can be allocated from a per-thread freelist of the runtime
+    // instead of the heap. Untied tasks may complete on another thread, so
+    // they always take the general path.
+    const CharUnits SmallTaskDataSize = CharUnits::fromQuantity(64);
+    bool IsSmallTask =
+        CGM.getCodeGenOpts().OpenMPSmallTaskAlloc &&
+        D.getDirectiveKind() == OMPD_task && Data.Tied &&
+        Data.Dependences.empty() &&
+        C.getTypeSizeInChars(KmpTaskTWithPrivatesQTy) -
+                C.getTypeSizeInChars(KmpTaskTQTy) +
+                C.getTypeSizeInChars(SharedsTy) <=
+            SmallTaskDataSize;
     llvm::Value *AllocArgs[] = {emitUpdateLocation(CGF, Loc),
                                 getThreadID(CGF, Loc),
                                 TaskFlags,
@@ -5234,7 +5656,9 @@ CGOpenMPRuntime::TaskResultTy CGOpenMPRuntime::emitTaskInit(
                                 CGF.Builder.CreatePointerBitCastOrAddrSpaceCast(
                                     TaskEntry, KmpRoutineEntryPtrTy)};
     NewTask = CGF.EmitRuntimeCall(
-        createRuntimeFunction(OMPRTL__kmpc_omp_task_alloc), AllocArgs);
+        createRuntimeFunction(IsSmallTask ? OMPRTL__kmpc_omp_small_task_alloc
+                                          : OMPRTL__kmpc_omp_task_alloc),
+        AllocArgs);
   }
   auto *NewTaskNewTaskTTy = CGF.Builder.CreatePointerBitCastOrAddrSpaceCast(
       NewTask, KmpTaskTWithPrivatesPtrTy);
@@ -5471,6 +5895,15 @@ void CGOpenMPRuntime::emitReductionCombiner(CodeGenFunction &CGF,
       if (auto *DRE =
               dyn_cast<DeclRefExpr>(OVE->getSourceExpr()->IgnoreImpCasts()))
         if (auto *DRD = dyn_cast<OMPDeclareReductionDecl>(DRE->getDecl())) {
+          if (CGF.CGM.getCodeGenOpts().OpenMPInlineReductionCombiners) {
+            // The arguments of the call are the addresses of omp_out and
+            // omp_in.
+            Address OutAddr = CGF.EmitPointerWithAlignment(CE->getArg(0));
+            Address InAddr = CGF.EmitPointerWithAlignment(CE->getArg(1));
+            emitInlinedCombinerOrInitializer(CGF, DRD, OutAddr, InAddr,
+                                             /*IsCombiner=*/true);
+            return;
+          }
           std::pair<llvm::Function *, llvm::Function *> Reduction =
               CGF.CGM.getOpenMPRuntime().getUserDefinedReduction(DRD);
           RValue Func = RValue::get(Reduction.first);
@@ -5690,6 +6123,17 @@ void CGOpenMPRuntime::emitReduction(CodeGenFunction &CGF, SourceLocation Loc,
       CGM, Loc, CGF.ConvertTypeForMem(ReductionArrayTy)->getPointerTo(),
       Privates, LHSExprs, RHSExprs, ReductionOps);
 
+  // Combine the lists of the threads in a tree instead of going through
+  // __kmpc_reduce, which falls back to a critical region for the combiners
+  // that cannot be emitted as atomics.
+  if (CGM.getCodeGenOpts().OpenMPTreeReduction &&
+      !CGM.getLangOpts().OpenMPIsDevice &&
+      !isOpenMPTeamsDirective(ReductionKind)) {
+    emitTreeReduction(CGF, Loc, ReductionList, ReductionFn, Privates, LHSExprs,
+                      RHSExprs, ReductionOps);
+    return;
+  }
+
   // 3. Create static kmp_critical_name lock = { 0 };
   auto *Lock = getCriticalRegionLock(".reduction");
 
@@ -5879,6 +6323,170 @@ void CGOpenMPRuntime::emitReduction(CodeGenFunction &CGF, SourceLocation Loc,
   CGF.EmitBlock(DefaultBB, /*IsFinished=*/true);
 }
 
+/// Emits the function that copies the address of the reduction slots of the
+/// master thread:
+/// \code
+/// void .omp.reduction.tree.copy_func(void *dst, void *src) {
+///   *(void **)dst = *(void **)src;
+/// }
+/// \endcode
+static llvm::Value *emitTreeReductionCopyFunction(CodeGenModule &CGM,
+                                                  SourceLocation Loc) {
+  auto &C = CGM.getContext();
+  FunctionArgList Args;
+  ImplicitParamDecl LHSArg(C, /*DC=*/nullptr, Loc, /*Id=*/nullptr, C.VoidPtrTy,
+                           ImplicitParamDecl::Other);
+  ImplicitParamDecl RHSArg(C, /*DC=*/nullptr, Loc, /*Id=*/nullptr, C.VoidPtrTy,
+                           ImplicitParamDecl::Other);
+  Args.push_back(&LHSArg);
+  Args.push_back(&RHSArg);
+  auto &CGFI = CGM.getTypes().arrangeBuiltinFunctionDeclaration(C.VoidTy, Args);
+  auto *Fn = llvm::Function::Create(
+      CGM.getTypes().GetFunctionType(CGFI), llvm::GlobalValue::InternalLinkage,
+      ".omp.reduction.tree.copy_func", &CGM.getModule());
+  CGM.SetInternalFunctionAttributes(/*D=*/nullptr, Fn, CGFI);
+  CodeGenFunction CGF(CGM);
+  CGF.StartFunction(GlobalDecl(), C.VoidTy, Fn, CGFI, Args, Loc, Loc);
+  Address LHS(CGF.Builder.CreatePointerBitCastOrAddrSpaceCast(
+                  CGF.Builder.CreateLoad(CGF.GetAddrOfLocalVar(&LHSArg)),
+                  CGM.VoidPtrPtrTy),
+              CGF.getPointerAlign());
+  Address RHS(CGF.Builder.CreatePointerBitCastOrAddrSpaceCast(
+                  CGF.Builder.CreateLoad(CGF.GetAddrOfLocalVar(&RHSArg)),
+                  CGM.VoidPtrPtrTy),
+              CGF.getPointerAlign());
+  CGF.Builder.CreateStore(CGF.Builder.CreateLoad(RHS), LHS);
+  CGF.FinishFunction();
+  return Fn;
+}
+
+void CGOpenMPRuntime::emitTreeReduction(CodeGenFunction &CGF,
+                                        SourceLocation Loc,
+                                        Address ReductionList,
+                                        llvm::Value *ReductionFn,
+                                        ArrayRef<const Expr *> Privates,
+                                        ArrayRef<const Expr *> LHSExprs,
+                                        ArrayRef<const Expr *> RHSExprs,
+                                        ArrayRef<const Expr *> ReductionOps) {
+  // Next code is emitted for the tree reduction:
+  //
+  // void *buf[<nth> * <stride>];
+  // void **slots = buf;
+  // __kmpc_copyprivate(<loc>, <gtid>, sizeof(void *), &slots, copy_func,
+  //                    <tid> == 0);
+  // slots[<tid> * <stride>] = RedList;
+  // __kmpc_barrier(<loc>, <gtid>);
+  // for (step = 1; step < <nth>; step *= 2) {
+  //   if ((<tid> & (2 * step - 1)) == 0 && <tid> + step < <nth>)
+  //     reduce_func(RedList, slots[(<tid> + step) * <stride>]);
+  //   __kmpc_barrier(<loc>, <gtid>);
+  // }
+  // if (<tid> == 0) {
+  //  ...
+  //  <LHSExprs>[i] = RedOp<i>(*<LHSExprs>[i], *<RHSExprs>[i]);
+  //  ...
+  // }
+  //
+  // The slots are on the stack of the master thread, which broadcasts their
+  // address to the team. The private copies of each thread stay alive until
+  // the barrier that ends the step in which they are combined, so no lock is
+  // needed.
+  auto &Builder = CGF.Builder;
+  llvm::Value *ThreadNum, *NumThreads;
+  std::tie(ThreadNum, NumThreads) = getTeamThreadNumAndSize(CGF, Loc);
+  // Each thread publishes its list in its own cache line.
+  const unsigned SlotSize = 64;
+  auto *Stride =
+      Builder.getInt32(SlotSize / CGM.getPointerSize().getQuantity());
+  llvm::Value *StackPtr = CGF.EmitNounwindRuntimeCall(
+      CGM.getIntrinsic(llvm::Intrinsic::stacksave));
+  auto *Buf = Builder.CreateAlloca(CGM.VoidPtrTy,
+                                   Builder.CreateMul(NumThreads, Stride),
+                                   ".omp.reduction.tree.buf");
+  Buf->setAlignment(SlotSize);
+  Address SlotsAddr = CGF.CreateMemTemp(CGF.getContext().VoidPtrTy,
+                                        ".omp.reduction.tree.slots");
+  Builder.CreateStore(Builder.CreatePointerBitCastOrAddrSpaceCast(
+                          Buf, CGM.VoidPtrTy),
+                      SlotsAddr);
+  llvm::Value *CopyArgs[] = {
+      emitUpdateLocation(CGF, Loc), getThreadID(CGF, Loc),
+      CGF.getTypeSize(CGF.getContext().VoidPtrTy),
+      Builder.CreatePointerBitCastOrAddrSpaceCast(SlotsAddr.getPointer(),
+                                                  CGM.VoidPtrTy),
+      emitTreeReductionCopyFunction(CGM, Loc),
+      Builder.CreateZExt(Builder.CreateIsNull(ThreadNum), CGM.Int32Ty)};
+  CGF.EmitRuntimeCall(createRuntimeFunction(OMPRTL__kmpc_copyprivate),
+                      CopyArgs);
+  auto *Slots = Builder.CreatePointerBitCastOrAddrSpaceCast(
+      Builder.CreateLoad(SlotsAddr), CGM.VoidPtrPtrTy);
+  auto *RL = Builder.CreatePointerBitCastOrAddrSpaceCast(
+      ReductionList.getPointer(), CGM.VoidPtrTy);
+  Address OwnSlot(
+      Builder.CreateInBoundsGEP(Slots, Builder.CreateMul(ThreadNum, Stride)),
+      CGF.getPointerAlign());
+  Builder.CreateStore(RL, OwnSlot);
+  emitBarrierCall(CGF, Loc, OMPD_unknown, /*EmitChecks=*/false,
+                  /*ForceSimpleCall=*/true);
+
+  Address Step = CGF.CreateDefaultAlignTempAlloca(CGF.Int32Ty,
+                                                  ".omp.reduction.tree.step");
+  Builder.CreateStore(Builder.getInt32(1), Step);
+  auto *CondBB = CGF.createBasicBlock(".omp.reduction.tree.cond");
+  auto *BodyBB = CGF.createBasicBlock(".omp.reduction.tree.body");
+  auto *CombineBB = CGF.createBasicBlock(".omp.reduction.tree.combine");
+  auto *NextBB = CGF.createBasicBlock(".omp.reduction.tree.next");
+  auto *ExitBB = CGF.createBasicBlock(".omp.reduction.tree.exit");
+  CGF.EmitBlock(CondBB);
+  auto *StepVal = Builder.CreateLoad(Step);
+  Builder.CreateCondBr(Builder.CreateICmpULT(StepVal, NumThreads), BodyBB,
+                       ExitBB);
+  CGF.EmitBlock(BodyBB);
+  // The head of each subtree of 2 * step threads combines the list of the
+  // head of its second half.
+  auto *Mask =
+      Builder.CreateSub(Builder.CreateShl(StepVal, 1), Builder.getInt32(1));
+  auto *IsHead = Builder.CreateIsNull(Builder.CreateAnd(ThreadNum, Mask));
+  auto *Partner = Builder.CreateAdd(ThreadNum, StepVal);
+  auto *HasPartner = Builder.CreateICmpULT(Partner, NumThreads);
+  Builder.CreateCondBr(Builder.CreateAnd(IsHead, HasPartner), CombineBB,
+                       NextBB);
+  CGF.EmitBlock(CombineBB);
+  Address PartnerSlot(
+      Builder.CreateInBoundsGEP(Slots, Builder.CreateMul(Partner, Stride)),
+      CGF.getPointerAlign());
+  llvm::Value *Lists[] = {RL, Builder.CreateLoad(PartnerSlot)};
+  emitOutlinedFunctionCall(CGF, Loc, ReductionFn, Lists);
+  CGF.EmitBlock(NextBB);
+  emitBarrierCall(CGF, Loc, OMPD_unknown, /*EmitChecks=*/false,
+                  /*ForceSimpleCall=*/true);
+  Builder.CreateStore(Builder.CreateShl(StepVal, 1), Step);
+  CGF.EmitBranch(CondBB);
+  CGF.EmitBlock(ExitBB);
+
+  // The master thread holds the result of the team.
+  auto *MasterBB = CGF.createBasicBlock(".omp.reduction.tree.master");
+  auto *DoneBB = CGF.createBasicBlock(".omp.reduction.tree.done");
+  Builder.CreateCondBr(Builder.CreateIsNull(ThreadNum), MasterBB, DoneBB);
+  CGF.EmitBlock(MasterBB);
+  {
+    CodeGenFunction::RunCleanupsScope Scope(CGF);
+    auto IPriv = Privates.begin();
+    auto ILHS = LHSExprs.begin();
+    auto IRHS = RHSExprs.begin();
+    for (auto *E : ReductionOps) {
+      emitSingleReductionCombiner(CGF, E, *IPriv, cast<DeclRefExpr>(*ILHS),
+                                  cast<DeclRefExpr>(*IRHS));
+      ++IPriv;
+      ++ILHS;
+      ++IRHS;
+    }
+  }
+  CGF.EmitBlock(DoneBB, /*IsFinished=*/true);
+  CGF.EmitNounwindRuntimeCall(CGM.getIntrinsic(llvm::Intrinsic::stackrestore),
+                              StackPtr);
+}
+
 /// Generates unique name for artificial threadprivate variables.
 /// Format is: <Prefix> "." <Loc_raw_encoding> "_" <N>
 static std::string generateUniqueName(StringRef Prefix, SourceLocation Loc,
@@ -6393,6 +7001,205 @@ static void getTargetEntryUniqueInfo(ASTContext &C, SourceLocation Loc,
   LineNum = PLoc.getLine();
 }
 
+/// Return true if an object of type \a Ty may hold the address of another
+/// object.
+static bool mayHoldAddress(const ASTContext &C, QualType Ty) {
+  Ty = C.getBaseElementType(Ty.getNonReferenceType());
+  return !Ty->isArithmeticType() && !Ty->isEnumeralType();
+}
+
+/// Return in [\a Lo, \a Lo + \a Len) the elements of the base array mapped by
+/// the component list \a Components, or false if they are not known at
+/// compile time.
+static bool getConstantMapExtent(
+    const ASTContext &C,
+    OMPClauseMappableExprCommon::MappableExprComponentListRef Components,
+    int64_t &Lo, int64_t &Len) {
+  if (Components.size() != 2)
+    return false;
+  const auto *ArrTy = C.getAsConstantArrayType(
+      Components.back().getAssociatedExpression()->getType());
+  if (!ArrTy)
+    return false;
+  llvm::APSInt Val;
+  const Expr *E = Components.front().getAssociatedExpression();
+  if (const auto *ASE = dyn_cast<ArraySubscriptExpr>(E)) {
+    if (!ASE->getIdx()->EvaluateAsInt(Val, C))
+      return false;
+    Lo = Val.getSExtValue();
+    Len = 1;
+    return true;
+  }
+  const auto *OASE = dyn_cast<OMPArraySectionExpr>(E);
+  if (!OASE)
+    return false;
+  Lo = 0;
+  if (const Expr *LB = OASE->getLowerBound()) {
+    if (!LB->EvaluateAsInt(Val, C))
+      return false;
+    Lo = Val.getSExtValue();
+  }
+  Len = ArrTy->getSize().getZExtValue() - Lo;
+  if (const Expr *Length = OASE->getLength()) {
+    if (!Length->EvaluateAsInt(Val, C))
+      return false;
+    Len = Val.getSExtValue();
+  }
+  return true;
+}
+
+namespace {
+/// Drops from a set of variables those that a statement may write or whose
+/// address it may take.  Only loads of the variables, possibly through array
+/// subscripts and member accesses, keep them in the set.
+class ReadOnlyUseChecker {
+  llvm::SmallPtrSetImpl<const VarDecl *> &Vars;
+
+  /// Return true if \a E designates a part of a variable in the set.
+  bool isLoadedVar(const Expr *E) {
+    E = E->IgnoreParens();
+    while (true) {
+      if (const auto *ASE = dyn_cast<ArraySubscriptExpr>(E)) {
+        visit(ASE->getIdx());
+        E = ASE->getBase()->IgnoreParenImpCasts();
+      } else if (const auto *ME = dyn_cast<MemberExpr>(E)) {
+        if (ME->isArrow())
+          return false;
+        E = ME->getBase()->IgnoreParens();
+      } else
+        break;
+    }
+    if (const auto *DRE = dyn_cast<DeclRefExpr>(E))
+      if (const auto *VD = dyn_cast<VarDecl>(DRE->getDecl()))
+        return Vars.count(VD->getCanonicalDecl());
+    return false;
+  }
+
+public:
+  explicit ReadOnlyUseChecker(llvm::SmallPtrSetImpl<const VarDecl *> &Vars)
+      : Vars(Vars) {}
+
+  void visit(const Stmt *S) {
+    if (!S)
+      return;
+    if (const auto *DRE = dyn_cast<DeclRefExpr>(S)) {
+      if (const auto *VD = dyn_cast<VarDecl>(DRE->getDecl()))
+        Vars.erase(VD->getCanonicalDecl());
+      return;
+    }
+    if (const auto *ICE = dyn_cast<ImplicitCastExpr>(S))
+      if (ICE->getCastKind() == CK_LValueToRValue &&
+          isLoadedVar(ICE->getSubExpr()))
+        return;
+    if (const auto *D = dyn_cast<OMPExecutableDirective>(S)) {
+      // Implicit and sharing clauses do not write their list items.
+      for (const OMPClause *C : D->clauses())
+        if (!C->isImplicit() && !isa<OMPSharedClause>(C) &&
+            !isa<OMPFirstprivateClause>(C))
+          for (const Stmt *Child : C->children())
+            visit(Child);
+      if (D->hasAssociatedStmt())
+        visit(D->getAssociatedStmt());
+      return;
+    }
+    for (const Stmt *Child : S->children())
+      visit(Child);
+  }
+};
+} // namespace
+
+/// Mark the parameters of the outlined target region \a Fn that are the only
+/// way for the region to reach their list items noalias, and readonly if the
+/// region only loads from them.  This is the case for local variables that
+/// cannot hold addresses and are mapped as a whole or in disjoint sections
+/// with constant bounds, if the region captures nothing else that may point
+/// to them.
+static void setNonAliasedMapParameters(const CodeGenModule &CGM,
+                                       const OMPExecutableDirective &D,
+                                       llvm::Function *Fn) {
+  const ASTContext &C = CGM.getContext();
+  struct MapExtents {
+    unsigned NumItems = 0;
+    bool AllConstant = true;
+    SmallVector<std::pair<int64_t, int64_t>, 2> Extents;
+  };
+  llvm::MapVector<const VarDecl *, MapExtents> Maps;
+  for (const auto *MC : D.getClausesOfKind<OMPMapClause>())
+    for (const auto &L : MC->component_lists()) {
+      const auto *VD = dyn_cast_or_null<VarDecl>(L.first);
+      if (!VD)
+        continue;
+      auto &ME = Maps[VD->getCanonicalDecl()];
+      ++ME.NumItems;
+      int64_t Lo, Len;
+      if (getConstantMapExtent(C, L.second, Lo, Len))
+        ME.Extents.push_back({Lo, Len});
+      else
+        ME.AllConstant = false;
+    }
+
+  llvm::SmallPtrSet<const VarDecl *, 8> Candidates;
+  for (const auto &P : Maps) {
+    if (!P.first->hasLocalStorage() || mayHoldAddress(C, P.first->getType()))
+      continue;
+    const MapExtents &ME = P.second;
+    bool Disjoint = ME.NumItems == 1 || ME.AllConstant;
+    for (unsigned I = 0, E = ME.Extents.size(); I < E && Disjoint; ++I)
+      for (unsigned J = I + 1; J < E && Disjoint; ++J) {
+        const auto &A = ME.Extents[I];
+        const auto &B = ME.Extents[J];
+        Disjoint = A.first + A.second <= B.first ||
+                   B.first + B.second <= A.first;
+      }
+    if (Disjoint)
+      Candidates.insert(P.first);
+  }
+  if (Candidates.empty())
+    return;
+
+  const auto *CS = cast<CapturedStmt>(D.getAssociatedStmt());
+  if (D.hasClausesOfKind<OMPDependClause>())
+    CS = cast<CapturedStmt>(CS->getCapturedStmt());
+
+  // Nothing else that the region captures may point into a list item.
+  for (const auto &Cap : CS->captures()) {
+    if (Cap.capturesThis())
+      return;
+    if (!Cap.capturesVariable() && !Cap.capturesVariableByCopy())
+      continue;
+    const VarDecl *VD = Cap.getCapturedVar();
+    if (!Candidates.count(VD->getCanonicalDecl()) &&
+        mayHoldAddress(C, VD->getType()))
+      return;
+  }
+
+  llvm::SmallPtrSet<const VarDecl *, 8> ReadOnly(Candidates.begin(),
+                                                 Candidates.end());
+  ReadOnlyUseChecker(ReadOnly).visit(CS->getCapturedStmt());
+
+  // The parameters follow the order of the captures of the region, see
+  // CodeGenFunction::GenerateOpenMPCapturedStmtParameters.
+  auto ArgIt = Fn->arg_begin();
+  for (const auto &Cap : CS->captures()) {
+    if (ArgIt == Fn->arg_end())
+      break;
+    const VarDecl *VD = nullptr;
+    if (Cap.capturesVariable() || Cap.capturesVariableByCopy()) {
+      VD = Cap.getCapturedVar()->getCanonicalDecl();
+      if (const auto *CED = dyn_cast<OMPCapturedExprDecl>(VD))
+        if (CED->getCaptureLevel() < 1)
+          continue;
+    }
+    llvm::Argument &Arg = *ArgIt++;
+    if (!VD || !Cap.capturesVariable() || !Arg.getType()->isPointerTy() ||
+        !Candidates.count(VD))
+      continue;
+    Arg.addAttr(llvm::Attribute::NoAlias);
+    if (ReadOnly.count(VD))
+      Arg.addAttr(llvm::Attribute::ReadOnly);
+  }
+}
+
 void CGOpenMPRuntime::emitTargetOutlinedFunction(
     const OMPExecutableDirective &D, StringRef ParentName,
     llvm::Function *&OutlinedFn, llvm::Constant *&OutlinedFnID,
@@ -6400,6 +7207,13 @@ void CGOpenMPRuntime::emitTargetOutlinedFunction(
     unsigned CaptureLevel) {
   assert(!ParentName.empty() && "Invalid target region parent name!");
 
+  // Remember the region body so that the functions it uses are kept for the
+  // device.
+  if (!CGM.getLangOpts().OpenMPIsDevice &&
+      CGM.getLangOpts().OpenMPImplicitDeclareTarget &&
+      CGM.getCodeGenOpts().OpenMPPruneImplicitDeclareTarget)
+    PendingDeviceCode.push_back(D.getAssociatedStmt());
+
   emitTargetOutlinedFunctionHelper(D, ParentName, OutlinedFn, OutlinedFnID,
                                    IsOffloadEntry, CodeGen, CaptureLevel);
 }
@@ -6457,6 +7271,7 @@ void CGOpenMPRuntime::emitTargetOutlinedFunctionHelper(
   }
 
   OutlinedFn = outlineTargetDirective(D, EntryFnName, CodeGen);
+  setNonAliasedMapParameters(CGM, D, OutlinedFn);
 
   // If this target outline function is not an offload entry, we don't need to
   // register it.
@@ -7071,6 +7886,23 @@ void CGOpenMPRuntime::emitTargetNumIterationsCall(
   }
 }
 
+/// Return true if the list items of the map clauses of \a D are accessed
+/// through their host addresses under -fopenmp-unified-memory. Variables with
+/// static storage keep their mapping, since the device has its own copy of
+/// the "declare target" variables.
+static bool isUnifiedMemoryDirective(CodeGenModule &CGM,
+                                     const OMPExecutableDirective &D) {
+  if (!CGM.getCodeGenOpts().OpenMPUnifiedMemory)
+    return false;
+  for (const auto *C : D.getClausesOfKind<OMPMapClause>())
+    for (auto L : C->component_lists()) {
+      const auto *VD = dyn_cast_or_null<VarDecl>(L.first);
+      if (VD && VD->hasGlobalStorage())
+        return false;
+    }
+  return true;
+}
+
 OMPMapArrays
 CGOpenMPRuntime::generateMapArrays(CodeGenFunction &CGF,
                                    const OMPExecutableDirective &D,
@@ -7225,6 +8057,21 @@ CGOpenMPRuntime::generateMapArrays(CodeGenFunction &CGF,
   Maps.Sizes.append(CurSizes.begin(), CurSizes.end());
   Maps.MapTypes.append(CurMapTypes.begin(), CurMapTypes.end());
 
+  // With unified memory the kernel arguments are valid on the device as they
+  // are: pass each of them as a literal so that the runtime library does not
+  // look them up in its mapping table, and drop the entries of the pointees.
+  if (isUnifiedMemoryDirective(CGM, D)) {
+    Maps.BasePointers.clear();
+    Maps.BasePointers.append(Maps.KernelArgs.begin(), Maps.KernelArgs.end());
+    Maps.Pointers = Maps.KernelArgs;
+    Maps.Sizes.assign(Maps.KernelArgs.size(),
+                      llvm::ConstantInt::get(CGM.SizeTy, /*V=*/0));
+    Maps.MapTypes.assign(Maps.KernelArgs.size(),
+                         MappableExprsHandler::OMP_MAP_LITERAL |
+                             MappableExprsHandler::OMP_MAP_TARGET_PARAM);
+    Maps.Lambdas.assign(Maps.KernelArgs.size(), nullptr);
+  }
+
   return Maps;
 }
 
@@ -7437,6 +8284,69 @@ void CGOpenMPRuntime::emitTaskCall(
   }
 }
 
+/// Kinds of the offloading calls reported to the profiler with
+/// -fopenmp-offload-profile.
+enum OpenMPOffloadProfileKind : unsigned {
+  /// Launch of a target region, including its data transfers.
+  OMP_PROFILE_TARGET = 0,
+  /// Opening of a data environment (target data, target enter data).
+  OMP_PROFILE_DATA_BEGIN = 1,
+  /// Closing of a data environment (target data, target exit data).
+  OMP_PROFILE_DATA_END = 2,
+  /// target update.
+  OMP_PROFILE_DATA_UPDATE = 3,
+};
+
+llvm::Value *CGOpenMPRuntime::emitOffloadProfileBegin(CodeGenFunction &CGF,
+                                                      SourceLocation Loc,
+                                                      StringRef Name,
+                                                      unsigned Kind,
+                                                      llvm::Value *DeviceID) {
+  if (!CGM.getCodeGenOpts().OpenMPOffloadProfile)
+    return nullptr;
+
+  // The site is reported with its location even without debug info, in the
+  // psource format of ident_t: ";<File>;<Function>;<Line>;<Column>;;".
+  SmallString<128> Buffer;
+  llvm::raw_svector_ostream OS(Buffer);
+  PresumedLoc PLoc = CGM.getContext().getSourceManager().getPresumedLoc(Loc);
+  OS << ";" << (PLoc.isValid() ? PLoc.getFilename() : "unknown") << ";";
+  if (const auto *FD = dyn_cast_or_null<FunctionDecl>(CGF.CurFuncDecl))
+    OS << FD->getQualifiedNameAsString();
+  OS << ";" << (PLoc.isValid() ? PLoc.getLine() : 0) << ";"
+     << (PLoc.isValid() ? PLoc.getColumn() : 0) << ";;";
+
+  // struct { char *name; char *psource; int32_t kind; };
+  llvm::Constant *SiteFields[] = {
+      llvm::ConstantExpr::getBitCast(
+          CGM.GetAddrOfConstantCString(Name).getPointer(), CGM.Int8PtrTy),
+      llvm::ConstantExpr::getBitCast(
+          CGM.GetAddrOfConstantCString(OS.str()).getPointer(), CGM.Int8PtrTy),
+      llvm::ConstantInt::get(CGM.Int32Ty, Kind)};
+  auto *SiteInit = llvm::ConstantStruct::getAnon(SiteFields);
+  auto *Site = new llvm::GlobalVariable(
+      CGM.getModule(), SiteInit->getType(), /*isConstant=*/true,
+      llvm::GlobalValue::PrivateLinkage, SiteInit, ".offload_profile_site");
+  Site->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+
+  llvm::Value *SiteArg =
+      CGF.Builder.CreatePointerBitCastOrAddrSpaceCast(Site, CGM.VoidPtrTy);
+  llvm::Value *Args[] = {SiteArg, DeviceID};
+  CGF.EmitRuntimeCall(createRuntimeFunction(OMPRTL__tgt_profile_begin), Args);
+  return SiteArg;
+}
+
+void CGOpenMPRuntime::emitOffloadProfileEnd(CodeGenFunction &CGF,
+                                            llvm::Value *Site,
+                                            llvm::Value *DeviceID,
+                                            llvm::Value *Ret) {
+  if (!Site)
+    return;
+  llvm::Value *Args[] = {Site, DeviceID,
+                         Ret ? Ret : CGF.Builder.getInt32(/*C=*/0)};
+  CGF.EmitRuntimeCall(createRuntimeFunction(OMPRTL__tgt_profile_end), Args);
+}
+
 void CGOpenMPRuntime::emitTargetCall(
     CodeGenFunction &CGF, const OMPExecutableDirective &D,
     llvm::Value *OutlinedFn, llvm::Value *OutlinedFnID, const Expr *IfCond,
@@ -7450,8 +8360,18 @@ void CGOpenMPRuntime::emitTargetCall(
   // Check if directive has nowait clause
   bool hasNowait = D.hasClausesOfKind<OMPNowaitClause>();
 
-  // Check if directive has depend clause
-  bool HasDepend = D.hasClausesOfKind<OMPDependClause>();
+  // A 'target nowait depend(...)' region is normally wrapped in a host task
+  // that resolves the dependences before launching the kernel. If requested,
+  // and the region is always offloaded, hand the dependences to the
+  // offloading runtime instead, together with the mapping of the region data.
+  // The launch and the release of the data then follow without a host task.
+  bool HasDeviceDepend = hasNowait && OutlinedFnID && !IfCond &&
+                         D.hasClausesOfKind<OMPDependClause>() &&
+                         CGM.getCodeGenOpts().OpenMPTargetNowaitDepend;
+
+  // Check if directive has depend clause that has to be resolved by a target
+  // task.
+  bool HasDepend = D.hasClausesOfKind<OMPDependClause>() && !HasDeviceDepend;
 
   // When calling a target task, we need to generate the offloading mapping
   // arrays upfront in the task caller and pass them to the task region.
@@ -7499,7 +8419,7 @@ void CGOpenMPRuntime::emitTargetCall(
 
   // Fill up the pointer arrays and transfer execution to the device.
   auto &&ThenGen = [this, Device, OutlinedFn, OutlinedFnID, &D, hasNowait,
-                    &MapArrays, HasDepend, &Data,
+                    &MapArrays, HasDepend, HasDeviceDepend, &Data,
                     &Info](CodeGenFunction &CGF, PrePostActionTy &) {
     auto &RT = CGF.CGM.getOpenMPRuntime();
 
@@ -7586,6 +8506,45 @@ void CGOpenMPRuntime::emitTargetCall(
     auto *NumTeams = emitNumTeamsClauseForTargetDirective(RT, CGF, D);
     auto *ThreadLimit = emitThreadLimitClauseForTargetDirective(RT, CGF, D);
 
+    // Map the data of the region once its dependences are resolved by the
+    // offloading runtime. The launch below finds all of it on the device.
+    llvm::SmallVector<DependenceType, 4> Dependences;
+    Address DependenciesArray = Address::invalid();
+    if (HasDeviceDepend) {
+      for (const auto *C : D.getClausesOfKind<OMPDependClause>())
+        for (auto *IRef : C->varlists())
+          Dependences.emplace_back(C->getDependencyKind(), IRef);
+      DependenciesArray = emitDependences(CGF, Dependences, RT.KmpDependInfoTy);
+      llvm::Value *DataBeginArgs[] = {
+          DeviceID,
+          PointerNum,
+          Info.BasePointersArray,
+          Info.PointersArray,
+          Info.SizesArray,
+          Info.MapTypesArray,
+          CGF.Builder.getInt32(Dependences.size()),
+          DependenciesArray.getPointer(),
+          CGF.Builder.getInt32(/*C=*/0),
+          llvm::ConstantPointerNull::get(CGF.VoidPtrTy)};
+      CGF.EmitRuntimeCall(
+          RT.createRuntimeFunction(OMPRTL__tgt_target_data_begin_nowait_depend),
+          DataBeginArgs);
+    }
+    // Release the data mapped above, copying back what the region produced.
+    auto &&EmitDataEnd = [&CGF, &RT, &Info, DeviceID,
+                          PointerNum](OpenMPRTLFunction RTLFn) {
+      llvm::Value *DataEndArgs[] = {
+          DeviceID,           PointerNum,      Info.BasePointersArray,
+          Info.PointersArray, Info.SizesArray, Info.MapTypesArray};
+      CGF.EmitRuntimeCall(RT.createRuntimeFunction(RTLFn), DataEndArgs);
+    };
+
+    // With -fopenmp-offload-profile the launch is reported under the name of
+    // its offload entry.
+    llvm::Value *ProfileSite =
+        RT.emitOffloadProfileBegin(CGF, D.getLocStart(), OutlinedFn->getName(),
+                                   OMP_PROFILE_TARGET, DeviceID);
+
     // If we have NumTeams defined this means that we have an enclosed teams
     // region. Therefore we also expect to have ThreadLimit defined. These two
     // values should be defined in the presence of a teams directive, regardless
@@ -7622,6 +8581,7 @@ void CGOpenMPRuntime::emitTargetCall(
         Return = CGF.EmitRuntimeCall(
             RT.createRuntimeFunction(OMPRTL__tgt_target), OffloadingArgs);
     }
+    RT.emitOffloadProfileEnd(CGF, ProfileSite, DeviceID, Return);
 
     // Check the error code and execute the host version if required.
     llvm::BasicBlock *OffloadFailedBlock =
@@ -7629,8 +8589,31 @@ void CGOpenMPRuntime::emitTargetCall(
     llvm::BasicBlock *OffloadContBlock =
         CGF.createBasicBlock("omp_offload.cont");
     llvm::Value *Failed = CGF.Builder.CreateIsNotNull(Return);
-    CGF.Builder.CreateCondBr(Failed, OffloadFailedBlock, OffloadContBlock);
+    if (HasDeviceDepend) {
+      llvm::BasicBlock *OffloadDoneBlock =
+          CGF.createBasicBlock("omp_offload.done");
+      CGF.Builder.CreateCondBr(Failed, OffloadFailedBlock, OffloadDoneBlock);
+      CGF.EmitBlock(OffloadDoneBlock);
+      EmitDataEnd(OMPRTL__tgt_target_data_end_nowait);
+      CGF.EmitBranch(OffloadContBlock);
+    } else
+      CGF.Builder.CreateCondBr(Failed, OffloadFailedBlock, OffloadContBlock);
     CGF.EmitBlock(OffloadFailedBlock);
+    if (HasDeviceDepend) {
+      // The host version runs in place, so it has to wait for the
+      // dependences the runtime was asked to resolve, and for the data to be
+      // back on the host.
+      llvm::Value *DepWaitArgs[] = {
+          RT.emitUpdateLocation(CGF, D.getLocStart()),
+          RT.getThreadID(CGF, D.getLocStart()),
+          CGF.Builder.getInt32(Dependences.size()),
+          DependenciesArray.getPointer(),
+          CGF.Builder.getInt32(/*C=*/0),
+          llvm::ConstantPointerNull::get(CGF.VoidPtrTy)};
+      CGF.EmitRuntimeCall(RT.createRuntimeFunction(OMPRTL__kmpc_omp_wait_deps),
+                          DepWaitArgs);
+      EmitDataEnd(OMPRTL__tgt_target_data_end);
+    }
     if (HasDepend) {
       const auto *PCS =
           cast<CapturedStmt>(D.getAssociatedStmt());
@@ -7730,6 +8713,254 @@ void CGOpenMPRuntime::emitTargetCall(
   }
 }
 
+void CGOpenMPRuntime::emitTargetTaskCall(CodeGenFunction &CGF,
+                                         const OMPExecutableDirective &D,
+                                         llvm::Value *OutlinedFn,
+                                         llvm::Value *OutlinedFnID,
+                                         llvm::Value *DeviceID,
+                                         llvm::Value *NumIterations,
+                                         OMPMapArrays &MapArrays) {
+  if (!CGF.HaveInsertPoint())
+    return;
+
+  assert(OutlinedFn && OutlinedFnID && "Invalid outlined function!");
+  auto &C = CGM.getContext();
+  SourceLocation Loc = D.getLocStart();
+
+  if (CGF.getLangOpts().OpenMPImplicitMapLambdas)
+    emitLambdaOffloadArgs(CGF, MapArrays);
+  TargetDataInfo Info = emitMapArrays(CGF, MapArrays);
+  unsigned NumPtrs = Info.NumberOfPtrs;
+  assert(isa<llvm::Constant>(Info.MapTypesArray) &&
+         "Expected a constant array of map types.");
+  auto *NumTeams = emitNumTeamsClauseForTargetDirective(*this, CGF, D);
+  auto *ThreadLimit = emitThreadLimitClauseForTargetDirective(*this, CGF, D);
+
+  // The arrays of the caller are filled up again by its next launch before
+  // the task runs, so the task gets its own copy of everything the launch
+  // needs:
+  // struct {
+  //   int64_t device_id;
+  //   uint64_t loop_tripcount;
+  //   void *args_base[n];
+  //   void *args[n];
+  //   size_t arg_sizes[n];
+  //   int32_t num_teams;
+  //   int32_t thread_limit;
+  //   <arguments of the host version>
+  // };
+  enum {
+    SharedsDeviceID,
+    SharedsNumIterations,
+    SharedsBasePointers,
+    SharedsPointers,
+    SharedsSizes,
+    SharedsNumTeams,
+    SharedsThreadLimit,
+    SharedsKernelArgs,
+  };
+  auto *PtrsTy = llvm::ArrayType::get(CGM.VoidPtrTy, NumPtrs);
+  auto *SizesTy = llvm::ArrayType::get(CGM.SizeTy, NumPtrs);
+  SmallVector<llvm::Type *, 16> FieldTys = {
+      CGM.Int64Ty, CGM.Int64Ty, PtrsTy,     PtrsTy,
+      SizesTy,     CGM.Int32Ty, CGM.Int32Ty};
+  for (auto *Arg : MapArrays.KernelArgs)
+    FieldTys.push_back(Arg->getType());
+  auto *SharedsTy =
+      llvm::StructType::create(FieldTys, "omp.target_task.shareds");
+  const auto &DL = CGM.getDataLayout();
+  const llvm::StructLayout *Layout = DL.getStructLayout(SharedsTy);
+  CharUnits SharedsAlign =
+      CharUnits::fromQuantity(DL.getABITypeAlignment(SharedsTy));
+  auto &&GetField = [Layout](CodeGenFunction &CGF, Address Shareds,
+                             unsigned I) {
+    return CGF.Builder.CreateStructGEP(
+        Shareds, I, CharUnits::fromQuantity(Layout->getElementOffset(I)));
+  };
+
+  auto KmpInt32Ty = C.getIntTypeForBitwidth(/*DestWidth=*/32, /*Signed=*/1);
+  // Build type kmp_routine_entry_t (if not built yet).
+  emitKmpRoutineEntryT(KmpInt32Ty);
+  // Build type kmp_task_t (if not built yet).
+  if (SavedKmpTaskTQTy.isNull()) {
+    SavedKmpTaskTQTy = C.getRecordType(createKmpTaskTRecordDecl(
+        CGM, D.getDirectiveKind(), KmpInt32Ty, KmpRoutineEntryPtrQTy));
+  }
+  QualType KmpTaskTPtrQTy = C.getPointerType(SavedKmpTaskTQTy);
+  auto *KmpTaskTQTyRD = cast<RecordDecl>(SavedKmpTaskTQTy->getAsTagDecl());
+  const FieldDecl *SharedsFD =
+      *std::next(KmpTaskTQTyRD->field_begin(), KmpTaskTShareds);
+
+  // Build kmp_int32 .omp_target_task_entry.(kmp_int32 gtid, kmp_task_t *tt),
+  // which launches the region and executes the host version if the launch
+  // fails.
+  FunctionArgList Args;
+  ImplicitParamDecl GtidArg(C, /*DC=*/nullptr, Loc, /*Id=*/nullptr, KmpInt32Ty,
+                            ImplicitParamDecl::Other);
+  ImplicitParamDecl TaskTypeArg(C, /*DC=*/nullptr, Loc, /*Id=*/nullptr,
+                                KmpTaskTPtrQTy.withRestrict(),
+                                ImplicitParamDecl::Other);
+  Args.push_back(&GtidArg);
+  Args.push_back(&TaskTypeArg);
+  auto &TaskEntryFnInfo =
+      CGM.getTypes().arrangeBuiltinFunctionDeclaration(KmpInt32Ty, Args);
+  auto *TaskEntryTy = CGM.getTypes().GetFunctionType(TaskEntryFnInfo);
+  auto *TaskEntry =
+      llvm::Function::Create(TaskEntryTy, llvm::GlobalValue::InternalLinkage,
+                             ".omp_target_task_entry.", &CGM.getModule());
+  CGM.SetInternalFunctionAttributes(/*D=*/nullptr, TaskEntry, TaskEntryFnInfo);
+  {
+    CodeGenFunction TaskCGF(CGM);
+    TaskCGF.StartFunction(GlobalDecl(), KmpInt32Ty, TaskEntry, TaskEntryFnInfo,
+                          Args, Loc, Loc);
+    CGBuilderTy &Bld = TaskCGF.Builder;
+    LValue TDBase = TaskCGF.EmitLoadOfPointerLValue(
+        TaskCGF.GetAddrOfLocalVar(&TaskTypeArg),
+        KmpTaskTPtrQTy->castAs<PointerType>());
+    Address Shareds(Bld.CreatePointerBitCastOrAddrSpaceCast(
+                        TaskCGF.EmitLoadOfScalar(
+                            TaskCGF.EmitLValueForField(TDBase, SharedsFD), Loc),
+                        SharedsTy->getPointerTo()),
+                    SharedsAlign);
+    auto &&Load = [&TaskCGF, &GetField, Shareds](unsigned I) {
+      return TaskCGF.Builder.CreateLoad(GetField(TaskCGF, Shareds, I));
+    };
+
+    llvm::Value *TaskDeviceID = Load(SharedsDeviceID);
+    if (NumIterations) {
+      llvm::Value *TripCountArgs[] = {TaskDeviceID,
+                                      Load(SharedsNumIterations)};
+      TaskCGF.EmitRuntimeCall(
+          createRuntimeFunction(OMPRTL__kmpc_push_target_tripcount),
+          TripCountArgs);
+    }
+
+    llvm::Value *BasePointersArray =
+        llvm::ConstantPointerNull::get(CGM.VoidPtrPtrTy);
+    llvm::Value *PointersArray =
+        llvm::ConstantPointerNull::get(CGM.VoidPtrPtrTy);
+    llvm::Value *SizesArray =
+        llvm::ConstantPointerNull::get(CGM.SizeTy->getPointerTo());
+    if (NumPtrs) {
+      BasePointersArray = Bld.CreateConstInBoundsGEP2_32(
+          PtrsTy, GetField(TaskCGF, Shareds, SharedsBasePointers).getPointer(),
+          /*Idx0=*/0, /*Idx1=*/0);
+      PointersArray = Bld.CreateConstInBoundsGEP2_32(
+          PtrsTy, GetField(TaskCGF, Shareds, SharedsPointers).getPointer(),
+          /*Idx0=*/0, /*Idx1=*/0);
+      SizesArray = Bld.CreateConstInBoundsGEP2_32(
+          SizesTy, GetField(TaskCGF, Shareds, SharedsSizes).getPointer(),
+          /*Idx0=*/0, /*Idx1=*/0);
+    }
+    SmallVector<llvm::Value *, 16> KernelArgs;
+    for (unsigned I = 0, E = MapArrays.KernelArgs.size(); I < E; ++I)
+      KernelArgs.push_back(Load(SharedsKernelArgs + I));
+
+    llvm::Value *ProfileSite =
+        emitOffloadProfileBegin(TaskCGF, Loc, OutlinedFn->getName(),
+                                OMP_PROFILE_TARGET, TaskDeviceID);
+    llvm::Value *PointerNum = Bld.getInt32(NumPtrs);
+    llvm::Value *Return;
+    if (NumTeams) {
+      llvm::Value *OffloadingArgs[] = {
+          TaskDeviceID,       OutlinedFnID,
+          PointerNum,         BasePointersArray,
+          PointersArray,      SizesArray,
+          Info.MapTypesArray, Load(SharedsNumTeams),
+          Load(SharedsThreadLimit)};
+      Return = TaskCGF.EmitRuntimeCall(
+          createRuntimeFunction(OMPRTL__tgt_target_teams_nowait),
+          OffloadingArgs);
+    } else {
+      llvm::Value *OffloadingArgs[] = {
+          TaskDeviceID,  OutlinedFnID, PointerNum,        BasePointersArray,
+          PointersArray, SizesArray,   Info.MapTypesArray};
+      Return = TaskCGF.EmitRuntimeCall(
+          createRuntimeFunction(OMPRTL__tgt_target_nowait), OffloadingArgs);
+    }
+    emitOffloadProfileEnd(TaskCGF, ProfileSite, TaskDeviceID, Return);
+
+    // Check the error code and execute the host version if required.
+    llvm::BasicBlock *OffloadFailedBlock =
+        TaskCGF.createBasicBlock("omp_offload.failed");
+    llvm::BasicBlock *OffloadContBlock =
+        TaskCGF.createBasicBlock("omp_offload.cont");
+    Bld.CreateCondBr(Bld.CreateIsNotNull(Return), OffloadFailedBlock,
+                     OffloadContBlock);
+    TaskCGF.EmitBlock(OffloadFailedBlock);
+    emitOutlinedFunctionCall(TaskCGF, Loc, OutlinedFn, KernelArgs);
+    TaskCGF.EmitBranch(OffloadContBlock);
+    TaskCGF.EmitBlock(OffloadContBlock, /*IsFinished=*/true);
+
+    TaskCGF.EmitStoreThroughLValue(
+        RValue::get(Bld.getInt32(/*C=*/0)),
+        TaskCGF.MakeAddrLValue(TaskCGF.ReturnValue, KmpInt32Ty));
+    TaskCGF.FinishFunction();
+  }
+
+  // Build call kmp_task_t * __kmpc_omp_target_task_alloc(ident_t *,
+  // kmp_int32 gtid, kmp_int32 flags, size_t sizeof_kmp_task_t,
+  // size_t sizeof_shareds, kmp_routine_entry_t *task_entry,
+  // kmp_int64 device_id) for a tied task.
+  llvm::Value *AllocArgs[] = {
+      emitUpdateLocation(CGF, Loc),
+      getThreadID(CGF, Loc),
+      CGF.Builder.getInt32(/*C=*/1),
+      CGF.getTypeSize(SavedKmpTaskTQTy),
+      CGM.getSize(CharUnits::fromQuantity(DL.getTypeAllocSize(SharedsTy))),
+      CGF.Builder.CreatePointerBitCastOrAddrSpaceCast(TaskEntry,
+                                                      KmpRoutineEntryPtrTy),
+      DeviceID};
+  llvm::Value *NewTask = CGF.EmitRuntimeCall(
+      createRuntimeFunction(OMPRTL__kmpc_tgt_target_task_alloc), AllocArgs);
+  LValue TDBase = CGF.MakeNaturalAlignAddrLValue(
+      CGF.Builder.CreatePointerBitCastOrAddrSpaceCast(
+          NewTask, CGF.ConvertTypeForMem(KmpTaskTPtrQTy)),
+      SavedKmpTaskTQTy);
+  Address Shareds(CGF.Builder.CreatePointerBitCastOrAddrSpaceCast(
+                      CGF.EmitLoadOfScalar(
+                          CGF.EmitLValueForField(TDBase, SharedsFD), Loc),
+                      SharedsTy->getPointerTo()),
+                  SharedsAlign);
+
+  // Fill up the shareds of the task.
+  CGF.Builder.CreateStore(DeviceID, GetField(CGF, Shareds, SharedsDeviceID));
+  if (NumIterations)
+    CGF.Builder.CreateStore(
+        CGF.Builder.CreateIntCast(NumIterations, CGM.Int64Ty,
+                                  /*isSigned=*/false),
+        GetField(CGF, Shareds, SharedsNumIterations));
+  if (NumPtrs) {
+    CGF.Builder.CreateMemCpy(
+        GetField(CGF, Shareds, SharedsBasePointers),
+        Address(Info.BasePointersArray, CGM.getPointerAlign()),
+        CGM.getSize(CGM.getPointerSize() * NumPtrs));
+    CGF.Builder.CreateMemCpy(
+        GetField(CGF, Shareds, SharedsPointers),
+        Address(Info.PointersArray, CGM.getPointerAlign()),
+        CGM.getSize(CGM.getPointerSize() * NumPtrs));
+    CGF.Builder.CreateMemCpy(GetField(CGF, Shareds, SharedsSizes),
+                             Address(Info.SizesArray, CGM.getSizeAlign()),
+                             CGM.getSize(CGM.getSizeSize() * NumPtrs));
+  }
+  if (NumTeams) {
+    assert(ThreadLimit && "Thread limit expression should be available along "
+                          "with number of teams.");
+    CGF.Builder.CreateStore(NumTeams, GetField(CGF, Shareds, SharedsNumTeams));
+    CGF.Builder.CreateStore(ThreadLimit,
+                            GetField(CGF, Shareds, SharedsThreadLimit));
+  }
+  for (unsigned I = 0, E = MapArrays.KernelArgs.size(); I < E; ++I)
+    CGF.Builder.CreateStore(MapArrays.KernelArgs[I],
+                            GetField(CGF, Shareds, SharedsKernelArgs + I));
+
+  // Build kmp_int32 __kmpc_omp_task(ident_t *, kmp_int32 gtid,
+  // kmp_task_t *new_task);
+  llvm::Value *TaskArgs[] = {emitUpdateLocation(CGF, Loc),
+                             getThreadID(CGF, Loc), NewTask};
+  CGF.EmitRuntimeCall(createRuntimeFunction(OMPRTL__kmpc_omp_task), TaskArgs);
+}
+
 /// \brief Return the declare target attribute if the declaration is marked as
 // 'declare target', i.e. the declaration itself, its template declaration, or
 /// any of its redeclarations have the 'declare target' attribute.
@@ -8426,6 +9657,26 @@ void MappableExprsHandler::generateInfoForCapture(
     return;
   }
 
+  // A mapped scalar that Sema decided to capture by copy (see
+  // -fopenmp-small-maps-by-value) travels in the argument list itself, so
+  // there is nothing to transfer.
+  if (VD && Cap->capturesVariableByCopy() &&
+      !VD->getType().getNonReferenceType()->isAnyPointerType()) {
+    bool IsMapped = llvm::any_of(
+        this->CurDir.getClausesOfKind<OMPMapClause>(),
+        [VD](const OMPMapClause *C) {
+          auto Lists = C->decl_component_lists(VD);
+          return Lists.begin() != Lists.end();
+        });
+    if (IsMapped) {
+      BasePointers.push_back({Arg, VD});
+      Pointers.push_back(Arg);
+      Sizes.push_back(CGF.getTypeSize(VD->getType().getNonReferenceType()));
+      Types.push_back(OMP_MAP_LITERAL | OMP_MAP_TARGET_PARAM);
+      return;
+    }
+  }
+
   // FIXME: MSVC 2013 seems to require this-> to find member CurDir.
   for (auto *C : this->CurDir.getClausesOfKind<OMPMapClause>())
     for (auto L : C->decl_component_lists(VD)) {
@@ -8615,11 +9866,15 @@ bool CGOpenMPRuntime::emitTargetFunctions(GlobalDecl GD) {
 
   // Emit this function normally if it is a device function, but still scan the
   // function in case it is marked as 'declare target'.
-  bool EmitNormally = !OffloadEntriesInfoManager.hasDeviceFunctionEntryInfo(
-      CGM.getMangledName(GD));
+  StringRef MangledName = CGM.getMangledName(GD);
+  bool EmitNormally =
+      !OffloadEntriesInfoManager.hasDeviceFunctionEntryInfo(MangledName);
 
-  // Try to detect target regions in the function.
-  scanForTargetRegionsFunctions(FD.getBody(), CGM.getMangledName(GD));
+  // Try to detect target regions in the function. Only the functions in which
+  // the host found some have to be scanned, which saves deserializing the
+  // bodies of all the others from an AST file.
+  if (OffloadEntriesInfoManager.hasTargetRegionEntriesInParent(MangledName))
+    scanForTargetRegionsFunctions(FD.getBody(), MangledName);
 
   // We should not emit any function other that the ones created during the
   // scanning. Therefore, we signal that this function is completely dealt
@@ -8639,13 +9894,15 @@ bool CGOpenMPRuntime::emitTargetGlobalVariable(GlobalDecl GD) {
     for (auto *Ctor : RD->ctors()) {
       StringRef ParentName =
           CGM.getMangledName(GlobalDecl(Ctor, Ctor_Complete));
-      scanForTargetRegionsFunctions(Ctor->getBody(), ParentName);
+      if (OffloadEntriesInfoManager.hasTargetRegionEntriesInParent(ParentName))
+        scanForTargetRegionsFunctions(Ctor->getBody(), ParentName);
     }
     auto *Dtor = RD->getDestructor();
     if (Dtor) {
       StringRef ParentName =
           CGM.getMangledName(GlobalDecl(Dtor, Dtor_Complete));
-      scanForTargetRegionsFunctions(Dtor->getBody(), ParentName);
+      if (OffloadEntriesInfoManager.hasTargetRegionEntriesInParent(ParentName))
+        scanForTargetRegionsFunctions(Dtor->getBody(), ParentName);
     }
   }
 
@@ -8690,6 +9947,27 @@ void CGOpenMPRuntime::registerCtorDtorEntry(unsigned DeviceID, unsigned FileID,
       IsDtor ? OMP_DECLARE_TARGET_DTOR : OMP_DECLARE_TARGET_CTOR);
 }
 
+// The initializers and destructors of all the declare target globals of a
+// compilation unit are run by a single pair of entries, so that loading and
+// unloading a device image launches two kernels rather than two per global.
+// The entries are identified by the main file of the compilation unit.
+static void getCtorDtorEntryUniqueInfo(ASTContext &C, unsigned &DeviceID,
+                                       unsigned &FileID, unsigned &Line) {
+  auto &SM = C.getSourceManager();
+  getTargetEntryUniqueInfo(C, SM.getLocForStartOfFile(SM.getMainFileID()),
+                           DeviceID, FileID, Line);
+}
+
+static void getCtorDtorEntryName(unsigned DeviceID, unsigned FileID,
+                                 bool IsDtor, SmallVectorImpl<char> &Name) {
+  llvm::raw_svector_ostream OS(Name);
+  OS << "__omp_offloading" << llvm::format("_%x", DeviceID)
+     << llvm::format("_%x_", FileID) << (IsDtor ? "dtor" : "init");
+}
+
+static const char *const CtorEntryParentName = "__omp_offloading_init";
+static const char *const DtorEntryParentName = "__omp_offloading_dtor";
+
 bool CGOpenMPRuntime::emitDeviceCtorDtor(const VarDecl &D,
                                          llvm::GlobalVariable *Addr,
                                          bool PerformInit) {
@@ -8697,83 +9975,117 @@ bool CGOpenMPRuntime::emitDeviceCtorDtor(const VarDecl &D,
   if (!CGM.getLangOpts().OpenMPIsDevice)
     return false;
 
-  // Produce the unique prefix to identify the new target regions. We use the
-  // source location of the variable declaration which we know to not conflict
-  // with any target region.
+  // If the host does not run the structors of this global, we don't have
+  // anything to do, but we return true to prevent the default initializer
+  // codegen.
   unsigned DeviceID;
   unsigned FileID;
   unsigned Line;
-  getTargetEntryUniqueInfo(CGM.getContext(), D.getLocStart(), DeviceID, FileID,
-                           Line);
-
-  // Check if we have a dtor target region specified by the host. The parent
-  // name is the name of the declaration with suffix _dtor and/or _init if that
-  // is a destructor or initializer target region.
-  SmallString<128> ParentNameDtor;
-  ParentNameDtor += "__omp_offloading_dtor_";
-  ParentNameDtor += D.getName();
-
-  // If we don't have a Dtor specified by the host, we don't have anything to
-  // do, but we return true to prevent the default initializer codegen.
-  if (!OffloadEntriesInfoManager.hasTargetRegionEntryInfo(DeviceID, FileID,
-                                                          ParentNameDtor, Line))
+  getCtorDtorEntryUniqueInfo(CGM.getContext(), DeviceID, FileID, Line);
+  auto *Attr = IsDeclareTargetDeclaration(&D);
+  if (!Attr || Attr->getMapType() == OMPDeclareTargetDeclAttr::MT_Link ||
+      !OffloadEntriesInfoManager.hasTargetRegionEntryInfo(
+          DeviceID, FileID, DtorEntryParentName, Line))
     return true;
 
-  auto &Ctx = CGM.getContext();
+  unsigned VarDeviceID;
+  unsigned VarFileID;
+  unsigned VarLine;
+  getTargetEntryUniqueInfo(CGM.getContext(), D.getLocStart(), VarDeviceID,
+                           VarFileID, VarLine);
   SmallString<64> PrefixName;
   {
     llvm::raw_svector_ostream OS(PrefixName);
-    OS << "__omp_offloading" << llvm::format("_%x", DeviceID)
-       << llvm::format("_%x_", FileID) << D.getName() << "_l" << Line;
+    OS << "__omp_offloading" << llvm::format("_%x", VarDeviceID)
+       << llvm::format("_%x_", VarFileID) << D.getName() << "_l" << VarLine;
   }
 
+  auto &Ctx = CGM.getContext();
+  auto &FnInfo =
+      CGM.getTypes().arrangeBuiltinFunctionDeclaration(Ctx.VoidTy, None);
+  auto *FnTy = CGM.getTypes().GetFunctionType(FnInfo);
+  unsigned Priority = 65535;
+  if (const auto *IPA = D.getAttr<InitPriorityAttr>())
+    Priority = IPA->getPriority();
+
   // If we need to perform an initialization, we need to create a function that
-  // calls the initializer as entry point.
+  // calls the initializer, to be called by the initializer entry.
   if (PerformInit) {
-    SmallString<128> ParentNameInit;
-    ParentNameInit += "__omp_offloading_init_";
-    ParentNameInit += D.getName();
-
     assert(OffloadEntriesInfoManager.hasTargetRegionEntryInfo(
-               DeviceID, FileID, ParentNameInit, Line) &&
+               DeviceID, FileID, CtorEntryParentName, Line) &&
            "Expecting initializer to be defined by the OpenMP host!");
 
-    auto &FnInfo =
-        CGM.getTypes().arrangeBuiltinFunctionDeclaration(Ctx.VoidTy, None);
-    auto *FnTy = CGM.getTypes().GetFunctionType(FnInfo);
     auto *Fn =
-        llvm::Function::Create(FnTy, llvm::GlobalValue::ExternalLinkage,
+        llvm::Function::Create(FnTy, llvm::GlobalValue::InternalLinkage,
                                Twine(PrefixName) + "_init", &CGM.getModule());
     CGM.SetLLVMFunctionAttributes(/*D=*/nullptr, FnInfo, Fn);
     CodeGenFunction(CGM).GenerateCXXGlobalVarDeclInitFunc(
         Fn, &D, Addr, /*PerformInit=*/true, /*emitInitOnly=*/true);
-
-    // Register the information for the entry associated with this target
-    // region.
-    registerCtorDtorEntry(DeviceID, FileID, ParentNameInit, Line, Fn,
-                          /*IsDtor=*/false);
+    DeviceGlobalCtors.push_back(std::make_pair(Priority, Fn));
   }
 
-  // Create the target region for the destructor.
-  auto &FnInfo =
-      CGM.getTypes().arrangeBuiltinFunctionDeclaration(Ctx.VoidTy, None);
-  auto *FnTy = CGM.getTypes().GetFunctionType(FnInfo);
+  // Create the function for the destructor.
   auto *Fn =
-      llvm::Function::Create(FnTy, llvm::GlobalValue::ExternalLinkage,
+      llvm::Function::Create(FnTy, llvm::GlobalValue::InternalLinkage,
                              Twine(PrefixName) + "_dtor", &CGM.getModule());
   CGM.SetLLVMFunctionAttributes(/*D=*/nullptr, FnInfo, Fn);
   CodeGenFunction(CGM).GenerateCXXGlobalVarDeclInitFunc(
       Fn, &D, Addr, PerformInit, /*emitInitOnly=*/false, /*emitDtorOnly=*/true);
+  DeviceGlobalDtors.push_back(std::make_pair(Priority, Fn));
 
-  // Register the information for the entry associated with this target region.
-  registerCtorDtorEntry(DeviceID, FileID, ParentNameDtor, Line, Fn,
-                        /*IsDtor=*/true);
-
-  // We successfully generated the target regions to initialize and destroy the
+  // We successfully generated the functions to initialize and destroy the
   // global.
   return true;
 }
 
+void CGOpenMPRuntime::emitDeviceCtorDtorEntries() {
+  if (DeviceGlobalDtors.empty())
+    return;
+
+  unsigned DeviceID;
+  unsigned FileID;
+  unsigned Line;
+  getCtorDtorEntryUniqueInfo(CGM.getContext(), DeviceID, FileID, Line);
+  auto &FnInfo = CGM.getTypes().arrangeBuiltinFunctionDeclaration(
+      CGM.getContext().VoidTy, None);
+  auto *FnTy = CGM.getTypes().GetFunctionType(FnInfo);
+  auto &&EmitEntry = [this, DeviceID, FileID, Line, &FnInfo, FnTy](
+      ArrayRef<std::pair<unsigned, llvm::Function *>> Fns, bool IsDtor) {
+    SmallString<64> Name;
+    getCtorDtorEntryName(DeviceID, FileID, IsDtor, Name);
+    auto *Fn = llvm::Function::Create(FnTy, llvm::GlobalValue::ExternalLinkage,
+                                      Name, &CGM.getModule());
+    CGM.SetLLVMFunctionAttributes(/*D=*/nullptr, FnInfo, Fn);
+    CodeGenFunction CGF(CGM);
+    CGF.StartFunction(GlobalDecl(), CGM.getContext().VoidTy, Fn, FnInfo,
+                      FunctionArgList());
+    for (const auto &P : Fns)
+      CGF.EmitRuntimeCall(P.second);
+    CGF.FinishFunction();
+    registerCtorDtorEntry(
+        DeviceID, FileID, IsDtor ? DtorEntryParentName : CtorEntryParentName,
+        Line, Fn, IsDtor);
+  };
+
+  // Globals are initialized in the order of their priorities and, for the
+  // same priority, in the order of their definitions.  They are destroyed in
+  // the reverse order.
+  auto &&ByPriority = [](const std::pair<unsigned, llvm::Function *> &LHS,
+                         const std::pair<unsigned, llvm::Function *> &RHS) {
+    return LHS.first < RHS.first;
+  };
+  std::stable_sort(DeviceGlobalCtors.begin(), DeviceGlobalCtors.end(),
+                   ByPriority);
+  std::stable_sort(DeviceGlobalDtors.begin(), DeviceGlobalDtors.end(),
+                   ByPriority);
+  std::reverse(DeviceGlobalDtors.begin(), DeviceGlobalDtors.end());
+  if (!DeviceGlobalCtors.empty())
+    EmitEntry(DeviceGlobalCtors, /*IsDtor=*/false);
+  EmitEntry(DeviceGlobalDtors, /*IsDtor=*/true);
+  DeviceGlobalCtors.clear();
+  DeviceGlobalDtors.clear();
+}
+
 void CGOpenMPRuntime::registerDeviceCtorDtorLaunching(
     CodeGenFunction &CGF, const VarDecl &D, llvm::GlobalVariable *Addr,
     bool PerformInit) {
@@ -8845,81 +10157,18 @@ void CGOpenMPRuntime::registerGlobalReplacement(StringRef MangledName,
 }
 
 llvm::Function *CGOpenMPRuntime::emitRegistrationFunction() {
-  auto &Ctx = CGM.getContext();
+  // The device emits the entries that run the structors of its globals.
+  if (CGM.getLangOpts().OpenMPIsDevice)
+    emitDeviceCtorDtorEntries();
 
   // Figure out all the declare target data that should be registered as such.
+  bool RequiresCtors = false;
+  bool RequiresDtors = false;
   for (auto II = DeclareTargetEntryInfoMap.begin(),
             IE = DeclareTargetEntryInfoMap.end();
        II != IE; ++II) {
     DeclareTargetEntryInfo &Info = II->second;
 
-    // Utility function to register the Ctors/Dtors.
-    auto &&RegisterCtorDtor = [&Info, &Ctx, this]() {
-      const VarDecl &D = *cast<VarDecl>(Info.Variable);
-      llvm::Constant *Addr = Info.VariableAddr;
-      assert(Addr && "declaration address is not defined??");
-
-      // Produce the unique prefix to identify the new target regions. We use
-      // the source location of the variable declaration which we know to not
-      // conflict with any target region.
-      unsigned DeviceID;
-      unsigned FileID;
-      unsigned Line;
-      getTargetEntryUniqueInfo(CGM.getContext(), D.getLocStart(), DeviceID,
-                               FileID, Line);
-      SmallString<64> PrefixName;
-      {
-        llvm::raw_svector_ostream OS(PrefixName);
-        OS << "__omp_offloading" << llvm::format("_%x", DeviceID)
-           << llvm::format("_%x_", FileID) << D.getName() << "_l" << Line;
-      }
-
-      // If we have to perform an initialization, create a target region to
-      // launch that on the device.
-      if (Info.PerformInitialization) {
-        // Produce an ID whose address uniquely identifies the target region.
-        auto ID = new llvm::GlobalVariable(
-            CGM.getModule(), CGM.Int8Ty, /*isConstant=*/true,
-            llvm::GlobalValue::PrivateLinkage,
-            llvm::Constant::getNullValue(CGM.Int8Ty),
-            Twine(PrefixName) + "_init");
-
-        // We define the parent name of this target region as the name of the
-        // global
-        // followed by the suffix _init. This suffix is what distinguishes a
-        // initializer from the destructor.
-        SmallString<128> ParentName;
-        ParentName += "__omp_offloading_init_";
-        ParentName += D.getName();
-
-        // Register the information for the entry associated with this target
-        // region.
-        OffloadEntriesInfoManager.registerTargetRegionEntryInfo(
-            DeviceID, FileID, ParentName, Line, ID, ID,
-            OMP_DECLARE_TARGET_CTOR);
-      }
-
-      // Produce an ID whose address uniquely identifies the target dtor.
-      auto ID = new llvm::GlobalVariable(
-          CGM.getModule(), CGM.Int8Ty, /*isConstant=*/true,
-          llvm::GlobalValue::PrivateLinkage,
-          llvm::Constant::getNullValue(CGM.Int8Ty),
-          Twine(PrefixName) + "_dtor");
-
-      // We define the parent name of this target region as the name of
-      // the global followed by the suffix _dtor. This suffix is what
-      // distinguishes a initializer from the destructor.
-      SmallString<128> ParentName;
-      ParentName += "__omp_offloading_dtor_";
-      ParentName += D.getName();
-
-      // Register the information for the entry associated with this
-      // target
-      // region.
-      OffloadEntriesInfoManager.registerTargetRegionEntryInfo(
-          DeviceID, FileID, ParentName, Line, ID, ID, OMP_DECLARE_TARGET_DTOR);
-    };
-
     // If we have a variable, register it and register any ctors/dtors entries.
     if (auto *D = dyn_cast<VarDecl>(Info.Variable)) {
       assert(Info.VariableAddr && "No variable address defined??");
@@ -8948,9 +10197,11 @@ llvm::Function *CGOpenMPRuntime::emitRegistrationFunction() {
               II->first(), Info.VariableAddr, D->getType(), 0,
               D->isExternallyVisible());
 
-          // Emit the ctor/dtor launching if required.
-          if (Info.RequiresCtorDtor)
-            RegisterCtorDtor();
+          // Record the ctor/dtor launching if required.
+          if (Info.RequiresCtorDtor) {
+            RequiresDtors = true;
+            RequiresCtors |= Info.PerformInitialization;
+          }
         }
       }
       continue;
@@ -8964,6 +10215,32 @@ llvm::Function *CGOpenMPRuntime::emitRegistrationFunction() {
     OffloadEntriesInfoManager.registerDeviceFunctionEntryInfo(II->first());
   }
 
+  // Launch the initializers and the destructors of all the globals that
+  // require them at once. The device runs them in the order of their
+  // priorities.
+  if (RequiresDtors) {
+    unsigned DeviceID;
+    unsigned FileID;
+    unsigned Line;
+    getCtorDtorEntryUniqueInfo(CGM.getContext(), DeviceID, FileID, Line);
+    auto &&RegisterEntry = [this, DeviceID, FileID, Line](bool IsDtor) {
+      // Produce an ID whose address uniquely identifies the target region.
+      SmallString<64> Name;
+      getCtorDtorEntryName(DeviceID, FileID, IsDtor, Name);
+      auto *ID = new llvm::GlobalVariable(
+          CGM.getModule(), CGM.Int8Ty, /*isConstant=*/true,
+          llvm::GlobalValue::PrivateLinkage,
+          llvm::Constant::getNullValue(CGM.Int8Ty), Name);
+      OffloadEntriesInfoManager.registerTargetRegionEntryInfo(
+          DeviceID, FileID, IsDtor ? DtorEntryParentName : CtorEntryParentName,
+          Line, ID, ID,
+          IsDtor ? OMP_DECLARE_TARGET_DTOR : OMP_DECLARE_TARGET_CTOR);
+    };
+    if (RequiresCtors)
+      RegisterEntry(/*IsDtor=*/false);
+    RegisterEntry(/*IsDtor=*/true);
+  }
+
   // If we have offloading in the current module, we need to emit the entries
   // now and register the offloading descriptor.
   createOffloadEntriesAndInfoMetadata();
@@ -9132,6 +10409,14 @@ void CGOpenMPRuntime::emitTargetDataCalls(
   // off.
   PrePostActionTy NoPrivAction;
 
+  // With unified memory there is nothing to map, and the device addresses of
+  // the 'use_device_ptr' list items are their host addresses.
+  if (isUnifiedMemoryDirective(CGM, D)) {
+    CodeGen.setAction(NoPrivAction);
+    CodeGen(CGF);
+    return;
+  }
+
   // Generate the code for the opening of the data environment. Capture all the
   // arguments of the runtime call by reference because they are used in the
   // closing of the region.
@@ -9181,8 +10466,12 @@ void CGOpenMPRuntime::emitTargetDataCalls(
         DeviceID,         PointerNum,    BasePointersArrayArg,
         PointersArrayArg, SizesArrayArg, MapTypesArrayArg};
     auto &RT = CGF.CGM.getOpenMPRuntime();
+    llvm::Value *ProfileSite = RT.emitOffloadProfileBegin(
+        CGF, D.getLocStart(), getOpenMPDirectiveName(D.getDirectiveKind()),
+        OMP_PROFILE_DATA_BEGIN, DeviceID);
     CGF.EmitRuntimeCall(RT.createRuntimeFunction(OMPRTL__tgt_target_data_begin),
                         OffloadingArgs);
+    RT.emitOffloadProfileEnd(CGF, ProfileSite, DeviceID, /*Ret=*/nullptr);
 
 
     // If device pointer privatization is required, emit the body of the region
@@ -9192,7 +10481,8 @@ void CGOpenMPRuntime::emitTargetDataCalls(
   };
 
   // Generate code for the closing of the data region.
-  auto &&EndThenGen = [Device, &Info](CodeGenFunction &CGF, PrePostActionTy &) {
+  auto &&EndThenGen = [&D, Device, &Info](CodeGenFunction &CGF,
+                                          PrePostActionTy &) {
     assert(Info.isValid() && "Invalid data environment closing arguments.");
 
     llvm::Value *BasePointersArrayArg = nullptr;
@@ -9217,8 +10507,12 @@ void CGOpenMPRuntime::emitTargetDataCalls(
         DeviceID,         PointerNum,    BasePointersArrayArg,
         PointersArrayArg, SizesArrayArg, MapTypesArrayArg};
     auto &RT = CGF.CGM.getOpenMPRuntime();
+    llvm::Value *ProfileSite = RT.emitOffloadProfileBegin(
+        CGF, D.getLocEnd(), getOpenMPDirectiveName(D.getDirectiveKind()),
+        OMP_PROFILE_DATA_END, DeviceID);
     CGF.EmitRuntimeCall(RT.createRuntimeFunction(OMPRTL__tgt_target_data_end),
                         OffloadingArgs);
+    RT.emitOffloadProfileEnd(CGF, ProfileSite, DeviceID, /*Ret=*/nullptr);
   };
 
   // If we need device pointer privatization, we need to emit the body of the
@@ -9269,6 +10563,10 @@ void CGOpenMPRuntime::emitTargetDataStandAloneCall(
           isa<OMPTargetUpdateDirective>(D)) &&
          "Expecting either target enter, exit data, or update directives.");
 
+  // The host and the devices share the list items: there is nothing to move.
+  if (isUnifiedMemoryDirective(CGM, D))
+    return;
+
   // Generate the code for the opening of the data environment.
   auto &&ThenGen = [&D, Device](CodeGenFunction &CGF, PrePostActionTy &) {
     // Fill up the arrays with all the mapped variables.
@@ -9316,6 +10614,7 @@ void CGOpenMPRuntime::emitTargetDataStandAloneCall(
     // Select the right runtime function call for each expected standalone
     // directive.
     OpenMPRTLFunction RTLFn;
+    unsigned ProfileKind;
     // Check if directive has nowait clause
     bool hasNowait = D.hasClausesOfKind<OMPNowaitClause>();
     bool HasDepend = D.hasClausesOfKind<OMPDependClause>();
@@ -9324,6 +10623,7 @@ void CGOpenMPRuntime::emitTargetDataStandAloneCall(
       llvm_unreachable("Unexpected standalone target data directive.");
       break;
     case OMPD_target_enter_data:
+      ProfileKind = OMP_PROFILE_DATA_BEGIN;
       if (hasNowait) {
         if (HasDepend)
           RTLFn = OMPRTL__tgt_target_data_begin_nowait_depend;
@@ -9337,6 +10637,7 @@ void CGOpenMPRuntime::emitTargetDataStandAloneCall(
       }
       break;
     case OMPD_target_exit_data:
+      ProfileKind = OMP_PROFILE_DATA_END;
       if (hasNowait) {
         if (HasDepend)
           RTLFn = OMPRTL__tgt_target_data_end_nowait_depend;
@@ -9350,6 +10651,7 @@ void CGOpenMPRuntime::emitTargetDataStandAloneCall(
       }
       break;
     case OMPD_target_update:
+      ProfileKind = OMP_PROFILE_DATA_UPDATE;
       if (hasNowait) {
         if (HasDepend)
           RTLFn = OMPRTL__tgt_target_data_update_nowait_depend;
@@ -9382,7 +10684,11 @@ void CGOpenMPRuntime::emitTargetDataStandAloneCall(
       // List of non-aliasing dependences.
       Args.emplace_back(llvm::ConstantPointerNull::get(CGF.VoidPtrTy));
     }
+    llvm::Value *ProfileSite = RT.emitOffloadProfileBegin(
+        CGF, D.getLocStart(), getOpenMPDirectiveName(D.getDirectiveKind()),
+        ProfileKind, DeviceID);
     CGF.EmitRuntimeCall(RT.createRuntimeFunction(RTLFn), Args);
+    RT.emitOffloadProfileEnd(CGF, ProfileSite, DeviceID, /*Ret=*/nullptr);
   };
 
   // In the event we get an if clause, we don't have to take any action on the
@@ -9460,27 +10766,43 @@ static unsigned evaluateCDTSize(const FunctionDecl *FD,
   return C.getTypeSize(CDT);
 }
 
+/// Records that the vectorizer may replace the calls to \a Fn in vectorized
+/// loops by calls to its vector variant \a VariantName of length \a VLEN.
+static void addDeclareSimdCall(CodeGenModule &CGM, llvm::Function *Fn,
+                               StringRef VariantName, unsigned VLEN) {
+  auto &Ctx = CGM.getLLVMContext();
+  llvm::Metadata *Ops[] = {
+      llvm::ValueAsMetadata::get(Fn), llvm::MDString::get(Ctx, Fn->getName()),
+      llvm::MDString::get(Ctx, VariantName),
+      llvm::ConstantAsMetadata::get(
+          llvm::ConstantInt::get(CGM.Int32Ty, VLEN))};
+  CGM.getModule()
+      .getOrInsertNamedMetadata("omp.declare_simd.calls")
+      ->addOperand(llvm::MDNode::get(Ctx, Ops));
+}
+
 static void
-emitX86DeclareSimdFunction(const FunctionDecl *FD, llvm::Function *Fn,
-                           const llvm::APSInt &VLENVal,
+emitX86DeclareSimdFunction(CodeGenModule &CGM, const FunctionDecl *FD,
+                           llvm::Function *Fn, const llvm::APSInt &VLENVal,
                            ArrayRef<ParamAttrTy> ParamAttrs,
                            OMPDeclareSimdDeclAttr::BranchStateTy State) {
   struct ISADataTy {
     char ISA;
     unsigned VecRegSize;
+    const char *Feature;
   };
   ISADataTy ISAData[] = {
       {
-          'b', 128
+          'b', 128, "sse2"
       }, // SSE
       {
-          'c', 256
+          'c', 256, "avx"
       }, // AVX
       {
-          'd', 256
+          'd', 256, "avx2"
       }, // AVX2
       {
-          'e', 512
+          'e', 512, "avx512f"
       }, // AVX512
   };
   llvm::SmallVector<char, 2> Masked;
@@ -9496,16 +10818,28 @@ emitX86DeclareSimdFunction(const FunctionDecl *FD, llvm::Function *Fn,
     Masked.push_back('M');
     break;
   }
+  // The vectorizer can only call the unmasked variants whose parameters are
+  // all vectors.
+  bool IsVectorizable =
+      CGM.getCodeGenOpts().OpenMPDeclareSimdCalls &&
+      std::all_of(ParamAttrs.begin(), ParamAttrs.end(),
+                  [](const ParamAttrTy &ParamAttr) {
+                    return ParamAttr.Kind == Vector && !ParamAttr.Alignment;
+                  });
+  llvm::SmallDenseSet<unsigned, 4> VectorizableVLENs;
   for (auto Mask : Masked) {
-    for (auto &Data : ISAData) {
+    // Visit the widest ISA first, so that the variant that is called for a
+    // given vector length is the one of the widest ISA of the target.
+    for (auto &Data : llvm::reverse(ISAData)) {
       SmallString<256> Buffer;
       llvm::raw_svector_ostream Out(Buffer);
       Out << "_ZGV" << Data.ISA << Mask;
-      if (!VLENVal) {
-        Out << llvm::APSInt::getUnsigned(Data.VecRegSize /
-                                         evaluateCDTSize(FD, ParamAttrs));
-      } else
-        Out << VLENVal;
+      unsigned VLEN;
+      if (!VLENVal)
+        VLEN = Data.VecRegSize / evaluateCDTSize(FD, ParamAttrs);
+      else
+        VLEN = VLENVal.getZExtValue();
+      Out << VLEN;
       for (auto &ParamAttr : ParamAttrs) {
         switch (ParamAttr.Kind){
         case LinearWithVarStride:
@@ -9528,6 +10862,10 @@ emitX86DeclareSimdFunction(const FunctionDecl *FD, llvm::Function *Fn,
       }
       Out << '_' << Fn->getName();
       Fn->addFnAttr(Out.str());
+      if (IsVectorizable && Mask == 'N' &&
+          CGM.getTarget().hasFeature(Data.Feature) &&
+          VectorizableVLENs.insert(VLEN).second)
+        addDeclareSimdCall(CGM, Fn, Out.str(), VLEN);
     }
   }
 }
@@ -9618,12 +10956,13 @@ void CGOpenMPRuntime::emitDeclareSimdFunction(const FunctionDecl *FD,
     OMPDeclareSimdDeclAttr::BranchStateTy State = Attr->getBranchState();
     if (CGM.getTriple().getArch() == llvm::Triple::x86 ||
         CGM.getTriple().getArch() == llvm::Triple::x86_64)
-      emitX86DeclareSimdFunction(FD, Fn, VLENVal, ParamAttrs, State);
+      emitX86DeclareSimdFunction(CGM, FD, Fn, VLENVal, ParamAttrs, State);
   }
 }
 
-StringRef CGOpenMPRuntime::RenameStandardFunction(StringRef name) {
-  return name;
+StringRef CGOpenMPRuntime::RenameStandardFunction(StringRef Name,
+                                                  const FunctionDecl *FD) {
+  return Name;
 }
 
 namespace {
@@ -9685,6 +11024,11 @@ void CGOpenMPRuntime::emitDoacrossInit(CodeGenFunction &CGF,
   llvm::Value *NumIterVal = CGF.EmitScalarConversion(
       CGF.EmitScalarExpr(D.getNumIterations()), D.getNumIterations()->getType(),
       Int64Ty, D.getNumIterations()->getExprLoc());
+  // The runtime tracks the tiles of a loop posted per tile.
+  if (CGF.OMPDoacrossTiledLoop == &D)
+    NumIterVal = CGF.Builder.CreateSDiv(
+        NumIterVal,
+        CGF.Builder.getInt64(CGM.getCodeGenOpts().OpenMPDoacrossTileSize));
   CGF.EmitStoreOfScalar(NumIterVal, UpperLVal);
   // dims.stride = 1;
   LValue StrideLVal =
@@ -9718,6 +11062,10 @@ void CGOpenMPRuntime::emitDoacrossOrdered(CodeGenFunction &CGF,
   llvm::Value *CntVal = CGF.EmitScalarConversion(CGF.EmitScalarExpr(CounterVal),
                                                  CounterVal->getType(), Int64Ty,
                                                  CounterVal->getExprLoc());
+  if (const OMPLoopDirective *D = CGF.OMPDoacrossTiledLoop) {
+    emitTiledDoacrossOrdered(CGF, *D, C, CntVal);
+    return;
+  }
   Address CntAddr = CGF.CreateMemTemp(Int64Ty, ".cnt.addr");
   CGF.EmitStoreOfScalar(CntVal, CntAddr, /*Volatile=*/false, Int64Ty);
   llvm::Value *Args[] = {emitUpdateLocation(CGF, C->getLocStart()),
@@ -9733,13 +11081,208 @@ void CGOpenMPRuntime::emitDoacrossOrdered(CodeGenFunction &CGF,
   CGF.EmitRuntimeCall(RTLFn, Args);
 }
 
+void CGOpenMPRuntime::emitTiledDoacrossOrdered(CodeGenFunction &CGF,
+                                               const OMPLoopDirective &D,
+                                               const OMPDependClause *C,
+                                               llvm::Value *CntVal) {
+  QualType Int64Ty =
+      CGM.getContext().getIntTypeForBitwidth(/*DestWidth=*/64, /*Signed=*/1);
+  SourceLocation Loc = C->getLocStart();
+  auto &&LoadAsInt64 = [&CGF, Int64Ty, Loc](const Expr *E) {
+    return CGF.EmitScalarConversion(
+        CGF.EmitLoadOfScalar(CGF.EmitLValue(E), Loc), E->getType(), Int64Ty,
+        Loc);
+  };
+  // The runtime tracks the tiles of the iterations, and all the iterations of
+  // a tile are executed by the same thread.
+  llvm::Value *TileSize =
+      CGF.Builder.getInt64(CGM.getCodeGenOpts().OpenMPDoacrossTileSize);
+  llvm::Value *Tile = CGF.Builder.CreateSDiv(CntVal, TileSize);
+  Address TileAddr = CGF.CreateMemTemp(Int64Ty, ".tile.addr");
+  CGF.EmitStoreOfScalar(Tile, TileAddr, /*Volatile=*/false, Int64Ty);
+  llvm::Value *Args[] = {emitUpdateLocation(CGF, Loc), getThreadID(CGF, Loc),
+                         TileAddr.getPointer()};
+  auto *ContBB = CGF.createBasicBlock("omp.doacross.cont");
+  if (C->getDependencyKind() == OMPC_DEPEND_source) {
+    // Post the tile after its last iteration, or after the last iteration of
+    // the chunk for the last tile of the loop.
+    llvm::Value *UB = LoadAsInt64(D.getUpperBoundVariable());
+    llvm::Value *IsTileEnd = CGF.Builder.CreateOr(
+        CGF.Builder.CreateICmpEQ(
+            CGF.Builder.CreateSRem(CntVal, TileSize),
+            CGF.Builder.CreateNSWSub(TileSize, CGF.Builder.getInt64(1))),
+        CGF.Builder.CreateICmpSGE(CntVal, UB));
+    auto *PostBB = CGF.createBasicBlock("omp.doacross.post");
+    CGF.Builder.CreateCondBr(IsTileEnd, PostBB, ContBB);
+    CGF.EmitBlock(PostBB);
+    CGF.EmitRuntimeCall(createRuntimeFunction(OMPRTL__kmpc_doacross_post),
+                        Args);
+  } else {
+    assert(C->getDependencyKind() == OMPC_DEPEND_sink);
+    // A sink in the current tile was executed before by this thread, and
+    // waiting for the tile would never end.
+    llvm::Value *IV = LoadAsInt64(D.getIterationVariable());
+    llvm::Value *IsOwn = CGF.Builder.CreateICmpEQ(
+        Tile, CGF.Builder.CreateSDiv(IV, TileSize));
+    auto *WaitBB = CGF.createBasicBlock("omp.doacross.wait");
+    CGF.Builder.CreateCondBr(IsOwn, ContBB, WaitBB);
+    CGF.EmitBlock(WaitBB);
+    CGF.EmitRuntimeCall(createRuntimeFunction(OMPRTL__kmpc_doacross_wait),
+                        Args);
+  }
+  CGF.EmitBlock(ContBB);
+}
+
 void CGOpenMPRuntime::addTrackedFunction(StringRef MangledName, GlobalDecl GD) {
   TrackedDecls[MangledName] = GD;
 }
 
+namespace {
+/// Collect the functions that device code may call or refer to, starting from
+/// the bodies of target regions and declare target functions. Besides direct
+/// calls, this follows the constructors, destructors, allocation functions and
+/// virtual functions used implicitly, as well as functions whose address is
+/// taken, since all of them must be available when the device code is linked.
+class DeviceReachableFunctionsCollector {
+  llvm::SmallPtrSetImpl<const FunctionDecl *> &Reachable;
+  SmallVector<const FunctionDecl *, 32> Worklist;
+
+  void scanFunction(const FunctionDecl *FD) {
+    const FunctionDecl *Def = nullptr;
+    if (FD->hasBody(Def))
+      scan(Def->getBody());
+    else
+      Def = FD;
+
+    if (const auto *Ctor = dyn_cast<CXXConstructorDecl>(Def)) {
+      for (const CXXCtorInitializer *Init : Ctor->inits())
+        scan(Init->getInit());
+      // Constructing a dynamic class refers to its virtual table.
+      const CXXRecordDecl *RD = Ctor->getParent();
+      if (RD->isDynamicClass()) {
+        for (const CXXMethodDecl *MD : RD->methods())
+          if (MD->isVirtual())
+            addFunction(MD);
+        addFunction(RD->getDestructor());
+      }
+    } else if (const auto *Dtor = dyn_cast<CXXDestructorDecl>(Def)) {
+      const CXXRecordDecl *RD = Dtor->getParent();
+      for (const FieldDecl *FD : RD->fields())
+        addDestructor(FD->getType());
+      for (const CXXBaseSpecifier &Base : RD->bases())
+        addDestructor(Base.getType());
+      addFunction(Dtor->getOperatorDelete());
+    }
+  }
+
+public:
+  explicit DeviceReachableFunctionsCollector(
+      llvm::SmallPtrSetImpl<const FunctionDecl *> &Reachable)
+      : Reachable(Reachable) {}
+
+  void addFunction(const FunctionDecl *FD) {
+    if (FD && Reachable.insert(FD->getCanonicalDecl()).second)
+      Worklist.push_back(FD);
+  }
+
+  void addDestructor(QualType Ty) {
+    if (const auto *RD = Ty->getBaseElementTypeUnsafe()->getAsCXXRecordDecl())
+      if (RD->hasDefinition())
+        addFunction(RD->getDestructor());
+  }
+
+  void scan(const Stmt *S) {
+    if (!S)
+      return;
+
+    if (const auto *DRE = dyn_cast<DeclRefExpr>(S))
+      addFunction(dyn_cast<FunctionDecl>(DRE->getDecl()));
+    else if (const auto *ME = dyn_cast<MemberExpr>(S))
+      addFunction(dyn_cast<FunctionDecl>(ME->getMemberDecl()));
+    else if (const auto *CE = dyn_cast<CXXConstructExpr>(S)) {
+      addFunction(CE->getConstructor());
+      addDestructor(CE->getType());
+    } else if (const auto *NE = dyn_cast<CXXNewExpr>(S)) {
+      addFunction(NE->getOperatorNew());
+      addFunction(NE->getOperatorDelete());
+    } else if (const auto *DE = dyn_cast<CXXDeleteExpr>(S)) {
+      addFunction(DE->getOperatorDelete());
+      addDestructor(DE->getDestroyedType());
+    } else if (const auto *BTE = dyn_cast<CXXBindTemporaryExpr>(S))
+      addFunction(BTE->getTemporary()->getDestructor());
+    else if (const auto *DS = dyn_cast<DeclStmt>(S)) {
+      for (const Decl *D : DS->decls())
+        if (const auto *VD = dyn_cast<VarDecl>(D))
+          addDestructor(VD->getType());
+    } else if (const auto *LE = dyn_cast<LambdaExpr>(S))
+      addFunction(LE->getCallOperator());
+    else if (const auto *DAE = dyn_cast<CXXDefaultArgExpr>(S))
+      scan(DAE->getExpr());
+    else if (const auto *DIE = dyn_cast<CXXDefaultInitExpr>(S))
+      scan(DIE->getExpr());
+    else if (const auto *CS = dyn_cast<CapturedStmt>(S))
+      scan(CS->getCapturedStmt());
+    else if (const auto *Dir = dyn_cast<OMPExecutableDirective>(S)) {
+      for (const OMPClause *C : Dir->clauses())
+        for (const Stmt *Child : const_cast<OMPClause *>(C)->children())
+          scan(Child);
+    }
+
+    for (const Stmt *Child : S->children())
+      scan(Child);
+  }
+
+  /// Scan the functions found so far until no new function is reached.
+  void run() {
+    while (!Worklist.empty())
+      scanFunction(Worklist.pop_back_val());
+  }
+};
+} // anonymous namespace
+
+/// Return true if \a FD only became declare target because it is used in
+/// device code. Sema gives these attributes the source range of the use.
+static bool isDeclareTargetBecauseOfUse(const FunctionDecl *FD) {
+  const OMPDeclareTargetDeclAttr *Attr = IsDeclareTargetDeclaration(FD);
+  return Attr && Attr->getRange().isValid();
+}
+
 void CGOpenMPRuntime::registerTrackedFunction() {
-  for (auto &GD : TrackedDecls)
+  bool Prune = CGM.getCodeGenOpts().OpenMPPruneImplicitDeclareTarget;
+  if (Prune) {
+    // The functions declared target by the user and the target regions
+    // emitted so far are the roots of the device code.
+    DeviceReachableFunctionsCollector Collector(DeviceReachableFunctions);
+    for (auto &GD : TrackedDecls) {
+      const auto *FD = dyn_cast<FunctionDecl>(GD.second.getDecl());
+      if (FD && IsDeclareTargetDeclaration(FD) &&
+          !isDeclareTargetBecauseOfUse(FD))
+        Collector.addFunction(FD);
+    }
+    for (const Stmt *S : PendingDeviceCode)
+      Collector.scan(S);
+    PendingDeviceCode.clear();
+
+    // The initialization of declare target variables runs on the device too.
+    for (auto &E : DeclareTargetEntryInfoMap)
+      if (const auto *VD = dyn_cast_or_null<VarDecl>(E.second.Variable)) {
+        Collector.scan(VD->getInit());
+        Collector.addDestructor(VD->getType());
+      }
+    Collector.run();
+  }
+
+  for (auto &GD : TrackedDecls) {
+    // Functions that only became declare target because of their use in
+    // device code are not needed if that code is never emitted.
+    if (Prune) {
+      const auto *FD = dyn_cast<FunctionDecl>(GD.second.getDecl());
+      if (FD && isDeclareTargetBecauseOfUse(FD) &&
+          !DeviceReachableFunctions.count(FD->getCanonicalDecl()))
+        continue;
+    }
     registerTargetFunctionDefinition(GD.second);
+  }
 }
 
 void CGOpenMPRuntime::emitCall(CodeGenFunction &CGF, llvm::Value *Callee,
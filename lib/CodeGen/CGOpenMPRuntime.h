@@ -22,6 +22,7 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/ValueHandle.h"
 
@@ -30,6 +31,7 @@ class ArrayType;
 class Constant;
 class FunctionType;
 class GlobalVariable;
+class NamedMDNode;
 class StructType;
 class Type;
 class Value;
@@ -115,6 +117,9 @@ struct OMPTaskDataTy final {
   SmallVector<const Expr *, 4> ReductionCopies;
   SmallVector<const Expr *, 4> ReductionOps;
   SmallVector<DependenceType, 4> Dependences;
+  /// Firstprivate variables of a taskloop that are copied once for all the
+  /// generated tasks and accessed through the shareds.
+  llvm::SmallPtrSet<const VarDecl *, 4> SharedFirstprivates;
   llvm::PointerIntPair<llvm::Value *, 1, bool> Final;
   llvm::PointerIntPair<llvm::Value *, 1, bool> Schedule;
   llvm::PointerIntPair<llvm::Value *, 1, bool> Priority;
@@ -481,6 +486,11 @@ protected:
   ///
   virtual llvm::Value *getThreadID(CodeGenFunction &CGF, SourceLocation Loc);
 
+  /// \brief Gets the thread number of the current thread in its binding team
+  /// and the number of threads of the team, queried once per function.
+  std::pair<llvm::Value *, llvm::Value *>
+  getTeamThreadNumAndSize(CodeGenFunction &CGF, SourceLocation Loc);
+
   /// \brief Returns pointer to ident_t type.
   llvm::Type *getIdentTyPointerTy();
 
@@ -520,7 +530,10 @@ protected:
                                      llvm::Function *Fn, bool IsDtor);
 
 public:
-  virtual StringRef RenameStandardFunction(StringRef name);
+  /// \brief Gets the name under which the function \a Name, declared by \a FD
+  /// if it is not null, is referenced in the target code.
+  virtual StringRef RenameStandardFunction(StringRef Name,
+                                           const FunctionDecl *FD);
 
   /// \brief Gets lane id value for the current simd lane.
   ///
@@ -561,11 +574,21 @@ private:
   struct DebugLocThreadIdTy {
     llvm::Value *DebugLoc;
     llvm::Value *ThreadID;
+    /// Thread number in the binding team and size of the team, used by the
+    /// inlined static schedules and the tree reductions.
+    llvm::Value *TeamThreadNum;
+    llvm::Value *TeamSize;
   };
   /// \brief Map of local debug location, ThreadId and functions.
   typedef llvm::DenseMap<llvm::Function *, DebugLocThreadIdTy>
       OpenMPLocThreadIDMapTy;
   OpenMPLocThreadIDMapTy OpenMPLocThreadIDMap;
+  /// Map of functions and the addresses of the threadprivate variables for
+  /// the current thread, looked up once in their entry block.
+  typedef llvm::DenseMap<llvm::Function *,
+                         llvm::SmallDenseMap<const VarDecl *, llvm::Value *, 4>>
+      FunctionThreadPrivateAddrMapTy;
+  FunctionThreadPrivateAddrMapTy FunctionThreadPrivateAddrMap;
   /// Map of UDRs and corresponding combiner/initializer.
   typedef llvm::DenseMap<const OMPDeclareReductionDecl *,
                          std::pair<llvm::Function *, llvm::Function *>>
@@ -755,6 +778,12 @@ private:
     /// information exists.
     bool hasTargetRegionEntryInfo(unsigned DeviceID, unsigned FileID,
                                   StringRef ParentName, unsigned LineNum) const;
+    /// \brief Return true if the host compilation recorded a target region
+    /// entry in the function named \a ParentName. Only available for the
+    /// device code generation.
+    bool hasTargetRegionEntriesInParent(StringRef ParentName) const {
+      return TargetRegionParentNames.count(ParentName);
+    }
     /// brief Applies action \a Action on all registered entries.
     typedef llvm::function_ref<void(unsigned, unsigned, StringRef, unsigned,
                                     OffloadEntryInfoTargetRegion &)>
@@ -872,6 +901,10 @@ private:
     typedef OffloadEntriesTargetRegionPerDevice OffloadEntriesTargetRegionTy;
     OffloadEntriesTargetRegionTy OffloadEntriesTargetRegion;
 
+    // The parent functions of the target region entries of the device code
+    // generation, so that the functions without any are not scanned.
+    llvm::StringSet<> TargetRegionParentNames;
+
     // Storage for device global variable entries kind. The storage is to be
     // indexed by mangled name.
     typedef llvm::StringMap<OffloadEntryInfoDeviceGlobalVar>
@@ -894,6 +927,10 @@ private:
   /// along with the associated metadata.
   void createOffloadEntriesAndInfoMetadata();
 
+  /// \brief Writes the offloading info metadata \a MD, if any, to the file
+  /// requested by the host compilation for the device compilations.
+  void emitOffloadInfoFile(llvm::NamedMDNode *MD);
+
   /// \brief Loads all the offload entries information from the host IR
   /// metadata.
   void loadOffloadInfoMetadata();
@@ -972,6 +1009,22 @@ private:
   ///
   llvm::Value *getCriticalRegionLock(StringRef CriticalName);
 
+  /// Emits the call to __tgt_profile_begin ahead of an offloading runtime call
+  /// when -fopenmp-offload-profile is on. The call site is described by a
+  /// constant { char *name, char *psource, int32_t kind } record, where
+  /// \a Name is the offload entry of a target region or the name of a data
+  /// directive and \a Kind one of OpenMPOffloadProfileKind.
+  /// \return The record to pass to emitOffloadProfileEnd, or null if
+  /// profiling is off.
+  llvm::Value *emitOffloadProfileBegin(CodeGenFunction &CGF,
+                                       SourceLocation Loc, StringRef Name,
+                                       unsigned Kind, llvm::Value *DeviceID);
+
+  /// Emits the call to __tgt_profile_end after the offloading runtime call
+  /// of \a Site, with its return code \a Ret if any.
+  void emitOffloadProfileEnd(CodeGenFunction &CGF, llvm::Value *Site,
+                             llvm::Value *DeviceID, llvm::Value *Ret);
+
   struct TaskResultTy {
     llvm::Value *NewTask = nullptr;
     llvm::Value *TaskEntry = nullptr;
@@ -987,6 +1040,12 @@ private:
   /// device codegen.
   llvm::StringMap<GlobalDecl> TrackedDecls;
 
+  /// Bodies of the target regions emitted for the host whose callees have not
+  /// been collected yet, and the functions known to be reachable from device
+  /// code. Only used when pruning implicitly declare target functions.
+  llvm::SmallVector<const Stmt *, 16> PendingDeviceCode;
+  llvm::SmallPtrSet<const FunctionDecl *, 64> DeviceReachableFunctions;
+
   /// Struct that keeps information about the emitted definitions and
   /// ctors/dtors so that it can be revisited when emitting declare target
   /// entries.
@@ -1005,6 +1064,18 @@ private:
   /// Map between a declaration name and its declare target information.
   llvm::StringMap<DeclareTargetEntryInfo> DeclareTargetEntryInfoMap;
 
+  /// The functions that initialize and destroy the declare target globals of
+  /// the device code, with the priority of their initialization.  They are
+  /// all called by the single initializer and destructor entries of the
+  /// compilation unit.
+  SmallVector<std::pair<unsigned, llvm::Function *>, 16> DeviceGlobalCtors;
+  SmallVector<std::pair<unsigned, llvm::Function *>, 16> DeviceGlobalDtors;
+
+  /// \brief Emit the entries that run the initializers of the declare target
+  /// globals of the device code in the order of their priorities, and the
+  /// destructors in the reverse order.
+  void emitDeviceCtorDtorEntries();
+
 public:
   explicit CGOpenMPRuntime(CodeGenModule &CGM);
   virtual ~CGOpenMPRuntime() {}
@@ -1022,7 +1093,9 @@ public:
   virtual void registerParallelContext(CodeGenFunction &CGF,
                                        const OMPExecutableDirective &S) {}
 
-  /// Emit code for the specified user defined reduction construct.
+  /// Emit code for the specified user defined reduction construct. Nothing is
+  /// emitted with -fopenmp-inline-reduction-combiners, which emits the
+  /// combiner and the initializer at each use.
   virtual void emitUserDefinedReduction(CodeGenFunction *CGF,
                                         const OMPDeclareReductionDecl *D);
   /// Get combiner/initializer for the specified user-defined reduction, if any.
@@ -1120,6 +1193,16 @@ public:
                                 ArrayRef<llvm::Value *> CapturedVars,
                                 const Expr *IfCond);
 
+  /// \brief Emits an outlined function that runs the outlined functions \a
+  /// OutlinedFns of adjacent parallel regions one after the other, with a
+  /// barrier between them, so that the regions share a single fork. The
+  /// variables captured by the regions are all pointers, they are passed to
+  /// the new function in order and forwarded to the region that owns them.
+  ///
+  virtual llvm::Value *
+  emitFusedParallelOutlinedFunction(SourceLocation Loc,
+                                    ArrayRef<llvm::Value *> OutlinedFns);
+
   /// \brief Emits code for simd call of the \a OutlinedFn with
   /// variables captured in a record which address is stored in \a
   /// CapturedStruct.
@@ -1142,6 +1225,21 @@ public:
                                   SourceLocation Loc,
                                   const Expr *Hint = nullptr);
 
+  /// \brief Emits a critical region as an atomic update if the runtime can
+  /// do so for the statement associated with it.
+  /// \param CriticalName Name of the critical region.
+  /// \param CriticalOpGen Generator for the statement associated with the
+  /// given critical region, for the runtime to emit it with
+  /// emitCriticalRegion where the atomic update cannot be used.
+  /// \param CriticalBody Statement associated with the critical region.
+  /// \param Hint Value of the 'hint' clause (optional).
+  /// \return true if the region has been emitted, false if it has to be
+  /// emitted with emitCriticalRegion.
+  virtual bool emitCriticalRegionAsAtomicUpdate(
+      CodeGenFunction &CGF, StringRef CriticalName,
+      const RegionCodeGenTy &CriticalOpGen, const Stmt *CriticalBody,
+      SourceLocation Loc, const Expr *Hint = nullptr);
+
   /// \brief Emits a master region.
   /// \param MasterOpGen Generator for the statement associated with the given
   /// master region.
@@ -1220,16 +1318,40 @@ public:
   /// \param DistScheduleKind Schedule Kind specified in the 'dist_schedule'
   /// clause.
   /// \param ScheduleKind Schedule Kind specified in the 'schedule' clause.
-  /// \param Chunked True if distribute chunk is specified in the clause.
+  /// \param DistChunkSize Distribute chunk specified in the clause, or
+  /// nullptr if there is none.
   /// \param ChunkSizeOne True if schedule chunk is one.
   /// \param Ordered true if loop is ordered, false otherwise.
   ///
   virtual bool
   generateCoalescedSchedule(OpenMPDistScheduleClauseKind DistScheduleKind,
                             OpenMPScheduleClauseKind ScheduleKind,
-                            bool DistChunked, bool ChunkSizeOne,
+                            const Expr *DistChunkSize, bool ChunkSizeOne,
                             bool Ordered) const;
 
+  /// \brief Report why the loop directive \a S is not given the coalesced
+  /// schedule of the target, if the target has one.
+  virtual void emitUncoalescedScheduleRemark(const OMPLoopDirective &S);
+
+  /// \brief Check if the teams running the coalesced loop \a S may stage the
+  /// arrays read by their iterations in memory shared by the team.
+  /// \param TeamSize The largest number of threads of a team.
+  /// \param Budget The number of bytes of shared memory available for the
+  /// staged elements.
+  virtual bool getStencilStagingLimits(const OMPLoopDirective &S,
+                                       unsigned &TeamSize,
+                                       uint64_t &Budget) const;
+
+  /// \brief Emit a buffer of \a NumElts elements of type \a EltTy in memory
+  /// shared by the threads of the team.
+  virtual Address emitStencilStagingBuffer(CodeGenFunction &CGF,
+                                           QualType EltTy, uint64_t NumElts);
+
+  /// \brief Emit the id of the current thread in its team and the number of
+  /// threads of the team.
+  virtual std::pair<llvm::Value *, llvm::Value *>
+  emitTeamThreadIDAndSize(CodeGenFunction &CGF);
+
   /// \brief Check if the specified \a ScheduleKind is dynamic.
   /// This kind of worksharing directive is emitted without outer loop.
   /// \param ScheduleKind Schedule Kind specified in the 'schedule' clause.
@@ -1303,6 +1425,19 @@ public:
                                  const OpenMPScheduleTy &ScheduleKind,
                                  const StaticRTInput &Values);
 
+  /// \brief Compute the bounds of the current thread for a loop with the
+  /// static non-chunked schedule inline, from its thread number and the size
+  /// of the team, instead of calling __kmpc_for_static_init. No static finish
+  /// call is needed after the loop.
+  ///
+  /// \param CGF Reference to current CodeGenFunction.
+  /// \param Loc Clang source location.
+  /// \param Values Input arguments for the construct.
+  ///
+  virtual void emitInlinedForStaticInit(CodeGenFunction &CGF,
+                                        SourceLocation Loc,
+                                        const StaticRTInput &Values);
+
   ///
   /// \param CGF Reference to current CodeGenFunction.
   /// \param Loc Clang source location.
@@ -1422,6 +1557,11 @@ public:
   /// concurrent execution of certain directive and clause combinations.
   virtual bool requiresBarrier(const OMPLoopDirective &S) const;
 
+  /// \brief Check if the simd directive \a S must be outlined and executed by
+  /// the lanes of the device rather than emitted inline, where the loop
+  /// vectorizer can see the loop.
+  virtual bool requiresOutlinedSimd(const OMPLoopDirective &S) const;
+
   /// Creates artificial threadprivate variable with name \p Name and type \p
   /// VarType.
   /// \param VarType Type of the artificial threadprivate variable.
@@ -1682,6 +1822,23 @@ public:
                  const Expr *IfCond, const Expr *Device,
                  ArrayRef<llvm::Value *> CapturedVars, OMPMapArrays &MapArrays);
 
+  /// Emit a target task that offloads \a D to the device \a DeviceID, so that
+  /// the caller can launch the region on several devices at the same time and
+  /// wait for all of them with a taskwait. The task runs the host version
+  /// \a OutlinedFn if the launch fails.
+  /// \param OutlinedFnID ID of host version of the code to be offloaded.
+  /// \param NumIterations Trip count of the loop pushed to the device before
+  /// the launch, or null.
+  /// \param MapArrays Map arrays and arguments of the launch, copied into the
+  /// task.
+  virtual void emitTargetTaskCall(CodeGenFunction &CGF,
+                                  const OMPExecutableDirective &D,
+                                  llvm::Value *OutlinedFn,
+                                  llvm::Value *OutlinedFnID,
+                                  llvm::Value *DeviceID,
+                                  llvm::Value *NumIterations,
+                                  OMPMapArrays &MapArrays);
+
   /// \brief Emit the target regions enclosed in \a GD function definition or
   /// the function itself in case it is a valid device function. Returns true if
   /// \a GD was dealt with successfully.
@@ -1698,9 +1855,10 @@ public:
   /// \param GD Global to scan.
   virtual bool emitTargetGlobal(GlobalDecl GD);
 
-  /// \brief Emit the entry points (target regions) that implement the
-  /// initializers and destructors of the global \a D if that is meaningful for
-  /// the device. Returns true if the emission was successful.
+  /// \brief Emit the functions that implement the initializer and destructor
+  /// of the global \a D if that is meaningful for the device, to be called by
+  /// the initializer and destructor entries of the compilation unit. Returns
+  /// true if the emission was successful.
   /// \param D Global whose initializers destructors should be emitted.
   /// \param Addr Address of the global being initialized/destroyed.
   /// \param PerformInit True if the initializer should be emitted.
@@ -1837,6 +1995,27 @@ public:
                             llvm::Value *TaskFunction, QualType SharedsTy,
                             Address Shareds, const OMPTaskDataTy &Data);
 
+  /// Emit the doacross ordered directive with 'depend' clause \a C nested in
+  /// loop \a D, whose iterations are posted per tile. The tile of a source is
+  /// posted after its last iteration, a sink is not waited for if it is in
+  /// the current tile.
+  /// \param CntVal Flattened iteration of the clause.
+  void emitTiledDoacrossOrdered(CodeGenFunction &CGF, const OMPLoopDirective &D,
+                                const OMPDependClause *C, llvm::Value *CntVal);
+
+  /// Emit the reduction of the lists \a ReductionList of the threads of the
+  /// team as a combine tree of logarithmic depth. Each thread publishes its
+  /// list in a cache-line-sized slot of a buffer on the stack of the master
+  /// thread, whose address is broadcast with __kmpc_copyprivate, the lists
+  /// are combined pairwise by \a ReductionFn between barriers, and the master
+  /// thread finally combines the result with the original variables.
+  void emitTreeReduction(CodeGenFunction &CGF, SourceLocation Loc,
+                         Address ReductionList, llvm::Value *ReductionFn,
+                         ArrayRef<const Expr *> Privates,
+                         ArrayRef<const Expr *> LHSExprs,
+                         ArrayRef<const Expr *> RHSExprs,
+                         ArrayRef<const Expr *> ReductionOps);
+
   /// Generate arrays for later emission of code to implement target map clause
   OMPMapArrays generateMapArrays(CodeGenFunction &CGF,
                                  const OMPExecutableDirective &D,
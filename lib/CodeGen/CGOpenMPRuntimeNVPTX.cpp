@@ -19,9 +19,12 @@
 #include "clang/AST/DeclOpenMP.h"
 #include "clang/AST/StmtOpenMP.h"
 #include "clang/AST/StmtVisitor.h"
+#include "clang/Basic/Builtins.h"
 #include "clang/Basic/Cuda.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/Transforms/Utils/FunctionComparator.h"
 
 using namespace clang;
 using namespace CodeGen;
@@ -196,6 +199,15 @@ enum DATA_SHARING_SIZES {
   // memory is one that uses device __shared__ memory.  The amount of such space
   // (in bytes) reserved by the OpenMP runtime is noted here.
   DS_SimpleBufferSize = 896,
+
+  // The largest master frame of an entry point that is laid out in a
+  // statically allocated __shared__ buffer when static data sharing is
+  // requested.  Larger frames are obtained from the runtime.
+  DS_Max_Static_Frame_Size = 2048,
+
+  // The shared memory a team may use to stage the arrays read by a stencil
+  // loop, in bytes.
+  DS_Max_Stencil_Staging_Size = 32 * 1024,
 };
 
 enum COPY_DIRECTION {
@@ -209,6 +221,22 @@ enum COPY_DIRECTION {
   Shuffle_To_ReduceData,
 };
 
+// Phases of a kernel whose cycles are accumulated over all of its threads with
+// -fopenmp-nvptx-cycle-counters, in the order of the <kernel>_cycles array.
+// The cycles of the workers in each parallel region of a generic kernel are
+// accumulated separately in <kernel>_parallel_cycles.
+enum CYCLE_COUNTER_PHASE {
+  // The entry function, from the kernel header to its footer.
+  CC_Kernel = 0,
+  // Workers waiting for and receiving work in the state machine.
+  CC_StateMachine = 1,
+  // Barriers, in the state machine and for OpenMP barriers.
+  CC_Barrier = 2,
+  // Opening of the data sharing environments.
+  CC_DataSharing = 3,
+  CC_NumPhases = 4,
+};
+
 /// Common pre(post)-action for different OpenMP constructs.
 class CommonActionTy final : public PrePostActionTy {
   llvm::Value *EnterCallee;
@@ -289,6 +317,14 @@ static llvm::Value *GetNVPTXBlockID(CodeGenFunction &CGF) {
       "nvptx_block_id");
 }
 
+/// Get the number of blocks in the GPU grid.
+static llvm::Value *GetNVPTXNumBlocks(CodeGenFunction &CGF) {
+  return CGF.EmitRuntimeCall(
+      llvm::Intrinsic::getDeclaration(
+          &CGF.CGM.getModule(), llvm::Intrinsic::nvvm_read_ptx_sreg_nctaid_x),
+      "nvptx_num_blocks");
+}
+
 /// Get the maximum number of threads in a block of the GPU.
 static llvm::Value *GetNVPTXNumThreads(CodeGenFunction &CGF) {
   return CGF.EmitRuntimeCall(
@@ -317,6 +353,13 @@ static void GetNVPTXBarrier(CodeGenFunction &CGF, int ID,
 /// Synchronize all GPU threads in a block.
 static void SyncCTAThreads(CodeGenFunction &CGF) { GetNVPTXCTABarrier(CGF); }
 
+/// Make global memory writes of the calling thread visible to all threads on
+/// the device.
+static void GetNVPTXGlobalMemFence(CodeGenFunction &CGF) {
+  CGF.EmitRuntimeCall(llvm::Intrinsic::getDeclaration(
+      &CGF.CGM.getModule(), llvm::Intrinsic::nvvm_membar_gl));
+}
+
 /// Get the value of the thread_limit clause in the teams directive.
 /// The runtime always starts thread_limit+warpSize threads.
 static llvm::Value *GetThreadLimit(CodeGenFunction &CGF,
@@ -606,9 +649,41 @@ LValue CGOpenMPRuntimeNVPTX::getDataSharingRootSlotLValue(CodeGenFunction &CGF,
                                         getDataSharingWorkerWarpSlotQty());
 }
 
+// \brief Create the per-team data sharing pool of a generic kernel, laid out
+// like the master slots with \p PoolSize bytes of data.
+llvm::GlobalVariable *
+CGOpenMPRuntimeNVPTX::createDataSharingPool(unsigned PoolSize) {
+  //  struct PoolSlot {
+  //    Slot *Next;
+  //    void *DataEnd;
+  //    char Data[PoolSize];
+  //  } Pool[DS_Max_Teams];
+  ASTContext &C = CGM.getContext();
+  auto *RD = C.buildImplicitRecord("__openmp_nvptx_data_sharing_pool_slot_ty");
+  RD->startDefinition();
+  addFieldToRecordDecl(C, RD, C.getPointerType(getDataSharingSlotQty()));
+  addFieldToRecordDecl(C, RD, C.VoidPtrTy);
+  llvm::APInt NumElems(C.getTypeSize(C.getUIntPtrType()), PoolSize);
+  addFieldToRecordDecl(C, RD,
+                       C.getConstantArrayType(C.CharTy, NumElems,
+                                              ArrayType::Normal,
+                                              /*IndexTypeQuals=*/0));
+  RD->completeDefinition();
+  llvm::APInt NumTeams(C.getTypeSize(C.getUIntPtrType()), DS_Max_Teams);
+  QualType PoolTy = C.getConstantArrayType(
+      C.getRecordType(RD), NumTeams, ArrayType::Normal, /*IndexTypeQuals=*/0);
+
+  auto *Ty = CGM.getTypes().ConvertTypeForMem(PoolTy);
+  return new llvm::GlobalVariable(
+      CGM.getModule(), Ty, /*isConstant=*/false,
+      llvm::GlobalVariable::InternalLinkage, llvm::Constant::getNullValue(Ty),
+      "data_sharing_pool", /*InsertBefore=*/nullptr,
+      llvm::GlobalVariable::NotThreadLocal);
+}
+
 // \brief Initialize the data sharing slots and pointers.
-void CGOpenMPRuntimeNVPTX::initializeDataSharing(CodeGenFunction &CGF,
-                                                 bool IsMaster) {
+void CGOpenMPRuntimeNVPTX::initializeDataSharing(
+    CodeGenFunction &CGF, bool IsMaster, llvm::GlobalVariable *Pool) {
   // We initialized the slot and stack pointer in shared memory with their
   // initial values. Also, we initialize the slots with the initial size.
 
@@ -626,16 +701,28 @@ void CGOpenMPRuntimeNVPTX::initializeDataSharing(CodeGenFunction &CGF,
     CGF.EmitBlock(InitBB);
   }
 
-  auto SlotLV = getDataSharingRootSlotLValue(CGF, IsMaster);
-
   auto *SlotPtrTy = getDataSharingSlotTy()->getPointerTo();
-  auto *CastedSlot =
-      Bld.CreateBitCast(SlotLV.getAddress(), SlotPtrTy).getPointer();
+  llvm::Value *CastedSlot;
+  uint64_t InitialDataSize;
+  if (IsMaster && Pool) {
+    // The root slot of the master is the slot of the team in the pool, so
+    // that the runtime pushes the frames in it.
+    llvm::Value *Idx[] = {llvm::Constant::getNullValue(CGM.Int32Ty),
+                          GetNVPTXBlockID(CGF)};
+    CastedSlot = Bld.CreateBitCast(Bld.CreateInBoundsGEP(Pool, Idx), SlotPtrTy);
+    auto *SlotTy = cast<llvm::StructType>(
+        cast<llvm::ArrayType>(Pool->getValueType())->getElementType());
+    InitialDataSize =
+        cast<llvm::ArrayType>(SlotTy->getElementType(2))->getNumElements();
+  } else {
+    auto SlotLV = getDataSharingRootSlotLValue(CGF, IsMaster);
+    CastedSlot =
+        Bld.CreateBitCast(SlotLV.getAddress(), SlotPtrTy).getPointer();
+    InitialDataSize = IsMaster ? DS_Slot_Size : DS_Worker_Warp_Slot_Size;
+  }
 
-  llvm::Value *Args[] = {
-      CastedSlot,
-      llvm::ConstantInt::get(CGM.SizeTy, IsMaster ? DS_Slot_Size
-                                                  : DS_Worker_Warp_Slot_Size)};
+  llvm::Value *Args[] = {CastedSlot,
+                         llvm::ConstantInt::get(CGM.SizeTy, InitialDataSize)};
   CGF.EmitRuntimeCall(
       createNVPTXRuntimeFunction(
           OMPRTL_NVPTX__kmpc_initialize_data_sharing_environment),
@@ -648,7 +735,8 @@ void CGOpenMPRuntimeNVPTX::initializeDataSharing(CodeGenFunction &CGF,
 // \brief Initialize the data sharing slots and pointers and return the
 // generated call.
 llvm::Function *CGOpenMPRuntimeNVPTX::createKernelInitializerFunction(
-    llvm::Function *WorkerFunction, bool RequiresOMPRuntime) {
+    llvm::Function *WorkerFunction, bool RequiresOMPRuntime,
+    llvm::GlobalVariable *DataSharingPool) {
   auto &Ctx = CGM.getContext();
 
   // FIXME: Consider to use name based on the worker function name.
@@ -698,7 +786,7 @@ llvm::Function *CGOpenMPRuntimeNVPTX::createKernelInitializerFunction(
                                Bld.getInt16(/*RequiresOMPRuntime=*/1)};
     CGF.EmitRuntimeCall(
         createNVPTXRuntimeFunction(OMPRTL_NVPTX__kmpc_kernel_init), InitArgs);
-    initializeDataSharing(CGF, /*IsMaster=*/true);
+    initializeDataSharing(CGF, /*IsMaster=*/true, DataSharingPool);
     CGF.EmitStoreOfScalar(One, CGF.ReturnValue, /*Volatile=*/false, RetQTy);
     CGF.EmitBranch(SyncBB);
 
@@ -976,6 +1064,345 @@ getNestedTeamsSPMDDirective(const OMPExecutableDirective &D,
   return nullptr;
 }
 
+// Record in \a Replicated the variables captured by copy in \a CS.  When the
+// teams region is executed redundantly by every thread each thread owns a
+// copy of these variables.
+static void
+addByCopyCaptures(const CapturedStmt &CS,
+                  llvm::SmallPtrSetImpl<const VarDecl *> &Replicated) {
+  for (const auto &Cap : CS.captures())
+    if (Cap.capturesVariableByCopy())
+      Replicated.insert(Cap.getCapturedVar()->getCanonicalDecl());
+}
+
+// Record in \a Replicated the variables privatized by the private and
+// firstprivate clauses of \a D.  Return false if a list item is not a plain
+// variable.
+template <typename ClauseTy>
+static bool
+addPrivatizedVars(const OMPExecutableDirective &D,
+                  llvm::SmallPtrSetImpl<const VarDecl *> &Replicated) {
+  for (const auto *C : D.getClausesOfKind<ClauseTy>()) {
+    for (const Expr *E : C->varlists()) {
+      const auto *DRE = dyn_cast<DeclRefExpr>(E->IgnoreParenImpCasts());
+      const auto *VD = DRE ? dyn_cast<VarDecl>(DRE->getDecl()) : nullptr;
+      if (!VD)
+        return false;
+      Replicated.insert(VD->getCanonicalDecl());
+    }
+  }
+  return true;
+}
+
+// Check that the sequential part of a teams region can be executed by all
+// threads of the team without changing the program semantics.  Only
+// declarations of scalars with side effect free initializers are allowed in
+// between the nested parallel directives, which are collected in
+// \a ParallelDirs.  The declared variables are added to \a Replicated.  If
+// \a Culprit is not null it is set to the statement that cannot be executed
+// redundantly.
+static bool isRedundantlyExecutableTeamsBody(
+    const Stmt *S, const ASTContext &Ctx,
+    llvm::SmallPtrSetImpl<const VarDecl *> &Replicated,
+    llvm::SmallVectorImpl<const OMPExecutableDirective *> &ParallelDirs,
+    const Stmt **Culprit = nullptr) {
+  if (!S || isa<NullStmt>(S))
+    return true;
+
+  if (const auto *CS = dyn_cast<CompoundStmt>(S)) {
+    for (const Stmt *Child : CS->body())
+      if (!isRedundantlyExecutableTeamsBody(Child, Ctx, Replicated,
+                                            ParallelDirs, Culprit))
+        return false;
+    return true;
+  }
+
+  if (Culprit)
+    *Culprit = S;
+
+  if (const auto *DS = dyn_cast<DeclStmt>(S)) {
+    for (const Decl *D : DS->decls()) {
+      const auto *VD = dyn_cast<VarDecl>(D);
+      if (!VD || !VD->hasLocalStorage() || !VD->getType()->isScalarType())
+        return false;
+      if (const Expr *Init = VD->getInit())
+        if (Init->HasSideEffects(Ctx))
+          return false;
+      Replicated.insert(VD->getCanonicalDecl());
+    }
+    return true;
+  }
+
+  if (const auto *Dir = dyn_cast<OMPExecutableDirective>(S)) {
+    switch (Dir->getDirectiveKind()) {
+    case OMPD_parallel:
+    case OMPD_parallel_for:
+    case OMPD_parallel_for_simd:
+      break;
+    default:
+      return false;
+    }
+    // These clauses either depend on the number of threads in the team or
+    // write back into the enclosing, now replicated, data environment.
+    if (Dir->hasClausesOfKind<OMPNumThreadsClause>() ||
+        Dir->hasClausesOfKind<OMPIfClause>() ||
+        Dir->hasClausesOfKind<OMPReductionClause>() ||
+        Dir->hasClausesOfKind<OMPLastprivateClause>() ||
+        Dir->hasClausesOfKind<OMPLinearClause>() ||
+        Dir->hasClausesOfKind<OMPCopyinClause>())
+      return false;
+    ParallelDirs.push_back(Dir);
+    return true;
+  }
+
+  return false;
+}
+
+// Return true if a variable in \a Replicated may be written, or may have its
+// address taken, in \a S.  Only reads through an lvalue-to-rvalue conversion
+// are known to be safe.
+static bool mayModifyReplicatedVar(
+    const Stmt *S, const llvm::SmallPtrSetImpl<const VarDecl *> &Replicated) {
+  if (!S)
+    return false;
+
+  if (const auto *ICE = dyn_cast<ImplicitCastExpr>(S))
+    if (ICE->getCastKind() == CK_LValueToRValue &&
+        isa<DeclRefExpr>(ICE->getSubExpr()->IgnoreParens()))
+      return false;
+
+  if (const auto *DRE = dyn_cast<DeclRefExpr>(S)) {
+    if (const auto *VD = dyn_cast<VarDecl>(DRE->getDecl()))
+      return Replicated.count(VD->getCanonicalDecl());
+    return false;
+  }
+
+  // The capture initializers of a nested region refer to the captured
+  // variables by reference; only look at the captured body.
+  if (const auto *CS = dyn_cast<CapturedStmt>(S))
+    return mayModifyReplicatedVar(CS->getCapturedStmt(), Replicated);
+
+  for (const Stmt *Child : S->children())
+    if (mayModifyReplicatedVar(Child, Replicated))
+      return true;
+  return false;
+}
+
+// Return true if a variable in \a Vars may be written, or may have its address
+// taken, by the clauses of a directive in \a S.
+static bool clausesMayModifyVar(
+    const Stmt *S, const llvm::SmallPtrSetImpl<const VarDecl *> &Vars) {
+  if (!S)
+    return false;
+
+  if (const auto *Dir = dyn_cast<OMPExecutableDirective>(S))
+    for (const OMPClause *C : Dir->clauses())
+      for (const Stmt *Child : const_cast<OMPClause *>(C)->children())
+        if (mayModifyReplicatedVar(Child, Vars))
+          return true;
+
+  for (const Stmt *Child : S->children())
+    if (clausesMayModifyVar(Child, Vars))
+      return true;
+  return false;
+}
+
+// Check if \a Body consists of a single 'distribute parallel for' loop, so
+// that the teams region around it is equivalent to the combined 'teams
+// distribute parallel for' construct.
+static bool isSoleDistributeParallelFor(const Stmt *Body) {
+  const auto *D =
+      dyn_cast_or_null<OMPExecutableDirective>(ignoreCompoundStmts(Body));
+  return D && onlyOneStmt(Body) &&
+         isOpenMPDistributeDirective(D->getDirectiveKind()) &&
+         isOpenMPParallelDirective(D->getDirectiveKind());
+}
+
+// Check if the teams region of target directive \a D can be executed in SPMD
+// mode by having every thread of a team execute the sequential part of the
+// teams region redundantly.  Return the teams directive if so.  Without
+// -fopenmp-combine-dirs this is only done for a teams region that has no
+// sequential part besides a 'distribute parallel for' loop.
+static const OMPExecutableDirective *
+getRedundantTeamsSPMDDirective(const CodeGenModule &CGM,
+                               const OMPExecutableDirective &D) {
+  const auto *CS = cast<CapturedStmt>(D.getAssociatedStmt());
+  if (D.hasClausesOfKind<OMPDependClause>())
+    CS = cast<CapturedStmt>(CS->getCapturedStmt());
+
+  llvm::SmallPtrSet<const VarDecl *, 16> Replicated;
+  addByCopyCaptures(*CS, Replicated);
+  if (!addPrivatizedVars<OMPPrivateClause>(D, Replicated) ||
+      !addPrivatizedVars<OMPFirstprivateClause>(D, Replicated))
+    return nullptr;
+
+  const OMPExecutableDirective *TeamsDir = nullptr;
+  switch (D.getDirectiveKind()) {
+  case OMPD_target_teams:
+    TeamsDir = &D;
+    break;
+  case OMPD_target: {
+    const auto *NestedDir = dyn_cast_or_null<OMPExecutableDirective>(
+        ignoreCompoundStmts(CS->getCapturedStmt()));
+    if (!NestedDir || NestedDir->getDirectiveKind() != OMPD_teams ||
+        !onlyOneStmt(CS->getCapturedStmt()))
+      return nullptr;
+    TeamsDir = NestedDir;
+    CS = cast<CapturedStmt>(TeamsDir->getAssociatedStmt());
+    addByCopyCaptures(*CS, Replicated);
+    if (!addPrivatizedVars<OMPPrivateClause>(*TeamsDir, Replicated) ||
+        !addPrivatizedVars<OMPFirstprivateClause>(*TeamsDir, Replicated))
+      return nullptr;
+    break;
+  }
+  default:
+    return nullptr;
+  }
+
+  // A teams reduction is combined by the team master only.
+  if (TeamsDir->hasClausesOfKind<OMPReductionClause>())
+    return nullptr;
+
+  if (!CGM.getCodeGenOpts().OpenmpCombineDirs &&
+      !isSoleDistributeParallelFor(CS->getCapturedStmt()))
+    return nullptr;
+
+  llvm::SmallVector<const OMPExecutableDirective *, 4> ParallelDirs;
+  if (!isRedundantlyExecutableTeamsBody(CS->getCapturedStmt(),
+                                        CGM.getContext(), Replicated,
+                                        ParallelDirs) ||
+      ParallelDirs.empty())
+    return nullptr;
+
+  // Each thread now shares its own copy of the replicated variables with the
+  // nested parallel region, so they must not be modified there.
+  for (const OMPExecutableDirective *Dir : ParallelDirs)
+    if (mayModifyReplicatedVar(Dir->getAssociatedStmt(), Replicated))
+      return nullptr;
+
+  return TeamsDir;
+}
+
+namespace {
+/// Reasons for executing a target region in generic mode, in the order of the
+/// remark that reports them.
+enum GenericModeReasonKind {
+  GMR_NoSPMDFlag,
+  GMR_NoNestedParallel,
+  GMR_SerialTargetCode,
+  GMR_TeamsReduction,
+  GMR_TeamsPrivatization,
+  GMR_SerialTeamsCode,
+  GMR_ReplicatedVarModified,
+};
+} // namespace
+
+/// Return the first statement of \a Body that is not a directive of a kind
+/// accepted by \a IsExpected, or \a Body itself if there is none.
+static const Stmt *
+findUnexpectedStmt(const Stmt *Body,
+                   llvm::function_ref<bool(OpenMPDirectiveKind)> IsExpected) {
+  if (const auto *CS = dyn_cast_or_null<CompoundStmt>(Body)) {
+    for (const Stmt *Child : CS->body()) {
+      const auto *Dir = dyn_cast<OMPExecutableDirective>(Child);
+      if (!isa<NullStmt>(Child) &&
+          (!Dir || !IsExpected(Dir->getDirectiveKind())))
+        return findUnexpectedStmt(Child, IsExpected);
+    }
+  }
+  return Body;
+}
+
+/// Explain why the target directive \a D, which is not executed in SPMD mode,
+/// is executed in generic mode: return the reason and the location of the
+/// construct responsible for it.
+static std::pair<GenericModeReasonKind, SourceLocation>
+getGenericModeReason(const CodeGenModule &CGM,
+                     const OMPExecutableDirective &D) {
+  if (CGM.getLangOpts().OpenMPNoSPMD)
+    return {GMR_NoSPMDFlag, D.getLocStart()};
+
+  const auto *TargetCS = cast<CapturedStmt>(D.getAssociatedStmt());
+  if (D.hasClausesOfKind<OMPDependClause>())
+    TargetCS = cast<CapturedStmt>(TargetCS->getCapturedStmt());
+
+  const CapturedStmt *CS = TargetCS;
+  const OMPExecutableDirective *TeamsDir = &D;
+  switch (D.getDirectiveKind()) {
+  case OMPD_target:
+  case OMPD_target_simd: {
+    const Stmt *Body = CS->getCapturedStmt();
+    const auto *NestedDir =
+        dyn_cast_or_null<OMPExecutableDirective>(ignoreCompoundStmts(Body));
+    if (!NestedDir || !onlyOneStmt(Body) ||
+        !isOpenMPTeamsDirective(NestedDir->getDirectiveKind()))
+      return {GMR_SerialTargetCode,
+              findUnexpectedStmt(Body, isOpenMPTeamsDirective)->getLocStart()};
+    if (NestedDir->getDirectiveKind() != OMPD_teams)
+      return {GMR_NoNestedParallel, NestedDir->getLocStart()};
+    TeamsDir = NestedDir;
+    CS = cast<CapturedStmt>(TeamsDir->getAssociatedStmt());
+    break;
+  }
+  case OMPD_target_teams:
+    break;
+  default:
+    return {GMR_NoNestedParallel, D.getLocStart()};
+  }
+
+  auto Reductions = TeamsDir->getClausesOfKind<OMPReductionClause>();
+  if (Reductions.begin() != Reductions.end())
+    return {GMR_TeamsReduction, (*Reductions.begin())->getLocStart()};
+
+  // Only plain variables can be privatized for each thread.
+  auto &&FindUnreplicableClause =
+      [](const OMPExecutableDirective &Dir) -> const OMPClause * {
+    for (const OMPClause *C : Dir.clauses()) {
+      if (!isa<OMPPrivateClause>(C) && !isa<OMPFirstprivateClause>(C))
+        continue;
+      for (const Stmt *Child : const_cast<OMPClause *>(C)->children()) {
+        const auto *DRE = dyn_cast<DeclRefExpr>(
+            cast<Expr>(Child)->IgnoreParenImpCasts());
+        if (!DRE || !isa<VarDecl>(DRE->getDecl()))
+          return C;
+      }
+    }
+    return nullptr;
+  };
+  for (const OMPExecutableDirective *Dir : {&D, TeamsDir})
+    if (const OMPClause *C = FindUnreplicableClause(*Dir))
+      return {GMR_TeamsPrivatization, C->getLocStart()};
+
+  llvm::SmallPtrSet<const VarDecl *, 16> Replicated;
+  addByCopyCaptures(*TargetCS, Replicated);
+  addByCopyCaptures(*CS, Replicated);
+  for (const OMPExecutableDirective *Dir : {&D, TeamsDir}) {
+    (void)addPrivatizedVars<OMPPrivateClause>(*Dir, Replicated);
+    (void)addPrivatizedVars<OMPFirstprivateClause>(*Dir, Replicated);
+  }
+
+  const Stmt *Body = CS->getCapturedStmt();
+  auto &&IsDistributeParallel = [](OpenMPDirectiveKind Kind) {
+    return isOpenMPDistributeDirective(Kind) && isOpenMPParallelDirective(Kind);
+  };
+  if (!CGM.getCodeGenOpts().OpenmpCombineDirs &&
+      !isSoleDistributeParallelFor(Body))
+    return {GMR_SerialTeamsCode,
+            findUnexpectedStmt(Body, IsDistributeParallel)->getLocStart()};
+
+  llvm::SmallVector<const OMPExecutableDirective *, 4> ParallelDirs;
+  const Stmt *Culprit = Body;
+  if (!isRedundantlyExecutableTeamsBody(Body, CGM.getContext(), Replicated,
+                                        ParallelDirs, &Culprit))
+    return {GMR_SerialTeamsCode, Culprit->getLocStart()};
+  if (ParallelDirs.empty())
+    return {GMR_NoNestedParallel, TeamsDir->getLocStart()};
+  for (const OMPExecutableDirective *Dir : ParallelDirs)
+    if (mayModifyReplicatedVar(Dir->getAssociatedStmt(), Replicated))
+      return {GMR_ReplicatedVarModified, Dir->getLocStart()};
+  return {GMR_SerialTeamsCode, TeamsDir->getLocStart()};
+}
+
 static CGOpenMPRuntimeNVPTX::ExecutionMode
 GetExecutionMode(const CodeGenModule &CGM, const OMPExecutableDirective &D) {
   if (CGM.getLangOpts().OpenMPNoSPMD)
@@ -987,12 +1414,17 @@ GetExecutionMode(const CodeGenModule &CGM, const OMPExecutableDirective &D) {
   case OMPD_target: {
     // If the target region as a nested 'teams distribute parallel for',
     // the specifications guarantee that there can be no serial region.
-    return hasNestedTeamsSPMDDirective(D,
-                                       CGM.getCodeGenOpts().OpenmpCombineDirs)
+    if (hasNestedTeamsSPMDDirective(D, CGM.getCodeGenOpts().OpenmpCombineDirs))
+      return CGOpenMPRuntimeNVPTX::ExecutionMode::SPMD;
+    // A nested 'teams' whose serial part may be executed redundantly.
+    return getRedundantTeamsSPMDDirective(CGM, D)
                ? CGOpenMPRuntimeNVPTX::ExecutionMode::SPMD
                : CGOpenMPRuntimeNVPTX::ExecutionMode::GENERIC;
   }
   case OMPD_target_teams:
+    return getRedundantTeamsSPMDDirective(CGM, D)
+               ? CGOpenMPRuntimeNVPTX::ExecutionMode::SPMD
+               : CGOpenMPRuntimeNVPTX::ExecutionMode::GENERIC;
   case OMPD_target_teams_distribute:
   case OMPD_target_teams_distribute_simd:
     return CGOpenMPRuntimeNVPTX::ExecutionMode::GENERIC;
@@ -1014,11 +1446,20 @@ getSPMDDirective(const CodeGenModule &CGM, const OMPExecutableDirective &D) {
   switch (D.getDirectiveKind()) {
   case OMPD_target:
   case OMPD_target_simd: {
+    bool CombineDirs = CGM.getCodeGenOpts().OpenmpCombineDirs;
     const OMPExecutableDirective *NestedDir =
-        getNestedTeamsSPMDDirective(D, CGM.getCodeGenOpts().OpenmpCombineDirs);
+        hasNestedTeamsSPMDDirective(D, CombineDirs)
+            ? getNestedTeamsSPMDDirective(D, CombineDirs)
+            : getRedundantTeamsSPMDDirective(CGM, D);
     assert(NestedDir && "Failed to find nested teams SPMD directive.");
     return NestedDir;
   }
+  case OMPD_target_teams: {
+    const OMPExecutableDirective *TeamsDir =
+        getRedundantTeamsSPMDDirective(CGM, D);
+    assert(TeamsDir && "Failed to find redundant teams SPMD directive.");
+    return TeamsDir;
+  }
   case OMPD_target_parallel:
   case OMPD_target_parallel_for:
   case OMPD_target_parallel_for_simd:
@@ -1032,21 +1473,24 @@ getSPMDDirective(const CodeGenModule &CGM, const OMPExecutableDirective &D) {
   return nullptr;
 }
 
-static bool worksharingClauseRequiresRuntime(const OMPExecutableDirective &D) {
+static bool worksharingClauseRequiresRuntime(const OMPExecutableDirective &D,
+                                             bool NativeDynamicSchedule) {
   // 1. An ordered schedule requires the runtime.
-  // 2. Schedule types dynamic, guided, runtime require the runtime.
+  // 2. Schedule types dynamic, guided, runtime require the runtime, unless
+  // dynamic and guided loops are dispatched natively.
   OpenMPScheduleClauseKind ScheduleKind = OMPC_SCHEDULE_unknown;
   if (auto *C = D.getSingleClause<OMPScheduleClause>())
     ScheduleKind = C->getScheduleKind();
   return D.getSingleClause<OMPOrderedClause>() != nullptr ||
-         ScheduleKind == OMPC_SCHEDULE_dynamic ||
-         ScheduleKind == OMPC_SCHEDULE_guided ||
+         (!NativeDynamicSchedule && (ScheduleKind == OMPC_SCHEDULE_dynamic ||
+                                     ScheduleKind == OMPC_SCHEDULE_guided)) ||
          ScheduleKind == OMPC_SCHEDULE_runtime;
 }
 
 static bool directiveRequiresOMPRuntime(const OMPExecutableDirective &D,
                                         bool IsSPMDDirective,
-                                        bool IsInParallelRegion) {
+                                        bool IsInParallelRegion,
+                                        bool NativeDynamicSchedule = false) {
   OpenMPDirectiveKind Kind = D.getDirectiveKind();
   if (isOpenMPParallelDirective(Kind)) {
     // num_threads requires the runtime unless it is on a target
@@ -1063,9 +1507,10 @@ static bool directiveRequiresOMPRuntime(const OMPExecutableDirective &D,
     return ((!IsSPMDDirective &&
              (D.getSingleClause<OMPNumThreadsClause>() != nullptr ||
               ContainsIfClause)) ||
-            worksharingClauseRequiresRuntime(D));
+            worksharingClauseRequiresRuntime(D, NativeDynamicSchedule));
   } else if (Kind == OMPD_for || Kind == OMPD_for_simd) {
-    return !IsInParallelRegion || worksharingClauseRequiresRuntime(D);
+    return !IsInParallelRegion ||
+           worksharingClauseRequiresRuntime(D, NativeDynamicSchedule);
   } else if (Kind == OMPD_barrier) {
     return !IsInParallelRegion;
   } else if (Kind == OMPD_teams || Kind == OMPD_distribute ||
@@ -1080,6 +1525,11 @@ static bool directiveRequiresOMPRuntime(const OMPExecutableDirective &D,
 
 void CGOpenMPRuntimeNVPTX::TargetKernelProperties::setExecutionMode() {
   Mode = GetExecutionMode(CGM, D);
+  if (Mode == CGOpenMPRuntimeNVPTX::ExecutionMode::SPMD) {
+    OpenMPDirectiveKind Kind = getSPMDDirective(CGM, D)->getDirectiveKind();
+    ExecutesTeamsRedundantly =
+        isOpenMPTeamsDirective(Kind) && !isOpenMPParallelDirective(Kind);
+  }
 }
 
 void CGOpenMPRuntimeNVPTX::TargetKernelProperties::setRequiresOMPRuntime() {
@@ -1090,9 +1540,11 @@ void CGOpenMPRuntimeNVPTX::TargetKernelProperties::setRequiresOMPRuntime() {
 
   if (Mode == CGOpenMPRuntimeNVPTX::ExecutionMode::SPMD) {
     const OMPExecutableDirective &SD = *getSPMDDirective(CGM, D);
-    RequiresOMPRuntime =
-        directiveRequiresOMPRuntime(SD, /*IsSPMDDirective=*/true,
-                                    /*IsInParallelRegion=*/true);
+    // The dynamic and guided loops of the SPMD directive are dispatched
+    // natively with -fopenmp-nvptx-native-dynamic-schedule.
+    RequiresOMPRuntime = directiveRequiresOMPRuntime(
+        SD, /*IsSPMDDirective=*/true, /*IsInParallelRegion=*/true,
+        CGM.getCodeGenOpts().OpenMPNVPTXNativeDynamicSchedule);
     RequiresOMPRuntimeReason =
         MatchReasonTy(DirectiveRequiresRuntime, SD.getLocStart());
     if (!RequiresOMPRuntime) {
@@ -1478,6 +1930,11 @@ void CGOpenMPRuntimeNVPTX::emitWorkerFunction(WorkerFunctionState &WST) {
   CGF.FinishFunction();
 }
 
+/// Return the identifier the master passes to the workers for the parallel
+/// region at position \a Index in the outlined functions of the current
+/// target region.  Zero is reserved to signal termination.
+static uint64_t getParallelWorkID(unsigned Index) { return Index + 1; }
+
 void CGOpenMPRuntimeNVPTX::emitWorkerLoop(CodeGenFunction &CGF,
                                           WorkerFunctionState &WST) {
   //
@@ -1491,6 +1948,9 @@ void CGOpenMPRuntimeNVPTX::emitWorkerLoop(CodeGenFunction &CGF,
 
   CGBuilderTy &Bld = CGF.Builder;
 
+  if (KernelCycleCounters && !Work.empty())
+    WST.ParallelCycleCounters = createCycleCounters(Work.size());
+
   llvm::BasicBlock *AwaitBB = CGF.createBasicBlock(".await.work");
   llvm::BasicBlock *SelectWorkersBB = CGF.createBasicBlock(".select.workers");
   llvm::BasicBlock *ExecuteBB = CGF.createBasicBlock(".execute.parallel");
@@ -1502,6 +1962,7 @@ void CGOpenMPRuntimeNVPTX::emitWorkerLoop(CodeGenFunction &CGF,
 
   // Workers wait for work from master.
   CGF.EmitBlock(AwaitBB);
+  llvm::Value *AwaitStart = emitCycleCounterStart(CGF);
   // Wait for parallel work
   SyncCTAThreads(CGF);
 
@@ -1527,12 +1988,14 @@ void CGOpenMPRuntimeNVPTX::emitWorkerLoop(CodeGenFunction &CGF,
 
   // Activate requested workers.
   CGF.EmitBlock(SelectWorkersBB);
+  emitCycleCounterStop(CGF, AwaitStart, KernelCycleCounters, CC_StateMachine);
   llvm::Value *IsActive =
       Bld.CreateICmpNE(Bld.CreateLoad(ExecStatus), Bld.getInt8(0), "is_active");
   Bld.CreateCondBr(IsActive, ExecuteBB, BarrierBB);
 
   // Signal start of parallel region.
   CGF.EmitBlock(ExecuteBB);
+  llvm::Value *ExecuteStart = emitCycleCounterStart(CGF);
 
   if (WST.TP.hasAtMostOneL1ParallelRegion()) {
     // Short circuit when there is at most one L1 parallel region.
@@ -1546,40 +2009,42 @@ void CGOpenMPRuntimeNVPTX::emitWorkerLoop(CodeGenFunction &CGF,
       emitOutlinedFunctionCall(
           CGF, WST.Loc, Fn,
           {Bld.getInt16(/*ParallelLevel=*/0), GetMasterThreadID(CGF)});
+      emitCycleCounterStop(CGF, ExecuteStart, WST.ParallelCycleCounters,
+                           /*Idx=*/0);
     }
 
     // Go to end of parallel region.
     CGF.EmitBranch(TerminateBB);
   } else {
     // Process outlined parallel functions in the lexical scope of the target.
-    for (auto *W : Work) {
-      // Try to match this outlined function.
-      auto ThisID = Bld.CreatePtrToInt(W, CGM.Int64Ty);
-      ThisID = Bld.CreateIntToPtr(ThisID, CGM.Int8PtrTy);
-      llvm::Value *WorkFnMatch = Bld.CreateICmpEQ(WorkID, ThisID, "work_match");
-
+    // The master identifies these by their position in 'Work', so dispatch
+    // with a switch and call each of them directly.
+    llvm::BasicBlock *DefaultBB = CGF.createBasicBlock(".execute.default");
+    llvm::Value *WorkIndex = Bld.CreatePtrToInt(WorkID, CGM.Int64Ty, "work_id");
+    llvm::SwitchInst *WorkSwitch =
+        Bld.CreateSwitch(WorkIndex, DefaultBB, Work.size());
+    for (unsigned I = 0, E = Work.size(); I < E; ++I) {
       llvm::BasicBlock *ExecuteFNBB = CGF.createBasicBlock(".execute.fn");
-      llvm::BasicBlock *CheckNextBB = CGF.createBasicBlock(".check.next");
-      Bld.CreateCondBr(WorkFnMatch, ExecuteFNBB, CheckNextBB);
+      WorkSwitch->addCase(Bld.getInt64(getParallelWorkID(I)), ExecuteFNBB);
 
       // Execute this outlined function.
       CGF.EmitBlock(ExecuteFNBB);
 
       // Insert call to work function. We pass the master has source thread ID.
-      auto Fn = cast<llvm::Function>(W);
+      auto Fn = cast<llvm::Function>(Work[I]);
       emitOutlinedFunctionCall(
           CGF, WST.Loc, Fn,
           {Bld.getInt16(/*ParallelLevel=*/0), GetMasterThreadID(CGF)});
+      emitCycleCounterStop(CGF, ExecuteStart, WST.ParallelCycleCounters, I);
 
       // Go to end of parallel region.
       CGF.EmitBranch(TerminateBB);
-
-      CGF.EmitBlock(CheckNextBB);
     }
 
     // Default case: call to outlined function through pointer if the target
     // region makes a declare target call that may contain an orphaned parallel
     // directive.
+    CGF.EmitBlock(DefaultBB);
     if (WST.TP.mayContainOrphanedParallel()) {
       auto ParallelFnTy =
           llvm::FunctionType::get(CGM.VoidTy, {CGM.Int16Ty, CGM.Int32Ty},
@@ -1589,9 +2054,9 @@ void CGOpenMPRuntimeNVPTX::emitWorkerLoop(CodeGenFunction &CGF,
       emitOutlinedFunctionCall(
           CGF, WST.Loc, WorkFnCast,
           {Bld.getInt16(/*ParallelLevel=*/0), GetMasterThreadID(CGF)});
-      // Go to end of parallel region.
-      CGF.EmitBranch(TerminateBB);
     }
+    // Go to end of parallel region.
+    CGF.EmitBranch(TerminateBB);
   }
 
   // Signal end of parallel region.
@@ -1605,12 +2070,50 @@ void CGOpenMPRuntimeNVPTX::emitWorkerLoop(CodeGenFunction &CGF,
 
   // All active and inactive workers wait at a barrier after parallel region.
   CGF.EmitBlock(BarrierBB);
+  llvm::Value *BarrierStart = emitCycleCounterStart(CGF);
   // Barrier after parallel region.
   SyncCTAThreads(CGF);
+  emitCycleCounterStop(CGF, BarrierStart, KernelCycleCounters, CC_Barrier);
   CGF.EmitBranch(AwaitBB);
 
   // Exit target region.
   CGF.EmitBlock(ExitBB);
+  emitCycleCounterStop(CGF, AwaitStart, KernelCycleCounters, CC_StateMachine);
+}
+
+llvm::GlobalVariable *
+CGOpenMPRuntimeNVPTX::createCycleCounters(unsigned NumCounters) {
+  auto *CountersTy = llvm::ArrayType::get(CGM.Int64Ty, NumCounters);
+  // Like the kernel properties, the counters are looked up by the offload
+  // library through the name of the kernel, which they get once it is emitted.
+  return new llvm::GlobalVariable(CGM.getModule(), CountersTy,
+                                  /*isConstant=*/false,
+                                  llvm::GlobalValue::WeakAnyLinkage,
+                                  llvm::Constant::getNullValue(CountersTy),
+                                  /* placeholder */ "_cycles");
+}
+
+llvm::Value *CGOpenMPRuntimeNVPTX::emitCycleCounterStart(CodeGenFunction &CGF) {
+  if (!KernelCycleCounters || !CGF.HaveInsertPoint())
+    return nullptr;
+  return CGF.EmitRuntimeCall(llvm::Intrinsic::getDeclaration(
+      &CGM.getModule(), llvm::Intrinsic::nvvm_read_ptx_sreg_clock64));
+}
+
+void CGOpenMPRuntimeNVPTX::emitCycleCounterStop(CodeGenFunction &CGF,
+                                                llvm::Value *Start,
+                                                llvm::GlobalVariable *Counters,
+                                                unsigned Idx) {
+  if (!Start || !Counters || !CGF.HaveInsertPoint())
+    return;
+  CGBuilderTy &Bld = CGF.Builder;
+  llvm::Value *End = CGF.EmitRuntimeCall(llvm::Intrinsic::getDeclaration(
+      &CGM.getModule(), llvm::Intrinsic::nvvm_read_ptx_sreg_clock64));
+  llvm::Value *Counter = Bld.CreateConstInBoundsGEP2_32(
+      Counters->getValueType(), Counters, /*Idx0=*/0, Idx);
+  Bld.CreateAtomicRMW(llvm::AtomicRMWInst::Add, Counter,
+                      Bld.CreateSub(End, Start),
+                      llvm::AtomicOrdering::Monotonic);
 }
 
 // Setup NVPTX threads for master-worker OpenMP scheme.
@@ -1668,6 +2171,9 @@ void CGOpenMPRuntimeNVPTX::emitGenericEntryHeader(CodeGenFunction &CGF,
   DataSharingFunctionInfoMap[CGF.CurFn].IsEntryPoint = true;
   DataSharingFunctionInfoMap[CGF.CurFn].EntryWorkerFunction = WST.WorkerFn;
   DataSharingFunctionInfoMap[CGF.CurFn].EntryExitBlock = EST.ExitBB;
+  DataSharingFunctionInfoMap[CGF.CurFn].DataSharingPool = DataSharingPool;
+
+  EST.CycleCounterStart = emitCycleCounterStart(CGF);
 }
 
 void CGOpenMPRuntimeNVPTX::emitGenericEntryFooter(CodeGenFunction &CGF,
@@ -1679,6 +2185,8 @@ void CGOpenMPRuntimeNVPTX::emitGenericEntryFooter(CodeGenFunction &CGF,
   CGF.EmitBranch(TerminateBB);
 
   CGF.EmitBlock(TerminateBB);
+  emitCycleCounterStop(CGF, EST.CycleCounterStart, KernelCycleCounters,
+                       CC_Kernel);
   llvm::Value *IsOMPRuntimeInitialized =
       CGF.Builder.getInt16(EST.TP.requiresOMPRuntime() ? 1 : 0);
   // Signal termination condition.
@@ -1730,6 +2238,175 @@ void CGOpenMPRuntimeNVPTX::SetTargetKernelProperties(
                                llvm::GlobalValue::WeakAnyLinkage);
 }
 
+// Add a !{<func-ref>, metadata !"<Name>", i32 <Operand>} node to the
+// nvvm.annotations metadata of the module containing \a Fn.
+static void addNVVMMetadata(llvm::Function *Fn, StringRef Name, int Operand) {
+  llvm::Module *M = Fn->getParent();
+  llvm::LLVMContext &Ctx = M->getContext();
+
+  llvm::NamedMDNode *MD = M->getOrInsertNamedMetadata("nvvm.annotations");
+  llvm::Metadata *MDVals[] = {
+      llvm::ConstantAsMetadata::get(Fn), llvm::MDString::get(Ctx, Name),
+      llvm::ConstantAsMetadata::get(
+          llvm::ConstantInt::get(llvm::Type::getInt32Ty(Ctx), Operand))};
+  MD->addOperand(llvm::MDNode::get(Ctx, MDVals));
+}
+
+// Return the number of threads per team requested by the thread_limit and
+// num_threads clauses that apply to target directive \a D, or zero if neither
+// evaluates to a constant.  The host passes the lesser of the two to the
+// runtime, so either constant is an upper bound.
+static unsigned getConstantTeamSize(const ASTContext &C,
+                                    const OMPExecutableDirective &D) {
+  const OMPExecutableDirective *Dir = &D;
+  if (!isOpenMPTeamsDirective(D.getDirectiveKind()) &&
+      !isOpenMPParallelDirective(D.getDirectiveKind())) {
+    const auto *CS = cast<CapturedStmt>(D.getAssociatedStmt());
+    if (D.hasClausesOfKind<OMPDependClause>())
+      CS = cast<CapturedStmt>(CS->getCapturedStmt());
+    const auto *NestedDir = dyn_cast_or_null<OMPExecutableDirective>(
+        ignoreCompoundStmts(CS->getCapturedStmt()));
+    if (!NestedDir || !onlyOneStmt(CS->getCapturedStmt()) ||
+        !isOpenMPTeamsDirective(NestedDir->getDirectiveKind()))
+      return 0;
+    Dir = NestedDir;
+  }
+
+  unsigned TeamSize = 0;
+  auto &&AddUpperBound = [&C, &TeamSize](const Expr *E) {
+    llvm::APSInt Value;
+    if (!E->EvaluateAsInt(Value, C) || Value.isNonPositive() ||
+        Value.getActiveBits() > 31)
+      return;
+    unsigned Bound = Value.getZExtValue();
+    if (TeamSize == 0 || Bound < TeamSize)
+      TeamSize = Bound;
+  };
+  if (const auto *TL = Dir->getSingleClause<OMPThreadLimitClause>())
+    AddUpperBound(TL->getThreadLimit());
+  if (const auto *NT = Dir->getSingleClause<OMPNumThreadsClause>())
+    AddUpperBound(NT->getNumThreads());
+  return TeamSize;
+}
+
+// Annotate kernel \a Fn with launch bounds when the number of threads per
+// team of target directive \a D is known at compile time, so that ptxas
+// allocates registers for the actual block size.  Generic kernels are
+// launched with an additional warp for the master thread.
+static void setKernelLaunchBounds(const CodeGenModule &CGM, llvm::Function *Fn,
+                                  const OMPExecutableDirective &D,
+                                  CGOpenMPRuntimeNVPTX::ExecutionMode Mode) {
+  unsigned TeamSize = getConstantTeamSize(CGM.getContext(), D);
+  if (TeamSize == 0)
+    return;
+
+  unsigned MaxThreads = TeamSize;
+  if (Mode == CGOpenMPRuntimeNVPTX::ExecutionMode::GENERIC) {
+    if (TeamSize > DS_Max_Worker_Threads)
+      return;
+    MaxThreads += DS_Max_Worker_Warp_Size;
+  } else if (TeamSize > DS_Max_Worker_Threads + DS_Max_Worker_Warp_Size) {
+    return;
+  }
+  addNVVMMetadata(Fn, "maxntidx", MaxThreads);
+
+  // A minimum number of resident teams lets ptxas derive a register cap
+  // from the launch bounds.
+  if (unsigned MinTeams = CGM.getCodeGenOpts().OpenMPMinTeamsPerSM)
+    addNVVMMetadata(Fn, "minctasm", MinTeams);
+}
+
+// Return true if \a S may write memory that it can only reach through a
+// pointer or reference to const: it casts the constness away or hands a
+// pointer or reference to a function that might.
+static bool mayWriteThroughConst(const Stmt *S) {
+  if (!S)
+    return false;
+  if (isa<CXXConstCastExpr>(S))
+    return true;
+  if (const auto *CE = dyn_cast<ExplicitCastExpr>(S)) {
+    QualType From = CE->getSubExpr()->getType();
+    QualType To = CE->getTypeAsWritten();
+    if (From->isPointerType() && To->isPointerType() &&
+        From->getPointeeType().isConstQualified() &&
+        !To->getPointeeType().isConstQualified())
+      return true;
+    if (To->isReferenceType() && From.isConstQualified() &&
+        !To->getPointeeType().isConstQualified())
+      return true;
+  }
+  if (isa<CXXMemberCallExpr>(S))
+    return true;
+  if (const auto *CE = dyn_cast<CXXConstructExpr>(S))
+    if (!CE->getConstructor()->isTrivial())
+      return true;
+  if (const auto *CE = dyn_cast<CallExpr>(S)) {
+    if (!CE->getBuiltinCallee())
+      for (const Expr *Arg : CE->arguments())
+        if (Arg->getType()->isPointerType() || Arg->isGLValue())
+          return true;
+  }
+  for (const Stmt *Child : S->children())
+    if (mayWriteThroughConst(Child))
+      return true;
+  return false;
+}
+
+// Mark the parameters of kernel \a Fn that point to const data mapped 'to'
+// by target directive \a D readonly.  Together with noalias this lets the
+// backend load them through the read-only data cache (ld.global.nc).
+static void setReadOnlyMapParameters(const CodeGenModule &CGM,
+                                     const OMPExecutableDirective &D,
+                                     llvm::Function *Fn) {
+  // A list item is read-only if every map of it is a 'to' map.
+  llvm::DenseMap<const ValueDecl *, bool> ToOnlyDecls;
+  for (const auto *C : D.getClausesOfKind<OMPMapClause>())
+    for (const auto &L : C->component_lists()) {
+      if (!L.first)
+        continue;
+      auto It = ToOnlyDecls.insert({L.first->getCanonicalDecl(), true}).first;
+      It->second = It->second && C->getMapType() == OMPC_MAP_to;
+    }
+  if (ToOnlyDecls.empty())
+    return;
+
+  const auto *CS = cast<CapturedStmt>(D.getAssociatedStmt());
+  if (D.hasClausesOfKind<OMPDependClause>())
+    CS = cast<CapturedStmt>(CS->getCapturedStmt());
+  if (mayWriteThroughConst(CS->getCapturedStmt()))
+    return;
+
+  // The parameters follow the order of the captures of the region, see
+  // CodeGenFunction::GenerateOpenMPCapturedStmtParameters.
+  auto ArgIt = Fn->arg_begin();
+  for (const auto &Cap : CS->captures()) {
+    if (ArgIt == Fn->arg_end())
+      break;
+    const VarDecl *VD = nullptr;
+    if (Cap.capturesVariable() || Cap.capturesVariableByCopy()) {
+      VD = Cap.getCapturedVar();
+      if (auto *C = dyn_cast<OMPCapturedExprDecl>(VD))
+        if (C->getCaptureLevel() < 1)
+          continue;
+    }
+    llvm::Argument &Arg = *ArgIt++;
+    if (!VD || !Arg.getType()->isPointerTy())
+      continue;
+    auto It = ToOnlyDecls.find(VD->getCanonicalDecl());
+    if (It == ToOnlyDecls.end() || !It->second)
+      continue;
+    // Pointers are passed by value, other variables by reference.
+    QualType PointeeTy = VD->getType().getNonReferenceType();
+    if (Cap.capturesVariableByCopy()) {
+      if (!PointeeTy->isPointerType())
+        continue;
+      PointeeTy = PointeeTy->getPointeeType();
+    }
+    if (PointeeTy.isConstant(CGM.getContext()))
+      Arg.addAttr(llvm::Attribute::ReadOnly);
+  }
+}
+
 void CGOpenMPRuntimeNVPTX::emitSPMDEntryHeader(
     CodeGenFunction &CGF, EntryFunctionState &EST,
     const OMPExecutableDirective &D) {
@@ -1749,6 +2426,7 @@ void CGOpenMPRuntimeNVPTX::emitSPMDEntryHeader(
   CGF.EmitBranch(ExecuteBB);
 
   CGF.EmitBlock(ExecuteBB);
+  EST.CycleCounterStart = emitCycleCounterStart(CGF);
 }
 
 void CGOpenMPRuntimeNVPTX::emitSPMDEntryFooter(CodeGenFunction &CGF,
@@ -1757,6 +2435,8 @@ void CGOpenMPRuntimeNVPTX::emitSPMDEntryFooter(CodeGenFunction &CGF,
   CGF.EmitBranch(OMPDeInitBB);
 
   CGF.EmitBlock(OMPDeInitBB);
+  emitCycleCounterStop(CGF, EST.CycleCounterStart, KernelCycleCounters,
+                       CC_Kernel);
   if (EST.TP.requiresOMPRuntime()) {
     // DeInitialize the OMP state in the runtime; called by all active threads.
     CGF.EmitRuntimeCall(
@@ -2436,6 +3116,27 @@ public:
 };
 }; // namespace
 
+/// Return the size of the per-team pool to preallocate for the data shared by
+/// the master thread of a generic kernel, or zero if the initial runtime slot
+/// is enough.  The pool covers the data sharing frames
+/// of the parallel regions lexically nested in the kernel, so that pushing
+/// them is a bump of the stack pointer instead of a device malloc.  Frames of
+/// regions reached through function calls still grow the slots on demand.
+static unsigned getDataSharingPoolSize(CodeGenModule &CGM,
+                                       bool RequiresOMPRuntime,
+                                       unsigned MasterSharedDataSize) {
+  if (!CGM.getCodeGenOpts().OpenMPDataSharingPool || !RequiresOMPRuntime)
+    return 0;
+  unsigned Size = MasterSharedDataSize;
+  if (Size <= DS_Slot_Size)
+    return 0;
+  // A frame of this size is laid out in static shared memory instead.
+  if (CGM.getCodeGenOpts().OpenMPStaticDataSharing &&
+      Size <= DS_Max_Static_Frame_Size)
+    return 0;
+  return llvm::alignTo(Size, DS_Slot_Size);
+}
+
 void CGOpenMPRuntimeNVPTX::emitGenericKernel(const OMPExecutableDirective &D,
                                              const TargetKernelProperties &TP,
                                              StringRef ParentName,
@@ -2450,6 +3151,9 @@ void CGOpenMPRuntimeNVPTX::emitGenericKernel(const OMPExecutableDirective &D,
   WorkerFunctionState WST(CGM, TP, D.getLocStart());
   Work.clear();
   WrapperFunctionsMap.clear();
+  if (unsigned PoolSize = getDataSharingPoolSize(
+          CGM, TP.requiresOMPRuntime(), TP.masterSharedDataSize()))
+    DataSharingPool = createDataSharingPool(PoolSize);
 
   // Emit target region as a standalone region.
   class NVPTXPrePostActionTy : public PrePostActionTy {
@@ -2471,6 +3175,9 @@ void CGOpenMPRuntimeNVPTX::emitGenericKernel(const OMPExecutableDirective &D,
   } Action(*this, EST, WST);
   CodeGen.setAction(Action);
 
+  if (CGM.getCodeGenOpts().OpenMPNVPTXCycleCounters)
+    KernelCycleCounters = createCycleCounters(CC_NumPhases);
+
   emitTargetOutlinedFunctionHelper(D, ParentName, OutlinedFn, OutlinedFnID,
                                    IsOffloadEntry, CodeGen,
                                    /* CaptureLevel = */ 1);
@@ -2481,7 +3188,20 @@ void CGOpenMPRuntimeNVPTX::emitGenericKernel(const OMPExecutableDirective &D,
   // Now change the name of the worker function to correspond to this target
   // region's entry function.
   WST.WorkerFn->setName(OutlinedFn->getName() + "_worker");
+  if (KernelCycleCounters) {
+    KernelCycleCounters->setName(OutlinedFn->getName() + "_cycles");
+    KernelCycleCounters = nullptr;
+  }
+  if (WST.ParallelCycleCounters)
+    WST.ParallelCycleCounters->setName(OutlinedFn->getName() +
+                                       "_parallel_cycles");
+  if (DataSharingPool) {
+    DataSharingPool->setName(OutlinedFn->getName() + "_data_sharing_pool");
+    DataSharingPool = nullptr;
+  }
 
+  if (IsOffloadEntry)
+    TargetRegionKernels.push_back(OutlinedFn);
   return;
 }
 
@@ -2494,6 +3214,8 @@ void CGOpenMPRuntimeNVPTX::emitSPMDKernel(const OMPExecutableDirective &D,
                                           const RegionCodeGenTy &CodeGen) {
   ExecutionModeRAII ModeRAII(
       CurrMode, CGOpenMPRuntimeNVPTX::ExecutionMode::SPMD, IsOrphaned, false);
+  RequiresL0JoinBarrier = TP.executesTeamsRedundantly();
+  ConstantTeamSize = getConstantTeamSize(CGM.getContext(), D);
   EntryFunctionState EST(CGM, TP);
 
   // Emit target region as a standalone region.
@@ -2515,9 +3237,19 @@ void CGOpenMPRuntimeNVPTX::emitSPMDKernel(const OMPExecutableDirective &D,
     }
   } Action(*this, EST, D);
   CodeGen.setAction(Action);
+  if (CGM.getCodeGenOpts().OpenMPNVPTXCycleCounters)
+    KernelCycleCounters = createCycleCounters(CC_NumPhases);
   emitTargetOutlinedFunctionHelper(D, ParentName, OutlinedFn, OutlinedFnID,
                                    IsOffloadEntry, CodeGen,
                                    /* CaptureLevel = */ 1);
+  if (KernelCycleCounters) {
+    KernelCycleCounters->setName(OutlinedFn->getName() + "_cycles");
+    KernelCycleCounters = nullptr;
+  }
+  if (IsOffloadEntry)
+    TargetRegionKernels.push_back(OutlinedFn);
+  RequiresL0JoinBarrier = false;
+  ConstantTeamSize = 0;
   return;
 }
 
@@ -2570,6 +3302,8 @@ void CGOpenMPRuntimeNVPTX::emitTargetOutlinedFunction(
   SetTargetKernelProperties(CGM, OutlinedFn->getName(), Mode,
                             TP.getReductionVariableCount(),
                             TP.getReductionSizeInBytes());
+  setKernelLaunchBounds(CGM, OutlinedFn, D, Mode);
+  setReadOnlyMapParameters(CGM, D, OutlinedFn);
 
   CGM.getContext().getDiagnostics().Report(
       D.getLocStart(),
@@ -2583,6 +3317,13 @@ void CGOpenMPRuntimeNVPTX::emitTargetOutlinedFunction(
         TP.requiresOMPRuntimeReason().Loc,
         diag::remark_fe_backend_optimization_remark_analysis_target_runtime)
         << TP.requiresOMPRuntimeReason().RC;
+  if (Mode == CGOpenMPRuntimeNVPTX::ExecutionMode::GENERIC) {
+    auto Reason = getGenericModeReason(CGM, D);
+    CGM.getContext().getDiagnostics().Report(
+        Reason.second,
+        diag::remark_fe_backend_optimization_remark_analysis_target_generic)
+        << Reason.first;
+  }
 }
 
 void CGOpenMPRuntimeNVPTX::emitNumThreadsClause(CodeGenFunction &CGF,
@@ -3096,6 +3837,21 @@ void CGOpenMPRuntimeNVPTX::createDataSharingInfo(CodeGenFunction &CGF) {
 
   assert(!CapturedDirs.empty() && "Expecting at least one parallel region!");
 
+  // Check if a scalar local only has its value read in the regions, in which
+  // case the regions can work on a copy made when they are forked.
+  auto &&IsReadOnlyInRegions = [&CapturedDirs](const VarDecl *VD) {
+    if (!VD->getType()->isScalarType() ||
+        VD->getType().isVolatileQualified() || VD->hasAttr<AlignedAttr>())
+      return false;
+    llvm::SmallPtrSet<const VarDecl *, 1> Vars;
+    Vars.insert(VD->getCanonicalDecl());
+    for (auto *Dir : CapturedDirs)
+      if (clausesMayModifyVar(Dir, Vars) ||
+          mayModifyReplicatedVar(Dir->getAssociatedStmt(), Vars))
+        return false;
+    return true;
+  };
+
   // Scan the captured statements and generate a record to contain all the data
   // to be shared. Make sure we do not share the same thing twice.
   auto *SharedMasterRD =
@@ -3172,6 +3928,12 @@ void CGOpenMPRuntimeNVPTX::createDataSharingInfo(CodeGenFunction &CGF) {
           // i.e., consider it a reference to something that can be shared.
           else if (OrigVD->getType()->isReferenceType())
             DST = DataSharingInfo::DST_Ref;
+          // If the regions only read the variable, the function can keep
+          // using its own storage and share a copy of the value.
+          else if (CGM.getCodeGenOpts().OpenMPCopyReadOnlyCaptures &&
+                   !CurField->hasCapturedVLAType() && OrigVD == CurVD &&
+                   isa<llvm::AllocaInst>(Val) && IsReadOnlyInRegions(OrigVD))
+            DST = DataSharingInfo::DST_Copy;
         }
       }
 
@@ -3182,6 +3944,14 @@ void CGOpenMPRuntimeNVPTX::createDataSharingInfo(CodeGenFunction &CGF) {
       AlreadySharedDecls.insert(CurVD);
       Info.add(CurVD, DST);
 
+      // Report the locals whose storage leaves the stack of the thread.
+      if (DST == DataSharingInfo::DST_Val && CurVD &&
+          !CurField->hasCapturedVLAType())
+        CGM.getContext().getDiagnostics().Report(
+            CurCap->getLocation(),
+            diag::remark_fe_backend_optimization_remark_analysis_target_globalized)
+            << CurVD << getOpenMPDirectiveName(Dir->getDirectiveKind());
+
       if (DST == DataSharingInfo::DST_Ref)
         ElemTy = C.getPointerType(ElemTy);
 
@@ -3440,36 +4210,72 @@ void CGOpenMPRuntimeNVPTX::createDataSharingPerFunctionInfrastructure(
                               (*ArgsIt)->getType()->getAs<PointerType>()));
   }
 
+  // An entry point is only ever executed by the team master at level 0 and
+  // cannot be reentered, so it pushes exactly one master frame.  If the size
+  // of that frame is known at compile time it can be laid out in a __shared__
+  // buffer owned by the kernel instead of being obtained from the runtime
+  // slot allocator.  Functions that are not entry points may recurse or be
+  // reached at any nesting level and keep using the runtime.
+  CharUnits MasterRecordSize = Ctx.getTypeSizeInChars(DSI.MasterRecordType);
+  bool UseStaticFrame =
+      IsEntryPoint && CGM.getCodeGenOpts().OpenMPStaticDataSharing &&
+      !DSI.MasterRecordType->isVariablyModifiedType() &&
+      DSI.VLADeclMap.empty() &&
+      MasterRecordSize.getQuantity() <= DS_Max_Static_Frame_Size;
+  EnclosingFuncInfo.UsesStaticFrame = UseStaticFrame;
+  llvm::GlobalVariable *StaticFrame = nullptr;
+  if (UseStaticFrame) {
+    auto *FrameTy = CGM.getTypes().ConvertTypeForMem(DSI.MasterRecordType);
+    StaticFrame = new llvm::GlobalVariable(
+        CGM.getModule(), FrameTy, /*isConstant=*/false,
+        llvm::GlobalValue::InternalLinkage, llvm::UndefValue::get(FrameTy),
+        EnclosingCGF.CurFn->getName() + ".static_data_share",
+        /*InsertBefore=*/nullptr, llvm::GlobalVariable::NotThreadLocal,
+        ADDRESS_SPACE_SHARED);
+    StaticFrame->setAlignment(
+        Ctx.getTypeAlignInChars(DSI.MasterRecordType).getQuantity());
+  }
+
   auto &&L0ParallelGen = [this, &DSI, MasterRD, &Ctx, SavedSlot, SavedStack, CD,
                           SavedFrame, SavedActiveThreads, &NewAddressPtrs,
-                          &OrigAddresses](CodeGenFunction &CGF,
-                                          PrePostActionTy &) {
+                          &OrigAddresses, MasterRecordSize,
+                          StaticFrame](CodeGenFunction &CGF,
+                                       PrePostActionTy &) {
     auto &Bld = CGF.Builder;
 
-    // In the Level 0 regions, we use the master record to get the data.
-    auto *DataSize = llvm::ConstantInt::get(
-        CGM.SizeTy, Ctx.getTypeSizeInChars(DSI.MasterRecordType).getQuantity());
-    auto *DefaultDataSize = llvm::ConstantInt::get(CGM.SizeTy, DS_Slot_Size);
-
-    llvm::Value *Args[] = {SavedSlot,
-                           SavedStack,
-                           SavedFrame,
-                           SavedActiveThreads,
-                           DataSize,
-                           DefaultDataSize,
-                           Bld.getInt16(isOMPRuntimeInitialized() ? 1 : 0)};
-    auto *DataShareAddr = CGF.EmitRuntimeCall(
-        createNVPTXRuntimeFunction(
-            OMPRTL_NVPTX__kmpc_data_sharing_environment_begin),
-        Args, "data_share_master_addr");
     auto DataSharePtrQTy = Ctx.getPointerType(DSI.MasterRecordType);
     auto *DataSharePtrTy = CGF.getTypes().ConvertTypeForMem(DataSharePtrQTy);
-    auto *CasterDataShareAddr =
-        Bld.CreateBitOrPointerCast(DataShareAddr, DataSharePtrTy);
+    llvm::Value *CasterDataShareAddr = StaticFrame;
+    if (!StaticFrame) {
+      // In the Level 0 regions, we use the master record to get the data.
+      auto *DataSize =
+          llvm::ConstantInt::get(CGM.SizeTy, MasterRecordSize.getQuantity());
+      auto *DefaultDataSize = llvm::ConstantInt::get(CGM.SizeTy, DS_Slot_Size);
+
+      llvm::Value *Args[] = {SavedSlot,
+                             SavedStack,
+                             SavedFrame,
+                             SavedActiveThreads,
+                             DataSize,
+                             DefaultDataSize,
+                             Bld.getInt16(isOMPRuntimeInitialized() ? 1 : 0)};
+      llvm::Value *DataSharingStart = emitCycleCounterStart(CGF);
+      auto *DataShareAddr = CGF.EmitRuntimeCall(
+          createNVPTXRuntimeFunction(
+              OMPRTL_NVPTX__kmpc_data_sharing_environment_begin),
+          Args, "data_share_master_addr");
+      emitCycleCounterStop(CGF, DataSharingStart, KernelCycleCounters,
+                           CC_DataSharing);
+      CasterDataShareAddr =
+          Bld.CreateBitOrPointerCast(DataShareAddr, DataSharePtrTy);
+    }
 
     // For each field, return the address by reference if it is not a reference
     // capture, otherwise copy the original pointer to the shared address space.
     // If it is a cast, we need to copy the pointee into shared memory.
+    // The master fills a static frame through shared pointers so that the
+    // stores do not go through the generic address space; only the addresses
+    // published to the region are converted.
     auto FI = MasterRD->field_begin();
     auto CapturesIt = DSI.CapturesValues.begin();
     auto NewAddressIt = NewAddressPtrs.begin();
@@ -3491,9 +4297,15 @@ void CGOpenMPRuntimeNVPTX::createDataSharingPerFunctionInfrastructure(
             CGF.MakeNaturalAlignAddrLValue(NewAddr, FI->getType());
         CGF.EmitStoreOfScalar(PointeeVal, NewAddrLVal);
       } // fallthrough.
-      case DataSharingInfo::DST_Val: {
-        CGF.EmitStoreOfScalar(NewAddr, *NewAddressIt, /*Volatile=*/false,
-                              Ctx.getPointerType(FI->getType()));
+      case DataSharingInfo::DST_Val:
+      case DataSharingInfo::DST_Copy: {
+        QualType PtrTy = Ctx.getPointerType(FI->getType());
+        llvm::Value *PublishedAddr = NewAddr;
+        if (StaticFrame)
+          PublishedAddr =
+              Bld.CreateAddrSpaceCast(NewAddr, CGF.ConvertTypeForMem(PtrTy));
+        CGF.EmitStoreOfScalar(PublishedAddr, *NewAddressIt, /*Volatile=*/false,
+                              PtrTy);
         ++NewAddressIt;
       } break;
       }
@@ -3520,10 +4332,13 @@ void CGOpenMPRuntimeNVPTX::createDataSharingPerFunctionInfrastructure(
                            DataSize,
                            DefaultDataSize,
                            /*isOMPRuntimeInitialized=*/Bld.getInt16(1)};
+    llvm::Value *DataSharingStart = emitCycleCounterStart(CGF);
     auto *DataShareAddr = CGF.EmitRuntimeCall(
         createNVPTXRuntimeFunction(
             OMPRTL_NVPTX__kmpc_data_sharing_environment_begin),
         Args, "data_share_master_addr");
+    emitCycleCounterStop(CGF, DataSharingStart, KernelCycleCounters,
+                         CC_DataSharing);
     auto DataSharePtrQTy = Ctx.getPointerType(DSI.WorkerWarpRecordType);
     auto *DataSharePtrTy = CGF.getTypes().ConvertTypeForMem(DataSharePtrQTy);
     auto *CasterDataShareAddr =
@@ -3555,7 +4370,8 @@ void CGOpenMPRuntimeNVPTX::createDataSharingPerFunctionInfrastructure(
             CGF.MakeNaturalAlignAddrLValue(NewAddr, FI->getType());
         CGF.EmitStoreOfScalar(PointeeVal, NewAddrLVal);
       } // fallthrough.
-      case DataSharingInfo::DST_Val: {
+      case DataSharingInfo::DST_Val:
+      case DataSharingInfo::DST_Copy: {
         CGF.EmitStoreOfScalar(NewAddr, *NewAddressIt, /*Volatile=*/false,
                               Ctx.getPointerType(FI->getType()));
         ++NewAddressIt;
@@ -3610,6 +4426,22 @@ void CGOpenMPRuntimeNVPTX::createDataSharingPerFunctionInfrastructure(
 
     assert(OriginalVal && "Can't obtain value to replace with??");
 
+    // A copied value keeps its storage. Its shared address is returned in a
+    // temporary that is used to copy the value before each fork.
+    if (DSI.CapturesValues[i].second == DataSharingInfo::DST_Copy) {
+      const VarDecl *VD = DSI.CapturesValues[i].first;
+      Address SharedAddrPtr = EnclosingCGF.CreateTempAlloca(
+          CGM.getTypes().ConvertTypeForMem(Ctx.getPointerType(FI->getType())),
+          EnclosingCGF.getPointerAlign(), VD->getName() + ".shared");
+      EnclosingFuncInfo.CopiedValues.push_back(std::make_pair(
+          Address(OriginalVal, Ctx.getDeclAlign(VD)), SharedAddrPtr));
+      EnclosingFuncInfo.ValuesToBeReplaced.push_back(
+          std::make_pair(SharedAddrPtr.getPointer(), /*IsReference=*/true));
+      EnclosingFuncInfo.ValuesToBeReplaced.push_back(
+          std::make_pair(OriginalVal, /*IsReference=*/true));
+      continue;
+    }
+
     EnclosingFuncInfo.ValuesToBeReplaced.push_back(std::make_pair(
         OriginalVal, DSI.CapturesValues[i].second == DataSharingInfo::DST_Ref));
   }
@@ -3620,6 +4452,19 @@ void CGOpenMPRuntimeNVPTX::createDataSharingPerFunctionInfrastructure(
   EnclosingFuncInfo.InitializationFunction = CGF.CurFn;
 }
 
+void CGOpenMPRuntimeNVPTX::emitDataSharingValueCopies(CodeGenFunction &CGF) {
+  auto It = DataSharingFunctionInfoMap.find(CGF.CurFn);
+  if (It == DataSharingFunctionInfoMap.end())
+    return;
+
+  auto &Bld = CGF.Builder;
+  for (auto &CV : It->second.CopiedValues) {
+    llvm::Value *Val = Bld.CreateLoad(CV.first);
+    Address SharedAddr(Bld.CreateLoad(CV.second), CV.first.getAlignment());
+    Bld.CreateStore(Val, SharedAddr);
+  }
+}
+
 // Store the data sharing address of the provided variable (null for 'this').
 static void CreateAddressStoreForVariable(
     CodeGenFunction &CGF, const VarDecl *VD, QualType Ty,
@@ -4087,12 +4932,21 @@ void CGOpenMPRuntimeNVPTX::emitGenericParallelCall(
   // Emit code that does the data sharing changes in the beginning of the
   // function.
   createDataSharingPerFunctionInfrastructure(CGF);
+  emitDataSharingValueCopies(CGF);
 
   auto *RTLoc = emitUpdateLocation(CGF, Loc);
   auto &&L0ParallelGen = [this, WFn](CodeGenFunction &CGF, PrePostActionTy &) {
     CGBuilderTy &Bld = CGF.Builder;
 
-    auto ID = Bld.CreateBitOrPointerCast(WFn, CGM.Int8PtrTy);
+    // Parallel regions in the lexical scope of the target are known to the
+    // worker loop and are identified by their position in 'Work'.  Orphaned
+    // parallel regions pass the address of the outlined function instead.
+    llvm::Value *ID;
+    if (IsOrphaned)
+      ID = Bld.CreateBitOrPointerCast(WFn, CGM.Int8PtrTy);
+    else
+      ID = llvm::ConstantExpr::getIntToPtr(
+          Bld.getInt64(getParallelWorkID(Work.size())), CGM.Int8PtrTy);
 
     // Prepare for parallel region. Indicate the outlined function.
     llvm::Value *IsOMPRuntimeInitialized =
@@ -4109,7 +4963,8 @@ void CGOpenMPRuntimeNVPTX::emitGenericParallelCall(
     SyncCTAThreads(CGF);
 
     // Remember for post-processing in worker loop.
-    Work.push_back(WFn);
+    if (!IsOrphaned)
+      Work.push_back(WFn);
   };
   auto &&L1ParallelGen = [this, WFn, Loc](CodeGenFunction &CGF,
                                           PrePostActionTy &) {
@@ -4249,6 +5104,12 @@ void CGOpenMPRuntimeNVPTX::emitSPMDParallelCall(
     OutlinedFnArgs.push_back(ZeroAddr.getPointer());
     OutlinedFnArgs.append(CapturedVars.begin(), CapturedVars.end());
     emitOutlinedFunctionCall(CGF, Loc, OutlinedFn, OutlinedFnArgs);
+
+    // All threads execute the sequential part of a redundantly executed
+    // teams region, so join them before continuing past the parallel region.
+    if (RequiresL0JoinBarrier)
+      emitBarrierCall(CGF, Loc, OMPD_unknown, /*EmitChecks=*/false,
+                      /*ForceSimpleCall=*/true);
   } else {
     emitGenericParallelCall(CGF, Loc, OutlinedFn, CapturedVars, IfCond);
   }
@@ -4285,6 +5146,7 @@ void CGOpenMPRuntimeNVPTX::emitSimdCall(CodeGenFunction &CGF,
   // Emit code that does the data sharing changes in the beginning of the
   // function.
   createDataSharingPerFunctionInfrastructure(CGF);
+  emitDataSharingValueCopies(CGF);
 
   auto &&L1SimdGen = [this, WFn, Loc](CodeGenFunction &CGF, PrePostActionTy &) {
     CGBuilderTy &Bld = CGF.Builder;
@@ -4466,6 +5328,501 @@ void CGOpenMPRuntimeNVPTX::emitCriticalRegion(
   CGF.EmitBlock(ExitBB, /*IsFinished=*/true);
 }
 
+// Return true if evaluating \a S only reads constants and variables that are
+// local to the executing thread, so that it cannot observe memory another
+// thread updates inside a critical region.
+static bool readsOnlyThreadLocalData(const Stmt *S) {
+  if (!S)
+    return true;
+  if (const auto *DRE = dyn_cast<DeclRefExpr>(S)) {
+    if (const auto *VD = dyn_cast<VarDecl>(DRE->getDecl()))
+      return (VD->hasLocalStorage() &&
+              !DRE->refersToEnclosingVariableOrCapture()) ||
+             VD->getType().isConstQualified();
+    return true;
+  }
+  if (isa<ArraySubscriptExpr>(S) || isa<MemberExpr>(S) ||
+      isa<CXXThisExpr>(S) || isa<CallExpr>(S))
+    return false;
+  if (const auto *UO = dyn_cast<UnaryOperator>(S))
+    if (UO->getOpcode() == UO_Deref)
+      return false;
+  for (const Stmt *Child : S->children())
+    if (!readsOnlyThreadLocalData(Child))
+      return false;
+  return true;
+}
+
+static bool isSameLValue(const ASTContext &C, const Expr *LHS,
+                         const Expr *RHS) {
+  llvm::FoldingSetNodeID LHSId, RHSId;
+  LHS->IgnoreParenImpCasts()->Profile(LHSId, C, /*Canonical=*/true);
+  RHS->IgnoreParenImpCasts()->Profile(RHSId, C, /*Canonical=*/true);
+  return LHSId == RHSId;
+}
+
+// Check if the statement \a S associated with a critical region is a single
+// update 'x binop= expr', 'x = x binop expr', 'x = expr binop x', '++x' or
+// 'x--' of an arithmetic scalar 'x' with '+', '-', '&', '|' or '^'.  On
+// success set \a X, the update value \a E (nullptr for increments and
+// decrements) and the operator \a BO.
+static bool getCriticalRegionUpdate(const ASTContext &C, const Stmt *S,
+                                    const Expr *&X, const Expr *&E,
+                                    BinaryOperatorKind &BO) {
+  while (const auto *CS = dyn_cast_or_null<CompoundStmt>(S)) {
+    if (CS->size() != 1)
+      return false;
+    S = CS->body_front();
+  }
+  const auto *Update = dyn_cast_or_null<Expr>(S);
+  if (!Update)
+    return false;
+  Update = Update->IgnoreParens();
+
+  if (const auto *UO = dyn_cast<UnaryOperator>(Update)) {
+    if (!UO->isIncrementDecrementOp())
+      return false;
+    X = UO->getSubExpr();
+    E = nullptr;
+    BO = UO->isIncrementOp() ? BO_Add : BO_Sub;
+  } else if (const auto *CAO = dyn_cast<CompoundAssignOperator>(Update)) {
+    X = CAO->getLHS();
+    E = CAO->getRHS();
+    BO = BinaryOperator::getOpForCompoundAssignment(CAO->getOpcode());
+    if (!C.hasSameUnqualifiedType(CAO->getComputationLHSType(),
+                                  X->getType()) ||
+        !C.hasSameUnqualifiedType(CAO->getComputationResultType(),
+                                  X->getType()))
+      return false;
+  } else if (const auto *Assign = dyn_cast<BinaryOperator>(Update)) {
+    if (Assign->getOpcode() != BO_Assign)
+      return false;
+    X = Assign->getLHS();
+    const auto *RHS =
+        dyn_cast<BinaryOperator>(Assign->getRHS()->IgnoreParenImpCasts());
+    if (!RHS || !C.hasSameUnqualifiedType(RHS->getType(), X->getType()))
+      return false;
+    BO = RHS->getOpcode();
+    if (isSameLValue(C, RHS->getLHS(), X))
+      E = RHS->getRHS();
+    else if (BO != BO_Sub && isSameLValue(C, RHS->getRHS(), X))
+      E = RHS->getLHS();
+    else
+      return false;
+  } else {
+    return false;
+  }
+
+  X = X->IgnoreParens();
+  QualType XTy = X->getType();
+  switch (BO) {
+  case BO_Add:
+  case BO_Sub:
+    if (!XTy->isIntegerType() && !XTy->isRealFloatingType())
+      return false;
+    break;
+  case BO_And:
+  case BO_Or:
+  case BO_Xor:
+    if (!XTy->isIntegerType())
+      return false;
+    break;
+  default:
+    return false;
+  }
+  unsigned Size = C.getTypeSize(XTy);
+  if (XTy->isBooleanType() || XTy->isEnumeralType() ||
+      (Size != 32 && Size != 64))
+    return false;
+
+  // The location of 'x' may differ between threads, but computing it must
+  // not depend on data that is protected by the critical region.
+  if (const auto *ASE = dyn_cast<ArraySubscriptExpr>(X)) {
+    if (!isa<DeclRefExpr>(ASE->getBase()->IgnoreParenImpCasts()) ||
+        ASE->getIdx()->HasSideEffects(C) ||
+        !readsOnlyThreadLocalData(ASE->getIdx()))
+      return false;
+  } else if (!isa<DeclRefExpr>(X)) {
+    return false;
+  }
+
+  return !E || (C.hasSameUnqualifiedType(E->getType(), XTy) &&
+                !E->HasSideEffects(C) && readsOnlyThreadLocalData(E));
+}
+
+bool CGOpenMPRuntimeNVPTX::emitCriticalRegionAsAtomicUpdate(
+    CodeGenFunction &CGF, StringRef CriticalName,
+    const RegionCodeGenTy &CriticalOpGen, const Stmt *CriticalBody,
+    SourceLocation Loc, const Expr *Hint) {
+  if (!CGF.HaveInsertPoint())
+    return false;
+
+  CGBuilderTy &Bld = CGF.Builder;
+  llvm::GlobalVariable *&Flag = CriticalAtomicUpdateFlags[CriticalName];
+  const Expr *X = nullptr;
+  const Expr *E = nullptr;
+  BinaryOperatorKind BO = BO_Comma;
+  if (!getCriticalRegionUpdate(CGM.getContext(), CriticalBody, X, E, BO)) {
+    // The regions with this name that were emitted as atomic updates must
+    // take the serialized path as well.
+    SerializedCriticalNames.insert(CriticalName);
+    if (Flag)
+      Flag->setInitializer(Bld.getFalse());
+    return false;
+  }
+
+  if (!Flag) {
+    Flag = new llvm::GlobalVariable(
+        CGM.getModule(), Bld.getInt1Ty(), /*isConstant=*/true,
+        llvm::GlobalValue::InternalLinkage,
+        SerializedCriticalNames.count(CriticalName) ? Bld.getFalse()
+                                                    : Bld.getTrue(),
+        Twine(".omp.critical.atomic.", CriticalName));
+  }
+
+  llvm::BasicBlock *AtomicBB = CGF.createBasicBlock("omp.critical.atomic");
+  llvm::BasicBlock *SerialBB = CGF.createBasicBlock("omp.critical.serial");
+  llvm::BasicBlock *EndBB = CGF.createBasicBlock("omp.critical.end");
+  Bld.CreateCondBr(
+      Bld.CreateLoad(Address(Flag, CharUnits::One()), "is_atomic_critical"),
+      AtomicBB, SerialBB);
+
+  CGF.EmitBlock(AtomicBB);
+  emitCriticalRegionUpdate(CGF, X, E, BO, Loc);
+  CGF.EmitBranch(EndBB);
+
+  CGF.EmitBlock(SerialBB);
+  emitCriticalRegion(CGF, CriticalName, CriticalOpGen, Loc, Hint);
+  CGF.EmitBranch(EndBB);
+
+  CGF.EmitBlock(EndBB, /*IsFinished=*/true);
+  return true;
+}
+
+/// \brief Emits the update 'x' = 'x' BO 'E' of a critical region as an
+/// atomic update, with one atomic per warp where possible.
+void CGOpenMPRuntimeNVPTX::emitCriticalRegionUpdate(CodeGenFunction &CGF,
+                                                    const Expr *X,
+                                                    const Expr *E,
+                                                    BinaryOperatorKind BO,
+                                                    SourceLocation Loc) {
+  CGBuilderTy &Bld = CGF.Builder;
+  QualType XTy = X->getType();
+  bool IsFloat = XTy->isRealFloatingType();
+  LValue XLValue = CGF.EmitLValue(X);
+  llvm::Type *ValTy = CGF.ConvertTypeForMem(XTy);
+  llvm::Value *Val = E ? CGF.EmitScalarExpr(E)
+                       : IsFloat ? llvm::ConstantFP::get(ValTy, 1.0)
+                                 : llvm::ConstantInt::get(ValTy, 1);
+
+  // 'x' = 'x' BO 'Val' for the values of the update and of the combination
+  // of the updates of a warp.  Subtractions are combined by adding the
+  // subtrahends.
+  auto &&EmitBinOp = [&Bld, IsFloat](BinaryOperatorKind BO, llvm::Value *LHS,
+                                     llvm::Value *RHS) -> llvm::Value * {
+    switch (BO) {
+    case BO_Add:
+      return IsFloat ? Bld.CreateFAdd(LHS, RHS) : Bld.CreateAdd(LHS, RHS);
+    case BO_Sub:
+      return IsFloat ? Bld.CreateFSub(LHS, RHS) : Bld.CreateSub(LHS, RHS);
+    case BO_And:
+      return Bld.CreateAnd(LHS, RHS);
+    case BO_Or:
+      return Bld.CreateOr(LHS, RHS);
+    case BO_Xor:
+      return Bld.CreateXor(LHS, RHS);
+    default:
+      llvm_unreachable("Unexpected critical region update operator.");
+    }
+  };
+  auto &&EmitAtomicUpdate = [&CGF, &XLValue, &EmitBinOp, BO,
+                             Loc](llvm::Value *UpdateVal) {
+    auto &&CommonGen = [&EmitBinOp, BO, UpdateVal](RValue XRValue) {
+      return RValue::get(EmitBinOp(BO, XRValue.getScalarVal(), UpdateVal));
+    };
+    (void)CGF.EmitOMPAtomicSimpleUpdateExpr(
+        XLValue, RValue::get(UpdateVal), BO, /*IsXLHSInRHSPart=*/true,
+        llvm::AtomicOrdering::Monotonic, Loc, CommonGen);
+  };
+
+  // Warp shuffles are only used for 32-bit values and where all threads of a
+  // warp execute in lock step.
+  if (CGM.getContext().getTypeSize(XTy) != 32 || IsVolta(CGM)) {
+    EmitAtomicUpdate(Val);
+    return;
+  }
+
+  llvm::BasicBlock *CheckBB = CGF.createBasicBlock("omp.critical.check");
+  llvm::BasicBlock *AggregateBB =
+      CGF.createBasicBlock("omp.critical.aggregate");
+  llvm::BasicBlock *LeaderBB = CGF.createBasicBlock("omp.critical.leader");
+  llvm::BasicBlock *LaneBB = CGF.createBasicBlock("omp.critical.lane");
+  llvm::BasicBlock *DoneBB = CGF.createBasicBlock("omp.critical.done");
+
+  // Aggregate the updates only if the whole warp is active.
+  llvm::Value *Mask = getNVPTXWarpActiveThreadsMask(CGF);
+  llvm::Value *IsFullWarp = Bld.CreateICmpEQ(
+      Mask, Bld.getInt32(~0u), "is_full_warp");
+  Bld.CreateCondBr(IsFullWarp, CheckBB, LaneBB);
+
+  // Check that all threads of the warp update the same location by comparing
+  // with the address of lane 0.
+  CGF.EmitBlock(CheckBB);
+  llvm::Value *ShflIdx = llvm::Intrinsic::getDeclaration(
+      &CGM.getModule(), llvm::Intrinsic::nvvm_shfl_idx_i32);
+  llvm::Value *ShflBflyI32 = llvm::Intrinsic::getDeclaration(
+      &CGM.getModule(), llvm::Intrinsic::nvvm_shfl_bfly_i32);
+  llvm::Value *Clamp = Bld.getInt32(DS_Max_Worker_Warp_Size_Log2_Mask);
+  llvm::Value *Addr = Bld.CreatePtrToInt(XLValue.getPointer(), CGM.Int64Ty);
+  llvm::Value *AddrLo = Bld.CreateTrunc(Addr, CGM.Int32Ty);
+  llvm::Value *AddrHi = Bld.CreateTrunc(Bld.CreateLShr(Addr, 32), CGM.Int32Ty);
+  llvm::Value *SameLo = Bld.CreateICmpEQ(
+      AddrLo, CGF.EmitNounwindRuntimeCall(
+                  ShflIdx, {AddrLo, Bld.getInt32(/*SrcLane=*/0), Clamp}));
+  llvm::Value *SameHi = Bld.CreateICmpEQ(
+      AddrHi, CGF.EmitNounwindRuntimeCall(
+                  ShflIdx, {AddrHi, Bld.getInt32(/*SrcLane=*/0), Clamp}));
+  llvm::Value *Same =
+      Bld.CreateZExt(Bld.CreateAnd(SameLo, SameHi), CGM.Int32Ty);
+  // A butterfly reduction leaves the result in every lane.
+  for (unsigned Offset = 1; Offset < DS_Max_Worker_Warp_Size; Offset <<= 1)
+    Same = Bld.CreateAnd(
+        Same, CGF.EmitNounwindRuntimeCall(
+                  ShflBflyI32, {Same, Bld.getInt32(Offset), Clamp}));
+  Bld.CreateCondBr(Bld.CreateIsNotNull(Same, "is_same_location"), AggregateBB,
+                   LaneBB);
+
+  // Combine the updates of the warp and let lane 0 issue the atomic.
+  CGF.EmitBlock(AggregateBB);
+  llvm::Value *ShflBfly = llvm::Intrinsic::getDeclaration(
+      &CGM.getModule(), IsFloat ? llvm::Intrinsic::nvvm_shfl_bfly_f32
+                                : llvm::Intrinsic::nvvm_shfl_bfly_i32);
+  BinaryOperatorKind CombineBO = BO == BO_Sub ? BO_Add : BO;
+  llvm::Value *WarpVal = Val;
+  for (unsigned Offset = 1; Offset < DS_Max_Worker_Warp_Size; Offset <<= 1)
+    WarpVal = EmitBinOp(
+        CombineBO, WarpVal,
+        CGF.EmitNounwindRuntimeCall(ShflBfly,
+                                    {WarpVal, Bld.getInt32(Offset), Clamp}));
+  llvm::Value *IsLeader = Bld.CreateICmpEQ(GetNVPTXThreadWarpID(CGF),
+                                           Bld.getInt32(0), "is_warp_leader");
+  Bld.CreateCondBr(IsLeader, LeaderBB, DoneBB);
+
+  CGF.EmitBlock(LeaderBB);
+  EmitAtomicUpdate(WarpVal);
+  CGF.EmitBranch(DoneBB);
+
+  // Otherwise each thread updates the location on its own.
+  CGF.EmitBlock(LaneBB);
+  EmitAtomicUpdate(Val);
+  CGF.EmitBranch(DoneBB);
+
+  CGF.EmitBlock(DoneBB);
+}
+
+void CGOpenMPRuntimeNVPTX::emitForDispatchInit(
+    CodeGenFunction &CGF, SourceLocation Loc,
+    const OpenMPScheduleTy &ScheduleKind, unsigned IVSize, bool IVSigned,
+    bool Ordered, llvm::Value *LB, llvm::Value *UB, llvm::Value *Chunk) {
+  if (!CGF.HaveInsertPoint())
+    return;
+
+  // The chunks are handed out from a counter shared by the threads of the
+  // team, so all of them must execute the loop. This holds for the parallel
+  // regions of SPMD kernels at level 1. Ordered loops still need the runtime
+  // to order their iterations.
+  NativeDispatchTy Dispatch;
+  if (!CGM.getCodeGenOpts().OpenMPNVPTXNativeDynamicSchedule ||
+      !isSPMDExecutionMode() || !InL1() || Ordered ||
+      (ScheduleKind.Schedule != OMPC_SCHEDULE_dynamic &&
+       ScheduleKind.Schedule != OMPC_SCHEDULE_guided)) {
+    NativeDispatches.push_back(Dispatch);
+    CGOpenMPRuntime::emitForDispatchInit(CGF, Loc, ScheduleKind, IVSize,
+                                         IVSigned, Ordered, LB, UB, Chunk);
+    return;
+  }
+
+  CGBuilderTy &Bld = CGF.Builder;
+  llvm::IntegerType *IVTy = Bld.getIntNTy(IVSize);
+  auto *Counter = new llvm::GlobalVariable(
+      CGM.getModule(), IVTy, /*isConstant=*/false,
+      llvm::GlobalValue::InternalLinkage, llvm::UndefValue::get(IVTy),
+      CGF.CurFn->getName() + ".dispatch_counter", /*InsertBefore=*/nullptr,
+      llvm::GlobalVariable::NotThreadLocal, ADDRESS_SPACE_SHARED);
+  Counter->setAlignment(IVSize / 8);
+  Dispatch.Counter = Counter;
+  Dispatch.LB = LB;
+  Dispatch.UB = Bld.CreateIntCast(UB, IVTy, IVSigned);
+  Dispatch.Chunk = Chunk ? Chunk : Bld.getIntN(IVSize, 1);
+  Dispatch.Guided = ScheduleKind.Schedule == OMPC_SCHEDULE_guided;
+  NativeDispatches.push_back(Dispatch);
+
+  // Wait for the threads still taking chunks of a previous execution of the
+  // loop before resetting the counter. Every thread stores the same value.
+  emitBarrierCall(CGF, Loc, OMPD_unknown, /*EmitChecks=*/false,
+                  /*ForceSimpleCall=*/true);
+  Bld.CreateStore(LB, Address(Counter, CharUnits::fromQuantity(IVSize / 8)));
+  emitBarrierCall(CGF, Loc, OMPD_unknown, /*EmitChecks=*/false,
+                  /*ForceSimpleCall=*/true);
+}
+
+llvm::Value *CGOpenMPRuntimeNVPTX::emitForNext(CodeGenFunction &CGF,
+                                               SourceLocation Loc,
+                                               unsigned IVSize, bool IVSigned,
+                                               Address IL, Address LB,
+                                               Address UB, Address ST) {
+  assert(!NativeDispatches.empty() && "dispatch next without dispatch init");
+  NativeDispatchTy Dispatch = NativeDispatches.pop_back_val();
+  if (!Dispatch.Counter)
+    return CGOpenMPRuntime::emitForNext(CGF, Loc, IVSize, IVSigned, IL, LB, UB,
+                                        ST);
+
+  CGBuilderTy &Bld = CGF.Builder;
+  llvm::IntegerType *IVTy = Bld.getIntNTy(IVSize);
+  llvm::Value *Counter = Dispatch.Counter;
+  llvm::Value *Chunk = Dispatch.Chunk;
+  llvm::Value *Begin = nullptr;
+  llvm::Value *Size = nullptr;
+
+  if (!Dispatch.Guided) {
+    Size = Chunk;
+    auto &&EmitFetch = [&Bld, Counter](llvm::Value *Count) {
+      return Bld.CreateAtomicRMW(llvm::AtomicRMWInst::Add, Counter, Count,
+                                 llvm::AtomicOrdering::Monotonic);
+    };
+    // Warp shuffles are only used where all threads of a warp execute in
+    // lock step.
+    if (IsVolta(CGM)) {
+      Begin = EmitFetch(Chunk);
+    } else {
+      llvm::BasicBlock *AggregateBB =
+          CGF.createBasicBlock("omp.dispatch.aggregate");
+      llvm::BasicBlock *LeaderBB = CGF.createBasicBlock("omp.dispatch.leader");
+      llvm::BasicBlock *BroadcastBB =
+          CGF.createBasicBlock("omp.dispatch.broadcast");
+      llvm::BasicBlock *LaneBB = CGF.createBasicBlock("omp.dispatch.lane");
+      llvm::BasicBlock *DoneBB = CGF.createBasicBlock("omp.dispatch.fetched");
+
+      // Take the chunks of the whole warp at once if all its threads ask for
+      // one.
+      llvm::Value *Mask = getNVPTXWarpActiveThreadsMask(CGF);
+      llvm::Value *IsFullWarp =
+          Bld.CreateICmpEQ(Mask, Bld.getInt32(~0u), "is_full_warp");
+      Bld.CreateCondBr(IsFullWarp, AggregateBB, LaneBB);
+
+      CGF.EmitBlock(AggregateBB);
+      llvm::Value *LaneID = GetNVPTXThreadWarpID(CGF);
+      llvm::Value *IsLeader =
+          Bld.CreateICmpEQ(LaneID, Bld.getInt32(0), "is_warp_leader");
+      Bld.CreateCondBr(IsLeader, LeaderBB, BroadcastBB);
+
+      CGF.EmitBlock(LeaderBB);
+      llvm::Value *WarpBegin = EmitFetch(
+          Bld.CreateMul(Chunk, Bld.getIntN(IVSize, DS_Max_Worker_Warp_Size)));
+      CGF.EmitBranch(BroadcastBB);
+
+      // Lane 0 broadcasts the first iteration of the chunks of the warp, 32
+      // bits at a time.
+      CGF.EmitBlock(BroadcastBB);
+      llvm::PHINode *LeaderBegin = Bld.CreatePHI(IVTy, 2);
+      LeaderBegin->addIncoming(llvm::UndefValue::get(IVTy), AggregateBB);
+      LeaderBegin->addIncoming(WarpBegin, LeaderBB);
+      llvm::Value *ShflIdx = llvm::Intrinsic::getDeclaration(
+          &CGM.getModule(), llvm::Intrinsic::nvvm_shfl_idx_i32);
+      llvm::Value *Clamp = Bld.getInt32(DS_Max_Worker_Warp_Size_Log2_Mask);
+      llvm::Value *Base = nullptr;
+      for (unsigned Offset = 0; Offset < IVSize; Offset += 32) {
+        llvm::Value *Part = Bld.CreateTrunc(
+            Offset ? Bld.CreateLShr(LeaderBegin, Offset) : LeaderBegin,
+            CGM.Int32Ty);
+        Part = Bld.CreateZExt(
+            CGF.EmitNounwindRuntimeCall(
+                ShflIdx, {Part, Bld.getInt32(/*SrcLane=*/0), Clamp}),
+            IVTy);
+        if (Offset)
+          Part = Bld.CreateShl(Part, Offset);
+        Base = Base ? Bld.CreateOr(Base, Part) : Part;
+      }
+      llvm::Value *WarpLaneBegin = Bld.CreateAdd(
+          Base, Bld.CreateMul(Bld.CreateZExt(LaneID, IVTy), Chunk));
+      llvm::BasicBlock *BroadcastEndBB = Bld.GetInsertBlock();
+      CGF.EmitBranch(DoneBB);
+
+      // Otherwise each thread takes its chunk on its own.
+      CGF.EmitBlock(LaneBB);
+      llvm::Value *LaneBegin = EmitFetch(Chunk);
+      CGF.EmitBranch(DoneBB);
+
+      CGF.EmitBlock(DoneBB);
+      llvm::PHINode *Fetched = Bld.CreatePHI(IVTy, 2, "dispatch_begin");
+      Fetched->addIncoming(WarpLaneBegin, BroadcastEndBB);
+      Fetched->addIncoming(LaneBegin, LaneBB);
+      Begin = Fetched;
+    }
+  } else {
+    // The guided chunks are a share of the remaining iterations, so they are
+    // claimed with a compare and swap:
+    // do {
+    //   Begin = Counter;
+    //   if (Begin > UB) break;
+    //   Size = max(Chunk, (UB - Begin + 1) / (2 * NumThreads));
+    // } while (!cmpxchg(Counter, Begin, Begin + Size));
+    llvm::BasicBlock *EntryBB = Bld.GetInsertBlock();
+    llvm::BasicBlock *LoopBB = CGF.createBasicBlock("omp.dispatch.guided");
+    llvm::BasicBlock *ClaimBB = CGF.createBasicBlock("omp.dispatch.claim");
+    llvm::BasicBlock *DoneBB = CGF.createBasicBlock("omp.dispatch.fetched");
+    llvm::Value *Initial = Bld.CreateLoad(
+        Address(Counter, CharUnits::fromQuantity(IVSize / 8)),
+        /*IsVolatile=*/true);
+    llvm::Value *Divisor = Bld.CreateShl(
+        Bld.CreateZExtOrTrunc(GetNVPTXNumThreads(CGF), IVTy), 1);
+    CGF.EmitBranch(LoopBB);
+
+    CGF.EmitBlock(LoopBB);
+    llvm::PHINode *Current = Bld.CreatePHI(IVTy, 2, "dispatch_begin");
+    Current->addIncoming(Initial, EntryBB);
+    llvm::Value *IsDone = IVSigned ? Bld.CreateICmpSGT(Current, Dispatch.UB)
+                                   : Bld.CreateICmpUGT(Current, Dispatch.UB);
+    Bld.CreateCondBr(IsDone, DoneBB, ClaimBB);
+
+    CGF.EmitBlock(ClaimBB);
+    llvm::Value *Remaining = Bld.CreateAdd(
+        Bld.CreateSub(Dispatch.UB, Current), Bld.getIntN(IVSize, 1));
+    llvm::Value *Share = IVSigned ? Bld.CreateSDiv(Remaining, Divisor)
+                                  : Bld.CreateUDiv(Remaining, Divisor);
+    llvm::Value *IsLarger = IVSigned ? Bld.CreateICmpSGT(Share, Chunk)
+                                     : Bld.CreateICmpUGT(Share, Chunk);
+    llvm::Value *ClaimSize = Bld.CreateSelect(IsLarger, Share, Chunk);
+    llvm::AtomicCmpXchgInst *Pair = Bld.CreateAtomicCmpXchg(
+        Counter, Current, Bld.CreateAdd(Current, ClaimSize),
+        llvm::AtomicOrdering::Monotonic, llvm::AtomicOrdering::Monotonic);
+    Current->addIncoming(Bld.CreateExtractValue(Pair, 0), ClaimBB);
+    Bld.CreateCondBr(Bld.CreateExtractValue(Pair, 1), DoneBB, LoopBB);
+
+    CGF.EmitBlock(DoneBB);
+    llvm::PHINode *Claimed = Bld.CreatePHI(IVTy, 2, "dispatch_size");
+    Claimed->addIncoming(Chunk, LoopBB);
+    Claimed->addIncoming(ClaimSize, ClaimBB);
+    Begin = Current;
+    Size = Claimed;
+  }
+
+  // The chunk is [Begin, min(Begin + Size - 1, UB)], and the last one holds
+  // the last iteration.
+  llvm::Value *End =
+      Bld.CreateSub(Bld.CreateAdd(Begin, Size), Bld.getIntN(IVSize, 1));
+  llvm::Value *IsPastEnd = IVSigned ? Bld.CreateICmpSGE(End, Dispatch.UB)
+                                    : Bld.CreateICmpUGE(End, Dispatch.UB);
+  llvm::Value *HasChunk = IVSigned ? Bld.CreateICmpSLE(Begin, Dispatch.UB)
+                                   : Bld.CreateICmpULE(Begin, Dispatch.UB);
+  Bld.CreateStore(Begin, LB);
+  Bld.CreateStore(Bld.CreateSelect(IsPastEnd, Dispatch.UB, End), UB);
+  Bld.CreateStore(Bld.getIntN(IVSize, 1), ST);
+  Bld.CreateStore(
+      Bld.CreateZExt(Bld.CreateAnd(HasChunk, IsPastEnd), CGM.Int32Ty), IL);
+  return HasChunk;
+}
+
 namespace {
 template <typename T>
 static T selectRuntimeCall(bool IsSPMDExecutionMode,
@@ -4543,15 +5900,95 @@ bool CGOpenMPRuntimeNVPTX::generateCoalescedSchedule(
 // schedule(static, 1) whenever the standard gives us freedom.  This allows
 // maximum coalescing on the NVPTX target and minimum loop overhead.
 //
+// An explicit dist_schedule(static, chunk) is handled the same way when the
+// chunk is known to equal the number of threads in a team, since the two
+// schedules then assign the same iterations to each thread.
+//
 // Only possible in SPMD mode.
 //
 bool CGOpenMPRuntimeNVPTX::generateCoalescedSchedule(
     OpenMPDistScheduleClauseKind DistScheduleKind,
-    OpenMPScheduleClauseKind ScheduleKind, bool DistChunked, bool ChunkSizeOne,
-    bool Ordered) const {
-  return isSPMDExecutionMode() &&
-         DistScheduleKind == OMPC_DIST_SCHEDULE_unknown &&
-         generateCoalescedSchedule(ScheduleKind, ChunkSizeOne, Ordered);
+    OpenMPScheduleClauseKind ScheduleKind, const Expr *DistChunkSize,
+    bool ChunkSizeOne, bool Ordered) const {
+  if (!isSPMDExecutionMode() ||
+      !generateCoalescedSchedule(ScheduleKind, ChunkSizeOne, Ordered))
+    return false;
+  if (DistScheduleKind == OMPC_DIST_SCHEDULE_unknown)
+    return true;
+  if (DistScheduleKind != OMPC_DIST_SCHEDULE_static || !DistChunkSize ||
+      ConstantTeamSize == 0)
+    return false;
+  llvm::APSInt DistChunk;
+  return DistChunkSize->EvaluateAsInt(DistChunk, CGM.getContext()) &&
+         DistChunk == ConstantTeamSize;
+}
+
+void CGOpenMPRuntimeNVPTX::emitUncoalescedScheduleRemark(
+    const OMPLoopDirective &S) {
+  enum { UCS_GenericMode, UCS_Ordered, UCS_Schedule, UCS_DistSchedule };
+  auto &&Report = [this, &S](SourceLocation Loc, unsigned Reason) {
+    // The distribute and the worksharing parts of a combined loop are both
+    // scheduled, report the loop once.
+    if (!UncoalescedLoops.insert(&S).second)
+      return;
+    CGM.getContext().getDiagnostics().Report(
+        Loc,
+        diag::remark_fe_backend_optimization_remark_analysis_target_uncoalesced)
+        << Reason;
+  };
+
+  if (const auto *C = S.getSingleClause<OMPOrderedClause>())
+    return Report(C->getLocStart(), UCS_Ordered);
+  if (const auto *C = S.getSingleClause<OMPScheduleClause>()) {
+    bool ChunkSizeOne = false;
+    llvm::APSInt Chunk;
+    if (const Expr *Ch = C->getChunkSize())
+      ChunkSizeOne = Ch->EvaluateAsInt(Chunk, CGM.getContext()) && Chunk == 1;
+    if (!generateCoalescedSchedule(C->getScheduleKind(), ChunkSizeOne,
+                                   /*Ordered=*/false))
+      return Report(C->getLocStart(), UCS_Schedule);
+  }
+  if (!isOpenMPDistributeDirective(S.getDirectiveKind()))
+    return;
+  if (!isSPMDExecutionMode())
+    return Report(S.getLocStart(), UCS_GenericMode);
+  if (const auto *C = S.getSingleClause<OMPDistScheduleClause>())
+    Report(C->getLocStart(), UCS_DistSchedule);
+}
+
+// The iterations of a coalesced loop run by a team in one step are
+// consecutive, so a team reads a contiguous window of the arrays of a stencil
+// loop.  The window is sized for the number of threads of the team, which must
+// therefore be known.
+bool CGOpenMPRuntimeNVPTX::getStencilStagingLimits(const OMPLoopDirective &S,
+                                                   unsigned &TeamSize,
+                                                   uint64_t &Budget) const {
+  if (!CGM.getCodeGenOpts().OpenMPNVPTXStencilTiling ||
+      !isSPMDExecutionMode() || ConstantTeamSize == 0)
+    return false;
+  TeamSize = ConstantTeamSize;
+  Budget = DS_Max_Stencil_Staging_Size;
+  return true;
+}
+
+Address CGOpenMPRuntimeNVPTX::emitStencilStagingBuffer(CodeGenFunction &CGF,
+                                                       QualType EltTy,
+                                                       uint64_t NumElts) {
+  auto *BufTy =
+      llvm::ArrayType::get(CGM.getTypes().ConvertTypeForMem(EltTy), NumElts);
+  auto *Buf = new llvm::GlobalVariable(
+      CGM.getModule(), BufTy, /*isConstant=*/false,
+      llvm::GlobalValue::InternalLinkage, llvm::UndefValue::get(BufTy),
+      CGF.CurFn->getName() + ".stencil_tile", /*InsertBefore=*/nullptr,
+      llvm::GlobalVariable::NotThreadLocal, ADDRESS_SPACE_SHARED);
+  CharUnits Align = CGM.getContext().getTypeAlignInChars(EltTy);
+  Buf->setAlignment(Align.getQuantity());
+  return Address(Buf, Align);
+}
+
+std::pair<llvm::Value *, llvm::Value *>
+CGOpenMPRuntimeNVPTX::emitTeamThreadIDAndSize(CodeGenFunction &CGF) {
+  return std::make_pair(GetNVPTXThreadID(CGF), GetNVPTXNumThreads(CGF));
 }
 
 bool CGOpenMPRuntimeNVPTX::requiresBarrier(const OMPLoopDirective &S) const {
@@ -4563,6 +6000,11 @@ bool CGOpenMPRuntimeNVPTX::requiresBarrier(const OMPLoopDirective &S) const {
          ScheduleKind == OMPC_SCHEDULE_guided;
 }
 
+bool CGOpenMPRuntimeNVPTX::requiresOutlinedSimd(
+    const OMPLoopDirective &S) const {
+  return !isSPMDExecutionMode();
+}
+
 /// \brief Values for bit flags used in the ident_t to describe the fields.
 /// All enumeric elements are named and described in accordance with the code
 /// from http://llvm.org/svn/llvm-project/openmp/trunk/runtime/src/kmp.h
@@ -4589,6 +6031,7 @@ void CGOpenMPRuntimeNVPTX::emitBarrierCall(CodeGenFunction &CGF,
     if (!ForceSimpleCall && OMPRegionInfo->hasCancel())
       IsSimpleBarrier = false;
 
+  llvm::Value *BarrierStart = emitCycleCounterStart(CGF);
   if (!isOMPRuntimeInitialized() && IsSimpleBarrier) {
     // Build call __kmpc_barrier_simple(loc, thread_id);
     unsigned Flags;
@@ -4604,14 +6047,17 @@ void CGOpenMPRuntimeNVPTX::emitBarrierCall(CodeGenFunction &CGF,
          OMPRTL_NVPTX__kmpc_barrier_simple_generic});
     CGF.EmitRuntimeCall(createNVPTXRuntimeFunction(Name), Args);
   } else {
-    return CGOpenMPRuntime::emitBarrierCall(CGF, Loc, Kind, EmitChecks,
-                                            ForceSimpleCall);
+    CGOpenMPRuntime::emitBarrierCall(CGF, Loc, Kind, EmitChecks,
+                                     ForceSimpleCall);
   }
+  emitCycleCounterStop(CGF, BarrierStart, KernelCycleCounters, CC_Barrier);
 }
 
 CGOpenMPRuntimeNVPTX::CGOpenMPRuntimeNVPTX(CodeGenModule &CGM)
     : CGOpenMPRuntime(CGM), IsOrphaned(true), ParallelNestingLevel(0),
-      IsOMPRuntimeInitialized(true), CurrMode(ExecutionMode::UNKNOWN) {
+      RequiresL0JoinBarrier(false), ConstantTeamSize(0),
+      DataSharingPool(nullptr), IsOMPRuntimeInitialized(true),
+      KernelCycleCounters(nullptr), CurrMode(ExecutionMode::UNKNOWN) {
   if (!CGM.getLangOpts().OpenMPIsDevice)
     llvm_unreachable("OpenMP NVPTX can only handle device code.");
 }
@@ -4747,6 +6193,101 @@ void CGOpenMPRuntimeNVPTX::emitTeamsCall(CodeGenFunction &CGF,
   }
 }
 
+void CGOpenMPRuntimeNVPTX::mergeIdenticalTargetRegions() {
+  llvm::Module &M = CGM.getModule();
+
+  // Groups the functions in \a Fns that are identical to their first member of
+  // the group, returning the groups with more than one member.
+  auto &&GroupIdentical = [](ArrayRef<llvm::Function *> Fns) {
+    llvm::GlobalNumberState GN;
+    llvm::DenseMap<llvm::FunctionComparator::FunctionHash,
+                   SmallVector<llvm::Function *, 2>>
+        Buckets;
+    for (auto *Fn : Fns)
+      Buckets[llvm::FunctionComparator::functionHash(*Fn)].push_back(Fn);
+    SmallVector<SmallVector<llvm::Function *, 2>, 4> Groups;
+    for (auto &B : Buckets) {
+      auto &Candidates = B.second;
+      while (Candidates.size() > 1) {
+        SmallVector<llvm::Function *, 2> Group(1, Candidates.front());
+        SmallVector<llvm::Function *, 2> Rest;
+        for (auto *Fn : llvm::makeArrayRef(Candidates).drop_front()) {
+          if (llvm::FunctionComparator(Group.front(), Fn, &GN).compare() == 0)
+            Group.push_back(Fn);
+          else
+            Rest.push_back(Fn);
+        }
+        if (Group.size() > 1)
+          Groups.push_back(std::move(Group));
+        Candidates = std::move(Rest);
+      }
+    }
+    return Groups;
+  };
+
+  // The outlined functions, workers and wrappers of identical target regions
+  // only refer to each other, so merge them bottom up until the kernels call
+  // the same functions. Only the functions whose address is not taken are
+  // merged so that no pointer comparison is affected.
+  bool Changed;
+  do {
+    Changed = false;
+    SmallVector<llvm::Function *, 16> Fns;
+    for (auto &Fn : M)
+      if (!Fn.isDeclaration() && Fn.hasLocalLinkage() && !Fn.hasAddressTaken())
+        Fns.push_back(&Fn);
+    for (auto &Group : GroupIdentical(Fns)) {
+      for (auto *Fn : llvm::makeArrayRef(Group).drop_front()) {
+        Fn->replaceAllUsesWith(Group.front());
+        Fn->eraseFromParent();
+      }
+      Changed = true;
+    }
+  } while (Changed);
+
+  // The kernels have to keep their names since the host launches them by
+  // name, and there are no aliases in PTX. Move the body of the first kernel
+  // of each group into an internal function and make all the kernels of the
+  // group call it.
+  for (auto &Group : GroupIdentical(TargetRegionKernels)) {
+    llvm::Function *First = Group.front();
+    auto *Body = llvm::Function::Create(First->getFunctionType(),
+                                        llvm::GlobalValue::InternalLinkage,
+                                        First->getName() + "_merged", &M);
+    Body->copyAttributesFrom(First);
+    Body->setLinkage(llvm::GlobalValue::InternalLinkage);
+    Body->setVisibility(llvm::GlobalValue::DefaultVisibility);
+    Body->removeFnAttr(llvm::Attribute::AlwaysInline);
+    Body->addFnAttr(llvm::Attribute::NoInline);
+    Body->getBasicBlockList().splice(Body->begin(),
+                                     First->getBasicBlockList());
+    for (auto I = First->arg_begin(), J = Body->arg_begin(),
+              E = First->arg_end();
+         I != E; ++I, ++J) {
+      I->replaceAllUsesWith(&*J);
+      J->takeName(&*I);
+    }
+    Body->setSubprogram(First->getSubprogram());
+    First->setSubprogram(nullptr);
+
+    for (auto *Kernel : Group) {
+      Kernel->dropAllReferences();
+      auto *EntryBB =
+          llvm::BasicBlock::Create(CGM.getLLVMContext(), "entry", Kernel);
+      CGBuilderTy Bld(CGM, EntryBB);
+      SmallVector<llvm::Value *, 8> Args;
+      for (auto &Arg : Kernel->args())
+        Args.push_back(&Arg);
+      auto *Call = Bld.CreateCall(Body, Args);
+      Call->setCallingConv(Body->getCallingConv());
+      if (Kernel->getReturnType()->isVoidTy())
+        Bld.CreateRetVoid();
+      else
+        Bld.CreateRet(Call);
+    }
+  }
+}
+
 llvm::Function *CGOpenMPRuntimeNVPTX::emitRegistrationFunction() {
   auto &Ctx = CGM.getContext();
   unsigned PointerAlign = Ctx.getTypeAlignInChars(Ctx.VoidPtrTy).getQuantity();
@@ -4815,7 +6356,8 @@ llvm::Function *CGOpenMPRuntimeNVPTX::emitRegistrationFunction() {
 
       auto *ShouldReturnImmediatelly = llvm::CallInst::Create(
           createKernelInitializerFunction(DSI.EntryWorkerFunction,
-                                          DSI.RequiresOMPRuntime),
+                                          DSI.RequiresOMPRuntime,
+                                          DSI.DataSharingPool),
           "", InsertPtr);
       auto *Cond = llvm::ICmpInst::Create(
           llvm::CmpInst::ICmp, llvm::CmpInst::ICMP_EQ, ShouldReturnImmediatelly,
@@ -4859,8 +6401,9 @@ llvm::Function *CGOpenMPRuntimeNVPTX::emitRegistrationFunction() {
                              "data_share_active_thd_saved", InsertPtr));
 
     // Create the remaining arguments. One if it is a reference sharing (the
-    // reference itself), two otherwise (the address of the replacement and the
-    // value to be replaced).
+    // reference itself) or a copied value (which comes with its own shared
+    // address temporary), two otherwise (the address of the replacement and
+    // the value to be replaced).
     for (auto &VR : DSI.ValuesToBeReplaced) {
       auto *Replacement = VR.first;
       bool IsReference = VR.second;
@@ -5072,8 +6615,8 @@ llvm::Function *CGOpenMPRuntimeNVPTX::emitRegistrationFunction() {
                                  InsertPtr);
 
     // Close the environment. The saved stack is in the 4 first entries of the
-    // arguments array.
-    if (DSI.RequiresOMPRuntime) {
+    // arguments array. A static frame did not open one.
+    if (DSI.RequiresOMPRuntime && !DSI.UsesStaticFrame) {
       llvm::Value *ClosingArgs[]{
           InitArgs[0], InitArgs[1], InitArgs[2], InitArgs[3],
           // If an entry point we need to signal the clean up.
@@ -5087,174 +6630,42 @@ llvm::Function *CGOpenMPRuntimeNVPTX::emitRegistrationFunction() {
     }
   }
 
+  // The kernels are complete now, share the identical ones.
+  if (CGM.getCodeGenOpts().OpenMPMergeIdenticalKernels)
+    mergeIdenticalTargetRegions();
+
   // Make the default registration procedure.
   return CGOpenMPRuntime::emitRegistrationFunction();
 }
 
-StringRef CGOpenMPRuntimeNVPTX::RenameStandardFunction(StringRef name) {
-  // Fill up hashmap entries lazily
-  if (stdFuncs.empty()) {
-
-    // Trigonometric functions
-    stdFuncs.insert(std::make_pair("cos", "__nv_cos"));
-    stdFuncs.insert(std::make_pair("sin", "__nv_sin"));
-    stdFuncs.insert(std::make_pair("tan", "__nv_tan"));
-    stdFuncs.insert(std::make_pair("acos", "__nv_acos"));
-    stdFuncs.insert(std::make_pair("asin", "__nv_asin"));
-    stdFuncs.insert(std::make_pair("atan", "__nv_atan"));
-    stdFuncs.insert(std::make_pair("atan2", "__nv_atan2"));
-
-    stdFuncs.insert(std::make_pair("cosf", "__nv_cosf"));
-    stdFuncs.insert(std::make_pair("sinf", "__nv_sinf"));
-    stdFuncs.insert(std::make_pair("tanf", "__nv_tanf"));
-    stdFuncs.insert(std::make_pair("acosf", "__nv_acosf"));
-    stdFuncs.insert(std::make_pair("asinf", "__nv_asinf"));
-    stdFuncs.insert(std::make_pair("atanf", "__nv_atanf"));
-    stdFuncs.insert(std::make_pair("atan2f", "__nv_atan2f"));
-
-    // Hyperbolic functions
-    stdFuncs.insert(std::make_pair("cosh", "__nv_cosh"));
-    stdFuncs.insert(std::make_pair("sinh", "__nv_sinh"));
-    stdFuncs.insert(std::make_pair("tanh", "__nv_tanh"));
-    stdFuncs.insert(std::make_pair("acosh", "__nv_acosh"));
-    stdFuncs.insert(std::make_pair("asinh", "__nv_asinh"));
-    stdFuncs.insert(std::make_pair("atanh", "__nv_atanh"));
-
-    stdFuncs.insert(std::make_pair("coshf", "__nv_coshf"));
-    stdFuncs.insert(std::make_pair("sinhf", "__nv_sinhf"));
-    stdFuncs.insert(std::make_pair("tanhf", "__nv_tanhf"));
-    stdFuncs.insert(std::make_pair("acoshf", "__nv_acoshf"));
-    stdFuncs.insert(std::make_pair("asinhf", "__nv_asinhf"));
-    stdFuncs.insert(std::make_pair("atanhf", "__nv_atanhf"));
-
-    // Exponential and logarithm functions
-    stdFuncs.insert(std::make_pair("exp", "__nv_exp"));
-    stdFuncs.insert(std::make_pair("frexp", "__nv_frexp"));
-    stdFuncs.insert(std::make_pair("ldexp", "__nv_ldexp"));
-    stdFuncs.insert(std::make_pair("log", "__nv_log"));
-    stdFuncs.insert(std::make_pair("log10", "__nv_log10"));
-    stdFuncs.insert(std::make_pair("modf", "__nv_modf"));
-    stdFuncs.insert(std::make_pair("exp2", "__nv_exp2"));
-    stdFuncs.insert(std::make_pair("expm1", "__nv_expm1"));
-    stdFuncs.insert(std::make_pair("ilogb", "__nv_ilogb"));
-    stdFuncs.insert(std::make_pair("log1p", "__nv_log1p"));
-    stdFuncs.insert(std::make_pair("log2", "__nv_log2"));
-    stdFuncs.insert(std::make_pair("logb", "__nv_logb"));
-    stdFuncs.insert(std::make_pair("scalbn", "__nv_scalbn"));
-    //     map.insert(std::make_pair((scalbln", ""));
-
-    stdFuncs.insert(std::make_pair("expf", "__nv_exp"));
-    stdFuncs.insert(std::make_pair("frexpf", "__nv_frexpf"));
-    stdFuncs.insert(std::make_pair("ldexpf", "__nv_ldexpf"));
-    stdFuncs.insert(std::make_pair("logf", "__nv_logf"));
-    stdFuncs.insert(std::make_pair("log10f", "__nv_log10f"));
-    stdFuncs.insert(std::make_pair("modff", "__nv_modff"));
-    stdFuncs.insert(std::make_pair("exp2f", "__nv_exp2f"));
-    stdFuncs.insert(std::make_pair("expm1f", "__nv_expm1f"));
-    stdFuncs.insert(std::make_pair("ilogbf", "__nv_ilogbf"));
-    stdFuncs.insert(std::make_pair("log1pf", "__nv_log1pf"));
-    stdFuncs.insert(std::make_pair("log2f", "__nv_log2f"));
-    stdFuncs.insert(std::make_pair("logbf", "__nv_logbf"));
-    stdFuncs.insert(std::make_pair("scalbnf", "__nv_scalbnf"));
-    //     map.insert(std::make_pair("scalblnf", ""));
-
-    // Power functions
-    stdFuncs.insert(std::make_pair("pow", "__nv_pow"));
-    stdFuncs.insert(std::make_pair("powi", "__nv_powi"));
-    stdFuncs.insert(std::make_pair("sqrt", "__nv_sqrt"));
-    stdFuncs.insert(std::make_pair("cbrt", "__nv_cbrt"));
-    stdFuncs.insert(std::make_pair("hypot", "__nv_hypot"));
-
-    stdFuncs.insert(std::make_pair("powf", "__nv_powf"));
-    stdFuncs.insert(std::make_pair("powif", "__nv_powif"));
-    stdFuncs.insert(std::make_pair("sqrtf", "__nv_sqrtf"));
-    stdFuncs.insert(std::make_pair("cbrtf", "__nv_cbrtf"));
-    stdFuncs.insert(std::make_pair("hypotf", "__nv_hypotf"));
-
-    // Error and gamma functions
-    stdFuncs.insert(std::make_pair("erf", "__nv_erf"));
-    stdFuncs.insert(std::make_pair("erfc", "__nv_erfc"));
-    stdFuncs.insert(std::make_pair("tgamma", "__nv_tgamma"));
-    stdFuncs.insert(std::make_pair("lgamma", "__nv_lgamma"));
-
-    stdFuncs.insert(std::make_pair("erff", "__nv_erff"));
-    stdFuncs.insert(std::make_pair("erfcf", "__nv_erfcf"));
-    stdFuncs.insert(std::make_pair("tgammaf", "__nv_tgammaf"));
-    stdFuncs.insert(std::make_pair("lgammaf", "__nv_lgammaf"));
-
-    // Rounding and remainder functions
-    stdFuncs.insert(std::make_pair("ceil", "__nv_ceil"));
-    stdFuncs.insert(std::make_pair("floor", "__nv_floor"));
-    stdFuncs.insert(std::make_pair("fmod", "__nv_fmod"));
-    stdFuncs.insert(std::make_pair("trunc", "__nv_trunc"));
-    stdFuncs.insert(std::make_pair("round", "__nv_round"));
-    stdFuncs.insert(std::make_pair("lround", "__nv_lround"));
-    stdFuncs.insert(std::make_pair("llround", "__nv_llround"));
-    stdFuncs.insert(std::make_pair("rint", "__nv_rint"));
-    stdFuncs.insert(std::make_pair("lrint", "__nv_lrint"));
-    stdFuncs.insert(std::make_pair("llrint", "__nv_llrint"));
-    stdFuncs.insert(std::make_pair("nearbyint", "__nv_nearbyint"));
-    stdFuncs.insert(std::make_pair("remainder", "__nv_remainder"));
-    stdFuncs.insert(std::make_pair("remquo", "__nv_remquo"));
-
-    stdFuncs.insert(std::make_pair("ceilf", "__nv_ceilf"));
-    stdFuncs.insert(std::make_pair("floorf", "__nv_floorf"));
-    stdFuncs.insert(std::make_pair("fmodf", "__nv_fmodf"));
-    stdFuncs.insert(std::make_pair("truncf", "__nv_truncf"));
-    stdFuncs.insert(std::make_pair("roundf", "__nv_roundf"));
-    stdFuncs.insert(std::make_pair("lroundf", "__nv_lroundf"));
-    stdFuncs.insert(std::make_pair("llroundf", "__nv_llroundf"));
-    stdFuncs.insert(std::make_pair("rintf", "__nv_rintf"));
-    stdFuncs.insert(std::make_pair("lrintf", "__nv_lrintf"));
-    stdFuncs.insert(std::make_pair("llrintf", "__nv_llrintf"));
-    stdFuncs.insert(std::make_pair("nearbyintf", "__nv_nearbyintf"));
-    stdFuncs.insert(std::make_pair("remainderf", "__nv_remainderf"));
-    stdFuncs.insert(std::make_pair("remquof", "__nv_remquof"));
-
-    // Floating-point manipulation functions
-    stdFuncs.insert(std::make_pair("copysign", "__nv_copysign"));
-    stdFuncs.insert(std::make_pair("nan", "__nv_nan"));
-    stdFuncs.insert(std::make_pair("nextafter", "__nv_nextafter"));
-    //     map.insert(std::make_pair("nexttoward", ""));
-
-    stdFuncs.insert(std::make_pair("copysignf", "__nv_copysignf"));
-    stdFuncs.insert(std::make_pair("nanf", "__nv_nanf"));
-    stdFuncs.insert(std::make_pair("nextafterf", "__nv_nextafterf"));
-    //     map.insert(std::make_pair("nexttowardf", ""));
-
-    // Minimum, maximu,, difference functions
-    stdFuncs.insert(std::make_pair("fdim", "__nv_fdim"));
-    stdFuncs.insert(std::make_pair("fmax", "__nv_fmax"));
-    stdFuncs.insert(std::make_pair("fmin", "__nv_fmin"));
-
-    stdFuncs.insert(std::make_pair("fdimf", "__nv_fdimf"));
-    stdFuncs.insert(std::make_pair("fmaxf", "__nv_fmaxf"));
-    stdFuncs.insert(std::make_pair("fminf", "__nv_fminf"));
-
-    // Other functions
-    stdFuncs.insert(std::make_pair("fabs", "__nv_fabs"));
-    stdFuncs.insert(std::make_pair("abs", "__nv_abs"));
-    stdFuncs.insert(std::make_pair("fma", "__nv_fma"));
-
-    stdFuncs.insert(std::make_pair("fabsf", "__nv_fabsf"));
-    stdFuncs.insert(std::make_pair("absf", "__nv_absf"));
-    stdFuncs.insert(std::make_pair("fmaf", "__nv_fmaf"));
-
-    // temporary solution for Znam: this is how the cuda toolkit defines
-    // _Znam but the header file is not properly picked up
-    // same for new and delete
-    stdFuncs.insert(std::make_pair("_Znam", "malloc"));
-    stdFuncs.insert(std::make_pair("_Znwm", "malloc"));
-    stdFuncs.insert(std::make_pair("_ZdlPv", "free"));
-  }
-
-  // If callee is standard function, change its name
-  StringRef match = stdFuncs.lookup(name);
-  if (!match.empty()) {
-    return match;
-  }
-
-  return name;
+StringRef
+CGOpenMPRuntimeNVPTX::RenameStandardFunction(StringRef Name,
+                                             const FunctionDecl *FD) {
+  // The math library builtins are switched over by ID, which does not cost a
+  // string lookup for every function that is referenced.
+  if (unsigned BuiltinID = FD ? FD->getBuiltinID() : 0) {
+    const bool FastMath =
+        CGM.getLangOpts().FastMath || CGM.getCodeGenOpts().UnsafeFPMath;
+    switch (BuiltinID) {
+#define LIBDEVICE_BUILTIN(Builtin, Precise)                                    \
+  case Builtin::BI##Builtin:                                                   \
+  case Builtin::BI__builtin_##Builtin:                                         \
+    return Precise;
+#define LIBDEVICE_FAST_BUILTIN(Builtin, Precise, Fast)                         \
+  case Builtin::BI##Builtin:                                                   \
+  case Builtin::BI__builtin_##Builtin:                                         \
+    return FastMath ? Fast : Precise;
+#include "NVPTXLibDeviceFunctions.def"
+    default:
+      return Name;
+    }
+  }
+
+  // The few functions without a builtin are renamed by name.
+  return llvm::StringSwitch<StringRef>(Name)
+#define LIBDEVICE_FUNCTION(Function, Precise) .Case(Function, Precise)
+#include "NVPTXLibDeviceFunctions.def"
+      .Default(Name);
 }
 
 /// This function creates calls to one of two shuffle functions to copy
@@ -6424,7 +7835,7 @@ void CGOpenMPRuntimeNVPTX::emitReduction(
                         // warp_num);
   };
 
-  llvm::CallInst *Res = nullptr;
+  llvm::Value *Res = nullptr;
   if (ParallelReduction) {
     Res = CGF.EmitRuntimeCall(
         createNVPTXRuntimeFunction(selectRuntimeCall<OpenMPRTLFunctionNVPTX>(
@@ -6449,7 +7860,34 @@ void CGOpenMPRuntimeNVPTX::emitReduction(
   if (ReductionKind == OMPD_distribute_parallel_for)
     return;
 
-  if (TeamsReduction) {
+  bool InlineTeamsReduction = false;
+  if (TeamsReduction && CGM.getCodeGenOpts().OpenMPInlineTeamsReduction) {
+    // The scratchpad is laid out statically, so every reduction element must
+    // have a size known at compile time.
+    InlineTeamsReduction = true;
+    for (auto *E : Privates)
+      InlineTeamsReduction &= !E->getType()->isVariablyModifiedType();
+  }
+
+  if (InlineTeamsReduction) {
+    // Reduce within the team first.  In a combined construct this was done by
+    // the parallel reduction above; in generic mode only the team master
+    // executes the teams region so it already holds the team value.
+    if (!ParallelReduction) {
+      if (isSPMDExecutionMode())
+        Res = CGF.EmitRuntimeCall(
+            createNVPTXRuntimeFunction(
+                selectRuntimeCall<OpenMPRTLFunctionNVPTX>(
+                    /*IsSPMDExecutionMode=*/true, isOMPRuntimeInitialized(),
+                    {OMPRTL_NVPTX__kmpc_parallel_reduce_nowait_simple_spmd,
+                     OMPRTL_NVPTX__kmpc_parallel_reduce_nowait_simple_generic,
+                     OMPRTL_NVPTX__kmpc_parallel_reduce_nowait})),
+            Args);
+    }
+    llvm::Value *IntraTeamRes = Res ? Res : CGF.Builder.getInt32(1);
+    Res = emitInlinedTeamsReduction(CGF, Privates, IntraTeamRes, RL,
+                                    ScratchPadCopy, LoadAndReduce);
+  } else if (TeamsReduction) {
     llvm::Value *TeamsArgs[] = {
         ThreadId,                              // i32 <gtid>
         CGF.Builder.getInt32(RHSExprs.size()), // i32 <n>
@@ -6516,6 +7954,122 @@ void CGOpenMPRuntimeNVPTX::emitReduction(
   CGF.EmitBlock(DefaultBB, /*IsFinished=*/true);
 }
 
+llvm::Value *CGOpenMPRuntimeNVPTX::emitInlinedTeamsReduction(
+    CodeGenFunction &CGF, ArrayRef<const Expr *> Privates,
+    llvm::Value *IntraTeamRes, llvm::Value *ReduceData,
+    llvm::Value *ScratchPadCopy, llvm::Value *LoadAndReduce) {
+  auto &C = CGM.getContext();
+  auto &Bld = CGF.Builder;
+
+  //
+  //  if (IntraTeamRes == 1) {               // team master
+  //    copy_to_scratchpad(ReduceData, scratchpad, team_id, num_teams);
+  //    __threadfence();
+  //    if (atomicAdd(&counter, 1) == num_teams - 1) {
+  //      __threadfence();
+  //      counter = 0;
+  //      for (i = 0; i < num_teams; ++i)
+  //        if (i != team_id)
+  //          load_and_reduce(ReduceData, scratchpad, i, num_teams, 1);
+  //      res = 1;
+  //    }
+  //  }
+  //
+
+  // The scratchpad holds one value per team for each reduction element.  Its
+  // layout mirrors the one expected by copy_to_scratchpad and
+  // load_and_reduce: each element occupies a 256 byte aligned row wide enough
+  // for the maximum number of teams.
+  uint64_t ScratchpadSize = 0;
+  for (auto *Private : Privates)
+    ScratchpadSize += llvm::alignTo(
+        C.getTypeSizeInChars(Private->getType()).getQuantity() * DS_Max_Teams,
+        256);
+  auto *ScratchpadTy = llvm::ArrayType::get(CGM.Int8Ty, ScratchpadSize);
+  auto *Scratchpad = new llvm::GlobalVariable(
+      CGM.getModule(), ScratchpadTy, /*isConstant=*/false,
+      llvm::GlobalValue::InternalLinkage,
+      llvm::Constant::getNullValue(ScratchpadTy),
+      ".omp.reduction.teams_scratchpad");
+  Scratchpad->setAlignment(256);
+  // Number of teams that have published their value.  The last team resets it
+  // so that the next launch of the kernel starts from zero.
+  auto *Counter = new llvm::GlobalVariable(
+      CGM.getModule(), CGM.Int32Ty, /*isConstant=*/false,
+      llvm::GlobalValue::InternalLinkage,
+      llvm::Constant::getNullValue(CGM.Int32Ty),
+      ".omp.reduction.teams_counter");
+  Address CounterAddr(Counter, CharUnits::fromQuantity(4));
+
+  llvm::BasicBlock *EntryBB = Bld.GetInsertBlock();
+  llvm::BasicBlock *MasterBB =
+      CGF.createBasicBlock(".omp.reduction.team_master");
+  llvm::BasicBlock *LastTeamBB =
+      CGF.createBasicBlock(".omp.reduction.last_team");
+  llvm::BasicBlock *LoopBB = CGF.createBasicBlock(".omp.reduction.teams_loop");
+  llvm::BasicBlock *BodyBB = CGF.createBasicBlock(".omp.reduction.teams_body");
+  llvm::BasicBlock *ReduceBB =
+      CGF.createBasicBlock(".omp.reduction.teams_reduce");
+  llvm::BasicBlock *LatchBB = CGF.createBasicBlock(".omp.reduction.teams_inc");
+  llvm::BasicBlock *DoneBB = CGF.createBasicBlock(".omp.reduction.teams_done");
+
+  Bld.CreateCondBr(Bld.CreateICmpEQ(IntraTeamRes, Bld.getInt32(1)), MasterBB,
+                   DoneBB);
+
+  // Publish the value of this team.
+  CGF.EmitBlock(MasterBB);
+  llvm::Value *TeamId = GetNVPTXBlockID(CGF);
+  llvm::Value *NumTeams = GetNVPTXNumBlocks(CGF);
+  llvm::Value *ScratchpadPtr =
+      Bld.CreatePointerBitCastOrAddrSpaceCast(Scratchpad, CGF.VoidPtrTy);
+  llvm::Value *CopyArgs[] = {ReduceData, ScratchpadPtr, TeamId, NumTeams};
+  CGF.EmitNounwindRuntimeCall(ScratchPadCopy, CopyArgs);
+  GetNVPTXGlobalMemFence(CGF);
+  llvm::Value *Finished =
+      Bld.CreateAtomicRMW(llvm::AtomicRMWInst::Add, Counter, Bld.getInt32(1),
+                          llvm::AtomicOrdering::Monotonic);
+  llvm::Value *IsLastTeam = Bld.CreateICmpEQ(
+      Finished, Bld.CreateNUWSub(NumTeams, Bld.getInt32(1)), "is_last_team");
+  llvm::BasicBlock *MasterExitBB = Bld.GetInsertBlock();
+  Bld.CreateCondBr(IsLastTeam, LastTeamBB, DoneBB);
+
+  // The last team to finish combines the values of all the other teams.
+  CGF.EmitBlock(LastTeamBB);
+  GetNVPTXGlobalMemFence(CGF);
+  Bld.CreateStore(Bld.getInt32(0), CounterAddr);
+  llvm::BasicBlock *PreheaderBB = Bld.GetInsertBlock();
+  CGF.EmitBlock(LoopBB);
+  auto *TeamIdx = Bld.CreatePHI(CGM.Int32Ty, /*NumReservedValues=*/2,
+                                "team_idx");
+  TeamIdx->addIncoming(Bld.getInt32(0), PreheaderBB);
+  llvm::BasicBlock *LoopExitBB =
+      CGF.createBasicBlock(".omp.reduction.teams_loop_exit");
+  Bld.CreateCondBr(Bld.CreateICmpULT(TeamIdx, NumTeams), BodyBB, LoopExitBB);
+
+  CGF.EmitBlock(BodyBB);
+  Bld.CreateCondBr(Bld.CreateICmpNE(TeamIdx, TeamId), ReduceBB, LatchBB);
+
+  CGF.EmitBlock(ReduceBB);
+  llvm::Value *ReduceArgs[] = {ReduceData, ScratchpadPtr, TeamIdx, NumTeams,
+                               /*ShouldReduce=*/Bld.getInt32(1)};
+  CGF.EmitNounwindRuntimeCall(LoadAndReduce, ReduceArgs);
+
+  CGF.EmitBlock(LatchBB);
+  TeamIdx->addIncoming(Bld.CreateNUWAdd(TeamIdx, Bld.getInt32(1)), LatchBB);
+  Bld.CreateBr(LoopBB);
+
+  CGF.EmitBlock(LoopExitBB);
+  llvm::BasicBlock *LastTeamExitBB = Bld.GetInsertBlock();
+
+  CGF.EmitBlock(DoneBB);
+  auto *Res = Bld.CreatePHI(CGM.Int32Ty, /*NumReservedValues=*/3,
+                            ".omp.reduction.teams_res");
+  Res->addIncoming(Bld.getInt32(0), EntryBB);
+  Res->addIncoming(Bld.getInt32(0), MasterExitBB);
+  Res->addIncoming(Bld.getInt32(1), LastTeamExitBB);
+  return Res;
+}
+
 const VarDecl *
 CGOpenMPRuntimeNVPTX::translateParameter(const FieldDecl *FD,
                                          const VarDecl *NativeParam) const {
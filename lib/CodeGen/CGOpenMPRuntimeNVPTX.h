@@ -18,14 +18,16 @@
 #include "CGOpenMPRuntime.h"
 #include "CodeGenFunction.h"
 #include "clang/AST/StmtOpenMP.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/IR/CallSite.h"
 
 namespace clang {
 namespace CodeGen {
 
 class CGOpenMPRuntimeNVPTX : public CGOpenMPRuntime {
-  llvm::StringMap<StringRef> stdFuncs;
-  StringRef RenameStandardFunction(StringRef name) override;
+  StringRef RenameStandardFunction(StringRef Name,
+                                   const FunctionDecl *FD) override;
 
   ///
   /// \param CGF Reference to current CodeGenFunction.
@@ -82,15 +84,20 @@ class CGOpenMPRuntimeNVPTX : public CGOpenMPRuntime {
   // \brief Return address of the initial slot that is used to share data.
   LValue getDataSharingRootSlotLValue(CodeGenFunction &CGF, bool IsMaster);
 
+  // \brief Create the per-team data sharing pool of a generic kernel.
+  llvm::GlobalVariable *createDataSharingPool(unsigned PoolSize);
+
   // \brief Initialize the data sharing slots and pointers and return the
-  // generated call.
-  void initializeDataSharing(CodeGenFunction &CGF, bool IsMaster);
+  // generated call. The master slot is taken from \p Pool if it is not null.
+  void initializeDataSharing(CodeGenFunction &CGF, bool IsMaster,
+                             llvm::GlobalVariable *Pool = nullptr);
 
   // \brief Initialize the data sharing slots and pointers and return the
   // generated call.
   llvm::Function *
   createKernelInitializerFunction(llvm::Function *WorkerFunction,
-                                  bool RequiresOMPRuntime);
+                                  bool RequiresOMPRuntime,
+                                  llvm::GlobalVariable *DataSharingPool);
 
 protected:
   /// \brief Returns __kmpc_for_static_init_* runtime function for the specified
@@ -112,6 +119,10 @@ public:
       // header - it has to be replaced by the address in shared memory and the
       // pointee has to be copied there.
       DST_Cast,
+      // A scalar allocated in the current function that the nested regions
+      // only read - the function keeps its own storage and the value is
+      // copied to shared memory every time a region is forked.
+      DST_Copy,
     };
     // The local values of the captures. The boolean indicates that what is
     // being shared is a reference and not the variable original storage.
@@ -199,15 +210,27 @@ private:
   struct DataSharingFunctionInfo {
     bool RequiresOMPRuntime;
     bool IsEntryPoint;
+    // The master frame is laid out in a __shared__ buffer of the kernel
+    // instead of being obtained from the runtime, so there is no environment
+    // to close.
+    bool UsesStaticFrame;
     llvm::Function *EntryWorkerFunction;
     llvm::BasicBlock *EntryExitBlock;
     llvm::BasicBlock *InitDSBlock;
     llvm::Function *InitializationFunction;
+    // The per-team data sharing pool of the kernel, if any.
+    llvm::GlobalVariable *DataSharingPool;
+    // The arguments of the initialization function. The boolean indicates that
+    // the value is passed as is and its uses are not replaced.
     SmallVector<std::pair<llvm::Value *, bool>, 16> ValuesToBeReplaced;
+    // The storage of the values that are copied to shared memory before each
+    // fork and the address where the location of their shared copy is saved.
+    SmallVector<std::pair<Address, Address>, 8> CopiedValues;
     DataSharingFunctionInfo()
         : RequiresOMPRuntime(true), IsEntryPoint(false),
-          EntryWorkerFunction(nullptr), EntryExitBlock(nullptr),
-          InitDSBlock(nullptr), InitializationFunction(nullptr) {}
+          UsesStaticFrame(false), EntryWorkerFunction(nullptr),
+          EntryExitBlock(nullptr), InitDSBlock(nullptr),
+          InitializationFunction(nullptr), DataSharingPool(nullptr) {}
   };
   typedef llvm::DenseMap<llvm::Function *, DataSharingFunctionInfo>
       DataSharingFunctionInfoMapTy;
@@ -218,6 +241,10 @@ private:
   void
   createDataSharingPerFunctionInfrastructure(CodeGenFunction &EnclosingCGF);
 
+  // \brief Copy the current value of the read-only captures of the function to
+  // shared memory before a region is forked.
+  void emitDataSharingValueCopies(CodeGenFunction &CGF);
+
   // \brief Create the data sharing arguments and call the parallel outlined
   // function.
   llvm::Function *createDataSharingParallelWrapper(
@@ -264,8 +291,8 @@ private:
           RequiresOMPRuntime(true), RequiresDataSharing(true),
           MayContainOrphanedParallel(true),
           HasAtMostOneNestedParallelInLexicalScope(false),
-          MasterSharedDataSize(0), ReductionVariableCount(0),
-          ReductionSizeInBytes(0) {
+          ExecutesTeamsRedundantly(false), MasterSharedDataSize(0),
+          ReductionVariableCount(0), ReductionSizeInBytes(0) {
       assert(isOpenMPTargetExecutionDirective(D.getDirectiveKind()) &&
              "Expecting a target execution directive.");
       setExecutionMode();
@@ -303,6 +330,8 @@ private:
              !MayContainOrphanedParallel;
     }
 
+    bool executesTeamsRedundantly() const { return ExecutesTeamsRedundantly; }
+
     unsigned masterSharedDataSize() const { return MasterSharedDataSize; }
 
     unsigned getReductionVariableCount() const {
@@ -332,6 +361,10 @@ private:
     // Record if the target region has at most a single nested parallel
     // region in its lexical scope.
     bool HasAtMostOneNestedParallelInLexicalScope;
+    // Record if the sequential part of the teams region is executed by all
+    // threads of the team in SPMD mode.  The nested parallel regions then
+    // need an explicit join barrier.
+    bool ExecutesTeamsRedundantly;
     // Approximate the size in bytes of variables to be shared from master
     // to workers.
     unsigned MasterSharedDataSize;
@@ -362,9 +395,11 @@ private:
   public:
     const TargetKernelProperties &TP;
     llvm::BasicBlock *ExitBB;
+    // %clock64 read in the entry header if cycles are counted.
+    llvm::Value *CycleCounterStart;
 
     EntryFunctionState(CodeGenModule &CGM, const TargetKernelProperties &TP)
-        : TP(TP), ExitBB(nullptr){};
+        : TP(TP), ExitBB(nullptr), CycleCounterStart(nullptr){};
   };
 
   class WorkerFunctionState {
@@ -373,10 +408,13 @@ private:
     llvm::Function *WorkerFn;
     const CGFunctionInfo *CGFI;
     SourceLocation Loc;
+    // Cycles spent by the workers in each parallel region, if counted.
+    llvm::GlobalVariable *ParallelCycleCounters;
 
     WorkerFunctionState(CodeGenModule &CGM, const TargetKernelProperties &TP,
                         SourceLocation Loc)
-        : TP(TP), WorkerFn(nullptr), CGFI(nullptr), Loc(Loc) {
+        : TP(TP), WorkerFn(nullptr), CGFI(nullptr), Loc(Loc),
+          ParallelCycleCounters(nullptr) {
       createWorkerFunction(CGM);
     };
 
@@ -388,9 +426,49 @@ private:
   bool IsOrphaned;
   // Track parallel nesting level.
   unsigned ParallelNestingLevel;
+  // Track whether L0 parallel regions in the current SPMD kernel are
+  // reached from a redundantly executed teams region.
+  bool RequiresL0JoinBarrier;
+  // Number of threads per team of the current SPMD kernel if it is known at
+  // compile time, zero otherwise.
+  unsigned ConstantTeamSize;
+  // The per-team data sharing pool of the current generic kernel, null if the
+  // runtime slots are grown on demand.
+  llvm::GlobalVariable *DataSharingPool;
   // Track whether the OMP runtime is available or elided for the
   // target region.
   bool IsOMPRuntimeInitialized;
+  // Per-phase cycle counters of the kernel being emitted with
+  // -fopenmp-nvptx-cycle-counters, null otherwise.
+  llvm::GlobalVariable *KernelCycleCounters;
+  // The kernels emitted for the target regions of the module.
+  SmallVector<llvm::Function *, 16> TargetRegionKernels;
+  // The loops whose uncoalesced schedule has been reported.
+  llvm::SmallPtrSet<const OMPLoopDirective *, 8> UncoalescedLoops;
+  // For each name of the critical regions emitted as atomic updates, the
+  // constant that selects the atomic update over the serialized region.
+  llvm::StringMap<llvm::GlobalVariable *> CriticalAtomicUpdateFlags;
+  // The names of the critical regions that cannot be atomic updates.
+  llvm::StringSet<> SerializedCriticalNames;
+
+  /// \brief Emits the update 'x' = 'x' \p BO \p E of a critical region as
+  /// an atomic update.  \p E is null for increments and decrements.
+  void emitCriticalRegionUpdate(CodeGenFunction &CGF, const Expr *X,
+                                const Expr *E, BinaryOperatorKind BO,
+                                SourceLocation Loc);
+
+  // State of a loop with a dynamic schedule between its dispatch init and its
+  // dispatch next. The counter is null if the loop calls the runtime.
+  struct NativeDispatchTy {
+    llvm::GlobalVariable *Counter = nullptr;
+    llvm::Value *LB = nullptr;
+    llvm::Value *UB = nullptr;
+    llvm::Value *Chunk = nullptr;
+    bool Guided = false;
+  };
+  // The loops whose dispatch was initialized and whose dispatch next has not
+  // been emitted yet.
+  SmallVector<NativeDispatchTy, 4> NativeDispatches;
 
   // The current codegen mode.  This is used to customize code generation of
   // certain constructs.
@@ -399,6 +477,24 @@ private:
   /// \brief Emit the worker function for the current target region.
   void emitWorkerFunction(WorkerFunctionState &WST);
 
+  /// Creates a zero-initialized array of \a NumCounters cycle counters in
+  /// device memory, to be renamed after the kernel once it is emitted.
+  llvm::GlobalVariable *createCycleCounters(unsigned NumCounters);
+
+  /// Returns the %clock64 of the current thread if the cycles of the kernel
+  /// being emitted are counted, null otherwise.
+  llvm::Value *emitCycleCounterStart(CodeGenFunction &CGF);
+
+  /// Adds the cycles elapsed since \a Start to counter \a Idx of
+  /// \a Counters. Does nothing if \a Start is null.
+  void emitCycleCounterStop(CodeGenFunction &CGF, llvm::Value *Start,
+                            llvm::GlobalVariable *Counters, unsigned Idx);
+
+  /// Merges the identical internal functions of the module and makes the
+  /// identical target regions, such as the ones of different instantiations
+  /// of a template, call a single copy of their body.
+  void mergeIdenticalTargetRegions();
+
   /// \brief Helper for worker function. Emit body of worker loop.
   void emitWorkerLoop(CodeGenFunction &CGF, WorkerFunctionState &WST);
 
@@ -528,6 +624,25 @@ private:
                                   OpenMPProcBindClauseKind ProcBind,
                                   SourceLocation Loc) override;
 
+  /// \brief Initialize the dispatch of a loop with a dynamic schedule. With
+  /// -fopenmp-nvptx-native-dynamic-schedule, the dynamic and guided loops of
+  /// SPMD parallel regions hand out their chunks from a counter in shared
+  /// memory instead of calling __kmpc_dispatch_init.
+  ///
+  virtual void emitForDispatchInit(CodeGenFunction &CGF, SourceLocation Loc,
+                                   const OpenMPScheduleTy &ScheduleKind,
+                                   unsigned IVSize, bool IVSigned, bool Ordered,
+                                   llvm::Value *LB, llvm::Value *UB,
+                                   llvm::Value *Chunk = nullptr) override;
+
+  /// \brief Get the next chunk of the loop whose dispatch was initialized
+  /// last, from the counter of the team if the loop is dispatched natively.
+  ///
+  virtual llvm::Value *emitForNext(CodeGenFunction &CGF, SourceLocation Loc,
+                                   unsigned IVSize, bool IVSigned,
+                                   Address IL, Address LB,
+                                   Address UB, Address ST) override;
+
   /// Call the appropriate runtime routine to notify that we finished
   /// iteration of the dynamic loop.
   ///
@@ -665,6 +780,29 @@ public:
                           SourceLocation Loc,
                           const Expr *Hint = nullptr) override;
 
+  /// \brief Emits a critical region whose body is a single update 'x op= expr'
+  /// of a scalar as a lock-free atomic update.  When all threads of a warp
+  /// update the same location their values are combined with warp shuffles
+  /// and a single atomic is issued per warp.
+  ///
+  /// The atomic update is only used if every critical region of the module
+  /// with the same name is a single update, because the others would not
+  /// exclude it.  Since later regions are not known yet, both the atomic
+  /// update and the serialized region are emitted, and the choice is made on
+  /// a constant that is cleared when a region that is not a single update is
+  /// found.
+  /// \param CriticalName Name of the critical region.
+  /// \param CriticalOpGen Generator for the statement associated with the
+  /// given critical region.
+  /// \param CriticalBody Statement associated with the critical region.
+  /// \param Hint Value of the 'hint' clause (optional).
+  bool emitCriticalRegionAsAtomicUpdate(CodeGenFunction &CGF,
+                                        StringRef CriticalName,
+                                        const RegionCodeGenTy &CriticalOpGen,
+                                        const Stmt *CriticalBody,
+                                        SourceLocation Loc,
+                                        const Expr *Hint = nullptr) override;
+
   /// \brief Check if we should generate code as if \a ScheduleKind is static
   /// with a chunk size of 1.
   /// \param ScheduleKind Schedule Kind specified in the 'schedule' clause.
@@ -680,21 +818,47 @@ public:
   /// \param DistScheduleKind Schedule Kind specified in the 'dist_schedule'
   /// clause.
   /// \param ScheduleKind Schedule Kind specified in the 'schedule' clause.
-  /// \param Chunked True if distribute chunk is specified in the clause.
+  /// \param DistChunkSize Distribute chunk specified in the clause, or
+  /// nullptr if there is none.
   /// \param ChunkSizeOne True if schedule chunk is one.
   /// \param Ordered true if loop is ordered, false otherwise.
   ///
   bool generateCoalescedSchedule(OpenMPDistScheduleClauseKind DistScheduleKind,
                                  OpenMPScheduleClauseKind ScheduleKind,
-                                 bool DistChunked, bool ChunkSizeOne,
+                                 const Expr *DistChunkSize, bool ChunkSizeOne,
                                  bool Ordered) const override;
 
+  /// \brief Report the clause, or the execution mode, that prevents the loop
+  /// directive \a S from being given a coalesced schedule, once per loop.
+  void emitUncoalescedScheduleRemark(const OMPLoopDirective &S) override;
+
+  /// \brief Check if the teams running the coalesced loop \a S may stage the
+  /// arrays read by their iterations in shared memory, which requires
+  /// -fopenmp-nvptx-stencil-tiling and a team size known at compile time.
+  bool getStencilStagingLimits(const OMPLoopDirective &S, unsigned &TeamSize,
+                               uint64_t &Budget) const override;
+
+  /// \brief Emit a buffer of \a NumElts elements of type \a EltTy in shared
+  /// memory.
+  Address emitStencilStagingBuffer(CodeGenFunction &CGF, QualType EltTy,
+                                   uint64_t NumElts) override;
+
+  /// \brief Emit the id of the current thread in its CTA and the number of
+  /// threads of the CTA.
+  std::pair<llvm::Value *, llvm::Value *>
+  emitTeamThreadIDAndSize(CodeGenFunction &CGF) override;
+
   /// \brief Check if we must always generate a barrier at the end of a
   /// particular construct regardless of the presence of a nowait clause.
   /// This may occur when a particular offload device does not support
   /// concurrent execution of certain directive and clause combinations.
   bool requiresBarrier(const OMPLoopDirective &S) const override;
 
+  /// \brief Check if the simd directive \a S must be outlined and executed by
+  /// the lanes of the device rather than emitted inline. The simd loops of SPMD
+  /// kernels are emitted inline.
+  bool requiresOutlinedSimd(const OMPLoopDirective &S) const override;
+
   /// \brief Emit an implicit/explicit barrier for OpenMP threads.
   /// \param Kind Directive for which this implicit barrier call must be
   /// generated. Must be OMPD_barrier for explicit barrier generation.
@@ -783,6 +947,21 @@ public:
   /// supports RTTI.
   bool requiresRTTIDescriptor() override { return false; }
 
+  /// Emit the inter-team stage of a teams reduction without going through
+  /// the runtime.  The team master copies the team value to a statically
+  /// sized scratchpad and the last team to finish, detected with an atomic
+  /// counter, reduces the values of all teams.
+  /// \param IntraTeamRes Result of the intra-team reduction, 1 in the thread
+  /// that holds the team value.
+  /// \param ReduceData Pointer to the list of reduction variables.
+  /// \return 1 in the thread that holds the final value, 0 otherwise.
+  llvm::Value *emitInlinedTeamsReduction(CodeGenFunction &CGF,
+                                         ArrayRef<const Expr *> Privates,
+                                         llvm::Value *IntraTeamRes,
+                                         llvm::Value *ReduceData,
+                                         llvm::Value *ScratchPadCopy,
+                                         llvm::Value *LoadAndReduce);
+
   virtual void emitReduction(CodeGenFunction &CGF, SourceLocation Loc,
                              ArrayRef<const Expr *> Privates,
                              ArrayRef<const Expr *> LHSExprs,
@@ -723,6 +723,9 @@ CGRecordLayout *CodeGenTypes::ComputeRecordLayout(const RecordDecl *D,
   // Add bitfield info.
   RL->BitFields.swap(Builder.BitFields);
 
+  ++NumRecordLayouts;
+  NumBitFieldsLaidOut += RL->BitFields.size();
+
   // Dump the layout, if requested.
   if (getContext().getLangOpts().DumpRecordLayouts) {
     llvm::outs() << "\n*** Dumping IRgen Record Layout\n";
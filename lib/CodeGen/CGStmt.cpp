@@ -27,6 +27,7 @@
 #include "llvm/IR/InlineAsm.h"
 #include "llvm/IR/Intrinsics.h"
 #include "llvm/IR/MDBuilder.h"
+#include "llvm/Support/SaveAndRestore.h"
 
 using namespace clang;
 using namespace CodeGen;
@@ -380,8 +381,23 @@ CodeGenFunction::EmitCompoundStmtWithoutScope(const CompoundStmt &S,
                                               AggValueSlot AggSlot) {
 
   for (CompoundStmt::const_body_iterator I = S.body_begin(),
-       E = S.body_end()-GetLast; I != E; ++I)
+       E = S.body_end()-GetLast; I != E; ++I) {
+    if (CGM.getCodeGenOpts().OpenMPFuseParallelRegions) {
+      if (unsigned NumFused =
+              EmitOMPFusedParallelDirectives(llvm::makeArrayRef(I, E))) {
+        I += NumFused - 1;
+        continue;
+      }
+    }
+    if (CGM.getCodeGenOpts().OpenMPHoistTargetData) {
+      if (unsigned NumHoisted =
+              EmitOMPHoistedTargetData(llvm::makeArrayRef(I, E))) {
+        I += NumHoisted - 1;
+        continue;
+      }
+    }
     EmitStmt(*I);
+  }
 
   Address RetAlloca = Address::invalid();
   if (GetLast) {
@@ -609,6 +625,18 @@ void CodeGenFunction::EmitIndirectGotoStmt(const IndirectGotoStmt &S) {
   EmitBranch(IndGotoBB);
 }
 
+/// Return the arm of \p S that is unlikely to run because its condition is a
+/// call to __builtin_expect, if any.
+static const Stmt *getUnlikelyArm(const IfStmt &S, const ASTContext &Ctx) {
+  const auto *Call = dyn_cast<CallExpr>(S.getCond()->IgnoreParenImpCasts());
+  if (!Call || Call->getBuiltinCallee() != Builtin::BI__builtin_expect)
+    return nullptr;
+  llvm::APSInt Expected;
+  if (!Call->getArg(1)->EvaluateAsInt(Expected, Ctx))
+    return nullptr;
+  return Expected.getBoolValue() ? S.getElse() : S.getThen();
+}
+
 void CodeGenFunction::EmitIfStmt(const IfStmt &S) {
   // C99 6.8.4.1: The first substatement is executed if the expression compares
   // unequal to 0.  The condition must be a scalar type.
@@ -655,11 +683,17 @@ void CodeGenFunction::EmitIfStmt(const IfStmt &S) {
   EmitBranchOnBoolExpr(S.getCond(), ThenBlock, ElseBlock,
                        getProfileCount(S.getThen()));
 
+  const Stmt *UnlikelyArm = nullptr;
+  if (CGM.getCodeGenOpts().ColdUnlikelyCalls)
+    UnlikelyArm = getUnlikelyArm(S, getContext());
+
   // Emit the 'then' code.
   EmitBlock(ThenBlock);
   incrementProfileCounter(&S);
   {
     RunCleanupsScope ThenScope(*this);
+    SaveAndRestore<bool> Unlikely(InUnlikelyPath,
+                                  InUnlikelyPath || UnlikelyArm == S.getThen());
     EmitStmt(S.getThen());
   }
   EmitBranch(ContBlock);
@@ -673,6 +707,8 @@ void CodeGenFunction::EmitIfStmt(const IfStmt &S) {
     }
     {
       RunCleanupsScope ElseScope(*this);
+      SaveAndRestore<bool> Unlikely(InUnlikelyPath,
+                                    InUnlikelyPath || UnlikelyArm == Else);
       EmitStmt(Else);
     }
     {
@@ -1081,6 +1117,7 @@ void CodeGenFunction::EmitReturnStmt(const ReturnStmt &S) {
                                 /*isInit*/ true);
       break;
     case TEK_Aggregate:
+      EmitAggregateCopyRemark(RV, ACR_Return);
       EmitAggExpr(RV, AggValueSlot::forAddr(ReturnValue,
                                             Qualifiers(),
                                             AggValueSlot::IsDestructed,
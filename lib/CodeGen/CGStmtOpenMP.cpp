@@ -18,8 +18,13 @@
 #include "TargetInfo.h"
 #include "clang/AST/Stmt.h"
 #include "clang/AST/StmtOpenMP.h"
+#include "clang/AST/StmtVisitor.h"
 #include "clang/AST/DeclOpenMP.h"
+#include "clang/Frontend/FrontendDiagnostic.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/IR/CallSite.h"
+#include "llvm/Support/SaveAndRestore.h"
 using namespace clang;
 using namespace CodeGen;
 
@@ -974,6 +979,13 @@ bool CodeGenFunction::EmitOMPCopyinClause(const OMPExecutableDirective &D) {
   return false;
 }
 
+/// Check if the private copies of the reduction and lastprivate variables must
+/// be padded to whole cache lines.
+static bool needsPaddedPrivateCopy(CodeGenFunction &CGF) {
+  return CGF.CGM.getCodeGenOpts().OpenMPPrivateCopyAlignment > 0 &&
+         !CGF.CGM.getLangOpts().OpenMPIsDevice;
+}
+
 bool CodeGenFunction::EmitOMPLastprivateClauseInit(
     const OMPExecutableDirective &D, OMPPrivateScope &PrivateScope) {
   if (!HaveInsertPoint())
@@ -1017,6 +1029,9 @@ bool CodeGenFunction::EmitOMPLastprivateClauseInit(
           auto *VD = cast<VarDecl>(cast<DeclRefExpr>(IInit)->getDecl());
           bool IsRegistered = PrivateScope.addPrivate(OrigVD, [&]() -> Address {
             // Emit private VarDecl with copy init.
+            llvm::SaveAndRestore<const VarDecl *> PaddedPrivate(
+                OMPPaddedPrivateCopy,
+                needsPaddedPrivateCopy(*this) ? VD : OMPPaddedPrivateCopy);
             EmitDecl(*VD);
             return GetAddrOfLocalVar(VD);
           });
@@ -1256,6 +1271,9 @@ void CodeGenFunction::EmitOMPReductionClauseInit(
     // Emit private VarDecl with reduction init.
     RedCG.emitSharedLValue(*this, Count);
     RedCG.emitAggregateType(*this, Count);
+    llvm::SaveAndRestore<const VarDecl *> PaddedPrivate(
+        OMPPaddedPrivateCopy,
+        needsPaddedPrivateCopy(*this) ? PrivateVD : OMPPaddedPrivateCopy);
     auto Emission = EmitAutoVarAlloca(*PrivateVD);
     RedCG.emitInitialization(*this, Count, Emission.getAllocatedAddress(),
                              RedCG.getSharedLValue(Count),
@@ -1433,10 +1451,91 @@ static void emitCommonOMPParallelDirective(CodeGenFunction &CGF,
     CapturedVars.push_back(UBCast);
   }
   CGF.GenerateOpenMPCapturedVars(*CS, CapturedVars, CaptureLevel);
+  if (CGF.OMPFusedParallelRegions) {
+    CGF.OMPFusedParallelRegions->emplace_back();
+    CGF.OMPFusedParallelRegions->back().OutlinedFn = OutlinedFn;
+    CGF.OMPFusedParallelRegions->back().CapturedVars.append(
+        CapturedVars.begin(), CapturedVars.end());
+    return;
+  }
   CGF.CGM.getOpenMPRuntime().emitParallelCall(CGF, S.getLocStart(), OutlinedFn,
                                               CapturedVars, IfCond);
 }
 
+/// Checks if the parallel region \a S can run under the fork of the parallel
+/// regions next to it: it uses the default team, has no code to run after its
+/// join and captures all the variables by reference, so that they do not
+/// depend on the point of the fork.
+static bool isFusibleParallelDirective(const Stmt *S) {
+  bool HasCancel;
+  if (const auto *D = dyn_cast<OMPParallelDirective>(S))
+    HasCancel = D->hasCancel();
+  else if (const auto *D = dyn_cast<OMPParallelForDirective>(S))
+    HasCancel = D->hasCancel();
+  else if (const auto *D = dyn_cast<OMPParallelSectionsDirective>(S))
+    HasCancel = D->hasCancel();
+  else if (isa<OMPParallelForSimdDirective>(S))
+    HasCancel = false;
+  else
+    return false;
+  if (HasCancel)
+    return false;
+  const auto &D = cast<OMPExecutableDirective>(*S);
+  for (const auto *C : D.clauses()) {
+    switch (C->getClauseKind()) {
+    case OMPC_if:
+    case OMPC_num_threads:
+    case OMPC_proc_bind:
+      return false;
+    default:
+      break;
+    }
+    if (const auto *CPI = OMPClauseWithPreInit::get(C))
+      if (CPI->getPreInitStmt())
+        return false;
+    if (const auto *CPU = OMPClauseWithPostUpdate::get(C))
+      if (CPU->getPostUpdateExpr())
+        return false;
+  }
+  for (const auto &C : cast<CapturedStmt>(D.getAssociatedStmt())->captures())
+    if (C.capturesVariableByCopy() || C.capturesVariableArrayType())
+      return false;
+  return true;
+}
+
+unsigned
+CodeGenFunction::EmitOMPFusedParallelDirectives(ArrayRef<Stmt *> Stmts) {
+  if (CGM.getLangOpts().OpenMPIsDevice || OMPFusedParallelRegions)
+    return 0;
+  unsigned NumFused = 0;
+  while (NumFused < Stmts.size() && isFusibleParallelDirective(Stmts[NumFused]))
+    ++NumFused;
+  if (NumFused < 2)
+    return 0;
+  // Emit the regions without their forks, then fork once for all of them.
+  SmallVector<OMPFusedParallelRegion, 4> Regions;
+  {
+    llvm::SaveAndRestore<SmallVectorImpl<OMPFusedParallelRegion> *>
+        SavedRegions(OMPFusedParallelRegions, &Regions);
+    for (const auto *S : Stmts.slice(0, NumFused))
+      EmitStmt(S);
+  }
+  if (Regions.empty())
+    return NumFused;
+  SmallVector<llvm::Value *, 4> OutlinedFns;
+  SmallVector<llvm::Value *, 16> CapturedVars;
+  for (const auto &R : Regions) {
+    OutlinedFns.push_back(R.OutlinedFn);
+    CapturedVars.append(R.CapturedVars.begin(), R.CapturedVars.end());
+  }
+  auto &RT = CGM.getOpenMPRuntime();
+  SourceLocation Loc = Stmts.front()->getLocStart();
+  RT.emitParallelCall(*this, Loc,
+                      RT.emitFusedParallelOutlinedFunction(Loc, OutlinedFns),
+                      CapturedVars, /*IfCond=*/nullptr);
+  return NumFused;
+}
+
 void CodeGenFunction::EmitOMPParallelDirective(const OMPParallelDirective &S) {
   // Emit parallel region as a standalone region.
   auto &&CodeGen = [&S](CodeGenFunction &CGF, PrePostActionTy &) {
@@ -1884,15 +1983,18 @@ void CodeGenFunction::EmitOMPSimdLoop(const OMPLoopDirective &S,
       CGF.incrementProfileCounter(&S);
     }
 
-    // Emit the lane init and num lanes variables for the nvptx device.
-    if (OutlinedSimd) {
-      const Expr *LIExpr = S.getLaneInit();
+    // Emit the lane init and num lanes variables for the nvptx device. A
+    // loop built for the lanes but emitted inline runs as a single lane.
+    if (const Expr *LIExpr = S.getLaneInit()) {
       const VarDecl *LIDecl =
           cast<VarDecl>(cast<DeclRefExpr>(LIExpr)->getDecl());
       CGF.EmitVarDecl(*LIDecl);
       LValue LI = CGF.EmitLValue(LIExpr);
       CGF.EmitStoreOfScalar(
-          CGF.CGM.getOpenMPRuntime().getLaneID(CGF, S.getLocStart()), LI);
+          OutlinedSimd
+              ? CGF.CGM.getOpenMPRuntime().getLaneID(CGF, S.getLocStart())
+              : llvm::ConstantInt::get(CGF.ConvertType(LIExpr->getType()), 0),
+          LI);
 
       const Expr *NLExpr = S.getNumLanes();
       const VarDecl *NLDecl =
@@ -1900,7 +2002,10 @@ void CodeGenFunction::EmitOMPSimdLoop(const OMPLoopDirective &S,
       CGF.EmitVarDecl(*NLDecl);
       LValue NL = CGF.EmitLValue(NLExpr);
       CGF.EmitStoreOfScalar(
-          CGF.CGM.getOpenMPRuntime().getNumLanes(CGF, S.getLocStart()), NL);
+          OutlinedSimd
+              ? CGF.CGM.getOpenMPRuntime().getNumLanes(CGF, S.getLocStart())
+              : llvm::ConstantInt::get(CGF.ConvertType(NLExpr->getType()), 1),
+          NL);
     }
 
     // Emit the loop iteration variable.
@@ -1990,8 +2095,9 @@ void CodeGenFunction::EmitOMPSimdLoop(const OMPLoopDirective &S,
 }
 
 void CodeGenFunction::EmitOMPSimdDirective(const OMPSimdDirective &S) {
-  bool OutlinedSimd =
-      CGM.getLangOpts().OpenMPIsDevice && CGM.getTriple().isNVPTX();
+  bool OutlinedSimd = CGM.getLangOpts().OpenMPIsDevice &&
+                      CGM.getTriple().isNVPTX() &&
+                      CGM.getOpenMPRuntime().requiresOutlinedSimd(S);
   EmitOMPSimdLoop(S, OutlinedSimd);
 }
 
@@ -2470,6 +2576,25 @@ namespace {
   };
 } // namespace
 
+/// Check whether the iterations of the doacross loop \p S can be posted per
+/// tile of -fopenmp-doacross-tile-size iterations. Every tile has to be
+/// executed by a single thread, so the loop needs a static or dynamic
+/// schedule whose constant chunk size is a multiple of the tile size.
+static bool hasTileAlignedChunks(CodeGenFunction &CGF,
+                                 const OMPLoopDirective &S) {
+  unsigned TileSize = CGF.CGM.getCodeGenOpts().OpenMPDoacrossTileSize;
+  if (TileSize <= 1 || isOpenMPLoopBoundSharingDirective(S.getDirectiveKind()))
+    return false;
+  const auto *C = S.getSingleClause<OMPScheduleClause>();
+  if (!C || !C->getChunkSize() ||
+      (C->getScheduleKind() != OMPC_SCHEDULE_static &&
+       C->getScheduleKind() != OMPC_SCHEDULE_dynamic))
+    return false;
+  llvm::APSInt Chunk;
+  return CGF.ConstantFoldsToSimpleInteger(C->getChunkSize(), Chunk) &&
+         Chunk.isStrictlyPositive() && Chunk.getZExtValue() % TileSize == 0;
+}
+
 bool CodeGenFunction::EmitOMPWorksharingLoop(const OMPLoopDirective &S) {
   // Emit the loop iteration variable.
   auto IVExpr = cast<DeclRefExpr>(S.getIterationVariable());
@@ -2516,11 +2641,16 @@ bool CodeGenFunction::EmitOMPWorksharingLoop(const OMPLoopDirective &S) {
       incrementProfileCounter(&S);
     }
 
+    // Post the iterations of a doacross loop per tile if its chunks are made
+    // of whole tiles.
+    llvm::SaveAndRestore<const OMPLoopDirective *> SavedDoacrossLoop(
+        OMPDoacrossTiledLoop, OMPDoacrossTiledLoop);
     bool Ordered = false;
     if (auto *OrderedClause = S.getSingleClause<OMPOrderedClause>()) {
-      if (OrderedClause->getNumForLoops())
+      if (OrderedClause->getNumForLoops()) {
+        OMPDoacrossTiledLoop = hasTileAlignedChunks(*this, S) ? &S : nullptr;
         RT.emitDoacrossInit(*this, S);
-      else
+      } else
         Ordered = true;
     }
 
@@ -2590,8 +2720,11 @@ bool CodeGenFunction::EmitOMPWorksharingLoop(const OMPLoopDirective &S) {
       }
       const unsigned IVSize = getContext().getTypeSize(IVExpr->getType());
       const bool IVSigned = IVExpr->getType()->hasSignedIntegerRepresentation();
-      if (RT.generateCoalescedSchedule(ScheduleKind.Schedule, ChunkSizeOne,
-                                       Ordered)) {
+      const bool Coalesced = RT.generateCoalescedSchedule(
+          ScheduleKind.Schedule, ChunkSizeOne, Ordered);
+      if (!Coalesced)
+        RT.emitUncoalescedScheduleRemark(S);
+      if (Coalesced) {
         // For NVPTX and other GPU targets high performance is often achieved
         // if adjacent threads access memory in a coalesced manner.  This is
         // true for loops that access memory with stride one if a static
@@ -2659,8 +2792,16 @@ bool CodeGenFunction::EmitOMPWorksharingLoop(const OMPLoopDirective &S) {
         CGOpenMPRuntime::StaticRTInput StaticInit(
             IVSize, IVSigned, Ordered, IL.getAddress(), LB.getAddress(),
             UB.getAddress(), ST.getAddress());
-        RT.emitForStaticInit(*this, S.getLocStart(), S.getDirectiveKind(),
-                             ScheduleKind, StaticInit);
+        // On the host the bounds of the thread can be computed inline from
+        // its number in the team, without calls to the runtime.
+        const bool InlineStaticInit =
+            CGM.getCodeGenOpts().OpenMPInlineStaticSchedule &&
+            !CGM.getLangOpts().OpenMPIsDevice;
+        if (InlineStaticInit)
+          RT.emitInlinedForStaticInit(*this, S.getLocStart(), StaticInit);
+        else
+          RT.emitForStaticInit(*this, S.getLocStart(), S.getDirectiveKind(),
+                               ScheduleKind, StaticInit);
         auto LoopExit =
             getJumpDestInCurrentScope(createBasicBlock("omp.loop.exit"));
         // UB = min(UB, GlobalUB);
@@ -2677,9 +2818,10 @@ bool CodeGenFunction::EmitOMPWorksharingLoop(const OMPLoopDirective &S) {
                          [](CodeGenFunction &) {});
         EmitBlock(LoopExit.getBlock());
         // Tell the runtime we are done.
-        auto &&CodeGen = [&S](CodeGenFunction &CGF) {
-          CGF.CGM.getOpenMPRuntime().emitForStaticFinish(CGF, S.getLocEnd(),
-                                                         S.getDirectiveKind());
+        auto &&CodeGen = [&S, InlineStaticInit](CodeGenFunction &CGF) {
+          if (!InlineStaticInit)
+            CGF.CGM.getOpenMPRuntime().emitForStaticFinish(
+                CGF, S.getLocEnd(), S.getDirectiveKind());
         };
         OMPCancelStack.emitExit(*this, S.getDirectiveKind(), CodeGen);
       } else {
@@ -3022,6 +3164,11 @@ void CodeGenFunction::EmitOMPCriticalDirective(const OMPCriticalDirective &S) {
   if (auto *HintClause = S.getSingleClause<OMPHintClause>())
     Hint = HintClause->getHint();
   OMPLexicalScope Scope(*this, S, /*AsInlined=*/true);
+  if (CGM.getOpenMPRuntime().emitCriticalRegionAsAtomicUpdate(
+          *this, S.getDirectiveName().getAsString(), CodeGen,
+          cast<CapturedStmt>(S.getAssociatedStmt())->getCapturedStmt(),
+          S.getLocStart(), Hint))
+    return;
   CGM.getOpenMPRuntime().emitCriticalRegion(*this,
                                             S.getDirectiveName().getAsString(),
                                             CodeGen, S.getLocStart(), Hint);
@@ -3115,7 +3262,8 @@ void CodeGenFunction::EmitOMPTaskBasedDirective(const OMPExecutableDirective &S,
     auto IElemInitRef = C->inits().begin();
     for (auto *IInit : C->private_copies()) {
       auto *OrigVD = cast<VarDecl>(cast<DeclRefExpr>(*IRef)->getDecl());
-      if (EmittedAsPrivate.insert(OrigVD->getCanonicalDecl()).second) {
+      if (!Data.SharedFirstprivates.count(OrigVD->getCanonicalDecl()) &&
+          EmittedAsPrivate.insert(OrigVD->getCanonicalDecl()).second) {
         Data.FirstprivateVars.push_back(*IRef);
         Data.FirstprivateCopies.push_back(IInit);
         Data.FirstprivateInits.push_back(*IElemInitRef);
@@ -3368,11 +3516,30 @@ void CodeGenFunction::EmitOMPTaskBasedDirective(const OMPExecutableDirective &S,
   TaskGen(*this, OutlinedFn, Data);
 }
 
+/// Check if task \a S may be emitted inline as a serial version of its body
+/// instead of through the runtime: it has no dependences to wait for, no
+/// in_reduction items and no cancellation points.
+static bool canEmitSerialTask(const OMPTaskDirective &S) {
+  return !S.hasClausesOfKind<OMPDependClause>() &&
+         !S.hasClausesOfKind<OMPInReductionClause>() && !S.hasCancel();
+}
+
+/// Emit the body of task \a S inline with its private copies, i.e. as an
+/// undeferred task that never touches a task descriptor.
+static void emitSerialTask(CodeGenFunction &CGF, const OMPTaskDirective &S) {
+  auto &&CodeGen = [&S](CodeGenFunction &CGF, PrePostActionTy &Action) {
+    Action.Enter(CGF);
+    CodeGenFunction::OMPPrivateScope TaskScope(CGF);
+    (void)CGF.EmitOMPFirstprivateClause(S, TaskScope);
+    CGF.EmitOMPPrivateClause(S, TaskScope);
+    (void)TaskScope.Privatize();
+    CGF.EmitStmt(cast<CapturedStmt>(S.getAssociatedStmt())->getCapturedStmt());
+  };
+  OMPLexicalScope Scope(CGF, S, /*AsInlined=*/true);
+  CGF.CGM.getOpenMPRuntime().emitInlinedDirective(CGF, OMPD_task, CodeGen);
+}
+
 void CodeGenFunction::EmitOMPTaskDirective(const OMPTaskDirective &S) {
-  // Emit outlined function for task construct.
-  auto CS = cast<CapturedStmt>(S.getAssociatedStmt());
-  auto CapturedStruct = GenerateCapturedStmtArgument(*CS);
-  auto SharedsTy = getContext().getRecordType(CS->getCapturedRecordDecl());
   const Expr *IfCond = nullptr;
   for (const auto *C : S.getClausesOfKind<OMPIfClause>()) {
     if (C->getNameModifier() == OMPD_unknown ||
@@ -3382,6 +3549,46 @@ void CodeGenFunction::EmitOMPTaskDirective(const OMPTaskDirective &S) {
     }
   }
 
+  // A task whose 'if' condition is false is run immediately by the
+  // encountering thread, so branch once at the creation site to an inline
+  // serial version of the body. Final tasks keep the runtime path, which
+  // records that they and the tasks they include are final for
+  // omp_in_final(). The condition is evaluated again by the task path, so it
+  // must be free of side effects.
+  if (CGM.getCodeGenOpts().OpenMPTaskSerialCutoff && IfCond &&
+      !S.getSingleClause<OMPFinalClause>() && canEmitSerialTask(S) &&
+      !IfCond->HasSideEffects(getContext())) {
+    llvm::Value *IsSerial = Builder.CreateNot(EvaluateExprAsBool(IfCond));
+    auto *ConstSerial = dyn_cast<llvm::ConstantInt>(IsSerial);
+    if (ConstSerial && ConstSerial->isOne()) {
+      emitSerialTask(*this, S);
+      return;
+    }
+    if (!ConstSerial) {
+      auto *SerialBlock = createBasicBlock("omp.task.serial");
+      auto *DeferredBlock = createBasicBlock("omp.task.deferred");
+      auto *ContBlock = createBasicBlock("omp.task.cont");
+      Builder.CreateCondBr(IsSerial, SerialBlock, DeferredBlock);
+      EmitBlock(SerialBlock);
+      emitSerialTask(*this, S);
+      EmitBranch(ContBlock);
+      EmitBlock(DeferredBlock);
+      EmitOMPTaskCall(S, IfCond);
+      EmitBranch(ContBlock);
+      EmitBlock(ContBlock, /*IsFinished=*/true);
+      return;
+    }
+  }
+  EmitOMPTaskCall(S, IfCond);
+}
+
+void CodeGenFunction::EmitOMPTaskCall(const OMPTaskDirective &S,
+                                      const Expr *IfCond) {
+  // Emit outlined function for task construct.
+  auto CS = cast<CapturedStmt>(S.getAssociatedStmt());
+  auto CapturedStruct = GenerateCapturedStmtArgument(*CS);
+  auto SharedsTy = getContext().getRecordType(CS->getCapturedRecordDecl());
+
   OMPTaskDataTy Data;
   // Check if we should emit tied or untied task.
   Data.Tied = !S.getSingleClause<OMPUntiedClause>();
@@ -3470,6 +3677,361 @@ void CodeGenFunction::EmitOMPLastprivateUpdateDirective(
   }
 }
 
+namespace {
+/// A two-dimensional array of constant size that the body of a collapsed loop
+/// only reads, at constant offsets from the loop counters.
+struct OMPStencilArray {
+  const VarDecl *VD;
+  const DeclRefExpr *Ref;
+  QualType EltTy;
+  uint64_t RowSize;
+  uint64_t NumElts;
+  /// The smallest and the largest of the offsets of the reads, flattened.
+  int64_t MinOffset;
+  int64_t MaxOffset;
+  SmallVector<const ArraySubscriptExpr *, 8> Reads;
+};
+
+/// Collects the arrays of the body of a loop with a 'collapse(2)' clause that
+/// are read as 'a[i + c1][j + c2]', where 'i' and 'j' are the counters of the
+/// outer and the inner loop.  Arrays that are used in any other way are
+/// dropped.
+class OMPStencilReadCollector {
+  ASTContext &C;
+  const VarDecl *OuterCounter;
+  const VarDecl *InnerCounter;
+  SmallVector<OMPStencilArray, 4> Arrays;
+  llvm::SmallPtrSet<const VarDecl *, 8> OtherUses;
+
+  static bool isCounterRef(const Expr *E, const VarDecl *Counter) {
+    const auto *DRE = dyn_cast<DeclRefExpr>(E->IgnoreParenImpCasts());
+    return DRE && DRE->getDecl()->getCanonicalDecl() == Counter;
+  }
+
+  /// Check if \a E is 'Counter', 'Counter + c', 'c + Counter' or
+  /// 'Counter - c' for a constant 'c', and return 'c' in \a Offset.
+  bool getCounterOffset(const Expr *E, const VarDecl *Counter,
+                        int64_t &Offset) const {
+    Offset = 0;
+    if (isCounterRef(E, Counter))
+      return true;
+    const auto *BO = dyn_cast<BinaryOperator>(E->IgnoreParenImpCasts());
+    if (!BO || (BO->getOpcode() != BO_Add && BO->getOpcode() != BO_Sub))
+      return false;
+    const Expr *CounterExpr = BO->getLHS();
+    const Expr *OffsetExpr = BO->getRHS();
+    if (BO->getOpcode() == BO_Add && !isCounterRef(CounterExpr, Counter))
+      std::swap(CounterExpr, OffsetExpr);
+    llvm::APSInt Val;
+    if (!isCounterRef(CounterExpr, Counter) ||
+        !OffsetExpr->EvaluateAsInt(Val, C) || Val.getMinSignedBits() > 32)
+      return false;
+    Offset =
+        BO->getOpcode() == BO_Add ? Val.getSExtValue() : -Val.getSExtValue();
+    return true;
+  }
+
+  /// Record \a E if it is a stencil read of a two-dimensional array.
+  bool recordRead(const ArraySubscriptExpr *E) {
+    const auto *Row =
+        dyn_cast<ArraySubscriptExpr>(E->getBase()->IgnoreParenImpCasts());
+    if (!Row)
+      return false;
+    const auto *DRE =
+        dyn_cast<DeclRefExpr>(Row->getBase()->IgnoreParenImpCasts());
+    const auto *VD = DRE ? dyn_cast<VarDecl>(DRE->getDecl()) : nullptr;
+    if (!VD)
+      return false;
+    const auto *OuterTy = C.getAsConstantArrayType(VD->getType());
+    const auto *InnerTy =
+        OuterTy ? C.getAsConstantArrayType(OuterTy->getElementType())
+                : nullptr;
+    if (!InnerTy || !InnerTy->getElementType()->isArithmeticType() ||
+        InnerTy->getElementType().isVolatileQualified())
+      return false;
+    int64_t RowOffset, ColOffset;
+    if (!getCounterOffset(Row->getIdx(), OuterCounter, RowOffset) ||
+        !getCounterOffset(E->getIdx(), InnerCounter, ColOffset))
+      return false;
+    uint64_t RowSize = InnerTy->getSize().getZExtValue();
+    int64_t Offset = RowOffset * static_cast<int64_t>(RowSize) + ColOffset;
+    VD = VD->getCanonicalDecl();
+    auto It = llvm::find_if(Arrays, [VD](const OMPStencilArray &A) {
+      return A.VD == VD;
+    });
+    if (It == Arrays.end()) {
+      Arrays.push_back({VD, DRE, InnerTy->getElementType(), RowSize,
+                        OuterTy->getSize().getZExtValue() * RowSize, Offset,
+                        Offset, {}});
+      It = std::prev(Arrays.end());
+    }
+    It->MinOffset = std::min(It->MinOffset, Offset);
+    It->MaxOffset = std::max(It->MaxOffset, Offset);
+    It->Reads.push_back(E);
+    return true;
+  }
+
+public:
+  OMPStencilReadCollector(ASTContext &C, const VarDecl *OuterCounter,
+                          const VarDecl *InnerCounter)
+      : C(C), OuterCounter(OuterCounter), InnerCounter(InnerCounter) {}
+
+  void visit(const Stmt *S) {
+    if (!S)
+      return;
+    if (const auto *ICE = dyn_cast<ImplicitCastExpr>(S))
+      if (ICE->getCastKind() == CK_LValueToRValue)
+        if (const auto *ASE = dyn_cast<ArraySubscriptExpr>(
+                ICE->getSubExpr()->IgnoreParens()))
+          if (recordRead(ASE))
+            return;
+    if (const auto *DRE = dyn_cast<DeclRefExpr>(S))
+      if (const auto *VD = dyn_cast<VarDecl>(DRE->getDecl()))
+        OtherUses.insert(VD->getCanonicalDecl());
+    for (const Stmt *Child : S->children())
+      visit(Child);
+  }
+
+  /// Return the arrays that are only read, at two or more distinct offsets,
+  /// so that neighbouring iterations share some of their elements.
+  SmallVector<OMPStencilArray, 4> getStencilArrays() const {
+    SmallVector<OMPStencilArray, 4> Result;
+    for (const OMPStencilArray &A : Arrays)
+      if (!OtherUses.count(A.VD) && A.MinOffset != A.MaxOffset)
+        Result.push_back(A);
+    return Result;
+  }
+};
+} // namespace
+
+// The iterations of the coalesced schedule run by the threads of a team in
+// one step are consecutive, so the team reads a contiguous window of each
+// stencil array, widened by the offsets of the reads:
+//
+// while (UB = min(UB, GlobalUB), idx = LB, idx - tid < UB) {
+//   lo = max(flat(idx - tid) + MinOffset, 0);
+//   len = min(flat(idx - tid + nthreads - 1) + MaxOffset, N * M - 1) - lo + 1;
+//   len = max(min(len, TileSize), 0);
+//   for (k = tid; k < len; k += nthreads)
+//     tile[k] = a[lo + k];
+//   barrier;
+//   if (idx < UB)
+//     BODY; // a[i][j] reads tile[flat(i, j) - lo] if it is in the window.
+//   barrier;
+//   LB = LB + ST;
+//   UB = UB + ST;
+// }
+//
+// where flat(i, j) = i * M + j.  All the threads of the team run the same
+// number of steps, so that they all reach the barriers.  Reads outside of the
+// window, e.g. if the team is smaller than expected or its iterations span
+// rows of different lengths, fall back to the array itself.
+bool CodeGenFunction::EmitOMPStencilStagedLoop(const OMPLoopDirective &S,
+                                               JumpDest LoopExit) {
+  auto &RT = CGM.getOpenMPRuntime();
+  unsigned TeamSize;
+  uint64_t Budget;
+  if (S.getDirectiveKind() != OMPD_target_teams_distribute_parallel_for ||
+      S.getCollapsedNumber() != 2 ||
+      !RT.getStencilStagingLimits(S, TeamSize, Budget))
+    return false;
+  const auto *OuterCounter = cast<VarDecl>(
+      cast<DeclRefExpr>(S.counters()[0])->getDecl()->getCanonicalDecl());
+  const auto *InnerCounter = cast<VarDecl>(
+      cast<DeclRefExpr>(S.counters()[1])->getDecl()->getCanonicalDecl());
+  OMPStencilReadCollector Collector(getContext(), OuterCounter, InnerCounter);
+  Collector.visit(S.getBody());
+  SmallVector<OMPStencilArray, 4> Arrays = Collector.getStencilArrays();
+
+  // Stage the arrays in the order they are found while they fit the budget.
+  SmallVector<uint64_t, 4> TileSizes;
+  uint64_t Size = 0;
+  for (auto It = Arrays.begin(); It != Arrays.end();) {
+    uint64_t TileSize = std::min<uint64_t>(
+        TeamSize + (It->MaxOffset - It->MinOffset) + It->RowSize,
+        It->NumElts);
+    uint64_t TileBytes =
+        TileSize * getContext().getTypeSizeInChars(It->EltTy).getQuantity();
+    if (Size + TileBytes > Budget) {
+      It = Arrays.erase(It);
+      continue;
+    }
+    Size += TileBytes;
+    TileSizes.push_back(TileSize);
+    ++It;
+  }
+  if (Arrays.empty())
+    return false;
+
+  SourceLocation Loc = S.getLocStart();
+  LValue IV = EmitLValue(S.getIterationVariable());
+  QualType IVTy = S.getIterationVariable()->getType();
+  bool IVSigned = IVTy->hasSignedIntegerRepresentation();
+  llvm::Type *IVLLTy = ConvertType(IVTy);
+  llvm::Value *ThreadID, *NumThreads;
+  std::tie(ThreadID, NumThreads) = RT.emitTeamThreadIDAndSize(*this);
+  llvm::Value *ThreadIdx = Builder.CreateZExt(ThreadID, Int64Ty);
+  llvm::Value *NumThreadsIdx = Builder.CreateZExt(NumThreads, Int64Ty);
+  ThreadID = Builder.CreateZExtOrTrunc(ThreadID, IVLLTy);
+  NumThreads = Builder.CreateZExtOrTrunc(NumThreads, IVLLTy);
+  llvm::Value *LastIteration = EmitScalarConversion(
+      EmitScalarExpr(S.getLastIteration()), S.getLastIteration()->getType(),
+      IVTy, Loc);
+
+  SmallVector<OMPStagedArrayRead, 4> Staged;
+  for (unsigned I = 0, E = Arrays.size(); I < E; ++I) {
+    llvm::Type *EltTy = ConvertTypeForMem(Arrays[I].EltTy);
+    OMPStagedArrayRead Read;
+    Read.Array =
+        Builder.CreateElementBitCast(EmitLValue(Arrays[I].Ref).getAddress(),
+                                     EltTy);
+    Read.Buffer = Builder.CreateElementBitCast(
+        RT.emitStencilStagingBuffer(*this, Arrays[I].EltTy, TileSizes[I]),
+        EltTy);
+    Read.RowSize = Arrays[I].RowSize;
+    Staged.push_back(Read);
+  }
+
+  auto *CondBB = createBasicBlock("omp.stencil.cond");
+  auto *BodyBB = createBasicBlock("omp.stencil.body");
+  EmitBlock(CondBB);
+  // The team runs as long as its first iteration does.
+  llvm::Value *LB = EmitLoadOfScalar(IV, Loc);
+  llvm::Value *TeamIV = Builder.CreateSub(LB, ThreadID, "omp.stencil.team.iv");
+  EmitStoreOfScalar(TeamIV, IV);
+  llvm::Value *TeamCond = EvaluateExprAsBool(S.getDistCond());
+  Builder.CreateCondBr(TeamCond, BodyBB, LoopExit.getBlock());
+
+  EmitBlock(BodyBB);
+  // Find the elements read by the first and the last iteration of the team.
+  auto &&EmitCounters = [this, &S, &IV, Loc](llvm::Value *IVVal) {
+    EmitStoreOfScalar(IVVal, IV);
+    for (const Expr *U : S.updates())
+      EmitIgnoredExpr(U);
+    auto &&EmitCounter = [this, Loc](const Expr *Counter) {
+      return Builder.CreateIntCast(
+          EmitLoadOfScalar(EmitLValue(Counter), Loc), Int64Ty,
+          Counter->getType()->hasSignedIntegerRepresentation());
+    };
+    llvm::Value *Outer = EmitCounter(S.counters()[0]);
+    return std::make_pair(Outer, EmitCounter(S.counters()[1]));
+  };
+  llvm::Value *LastTeamIV = Builder.CreateAdd(
+      TeamIV, Builder.CreateSub(NumThreads, llvm::ConstantInt::get(IVLLTy, 1)));
+  LastTeamIV = Builder.CreateSelect(
+      IVSigned ? Builder.CreateICmpSLT(LastTeamIV, LastIteration)
+               : Builder.CreateICmpULT(LastTeamIV, LastIteration),
+      LastTeamIV, LastIteration);
+  auto First = EmitCounters(TeamIV);
+  auto Last = EmitCounters(LastTeamIV);
+  EmitStoreOfScalar(LB, IV);
+
+  auto &&Max = [this](llvm::Value *LHS, llvm::Value *RHS) {
+    return Builder.CreateSelect(Builder.CreateICmpSGT(LHS, RHS), LHS, RHS);
+  };
+  auto &&Min = [this](llvm::Value *LHS, llvm::Value *RHS) {
+    return Builder.CreateSelect(Builder.CreateICmpSLT(LHS, RHS), LHS, RHS);
+  };
+  for (unsigned I = 0, E = Arrays.size(); I < E; ++I) {
+    const OMPStencilArray &A = Arrays[I];
+    OMPStagedArrayRead &Read = Staged[I];
+    llvm::Value *RowSize = llvm::ConstantInt::get(Int64Ty, A.RowSize);
+    llvm::Value *FirstElt = Builder.CreateAdd(
+        Builder.CreateMul(First.first, RowSize), First.second);
+    llvm::Value *LastElt = Builder.CreateAdd(
+        Builder.CreateMul(Last.first, RowSize), Last.second);
+    llvm::Value *Lo = Builder.CreateAdd(
+        Min(FirstElt, LastElt), llvm::ConstantInt::get(Int64Ty, A.MinOffset));
+    Lo = Max(Lo, llvm::ConstantInt::get(Int64Ty, 0));
+    llvm::Value *Hi = Builder.CreateAdd(
+        Max(FirstElt, LastElt), llvm::ConstantInt::get(Int64Ty, A.MaxOffset));
+    Hi = Min(Hi, llvm::ConstantInt::get(Int64Ty, A.NumElts - 1));
+    llvm::Value *Len = Builder.CreateAdd(Builder.CreateSub(Hi, Lo),
+                                         llvm::ConstantInt::get(Int64Ty, 1));
+    Len = Min(Len, llvm::ConstantInt::get(Int64Ty, TileSizes[I]));
+    Len = Max(Len, llvm::ConstantInt::get(Int64Ty, 0));
+    Read.Lo = Lo;
+    Read.Len = Len;
+
+    // The threads of the team copy the window together.
+    auto *CopyBB = createBasicBlock("omp.stencil.copy");
+    auto *CopyEndBB = createBasicBlock("omp.stencil.copy.end");
+    llvm::BasicBlock *EntryBB = Builder.GetInsertBlock();
+    Builder.CreateCondBr(Builder.CreateICmpSLT(ThreadIdx, Len), CopyBB,
+                         CopyEndBB);
+    EmitBlock(CopyBB);
+    auto *K = Builder.CreatePHI(Int64Ty, 2, "omp.stencil.k");
+    K->addIncoming(ThreadIdx, EntryBB);
+    CharUnits EltAlign = getContext().getTypeAlignInChars(A.EltTy);
+    llvm::Value *Elt = Builder.CreateAlignedLoad(
+        Builder.CreateInBoundsGEP(Read.Array.getPointer(),
+                                  Builder.CreateAdd(Lo, K)),
+        EltAlign.getQuantity());
+    Builder.CreateAlignedStore(
+        Elt, Builder.CreateInBoundsGEP(Read.Buffer.getPointer(), K),
+        EltAlign.getQuantity());
+    llvm::Value *NextK = Builder.CreateAdd(K, NumThreadsIdx);
+    K->addIncoming(NextK, Builder.GetInsertBlock());
+    Builder.CreateCondBr(Builder.CreateICmpSLT(NextK, Len), CopyBB,
+                         CopyEndBB);
+    EmitBlock(CopyEndBB);
+  }
+  RT.emitBarrierCall(*this, Loc, OMPD_unknown, /*EmitChecks=*/false,
+                     /*ForceSimpleCall=*/true);
+
+  // Each thread runs its own iteration, if there is one.
+  auto *IterBB = createBasicBlock("omp.stencil.iter");
+  auto *NextBB = createBasicBlock("omp.stencil.next");
+  Builder.CreateCondBr(EvaluateExprAsBool(S.getDistCond()), IterBB, NextBB);
+  EmitBlock(IterBB);
+  for (unsigned I = 0, E = Arrays.size(); I < E; ++I)
+    for (const ArraySubscriptExpr *Read : Arrays[I].Reads)
+      OMPStagedArrayReads[Read] = Staged[I];
+  EmitOMPLoopBody(S, LoopExit);
+  EmitStopPoint(&S);
+  OMPStagedArrayReads.clear();
+  EmitBlock(NextBB);
+  // Wait for the team to be done with the window before replacing it.
+  RT.emitBarrierCall(*this, Loc, OMPD_unknown, /*EmitChecks=*/false,
+                     /*ForceSimpleCall=*/true);
+  // LB = LB + Stride
+  EmitIgnoredExpr(S.getNextLowerBound());
+  // UB = min(UB + Stride, GlobalUB);
+  EmitIgnoredExpr(S.getNextUpperBound());
+  EmitIgnoredExpr(S.getEnsureUpperBound());
+  // IV = LB;
+  EmitIgnoredExpr(S.getInit());
+  EmitBranch(CondBB);
+  return true;
+}
+
+LValue CodeGenFunction::EmitOMPStagedArraySubscriptExpr(
+    const ArraySubscriptExpr *E, const OMPStagedArrayRead &Read) {
+  const auto *Row =
+      cast<ArraySubscriptExpr>(E->getBase()->IgnoreParenImpCasts());
+  auto &&EmitIdx = [this](const Expr *Idx) {
+    return Builder.CreateIntCast(
+        EmitScalarExpr(Idx), Int64Ty,
+        Idx->getType()->isSignedIntegerOrEnumerationType());
+  };
+  llvm::Value *Flat = Builder.CreateAdd(
+      Builder.CreateMul(EmitIdx(Row->getIdx()),
+                        llvm::ConstantInt::get(Int64Ty, Read.RowSize)),
+      EmitIdx(E->getIdx()), "omp.stencil.flat");
+  llvm::Value *TileIdx = Builder.CreateSub(Flat, Read.Lo);
+  llvm::Value *InTile = Builder.CreateICmpULT(TileIdx, Read.Len);
+  llvm::Value *ArrayPtr =
+      Builder.CreateInBoundsGEP(Read.Array.getPointer(), Flat);
+  llvm::Value *TilePtr = Builder.CreateAddrSpaceCast(
+      Builder.CreateGEP(Read.Buffer.getPointer(), TileIdx),
+      ArrayPtr->getType());
+  llvm::Value *Ptr =
+      Builder.CreateSelect(InTile, TilePtr, ArrayPtr, "omp.stencil.elt");
+  return MakeAddrLValue(
+      Address(Ptr, getContext().getTypeAlignInChars(E->getType())),
+      E->getType());
+}
+
 void CodeGenFunction::EmitOMPDistributeLoop(
     const OMPLoopDirective &S,
     const RegionCodeGenTy &CodeGenDistributeLoopContent) {
@@ -3537,11 +4099,13 @@ void CodeGenFunction::EmitOMPDistributeLoop(
 
       // Detect the distribute schedule kind and chunk.
       llvm::Value *DistChunk = nullptr;
+      const Expr *DistChunkExpr = nullptr;
       OpenMPDistScheduleClauseKind DistScheduleKind =
           OMPC_DIST_SCHEDULE_unknown;
       if (auto *C = S.getSingleClause<OMPDistScheduleClause>()) {
         DistScheduleKind = C->getDistScheduleKind();
         if (const auto *Ch = C->getChunkSize()) {
+          DistChunkExpr = Ch;
           DistChunk = EmitScalarExpr(Ch);
           DistChunk = EmitScalarConversion(DistChunk, Ch->getType(),
                                            S.getIterationVariable()->getType(),
@@ -3574,18 +4138,20 @@ void CodeGenFunction::EmitOMPDistributeLoop(
       }
       const bool Ordered = S.getSingleClause<OMPOrderedClause>() != nullptr;
 
-      if (RT.generateCoalescedSchedule(DistScheduleKind, ScheduleKind,
-                                       /* Chunked */ DistChunk != nullptr,
-                                       ChunkSizeOne, Ordered)) {
+      const bool Coalesced = RT.generateCoalescedSchedule(
+          DistScheduleKind, ScheduleKind, DistChunkExpr, ChunkSizeOne, Ordered);
+      if (!Coalesced)
+        RT.emitUncoalescedScheduleRemark(S);
+      if (Coalesced) {
         // For NVPTX and other GPU targets high performance is often achieved
         // if adjacent threads access memory in a coalesced manner.  This is
         // true for loops that access memory with stride one if a static
         // schedule with chunk size of 1 is used.  We generate such code
         // whenever the OpenMP standard gives us freedom to do so.
         //
-        // This case is called if there is no dist_schedule clause, and there is
-        // no schedule clause, with a schedule(auto), or with a
-        // schedule(static,1).
+        // This case is called if there is no dist_schedule clause, or one
+        // whose chunk matches the team size, and there is no schedule clause,
+        // with a schedule(auto), or with a schedule(static,1).
         //
         // Codegen is optimized for this case.  Since chunk size is 1 we do not
         // need to generate the inner loop, i.e., the chunk iterator can be
@@ -3595,6 +4161,12 @@ void CodeGenFunction::EmitOMPDistributeLoop(
         //   LB = LB + ST;
         //   UB = UB + ST;
         // }
+        //
+        // Sema builds the distribute condition as IV < GlobalUB when it
+        // predicts this schedule and as IV <= UB otherwise, e.g. for a
+        // dist_schedule chunk that turns out to match the team size. UB is
+        // kept up to date so that either form is correct; it folds away when
+        // the condition does not read it.
         if (!Chunk) // Force use of chunk = 1.
           Chunk = Builder.getIntN(IVSize, 1);
         CGOpenMPRuntime::StaticRTInput StaticInit(
@@ -3604,22 +4176,29 @@ void CodeGenFunction::EmitOMPDistributeLoop(
                                     StaticInit, /*CoalescedDistSchedule=*/true);
         auto LoopExit =
             getJumpDestInCurrentScope(createBasicBlock("omp.loop.exit"));
+        // UB = min(UB, GlobalUB);
+        EmitIgnoredExpr(S.getEnsureUpperBound());
         // IV = LB
         EmitIgnoredExpr(S.getInit());
-        EmitOMPInnerLoop(S, LoopScope.requiresCleanups(),
-                         S.getDistCond() /* IV < GlobalUB */,
-                         S.getInc() /* Unused */,
-                         /*LastprivateIterInitExpr=*/nullptr,
-                         [&S, &LoopExit](CodeGenFunction &CGF) {
-                           CGF.EmitOMPLoopBody(S, LoopExit);
-                           CGF.EmitStopPoint(&S);
-                         },
-                         [&S](CodeGenFunction &CGF) {
-                           // LB = LB + Stride
-                           CGF.EmitIgnoredExpr(S.getNextLowerBound());
-                           // IV = LB;
-                           CGF.EmitIgnoredExpr(S.getInit());
-                         });
+        if (LoopScope.requiresCleanups() ||
+            !EmitOMPStencilStagedLoop(S, LoopExit))
+          EmitOMPInnerLoop(S, LoopScope.requiresCleanups(),
+                           S.getDistCond() /* IV < GlobalUB */,
+                           S.getInc() /* Unused */,
+                           /*LastprivateIterInitExpr=*/nullptr,
+                           [&S, &LoopExit](CodeGenFunction &CGF) {
+                             CGF.EmitOMPLoopBody(S, LoopExit);
+                             CGF.EmitStopPoint(&S);
+                           },
+                           [&S](CodeGenFunction &CGF) {
+                             // LB = LB + Stride
+                             CGF.EmitIgnoredExpr(S.getNextLowerBound());
+                             // UB = min(UB + Stride, GlobalUB);
+                             CGF.EmitIgnoredExpr(S.getNextUpperBound());
+                             CGF.EmitIgnoredExpr(S.getEnsureUpperBound());
+                             // IV = LB;
+                             CGF.EmitIgnoredExpr(S.getInit());
+                           });
         EmitBlock(LoopExit.getBlock());
         // Tell the runtime we are done.
         RT.emitForStaticFinish(*this, S.getLocStart(), S.getDirectiveKind(),
@@ -3991,6 +4570,69 @@ std::pair<bool, RValue> CodeGenFunction::EmitOMPAtomicSimpleUpdateExpr(
   return Res;
 }
 
+/// Emit 'x = x + expr' or 'x = x - expr' for a complex 'x' that is too wide
+/// for the native atomics of the target as two independent atomic updates of
+/// its real and imaginary parts. Each part is updated atomically, but another
+/// thread may observe the value between the two updates, so this is only done
+/// on request. Returns false if the update must be emitted as a whole.
+static bool emitOMPAtomicComplexSplitUpdate(CodeGenFunction &CGF, LValue X,
+                                            const Expr *E, RValue Update,
+                                            BinaryOperatorKind BO,
+                                            bool IsXLHSInRHSPart,
+                                            llvm::AtomicOrdering AO,
+                                            SourceLocation Loc) {
+  auto &Context = CGF.getContext();
+  if (!CGF.CGM.getCodeGenOpts().OpenMPSplitComplexAtomics ||
+      !X.isSimple() || !X.getType()->isAnyComplexType() ||
+      !(BO == BO_Add || (BO == BO_Sub && IsXLHSInRHSPart)))
+    return false;
+  QualType ElemTy = X.getType()->castAs<ComplexType>()->getElementType();
+  const TargetInfo &TI = Context.getTargetInfo();
+  if (TI.hasBuiltinAtomic(Context.getTypeSize(X.getType()),
+                          Context.toBits(X.getAlignment())) ||
+      !TI.hasBuiltinAtomic(Context.getTypeSize(ElemTy),
+                           Context.getTypeAlign(ElemTy)))
+    return false;
+
+  // 'expr' is either of the type of 'x' or a real value that only updates the
+  // real part.
+  llvm::Value *RealUpdate;
+  llvm::Value *ImagUpdate = nullptr;
+  QualType ETy = E->getType();
+  if (Update.isComplex()) {
+    if (!Context.hasSameUnqualifiedType(ETy, X.getType()))
+      return false;
+    std::tie(RealUpdate, ImagUpdate) = Update.getComplexVal();
+  } else if (Update.isScalar() && ETy->isRealType()) {
+    RealUpdate = CGF.EmitScalarConversion(Update.getScalarVal(), ETy, ElemTy,
+                                          Loc);
+  } else
+    return false;
+
+  bool IsFloat = ElemTy->isRealFloatingType();
+  bool IsVolatile = X.getType().isVolatileQualified();
+  auto &&EmitPartUpdate = [&CGF, ElemTy, BO, IsFloat, AO,
+                           IsVolatile](Address PartAddr, llvm::Value *PartUpd) {
+    auto &&Gen = [&CGF, BO, IsFloat, PartUpd](RValue XRValue) {
+      auto &Bld = CGF.Builder;
+      auto *Old = XRValue.getScalarVal();
+      if (BO == BO_Add)
+        return RValue::get(IsFloat ? Bld.CreateFAdd(Old, PartUpd)
+                                   : Bld.CreateAdd(Old, PartUpd));
+      return RValue::get(IsFloat ? Bld.CreateFSub(Old, PartUpd)
+                                 : Bld.CreateSub(Old, PartUpd));
+    };
+    CGF.EmitAtomicUpdate(CGF.MakeAddrLValue(PartAddr, ElemTy), AO, Gen,
+                         IsVolatile);
+  };
+  EmitPartUpdate(CGF.emitAddrOfRealComponent(X.getAddress(), X.getType()),
+                 RealUpdate);
+  if (ImagUpdate)
+    EmitPartUpdate(CGF.emitAddrOfImagComponent(X.getAddress(), X.getType()),
+                   ImagUpdate);
+  return true;
+}
+
 static void EmitOMPAtomicUpdateExpr(CodeGenFunction &CGF, bool IsSeqCst,
                                     const Expr *X, const Expr *E,
                                     const Expr *UE, bool IsXLHSInRHSPart,
@@ -4019,8 +4661,11 @@ static void EmitOMPAtomicUpdateExpr(CodeGenFunction &CGF, bool IsSeqCst,
         CodeGenFunction::OpaqueValueMapping MapX(CGF, XRValExpr, XRValue);
         return CGF.EmitAnyExpr(UE);
       };
-  (void)CGF.EmitOMPAtomicSimpleUpdateExpr(
-      XLValue, ExprRValue, BOUE->getOpcode(), IsXLHSInRHSPart, AO, Loc, Gen);
+  if (!emitOMPAtomicComplexSplitUpdate(CGF, XLValue, E, ExprRValue,
+                                       BOUE->getOpcode(), IsXLHSInRHSPart, AO,
+                                       Loc))
+    (void)CGF.EmitOMPAtomicSimpleUpdateExpr(
+        XLValue, ExprRValue, BOUE->getOpcode(), IsXLHSInRHSPart, AO, Loc, Gen);
   // OpenMP, 2.12.6, atomic Construct
   // Any atomic construct with a seq_cst clause forces the atomically
   // performed operation to include an implicit flush operation without a
@@ -4234,6 +4879,294 @@ void CodeGenFunction::EmitOMPAtomicDirective(const OMPAtomicDirective &S) {
   CGM.getOpenMPRuntime().emitInlinedDirective(*this, OMPD_atomic, CodeGen);
 }
 
+static void
+generateCapturedVarsAndMapArrays(CodeGenFunction &CGF,
+                                 const OMPExecutableDirective &S,
+                                 SmallVectorImpl<llvm::Value *> &CapturedVars,
+                                 OMPMapArrays &MapArrays, bool HasDepend);
+
+namespace {
+/// Outcomes of -fopenmp-split-target-devices, in the order of the remark.
+enum SplitTargetDevicesKind {
+  SplitDevicesDone,
+  SplitDevicesClause,
+  SplitDevicesLoopForm,
+  SplitDevicesCopiedBack,
+};
+} // namespace
+
+/// Return true if \a S refers to \a VD.
+static bool refersToVar(const Stmt *S, const VarDecl *VD) {
+  if (!S)
+    return false;
+  if (const auto *DRE = dyn_cast<DeclRefExpr>(S))
+    return DRE->getDecl()->getCanonicalDecl() == VD->getCanonicalDecl();
+  for (const Stmt *Child : S->children())
+    if (refersToVar(Child, VD))
+      return true;
+  return false;
+}
+
+/// Return true if \a E is a reference to \a VD.
+static bool isVarRef(const Expr *E, const VarDecl *VD) {
+  if (!E)
+    return false;
+  const auto *DRE = dyn_cast<DeclRefExpr>(E->IgnoreParenImpCasts());
+  return DRE && DRE->getDecl()->getCanonicalDecl() == VD->getCanonicalDecl();
+}
+
+/// Return the reference if \a E is a variable of integer type.
+static const DeclRefExpr *getIntegerVarRef(const Expr *E) {
+  if (!E)
+    return nullptr;
+  const auto *DRE = dyn_cast<DeclRefExpr>(E->IgnoreParenImpCasts());
+  if (!DRE || !isa<VarDecl>(DRE->getDecl()) ||
+      !DRE->getType()->isIntegerType())
+    return nullptr;
+  return DRE;
+}
+
+/// Check if the iterations of the 'target teams distribute' loop \a S can
+/// be split across devices with -fopenmp-split-target-devices. The loop has
+/// to be 'for (i = lb; i < ub; ++i)', where 'lb' and 'ub' are passed to the
+/// target region \a CS by value, so that each device can be launched with the
+/// bounds of its own slice. Every list item copied back to the host must be
+/// exactly the array section '[lb:ub - lb]': the map clauses are evaluated
+/// with the bounds of the slice, so that each device only copies back the
+/// elements of its own iterations and the slices of the devices do not
+/// overlap. Sections of any other shape, such as halos around the slice, may
+/// only be mapped 'to'. Report the outcome with a remark.
+static bool getSplitLoopBounds(CodeGenModule &CGM, const OMPLoopDirective &S,
+                               const CapturedStmt &CS,
+                               const DeclRefExpr *&LBRef,
+                               const DeclRefExpr *&UBRef) {
+  auto &&Report = [&CGM, &S](unsigned Kind) {
+    return CGM.getDiags().Report(
+               S.getLocStart(),
+               diag::remark_fe_backend_optimization_remark_analysis_target_split)
+           << Kind;
+  };
+
+  for (const auto *C : S.clauses()) {
+    OpenMPClauseKind Kind = C->getClauseKind();
+    if (Kind == OMPC_if || Kind == OMPC_device || Kind == OMPC_nowait ||
+        Kind == OMPC_depend || Kind == OMPC_reduction ||
+        Kind == OMPC_lastprivate || Kind == OMPC_ordered ||
+        (Kind == OMPC_collapse && S.getCollapsedNumber() > 1)) {
+      Report(SplitDevicesClause) << getOpenMPClauseName(Kind);
+      return false;
+    }
+  }
+
+  // Find 'for (i = lb; i < ub; ++i)'.
+  const Stmt *Body = S.getAssociatedStmt();
+  while (const auto *Captured = dyn_cast<CapturedStmt>(Body))
+    Body = Captured->getCapturedStmt();
+  const auto *For = dyn_cast<ForStmt>(Body);
+  const VarDecl *IV = nullptr;
+  LBRef = nullptr;
+  UBRef = nullptr;
+  if (For) {
+    if (const auto *DS = dyn_cast_or_null<DeclStmt>(For->getInit())) {
+      if (DS->isSingleDecl()) {
+        IV = dyn_cast<VarDecl>(DS->getSingleDecl());
+        LBRef = IV ? getIntegerVarRef(IV->getInit()) : nullptr;
+      }
+    } else if (const auto *BO =
+                   dyn_cast_or_null<BinaryOperator>(For->getInit())) {
+      const DeclRefExpr *Ref = getIntegerVarRef(BO->getLHS());
+      if (BO->getOpcode() == BO_Assign && Ref) {
+        IV = cast<VarDecl>(Ref->getDecl());
+        LBRef = getIntegerVarRef(BO->getRHS());
+      }
+    }
+    const auto *Cond = dyn_cast_or_null<BinaryOperator>(For->getCond());
+    if (Cond && Cond->getOpcode() == BO_LT && IV &&
+        refersToVar(getIntegerVarRef(Cond->getLHS()), IV))
+      UBRef = getIntegerVarRef(Cond->getRHS());
+    const auto *Inc = dyn_cast_or_null<UnaryOperator>(For->getInc());
+    if (!IV || !Inc || !Inc->isIncrementOp() ||
+        !refersToVar(getIntegerVarRef(Inc->getSubExpr()), IV))
+      UBRef = nullptr;
+  }
+  auto &&IsPassedByValue = [&CS, IV](const DeclRefExpr *Ref) {
+    if (!Ref || Ref->getDecl()->getCanonicalDecl() == IV->getCanonicalDecl())
+      return false;
+    for (const auto &Cap : CS.captures())
+      if (Cap.capturesVariableByCopy() &&
+          Cap.getCapturedVar()->getCanonicalDecl() ==
+              Ref->getDecl()->getCanonicalDecl())
+        return true;
+    return false;
+  };
+  if (!IsPassedByValue(LBRef) || !IsPassedByValue(UBRef) ||
+      LBRef->getDecl()->getCanonicalDecl() ==
+          UBRef->getDecl()->getCanonicalDecl()) {
+    Report(SplitDevicesLoopForm);
+    return false;
+  }
+  const auto *LBVar = cast<VarDecl>(LBRef->getDecl());
+  const auto *UBVar = cast<VarDecl>(UBRef->getDecl());
+
+  llvm::SmallPtrSet<const Decl *, 8> MappedDecls;
+  for (const auto *C : S.getClausesOfKind<OMPMapClause>()) {
+    bool CopiedBack = C->getMapType() == OMPC_MAP_from ||
+                      C->getMapType() == OMPC_MAP_tofrom ||
+                      C->getMapType() == OMPC_MAP_unknown;
+    for (auto L : C->component_lists()) {
+      if (!L.first)
+        continue;
+      MappedDecls.insert(L.first->getCanonicalDecl());
+      if (!CopiedBack)
+        continue;
+      // Only accept 'x[lb:ub - lb]'.
+      const auto *OASE = dyn_cast<OMPArraySectionExpr>(
+          L.second.front().getAssociatedExpression());
+      const Expr *Length = OASE ? OASE->getLength() : nullptr;
+      const auto *Sub =
+          Length ? dyn_cast<BinaryOperator>(Length->IgnoreParenImpCasts())
+                 : nullptr;
+      if (!OASE || OASE->getColonLoc().isInvalid() ||
+          isa<OMPArraySectionExpr>(OASE->getBase()->IgnoreParenImpCasts()) ||
+          !isVarRef(OASE->getLowerBound(), LBVar) || !Sub ||
+          Sub->getOpcode() != BO_Sub || !isVarRef(Sub->getLHS(), UBVar) ||
+          !isVarRef(Sub->getRHS(), LBVar)) {
+        Report(SplitDevicesCopiedBack) << L.first;
+        return false;
+      }
+    }
+  }
+  // Variables captured by reference without a map clause are mapped tofrom.
+  for (const auto &Cap : CS.captures()) {
+    if (Cap.capturesThis()) {
+      Report(SplitDevicesCopiedBack) << "'this'";
+      return false;
+    }
+    if (Cap.capturesVariable() &&
+        !MappedDecls.count(Cap.getCapturedVar()->getCanonicalDecl())) {
+      Report(SplitDevicesCopiedBack) << Cap.getCapturedVar();
+      return false;
+    }
+  }
+
+  Report(SplitDevicesDone);
+  return true;
+}
+
+/// Launch the target region \a S on every available device, each from its own
+/// target task, and wait for all of them. Each device runs a slice of the
+/// iterations of the loop: the variables \a LBRef and \a UBRef that bound
+/// the loop are replaced with the bounds of the slice while the captured
+/// variables and the map arrays of the launch are emitted. With less than two
+/// devices, the region is launched as usual with \a CapturedVars and \a
+/// MapArrays.
+static void emitTargetCallsAcrossDevices(
+    CodeGenFunction &CGF, const OMPLoopDirective &S, llvm::Function *Fn,
+    llvm::Constant *FnID, const DeclRefExpr *LBRef, const DeclRefExpr *UBRef,
+    ArrayRef<llvm::Value *> CapturedVars, OMPMapArrays &MapArrays,
+    const llvm::function_ref<llvm::Value *(
+        CodeGenFunction &CGF, const OMPLoopDirective &D)> &SizeEmitter) {
+  CodeGenModule &CGM = CGF.CGM;
+  CGOpenMPRuntime &RT = CGM.getOpenMPRuntime();
+  ASTContext &Ctx = CGF.getContext();
+  SourceLocation Loc = S.getLocStart();
+  CGBuilderTy &Builder = CGF.Builder;
+
+  // int omp_get_num_devices(void);
+  llvm::Value *NumDevices = CGF.EmitRuntimeCall(CGM.CreateRuntimeFunction(
+      llvm::FunctionType::get(CGF.Int32Ty, /*isVarArg=*/false),
+      "omp_get_num_devices"));
+  llvm::BasicBlock *SplitBB = CGF.createBasicBlock("omp_split.then");
+  llvm::BasicBlock *SingleBB = CGF.createBasicBlock("omp_split.else");
+  llvm::BasicBlock *ContBB = CGF.createBasicBlock("omp_split.end");
+  Builder.CreateCondBr(Builder.CreateICmpSGT(NumDevices, Builder.getInt32(1)),
+                       SplitBB, SingleBB);
+
+  CGF.EmitBlock(SingleBB);
+  RT.emitTargetNumIterationsCall(CGF, S, /*Device=*/nullptr, SizeEmitter);
+  RT.emitTargetCall(CGF, S, Fn, FnID, /*IfCond=*/nullptr, /*Device=*/nullptr,
+                    CapturedVars, MapArrays);
+  CGF.EmitBranch(ContBB);
+
+  // Device D runs the iterations [LB + N * D / NumDevices,
+  // LB + N * (D + 1) / NumDevices), where N is the number of iterations.
+  CGF.EmitBlock(SplitBB);
+  QualType LBTy = LBRef->getType();
+  QualType UBTy = UBRef->getType();
+  llvm::Value *LB = CGF.EmitScalarConversion(CGF.EmitScalarExpr(LBRef), LBTy,
+                                             Ctx.LongLongTy, Loc);
+  llvm::Value *UB = CGF.EmitScalarConversion(CGF.EmitScalarExpr(UBRef), UBTy,
+                                             Ctx.LongLongTy, Loc);
+  llvm::Value *Diff = Builder.CreateNSWSub(UB, LB);
+  llvm::Value *NumIterations =
+      Builder.CreateSelect(Builder.CreateICmpSGT(Diff, Builder.getInt64(0)),
+                           Diff, Builder.getInt64(0));
+  llvm::Value *NumDevices64 = Builder.CreateSExt(NumDevices, CGF.Int64Ty);
+  auto &&SliceBound = [&Builder, LB, NumIterations,
+                       NumDevices64](llvm::Value *Device) {
+    return Builder.CreateNSWAdd(
+        LB, Builder.CreateSDiv(Builder.CreateNSWMul(NumIterations, Device),
+                               NumDevices64));
+  };
+
+  Address DeviceAddr = CGF.CreateMemTemp(Ctx.LongLongTy, "omp_split.device");
+  Address LBAddr = CGF.CreateMemTemp(LBTy, "omp_split.lb");
+  Address UBAddr = CGF.CreateMemTemp(UBTy, "omp_split.ub");
+  Builder.CreateStore(Builder.getInt64(0), DeviceAddr);
+  llvm::BasicBlock *CondBB = CGF.createBasicBlock("omp_split.cond");
+  llvm::BasicBlock *BodyBB = CGF.createBasicBlock("omp_split.body");
+  llvm::BasicBlock *EndBB = CGF.createBasicBlock("omp_split.wait");
+  CGF.EmitBlock(CondBB);
+  llvm::Value *Device = Builder.CreateLoad(DeviceAddr);
+  Builder.CreateCondBr(Builder.CreateICmpSLT(Device, NumDevices64), BodyBB,
+                       EndBB);
+
+  CGF.EmitBlock(BodyBB);
+  llvm::Value *NextDevice = Builder.CreateNSWAdd(Device, Builder.getInt64(1));
+  CGF.EmitStoreOfScalar(CGF.EmitScalarConversion(SliceBound(Device),
+                                                 Ctx.LongLongTy, LBTy, Loc),
+                        CGF.MakeAddrLValue(LBAddr, LBTy));
+  CGF.EmitStoreOfScalar(CGF.EmitScalarConversion(SliceBound(NextDevice),
+                                                 Ctx.LongLongTy, UBTy, Loc),
+                        CGF.MakeAddrLValue(UBAddr, UBTy));
+  {
+    CodeGenFunction::OMPPrivateScope BoundsScope(CGF);
+    BoundsScope.addPrivate(cast<VarDecl>(LBRef->getDecl()),
+                           [LBAddr]() { return LBAddr; });
+    BoundsScope.addPrivate(cast<VarDecl>(UBRef->getDecl()),
+                           [UBAddr]() { return UBAddr; });
+    (void)BoundsScope.Privatize();
+    SmallVector<llvm::Value *, 16> SliceCapturedVars;
+    OMPMapArrays SliceMapArrays;
+    RT.emitInlinedDirective(
+        CGF, OMPD_target,
+        [&S, &SliceCapturedVars, &SliceMapArrays](CodeGenFunction &CGF,
+                                                  PrePostActionTy &) {
+          generateCapturedVarsAndMapArrays(CGF, S, SliceCapturedVars,
+                                           SliceMapArrays,
+                                           /*HasDepend=*/false);
+        });
+    // The trip count only depends on 'lb' and 'ub', which are passed by
+    // value.
+    llvm::Value *NumIterations = nullptr;
+    RT.emitInlinedDirective(
+        CGF, OMPD_for,
+        [&S, &SizeEmitter, &NumIterations](CodeGenFunction &CGF,
+                                           PrePostActionTy &) {
+          NumIterations = SizeEmitter(CGF, S);
+        },
+        /*HasCancel=*/false);
+    RT.emitTargetTaskCall(CGF, S, Fn, FnID, Device, NumIterations,
+                          SliceMapArrays);
+  }
+  Builder.CreateStore(NextDevice, DeviceAddr);
+  CGF.EmitBranch(CondBB);
+
+  CGF.EmitBlock(EndBB);
+  RT.emitTaskwaitCall(CGF, Loc);
+  CGF.EmitBlock(ContBB);
+}
+
 static void emitCommonOMPTargetDirective(CodeGenFunction &CGF,
                                          const OMPExecutableDirective &S,
                                          OpenMPDirectiveKind InnermostKind,
@@ -4317,6 +5250,21 @@ static void emitCommonOMPTargetDirective(CodeGenFunction &CGF,
                                               /*IsSigned=*/false);
     return NumIterations;
   };
+
+  // With -fopenmp-split-target-devices, the iterations of a 'target teams
+  // distribute' loop run on all the available devices.
+  const DeclRefExpr *LBRef = nullptr;
+  const DeclRefExpr *UBRef = nullptr;
+  if (FnID && CGM.getCodeGenOpts().OpenMPSplitTargetDevices &&
+      isOpenMPTeamsDirective(S.getDirectiveKind()) &&
+      isOpenMPDistributeDirective(S.getDirectiveKind()) &&
+      getSplitLoopBounds(CGM, cast<OMPLoopDirective>(S), CS, LBRef, UBRef)) {
+    emitTargetCallsAcrossDevices(CGF, cast<OMPLoopDirective>(S), Fn, FnID,
+                                 LBRef, UBRef, CapturedVars, MapArrays,
+                                 SizeEmitter);
+    return;
+  }
+
   CGM.getOpenMPRuntime().emitTargetNumIterationsCall(CGF, S, Device,
                                                      SizeEmitter);
   CGM.getOpenMPRuntime().emitTargetCall(CGF, S, Fn, FnID, IfCond, Device,
@@ -5087,6 +6035,254 @@ void CodeGenFunction::EmitOMPTargetDataDirective(
                                              Info);
 }
 
+namespace {
+/// Checks the host code of the statements whose target regions would have
+/// their maps hoisted into a target data region around them. The host code
+/// must not access memory other than through the variables it names, nor
+/// leave or enter the statements other than by falling through. It records
+/// the target regions and the variables that the host code refers to,
+/// writes and declares.
+class TargetDataHoistingChecker
+    : public ConstStmtVisitor<TargetDataHoistingChecker> {
+  unsigned SwitchDepth = 0;
+
+  void markWritten(const Expr *E) {
+    if (const auto *DRE = dyn_cast<DeclRefExpr>(E->IgnoreParenImpCasts()))
+      if (const auto *VD = dyn_cast<VarDecl>(DRE->getDecl()))
+        Written.insert(VD->getCanonicalDecl());
+  }
+
+public:
+  bool Unsafe = false;
+  SmallVector<const OMPExecutableDirective *, 4> Targets;
+  llvm::SmallPtrSet<const VarDecl *, 16> Referenced;
+  llvm::SmallPtrSet<const VarDecl *, 16> Written;
+  llvm::SmallPtrSet<const VarDecl *, 16> Declared;
+
+  void VisitStmt(const Stmt *S) {
+    for (const Stmt *Child : S->children())
+      if (Child && !Unsafe)
+        Visit(Child);
+  }
+  void VisitOMPExecutableDirective(const OMPExecutableDirective *D) {
+    if (!isOpenMPTargetExecutionDirective(D->getDirectiveKind())) {
+      Unsafe = true;
+      return;
+    }
+    Targets.push_back(D);
+    // The region runs on the device and its maps are checked separately, but
+    // the other clauses are evaluated on the host.
+    for (const OMPClause *C : D->clauses()) {
+      if (isa<OMPMapClause>(C))
+        continue;
+      for (const Stmt *Child : const_cast<OMPClause *>(C)->children())
+        if (Child && !Unsafe)
+          Visit(Child);
+    }
+  }
+  void VisitDeclRefExpr(const DeclRefExpr *E) {
+    if (const auto *VD = dyn_cast<VarDecl>(E->getDecl())) {
+      // A reference may alias a mapped variable.
+      if (VD->getType()->isReferenceType())
+        Unsafe = true;
+      Referenced.insert(VD->getCanonicalDecl());
+    }
+  }
+  void VisitDeclStmt(const DeclStmt *S) {
+    for (const Decl *D : S->decls())
+      if (const auto *VD = dyn_cast<VarDecl>(D))
+        Declared.insert(VD->getCanonicalDecl());
+    VisitStmt(S);
+  }
+  void VisitBinaryOperator(const BinaryOperator *E) {
+    if (E->isAssignmentOp())
+      markWritten(E->getLHS());
+    VisitStmt(E);
+  }
+  void VisitUnaryOperator(const UnaryOperator *E) {
+    if (E->getOpcode() == UO_Deref || E->getOpcode() == UO_AddrOf) {
+      Unsafe = true;
+      return;
+    }
+    if (E->isIncrementDecrementOp())
+      markWritten(E->getSubExpr());
+    VisitStmt(E);
+  }
+  void VisitSwitchStmt(const SwitchStmt *S) {
+    ++SwitchDepth;
+    VisitStmt(S);
+    --SwitchDepth;
+  }
+  void VisitSwitchCase(const SwitchCase *S) {
+    // A case of an enclosing switch jumps into the statements.
+    if (!SwitchDepth)
+      Unsafe = true;
+    else
+      VisitStmt(S);
+  }
+  // Memory accessed through pointers, calls and jumps.
+  void VisitArraySubscriptExpr(const ArraySubscriptExpr *) { Unsafe = true; }
+  void VisitMemberExpr(const MemberExpr *) { Unsafe = true; }
+  void VisitCXXThisExpr(const CXXThisExpr *) { Unsafe = true; }
+  void VisitCallExpr(const CallExpr *) { Unsafe = true; }
+  void VisitCXXConstructExpr(const CXXConstructExpr *) { Unsafe = true; }
+  void VisitCXXNewExpr(const CXXNewExpr *) { Unsafe = true; }
+  void VisitCXXDeleteExpr(const CXXDeleteExpr *) { Unsafe = true; }
+  void VisitCXXThrowExpr(const CXXThrowExpr *) { Unsafe = true; }
+  void VisitLambdaExpr(const LambdaExpr *) { Unsafe = true; }
+  void VisitBlockExpr(const BlockExpr *) { Unsafe = true; }
+  void VisitAsmStmt(const AsmStmt *) { Unsafe = true; }
+  void VisitCXXTryStmt(const CXXTryStmt *) { Unsafe = true; }
+  void VisitReturnStmt(const ReturnStmt *) { Unsafe = true; }
+  void VisitGotoStmt(const GotoStmt *) { Unsafe = true; }
+  void VisitIndirectGotoStmt(const IndirectGotoStmt *) { Unsafe = true; }
+  void VisitLabelStmt(const LabelStmt *) { Unsafe = true; }
+};
+
+/// A map of a variable by a target region whose maps may be hoisted.
+struct HoistedMapUse {
+  const OMPExecutableDirective *D;
+  const OMPMapClause *C;
+  OMPClauseMappableExprCommon::MappableExprComponentListRef Components;
+  const Expr *getMapExpr() const {
+    return Components.front().getAssociatedExpression();
+  }
+};
+} // namespace
+
+unsigned CodeGenFunction::EmitOMPHoistedTargetData(ArrayRef<Stmt *> Stmts) {
+  const LangOptions &LangOpts = CGM.getLangOpts();
+  if (LangOpts.OpenMPIsDevice || LangOpts.OMPTargetTriples.empty() ||
+      InOMPHoistedTargetData || CapturedStmtInfo || Stmts.empty())
+    return 0;
+
+  // Hoist the maps out of a loop, or out of a run of target regions.
+  const Stmt *First = Stmts.front();
+  bool IsLoop = isa<ForStmt>(First) || isa<WhileStmt>(First) ||
+                isa<DoStmt>(First);
+  unsigned NumStmts = 1;
+  if (!IsLoop) {
+    NumStmts = 0;
+    while (NumStmts < Stmts.size()) {
+      const auto *D = dyn_cast<OMPExecutableDirective>(Stmts[NumStmts]);
+      if (!D || !isOpenMPTargetExecutionDirective(D->getDirectiveKind()))
+        break;
+      ++NumStmts;
+    }
+    if (NumStmts < 2)
+      return 0;
+  }
+  ArrayRef<Stmt *> Region = Stmts.slice(0, NumStmts);
+
+  TargetDataHoistingChecker Checker;
+  for (const Stmt *S : Region)
+    Checker.Visit(S);
+  if (Checker.Unsafe || Checker.Targets.empty())
+    return 0;
+
+  // Target regions that may run on the host, or asynchronously, see the host
+  // copies of the variables.
+  for (const auto *D : Checker.Targets)
+    for (const auto *C : D->clauses())
+      if (isa<OMPIfClause>(C) || isa<OMPDeviceClause>(C) ||
+          isa<OMPNowaitClause>(C) || isa<OMPDependClause>(C))
+        return 0;
+
+  llvm::MapVector<const VarDecl *, SmallVector<HoistedMapUse, 4>> Uses;
+  for (const auto *D : Checker.Targets)
+    for (const auto *C : D->getClausesOfKind<OMPMapClause>())
+      for (const auto &L : C->component_lists())
+        if (const auto *VD = dyn_cast_or_null<VarDecl>(L.first))
+          Uses[VD->getCanonicalDecl()].push_back({D, C, L.second});
+
+  auto &&IsHoistable = [&](const VarDecl *VD,
+                           ArrayRef<HoistedMapUse> VDUses) {
+    // The host code must not see the host copy of the variable, which is only
+    // updated at the end of the hoisted region.
+    if (!VD->hasLocalStorage() || VD->getType()->isReferenceType() ||
+        Checker.Referenced.count(VD) || Checker.Declared.count(VD))
+      return false;
+    // Every target region that uses the variable maps it once, so that the
+    // hoisted map covers them all.
+    for (const auto *D : Checker.Targets) {
+      unsigned NumMaps = llvm::count_if(
+          VDUses, [D](const HoistedMapUse &U) { return U.D == D; });
+      if (NumMaps > 1 ||
+          (NumMaps == 0 &&
+           cast<CapturedStmt>(D->getAssociatedStmt())->capturesVariable(VD)))
+        return false;
+    }
+    // Without copying the variable back, the writes of a target region would
+    // be discarded at its end, but carried to the next region once hoisted.
+    llvm::FoldingSetNodeID FirstID;
+    VDUses.front().getMapExpr()->Profile(FirstID, getContext(),
+                                         /*Canonical=*/true);
+    for (const auto &U : VDUses) {
+      if ((U.C->getMapType() != OMPC_MAP_tofrom &&
+           U.C->getMapType() != OMPC_MAP_from) ||
+          U.C->getMapTypeModifier() == OMPC_MAP_always)
+        return false;
+      llvm::FoldingSetNodeID ID;
+      U.getMapExpr()->Profile(ID, getContext(), /*Canonical=*/true);
+      if (ID != FirstID)
+        return false;
+    }
+    // The bounds of the mapped section are evaluated before the statements,
+    // so they must keep their values in them.
+    TargetDataHoistingChecker BoundsChecker;
+    BoundsChecker.Visit(VDUses.front().getMapExpr());
+    if (BoundsChecker.Unsafe)
+      return false;
+    for (const VarDecl *Bound : BoundsChecker.Referenced)
+      if (Bound != VD &&
+          (Checker.Written.count(Bound) || Checker.Declared.count(Bound) ||
+           Uses.count(Bound)))
+        return false;
+    // Only a loop repeats the map of a single target region.
+    return IsLoop || VDUses.size() > 1;
+  };
+
+  SmallVector<Expr *, 4> Vars;
+  SmallVector<ValueDecl *, 4> Decls;
+  SmallVector<OMPClauseMappableExprCommon::MappableExprComponentListRef, 4>
+      Lists;
+  for (const auto &U : Uses) {
+    if (!IsHoistable(U.first, U.second))
+      continue;
+    const HoistedMapUse &FirstUse = U.second.front();
+    Vars.push_back(const_cast<Expr *>(FirstUse.getMapExpr()));
+    Decls.push_back(const_cast<VarDecl *>(U.first));
+    Lists.push_back(FirstUse.Components);
+    CGM.getDiags().Report(
+        FirstUse.getMapExpr()->getExprLoc(),
+        diag::remark_fe_backend_optimization_remark_analysis_target_data_hoisted)
+        << U.first << !IsLoop << NumStmts;
+  }
+  if (Vars.empty())
+    return 0;
+
+  // Map the variables 'tofrom' even if the target regions only copy them
+  // back, since the statements may not run any target region at all.
+  ASTContext &Ctx = getContext();
+  SourceLocation Loc = First->getLocStart();
+  OMPClause *Map = OMPMapClause::Create(
+      Ctx, Loc, Loc, Loc, Vars, Decls, Lists, OMPC_MAP_unknown,
+      OMPC_MAP_tofrom, /*TypeIsImplicit=*/true, Loc);
+  auto *Data = OMPTargetDataDirective::Create(
+      Ctx, Loc, Region.back()->getLocEnd(), Map, Stmts.front());
+
+  auto &&CodeGen = [Region](CodeGenFunction &CGF, PrePostActionTy &) {
+    llvm::SaveAndRestore<bool> SavedHoisted(CGF.InOMPHoistedTargetData, true);
+    for (const Stmt *S : Region)
+      CGF.EmitStmt(S);
+  };
+  CGOpenMPRuntime::TargetDataInfo Info(/*RequiresDevicePointerInfo=*/false);
+  CGM.getOpenMPRuntime().emitTargetDataCalls(
+      *this, *Data, /*IfCond=*/nullptr, /*Device=*/nullptr,
+      RegionCodeGenTy(CodeGen), Info);
+  return NumStmts;
+}
+
 void CodeGenFunction::EmitOMPTargetEnterDataDirective(
     const OMPTargetEnterDataDirective &S) {
   // If we don't have target devices, don't bother emitting the data mapping
@@ -5136,6 +6332,103 @@ static void mapParam(CodeGenFunction &CGF, const DeclRefExpr *Helper,
       VDecl, [&CGF, PVD]() -> Address { return CGF.GetAddrOfLocalVar(PVD); });
 }
 
+/// Return true if \a VD may be written, or may have its address escape, in
+/// \a S. Only loads of the variable, of its elements and of its fields are
+/// known to be safe.
+static bool mayModifyVar(const Stmt *S, const VarDecl *VD) {
+  if (!S)
+    return false;
+
+  if (const auto *ICE = dyn_cast<ImplicitCastExpr>(S)) {
+    if (ICE->getCastKind() == CK_LValueToRValue) {
+      const Expr *E = ICE->getSubExpr()->IgnoreParens();
+      while (true) {
+        if (const auto *ASE = dyn_cast<ArraySubscriptExpr>(E)) {
+          if (mayModifyVar(ASE->getIdx(), VD))
+            return true;
+          const auto *Base =
+              dyn_cast<ImplicitCastExpr>(ASE->getBase()->IgnoreParens());
+          if (!Base || Base->getCastKind() != CK_ArrayToPointerDecay)
+            break;
+          E = Base->getSubExpr()->IgnoreParens();
+        } else if (const auto *ME = dyn_cast<MemberExpr>(E)) {
+          if (ME->isArrow())
+            break;
+          E = ME->getBase()->IgnoreParens();
+        } else
+          break;
+      }
+      if (isa<DeclRefExpr>(E))
+        return false;
+    }
+  }
+
+  if (const auto *DRE = dyn_cast<DeclRefExpr>(S))
+    return DRE->getDecl()->getCanonicalDecl() == VD->getCanonicalDecl();
+
+  // The clauses of nested directives may refer to the variable as well.
+  if (const auto *Dir = dyn_cast<OMPExecutableDirective>(S))
+    for (const OMPClause *C : Dir->clauses())
+      for (const Stmt *Child : const_cast<OMPClause *>(C)->children())
+        if (mayModifyVar(Child, VD))
+          return true;
+
+  // The capture initializers of a nested region refer to the captured
+  // variables by reference; only look at the captured body.
+  if (const auto *CS = dyn_cast<CapturedStmt>(S))
+    return mayModifyVar(CS->getCapturedStmt(), VD);
+
+  for (const Stmt *Child : S->children())
+    if (mayModifyVar(Child, VD))
+      return true;
+  return false;
+}
+
+/// The tasks generated by a taskloop without 'nogroup' complete before the
+/// encountering task leaves the taskloop, so a firstprivate aggregate that the
+/// loop only reads can be copied once, at the encountering point, for all of
+/// them. Point the shareds of taskloop \a S at such copies and record the
+/// variables in \a Data, so that the runtime duplicates a reference instead of
+/// the whole copy for every generated task.
+static void emitSharedFirstprivates(CodeGenFunction &CGF,
+                                    const OMPLoopDirective &S,
+                                    const CapturedStmt &CS,
+                                    Address CapturedStruct, QualType SharedsTy,
+                                    OMPTaskDataTy &Data) {
+  auto &C = CGF.getContext();
+  llvm::SmallPtrSet<const VarDecl *, 4> Lastprivates;
+  for (const auto *Clause : S.getClausesOfKind<OMPLastprivateClause>())
+    for (const auto *Ref : Clause->varlists())
+      Lastprivates.insert(
+          cast<VarDecl>(cast<DeclRefExpr>(Ref)->getDecl())->getCanonicalDecl());
+  CodeGenFunction::CGCapturedStmtInfo CapturesInfo(CS);
+  LValue SharedsBase = CGF.MakeAddrLValue(CapturedStruct, SharedsTy);
+  for (const auto *Clause : S.getClausesOfKind<OMPFirstprivateClause>()) {
+    for (const auto *Ref : Clause->varlists()) {
+      const auto *OrigVD = cast<VarDecl>(cast<DeclRefExpr>(Ref)->getDecl());
+      QualType Type = OrigVD->getType();
+      const FieldDecl *FD = CapturesInfo.lookup(OrigVD);
+      if (!FD || Type->isReferenceType() || Type->isVariablyModifiedType() ||
+          !CodeGenFunction::hasAggregateEvaluationKind(Type) ||
+          !Type.isTriviallyCopyableType(C) ||
+          C.getTypeSizeInChars(Type) <= CGF.getPointerSize() ||
+          Lastprivates.count(OrigVD->getCanonicalDecl()) ||
+          Data.SharedFirstprivates.count(OrigVD->getCanonicalDecl()) ||
+          mayModifyVar(CS.getCapturedStmt(), OrigVD))
+        continue;
+      Address Copy =
+          CGF.CreateMemTemp(Type, OrigVD->getName() + ".firstpriv.shared");
+      Address FieldAddr = CGF.Builder.CreateElementBitCast(
+          CGF.EmitLValueForFieldInitialization(SharedsBase, FD).getAddress(),
+          Copy.getType());
+      Address Orig(CGF.Builder.CreateLoad(FieldAddr), C.getDeclAlign(OrigVD));
+      CGF.EmitAggregateCopy(Copy, Orig, Type);
+      CGF.Builder.CreateStore(Copy.getPointer(), FieldAddr);
+      Data.SharedFirstprivates.insert(OrigVD->getCanonicalDecl());
+    }
+  }
+}
+
 void CodeGenFunction::EmitOMPTaskLoopBasedDirective(const OMPLoopDirective &S) {
   assert(isOpenMPTaskLoopDirective(S.getDirectiveKind()));
   // Emit outlined function for task construct.
@@ -5166,6 +6459,8 @@ void CodeGenFunction::EmitOMPTaskLoopBasedDirective(const OMPLoopDirective &S) {
     Data.Schedule.setInt(/*IntVal=*/true);
     Data.Schedule.setPointer(EmitScalarExpr(Clause->getNumTasks()));
   }
+  if (CGM.getCodeGenOpts().OpenMPTaskloopSharedFirstprivates && !Data.Nogroup)
+    emitSharedFirstprivates(*this, S, *CS, CapturedStruct, SharedsTy, Data);
 
   auto &&BodyGen = [CS, &S](CodeGenFunction &CGF, PrePostActionTy &) {
     // if (PreCond) {
@@ -22,6 +22,7 @@
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Lex/Preprocessor.h"
 #include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/DebugInfo.h"
 #include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/DiagnosticPrinter.h"
@@ -30,15 +31,105 @@
 #include "llvm/IRReader/IRReader.h"
 #include "llvm/Linker/Linker.h"
 #include "llvm/Pass.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/YAMLTraits.h"
 #include <memory>
+#include <mutex>
 using namespace clang;
 using namespace llvm;
 
+namespace {
+/// The bitcode files linked into the modules with -mlink-bitcode-file and
+/// -mlink-cuda-bitcode. Every device compilation links the same libraries,
+/// such as libdevice and the OpenMP device runtime, so they are read once for
+/// all the compilations a process runs, as with -fintegrated-cc1. Only the
+/// bitcode is kept: a module belongs to the LLVMContext of a compilation and
+/// the linker consumes it, and the module is lazily loaded anyway, so only the
+/// functions that are linked in are parsed.
+class LinkBitcodeCache {
+  struct Entry {
+    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+    off_t Size = 0;
+    time_t ModTime = 0;
+  };
+
+  llvm::StringMap<Entry> Entries;
+  std::mutex Lock;
+
+public:
+  /// Returns the contents of \p File, reading it again if it changed since
+  /// it was cached.
+  llvm::ErrorOr<llvm::MemoryBufferRef> get(FileManager &FileMgr,
+                                           StringRef File);
+};
+} // end anonymous namespace
+
+llvm::ErrorOr<llvm::MemoryBufferRef>
+LinkBitcodeCache::get(FileManager &FileMgr, StringRef File) {
+  std::lock_guard<std::mutex> Guard(Lock);
+  const FileEntry *FE = FileMgr.getFile(File);
+  auto I = Entries.find(File);
+  if (I != Entries.end() && FE && FE->getSize() == I->second.Size &&
+      FE->getModificationTime() == I->second.ModTime)
+    return I->second.Buffer->getMemBufferRef();
+
+  auto BufferOrErr = FileMgr.getBufferForFile(File);
+  if (!BufferOrErr) {
+    if (I != Entries.end())
+      Entries.erase(I);
+    return BufferOrErr.getError();
+  }
+
+  // A module loaded from an older version of the file was consumed by the
+  // compilation that loaded it, so the old buffer can go.
+  Entry &E = Entries[File];
+  E.Buffer = std::move(*BufferOrErr);
+  E.Size = FE ? FE->getSize() : -1;
+  E.ModTime = FE ? FE->getModificationTime() : 0;
+  return E.Buffer->getMemBufferRef();
+}
+
+static llvm::ManagedStatic<LinkBitcodeCache> LinkBitcode;
+
+/// Write \p M to the file named by -fopenmp-device-bitcode-output, if any.
+/// The bitcode follows a wrapper header with its size, so that the modules of
+/// several translation units can be embedded one after another.
+static void WriteOpenMPDeviceBitcode(DiagnosticsEngine &Diags,
+                                     const CodeGenOptions &CodeGenOpts,
+                                     llvm::Module *M) {
+  const std::string &FileName = CodeGenOpts.OpenMPDeviceBitcodeOutputFile;
+  if (FileName.empty())
+    return;
+
+  SmallVector<char, 0> Bitcode;
+  {
+    raw_svector_ostream BitcodeOS(Bitcode);
+    WriteBitcodeToFile(M, BitcodeOS);
+  }
+
+  std::error_code EC;
+  raw_fd_ostream OS(FileName, EC, sys::fs::F_None);
+  if (EC) {
+    Diags.Report(diag::err_cannot_open_file) << FileName << EC.message();
+    return;
+  }
+
+  // The magic, version, offset and size of the bitcode, and CPU type.
+  support::endian::Writer<support::little> W(OS);
+  W.write<uint32_t>(0x0B17C0DE);
+  W.write<uint32_t>(0);
+  W.write<uint32_t>(5 * sizeof(uint32_t));
+  W.write<uint32_t>(Bitcode.size());
+  W.write<uint32_t>(0);
+  OS.write(Bitcode.data(), Bitcode.size());
+}
+
 namespace clang {
   class BackendConsumer : public ASTConsumer {
     virtual void anchor();
@@ -60,6 +151,13 @@ namespace clang {
 
     std::unique_ptr<CodeGenerator> Gen;
 
+    /// The per-function passes run over the functions of each top-level
+    /// declaration once it is generated, with -fearly-function-passes.
+    std::unique_ptr<EarlyFunctionPasses> EarlyPasses;
+
+    /// The depth of the HandleTopLevelDecl calls in progress.
+    unsigned TopLevelDeclDepth = 0;
+
     SmallVector<std::pair<unsigned, std::unique_ptr<llvm::Module>>, 4>
         LinkModules;
 
@@ -114,6 +212,18 @@ namespace clang {
 
       if (llvm::TimePassesIsEnabled)
         LLVMIRGeneration.stopTimer();
+
+      // The passes must not run before the IR they see is final: debug info
+      // is only finalized at the end of the module, bitcode embedding wants
+      // the unoptimized module, and the OpenMP device runtime rewrites
+      // target regions once they are all known.
+      if (CodeGenOpts.EarlyFunctionPasses &&
+          !CodeGenOpts.ExperimentalNewPassManager &&
+          CodeGenOpts.getDebugInfo() == codegenoptions::NoDebugInfo &&
+          CodeGenOpts.getEmbedBitcode() == CodeGenOptions::Embed_Off &&
+          !LangOpts.OpenMPIsDevice)
+        EarlyPasses = llvm::make_unique<EarlyFunctionPasses>(
+            Diags, CodeGenOpts, TargetOpts, LangOpts, getModule());
     }
 
     bool HandleTopLevelDecl(DeclGroupRef D) override {
@@ -128,7 +238,9 @@ namespace clang {
           LLVMIRGeneration.startTimer();
       }
 
+      ++TopLevelDeclDepth;
       Gen->HandleTopLevelDecl(D);
+      --TopLevelDeclDepth;
 
       if (llvm::TimePassesIsEnabled) {
         LLVMIRGenerationRefCount -= 1;
@@ -136,9 +248,26 @@ namespace clang {
           LLVMIRGeneration.stopTimer();
       }
 
+      if (EarlyPasses && !TopLevelDeclDepth && !Diags.hasErrorOccurred())
+        runEarlyFunctionPasses();
+
       return true;
     }
 
+    void runEarlyFunctionPasses() {
+      // Report the diagnostics of the passes through our hooks, as
+      // HandleTranslationUnit does.
+      LLVMContext &Ctx = getModule()->getContext();
+      LLVMContext::DiagnosticHandlerTy OldDiagnosticHandler =
+          Ctx.getDiagnosticHandler();
+      void *OldDiagnosticContext = Ctx.getDiagnosticContext();
+      Ctx.setDiagnosticHandler(DiagnosticHandler, this);
+
+      EarlyPasses->run();
+
+      Ctx.setDiagnosticHandler(OldDiagnosticHandler, OldDiagnosticContext);
+    }
+
     void HandleInlineFunctionDefinition(FunctionDecl *D) override {
       PrettyStackTraceDecl CrashInfo(D, SourceLocation(),
                                      Context->getSourceManager(),
@@ -158,6 +287,10 @@ namespace clang {
         HandleTopLevelDecl(D);
     }
 
+    void PrintStats() override {
+      Gen->PrintStats();
+    }
+
     void HandleTranslationUnit(ASTContext &C) override {
       {
         PrettyStackTraceString CrashInfo("Per-file LLVM IR generation");
@@ -223,11 +356,14 @@ namespace clang {
           return;
       }
 
+      WriteOpenMPDeviceBitcode(Diags, CodeGenOpts, getModule());
+
       EmbedBitcode(getModule(), CodeGenOpts, llvm::MemoryBufferRef());
 
       EmitBackendOutput(Diags, CodeGenOpts, TargetOpts, LangOpts,
                         C.getTargetInfo().getDataLayout(),
-                        getModule(), Action, std::move(AsmOutStream));
+                        getModule(), Action, std::move(AsmOutStream),
+                        EarlyPasses.get());
 
       Ctx.setInlineAsmDiagnosticHandler(OldHandler, OldContext);
 
@@ -260,6 +396,10 @@ namespace clang {
       Gen->HandleVTable(RD);
     }
 
+    void HandlePendingInstantiations() override {
+      Gen->HandlePendingInstantiations();
+    }
+
     static void InlineAsmDiagHandler(const llvm::SMDiagnostic &SM,void *Context,
                                      unsigned LocCookie) {
       SourceLocation Loc = SourceLocation::getFromRawEncoding(LocCookie);
@@ -777,7 +917,8 @@ CodeGenAction::CreateASTConsumer(CompilerInstance &CI, StringRef InFile) {
     for (auto &I : CI.getCodeGenOpts().LinkBitcodeFiles) {
       const std::string &LinkBCFile = I.second;
 
-      auto BCBuf = CI.getFileManager().getBufferForFile(LinkBCFile);
+      llvm::ErrorOr<llvm::MemoryBufferRef> BCBuf =
+          LinkBitcode->get(CI.getFileManager(), LinkBCFile);
       if (!BCBuf) {
         CI.getDiagnostics().Report(diag::err_cannot_open_file)
             << LinkBCFile << BCBuf.getError().message();
@@ -786,7 +927,7 @@ CodeGenAction::CreateASTConsumer(CompilerInstance &CI, StringRef InFile) {
       }
 
       Expected<std::unique_ptr<llvm::Module>> ModuleOrErr =
-          getOwningLazyBitcodeModule(std::move(*BCBuf), *VMContext);
+          getLazyBitcodeModule(*BCBuf, *VMContext);
       if (!ModuleOrErr) {
         handleAllErrors(ModuleOrErr.takeError(), [&](ErrorInfoBase &EIB) {
           CI.getDiagnostics().Report(diag::err_cannot_open_file)
@@ -891,6 +1032,9 @@ void CodeGenAction::ExecuteAction() {
       TheModule->setTargetTriple(TargetOpts.Triple);
     }
 
+    WriteOpenMPDeviceBitcode(CI.getDiagnostics(), CI.getCodeGenOpts(),
+                             TheModule.get());
+
     EmbedBitcode(TheModule.get(), CI.getCodeGenOpts(),
                  MainFile->getMemBufferRef());
 
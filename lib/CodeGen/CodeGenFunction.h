@@ -329,6 +329,11 @@ public:
   /// finally block or filter expression.
   bool IsOutlinedSEHHelper;
 
+  /// True while emitting code that __builtin_expect or a throw expression
+  /// makes unlikely to run, with -fcold-unlikely-calls. The calls emitted
+  /// there are marked cold.
+  bool InUnlikelyPath = false;
+
   const CodeGen::CGBlockInfo *BlockInfo;
   llvm::Value *BlockPointer;
 
@@ -1097,6 +1102,39 @@ private:
   };
   OpenMPCancelExitStack OMPCancelStack;
 
+public:
+  /// The loop with an 'ordered(n)' clause being emitted whose iterations are
+  /// posted per tile.
+  const OMPLoopDirective *OMPDoacrossTiledLoop = nullptr;
+  /// The private copy of a reduction or lastprivate variable being emitted,
+  /// which is over-aligned and padded to whole cache lines.
+  const VarDecl *OMPPaddedPrivateCopy = nullptr;
+  /// A parallel region whose fork is deferred to be shared with the adjacent
+  /// parallel regions.
+  struct OMPFusedParallelRegion {
+    llvm::Value *OutlinedFn = nullptr;
+    SmallVector<llvm::Value *, 16> CapturedVars;
+  };
+  /// When set, the parallel regions being emitted are recorded here instead
+  /// of forking.
+  SmallVectorImpl<OMPFusedParallelRegion> *OMPFusedParallelRegions = nullptr;
+  /// Whether the statements being emitted are in a target data region
+  /// synthesized by EmitOMPHoistedTargetData.
+  bool InOMPHoistedTargetData = false;
+  /// A read of a two-dimensional array of a stencil loop whose elements are
+  /// staged in a buffer shared by the team, see EmitOMPStencilStagedLoop.
+  /// The buffer holds the \a Len elements of the array from \a Lo on.
+  struct OMPStagedArrayRead {
+    Address Array = Address::invalid();
+    Address Buffer = Address::invalid();
+    llvm::Value *Lo = nullptr;
+    llvm::Value *Len = nullptr;
+    uint64_t RowSize = 0;
+  };
+  llvm::DenseMap<const ArraySubscriptExpr *, OMPStagedArrayRead>
+      OMPStagedArrayReads;
+
+private:
   CodeGenPGO PGO;
 
   /// Calculate branch weights appropriate for PGO data
@@ -1984,6 +2022,20 @@ public:
                          QualType EltTy, bool isVolatile=false,
                          bool isAssignment = false);
 
+  /// The reasons for which an aggregate is copied, as reported by
+  /// -Rpass-analysis=clang-copy.
+  enum AggregateCopyReason {
+    ACR_Return,
+    ACR_MissedNRVO,
+    ACR_Argument,
+    ACR_LambdaCapture
+  };
+
+  /// EmitAggregateCopyRemark - Report that evaluating the aggregate \p E
+  /// copies an existing object for \p Reason, if the object is at least as
+  /// large as -faggregate-copy-remark-threshold.
+  void EmitAggregateCopyRemark(const Expr *E, AggregateCopyReason Reason);
+
   /// GetAddrOfLocalVar - Return the address of a local variable.
   Address GetAddrOfLocalVar(const VarDecl *VD) {
     auto it = LocalDeclMap.find(VD);
@@ -2661,6 +2713,15 @@ public:
                                  const TaskGenTy &TaskGen, OMPTaskDataTy &Data);
 
   void EmitOMPParallelDirective(const OMPParallelDirective &S);
+  /// Emits the leading parallel directives of \p Stmts that can share a
+  /// single fork. Returns the number of statements emitted, 0 if there are
+  /// less than two of them.
+  unsigned EmitOMPFusedParallelDirectives(ArrayRef<Stmt *> Stmts);
+  /// Emits the leading loop of \p Stmts, or its leading target regions, in a
+  /// target data region that maps once the variables that the target regions
+  /// map, with -fopenmp-hoist-target-data. Returns the number of statements
+  /// emitted, 0 if nothing can be hoisted.
+  unsigned EmitOMPHoistedTargetData(ArrayRef<Stmt *> Stmts);
   void EmitOMPSimdDirective(const OMPSimdDirective &S);
   void EmitOMPForDirective(const OMPForDirective &S);
   void EmitOMPForSimdDirective(const OMPForSimdDirective &S);
@@ -2673,6 +2734,8 @@ public:
   void EmitOMPParallelForSimdDirective(const OMPParallelForSimdDirective &S);
   void EmitOMPParallelSectionsDirective(const OMPParallelSectionsDirective &S);
   void EmitOMPTaskDirective(const OMPTaskDirective &S);
+  /// Emit task \a S through the runtime, with \a IfCond as its 'if' clause.
+  void EmitOMPTaskCall(const OMPTaskDirective &S, const Expr *IfCond);
   void EmitOMPTaskyieldDirective(const OMPTaskyieldDirective &S);
   void EmitOMPBarrierDirective(const OMPBarrierDirective &S);
   void EmitOMPTaskwaitDirective(const OMPTaskwaitDirective &S);
@@ -2803,6 +2866,10 @@ private:
 
   /// Helpers for the OpenMP loop directives.
   void EmitOMPLoopBody(const OMPLoopDirective &D, JumpDest LoopExit);
+  /// Emit the coalesced loop of a stencil distribute directive whose teams
+  /// stage the arrays read by their iterations in memory shared by the team.
+  /// \return false, and emit nothing, if the loop is not such a stencil.
+  bool EmitOMPStencilStagedLoop(const OMPLoopDirective &S, JumpDest LoopExit);
   void EmitOMPSimdInit(const OMPLoopDirective &D, bool IsMonotonic = false);
   void EmitOMPSimdFinal(
       const OMPLoopDirective &D,
@@ -2997,6 +3064,8 @@ public:
                                 bool Accessed = false);
   LValue EmitOMPArraySectionExpr(const OMPArraySectionExpr *E,
                                  bool IsLowerBound = true);
+  LValue EmitOMPStagedArraySubscriptExpr(const ArraySubscriptExpr *E,
+                                         const OMPStagedArrayRead &Read);
   LValue EmitExtVectorElementExpr(const ExtVectorElementExpr *E);
   LValue EmitMemberExpr(const MemberExpr *E);
   LValue EmitObjCIsaExpr(const ObjCIsaExpr *E);
@@ -3089,6 +3158,15 @@ public:
                   ReturnValueSlot ReturnValue, const CallArgList &Args,
                   llvm::Instruction **callOrInvoke = nullptr);
 
+  /// Split a virtual call in a direct call of the given target, when the
+  /// object has the vtable of the target's class, and the original indirect
+  /// call otherwise. Return the merged result of the calls.
+  llvm::Instruction *EmitSpeculativeVirtualCall(llvm::Instruction *CI,
+                                                const CGCallee &Callee,
+                                                const CXXMethodDecl *Target,
+                                                uint64_t Count,
+                                                uint64_t Total);
+
   RValue EmitCall(QualType FnType, const CGCallee &Callee, const CallExpr *E,
                   ReturnValueSlot ReturnValue,
                   llvm::Value *Chain = nullptr);
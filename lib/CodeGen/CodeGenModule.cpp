@@ -41,6 +41,7 @@
 #include "clang/Basic/Module.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Basic/TargetInfo.h"
+#include "clang/Basic/TimeTrace.h"
 #include "clang/Basic/Version.h"
 #include "clang/Frontend/CodeGenOptions.h"
 #include "clang/Sema/SemaDiagnostic.h"
@@ -154,7 +155,8 @@ CodeGenModule::CodeGenModule(ASTContext &C, const HeaderSearchOptions &HSO,
       PreprocessorOpts(PPO), CodeGenOpts(CGO), TheModule(M), Diags(diags),
       Target(C.getTargetInfo()), ABI(createCXXABI(*this)),
       VMContext(M.getContext()), Types(*this), VTables(*this),
-      SanitizerMD(new SanitizerMetadata(*this)) {
+      SanitizerMD(new SanitizerMetadata(*this)),
+      ManglingTimer("mangling", "Name Mangling Time") {
 
   // Initialize the type cache.
   llvm::LLVMContext &LLVMContext = M.getContext();
@@ -590,6 +592,31 @@ void CodeGenModule::Release() {
 void CodeGenModule::UpdateCompletedType(const TagDecl *TD) {
   // Make sure that this type is translated.
   Types.UpdateCompletedType(TD);
+
+  // Remember the dynamic classes for speculative devirtualization.
+  if (CodeGenOpts.SpeculativeDevirtualization && PGOReader)
+    if (const auto *RD = dyn_cast<CXXRecordDecl>(TD))
+      if (!RD->isDependentContext() && RD->isDynamicClass())
+        SpeculativeVCallClasses.push_back(RD);
+}
+
+const CXXMethodDecl *CodeGenModule::getSpeculativeVCallTarget(uint64_t Hash) {
+  // Index the classes completed since the last lookup.
+  for (; NumIndexedSpeculativeVCallClasses != SpeculativeVCallClasses.size();
+       ++NumIndexedSpeculativeVCallClasses) {
+    const CXXRecordDecl *RD =
+        SpeculativeVCallClasses[NumIndexedSpeculativeVCallClasses];
+    for (const CXXMethodDecl *MD : RD->methods()) {
+      if (!MD->isVirtual() || MD->isPure() || isa<CXXDestructorDecl>(MD))
+        continue;
+      std::string FuncName = llvm::getPGOFuncName(
+          getMangledName(MD), getFunctionLinkage(MD),
+          CodeGenOpts.MainFileName, PGOReader->getVersion());
+      SpeculativeVCallTargets.insert(
+          std::make_pair(llvm::IndexedInstrProf::ComputeHash(FuncName), MD));
+    }
+  }
+  return SpeculativeVCallTargets.lookup(Hash);
 }
 
 void CodeGenModule::RefreshTypeCacheForClass(const CXXRecordDecl *RD) {
@@ -744,6 +771,7 @@ StringRef CodeGenModule::getMangledName(GlobalDecl GD) {
   if (!FoundStr.empty())
     return FoundStr;
 
+  llvm::TimeRegion Timing(CodeGenOpts.TimePasses ? &ManglingTimer : nullptr);
   const auto *ND = cast<NamedDecl>(GD.getDecl());
   SmallString<256> Buffer;
   StringRef Str;
@@ -778,6 +806,7 @@ StringRef CodeGenModule::getMangledName(GlobalDecl GD) {
 
 StringRef CodeGenModule::getBlockMangledName(GlobalDecl GD,
                                              const BlockDecl *BD) {
+  llvm::TimeRegion Timing(CodeGenOpts.TimePasses ? &ManglingTimer : nullptr);
   MangleContext &MangleCtx = getCXXABI().getMangleContext();
   const Decl *D = GD.getDecl();
 
@@ -1030,6 +1059,8 @@ void CodeGenModule::SetLLVMFunctionAttributesForDefinition(const Decl *D,
     if (D->hasAttr<ColdAttr>()) {
       B.addAttribute(llvm::Attribute::OptimizeForSize);
       B.addAttribute(llvm::Attribute::Cold);
+      if (CodeGenOpts.ColdUnlikelyCalls && !D->hasAttr<SectionAttr>())
+        F->setSectionPrefix(".unlikely");
     }
 
     if (D->hasAttr<MinSizeAttr>())
@@ -1215,6 +1246,12 @@ void CodeGenModule::SetFunctionAttributes(GlobalDecl GD, llvm::Function *F,
   // is handled with better precision by the receiving DSO.
   if (!CodeGenOpts.SanitizeCfiCrossDso)
     CreateFunctionTypeMetadata(FD, F);
+
+  // The vector variants of the 'declare simd' functions defined in other
+  // modules can be called from the loops of this one.
+  if (LangOpts.OpenMP && CodeGenOpts.OpenMPDeclareSimdCalls &&
+      FD->hasAttr<OMPDeclareSimdDeclAttr>())
+    getOpenMPRuntime().emitDeclareSimdFunction(FD, F);
 }
 
 void CodeGenModule::addUsedGlobal(llvm::GlobalValue *GV) {
@@ -1378,12 +1415,12 @@ void CodeGenModule::EmitModuleLinkOptions() {
                                               LinkerOptionsMetadata));
 }
 
-void CodeGenModule::EmitDeferred() {
+void CodeGenModule::EmitDeferred(bool DeclsOnly) {
   // Emit code for any potentially referenced deferred decls.  Since a
   // previously unused static decl may become used during the generation of code
   // for a static function, iterate until no changes are made.
 
-  if (!DeferredVTables.empty()) {
+  if (!DeclsOnly && !DeferredVTables.empty()) {
     EmitDeferredVTables();
 
     // Emitting a vtable doesn't directly cause more vtables to
@@ -1392,7 +1429,7 @@ void CodeGenModule::EmitDeferred() {
     assert(DeferredVTables.empty());
   }
 
-  if (LangOpts.OpenMP && !LangOpts.OpenMPIsDevice) {
+  if (!DeclsOnly && LangOpts.OpenMP && !LangOpts.OpenMPIsDevice) {
     OpenMPRuntime->registerTrackedFunction();
   }
 
@@ -1409,6 +1446,20 @@ void CodeGenModule::EmitDeferred() {
     GlobalDecl D = G.GD;
     G.GV = nullptr;
 
+    // Decls are often queued several times; recognize the ones that were
+    // already emitted by their cached mangled name, without arranging their
+    // type again. A definition of another decl with the same name still goes
+    // through GetAddrOfGlobal so that the conflict is diagnosed.
+    StringRef MangledName = getMangledName(D);
+    if (llvm::GlobalValue *Existing = GetGlobalValue(MangledName)) {
+      GlobalDecl OtherGD;
+      if (!Existing->isDeclaration() &&
+          lookupRepresentativeDecl(MangledName, OtherGD) &&
+          OtherGD.getCanonicalDecl().getDecl() ==
+              D.getCanonicalDecl().getDecl())
+        continue;
+    }
+
     // We should call GetAddrOfGlobal with IsForDefinition set to true in order
     // to get GlobalValue with exactly the type we need, not something that
     // might had been created for another decl with the same mangled name but
@@ -1420,7 +1471,7 @@ void CodeGenModule::EmitDeferred() {
     // IsForDefinition equal to true. Query mangled names table to get
     // GlobalValue.
     if (!GV)
-      GV = GetGlobalValue(getMangledName(D));
+      GV = GetGlobalValue(MangledName);
 
     // Make sure GetGlobalValue returned non-null.
     assert(GV);
@@ -1440,9 +1491,11 @@ void CodeGenModule::EmitDeferred() {
     // If we found out that we need to emit more decls, do that recursively.
     // This has the advantage that the decls are emitted in a DFS and related
     // ones are close together, which is convenient for testing.
-    if (!DeferredVTables.empty() || !DeferredDeclsToEmit.empty()) {
-      EmitDeferred();
-      assert(DeferredVTables.empty() && DeferredDeclsToEmit.empty());
+    if ((!DeclsOnly && !DeferredVTables.empty()) ||
+        !DeferredDeclsToEmit.empty()) {
+      EmitDeferred(DeclsOnly);
+      assert((DeclsOnly || DeferredVTables.empty()) &&
+             DeferredDeclsToEmit.empty());
     }
   }
 }
@@ -2022,7 +2075,8 @@ CodeGenModule::GetOrCreateLLVMFunction(StringRef MangledName,
 
   // Process function name as required by the OpenMP runtime
   if (OpenMPRuntime) {
-    MangledName = OpenMPRuntime->RenameStandardFunction(MangledName);
+    MangledName = OpenMPRuntime->RenameStandardFunction(
+        MangledName, dyn_cast_or_null<FunctionDecl>(D));
   }
 
   // Lookup the entry, lazily creating it if necessary.
@@ -2854,6 +2908,11 @@ void CodeGenModule::EmitGlobalVarDefinition(const VarDecl *D,
   if (NeedsGlobalCtor || NeedsGlobalDtor)
     EmitCXXGlobalVarDeclInitFunc(D, GV, NeedsGlobalCtor);
 
+  // The uses of a lazily initialized variable call its initialization
+  // function even if its initializer turned out to be constant.
+  if (!NeedsGlobalCtor && isLazilyInitialized(D))
+    EmitTrivialLazyInitFunc(D, GV);
+
   SanitizerMD->reportGlobalToASan(GV, *D, NeedsGlobalCtor);
 
   // Emit global variable debug information.
@@ -3138,6 +3197,13 @@ void CodeGenModule::HandleCXXStaticMemberVarInstantiation(VarDecl *VD) {
 void CodeGenModule::EmitGlobalFunctionDefinition(GlobalDecl GD,
                                                  llvm::GlobalValue *GV) {
   const auto *D = cast<FunctionDecl>(GD.getDecl());
+  TimeTraceScope TTS("CodeGenFunction", [&] {
+    std::string Name;
+    llvm::raw_string_ostream OS(Name);
+    D->getNameForDiagnostic(OS, getContext().getPrintingPolicy(),
+                            /*Qualified=*/true);
+    return OS.str();
+  });
 
   // Compute the function info and LLVM type.
   const CGFunctionInfo &FI = getTypes().arrangeGlobalDeclaration(GD);
@@ -3558,6 +3624,46 @@ CodeGenModule::GetConstantArrayFromStringLiteral(const StringLiteral *E) {
   return llvm::ConstantDataArray::get(VMContext, Elements);
 }
 
+template <typename T>
+static SmallVector<T, 0>
+GetCompactArrayElements(const CompactArrayInitExpr *E, unsigned NumElements) {
+  SmallVector<T, 0> Elements;
+  Elements.reserve(NumElements);
+  for (unsigned i = 0, e = E->getNumElements(); i != e; ++i)
+    Elements.push_back(E->getElement(i));
+  Elements.resize(NumElements);
+  return Elements;
+}
+
+llvm::Constant *CodeGenModule::GetConstantArrayFromCompactArrayInit(
+    const CompactArrayInitExpr *E) {
+  auto *AType = cast<llvm::ArrayType>(getTypes().ConvertType(E->getType()));
+  unsigned NumElements = AType->getNumElements();
+  bool IsFloating = AType->getElementType()->isFloatingPointTy();
+
+  switch (E->getElementByteWidth()) {
+  case 1:
+    return llvm::ConstantDataArray::get(
+        VMContext, GetCompactArrayElements<uint8_t>(E, NumElements));
+  case 2:
+    return llvm::ConstantDataArray::get(
+        VMContext, GetCompactArrayElements<uint16_t>(E, NumElements));
+  case 4: {
+    auto Elements = GetCompactArrayElements<uint32_t>(E, NumElements);
+    if (IsFloating)
+      return llvm::ConstantDataArray::getFP(VMContext, Elements);
+    return llvm::ConstantDataArray::get(VMContext, Elements);
+  }
+  default: {
+    assert(E->getElementByteWidth() == 8 && "unexpected element width");
+    auto Elements = GetCompactArrayElements<uint64_t>(E, NumElements);
+    if (IsFloating)
+      return llvm::ConstantDataArray::getFP(VMContext, Elements);
+    return llvm::ConstantDataArray::get(VMContext, Elements);
+  }
+  }
+}
+
 static llvm::GlobalVariable *
 GenerateStringLiteral(llvm::Constant *C, llvm::GlobalValue::LinkageTypes LT,
                       CodeGenModule &CGM, StringRef GlobalName,
@@ -3923,6 +4029,12 @@ void CodeGenModule::EmitTopLevelDecl(Decl *D) {
     EmitDeclContext(cast<NamespaceDecl>(D));
     break;
   case Decl::CXXRecord:
+    // The object file of a module built with -fmodules-debuginfo is the home
+    // of the debug info of its classes.
+    if (CGDebugInfo *DI = getModuleDebugInfo())
+      if (ExternalASTSource *Source = getContext().getExternalSource())
+        if (Source->hasExternalDefinitions(D) == ExternalASTSource::EK_Never)
+          DI->completeUnusedClass(*cast<CXXRecordDecl>(D));
     // Emit any static data members, they may be definitions.
     for (auto *I : cast<CXXRecordDecl>(D)->decls())
       if (isa<VarDecl>(I) || isa<CXXRecordDecl>(I))
@@ -4138,6 +4250,12 @@ void CodeGenModule::AddDeferredUnusedCoverageMapping(Decl *D) {
   case Decl::CXXDestructor: {
     if (!cast<FunctionDecl>(D)->doesThisDeclarationHaveABody())
       return;
+    // Every translation unit that includes a header would otherwise describe
+    // its unused inline functions; those that use them already do.
+    if (!CodeGenOpts.CoverageUnusedHeaderFunctions &&
+        cast<FunctionDecl>(D)->isExternallyVisible() &&
+        !getContext().getSourceManager().isInMainFile(D->getLocation()))
+      return;
     auto I = DeferredEmptyCoverageMappingDecls.find(D);
     if (I == DeferredEmptyCoverageMappingDecls.end())
       DeferredEmptyCoverageMappingDecls[D] = true;
@@ -34,6 +34,7 @@
 #include "llvm/ADT/StringMap.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/ValueHandle.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Transforms/Utils/SanitizerStats.h"
 
 namespace llvm {
@@ -345,6 +346,14 @@ private:
   /// A queue of (optional) vtables to consider emitting.
   std::vector<const CXXRecordDecl*> DeferredVTables;
 
+  /// The dynamic classes completed in this translation unit, whose virtual
+  /// functions are the targets profiled virtual calls can be speculated on.
+  std::vector<const CXXRecordDecl *> SpeculativeVCallClasses;
+  /// The virtual functions of the indexed classes above, by the MD5 hash of
+  /// their PGO name.
+  llvm::DenseMap<uint64_t, const CXXMethodDecl *> SpeculativeVCallTargets;
+  unsigned NumIndexedSpeculativeVCallClasses = 0;
+
   /// List of global values which are required to be present in the object file;
   /// bitcast to i8*. This is used for forcing visibility of symbols which may
   /// otherwise be optimized out.
@@ -363,6 +372,10 @@ private:
   llvm::MapVector<GlobalDecl, StringRef> MangledDeclNames;
   llvm::StringMap<GlobalDecl, llvm::BumpPtrAllocator> Manglings;
 
+  /// The time spent mangling the names of declarations, reported under
+  /// -ftime-report.
+  llvm::Timer ManglingTimer;
+
   /// Global annotations.
   std::vector<llvm::Constant*> Annotations;
 
@@ -405,6 +418,10 @@ private:
   /// order. Once the decl is emitted, the index is replaced with ~0U to ensure
   /// that we don't re-emit the initializer.
   llvm::DenseMap<const Decl*, unsigned> DelayedCXXInitPosition;
+
+  /// Whether the variables are initialized on their first use, by their
+  /// canonical declaration.
+  llvm::DenseMap<const VarDecl *, bool> LazilyInitializedVars;
   
   typedef std::pair<OrderGlobalInits, llvm::Function*> GlobalInitData;
 
@@ -514,6 +531,10 @@ public:
   /// Finalize LLVM code generation.
   void Release();
 
+  /// Emit the deferred definitions that are known to be needed, leaving the
+  /// deferred vtables to Release.
+  void EmitDeferredDecls() { EmitDeferred(/*DeclsOnly=*/true); }
+
   /// Return a reference to the configured Objective-C runtime.
   CGObjCRuntime &getObjCRuntime() {
     if (!ObjCRuntime) createObjCRuntime();
@@ -806,6 +827,10 @@ public:
   /// Return a constant array for the given string.
   llvm::Constant *GetConstantArrayFromStringLiteral(const StringLiteral *E);
 
+  /// Return a constant array for the given compact array initializer.
+  llvm::Constant *
+  GetConstantArrayFromCompactArrayInit(const CompactArrayInitExpr *E);
+
   /// Return a pointer to a constant array for the given string literal.
   ConstantAddress
   GetAddrOfConstantStringFromLiteral(const StringLiteral *S,
@@ -934,6 +959,20 @@ public:
   // Make sure that this type is translated.
   void UpdateCompletedType(const TagDecl *TD);
 
+  /// Return true if the dynamic initializer of the given variable runs on its
+  /// first use, from the function returned by getLazyInitFunction, instead of
+  /// at startup.
+  bool isLazilyInitialized(const VarDecl *D);
+
+  /// Return the function that initializes the given lazily initialized
+  /// variable if it isn't initialized yet. It is called before every use of
+  /// the variable.
+  llvm::Function *getLazyInitFunction(const VarDecl *D);
+
+  /// Return the virtual function, of a class completed in this translation
+  /// unit, whose PGO name has the given MD5 hash, or null if there is none.
+  const CXXMethodDecl *getSpeculativeVCallTarget(uint64_t Hash);
+
   llvm::Constant *getMemberPointerConstant(const UnaryOperator *e);
 
   /// Try to emit the initializer for the given declaration as a constant;
@@ -1242,6 +1281,10 @@ private:
   void EmitPointerToInitFunc(const VarDecl *VD, llvm::GlobalVariable *Addr,
                              llvm::Function *InitFunc, InitSegAttr *ISA);
 
+  /// Emit the initialization function of a lazily initialized variable whose
+  /// initializer turned out to be constant, which has nothing to do.
+  void EmitTrivialLazyInitFunc(const VarDecl *D, llvm::GlobalVariable *Addr);
+
   // FIXME: Hardcoding priority here is gross.
   void AddGlobalCtor(llvm::Function *Ctor, int Priority = 65535,
                      llvm::Constant *AssociatedData = nullptr);
@@ -1253,7 +1296,8 @@ private:
   void EmitCtorList(CtorList &Fns, const char *GlobalName);
 
   /// Emit any needed decls for which code generation was deferred.
-  void EmitDeferred();
+  /// \param DeclsOnly Whether to leave the deferred vtables for later.
+  void EmitDeferred(bool DeclsOnly = false);
 
   /// Call replaceAllUsesWith on all pairs in Replacements.
   void applyReplacements();
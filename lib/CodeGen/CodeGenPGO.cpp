@@ -26,6 +26,18 @@ static llvm::cl::opt<bool> EnableValueProfiling(
   "enable-value-profiling", llvm::cl::ZeroOrMore,
   llvm::cl::desc("Enable value profiling"), llvm::cl::init(false));
 
+static llvm::cl::opt<unsigned> DominantCallTargetPercent(
+  "dominant-call-target-percent", llvm::cl::ZeroOrMore,
+  llvm::cl::desc("Percentage of the calls of an indirect call site that must "
+                 "go to a target to speculatively call it directly"),
+  llvm::cl::init(80));
+
+static llvm::cl::opt<unsigned> DominantCallTargetCount(
+  "dominant-call-target-count", llvm::cl::ZeroOrMore,
+  llvm::cl::desc("Number of calls of an indirect call site that must go to "
+                 "a target to speculatively call it directly"),
+  llvm::cl::init(1000));
+
 using namespace clang;
 using namespace CodeGen;
 
@@ -743,6 +755,20 @@ void CodeGenPGO::emitCounterIncrement(CGBuilderTy &Builder, const Stmt *S) {
   if (!Builder.GetInsertBlock())
     return;
 
+  // When sampling, only increment the counter in the calls that are sampled;
+  // the other calls just test a flag that is almost always false.
+  llvm::BasicBlock *CurBB = Builder.GetInsertBlock();
+  llvm::BasicBlock *ContBB = nullptr;
+  unsigned SamplePeriod = CGM.getCodeGenOpts().ProfileInstrSamplePeriod;
+  if (SamplePeriod > 1 && Builder.GetInsertPoint() == CurBB->end()) {
+    llvm::Function *Fn = CurBB->getParent();
+    auto *SampleBB =
+        llvm::BasicBlock::Create(CGM.getLLVMContext(), "pgo.sample", Fn);
+    ContBB = llvm::BasicBlock::Create(CGM.getLLVMContext(), "pgo.cont", Fn);
+    Builder.CreateCondBr(getSampledCall(Fn, SamplePeriod), SampleBB, ContBB);
+    Builder.SetInsertPoint(SampleBB);
+  }
+
   unsigned Counter = (*RegionCounterMap)[S];
   auto *I8PtrTy = llvm::Type::getInt8PtrTy(CGM.getLLVMContext());
   Builder.CreateCall(CGM.getIntrinsic(llvm::Intrinsic::instrprof_increment),
@@ -750,6 +776,39 @@ void CodeGenPGO::emitCounterIncrement(CGBuilderTy &Builder, const Stmt *S) {
                       Builder.getInt64(FunctionHash),
                       Builder.getInt32(NumRegionCounters),
                       Builder.getInt32(Counter)});
+
+  if (ContBB) {
+    Builder.CreateBr(ContBB);
+    Builder.SetInsertPoint(ContBB);
+  }
+}
+
+/// Decide, on entry to \p Fn, whether the current call is one of the one in
+/// \p Period calls whose counts are collected. Each function counts down its
+/// calls in a private global, so that the first call is sampled.
+llvm::Value *CodeGenPGO::getSampledCall(llvm::Function *Fn, unsigned Period) {
+  if (SampledCall)
+    return SampledCall;
+
+  auto *Int32Ty = llvm::Type::getInt32Ty(CGM.getLLVMContext());
+  auto *Countdown = new llvm::GlobalVariable(
+      CGM.getModule(), Int32Ty, /*isConstant=*/false,
+      llvm::GlobalValue::PrivateLinkage, llvm::ConstantInt::get(Int32Ty, 0),
+      "__profsample_" + FuncName);
+
+  // The entry block dominates all the increments of the function.
+  llvm::BasicBlock &Entry = Fn->getEntryBlock();
+  llvm::IRBuilder<> EntryBuilder(&Entry, Entry.getFirstInsertionPt());
+  llvm::Value *Left = EntryBuilder.CreateLoad(Countdown, "pgo.countdown");
+  SampledCall = EntryBuilder.CreateICmpEQ(Left, EntryBuilder.getInt32(0),
+                                          "pgo.sampled");
+  EntryBuilder.CreateStore(
+      EntryBuilder.CreateSelect(SampledCall,
+                                EntryBuilder.getInt32(Period - 1),
+                                EntryBuilder.CreateSub(
+                                    Left, EntryBuilder.getInt32(1))),
+      Countdown);
+  return SampledCall;
 }
 
 // This method either inserts a call to the profile run-time during
@@ -802,6 +861,35 @@ void CodeGenPGO::valueProfile(CGBuilderTy &Builder, uint32_t ValueKind,
   }
 }
 
+bool CodeGenPGO::getDominantCallTarget(uint64_t &TargetHash, uint64_t &Count,
+                                       uint64_t &Total) const {
+  if (!EnableValueProfiling || !CGM.getPGOReader() || !haveRegionCounts())
+    return false;
+
+  // This is the site valueProfile will annotate next.
+  uint32_t Site = NumValueSites[llvm::IPVK_IndirectCallTarget];
+  if (Site >= ProfRecord->getNumValueSites(llvm::IPVK_IndirectCallTarget))
+    return false;
+  uint32_t NumValues =
+      ProfRecord->getNumValueDataForSite(llvm::IPVK_IndirectCallTarget, Site);
+  if (!NumValues)
+    return false;
+  std::unique_ptr<llvm::InstrProfValueData[]> Values =
+      ProfRecord->getValueForSite(llvm::IPVK_IndirectCallTarget, Site, &Total);
+
+  const llvm::InstrProfValueData *Max = &Values[0];
+  for (uint32_t I = 1; I != NumValues; ++I)
+    if (Values[I].Count > Max->Count)
+      Max = &Values[I];
+  if (Max->Count < DominantCallTargetCount ||
+      Max->Count * 100 < Total * DominantCallTargetPercent)
+    return false;
+
+  TargetHash = Max->Value;
+  Count = Max->Count;
+  return true;
+}
+
 void CodeGenPGO::loadRegionCounts(llvm::IndexedInstrProfReader *PGOReader,
                                   bool IsInMainFile) {
   CGM.getPGOStats().addVisited(IsInMainFile);
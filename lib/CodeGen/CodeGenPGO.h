@@ -43,11 +43,15 @@ private:
   /// \brief A flag that is set to true when this function doesn't need
   /// to have coverage mapping data.
   bool SkipCoverageMapping;
+  /// \brief With -fprofile-instr-sample-period, whether the current call of
+  /// the function is one whose counts are collected.
+  llvm::Value *SampledCall;
 
 public:
   CodeGenPGO(CodeGenModule &CGM)
       : CGM(CGM), NumValueSites({{0}}), NumRegionCounters(0),
-        FunctionHash(0), CurrentRegionCount(0), SkipCoverageMapping(false) {}
+        FunctionHash(0), CurrentRegionCount(0), SkipCoverageMapping(false),
+        SampledCall(nullptr) {}
 
   /// Whether or not we have PGO region data for the current function. This is
   /// false both when we have no data at all and when our data has been
@@ -92,6 +96,11 @@ public:
   // Insert instrumentation or attach profile metadata at value sites
   void valueProfile(CGBuilderTy &Builder, uint32_t ValueKind,
                     llvm::Instruction *ValueSite, llvm::Value *ValuePtr);
+  /// Return the target of the next indirect call site if the profile shows
+  /// that it is called often enough, and by enough of the calls of the site,
+  /// to be worth calling directly. The target is the MD5 hash of its PGO name.
+  bool getDominantCallTarget(uint64_t &TargetHash, uint64_t &Count,
+                             uint64_t &Total) const;
 private:
   void setFuncName(llvm::Function *Fn);
   void setFuncName(StringRef Name, llvm::GlobalValue::LinkageTypes Linkage);
@@ -103,6 +112,7 @@ private:
                         bool IsInMainFile);
   bool skipRegionMappingForDecl(const Decl *D);
   void emitCounterRegionMapping(const Decl *D);
+  llvm::Value *getSampledCall(llvm::Function *Fn, unsigned Period);
 
 public:
   void emitCounterIncrement(CGBuilderTy &Builder, const Stmt *S);
@@ -26,6 +26,8 @@
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/SaveAndRestore.h"
+#include "llvm/Support/raw_ostream.h"
 using namespace clang;
 using namespace CodeGen;
 
@@ -44,6 +46,16 @@ CodeGenTypes::~CodeGenTypes() {
     delete &*I++;
 }
 
+void CodeGenTypes::PrintStats() const {
+  llvm::errs() << "\n*** CodeGen Type Stats:\n";
+  llvm::errs() << "  " << RecordDeclTypes.size() << " record types converted, "
+               << NumRecordLayouts << " laid out, with "
+               << NumBitFieldsLaidOut << " bit-fields\n";
+  llvm::errs() << "  " << TypeCache.size() << " cached types, "
+               << NumTypeCacheFlushes
+               << " flushes of the type cache for skipped layouts\n";
+}
+
 void CodeGenTypes::addRecordTypeName(const RecordDecl *RD,
                                      llvm::StructType *Ty,
                                      StringRef suffix) {
@@ -367,7 +379,7 @@ llvm::Type *CodeGenTypes::ConvertFunctionType(QualType QFT,
   RecordsBeingLaidOut.erase(Ty);
 
   if (SkippedLayout)
-    TypeCache.clear();
+    flushSkippedLayouts();
 
   if (RecordsBeingLaidOut.empty())
     while (!DeferredRecords.empty())
@@ -375,6 +387,17 @@ llvm::Type *CodeGenTypes::ConvertFunctionType(QualType QFT,
   return ResultType;
 }
 
+/// Flush the types derived from the placeholders of skipped layouts from the
+/// cache. Once no conversion is in progress, no placeholder is left to be
+/// cached again, so the conversions done from now on need not flush it.
+void CodeGenTypes::flushSkippedLayouts() {
+  TypeCache.clear();
+  ++NumTypeCacheFlushes;
+  if (!ConvertTypeDepth && RecordsBeingLaidOut.empty() &&
+      FunctionsBeingProcessed.empty())
+    SkippedLayout = false;
+}
+
 /// ConvertType - Convert the specified type to its LLVM form.
 llvm::Type *CodeGenTypes::ConvertType(QualType T) {
   T = Context.getCanonicalType(T);
@@ -384,7 +407,14 @@ llvm::Type *CodeGenTypes::ConvertType(QualType T) {
   // RecordTypes are cached and processed specially.
   if (const RecordType *RT = dyn_cast<RecordType>(Ty))
     return ConvertRecordDeclType(RT->getDecl());
-  
+
+  // The outermost conversion may have cached types derived from a placeholder
+  // after the last flush.
+  if (SkippedLayout && !ConvertTypeDepth && RecordsBeingLaidOut.empty() &&
+      FunctionsBeingProcessed.empty())
+    flushSkippedLayouts();
+  llvm::SaveAndRestore<unsigned> Depth(ConvertTypeDepth, ConvertTypeDepth + 1);
+
   // See if type is already cached.
   llvm::DenseMap<const Type *, llvm::Type *>::iterator TCI = TypeCache.find(Ty);
   // If type is found in map then use it. Otherwise, convert type T.
@@ -707,7 +737,7 @@ llvm::StructType *CodeGenTypes::ConvertRecordDeclType(const RecordDecl *RD) {
   // was derived from that.
   // FIXME: This is hugely overconservative.
   if (SkippedLayout)
-    TypeCache.clear();
+    flushSkippedLayouts();
     
   // If we're done converting the outer-most record, then convert any deferred
   // structs as well.
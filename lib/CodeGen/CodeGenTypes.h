@@ -153,9 +153,18 @@ class CodeGenTypes {
   llvm::SmallPtrSet<const CGFunctionInfo*, 4> FunctionsBeingProcessed;
   
   /// True if we didn't layout a function due to a being inside
-  /// a recursive struct conversion, set this to true.
+  /// a recursive struct conversion, set this to true. Reset once the types
+  /// derived from the placeholder have been flushed from TypeCache.
   bool SkippedLayout;
 
+  /// The number of ConvertType calls in progress.
+  unsigned ConvertTypeDepth = 0;
+
+  /// Statistics about the work done to convert types, for -print-stats.
+  unsigned NumRecordLayouts = 0;
+  unsigned NumBitFieldsLaidOut = 0;
+  unsigned NumTypeCacheFlushes = 0;
+
   SmallVector<const RecordDecl *, 8> DeferredRecords;
   
   /// This map keeps cache of llvm::Types and maps clang::Type to
@@ -166,10 +175,15 @@ class CodeGenTypes {
 
   unsigned ClangCallConvToLLVMCallConv(CallingConv CC);
 
+  void flushSkippedLayouts();
+
 public:
   CodeGenTypes(CodeGenModule &cgm);
   ~CodeGenTypes();
 
+  /// Print statistics about the types converted so far.
+  void PrintStats() const;
+
   const llvm::DataLayout &getDataLayout() const {
     return TheModule.getDataLayout();
   }
@@ -1622,7 +1622,9 @@ CGCallee ItaniumCXXABI::getVirtualFunctionPointer(CodeGenFunction &CGF,
 
   uint64_t VTableIndex = CGM.getItaniumVTableContext().getMethodVTableIndex(GD);
   llvm::Value *VFunc;
+  bool IsTypeCheckedLoad = false;
   if (CGF.ShouldEmitVTableTypeCheckedLoad(MethodDecl->getParent())) {
+    IsTypeCheckedLoad = true;
     VFunc = CGF.EmitVTableTypeCheckedLoad(
         MethodDecl->getParent(), VTable,
         VTableIndex * CGM.getContext().getTargetInfo().getPointerWidth(0) / 8);
@@ -1650,6 +1652,10 @@ CGCallee ItaniumCXXABI::getVirtualFunctionPointer(CodeGenFunction &CGF,
   }
 
   CGCallee Callee(MethodDecl, VFunc);
+  // The call can be speculated on the vtable, unless the function pointer is
+  // only valid if the type check passed.
+  if (!IsTypeCheckedLoad)
+    Callee.setVirtualCallVTable(VTable);
   return Callee;
 }
 
@@ -1961,11 +1967,13 @@ void ItaniumCXXABI::EmitGuardedInit(CodeGenFunction &CGF, const VarDecl &D,
       D.isInline() &&
       !isTemplateInstantiation(D.getTemplateSpecializationKind());
 
-  // We only need to use thread-safe statics for local non-TLS variables and
-  // inline variables; other global initialization is always single-threaded
-  // or (through lazy dynamic loading in multiple threads) unsequenced.
+  // We only need to use thread-safe statics for local non-TLS variables,
+  // inline variables and variables initialized on their first use; other
+  // global initialization is always single-threaded or (through lazy dynamic
+  // loading in multiple threads) unsequenced.
   bool threadsafe = getContext().getLangOpts().ThreadsafeStatics &&
-                    (D.isLocalVarDecl() || NonTemplateInline) &&
+                    (D.isLocalVarDecl() || NonTemplateInline ||
+                     CGM.isLazilyInitialized(&D)) &&
                     !D.getTLSKind();
 
   // If we have a global variable with internal linkage and thread-safe statics
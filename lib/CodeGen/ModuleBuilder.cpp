@@ -39,6 +39,11 @@ namespace {
 
     unsigned HandlingTopLevelDecls;
 
+    /// Whether to emit the needed definitions after each top-level decl,
+    /// which is done for the instantiations at the end of the translation
+    /// unit with -fstream-instantiations.
+    bool EmittingInstantiations;
+
     /// Use this when emitting decls to block re-entrant decl emission. It will
     /// emit all deferred decls on scope exit. Set EmitDeferred to false if decl
     /// emission must be deferred longer, like at the end of a tag definition.
@@ -74,7 +79,7 @@ namespace {
                       CoverageSourceInfo *CoverageInfo = nullptr)
         : Diags(diags), Ctx(nullptr), HeaderSearchOpts(HSO),
           PreprocessorOpts(PPO), CodeGenOpts(CGO), HandlingTopLevelDecls(0),
-          CoverageInfo(CoverageInfo), M(new llvm::Module(ModuleName, C)) {
+          EmittingInstantiations(false), CoverageInfo(CoverageInfo), M(new llvm::Module(ModuleName, C)) {
       C.setDiscardValueNames(CGO.DiscardValueNames);
     }
 
@@ -151,16 +156,21 @@ namespace {
     }
 
     void EmitDeferredDecls() {
-      if (DeferredInlineMethodDefinitions.empty())
-        return;
+      if (!DeferredInlineMethodDefinitions.empty()) {
+        // Emit any deferred inline method definitions. Note that more deferred
+        // methods may be added during this loop, since ASTConsumer callbacks
+        // can be invoked if AST inspection results in declarations being
+        // added.
+        HandlingTopLevelDeclRAII HandlingDecl(*this);
+        for (unsigned I = 0; I != DeferredInlineMethodDefinitions.size(); ++I)
+          Builder->EmitTopLevelDecl(DeferredInlineMethodDefinitions[I]);
+        DeferredInlineMethodDefinitions.clear();
+      }
 
-      // Emit any deferred inline method definitions. Note that more deferred
-      // methods may be added during this loop, since ASTConsumer callbacks
-      // can be invoked if AST inspection results in declarations being added.
-      HandlingTopLevelDeclRAII HandlingDecl(*this);
-      for (unsigned I = 0; I != DeferredInlineMethodDefinitions.size(); ++I)
-        Builder->EmitTopLevelDecl(DeferredInlineMethodDefinitions[I]);
-      DeferredInlineMethodDefinitions.clear();
+      if (EmittingInstantiations) {
+        HandlingTopLevelDeclRAII HandlingDecl(*this, /*EmitDeferred=*/false);
+        Builder->EmitDeferredDecls();
+      }
     }
 
     void HandleInlineFunctionDefinition(FunctionDecl *D) override {
@@ -247,6 +257,23 @@ namespace {
           DI->completeRequiredType(RD);
     }
 
+    void HandlePendingInstantiations() override {
+      if (Diags.hasErrorOccurred() || !CodeGenOpts.StreamInstantiations)
+        return;
+
+      // The OpenMP and CUDA runtimes pick the functions to emit for the
+      // device at the end of the module.
+      const LangOptions &LangOpts = Ctx->getLangOpts();
+      if (LangOpts.OpenMP || LangOpts.CUDA)
+        return;
+
+      // Implicit instantiations may no longer change linkage, so generate
+      // code for each one that is needed as soon as it is instantiated,
+      // rather than for all of them in Release.
+      EmittingInstantiations = true;
+      EmitDeferredDecls();
+    }
+
     void HandleTranslationUnit(ASTContext &Ctx) override {
       // Release the Builder when there is no error.
       if (!Diags.hasErrorOccurred() && Builder)
@@ -262,6 +289,11 @@ namespace {
       }
     }
 
+    void PrintStats() override {
+      if (Builder)
+        Builder->getTypes().PrintStats();
+    }
+
     void AssignInheritanceModel(CXXRecordDecl *RD) override {
       if (Diags.hasErrorOccurred())
         return;
@@ -14,9 +14,14 @@
 #include "clang/Driver/Options.h"
 #include "clang/Driver/ToolChain.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Option/ArgList.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/raw_ostream.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 using namespace clang::driver;
 using namespace clang;
@@ -26,7 +31,7 @@ Compilation::Compilation(const Driver &D, const ToolChain &_DefaultToolChain,
                          InputArgList *_Args, DerivedArgList *_TranslatedArgs)
     : TheDriver(D), DefaultToolChain(_DefaultToolChain), ActiveOffloadMask(0u),
       Args(_Args), TranslatedArgs(_TranslatedArgs), Redirects(nullptr),
-      ForDiagnostics(false) {
+      ForDiagnostics(false), MaxParallelDeviceJobs(1) {
   // The offloading host toolchain is the default tool chain.
   OrderedOffloadingToolchains.insert(
       std::make_pair(Action::OFK_Host, &DefaultToolChain));
@@ -144,8 +149,7 @@ bool Compilation::CleanupFileMap(const ArgStringMap &Files,
   return Success;
 }
 
-int Compilation::ExecuteCommand(const Command &C,
-                                const Command *&FailingCommand) const {
+bool Compilation::PrintCommand(const Command &C) const {
   if ((getDriver().CCPrintOptions ||
        getArgs().hasArg(options::OPT_v)) && !getDriver().CCGenDiagnostics) {
     raw_ostream *OS = &llvm::errs();
@@ -160,9 +164,8 @@ int Compilation::ExecuteCommand(const Command &C,
       if (EC) {
         getDriver().Diag(clang::diag::err_drv_cc_print_options_failure)
             << EC.message();
-        FailingCommand = &C;
         delete OS;
-        return 1;
+        return false;
       }
     }
 
@@ -175,6 +178,16 @@ int Compilation::ExecuteCommand(const Command &C,
       delete OS;
   }
 
+  return true;
+}
+
+int Compilation::ExecuteCommand(const Command &C,
+                                const Command *&FailingCommand) const {
+  if (!PrintCommand(C)) {
+    FailingCommand = &C;
+    return 1;
+  }
+
   std::string Error;
   bool ExecutionFailed;
   int Res = C.Execute(Redirects, &Error, &ExecutionFailed);
@@ -189,9 +202,151 @@ int Compilation::ExecuteCommand(const Command &C,
   return ExecutionFailed ? 1 : Res;
 }
 
+/// Return true if \p Job consumes the output of \p Dep, i.e. if the action
+/// that created \p Dep is reachable from the inputs of the action that created
+/// \p Job.
+static bool dependsOnJob(const Command &Job, const Command &Dep) {
+  const Action *DepSource = &Dep.getSource();
+  const ActionList &Inputs = Job.getSource().getInputs();
+  SmallVector<const Action *, 8> Worklist(Inputs.begin(), Inputs.end());
+  llvm::SmallPtrSet<const Action *, 16> Visited;
+  while (!Worklist.empty()) {
+    const Action *A = Worklist.pop_back_val();
+    if (A == DepSource)
+      return true;
+    if (!Visited.insert(A).second)
+      continue;
+    Worklist.append(A->getInputs().begin(), A->getInputs().end());
+  }
+  return false;
+}
+
+/// Return true if \p Job belongs to the compilation for an offloading device.
+static bool isDeviceJob(const Command &Job) {
+  Action::OffloadKind Kind = Job.getSource().getOffloadingDeviceKind();
+  return Kind != Action::OFK_None && Kind != Action::OFK_Host;
+}
+
+bool Compilation::ExecuteDeviceJobs(
+    ArrayRef<const Command *> Jobs,
+    SmallVectorImpl<std::pair<int, const Command *>> &FailingCommands) const {
+  // Jobs only depend on the jobs that precede them in the list.
+  SmallVector<SmallVector<unsigned, 4>, 8> Dependences(Jobs.size());
+  for (unsigned I = 0, E = Jobs.size(); I < E; ++I)
+    for (unsigned J = 0; J < I; ++J)
+      if (dependsOnJob(*Jobs[I], *Jobs[J]))
+        Dependences[I].push_back(J);
+
+  enum JobStatus { JS_Pending, JS_Running, JS_Done };
+  struct JobResult {
+    int Res = 0;
+    std::string Error;
+    bool ExecutionFailed = false;
+  };
+  SmallVector<JobStatus, 8> Status(Jobs.size(), JS_Pending);
+  SmallVector<JobResult, 8> Results(Jobs.size());
+  std::vector<std::thread> Threads;
+
+  // Jobs completed by the worker threads and not yet processed, guarded by
+  // Mutex. Diagnostics are only emitted from this thread.
+  std::mutex Mutex;
+  std::condition_variable Completed;
+  SmallVector<unsigned, 8> CompletedJobs;
+
+  unsigned NumRunning = 0;
+  bool Failed = false;
+  while (true) {
+    // Stop launching new jobs as soon as one fails, as ExecuteJobs does, but
+    // wait for the running ones to complete.
+    for (unsigned I = 0, E = Jobs.size();
+         !Failed && I < E && NumRunning < MaxParallelDeviceJobs; ++I) {
+      if (Status[I] != JS_Pending ||
+          llvm::any_of(Dependences[I],
+                       [&Status](unsigned J) { return Status[J] != JS_Done; }))
+        continue;
+
+      Status[I] = JS_Running;
+      if (!PrintCommand(*Jobs[I])) {
+        Status[I] = JS_Done;
+        FailingCommands.push_back(std::make_pair(1, Jobs[I]));
+        Failed = true;
+        break;
+      }
+
+      ++NumRunning;
+      Threads.emplace_back([this, I, &Jobs, &Results, &Mutex, &Completed,
+                            &CompletedJobs]() {
+        JobResult &R = Results[I];
+        R.Res = Jobs[I]->Execute(Redirects, &R.Error, &R.ExecutionFailed);
+        std::lock_guard<std::mutex> Lock(Mutex);
+        CompletedJobs.push_back(I);
+        Completed.notify_one();
+      });
+    }
+
+    if (NumRunning == 0)
+      break;
+
+    SmallVector<unsigned, 8> Done;
+    {
+      std::unique_lock<std::mutex> Lock(Mutex);
+      Completed.wait(Lock,
+                     [&CompletedJobs]() { return !CompletedJobs.empty(); });
+      Done.swap(CompletedJobs);
+    }
+
+    for (unsigned I : Done) {
+      --NumRunning;
+      Status[I] = JS_Done;
+      const JobResult &R = Results[I];
+      if (!R.Error.empty()) {
+        assert(R.Res && "Error string set with 0 result code!");
+        getDriver().Diag(clang::diag::err_drv_command_failure) << R.Error;
+      }
+      if (R.Res || R.ExecutionFailed) {
+        FailingCommands.push_back(
+            std::make_pair(R.ExecutionFailed ? 1 : R.Res, Jobs[I]));
+        Failed = true;
+      }
+    }
+  }
+
+  for (auto &T : Threads)
+    T.join();
+
+  return Failed;
+}
+
 void Compilation::ExecuteJobs(
     const JobList &Jobs,
     SmallVectorImpl<std::pair<int, const Command *>> &FailingCommands) const {
+#if LLVM_ENABLE_THREADS
+  // Run the consecutive jobs of the offloading devices concurrently. The
+  // jobs of the host still run one at a time, in order, and wait for all the
+  // device jobs that precede them.
+  if (MaxParallelDeviceJobs > 1) {
+    const JobList::list_type &List = Jobs.getJobs();
+    for (unsigned I = 0, E = List.size(); I < E;) {
+      if (!isDeviceJob(*List[I])) {
+        const Command *FailingCommand = nullptr;
+        if (int Res = ExecuteCommand(*List[I], FailingCommand)) {
+          FailingCommands.push_back(std::make_pair(Res, FailingCommand));
+          return;
+        }
+        ++I;
+        continue;
+      }
+
+      SmallVector<const Command *, 8> DeviceJobs;
+      for (; I < E && isDeviceJob(*List[I]); ++I)
+        DeviceJobs.push_back(List[I].get());
+      if (ExecuteDeviceJobs(DeviceJobs, FailingCommands))
+        return;
+    }
+    return;
+  }
+#endif
+
   for (const auto &Job : Jobs) {
     const Command *FailingCommand = nullptr;
     if (int Res = ExecuteCommand(Job, FailingCommand)) {
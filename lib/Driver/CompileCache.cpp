@@ -0,0 +1,293 @@
+//===--- CompileCache.cpp - Cache of compilation results ------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "CompileCache.h"
+#include "clang/Basic/Version.h"
+#include "clang/Driver/Action.h"
+#include "clang/Driver/Compilation.h"
+#include "clang/Driver/Driver.h"
+#include "clang/Driver/Job.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/Support/Chrono.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Program.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cstdlib> // ::getenv
+
+using namespace clang::driver;
+using namespace clang;
+
+CompileCache::CompileCache(Compilation &C) : C(C) {
+  if (const char *CacheDir = ::getenv("CLANG_COMPILE_CACHE"))
+    Dir = CacheDir;
+}
+
+std::string CompileCache::getEntryPath() const {
+  SmallString<128> Path(Dir);
+  llvm::sys::path::append(Path, Key);
+  return Path.str();
+}
+
+std::string CompileCache::getOutputPath(unsigned I) const {
+  return getEntryPath() + "-" + llvm::utostr(I);
+}
+
+/// Whether a -cc1 job given \p Arg produces or reads files that the key does
+/// not account for, such as dependency files or modules.
+static bool isUncacheableCC1Arg(StringRef Arg) {
+  return llvm::StringSwitch<bool>(Arg)
+      .Cases("-dependency-file", "-header-include-file", true)
+      .Cases("-serialize-diagnostic-file", "-split-dwarf-file", true)
+      .Cases("-opt-record-file", "-femit-coverage-notes", true)
+      .Cases("-include-pch", "-fmodules", true)
+      .StartsWith("-fmodule-file=", true)
+      .StartsWith("-fprofile-instrument-use-path=", true)
+      .StartsWith("-fprofile-sample-use=", true)
+      .StartsWith("-fsanitize-blacklist=", true)
+      .StartsWith("-stats-file=", true)
+      .Default(false);
+}
+
+/// Whether the argument after \p Arg names a file that a -cc1 job reads
+/// besides its inputs.
+static bool isLinkedFileArg(StringRef Arg) {
+  return Arg == "-mlink-bitcode-file" || Arg == "-mlink-cuda-bitcode";
+}
+
+/// Replace the names of temporary files in \p Arg by their position in
+/// \p TempFiles, as they differ between invocations.
+static std::string normalizeArg(StringRef Arg,
+                                ArrayRef<std::string> TempFiles) {
+  StringRef Prefix = Arg, Path = Arg;
+  if (Arg.startswith("-"))
+    std::tie(Prefix, Path) = Arg.split('=');
+  auto I = std::find(TempFiles.begin(), TempFiles.end(), Path);
+  if (I == TempFiles.end())
+    return Arg;
+  std::string Result = Prefix == Path ? "" : (Prefix + "=").str();
+  return Result + "<temp " + llvm::utostr(I - TempFiles.begin()) + ">";
+}
+
+/// Run \p Job as a preprocessor-only job and return its output in
+/// \p Contents. Returns false if it cannot be run that way or fails; its
+/// diagnostics are discarded, as the job itself will report them.
+bool CompileCache::preprocess(const Command &Job, std::string &Contents) {
+  const ArgStringList &Arguments = Job.getArguments();
+  SmallVector<const char *, 128> Argv;
+  Argv.push_back(Job.getExecutable());
+  bool HasAction = false;
+  for (size_t I = 0, E = Arguments.size(); I != E; ++I) {
+    StringRef Arg = Arguments[I];
+    if (Arg == "-emit-obj" || Arg == "-emit-llvm-bc" || Arg == "-emit-llvm" ||
+        Arg == "-S") {
+      if (HasAction)
+        return false;
+      HasAction = true;
+      Argv.push_back("-E");
+      continue;
+    }
+    // The output is replaced below. The files that only code generation
+    // reads may not exist yet, as an earlier job produces them.
+    if (Arg == "-o" || Arg == "-fopenmp-host-ir-file-path" ||
+        Arg == "-fcuda-include-gpubinary") {
+      ++I;
+      continue;
+    }
+    Argv.push_back(Arguments[I]);
+  }
+  if (!HasAction)
+    return false;
+
+  std::string OutputPath =
+      C.getDriver().GetTemporaryPath("preprocessed", "i");
+  const char *Output = C.addTempFile(C.getArgs().MakeArgString(OutputPath));
+  Argv.push_back("-o");
+  Argv.push_back(Output);
+  Argv.push_back(nullptr);
+
+  StringRef Empty;
+  const StringRef *Redirects[] = {nullptr, &Empty, &Empty};
+  if (llvm::sys::ExecuteAndWait(Job.getExecutable(), Argv.data(),
+                                /*env*/ nullptr, Redirects) != 0)
+    return false;
+
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> File =
+      llvm::MemoryBuffer::getFile(Output);
+  if (!File)
+    return false;
+  Contents = (*File)->getBuffer();
+  return true;
+}
+
+bool CompileCache::computeKey() {
+  const Driver &D = C.getDriver();
+  if (!isEnabled() || D.isSaveTempsEnabled() || D.CCGenDiagnostics)
+    return false;
+
+  for (const auto &Result : C.getResultFiles()) {
+    if (StringRef(Result.second) == "-")
+      return false;
+    Outputs.push_back(Result.second);
+  }
+  if (Outputs.empty())
+    return false;
+  std::sort(Outputs.begin(), Outputs.end());
+
+  // Every file a job reads is either produced by an earlier job, and thus
+  // accounted for by its command line, or hashed here.
+  std::vector<std::string> TempFiles(C.getTempFiles().begin(),
+                                     C.getTempFiles().end());
+  llvm::StringSet<> Produced;
+  for (const std::string &File : TempFiles)
+    Produced.insert(File);
+  for (const std::string &File : Outputs)
+    Produced.insert(File);
+
+  llvm::MD5 Hash;
+  auto Add = [&](StringRef Data) {
+    Hash.update(Data);
+    Hash.update(StringRef("", 1));
+  };
+  Add(getClangFullVersion());
+
+  for (const Command &Job : C.getJobs()) {
+    // The libraries a link reads are not known here.
+    if (isa<LinkJobAction>(Job.getSource()))
+      return false;
+
+    const ArgStringList &Arguments = Job.getArguments();
+    bool IsCC1 = StringRef(Job.getExecutable()) == D.getClangProgramPath() &&
+                 !Arguments.empty() && StringRef(Arguments[0]) == "-cc1";
+
+    // Tell the other tools apart by the size and age of their executable.
+    Add(Job.getExecutable());
+    if (!IsCC1) {
+      llvm::sys::fs::file_status Status;
+      if (llvm::sys::fs::status(Job.getExecutable(), Status))
+        return false;
+      Add(llvm::utostr(Status.getSize()));
+      Add(llvm::utostr(
+          llvm::sys::toTimeT(Status.getLastModificationTime())));
+    }
+
+    for (size_t I = 0, E = Arguments.size(); I != E; ++I) {
+      StringRef Arg = Arguments[I];
+      if (IsCC1 && isUncacheableCC1Arg(Arg))
+        return false;
+      Add(normalizeArg(Arg, TempFiles));
+      if (IsCC1 && isLinkedFileArg(Arg) && I + 1 != E &&
+          !Produced.count(Arguments[I + 1])) {
+        llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> File =
+            llvm::MemoryBuffer::getFile(Arguments[I + 1]);
+        if (!File)
+          return false;
+        Add((*File)->getBuffer());
+      }
+    }
+
+    // A -cc1 job that reads a source file is accounted for by its
+    // preprocessed output, which includes its headers.
+    bool ReadsSource = false;
+    for (const char *Input : Job.getInputFilenames()) {
+      if (Produced.count(Input))
+        continue;
+      if (!IsCC1)
+        return false;
+      ReadsSource = true;
+    }
+    if (ReadsSource) {
+      std::string Contents;
+      if (!preprocess(Job, Contents))
+        return false;
+      Add(Contents);
+    }
+  }
+
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Name;
+  llvm::MD5::stringifyResult(Result, Name);
+  Key = Name.str();
+  return true;
+}
+
+// An entry is a text file listing the outputs of the compilation, one per
+// line. The Nth output is stored next to it, with the suffix "-N".
+bool CompileCache::replay() const {
+  if (Key.empty())
+    return false;
+
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> File =
+      llvm::MemoryBuffer::getFile(getEntryPath());
+  if (!File)
+    return false;
+
+  SmallVector<StringRef, 4> Lines;
+  (*File)->getBuffer().split(Lines, '\n', /*MaxSplit=*/-1,
+                             /*KeepEmpty=*/false);
+  if (Lines.size() != Outputs.size() ||
+      !std::equal(Lines.begin(), Lines.end(), Outputs.begin()))
+    return false;
+
+  for (unsigned I = 0, E = Outputs.size(); I != E; ++I)
+    if (llvm::sys::fs::copy_file(getOutputPath(I), Outputs[I]))
+      return false;
+  return true;
+}
+
+void CompileCache::store() const {
+  if (Key.empty() || llvm::sys::fs::create_directories(Dir))
+    return;
+
+  // Write each file to a temporary file and rename it into place, so that
+  // concurrent invocations never read a partial entry. The entry itself is
+  // written last, once all the outputs are in place.
+  auto Install = [](StringRef Path,
+                    llvm::function_ref<bool(StringRef)> Write) {
+    SmallString<128> TempPath;
+    if (llvm::sys::fs::createUniqueFile(Path + "-%%%%%%%%", TempPath))
+      return false;
+    if (!Write(TempPath) || llvm::sys::fs::rename(TempPath, Path)) {
+      llvm::sys::fs::remove(TempPath);
+      return false;
+    }
+    return true;
+  };
+
+  for (unsigned I = 0, E = Outputs.size(); I != E; ++I) {
+    const std::string &Output = Outputs[I];
+    if (!Install(getOutputPath(I), [&](StringRef TempPath) {
+          return !llvm::sys::fs::copy_file(Output, TempPath);
+        }))
+      return;
+  }
+
+  Install(getEntryPath(), [&](StringRef TempPath) {
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(TempPath, EC, llvm::sys::fs::F_Text);
+    if (EC)
+      return false;
+    for (const std::string &Output : Outputs)
+      OS << Output << '\n';
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      return false;
+    }
+    return true;
+  });
+}
@@ -0,0 +1,69 @@
+//===--- CompileCache.h - Cache of compilation results ----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LIB_DRIVER_COMPILECACHE_H
+#define LLVM_CLANG_LIB_DRIVER_COMPILECACHE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/StringRef.h"
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace driver {
+class Command;
+class Compilation;
+
+/// CompileCache - A cache of the files a compilation produces, shared by the
+/// driver invocations that name the same cache directory in the
+/// CLANG_COMPILE_CACHE environment variable.
+///
+/// The key of a compilation hashes the command lines of all of its jobs and
+/// the preprocessed source of each -cc1 job, so the jobs that an offloading
+/// compilation runs for each device, and the bundling of their outputs, are
+/// all covered by one entry, and are only run when it misses.
+class CompileCache {
+  Compilation &C;
+
+  /// The cache directory, or empty if the cache is disabled.
+  std::string Dir;
+
+  /// The hash of the compilation, once computed.
+  std::string Key;
+
+  /// The files the compilation produces, sorted.
+  std::vector<std::string> Outputs;
+
+  bool preprocess(const Command &Job, std::string &Contents);
+
+  std::string getEntryPath() const;
+  std::string getOutputPath(unsigned I) const;
+
+public:
+  explicit CompileCache(Compilation &C);
+
+  bool isEnabled() const { return !Dir.empty(); }
+
+  /// Compute the key of the compilation. Returns false if it cannot be
+  /// cached, for example because one of its jobs writes a file that is not
+  /// one of its results, or reads one that the key cannot account for.
+  bool computeKey();
+
+  /// Copy the cached results into place. Returns false on a miss.
+  bool replay() const;
+
+  /// Store the results of the compilation, which has just succeeded.
+  /// Failing to write the cache is not an error.
+  void store() const;
+};
+
+} // end namespace driver
+} // end namespace clang
+
+#endif
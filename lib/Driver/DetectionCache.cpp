@@ -0,0 +1,119 @@
+//===--- DetectionCache.cpp - Cache of toolchain detection results --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "DetectionCache.h"
+#include "clang/Basic/VirtualFileSystem.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Chrono.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstdlib> // ::getenv
+
+using namespace clang::driver;
+using namespace clang;
+
+DetectionCache::DetectionCache(vfs::FileSystem &FS) : FS(FS) {
+  if (const char *CacheDir = ::getenv("CLANG_DETECTION_CACHE"))
+    Dir = CacheDir;
+}
+
+std::string DetectionCache::getEntryPath(StringRef Key) const {
+  llvm::MD5 Hash;
+  Hash.update(Key);
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Name;
+  llvm::MD5::stringifyResult(Result, Name);
+
+  SmallString<128> Path(Dir);
+  llvm::sys::path::append(Path, Name);
+  return Path.str();
+}
+
+/// Get the modification time of \p Path, or -1 if it does not exist.
+static long long getModificationTime(vfs::FileSystem &FS, StringRef Path) {
+  llvm::ErrorOr<vfs::Status> Status = FS.status(Path);
+  if (!Status)
+    return -1;
+  return llvm::sys::toTimeT(Status->getLastModificationTime());
+}
+
+// An entry is a text file with one line per item: the key, then the watched
+// paths with their modification times, then the values.
+bool DetectionCache::lookup(StringRef Key,
+                            std::vector<std::string> &Values) const {
+  if (!isEnabled())
+    return false;
+
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> File =
+      llvm::MemoryBuffer::getFile(getEntryPath(Key));
+  if (!File)
+    return false;
+
+  SmallVector<StringRef, 16> Lines;
+  (*File)->getBuffer().split(Lines, '\n', /*MaxSplit=*/-1,
+                             /*KeepEmpty=*/false);
+  if (Lines.empty() || Lines[0] != ("key " + Key).str())
+    return false;
+
+  std::vector<std::string> Result;
+  for (StringRef Line : llvm::makeArrayRef(Lines).slice(1)) {
+    if (Line.consume_front("watch ")) {
+      StringRef Time, Path;
+      std::tie(Time, Path) = Line.split(' ');
+      long long StoredTime;
+      if (Time.getAsInteger(10, StoredTime) ||
+          getModificationTime(FS, Path) != StoredTime)
+        return false;
+    } else if (Line.consume_front("value ")) {
+      Result.push_back(Line);
+    } else {
+      return false;
+    }
+  }
+
+  Values = std::move(Result);
+  return true;
+}
+
+void DetectionCache::store(StringRef Key, ArrayRef<std::string> Values,
+                           ArrayRef<std::string> Watched) const {
+  if (!isEnabled() || llvm::sys::fs::create_directories(Dir))
+    return;
+
+  // Write the entry to a temporary file and rename it into place, so that
+  // concurrent invocations never read a partial entry.
+  std::string EntryPath = getEntryPath(Key);
+  int FD;
+  SmallString<128> TempPath;
+  if (llvm::sys::fs::createUniqueFile(EntryPath + "-%%%%%%%%", FD, TempPath))
+    return;
+
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << "key " << Key << '\n';
+    for (const std::string &Path : Watched)
+      OS << "watch " << getModificationTime(FS, Path) << ' ' << Path << '\n';
+    for (const std::string &Value : Values)
+      OS << "value " << Value << '\n';
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      llvm::sys::fs::remove(TempPath);
+      return;
+    }
+  }
+
+  if (llvm::sys::fs::rename(TempPath, EntryPath))
+    llvm::sys::fs::remove(TempPath);
+}
@@ -0,0 +1,57 @@
+//===--- DetectionCache.h - Cache of toolchain detection results -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LIB_DRIVER_DETECTIONCACHE_H
+#define LLVM_CLANG_LIB_DRIVER_DETECTIONCACHE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/StringRef.h"
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace vfs {
+class FileSystem;
+}
+
+namespace driver {
+
+/// DetectionCache - A cache of the results of probing the file system for
+/// toolchain installations, shared by the driver invocations that name the
+/// same cache directory in the CLANG_DETECTION_CACHE environment variable.
+///
+/// Each entry maps a key, which describes what was probed for, to a list of
+/// values. It also records the modification times of the directories that
+/// the result depends on, and is out of date once any of them changes.
+class DetectionCache {
+  vfs::FileSystem &FS;
+
+  /// The cache directory, or empty if the cache is disabled.
+  std::string Dir;
+
+  std::string getEntryPath(StringRef Key) const;
+
+public:
+  explicit DetectionCache(vfs::FileSystem &FS);
+
+  bool isEnabled() const { return !Dir.empty(); }
+
+  /// Find the values stored for \p Key, if they are still up to date.
+  bool lookup(StringRef Key, std::vector<std::string> &Values) const;
+
+  /// Store \p Values for \p Key, valid until one of \p Watched is created,
+  /// removed or modified. Failing to write the cache is not an error.
+  void store(StringRef Key, ArrayRef<std::string> Values,
+             ArrayRef<std::string> Watched) const;
+};
+
+} // end namespace driver
+} // end namespace clang
+
+#endif
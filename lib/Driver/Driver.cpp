@@ -8,6 +8,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Driver/Driver.h"
+#include "CompileCache.h"
 #include "InputInfo.h"
 #include "ToolChains.h"
 #include "clang/Basic/Version.h"
@@ -60,7 +61,8 @@ Driver::Driver(StringRef ClangExecutable, StringRef DefaultTargetTriple,
       DriverTitle("clang LLVM compiler"), CCPrintOptionsFilename(nullptr),
       CCPrintHeadersFilename(nullptr), CCLogDiagnosticsFilename(nullptr),
       CCCPrintBindings(false), CCPrintHeaders(false), CCLogDiagnostics(false),
-      CCGenDiagnostics(false), DefaultTargetTriple(DefaultTargetTriple),
+      CCGenDiagnostics(false), CC1InProcess(false), CC1Main(nullptr),
+      DefaultTargetTriple(DefaultTargetTriple),
       CCCGenericGCCName(""), CheckInputsExist(true), CCCUsePCH(true),
       SuppressMissingInputWarning(false) {
 
@@ -548,6 +550,19 @@ void Driver::CreateOffloadingDeviceToolChains(Compilation &C,
             C.addOffloadDeviceToolChain(TC, Action::OFK_OpenMP);
           }
         }
+
+        // The jobs of the different devices are independent from each other,
+        // so they may run concurrently.
+        if (Arg *A = C.getInputArgs().getLastArg(
+                options::OPT_fopenmp_device_jobs_EQ)) {
+          unsigned MaxJobs;
+          StringRef Val = A->getValue();
+          if (Val.getAsInteger(10, MaxJobs) || MaxJobs == 0)
+            Diag(clang::diag::err_drv_invalid_int_value)
+                << A->getAsString(C.getInputArgs()) << Val;
+          else
+            C.setMaxParallelDeviceJobs(MaxJobs);
+        }
       } else
         Diag(clang::diag::err_drv_expecting_fopenmp_with_fopenmp_targets);
     } else
@@ -607,6 +622,9 @@ Compilation *Driver::BuildCompilation(ArrayRef<const char *> ArgList) {
   // or -b.
   CCCPrintPhases = Args.hasArg(options::OPT_ccc_print_phases);
   CCCPrintBindings = Args.hasArg(options::OPT_ccc_print_bindings);
+  CC1InProcess = CC1Main && Args.hasFlag(options::OPT_fintegrated_cc1,
+                                         options::OPT_fno_integrated_cc1,
+                                         false);
   if (const Arg *A = Args.getLastArg(options::OPT_ccc_gcc_name))
     CCCGenericGCCName = A->getValue();
   CCCUsePCH =
@@ -1022,14 +1040,24 @@ int Driver::ExecuteCompilation(
   for (auto &Job : C.getJobs())
     setUpResponseFiles(C, Job);
 
+  // Reuse the results of an identical compilation if there is one in the
+  // cache, and only run the jobs otherwise.
+  CompileCache Cache(C);
+  if (Cache.isEnabled() && Cache.computeKey() && Cache.replay()) {
+    C.CleanupFileList(C.getTempFiles());
+    return 0;
+  }
+
   C.ExecuteJobs(C.getJobs(), FailingCommands);
 
   // Remove temp files.
   C.CleanupFileList(C.getTempFiles());
 
   // If the command succeeded, we are done.
-  if (FailingCommands.empty())
+  if (FailingCommands.empty()) {
+    Cache.store();
     return 0;
+  }
 
   // Otherwise, remove result files and print extra information about abnormal
   // failures.
@@ -19,6 +19,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/StringSwitch.h"
+#include "llvm/Support/CrashRecoveryContext.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Program.h"
@@ -305,6 +306,25 @@ int Command::Execute(const StringRef **Redirects, std::string *ErrMsg,
                      bool *ExecutionFailed) const {
   SmallVector<const char*, 128> Argv;
 
+  // Run the integrated tools in this process if asked to. Neither a response
+  // file nor redirects are needed for that, so jobs with redirects (which
+  // are for crash reproduction) still get a process of their own.
+  const Driver &D = Creator.getToolChain().getDriver();
+  if (D.CC1InProcess && !Redirects && !Arguments.empty() &&
+      StringRef(Arguments[0]).startswith("-cc1") &&
+      StringRef(Executable) == D.getClangProgramPath()) {
+    Argv.push_back(Executable);
+    Argv.append(Arguments.begin(), Arguments.end());
+
+    // Report a crash the way ExecuteAndWait would, so that the driver still
+    // generates the crash diagnostics.
+    llvm::CrashRecoveryContext::Enable();
+    llvm::CrashRecoveryContext CRC;
+    int Res = -2;
+    CRC.RunSafely([&]() { Res = D.CC1Main(Argv); });
+    return Res;
+  }
+
   if (ResponseFile == nullptr) {
     Argv.push_back(Executable);
     Argv.append(Arguments.begin(), Arguments.end());
@@ -8,6 +8,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "ToolChains.h"
+#include "DetectionCache.h"
 #include "clang/Basic/Cuda.h"
 #include "clang/Basic/ObjCRuntime.h"
 #include "clang/Basic/Version.h"
@@ -1471,9 +1472,50 @@ void Generic_GCC::GCCInstallationDetector::init(
     }
   }
 
+  // The search of the prefixes below is what the detection cache saves. Its
+  // result depends on the target, the prefixes and the flags that select the
+  // multilibs. The Solaris layout is not cached.
+  Version = GCCVersion::Parse("0.0.0");
+  DetectionCache Cache(D.getVFS());
+  std::string CacheKey;
+  if (Cache.isEnabled() && TargetTriple.getOS() != llvm::Triple::Solaris) {
+    llvm::raw_string_ostream OS(CacheKey);
+    OS << "gcc " << TargetTriple.str();
+    for (StringRef Candidate : ExtraTripleAliases)
+      OS << ' ' << Candidate;
+    for (const std::string &Prefix : Prefixes)
+      OS << ' ' << Prefix;
+    for (const Arg *A : Args.filtered(options::OPT_m_Group,
+                                      options::OPT_mlittle_endian,
+                                      options::OPT_mbig_endian))
+      OS << ' ' << A->getAsString(Args);
+    OS.flush();
+
+    // The selected installation is checked again, which also detects its
+    // multilibs.
+    std::vector<std::string> Cached;
+    if (Cache.lookup(CacheKey, Cached) && Cached.size() >= 5 &&
+        (Cached[0].empty() ||
+         ScanGCCForMultilibs(TargetTriple, Args, Cached[1],
+                             Cached[4] == "1"))) {
+      if (!Cached[0].empty()) {
+        GCCTriple.setTriple(Cached[0]);
+        GCCInstallPath = Cached[1];
+        GCCParentLibPath = Cached[2];
+        Version = GCCVersion::Parse(Cached[3]);
+        NeedsBiarchSuffix = Cached[4] == "1";
+        IsValid = true;
+      }
+      CandidateGCCInstallPaths.insert(Cached.begin() + 5, Cached.end());
+      return;
+    }
+  }
+
+  // The directories whose contents decide which installation is selected.
+  std::vector<std::string> Watched(Prefixes.begin(), Prefixes.end());
+
   // Loop over the various components which exist and select the best GCC
   // installation available. GCC installs are ranked by version number.
-  Version = GCCVersion::Parse("0.0.0");
   for (const std::string &Prefix : Prefixes) {
     if (!D.getVFS().exists(Prefix))
       continue;
@@ -1481,6 +1523,7 @@ void Generic_GCC::GCCInstallationDetector::init(
       const std::string LibDir = Prefix + Suffix.str();
       if (!D.getVFS().exists(LibDir))
         continue;
+      Watched.push_back(LibDir);
       for (StringRef Candidate : ExtraTripleAliases) // Try these first.
         ScanLibDirForGCCTriple(TargetTriple, Args, LibDir, Candidate);
       for (StringRef Candidate : CandidateTripleAliases)
@@ -1490,11 +1533,32 @@ void Generic_GCC::GCCInstallationDetector::init(
       const std::string LibDir = Prefix + Suffix.str();
       if (!D.getVFS().exists(LibDir))
         continue;
+      Watched.push_back(LibDir);
       for (StringRef Candidate : CandidateBiarchTripleAliases)
         ScanLibDirForGCCTriple(TargetTriple, Args, LibDir, Candidate,
                                /*NeedsBiarchSuffix=*/ true);
     }
   }
+
+  if (CacheKey.empty())
+    return;
+
+  std::vector<std::string> Values;
+  if (IsValid) {
+    Values.push_back(GCCTriple.str());
+    Values.push_back(GCCInstallPath);
+    Values.push_back(GCCParentLibPath);
+    Values.push_back(Version.Text);
+    Values.push_back(NeedsBiarchSuffix ? "1" : "0");
+    // A newer version installed next to the selected one must be noticed.
+    Watched.push_back(llvm::sys::path::parent_path(GCCInstallPath));
+    Watched.push_back(GCCInstallPath);
+  } else {
+    Values.resize(5);
+  }
+  Values.insert(Values.end(), CandidateGCCInstallPaths.begin(),
+                CandidateGCCInstallPaths.end());
+  Cache.store(CacheKey, Values, Watched);
 }
 
 void Generic_GCC::GCCInstallationDetector::print(raw_ostream &OS) const {
@@ -2852,6 +2916,7 @@ void Generic_GCC::GCCInstallationDetector::ScanLibDirForGCCTriple(
       GCCInstallPath =
           LibDir + LibAndInstallSuffixes[i][0] + "/" + VersionText.str();
       GCCParentLibPath = GCCInstallPath + LibAndInstallSuffixes[i][1];
+      this->NeedsBiarchSuffix = NeedsBiarchSuffix;
       IsValid = true;
     }
   }
@@ -147,6 +147,9 @@ public:
 
     GCCVersion Version;
 
+    /// Whether the detected installation was found through a biarch triple.
+    bool NeedsBiarchSuffix;
+
     // We retain the list of install paths that were considered and rejected in
     // order to print out detailed information in verbose mode.
     std::set<std::string> CandidateGCCInstallPaths;
@@ -155,7 +158,8 @@ public:
     MultilibSet Multilibs;
 
   public:
-    explicit GCCInstallationDetector(const Driver &D) : IsValid(false), D(D) {}
+    explicit GCCInstallationDetector(const Driver &D)
+        : IsValid(false), D(D), NeedsBiarchSuffix(false) {}
     void init(const llvm::Triple &TargetTriple, const llvm::opt::ArgList &Args,
               ArrayRef<std::string> ExtraTripleAliases = None);
 
@@ -283,6 +283,188 @@ static void AddLinkerInputs(const ToolChain &TC, const InputInfoList &Inputs,
     addDirectoryList(Args, CmdArgs, "-L", "LIBRARY_PATH");
 }
 
+/// Collect the normalized triple and the file name of each of the OpenMP device
+/// images that are inputs of the host link.
+static void getOpenMPDeviceImages(
+    Compilation &C, const InputInfoList &Inputs,
+    SmallVectorImpl<std::pair<std::string, const char *>> &Images) {
+  // Get the OpenMP offload tool chains so that we can extract the triple
+  // associated with each device input.
+  auto OpenMPToolChains = C.getOffloadToolChains<Action::OFK_OpenMP>();
+  assert(OpenMPToolChains.first != OpenMPToolChains.second &&
+         "No OpenMP toolchains??");
+
+  auto DTC = OpenMPToolChains.first;
+  for (auto &II : Inputs) {
+    const Action *A = II.getAction();
+    // Is this a device linking action?
+    if (A && isa<LinkJobAction>(A) &&
+        A->isDeviceOffloading(Action::OFK_OpenMP)) {
+      assert(DTC != OpenMPToolChains.second &&
+             "More device inputs than device toolchains??");
+      Images.push_back(std::make_pair(DTC->second->getTriple().normalize(),
+                                      II.getFilename()));
+      ++DTC;
+    }
+  }
+
+  assert(DTC == OpenMPToolChains.second &&
+         "Less device inputs than device toolchains??");
+}
+
+/// Return true if the OpenMP device images should be embedded into the host
+/// binary with wrapper objects rather than with a linker script.
+static bool useOpenMPWrapperObjects(const ToolChain &TC, const ArgList &Args,
+                                    const JobAction &JA) {
+  return JA.isHostOffloading(Action::OFK_OpenMP) &&
+         TC.getTriple().isOSBinFormatELF() &&
+         Args.hasFlag(options::OPT_fopenmp_offload_wrapper_objects,
+                      options::OPT_fnoopenmp_offload_wrapper_objects,
+                      /*Default=*/false);
+}
+
+/// Assemble \p Source, written to a temporary file with the name of \p Output
+/// and suffix \p Suffix, with the integrated assembler of the host. Return the
+/// name of the resulting object.
+static const char *AssembleOpenMPWrapperObject(
+    const Tool &T, Compilation &C, const InputInfo &Output,
+    const InputInfoList &Inputs, const ArgList &Args, const JobAction &JA,
+    StringRef Suffix, StringRef Source) {
+  const Driver &D = C.getDriver();
+
+  // Create the temporary source and object names. Keep them if save-temps is
+  // enabled.
+  SmallString<256> Name = llvm::sys::path::filename(Output.getFilename());
+  llvm::sys::path::replace_extension(Name, "");
+  Name += Suffix;
+  const char *SourceName;
+  const char *ObjectName;
+  if (D.isSaveTempsEnabled()) {
+    SourceName = C.getArgs().MakeArgString(Name + ".s");
+    ObjectName = C.getArgs().MakeArgString(Name + ".o");
+  } else {
+    SourceName =
+        C.addTempFile(C.getArgs().MakeArgString(D.GetTemporaryPath(Name, "s")));
+    ObjectName =
+        C.addTempFile(C.getArgs().MakeArgString(D.GetTemporaryPath(Name, "o")));
+  }
+
+  // Dump the contents of the wrapper if the user requested that. We support
+  // this option to enable testing of behavior with -###.
+  if (C.getArgs().hasArg(options::OPT_fopenmp_dump_offload_linker_script))
+    llvm::errs() << Source;
+
+  // If this is not a dry run, write the wrapper source.
+  if (!C.getArgs().hasArg(options::OPT__HASH_HASH_HASH)) {
+    std::error_code EC;
+    llvm::raw_fd_ostream SourceFile(SourceName, EC, llvm::sys::fs::F_None);
+    if (EC) {
+      D.Diag(clang::diag::err_unable_to_make_temp) << EC.message();
+      return ObjectName;
+    }
+    SourceFile << Source;
+  }
+
+  ArgStringList AsArgs;
+  AsArgs.push_back("-cc1as");
+  AsArgs.push_back("-triple");
+  AsArgs.push_back(Args.MakeArgString(T.getToolChain().getTripleString()));
+  AsArgs.push_back("-filetype");
+  AsArgs.push_back("obj");
+  AsArgs.push_back("-o");
+  AsArgs.push_back(ObjectName);
+  AsArgs.push_back(SourceName);
+
+  const char *Exec = Args.MakeArgString(D.getClangProgramPath());
+  C.addCommand(llvm::make_unique<Command>(JA, T, Exec, AsArgs, Inputs));
+  return ObjectName;
+}
+
+/// Add the object that marks the beginning of the OpenMP host entries table.
+/// It has to precede any other input of the host link, so that its empty
+/// entries section is placed first.
+static void AddOpenMPWrapperBeginObject(const Tool &T, Compilation &C,
+                                        const InputInfo &Output,
+                                        const InputInfoList &Inputs,
+                                        const ArgList &Args,
+                                        ArgStringList &CmdArgs,
+                                        const JobAction &JA) {
+  std::string Source;
+  llvm::raw_string_ostream OS(Source);
+  OS << "# OpenMP offload wrapper, automatically generated by Clang.\n";
+  OS << "  .section .omp_offloading.entries,\"a\",@progbits\n";
+  OS << "  .p2align 4\n";
+  OS << "  .globl \".omp_offloading.entries_begin\"\n";
+  OS << "  .hidden \".omp_offloading.entries_begin\"\n";
+  OS << "\".omp_offloading.entries_begin\":\n";
+  OS.flush();
+
+  CmdArgs.push_back(AssembleOpenMPWrapperObject(
+      T, C, Output, Inputs, Args, JA, "-omp-wrapper-begin", Source));
+}
+
+/// Add the object that holds the OpenMP device images and marks the end of the
+/// OpenMP host entries table. It has to follow any other input of the host
+/// link, so that its empty entries section is placed last. The images are
+/// embedded the same way the linker script does, with the same symbols
+/// delimiting each of them.
+static void AddOpenMPWrapperEndObject(const Tool &T, Compilation &C,
+                                      const InputInfo &Output,
+                                      const InputInfoList &Inputs,
+                                      const ArgList &Args,
+                                      ArgStringList &CmdArgs,
+                                      const JobAction &JA) {
+  SmallVector<std::pair<std::string, const char *>, 8> InputBinaryInfo;
+  getOpenMPDeviceImages(C, Inputs, InputBinaryInfo);
+
+  std::string Source;
+  llvm::raw_string_ostream OS(Source);
+  OS << "# OpenMP offload wrapper, automatically generated by Clang.\n";
+  OS << "  .section .omp_offloading.entries,\"a\",@progbits\n";
+  OS << "  .globl \".omp_offloading.entries_end\"\n";
+  OS << "  .hidden \".omp_offloading.entries_end\"\n";
+  OS << "\".omp_offloading.entries_end\":\n";
+
+  for (const auto &BI : InputBinaryInfo) {
+    std::string Start = ".omp_offloading.img_start." + BI.first;
+    std::string End = ".omp_offloading.img_end." + BI.first;
+    OS << "  .section \".omp_offloading." << BI.first << "\",\"a\",@progbits\n";
+    OS << "  .p2align 4\n";
+    OS << "  .globl \"" << Start << "\"\n";
+    OS << "  .hidden \"" << Start << "\"\n";
+    OS << "\"" << Start << "\":\n";
+    OS << "  .incbin \"" << BI.second << "\"\n";
+    OS << "  .globl \"" << End << "\"\n";
+    OS << "  .hidden \"" << End << "\"\n";
+    OS << "\"" << End << "\":\n";
+  }
+
+  // The bitcode of the device code of each translation unit follows the
+  // previous one, behind a wrapper header with its size.
+  for (const auto &BI : InputBinaryInfo) {
+    const ArgStringList *Bitcode = C.getOpenMPDeviceBitcodeFiles(BI.first);
+    if (!Bitcode)
+      continue;
+    std::string Start = ".omp_offloading.bitcode_start." + BI.first;
+    std::string End = ".omp_offloading.bitcode_end." + BI.first;
+    OS << "  .section \".omp_offloading.bitcode." << BI.first
+       << "\",\"a\",@progbits\n";
+    OS << "  .p2align 4\n";
+    OS << "  .globl \"" << Start << "\"\n";
+    OS << "  .hidden \"" << Start << "\"\n";
+    OS << "\"" << Start << "\":\n";
+    for (const char *File : *Bitcode)
+      OS << "  .incbin \"" << File << "\"\n";
+    OS << "  .globl \"" << End << "\"\n";
+    OS << "  .hidden \"" << End << "\"\n";
+    OS << "\"" << End << "\":\n";
+  }
+  OS.flush();
+
+  CmdArgs.push_back(AssembleOpenMPWrapperObject(
+      T, C, Output, Inputs, Args, JA, "-omp-wrapper-end", Source));
+}
+
 /// Add OpenMP linker script arguments at the end of the argument list so that
 /// the fat binary is built by embedding each of the device images into the
 /// host. The linker script also defines a few symbols required by the code
@@ -319,15 +501,10 @@ static void AddOpenMPLinkerScript(const ToolChain &TC, Compilation &C,
   std::string LksBuffer;
   llvm::raw_string_ostream LksStream(LksBuffer);
 
-  // Get the OpenMP offload tool chains so that we can extract the triple
-  // associated with each device input.
-  auto OpenMPToolChains = C.getOffloadToolChains<Action::OFK_OpenMP>();
-  assert(OpenMPToolChains.first != OpenMPToolChains.second &&
-         "No OpenMP toolchains??");
-
   // Track the input file name and device triple in order to build the script,
   // inserting binaries in the designated sections.
   SmallVector<std::pair<std::string, const char *>, 8> InputBinaryInfo;
+  getOpenMPDeviceImages(C, Inputs, InputBinaryInfo);
 
   // Add commands to embed target binaries. We ensure that each section and
   // image is 16-byte aligned. This is not mandatory, but increases the
@@ -338,24 +515,13 @@ static void AddOpenMPLinkerScript(const ToolChain &TC, Compilation &C,
   LksStream << " *** Automatically generated by Clang ***\n";
   LksStream << "*/\n";
   LksStream << "TARGET(binary)\n";
-  auto DTC = OpenMPToolChains.first;
-  for (auto &II : Inputs) {
-    const Action *A = II.getAction();
-    // Is this a device linking action?
-    if (A && isa<LinkJobAction>(A) &&
-        A->isDeviceOffloading(Action::OFK_OpenMP)) {
-      assert(DTC != OpenMPToolChains.second &&
-             "More device inputs than device toolchains??");
-      InputBinaryInfo.push_back(std::make_pair(
-          DTC->second->getTriple().normalize(), II.getFilename()));
-      ++DTC;
-      LksStream << "INPUT(" << II.getFilename() << ")\n";
-    }
+  for (const auto &BI : InputBinaryInfo) {
+    LksStream << "INPUT(" << BI.second << ")\n";
+    if (const ArgStringList *Bitcode = C.getOpenMPDeviceBitcodeFiles(BI.first))
+      for (const char *File : *Bitcode)
+        LksStream << "INPUT(" << File << ")\n";
   }
 
-  assert(DTC == OpenMPToolChains.second &&
-         "Less device inputs than device toolchains??");
-
   LksStream << "SECTIONS\n";
   LksStream << "{\n";
 
@@ -370,7 +536,22 @@ static void AddOpenMPLinkerScript(const ToolChain &TC, Compilation &C,
     LksStream << "    PROVIDE_HIDDEN(.omp_offloading.img_end." << BI.first
               << " = .);\n";
     LksStream << "  }\n";
-  }
+
+    // The bitcode of the device code of each translation unit follows the
+    // previous one, behind a wrapper header with its size.
+    const ArgStringList *Bitcode = C.getOpenMPDeviceBitcodeFiles(BI.first);
+    if (!Bitcode)
+      continue;
+    LksStream << "  .omp_offloading.bitcode." << BI.first << " :\n";
+    LksStream << "  ALIGN(0x10)\n";
+    LksStream << "  {\n";
+    LksStream << "    PROVIDE_HIDDEN(.omp_offloading.bitcode_start." << BI.first
+              << " = .);\n";
+    for (const char *File : *Bitcode)
+      LksStream << "    " << File << "\n";
+    LksStream << "    PROVIDE_HIDDEN(.omp_offloading.bitcode_end." << BI.first
+              << " = .);\n";
+    LksStream << "  }\n";
 
   // Add commands to define host entries begin and end. We use 1-byte subalign
   // so that the linker does not add any padding and the elements in this
@@ -3704,6 +3885,7 @@ static void addPGOAndCoverageFlags(Compilation &C, const Driver &D,
                                            ProfileGenerateArg->getValue()));
     // The default is to use Clang Instrumentation.
     CmdArgs.push_back("-fprofile-instrument=clang");
+    Args.AddLastArg(CmdArgs, options::OPT_fprofile_instr_sample_period_EQ);
   }
 
   if (PGOGenerateArg) {
@@ -3750,8 +3932,12 @@ static void addPGOAndCoverageFlags(Compilation &C, const Driver &D,
         << "-fprofile-instr-generate";
 
   if (Args.hasFlag(options::OPT_fcoverage_mapping,
-                   options::OPT_fno_coverage_mapping, false))
+                   options::OPT_fno_coverage_mapping, false)) {
     CmdArgs.push_back("-fcoverage-mapping");
+    if (!Args.hasFlag(options::OPT_fcoverage_unused_header_functions,
+                      options::OPT_fno_coverage_unused_header_functions, true))
+      CmdArgs.push_back("-fno-coverage-unused-header-functions");
+  }
 
   if (C.getArgs().hasArg(options::OPT_c) ||
       C.getArgs().hasArg(options::OPT_S)) {
@@ -4150,6 +4336,12 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
 
     CmdArgs.push_back("-aux-triple");
     CmdArgs.push_back(Args.MakeArgString(NormalizedTriple));
+
+    // Both sides parse the kernel calls, so both need to know how the
+    // configuration is passed to the launch.
+    if (Args.hasFlag(options::OPT_fcuda_launch_kernel,
+                     options::OPT_fno_cuda_launch_kernel, false))
+      CmdArgs.push_back("-fcuda-launch-kernel");
   }
 
   if (IsOpenMPDevice) {
@@ -4186,9 +4378,13 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
   } else if (isa<MigrateJobAction>(JA)) {
     CmdArgs.push_back("-migrate");
   } else if (isa<PreprocessJobAction>(JA)) {
-    if (Output.getType() == types::TY_Dependencies)
-      CmdArgs.push_back("-Eonly");
-    else {
+    if (Output.getType() == types::TY_Dependencies) {
+      // -fminimize-dependency-scan only looks at the directives of each file.
+      if (Args.hasArg(options::OPT_fminimize_dependency_scan))
+        CmdArgs.push_back("-Eonly-directives");
+      else
+        CmdArgs.push_back("-Eonly");
+    } else {
       CmdArgs.push_back("-E");
       if (Args.hasArg(options::OPT_rewrite_objc) &&
           !Args.hasArg(options::OPT_g_Group))
@@ -4487,13 +4683,23 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
   if (Args.hasFlag(options::OPT_fstrict_enums, options::OPT_fno_strict_enums,
                    false))
     CmdArgs.push_back("-fstrict-enums");
+  Args.AddLastArg(CmdArgs, options::OPT_fstream_instantiations);
   if (!Args.hasFlag(options::OPT_fstrict_return, options::OPT_fno_strict_return,
                     true))
     CmdArgs.push_back("-fno-strict-return");
+  if (Args.hasFlag(options::OPT_fcold_unlikely_calls,
+                   options::OPT_fno_cold_unlikely_calls, false))
+    CmdArgs.push_back("-fcold-unlikely-calls");
   if (Args.hasFlag(options::OPT_fstrict_vtable_pointers,
                    options::OPT_fno_strict_vtable_pointers,
                    false))
     CmdArgs.push_back("-fstrict-vtable-pointers");
+  if (Args.hasFlag(options::OPT_fspeculative_devirtualization,
+                   options::OPT_fno_speculative_devirtualization, false))
+    CmdArgs.push_back("-fspeculative-devirtualization");
+  if (Args.hasFlag(options::OPT_flazy_dynamic_init,
+                   options::OPT_fno_lazy_dynamic_init, false))
+    CmdArgs.push_back("-flazy-dynamic-init");
   if (!Args.hasFlag(options::OPT_foptimize_sibling_calls,
                     options::OPT_fno_optimize_sibling_calls))
     CmdArgs.push_back("-mdisable-tail-calls");
@@ -5306,6 +5512,8 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
     CmdArgs.push_back(A->getValue());
   }
 
+  Args.AddLastArg(CmdArgs, options::OPT_fexperimental_constexpr_interpreter);
+
   if (Arg *A = Args.getLastArg(options::OPT_fbracket_depth_EQ)) {
     CmdArgs.push_back("-fbracket-depth");
     CmdArgs.push_back(A->getValue());
@@ -5451,6 +5659,130 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
                        /*Default=*/false))
         CmdArgs.push_back("-fopenmp-nvptx-requireruntime");
 
+      if (Args.hasFlag(options::OPT_fopenmp_nvptx_inline_teams_reduction,
+                       options::OPT_fopenmp_nvptx_noinline_teams_reduction,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-nvptx-inline-teams-reduction");
+
+      if (Args.hasFlag(options::OPT_fopenmp_nvptx_static_data_sharing,
+                       options::OPT_fopenmp_nvptx_nostatic_data_sharing,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-nvptx-static-data-sharing");
+
+      if (Args.hasFlag(options::OPT_fopenmp_nvptx_data_sharing_pool,
+                       options::OPT_fopenmp_nvptx_nodata_sharing_pool,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-nvptx-data-sharing-pool");
+
+      if (Args.hasFlag(options::OPT_fopenmp_nvptx_copy_readonly_captures,
+                       options::OPT_fopenmp_nvptx_nocopy_readonly_captures,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-nvptx-copy-readonly-captures");
+
+      Args.AddLastArg(CmdArgs, options::OPT_fopenmp_nvptx_min_teams_per_sm_EQ);
+
+      if (Args.hasFlag(options::OPT_fopenmp_target_nowait_depend,
+                       options::OPT_fnoopenmp_target_nowait_depend,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-target-nowait-depend");
+
+      // The host and device compilations must agree on the layout of the
+      // offload entries table.
+      if (Args.hasFlag(options::OPT_fopenmp_hashed_offload_entries,
+                       options::OPT_fnoopenmp_hashed_offload_entries,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-hashed-offload-entries");
+
+      // Without the linker script, the offload entries have to be protected
+      // from the garbage collection of sections by the compiler.
+      if (Args.hasFlag(options::OPT_fopenmp_offload_wrapper_objects,
+                       options::OPT_fnoopenmp_offload_wrapper_objects,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-offload-wrapper-objects");
+
+      if (Args.hasFlag(options::OPT_fopenmp_small_task_alloc,
+                       options::OPT_fnoopenmp_small_task_alloc,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-small-task-alloc");
+
+      if (Args.hasFlag(options::OPT_fopenmp_task_serial_cutoff,
+                       options::OPT_fnoopenmp_task_serial_cutoff,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-task-serial-cutoff");
+
+      if (Args.hasFlag(options::OPT_fopenmp_taskloop_shared_firstprivates,
+                       options::OPT_fnoopenmp_taskloop_shared_firstprivates,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-taskloop-shared-firstprivates");
+
+      Args.AddLastArg(CmdArgs, options::OPT_fopenmp_doacross_tile_size_EQ);
+
+      if (Args.hasFlag(options::OPT_fopenmp_inline_static_schedule,
+                       options::OPT_fnoopenmp_inline_static_schedule,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-inline-static-schedule");
+
+      if (Args.hasFlag(options::OPT_fopenmp_tree_reduction,
+                       options::OPT_fnoopenmp_tree_reduction,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-tree-reduction");
+
+      Args.AddLastArg(CmdArgs, options::OPT_fopenmp_private_copy_align_EQ);
+
+      if (Args.hasFlag(options::OPT_fopenmp_declare_simd_calls,
+                       options::OPT_fnoopenmp_declare_simd_calls,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-declare-simd-calls");
+
+      if (Args.hasFlag(options::OPT_fopenmp_hoist_threadprivate_lookups,
+                       options::OPT_fnoopenmp_hoist_threadprivate_lookups,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-hoist-threadprivate-lookups");
+      if (Args.hasFlag(options::OPT_fopenmp_fuse_parallel_regions,
+                       options::OPT_fnoopenmp_fuse_parallel_regions,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-fuse-parallel-regions");
+      if (Args.hasFlag(options::OPT_fopenmp_hoist_target_data,
+                       options::OPT_fnoopenmp_hoist_target_data,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-hoist-target-data");
+      if (Args.hasFlag(options::OPT_fopenmp_unified_memory,
+                       options::OPT_fnoopenmp_unified_memory,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-unified-memory");
+      if (Args.hasFlag(options::OPT_fopenmp_split_target_devices,
+                       options::OPT_fnoopenmp_split_target_devices,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-split-target-devices");
+      if (Args.hasFlag(options::OPT_fopenmp_inline_reduction_combiners,
+                       options::OPT_fnoopenmp_inline_reduction_combiners,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-inline-reduction-combiners");
+      if (Args.hasFlag(options::OPT_fopenmp_offload_profile,
+                       options::OPT_fnoopenmp_offload_profile,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-offload-profile");
+      if (Args.hasFlag(options::OPT_fopenmp_nvptx_cycle_counters,
+                       options::OPT_fnoopenmp_nvptx_cycle_counters,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-nvptx-cycle-counters");
+      if (Args.hasFlag(options::OPT_fopenmp_merge_identical_kernels,
+                       options::OPT_fnoopenmp_merge_identical_kernels,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-merge-identical-kernels");
+      if (Args.hasFlag(options::OPT_fopenmp_split_complex_atomics,
+                       options::OPT_fnoopenmp_split_complex_atomics,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-split-complex-atomics");
+      if (Args.hasFlag(options::OPT_fopenmp_nvptx_stencil_tiling,
+                       options::OPT_fnoopenmp_nvptx_stencil_tiling,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-nvptx-stencil-tiling");
+      if (Args.hasFlag(options::OPT_fopenmp_nvptx_native_dynamic_schedule,
+                       options::OPT_fnoopenmp_nvptx_native_dynamic_schedule,
+                       /*Default=*/false))
+        CmdArgs.push_back("-fopenmp-nvptx-native-dynamic-schedule");
+
       Args.AddAllArgs(CmdArgs, options::OPT_fopenmp_version_EQ);
       break;
     default:
@@ -5798,6 +6130,14 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
           std::string("-fprebuilt-module-path=") + A->getValue()));
   }
       
+  // -fheader-info-cache specifies where header search results are kept
+  // between compilations.
+  Args.AddLastArg(CmdArgs, options::OPT_fheader_info_cache_EQ);
+
+  // -fstat-prefetch-threads looks up the candidate paths of header search
+  // concurrently.
+  Args.AddLastArg(CmdArgs, options::OPT_fstat_prefetch_threads_EQ);
+
   // -fmodule-name specifies the module that is currently being built (or
   // used for header checking by -fmodule-maps).
   Args.AddLastArg(CmdArgs, options::OPT_fmodule_name_EQ);
@@ -5871,6 +6211,15 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
                     options::OPT_fmodules_validate_once_per_build_session);
   }
 
+  if (Args.getLastArg(options::OPT_fmodules_share_build_session_validation)) {
+    if (!Args.getLastArg(options::OPT_fbuild_session_timestamp,
+                         options::OPT_fbuild_session_file))
+      D.Diag(diag::err_drv_modules_share_validation_requires_timestamp);
+
+    Args.AddLastArg(CmdArgs,
+                    options::OPT_fmodules_share_build_session_validation);
+  }
+
   Args.AddLastArg(CmdArgs, options::OPT_fmodules_validate_system_headers);
   Args.AddLastArg(CmdArgs, options::OPT_fmodules_disable_diagnostic_validation);
 
@@ -5993,6 +6342,8 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
                    options::OPT_fno_delayed_template_parsing, IsWindowsMSVC))
     CmdArgs.push_back("-fdelayed-template-parsing");
 
+  Args.AddLastArg(CmdArgs, options::OPT_fpch_instantiate_templates);
+
   // -fgnu-keywords default varies depending on language; only pass if
   // specified.
   if (Arg *A = Args.getLastArg(options::OPT_fgnu_keywords,
@@ -6247,6 +6598,8 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
                    options::OPT_fno_diagnostics_show_hotness, false))
     CmdArgs.push_back("-fdiagnostics-show-hotness");
 
+  Args.AddLastArg(CmdArgs, options::OPT_faggregate_copy_remark_threshold_EQ);
+
   if (const Arg *A = Args.getLastArg(options::OPT_fdiagnostics_format_EQ)) {
     CmdArgs.push_back("-fdiagnostics-format");
     CmdArgs.push_back(A->getValue());
@@ -6489,6 +6842,21 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
     }
   }
 
+  // Setup time trace output, next to the object file.
+  if (Args.hasArg(options::OPT_ftime_trace)) {
+    SmallString<128> TraceFile;
+    if (Output.isFilename()) {
+      TraceFile.assign(Output.getFilename());
+      llvm::sys::path::remove_filename(TraceFile);
+    }
+    llvm::sys::path::append(TraceFile,
+                            llvm::sys::path::filename(Input.getBaseInput()));
+    llvm::sys::path::replace_extension(TraceFile, "json");
+    CmdArgs.push_back(
+        Args.MakeArgString(Twine("-time-trace-file=") + TraceFile));
+    Args.AddLastArg(CmdArgs, options::OPT_ftime_trace_top_EQ);
+  }
+
   // Forward -Xclang arguments to -cc1, and -mllvm arguments to the LLVM option
   // parser.
   Args.AddAllArgValues(CmdArgs, options::OPT_Xclang);
@@ -6515,8 +6883,40 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
       !C.getDriver().embedBitcodeInObject() && isa<CompileJobAction>(JA))
     CmdArgs.push_back("-disable-llvm-passes");
 
+  // With -fparallel-codegen=N, the backend writes the object files of N
+  // partitions of the module, which are then linked into the output with a
+  // relocatable link.
+  SmallVector<const char *, 4> ParallelCodeGenParts;
+  if (Arg *A = Args.getLastArg(options::OPT_fparallel_codegen_EQ)) {
+    unsigned NumParts;
+    if (StringRef(A->getValue()).getAsInteger(10, NumParts) || NumParts == 0)
+      D.Diag(diag::err_drv_invalid_int_value) << A->getAsString(Args)
+                                              << A->getValue();
+    else if (NumParts > 1 && Output.isFilename() &&
+             Output.getType() == types::TY_Object &&
+             getToolChain().getTriple().isOSBinFormatELF()) {
+      if (Args.hasArg(options::OPT_gsplit_dwarf))
+        D.Diag(diag::err_drv_argument_not_allowed_with)
+            << A->getAsString(Args) << "-gsplit-dwarf";
+      for (unsigned I = 0; I != NumParts; ++I) {
+        const char *Part = Args.MakeArgString(Twine(Output.getFilename()) +
+                                              ".part" + Twine(I) + ".o");
+        if (!D.isSaveTempsEnabled())
+          C.addTempFile(Part);
+        ParallelCodeGenParts.push_back(Part);
+      }
+    }
+  }
+
   if (Output.getType() == types::TY_Dependencies) {
     // Handled with other dependency code.
+  } else if (!ParallelCodeGenParts.empty()) {
+    CmdArgs.push_back("-o");
+    CmdArgs.push_back(ParallelCodeGenParts[0]);
+    for (const char *Part : makeArrayRef(ParallelCodeGenParts).drop_front()) {
+      CmdArgs.push_back("-parallel-codegen-output");
+      CmdArgs.push_back(Part);
+    }
   } else if (Output.isFilename()) {
     CmdArgs.push_back("-o");
     CmdArgs.push_back(Output.getFilename());
@@ -6573,18 +6973,39 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
       CmdArgs.push_back("-fcuda-include-gpubinary");
       CmdArgs.push_back(I->getFilename());
     }
+  // Their registration can be deferred to the first kernel launch.
+  if (IsCuda && Inputs.size() > 1 &&
+      Args.hasFlag(options::OPT_fcuda_lazy_registration,
+                   options::OPT_fno_cuda_lazy_registration, false))
+    CmdArgs.push_back("-fcuda-lazy-registration");
 
   // OpenMP offloading device jobs take the argument -fopenmp-host-ir-file-path
   // to specify the result of the compile phase on the host, so the meaningful
   // device declarations can be identified. Also, -fopenmp-is-device is passed
   // along to tell the frontend that it is generating code for a device, so that
   // only the relevant declarations are emitted.
+  //
+  // The host compile phase also writes the offload entries info next to its
+  // IR, so that the device jobs can read that small file instead of the host
+  // IR.
   if (IsOpenMPDevice) {
     CmdArgs.push_back("-fopenmp-is-device");
     if (Inputs.size() == 2) {
       CmdArgs.push_back("-fopenmp-host-ir-file-path");
       CmdArgs.push_back(Args.MakeArgString(Inputs.back().getFilename()));
+      if (Inputs.back().getType() == types::TY_LLVM_BC) {
+        CmdArgs.push_back("-fopenmp-host-offload-info-file-path");
+        CmdArgs.push_back(Args.MakeArgString(
+            Twine(Inputs.back().getFilename()) + ".ompinfo"));
+      }
     }
+
+    // Only the device compilation can skip the bodies of host-only
+    // functions, the host needs all of them.
+    if (Args.hasFlag(options::OPT_fopenmp_skip_host_function_bodies,
+                     options::OPT_fnoopenmp_skip_host_function_bodies,
+                     /*Default=*/false))
+      CmdArgs.push_back("-fopenmp-skip-host-function-bodies");
   }
 
   // OpenMP 4.5 standard does not allow to use any declaration in target region
@@ -6596,11 +7017,27 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
                    /*Default=*/false))
     CmdArgs.push_back("-fopenmp-implicit-declare-target");
 
+  if (Args.hasFlag(options::OPT_fopenmp_prune_implicit_declare_target,
+                   options::OPT_fnoopenmp_prune_implicit_declare_target,
+                   /*Default=*/false))
+    CmdArgs.push_back("-fopenmp-prune-implicit-declare-target");
+
   if(Args.hasFlag(options::OPT_fopenmp_implicit_map_lambdas,
                   options::OPT_fnoopenmp_implicit_map_lambdas,
                   false))
     CmdArgs.push_back("-fopenmp-implicit-map-lambdas");
 
+  // The host and device compilations have to agree on how these variables
+  // are captured, so forward the flag to both of them.
+  if (Args.hasFlag(options::OPT_fopenmp_small_maps_by_value,
+                   options::OPT_fnoopenmp_small_maps_by_value,
+                   /*Default=*/false))
+    CmdArgs.push_back("-fopenmp-small-maps-by-value");
+  if (Args.hasFlag(options::OPT_fopenmp_narrow_implicit_maps,
+                   options::OPT_fnoopenmp_narrow_implicit_maps,
+                   /*Default=*/false))
+    CmdArgs.push_back("-fopenmp-narrow-implicit-maps");
+
   if (Args.hasFlag(options::OPT_fopenmp_nvptx_nospmd,
                    options::OPT_fopenmp_nvptx_spmd,
                    /*Default=*/false)) {
@@ -6630,6 +7067,35 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
       TargetInfo += T.getTriple();
     }
     CmdArgs.push_back(Args.MakeArgString(TargetInfo.str()));
+
+    // Write the offload entries info next to the host IR for the device jobs.
+    if (Output.isFilename() && Output.getType() == types::TY_LLVM_BC) {
+      const char *InfoFile =
+          Args.MakeArgString(Twine(Output.getFilename()) + ".ompinfo");
+      if (!D.isSaveTempsEnabled())
+        C.addTempFile(InfoFile);
+      CmdArgs.push_back("-fopenmp-offload-info-output");
+      CmdArgs.push_back(InfoFile);
+    }
+  }
+
+  // Keep the bitcode of the NVPTX device code, so that the host link embeds it
+  // next to the device image.
+  if (JA.isDeviceOffloading(Action::OFK_OpenMP) &&
+      getToolChain().getTriple().isNVPTX() && Output.isFilename() &&
+      Output.getType() == types::TY_PP_Asm && !Args.hasArg(options::OPT_c) &&
+      !Args.hasArg(options::OPT_S) &&
+      Args.hasFlag(options::OPT_fopenmp_nvptx_embed_bitcode,
+                   options::OPT_fopenmp_nvptx_noembed_bitcode,
+                   /*Default=*/false)) {
+    const char *BitcodeFile =
+        Args.MakeArgString(Twine(Output.getFilename()) + ".jit.bc");
+    if (!D.isSaveTempsEnabled())
+      C.addTempFile(BitcodeFile);
+    CmdArgs.push_back("-fopenmp-device-bitcode-output");
+    CmdArgs.push_back(BitcodeFile);
+    C.addOpenMPDeviceBitcodeFile(getToolChain().getTriple().normalize(),
+                                 BitcodeFile);
   }
 
   bool WholeProgramVTables =
@@ -6661,6 +7127,18 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
     C.addCommand(llvm::make_unique<Command>(JA, *this, Exec, CmdArgs, Inputs));
   }
 
+  // Link the partitions generated with -fparallel-codegen into the output.
+  if (!ParallelCodeGenParts.empty()) {
+    ArgStringList LinkArgs;
+    LinkArgs.push_back("-r");
+    LinkArgs.append(ParallelCodeGenParts.begin(), ParallelCodeGenParts.end());
+    LinkArgs.push_back("-o");
+    LinkArgs.push_back(Output.getFilename());
+    C.addCommand(llvm::make_unique<Command>(
+        JA, *this, Args.MakeArgString(getToolChain().GetLinkerPath()),
+        LinkArgs, None));
+  }
+
   // Handle the debug info splitting at object creation time if we're
   // creating an object.
   // TODO: Currently only works on linux with newer objcopy.
@@ -10354,6 +10832,9 @@ void gnutools::Linker::ConstructJob(Compilation &C, const JobAction &JA,
 
   bool NeedsSanitizerDeps = addSanitizerRuntimes(ToolChain, Args, CmdArgs);
   bool NeedsXRayDeps = addXRayRuntime(ToolChain, Args, CmdArgs);
+  bool UseOpenMPWrapperObjects = useOpenMPWrapperObjects(ToolChain, Args, JA);
+  if (UseOpenMPWrapperObjects)
+    AddOpenMPWrapperBeginObject(*this, C, Output, Inputs, Args, CmdArgs, JA);
   AddLinkerInputs(ToolChain, Inputs, Args, CmdArgs, JA);
   // The profile runtime also needs access to system libraries.
   getToolChain().addProfileRTLibs(Args, CmdArgs);
@@ -10458,8 +10939,11 @@ void gnutools::Linker::ConstructJob(Compilation &C, const JobAction &JA,
     }
   }
 
-  // Add OpenMP offloading linker script args if required.
-  AddOpenMPLinkerScript(getToolChain(), C, Output, Inputs, Args, CmdArgs, JA);
+  // Add OpenMP offloading linker script args or wrapper objects if required.
+  if (UseOpenMPWrapperObjects)
+    AddOpenMPWrapperEndObject(*this, C, Output, Inputs, Args, CmdArgs, JA);
+  else
+    AddOpenMPLinkerScript(getToolChain(), C, Output, Inputs, Args, CmdArgs, JA);
 
   C.addCommand(llvm::make_unique<Command>(JA, *this, Exec, CmdArgs, Inputs));
 }
@@ -72,6 +72,12 @@ ContinuationIndenter::ContinuationIndenter(const FormatStyle &Style,
       BinPackInconclusiveFunctions(BinPackInconclusiveFunctions),
       CommentPragmasRegex(Style.CommentPragmas) {}
 
+ContinuationIndenter::ContinuationIndenter(const ContinuationIndenter &Other,
+                                           WhitespaceManager &Whitespaces)
+    : ContinuationIndenter(Other.Style, Other.Keywords, Other.SourceMgr,
+                           Whitespaces, Other.Encoding,
+                           Other.BinPackInconclusiveFunctions) {}
+
 LineState ContinuationIndenter::getInitialState(unsigned FirstIndent,
                                                 const AnnotatedLine *Line,
                                                 bool DryRun) {
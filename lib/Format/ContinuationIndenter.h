@@ -19,6 +19,7 @@
 #include "Encoding.h"
 #include "FormatToken.h"
 #include "clang/Format/Format.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/Support/Regex.h"
 
 namespace clang {
@@ -43,6 +44,11 @@ public:
                        encoding::Encoding Encoding,
                        bool BinPackInconclusiveFunctions);
 
+  /// \brief Constructs a \c ContinuationIndenter like \p Other that records
+  /// its changes in \p Whitespaces, to format lines on another thread.
+  ContinuationIndenter(const ContinuationIndenter &Other,
+                       WhitespaceManager &Whitespaces);
+
   /// \brief Get the initial state, i.e. the state after placing \p Line's
   /// first token at \p FirstIndent.
   LineState getInitialState(unsigned FirstIndent, const AnnotatedLine *Line,
@@ -302,6 +308,41 @@ struct ParenState {
       return NestedBlockInlined;
     return false;
   }
+
+  /// \brief Equality under \c operator<, i.e. comparing the same members.
+  bool operator==(const ParenState &Other) const {
+    return Indent == Other.Indent && LastSpace == Other.LastSpace &&
+           NestedBlockIndent == Other.NestedBlockIndent &&
+           FirstLessLess == Other.FirstLessLess &&
+           BreakBeforeClosingBrace == Other.BreakBeforeClosingBrace &&
+           QuestionColumn == Other.QuestionColumn &&
+           AvoidBinPacking == Other.AvoidBinPacking &&
+           BreakBeforeParameter == Other.BreakBeforeParameter &&
+           NoLineBreak == Other.NoLineBreak &&
+           LastOperatorWrapped == Other.LastOperatorWrapped &&
+           ColonPos == Other.ColonPos &&
+           StartOfFunctionCall == Other.StartOfFunctionCall &&
+           StartOfArraySubscripts == Other.StartOfArraySubscripts &&
+           CallContinuation == Other.CallContinuation &&
+           VariablePos == Other.VariablePos &&
+           ContainsLineBreak == Other.ContainsLineBreak &&
+           ContainsUnwrappedBuilder == Other.ContainsUnwrappedBuilder &&
+           NestedBlockInlined == Other.NestedBlockInlined;
+  }
+
+  /// \brief A hash of the members compared by \c operator<.
+  friend llvm::hash_code hash_value(const ParenState &State) {
+    return llvm::hash_combine(
+        State.Indent, State.LastSpace, State.NestedBlockIndent,
+        State.FirstLessLess, bool(State.BreakBeforeClosingBrace),
+        State.QuestionColumn, bool(State.AvoidBinPacking),
+        bool(State.BreakBeforeParameter), bool(State.NoLineBreak),
+        bool(State.LastOperatorWrapped), State.ColonPos,
+        State.StartOfFunctionCall, State.StartOfArraySubscripts,
+        State.CallContinuation, State.VariablePos,
+        bool(State.ContainsLineBreak), bool(State.ContainsUnwrappedBuilder),
+        bool(State.NestedBlockInlined));
+  }
 };
 
 /// \brief The current state when indenting a unwrapped line.
@@ -373,6 +414,30 @@ struct LineState {
       return false;
     return Stack < Other.Stack;
   }
+
+  /// \brief Returns \c true if neither this state nor \p Other is less than
+  /// the other one, comparing the stacks only if \p CompareStack is \c true.
+  bool isEquivalent(const LineState &Other, bool CompareStack) const {
+    return NextToken == Other.NextToken && Column == Other.Column &&
+           LineContainsContinuedForLoopSection ==
+               Other.LineContainsContinuedForLoopSection &&
+           StartOfLineLevel == Other.StartOfLineLevel &&
+           LowestLevelOnLine == Other.LowestLevelOnLine &&
+           StartOfStringLiteral == Other.StartOfStringLiteral &&
+           (!CompareStack || Stack == Other.Stack);
+  }
+
+  /// \brief A hash that is the same for the states \c isEquivalent considers
+  /// equal with the same \p CompareStack.
+  llvm::hash_code getHash(bool CompareStack) const {
+    llvm::hash_code Hash = llvm::hash_combine(
+        NextToken, Column, LineContainsContinuedForLoopSection,
+        StartOfLineLevel, LowestLevelOnLine, StartOfStringLiteral);
+    if (!CompareStack)
+      return Hash;
+    return llvm::hash_combine(
+        Hash, llvm::hash_combine_range(Stack.begin(), Stack.end()));
+  }
 };
 
 } // end namespace format
@@ -35,7 +35,9 @@
 #include "llvm/Support/Regex.h"
 #include "llvm/Support/YAMLTraits.h"
 #include <algorithm>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 
 #define DEBUG_TYPE "format-formatter"
@@ -889,11 +891,87 @@ private:
   }
 };
 
+/// \brief What \c Formatter derives the style adapting to the code from.
+struct LocalStyleInfo {
+  /// The pointers and references bound to the name minus those bound to the
+  /// type.
+  int VariableAlignments = 0;
+  bool HasBinPackedFunction = false;
+  bool HasOnePerLineFunction = false;
+  bool HasCpp03IncompatibleFormat = false;
+
+  void add(const LocalStyleInfo &Other) {
+    VariableAlignments += Other.VariableAlignments;
+    HasBinPackedFunction |= Other.HasBinPackedFunction;
+    HasOnePerLineFunction |= Other.HasOnePerLineFunction;
+    HasCpp03IncompatibleFormat |= Other.HasCpp03IncompatibleFormat;
+  }
+};
+
+bool hasCpp03IncompatibleFormat(const SmallVectorImpl<AnnotatedLine *> &Lines) {
+  for (const AnnotatedLine *Line : Lines) {
+    if (hasCpp03IncompatibleFormat(Line->Children))
+      return true;
+    for (FormatToken *Tok = Line->First->Next; Tok; Tok = Tok->Next) {
+      if (Tok->WhitespaceRange.getBegin() == Tok->WhitespaceRange.getEnd()) {
+        if (Tok->is(tok::coloncolon) && Tok->Previous->is(TT_TemplateOpener))
+          return true;
+        if (Tok->is(TT_TemplateCloser) &&
+            Tok->Previous->is(TT_TemplateCloser))
+          return true;
+      }
+    }
+  }
+  return false;
+}
+
+int countVariableAlignments(const SmallVectorImpl<AnnotatedLine *> &Lines) {
+  int AlignmentDiff = 0;
+  for (const AnnotatedLine *Line : Lines) {
+    AlignmentDiff += countVariableAlignments(Line->Children);
+    for (FormatToken *Tok = Line->First; Tok && Tok->Next; Tok = Tok->Next) {
+      if (!Tok->is(TT_PointerOrReference))
+        continue;
+      bool SpaceBefore =
+          Tok->WhitespaceRange.getBegin() != Tok->WhitespaceRange.getEnd();
+      bool SpaceAfter = Tok->Next->WhitespaceRange.getBegin() !=
+                        Tok->Next->WhitespaceRange.getEnd();
+      if (SpaceBefore && !SpaceAfter)
+        ++AlignmentDiff;
+      if (!SpaceBefore && SpaceAfter)
+        --AlignmentDiff;
+    }
+  }
+  return AlignmentDiff;
+}
+
+LocalStyleInfo
+getLocalStyleInfo(const SmallVectorImpl<AnnotatedLine *> &Lines) {
+  LocalStyleInfo Info;
+  for (const AnnotatedLine *Line : Lines) {
+    if (!Line->First->Next)
+      continue;
+    for (FormatToken *Tok = Line->First->Next; Tok->Next; Tok = Tok->Next) {
+      if (Tok->PackingKind == PPK_BinPacked)
+        Info.HasBinPackedFunction = true;
+      if (Tok->PackingKind == PPK_OnePerLine)
+        Info.HasOnePerLineFunction = true;
+    }
+  }
+  Info.VariableAlignments = countVariableAlignments(Lines);
+  Info.HasCpp03IncompatibleFormat = hasCpp03IncompatibleFormat(Lines);
+  return Info;
+}
+
 class Formatter : public TokenAnalyzer {
 public:
+  /// If \p FileInfo is not null, the style adapts to it instead of to the
+  /// formatted code, which is then only a part of the file.
   Formatter(const Environment &Env, const FormatStyle &Style,
-            bool *IncompleteFormat)
-      : TokenAnalyzer(Env, Style), IncompleteFormat(IncompleteFormat) {}
+            bool *IncompleteFormat, unsigned Threads = 1,
+            const LocalStyleInfo *FileInfo = nullptr)
+      : TokenAnalyzer(Env, Style), IncompleteFormat(IncompleteFormat),
+        Threads(Threads), FileInfo(FileInfo) {}
 
   tooling::Replacements
   analyze(TokenAnnotator &Annotator,
@@ -915,7 +993,7 @@ public:
                                   Env.getSourceManager(), Whitespaces, Encoding,
                                   BinPackInconclusiveFunctions);
     UnwrappedLineFormatter(&Indenter, &Whitespaces, Style, Tokens.getKeywords(),
-                           IncompleteFormat)
+                           IncompleteFormat, Threads)
         .format(AnnotatedLines);
     for (const auto &R : Whitespaces.generateReplacements())
       if (Result.add(R))
@@ -929,75 +1007,26 @@ private:
     return Text.count('\r') * 2 > Text.count('\n');
   }
 
-  bool
-  hasCpp03IncompatibleFormat(const SmallVectorImpl<AnnotatedLine *> &Lines) {
-    for (const AnnotatedLine *Line : Lines) {
-      if (hasCpp03IncompatibleFormat(Line->Children))
-        return true;
-      for (FormatToken *Tok = Line->First->Next; Tok; Tok = Tok->Next) {
-        if (Tok->WhitespaceRange.getBegin() == Tok->WhitespaceRange.getEnd()) {
-          if (Tok->is(tok::coloncolon) && Tok->Previous->is(TT_TemplateOpener))
-            return true;
-          if (Tok->is(TT_TemplateCloser) &&
-              Tok->Previous->is(TT_TemplateCloser))
-            return true;
-        }
-      }
-    }
-    return false;
-  }
-
-  int countVariableAlignments(const SmallVectorImpl<AnnotatedLine *> &Lines) {
-    int AlignmentDiff = 0;
-    for (const AnnotatedLine *Line : Lines) {
-      AlignmentDiff += countVariableAlignments(Line->Children);
-      for (FormatToken *Tok = Line->First; Tok && Tok->Next; Tok = Tok->Next) {
-        if (!Tok->is(TT_PointerOrReference))
-          continue;
-        bool SpaceBefore =
-            Tok->WhitespaceRange.getBegin() != Tok->WhitespaceRange.getEnd();
-        bool SpaceAfter = Tok->Next->WhitespaceRange.getBegin() !=
-                          Tok->Next->WhitespaceRange.getEnd();
-        if (SpaceBefore && !SpaceAfter)
-          ++AlignmentDiff;
-        if (!SpaceBefore && SpaceAfter)
-          --AlignmentDiff;
-      }
-    }
-    return AlignmentDiff;
-  }
-
   void
   deriveLocalStyle(const SmallVectorImpl<AnnotatedLine *> &AnnotatedLines) {
-    bool HasBinPackedFunction = false;
-    bool HasOnePerLineFunction = false;
-    for (unsigned i = 0, e = AnnotatedLines.size(); i != e; ++i) {
-      if (!AnnotatedLines[i]->First->Next)
-        continue;
-      FormatToken *Tok = AnnotatedLines[i]->First->Next;
-      while (Tok->Next) {
-        if (Tok->PackingKind == PPK_BinPacked)
-          HasBinPackedFunction = true;
-        if (Tok->PackingKind == PPK_OnePerLine)
-          HasOnePerLineFunction = true;
-
-        Tok = Tok->Next;
-      }
-    }
+    LocalStyleInfo Info =
+        FileInfo ? *FileInfo : getLocalStyleInfo(AnnotatedLines);
     if (Style.DerivePointerAlignment)
-      Style.PointerAlignment = countVariableAlignments(AnnotatedLines) <= 0
+      Style.PointerAlignment = Info.VariableAlignments <= 0
                                    ? FormatStyle::PAS_Left
                                    : FormatStyle::PAS_Right;
     if (Style.Standard == FormatStyle::LS_Auto)
-      Style.Standard = hasCpp03IncompatibleFormat(AnnotatedLines)
+      Style.Standard = Info.HasCpp03IncompatibleFormat
                            ? FormatStyle::LS_Cpp11
                            : FormatStyle::LS_Cpp03;
     BinPackInconclusiveFunctions =
-        HasBinPackedFunction || !HasOnePerLineFunction;
+        Info.HasBinPackedFunction || !Info.HasOnePerLineFunction;
   }
 
   bool BinPackInconclusiveFunctions;
   bool *IncompleteFormat;
+  unsigned Threads;
+  const LocalStyleInfo *FileInfo;
 };
 
 // This class clean up the erroneous/redundant code around the given ranges in
@@ -1224,6 +1253,97 @@ private:
   std::set<FormatToken *, FormatTokenLess> DeletedTokens;
 };
 
+// Splits code into chunks that can be formatted on their own, that is, at
+// top-level lines that follow an empty line and are outside of any braces,
+// preprocessor conditionals and Objective-C containers.
+class ChunkAnalyzer : public TokenAnalyzer {
+public:
+  struct Chunk {
+    unsigned Offset;
+    LocalStyleInfo Info;
+  };
+
+  ChunkAnalyzer(const Environment &Env, const FormatStyle &Style)
+      : TokenAnalyzer(Env, Style) {}
+
+  tooling::Replacements
+  analyze(TokenAnnotator &Annotator,
+          SmallVectorImpl<AnnotatedLine *> &AnnotatedLines,
+          FormatTokenLexer &Tokens) override {
+    // The later runs only differ in the preprocessor conditionals, outside of
+    // which the first run already sees all lines.
+    if (!Chunks.empty())
+      return tooling::Replacements();
+
+    const SourceManager &SourceMgr = Env.getSourceManager();
+    SmallVector<AnnotatedLine *, 16> ChunkLines;
+    const AnnotatedLine *PreviousLine = nullptr;
+    unsigned BraceDepth = 0;
+    unsigned PPDepth = 0;
+    bool InObjCContainer = false;
+    Chunks.push_back({0, LocalStyleInfo()});
+    for (AnnotatedLine *Line : AnnotatedLines) {
+      const FormatToken *First = Line->First;
+      if (PreviousLine && isAtTopLevel(BraceDepth, PPDepth, InObjCContainer) &&
+          PreviousLine->Level == 0 && startsChunk(*Line)) {
+        Chunks.back().Info = getLocalStyleInfo(ChunkLines);
+        ChunkLines.clear();
+        Chunks.push_back(
+            {SourceMgr.getFileOffset(First->WhitespaceRange.getBegin()),
+             LocalStyleInfo()});
+      }
+      ChunkLines.push_back(Line);
+      PreviousLine = Line;
+
+      for (const FormatToken *Tok = First; Tok; Tok = Tok->Next) {
+        if (Tok->is(tok::l_brace))
+          ++BraceDepth;
+        else if (Tok->is(tok::r_brace) && BraceDepth > 0)
+          --BraceDepth;
+      }
+      if (First->is(tok::hash) && First->Next) {
+        if (First->Next->isOneOf(tok::pp_if, tok::pp_ifdef, tok::pp_ifndef))
+          ++PPDepth;
+        else if (First->Next->is(tok::pp_endif) && PPDepth > 0)
+          --PPDepth;
+      }
+      if (First->is(tok::at) && First->Next) {
+        if (First->Next->isObjCAtKeyword(tok::objc_interface) ||
+            First->Next->isObjCAtKeyword(tok::objc_implementation) ||
+            First->Next->isObjCAtKeyword(tok::objc_protocol))
+          InObjCContainer = true;
+        else if (First->Next->isObjCAtKeyword(tok::objc_end))
+          InObjCContainer = false;
+      }
+    }
+    Chunks.back().Info = getLocalStyleInfo(ChunkLines);
+    EndsAtTopLevel = isAtTopLevel(BraceDepth, PPDepth, InObjCContainer);
+    return tooling::Replacements();
+  }
+
+  /// The chunks in the order of their offsets, the first one at offset 0.
+  std::vector<Chunk> Chunks;
+
+  /// Whether the code ends outside of braces, conditionals and containers.
+  bool EndsAtTopLevel = true;
+
+private:
+  static bool isAtTopLevel(unsigned BraceDepth, unsigned PPDepth,
+                           bool InObjCContainer) {
+    return BraceDepth == 0 && PPDepth == 0 && !InObjCContainer;
+  }
+
+  // Whether a chunk can start with \p Line, i.e. its formatting and the
+  // alignment of the lines around it do not depend on what is before it.
+  static bool startsChunk(const AnnotatedLine &Line) {
+    const FormatToken *First = Line.First;
+    return Line.Level == 0 && !Line.InPPDirective &&
+           First->NewlinesBefore > 1 &&
+           !First->isOneOf(tok::eof, tok::r_brace, tok::kw_else, tok::kw_catch,
+                           tok::kw_while);
+  }
+};
+
 struct IncludeDirective {
   StringRef Filename;
   StringRef Text;
@@ -1804,7 +1924,8 @@ cleanupAroundReplacements(StringRef Code, const tooling::Replacements &Replaces,
 
 tooling::Replacements reformat(const FormatStyle &Style, StringRef Code,
                                ArrayRef<tooling::Range> Ranges,
-                               StringRef FileName, bool *IncompleteFormat) {
+                               StringRef FileName, bool *IncompleteFormat,
+                               unsigned Threads) {
   FormatStyle Expanded = expandPresets(Style);
   if (Expanded.DisableFormat)
     return tooling::Replacements();
@@ -1821,13 +1942,13 @@ tooling::Replacements reformat(const FormatStyle &Style, StringRef Code,
         auto NewEnv = Environment::CreateVirtualEnvironment(
             *NewCode, FileName,
             tooling::calculateRangesAfterReplacements(Requotes, Ranges));
-        Formatter Format(*NewEnv, Expanded, IncompleteFormat);
+        Formatter Format(*NewEnv, Expanded, IncompleteFormat, Threads);
         return Requotes.merge(Format.process());
       }
     }
   }
 
-  Formatter Format(*Env, Expanded, IncompleteFormat);
+  Formatter Format(*Env, Expanded, IncompleteFormat, Threads);
   return Format.process();
 }
 
@@ -1840,6 +1961,172 @@ tooling::Replacements cleanup(const FormatStyle &Style, StringRef Code,
   return Clean.process();
 }
 
+class FormatSession::Implementation {
+public:
+  Implementation(const FormatStyle &Style, StringRef Code, StringRef FileName)
+      : Style(expandPresets(Style)), Code(Code), FileName(FileName),
+        Incremental(Style.Language == FormatStyle::LK_Cpp) {
+    if (Incremental)
+      Chunks = analyzeChunks(0, this->Code.size()).first;
+  }
+
+  llvm::Error applyEdits(const tooling::Replacements &Edits) {
+    if (Edits.empty())
+      return llvm::Error::success();
+    auto NewCode = tooling::applyAllReplacements(Code, Edits);
+    if (!NewCode)
+      return NewCode.takeError();
+    int Delta = int(NewCode->size()) - int(Code.size());
+    Code = std::move(*NewCode);
+    if (!Incremental)
+      return llvm::Error::success();
+
+    // The replacements are sorted and do not overlap.
+    unsigned EditBegin = Edits.begin()->getOffset();
+    unsigned EditEnd = std::prev(Edits.end())->getOffset() +
+                       std::prev(Edits.end())->getLength();
+
+    // The chunks after the edited ones move. The edit may also join the
+    // chunk before it with the edited ones, or those with the chunk after it.
+    unsigned LastEdited = getChunkIndex(EditEnd);
+    for (unsigned I = LastEdited + 1, E = Chunks.size(); I != E; ++I)
+      Chunks[I].Offset += Delta;
+    unsigned Begin = getChunkIndex(EditBegin);
+    if (Begin > 0)
+      --Begin;
+    unsigned End = std::min<unsigned>(LastEdited + 2, Chunks.size());
+
+    // Analyze until the code is back at the top level, like before the edit.
+    for (;;) {
+      unsigned EndOffset =
+          End == Chunks.size() ? Code.size() : Chunks[End].Offset;
+      auto Analyzed = analyzeChunks(Chunks[Begin].Offset, EndOffset);
+      if (!Analyzed.second && End != Chunks.size()) {
+        ++End;
+        continue;
+      }
+      Chunks.erase(Chunks.begin() + Begin, Chunks.begin() + End);
+      Chunks.insert(Chunks.begin() + Begin, Analyzed.first.begin(),
+                    Analyzed.first.end());
+      return llvm::Error::success();
+    }
+  }
+
+  tooling::Replacements format(ArrayRef<tooling::Range> Ranges,
+                               bool *IncompleteFormat) {
+    if (!Incremental || Style.DisableFormat)
+      return reformat(Style, Code, Ranges, FileName, IncompleteFormat);
+
+    LocalStyleInfo FileInfo;
+    for (const ChunkAnalyzer::Chunk &C : Chunks)
+      FileInfo.add(C.Info);
+
+    // The spans of chunks touched by the ranges. A range starting at a chunk
+    // may affect the last line of the chunk before it.
+    std::vector<std::pair<unsigned, unsigned>> Spans;
+    for (const tooling::Range &Range : Ranges) {
+      unsigned First = getChunkIndex(Range.getOffset());
+      if (First > 0 && Chunks[First].Offset == Range.getOffset())
+        --First;
+      Spans.push_back(std::make_pair(
+          First, getChunkIndex(Range.getOffset() + Range.getLength())));
+    }
+    std::sort(Spans.begin(), Spans.end());
+
+    tooling::Replacements Result;
+    for (unsigned I = 0, E = Spans.size(); I != E;) {
+      unsigned First = Spans[I].first;
+      unsigned Last = Spans[I].second;
+      for (++I; I != E && Spans[I].first <= Last + 1; ++I)
+        Last = std::max(Last, Spans[I].second);
+
+      unsigned Begin = Chunks[First].Offset;
+      unsigned End =
+          Last + 1 == Chunks.size() ? Code.size() : Chunks[Last + 1].Offset;
+      std::vector<tooling::Range> SpanRanges;
+      for (const tooling::Range &Range : Ranges) {
+        unsigned RangeEnd = Range.getOffset() + Range.getLength();
+        if (Range.getOffset() > End || RangeEnd < Begin)
+          continue;
+        unsigned ClippedBegin = std::max(Range.getOffset(), Begin);
+        unsigned ClippedEnd = std::min(RangeEnd, End);
+        SpanRanges.push_back(
+            tooling::Range(ClippedBegin - Begin, ClippedEnd - ClippedBegin));
+      }
+
+      auto Env = Environment::CreateVirtualEnvironment(
+          StringRef(Code).slice(Begin, End), FileName, SpanRanges);
+      Formatter Format(*Env, Style, IncompleteFormat, /*Threads=*/1,
+                       &FileInfo);
+      for (const tooling::Replacement &R : Format.process()) {
+        auto Err = Result.add(tooling::Replacement(
+            FileName, Begin + R.getOffset(), R.getLength(),
+            R.getReplacementText()));
+        if (Err) {
+          llvm::errs() << llvm::toString(std::move(Err)) << "\n";
+          return tooling::Replacements();
+        }
+      }
+    }
+    return Result;
+  }
+
+  StringRef getCode() const { return Code; }
+
+private:
+  // Returns the index of the chunk containing \p Offset.
+  unsigned getChunkIndex(unsigned Offset) const {
+    auto I = std::upper_bound(
+        Chunks.begin(), Chunks.end(), Offset,
+        [](unsigned Offset, const ChunkAnalyzer::Chunk &C) {
+          return Offset < C.Offset;
+        });
+    return I - Chunks.begin() - 1;
+  }
+
+  // Returns the chunks of the code between \p Begin and \p End, which must
+  // start a chunk, and whether the code ends at the top level.
+  std::pair<std::vector<ChunkAnalyzer::Chunk>, bool>
+  analyzeChunks(unsigned Begin, unsigned End) {
+    auto Env = Environment::CreateVirtualEnvironment(
+        StringRef(Code).slice(Begin, End), FileName, /*Ranges=*/{});
+    ChunkAnalyzer Analyzer(*Env, Style);
+    Analyzer.process();
+    if (Analyzer.Chunks.empty())
+      Analyzer.Chunks.push_back({0, LocalStyleInfo()});
+    for (ChunkAnalyzer::Chunk &C : Analyzer.Chunks)
+      C.Offset += Begin;
+    return std::make_pair(std::move(Analyzer.Chunks), Analyzer.EndsAtTopLevel);
+  }
+
+  FormatStyle Style;
+  std::string Code;
+  std::string FileName;
+
+  // Whether only the chunks touched by a range are formatted.
+  bool Incremental;
+
+  // The chunks of the code, see \c ChunkAnalyzer.
+  std::vector<ChunkAnalyzer::Chunk> Chunks;
+};
+
+FormatSession::FormatSession(const FormatStyle &Style, StringRef Code,
+                             StringRef FileName)
+    : Impl(new Implementation(Style, Code, FileName)) {}
+
+FormatSession::~FormatSession() {}
+
+StringRef FormatSession::getCode() const { return Impl->getCode(); }
+
+llvm::Error FormatSession::applyEdits(const tooling::Replacements &Edits) {
+  return Impl->applyEdits(Edits);
+}
+
+tooling::Replacements FormatSession::format(ArrayRef<tooling::Range> Ranges,
+                                            bool *IncompleteFormat) {
+  return Impl->format(Ranges, IncompleteFormat);
+}
+
 LangOptions getFormattingLangOpts(const FormatStyle &Style) {
   LangOptions LangOpts;
   LangOpts.CPlusPlus = 1;
@@ -1882,9 +2169,106 @@ static FormatStyle::LanguageKind getLanguageByFileName(StringRef FileName) {
   return FormatStyle::LK_Cpp;
 }
 
-FormatStyle getStyle(StringRef StyleName, StringRef FileName,
-                     StringRef FallbackStyle, StringRef Code,
-                     vfs::FileSystem *FS) {
+// Returns the configuration file in \p Directory, or an empty string if there
+// is none.
+static std::string findConfigFile(vfs::FileSystem *FS, StringRef Directory) {
+  auto Status = FS->status(Directory);
+  if (!Status ||
+      Status->getType() != llvm::sys::fs::file_type::directory_file)
+    return std::string();
+
+  SmallString<128> ConfigFile(Directory);
+  llvm::sys::path::append(ConfigFile, ".clang-format");
+  DEBUG(llvm::dbgs() << "Trying " << ConfigFile << "...\n");
+
+  Status = FS->status(ConfigFile.str());
+  bool IsFile =
+      Status && (Status->getType() == llvm::sys::fs::file_type::regular_file);
+  if (!IsFile) {
+    // Try _clang-format too, since dotfiles are not commonly used on Windows.
+    ConfigFile = Directory;
+    llvm::sys::path::append(ConfigFile, "_clang-format");
+    DEBUG(llvm::dbgs() << "Trying " << ConfigFile << "...\n");
+    Status = FS->status(ConfigFile.str());
+    IsFile = Status &&
+             (Status->getType() == llvm::sys::fs::file_type::regular_file);
+  }
+  return IsFile ? ConfigFile.str().str() : std::string();
+}
+
+namespace {
+
+// The result of applying a configuration file to a style.
+struct ParsedConfigFile {
+  // The error reading the file.
+  std::error_code ReadError;
+  // The error parsing the file, if it could be read.
+  std::error_code ParseError;
+  FormatStyle Style;
+};
+
+} // anonymous namespace
+
+static ParsedConfigFile parseConfigFile(vfs::FileSystem *FS,
+                                        StringRef ConfigFile,
+                                        const FormatStyle &Style) {
+  ParsedConfigFile Result;
+  Result.Style = Style;
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Text =
+      FS->getBufferForFile(ConfigFile);
+  if ((Result.ReadError = Text.getError()))
+    return Result;
+  Result.ParseError =
+      parseConfiguration(Text.get()->getBuffer(), &Result.Style);
+  return Result;
+}
+
+class StyleCache::Implementation {
+public:
+  Implementation(StringRef StyleName, StringRef FallbackStyle,
+                 vfs::FileSystem *FS)
+      : StyleName(StyleName), FallbackStyle(FallbackStyle), FS(FS) {}
+
+  std::string StyleName;
+  std::string FallbackStyle;
+  vfs::FileSystem *FS;
+
+  // Guards the maps below.
+  std::mutex Mutex;
+
+  // The configuration file of each directory looked at so far.
+  llvm::StringMap<std::string> ConfigFiles;
+
+  // The styles parsed from each configuration file, by language.
+  std::map<std::pair<std::string, FormatStyle::LanguageKind>, ParsedConfigFile>
+      ParsedConfigFiles;
+
+  std::string getConfigFile(StringRef Directory) {
+    auto I = ConfigFiles.find(Directory);
+    if (I != ConfigFiles.end())
+      return I->second;
+    std::string ConfigFile = findConfigFile(FS, Directory);
+    ConfigFiles[Directory] = ConfigFile;
+    return ConfigFile;
+  }
+
+  ParsedConfigFile parse(StringRef ConfigFile, const FormatStyle &Style) {
+    auto Key = std::make_pair(ConfigFile.str(), Style.Language);
+    auto I = ParsedConfigFiles.find(Key);
+    if (I != ParsedConfigFiles.end())
+      return I->second;
+    ParsedConfigFile Result = parseConfigFile(FS, ConfigFile, Style);
+    ParsedConfigFiles[Key] = Result;
+    return Result;
+  }
+};
+
+// Implements getStyle(), looking up the configuration files in \p Cache if it
+// is not null.
+static FormatStyle getStyle(StringRef StyleName, StringRef FileName,
+                            StringRef FallbackStyle, StringRef Code,
+                            vfs::FileSystem *FS,
+                            StyleCache::Implementation *Cache) {
   if (!FS) {
     FS = vfs::getRealFileSystem().get();
   }
@@ -1930,53 +2314,30 @@ FormatStyle getStyle(StringRef StyleName, StringRef FileName,
 
   for (StringRef Directory = Path; !Directory.empty();
        Directory = llvm::sys::path::parent_path(Directory)) {
-
-    auto Status = FS->status(Directory);
-    if (!Status ||
-        Status->getType() != llvm::sys::fs::file_type::directory_file) {
+    std::string ConfigFile = Cache ? Cache->getConfigFile(Directory)
+                                   : findConfigFile(FS, Directory);
+    if (ConfigFile.empty())
       continue;
-    }
 
-    SmallString<128> ConfigFile(Directory);
-
-    llvm::sys::path::append(ConfigFile, ".clang-format");
-    DEBUG(llvm::dbgs() << "Trying " << ConfigFile << "...\n");
-
-    Status = FS->status(ConfigFile.str());
-    bool IsFile =
-        Status && (Status->getType() == llvm::sys::fs::file_type::regular_file);
-    if (!IsFile) {
-      // Try _clang-format too, since dotfiles are not commonly used on Windows.
-      ConfigFile = Directory;
-      llvm::sys::path::append(ConfigFile, "_clang-format");
-      DEBUG(llvm::dbgs() << "Trying " << ConfigFile << "...\n");
-      Status = FS->status(ConfigFile.str());
-      IsFile = Status &&
-               (Status->getType() == llvm::sys::fs::file_type::regular_file);
+    ParsedConfigFile Parsed = Cache ? Cache->parse(ConfigFile, Style)
+                                    : parseConfigFile(FS, ConfigFile, Style);
+    if (Parsed.ReadError) {
+      llvm::errs() << Parsed.ReadError.message() << "\n";
+      break;
     }
-
-    if (IsFile) {
-      llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Text =
-          FS->getBufferForFile(ConfigFile.str());
-      if (std::error_code EC = Text.getError()) {
-        llvm::errs() << EC.message() << "\n";
-        break;
-      }
-      if (std::error_code ec =
-              parseConfiguration(Text.get()->getBuffer(), &Style)) {
-        if (ec == ParseError::Unsuitable) {
-          if (!UnsuitableConfigFiles.empty())
-            UnsuitableConfigFiles.append(", ");
-          UnsuitableConfigFiles.append(ConfigFile);
-          continue;
-        }
-        llvm::errs() << "Error reading " << ConfigFile << ": " << ec.message()
-                     << "\n";
-        break;
+    if (Parsed.ParseError) {
+      if (Parsed.ParseError == ParseError::Unsuitable) {
+        if (!UnsuitableConfigFiles.empty())
+          UnsuitableConfigFiles.append(", ");
+        UnsuitableConfigFiles.append(ConfigFile);
+        continue;
       }
-      DEBUG(llvm::dbgs() << "Using configuration file " << ConfigFile << "\n");
-      return Style;
+      llvm::errs() << "Error reading " << ConfigFile << ": "
+                   << Parsed.ParseError.message() << "\n";
+      break;
     }
+    DEBUG(llvm::dbgs() << "Using configuration file " << ConfigFile << "\n");
+    return Parsed.Style;
   }
   if (!UnsuitableConfigFiles.empty()) {
     llvm::errs() << "Configuration file(s) do(es) not support "
@@ -1986,5 +2347,25 @@ FormatStyle getStyle(StringRef StyleName, StringRef FileName,
   return Style;
 }
 
+FormatStyle getStyle(StringRef StyleName, StringRef FileName,
+                     StringRef FallbackStyle, StringRef Code,
+                     vfs::FileSystem *FS) {
+  return getStyle(StyleName, FileName, FallbackStyle, Code, FS,
+                  /*Cache=*/nullptr);
+}
+
+StyleCache::StyleCache(StringRef StyleName, StringRef FallbackStyle,
+                       vfs::FileSystem *FS)
+    : Impl(new Implementation(StyleName, FallbackStyle,
+                              FS ? FS : vfs::getRealFileSystem().get())) {}
+
+StyleCache::~StyleCache() {}
+
+FormatStyle StyleCache::getStyle(StringRef FileName, StringRef Code) {
+  std::lock_guard<std::mutex> Lock(Impl->Mutex);
+  return format::getStyle(Impl->StyleName, FileName, Impl->FallbackStyle, Code,
+                          Impl->FS, Impl.get());
+}
+
 } // namespace format
 } // namespace clang
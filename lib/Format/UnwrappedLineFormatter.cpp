@@ -9,7 +9,10 @@
 
 #include "UnwrappedLineFormatter.h"
 #include "WhitespaceManager.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/ThreadPool.h"
 #include <queue>
 
 #define DEBUG_TYPE "format-formatter"
@@ -476,7 +479,7 @@ public:
   LineFormatter(ContinuationIndenter *Indenter, WhitespaceManager *Whitespaces,
                 const FormatStyle &Style,
                 UnwrappedLineFormatter *BlockFormatter)
-      : Indenter(Indenter), Whitespaces(Whitespaces), Style(Style),
+      : Indenter(Indenter), Style(Style), Whitespaces(Whitespaces),
         BlockFormatter(BlockFormatter) {}
   virtual ~LineFormatter() {}
 
@@ -562,10 +565,10 @@ protected:
   }
 
   ContinuationIndenter *Indenter;
+  const FormatStyle &Style;
 
 private:
   WhitespaceManager *Whitespaces;
-  const FormatStyle &Style;
   UnwrappedLineFormatter *BlockFormatter;
 };
 
@@ -643,14 +646,31 @@ public:
   }
 
 private:
-  struct CompareLineStatePointers {
-    bool operator()(LineState *obj1, LineState *obj2) const {
-      return *obj1 < *obj2;
+  /// \brief Hashes and compares the \c LineStates pointed to like
+  /// \c LineState::operator<, with or without their \c ParenState stacks.
+  template <bool CompareStack> struct LineStatePointerInfo {
+    static LineState *getEmptyKey() {
+      return llvm::DenseMapInfo<LineState *>::getEmptyKey();
+    }
+    static LineState *getTombstoneKey() {
+      return llvm::DenseMapInfo<LineState *>::getTombstoneKey();
+    }
+    static unsigned getHashValue(const LineState *State) {
+      return State->getHash(CompareStack);
+    }
+    static bool isEqual(const LineState *LHS, const LineState *RHS) {
+      if (LHS == RHS || LHS == getEmptyKey() || LHS == getTombstoneKey() ||
+          RHS == getEmptyKey() || RHS == getTombstoneKey())
+        return LHS == RHS;
+      return LHS->isEquivalent(*RHS, CompareStack);
     }
   };
 
   /// \brief A pair of <penalty, count> that is used to prioritize the BFS on.
   ///
+  /// The penalty is the one of the state plus a lower bound of the penalty
+  /// needed to place the remaining tokens.
+  ///
   /// In case of equal penalties, we want to prefer states that were inserted
   /// first. During state generation we make sure that we insert states first
   /// that break the line as late as possible.
@@ -664,6 +684,9 @@ private:
     LineState State;
     bool NewLine;
     StateNode *Previous;
+
+    /// \brief The penalty with which \c State has been reached.
+    unsigned Penalty = 0;
   };
 
   /// \brief An item in the prioritized BFS search queue. The \c StateNode's
@@ -676,14 +699,19 @@ private:
 
   /// \brief Analyze the entire solution space starting from \p InitialState.
   ///
-  /// This implements a variant of Dijkstra's algorithm on the graph that spans
+  /// This implements a variant of the A* algorithm on the graph that spans
   /// the solution space (\c LineStates are the nodes). The algorithm tries to
   /// find the shortest path (the one with lowest penalty) from \p InitialState
   /// to a state where all tokens are placed. Returns the penalty.
   ///
+  /// The states are expanded in the order of their penalty plus the lower
+  /// bound from \c getMinimalRemainingPenalty, which never overestimates, so
+  /// the first complete state found has the lowest penalty.
+  ///
   /// If \p DryRun is \c false, directly applies the changes.
   unsigned analyzeSolutionSpace(LineState &InitialState, bool DryRun) {
-    std::set<LineState *, CompareLineStatePointers> Seen;
+    llvm::DenseSet<LineState *, LineStatePointerInfo<true>> Seen;
+    llvm::DenseSet<LineState *, LineStatePointerInfo<false>> SeenIgnoringStack;
 
     // Increasing count of \c StateNode items we have created. This is used to
     // create a deterministic order independent of the container.
@@ -700,8 +728,8 @@ private:
 
     // While not empty, take first element and follow edges.
     while (!Queue.empty()) {
-      Penalty = Queue.top().first.first;
       StateNode *Node = Queue.top().second;
+      Penalty = Node->Penalty;
       if (!Node->State.NextToken) {
         DEBUG(llvm::dbgs() << "\n---\nPenalty for line: " << Penalty << "\n");
         break;
@@ -713,7 +741,11 @@ private:
       if (Count > 50000)
         Node->State.IgnoreStackForComparison = true;
 
-      if (!Seen.insert(&Node->State).second)
+      // Both sets see every state, so that the one ignoring the stack covers
+      // the states examined before the cut off.
+      bool IsNew = Seen.insert(&Node->State).second;
+      bool IsNewIgnoringStack = SeenIgnoringStack.insert(&Node->State).second;
+      if (Node->State.IgnoreStackForComparison ? !IsNewIgnoringStack : !IsNew)
         // State already examined with lower penalty.
         continue;
 
@@ -758,11 +790,42 @@ private:
       return;
 
     Penalty += Indenter->addTokenToState(Node->State, NewLine, true);
+    Node->Penalty = Penalty;
 
-    Queue->push(QueueItem(OrderedPenalty(Penalty, *Count), Node));
+    Queue->push(QueueItem(
+        OrderedPenalty(Penalty + getMinimalRemainingPenalty(Node->State),
+                       *Count),
+        Node));
     ++(*Count);
   }
 
+  /// \brief Returns a lower bound of the penalty for placing the remaining
+  /// tokens after \p State.
+  ///
+  /// The tokens that cannot be preceded by a line break have to be placed on
+  /// the current line, and each of them ending behind the column limit adds
+  /// its excess characters. This stops at the tokens that can end up in a
+  /// lower column, such as multi-line and breakable tokens.
+  unsigned getMinimalRemainingPenalty(const LineState &State) {
+    if (Style.ColumnLimit == 0)
+      return 0;
+    unsigned ColumnLimit = Indenter->getColumnLimit(State);
+    unsigned Column = State.Column;
+    unsigned Penalty = 0;
+    for (const FormatToken *Tok = State.NextToken; Tok; Tok = Tok->Next) {
+      if (Tok->CanBreakBefore || Tok->closesBlockOrBlockTypeList(Style) ||
+          Tok->IsMultiline || Tok->isStringLiteral() ||
+          Tok->is(tok::comment) || !Tok->Children.empty() || Tok->Role ||
+          (Tok->Previous &&
+           (Tok->Previous->Role || !Tok->Previous->Children.empty())))
+        break;
+      Column += Tok->SpacesRequiredBefore + Tok->ColumnWidth;
+      if (Column > ColumnLimit)
+        Penalty += Style.PenaltyExcessCharacter * (Column - ColumnLimit);
+    }
+    return Penalty;
+  }
+
   /// \brief Applies the best formatting by reconstructing the path in the
   /// solution space that leads to \c Best.
   void reconstructPath(LineState &State, StateNode *Best) {
@@ -807,6 +870,9 @@ UnwrappedLineFormatter::format(const SmallVectorImpl<AnnotatedLine *> &Lines,
   if (DryRun && CacheIt != PenaltyCache.end())
     return CacheIt->second;
 
+  if (!DryRun && Threads > 1 && !Jobs)
+    return formatConcurrently(Lines, AdditionalIndent, FixBadIndentation);
+
   assert(!Lines.empty());
   unsigned Penalty = 0;
   LevelIndentTracker IndentTracker(Style, Keywords, Lines[0]->Level,
@@ -852,23 +918,25 @@ UnwrappedLineFormatter::format(const SmallVectorImpl<AnnotatedLine *> &Lines,
            (Style.Language != FormatStyle::LK_JavaScript ||
             !Style.JavaScriptWrapImports));
 
+      LineFormatterKind Kind = LFK_Optimizing;
       if (Style.ColumnLimit == 0)
-        NoColumnLimitLineFormatter(Indenter, Whitespaces, Style, this)
-            .formatLine(TheLine, Indent, DryRun);
+        Kind = LFK_NoColumnLimit;
       else if (FitsIntoOneLine)
-        Penalty += NoLineBreakFormatter(Indenter, Whitespaces, Style, this)
-                       .formatLine(TheLine, Indent, DryRun);
+        Kind = LFK_NoLineBreak;
+      if (Jobs)
+        Jobs->push_back({&TheLine, Indent, Kind});
       else
-        Penalty += OptimizingLineFormatter(Indenter, Whitespaces, Style, this)
-                       .formatLine(TheLine, Indent, DryRun);
+        Penalty += formatLine(TheLine, Indent, Kind, DryRun);
       RangeMinLevel = std::min(RangeMinLevel, TheLine.Level);
     } else {
       // If no token in the current line is affected, we still need to format
       // affected children.
-      if (TheLine.ChildrenAffected)
-        for (const FormatToken *Tok = TheLine.First; Tok; Tok = Tok->Next)
-          if (!Tok->Children.empty())
-            format(Tok->Children, DryRun);
+      if (TheLine.ChildrenAffected) {
+        if (Jobs)
+          Jobs->push_back({&TheLine, Indent, LFK_Children});
+        else
+          formatLine(TheLine, Indent, LFK_Children, DryRun);
+      }
 
       // Adapt following lines on the current indent level to the same level
       // unless the current \c AnnotatedLine is not at the beginning of a line.
@@ -896,7 +964,9 @@ UnwrappedLineFormatter::format(const SmallVectorImpl<AnnotatedLine *> &Lines,
       NextLine = Joiner.getNextMergedLine(DryRun, IndentTracker);
       RangeMinLevel = UINT_MAX;
     }
-    if (!DryRun)
+    // The lines prepared for formatConcurrently are finalized once their
+    // jobs are done.
+    if (!DryRun && !Jobs)
       markFinalized(TheLine.First);
     PreviousLine = &TheLine;
   }
@@ -904,6 +974,101 @@ UnwrappedLineFormatter::format(const SmallVectorImpl<AnnotatedLine *> &Lines,
   return Penalty;
 }
 
+unsigned UnwrappedLineFormatter::formatLine(const AnnotatedLine &Line,
+                                            unsigned Indent,
+                                            LineFormatterKind Kind,
+                                            bool DryRun) {
+  switch (Kind) {
+  case LFK_NoColumnLimit:
+    NoColumnLimitLineFormatter(Indenter, Whitespaces, Style, this)
+        .formatLine(Line, Indent, DryRun);
+    return 0;
+  case LFK_NoLineBreak:
+    return NoLineBreakFormatter(Indenter, Whitespaces, Style, this)
+        .formatLine(Line, Indent, DryRun);
+  case LFK_Optimizing:
+    return OptimizingLineFormatter(Indenter, Whitespaces, Style, this)
+        .formatLine(Line, Indent, DryRun);
+  case LFK_Children:
+    for (const FormatToken *Tok = Line.First; Tok; Tok = Tok->Next)
+      if (!Tok->Children.empty())
+        format(Tok->Children, DryRun);
+    return 0;
+  }
+  llvm_unreachable("unknown LineFormatterKind");
+}
+
+unsigned UnwrappedLineFormatter::formatConcurrently(
+    const SmallVectorImpl<AnnotatedLine *> &Lines, int AdditionalIndent,
+    bool FixBadIndentation) {
+  // Merging the lines, computing their indent and placing their first token
+  // depends on the previous lines, so it is done sequentially.
+  std::vector<LineJob> LineJobs;
+  Jobs = &LineJobs;
+  format(Lines, /*DryRun=*/false, AdditionalIndent, FixBadIndentation);
+  Jobs = nullptr;
+
+  // Make a few partitions per thread to even out the load.
+  unsigned TotalLength = 0;
+  for (const LineJob &Job : LineJobs)
+    TotalLength += Job.Line->Last->TotalLength;
+  unsigned PartitionLength = TotalLength / (4 * Threads) + 1;
+
+  ArrayRef<LineJob> AllJobs = LineJobs;
+  SmallVector<ArrayRef<LineJob>, 16> Partitions;
+  unsigned Begin = 0;
+  unsigned Length = 0;
+  for (unsigned I = 0, E = LineJobs.size(); I != E; ++I) {
+    if (I != Begin && Length >= PartitionLength &&
+        LineJobs[I].Line->Level == 0) {
+      Partitions.push_back(AllJobs.slice(Begin, I - Begin));
+      Begin = I;
+      Length = 0;
+    }
+    Length += LineJobs[I].Line->Last->TotalLength;
+  }
+  if (Begin != LineJobs.size())
+    Partitions.push_back(AllJobs.slice(Begin));
+
+  struct PartitionResult {
+    std::unique_ptr<WhitespaceManager> Whitespaces;
+    unsigned Penalty = 0;
+    bool IncompleteFormat = false;
+  };
+  std::vector<PartitionResult> Results(Partitions.size());
+  for (PartitionResult &Result : Results)
+    Result.Whitespaces =
+        llvm::make_unique<WhitespaceManager>(Whitespaces->createEmptyCopy());
+
+  if (!Partitions.empty()) {
+    llvm::ThreadPool Pool(std::min<unsigned>(Threads, Partitions.size()));
+    for (unsigned I = 0, E = Partitions.size(); I != E; ++I) {
+      Pool.async([this, &Partitions, &Results, I] {
+        PartitionResult &Result = Results[I];
+        ContinuationIndenter PartitionIndenter(*Indenter, *Result.Whitespaces);
+        UnwrappedLineFormatter PartitionFormatter(
+            &PartitionIndenter, Result.Whitespaces.get(), Style, Keywords,
+            &Result.IncompleteFormat);
+        for (const LineJob &Job : Partitions[I])
+          Result.Penalty += PartitionFormatter.formatLine(
+              *Job.Line, Job.Indent, Job.Kind, /*DryRun=*/false);
+      });
+    }
+    Pool.wait();
+  }
+
+  unsigned Penalty = 0;
+  for (const PartitionResult &Result : Results) {
+    Whitespaces->addChanges(*Result.Whitespaces);
+    Penalty += Result.Penalty;
+    if (Result.IncompleteFormat && IncompleteFormat)
+      *IncompleteFormat = true;
+  }
+  for (const AnnotatedLine *Line : Lines)
+    markFinalized(Line->First);
+  return Penalty;
+}
+
 void UnwrappedLineFormatter::formatFirstToken(FormatToken &RootToken,
                                               const AnnotatedLine *PreviousLine,
                                               unsigned IndentLevel,
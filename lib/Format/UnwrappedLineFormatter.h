@@ -19,6 +19,7 @@
 #include "ContinuationIndenter.h"
 #include "clang/Format/Format.h"
 #include <map>
+#include <vector>
 
 namespace clang {
 namespace format {
@@ -32,16 +33,52 @@ public:
                          WhitespaceManager *Whitespaces,
                          const FormatStyle &Style,
                          const AdditionalKeywords &Keywords,
-                         bool *IncompleteFormat)
+                         bool *IncompleteFormat, unsigned Threads = 1)
       : Indenter(Indenter), Whitespaces(Whitespaces), Style(Style),
-        Keywords(Keywords), IncompleteFormat(IncompleteFormat) {}
+        Keywords(Keywords), IncompleteFormat(IncompleteFormat),
+        Threads(Threads) {}
 
   /// \brief Format the current block and return the penalty.
+  ///
+  /// If the formatter was created with more than one thread, the lines are
+  /// formatted concurrently unless \p DryRun is \c true.
   unsigned format(const SmallVectorImpl<AnnotatedLine *> &Lines,
                   bool DryRun = false, int AdditionalIndent = 0,
                   bool FixBadIndentation = false);
 
 private:
+  /// \brief The ways of formatting a line that \c format chooses from.
+  enum LineFormatterKind {
+    LFK_NoColumnLimit,
+    LFK_NoLineBreak,
+    LFK_Optimizing,
+    /// Only the children of the line are formatted.
+    LFK_Children
+  };
+
+  /// \brief A line that \c format has prepared for formatting, i.e. whose
+  /// first token has been placed at \c Indent.
+  struct LineJob {
+    const AnnotatedLine *Line;
+    unsigned Indent;
+    LineFormatterKind Kind;
+  };
+
+  /// \brief Formats the tokens of \p Line after the first one and returns the
+  /// penalty.
+  unsigned formatLine(const AnnotatedLine &Line, unsigned Indent,
+                      LineFormatterKind Kind, bool DryRun);
+
+  /// \brief Formats \p Lines by preparing all of them on this thread and
+  /// formatting their partitions on \c Threads threads.
+  ///
+  /// The lines are only partitioned between top-level lines, so that each
+  /// declaration is formatted by a single thread. Every partition has its own
+  /// \c WhitespaceManager, whose changes are added to \c Whitespaces
+  /// afterwards.
+  unsigned formatConcurrently(const SmallVectorImpl<AnnotatedLine *> &Lines,
+                              int AdditionalIndent, bool FixBadIndentation);
+
   /// \brief Add a new line and the required indent before the first Token
   /// of the \c UnwrappedLine if there was no structural parsing error.
   void formatFirstToken(FormatToken &RootToken,
@@ -64,6 +101,13 @@ private:
   const FormatStyle &Style;
   const AdditionalKeywords &Keywords;
   bool *IncompleteFormat;
+
+  /// \brief The number of threads formatting the lines.
+  unsigned Threads;
+
+  /// \brief If not null, \c format only prepares the lines and adds them here
+  /// instead of formatting them.
+  std::vector<LineJob> *Jobs = nullptr;
 };
 } // end namespace format
 } // end namespace clang
@@ -78,6 +78,18 @@ public:
   /// \brief Returns all the \c Replacements created during formatting.
   const tooling::Replacements &generateReplacements();
 
+  /// \brief Returns a manager for the same file without any changes, to
+  /// record those of lines formatted on another thread.
+  WhitespaceManager createEmptyCopy() const {
+    return WhitespaceManager(SourceMgr, Style, UseCRLF);
+  }
+
+  /// \brief Adds the changes recorded by \p Other, which must be about other
+  /// tokens of the same file.
+  void addChanges(const WhitespaceManager &Other) {
+    Changes.append(Other.Changes.begin(), Other.Changes.end());
+  }
+
   /// \brief Represents a change before a token, a break inside a token,
   /// or the layout of an unchanged token (or whitespace within).
   struct Change {
@@ -57,6 +57,7 @@ void ASTMergeAction::ExecuteAction() {
                          Unit->getASTContext(), 
                          Unit->getFileManager(),
                          /*MinimalImport=*/false);
+    Importer.setIndexedLookup(true);
 
     TranslationUnitDecl *TU = Unit->getASTContext().getTranslationUnitDecl();
     for (auto *D : TU->decls()) {
@@ -20,6 +20,7 @@
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/TargetInfo.h"
 #include "clang/Basic/TargetOptions.h"
+#include "clang/Basic/Version.h"
 #include "clang/Basic/VirtualFileSystem.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/FrontendActions.h"
@@ -41,6 +42,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Mutex.h"
 #include "llvm/Support/MutexGuard.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <atomic>
@@ -83,6 +85,10 @@ namespace {
     /// \brief The file in which the precompiled preamble is stored.
     std::string PreambleFile;
 
+    /// \brief The precompiled preambles that PreambleFile extends, from the
+    /// one built from scratch to the one PreambleFile chains onto.
+    SmallVector<std::string, 4> ChainedPreambleFiles;
+
     /// \brief Temporary files that should be removed when the ASTUnit is
     /// destroyed.
     SmallVector<std::string, 4> TemporaryFiles;
@@ -90,7 +96,7 @@ namespace {
     /// \brief Erase temporary files.
     void CleanTemporaryFiles();
 
-    /// \brief Erase the preamble file.
+    /// \brief Erase the preamble file and the preambles it extends.
     void CleanPreambleFile();
 
     /// \brief Erase temporary files and the preamble file.
@@ -162,6 +168,18 @@ static const std::string &getPreambleFile(const ASTUnit *AU) {
   return getOnDiskData(AU).PreambleFile;  
 }
 
+/// \brief Keep the current preamble file as part of the chain of the preamble
+/// that extends it.
+static void chainPreambleFile(const ASTUnit *AU) {
+  OnDiskData &D = getOnDiskData(AU);
+  D.ChainedPreambleFiles.push_back(std::move(D.PreambleFile));
+  D.PreambleFile.clear();
+}
+
+static unsigned getNumChainedPreambleFiles(const ASTUnit *AU) {
+  return getOnDiskData(AU).ChainedPreambleFiles.size();
+}
+
 void OnDiskData::CleanTemporaryFiles() {
   for (StringRef File : TemporaryFiles)
     llvm::sys::fs::remove(File);
@@ -173,6 +191,9 @@ void OnDiskData::CleanPreambleFile() {
     llvm::sys::fs::remove(PreambleFile);
     PreambleFile.clear();
   }
+  for (StringRef File : ChainedPreambleFiles)
+    llvm::sys::fs::remove(File);
+  ChainedPreambleFiles.clear();
 }
 
 void OnDiskData::Cleanup() {
@@ -206,6 +227,10 @@ void ASTUnit::addTemporaryFile(StringRef TempFile) {
 /// preamble.
 const unsigned DefaultPreambleRebuildInterval = 5;
 
+/// \brief The number of times a precompiled preamble can be extended by a
+/// chained precompiled header before it is rebuilt from scratch.
+const unsigned MaxPreambleExtensions = 4;
+
 /// \brief Tracks the number of ASTUnit objects that are currently active.
 ///
 /// Used for debugging purposes only.
@@ -859,6 +884,10 @@ public:
   // We're not interested in "interesting" decls.
   void HandleInterestingDecl(DeclGroupRef) override {}
 
+  bool shouldSkipFunctionBody(Decl *D) override {
+    return Unit.shouldSkipFunctionBody(D);
+  }
+
   void HandleTopLevelDeclInObjCContainer(DeclGroupRef D) override {
     for (Decl *TopLevelDecl : D)
       handleTopLevelDecl(TopLevelDecl);
@@ -1051,6 +1080,11 @@ bool ASTUnit::Parse(std::shared_ptr<PCHContainerOperations> PCHContainerOps,
 
   Clang->setInvocation(CCInvocation.get());
   OriginalSourceFile = Clang->getFrontendOpts().Inputs[0].getFile();
+
+  // Skip the bodies that are evicted because of the memory budget; see
+  // shouldSkipFunctionBody.
+  if (EvictBodies)
+    Clang->getFrontendOpts().SkipFunctionBodies = true;
     
   // Set up diagnostics, capturing any diagnostics that would
   // otherwise be dropped.
@@ -1150,12 +1184,24 @@ bool ASTUnit::Parse(std::shared_ptr<PCHContainerOperations> PCHContainerOps,
   Act->EndSourceFile();
 
   FailedParseDiagnostics.clear();
+  recordFilesInLastParse();
+
+  // Once the AST is over its budget, evict the bodies outside the visible
+  // range from the next parses.
+  EvictedBodiesChanged = false;
+  if (MemoryBudget && !EvictBodies &&
+      Ctx->getASTAllocatedMemory() + Ctx->getSideTableAllocatedMemory() >
+          MemoryBudget) {
+    EvictBodies = true;
+    EvictedBodiesChanged = true;
+  }
 
   return false;
 
 error:
   // Remove the overridden buffer we used for the preamble.
   SavedMainFileBuffer = nullptr;
+  FilesInLastParse.clear();
 
   // Keep the ownership of the data in the ASTUnit because the client may
   // want to see the diagnostics.
@@ -1316,6 +1362,163 @@ makeStandaloneDiagnostic(const LangOptions &LangOpts,
   return OutDiag;
 }
 
+/// \brief Whether the only file remapped by \p PPOpts is the main file
+/// \p MainFilePath, whose preamble is part of the key of the preamble cache.
+static bool remapsOnlyMainFile(const PreprocessorOptions &PPOpts,
+                               StringRef MainFilePath) {
+  for (const auto &R : PPOpts.RemappedFiles)
+    if (R.first != MainFilePath)
+      return false;
+  for (const auto &RB : PPOpts.RemappedFileBuffers)
+    if (RB.first != MainFilePath)
+      return false;
+  return true;
+}
+
+/// \brief Compute the name of the entry of the preamble cache for the
+/// preamble \p PreambleText of a translation unit parsed with the command line
+/// hashed as \p CommandLineHash.
+static std::string getPreambleCacheKey(StringRef CommandLineHash,
+                                       StringRef PreambleText,
+                                       bool PreambleEndsAtStartOfLine) {
+  llvm::MD5 Hash;
+  Hash.update(getClangFullRepositoryVersion());
+  Hash.update(CommandLineHash);
+  Hash.update(PreambleText);
+  Hash.update(PreambleEndsAtStartOfLine ? "1" : "0");
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Key;
+  llvm::MD5::stringifyResult(Result, Key);
+  return Key.str();
+}
+
+/// \brief Write \p Contents to \p File through a temporary file, so that the
+/// other processes using the preamble cache never see a partial file.
+///
+/// \returns true if an error occurred.
+static bool writeFileAtomically(StringRef File, StringRef Contents) {
+  SmallString<128> TempPath;
+  TempPath = File;
+  TempPath += "-%%%%%%%%";
+  int fd;
+  if (llvm::sys::fs::createUniqueFile(TempPath, fd, TempPath))
+    return true;
+
+  llvm::raw_fd_ostream Out(fd, /*shouldClose=*/true);
+  Out << Contents;
+  Out.close();
+  if (Out.has_error()) {
+    Out.clear_error();
+    llvm::sys::fs::remove(TempPath);
+    return true;
+  }
+
+  if (llvm::sys::fs::rename(TempPath, File)) {
+    llvm::sys::fs::remove(TempPath);
+    return true;
+  }
+  return false;
+}
+
+/// \brief Copy the precompiled preamble stored under \p Key in the preamble
+/// cache to \p PreamblePCHPath, if the files it was built from have not
+/// changed since, and restore the state that building it would have set up.
+///
+/// The entry of the cache consists of the precompiled preamble, Key.pch, and
+/// of Key.deps, which lists the top-level hash value, the top-level
+/// declarations and the files of the preamble.
+///
+/// \returns true if the precompiled preamble was loaded from the cache.
+bool ASTUnit::loadPreambleFromCache(StringRef Key, StringRef PreamblePCHPath) {
+  SmallString<128> Entry(PreambleCacheDirectory);
+  llvm::sys::path::append(Entry, Key);
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Deps =
+      llvm::MemoryBuffer::getFile(Entry + ".deps");
+  if (!Deps)
+    return false;
+
+  unsigned TopLevelHashValue = 0;
+  std::vector<serialization::DeclID> TopLevelDecls;
+  llvm::StringMap<PreambleFileHash> Files;
+  SmallVector<StringRef, 32> Lines;
+  (*Deps)->getBuffer().split(Lines, '\n', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  for (StringRef Line : Lines) {
+    StringRef Kind, Value;
+    std::tie(Kind, Value) = Line.split(' ');
+    if (Kind == "hash") {
+      if (Value.getAsInteger(10, TopLevelHashValue))
+        return false;
+    } else if (Kind == "decl") {
+      serialization::DeclID ID;
+      if (Value.getAsInteger(10, ID))
+        return false;
+      TopLevelDecls.push_back(ID);
+    } else if (Kind == "file") {
+      StringRef Size, ModTime, Filename;
+      std::tie(Size, Value) = Value.split(' ');
+      std::tie(ModTime, Filename) = Value.split(' ');
+      PreambleFileHash Hash = PreambleFileHash::createForFile(0, 0);
+      if (Size.getAsInteger(10, Hash.Size) ||
+          ModTime.getAsInteger(10, Hash.ModTime) || Filename.empty())
+        return false;
+
+      // The entry is stale if any of the files changed since it was stored.
+      vfs::Status Status;
+      if (FileMgr->getNoncachedStatValue(Filename, Status) ||
+          Status.getSize() != uint64_t(Hash.Size) ||
+          llvm::sys::toTimeT(Status.getLastModificationTime()) != Hash.ModTime)
+        return false;
+      Files[Filename] = Hash;
+    } else {
+      return false;
+    }
+  }
+
+  if (llvm::sys::fs::copy_file(Entry + ".pch", PreamblePCHPath))
+    return false;
+
+  CurrentTopLevelHashValue = TopLevelHashValue;
+  TopLevelDeclsInPreamble = std::move(TopLevelDecls);
+  FilesInPreamble = std::move(Files);
+  return true;
+}
+
+/// \brief Store the precompiled preamble \p PreamblePCHPath that was just
+/// built in the preamble cache under \p Key.
+void ASTUnit::storePreambleInCache(StringRef Key, StringRef PreamblePCHPath) {
+  // The diagnostics of the preamble are not stored, and the unsaved files it
+  // may depend on are not available to other processes.
+  if (!PreambleDiagnostics.empty())
+    return;
+
+  std::string Deps;
+  llvm::raw_string_ostream OS(Deps);
+  OS << "hash " << PreambleTopLevelHashValue << '\n';
+  for (serialization::DeclID ID : TopLevelDeclsInPreamble)
+    OS << "decl " << ID << '\n';
+  for (const auto &F : FilesInPreamble) {
+    if (!F.second.ModTime)
+      return;
+    OS << "file " << F.second.Size << ' ' << F.second.ModTime << ' '
+       << F.first() << '\n';
+  }
+  OS.flush();
+
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> PCH =
+      llvm::MemoryBuffer::getFile(PreamblePCHPath);
+  if (!PCH || llvm::sys::fs::create_directories(PreambleCacheDirectory))
+    return;
+
+  // The dependencies are written last, since their presence is what makes
+  // the entry visible to loadPreambleFromCache().
+  SmallString<128> Entry(PreambleCacheDirectory);
+  llvm::sys::path::append(Entry, Key);
+  if (writeFileAtomically(Entry + ".pch", (*PCH)->getBuffer()))
+    return;
+  writeFileAtomically(Entry + ".deps", Deps);
+}
+
 /// \brief Attempt to build or re-use a precompiled preamble when (re-)parsing
 /// the source file.
 ///
@@ -1361,17 +1564,36 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
     return nullptr;
   }
   
+  // Whether the new preamble only appends directives to the precompiled one,
+  // which is then extended by a precompiled header chained onto it instead of
+  // being rebuilt.
+  bool ExtendPreamble = false;
+  unsigned ExtendedPreambleSize = 0;
+
   if (!Preamble.empty()) {
     // We've previously computed a preamble. Check whether we have the same
     // preamble now that we did before, and that there's enough space in
     // the main-file buffer within the precompiled preamble to fit the
     // new main file.
-    if (Preamble.size() == NewPreamble.Size &&
+    bool SamePreamble =
+        Preamble.size() == NewPreamble.Size &&
         PreambleEndsAtStartOfLine == NewPreamble.PreambleEndsAtStartOfLine &&
         memcmp(Preamble.getBufferStart(), NewPreamble.Buffer->getBufferStart(),
-               NewPreamble.Size) == 0) {
-      // The preamble has not changed. We may be able to re-use the precompiled
-      // preamble.
+               NewPreamble.Size) == 0;
+
+    // Otherwise, check whether the new preamble starts with the whole lines
+    // of the previous one, e.g. because an #include was added at its end.
+    bool AppendedToPreamble =
+        !SamePreamble && AllowRebuild && PreambleEndsAtStartOfLine &&
+        Preamble.size() < NewPreamble.Size &&
+        PreprocessorOpts.ImplicitPCHInclude.empty() &&
+        getNumChainedPreambleFiles(this) < MaxPreambleExtensions &&
+        memcmp(Preamble.getBufferStart(), NewPreamble.Buffer->getBufferStart(),
+               Preamble.size()) == 0;
+
+    if (SamePreamble || AppendedToPreamble) {
+      // The precompiled preamble still matches the start of the main file. We
+      // may be able to re-use or extend it.
 
       // Check that none of the files used by the preamble have changed.
       bool AnyFileChanged = false;
@@ -1439,7 +1661,7 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
           AnyFileChanged = true;
       }
           
-      if (!AnyFileChanged) {
+      if (!AnyFileChanged && SamePreamble) {
         // Okay! We can re-use the precompiled preamble.
 
         // Set the state of the diagnostic object to mimic its state
@@ -1452,6 +1674,11 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
         return llvm::MemoryBuffer::getMemBufferCopy(
             NewPreamble.Buffer->getBuffer(), FrontendOpts.Inputs[0].getFile());
       }
+
+      if (!AnyFileChanged) {
+        ExtendPreamble = true;
+        ExtendedPreambleSize = Preamble.size();
+      }
     }
 
     // If we aren't allowed to rebuild the precompiled preamble, just
@@ -1459,10 +1686,12 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
     if (!AllowRebuild)
       return nullptr;
 
-    // We can't reuse the previously-computed preamble. Build a new one.
-    Preamble.clear();
-    PreambleDiagnostics.clear();
-    erasePreambleFile(this);
+    if (!ExtendPreamble) {
+      // We can't reuse the previously-computed preamble. Build a new one.
+      Preamble.clear();
+      PreambleDiagnostics.clear();
+      erasePreambleFile(this);
+    }
     PreambleRebuildCounter = 1;
   } else if (!AllowRebuild) {
     // We aren't allowed to rebuild the precompiled preamble; just
@@ -1487,13 +1716,54 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
     return nullptr;
   }
   
+  // Look for a preamble that another translation unit with the same command
+  // line and the same preamble precompiled in the preamble cache.
+  StringRef MainFilename = FrontendOpts.Inputs[0].getFile();
+  std::string PreambleCacheKey;
+  if (!PreambleCacheDirectory.empty() && !ExtendPreamble &&
+      remapsOnlyMainFile(PreprocessorOpts, MainFilename)) {
+    PreambleCacheKey = getPreambleCacheKey(
+        CommandLineHash,
+        NewPreamble.Buffer->getBuffer().slice(0, NewPreamble.Size),
+        NewPreamble.PreambleEndsAtStartOfLine);
+
+    SimpleTimer CacheTimer(WantTiming);
+    CacheTimer.setOutput("Looking up the precompiled preamble in the cache");
+    if (loadPreambleFromCache(PreambleCacheKey, PreamblePCHPath)) {
+      Preamble.assign(FileMgr->getFile(MainFilename),
+                      NewPreamble.Buffer->getBufferStart(),
+                      NewPreamble.Buffer->getBufferStart() + NewPreamble.Size);
+      PreambleEndsAtStartOfLine = NewPreamble.PreambleEndsAtStartOfLine;
+      OriginalSourceFile = MainFilename;
+      setPreambleFile(this, PreamblePCHPath);
+      PreambleDiagnostics.clear();
+      NumWarningsInPreamble = 0;
+      TopLevelDecls.clear();
+
+      // Set the state of the diagnostic object to mimic its state
+      // after parsing the preamble.
+      getDiagnostics().Reset();
+      ProcessWarningOptions(getDiagnostics(),
+                            PreambleInvocation->getDiagnosticOpts());
+      checkAndRemoveNonDriverDiags(StoredDiagnostics);
+
+      PreambleRebuildCounter = 1;
+      if (CurrentTopLevelHashValue != PreambleTopLevelHashValue) {
+        CompletionCacheTopLevelHashValue = 0;
+        PreambleTopLevelHashValue = CurrentTopLevelHashValue;
+      }
+
+      return llvm::MemoryBuffer::getMemBufferCopy(
+          NewPreamble.Buffer->getBuffer(), MainFilename);
+    }
+  }
+
   // We did not previously compute a preamble, or it can't be reused anyway.
   SimpleTimer PreambleTimer(WantTiming);
   PreambleTimer.setOutput("Precompiling preamble");
 
   // Save the preamble text for later; we'll need to compare against it for
   // subsequent reparses.
-  StringRef MainFilename = FrontendOpts.Inputs[0].getFile();
   Preamble.assign(FileMgr->getFile(MainFilename),
                   NewPreamble.Buffer->getBufferStart(),
                   NewPreamble.Buffer->getBufferStart() + NewPreamble.Size);
@@ -1510,8 +1780,20 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
   FrontendOpts.ProgramAction = frontend::GeneratePCH;
   // FIXME: Generate the precompiled header into memory?
   FrontendOpts.OutputFile = PreamblePCHPath;
-  PreprocessorOpts.PrecompiledPreambleBytes.first = 0;
-  PreprocessorOpts.PrecompiledPreambleBytes.second = false;
+  if (ExtendPreamble) {
+    // Load the previous preamble and skip the part of the main file it
+    // covers. The precompiled header then only contains the appended
+    // directives, and chains onto the previous preamble. The locations of
+    // the previous preamble keep referring to its own copy of the main file;
+    // see getPreambleFileIDs().
+    PreprocessorOpts.PrecompiledPreambleBytes.first = ExtendedPreambleSize;
+    PreprocessorOpts.PrecompiledPreambleBytes.second = true;
+    PreprocessorOpts.ImplicitPCHInclude = getPreambleFile(this);
+    PreprocessorOpts.DisablePCHValidation = true;
+  } else {
+    PreprocessorOpts.PrecompiledPreambleBytes.first = 0;
+    PreprocessorOpts.PrecompiledPreambleBytes.second = false;
+  }
   
   // Create the compiler instance to use for building the precompiled preamble.
   std::unique_ptr<CompilerInstance> Clang(
@@ -1532,6 +1814,7 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
       Clang->getDiagnostics(), Clang->getInvocation().TargetOpts));
   if (!Clang->hasTarget()) {
     llvm::sys::fs::remove(FrontendOpts.OutputFile);
+    erasePreambleFile(this);
     Preamble.clear();
     PreambleRebuildCounter = DefaultPreambleRebuildInterval;
     PreprocessorOpts.RemappedFileBuffers.pop_back();
@@ -1556,8 +1839,15 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
   ProcessWarningOptions(getDiagnostics(), Clang->getDiagnosticOpts());
   checkAndRemoveNonDriverDiags(StoredDiagnostics);
   TopLevelDecls.clear();
-  TopLevelDeclsInPreamble.clear();
-  PreambleDiagnostics.clear();
+  // An extended preamble keeps the declarations and the diagnostics of the
+  // preamble it chains onto.
+  unsigned NumWarningsInExtendedPreamble = 0;
+  if (ExtendPreamble) {
+    NumWarningsInExtendedPreamble = NumWarningsInPreamble;
+  } else {
+    TopLevelDeclsInPreamble.clear();
+    PreambleDiagnostics.clear();
+  }
 
   IntrusiveRefCntPtr<vfs::FileSystem> VFS =
       createVFSFromCompilerInvocation(Clang->getInvocation(), getDiagnostics());
@@ -1578,6 +1868,7 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
   Act.reset(new PrecompilePreambleAction(*this));
   if (!Act->BeginSourceFile(*Clang.get(), Clang->getFrontendOpts().Inputs[0])) {
     llvm::sys::fs::remove(FrontendOpts.OutputFile);
+    erasePreambleFile(this);
     Preamble.clear();
     PreambleRebuildCounter = DefaultPreambleRebuildInterval;
     PreprocessorOpts.RemappedFileBuffers.pop_back();
@@ -1603,6 +1894,7 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
     // so no precompiled header was generated. Forget that we even tried.
     // FIXME: Should we leave a note for ourselves to try again?
     llvm::sys::fs::remove(FrontendOpts.OutputFile);
+    erasePreambleFile(this);
     Preamble.clear();
     TopLevelDeclsInPreamble.clear();
     PreambleRebuildCounter = DefaultPreambleRebuildInterval;
@@ -1610,13 +1902,18 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
     return nullptr;
   }
   
-  // Keep track of the preamble we precompiled.
+  // Keep track of the preamble we precompiled, and of the one it extends.
+  if (ExtendPreamble)
+    chainPreambleFile(this);
   setPreambleFile(this, FrontendOpts.OutputFile);
-  NumWarningsInPreamble = getDiagnostics().getNumWarnings();
+  NumWarningsInPreamble =
+      NumWarningsInExtendedPreamble + getDiagnostics().getNumWarnings();
   
   // Keep track of all of the files that the source manager knows about,
-  // so we can verify whether they have changed or not.
-  FilesInPreamble.clear();
+  // so we can verify whether they have changed or not. The files of an
+  // extended preamble have not changed.
+  if (!ExtendPreamble)
+    FilesInPreamble.clear();
   SourceManager &SourceMgr = Clang->getSourceManager();
   for (auto &Filename : PreambleDepCollector->getDependencies()) {
     const FileEntry *File = Clang->getFileManager().getFile(Filename);
@@ -1643,6 +1940,9 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
     PreambleTopLevelHashValue = CurrentTopLevelHashValue;
   }
 
+  if (!PreambleCacheKey.empty())
+    storePreambleInCache(PreambleCacheKey, FrontendOpts.OutputFile);
+
   return llvm::MemoryBuffer::getMemBufferCopy(NewPreamble.Buffer->getBuffer(),
                                               MainFilename);
 }
@@ -1946,7 +2246,8 @@ ASTUnit *ASTUnit::LoadFromCommandLine(
     bool CacheCodeCompletionResults, bool IncludeBriefCommentsInCodeCompletion,
     bool AllowPCHWithCompilerErrors, bool SkipFunctionBodies,
     bool UserFilesAreVolatile, bool ForSerialization,
-    llvm::Optional<StringRef> ModuleFormat, std::unique_ptr<ASTUnit> *ErrAST) {
+    llvm::Optional<StringRef> ModuleFormat, StringRef PreambleCacheDirectory,
+    std::unique_ptr<ASTUnit> *ErrAST) {
   assert(Diags.get() && "no DiagnosticsEngine was provided");
 
   SmallVector<StoredDiagnostic, 4> StoredDiagnostics;
@@ -2005,6 +2306,22 @@ ASTUnit *ASTUnit::LoadFromCommandLine(
   AST->Invocation = CI;
   if (ForSerialization)
     AST->WriterData.reset(new ASTWriterData());
+  if (!PreambleCacheDirectory.empty()) {
+    // The preamble is only shared with the translation units that are parsed
+    // with the same arguments from the same directory.
+    AST->PreambleCacheDirectory = PreambleCacheDirectory;
+    llvm::MD5 Hash;
+    SmallString<128> WorkingDir;
+    if (!llvm::sys::fs::current_path(WorkingDir))
+      Hash.update(WorkingDir);
+    for (const char **Arg = ArgBegin; Arg != ArgEnd; ++Arg) {
+      Hash.update(*Arg);
+      Hash.update(StringRef("", 1));
+    }
+    llvm::MD5::MD5Result Result;
+    Hash.final(Result);
+    llvm::MD5::stringifyResult(Result, AST->CommandLineHash);
+  }
   // Zero out now to ease cleanup during crash recovery.
   CI = nullptr;
   Diags = nullptr;
@@ -2027,11 +2344,120 @@ ASTUnit *ASTUnit::LoadFromCommandLine(
   return AST.release();
 }
 
+void ASTUnit::recordFilesInLastParse() {
+  FilesInLastParse.clear();
+  RemappedFilesInLastParse.clear();
+
+  for (SourceManager::fileinfo_iterator I = SourceMgr->fileinfo_begin(),
+                                        E = SourceMgr->fileinfo_end();
+       I != E; ++I) {
+    for (const FileEntry *File : {I->first, I->second->ContentsEntry}) {
+      if (File)
+        FilesInLastParse[File->getName()] = PreambleFileHash::createForFile(
+            File->getSize(), File->getModificationTime());
+    }
+  }
+
+  // The files read for the preamble are not necessarily in the source manager.
+  for (const auto &F : FilesInPreamble)
+    FilesInLastParse.insert(std::make_pair(F.first(), F.second));
+
+  for (const auto &RB : Invocation->getPreprocessorOpts().RemappedFileBuffers)
+    RemappedFilesInLastParse[RB.first] =
+        PreambleFileHash::createForMemoryBuffer(RB.second);
+
+  // The main file is the one being edited, so compare its contents rather
+  // than trusting its size and modification time.
+  if (!RemappedFilesInLastParse.count(OriginalSourceFile))
+    if (auto Buffer = FileMgr->getBufferForFile(OriginalSourceFile))
+      FilesInLastParse[OriginalSourceFile] =
+          PreambleFileHash::createForMemoryBuffer(Buffer->get());
+}
+
+bool ASTUnit::anyFileChangedSinceLastParse(
+    ArrayRef<RemappedFile> RemappedFiles) {
+  if (FilesInLastParse.empty())
+    return true;
+
+  // The remapped files need to be the same, with the same contents.
+  if (RemappedFiles.size() != RemappedFilesInLastParse.size())
+    return true;
+  for (const auto &RF : RemappedFiles) {
+    auto Known = RemappedFilesInLastParse.find(RF.first);
+    if (Known == RemappedFilesInLastParse.end() ||
+        Known->second != PreambleFileHash::createForMemoryBuffer(RF.second))
+      return true;
+  }
+
+  // The other files need to be unchanged on disk.
+  for (const auto &F : FilesInLastParse) {
+    if (RemappedFilesInLastParse.count(F.first()))
+      continue;
+
+    // Files without a modification time were recorded by their contents.
+    if (!F.second.ModTime) {
+      auto Buffer = FileMgr->getBufferForFile(F.first());
+      if (!Buffer ||
+          F.second != PreambleFileHash::createForMemoryBuffer(Buffer->get()))
+        return true;
+      continue;
+    }
+
+    vfs::Status Status;
+    if (FileMgr->getNoncachedStatValue(F.first(), Status))
+      return true;
+    if (Status.getSize() != uint64_t(F.second.Size) ||
+        llvm::sys::toTimeT(Status.getLastModificationTime()) !=
+            F.second.ModTime)
+      return true;
+  }
+  return false;
+}
+
+void ASTUnit::setMemoryBudget(uint64_t Budget, unsigned Begin, unsigned End) {
+  if (!Budget) {
+    EvictedBodiesChanged |= EvictBodies;
+    EvictBodies = false;
+  } else if (EvictBodies && (Begin != VisibleBegin || End != VisibleEnd)) {
+    EvictedBodiesChanged = true;
+  }
+  MemoryBudget = Budget;
+  VisibleBegin = Begin;
+  VisibleEnd = End;
+}
+
+bool ASTUnit::shouldSkipFunctionBody(Decl *D) {
+  // Skip every body when asked to by the invocation.
+  if (!EvictBodies || Invocation->getFrontendOpts().SkipFunctionBodies)
+    return true;
+
+  // Otherwise, only the bodies in the main file outside the visible range are
+  // evicted.
+  SourceManager &SM = getSourceManager();
+  SourceLocation Loc = SM.getExpansionLoc(D->getLocStart());
+  if (!SM.isInMainFile(Loc))
+    return false;
+  unsigned Offset = SM.getFileOffset(Loc);
+  return Offset < VisibleBegin || Offset >= VisibleEnd;
+}
+
 bool ASTUnit::Reparse(std::shared_ptr<PCHContainerOperations> PCHContainerOps,
                       ArrayRef<RemappedFile> RemappedFiles) {
   if (!Invocation)
     return true;
 
+  // If none of the inputs of the last parse have changed, reparsing would
+  // produce the same AST; keep it. This is not done when a preamble is yet to
+  // be built, which the reparse would do.
+  bool PreamblePending =
+      getPreambleFile(this).empty() && PreambleRebuildCounter > 0;
+  if (!PreamblePending && !EvictedBodiesChanged &&
+      !anyFileChangedSinceLastParse(RemappedFiles)) {
+    for (const auto &RemappedFile : RemappedFiles)
+      delete RemappedFile.second;
+    return false;
+  }
+
   clearFileLevelDecls();
   
   SimpleTimer ParsingTimer(WantTiming);
@@ -2674,22 +3100,49 @@ SourceLocation ASTUnit::getLocation(const FileEntry *File,
   return SM.getMacroArgExpandedLocation(FileLoc.getLocWithOffset(Offset));
 }
 
+/// \brief Collect the file IDs of the main file in the loaded precompiled
+/// preamble and in the preambles it extends, from the one that was built from
+/// scratch to the loaded one.
+///
+/// Each extension only contains the directives that were appended to the
+/// preamble it chains onto, and its copy of the main file is exactly as large
+/// as its preamble, so the sizes of these file IDs increase along the chain.
+void ASTUnit::getPreambleFileIDs(SmallVectorImpl<FileID> &FIDs) const {
+  if (!SourceMgr || SourceMgr->getPreambleFileID().isInvalid())
+    return;
+
+  // Each extension is loaded before the preamble it chains onto.
+  if (Reader) {
+    for (serialization::ModuleFile *M :
+         llvm::reverse(Reader->getModuleManager().pch_modules()))
+      if (M->Kind == serialization::MK_Preamble &&
+          M->OriginalSourceFileID.isValid())
+        FIDs.push_back(M->OriginalSourceFileID);
+  }
+
+  if (FIDs.empty())
+    FIDs.push_back(SourceMgr->getPreambleFileID());
+}
+
 /// \brief If \arg Loc is a loaded location from the preamble, returns
 /// the corresponding local location of the main file, otherwise it returns
 /// \arg Loc.
 SourceLocation ASTUnit::mapLocationFromPreamble(SourceLocation Loc) {
-  FileID PreambleID;
-  if (SourceMgr)
-    PreambleID = SourceMgr->getPreambleFileID();
-
-  if (Loc.isInvalid() || Preamble.empty() || PreambleID.isInvalid())
+  if (Loc.isInvalid() || Preamble.empty())
     return Loc;
 
+  SmallVector<FileID, 4> PreambleIDs;
+  getPreambleFileIDs(PreambleIDs);
+
   unsigned Offs;
-  if (SourceMgr->isInFileID(Loc, PreambleID, &Offs) && Offs < Preamble.size()) {
-    SourceLocation FileLoc
-        = SourceMgr->getLocForStartOfFile(SourceMgr->getMainFileID());
-    return FileLoc.getLocWithOffset(Offs);
+  for (FileID PreambleID : PreambleIDs) {
+    if (SourceMgr->isInFileID(Loc, PreambleID, &Offs)) {
+      if (Offs >= Preamble.size())
+        return Loc;
+      SourceLocation FileLoc
+          = SourceMgr->getLocForStartOfFile(SourceMgr->getMainFileID());
+      return FileLoc.getLocWithOffset(Offs);
+    }
   }
 
   return Loc;
@@ -2698,17 +3151,28 @@ SourceLocation ASTUnit::mapLocationFromPreamble(SourceLocation Loc) {
 /// \brief If \arg Loc is a local location of the main file but inside the
 /// preamble chunk, returns the corresponding loaded location from the
 /// preamble, otherwise it returns \arg Loc.
+///
+/// If the preamble was extended, the location is mapped into the preamble
+/// that covers it.
 SourceLocation ASTUnit::mapLocationToPreamble(SourceLocation Loc) {
-  FileID PreambleID;
-  if (SourceMgr)
-    PreambleID = SourceMgr->getPreambleFileID();
+  if (Loc.isInvalid() || Preamble.empty())
+    return Loc;
 
-  if (Loc.isInvalid() || Preamble.empty() || PreambleID.isInvalid())
+  SmallVector<FileID, 4> PreambleIDs;
+  getPreambleFileIDs(PreambleIDs);
+  if (PreambleIDs.empty())
     return Loc;
 
   unsigned Offs;
   if (SourceMgr->isInFileID(Loc, SourceMgr->getMainFileID(), &Offs) &&
       Offs < Preamble.size()) {
+    FileID PreambleID = PreambleIDs.back();
+    for (FileID ID : PreambleIDs) {
+      if (Offs < SourceMgr->getFileIDSize(ID)) {
+        PreambleID = ID;
+        break;
+      }
+    }
     SourceLocation FileLoc = SourceMgr->getLocForStartOfFile(PreambleID);
     return FileLoc.getLocWithOffset(Offs);
   }
@@ -2717,14 +3181,16 @@ SourceLocation ASTUnit::mapLocationToPreamble(SourceLocation Loc) {
 }
 
 bool ASTUnit::isInPreambleFileID(SourceLocation Loc) {
-  FileID FID;
-  if (SourceMgr)
-    FID = SourceMgr->getPreambleFileID();
-  
-  if (Loc.isInvalid() || FID.isInvalid())
+  if (Loc.isInvalid())
     return false;
-  
-  return SourceMgr->isInFileID(Loc, FID);
+
+  SmallVector<FileID, 4> PreambleIDs;
+  getPreambleFileIDs(PreambleIDs);
+  for (FileID PreambleID : PreambleIDs)
+    if (SourceMgr->isInFileID(Loc, PreambleID))
+      return true;
+
+  return false;
 }
 
 bool ASTUnit::isInMainFileID(SourceLocation Loc) {
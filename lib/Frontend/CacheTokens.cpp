@@ -490,6 +490,11 @@ void PTHWriter::GeneratePTH(StringRef MainFile) {
   Out << "cfe-pth" << '\0';
   Emit32(PTHManager::Version);
 
+  // Record the language options that the tokens are lexed with.
+  uint64_t Fingerprint = PTHManager::getLexerFingerprint(PP.getLangOpts());
+  Emit32(Fingerprint);
+  Emit32(Fingerprint >> 32);
+
   // Leave 4 words for the prologue.
   Offset PrologueOffset = Out.tell();
   for (unsigned i = 0; i < 4; ++i)
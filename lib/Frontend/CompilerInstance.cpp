@@ -15,6 +15,7 @@
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Basic/TargetInfo.h"
+#include "clang/Basic/TimeTrace.h"
 #include "clang/Basic/Version.h"
 #include "clang/Config/config.h"
 #include "clang/Frontend/ChainedDiagnosticConsumer.h"
@@ -27,6 +28,7 @@
 #include "clang/Frontend/Utils.h"
 #include "clang/Frontend/VerifyDiagnosticConsumer.h"
 #include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/PPCallbacks.h"
 #include "clang/Lex/PTHManager.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Lex/PreprocessorOptions.h"
@@ -35,6 +37,7 @@
 #include "clang/Serialization/ASTReader.h"
 #include "clang/Serialization/GlobalModuleIndex.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/Support/CrashRecoveryContext.h"
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/FileSystem.h"
@@ -46,6 +49,8 @@
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
+#include <condition_variable>
+#include <mutex>
 #include <sys/stat.h>
 #include <system_error>
 #include <time.h>
@@ -201,6 +206,42 @@ static void collectVFSEntries(CompilerInstance &CI,
     MDC->addFile(E.VPath, E.RPath);
 }
 
+namespace {
+/// \brief Records the time spent in each source file in the time trace, from
+/// entering the file to leaving it, including the files it includes.
+class TimeTraceSourceCallbacks : public PPCallbacks {
+  TimeTracer &Tracer;
+  SourceManager &SM;
+  /// The events of the files being processed, or ~0U for the buffers that
+  /// are not files.
+  SmallVector<unsigned, 16> Events;
+
+public:
+  TimeTraceSourceCallbacks(TimeTracer &Tracer, SourceManager &SM)
+      : Tracer(Tracer), SM(SM) {}
+
+  void FileChanged(SourceLocation Loc, FileChangeReason Reason,
+                   SrcMgr::CharacteristicKind FileType,
+                   FileID PrevFID) override {
+    if (Reason == EnterFile) {
+      const FileEntry *File = SM.getFileEntryForID(SM.getFileID(Loc));
+      Events.push_back(File ? Tracer.begin("Source", File->getName()) : ~0U);
+    } else if (Reason == ExitFile && !Events.empty()) {
+      if (Events.back() != ~0U)
+        Tracer.end(Events.back());
+      Events.pop_back();
+    }
+  }
+
+  void EndOfMainFile() override {
+    for (unsigned Event : Events)
+      if (Event != ~0U)
+        Tracer.end(Event);
+    Events.clear();
+  }
+};
+} // end anonymous namespace
+
 // Diagnostics
 static void SetUpDiagnosticLog(DiagnosticOptions *DiagOpts,
                                const CodeGenOptions *CodeGenOpts,
@@ -362,7 +403,8 @@ void CompilerInstance::createPreprocessor(TranslationUnitKind TUKind) {
   // Create a PTH manager if we are using some form of a token cache.
   PTHManager *PTHMgr = nullptr;
   if (!PPOpts.TokenCache.empty())
-    PTHMgr = PTHManager::Create(PPOpts.TokenCache, getDiagnostics());
+    PTHMgr = PTHManager::Create(PPOpts.TokenCache, getDiagnostics(),
+                                getLangOpts());
 
   // Create the Preprocessor.
   HeaderSearch *HeaderInfo = new HeaderSearch(&getHeaderSearchOpts(),
@@ -438,6 +480,10 @@ void CompilerInstance::createPreprocessor(TranslationUnitKind TUKind) {
   for (auto &Listener : DependencyCollectors)
     Listener->attachToPreprocessor(*PP);
 
+  if (TimeTracer *Tracer = getTimeTracer())
+    PP->addPPCallbacks(llvm::make_unique<TimeTraceSourceCallbacks>(
+        *Tracer, PP->getSourceManager()));
+
   // Handle generating header include information, if requested.
   if (DepOpts.ShowHeaderIncludes)
     AttachHeaderIncludeGen(*PP, DepOpts);
@@ -949,18 +995,39 @@ bool CompilerInstance::ExecuteAction(FrontendAction &Act) {
   if (getFrontendOpts().ShowStats || !getFrontendOpts().StatsFile.empty())
     llvm::EnableStatistics(false);
 
+  // Trace the time spent in the frontend, unless a trace is already being
+  // recorded, e.g. when building a module for the compilation being traced.
+  std::unique_ptr<TimeTracer> Tracer;
+  if (!getFrontendOpts().TimeTraceFile.empty() && !getTimeTracer()) {
+    Tracer = llvm::make_unique<TimeTracer>(getFrontendOpts().TimeTraceTopN);
+    setTimeTracer(Tracer.get());
+  }
+
   for (const FrontendInputFile &FIF : getFrontendOpts().Inputs) {
     // Reset the ID tables if we are reusing the SourceManager and parsing
     // regular files.
     if (hasSourceManager() && !Act.isModelParsingAction())
       getSourceManager().clearIDTables();
 
+    TimeTraceScope TTS("Frontend", [&] { return FIF.getFile().str(); });
     if (Act.BeginSourceFile(*this, FIF)) {
       Act.Execute();
       Act.EndSourceFile();
     }
   }
 
+  if (Tracer) {
+    setTimeTracer(nullptr);
+    StringRef TraceFile = getFrontendOpts().TimeTraceFile;
+    std::error_code EC;
+    llvm::raw_fd_ostream TraceOS(TraceFile, EC, llvm::sys::fs::F_Text);
+    if (EC)
+      getDiagnostics().Report(diag::warn_fe_unable_to_open_time_trace_file)
+          << TraceFile << EC.message();
+    else
+      Tracer->write(TraceOS);
+  }
+
   // Notify the diagnostic client that all files were processed.
   getDiagnostics().getClient()->finish();
 
@@ -1163,6 +1230,56 @@ static bool compileModuleImpl(CompilerInstance &ImportingInstance,
   return !Instance.getDiagnostics().hasErrorOccurred();
 }
 
+namespace {
+/// The implicit modules that the threads of this process are building.
+///
+/// Threads that need a module another thread of the process is building wait
+/// here, and are woken up as soon as it is written, instead of polling its
+/// lock file like the other processes do.
+class InProcessModuleBuilds {
+  std::mutex Mutex;
+  std::condition_variable Finished;
+  llvm::StringSet<> Building;
+
+public:
+  /// Claim the build of the module file \p ModuleFileName. If another thread
+  /// is already building it, wait for it to finish and return false.
+  bool claim(StringRef ModuleFileName) {
+    std::unique_lock<std::mutex> Lock(Mutex);
+    if (Building.insert(ModuleFileName).second)
+      return true;
+    Finished.wait(Lock, [&] { return !Building.count(ModuleFileName); });
+    return false;
+  }
+
+  /// Release a claim made by \c claim and wake up the threads waiting on it.
+  void release(StringRef ModuleFileName) {
+    {
+      std::lock_guard<std::mutex> Lock(Mutex);
+      Building.erase(ModuleFileName);
+    }
+    Finished.notify_all();
+  }
+};
+
+/// Releases the claim on a module build when it goes out of scope.
+class InProcessModuleBuildClaim {
+  InProcessModuleBuilds &Builds;
+  StringRef ModuleFileName;
+
+public:
+  InProcessModuleBuildClaim(InProcessModuleBuilds &Builds,
+                            StringRef ModuleFileName)
+      : Builds(Builds), ModuleFileName(ModuleFileName) {}
+  ~InProcessModuleBuildClaim() { Builds.release(ModuleFileName); }
+};
+} // end anonymous namespace
+
+static InProcessModuleBuilds &getInProcessModuleBuilds() {
+  static InProcessModuleBuilds Builds;
+  return Builds;
+}
+
 static bool compileAndLoadModule(CompilerInstance &ImportingInstance,
                                  SourceLocation ImportLoc,
                                  SourceLocation ModuleNameLoc, Module *Module,
@@ -1174,6 +1291,26 @@ static bool compileAndLoadModule(CompilerInstance &ImportingInstance,
         << Module->Name << SourceRange(ImportLoc, ModuleNameLoc);
   };
 
+  // If another thread of this process is building the module, wait for it
+  // and use the module it wrote. If that one cannot be used, build it again
+  // under the lock below, which diagnoses a failure.
+  InProcessModuleBuilds &Builds = getInProcessModuleBuilds();
+  while (!Builds.claim(ModuleFileName)) {
+    ASTReader::ASTReadResult ReadResult =
+        ImportingInstance.getModuleManager()->ReadAST(
+            ModuleFileName, serialization::MK_ImplicitModule, ImportLoc,
+            ASTReader::ARR_Missing | ASTReader::ARR_OutOfDate);
+    if (ReadResult == ASTReader::Success)
+      return true;
+    if (ReadResult != ASTReader::OutOfDate &&
+        ReadResult != ASTReader::Missing) {
+      if (!Diags.hasErrorOccurred())
+        diagnoseBuildFailure();
+      return false;
+    }
+  }
+  InProcessModuleBuildClaim Claim(Builds, ModuleFileName);
+
   // FIXME: have LockFileManager return an error_code so that we can
   // avoid the mkdir when the directory already exists.
   StringRef Dir = llvm::sys::path::parent_path(ModuleFileName);
@@ -510,6 +510,8 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
   Opts.WholeProgramVTables = Args.hasArg(OPT_fwhole_program_vtables);
   Opts.LTOVisibilityPublicStd = Args.hasArg(OPT_flto_visibility_public_std);
   Opts.SplitDwarfFile = Args.getLastArgValue(OPT_split_dwarf_file);
+  Opts.ParallelCodeGenOutputs =
+      Args.getAllArgValues(OPT_parallel_codegen_output);
   Opts.SplitDwarfInlining = !Args.hasArg(OPT_fno_split_dwarf_inlining);
   Opts.DebugTypeExtRefs = Args.hasArg(OPT_dwarf_ext_refs);
   Opts.DebugExplicitImport = Triple.isPS4CPU();
@@ -522,6 +524,7 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
     Opts.EmitLLVMUseLists = A->getOption().getID() == OPT_emit_llvm_uselists;
 
   Opts.DisableLLVMPasses = Args.hasArg(OPT_disable_llvm_passes);
+  Opts.EarlyFunctionPasses = Args.hasArg(OPT_fearly_function_passes);
   Opts.DisableRedZone = Args.hasArg(OPT_disable_red_zone);
   Opts.ForbidGuardVariables = Args.hasArg(OPT_fforbid_guard_variables);
   Opts.UseRegisterSizedBitfieldAccess = Args.hasArg(
@@ -531,6 +534,70 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
   Opts.OpenmpCombineDirs = Args.hasArg(OPT_fopenmp_combine_dirs);
   Opts.OpenmpNonaliasedMaps = Args.hasArg(OPT_fopenmp_nonaliased_maps);
   Opts.OpenMPRequireGPURuntime = Args.hasArg(OPT_fopenmp_nvptx_requireruntime);
+  Opts.OpenMPInlineTeamsReduction =
+      Args.hasArg(OPT_fopenmp_nvptx_inline_teams_reduction);
+  Opts.OpenMPStaticDataSharing =
+      Args.hasArg(OPT_fopenmp_nvptx_static_data_sharing);
+  Opts.OpenMPDataSharingPool =
+      Args.hasArg(OPT_fopenmp_nvptx_data_sharing_pool);
+  Opts.OpenMPCopyReadOnlyCaptures =
+      Args.hasArg(OPT_fopenmp_nvptx_copy_readonly_captures);
+  Opts.OpenMPPruneImplicitDeclareTarget =
+      Args.hasArg(OPT_fopenmp_prune_implicit_declare_target);
+  Opts.OpenMPMinTeamsPerSM =
+      getLastArgIntValue(Args, OPT_fopenmp_nvptx_min_teams_per_sm_EQ, 0, Diags);
+  Opts.OpenMPTargetNowaitDepend =
+      Args.hasArg(OPT_fopenmp_target_nowait_depend);
+  Opts.OpenMPHashedOffloadEntries =
+      Args.hasArg(OPT_fopenmp_hashed_offload_entries);
+  Opts.OpenMPOffloadWrapperObjects =
+      Args.hasArg(OPT_fopenmp_offload_wrapper_objects);
+  Opts.OpenMPSmallTaskAlloc = Args.hasArg(OPT_fopenmp_small_task_alloc);
+  Opts.OpenMPTaskSerialCutoff = Args.hasArg(OPT_fopenmp_task_serial_cutoff);
+  Opts.OpenMPTaskloopSharedFirstprivates =
+      Args.hasArg(OPT_fopenmp_taskloop_shared_firstprivates);
+  Opts.OpenMPDoacrossTileSize =
+      getLastArgIntValue(Args, OPT_fopenmp_doacross_tile_size_EQ, 0, Diags);
+  Opts.OpenMPInlineStaticSchedule =
+      Args.hasArg(OPT_fopenmp_inline_static_schedule);
+  Opts.OpenMPTreeReduction = Args.hasArg(OPT_fopenmp_tree_reduction);
+  if (Arg *A = Args.getLastArg(OPT_fopenmp_private_copy_align_EQ)) {
+    unsigned Val;
+    if (StringRef(A->getValue()).getAsInteger(10, Val) ||
+        !llvm::isPowerOf2_32(Val))
+      Diags.Report(diag::err_drv_invalid_value) << A->getAsString(Args)
+                                                << A->getValue();
+    else
+      Opts.OpenMPPrivateCopyAlignment = Val;
+  }
+  Opts.OpenMPDeclareSimdCalls = Args.hasArg(OPT_fopenmp_declare_simd_calls);
+  Opts.OpenMPHoistThreadPrivateLookups =
+      Args.hasArg(OPT_fopenmp_hoist_threadprivate_lookups);
+  Opts.OpenMPFuseParallelRegions =
+      Args.hasArg(OPT_fopenmp_fuse_parallel_regions);
+  Opts.OpenMPHoistTargetData = Args.hasArg(OPT_fopenmp_hoist_target_data);
+  Opts.OpenMPUnifiedMemory = Args.hasArg(OPT_fopenmp_unified_memory);
+  Opts.OpenMPSplitTargetDevices =
+      Args.hasArg(OPT_fopenmp_split_target_devices);
+  Opts.OpenMPInlineReductionCombiners =
+      Args.hasArg(OPT_fopenmp_inline_reduction_combiners);
+  Opts.OpenMPOffloadProfile = Args.hasArg(OPT_fopenmp_offload_profile);
+  Opts.OpenMPNVPTXCycleCounters =
+      Args.hasArg(OPT_fopenmp_nvptx_cycle_counters);
+  Opts.OpenMPMergeIdenticalKernels =
+      Args.hasArg(OPT_fopenmp_merge_identical_kernels);
+  Opts.OpenMPSplitComplexAtomics =
+      Args.hasArg(OPT_fopenmp_split_complex_atomics);
+  Opts.OpenMPNVPTXStencilTiling =
+      Args.hasArg(OPT_fopenmp_nvptx_stencil_tiling);
+  Opts.OpenMPNVPTXNativeDynamicSchedule =
+      Args.hasArg(OPT_fopenmp_nvptx_native_dynamic_schedule);
+  Opts.OpenMPOffloadInfoOutputFile =
+      Args.getLastArgValue(OPT_fopenmp_offload_info_output);
+  Opts.OpenMPHostOffloadInfoFile =
+      Args.getLastArgValue(OPT_fopenmp_host_offload_info_file_path);
+  Opts.OpenMPDeviceBitcodeOutputFile =
+      Args.getLastArgValue(OPT_fopenmp_device_bitcode_output);
   Opts.DwarfDebugFlags = Args.getLastArgValue(OPT_dwarf_debug_flags);
   Opts.MergeAllConstants = !Args.hasArg(OPT_fno_merge_all_constants);
   Opts.NoCommon = Args.hasArg(OPT_fno_common);
@@ -552,6 +619,8 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
   setPGOInstrumentor(Opts, Args, Diags);
   Opts.InstrProfileOutput =
       Args.getLastArgValue(OPT_fprofile_instrument_path_EQ);
+  Opts.ProfileInstrSamplePeriod =
+      getLastArgIntValue(Args, OPT_fprofile_instr_sample_period_EQ, 0, Diags);
   Opts.ProfileInstrumentUsePath =
       Args.getLastArgValue(OPT_fprofile_instrument_use_path_EQ);
   if (!Opts.ProfileInstrumentUsePath.empty())
@@ -559,6 +628,8 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
 
   Opts.CoverageMapping =
       Args.hasFlag(OPT_fcoverage_mapping, OPT_fno_coverage_mapping, false);
+  Opts.CoverageUnusedHeaderFunctions =
+      !Args.hasArg(OPT_fno_coverage_unused_header_functions);
   Opts.DumpCoverageMapping = Args.hasArg(OPT_dump_coverage_mapping);
   Opts.AsmVerbose = Args.hasArg(OPT_masm_verbose);
   Opts.PreserveAsmComments = !Args.hasArg(OPT_fno_preserve_as_comments);
@@ -575,6 +646,7 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
   Opts.DisableTailCalls = Args.hasArg(OPT_mdisable_tail_calls);
   Opts.FloatABI = Args.getLastArgValue(OPT_mfloat_abi);
   Opts.LessPreciseFPMAD = Args.hasArg(OPT_cl_mad_enable);
+  Opts.LazyDynamicInit = Args.hasArg(OPT_flazy_dynamic_init);
   Opts.LimitFloatPrecision = Args.getLastArgValue(OPT_mlimit_float_precision);
   Opts.NoInfsFPMath = (Args.hasArg(OPT_menable_no_infinities) ||
                        Args.hasArg(OPT_cl_finite_math_only) ||
@@ -605,9 +677,13 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
   Opts.SaveTempLabels = Args.hasArg(OPT_msave_temp_labels);
   Opts.NoDwarfDirectoryAsm = Args.hasArg(OPT_fno_dwarf_directory_asm);
   Opts.SoftFloat = Args.hasArg(OPT_msoft_float);
+  Opts.StreamInstantiations = Args.hasArg(OPT_fstream_instantiations);
   Opts.StrictEnums = Args.hasArg(OPT_fstrict_enums);
   Opts.StrictReturn = !Args.hasArg(OPT_fno_strict_return);
+  Opts.ColdUnlikelyCalls = Args.hasArg(OPT_fcold_unlikely_calls);
   Opts.StrictVTablePointers = Args.hasArg(OPT_fstrict_vtable_pointers);
+  Opts.SpeculativeDevirtualization =
+      Args.hasArg(OPT_fspeculative_devirtualization);
   Opts.UnsafeFPMath = Args.hasArg(OPT_menable_unsafe_fp_math) ||
                       Args.hasArg(OPT_cl_unsafe_math_optimizations) ||
                       Args.hasArg(OPT_cl_fast_relaxed_math);
@@ -863,6 +939,8 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
         GenerateOptimizationRemarkRegex(Diags, Args, A);
     NeedLocTracking = true;
   }
+  Opts.AggregateCopyRemarkThreshold = getLastArgIntValue(
+      Args, OPT_faggregate_copy_remark_threshold_EQ, 64, Diags);
 
   Opts.DiagnosticsWithHotness =
       Args.hasArg(options::OPT_fdiagnostics_show_hotness);
@@ -894,6 +972,7 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
 
   Opts.CudaGpuBinaryFileNames =
       Args.getAllArgValues(OPT_fcuda_include_gpubinary);
+  Opts.CUDALazyRegistration = Args.hasArg(OPT_fcuda_lazy_registration);
 
   Opts.Backchain = Args.hasArg(OPT_mbackchain);
 
@@ -1087,8 +1166,11 @@ bool clang::ParseDiagnosticArgs(DiagnosticOptions &Opts, ArgList &Args,
   return Success;
 }
 
-static void ParseFileSystemArgs(FileSystemOptions &Opts, ArgList &Args) {
+static void ParseFileSystemArgs(FileSystemOptions &Opts, ArgList &Args,
+                                DiagnosticsEngine &Diags) {
   Opts.WorkingDir = Args.getLastArgValue(OPT_working_directory);
+  Opts.StatPrefetchThreads =
+      getLastArgIntValue(Args, OPT_fstat_prefetch_threads_EQ, 0, Diags);
 }
 
 /// Parse the argument to the -ftest-module-file-extension
@@ -1190,6 +1272,8 @@ static InputKind ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
       Opts.ProgramAction = frontend::MigrateSource; break;
     case OPT_Eonly:
       Opts.ProgramAction = frontend::RunPreprocessorOnly; break;
+    case OPT_Eonly_directives:
+      Opts.ProgramAction = frontend::RunPreprocessorDirectivesOnly; break;
     }
   }
 
@@ -1270,6 +1354,9 @@ static InputKind ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
       llvm::Triple::normalize(Args.getLastArgValue(OPT_aux_triple));
   Opts.FindPchSource = Args.getLastArgValue(OPT_find_pch_source_EQ);
   Opts.StatsFile = Args.getLastArgValue(OPT_stats_file);
+  Opts.TimeTraceFile = Args.getLastArgValue(OPT_time_trace_file);
+  Opts.TimeTraceTopN =
+      getLastArgIntValue(Args, OPT_ftime_trace_top_EQ, 10, Diags);
 
   if (const Arg *A = Args.getLastArg(OPT_arcmt_check,
                                      OPT_arcmt_modify,
@@ -1423,6 +1510,7 @@ static void ParseHeaderSearchArgs(HeaderSearchOptions &Opts, ArgList &Args) {
   Opts.ResourceDir = Args.getLastArgValue(OPT_resource_dir);
   Opts.ModuleCachePath = Args.getLastArgValue(OPT_fmodules_cache_path);
   Opts.ModuleUserBuildPath = Args.getLastArgValue(OPT_fmodules_user_build_path);
+  Opts.HeaderInfoCachePath = Args.getLastArgValue(OPT_fheader_info_cache_EQ);
   for (const Arg *A : Args.filtered(OPT_fprebuilt_module_path))
     Opts.AddPrebuiltModulePath(A->getValue());
   Opts.DisableModuleHash = Args.hasArg(OPT_fdisable_module_hash);
@@ -1434,8 +1522,11 @@ static void ParseHeaderSearchArgs(HeaderSearchOptions &Opts, ArgList &Args) {
       getLastArgIntValue(Args, OPT_fmodules_prune_interval, 7 * 24 * 60 * 60);
   Opts.ModuleCachePruneAfter =
       getLastArgIntValue(Args, OPT_fmodules_prune_after, 31 * 24 * 60 * 60);
+  Opts.ModulesShareBuildSessionValidation =
+      Args.hasArg(OPT_fmodules_share_build_session_validation);
   Opts.ModulesValidateOncePerBuildSession =
-      Args.hasArg(OPT_fmodules_validate_once_per_build_session);
+      Args.hasArg(OPT_fmodules_validate_once_per_build_session) ||
+      Opts.ModulesShareBuildSessionValidation;
   Opts.BuildSessionTimestamp =
       getLastArgUInt64Value(Args, OPT_fbuild_session_timestamp, 0);
   Opts.ModulesValidateSystemHeaders =
@@ -1527,6 +1618,8 @@ static void ParseHeaderSearchArgs(HeaderSearchOptions &Opts, ArgList &Args) {
 
   for (const Arg *A : Args.filtered(OPT_ivfsoverlay))
     Opts.AddVFSOverlayFile(A->getValue());
+  for (const Arg *A : Args.filtered(OPT_ivfsarchive))
+    Opts.AddVFSArchiveFile(A->getValue());
 }
 
 static bool isOpenCL(LangStandard::Kind LangStd) {
@@ -1792,6 +1885,9 @@ static void ParseLangArgs(LangOptions &Opts, ArgList &Args, InputKind IK,
   if (Opts.CUDAIsDevice && Args.hasArg(OPT_fcuda_approx_transcendentals))
     Opts.CUDADeviceApproxTranscendentals = 1;
 
+  if (Args.hasArg(OPT_fcuda_launch_kernel))
+    Opts.CUDALaunchKernel = 1;
+
   if (Opts.ObjC1) {
     if (Arg *arg = Args.getLastArg(OPT_fobjc_runtime_EQ)) {
       StringRef value = arg->getValue();
@@ -1951,6 +2047,8 @@ static void ParseLangArgs(LangOptions &Opts, ArgList &Args, InputKind IK,
       Args.hasArg(OPT_fmodules_decluse) || Opts.ModulesStrictDeclUse;
   Opts.ModulesLocalVisibility =
       Args.hasArg(OPT_fmodules_local_submodule_visibility) || Opts.ModulesTS;
+  Opts.ModulesCodegen = Args.hasArg(OPT_fmodules_codegen);
+  Opts.ModulesDebugInfo = Args.hasArg(OPT_fmodules_debuginfo);
   Opts.ModulesSearchAll = Opts.Modules &&
     !Args.hasArg(OPT_fno_modules_search_all) &&
     Args.hasArg(OPT_fmodules_search_all);
@@ -1992,8 +2090,13 @@ static void ParseLangArgs(LangOptions &Opts, ArgList &Args, InputKind IK,
       getLastArgIntValue(Args, OPT_fconstexpr_depth, 512, Diags);
   Opts.ConstexprStepLimit =
       getLastArgIntValue(Args, OPT_fconstexpr_steps, 1048576, Diags);
+  Opts.ExperimentalConstexprInterpreter =
+      Args.hasArg(OPT_fexperimental_constexpr_interpreter);
   Opts.BracketDepth = getLastArgIntValue(Args, OPT_fbracket_depth, 256, Diags);
   Opts.DelayedTemplateParsing = Args.hasArg(OPT_fdelayed_template_parsing);
+  Opts.PCHInstantiateTemplates = Args.hasArg(OPT_fpch_instantiate_templates);
+  Opts.SkipFunctionBodiesOutsideMainFile =
+      Args.hasArg(OPT_skip_function_bodies_outside_main_file);
   Opts.NumLargeByValueCopy =
       getLastArgIntValue(Args, OPT_Wlarge_by_value_copy_EQ, 0, Diags);
   Opts.MSBitfields = Args.hasArg(OPT_mms_bitfields);
@@ -2144,6 +2247,9 @@ static void ParseLangArgs(LangOptions &Opts, ArgList &Args, InputKind IK,
       Opts.OpenMP && !Args.hasArg(options::OPT_fnoopenmp_use_tls);
   Opts.OpenMPIsDevice =
       Opts.OpenMP && Args.hasArg(options::OPT_fopenmp_is_device);
+  Opts.OpenMPSkipHostFunctionBodies =
+      Opts.OpenMPIsDevice &&
+      Args.hasArg(options::OPT_fopenmp_skip_host_function_bodies);
   Opts.OpenMPNonAliasedMaps =
       Opts.OpenMP && Args.hasArg(options::OPT_fopenmp_nonaliased_maps);
   Opts.OpenMPCombineDirs = 
@@ -2156,6 +2262,10 @@ static void ParseLangArgs(LangOptions &Opts, ArgList &Args, InputKind IK,
       Opts.OpenMP && Args.hasArg(options::OPT_fopenmp_implicit_declare_target);
   Opts.OpenMPImplicitMapLambdas =
       Opts.OpenMP && Args.hasArg(options::OPT_fopenmp_implicit_map_lambdas);
+  Opts.OpenMPSmallMapsByValue =
+      Opts.OpenMP && Args.hasArg(options::OPT_fopenmp_small_maps_by_value);
+  Opts.OpenMPNarrowImplicitMaps =
+      Opts.OpenMP && Args.hasArg(options::OPT_fopenmp_narrow_implicit_maps);
 
   if (Arg *A = Args.getLastArg(OPT_ftrap_EQ)) {
     StringRef Value = A->getValue();
@@ -2443,6 +2553,7 @@ static void ParsePreprocessorOutputArgs(PreprocessorOutputOptions &Opts,
   case frontend::PrintPreprocessedInput:
   case frontend::RewriteMacros:
   case frontend::RunPreprocessorOnly:
+  case frontend::RunPreprocessorDirectivesOnly:
     Opts.ShowCPP = !Args.hasArg(OPT_dM);
     break;
   }
@@ -2521,7 +2632,7 @@ bool CompilerInvocation::CreateFromArgs(CompilerInvocation &Res,
       ParseDiagnosticArgs(Res.getDiagnosticOpts(), Args, &Diags,
                           false /*DefaultDiagColor*/, false /*DefaultShowOpt*/);
   ParseCommentArgs(LangOpts.CommentOpts, Args);
-  ParseFileSystemArgs(Res.getFileSystemOpts(), Args);
+  ParseFileSystemArgs(Res.getFileSystemOpts(), Args, Diags);
   // FIXME: We shouldn't have to pass the DashX option around here
   InputKind DashX = ParseFrontendArgs(Res.getFrontendOpts(), Args, Diags,
                                       LangOpts.IsHeaderFile);
@@ -2736,11 +2847,31 @@ void BuryPointer(const void *Ptr) {
 IntrusiveRefCntPtr<vfs::FileSystem>
 createVFSFromCompilerInvocation(const CompilerInvocation &CI,
                                 DiagnosticsEngine &Diags) {
-  if (CI.getHeaderSearchOpts().VFSOverlayFiles.empty())
+  if (CI.getHeaderSearchOpts().VFSOverlayFiles.empty() &&
+      CI.getHeaderSearchOpts().VFSArchiveFiles.empty())
     return vfs::getRealFileSystem();
 
   IntrusiveRefCntPtr<vfs::OverlayFileSystem>
     Overlay(new vfs::OverlayFileSystem(vfs::getRealFileSystem()));
+  // The archives are mapped rather than read, and their files are served
+  // from the mapping, so concurrent compilations share the same pages.
+  for (const std::string &File : CI.getHeaderSearchOpts().VFSArchiveFiles) {
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+        llvm::MemoryBuffer::getFile(File, /*FileSize=*/-1,
+                                    /*RequiresNullTerminator=*/false);
+    if (!Buffer) {
+      Diags.Report(diag::err_missing_vfs_archive) << File;
+      return IntrusiveRefCntPtr<vfs::FileSystem>();
+    }
+
+    IntrusiveRefCntPtr<vfs::FileSystem> FS =
+        vfs::getVFSFromArchive(std::move(Buffer.get()));
+    if (!FS.get()) {
+      Diags.Report(diag::err_invalid_vfs_archive) << File;
+      return IntrusiveRefCntPtr<vfs::FileSystem>();
+    }
+    Overlay->pushOverlay(FS);
+  }
   // earlier vfs files are on the bottom
   for (const std::string &File : CI.getHeaderSearchOpts().VFSOverlayFiles) {
     llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
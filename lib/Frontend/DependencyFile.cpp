@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Frontend/Utils.h"
+#include "clang/Basic/CharInfo.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Frontend/DependencyOutputOptions.h"
@@ -471,3 +472,204 @@ void DFGASTReaderListener::visitModuleFile(llvm::StringRef Filename,
   if (Parent.includeModuleFiles())
     Parent.AddFilename(Filename);
 }
+
+//===----------------------------------------------------------------------===//
+// Source minimization for dependency scanning.
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// Copies the directive lines of a file and drops everything else but the
+/// newlines.  Comments and literals are skipped as a whole, so that the
+/// quotes and '#'s in them are not mistaken for the start of a literal or a
+/// directive.
+class DirectiveMinimizer {
+  StringRef Input;
+  const LangOptions &LangOpts;
+  SmallVectorImpl<char> &Output;
+  size_t Pos;
+
+public:
+  DirectiveMinimizer(StringRef Input, const LangOptions &LangOpts,
+                     SmallVectorImpl<char> &Output)
+      : Input(Input), LangOpts(LangOpts), Output(Output), Pos(0) {}
+
+  void run();
+
+private:
+  char peek(size_t Offset) const {
+    return Pos + Offset < Input.size() ? Input[Pos + Offset] : '\0';
+  }
+
+  /// Return the length of the escaped newline at \p At, or 0 if there is
+  /// none.
+  size_t getEscapedNewlineSize(size_t At) const;
+
+  /// Move past the next \p N characters, copying them if \p Copy is true
+  /// and only their newlines otherwise.
+  void advance(size_t N, bool Copy);
+
+  void advanceBlockComment(bool Copy);
+  void advanceLineComment(bool Copy);
+  void advanceQuoted(bool Copy);
+  bool advanceRawString(bool Copy);
+};
+} // end anonymous namespace
+
+size_t DirectiveMinimizer::getEscapedNewlineSize(size_t At) const {
+  if (Input[At] != '\\')
+    return 0;
+  // Whitespace between the backslash and the newline is accepted, like in
+  // the lexer.
+  size_t End = At + 1;
+  while (End < Input.size() && isHorizontalWhitespace(Input[End]))
+    ++End;
+  if (End < Input.size() && Input[End] == '\r')
+    ++End;
+  if (End < Input.size() && Input[End] == '\n')
+    return End + 1 - At;
+  return 0;
+}
+
+void DirectiveMinimizer::advance(size_t N, bool Copy) {
+  StringRef Chars = Input.substr(Pos, N);
+  if (Copy)
+    Output.append(Chars.begin(), Chars.end());
+  else
+    Output.append(Chars.count('\n'), '\n');
+  Pos += Chars.size();
+}
+
+void DirectiveMinimizer::advanceBlockComment(bool Copy) {
+  size_t End = Input.find("*/", Pos + 2);
+  advance(End == StringRef::npos ? StringRef::npos : End + 2 - Pos, Copy);
+}
+
+void DirectiveMinimizer::advanceLineComment(bool Copy) {
+  size_t End = Pos;
+  while (End < Input.size() && Input[End] != '\n') {
+    if (size_t N = getEscapedNewlineSize(End))
+      End += N;
+    else
+      ++End;
+  }
+  advance(End - Pos, Copy);
+}
+
+void DirectiveMinimizer::advanceQuoted(bool Copy) {
+  // An unterminated literal ends with its line.
+  char Quote = Input[Pos];
+  size_t End = Pos + 1;
+  while (End < Input.size() && Input[End] != Quote && Input[End] != '\n') {
+    if (size_t N = getEscapedNewlineSize(End))
+      End += N;
+    else if (Input[End] == '\\' && End + 1 < Input.size() &&
+             Input[End + 1] != '\n')
+      End += 2;
+    else
+      ++End;
+  }
+  if (End < Input.size() && Input[End] == Quote)
+    ++End;
+  advance(End - Pos, Copy);
+}
+
+bool DirectiveMinimizer::advanceRawString(bool Copy) {
+  size_t OpenParen = Input.find_first_of("( \t\n\\)\"", Pos + 1);
+  if (OpenParen == StringRef::npos || Input[OpenParen] != '(' ||
+      OpenParen - Pos - 1 > 16)
+    return false;
+  std::string Terminator = ")";
+  Terminator += Input.slice(Pos + 1, OpenParen);
+  Terminator += '"';
+  size_t End = Input.find(Terminator, OpenParen + 1);
+  advance(End == StringRef::npos ? StringRef::npos
+                                 : End + Terminator.size() - Pos,
+          Copy);
+  return true;
+}
+
+void DirectiveMinimizer::run() {
+  // Keep the byte order mark, which does not start a line of code.
+  if (Input.startswith("\xEF\xBB\xBF"))
+    advance(3, /*Copy=*/true);
+
+  bool AtLineStart = true;
+  bool InDirective = false;
+  // The start of the identifier or number that ends at Pos, if any, which
+  // tells raw string prefixes and digit separators apart from the start of a
+  // literal.
+  size_t TokenStart = StringRef::npos;
+  bool InNumber = false;
+
+  while (Pos < Input.size()) {
+    char C = Input[Pos];
+    if (C == '\n') {
+      advance(1, InDirective);
+      AtLineStart = true;
+      InDirective = false;
+      TokenStart = StringRef::npos;
+      continue;
+    }
+    if (size_t N = getEscapedNewlineSize(Pos)) {
+      advance(N, InDirective);
+      continue;
+    }
+    if (isHorizontalWhitespace(C) || C == '\r') {
+      advance(1, InDirective);
+      TokenStart = StringRef::npos;
+      continue;
+    }
+    if (C == '/' && peek(1) == '*') {
+      advanceBlockComment(InDirective);
+      TokenStart = StringRef::npos;
+      continue;
+    }
+    if (C == '/' && peek(1) == '/' && LangOpts.LineComment) {
+      advanceLineComment(InDirective);
+      continue;
+    }
+
+    if (AtLineStart &&
+        (C == '#' || (C == '%' && peek(1) == ':' && LangOpts.Digraphs)))
+      InDirective = true;
+    AtLineStart = false;
+
+    if (C == '"') {
+      StringRef Prefix = TokenStart == StringRef::npos
+                             ? StringRef()
+                             : Input.slice(TokenStart, Pos);
+      bool IsRaw = LangOpts.CPlusPlus11 &&
+                   (Prefix == "R" || Prefix == "LR" || Prefix == "uR" ||
+                    Prefix == "UR" || Prefix == "u8R");
+      if (!IsRaw || !advanceRawString(InDirective))
+        advanceQuoted(InDirective);
+      TokenStart = StringRef::npos;
+      continue;
+    }
+    bool IsDigitSeparator =
+        C == '\'' && TokenStart != StringRef::npos && InNumber &&
+        LangOpts.CPlusPlus14;
+    if (C == '\'' && !IsDigitSeparator) {
+      advanceQuoted(InDirective);
+      TokenStart = StringRef::npos;
+      continue;
+    }
+
+    if (isIdentifierBody(C, LangOpts.DollarIdents) || !isASCII(C) ||
+        IsDigitSeparator) {
+      if (TokenStart == StringRef::npos) {
+        TokenStart = Pos;
+        InNumber = isDigit(C);
+      }
+    } else {
+      TokenStart = StringRef::npos;
+    }
+    advance(1, InDirective);
+  }
+}
+
+void clang::minimizeSourceToDependencyDirectives(StringRef Input,
+                                                 const LangOptions &LangOpts,
+                                                 SmallVectorImpl<char> &Output) {
+  DirectiveMinimizer(Input, LangOpts, Output).run();
+}
@@ -16,6 +16,7 @@
 #include "clang/Frontend/MultiplexConsumer.h"
 #include "clang/Frontend/Utils.h"
 #include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/PPCallbacks.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Lex/PreprocessorOptions.h"
 #include "clang/Serialization/ASTReader.h"
@@ -710,6 +711,75 @@ void PreprocessOnlyAction::ExecuteAction() {
   } while (Tok.isNot(tok::eof));
 }
 
+namespace {
+/// \brief Minimizes the included files before they are entered.
+class MinimizeIncludedFiles : public PPCallbacks {
+  DirectivesOnlyPreprocessAction &Action;
+  CompilerInstance &CI;
+
+public:
+  MinimizeIncludedFiles(DirectivesOnlyPreprocessAction &Action,
+                        CompilerInstance &CI)
+      : Action(Action), CI(CI) {}
+
+  void InclusionDirective(SourceLocation HashLoc, const Token &IncludeTok,
+                          StringRef FileName, bool IsAngled,
+                          CharSourceRange FilenameRange, const FileEntry *File,
+                          StringRef SearchPath, StringRef RelativePath,
+                          const Module *Imported) override {
+    if (File && !Imported)
+      Action.minimizeFile(CI, File);
+  }
+};
+} // end anonymous namespace
+
+void DirectivesOnlyPreprocessAction::minimizeFile(CompilerInstance &CI,
+                                                  const FileEntry *File) {
+  // Leave the files remapped by the user alone.
+  SourceManager &SM = CI.getSourceManager();
+  if (SM.isFileOverridden(File))
+    return;
+
+  std::unique_ptr<llvm::MemoryBuffer> &Minimized =
+      MinimizedFiles[File->getUniqueID()];
+  if (!Minimized) {
+    // If the file cannot be read, the preprocessor reports it when it enters
+    // the file.
+    auto Buffer = CI.getFileManager().getBufferForFile(File);
+    if (!Buffer)
+      return;
+    SmallString<0> Directives;
+    minimizeSourceToDependencyDirectives((*Buffer)->getBuffer(),
+                                         CI.getLangOpts(), Directives);
+    Minimized = llvm::MemoryBuffer::getMemBufferCopy(Directives,
+                                                     File->getName());
+  }
+  SM.overrideFileContents(File, Minimized.get(), /*DoNotFree=*/true);
+}
+
+bool DirectivesOnlyPreprocessAction::BeginSourceFileAction(
+    CompilerInstance &CI, StringRef Filename) {
+  // The main file has to be minimized before the source manager opens it.
+  if (const FileEntry *File = CI.getFileManager().getFile(Filename))
+    minimizeFile(CI, File);
+  return true;
+}
+
+void DirectivesOnlyPreprocessAction::ExecuteAction() {
+  CompilerInstance &CI = getCompilerInstance();
+  Preprocessor &PP = CI.getPreprocessor();
+  PP.addPPCallbacks(llvm::make_unique<MinimizeIncludedFiles>(*this, CI));
+
+  // Ignore unknown pragmas.
+  PP.IgnorePragmas();
+
+  Token Tok;
+  PP.EnterMainSourceFile();
+  do {
+    PP.Lex(Tok);
+  } while (Tok.isNot(tok::eof));
+}
+
 void PrintPreprocessedAction::ExecuteAction() {
   CompilerInstance &CI = getCompilerInstance();
   // Output file may need to be set to 'Binary', to avoid converting Unix style
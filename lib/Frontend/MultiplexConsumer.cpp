@@ -320,6 +320,11 @@ void MultiplexConsumer::HandleCXXImplicitFunctionInstantiation(FunctionDecl *D){
     Consumer->HandleCXXImplicitFunctionInstantiation(D);
 }
 
+void MultiplexConsumer::HandlePendingInstantiations() {
+  for (auto &Consumer : Consumers)
+    Consumer->HandlePendingInstantiations();
+}
+
 void MultiplexConsumer::HandleTopLevelDeclInObjCContainer(DeclGroupRef D) {
   for (auto &Consumer : Consumers)
     Consumer->HandleTopLevelDeclInObjCContainer(D);
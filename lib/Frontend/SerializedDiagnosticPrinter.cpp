@@ -152,9 +152,14 @@ public:
       : LangOpts(nullptr), OriginalInstance(true),
         MergeChildRecords(MergeChildRecords),
         State(new SharedState(File, Diags)) {
+    // The diagnostics are written out as they are completed, unless they are
+    // merged with those of child processes at the end.
     if (MergeChildRecords)
       RemoveOldDiagnostics();
+    else
+      OpenOutputFile();
     EmitPreamble();
+    FlushCompletedBlocks();
   }
 
   ~SDiagsWriter() override {}
@@ -177,6 +182,14 @@ private:
   /// merge into our own.
   void RemoveOldDiagnostics();
 
+  /// \brief Open the diagnostics file. On failure, the diagnostics are kept in
+  /// memory and finish() tries again.
+  std::error_code OpenOutputFile();
+
+  /// \brief Write the blocks that have been completed to the diagnostics file,
+  /// if it is open, so that the whole bitstream isn't kept in memory.
+  void FlushCompletedBlocks();
+
   /// \brief Emit the preamble for the serialized diagnostics.
   void EmitPreamble();
   
@@ -254,7 +267,7 @@ private:
   struct SharedState : RefCountedBase<SharedState> {
     SharedState(StringRef File, DiagnosticOptions *Diags)
         : DiagOpts(Diags), Stream(Buffer), OutputFile(File.str()),
-          EmittedAnyDiagBlocks(false) {}
+          OpenDiagBlocks(0), EmittedAnyDiagBlocks(false) {}
 
     /// \brief Diagnostic options.
     IntrusiveRefCntPtr<DiagnosticOptions> DiagOpts;
@@ -268,6 +281,14 @@ private:
     /// \brief The name of the diagnostics file.
     std::string OutputFile;
 
+    /// \brief The diagnostics file, once it is open.
+    std::unique_ptr<llvm::raw_fd_ostream> OS;
+
+    /// \brief The number of DIAG blocks that have been entered but not exited.
+    /// The buffer can only be written out when it is zero, since the size of a
+    /// block is backpatched into the buffer when the block is exited.
+    unsigned OpenDiagBlocks;
+
     /// \brief The set of constructed record abbreviations.
     AbbreviationMap Abbrevs;
 
@@ -585,8 +606,10 @@ void SDiagsWriter::HandleDiagnostic(DiagnosticsEngine::Level DiagLevel,
   // for beginDiagnostic, in case associated notes are emitted before we get
   // there.
   if (DiagLevel != DiagnosticsEngine::Note) {
-    if (State->EmittedAnyDiagBlocks)
+    if (State->EmittedAnyDiagBlocks) {
       ExitDiagBlock();
+      FlushCompletedBlocks();
+    }
 
     EnterDiagBlock();
     State->EmittedAnyDiagBlocks = true;
@@ -685,10 +708,12 @@ SDiagsRenderer::emitDiagnosticMessage(SourceLocation Loc,
 
 void SDiagsWriter::EnterDiagBlock() {
   State->Stream.EnterSubblock(BLOCK_DIAG, 4);
+  ++State->OpenDiagBlocks;
 }
 
 void SDiagsWriter::ExitDiagBlock() {
   State->Stream.ExitBlock();
+  --State->OpenDiagBlocks;
 }
 
 void SDiagsRenderer::beginDiagnostic(DiagOrStoredDiag D,
@@ -784,6 +809,25 @@ void SDiagsWriter::RemoveOldDiagnostics() {
   MergeChildRecords = false;
 }
 
+std::error_code SDiagsWriter::OpenOutputFile() {
+  std::error_code EC;
+  State->OS = llvm::make_unique<llvm::raw_fd_ostream>(
+      State->OutputFile.c_str(), EC, llvm::sys::fs::F_None);
+  if (EC)
+    State->OS.reset();
+  return EC;
+}
+
+void SDiagsWriter::FlushCompletedBlocks() {
+  if (!State->OS || State->OpenDiagBlocks)
+    return;
+
+  // Every block ends on a word boundary, so once they are all closed the
+  // buffer holds whole words that won't change anymore.
+  State->OS->write(State->Buffer.data(), State->Buffer.size());
+  State->Buffer.clear();
+}
+
 void SDiagsWriter::finish() {
   // The original instance is responsible for writing the file.
   if (!OriginalInstance)
@@ -804,18 +848,18 @@ void SDiagsWriter::finish() {
         getMetaDiags()->Report(diag::warn_fe_serialized_diag_merge_failure);
   }
 
-  std::error_code EC;
-  auto OS = llvm::make_unique<llvm::raw_fd_ostream>(State->OutputFile.c_str(),
-                                                    EC, llvm::sys::fs::F_None);
-  if (EC) {
-    getMetaDiags()->Report(diag::warn_fe_serialized_diag_failure)
-        << State->OutputFile << EC.message();
-    return;
+  if (!State->OS) {
+    if (std::error_code EC = OpenOutputFile()) {
+      getMetaDiags()->Report(diag::warn_fe_serialized_diag_failure)
+          << State->OutputFile << EC.message();
+      return;
+    }
   }
 
-  // Write the generated bitstream to "Out".
-  OS->write((char *)&State->Buffer.front(), State->Buffer.size());
-  OS->flush();
+  // Write the rest of the generated bitstream to the file.
+  State->OS->write(State->Buffer.data(), State->Buffer.size());
+  State->Buffer.clear();
+  State->OS->flush();
 }
 
 std::error_code SDiagsMerger::visitStartOfDiagnostic() {
@@ -11,6 +11,8 @@
 #include "clang/Basic/FileManager.h"
 #include "clang/Frontend/SerializedDiagnostics.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
 
 using namespace clang;
 using namespace clang::serialized_diags;
@@ -248,6 +250,58 @@ SerializedDiagnosticReader::readDiagnosticBlock(llvm::BitstreamCursor &Stream) {
   }
 }
 
+/// \brief Returns the size in bytes of the signature, BLOCKINFO and META blocks
+/// at the start of a diagnostics file, skipping the blocks without reading
+/// their records.
+static llvm::ErrorOr<uint64_t>
+getPreambleSize(const llvm::MemoryBuffer &Buffer) {
+  llvm::BitstreamCursor Stream(Buffer);
+
+  if (Stream.Read(8) != 'D' ||
+      Stream.Read(8) != 'I' ||
+      Stream.Read(8) != 'A' ||
+      Stream.Read(8) != 'G')
+    return SDError::InvalidSignature;
+
+  while (!Stream.AtEndOfStream()) {
+    // Top-level blocks start and end on word boundaries, so the preamble is a
+    // whole number of bytes.
+    uint64_t BitNo = Stream.GetCurrentBitNo();
+    if (Stream.ReadCode() != llvm::bitc::ENTER_SUBBLOCK)
+      return SDError::InvalidDiagnostics;
+
+    unsigned BlockID = Stream.ReadSubBlockID();
+    if (BlockID != llvm::bitc::BLOCKINFO_BLOCK_ID && BlockID != BLOCK_META)
+      return BitNo / 8;
+    if (Stream.SkipBlock())
+      return SDError::MalformedTopLevelBlock;
+  }
+  return Stream.GetCurrentBitNo() / 8;
+}
+
+std::error_code SerializedDiagnosticConcatenator::append(StringRef File) {
+  auto Buffer = llvm::MemoryBuffer::getFile(File);
+  if (!Buffer)
+    return SDError::CouldNotLoad;
+
+  llvm::ErrorOr<uint64_t> PreambleSize = getPreambleSize(**Buffer);
+  if (!PreambleSize)
+    return PreambleSize.getError();
+
+  StringRef Contents = (*Buffer)->getBuffer();
+  StringRef FilePreamble = Contents.take_front(*PreambleSize);
+  if (!WrotePreamble) {
+    Preamble = FilePreamble;
+    OS << Preamble;
+    WrotePreamble = true;
+  } else if (FilePreamble != Preamble) {
+    return SDError::PreambleMismatch;
+  }
+
+  OS << Contents.drop_front(*PreambleSize);
+  return std::error_code();
+}
+
 namespace {
 class SDErrorCategoryType final : public std::error_category {
   const char *name() const noexcept override {
@@ -280,6 +334,8 @@ class SDErrorCategoryType final : public std::error_category {
       return "Unsupported diagnostics version";
     case SDError::UnsupportedConstruct:
       return "Bitcode constructs that are not supported in diagnostics appear";
+    case SDError::PreambleMismatch:
+      return "Diagnostics were written by an incompatible version";
     case SDError::HandlerFailed:
       return "Generic error occurred while handling a record";
     }
@@ -0,0 +1,108 @@
+/*===--- omp_nvptx_intrinsics.h - Warp primitives for OpenMP device code ----===
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *===-----------------------------------------------------------------------===
+ */
+
+/* Warp level primitives for the code of OpenMP target regions offloaded to
+ * NVPTX devices. They are macros, so that the device compilation can check
+ * that the underlying builtins are only used in target regions and declare
+ * target functions. In the host fallback of a target region, every thread is
+ * a warp of a single lane.
+ */
+
+#ifndef __OMP_NVPTX_INTRINSICS_H
+#define __OMP_NVPTX_INTRINSICS_H
+
+#ifndef _OPENMP
+#error "This file is for OpenMP compilation only."
+#endif
+
+#ifdef __NVPTX__
+
+#define __omp_warp_size() 32
+#define __omp_lane_id() __nvvm_read_ptx_sreg_laneid()
+
+/* Shuffles between the lanes of segments of __width lanes of the warp. */
+#define __omp_shfl_i32(__val, __lane, __width)                                 \
+  __nvvm_shfl_idx_i32((__val), (__lane), ((32 - (__width)) << 8) | 0x1f)
+#define __omp_shfl_f32(__val, __lane, __width)                                 \
+  __nvvm_shfl_idx_f32((__val), (__lane), ((32 - (__width)) << 8) | 0x1f)
+/* shfl.up applies to the lanes above the first one of the segment. */
+#define __omp_shfl_up_i32(__val, __delta, __width)                             \
+  __nvvm_shfl_up_i32((__val), (__delta), (32 - (__width)) << 8)
+#define __omp_shfl_up_f32(__val, __delta, __width)                             \
+  __nvvm_shfl_up_f32((__val), (__delta), (32 - (__width)) << 8)
+#define __omp_shfl_down_i32(__val, __delta, __width)                           \
+  __nvvm_shfl_down_i32((__val), (__delta), ((32 - (__width)) << 8) | 0x1f)
+#define __omp_shfl_down_f32(__val, __delta, __width)                           \
+  __nvvm_shfl_down_f32((__val), (__delta), ((32 - (__width)) << 8) | 0x1f)
+#define __omp_shfl_xor_i32(__val, __mask, __width)                             \
+  __nvvm_shfl_bfly_i32((__val), (__mask), ((32 - (__width)) << 8) | 0x1f)
+#define __omp_shfl_xor_f32(__val, __mask, __width)                             \
+  __nvvm_shfl_bfly_f32((__val), (__mask), ((32 - (__width)) << 8) | 0x1f)
+
+/* Votes of the active lanes of the warp. */
+#define __omp_vote_all(__pred) __nvvm_vote_all(__pred)
+#define __omp_vote_any(__pred) __nvvm_vote_any(__pred)
+#define __omp_vote_uni(__pred) __nvvm_vote_uni(__pred)
+#define __omp_ballot(__pred) __nvvm_vote_ballot(__pred)
+
+/* Lanes of __mask with the same value, these need PTX 6.0 and sm_70. */
+#define __omp_match_any_i32(__mask, __val)                                     \
+  __nvvm_match_any_sync_i32((__mask), (__val))
+#define __omp_match_any_i64(__mask, __val)                                     \
+  __nvvm_match_any_sync_i64((__mask), (__val))
+
+#else
+
+#define __omp_warp_size() 1
+#define __omp_lane_id() 0
+
+#define __omp_shfl_i32(__val, __lane, __width)                                 \
+  ((void)(__lane), (void)(__width), (int)(__val))
+#define __omp_shfl_f32(__val, __lane, __width)                                 \
+  ((void)(__lane), (void)(__width), (float)(__val))
+#define __omp_shfl_up_i32(__val, __delta, __width)                             \
+  ((void)(__delta), (void)(__width), (int)(__val))
+#define __omp_shfl_up_f32(__val, __delta, __width)                             \
+  ((void)(__delta), (void)(__width), (float)(__val))
+#define __omp_shfl_down_i32(__val, __delta, __width)                           \
+  ((void)(__delta), (void)(__width), (int)(__val))
+#define __omp_shfl_down_f32(__val, __delta, __width)                           \
+  ((void)(__delta), (void)(__width), (float)(__val))
+#define __omp_shfl_xor_i32(__val, __mask, __width)                             \
+  ((void)(__mask), (void)(__width), (int)(__val))
+#define __omp_shfl_xor_f32(__val, __mask, __width)                             \
+  ((void)(__mask), (void)(__width), (float)(__val))
+
+#define __omp_vote_all(__pred) (!!(__pred))
+#define __omp_vote_any(__pred) (!!(__pred))
+#define __omp_vote_uni(__pred) ((void)(__pred), 1)
+#define __omp_ballot(__pred) ((__pred) ? 1u : 0u)
+
+#define __omp_match_any_i32(__mask, __val)                                     \
+  ((void)(__val), (unsigned int)(__mask) & 1u)
+#define __omp_match_any_i64(__mask, __val)                                     \
+  ((void)(__val), (long long)((__mask) & 1u))
+
+#endif
+
+#endif /* __OMP_NVPTX_INTRINSICS_H */
@@ -12,6 +12,7 @@
 #include "clang/AST/DeclTemplate.h"
 #include "clang/AST/DeclVisitor.h"
 #include "clang/Lex/PreprocessingRecord.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
 
@@ -53,16 +54,19 @@ class USRGenerator : public ConstDeclVisitor<USRGenerator> {
   bool IgnoreResults;
   ASTContext *Context;
   bool generatedLoc;
+  USRCache *Cache;
   
   llvm::DenseMap<const Type *, unsigned> TypeSubstitutions;
   
 public:
-  explicit USRGenerator(ASTContext *Ctx, SmallVectorImpl<char> &Buf)
+  explicit USRGenerator(ASTContext *Ctx, SmallVectorImpl<char> &Buf,
+                        USRCache *Cache = nullptr)
   : Buf(Buf),
     Out(Buf),
     IgnoreResults(false),
     Context(Ctx),
-    generatedLoc(false)
+    generatedLoc(false),
+    Cache(Cache)
   {
     // Add the USR space prefix.
     Out << getUSRSpacePrefix();
@@ -70,6 +74,12 @@ public:
 
   bool ignoreResults() const { return IgnoreResults; }
 
+  /// Whether the generated USR can start the USRs generated for the
+  /// declarations in its context, as if they generated it themselves.
+  bool isReusablePrefix() const {
+    return TypeSubstitutions.empty() && !generatedLoc;
+  }
+
   // Visitation methods from generating USRs from AST elements.
   void VisitDeclContext(const DeclContext *D);
   void VisitFieldDecl(const FieldDecl *D);
@@ -181,8 +191,23 @@ bool USRGenerator::ShouldGenerateLocation(const NamedDecl *D) {
 }
 
 void USRGenerator::VisitDeclContext(const DeclContext *DC) {
-  if (const NamedDecl *D = dyn_cast<NamedDecl>(DC))
-    Visit(D);
+  const NamedDecl *D = dyn_cast<NamedDecl>(DC);
+  if (!D)
+    return;
+
+  // At the start of a USR, use the cached USR of the context.
+  if (Cache && Buf.size() == getUSRSpacePrefix().size() &&
+      isReusablePrefix()) {
+    USRCache::CachedUSR ContextUSR = Cache->get(D);
+    if (ContextUSR.IsReusablePrefix) {
+      if (ContextUSR.USR.empty())
+        IgnoreResults = true;
+      else
+        Out << ContextUSR.USR.drop_front(getUSRSpacePrefix().size());
+      return;
+    }
+  }
+  Visit(D);
 }
 
 void USRGenerator::VisitFieldDecl(const FieldDecl *D) {
@@ -908,6 +933,27 @@ bool clang::index::generateUSRForDecl(const Decl *D,
   return UG.ignoreResults();
 }
 
+USRCache::CachedUSR USRCache::get(const Decl *D) {
+  auto Known = USRs.find(D);
+  if (Known != USRs.end())
+    return Known->second;
+
+  CachedUSR Result = {StringRef(), true};
+  if (D) {
+    SmallString<128> Buf;
+    USRGenerator UG(&D->getASTContext(), Buf, this);
+    UG.Visit(D);
+    if (!UG.ignoreResults())
+      Result.USR = Strings.insert(Buf).first->getKey();
+    Result.IsReusablePrefix = UG.isReusablePrefix();
+  }
+
+  // Generating the USR may have cached the USRs of the contexts of D, so
+  // insert it only now.
+  USRs[D] = Result;
+  return Result;
+}
+
 bool clang::index::generateUSRForMacro(const MacroDefinitionRecord *MD,
                                        const SourceManager &SM,
                                        SmallVectorImpl<char> &Buf) {
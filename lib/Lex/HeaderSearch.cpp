@@ -14,6 +14,7 @@
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/IdentifierTable.h"
+#include "clang/Basic/VirtualFileSystem.h"
 #include "clang/Lex/ExternalPreprocessorSource.h"
 #include "clang/Lex/HeaderMap.h"
 #include "clang/Lex/HeaderSearchOptions.h"
@@ -24,9 +25,13 @@
 #include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Support/Capacity.h"
+#include "llvm/Support/Chrono.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 #include <cstdio>
+#include <tuple>
 #include <utility>
 #if defined(LLVM_ON_UNIX)
 #include <limits.h>
@@ -54,6 +59,148 @@ HeaderFileInfo::getControllingMacro(ExternalPreprocessorSource *External) {
 
 ExternalHeaderFileInfoSource::~ExternalHeaderFileInfoSource() {}
 
+namespace clang {
+/// \brief The header search results and include guards that HeaderSearch
+/// keeps in a file between compilations.
+///
+/// The lookups are only valid for the search directories they were recorded
+/// with.  The hash of the search directories covers their modification times,
+/// so that adding a header to one of them drops the lookups.  The include
+/// guard of a file is only reused while the file keeps its modification time
+/// and size.
+class HeaderInfoCache {
+public:
+  struct LookupRecord {
+    /// The entry in SearchDirs that the search was started from.
+    unsigned StartIdx;
+    /// The entry in SearchDirs that satisfied the search.
+    unsigned HitIdx;
+  };
+
+  struct FileRecord {
+    time_t ModTime = 0;
+    uint64_t Size = 0;
+    std::string ControllingMacro;
+  };
+
+  /// \brief The hash of the search directories the lookups were made with.
+  uint64_t SearchHash = 0;
+  llvm::StringMap<LookupRecord> Lookups;
+  llvm::StringMap<FileRecord> Files;
+
+  /// \brief Whether the cache has changed since it was read.
+  bool Dirty = false;
+
+  /// \brief Read the cache from the given file.
+  ///
+  /// \returns false, leaving the cache empty, if the file does not exist or
+  /// is not a header info cache.
+  bool read(StringRef Path);
+
+  /// \brief Replace the given file with the contents of the cache.
+  bool write(StringRef Path) const;
+
+private:
+  bool readImpl(StringRef Path);
+};
+} // end namespace clang
+
+bool HeaderInfoCache::read(StringRef Path) {
+  if (readImpl(Path))
+    return true;
+  SearchHash = 0;
+  Lookups.clear();
+  Files.clear();
+  return false;
+}
+
+bool HeaderInfoCache::readImpl(StringRef Path) {
+  auto Buffer = llvm::MemoryBuffer::getFile(Path);
+  if (!Buffer)
+    return false;
+
+  // The file has a line for each entry, with the name last so that it may
+  // contain spaces:
+  //   search <hash>
+  //   lookup <start> <hit> <name>
+  //   file <mtime> <size> <macro> <path>
+  SmallVector<StringRef, 64> Lines;
+  (*Buffer)->getBuffer().split(Lines, '\n', /*MaxSplit=*/-1,
+                               /*KeepEmpty=*/false);
+  if (Lines.empty() || Lines[0] != "header-info-cache 1")
+    return false;
+
+  for (StringRef Line : llvm::makeArrayRef(Lines).slice(1)) {
+    StringRef Kind;
+    std::tie(Kind, Line) = Line.split(' ');
+    if (Kind == "search") {
+      if (Line.getAsInteger(16, SearchHash))
+        return false;
+    } else if (Kind == "lookup") {
+      StringRef Start, Hit;
+      std::tie(Start, Line) = Line.split(' ');
+      std::tie(Hit, Line) = Line.split(' ');
+      LookupRecord Record;
+      if (Start.getAsInteger(10, Record.StartIdx) ||
+          Hit.getAsInteger(10, Record.HitIdx) || Line.empty())
+        return false;
+      Lookups[Line] = Record;
+    } else if (Kind == "file") {
+      StringRef ModTime, Size, Macro;
+      std::tie(ModTime, Line) = Line.split(' ');
+      std::tie(Size, Line) = Line.split(' ');
+      std::tie(Macro, Line) = Line.split(' ');
+      long long Time;
+      FileRecord Record;
+      if (ModTime.getAsInteger(10, Time) ||
+          Size.getAsInteger(10, Record.Size) || Macro.empty() || Line.empty())
+        return false;
+      Record.ModTime = Time;
+      Record.ControllingMacro = Macro;
+      Files[Line] = std::move(Record);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool HeaderInfoCache::write(StringRef Path) const {
+  // Write to a temporary file and rename it over the cache, so that
+  // compilations running concurrently never see a partial cache.
+  int TmpFD;
+  SmallString<128> TmpPath;
+  if (llvm::sys::fs::createUniqueFile(Path + "-%%%%%%%%", TmpFD, TmpPath))
+    return false;
+
+  {
+    llvm::raw_fd_ostream Out(TmpFD, /*shouldClose=*/true);
+    Out << "header-info-cache 1\n";
+    Out << "search ";
+    Out.write_hex(SearchHash);
+    Out << '\n';
+    for (const auto &Lookup : Lookups)
+      Out << "lookup " << Lookup.second.StartIdx << ' '
+          << Lookup.second.HitIdx << ' ' << Lookup.first() << '\n';
+    for (const auto &File : Files)
+      Out << "file " << (long long)File.second.ModTime << ' '
+          << File.second.Size << ' ' << File.second.ControllingMacro << ' '
+          << File.first() << '\n';
+    Out.close();
+    if (Out.has_error()) {
+      Out.clear_error();
+      llvm::sys::fs::remove(TmpPath);
+      return false;
+    }
+  }
+
+  if (llvm::sys::fs::rename(TmpPath, Path)) {
+    llvm::sys::fs::remove(TmpPath);
+    return false;
+  }
+  return true;
+}
+
 HeaderSearch::HeaderSearch(IntrusiveRefCntPtr<HeaderSearchOptions> HSOpts,
                            SourceManager &SourceMgr, DiagnosticsEngine &Diags,
                            const LangOptions &LangOpts,
@@ -65,6 +212,9 @@ HeaderSearch::HeaderSearch(IntrusiveRefCntPtr<HeaderSearchOptions> HSOpts,
   SystemDirIdx = 0;
   NoCurDirSearch = false;
 
+  InfoCacheLoaded = false;
+  InfoCacheValidated = false;
+
   ExternalLookup = nullptr;
   ExternalSource = nullptr;
   NumIncluded = 0;
@@ -78,6 +228,87 @@ HeaderSearch::~HeaderSearch() {
     delete HeaderMaps[i].second;
 }
 
+HeaderInfoCache *HeaderSearch::getHeaderInfoCache() {
+  if (!InfoCacheLoaded) {
+    InfoCacheLoaded = true;
+    if (HSOpts->HeaderInfoCachePath.empty())
+      return nullptr;
+    InfoCache.reset(new HeaderInfoCache);
+    InfoCache->read(HSOpts->HeaderInfoCachePath);
+  }
+  if (!InfoCache)
+    return nullptr;
+
+  // The recorded lookups only hold for the search directories they were made
+  // with, in the state they were in.
+  if (!InfoCacheValidated) {
+    InfoCacheValidated = true;
+    llvm::hash_code Hash =
+        llvm::hash_combine(AngledDirIdx, SystemDirIdx, NoCurDirSearch);
+    for (const DirectoryLookup &DL : SearchDirs) {
+      Hash = llvm::hash_combine(Hash, DL.getName(),
+                                (unsigned)DL.getLookupType(),
+                                (unsigned)DL.getDirCharacteristic());
+      if (auto Status = FileMgr.getVirtualFileSystem()->status(DL.getName())) {
+        time_t ModTime = llvm::sys::toTimeT(Status->getLastModificationTime());
+        Hash = llvm::hash_combine(Hash, (long long)ModTime);
+      }
+    }
+    if (InfoCache->SearchHash != (uint64_t)Hash) {
+      InfoCache->SearchHash = Hash;
+      InfoCache->Lookups.clear();
+      InfoCache->Dirty = true;
+    }
+  }
+  return InfoCache.get();
+}
+
+void HeaderSearch::writeHeaderInfoCache() {
+  HeaderInfoCache *Cache = getHeaderInfoCache();
+  if (!Cache)
+    return;
+
+  // Record the include guards found by this compilation.
+  SmallVector<const FileEntry *, 16> FilesByUID;
+  FileMgr.GetUniqueIDMapping(FilesByUID);
+  for (unsigned UID = 0, E = std::min(FileInfo.size(), FilesByUID.size());
+       UID != E; ++UID) {
+    const HeaderFileInfo &HFI = FileInfo[UID];
+    const FileEntry *FE = FilesByUID[UID];
+    if (!FE || !HFI.IsValid || HFI.External || !HFI.ControllingMacro ||
+        FE->getName().find('\n') != StringRef::npos)
+      continue;
+
+    HeaderInfoCache::FileRecord &Record = Cache->Files[FE->getName()];
+    StringRef Macro = HFI.ControllingMacro->getName();
+    if (Record.ModTime == FE->getModificationTime() &&
+        Record.Size == (uint64_t)FE->getSize() &&
+        Record.ControllingMacro == Macro)
+      continue;
+    Record.ModTime = FE->getModificationTime();
+    Record.Size = FE->getSize();
+    Record.ControllingMacro = Macro;
+    Cache->Dirty = true;
+  }
+  if (!Cache->Dirty)
+    return;
+
+  // Keep what the compilations that finished in the meantime recorded.
+  StringRef Path = HSOpts->HeaderInfoCachePath;
+  HeaderInfoCache OnDisk;
+  if (OnDisk.read(Path)) {
+    if (OnDisk.SearchHash == Cache->SearchHash)
+      for (const auto &Lookup : OnDisk.Lookups)
+        Cache->Lookups.insert(std::make_pair(Lookup.first(), Lookup.second));
+    for (const auto &File : OnDisk.Files)
+      Cache->Files.insert(std::make_pair(File.first(), File.second));
+  }
+
+  // The cache only holds hints, so failing to write it is not an error.
+  Cache->write(Path);
+  Cache->Dirty = false;
+}
+
 void HeaderSearch::PrintStats() {
   fprintf(stderr, "\n*** HeaderSearch Stats:\n");
   fprintf(stderr, "%d files tracked.\n", (int)FileInfo.size());
@@ -759,6 +990,40 @@ const FileEntry *HeaderSearch::LookupFile(
     // our search start.  We will fill in our found location below, so prime the
     // start point value.
     CacheLookup.reset(/*StartIdx=*/i+1);
+
+    // An earlier compilation may have made the same search.  Its result holds
+    // as long as the file is still in the directory it was found in.
+    HeaderInfoCache *Cache = SkipCache ? nullptr : getHeaderInfoCache();
+    bool KnownHit = false;
+    if (Cache) {
+      auto Known = Cache->Lookups.find(Filename);
+      if (Known != Cache->Lookups.end() && Known->second.StartIdx == i &&
+          Known->second.HitIdx < SearchDirs.size() &&
+          SearchDirs[Known->second.HitIdx].isNormalDir()) {
+        SmallString<1024> Path(SearchDirs[Known->second.HitIdx].getName());
+        llvm::sys::path::append(Path, Filename);
+        if (FileMgr.getFile(Path, /*OpenFile=*/false)) {
+          i = Known->second.HitIdx;
+          KnownHit = true;
+        }
+      }
+    }
+
+    // Nothing is known about this search, so look up the candidates of all
+    // the remaining directories at once on a file system where each lookup
+    // is slow.
+    if (!KnownHit && FileMgr.canPrefetchFiles() &&
+        SearchDirs.size() - i > 1) {
+      std::vector<std::string> Candidates;
+      for (unsigned j = i, e = SearchDirs.size(); j != e; ++j) {
+        if (!SearchDirs[j].isNormalDir())
+          continue;
+        SmallString<1024> Path(SearchDirs[j].getName());
+        llvm::sys::path::append(Path, Filename);
+        Candidates.push_back(Path.str());
+      }
+      FileMgr.prefetchFiles(Candidates);
+    }
   }
 
   SmallString<64> MappedName;
@@ -818,6 +1083,17 @@ const FileEntry *HeaderSearch::LookupFile(
 
     // Remember this location for the next lookup we do.
     CacheLookup.HitIdx = i;
+    if (!SkipCache && !CacheLookup.MappedName && CurDir->isNormalDir() &&
+        Filename.find('\n') == StringRef::npos)
+      if (HeaderInfoCache *Cache = getHeaderInfoCache()) {
+        HeaderInfoCache::LookupRecord Record = {CacheLookup.StartIdx - 1, i};
+        auto Known = Cache->Lookups.insert(std::make_pair(Filename, Record));
+        if (Known.second || Known.first->second.StartIdx != Record.StartIdx ||
+            Known.first->second.HitIdx != Record.HitIdx) {
+          Known.first->second = Record;
+          Cache->Dirty = true;
+        }
+      }
     return FE;
   }
 
@@ -1114,6 +1390,19 @@ bool HeaderSearch::ShouldEnterIncludeFile(Preprocessor &PP,
       return false;
   }
 
+  // If an earlier compilation found the include guard of this file, use it
+  // before the file is lexed for the first time.
+  if (!FileInfo.NumIncludes && !FileInfo.ControllingMacro &&
+      !FileInfo.ControllingMacroID && !FileInfo.External)
+    if (HeaderInfoCache *Cache = getHeaderInfoCache()) {
+      auto Known = Cache->Files.find(File->getName());
+      if (Known != Cache->Files.end() &&
+          Known->second.ModTime == File->getModificationTime() &&
+          Known->second.Size == (uint64_t)File->getSize())
+        FileInfo.ControllingMacro =
+            PP.getIdentifierInfo(Known->second.ControllingMacro);
+    }
+
   // Next, check to see if the file is wrapped with #ifndef guards.  If so, and
   // if the macro that guards it is defined, we know the #include has no effect.
   if (const IdentifierInfo *ControllingMacro
@@ -35,6 +35,12 @@
 #include <tuple>
 #include <utility>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 using namespace clang;
 
 //===----------------------------------------------------------------------===//
@@ -1504,9 +1510,160 @@ bool Lexer::tryConsumeIdentifierUTF8Char(const char *&CurPtr) {
   return true;
 }
 
+//===----------------------------------------------------------------------===//
+// Vectorized scanning
+//===----------------------------------------------------------------------===//
+//
+// The inner loops of the lexer that skip identifier bodies, horizontal
+// whitespace and the plain characters of literals look at 16 bytes at a time
+// where SSE2 or NEON is available.  Each of them stops short of the end of
+// the buffer, which leaves the last bytes and the targets without vectors to
+// the scalar loops that follow.
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+#define LEXER_VECTOR_SCAN
+
+#ifdef __SSE2__
+typedef __m128i ByteVector;
+
+/// The number of bits of a match mask for each byte of a vector.
+enum { MatchMaskBitsPerByte = 1 };
+
+static inline ByteVector loadBytes(const char *Ptr) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i *>(Ptr));
+}
+
+static inline ByteVector splatByte(char C) { return _mm_set1_epi8(C); }
+
+static inline ByteVector matchByte(ByteVector V, char C) {
+  return _mm_cmpeq_epi8(V, splatByte(C));
+}
+
+static inline ByteVector matchRange(ByteVector V, char Lo, char Hi) {
+  // The ranges are ASCII, the bytes that do not fit a signed char compare
+  // less than Lo.
+  return _mm_and_si128(_mm_cmpgt_epi8(V, splatByte(Lo - 1)),
+                       _mm_cmplt_epi8(V, splatByte(Hi + 1)));
+}
+
+static inline ByteVector orBytes(ByteVector A, ByteVector B) {
+  return _mm_or_si128(A, B);
+}
+
+static inline uint64_t getMatchMask(ByteVector V) {
+  return static_cast<unsigned>(_mm_movemask_epi8(V));
+}
+#else
+typedef uint8x16_t ByteVector;
+
+/// The number of bits of a match mask for each byte of a vector.
+enum { MatchMaskBitsPerByte = 4 };
+
+static inline ByteVector loadBytes(const char *Ptr) {
+  return vld1q_u8(reinterpret_cast<const uint8_t *>(Ptr));
+}
+
+static inline ByteVector splatByte(char C) {
+  return vdupq_n_u8(static_cast<uint8_t>(C));
+}
+
+static inline ByteVector matchByte(ByteVector V, char C) {
+  return vceqq_u8(V, splatByte(C));
+}
+
+static inline ByteVector matchRange(ByteVector V, char Lo, char Hi) {
+  return vcleq_u8(vsubq_u8(V, splatByte(Lo)), splatByte(Hi - Lo));
+}
+
+static inline ByteVector orBytes(ByteVector A, ByteVector B) {
+  return vorrq_u8(A, B);
+}
+
+static inline uint64_t getMatchMask(ByteVector V) {
+  // Narrow each byte to a nibble, there is no movemask.
+  return vget_lane_u64(
+      vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(V), 4)), 0);
+}
+#endif
+
+/// Return the number of bytes at the start of \p Mask that match.
+static inline unsigned countLeadingMatches(uint64_t Mask) {
+  return llvm::countTrailingOnes(Mask) / MatchMaskBitsPerByte;
+}
+
+/// Return the number of bytes at the start of \p Mask that do not match.
+static inline unsigned countLeadingMismatches(uint64_t Mask) {
+  return Mask ? llvm::countTrailingZeros(Mask) / MatchMaskBitsPerByte : 16;
+}
+#endif
+
+/// Skip the characters of an identifier body, [_A-Za-z0-9], from \p Ptr on.
+/// This may stop early, the caller scans the rest.
+static const char *skipIdentifierBody(const char *Ptr, const char *BufferEnd) {
+#ifdef LEXER_VECTOR_SCAN
+  while (Ptr + 16 <= BufferEnd) {
+    ByteVector V = loadBytes(Ptr);
+    // Map upper case letters to lower case ones, and nothing else into them.
+    ByteVector Lower = orBytes(V, splatByte(0x20));
+    uint64_t Mask = getMatchMask(
+        orBytes(orBytes(matchRange(Lower, 'a', 'z'), matchRange(V, '0', '9')),
+                matchByte(V, '_')));
+    unsigned N = countLeadingMatches(Mask);
+    Ptr += N;
+    if (N != 16)
+      break;
+  }
+#endif
+  return Ptr;
+}
+
+/// Skip the spaces and tabs from \p Ptr on, or all the horizontal whitespace
+/// characters if \p AllKinds is true.  This may stop early, the caller scans
+/// the rest.
+static const char *skipHorizontalWhitespace(const char *Ptr,
+                                            const char *BufferEnd,
+                                            bool AllKinds) {
+#ifdef LEXER_VECTOR_SCAN
+  while (Ptr + 16 <= BufferEnd) {
+    ByteVector V = loadBytes(Ptr);
+    ByteVector Match = orBytes(matchByte(V, ' '), matchByte(V, '\t'));
+    if (AllKinds)
+      Match = orBytes(Match, orBytes(matchByte(V, '\f'), matchByte(V, '\v')));
+    unsigned N = countLeadingMatches(getMatchMask(Match));
+    Ptr += N;
+    if (N != 16)
+      break;
+  }
+#endif
+  return Ptr;
+}
+
+/// Skip the characters of a string or character literal quoted by \p Quote
+/// from \p Ptr on that getAndAdvanceChar returns as they are and that do not
+/// end the literal: all but the quote, '\\', '?', newlines and nul.  This may
+/// stop early, the caller scans the rest.
+static const char *skipPlainLiteralChars(const char *Ptr, const char *BufferEnd,
+                                         char Quote) {
+#ifdef LEXER_VECTOR_SCAN
+  while (Ptr + 16 <= BufferEnd) {
+    ByteVector V = loadBytes(Ptr);
+    uint64_t Mask = getMatchMask(
+        orBytes(orBytes(orBytes(matchByte(V, Quote), matchByte(V, '\\')),
+                        orBytes(matchByte(V, '?'), matchByte(V, '\0'))),
+                orBytes(matchByte(V, '\n'), matchByte(V, '\r'))));
+    unsigned N = countLeadingMismatches(Mask);
+    Ptr += N;
+    if (N != 16)
+      break;
+  }
+#endif
+  return Ptr;
+}
+
 bool Lexer::LexIdentifier(Token &Result, const char *CurPtr) {
   // Match [_A-Za-z0-9]*, we have already matched [_A-Za-z$]
   unsigned Size;
+  CurPtr = skipIdentifierBody(CurPtr, BufferEnd);
   unsigned char C = *CurPtr++;
   while (isIdentifierBody(C))
     C = *CurPtr++;
@@ -1792,6 +1949,7 @@ bool Lexer::LexStringLiteral(Token &Result, const char *CurPtr,
 
       NulCharacter = CurPtr-1;
     }
+    CurPtr = skipPlainLiteralChars(CurPtr, BufferEnd, '"');
     C = getAndAdvanceChar(CurPtr, Result);
   }
 
@@ -1973,6 +2131,7 @@ bool Lexer::LexCharConstant(Token &Result, const char *CurPtr,
 
       NulCharacter = CurPtr-1;
     }
+    CurPtr = skipPlainLiteralChars(CurPtr, BufferEnd, '\'');
     C = getAndAdvanceChar(CurPtr, Result);
   }
 
@@ -2006,6 +2165,8 @@ bool Lexer::SkipWhitespace(Token &Result, const char *CurPtr,
   // Skip consecutive spaces efficiently.
   while (true) {
     // Skip horizontal whitespace very aggressively.
+    CurPtr = skipHorizontalWhitespace(CurPtr, BufferEnd, /*AllKinds=*/true);
+    Char = *CurPtr;
     while (isHorizontalWhitespace(Char))
       Char = *++CurPtr;
 
@@ -2951,6 +3112,7 @@ LexNextToken:
   // Small amounts of horizontal whitespace is very common between tokens.
   if ((*CurPtr == ' ') || (*CurPtr == '\t')) {
     ++CurPtr;
+    CurPtr = skipHorizontalWhitespace(CurPtr, BufferEnd, /*AllKinds=*/false);
     while ((*CurPtr == ' ') || (*CurPtr == '\t'))
       ++CurPtr;
 
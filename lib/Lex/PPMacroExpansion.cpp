@@ -606,6 +606,12 @@ bool Preprocessor::HandleMacroExpandedIdentifier(Token &Identifier,
     // we're done.
     ++NumFastMacroExpanded;
     return true;
+  } else if (MI->isObjectLike() && MI->getNumTokens() == 1 &&
+             HandleSingleTokenMacroChain(Identifier, MI, ExpansionEnd)) {
+    // Otherwise, if this macro is the first of a chain like "#define A B" and
+    // "#define B 42", expand all of it now.
+    ++NumFastMacroExpanded;
+    return true;
   }
 
   // Start expanding the macro.
@@ -613,6 +619,88 @@ bool Preprocessor::HandleMacroExpandedIdentifier(Token &Identifier,
   return false;
 }
 
+bool Preprocessor::HandleSingleTokenMacroChain(Token &Identifier,
+                                               MacroInfo *MI,
+                                               SourceLocation ExpansionEnd) {
+  // The callbacks of expansions in macro arguments are delayed; leave those
+  // to EnterMacro.
+  if (InMacroArgs)
+    return false;
+
+  // Find the macros of the chain.  Each stays enabled while the next one is
+  // expanded, so they are all disabled at the end of the chain.
+  enum { MaxChainLength = 8 };
+  SmallVector<MacroDefinition, 4> Links;
+  auto IsInChain = [&](const MacroInfo *Other) {
+    return Other == MI ||
+           std::any_of(Links.begin(), Links.end(),
+                       [&](const MacroDefinition &Link) {
+                         return Link.getMacroInfo() == Other;
+                       });
+  };
+  for (MacroInfo *Last = MI;;) {
+    IdentifierInfo *II = Last->getReplacementToken(0).getIdentifierInfo();
+    if (!II)
+      break;
+    if (II->isOutOfDate())
+      getExternalSource()->updateOutOfDateIdentifier(*II);
+    MacroDefinition Next = getMacroDefinition(II);
+    MacroInfo *NextMI = Next.getMacroInfo();
+    if (!NextMI || !NextMI->isEnabled() || IsInChain(NextMI))
+      break;
+
+    // Anything but another single token object-like macro needs a TokenLexer.
+    if (Links.size() == MaxChainLength || !NextMI->isObjectLike() ||
+        NextMI->isBuiltinMacro() || NextMI->getNumTokens() != 1 ||
+        Next.isAmbiguous())
+      return false;
+    Links.push_back(Next);
+    Last = NextMI;
+  }
+  if (Links.empty())
+    return false;
+
+  bool isAtStartOfLine = Identifier.isAtStartOfLine();
+  bool hasLeadingSpace = Identifier.hasLeadingSpace();
+  SourceLocation ExpandLoc = Identifier.getLocation();
+  MacroInfo *Cur = MI;
+  for (unsigned I = 0;; ++I) {
+    // Replace the token, as the single token fast path does, with a location
+    // nested in the expansion of the previous macro.
+    Identifier = Cur->getReplacementToken(0);
+    Identifier.setFlagValue(Token::StartOfLine, isAtStartOfLine);
+    Identifier.setFlagValue(Token::LeadingSpace, hasLeadingSpace);
+    Identifier.setLocation(SourceMgr.createExpansionLoc(
+        Identifier.getLocation(), ExpandLoc, ExpansionEnd,
+        Identifier.getLength()));
+    if (I == Links.size())
+      break;
+
+    const MacroDefinition &Next = Links[I];
+    ExpandLoc = ExpansionEnd = Identifier.getLocation();
+    if (Callbacks)
+      Callbacks->MacroExpands(Identifier, Next, SourceRange(ExpandLoc),
+                              /*Args=*/nullptr);
+    Cur = Next.getMacroInfo();
+    markMacroAsUsed(Cur);
+    ++NumMacroExpanded;
+    ++NumFastMacroExpanded;
+  }
+
+  // A name that is disabled, or that names a macro of the chain, must not be
+  // expanded later.
+  if (IdentifierInfo *NewII = Identifier.getIdentifierInfo()) {
+    if (MacroInfo *NewMI = getMacroInfo(NewII))
+      if (!NewMI->isEnabled() || IsInChain(NewMI)) {
+        Identifier.setFlag(Token::DisableExpand);
+        // Don't warn for "#define X X" at the end of the chain.
+        if (NewMI != Cur)
+          Diag(Identifier, diag::pp_disabled_macro_expansion);
+      }
+  }
+  return true;
+}
+
 enum Bracket {
   Brace,
   Paren
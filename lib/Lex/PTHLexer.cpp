@@ -15,11 +15,13 @@
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/FileSystemStatCache.h"
 #include "clang/Basic/IdentifierTable.h"
+#include "clang/Basic/LangOptions.h"
 #include "clang/Basic/TokenKinds.h"
 #include "clang/Lex/LexDiagnostic.h"
 #include "clang/Lex/PTHManager.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Lex/Token.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/EndianStream.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -430,7 +432,18 @@ static void InvalidPTH(DiagnosticsEngine &Diags, const char *Msg) {
   Diags.Report(Diags.getCustomDiagID(DiagnosticsEngine::Error, "%0")) << Msg;
 }
 
-PTHManager *PTHManager::Create(StringRef file, DiagnosticsEngine &Diags) {
+uint64_t PTHManager::getLexerFingerprint(const LangOptions &LangOpts) {
+  return llvm::hash_combine(
+      LangOpts.CPlusPlus, LangOpts.CPlusPlus11, LangOpts.CPlusPlus14,
+      LangOpts.CPlusPlus1z, LangOpts.C99, LangOpts.C11, LangOpts.ObjC1,
+      LangOpts.OpenCL, LangOpts.CUDA, LangOpts.MicrosoftExt,
+      LangOpts.MSVCCompat, LangOpts.AsmPreprocessor, LangOpts.TraditionalCPP,
+      LangOpts.Digraphs, LangOpts.Trigraphs, LangOpts.LineComment,
+      LangOpts.DollarIdents);
+}
+
+PTHManager *PTHManager::Create(StringRef file, DiagnosticsEngine &Diags,
+                               const LangOptions &LangOpts) {
   // Memory map the PTH file.
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> FileOrErr =
       llvm::MemoryBuffer::getFile(file);
@@ -450,7 +463,7 @@ PTHManager *PTHManager::Create(StringRef file, DiagnosticsEngine &Diags) {
   const unsigned char *BufEnd = (const unsigned char*)File->getBufferEnd();
 
   // Check the prologue of the file.
-  if ((BufEnd - BufBeg) < (signed)(sizeof("cfe-pth") + 4 + 4) ||
+  if ((BufEnd - BufBeg) < (signed)(sizeof("cfe-pth") + 4 + 8 + 4) ||
       memcmp(BufBeg, "cfe-pth", sizeof("cfe-pth")) != 0) {
     Diags.Report(diag::err_invalid_pth_file) << file;
     return nullptr;
@@ -468,6 +481,15 @@ PTHManager *PTHManager::Create(StringRef file, DiagnosticsEngine &Diags) {
     return nullptr;
   }
 
+  // Read the fingerprint of the language options the tokens were lexed with.
+  uint64_t Fingerprint = endian::readNext<uint32_t, little, aligned>(p);
+  Fingerprint |= (uint64_t)endian::readNext<uint32_t, little, aligned>(p) << 32;
+  if (Fingerprint != getLexerFingerprint(LangOpts)) {
+    InvalidPTH(Diags, "PTH file was generated with language options that lex "
+                      "differently from the current ones");
+    return nullptr;
+  }
+
   // Compute the address of the index table at the end of the PTH file.
   const unsigned char *PrologueOffset = p;
 
@@ -59,19 +59,21 @@ PreprocessingRecord::getPreprocessedEntitiesInRange(SourceRange Range) {
                           iterator(this, Res.second));
 }
 
-static bool isPreprocessedEntityIfInFileID(PreprocessedEntity *PPE, FileID FID,
-                                           SourceManager &SM) {
+static bool isLocInFileID(SourceLocation Loc, FileID FID, SourceManager &SM) {
   assert(FID.isValid());
-  if (!PPE)
-    return false;
-
-  SourceLocation Loc = PPE->getSourceRange().getBegin();
   if (Loc.isInvalid())
     return false;
 
   return SM.isInFileID(SM.getFileLoc(Loc), FID);
 }
 
+static bool isPreprocessedEntityIfInFileID(PreprocessedEntity *PPE, FileID FID,
+                                           SourceManager &SM) {
+  if (!PPE)
+    return false;
+  return isLocInFileID(PPE->getSourceRange().getBegin(), FID, SM);
+}
+
 /// \brief Returns true if the preprocessed entity that \arg PPEI iterator
 /// points to is coming from the file \arg FID.
 ///
@@ -112,8 +114,8 @@ bool PreprocessingRecord::isEntityInFileID(iterator PPEI, FileID FID) {
     assert(0 && "Out-of bounds local preprocessed entity");
     return false;
   }
-  return isPreprocessedEntityIfInFileID(PreprocessedEntities[Pos],
-                                        FID, SourceMgr);
+  SourceRange Range = getLocalEntityRange(PreprocessedEntities[Pos]);
+  return isLocInFileID(Range.getBegin(), FID, SourceMgr);
 }
 
 /// \brief Returns a pair of [Begin, End) iterators of preprocessed entities
@@ -160,38 +162,6 @@ PreprocessingRecord::findLocalPreprocessedEntitiesInRange(
   return std::make_pair(Begin, End);
 }
 
-namespace {
-
-template <SourceLocation (SourceRange::*getRangeLoc)() const>
-struct PPEntityComp {
-  const SourceManager &SM;
-
-  explicit PPEntityComp(const SourceManager &SM) : SM(SM) { }
-
-  bool operator()(PreprocessedEntity *L, PreprocessedEntity *R) const {
-    SourceLocation LHS = getLoc(L);
-    SourceLocation RHS = getLoc(R);
-    return SM.isBeforeInTranslationUnit(LHS, RHS);
-  }
-
-  bool operator()(PreprocessedEntity *L, SourceLocation RHS) const {
-    SourceLocation LHS = getLoc(L);
-    return SM.isBeforeInTranslationUnit(LHS, RHS);
-  }
-
-  bool operator()(SourceLocation LHS, PreprocessedEntity *R) const {
-    SourceLocation RHS = getLoc(R);
-    return SM.isBeforeInTranslationUnit(LHS, RHS);
-  }
-
-  SourceLocation getLoc(PreprocessedEntity *PPE) const {
-    SourceRange Range = PPE->getSourceRange();
-    return (Range.*getRangeLoc)();
-  }
-};
-
-}
-
 unsigned PreprocessingRecord::findBeginLocalPreprocessedEntity(
                                                      SourceLocation Loc) const {
   if (SourceMgr.isLoadedSourceLocation(Loc))
@@ -199,9 +169,8 @@ unsigned PreprocessingRecord::findBeginLocalPreprocessedEntity(
 
   size_t Count = PreprocessedEntities.size();
   size_t Half;
-  std::vector<PreprocessedEntity *>::const_iterator
-    First = PreprocessedEntities.begin();
-  std::vector<PreprocessedEntity *>::const_iterator I;
+  std::vector<LocalEntity>::const_iterator First = PreprocessedEntities.begin();
+  std::vector<LocalEntity>::const_iterator I;
 
   // Do a binary search manually instead of using std::lower_bound because
   // The end locations of entities may be unordered (when a macro expansion
@@ -211,7 +180,7 @@ unsigned PreprocessingRecord::findBeginLocalPreprocessedEntity(
     Half = Count/2;
     I = First;
     std::advance(I, Half);
-    if (SourceMgr.isBeforeInTranslationUnit((*I)->getSourceRange().getEnd(),
+    if (SourceMgr.isBeforeInTranslationUnit(getLocalEntityRange(*I).getEnd(),
                                             Loc)){
       First = I;
       ++First;
@@ -228,14 +197,24 @@ unsigned PreprocessingRecord::findEndLocalPreprocessedEntity(
   if (SourceMgr.isLoadedSourceLocation(Loc))
     return 0;
 
-  std::vector<PreprocessedEntity *>::const_iterator
-  I = std::upper_bound(PreprocessedEntities.begin(),
-                       PreprocessedEntities.end(),
-                       Loc,
-                       PPEntityComp<&SourceRange::getBegin>(SourceMgr));
+  std::vector<LocalEntity>::const_iterator I = std::upper_bound(
+      PreprocessedEntities.begin(), PreprocessedEntities.end(), Loc,
+      [&](SourceLocation LHS, LocalEntity Entity) {
+        return SourceMgr.isBeforeInTranslationUnit(
+            LHS, getLocalEntityRange(Entity).getBegin());
+      });
   return I - PreprocessedEntities.begin();
 }
 
+SourceRange PreprocessingRecord::getLocalEntityRange(LocalEntity Entity) const {
+  if (PreprocessedEntity *PPE = Entity.getEntity())
+    return PPE->getSourceRange();
+  const CompactExpansion &Expansion =
+      CompactExpansions[Entity.getCompactExpansionIndex()];
+  return SourceRange(SourceLocation::getFromRawEncoding(Expansion.Begin),
+                     SourceLocation::getFromRawEncoding(Expansion.End));
+}
+
 PreprocessingRecord::PPEntityID
 PreprocessingRecord::addPreprocessedEntity(PreprocessedEntity *Entity) {
   assert(Entity);
@@ -245,16 +224,23 @@ PreprocessingRecord::addPreprocessedEntity(PreprocessedEntity *Entity) {
     assert((PreprocessedEntities.empty() ||
             !SourceMgr.isBeforeInTranslationUnit(
                 BeginLoc,
-                PreprocessedEntities.back()->getSourceRange().getBegin())) &&
+                getLocalEntityRange(PreprocessedEntities.back()).getBegin())) &&
            "a macro definition was encountered out-of-order");
     PreprocessedEntities.push_back(Entity);
     return getPPEntityID(PreprocessedEntities.size()-1, /*isLoaded=*/false);
   }
 
+  return addLocalEntity(Entity, BeginLoc);
+}
+
+PreprocessingRecord::PPEntityID
+PreprocessingRecord::addLocalEntity(LocalEntity Entity,
+                                    SourceLocation BeginLoc) {
   // Check normal case, this entity begin location is after the previous one.
   if (PreprocessedEntities.empty() ||
-      !SourceMgr.isBeforeInTranslationUnit(BeginLoc,
-                   PreprocessedEntities.back()->getSourceRange().getBegin())) {
+      !SourceMgr.isBeforeInTranslationUnit(
+          BeginLoc,
+          getLocalEntityRange(PreprocessedEntities.back()).getBegin())) {
     PreprocessedEntities.push_back(Entity);
     return getPPEntityID(PreprocessedEntities.size()-1, /*isLoaded=*/false);
   }
@@ -271,7 +257,7 @@ PreprocessingRecord::addPreprocessedEntity(PreprocessedEntity *Entity) {
   //  FM(M1, M2)
   // \endcode
 
-  typedef std::vector<PreprocessedEntity *>::iterator pp_iter;
+  typedef std::vector<LocalEntity>::iterator pp_iter;
 
   // Usually there are few macro expansions when defining the filename, do a
   // linear search for a few entities.
@@ -281,8 +267,8 @@ PreprocessingRecord::addPreprocessedEntity(PreprocessedEntity *Entity) {
        RI != Begin && count < 4; --RI, ++count) {
     pp_iter I = RI;
     --I;
-    if (!SourceMgr.isBeforeInTranslationUnit(BeginLoc,
-                                           (*I)->getSourceRange().getBegin())) {
+    if (!SourceMgr.isBeforeInTranslationUnit(
+            BeginLoc, getLocalEntityRange(*I).getBegin())) {
       pp_iter insertI = PreprocessedEntities.insert(RI, Entity);
       return getPPEntityID(insertI - PreprocessedEntities.begin(),
                            /*isLoaded=*/false);
@@ -290,10 +276,12 @@ PreprocessingRecord::addPreprocessedEntity(PreprocessedEntity *Entity) {
   }
 
   // Linear search unsuccessful. Do a binary search.
-  pp_iter I = std::upper_bound(PreprocessedEntities.begin(),
-                               PreprocessedEntities.end(),
-                               BeginLoc,
-                               PPEntityComp<&SourceRange::getBegin>(SourceMgr));
+  pp_iter I = std::upper_bound(
+      PreprocessedEntities.begin(), PreprocessedEntities.end(), BeginLoc,
+      [&](SourceLocation Loc, LocalEntity Other) {
+        return SourceMgr.isBeforeInTranslationUnit(
+            Loc, getLocalEntityRange(Other).getBegin());
+      });
   pp_iter insertI = PreprocessedEntities.insert(I, Entity);
   return getPPEntityID(insertI - PreprocessedEntities.begin(),
                        /*isLoaded=*/false);
@@ -332,7 +320,23 @@ PreprocessedEntity *PreprocessingRecord::getPreprocessedEntity(PPEntityID PPID){
   unsigned Index = PPID.ID - 1;
   assert(Index < PreprocessedEntities.size() &&
          "Out-of bounds local preprocessed entity");
-  return PreprocessedEntities[Index];
+  LocalEntity &Entity = PreprocessedEntities[Index];
+  if (!Entity.isCompactExpansion())
+    return Entity.getEntity();
+
+  // Create the macro expansion now that it is needed.
+  SourceRange Range = getLocalEntityRange(Entity);
+  MacroExpansion::NameOrDefinition Macro =
+      ExpandedMacros[CompactExpansions[Entity.getCompactExpansionIndex()]
+                         .Macro];
+  MacroExpansion *Expansion;
+  if (MacroDefinitionRecord *Def = Macro.dyn_cast<MacroDefinitionRecord *>())
+    Expansion = new (*this) MacroExpansion(Def, Range);
+  else
+    Expansion =
+        new (*this) MacroExpansion(Macro.get<IdentifierInfo *>(), Range);
+  Entity = Expansion;
+  return Expansion;
 }
 
 /// \brief Retrieve the loaded preprocessed entity at the given index.
@@ -368,11 +372,25 @@ void PreprocessingRecord::addMacroExpansion(const Token &Id,
   if (Id.getLocation().isMacroID())
     return;
 
+  MacroExpansion::NameOrDefinition Macro;
   if (MI->isBuiltinMacro())
-    addPreprocessedEntity(new (*this)
-                              MacroExpansion(Id.getIdentifierInfo(), Range));
+    Macro = Id.getIdentifierInfo();
   else if (MacroDefinitionRecord *Def = findMacroDefinition(MI))
-    addPreprocessedEntity(new (*this) MacroExpansion(Def, Range));
+    Macro = Def;
+  else
+    return;
+
+  // Record the expansion compactly; its MacroExpansion is created when it is
+  // first retrieved.
+  auto Known = ExpandedMacroIDs.insert(
+      std::make_pair(Macro.getOpaqueValue(), ExpandedMacros.size()));
+  if (Known.second)
+    ExpandedMacros.push_back(Macro);
+  CompactExpansions.push_back({Range.getBegin().getRawEncoding(),
+                               Range.getEnd().getRawEncoding(),
+                               Known.first->second});
+  addLocalEntity(LocalEntity::getCompactExpansion(CompactExpansions.size() - 1),
+                 Range.getBegin());
 }
 
 void PreprocessingRecord::Ifdef(SourceLocation Loc, const Token &MacroNameTok,
@@ -479,5 +497,8 @@ size_t PreprocessingRecord::getTotalMemory() const {
   return BumpAlloc.getTotalMemory()
     + llvm::capacity_in_bytes(MacroDefinitions)
     + llvm::capacity_in_bytes(PreprocessedEntities)
+    + llvm::capacity_in_bytes(CompactExpansions)
+    + llvm::capacity_in_bytes(ExpandedMacros)
+    + llvm::capacity_in_bytes(ExpandedMacroIDs)
     + llvm::capacity_in_bytes(LoadedPreprocessedEntities);
 }
@@ -2001,6 +2001,8 @@ bool Parser::trySkippingFunctionBody() {
   assert(SkipFunctionBodies &&
          "Should only be called when SkipFunctionBodies is enabled");
   if (!PP.isCodeCompletionEnabled()) {
+    if (getLangOpts().OpenMPSkipHostFunctionBodies)
+      return trySkippingOpenMPHostFunctionBody();
     SkipFunctionBody();
     return true;
   }
@@ -2037,6 +2039,42 @@ bool Parser::trySkippingFunctionBody() {
   return true;
 }
 
+bool Parser::trySkippingOpenMPHostFunctionBody() {
+  // In an OpenMP device compilation only the target regions and the declare
+  // target functions produce code. Sema already refused to skip the latter,
+  // so store the body and parse it only if it contains an OpenMP directive
+  // that starts with 'target'.
+  TentativeParsingAction PA(*this);
+  tok::TokenKind Kind = Tok.getKind();
+  CachedTokens Toks;
+  if (ConsumeAndStoreFunctionPrologue(Toks) ||
+      !ConsumeAndStoreUntil(tok::r_brace, Toks, /*StopAtSemi=*/false)) {
+    // Let the parser diagnose the malformed body.
+    PA.Revert();
+    return false;
+  }
+  if (Kind == tok::kw_try) {
+    while (Tok.is(tok::kw_catch)) {
+      if (!ConsumeAndStoreUntil(tok::l_brace, Toks, /*StopAtSemi=*/false) ||
+          !ConsumeAndStoreUntil(tok::r_brace, Toks, /*StopAtSemi=*/false)) {
+        PA.Revert();
+        return false;
+      }
+    }
+  }
+
+  IdentifierInfo *TargetII = PP.getIdentifierInfo("target");
+  for (unsigned I = 0, E = Toks.size(); I + 1 < E; ++I) {
+    if (Toks[I].is(tok::annot_pragma_openmp) &&
+        Toks[I + 1].getIdentifierInfo() == TargetII) {
+      PA.Revert();
+      return false;
+    }
+  }
+  PA.Commit();
+  return true;
+}
+
 /// ParseCXXTryBlock - Parse a C++ try-block.
 ///
 ///       try-block:
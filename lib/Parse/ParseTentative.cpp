@@ -131,23 +131,62 @@ bool Parser::isCXXSimpleDeclaration(bool AllowForRangeDecl) {
 
   // Ok, we have a simple-type-specifier/typename-specifier followed by a '(',
   // or an identifier which doesn't resolve as anything. We need tentative
-  // parsing...
- 
+  // parsing, unless we already did it for this statement.
+  DisambiguationKind Kind =
+      AllowForRangeDecl ? DK_ForRangeDeclaration : DK_SimpleDeclaration;
+  if (const DisambiguationResult *R = findDisambiguationResult(Kind))
+    return R->IsDeclaration;
+
   {
     RevertingTentativeParsingAction PA(*this);
     TPR = TryParseSimpleDeclaration(AllowForRangeDecl);
   }
 
   // In case of an error, let the declaration parsing code handle it.
-  if (TPR == TPResult::Error)
-    return true;
-
   // Declarations take precedence over expressions.
-  if (TPR == TPResult::Ambiguous)
-    TPR = TPResult::True;
+  bool IsDeclaration = TPR != TPResult::False;
+  addDisambiguationResult(Kind, IsDeclaration, /*IsAmbiguous=*/false);
+  return IsDeclaration;
+}
 
-  assert(TPR == TPResult::True || TPR == TPResult::False);
-  return TPR == TPResult::True;
+/// \brief Compute the key of the disambiguation of kind \p Kind starting at the
+/// current token. The results also depend on whether '>' and ':' are
+/// operators here.
+std::pair<unsigned, unsigned>
+Parser::getDisambiguationKey(DisambiguationKind Kind) {
+  return std::make_pair(Tok.getLocation().getRawEncoding(),
+                        Kind | GreaterThanIsOperator << 2 | ColonIsSacred << 3);
+}
+
+/// \brief Find the result of a disambiguation of kind \p Kind that was
+/// performed at the current token in the same state.
+const Parser::DisambiguationResult *
+Parser::findDisambiguationResult(DisambiguationKind Kind) {
+  // A code completion point cuts the tentative parses short.
+  if (PP.isCodeCompletionEnabled())
+    return nullptr;
+
+  auto I = DisambiguationResults.find(getDisambiguationKey(Kind));
+  if (I == DisambiguationResults.end())
+    return nullptr;
+
+  const DisambiguationResult &R = I->second;
+  if (makeArrayRef(R.TentativelyDeclared) !=
+      makeArrayRef(TentativelyDeclaredIdentifiers))
+    return nullptr;
+  return &R;
+}
+
+void Parser::addDisambiguationResult(DisambiguationKind Kind,
+                                     bool IsDeclaration, bool IsAmbiguous) {
+  if (PP.isCodeCompletionEnabled())
+    return;
+
+  DisambiguationResult &R = DisambiguationResults[getDisambiguationKey(Kind)];
+  R.TentativelyDeclared.assign(TentativelyDeclaredIdentifiers.begin(),
+                               TentativelyDeclaredIdentifiers.end());
+  R.IsDeclaration = IsDeclaration;
+  R.IsAmbiguous = IsAmbiguous;
 }
 
 /// Try to consume a token sequence that we've already identified as
@@ -1674,27 +1713,38 @@ bool Parser::isCXXFunctionDeclarator(bool *IsAmbiguous) {
   // ambiguities mentioned in 6.8, the resolution is to consider any construct
   // that could possibly be a declaration a declaration.
 
-  RevertingTentativeParsingAction PA(*this);
+  if (const DisambiguationResult *R =
+          findDisambiguationResult(DK_FunctionDeclarator)) {
+    if (IsAmbiguous && R->IsAmbiguous)
+      *IsAmbiguous = true;
+    return R->IsDeclaration;
+  }
 
-  ConsumeParen();
-  bool InvalidAsDeclaration = false;
-  TPResult TPR = TryParseParameterDeclarationClause(&InvalidAsDeclaration);
-  if (TPR == TPResult::Ambiguous) {
-    if (Tok.isNot(tok::r_paren))
-      TPR = TPResult::False;
-    else {
-      const Token &Next = NextToken();
-      if (Next.isOneOf(tok::amp, tok::ampamp, tok::kw_const, tok::kw_volatile,
-                       tok::kw_throw, tok::kw_noexcept, tok::l_square,
-                       tok::l_brace, tok::kw_try, tok::equal, tok::arrow) ||
-          isCXX11VirtSpecifier(Next))
-        // The next token cannot appear after a constructor-style initializer,
-        // and can appear next in a function definition. This must be a function
-        // declarator.
-        TPR = TPResult::True;
-      else if (InvalidAsDeclaration)
-        // Use the absence of 'typename' as a tie-breaker.
+  TPResult TPR;
+  {
+    RevertingTentativeParsingAction PA(*this);
+
+    ConsumeParen();
+    bool InvalidAsDeclaration = false;
+    TPR = TryParseParameterDeclarationClause(&InvalidAsDeclaration);
+    if (TPR == TPResult::Ambiguous) {
+      if (Tok.isNot(tok::r_paren))
         TPR = TPResult::False;
+      else {
+        const Token &Next = NextToken();
+        if (Next.isOneOf(tok::amp, tok::ampamp, tok::kw_const,
+                         tok::kw_volatile, tok::kw_throw, tok::kw_noexcept,
+                         tok::l_square, tok::l_brace, tok::kw_try, tok::equal,
+                         tok::arrow) ||
+            isCXX11VirtSpecifier(Next))
+          // The next token cannot appear after a constructor-style
+          // initializer, and can appear next in a function definition. This
+          // must be a function declarator.
+          TPR = TPResult::True;
+        else if (InvalidAsDeclaration)
+          // Use the absence of 'typename' as a tie-breaker.
+          TPR = TPResult::False;
+      }
     }
   }
 
@@ -1702,7 +1752,10 @@ bool Parser::isCXXFunctionDeclarator(bool *IsAmbiguous) {
     *IsAmbiguous = true;
 
   // In case of an error, let the declaration parsing code handle it.
-  return TPR != TPResult::False;
+  bool IsDeclaration = TPR != TPResult::False;
+  addDisambiguationResult(DK_FunctionDeclarator, IsDeclaration,
+                          TPR == TPResult::Ambiguous);
+  return IsDeclaration;
 }
 
 /// parameter-declaration-clause:
@@ -16,6 +16,7 @@
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/DeclTemplate.h"
+#include "clang/Basic/TimeTrace.h"
 #include "clang/Parse/ParseDiagnostic.h"
 #include "clang/Sema/DeclSpec.h"
 #include "clang/Sema/ParsedTemplate.h"
@@ -72,7 +73,9 @@ Parser::Parser(Preprocessor &pp, Sema &actions, bool skipFunctionBodies)
     GreaterThanIsOperator(true), ColonIsSacred(false), 
     InMessageExpression(false), TemplateParameterDepth(0),
     ParsingInObjCContainer(false) {
-  SkipFunctionBodies = pp.isCodeCompletionEnabled() || skipFunctionBodies;
+  SkipFunctionBodies = pp.isCodeCompletionEnabled() || skipFunctionBodies ||
+                       getLangOpts().OpenMPSkipHostFunctionBodies ||
+                       getLangOpts().SkipFunctionBodiesOutsideMainFile;
   Tok.startToken();
   Tok.setKind(tok::eof);
   Actions.CurScope = nullptr;
@@ -569,8 +572,17 @@ bool Parser::ParseFirstTopLevelDecl(DeclGroupPtrTy &Result) {
 /// ParseTopLevelDecl - Parse one top-level declaration, return whatever the
 /// action tells us to.  This returns true if the EOF was encountered.
 bool Parser::ParseTopLevelDecl(DeclGroupPtrTy &Result) {
+  TimeTraceScope TTS("ParseTopLevelDecl", [&] {
+    PresumedLoc PLoc = PP.getSourceManager().getPresumedLoc(Tok.getLocation());
+    if (PLoc.isInvalid())
+      return std::string();
+    return (Twine(PLoc.getFilename()) + ":" + Twine(PLoc.getLine())).str();
+  });
   DestroyTemplateIdAnnotationsRAIIObj CleanupRAII(TemplateIds);
 
+  // Ambiguities do not span top-level declarations.
+  DisambiguationResults.clear();
+
   // Skip over the EOF token, flagging end of previous input for incremental
   // processing
   if (PP.isIncrementalProcessingEnabled() && Tok.is(tok::eof))
@@ -1860,6 +1860,7 @@ static unsigned isEnabled(DiagnosticsEngine &D, unsigned diag) {
 
 clang::sema::AnalysisBasedWarnings::AnalysisBasedWarnings(Sema &s)
   : S(s),
+    SharedCFGs(nullptr),
     NumFunctionsAnalyzed(0),
     NumFunctionsWithBadCFGs(0),
     NumCFGBlocks(0),
@@ -1925,6 +1926,7 @@ AnalysisBasedWarnings::IssueWarnings(sema::AnalysisBasedWarnings::Policy P,
 
   // Construct the analysis context with the specified CFG build options.
   AnalysisDeclContext AC(/* AnalysisDeclContextManager */ nullptr, D);
+  AC.setCFGCache(SharedCFGs);
 
   // Don't generate EH edges for CallExprs as we'd like to avoid the n^2
   // explosion for destructors that can result and the compile time hit.
@@ -1943,8 +1945,10 @@ AnalysisBasedWarnings::IssueWarnings(sema::AnalysisBasedWarnings::Policy P,
   // expect to always be CFGElements and then fill in the BuildOptions
   // appropriately.  This is essentially a layering violation.
   if (P.enableCheckUnreachable || P.enableThreadSafetyAnalysis ||
-      P.enableConsumedAnalysis) {
+      P.enableConsumedAnalysis || SharedCFGs) {
     // Unreachable code analysis and thread safety require a linearized CFG.
+    // So do the other clients of the shared CFGs, and the linearized CFG
+    // works for all the analyses here.
     AC.getCFGBuildOptions().setAllAlwaysAdd();
   }
   else {
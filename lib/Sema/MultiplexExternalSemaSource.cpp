@@ -137,6 +137,16 @@ void MultiplexExternalSemaSource::ReadComments() {
     Sources[i]->ReadComments();
 }
 
+ExternalASTSource::ExtKind
+MultiplexExternalSemaSource::hasExternalDefinitions(const Decl *D) {
+  for (size_t i = 0; i < Sources.size(); ++i) {
+    ExtKind EK = Sources[i]->hasExternalDefinitions(D);
+    if (EK != EK_ReplyHazy)
+      return EK;
+  }
+  return EK_ReplyHazy;
+}
+
 void MultiplexExternalSemaSource::StartedDeserializing() {
   for(size_t i = 0; i < Sources.size(); ++i)
     Sources[i]->StartedDeserializing();
@@ -98,6 +98,8 @@ Sema::Sema(Preprocessor &pp, ASTContext &ctxt, ASTConsumer &consumer,
     NSDictionaryDecl(nullptr), DictionaryWithObjectsMethod(nullptr),
     GlobalNewDeleteDeclared(false),
     TUKind(TUKind),
+    NumConversionSequenceSets(0), NumConversionSequencesAllocated(0),
+    NumConversionSequenceBytes(0),
     NumSFINAEErrors(0),
     CachedFakeTopLevelModule(nullptr),
     AccessCheckingSFINAE(false), InNonInstantiationSFINAEContext(false),
@@ -371,6 +373,9 @@ void Sema::addExternalSource(ExternalSemaSource *E) {
 void Sema::PrintStats() const {
   llvm::errs() << "\n*** Semantic Analysis Stats:\n";
   llvm::errs() << NumSFINAEErrors << " SFINAE diagnostics trapped.\n";
+  llvm::errs() << NumConversionSequencesAllocated
+               << " overload candidate conversion sequences allocated out of "
+                  "line (" << NumConversionSequenceBytes << " bytes).\n";
 
   BumpAlloc.PrintStats();
   AnalysisWarnings.PrintStats();
@@ -723,12 +728,21 @@ void Sema::ActOnEndOfTranslationUnit() {
       PendingInstantiations.insert(PendingInstantiations.begin(),
                                    Pending.begin(), Pending.end());
     }
+    // Incremental processing parses more declarations after this point.
+    if (!PP.isIncrementalProcessingEnabled())
+      Consumer.HandlePendingInstantiations();
     PerformPendingInstantiations();
 
     if (LateTemplateParserCleanup)
       LateTemplateParserCleanup(OpaqueParser);
 
     CheckDelayedMemberExceptionSpecs();
+  } else if (LangOpts.PCHInstantiateTemplates) {
+    // Instantiate what the prefix uses while building it, so that the
+    // definitions are written to the AST file and every translation unit that
+    // includes it reuses them. The point of instantiation is then the end of
+    // the prefix, so declarations that follow it are not found.
+    PerformPendingInstantiations();
   }
 
   // All delayed member exception specs should be checked or we end up accepting
@@ -1104,6 +1118,12 @@ void Sema::EmitCurrentDiagnostic(unsigned DiagID) {
   }
 }
 
+bool Sema::isDiagnosticIgnored(unsigned DiagID, SourceLocation Loc) const {
+  // Template argument deduction keeps the diagnostics it suppresses, and may
+  // show their text in a note or report them again later.
+  return Diags.isIgnored(DiagID, Loc) && !isSFINAEContext();
+}
+
 Sema::SemaDiagnosticBuilder
 Sema::Diag(SourceLocation Loc, const PartialDiagnostic& PD) {
   SemaDiagnosticBuilder Builder(Diag(Loc, PD.getDiagID()));
@@ -37,13 +37,21 @@ bool Sema::PopForceCUDAHostDevice() {
   return true;
 }
 
+StringRef Sema::getCudaConfigureFuncName() const {
+  // The stubs that call cudaLaunchKernel pop the configuration pushed by
+  // __cudaPushCallConfiguration, the legacy ones get it from cudaLaunch.
+  if (getLangOpts().CUDALaunchKernel)
+    return "__cudaPushCallConfiguration";
+  return "cudaConfigureCall";
+}
+
 ExprResult Sema::ActOnCUDAExecConfigExpr(Scope *S, SourceLocation LLLLoc,
                                          MultiExprArg ExecConfig,
                                          SourceLocation GGGLoc) {
   FunctionDecl *ConfigDecl = Context.getcudaConfigureCallDecl();
   if (!ConfigDecl)
     return ExprError(Diag(LLLLoc, diag::err_undeclared_var_use)
-                     << "cudaConfigureCall");
+                     << getCudaConfigureFuncName());
   QualType ConfigQTy = ConfigDecl->getType();
 
   DeclRefExpr *ConfigDR = new (Context)
@@ -101,32 +109,49 @@ static bool hasAttr(const FunctionDecl *D, bool IgnoreImplicitAttr) {
          });
 }
 
-/// IdentifyCUDATarget - Determine the CUDA compilation target for this function
-Sema::CUDAFunctionTarget Sema::IdentifyCUDATarget(const FunctionDecl *D,
+/// Determines the CUDA compilation target of \p D from its attributes.
+static Sema::CUDAFunctionTarget computeCUDATarget(const FunctionDecl *D,
                                                   bool IgnoreImplicitHDAttr) {
-  // Code that lives outside a function is run on the host.
-  if (D == nullptr)
-    return CFT_Host;
-
   if (D->hasAttr<CUDAInvalidTargetAttr>())
-    return CFT_InvalidTarget;
+    return Sema::CFT_InvalidTarget;
 
   if (D->hasAttr<CUDAGlobalAttr>())
-    return CFT_Global;
+    return Sema::CFT_Global;
 
   if (hasAttr<CUDADeviceAttr>(D, IgnoreImplicitHDAttr)) {
     if (hasAttr<CUDAHostAttr>(D, IgnoreImplicitHDAttr))
-      return CFT_HostDevice;
-    return CFT_Device;
+      return Sema::CFT_HostDevice;
+    return Sema::CFT_Device;
   } else if (hasAttr<CUDAHostAttr>(D, IgnoreImplicitHDAttr)) {
-    return CFT_Host;
+    return Sema::CFT_Host;
   } else if (D->isImplicit() && !IgnoreImplicitHDAttr) {
     // Some implicit declarations (like intrinsic functions) are not marked.
     // Set the most lenient target on them for maximal flexibility.
-    return CFT_HostDevice;
+    return Sema::CFT_HostDevice;
   }
 
-  return CFT_Host;
+  return Sema::CFT_Host;
+}
+
+/// IdentifyCUDATarget - Determine the CUDA compilation target for this function
+Sema::CUDAFunctionTarget Sema::IdentifyCUDATarget(const FunctionDecl *D,
+                                                  bool IgnoreImplicitHDAttr) {
+  // Code that lives outside a function is run on the host.
+  if (D == nullptr)
+    return CFT_Host;
+
+  if (IgnoreImplicitHDAttr)
+    return computeCUDATarget(D, IgnoreImplicitHDAttr);
+
+  // Overload resolution asks for the targets of the same functions over and
+  // over again.
+  unsigned NumAttrs = D->hasAttrs() ? D->getAttrs().size() : 0;
+  auto Cached = CUDATargetCache.find(D);
+  if (Cached != CUDATargetCache.end() && Cached->second.first == NumAttrs)
+    return Cached->second.second;
+  CUDAFunctionTarget Target = computeCUDATarget(D, IgnoreImplicitHDAttr);
+  CUDATargetCache[D] = std::make_pair(NumAttrs, Target);
+  return Target;
 }
 
 // * CUDA Call preference table
@@ -160,8 +185,13 @@ Sema::CUDAFunctionTarget Sema::IdentifyCUDATarget(const FunctionDecl *D,
 Sema::CUDAFunctionPreference
 Sema::IdentifyCUDAPreference(const FunctionDecl *Caller,
                              const FunctionDecl *Callee) {
+  return IdentifyCUDAPreference(IdentifyCUDATarget(Caller), Callee);
+}
+
+Sema::CUDAFunctionPreference
+Sema::IdentifyCUDAPreference(CUDAFunctionTarget CallerTarget,
+                             const FunctionDecl *Callee) {
   assert(Callee && "Callee must be valid.");
-  CUDAFunctionTarget CallerTarget = IdentifyCUDATarget(Caller);
   CUDAFunctionTarget CalleeTarget = IdentifyCUDATarget(Callee);
 
   // If one of the targets is invalid, the check always fails, no matter what
@@ -215,23 +245,23 @@ void Sema::EraseUnwantedCUDAMatches(
   if (Matches.size() <= 1)
     return;
 
-  using Pair = std::pair<DeclAccessPair, FunctionDecl*>;
-
-  // Gets the CUDA function preference for a call from Caller to Match.
-  auto GetCFP = [&](const Pair &Match) {
-    return IdentifyCUDAPreference(Caller, Match.second);
-  };
+  // Compute the CUDA function preference for a call from Caller to each of
+  // the matches once.
+  CUDAFunctionTarget CallerTarget = IdentifyCUDATarget(Caller);
+  SmallVector<CUDAFunctionPreference, 8> CFPs;
+  CFPs.reserve(Matches.size());
+  for (const auto &Match : Matches)
+    CFPs.push_back(IdentifyCUDAPreference(CallerTarget, Match.second));
 
   // Find the best call preference among the functions in Matches.
-  CUDAFunctionPreference BestCFP = GetCFP(*std::max_element(
-      Matches.begin(), Matches.end(),
-      [&](const Pair &M1, const Pair &M2) { return GetCFP(M1) < GetCFP(M2); }));
+  CUDAFunctionPreference BestCFP = *std::max_element(CFPs.begin(), CFPs.end());
 
   // Erase all functions with lower priority.
-  Matches.erase(
-      llvm::remove_if(
-          Matches, [&](const Pair &Match) { return GetCFP(Match) < BestCFP; }),
-      Matches.end());
+  unsigned Kept = 0;
+  for (unsigned I = 0, E = Matches.size(); I < E; ++I)
+    if (CFPs[I] == BestCFP)
+      Matches[Kept++] = Matches[I];
+  Matches.erase(Matches.begin() + Kept, Matches.end());
 }
 
 /// When an implicitly-declared special member has to invoke more than one
@@ -1130,6 +1130,11 @@ Sema::CheckBuiltinFunctionCall(FunctionDecl *FDecl, unsigned BuiltinID,
         if (CheckPPCBuiltinFunctionCall(BuiltinID, TheCall))
           return ExprError();
         break;
+      case llvm::Triple::nvptx:
+      case llvm::Triple::nvptx64:
+        if (CheckNVPTXBuiltinFunctionCall(BuiltinID, TheCall))
+          return ExprError();
+        break;
       default:
         break;
     }
@@ -1707,6 +1712,59 @@ bool Sema::CheckPPCBuiltinFunctionCall(unsigned BuiltinID, CallExpr *TheCall) {
   return SemaBuiltinConstantArgRange(TheCall, i, l, u);
 }
 
+bool Sema::CheckNVPTXBuiltinFunctionCall(unsigned BuiltinID,
+                                         CallExpr *TheCall) {
+  // In OpenMP device code the warp primitives are only meaningful in the code
+  // executed by the threads of a target region.
+  if (!getLangOpts().OpenMPIsDevice)
+    return false;
+
+  switch (BuiltinID) {
+  default:
+    return false;
+  case NVPTX::BI__nvvm_shfl_down_i32:
+  case NVPTX::BI__nvvm_shfl_down_f32:
+  case NVPTX::BI__nvvm_shfl_up_i32:
+  case NVPTX::BI__nvvm_shfl_up_f32:
+  case NVPTX::BI__nvvm_shfl_bfly_i32:
+  case NVPTX::BI__nvvm_shfl_bfly_f32:
+  case NVPTX::BI__nvvm_shfl_idx_i32:
+  case NVPTX::BI__nvvm_shfl_idx_f32:
+  case NVPTX::BI__nvvm_shfl_sync_down_i32:
+  case NVPTX::BI__nvvm_shfl_sync_down_f32:
+  case NVPTX::BI__nvvm_shfl_sync_up_i32:
+  case NVPTX::BI__nvvm_shfl_sync_up_f32:
+  case NVPTX::BI__nvvm_shfl_sync_bfly_i32:
+  case NVPTX::BI__nvvm_shfl_sync_bfly_f32:
+  case NVPTX::BI__nvvm_shfl_sync_idx_i32:
+  case NVPTX::BI__nvvm_shfl_sync_idx_f32:
+  case NVPTX::BI__nvvm_vote_all:
+  case NVPTX::BI__nvvm_vote_any:
+  case NVPTX::BI__nvvm_vote_uni:
+  case NVPTX::BI__nvvm_vote_ballot:
+  case NVPTX::BI__nvvm_vote_all_sync:
+  case NVPTX::BI__nvvm_vote_any_sync:
+  case NVPTX::BI__nvvm_vote_uni_sync:
+  case NVPTX::BI__nvvm_vote_ballot_sync:
+  case NVPTX::BI__nvvm_match_any_sync_i32:
+  case NVPTX::BI__nvvm_match_any_sync_i64:
+  case NVPTX::BI__nvvm_match_all_sync_i32p:
+  case NVPTX::BI__nvvm_match_all_sync_i64p:
+    break;
+  }
+
+  // Functions called from target regions are only known to be device code
+  // once they are marked, so this is not an error.
+  const FunctionDecl *FD = getCurFunctionDecl();
+  if (isInOpenMPTargetExecutionDirective() ||
+      isInOpenMPDeclareTargetContext() ||
+      (FD && FD->hasAttr<OMPDeclareTargetDeclAttr>()))
+    return false;
+  Diag(TheCall->getLocStart(), diag::warn_omp_warp_builtin_outside_target)
+      << TheCall->getDirectCallee() << TheCall->getSourceRange();
+  return false;
+}
+
 bool Sema::CheckSystemZBuiltinFunctionCall(unsigned BuiltinID,
                                            CallExpr *TheCall) {
   if (BuiltinID == SystemZ::BI__builtin_tabort) {
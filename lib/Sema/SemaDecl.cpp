@@ -8712,7 +8712,8 @@ Sema::ActOnFunctionDeclarator(Scope *S, Declarator &D, DeclContext *DC,
 
   if (getLangOpts().CUDA) {
     IdentifierInfo *II = NewFD->getIdentifier();
-    if (II && II->isStr("cudaConfigureCall") && !NewFD->isInvalidDecl() &&
+    if (II && II->isStr(getCudaConfigureFuncName()) &&
+        !NewFD->isInvalidDecl() &&
         NewFD->getDeclContext()->getRedeclContext()->isTranslationUnit()) {
       if (!R->getAs<FunctionType>()->getReturnType()->isScalarType())
         Diag(NewFD->getLocation(), diag::err_config_scalar_return);
@@ -11812,6 +11813,31 @@ bool Sema::canSkipFunctionBody(Decl *D) {
   if (const FunctionDecl *FD = D->getAsFunction())
     if (FD->isConstexpr() || FD->getReturnType()->isUndeducedType())
       return false;
+  // When only skipping the bodies outside the main file, keep the ones in it
+  // and the bodies of templates, which the main file may instantiate.
+  if (getLangOpts().SkipFunctionBodiesOutsideMainFile) {
+    if (SourceMgr.isInMainFile(SourceMgr.getExpansionLoc(D->getLocation())))
+      return false;
+    if (const FunctionDecl *FD = D->getAsFunction())
+      if (FD->isDependentContext())
+        return false;
+  }
+  // In an OpenMP device compilation we cannot skip the body of a function that
+  // may be emitted for the device: a declare target function, a template that
+  // may be instantiated from one, or any function when declare target is
+  // implicit.
+  if (getLangOpts().OpenMPSkipHostFunctionBodies) {
+    if (getLangOpts().OpenMPImplicitDeclareTarget ||
+        isInOpenMPDeclareTargetContext())
+      return false;
+    if (const FunctionDecl *FD = D->getAsFunction()) {
+      if (FD->isDependentContext())
+        return false;
+      for (const FunctionDecl *RD : FD->redecls())
+        if (RD->hasAttr<OMPDeclareTargetDeclAttr>())
+          return false;
+    }
+  }
   return Consumer.shouldSkipFunctionBody(D);
 }
 
@@ -1262,6 +1262,7 @@ CanThrowResult Sema::canThrow(const Expr *E) {
   case Expr::ImplicitValueInitExprClass:
   case Expr::IntegerLiteralClass:
   case Expr::ArrayInitIndexExprClass:
+  case Expr::CompactArrayInitExprClass:
   case Expr::NoInitExprClass:
   case Expr::ObjCEncodeExprClass:
   case Expr::ObjCStringLiteralClass:
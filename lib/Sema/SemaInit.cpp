@@ -6344,6 +6344,136 @@ static void CheckMoveOnConstruction(Sema &S, const Expr *InitExpr,
       << FixItHint::CreateRemoval(SourceRange(RParen, RParen));
 }
 
+/// \brief The minimum number of elements of an initializer list that is kept
+/// in a CompactArrayInitExpr.
+static const unsigned MinCompactArrayInitElements = 1024;
+
+/// \brief Evaluate an element of an initializer list of integers, if it is
+/// an integer or character literal, possibly negated.
+static bool getCompactIntegerElement(ASTContext &Ctx, const Expr *E,
+                                     llvm::APSInt &Value) {
+  E = E->IgnoreParens();
+  bool Negate = false;
+  if (auto *UO = dyn_cast<UnaryOperator>(E)) {
+    if (UO->getOpcode() != UO_Minus && UO->getOpcode() != UO_Plus)
+      return false;
+    Negate = UO->getOpcode() == UO_Minus;
+    E = UO->getSubExpr()->IgnoreParens();
+    // The negation of an unsigned literal wraps around.
+    if (Negate && !E->getType()->isSignedIntegerType())
+      return false;
+  }
+
+  if (auto *IL = dyn_cast<IntegerLiteral>(E))
+    Value = llvm::APSInt(IL->getValue(),
+                         IL->getType()->isUnsignedIntegerType());
+  else if (auto *CL = dyn_cast<CharacterLiteral>(E))
+    Value = llvm::APSInt(
+        llvm::APInt(Ctx.getTypeSize(CL->getType()), CL->getValue()),
+        CL->getType()->isUnsignedIntegerType());
+  else
+    return false;
+
+  // Compute the value in a signed type wide enough for every literal.
+  Value = Value.extend(Value.getBitWidth() + 1);
+  Value.setIsSigned(true);
+  if (Negate)
+    Value = -Value;
+  return true;
+}
+
+/// \brief Evaluate an element of an initializer list of floating-point
+/// numbers, if it is a floating-point literal, possibly negated.
+static bool getCompactFloatingElement(const Expr *E, llvm::APFloat &Value) {
+  E = E->IgnoreParens();
+  bool Negate = false;
+  if (auto *UO = dyn_cast<UnaryOperator>(E)) {
+    if (UO->getOpcode() != UO_Minus && UO->getOpcode() != UO_Plus)
+      return false;
+    Negate = UO->getOpcode() == UO_Minus;
+    E = UO->getSubExpr()->IgnoreParens();
+  }
+
+  auto *FL = dyn_cast<FloatingLiteral>(E);
+  if (!FL)
+    return false;
+  Value = FL->getValue();
+  if (Negate)
+    Value.changeSign();
+  return true;
+}
+
+/// \brief Try to represent the list initialization of an array variable by
+/// a long list of numeric literals as a CompactArrayInitExpr.
+///
+/// Every element must be a literal whose value is exactly representable in
+/// the element type, so that the conversions of the elements, which are not
+/// checked, could not have been diagnosed.
+static CompactArrayInitExpr *tryBuildCompactArrayInit(Sema &S,
+                                                      InitListExpr *InitList,
+                                                      QualType &Ty) {
+  ASTContext &Ctx = S.Context;
+  unsigned NumInits = InitList->getNumInits();
+  if (NumInits < MinCompactArrayInitElements || InitList->getSyntacticForm())
+    return nullptr;
+
+  const ArrayType *AT = Ctx.getAsArrayType(Ty);
+  if (!AT || !(isa<ConstantArrayType>(AT) || isa<IncompleteArrayType>(AT)))
+    return nullptr;
+  if (auto *CAT = dyn_cast<ConstantArrayType>(AT))
+    if (CAT->getSize().ult(NumInits))
+      return nullptr;
+
+  QualType EltTy = AT->getElementType();
+  const BuiltinType *BT = EltTy->getAs<BuiltinType>();
+  if (!BT || BT->isBooleanType())
+    return nullptr;
+  bool IsFloating = BT->getKind() == BuiltinType::Float ||
+                    BT->getKind() == BuiltinType::Double;
+  if (!IsFloating && !BT->isInteger())
+    return nullptr;
+  unsigned EltWidth = Ctx.getTypeSize(EltTy);
+  if (EltWidth != 8 && EltWidth != 16 && EltWidth != 32 && EltWidth != 64)
+    return nullptr;
+
+  SmallVector<uint64_t, 0> Values;
+  Values.reserve(NumInits);
+  for (const Expr *Init : InitList->inits()) {
+    if (IsFloating) {
+      llvm::APFloat Value(0.0);
+      if (!getCompactFloatingElement(Init, Value))
+        return nullptr;
+      bool LosesInfo;
+      if (Value.convert(Ctx.getFloatTypeSemantics(EltTy),
+                        llvm::APFloat::rmNearestTiesToEven,
+                        &LosesInfo) != llvm::APFloat::opOK || LosesInfo)
+        return nullptr;
+      Values.push_back(Value.bitcastToAPInt().getZExtValue());
+      continue;
+    }
+
+    llvm::APSInt Value;
+    if (!getCompactIntegerElement(Ctx, Init, Value))
+      return nullptr;
+    llvm::APSInt Converted = Value.extOrTrunc(EltWidth);
+    Converted.setIsUnsigned(BT->isUnsignedInteger());
+    if (!llvm::APSInt::isSameValue(Value, Converted))
+      return nullptr;
+    Values.push_back(Converted.getZExtValue());
+  }
+
+  if (isa<IncompleteArrayType>(AT))
+    Ty = Ctx.getConstantArrayType(EltTy, llvm::APInt(32, NumInits),
+                                  ArrayType::Normal, 0);
+  InitList->setType(Ty);
+
+  CompactArrayInitExpr *E =
+      CompactArrayInitExpr::Create(Ctx, Ty, InitList, NumInits, EltWidth / 8);
+  for (unsigned I = 0; I != NumInits; ++I)
+    E->setElement(I, Values[I]);
+  return E;
+}
+
 static void CheckForNullPointerDereference(Sema &S, const Expr *E) {
   // Check to see if we are dereferencing a null pointer.  If so, this is
   // undefined behavior, so warn about it.  This only handles the pattern
@@ -6860,6 +6990,19 @@ InitializationSequence::Perform(Sema &S,
       bool IsTemporary = !S.Context.hasSameType(Entity.getType(), Ty);
       InitializedEntity TempEntity = InitializedEntity::InitializeTemporary(Ty);
       InitializedEntity InitEntity = IsTemporary ? TempEntity : Entity;
+
+      // Long lists of literals initializing an array variable are not
+      // checked element by element.
+      CompactArrayInitExpr *CompactInit = nullptr;
+      if (Entity.getKind() == InitializedEntity::EK_Variable && !IsTemporary)
+        CompactInit = tryBuildCompactArrayInit(S, InitList, Ty);
+      if (CompactInit) {
+        if (ResultType && (*ResultType)->isIncompleteArrayType())
+          *ResultType = Ty;
+        CurInit = CompactInit;
+        break;
+      }
+
       InitListChecker PerformInitList(S, InitEntity,
           InitList, Ty, /*VerifyOnly=*/false,
           /*TreatUnavailableAsInvalid=*/false);
@@ -8106,6 +8249,8 @@ static void DiagnoseNarrowingInInitList(Sema &S,
   // C++11 [dcl.init.list]p7: Check whether this is a narrowing conversion.
   APValue ConstantValue;
   QualType ConstantType;
+  bool AsWarning = S.getLangOpts().MicrosoftExt || !S.getLangOpts().CPlusPlus11;
+  unsigned DiagID;
   switch (SCS->getNarrowingKind(S.Context, PostInit, ConstantValue,
                                 ConstantType)) {
   case NK_Not_Narrowing:
@@ -8117,38 +8262,44 @@ static void DiagnoseNarrowingInInitList(Sema &S,
     // This was a floating-to-integer conversion, which is always considered a
     // narrowing conversion even if the value is a constant and can be
     // represented exactly as an integer.
-    S.Diag(PostInit->getLocStart(),
-           (S.getLangOpts().MicrosoftExt || !S.getLangOpts().CPlusPlus11)
-               ? diag::warn_init_list_type_narrowing
-               : diag::ext_init_list_type_narrowing)
+    DiagID = AsWarning ? diag::warn_init_list_type_narrowing
+                       : diag::ext_init_list_type_narrowing;
+    S.Diag(PostInit->getLocStart(), DiagID)
       << PostInit->getSourceRange()
       << PreNarrowingType.getLocalUnqualifiedType()
       << EntityType.getLocalUnqualifiedType();
     break;
 
-  case NK_Constant_Narrowing:
+  case NK_Constant_Narrowing: {
     // A constant value was narrowed.
-    S.Diag(PostInit->getLocStart(),
-           (S.getLangOpts().MicrosoftExt || !S.getLangOpts().CPlusPlus11)
-               ? diag::warn_init_list_constant_narrowing
-               : diag::ext_init_list_constant_narrowing)
-      << PostInit->getSourceRange()
-      << ConstantValue.getAsString(S.getASTContext(), ConstantType)
-      << EntityType.getLocalUnqualifiedType();
+    DiagID = AsWarning ? diag::warn_init_list_constant_narrowing
+                       : diag::ext_init_list_constant_narrowing;
+    auto DB = S.Diag(PostInit->getLocStart(), DiagID);
+    DB << PostInit->getSourceRange();
+    // Printing the value is only worth it if it is shown.
+    if (DB.isIgnored())
+      DB << StringRef();
+    else
+      DB << ConstantValue.getAsString(S.getASTContext(), ConstantType);
+    DB << EntityType.getLocalUnqualifiedType();
     break;
+  }
 
   case NK_Variable_Narrowing:
     // A variable's value may have been narrowed.
-    S.Diag(PostInit->getLocStart(),
-           (S.getLangOpts().MicrosoftExt || !S.getLangOpts().CPlusPlus11)
-               ? diag::warn_init_list_variable_narrowing
-               : diag::ext_init_list_variable_narrowing)
+    DiagID = AsWarning ? diag::warn_init_list_variable_narrowing
+                       : diag::ext_init_list_variable_narrowing;
+    S.Diag(PostInit->getLocStart(), DiagID)
       << PostInit->getSourceRange()
       << PreNarrowingType.getLocalUnqualifiedType()
       << EntityType.getLocalUnqualifiedType();
     break;
   }
 
+  // The note that suggests a cast is dropped along with the diagnostic.
+  if (S.isDiagnosticIgnored(DiagID, PostInit->getLocStart()))
+    return;
+
   SmallString<128> StaticCast;
   llvm::raw_svector_ostream OS(StaticCast);
   OS << "static_cast<";
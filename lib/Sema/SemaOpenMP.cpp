@@ -83,6 +83,8 @@ private:
   struct MappedExprComponentTy {
     OMPClauseMappableExprCommon::MappableExprComponentLists Components;
     OpenMPClauseKind Kind = OMPC_unknown;
+    /// True if every map clause listing the declaration uses the 'to' type.
+    bool IsMapToOnly = true;
   };
   typedef llvm::DenseMap<ValueDecl *, MappedExprComponentTy>
       MappedExprComponentsTy;
@@ -143,9 +145,16 @@ private:
   };
 
   typedef SmallVector<SharingMapTy, 4> StackTy;
+  /// Positions (function stack index, region level) of the regions with
+  /// explicit data-sharing attributes for a declaration, from outer to inner.
+  typedef llvm::SmallVector<std::pair<unsigned, unsigned>, 2> DSALevelsTy;
 
   /// \brief Stack of used declaration and their data-sharing attributes.
   DeclSAMapTy Threadprivates;
+  /// Index of the regions that have explicit data-sharing attributes for each
+  /// declaration, so that looking up a declaration through the enclosing
+  /// regions does not query the sharing map of each of them.
+  llvm::DenseMap<ValueDecl *, DSALevelsTy> ExplicitDSALevels;
   const FunctionScopeInfo *CurrentNonCapturingFunctionScope = nullptr;
   SmallVector<std::pair<StackTy, const FunctionScopeInfo *>, 4> Stack;
   /// \brief true, if check for DSA must be from parent directive, false, if
@@ -154,10 +163,28 @@ private:
   Sema &SemaRef;
   bool ForceCapturing = false;
   CriticalsWithHintsTy Criticals;
+  /// Declarations listed in the clauses of a device data management
+  /// directive, which may have a device copy that outlives a target region.
+  llvm::SmallPtrSet<ValueDecl *, 8> DeviceDataMapped;
 
   typedef SmallVector<SharingMapTy, 8>::reverse_iterator reverse_iterator;
 
   DSAVarData getDSA(StackTy::reverse_iterator &Iter, ValueDecl *D);
+  DSAVarData getDSA(StackTy::reverse_iterator &Iter, ValueDecl *D,
+                    const DSALevelsTy *Levels);
+
+  /// Returns the indexed positions of the regions with explicit data-sharing
+  /// attributes for the canonical declaration \p D, or null if there are none.
+  const DSALevelsTy *getExplicitDSALevels(ValueDecl *D) const {
+    auto It = ExplicitDSALevels.find(D);
+    return It == ExplicitDSALevels.end() ? nullptr : &It->second;
+  }
+  /// Returns the explicit data-sharing attributes of the canonical declaration
+  /// \p D in the region \p Iter of the current function, or null.
+  DSAInfo *getExplicitDSA(StackTy::reverse_iterator Iter, ValueDecl *D,
+                          const DSALevelsTy *Levels);
+  /// Adds \p D to the sharing map of the innermost region.
+  DSAInfo &addExplicitDSA(ValueDecl *D);
 
   /// \brief Checks if the variable is a local for OpenMP region.
   bool isOpenMPLocal(VarDecl *D, StackTy::reverse_iterator Iter);
@@ -191,6 +218,15 @@ public:
   void pop() {
     assert(!Stack.back().first.empty() &&
            "Data-sharing attributes stack is empty!");
+    for (auto &Entry : Stack.back().first.back().SharingMap) {
+      auto It = ExplicitDSALevels.find(Entry.first);
+      assert(It != ExplicitDSALevels.end() &&
+             It->second.back().second + 1 == Stack.back().first.size() &&
+             "Sharing map entry is not indexed.");
+      It->second.pop_back();
+      if (It->second.empty())
+        ExplicitDSALevels.erase(It);
+    }
     Stack.back().first.pop_back();
   }
 
@@ -510,7 +546,8 @@ public:
   void addMappableExpressionComponents(
       ValueDecl *VD,
       OMPClauseMappableExprCommon::MappableExprComponentListRef Components,
-      OpenMPClauseKind WhereFoundClauseKind) {
+      OpenMPClauseKind WhereFoundClauseKind,
+      OpenMPMapClauseKind MapType = OMPC_MAP_unknown) {
     assert(!isStackEmpty() &&
            "Not expecting to retrieve components from a empty stack!");
     auto &MEC = Stack.back().first.back().MappedExprComponents[VD];
@@ -518,6 +555,54 @@ public:
     MEC.Components.resize(MEC.Components.size() + 1);
     MEC.Components.back().append(Components.begin(), Components.end());
     MEC.Kind = WhereFoundClauseKind;
+    MEC.IsMapToOnly &= MapType == OMPC_MAP_to;
+    switch (Stack.back().first.back().Directive) {
+    case OMPD_target_data:
+    case OMPD_target_enter_data:
+    case OMPD_target_exit_data:
+    case OMPD_target_update:
+      DeviceDataMapped.insert(VD);
+      break;
+    default:
+      break;
+    }
+  }
+
+  /// Return true if the declaration \a VD may already be present in a device
+  /// data environment when the region at the given level is entered, either
+  /// because the region is nested in a 'target data' region or because a data
+  /// management directive of the function has mapped it.
+  bool mayBeInDeviceDataEnvironment(ValueDecl *VD, unsigned Level) {
+    if (isStackEmpty())
+      return true;
+    auto *Var = dyn_cast<VarDecl>(VD);
+    // Variables that outlive the function may have been mapped by a caller.
+    if (!Var || !Var->hasLocalStorage() || DeviceDataMapped.count(VD))
+      return true;
+    auto StartI = Stack.back().first.begin();
+    auto EndI = Stack.back().first.end();
+    if (std::distance(StartI, EndI) <= (int)Level)
+      return true;
+    return std::any_of(StartI, std::next(StartI, Level),
+                       [](const SharingMapTy &Region) {
+                         return Region.Directive == OMPD_target_data;
+                       });
+  }
+
+  /// Return true if the declaration \a VD is only found in map clauses with
+  /// the 'to' map type at the given level.
+  bool isMapToOnlyAtLevel(ValueDecl *VD, unsigned Level) {
+    if (isStackEmpty())
+      return false;
+
+    auto StartI = Stack.back().first.begin();
+    auto EndI = Stack.back().first.end();
+    if (std::distance(StartI, EndI) <= (int)Level)
+      return false;
+    std::advance(StartI, Level);
+
+    auto MI = StartI->MappedExprComponents.find(VD);
+    return MI != StartI->MappedExprComponents.end() && MI->second.IsMapToOnly;
   }
 
   /// Return true if the default map is set to to/from at the given level.
@@ -601,9 +686,43 @@ static ValueDecl *getCanonicalDecl(ValueDecl *D) {
   return D;
 }
 
+DSAStackTy::DSAInfo *
+DSAStackTy::getExplicitDSA(StackTy::reverse_iterator Iter, ValueDecl *D,
+                           const DSALevelsTy *Levels) {
+  if (!Levels)
+    return nullptr;
+  std::pair<unsigned, unsigned> Pos(
+      Stack.size() - 1, std::distance(Iter, Stack.back().first.rend()) - 1);
+  for (const auto &L : llvm::reverse(*Levels)) {
+    if (L == Pos) {
+      auto It = Iter->SharingMap.find(D);
+      assert(It != Iter->SharingMap.end() && "Stale data-sharing index.");
+      return &It->second;
+    }
+    if (L < Pos)
+      break;
+  }
+  return nullptr;
+}
+
+DSAStackTy::DSAInfo &DSAStackTy::addExplicitDSA(ValueDecl *D) {
+  std::pair<unsigned, unsigned> Pos(Stack.size() - 1,
+                                    Stack.back().first.size() - 1);
+  auto &Levels = ExplicitDSALevels[D];
+  if (Levels.empty() || Levels.back() != Pos)
+    Levels.push_back(Pos);
+  return Stack.back().first.back().SharingMap[D];
+}
+
 DSAStackTy::DSAVarData DSAStackTy::getDSA(StackTy::reverse_iterator &Iter,
                                           ValueDecl *D) {
   D = getCanonicalDecl(D);
+  return getDSA(Iter, D, getExplicitDSALevels(D));
+}
+
+DSAStackTy::DSAVarData DSAStackTy::getDSA(StackTy::reverse_iterator &Iter,
+                                          ValueDecl *D,
+                                          const DSALevelsTy *Levels) {
   auto *VD = dyn_cast<VarDecl>(D);
   auto *FD = dyn_cast<FieldDecl>(D);
   DSAVarData DVar;
@@ -643,11 +762,11 @@ DSAStackTy::DSAVarData DSAStackTy::getDSA(StackTy::reverse_iterator &Iter,
   DVar.DKind = Iter->Directive;
   // Explicitly specified attributes and local variables with predetermined
   // attributes.
-  if (Iter->SharingMap.count(D)) {
-    DVar.RefExpr = Iter->SharingMap[D].RefExpr.getPointer();
-    DVar.PrivateCopy = Iter->SharingMap[D].PrivateCopy;
-    DVar.LastprivateUpdateIter = Iter->SharingMap[D].LastprivateUpdateIter;
-    DVar.CKind = Iter->SharingMap[D].Attributes;
+  if (auto *Data = getExplicitDSA(Iter, D, Levels)) {
+    DVar.RefExpr = Data->RefExpr.getPointer();
+    DVar.PrivateCopy = Data->PrivateCopy;
+    DVar.LastprivateUpdateIter = Data->LastprivateUpdateIter;
+    DVar.CKind = Data->Attributes;
     DVar.ImplicitDSALoc = Iter->DefaultAttrLoc;
     return DVar;
   }
@@ -690,7 +809,7 @@ DSAStackTy::DSAVarData DSAStackTy::getDSA(StackTy::reverse_iterator &Iter,
         //  In a task construct, if no default clause is present, a variable
         //  whose data-sharing attribute is not determined by the rules above is
         //  firstprivate.
-        DVarTemp = getDSA(I, D);
+        DVarTemp = getDSA(I, D, Levels);
         if (DVarTemp.CKind != OMPC_shared) {
           DVar.RefExpr = nullptr;
           DVar.CKind = OMPC_firstprivate;
@@ -707,7 +826,7 @@ DSAStackTy::DSAVarData DSAStackTy::getDSA(StackTy::reverse_iterator &Iter,
   //  For constructs other than task, if no default clause is present, these
   //  variables inherit their data-sharing attributes from the enclosing
   //  context.
-  return getDSA(++Iter, D);
+  return getDSA(++Iter, D, Levels);
 }
 
 Expr *DSAStackTy::addUniqueAligned(ValueDecl *D, Expr *NewDE) {
@@ -777,7 +896,7 @@ void DSAStackTy::addDSA(ValueDecl *D, Expr *E, OpenMPClauseKind A,
     Data.PrivateCopy = nullptr;
   } else {
     assert(!isStackEmpty() && "Data-sharing attributes stack is empty");
-    auto &Data = Stack.back().first.back().SharingMap[D];
+    auto &Data = addExplicitDSA(D);
     assert(Data.Attributes == OMPC_unknown || (A == Data.Attributes) ||
            (A == OMPC_firstprivate && Data.Attributes == OMPC_lastprivate) ||
            (A == OMPC_lastprivate && Data.Attributes == OMPC_firstprivate) ||
@@ -793,7 +912,7 @@ void DSAStackTy::addDSA(ValueDecl *D, Expr *E, OpenMPClauseKind A,
     Data.LastprivateUpdateIter = LastprivateUpdateIter;
     Data.PrivateCopy = PrivateCopy;
     if (PrivateCopy) {
-      auto &Data = Stack.back().first.back().SharingMap[PrivateCopy->getDecl()];
+      auto &Data = addExplicitDSA(PrivateCopy->getDecl());
       Data.Attributes = A;
       Data.RefExpr.setPointerAndInt(PrivateCopy, IsLastprivate);
       Data.PrivateCopy = nullptr;
@@ -884,11 +1003,16 @@ DSAStackTy::getTopMostTaskgroupReductionData(ValueDecl *D, SourceRange &SR,
   assert(!isStackEmpty() && "Data-sharing attributes stack is empty.");
   if (Stack.back().first.empty())
       return DSAVarData();
+  const DSALevelsTy *Levels = getExplicitDSALevels(D);
+  if (!Levels)
+    return DSAVarData();
   for (auto I = std::next(Stack.back().first.rbegin(), 1),
             E = Stack.back().first.rend();
        I != E; std::advance(I, 1)) {
-    auto &Data = I->SharingMap[D];
-    if (Data.Attributes != OMPC_reduction || I->Directive != OMPD_taskgroup)
+    if (I->Directive != OMPD_taskgroup)
+      continue;
+    auto *Data = getExplicitDSA(I, D, Levels);
+    if (!Data || Data->Attributes != OMPC_reduction)
       continue;
     auto &ReductionData = I->ReductionMap[D];
     if (!ReductionData.ReductionOp ||
@@ -900,8 +1024,9 @@ DSAStackTy::getTopMostTaskgroupReductionData(ValueDecl *D, SourceRange &SR,
                                        "expression for the descriptor is not "
                                        "set.");
     TaskgroupDescriptor = I->TaskgroupReductionRef;
-    return DSAVarData(OMPD_taskgroup, OMPC_reduction, Data.RefExpr.getPointer(),
-                      Data.PrivateCopy, I->DefaultAttrLoc);
+    return DSAVarData(OMPD_taskgroup, OMPC_reduction,
+                      Data->RefExpr.getPointer(), Data->PrivateCopy,
+                      I->DefaultAttrLoc);
   }
   return DSAVarData();
 }
@@ -914,11 +1039,16 @@ DSAStackTy::getTopMostTaskgroupReductionData(ValueDecl *D, SourceRange &SR,
   assert(!isStackEmpty() && "Data-sharing attributes stack is empty.");
   if (Stack.back().first.empty())
       return DSAVarData();
+  const DSALevelsTy *Levels = getExplicitDSALevels(D);
+  if (!Levels)
+    return DSAVarData();
   for (auto I = std::next(Stack.back().first.rbegin(), 1),
             E = Stack.back().first.rend();
        I != E; std::advance(I, 1)) {
-    auto &Data = I->SharingMap[D];
-    if (Data.Attributes != OMPC_reduction || I->Directive != OMPD_taskgroup)
+    if (I->Directive != OMPD_taskgroup)
+      continue;
+    auto *Data = getExplicitDSA(I, D, Levels);
+    if (!Data || Data->Attributes != OMPC_reduction)
       continue;
     auto &ReductionData = I->ReductionMap[D];
     if (!ReductionData.ReductionOp ||
@@ -930,8 +1060,9 @@ DSAStackTy::getTopMostTaskgroupReductionData(ValueDecl *D, SourceRange &SR,
                                        "expression for the descriptor is not "
                                        "set.");
     TaskgroupDescriptor = I->TaskgroupReductionRef;
-    return DSAVarData(OMPD_taskgroup, OMPC_reduction, Data.RefExpr.getPointer(),
-                      Data.PrivateCopy, I->DefaultAttrLoc);
+    return DSAVarData(OMPD_taskgroup, OMPC_reduction,
+                      Data->RefExpr.getPointer(), Data->PrivateCopy,
+                      I->DefaultAttrLoc);
   }
   return DSAVarData();
 }
@@ -1039,11 +1170,11 @@ DSAStackTy::DSAVarData DSAStackTy::getTopDSA(ValueDecl *D, bool FromParent) {
   auto EndI = Stack.back().first.rend();
   if (FromParent && I != EndI)
     std::advance(I, 1);
-  if (I->SharingMap.count(D)) {
-    DVar.RefExpr = I->SharingMap[D].RefExpr.getPointer();
-    DVar.LastprivateUpdateIter = I->SharingMap[D].LastprivateUpdateIter;
-    DVar.PrivateCopy = I->SharingMap[D].PrivateCopy;
-    DVar.CKind = I->SharingMap[D].Attributes;
+  if (auto *Data = getExplicitDSA(I, D, getExplicitDSALevels(D))) {
+    DVar.RefExpr = Data->RefExpr.getPointer();
+    DVar.LastprivateUpdateIter = Data->LastprivateUpdateIter;
+    DVar.PrivateCopy = Data->PrivateCopy;
+    DVar.CKind = Data->Attributes;
     DVar.ImplicitDSALoc = I->DefaultAttrLoc;
     DVar.DKind = I->Directive;
   }
@@ -1062,7 +1193,7 @@ DSAStackTy::DSAVarData DSAStackTy::getImplicitDSA(ValueDecl *D,
   auto EndI = Stack.back().first.rend();
   if (FromParent && StartI != EndI)
     std::advance(StartI, 1);
-  return getDSA(StartI, D);
+  return getDSA(StartI, D, getExplicitDSALevels(D));
 }
 
 DSAStackTy::DSAVarData
@@ -1077,11 +1208,12 @@ DSAStackTy::hasDSA(ValueDecl *D,
   auto EndI = Stack.back().first.rend();
   if (FromParent && I != EndI)
     std::advance(I, 1);
+  const DSALevelsTy *Levels = getExplicitDSALevels(D);
   for (; I != EndI; std::advance(I, 1)) {
     if (!DPred(I->Directive) && !isParallelOrTaskRegion(I->Directive))
       continue;
     auto NewI = I;
-    DSAVarData DVar = getDSA(NewI, D);
+    DSAVarData DVar = getDSA(NewI, D, Levels);
     if (I == NewI && CPred(DVar.CKind))
       return DVar;
   }
@@ -1102,7 +1234,7 @@ DSAStackTy::DSAVarData DSAStackTy::hasInnermostDSA(
   if (StartI == EndI || !DPred(StartI->Directive))
     return {};
   auto NewI = StartI;
-  DSAVarData DVar = getDSA(NewI, D);
+  DSAVarData DVar = getDSA(NewI, D, getExplicitDSALevels(D));
   return (NewI == StartI && CPred(DVar.CKind)) ? DVar : DSAVarData();
 }
 
@@ -1119,10 +1251,10 @@ bool DSAStackTy::hasExplicitDSA(
   if (std::distance(StartI, EndI) <= (int)Level)
     return false;
   std::advance(StartI, Level);
-  return (StartI->SharingMap.count(D) > 0) &&
-         StartI->SharingMap[D].RefExpr.getPointer() &&
-         CPred(StartI->SharingMap[D].Attributes) &&
-         (!NotLastprivate || !StartI->SharingMap[D].RefExpr.getInt());
+  auto *Data = getExplicitDSA(StackTy::reverse_iterator(std::next(StartI)), D,
+                              getExplicitDSALevels(D));
+  return Data && Data->RefExpr.getPointer() && CPred(Data->Attributes) &&
+         (!NotLastprivate || !Data->RefExpr.getInt());
 }
 
 bool DSAStackTy::hasExplicitDirective(
@@ -1242,9 +1374,12 @@ bool ImplicitDeviceFunctionChecker::TraverseLambdaCapture(
 
 bool ImplicitDeviceFunctionChecker::VisitFunctionDecl(FunctionDecl *F) {
   assert(F);
+  // Functions marked because they are used in device code carry a source
+  // range, which tells them apart from the ones declared target by the user.
   if (!F->hasAttr<OMPDeclareTargetDeclAttr>()) {
     Attr *A = OMPDeclareTargetDeclAttr::CreateImplicit(
-        SemaRef.Context, OMPDeclareTargetDeclAttr::MT_To);
+        SemaRef.Context, OMPDeclareTargetDeclAttr::MT_To,
+        F->getSourceRange());
     F->addAttr(A);
     TraverseDecl(F);
   }
@@ -1253,7 +1388,8 @@ bool ImplicitDeviceFunctionChecker::VisitFunctionDecl(FunctionDecl *F) {
     auto *D = cast<Decl>(F->getParent());
     if (!D->hasAttr<OMPDeclareTargetDeclAttr>()) {
       Attr *A = OMPDeclareTargetDeclAttr::CreateImplicit(
-          SemaRef.Context, OMPDeclareTargetDeclAttr::MT_To);
+          SemaRef.Context, OMPDeclareTargetDeclAttr::MT_To,
+          D->getSourceRange());
       D->addAttr(A);
       TraverseDecl(cast<Decl>(F->getParent()));
     }
@@ -1304,6 +1440,16 @@ void Sema::popOpenMPFunctionRegion(const FunctionScopeInfo *OldFSI) {
   DSAStack->popFunction(OldFSI);
 }
 
+/// Return true if \a Ty is a vector type that fits a uintptr. Such vectors
+/// are register values on the device as well and are passed to target
+/// regions like scalars, as by-value kernel arguments. Larger vectors keep
+/// the default map(tofrom).
+static bool isSmallVectorType(ASTContext &Ctx, QualType Ty) {
+  return Ty->isVectorType() &&
+         Ctx.getTypeSizeInChars(Ty) <=
+             Ctx.getTypeSizeInChars(Ctx.getUIntPtrType());
+}
+
 bool Sema::IsOpenMPCapturedByRef(ValueDecl *D, unsigned Level) {
   assert(LangOpts.OpenMP && "OpenMP is not allowed");
 
@@ -1416,10 +1562,22 @@ bool Sema::IsOpenMPCapturedByRef(ValueDecl *D, unsigned Level) {
       // If variable is identified in a map clause it is always captured by
       // reference except if it is a pointer that is dereferenced somehow.
       IsByRef = !(Ty->isPointerType() && IsVariableAssociatedWithSection);
+
+      // On request, a scalar that is only ever mapped 'to' the region is
+      // passed by value, which spares the runtime a separate host-to-device
+      // copy for it. A variable that may already be present in a device data
+      // environment keeps the reference, since the region must see the device
+      // copy rather than the host value.
+      if (IsByRef && LangOpts.OpenMPSmallMapsByValue &&
+          !IsVariableAssociatedWithSection && Ty->isScalarType() &&
+          !Ty->isPointerType() && DSAStack->isMapToOnlyAtLevel(D, Level) &&
+          !DSAStack->mayBeInDeviceDataEnvironment(D, Level))
+        IsByRef = false;
     } else {
-      // By default, all the data that has a scalar type is mapped by copy.
-      IsByRef =
-          !Ty->isScalarType() || DSAStack->isDefaultMapToFromAtLevel(Level);
+      // By default, all the data that has a scalar type is mapped by copy,
+      // and so are the vectors that fit a uintptr.
+      IsByRef = !(Ty->isScalarType() || isSmallVectorType(Context, Ty)) ||
+                DSAStack->isDefaultMapToFromAtLevel(Level);
     }
   } else if (Ty.getNonReferenceType()->isScalarType()) {
     IsByRef = !DSAStack->hasExplicitDSA(
@@ -2105,7 +2263,9 @@ public:
             IsFirstprivate = RD->isLambda();
           IsFirstprivate =
               IsFirstprivate ||
-              (VD->getType().getNonReferenceType()->isScalarType() &&
+              ((VD->getType().getNonReferenceType()->isScalarType() ||
+                isSmallVectorType(SemaRef.Context,
+                                  VD->getType().getNonReferenceType())) &&
                !Stack->isDefaultMapToFromAtLevel(Stack->getNestingLevel()));
           if (IsFirstprivate)
             ImplicitFirstprivate.emplace_back(E);
@@ -2961,6 +3121,133 @@ static bool checkIfClauses(Sema &S, OpenMPDirectiveKind Kind,
   return ErrorFound;
 }
 
+/// Return true if \a E names the implicitly mapped declaration \a D, a
+/// variable or a field of 'this'.
+static bool isRefToMappedDecl(const Expr *E, const ValueDecl *D) {
+  E = E->IgnoreParens();
+  if (const auto *DRE = dyn_cast<DeclRefExpr>(E))
+    return DRE->getDecl()->getCanonicalDecl() == D;
+  if (const auto *ME = dyn_cast<MemberExpr>(E))
+    return isa<CXXThisExpr>(ME->getBase()->IgnoreParenImpCasts()) &&
+           ME->getMemberDecl()->getCanonicalDecl() == D;
+  return false;
+}
+
+/// Return true if \a S refers to \a D in any way.
+static bool refersToMappedDecl(const Stmt *S, const ValueDecl *D) {
+  if (!S)
+    return false;
+  if (const auto *E = dyn_cast<Expr>(S))
+    if (isRefToMappedDecl(E, D))
+      return true;
+  if (const auto *Dir = dyn_cast<OMPExecutableDirective>(S))
+    for (const OMPClause *C : Dir->clauses())
+      for (const Stmt *Child : const_cast<OMPClause *>(C)->children())
+        if (refersToMappedDecl(Child, D))
+          return true;
+  for (const Stmt *Child : S->children())
+    if (refersToMappedDecl(Child, D))
+      return true;
+  return false;
+}
+
+/// Return true if \a D may be written, or may have its address escape, in
+/// \a S. Only loads of \a D, of its elements and of its fields are known to be
+/// safe.
+static bool mayModifyMappedDecl(const Stmt *S, const ValueDecl *D) {
+  if (!S)
+    return false;
+
+  if (const auto *ICE = dyn_cast<ImplicitCastExpr>(S)) {
+    if (ICE->getCastKind() == CK_LValueToRValue) {
+      const Expr *E = ICE->getSubExpr()->IgnoreParens();
+      while (true) {
+        if (isRefToMappedDecl(E, D))
+          return false;
+        if (const auto *ASE = dyn_cast<ArraySubscriptExpr>(E)) {
+          if (mayModifyMappedDecl(ASE->getIdx(), D))
+            return true;
+          const auto *Base =
+              dyn_cast<ImplicitCastExpr>(ASE->getBase()->IgnoreParens());
+          if (!Base || Base->getCastKind() != CK_ArrayToPointerDecay)
+            break;
+          E = Base->getSubExpr()->IgnoreParens();
+        } else if (const auto *ME = dyn_cast<MemberExpr>(E)) {
+          if (ME->isArrow())
+            break;
+          E = ME->getBase()->IgnoreParens();
+        } else
+          break;
+      }
+    }
+  }
+
+  if (const auto *E = dyn_cast<Expr>(S))
+    if (isRefToMappedDecl(E, D))
+      return true;
+
+  // Trivial copies only read their source.
+  if (const auto *OCE = dyn_cast<CXXOperatorCallExpr>(S)) {
+    const auto *MD = dyn_cast_or_null<CXXMethodDecl>(OCE->getDirectCallee());
+    if (OCE->getOperator() == OO_Equal && MD && MD->isTrivial() &&
+        OCE->getNumArgs() == 2) {
+      const Expr *Src = OCE->getArg(1);
+      return mayModifyMappedDecl(OCE->getArg(0), D) ||
+             (!isRefToMappedDecl(Src->IgnoreImpCasts(), D) &&
+              mayModifyMappedDecl(Src, D));
+    }
+  }
+  if (const auto *CE = dyn_cast<CXXConstructExpr>(S))
+    if (CE->getConstructor()->isTrivial() && CE->getNumArgs() == 1 &&
+        isRefToMappedDecl(CE->getArg(0)->IgnoreImpCasts(), D))
+      return false;
+
+  // The clauses of nested directives may refer to the declaration as well.
+  if (const auto *Dir = dyn_cast<OMPExecutableDirective>(S))
+    for (const OMPClause *C : Dir->clauses())
+      for (const Stmt *Child : const_cast<OMPClause *>(C)->children())
+        if (mayModifyMappedDecl(Child, D))
+          return true;
+
+  // The capture initializers of a nested region refer to the captured
+  // variables by reference; only look at the captured body.
+  if (const auto *CS = dyn_cast<CapturedStmt>(S))
+    return mayModifyMappedDecl(CS->getCapturedStmt(), D);
+
+  for (const Stmt *Child : S->children())
+    if (mayModifyMappedDecl(Child, D))
+      return true;
+  return false;
+}
+
+/// Return true if the first statement of \a Body assigns the whole of \a D
+/// from a value that does not depend on it, so that the region never observes
+/// the value \a D has on entry.
+static bool isOverwrittenBeforeRead(const Stmt *Body, const ValueDecl *D) {
+  if (const auto *CS = dyn_cast<CompoundStmt>(Body)) {
+    if (CS->body_empty())
+      return false;
+    Body = CS->body_front();
+  }
+  const Expr *LHS = nullptr;
+  const Expr *RHS = nullptr;
+  if (const auto *BO = dyn_cast<BinaryOperator>(Body)) {
+    if (BO->getOpcode() != BO_Assign)
+      return false;
+    LHS = BO->getLHS();
+    RHS = BO->getRHS();
+  } else if (const auto *OCE = dyn_cast<CXXOperatorCallExpr>(Body)) {
+    const auto *MD = dyn_cast_or_null<CXXMethodDecl>(OCE->getDirectCallee());
+    if (OCE->getOperator() != OO_Equal || !MD || !MD->isTrivial() ||
+        OCE->getNumArgs() != 2)
+      return false;
+    LHS = OCE->getArg(0);
+    RHS = OCE->getArg(1);
+  } else
+    return false;
+  return isRefToMappedDecl(LHS, D) && !refersToMappedDecl(RHS, D);
+}
+
 StmtResult Sema::ActOnOpenMPExecutableDirective(
     OpenMPDirectiveKind Kind, const DeclarationNameInfo &DirName,
     OpenMPDirectiveKind CancelRegion, ArrayRef<OMPClause *> Clauses,
@@ -3009,18 +3296,51 @@ StmtResult Sema::ActOnOpenMPExecutableDirective(
       } else
         ErrorFound = true;
     }
+    // Narrow the implicit maps of the declarations that the region only
+    // reads to 'to', and of the ones it overwrites before reading them to
+    // 'from'.
+    SmallVector<Expr *, 4> ImplicitlyMappedToVars;
+    SmallVector<Expr *, 4> ImplicitlyMappedFromVars;
+    if (getLangOpts().OpenMPNarrowImplicitMaps &&
+        !ImplicitlyMappedVars.empty()) {
+      const Stmt *Body = cast<CapturedStmt>(AStmt)->getCapturedStmt();
+      SmallVector<Expr *, 4> ImplicitlyMappedToFromVars;
+      for (auto *E : ImplicitlyMappedVars) {
+        const ValueDecl *D =
+            isa<DeclRefExpr>(E)
+                ? cast<DeclRefExpr>(E)->getDecl()->getCanonicalDecl()
+                : cast<MemberExpr>(E)->getMemberDecl()->getCanonicalDecl();
+        if (!mayModifyMappedDecl(Body, D)) {
+          Diag(E->getExprLoc(), diag::remark_omp_implicit_map_narrowed)
+              << D << /*To=*/0;
+          ImplicitlyMappedToVars.push_back(E);
+        } else if (Kind == OMPD_target && isOverwrittenBeforeRead(Body, D)) {
+          Diag(E->getExprLoc(), diag::remark_omp_implicit_map_narrowed)
+              << D << /*From=*/1;
+          ImplicitlyMappedFromVars.push_back(E);
+        } else
+          ImplicitlyMappedToFromVars.push_back(E);
+      }
+      ImplicitlyMappedVars.swap(ImplicitlyMappedToFromVars);
+    }
     // TODO: add combined constructs
-    if (!ImplicitlyMappedVars.empty()) {
+    auto &&AddImplicitMap = [&](OpenMPMapClauseKind MapType,
+                                ArrayRef<Expr *> Vars) {
+      if (Vars.empty())
+        return;
       if (OMPClause *Implicit = ActOnOpenMPMapClause(
-              OMPC_MAP_unknown, OMPC_MAP_tofrom, /* IsMapTypeImplicit = */ true,
-              SourceLocation(), SourceLocation(), ImplicitlyMappedVars,
-              SourceLocation(), SourceLocation(), SourceLocation())) {
+              OMPC_MAP_unknown, MapType, /* IsMapTypeImplicit = */ true,
+              SourceLocation(), SourceLocation(), Vars, SourceLocation(),
+              SourceLocation(), SourceLocation())) {
         ClausesWithImplicit.push_back(Implicit);
-        ErrorFound |= cast<OMPMapClause>(Implicit)->varlist_size() !=
-                      ImplicitlyMappedVars.size();
+        ErrorFound |=
+            cast<OMPMapClause>(Implicit)->varlist_size() != Vars.size();
       } else
         ErrorFound = true;
-    }
+    };
+    AddImplicitMap(OMPC_MAP_tofrom, ImplicitlyMappedVars);
+    AddImplicitMap(OMPC_MAP_to, ImplicitlyMappedToVars);
+    AddImplicitMap(OMPC_MAP_from, ImplicitlyMappedFromVars);
   }
 
   llvm::SmallVector<OpenMPDirectiveKind, 4> AllowedNameModifiers;
@@ -5074,12 +5394,9 @@ static unsigned CheckOpenMPLoop(
   Built.PreInits = buildPreInits(C, Captures);
   Built.Cond = Cond.get();
   Built.Init = Init.get();
-  Built.LaneInit =
-      OutlinedSimd ? LaneInit.get()
-                   : SemaRef.ActOnIntegerConstant(SourceLocation(), 0).get();
-  Built.NumLanes =
-      OutlinedSimd ? NumLanes.get()
-                   : SemaRef.ActOnIntegerConstant(SourceLocation(), 0).get();
+  // Only read by CodeGen for simd loops outlined on nvptx.
+  Built.LaneInit = LaneInit.get();
+  Built.NumLanes = NumLanes.get();
   Built.Inc = Inc.get();
   Built.LB = LB.get();
   Built.UB = UB.get();
@@ -6968,12 +7285,6 @@ StmtResult Sema::ActOnOpenMPDistributeParallelForDirective(
   bool CoalescedDistSchedule;
   std::tie(CoalescedSchedule, CoalescedDistSchedule) =
       generateCoalescedSchedule(*this, Clauses);
-  // FIXME: 'distribute parallel for' does not support coalescing on the
-  // distribute clause.
-
-  if (!getLangOpts().OpenMPCombineDirs) {
-  CoalescedDistSchedule = false;
-  }
   OMPLoopDirective::HelperExprs B;
   // In presence of clause 'collapse' with number of loops, it will
   // define the nested loops number.
@@ -11246,7 +11557,7 @@ static Expr *CheckMapClauseExpressionBase(
       AllowWholeSizeArraySection = false;
 
       // Record the component.
-      CurComponents.emplace_back(CurE, CurE->getDecl());
+      CurComponents.emplace_back(CurE);
     } else if (auto *CurE = dyn_cast<MemberExpr>(E)) {
       auto *BaseE = CurE->getBase()->IgnoreParenImpCasts();
 
@@ -11314,7 +11625,7 @@ static Expr *CheckMapClauseExpressionBase(
       AllowWholeSizeArraySection = false;
 
       // Record the component.
-      CurComponents.emplace_back(CurE, FD);
+      CurComponents.emplace_back(CurE);
     } else if (auto *CurE = dyn_cast<ArraySubscriptExpr>(E)) {
       E = CurE->getBase()->IgnoreParenImpCasts();
 
@@ -11335,7 +11646,7 @@ static Expr *CheckMapClauseExpressionBase(
         AllowWholeSizeArraySection = false;
 
       // Record the component - we don't have any declaration associated.
-      CurComponents.emplace_back(CurE, nullptr);
+      CurComponents.emplace_back(CurE);
     } else if (auto *CurE = dyn_cast<OMPArraySectionExpr>(E)) {
       assert(!NoDiagnose && "Array sections cannot be implicitly mapped.");
       E = CurE->getBase()->IgnoreParenImpCasts();
@@ -11381,7 +11692,7 @@ static Expr *CheckMapClauseExpressionBase(
       }
 
       // Record the component - we don't have any declaration associated.
-      CurComponents.emplace_back(CurE, nullptr);
+      CurComponents.emplace_back(CurE);
     } else {
       if (!NoDiagnose) {
         // If nothing else worked, this is not a valid map clause expression.
@@ -11799,7 +12110,8 @@ checkMappableExpressionList(Sema &SemaRef, DSAStackTy *DSAS,
     // Store the components in the stack so that they can be used to check
     // against other clauses later on.
     DSAS->addMappableExpressionComponents(CurDeclaration, CurComponents,
-                                          /*WhereFoundClauseKind=*/OMPC_map);
+                                          /*WhereFoundClauseKind=*/OMPC_map,
+                                          MapType);
 
     // Save the components and declaration to create the clause. For purposes of
     // the clause creation, any component list that has has base 'this' uses
@@ -12391,6 +12703,18 @@ void Sema::ActOnOpenMPDeclareTargetName(Scope *CurScope,
     if (!SameDirectiveDecls.insert(cast<NamedDecl>(ND->getCanonicalDecl())))
       Diag(Id.getLoc(), diag::err_omp_declare_target_multiple) << Id.getName();
 
+    // The body of a function that was not declare target when it was defined
+    // may have been skipped, in which case there is nothing to emit.
+    if (auto *FD = dyn_cast<FunctionDecl>(ND)) {
+      for (const FunctionDecl *RD : FD->redecls()) {
+        if (RD->hasSkippedBody()) {
+          Diag(Id.getLoc(), diag::err_omp_declare_target_skipped_body)
+              << Id.getName();
+          return;
+        }
+      }
+    }
+
     if (!ND->hasAttr<OMPDeclareTargetDeclAttr>()) {
       Attr *A = OMPDeclareTargetDeclAttr::CreateImplicit(Context, MT);
       ND->addAttr(A);
@@ -12427,6 +12751,16 @@ static void checkDeclInTargetContext(SourceLocation SL, SourceRange SR,
     }
 
   } else if (isa<FunctionDecl>(D)) {
+    // A function that is not declare target may have had its body skipped in
+    // this device compilation, in which case it cannot be made declare target
+    // implicitly.
+    for (const FunctionDecl *RD : cast<FunctionDecl>(D)->redecls()) {
+      if (RD->hasSkippedBody()) {
+        SemaRef.Diag(SL, diag::err_omp_declare_target_skipped_body)
+            << cast<FunctionDecl>(D) << SR;
+        return;
+      }
+    }
     const FunctionDecl *FD = nullptr;
     if (cast<FunctionDecl>(D)->hasBody(FD))
       LD = const_cast<FunctionDecl *>(FD);
@@ -12466,9 +12800,10 @@ static void checkDeclInTargetContext(SourceLocation SL, SourceRange SR,
       SemaRef.Diag(LD->getLocation(), diag::warn_omp_not_in_target_context);
       SemaRef.Diag(SL, diag::note_used_here) << SR;
     }
-    // Mark decl as declared target to prevent further diagnostic.
+    // Mark decl as declared target to prevent further diagnostic. The range of
+    // the use records that it was not declared target by the user.
     Attr *A = OMPDeclareTargetDeclAttr::CreateImplicit(
-        SemaRef.Context, OMPDeclareTargetDeclAttr::MT_To);
+        SemaRef.Context, OMPDeclareTargetDeclAttr::MT_To, SR);
     D->addAttr(A);
     if (ASTMutationListener *ML = SemaRef.Context.getASTMutationListener())
       ML->DeclarationMarkedOpenMPDeclareTarget(D, A);
@@ -12641,7 +12976,7 @@ OMPClause *Sema::ActOnOpenMPUseDevicePtrClause(ArrayRef<Expr *> VarList,
     MVLI.VarBaseDeclarations.push_back(D);
     MVLI.VarComponents.resize(MVLI.VarComponents.size() + 1);
     MVLI.VarComponents.back().push_back(
-        OMPClauseMappableExprCommon::MappableComponent(SimpleRefExpr, D));
+        OMPClauseMappableExprCommon::MappableComponent(SimpleRefExpr));
   }
 
   if (MVLI.ProcessedVarList.empty())
@@ -12709,7 +13044,7 @@ OMPClause *Sema::ActOnOpenMPIsDevicePtrClause(ArrayRef<Expr *> VarList,
 
     // Store the components in the stack so that they can be used to check
     // against other clauses later on.
-    OMPClauseMappableExprCommon::MappableComponent MC(SimpleRefExpr, D);
+    OMPClauseMappableExprCommon::MappableComponent MC(SimpleRefExpr);
     DSAStack->addMappableExpressionComponents(
         D, MC, /*WhereFoundClauseKind=*/OMPC_is_device_ptr);
 
@@ -836,9 +836,36 @@ void OverloadCandidateSet::destroyCandidates() {
   }
 }
 
+ImplicitConversionSequence *
+OverloadCandidateSet::allocateConversionSequences(Sema &S,
+                                                  unsigned NumConversions) {
+  assert((!ConversionSequenceOwner || ConversionSequenceOwner == &S) &&
+         "candidate set used with two Sema objects");
+  if (!ConversionSequenceOwner) {
+    ConversionSequenceOwner = &S;
+    ++S.NumConversionSequenceSets;
+  }
+  S.NumConversionSequencesAllocated += NumConversions;
+  S.NumConversionSequenceBytes +=
+      NumConversions * sizeof(ImplicitConversionSequence);
+  return S.ConversionSequenceAlloc.Allocate<ImplicitConversionSequence>(
+      NumConversions);
+}
+
+void OverloadCandidateSet::releaseConversionSequences() {
+  if (!ConversionSequenceOwner)
+    return;
+  // Candidate sets nest, but are not always destroyed in the reverse order
+  // of their creation, so the memory is only reclaimed once none of them
+  // uses it. Reset keeps the current slab for the next overload resolution.
+  if (--ConversionSequenceOwner->NumConversionSequenceSets == 0)
+    ConversionSequenceOwner->ConversionSequenceAlloc.Reset();
+  ConversionSequenceOwner = nullptr;
+}
+
 void OverloadCandidateSet::clear() {
   destroyCandidates();
-  ConversionSequenceAllocator.Reset();
+  releaseConversionSequences();
   NumInlineSequences = 0;
   Candidates.clear();
   Functions.clear();
@@ -5889,7 +5916,8 @@ Sema::AddOverloadCandidate(FunctionDecl *Function,
   EnterExpressionEvaluationContext Unevaluated(*this, Sema::Unevaluated);
 
   // Add this candidate
-  OverloadCandidate &Candidate = CandidateSet.addCandidate(Args.size());
+  OverloadCandidate &Candidate =
+      CandidateSet.addCandidate(*this, Args.size());
   Candidate.FoundDecl = FoundDecl;
   Candidate.Function = Function;
   Candidate.Viable = true;
@@ -6186,6 +6214,7 @@ void Sema::AddFunctionCandidates(const UnresolvedSetImpl &Fns,
                                  TemplateArgumentListInfo *ExplicitTemplateArgs,
                                  bool SuppressUserConversions,
                                  bool PartialOverloading) {
+  CandidateSet.reserve(Fns.size());
   for (UnresolvedSetIterator F = Fns.begin(), E = Fns.end(); F != E; ++F) {
     NamedDecl *D = F.getDecl()->getUnderlyingDecl();
     if (FunctionDecl *FD = dyn_cast<FunctionDecl>(D)) {
@@ -6283,7 +6312,8 @@ Sema::AddMethodCandidate(CXXMethodDecl *Method, DeclAccessPair FoundDecl,
   EnterExpressionEvaluationContext Unevaluated(*this, Sema::Unevaluated);
 
   // Add this candidate
-  OverloadCandidate &Candidate = CandidateSet.addCandidate(Args.size() + 1);
+  OverloadCandidate &Candidate =
+      CandidateSet.addCandidate(*this, Args.size() + 1);
   Candidate.FoundDecl = FoundDecl;
   Candidate.Function = Method;
   Candidate.IsSurrogate = false;
@@ -6558,7 +6588,7 @@ Sema::AddConversionCandidate(CXXConversionDecl *Conversion,
   EnterExpressionEvaluationContext Unevaluated(*this, Sema::Unevaluated);
 
   // Add this candidate
-  OverloadCandidate &Candidate = CandidateSet.addCandidate(1);
+  OverloadCandidate &Candidate = CandidateSet.addCandidate(*this, 1);
   Candidate.FoundDecl = FoundDecl;
   Candidate.Function = Conversion;
   Candidate.IsSurrogate = false;
@@ -6748,7 +6778,8 @@ void Sema::AddSurrogateCandidate(CXXConversionDecl *Conversion,
   // Overload resolution is always an unevaluated context.
   EnterExpressionEvaluationContext Unevaluated(*this, Sema::Unevaluated);
 
-  OverloadCandidate &Candidate = CandidateSet.addCandidate(Args.size() + 1);
+  OverloadCandidate &Candidate =
+      CandidateSet.addCandidate(*this, Args.size() + 1);
   Candidate.FoundDecl = FoundDecl;
   Candidate.Function = nullptr;
   Candidate.Surrogate = Conversion;
@@ -6909,7 +6940,8 @@ void Sema::AddBuiltinCandidate(QualType ResultTy, QualType *ParamTys,
   EnterExpressionEvaluationContext Unevaluated(*this, Sema::Unevaluated);
 
   // Add this candidate
-  OverloadCandidate &Candidate = CandidateSet.addCandidate(Args.size());
+  OverloadCandidate &Candidate =
+      CandidateSet.addCandidate(*this, Args.size());
   Candidate.FoundDecl = DeclAccessPair::make(nullptr, AS_none);
   Candidate.Function = nullptr;
   Candidate.IsSurrogate = false;
@@ -8840,9 +8872,9 @@ bool clang::isBetterOverloadCandidate(Sema &S, const OverloadCandidate &Cand1,
   }
 
   if (S.getLangOpts().CUDA && Cand1.Function && Cand2.Function) {
-    FunctionDecl *Caller = dyn_cast<FunctionDecl>(S.CurContext);
-    return S.IdentifyCUDAPreference(Caller, Cand1.Function) >
-           S.IdentifyCUDAPreference(Caller, Cand2.Function);
+    Sema::CUDAFunctionTarget CallerTarget = S.CurrentCUDATarget();
+    return S.IdentifyCUDAPreference(CallerTarget, Cand1.Function) >
+           S.IdentifyCUDAPreference(CallerTarget, Cand2.Function);
   }
 
   bool HasPS1 = Cand1.Function != nullptr &&
@@ -8945,17 +8977,17 @@ OverloadCandidateSet::BestViableFunction(Sema &S, SourceLocation Loc,
   // candidate call is WrongSide and the other is SameSide, we ignore
   // the WrongSide candidate.
   if (S.getLangOpts().CUDA) {
-    const FunctionDecl *Caller = dyn_cast<FunctionDecl>(S.CurContext);
+    Sema::CUDAFunctionTarget CallerTarget = S.CurrentCUDATarget();
     bool ContainsSameSideCandidate =
         llvm::any_of(Candidates, [&](OverloadCandidate *Cand) {
           return Cand->Function &&
-                 S.IdentifyCUDAPreference(Caller, Cand->Function) ==
+                 S.IdentifyCUDAPreference(CallerTarget, Cand->Function) ==
                      Sema::CFP_SameSide;
         });
     if (ContainsSameSideCandidate) {
       auto IsWrongSideCandidate = [&](OverloadCandidate *Cand) {
         return Cand->Function &&
-               S.IdentifyCUDAPreference(Caller, Cand->Function) ==
+               S.IdentifyCUDAPreference(CallerTarget, Cand->Function) ==
                    Sema::CFP_WrongSide;
       };
       Candidates.erase(std::remove_if(Candidates.begin(), Candidates.end(),
@@ -11246,6 +11278,7 @@ void Sema::AddOverloadedCallCandidates(UnresolvedLookupExpr *ULE,
     ExplicitTemplateArgs = &TABuffer;
   }
 
+  CandidateSet.reserve(ULE->getNumDecls());
   for (UnresolvedLookupExpr::decls_iterator I = ULE->decls_begin(),
          E = ULE->decls_end(); I != E; ++I)
     AddOverloadedCallCandidate(*this, I.getPair(), ExplicitTemplateArgs, Args,
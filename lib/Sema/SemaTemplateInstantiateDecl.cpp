@@ -19,6 +19,7 @@
 #include "clang/AST/Expr.h"
 #include "clang/AST/ExprCXX.h"
 #include "clang/AST/TypeLoc.h"
+#include "clang/Basic/TimeTrace.h"
 #include "clang/Sema/Initialization.h"
 #include "clang/Sema/Lookup.h"
 #include "clang/Sema/PrettyDeclStackTrace.h"
@@ -3707,6 +3708,14 @@ void Sema::InstantiateFunctionDefinition(SourceLocation PointOfInstantiation,
     return;
   }
 
+  TimeTraceScope TTS("InstantiateFunction", [&] {
+    std::string Name;
+    llvm::raw_string_ostream OS(Name);
+    Function->getNameForDiagnostic(OS, getPrintingPolicy(),
+                                   /*Qualified=*/true);
+    return OS.str();
+  });
+
   // If we're performing recursive template instantiation, create our own
   // queue of pending implicit instantiations that we will instantiate later,
   // while we're still within our own instantiation context.
@@ -3728,8 +3737,17 @@ void Sema::InstantiateFunctionDefinition(SourceLocation PointOfInstantiation,
     auto LPTIter = LateParsedTemplateMap.find(PatternDecl);
     assert(LPTIter != LateParsedTemplateMap.end() &&
            "missing LateParsedTemplate");
-    LateTemplateParser(OpaqueParser, *LPTIter->second);
+    // Parsing the body can add entries to the map, so hold on to the
+    // template itself rather than the iterator.
+    LateParsedTemplate &LPT = *LPTIter->second;
+    LateTemplateParser(OpaqueParser, LPT);
     Pattern = PatternDecl->getBody(PatternDecl);
+
+    // Once the body is parsed its tokens are not needed any more; free them
+    // rather than keeping every late parsed body alive until the end of the
+    // translation unit.
+    if (!PatternDecl->isLateTemplateParsed())
+      CachedTokens().swap(LPT.Toks);
   }
 
   // Note, we should never try to instantiate a deleted function template.
@@ -3275,6 +3275,9 @@ ExprResult TreeTransform<Derived>::TransformInitializer(Expr *Init,
   if (auto *AIL = dyn_cast<ArrayInitLoopExpr>(Init))
     Init = AIL->getCommonExpr();
 
+  if (auto *CAI = dyn_cast<CompactArrayInitExpr>(Init))
+    Init = CAI->getSyntacticForm();
+
   if (MaterializeTemporaryExpr *MTE = dyn_cast<MaterializeTemporaryExpr>(Init))
     Init = MTE->GetTemporaryExpr();
 
@@ -9179,6 +9182,13 @@ TreeTransform<Derived>::TransformInitListExpr(InitListExpr *E) {
                                       E->getRBraceLoc(), E->getType());
 }
 
+template<typename Derived>
+ExprResult
+TreeTransform<Derived>::TransformCompactArrayInitExpr(CompactArrayInitExpr *E) {
+  // The initialization is performed again on the initializer list as written.
+  return getDerived().TransformInitListExpr(E->getSyntacticForm());
+}
+
 template<typename Derived>
 ExprResult
 TreeTransform<Derived>::TransformDesignatedInitExpr(DesignatedInitExpr *E) {
@@ -71,6 +71,21 @@ TypeID MakeTypeID(ASTContext &Context, QualType T, IdxForTypeTy IdxForType) {
 
 unsigned ComputeHash(Selector Sel);
 
+/// \brief The number of bits of the identifier filter of an AST file that
+/// are set for each identifier in its identifier table.
+const unsigned IdentifierFilterProbes = 4;
+
+/// \brief Retrieve the bit of an identifier filter of \p NumBits bits, a power
+/// of two, that the probe \p Probe checks for an identifier whose hash is
+/// \p Hash.
+inline unsigned getIdentifierFilterBit(unsigned Hash, unsigned Probe,
+                                       unsigned NumBits) {
+  // Derive the probes from the hash of the identifier table, so that the
+  // name is only hashed once.
+  unsigned Step = (Hash >> 16 | Hash << 16) | 1;
+  return (Hash + Probe * Step) & (NumBits - 1);
+}
+
 /// \brief Retrieve the "definitive" declaration that provides all of the
 /// visible entries for the given declaration context, if there is one.
 ///
@@ -44,6 +44,7 @@
 #include "clang/Basic/Specifiers.h"
 #include "clang/Basic/TargetInfo.h"
 #include "clang/Basic/TargetOptions.h"
+#include "clang/Basic/TimeTrace.h"
 #include "clang/Basic/TokenKinds.h"
 #include "clang/Basic/Version.h"
 #include "clang/Basic/VersionTuple.h"
@@ -986,6 +987,15 @@ ASTDeclContextNameLookupTrait::ReadFileRef(const unsigned char *&d) {
   return Reader.getLocalModuleFile(F, ModuleFileID);
 }
 
+void ASTDeclContextNameLookupTrait::noteCondensed(unsigned NumTables,
+                                                  unsigned NumEntries,
+                                                  double Seconds) {
+  ++Reader.NumLookupTableCondenses;
+  Reader.NumLookupTablesCondensed += NumTables;
+  Reader.NumLookupTableEntriesCondensed += NumEntries;
+  Reader.LookupTableCondenseTime += Seconds;
+}
+
 std::pair<unsigned, unsigned>
 ASTDeclContextNameLookupTrait::ReadKeyDataLength(const unsigned char *&d) {
   using namespace llvm::support;
@@ -1355,6 +1365,14 @@ bool ASTReader::ReadSLocEntry(int ID) {
     if (OverriddenBuffer && !ContentCache->BufferOverridden &&
         ContentCache->ContentsEntry == ContentCache->OrigEntry &&
         !ContentCache->getRawBuffer()) {
+      // The contents are written with the first entry of the file. Load it
+      // through the SourceManager, which sets the contents of this entry too.
+      if (unsigned ContentsEntry = Record[8]) {
+        SourceMgr.getLoadedSLocEntryByID(int(ContentsEntry - 1) +
+                                         F->SLocEntryBaseID);
+        break;
+      }
+
       auto Buffer = ReadBuffer(SLocEntryCursor, File->getName());
       if (!Buffer)
         return true;
@@ -1763,16 +1781,20 @@ namespace {
     unsigned PriorGeneration;
     unsigned &NumIdentifierLookups;
     unsigned &NumIdentifierLookupHits;
+    unsigned &NumIdentifierLookupsFiltered;
     IdentifierInfo *Found;
 
   public:
-    IdentifierLookupVisitor(StringRef Name, unsigned PriorGeneration,
+    IdentifierLookupVisitor(StringRef Name, unsigned NameHash,
+                            unsigned PriorGeneration,
                             unsigned &NumIdentifierLookups,
-                            unsigned &NumIdentifierLookupHits)
-      : Name(Name), NameHash(ASTIdentifierLookupTrait::ComputeHash(Name)),
+                            unsigned &NumIdentifierLookupHits,
+                            unsigned &NumIdentifierLookupsFiltered)
+      : Name(Name), NameHash(NameHash),
         PriorGeneration(PriorGeneration),
         NumIdentifierLookups(NumIdentifierLookups),
         NumIdentifierLookupHits(NumIdentifierLookupHits),
+        NumIdentifierLookupsFiltered(NumIdentifierLookupsFiltered),
         Found()
     {
     }
@@ -1787,6 +1809,19 @@ namespace {
       if (!IdTable)
         return false;
 
+      // Most names are not in most module files; the filter rules out nearly
+      // all of them without touching the table.
+      if (M.IdentifierFilter) {
+        for (unsigned I = 0; I != IdentifierFilterProbes; ++I) {
+          unsigned Bit =
+              getIdentifierFilterBit(NameHash, I, M.IdentifierFilterBits);
+          if (!(M.IdentifierFilter[Bit / 32] & (1u << (Bit % 32)))) {
+            ++NumIdentifierLookupsFiltered;
+            return false;
+          }
+        }
+      }
+
       ASTIdentifierLookupTrait Trait(IdTable->getInfoObj().getReader(), M,
                                      Found);
       ++NumIdentifierLookups;
@@ -1818,19 +1853,24 @@ void ASTReader::updateOutOfDateIdentifier(IdentifierInfo &II) {
   if (getContext().getLangOpts().Modules)
     PriorGeneration = IdentifierGeneration[&II];
 
+  // The global index and the identifier tables of all the module files share
+  // the hash of the name, so compute it once.
+  unsigned NameHash = ASTIdentifierLookupTrait::ComputeHash(II.getName());
+
   // If there is a global index, look there first to determine which modules
   // provably do not have any results for this identifier.
   GlobalModuleIndex::HitSet Hits;
   GlobalModuleIndex::HitSet *HitsPtr = nullptr;
   if (!loadGlobalIndex()) {
-    if (GlobalIndex->lookupIdentifier(II.getName(), Hits)) {
+    if (GlobalIndex->lookupIdentifier(II.getName(), NameHash, Hits)) {
       HitsPtr = &Hits;
     }
   }
 
-  IdentifierLookupVisitor Visitor(II.getName(), PriorGeneration,
+  IdentifierLookupVisitor Visitor(II.getName(), NameHash, PriorGeneration,
                                   NumIdentifierLookups,
-                                  NumIdentifierLookupHits);
+                                  NumIdentifierLookupHits,
+                                  NumIdentifierLookupsFiltered);
   ModuleMgr.visit(Visitor, HitsPtr);
   markIdentifierUpToDate(&II);
 }
@@ -2227,6 +2267,20 @@ ASTReader::ASTReadResult ASTReader::ReadOptionsBlock(
   }
 }
 
+/// \brief Determine whether the timestamp file of \p MF was written after
+/// validating \p MF itself, rather than an earlier module file at the same
+/// path.
+static bool isTimestampForModuleFile(const ModuleFile &MF) {
+  if (!MF.Signature)
+    return false;
+  auto Buffer = llvm::MemoryBuffer::getFile(MF.getTimestampFilename());
+  if (!Buffer)
+    return false;
+  uint64_t Signature;
+  StringRef Contents = (*Buffer)->getBuffer().split('\n').second.trim();
+  return !Contents.getAsInteger(10, Signature) && Signature == MF.Signature;
+}
+
 ASTReader::ASTReadResult
 ASTReader::ReadControlBlock(ModuleFile &F,
                             SmallVectorImpl<ImportedModule> &Loaded,
@@ -2273,6 +2327,23 @@ ASTReader::ReadControlBlock(ModuleFile &F,
              F.InputFilesValidationTimestamp <= HSOpts.BuildSessionTimestamp &&
              F.Kind == MK_ImplicitModule))
           N = NumInputs;
+        else if (HSOpts.ModulesShareBuildSessionValidation &&
+                 F.Kind == MK_ImplicitModule &&
+                 isTimestampForModuleFile(F))
+          // Another compilation validated this very module file during the
+          // build session; trust its result for the user inputs as well.
+          N = 0;
+
+        // On a file system where each lookup is slow, start looking up all
+        // the input files at once rather than one after the other below.
+        if (FileMgr.canPrefetchFiles() && N > 1) {
+          std::vector<std::string> Paths;
+          Paths.reserve(N);
+          for (unsigned I = 0; I < N; ++I)
+            if (!F.InputFilesLoaded[I].getFile())
+              Paths.push_back(readInputFileInfo(F, I+1).Filename);
+          FileMgr.prefetchFiles(Paths);
+        }
 
         for (unsigned I = 0; I < N; ++I) {
           InputFile IF = getInputFile(F, I+1, Complain);
@@ -2409,6 +2480,18 @@ ASTReader::ReadControlBlock(ModuleFile &F,
       break;
 
     case IMPORTS: {
+      // On a file system where each lookup is slow, start looking up all the
+      // imported files at once, before they are loaded one by one below.
+      if (FileMgr.canPrefetchFiles()) {
+        std::vector<std::string> Paths;
+        for (unsigned Idx = 0, N = Record.size(); Idx < N; /* In loop */) {
+          // Skip the kind, location, size, modification time and signature.
+          Idx += 5;
+          Paths.push_back(ReadPath(F, Record, Idx));
+        }
+        FileMgr.prefetchFiles(Paths);
+      }
+
       // Load each of the imported PCH files.
       unsigned Idx = 0, N = Record.size();
       while (Idx < N) {
@@ -2727,6 +2810,15 @@ ASTReader::ReadASTBlock(ModuleFile &F, unsigned ClientLoadCapabilities) {
       }
       break;
 
+    case IDENTIFIER_FILTER:
+      // Only use a filter whose size is one that the writer would produce.
+      if (Record[0] >= 32 && llvm::isPowerOf2_32(Record[0]) &&
+          Blob.size() == Record[0] / 8) {
+        F.IdentifierFilter = (const uint32_t *)Blob.data();
+        F.IdentifierFilterBits = Record[0];
+      }
+      break;
+
     case IDENTIFIER_OFFSET: {
       if (F.LocalNumIdentifiers != 0) {
         Error("duplicate IDENTIFIER_OFFSET record in AST file");
@@ -2766,6 +2858,14 @@ ASTReader::ReadASTBlock(ModuleFile &F, unsigned ClientLoadCapabilities) {
         EagerlyDeserializedDecls.push_back(getGlobalDeclID(F, Record[I]));
       break;
 
+    case MODULAR_CODEGEN_DECLS:
+      // The definitions are only emitted when the module itself is compiled
+      // to an object file.
+      if (F.Kind == MK_MainFile)
+        for (unsigned I = 0, N = Record.size(); I != N; ++I)
+          EagerlyDeserializedDecls.push_back(getGlobalDeclID(F, Record[I]));
+      break;
+
     case SPECIAL_TYPES:
       if (SpecialTypes.empty()) {
         for (unsigned I = 0, N = Record.size(); I != N; ++I)
@@ -3566,13 +3666,28 @@ bool ASTReader::isGlobalIndexUnavailable() const {
 }
 
 static void updateModuleTimestamp(ModuleFile &MF) {
-  // Overwrite the timestamp file contents so that file's mtime changes.
+  // Replace the timestamp file so that its mtime changes. It records the
+  // signature of the module file that was validated; it is written to a
+  // temporary file first so that other compilations never see it partially
+  // written.
   std::string TimestampFilename = MF.getTimestampFilename();
-  std::error_code EC;
-  llvm::raw_fd_ostream OS(TimestampFilename, EC, llvm::sys::fs::F_Text);
-  if (EC)
+  int FD;
+  SmallString<128> TempPath;
+  if (llvm::sys::fs::createUniqueFile(TimestampFilename + "-%%%%%%%%", FD,
+                                      TempPath))
     return;
-  OS << "Timestamp file\n";
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << "Timestamp file\n" << MF.Signature << "\n";
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      llvm::sys::fs::remove(TempPath);
+      return;
+    }
+  }
+  if (llvm::sys::fs::rename(TempPath, TimestampFilename))
+    llvm::sys::fs::remove(TempPath);
 }
 
 /// \brief Given a cursor at the start of an AST file, scan ahead and drop the
@@ -3610,6 +3725,7 @@ ASTReader::ASTReadResult ASTReader::ReadAST(StringRef FileName,
                                             SourceLocation ImportLoc,
                                             unsigned ClientLoadCapabilities,
                                             SmallVectorImpl<ImportedSubmodule> *Imported) {
+  TimeTraceScope TTS("LoadModule", [&] { return FileName.str(); });
   llvm::SaveAndRestore<SourceLocation>
     SetCurImportLocRAII(CurrentImportLoc, ImportLoc);
 
@@ -3716,6 +3832,12 @@ ASTReader::ASTReadResult ASTReader::ReadAST(StringRef FileName,
 
     ModuleMgr.moduleFileAccepted(&F);
 
+    // Translate the file ID of the original source file into the file IDs
+    // of the source manager, now that its source locations are allocated.
+    if (F.OriginalSourceFileID.isValid())
+      F.OriginalSourceFileID = FileID::get(
+          F.SLocEntryBaseID + F.OriginalSourceFileID.getOpaqueValue() - 1);
+
     // Set the import location.
     F.DirectImportLoc = ImportLoc;
     // FIXME: We assume that locations from PCH / preamble do not need
@@ -3793,10 +3915,6 @@ ASTReader::ASTReadResult ASTReader::ReadAST(StringRef FileName,
 
   ModuleFile &PrimaryModule = ModuleMgr.getPrimaryModule();
   if (PrimaryModule.OriginalSourceFileID.isValid()) {
-    PrimaryModule.OriginalSourceFileID
-      = FileID::get(PrimaryModule.SLocEntryBaseID
-                    + PrimaryModule.OriginalSourceFileID.getOpaqueValue() - 1);
-
     // If this AST file is a precompiled preamble, then set the
     // preamble file ID of the source manager to the file source file
     // from which the preamble was built.
@@ -7042,12 +7160,30 @@ void ASTReader::PrintStats() {
                   * 100.0));
   }
 
+  if (!Lookups.empty()) {
+    unsigned NumTables = 0;
+    for (auto &Lookup : Lookups)
+      NumTables += Lookup.second.Table.getNumTables();
+    std::fprintf(stderr, "  %u lookup tables for %u declcontexts\n",
+                 NumTables, (unsigned)Lookups.size());
+  }
+  if (NumLookupTableCondenses)
+    std::fprintf(stderr,
+                 "  %u lookup table merges of %u tables and %u entries "
+                 "(%f seconds)\n",
+                 NumLookupTableCondenses, NumLookupTablesCondensed,
+                 NumLookupTableEntriesCondensed, LookupTableCondenseTime);
+
   if (NumIdentifierLookupHits) {
     std::fprintf(stderr,
                  "  %u / %u identifier table lookups succeeded (%f%%)\n",
                  NumIdentifierLookupHits, NumIdentifierLookups,
                  (double)NumIdentifierLookupHits*100.0/NumIdentifierLookups);
   }
+  if (NumIdentifierLookupsFiltered)
+    std::fprintf(stderr,
+                 "  %u identifier table lookups ruled out by the identifier "
+                 "filter\n", NumIdentifierLookupsFiltered);
 
   if (GlobalIndex) {
     std::fprintf(stderr, "\n");
@@ -7177,9 +7313,13 @@ IdentifierInfo *ASTReader::get(StringRef Name) {
   // Note that we are loading an identifier.
   Deserializing AnIdentifier(this);
 
-  IdentifierLookupVisitor Visitor(Name, /*PriorGeneration=*/0,
+  // The global index and the identifier tables of all the module files share
+  // the hash of the name, so compute it once.
+  unsigned NameHash = ASTIdentifierLookupTrait::ComputeHash(Name);
+  IdentifierLookupVisitor Visitor(Name, NameHash, /*PriorGeneration=*/0,
                                   NumIdentifierLookups,
-                                  NumIdentifierLookupHits);
+                                  NumIdentifierLookupHits,
+                                  NumIdentifierLookupsFiltered);
 
   // We don't need to do identifier table lookups in C++ modules (we preload
   // all interesting declarations, and don't need to use the scope for name
@@ -7195,7 +7335,7 @@ IdentifierInfo *ASTReader::get(StringRef Name) {
     GlobalModuleIndex::HitSet Hits;
     GlobalModuleIndex::HitSet *HitsPtr = nullptr;
     if (!loadGlobalIndex()) {
-      if (GlobalIndex->lookupIdentifier(Name, Hits)) {
+      if (GlobalIndex->lookupIdentifier(Name, NameHash, Hits)) {
         HitsPtr = &Hits;
       }
     }
@@ -7841,6 +7981,13 @@ ASTReader::getSourceDescriptor(unsigned ID) {
   return None;
 }
 
+ExternalASTSource::ExtKind ASTReader::hasExternalDefinitions(const Decl *D) {
+  auto I = DefinitionSource.find(D);
+  if (I == DefinitionSource.end())
+    return EK_ReplyHazy;
+  return I->second ? EK_Never : EK_Always;
+}
+
 Selector ASTReader::getLocalSelector(ModuleFile &M, unsigned LocalID) {
   return DecodeSelector(getGlobalSelectorID(M, LocalID));
 }
@@ -8920,7 +9067,8 @@ ASTReader::ASTReader(
       CurrSwitchCaseStmts(&SwitchCaseStmts), NumSLocEntriesRead(0),
       TotalNumSLocEntries(0), NumStatementsRead(0), TotalNumStatements(0),
       NumMacrosRead(0), TotalNumMacros(0), NumIdentifierLookups(0),
-      NumIdentifierLookupHits(0), NumSelectorsRead(0),
+      NumIdentifierLookupHits(0), NumIdentifierLookupsFiltered(0),
+      NumSelectorsRead(0),
       NumMethodPoolEntriesRead(0), NumMethodPoolLookups(0),
       NumMethodPoolHits(0), NumMethodPoolTableLookups(0),
       NumMethodPoolTableHits(0), TotalNumMethodPoolEntries(0),
@@ -458,6 +458,8 @@ void ASTDeclReader::Visit(Decl *D) {
     // module).
     // FIXME: Can we diagnose ODR violations somehow?
     if (Record.readInt()) {
+      if (Record.readInt())
+        Reader.DefinitionSource[FD] = Loc.F->Kind == MK_MainFile;
       if (auto *CD = dyn_cast<CXXConstructorDecl>(FD)) {
         CD->NumCtorInitializers = Record.readInt();
         if (CD->NumCtorInitializers)
@@ -1517,6 +1519,12 @@ void ASTDeclReader::ReadCXXDefinitionData(
   Data.HasDeclaredCopyConstructorWithConstParam = Record.readInt();
   Data.HasDeclaredCopyAssignmentWithConstParam = Record.readInt();
 
+  Data.ODRHash = Record.readInt();
+  Data.HasODRHash = true;
+
+  if (Record.readInt())
+    Reader.DefinitionSource[Data.Definition] = Loc.F->Kind == MK_MainFile;
+
   Data.NumBases = Record.readInt();
   if (Data.NumBases)
     Data.Bases = ReadGlobalOffset();
@@ -1580,6 +1588,11 @@ void ASTDeclReader::MergeDefinitionData(
     Reader.mergeDefinitionVisibility(DD.Definition, MergeDD.Definition);
     assert(Reader.Lookups.find(MergeDD.Definition) == Reader.Lookups.end() &&
            "already loaded pending lookups for merged definition");
+
+    // If both definitions have the same members, there is no need to check
+    // that each member of the merged one is in the canonical one.
+    if (DD.HasODRHash && MergeDD.HasODRHash && DD.ODRHash == MergeDD.ODRHash)
+      Reader.MergedDeclContextsWithSameMembers.insert(MergeDD.Definition);
   }
 
   auto PFDI = Reader.PendingFakeDefinitionData.find(&DD);
@@ -3022,7 +3035,8 @@ ASTDeclReader::FindExistingResult ASTDeclReader::findExisting(NamedDecl *D) {
   // same template specialization into the same CXXRecordDecl.
   auto MergedDCIt = Reader.MergedDeclContexts.find(D->getLexicalDeclContext());
   if (MergedDCIt != Reader.MergedDeclContexts.end() &&
-      MergedDCIt->second == D->getDeclContext())
+      MergedDCIt->second == D->getDeclContext() &&
+      !Reader.MergedDeclContextsWithSameMembers.count(MergedDCIt->first))
     Reader.PendingOdrMergeChecks.push_back(D);
 
   return FindExistingResult(Reader, D, /*Existing=*/nullptr,
@@ -3861,6 +3875,8 @@ void ASTDeclReader::UpdateDecl(Decl *D) {
         });
       }
       FD->setInnerLocStart(ReadSourceLocation());
+      if (Record.readInt())
+        Reader.DefinitionSource[FD] = Loc.F->Kind == MK_MainFile;
       if (auto *CD = dyn_cast<CXXConstructorDecl>(FD)) {
         CD->NumCtorInitializers = Record.readInt();
         if (CD->NumCtorInitializers)
@@ -106,6 +106,8 @@ public:
   }
 
   file_type ReadFileRef(const unsigned char *&d);
+
+  void noteCondensed(unsigned NumTables, unsigned NumEntries, double Seconds);
 };
 
 struct DeclContextLookupTable {
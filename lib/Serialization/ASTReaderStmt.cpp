@@ -752,6 +752,16 @@ void ASTStmtReader::VisitInitListExpr(InitListExpr *E) {
   }
 }
 
+void ASTStmtReader::VisitCompactArrayInitExpr(CompactArrayInitExpr *E) {
+  VisitExpr(E);
+  E->SyntacticForm = cast<InitListExpr>(Record.readSubExpr());
+  unsigned NumElements = Record.readInt();
+  unsigned ElementByteWidth = Record.readInt();
+  E->allocateData(Record.getContext(), NumElements, ElementByteWidth);
+  for (unsigned I = 0; I != NumElements; ++I)
+    E->setElement(I, Record.readInt());
+}
+
 void ASTStmtReader::VisitDesignatedInitExpr(DesignatedInitExpr *E) {
   typedef DesignatedInitExpr::Designator Designator;
 
@@ -2324,9 +2334,8 @@ void OMPClauseReader::VisitOMPMapClause(OMPMapClause *C) {
   Components.reserve(TotalComponents);
   for (unsigned i = 0; i < TotalComponents; ++i) {
     Expr *AssociatedExpr = Reader->Record.readSubExpr();
-    ValueDecl *AssociatedDecl = Reader->Record.readDeclAs<ValueDecl>();
-    Components.push_back(OMPClauseMappableExprCommon::MappableComponent(
-        AssociatedExpr, AssociatedDecl));
+    Components.push_back(
+        OMPClauseMappableExprCommon::MappableComponent(AssociatedExpr));
   }
   C->setComponents(Components, ListSizes);
 }
@@ -2418,9 +2427,8 @@ void OMPClauseReader::VisitOMPToClause(OMPToClause *C) {
   Components.reserve(TotalComponents);
   for (unsigned i = 0; i < TotalComponents; ++i) {
     Expr *AssociatedExpr = Reader->Record.readSubExpr();
-    ValueDecl *AssociatedDecl = Reader->Record.readDeclAs<ValueDecl>();
-    Components.push_back(OMPClauseMappableExprCommon::MappableComponent(
-        AssociatedExpr, AssociatedDecl));
+    Components.push_back(
+        OMPClauseMappableExprCommon::MappableComponent(AssociatedExpr));
   }
   C->setComponents(Components, ListSizes);
 }
@@ -2460,9 +2468,8 @@ void OMPClauseReader::VisitOMPFromClause(OMPFromClause *C) {
   Components.reserve(TotalComponents);
   for (unsigned i = 0; i < TotalComponents; ++i) {
     Expr *AssociatedExpr = Reader->Record.readSubExpr();
-    ValueDecl *AssociatedDecl = Reader->Record.readDeclAs<ValueDecl>();
-    Components.push_back(OMPClauseMappableExprCommon::MappableComponent(
-        AssociatedExpr, AssociatedDecl));
+    Components.push_back(
+        OMPClauseMappableExprCommon::MappableComponent(AssociatedExpr));
   }
   C->setComponents(Components, ListSizes);
 }
@@ -2510,9 +2517,8 @@ void OMPClauseReader::VisitOMPUseDevicePtrClause(OMPUseDevicePtrClause *C) {
   Components.reserve(TotalComponents);
   for (unsigned i = 0; i < TotalComponents; ++i) {
     Expr *AssociatedExpr = Reader->Record.readSubExpr();
-    ValueDecl *AssociatedDecl = Reader->Record.readDeclAs<ValueDecl>();
-    Components.push_back(OMPClauseMappableExprCommon::MappableComponent(
-        AssociatedExpr, AssociatedDecl));
+    Components.push_back(
+        OMPClauseMappableExprCommon::MappableComponent(AssociatedExpr));
   }
   C->setComponents(Components, ListSizes);
 }
@@ -2553,9 +2559,8 @@ void OMPClauseReader::VisitOMPIsDevicePtrClause(OMPIsDevicePtrClause *C) {
   Components.reserve(TotalComponents);
   for (unsigned i = 0; i < TotalComponents; ++i) {
     Expr *AssociatedExpr = Reader->Record.readSubExpr();
-    ValueDecl *AssociatedDecl = Reader->Record.readDeclAs<ValueDecl>();
-    Components.push_back(OMPClauseMappableExprCommon::MappableComponent(
-        AssociatedExpr, AssociatedDecl));
+    Components.push_back(
+        OMPClauseMappableExprCommon::MappableComponent(AssociatedExpr));
   }
   C->setComponents(Components, ListSizes);
 }
@@ -3327,6 +3332,10 @@ Stmt *ASTReader::ReadStmtFromStream(ModuleFile &F) {
       S = new (Context) InitListExpr(Empty);
       break;
 
+    case EXPR_COMPACT_ARRAY_INIT:
+      S = CompactArrayInitExpr::CreateEmpty(Context);
+      break;
+
     case EXPR_DESIGNATED_INIT:
       S = DesignatedInitExpr::CreateEmpty(Context,
                                      Record[ASTStmtReader::NumExprFields] - 1);
@@ -908,6 +908,7 @@ static void AddStmtsExprs(llvm::BitstreamWriter &Stream,
   RECORD(EXPR_COMPOUND_LITERAL);
   RECORD(EXPR_EXT_VECTOR_ELEMENT);
   RECORD(EXPR_INIT_LIST);
+  RECORD(EXPR_COMPACT_ARRAY_INIT);
   RECORD(EXPR_DESIGNATED_INIT);
   RECORD(EXPR_DESIGNATED_INIT_UPDATE);
   RECORD(EXPR_IMPLICIT_VALUE_INIT);
@@ -1027,7 +1028,9 @@ void ASTWriter::WriteBlockInfoBlock() {
   RECORD(DECL_OFFSET);
   RECORD(IDENTIFIER_OFFSET);
   RECORD(IDENTIFIER_TABLE);
+  RECORD(IDENTIFIER_FILTER);
   RECORD(EAGERLY_DESERIALIZED_DECLS);
+  RECORD(MODULAR_CODEGEN_DECLS);
   RECORD(SPECIAL_TYPES);
   RECORD(STATISTICS);
   RECORD(TENTATIVE_DEFINITIONS);
@@ -1746,6 +1749,7 @@ static unsigned CreateSLocFileAbbrev(llvm::BitstreamWriter &Stream) {
   Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8)); // NumCreatedFIDs
   Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 24)); // FirstDeclIndex
   Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8)); // NumDecls
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8)); // Contents entry
   return Stream.EmitAbbrev(Abbrev);
 }
 
@@ -2013,6 +2017,11 @@ void ASTWriter::WriteSourceManagerBlock(SourceManager &SourceMgr,
   std::vector<uint32_t> SLocEntryOffsets;
   RecordData PreloadSLocs;
   SLocEntryOffsets.reserve(SourceMgr.local_sloc_entry_size() - 1);
+
+  // The entries whose blobs hold the contents of the embedded files. A file
+  // that is entered several times, like a .def file, has its contents written
+  // once, and its other entries refer to that entry.
+  llvm::DenseMap<const FileEntry *, unsigned> EmbeddedFileEntries;
   for (unsigned I = 1, N = SourceMgr.local_sloc_entry_size();
        I != N; ++I) {
     // Get this source location entry.
@@ -2064,11 +2073,21 @@ void ASTWriter::WriteSourceManagerBlock(SourceManager &SourceMgr,
           Record.push_back(0);
           Record.push_back(0);
         }
-        
+
+        // The 1-based index of the entry whose blob has the contents of the
+        // file, if it is not this one.
+        unsigned ContentsEntry = 0;
+        if (Content->BufferOverridden || Content->IsTransient) {
+          auto Known = EmbeddedFileEntries.insert(
+              std::make_pair(Content->OrigEntry, SLocEntryOffsets.size()));
+          if (Known.second)
+            EmitBlob = true;
+          else
+            ContentsEntry = Known.first->second;
+        }
+        Record.push_back(ContentsEntry);
+
         Stream.EmitRecordWithAbbrev(SLocFileAbbrv, Record);
-        
-        if (Content->BufferOverridden || Content->IsTransient)
-          EmitBlob = true;
       } else {
         // The source location entry is a buffer. The blob associated
         // with this entry contains the contents of the buffer.
@@ -2925,10 +2944,13 @@ void ASTWriter::WriteFileDeclIDsMap() {
   std::sort(SortedFileDeclIDs.begin(), SortedFileDeclIDs.end(),
             llvm::less_first());
 
-  // Join the vectors of DeclIDs from all files.
+  // Join the vectors of DeclIDs from all files, sorting each by file offset.
+  // Declarations at the same offset stay in the order they were written in.
   SmallVector<DeclID, 256> FileGroupedDeclIDs;
   for (auto &FileDeclEntry : SortedFileDeclIDs) {
     DeclIDInFileInfo &Info = *FileDeclEntry.second;
+    std::stable_sort(Info.DeclIDs.begin(), Info.DeclIDs.end(),
+                     llvm::less_first());
     Info.FirstDeclIndex = FileGroupedDeclIDs.size();
     for (auto &LocDeclEntry : Info.DeclIDs)
       FileGroupedDeclIDs.push_back(LocDeclEntry.second);
@@ -3427,6 +3449,7 @@ void ASTWriter::WriteIdentifierTable(Preprocessor &PP,
     // Create the on-disk hash table representation. We only store offsets
     // for identifiers that appear here for the first time.
     IdentifierOffsets.resize(NextIdentID - FirstIdentID);
+    std::vector<unsigned> IdentifierHashes;
     for (auto IdentIDPair : IdentifierIDs) {
       auto *II = const_cast<IdentifierInfo *>(IdentIDPair.first);
       IdentID ID = IdentIDPair.second;
@@ -3436,8 +3459,10 @@ void ASTWriter::WriteIdentifierTable(Preprocessor &PP,
       if (ID >= FirstIdentID || !Chain || !II->isFromAST()
           || II->hasChangedSinceDeserialization() ||
           (Trait.needDecls() &&
-           II->hasFETokenInfoChangedSinceDeserialization()))
+           II->hasFETokenInfoChangedSinceDeserialization())) {
         Generator.insert(II, ID, Trait);
+        IdentifierHashes.push_back(Trait.ComputeHash(II));
+      }
     }
 
     // Create the on-disk hash table in a buffer.
@@ -3461,6 +3486,29 @@ void ASTWriter::WriteIdentifierTable(Preprocessor &PP,
     // Write the identifier table
     RecordData::value_type Record[] = {IDENTIFIER_TABLE, BucketOffset};
     Stream.EmitRecordWithBlob(IDTableAbbrev, Record, IdentifierTable);
+
+    // Write the bloom filter of the identifiers in the table. With 8 to 16
+    // bits per identifier, at most about one in forty of the lookups of names
+    // that the table does not contain still reach it.
+    if (!IdentifierHashes.empty()) {
+      unsigned NumBits =
+          std::max(32u, (unsigned)NextPowerOf2(IdentifierHashes.size() * 8 - 1));
+      std::vector<uint32_t> Filter(NumBits / 32);
+      for (unsigned Hash : IdentifierHashes)
+        for (unsigned I = 0; I != IdentifierFilterProbes; ++I) {
+          unsigned Bit = getIdentifierFilterBit(Hash, I, NumBits);
+          Filter[Bit / 32] |= 1u << (Bit % 32);
+        }
+
+      auto *Abbrev = new BitCodeAbbrev();
+      Abbrev->Add(BitCodeAbbrevOp(IDENTIFIER_FILTER));
+      Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 32)); // # of bits
+      Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob));
+      unsigned FilterAbbrev = Stream.EmitAbbrev(Abbrev);
+
+      RecordData::value_type Record[] = {IDENTIFIER_FILTER, NumBits};
+      Stream.EmitRecordWithBlob(FilterAbbrev, Record, bytes(Filter));
+    }
   }
 
   // Write the offsets table for identifier IDs.
@@ -4049,6 +4097,10 @@ void ASTWriter::WriteLateParsedTemplates(Sema &SemaRef) {
   RecordData Record;
   for (auto &LPTMapEntry : LPTMap) {
     const FunctionDecl *FD = LPTMapEntry.first;
+    // Templates whose bodies have already been parsed are written with the
+    // rest of the AST.
+    if (!FD->isLateTemplateParsed())
+      continue;
     LateParsedTemplate &LPT = *LPTMapEntry.second;
     AddDeclRef(FD, Record);
     AddDeclRef(LPT.D, Record);
@@ -4691,6 +4743,11 @@ uint64_t ASTWriter::WriteASTCore(Sema &SemaRef, StringRef isysroot,
   if (!EagerlyDeserializedDecls.empty())
     Stream.EmitRecord(EAGERLY_DESERIALIZED_DECLS, EagerlyDeserializedDecls);
 
+  // Write the record containing the inline functions emitted by the module's
+  // object file.
+  if (!ModularCodegenDecls.empty())
+    Stream.EmitRecord(MODULAR_CODEGEN_DECLS, ModularCodegenDecls);
+
   // Write the record containing tentative definitions.
   if (!TentativeDefinitions.empty())
     Stream.EmitRecord(TENTATIVE_DEFINITIONS, TentativeDefinitions);
@@ -5224,18 +5281,9 @@ void ASTWriter::associateDeclWithFile(const Decl *D, DeclID ID) {
   if (!Info)
     Info = new DeclIDInFileInfo();
 
-  std::pair<unsigned, serialization::DeclID> LocDecl(Offset, ID);
-  LocDeclIDsTy &Decls = Info->DeclIDs;
-
-  if (Decls.empty() || Decls.back().first <= Offset) {
-    Decls.push_back(LocDecl);
-    return;
-  }
-
-  LocDeclIDsTy::iterator I =
-      std::upper_bound(Decls.begin(), Decls.end(), LocDecl, llvm::less_first());
-
-  Decls.insert(I, LocDecl);
+  // Declarations are not written in the order of their locations, so they are
+  // only sorted once they have all been written, by WriteFileDeclIDsMap.
+  Info->DeclIDs.push_back(std::make_pair(Offset, ID));
 }
 
 void ASTRecordWriter::AddDeclarationName(DeclarationName Name) {
@@ -5686,6 +5734,18 @@ void ASTRecordWriter::AddCXXDefinitionData(const CXXRecordDecl *D) {
   Record->push_back(Data.HasDeclaredCopyAssignmentWithConstParam);
   // IsLambda bit is already saved.
 
+  Record->push_back(D->getODRHash());
+
+  // With -fmodules-debuginfo, the object file built from the module describes
+  // its classes in full, and the importers only refer to them.
+  bool ModulesDebugInfo = Writer->WritingModule &&
+                          Writer->getLangOpts().ModulesDebugInfo &&
+                          !D->isDependentContext() &&
+                          D->isExternallyVisible();
+  Record->push_back(ModulesDebugInfo);
+  if (ModulesDebugInfo)
+    Writer->ModularCodegenDecls.push_back(Writer->GetDeclRef(D));
+
   Record->push_back(Data.NumBases);
   if (Data.NumBases > 0)
     AddCXXBaseSpecifiers(Data.bases());
@@ -2226,6 +2226,18 @@ void ASTRecordWriter::AddFunctionDefinition(const FunctionDecl *FD) {
   Writer->ClearSwitchCaseIDs();
 
   assert(FD->doesThisDeclarationHaveABody());
+  // With -fmodules-codegen, the object file built from the module provides
+  // the definitions of its inline functions, so that the translation units
+  // importing it do not each have to emit them.
+  bool ModulesCodegen = false;
+  if (Writer->WritingModule && Writer->getLangOpts().ModulesCodegen &&
+      !FD->isDependentContext() && !FD->hasAttr<AlwaysInlineAttr>()) {
+    GVALinkage Linkage = Writer->Context->GetGVALinkageForFunction(FD);
+    ModulesCodegen = Linkage == GVA_DiscardableODR || Linkage == GVA_StrongODR;
+  }
+  Record->push_back(ModulesCodegen);
+  if (ModulesCodegen)
+    Writer->ModularCodegenDecls.push_back(Writer->GetDeclRef(FD));
   if (auto *CD = dyn_cast<CXXConstructorDecl>(FD)) {
     Record->push_back(CD->getNumCtorInitializers());
     if (CD->getNumCtorInitializers())
@@ -745,6 +745,16 @@ void ASTStmtWriter::VisitInitListExpr(InitListExpr *E) {
   Code = serialization::EXPR_INIT_LIST;
 }
 
+void ASTStmtWriter::VisitCompactArrayInitExpr(CompactArrayInitExpr *E) {
+  VisitExpr(E);
+  Record.AddStmt(E->getSyntacticForm());
+  Record.push_back(E->getNumElements());
+  Record.push_back(E->getElementByteWidth());
+  for (unsigned I = 0, N = E->getNumElements(); I != N; ++I)
+    Record.push_back(E->getElement(I));
+  Code = serialization::EXPR_COMPACT_ARRAY_INIT;
+}
+
 void ASTStmtWriter::VisitDesignatedInitExpr(DesignatedInitExpr *E) {
   VisitExpr(E);
   Record.push_back(E->getNumSubExprs());
@@ -2075,10 +2085,8 @@ void OMPClauseWriter::VisitOMPMapClause(OMPMapClause *C) {
     Record.push_back(N);
   for (auto N : C->all_lists_sizes())
     Record.push_back(N);
-  for (auto &M : C->all_components()) {
+  for (auto &M : C->all_components())
     Record.AddStmt(M.getAssociatedExpression());
-    Record.AddDeclRef(M.getAssociatedDeclaration());
-  }
 }
 
 void OMPClauseWriter::VisitOMPNumTeamsClause(OMPNumTeamsClause *C) {
@@ -2144,10 +2152,8 @@ void OMPClauseWriter::VisitOMPToClause(OMPToClause *C) {
     Record.push_back(N);
   for (auto N : C->all_lists_sizes())
     Record.push_back(N);
-  for (auto &M : C->all_components()) {
+  for (auto &M : C->all_components())
     Record.AddStmt(M.getAssociatedExpression());
-    Record.AddDeclRef(M.getAssociatedDeclaration());
-  }
 }
 
 void OMPClauseWriter::VisitOMPFromClause(OMPFromClause *C) {
@@ -2164,10 +2170,8 @@ void OMPClauseWriter::VisitOMPFromClause(OMPFromClause *C) {
     Record.push_back(N);
   for (auto N : C->all_lists_sizes())
     Record.push_back(N);
-  for (auto &M : C->all_components()) {
+  for (auto &M : C->all_components())
     Record.AddStmt(M.getAssociatedExpression());
-    Record.AddDeclRef(M.getAssociatedDeclaration());
-  }
 }
 
 void OMPClauseWriter::VisitOMPUseDevicePtrClause(OMPUseDevicePtrClause *C) {
@@ -2188,10 +2192,8 @@ void OMPClauseWriter::VisitOMPUseDevicePtrClause(OMPUseDevicePtrClause *C) {
     Record.push_back(N);
   for (auto N : C->all_lists_sizes())
     Record.push_back(N);
-  for (auto &M : C->all_components()) {
+  for (auto &M : C->all_components())
     Record.AddStmt(M.getAssociatedExpression());
-    Record.AddDeclRef(M.getAssociatedDeclaration());
-  }
 }
 
 void OMPClauseWriter::VisitOMPIsDevicePtrClause(OMPIsDevicePtrClause *C) {
@@ -2208,10 +2210,8 @@ void OMPClauseWriter::VisitOMPIsDevicePtrClause(OMPIsDevicePtrClause *C) {
     Record.push_back(N);
   for (auto N : C->all_lists_sizes())
     Record.push_back(N);
-  for (auto &M : C->all_components()) {
+  for (auto &M : C->all_components())
     Record.AddStmt(M.getAssociatedExpression());
-    Record.AddDeclRef(M.getAssociatedDeclaration());
-  }
 }
 
 void OMPClauseWriter::VisitOMPTaskReductionClause(OMPTaskReductionClause *C) {
@@ -27,6 +27,7 @@ ModuleFile::ModuleFile(ModuleKind Kind, unsigned Generation)
     LocalNumIdentifiers(0),
     IdentifierOffsets(nullptr), BaseIdentifierID(0),
     IdentifierTableData(nullptr), IdentifierLookupTable(nullptr),
+    IdentifierFilter(nullptr), IdentifierFilterBits(0),
     LocalNumMacros(0), MacroOffsets(nullptr),
     BasePreprocessedEntityID(0),
     PreprocessedEntityOffsets(nullptr), NumPreprocessedEntities(0),
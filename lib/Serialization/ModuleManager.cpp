@@ -120,9 +120,15 @@ ModuleManager::addModule(StringRef FileName, ModuleKind Type,
         // ModuleManager it must be the same underlying file.
         // FIXME: Because FileManager::getFile() doesn't guarantee that it will
         // give us an open file, this may not be 100% reliable.
+        //
+        // The bitstream does not need a null terminator, so the file is always
+        // mapped rather than read: the ASTUnits of an IDE that load the same
+        // PCH or preamble then share its pages instead of each holding a
+        // private copy.
         Buf = FileMgr.getBufferForFile(ModuleEntry->File,
                                        /*IsVolatile=*/false,
-                                       /*ShouldClose=*/false);
+                                       /*ShouldClose=*/false,
+                                       /*RequiresNullTerminator=*/false);
       }
 
       if (!Buf) {
@@ -25,6 +25,7 @@
 #include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/Support/EndianStream.h"
 #include "llvm/Support/OnDiskHashTable.h"
+#include "llvm/Support/Timer.h"
 
 namespace clang {
 namespace serialization {
@@ -79,6 +80,10 @@ private:
   /// discarded.
   llvm::TinyPtrVector<file_type> PendingOverrides;
 
+  /// \brief The number of lookups that have probed the on-disk tables since
+  /// they were last condensed.
+  unsigned NumLookupsSinceCondense = 0;
+
   struct AsOnDiskTable {
     typedef OnDiskTable *result_type;
     result_type operator()(void *P) const {
@@ -130,13 +135,39 @@ private:
     PendingOverrides.clear();
   }
 
+  /// \brief The number of entries in the on-disk tables.
+  unsigned getNumOnDiskEntries() {
+    unsigned NumEntries = 0;
+    for (auto *ODT : tables())
+      NumEntries += ODT->Table.getNumEntries();
+    return NumEntries;
+  }
+
+  /// \brief Whether the on-disk tables should be merged into the merged table
+  /// before the next lookup.
+  ///
+  /// Merging costs a read of every entry, so it is put off until the lookups
+  /// have spent about as many probes on the extra tables as it would take.
+  /// Tables that are only looked up a few times, like those of most
+  /// namespaces that many modules extend, are then never merged at all.
+  bool shouldCondense() {
+    if (Tables.size() <= static_cast<unsigned>(Info::MaxTables))
+      return false;
+    return uint64_t(NumLookupsSinceCondense) * Tables.size() >=
+           getNumOnDiskEntries();
+  }
+
   void condense() {
+    llvm::TimeRecord Start = llvm::TimeRecord::getCurrentTime(true);
+    unsigned NumTables = 0;
+    unsigned NumEntries = getNumOnDiskEntries();
+    Info StatsInfo = (*tables().begin())->Table.getInfoObj();
+
     MergedTable *Merged = getMergedTable();
     if (!Merged)
       Merged = new MergedTable;
 
     // Read in all the tables and merge them together.
-    // FIXME: Be smarter about which tables we merge.
     for (auto *ODT : tables()) {
       auto &HT = ODT->Table;
       Info &InfoObj = HT.getInfoObj();
@@ -154,10 +185,16 @@ private:
 
       Merged->Files.push_back(ODT->File);
       delete ODT;
+      ++NumTables;
     }
 
     Tables.clear();
     Tables.push_back(Table(Merged).getOpaqueValue());
+    NumLookupsSinceCondense = 0;
+
+    llvm::TimeRecord Elapsed = llvm::TimeRecord::getCurrentTime(false);
+    Elapsed -= Start;
+    StatsInfo.noteCondensed(NumTables, NumEntries, Elapsed.getWallTime());
   }
 
   /// The generator is permitted to read our merged table.
@@ -168,7 +205,8 @@ public:
   MultiOnDiskHashTable() {}
   MultiOnDiskHashTable(MultiOnDiskHashTable &&O)
       : Tables(std::move(O.Tables)),
-        PendingOverrides(std::move(O.PendingOverrides)) {
+        PendingOverrides(std::move(O.PendingOverrides)),
+        NumLookupsSinceCondense(O.NumLookupsSinceCondense) {
     O.Tables.clear();
   }
   MultiOnDiskHashTable &operator=(MultiOnDiskHashTable &&O) {
@@ -178,10 +216,15 @@ public:
     Tables = std::move(O.Tables);
     O.Tables.clear();
     PendingOverrides = std::move(O.PendingOverrides);
+    NumLookupsSinceCondense = O.NumLookupsSinceCondense;
     return *this;
   }
   ~MultiOnDiskHashTable() { clear(); }
 
+  /// \brief The number of tables lookups have to probe, counting the merged
+  /// table.
+  unsigned getNumTables() const { return Tables.size(); }
+
   /// \brief Add the table \p Data loaded from file \p File.
   void add(file_type File, storage_type Data, Info InfoObj = Info()) {
     using namespace llvm::support;
@@ -219,8 +262,9 @@ public:
     if (!PendingOverrides.empty())
       removeOverriddenTables();
 
-    if (Tables.size() > static_cast<unsigned>(Info::MaxTables))
+    if (shouldCondense())
       condense();
+    ++NumLookupsSinceCondense;
 
     internal_key_type Key = Info::GetInternalKey(EKey);
     auto KeyHash = Info::ComputeHash(Key);
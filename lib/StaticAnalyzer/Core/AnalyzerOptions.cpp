@@ -55,6 +55,23 @@ AnalyzerOptions::UserModeKind AnalyzerOptions::getUserMode() {
   return UserMode;
 }
 
+AnalyzerOptions::ExplorationStrategyKind
+AnalyzerOptions::getExplorationStrategy() {
+  if (!ExplorationStrategy.hasValue()) {
+    StringRef StratStr =
+        Config.insert(std::make_pair("exploration_strategy", "dfs"))
+            .first->second;
+    ExplorationStrategy =
+        llvm::StringSwitch<ExplorationStrategyKind>(StratStr)
+            .Case("dfs", ESK_DFS)
+            .Case("bfs", ESK_BFS)
+            .Case("bfs_block_dfs_contents", ESK_BFSBlockDFSContents)
+            .Case("unexplored_first", ESK_UnexploredFirst)
+            .Default(ESK_DFS);
+  }
+  return ExplorationStrategy.getValue();
+}
+
 IPAKind AnalyzerOptions::getIPAMode() {
   if (IPAMode == IPAK_NotSet) {
 
@@ -308,6 +325,13 @@ unsigned AnalyzerOptions::getGraphTrimInterval() {
   return GraphTrimInterval.getValue();
 }
 
+bool AnalyzerOptions::shouldTrimGraphAggressively() {
+  if (!TrimGraphAggressively.hasValue())
+    TrimGraphAggressively =
+        getBooleanOption("graph-trim-aggressive", /*Default=*/false);
+  return TrimGraphAggressively.getValue();
+}
+
 unsigned AnalyzerOptions::getMaxTimesInlineLarge() {
   if (!MaxTimesInlineLarge.hasValue())
     MaxTimesInlineLarge = getOptionAsInteger("max-times-inline-large", 32);
@@ -364,9 +388,59 @@ bool AnalyzerOptions::shouldWidenLoops() {
   return WidenLoops.getValue();
 }
 
+bool AnalyzerOptions::shouldPruneConstantBranches() {
+  if (!PruneConstantBranches.hasValue())
+    PruneConstantBranches =
+        getBooleanOption("prune-constant-branches", /*Default=*/false);
+  return PruneConstantBranches.getValue();
+}
+
+bool AnalyzerOptions::shouldProfileCheckers() {
+  if (!ProfileCheckers.hasValue())
+    ProfileCheckers = getBooleanOption("checker-profile", /*Default=*/false);
+  return ProfileCheckers.getValue();
+}
+
+unsigned AnalyzerOptions::getPurgeStatementInterval() {
+  if (!PurgeStatementInterval.hasValue()) {
+    int Interval = getOptionAsInteger("purge-statement-interval", 1);
+    PurgeStatementInterval = Interval > 1 ? Interval : 1;
+  }
+  return PurgeStatementInterval.getValue();
+}
+
 bool AnalyzerOptions::shouldDisplayNotesAsEvents() {
   if (!DisplayNotesAsEvents.hasValue())
     DisplayNotesAsEvents =
         getBooleanOption("notes-as-events", /*Default=*/false);
   return DisplayNotesAsEvents.getValue();
 }
+
+unsigned AnalyzerOptions::getShardCount() {
+  if (!ShardCount.hasValue())
+    ShardCount = getOptionAsInteger("shard-count", 1);
+  return ShardCount.getValue();
+}
+
+unsigned AnalyzerOptions::getShardIndex() {
+  if (!ShardIndex.hasValue())
+    ShardIndex = getOptionAsInteger("shard-index", 0);
+  return ShardIndex.getValue();
+}
+
+StringRef AnalyzerOptions::getCallSummariesOutputFile() {
+  // Unlike the other options, these are only listed in the configuration when
+  // set, like 'model-path'.
+  ConfigTable::const_iterator I = Config.find("call-summaries-output");
+  return I == Config.end() ? StringRef() : StringRef(I->getValue());
+}
+
+StringRef AnalyzerOptions::getCallSummariesFile() {
+  ConfigTable::const_iterator I = Config.find("call-summaries");
+  return I == Config.end() ? StringRef() : StringRef(I->getValue());
+}
+
+StringRef AnalyzerOptions::getAnalysisCacheFile() {
+  ConfigTable::const_iterator I = Config.find("analysis-cache");
+  return I == Config.end() ? StringRef() : StringRef(I->getValue());
+}
@@ -16,6 +16,7 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/CallEvent.h"
 #include "clang/AST/ParentMap.h"
 #include "clang/Analysis/ProgramPoint.h"
+#include "clang/StaticAnalyzer/Core/PathSensitive/CallSummary.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/CheckerContext.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/DynamicTypeMap.h"
 #include "llvm/ADT/SmallSet.h"
@@ -154,7 +155,8 @@ static void findPtrToConstParams(llvm::SmallSet<unsigned, 4> &PreserveArgs,
 }
 
 ProgramStateRef CallEvent::invalidateRegions(unsigned BlockCount,
-                                             ProgramStateRef Orig) const {
+                                             ProgramStateRef Orig,
+                                             const CallSummary *Summary) const {
   ProgramStateRef Result = (Orig ? Orig : getState());
 
   // Don't invalidate anything if the callee is marked pure/const.
@@ -173,6 +175,10 @@ ProgramStateRef CallEvent::invalidateRegions(unsigned BlockCount,
     findPtrToConstParams(PreserveArgs, *this);
 
   for (unsigned Idx = 0, Count = getNumArgs(); Idx != Count; ++Idx) {
+    // The summary tells which arguments are neither modified nor let escape.
+    if (Summary && !Summary->mayModifyParam(Idx))
+      continue;
+
     // Mark this region for invalidation.  We batch invalidate regions
     // below for efficiency.
     if (PreserveArgs.count(Idx))
@@ -186,11 +192,18 @@ ProgramStateRef CallEvent::invalidateRegions(unsigned BlockCount,
 
   // Invalidate designated regions using the batch invalidation API.
   // NOTE: Even if RegionsToInvalidate is empty, we may still invalidate
-  //  global variables.
+  //  global variables, unless the summary says the callee leaves them alone.
+  //  The store only invalidates globals for calls.
+  const CallEvent *Call = this;
+  if (Summary && !Summary->ModifiesGlobals) {
+    if (ValuesToInvalidate.empty())
+      return Result;
+    Call = nullptr;
+  }
   return Result->invalidateRegions(ValuesToInvalidate, getOriginExpr(),
                                    BlockCount, getLocationContext(),
                                    /*CausedByPointerEscape*/ true,
-                                   /*Symbols=*/nullptr, this, &ETraits);
+                                   /*Symbols=*/nullptr, Call, &ETraits);
 }
 
 ProgramPoint CallEvent::getProgramPoint(bool IsPreVisit,
@@ -0,0 +1,269 @@
+//== CallSummary.cpp - Side effects of functions of other TUs -----*- C++ -*-//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines CallSummary, a compact description of the side effects
+// and the return value of a function, which lets the analyzer evaluate calls
+// to functions defined in other translation units less conservatively.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/StaticAnalyzer/Core/PathSensitive/CallSummary.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Expr.h"
+#include "clang/AST/ExprCXX.h"
+#include "clang/AST/ExprObjC.h"
+#include "clang/AST/ParentMap.h"
+#include "clang/AST/StmtCXX.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace clang;
+using namespace ento;
+
+namespace {
+/// Computes the summary of a function by looking at every use of its
+/// parameters and of globals in its body.
+class CallSummaryBuilder {
+  const FunctionDecl *FD;
+  ASTContext &Ctx;
+  ParentMap PM;
+  CallSummary &Summary;
+
+  bool SawReturn = false;
+  bool AllReturnsNonNull = true;
+  bool AllReturnsConstant = true;
+
+  /// Whether the value of the pointer \p V is only compared or dereferenced
+  /// for reading.
+  bool isReadOnlyPointer(const Expr *V) const;
+
+  /// Whether the object designated by the lvalue \p E is only read, and the
+  /// pointers read from it are only used for reading.
+  bool isReadOnlyLValue(const Expr *E) const;
+
+  void markUnknown() {
+    Summary.ModifiedParams = ~0u;
+    Summary.ModifiesGlobals = true;
+  }
+
+  void visitDeclRef(const DeclRefExpr *DRE);
+  void visitReturn(const ReturnStmt *RS);
+
+public:
+  CallSummaryBuilder(const FunctionDecl *FD, CallSummary &Summary)
+      : FD(FD), Ctx(FD->getASTContext()), PM(FD->getBody()), Summary(Summary) {
+  }
+
+  void visit(const Stmt *S);
+  void finish();
+};
+} // end anonymous namespace
+
+static bool isSubExpr(const Expr *Sub, const Expr *E) {
+  return Sub && Sub->IgnoreParens() == E;
+}
+
+bool CallSummaryBuilder::isReadOnlyPointer(const Expr *V) const {
+  const Stmt *P = PM.getParentIgnoreParens(V);
+  if (!P)
+    return false;
+
+  if (const auto *ICE = dyn_cast<ImplicitCastExpr>(P)) {
+    switch (ICE->getCastKind()) {
+    case CK_NoOp:
+    case CK_BitCast:
+      return isReadOnlyPointer(ICE);
+    case CK_PointerToBoolean:
+      return true;
+    default:
+      return false;
+    }
+  }
+  if (const auto *UO = dyn_cast<UnaryOperator>(P)) {
+    if (UO->getOpcode() == UO_Deref)
+      return isReadOnlyLValue(UO);
+    return UO->getOpcode() == UO_LNot;
+  }
+  if (const auto *ASE = dyn_cast<ArraySubscriptExpr>(P))
+    return isSubExpr(ASE->getBase(), V) && isReadOnlyLValue(ASE);
+  if (const auto *ME = dyn_cast<MemberExpr>(P))
+    return ME->isArrow() && isReadOnlyLValue(ME);
+  if (const auto *BO = dyn_cast<BinaryOperator>(P))
+    return BO->isComparisonOp() || BO->isLogicalOp();
+  return false;
+}
+
+bool CallSummaryBuilder::isReadOnlyLValue(const Expr *E) const {
+  const Stmt *P = PM.getParentIgnoreParens(E);
+  if (!P)
+    return false;
+
+  if (const auto *ICE = dyn_cast<ImplicitCastExpr>(P)) {
+    switch (ICE->getCastKind()) {
+    case CK_NoOp:
+      return isReadOnlyLValue(ICE);
+    case CK_ArrayToPointerDecay:
+      return isReadOnlyPointer(ICE);
+    case CK_LValueToRValue: {
+      QualType T = ICE->getType();
+      if (T->isAnyPointerType() || T->isBlockPointerType())
+        return isReadOnlyPointer(ICE);
+      // Pointers read as part of an aggregate may be written through.
+      return T->isScalarType();
+    }
+    default:
+      return false;
+    }
+  }
+  if (const auto *ME = dyn_cast<MemberExpr>(P))
+    return !ME->isArrow() && isReadOnlyLValue(ME);
+  return false;
+}
+
+void CallSummaryBuilder::visitDeclRef(const DeclRefExpr *DRE) {
+  const auto *VD = dyn_cast<VarDecl>(DRE->getDecl());
+  if (!VD)
+    return;
+
+  if (const auto *PVD = dyn_cast<ParmVarDecl>(VD)) {
+    if (PVD->getDeclContext() != FD)
+      return;
+    // Nothing the callee does to a scalar copy can be seen by the caller.
+    QualType T = PVD->getType();
+    if (T->isScalarType() && !T->isAnyPointerType() &&
+        !T->isBlockPointerType())
+      return;
+    unsigned Idx = PVD->getFunctionScopeIndex();
+    if (Idx < CallSummary::MaxParams && !isReadOnlyLValue(DRE))
+      Summary.ModifiedParams |= 1u << Idx;
+    return;
+  }
+
+  if ((VD->hasGlobalStorage() || VD->getType()->isReferenceType()) &&
+      !isReadOnlyLValue(DRE))
+    Summary.ModifiesGlobals = true;
+}
+
+void CallSummaryBuilder::visitReturn(const ReturnStmt *RS) {
+  const Expr *RV = RS->getRetValue();
+  if (!RV)
+    return;
+  SawReturn = true;
+
+  const Expr *Stripped = RV->IgnoreParenImpCasts();
+  const auto *UO = dyn_cast<UnaryOperator>(Stripped);
+  if (!(UO && UO->getOpcode() == UO_AddrOf) && !isa<StringLiteral>(Stripped))
+    AllReturnsNonNull = false;
+
+  llvm::APSInt Value;
+  if (!AllReturnsConstant || !RV->getType()->isIntegralOrEnumerationType() ||
+      RV->isValueDependent() || !RV->EvaluateAsInt(Value, Ctx) ||
+      (Value.isUnsigned() ? Value.getActiveBits() > 63
+                          : Value.getMinSignedBits() > 64)) {
+    AllReturnsConstant = false;
+    return;
+  }
+
+  int64_t V = Value.getExtValue();
+  if (!Summary.HasReturnRange) {
+    Summary.HasReturnRange = true;
+    Summary.ReturnMin = Summary.ReturnMax = V;
+  } else {
+    Summary.ReturnMin = std::min(Summary.ReturnMin, V);
+    Summary.ReturnMax = std::max(Summary.ReturnMax, V);
+  }
+}
+
+void CallSummaryBuilder::visit(const Stmt *S) {
+  if (!S)
+    return;
+
+  if (const auto *DRE = dyn_cast<DeclRefExpr>(S)) {
+    visitDeclRef(DRE);
+  } else if (const auto *RS = dyn_cast<ReturnStmt>(S)) {
+    visitReturn(RS);
+  } else if (isa<CallExpr>(S) || isa<CXXConstructExpr>(S) ||
+             isa<CXXNewExpr>(S) || isa<CXXDeleteExpr>(S) ||
+             isa<CXXThrowExpr>(S) || isa<ObjCMessageExpr>(S)) {
+    // The callee may do anything to globals, and the arguments are checked
+    // like any other use of the parameters.
+    Summary.ModifiesGlobals = true;
+  } else if (const auto *CE = dyn_cast<CastExpr>(S)) {
+    // A pointer made from an integer may point anywhere.
+    if (CE->getCastKind() == CK_IntegralToPointer)
+      Summary.ModifiesGlobals = true;
+  } else if (isa<AsmStmt>(S) || isa<BlockExpr>(S) || isa<LambdaExpr>(S) ||
+             isa<CXXThisExpr>(S)) {
+    markUnknown();
+    return;
+  }
+
+  for (const Stmt *Child : S->children())
+    visit(Child);
+}
+
+void CallSummaryBuilder::finish() {
+  if (!SawReturn || !AllReturnsConstant)
+    Summary.HasReturnRange = false;
+  Summary.ReturnsNonNull = SawReturn && AllReturnsNonNull &&
+                           FD->getReturnType()->isAnyPointerType();
+}
+
+CallSummary CallSummary::compute(const FunctionDecl *FD) {
+  CallSummary Summary;
+  const Stmt *Body = FD->getBody();
+  if (!Body || FD->isVariadic())
+    return Summary;
+
+  Summary.ModifiedParams = 0;
+  Summary.ModifiesGlobals = false;
+
+  CallSummaryBuilder Builder(FD, Summary);
+  Builder.visit(Body);
+  Builder.finish();
+  return Summary;
+}
+
+void CallSummary::print(raw_ostream &OS, StringRef USR) const {
+  OS << USR << '\t';
+  OS.write_hex(ModifiedParams);
+  OS << '\t' << (ModifiesGlobals ? 'g' : '-') << (ReturnsNonNull ? 'n' : '-');
+  if (HasReturnRange)
+    OS << '\t' << ReturnMin << '\t' << ReturnMax;
+  OS << '\n';
+}
+
+bool CallSummary::parse(StringRef Buffer,
+                        llvm::StringMap<CallSummary> &Summaries) {
+  SmallVector<StringRef, 16> Lines;
+  Buffer.split(Lines, '\n', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  for (StringRef Line : Lines) {
+    SmallVector<StringRef, 5> Fields;
+    Line.split(Fields, '\t');
+    if (Fields.size() != 3 && Fields.size() != 5)
+      return false;
+
+    CallSummary Summary;
+    if (Fields[0].empty() || Fields[1].getAsInteger(16, Summary.ModifiedParams)
+        || Fields[2].size() != 2)
+      return false;
+    Summary.ModifiesGlobals = Fields[2][0] == 'g';
+    Summary.ReturnsNonNull = Fields[2][1] == 'n';
+    if (Fields.size() == 5) {
+      Summary.HasReturnRange = true;
+      if (Fields[3].getAsInteger(10, Summary.ReturnMin) ||
+          Fields[4].getAsInteger(10, Summary.ReturnMax) ||
+          Summary.ReturnMin > Summary.ReturnMax)
+        return false;
+    }
+    Summaries[Fields[0]] = Summary;
+  }
+  return true;
+}
@@ -17,10 +17,150 @@
 #include "clang/StaticAnalyzer/Core/Checker.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/CallEvent.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/CheckerContext.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <chrono>
 
 using namespace clang;
 using namespace ento;
 
+//===----------------------------------------------------------------------===//
+// Checker profiling.
+//===----------------------------------------------------------------------===//
+
+namespace {
+enum CallbackKind {
+  CB_ASTDecl,
+  CB_ASTCodeBody,
+  CB_PreStmt,
+  CB_PostStmt,
+  CB_PreObjCMessage,
+  CB_ObjCMessageNil,
+  CB_PostObjCMessage,
+  CB_PreCall,
+  CB_PostCall,
+  CB_Location,
+  CB_Bind,
+  CB_EndAnalysis,
+  CB_BeginFunction,
+  CB_EndFunction,
+  CB_BranchCondition,
+  CB_LiveSymbols,
+  CB_DeadSymbols,
+  CB_RegionChanges,
+  CB_PointerEscape,
+  CB_EvalAssume,
+  CB_EvalCall,
+  CB_EndOfTranslationUnit
+};
+} // end anonymous namespace
+
+static const char *getCallbackName(unsigned Kind) {
+  static const char *const Names[] = {
+    "ASTDecl", "ASTCodeBody", "PreStmt", "PostStmt", "PreObjCMessage",
+    "ObjCMessageNil", "PostObjCMessage", "PreCall", "PostCall", "Location",
+    "Bind", "EndAnalysis", "BeginFunction", "EndFunction", "BranchCondition",
+    "LiveSymbols", "DeadSymbols", "RegionChanges", "PointerEscape",
+    "EvalAssume", "EvalCall", "EndOfTranslationUnit"
+  };
+  return Names[Kind];
+}
+
+namespace clang {
+namespace ento {
+class CheckerProfile {
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Entry {
+    Clock::duration Time;
+    unsigned Calls;
+
+    Entry() : Time(), Calls(0) {}
+  };
+
+  typedef std::pair<const CheckerBase *, unsigned> KeyTy;
+  llvm::DenseMap<KeyTy, Entry> Entries;
+
+  /// The time spent in the callbacks run by the callback being measured,
+  /// which is not counted as its own.
+  Clock::duration NestedTime;
+
+  CheckerProfile() : NestedTime() {}
+};
+} // end ento namespace
+} // end clang namespace
+
+namespace {
+/// Measures a call to a checker callback, when profiling is on.
+class ProfiledCall {
+  CheckerProfile *Profile;
+  const CheckerBase *Checker;
+  CallbackKind Kind;
+  CheckerProfile::Clock::time_point Start;
+  CheckerProfile::Clock::duration OuterNestedTime;
+
+public:
+  ProfiledCall(CheckerProfile *Profile, const CheckerBase *Checker,
+               CallbackKind Kind)
+      : Profile(Profile), Checker(Checker), Kind(Kind) {
+    if (!Profile)
+      return;
+    OuterNestedTime = Profile->NestedTime;
+    Profile->NestedTime = CheckerProfile::Clock::duration();
+    Start = CheckerProfile::Clock::now();
+  }
+
+  ~ProfiledCall() {
+    if (!Profile)
+      return;
+    CheckerProfile::Clock::duration Time =
+        CheckerProfile::Clock::now() - Start;
+    CheckerProfile::Entry &E = Profile->Entries[std::make_pair(Checker, Kind)];
+    E.Time += Time - Profile->NestedTime;
+    ++E.Calls;
+    Profile->NestedTime = OuterNestedTime + Time;
+  }
+};
+} // end anonymous namespace
+
+CheckerManager::CheckerManager(const LangOptions &langOpts,
+                               AnalyzerOptionsRef AOptions)
+    : LangOpts(langOpts), AOptions(std::move(AOptions)) {
+  if (this->AOptions->shouldProfileCheckers())
+    Profile.reset(new CheckerProfile());
+}
+
+void CheckerManager::printProfile(raw_ostream &OS) const {
+  if (!Profile)
+    return;
+
+  typedef std::pair<CheckerProfile::KeyTy, CheckerProfile::Entry> Row;
+  std::vector<Row> Rows(Profile->Entries.begin(), Profile->Entries.end());
+  std::sort(Rows.begin(), Rows.end(), [](const Row &LHS, const Row &RHS) {
+    if (LHS.second.Time != RHS.second.Time)
+      return LHS.second.Time > RHS.second.Time;
+    int Cmp = LHS.first.first->getTagDescription().compare(
+        RHS.first.first->getTagDescription());
+    if (Cmp != 0)
+      return Cmp < 0;
+    return LHS.first.second < RHS.first.second;
+  });
+
+  OS << "===" << std::string(73, '-') << "===\n"
+     << "                        Checker callback profile\n"
+     << "===" << std::string(73, '-') << "===\n"
+     << "   Time (s)      Calls  Callback              Checker\n";
+  for (const Row &R : Rows) {
+    double Seconds = std::chrono::duration<double>(R.second.Time).count();
+    StringRef Name = R.first.first->getTagDescription();
+    OS << llvm::format("%11.4f %10u  %-20s  ", Seconds, R.second.Calls,
+                       getCallbackName(R.first.second))
+       << (Name.empty() ? "<unnamed>" : Name) << '\n';
+  }
+}
+
 bool CheckerManager::hasPathSensitiveCheckers() const {
   return !StmtCheckers.empty()              ||
          !PreObjCMessageCheckers.empty()    ||
@@ -74,16 +214,20 @@ void CheckerManager::runCheckersOnASTDecl(const Decl *D, AnalysisManager& mgr,
 
   assert(checkers);
   for (CachedDeclCheckers::iterator
-         I = checkers->begin(), E = checkers->end(); I != E; ++I)
+         I = checkers->begin(), E = checkers->end(); I != E; ++I) {
+    ProfiledCall PC(Profile.get(), I->Checker, CB_ASTDecl);
     (*I)(D, mgr, BR);
+  }
 }
 
 void CheckerManager::runCheckersOnASTBody(const Decl *D, AnalysisManager& mgr,
                                           BugReporter &BR) {
   assert(D && D->hasBody());
 
-  for (unsigned i = 0, e = BodyCheckers.size(); i != e; ++i)
+  for (unsigned i = 0, e = BodyCheckers.size(); i != e; ++i) {
+    ProfiledCall PC(Profile.get(), BodyCheckers[i].Checker, CB_ASTCodeBody);
     BodyCheckers[i](D, mgr, BR);
+  }
 }
 
 //===----------------------------------------------------------------------===//
@@ -93,7 +237,9 @@ void CheckerManager::runCheckersOnASTBody(const Decl *D, AnalysisManager& mgr,
 template <typename CHECK_CTX>
 static void expandGraphWithCheckers(CHECK_CTX checkCtx,
                                     ExplodedNodeSet &Dst,
-                                    const ExplodedNodeSet &Src) {
+                                    const ExplodedNodeSet &Src,
+                                    CheckerProfile *Profile,
+                                    CallbackKind Kind) {
   const NodeBuilderContext &BldrCtx = checkCtx.Eng.getBuilderContext();
   if (Src.empty())
     return;
@@ -120,6 +266,7 @@ static void expandGraphWithCheckers(CHECK_CTX checkCtx,
     NodeBuilder B(*PrevSet, *CurrSet, BldrCtx);
     for (ExplodedNodeSet::iterator NI = PrevSet->begin(), NE = PrevSet->end();
          NI != NE; ++NI) {
+      ProfiledCall PC(Profile, I->Checker, Kind);
       checkCtx.runChecker(*I, B, *NI);
     }
 
@@ -171,7 +318,8 @@ void CheckerManager::runCheckersForStmt(bool isPreVisit,
                                         bool WasInlined) {
   CheckStmtContext C(isPreVisit, getCachedStmtCheckersFor(S, isPreVisit),
                      S, Eng, WasInlined);
-  expandGraphWithCheckers(C, Dst, Src);
+  expandGraphWithCheckers(C, Dst, Src, Profile.get(),
+                          isPreVisit ? CB_PreStmt : CB_PostStmt);
 }
 
 namespace {
@@ -226,7 +374,12 @@ void CheckerManager::runCheckersForObjCMessage(ObjCMessageVisitKind visitKind,
                                                bool WasInlined) {
   auto &checkers = getObjCMessageCheckers(visitKind);
   CheckObjCMessageContext C(visitKind, checkers, msg, Eng, WasInlined);
-  expandGraphWithCheckers(C, Dst, Src);
+  CallbackKind Kind = CB_PostObjCMessage;
+  if (visitKind == ObjCMessageVisitKind::Pre)
+    Kind = CB_PreObjCMessage;
+  else if (visitKind == ObjCMessageVisitKind::MessageNil)
+    Kind = CB_ObjCMessageNil;
+  expandGraphWithCheckers(C, Dst, Src, Profile.get(), Kind);
 }
 
 const std::vector<CheckerManager::CheckObjCMessageFunc> &
@@ -282,7 +435,8 @@ void CheckerManager::runCheckersForCallEvent(bool isPreVisit,
                      isPreVisit ? PreCallCheckers
                                 : PostCallCheckers,
                      Call, Eng, WasInlined);
-  expandGraphWithCheckers(C, Dst, Src);
+  expandGraphWithCheckers(C, Dst, Src, Profile.get(),
+                          isPreVisit ? CB_PreCall : CB_PostCall);
 }
 
 namespace {
@@ -329,7 +483,7 @@ void CheckerManager::runCheckersForLocation(ExplodedNodeSet &Dst,
                                             ExprEngine &Eng) {
   CheckLocationContext C(LocationCheckers, location, isLoad, NodeEx,
                          BoundEx, Eng);
-  expandGraphWithCheckers(C, Dst, Src);
+  expandGraphWithCheckers(C, Dst, Src, Profile.get(), CB_Location);
 }
 
 namespace {
@@ -367,14 +521,17 @@ void CheckerManager::runCheckersForBind(ExplodedNodeSet &Dst,
                                         const Stmt *S, ExprEngine &Eng,
                                         const ProgramPoint &PP) {
   CheckBindContext C(BindCheckers, location, val, S, Eng, PP);
-  expandGraphWithCheckers(C, Dst, Src);
+  expandGraphWithCheckers(C, Dst, Src, Profile.get(), CB_Bind);
 }
 
 void CheckerManager::runCheckersForEndAnalysis(ExplodedGraph &G,
                                                BugReporter &BR,
                                                ExprEngine &Eng) {
-  for (unsigned i = 0, e = EndAnalysisCheckers.size(); i != e; ++i)
+  for (unsigned i = 0, e = EndAnalysisCheckers.size(); i != e; ++i) {
+    ProfiledCall PC(Profile.get(), EndAnalysisCheckers[i].Checker,
+                    CB_EndAnalysis);
     EndAnalysisCheckers[i](G, BR, Eng);
+  }
 }
 
 namespace {
@@ -408,7 +565,7 @@ void CheckerManager::runCheckersForBeginFunction(ExplodedNodeSet &Dst,
   ExplodedNodeSet Src;
   Src.insert(Pred);
   CheckBeginFunctionContext C(BeginFunctionCheckers, Eng, L);
-  expandGraphWithCheckers(C, Dst, Src);
+  expandGraphWithCheckers(C, Dst, Src, Profile.get(), CB_BeginFunction);
 }
 
 /// \brief Run checkers for end of path.
@@ -429,6 +586,7 @@ void CheckerManager::runCheckersForEndFunction(NodeBuilderContext &BC,
     const ProgramPoint &L = BlockEntrance(BC.Block,
                                           Pred->getLocationContext(),
                                           checkFn.Checker);
+    ProfiledCall PC(Profile.get(), checkFn.Checker, CB_EndFunction);
     CheckerContext C(Bldr, Eng, Pred, L);
     checkFn(C);
   }
@@ -466,14 +624,17 @@ void CheckerManager::runCheckersForBranchCondition(const Stmt *Condition,
   ExplodedNodeSet Src;
   Src.insert(Pred);
   CheckBranchConditionContext C(BranchConditionCheckers, Condition, Eng);
-  expandGraphWithCheckers(C, Dst, Src);
+  expandGraphWithCheckers(C, Dst, Src, Profile.get(), CB_BranchCondition);
 }
 
 /// \brief Run checkers for live symbols.
 void CheckerManager::runCheckersForLiveSymbols(ProgramStateRef state,
                                                SymbolReaper &SymReaper) {
-  for (unsigned i = 0, e = LiveSymbolsCheckers.size(); i != e; ++i)
+  for (unsigned i = 0, e = LiveSymbolsCheckers.size(); i != e; ++i) {
+    ProfiledCall PC(Profile.get(), LiveSymbolsCheckers[i].Checker,
+                    CB_LiveSymbols);
     LiveSymbolsCheckers[i](state, SymReaper);
+  }
 }
 
 namespace {
@@ -515,7 +676,7 @@ void CheckerManager::runCheckersForDeadSymbols(ExplodedNodeSet &Dst,
                                                ExprEngine &Eng,
                                                ProgramPoint::Kind K) {
   CheckDeadSymbolsContext C(DeadSymbolsCheckers, SymReaper, S, Eng, K);
-  expandGraphWithCheckers(C, Dst, Src);
+  expandGraphWithCheckers(C, Dst, Src, Profile.get(), CB_DeadSymbols);
 }
 
 /// \brief Run checkers for region changes.
@@ -530,6 +691,8 @@ CheckerManager::runCheckersForRegionChanges(ProgramStateRef state,
     // bail out.
     if (!state)
       return nullptr;
+    ProfiledCall PC(Profile.get(), RegionChangesCheckers[i].Checker,
+                    CB_RegionChanges);
     state = RegionChangesCheckers[i](state, invalidated,
                                      ExplicitRegions, Regions, Call);
   }
@@ -552,6 +715,8 @@ CheckerManager::runCheckersForPointerEscape(ProgramStateRef State,
       //  way), bail out.
       if (!State)
         return nullptr;
+      ProfiledCall PC(Profile.get(), PointerEscapeCheckers[i].Checker,
+                      CB_PointerEscape);
       State = PointerEscapeCheckers[i](State, Escaped, Call, Kind, ETraits);
     }
   return State;
@@ -566,6 +731,8 @@ CheckerManager::runCheckersForEvalAssume(ProgramStateRef state,
     // bail out.
     if (!state)
       return nullptr;
+    ProfiledCall PC(Profile.get(), EvalAssumeCheckers[i].Checker,
+                    CB_EvalAssume);
     state = EvalAssumeCheckers[i](state, Cond, Assumption);
   }
   return state;
@@ -597,6 +764,7 @@ void CheckerManager::runCheckersForEvalCall(ExplodedNodeSet &Dst,
       { // CheckerContext generates transitions(populates checkDest) on
         // destruction, so introduce the scope to make sure it gets properly
         // populated.
+        ProfiledCall PC(Profile.get(), EI->Checker, CB_EvalCall);
         CheckerContext C(B, Eng, Pred, L);
         evaluated = (*EI)(CE, C);
       }
@@ -624,8 +792,11 @@ void CheckerManager::runCheckersOnEndOfTranslationUnit(
                                                   const TranslationUnitDecl *TU,
                                                   AnalysisManager &mgr,
                                                   BugReporter &BR) {
-  for (unsigned i = 0, e = EndOfTranslationUnitCheckers.size(); i != e; ++i)
+  for (unsigned i = 0, e = EndOfTranslationUnitCheckers.size(); i != e; ++i) {
+    ProfiledCall PC(Profile.get(), EndOfTranslationUnitCheckers[i].Checker,
+                    CB_EndOfTranslationUnit);
     EndOfTranslationUnitCheckers[i](TU, mgr, BR);
+  }
 }
 
 void CheckerManager::runCheckersForPrintState(raw_ostream &Out,
@@ -20,6 +20,7 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/ExprEngine.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Support/Casting.h"
+#include <algorithm>
 
 using namespace clang;
 using namespace ento;
@@ -156,6 +157,128 @@ WorkList* WorkList::makeBFSBlockDFSContents() {
   return new BFSBlockDFSContents();
 }
 
+namespace {
+  /// Explores first the nodes entering the blocks that were entered the
+  /// fewest times so far, on any path, and the contents of each block in
+  /// depth-first order. Ties are broken by the number of times the path of
+  /// the node entered the block, then by preferring the most recent node.
+  class UnexploredFirst : public WorkList {
+    typedef std::pair<const CFGBlock *, const StackFrameContext *>
+        BlockInContext;
+
+    struct Entrance {
+      WorkListUnit U;
+      BlockInContext Block;
+      unsigned NumEntered;
+      unsigned NumEnteredOnPath;
+      unsigned Order;
+    };
+
+    /// Whether \p LHS is explored after \p RHS.
+    static bool exploredAfter(const Entrance &LHS, const Entrance &RHS) {
+      if (LHS.NumEntered != RHS.NumEntered)
+        return LHS.NumEntered > RHS.NumEntered;
+      if (LHS.NumEnteredOnPath != RHS.NumEnteredOnPath)
+        return LHS.NumEnteredOnPath > RHS.NumEnteredOnPath;
+      return LHS.Order < RHS.Order;
+    }
+
+    /// The number of times each block was entered, on any path.
+    llvm::DenseMap<BlockInContext, unsigned> NumEntered;
+    /// The heap of the nodes entering a block.
+    std::vector<Entrance> Entrances;
+    SmallVector<WorkListUnit,20> Stack;
+    unsigned NextOrder;
+
+  public:
+    UnexploredFirst() : NextOrder(0) {}
+
+    bool hasWork() const override {
+      return !Entrances.empty() || !Stack.empty();
+    }
+
+    void enqueue(const WorkListUnit& U) override {
+      Optional<BlockEntrance> BE =
+          U.getNode()->getLocation().getAs<BlockEntrance>();
+      if (!BE) {
+        Stack.push_back(U);
+        return;
+      }
+
+      const StackFrameContext *SFC =
+          U.getNode()->getLocationContext()->getCurrentStackFrame();
+      Entrance E = {U, BlockInContext(BE->getBlock(), SFC),
+                    NumEntered.lookup(BlockInContext(BE->getBlock(), SFC)),
+                    U.getBlockCounter().getNumVisited(
+                        SFC, BE->getBlock()->getBlockID()),
+                    NextOrder++};
+      Entrances.push_back(E);
+      std::push_heap(Entrances.begin(), Entrances.end(), exploredAfter);
+    }
+
+    WorkListUnit dequeue() override {
+      // Process all basic blocks to completion.
+      if (!Stack.empty()) {
+        const WorkListUnit& U = Stack.back();
+        Stack.pop_back(); // This technically "invalidates" U, but we are fine.
+        return U;
+      }
+
+      assert(!Entrances.empty());
+      while (true) {
+        std::pop_heap(Entrances.begin(), Entrances.end(), exploredAfter);
+        Entrance &E = Entrances.back();
+        // The block may have been entered since the node was queued; if so,
+        // queue the node again at its current priority.
+        unsigned &Count = NumEntered[E.Block];
+        if (Count != E.NumEntered) {
+          E.NumEntered = Count;
+          std::push_heap(Entrances.begin(), Entrances.end(), exploredAfter);
+          continue;
+        }
+        ++Count;
+        WorkListUnit U = E.U;
+        Entrances.pop_back();
+        return U;
+      }
+    }
+
+    bool visitItemsInWorkList(Visitor &V) override {
+      for (SmallVectorImpl<WorkListUnit>::iterator
+           I = Stack.begin(), E = Stack.end(); I != E; ++I) {
+        if (V.visit(*I))
+          return true;
+      }
+      for (const Entrance &E : Entrances) {
+        if (V.visit(E.U))
+          return true;
+      }
+      return false;
+    }
+  };
+} // end anonymous namespace
+
+WorkList *WorkList::makeUnexploredFirst() { return new UnexploredFirst(); }
+
+static WorkList *generateWorkList(AnalyzerOptions &Opts) {
+  switch (Opts.getExplorationStrategy()) {
+  case AnalyzerOptions::ESK_DFS:
+    return WorkList::makeDFS();
+  case AnalyzerOptions::ESK_BFS:
+    return WorkList::makeBFS();
+  case AnalyzerOptions::ESK_BFSBlockDFSContents:
+    return WorkList::makeBFSBlockDFSContents();
+  case AnalyzerOptions::ESK_UnexploredFirst:
+    return WorkList::makeUnexploredFirst();
+  }
+  llvm_unreachable("Unknown exploration strategy");
+}
+
+CoreEngine::CoreEngine(SubEngine &subengine, FunctionSummariesTy *FS,
+                       AnalyzerOptions &Opts)
+    : SubEng(subengine), WList(generateWorkList(Opts)),
+      BCounterFactory(G.getAllocator()), FunctionSummaries(FS) {}
+
 //===----------------------------------------------------------------------===//
 // Core analysis engine.
 //===----------------------------------------------------------------------===//
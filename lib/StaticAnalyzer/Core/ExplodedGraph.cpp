@@ -24,6 +24,10 @@
 using namespace clang;
 using namespace ento;
 
+#define DEBUG_TYPE "ExplodedGraph"
+
+STATISTIC(NumReclaimedNodes, "The # of nodes reclaimed from exploded graphs.");
+
 //===----------------------------------------------------------------------===//
 // Node auditing.
 //===----------------------------------------------------------------------===//
@@ -46,7 +50,7 @@ void ExplodedNode::SetAuditor(ExplodedNode::Auditor* A) {
 //===----------------------------------------------------------------------===//
 
 ExplodedGraph::ExplodedGraph()
-  : NumNodes(0), ReclaimNodeInterval(0) {}
+  : NumNodes(0), ReclaimNodeInterval(0), AggressiveReclamation(false) {}
 
 ExplodedGraph::~ExplodedGraph() {}
 
@@ -91,6 +95,9 @@ bool ExplodedGraph::shouldCollect(const ExplodedNode *node) {
   // (10) The successor is neither a CallExpr StmtPoint nor a CallEnter or
   //      PreImplicitCall (so that we would be able to find it when retrying a
   //      call with no inlining).
+  //
+  // With aggressive reclamation, conditions 8 and 9, which only keep the
+  // nodes that make path diagnostics more precise, are not checked.
   // FIXME: It may be safe to reclaim PreCall and PostCall nodes as well.
 
   // Conditions 1 and 2.
@@ -132,19 +139,21 @@ bool ExplodedGraph::shouldCollect(const ExplodedNode *node) {
   if (!Ex)
     return false;
 
-  // Condition 8.
-  // Do not collect nodes for "interesting" lvalue expressions since they are
-  // used extensively for generating path diagnostics.
-  if (isInterestingLValueExpr(Ex))
-    return false;
+  if (!AggressiveReclamation) {
+    // Condition 8.
+    // Do not collect nodes for "interesting" lvalue expressions since they
+    // are used extensively for generating path diagnostics.
+    if (isInterestingLValueExpr(Ex))
+      return false;
 
-  // Condition 9.
-  // Do not collect nodes for non-consumed Stmt or Expr to ensure precise
-  // diagnostic generation; specifically, so that we could anchor arrows
-  // pointing to the beginning of statements (as written in code).
-  ParentMap &PM = progPoint.getLocationContext()->getParentMap();
-  if (!PM.isConsumedExpr(Ex))
-    return false;
+    // Condition 9.
+    // Do not collect nodes for non-consumed Stmt or Expr to ensure precise
+    // diagnostic generation; specifically, so that we could anchor arrows
+    // pointing to the beginning of statements (as written in code).
+    ParentMap &PM = progPoint.getLocationContext()->getParentMap();
+    if (!PM.isConsumedExpr(Ex))
+      return false;
+  }
 
   // Condition 10.
   const ProgramPoint SuccLoc = succ->getLocation();
@@ -172,6 +181,7 @@ void ExplodedGraph::collectNode(ExplodedNode *node) {
   FreeNodes.push_back(node);
   Nodes.RemoveNode(node);
   --NumNodes;
+  ++NumReclaimedNodes;
   node->~ExplodedNode();
 }
 
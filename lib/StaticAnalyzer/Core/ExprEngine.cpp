@@ -19,6 +19,7 @@
 #include "clang/AST/ParentMap.h"
 #include "clang/AST/StmtCXX.h"
 #include "clang/AST/StmtObjC.h"
+#include "clang/Analysis/Analyses/ConstantBranches.h"
 #include "clang/Basic/Builtins.h"
 #include "clang/Basic/PrettyStackTrace.h"
 #include "clang/Basic/SourceManager.h"
@@ -51,6 +52,9 @@ STATISTIC(NumMaxBlockCountReachedInInlined,
             "an inlined function");
 STATISTIC(NumTimesRetriedWithoutInlining,
             "The # of times we re-evaluated a call without inlining");
+STATISTIC(NumPrunedConstantBranches,
+            "The # of branches evaluated with a condition known to be "
+            "constant");
 
 typedef std::pair<const CXXBindTemporaryExpr *, const StackFrameContext *>
     CXXBindTemporaryContext;
@@ -73,7 +77,7 @@ ExprEngine::ExprEngine(AnalysisManager &mgr, bool gcEnabled,
                        InliningModes HowToInlineIn)
   : AMgr(mgr),
     AnalysisDeclContexts(mgr.getAnalysisDeclContextManager()),
-    Engine(*this, FS),
+    Engine(*this, FS, mgr.getAnalyzerOptions()),
     G(Engine.getGraph()),
     StateMgr(getContext(), mgr.getStoreManagerCreator(),
              mgr.getConstraintManagerCreator(), G.getAllocator(),
@@ -89,7 +93,8 @@ ExprEngine::ExprEngine(AnalysisManager &mgr, bool gcEnabled,
   unsigned TrimInterval = mgr.options.getGraphTrimInterval();
   if (TrimInterval != 0) {
     // Enable eager node reclaimation when constructing the ExplodedGraph.
-    G.enableNodeReclamation(TrimInterval);
+    G.enableNodeReclamation(TrimInterval,
+                            mgr.options.shouldTrimGraphAggressively());
   }
 }
 
@@ -329,6 +334,7 @@ void ExprEngine::processCFGElement(const CFGElement E, ExplodedNode *Pred,
 
 static bool shouldRemoveDeadBindings(AnalysisManager &AMgr,
                                      const CFGStmt S,
+                                     unsigned StmtIdx,
                                      const ExplodedNode *Pred,
                                      const LocationContext *LC) {
 
@@ -336,18 +342,28 @@ static bool shouldRemoveDeadBindings(AnalysisManager &AMgr,
   if (AMgr.options.AnalysisPurgeOpt == PurgeNone)
     return false;
 
+  unsigned Interval = AMgr.options.getPurgeStatementInterval();
+
   // Is this the beginning of a basic block?
   if (Pred->getLocation().getAs<BlockEntrance>())
     return true;
 
-  // Is this on a non-expression?
-  if (!isa<Expr>(S.getStmt()))
-    return true;
+  // Are we only purging once per basic block?
+  if (AMgr.options.AnalysisPurgeOpt == PurgeBlock)
+    return false;
 
   // Run before processing a call.
   if (CallEvent::isCallStmt(S.getStmt()))
     return true;
 
+  // Are we batching the statements in between?
+  if (Interval > 1 && StmtIdx % Interval != 0)
+    return false;
+
+  // Is this on a non-expression?
+  if (!isa<Expr>(S.getStmt()))
+    return true;
+
   // Is this an expression that is consumed by another expression?  If so,
   // postpone cleaning out the state.
   ParentMap &PM = LC->getAnalysisDeclContext()->getParentMap();
@@ -448,7 +464,8 @@ void ExprEngine::ProcessStmt(const CFGStmt S,
 
   // Remove dead bindings and symbols.
   ExplodedNodeSet CleanedStates;
-  if (shouldRemoveDeadBindings(AMgr, S, Pred, Pred->getLocationContext())){
+  if (shouldRemoveDeadBindings(AMgr, S, currStmtIdx, Pred,
+                               Pred->getLocationContext())) {
     removeDead(Pred, CleanedStates, currStmt, Pred->getLocationContext());
   } else
     CleanedStates.Add(Pred);
@@ -1261,6 +1278,12 @@ void ExprEngine::Visit(const Stmt *S, ExplodedNode *Pred,
       Bldr.addNodes(Dst);
       break;
 
+    case Stmt::CompactArrayInitExprClass:
+      Bldr.takeNodes(Pred);
+      VisitCompactArrayInitExpr(cast<CompactArrayInitExpr>(S), Pred, Dst);
+      Bldr.addNodes(Dst);
+      break;
+
     case Stmt::MemberExprClass:
       Bldr.takeNodes(Pred);
       VisitMemberExpr(cast<MemberExpr>(S), Pred, Dst);
@@ -1631,6 +1654,17 @@ void ExprEngine::processBranch(const Stmt *Condition, const Stmt *Term,
     return;
 
   BranchNodeBuilder builder(CheckersOutSet, Dst, BldCtx, DstT, DstF);
+
+  // Don't explore a branch that is never taken, even when the state has lost
+  // track of the values that decide it.
+  if (AMgr.options.shouldPruneConstantBranches())
+    if (const ConstantBranches *CB =
+            LCtx->getAnalysisDeclContext()->getAnalysis<ConstantBranches>())
+      if (Optional<bool> Value = CB->getBranchValue(BldCtx.getBlock())) {
+        ++NumPrunedConstantBranches;
+        builder.markInfeasible(!*Value);
+      }
+
   for (NodeBuilder::iterator I = CheckersOutSet.begin(),
                              E = CheckersOutSet.end(); E != I; ++I) {
     ExplodedNode *PredI = *I;
@@ -727,6 +727,34 @@ void ExprEngine::VisitInitListExpr(const InitListExpr *IE,
   B.generateNode(IE, Pred, state->BindExpr(IE, LCtx, V));
 }
 
+void ExprEngine::VisitCompactArrayInitExpr(const CompactArrayInitExpr *E,
+                                           ExplodedNode *Pred,
+                                           ExplodedNodeSet &Dst) {
+  StmtNodeBuilder B(Pred, Dst, *currBldrCtx);
+
+  ProgramStateRef state = Pred->getState();
+  const LocationContext *LCtx = Pred->getLocationContext();
+  QualType T = getContext().getCanonicalType(E->getType());
+  QualType EltTy = getContext().getAsArrayType(T)->getElementType();
+  unsigned EltWidth = getContext().getTypeSize(EltTy);
+  bool IsUnsigned = !EltTy->isSignedIntegerType();
+
+  // Bind the same values as for the initializer list that was replaced.
+  // Like floating-point literals, the floating-point elements are unknown.
+  llvm::ImmutableList<SVal> vals = getBasicVals().getEmptySValList();
+  for (unsigned I = E->getNumElements(); I != 0; --I) {
+    SVal V = UnknownVal();
+    if (EltTy->isIntegerType())
+      V = svalBuilder.makeIntVal(llvm::APSInt(
+          llvm::APInt(EltWidth, E->getElement(I - 1)), IsUnsigned));
+    vals = getBasicVals().prependSVal(V, vals);
+  }
+
+  B.generateNode(E, Pred,
+                 state->BindExpr(E, LCtx,
+                                 svalBuilder.makeCompoundVal(T, vals)));
+}
+
 void ExprEngine::VisitGuardedExpr(const Expr *Ex,
                                   const Expr *L,
                                   const Expr *R,
@@ -18,6 +18,7 @@
 #include "clang/AST/ParentMap.h"
 #include "clang/Analysis/Analyses/LiveVariables.h"
 #include "clang/StaticAnalyzer/Core/CheckerManager.h"
+#include "clang/StaticAnalyzer/Core/PathSensitive/APSIntType.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/CallEvent.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/Statistic.h"
@@ -557,13 +558,60 @@ ProgramStateRef ExprEngine::bindReturnValue(const CallEvent &Call,
   return State->BindExpr(E, LCtx, R);
 }
 
+ProgramStateRef ExprEngine::applyReturnSummary(const CallEvent &Call,
+                                               const CallSummary &Summary,
+                                               const LocationContext *LCtx,
+                                               ProgramStateRef State) {
+  const Expr *E = Call.getOriginExpr();
+  if (!E)
+    return State;
+
+  Optional<DefinedSVal> V = State->getSVal(E, LCtx).getAs<DefinedSVal>();
+  if (!V)
+    return State;
+
+  QualType ResultTy = Call.getResultType();
+  ProgramStateRef NewState;
+  if (Summary.HasReturnRange && ResultTy->isIntegralOrEnumerationType()) {
+    BasicValueFactory &BVF = getBasicVals();
+    APSIntType IntTy = BVF.getAPSIntType(ResultTy);
+    llvm::APSInt Min(llvm::APInt(64, Summary.ReturnMin, /*isSigned=*/true),
+                     /*isUnsigned=*/false);
+    llvm::APSInt Max(llvm::APInt(64, Summary.ReturnMax, /*isSigned=*/true),
+                     /*isUnsigned=*/false);
+    if (IntTy.testInRange(Min, /*AllowMixedSign=*/true) !=
+            APSIntType::RTR_Within ||
+        IntTy.testInRange(Max, /*AllowMixedSign=*/true) !=
+            APSIntType::RTR_Within)
+      return State;
+    const llvm::APSInt &From = BVF.getValue(IntTy.convert(Min));
+    const llvm::APSInt &To = BVF.getValue(IntTy.convert(Max));
+    if (&From == &To)
+      return State->BindExpr(E, LCtx, svalBuilder.makeIntVal(From));
+    NewState = State->assumeInclusiveRange(*V, From, To, true);
+  } else if (Summary.ReturnsNonNull && Loc::isLocType(ResultTy)) {
+    NewState = State->assume(*V, true);
+  }
+
+  // If the summary contradicts what we know, keep the conjured value.
+  return NewState ? NewState : State;
+}
+
 // Conservatively evaluate call by invalidating regions and binding
 // a conjured return value.
 void ExprEngine::conservativeEvalCall(const CallEvent &Call, NodeBuilder &Bldr,
                                       ExplodedNode *Pred,
                                       ProgramStateRef State) {
-  State = Call.invalidateRegions(currBldrCtx->blockCount(), State);
+  // A function defined in another translation unit may have a summary.
+  const CallSummary *Summary = nullptr;
+  if (const Decl *D = Call.getDecl())
+    Summary = AMgr.getCallSummaries().lookup(D);
+
+  State = Call.invalidateRegions(currBldrCtx->blockCount(), State, Summary);
   State = bindReturnValue(Call, Pred->getLocationContext(), State);
+  if (Summary)
+    State = applyReturnSummary(Call, *Summary, Pred->getLocationContext(),
+                               State);
 
   // And make the result node.
   Bldr.generateNode(Call.getProgramPoint(), State, Pred);
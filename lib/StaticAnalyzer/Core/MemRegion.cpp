@@ -1202,11 +1202,28 @@ static bool isImmediateBase(const CXXRecordDecl *Child,
 }
 
 RegionOffset MemRegion::getAsOffset() const {
+  // Regions are immutable, so their offsets never change.
+  if (!cachedOffset)
+    cachedOffset = calculateOffset();
+  return *cachedOffset;
+}
+
+RegionOffset MemRegion::calculateOffset() const {
   const MemRegion *R = this;
   const MemRegion *SymbolicOffsetBase = nullptr;
   int64_t Offset = 0;
 
   while (1) {
+    // A super region whose concrete offset is known shares the rest of the
+    // walk with us, so jump straight to its base region.
+    if (R->cachedOffset && !R->cachedOffset->hasSymbolicOffset() &&
+        R->cachedOffset->getRegion() != R) {
+      if (!SymbolicOffsetBase)
+        Offset += R->cachedOffset->getOffset();
+      R = R->cachedOffset->getRegion();
+      continue;
+    }
+
     switch (R->getKind()) {
     case CodeSpaceRegionKind:
     case StackLocalsSpaceRegionKind:
@@ -1347,16 +1364,9 @@ RegionOffset MemRegion::getAsOffset() const {
       if (SymbolicOffsetBase)
         continue;
 
-      // Get the field number.
-      unsigned idx = 0;
-      for (RecordDecl::field_iterator FI = RD->field_begin(),
-             FE = RD->field_end(); FI != FE; ++FI, ++idx) {
-        if (FR->getDecl() == *FI)
-          break;
-      }
       const ASTRecordLayout &Layout = getContext().getASTRecordLayout(RD);
       // This is offset in bits.
-      Offset += Layout.getFieldOffset(idx);
+      Offset += Layout.getFieldOffset(FR->getDecl()->getFieldIndex());
       break;
     }
     }
@@ -17,8 +17,11 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramState.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramStateTrait.h"
 #include "llvm/ADT/FoldingSet.h"
-#include "llvm/ADT/ImmutableSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <iterator>
 
 using namespace clang;
 using namespace ento;
@@ -48,66 +51,124 @@ public:
   }
 };
 
-class RangeTrait : public llvm::ImutContainerInfo<Range> {
+/// The ranges of a RangeSet, in ascending order. The ranges are allocated by,
+/// and uniqued in, the RangeSet::Factory, so that sets with the same ranges
+/// share their storage and can be compared by identity.
+class RangeList : public llvm::FoldingSetNode {
+  ArrayRef<Range> Ranges;
+
 public:
-  // When comparing if one Range is less than another, we should compare
-  // the actual APSInt values instead of their pointers.  This keeps the order
-  // consistent (instead of comparing by pointer values) and can potentially
-  // be used to speed up some of the operations in RangeSet.
-  static inline bool isLess(key_type_ref lhs, key_type_ref rhs) {
-    return *lhs.first < *rhs.first ||
-           (!(*rhs.first < *lhs.first) && *lhs.second < *rhs.second);
+  explicit RangeList(ArrayRef<Range> Ranges) : Ranges(Ranges) {}
+
+  ArrayRef<Range> getRanges() const { return Ranges; }
+
+  static void Profile(llvm::FoldingSetNodeID &ID, ArrayRef<Range> Ranges) {
+    for (const Range &R : Ranges)
+      R.Profile(ID);
   }
+  void Profile(llvm::FoldingSetNodeID &ID) const { Profile(ID, Ranges); }
 };
 
 /// RangeSet contains a set of ranges. If the set is empty, then
 ///  there the value of a symbol is overly constrained and there are no
 ///  possible values for that symbol.
+///
+/// A symbol is rarely constrained to more than a few ranges, so the ranges
+/// are kept in a sorted array rather than in a balanced tree: the operations
+/// on a set build the new array in a SmallVector and only allocate it if the
+/// factory has not seen the same ranges before.
 class RangeSet {
-  typedef llvm::ImmutableSet<Range, RangeTrait> PrimRangeSet;
-  PrimRangeSet ranges; // no need to make const, since it is an
-                       // ImmutableSet - this allows default operator=
-                       // to work.
+  /// The ranges of the set, or null if the set is empty.
+  const RangeList *Ranges;
+
+  explicit RangeSet(const RangeList *Ranges) : Ranges(Ranges) {}
+
+  /// Compare two ranges by their values, so that the order does not depend on
+  /// where the values were allocated.
+  static bool isLess(const Range &LHS, const Range &RHS) {
+    return LHS.From() < RHS.From() ||
+           (!(RHS.From() < LHS.From()) && LHS.To() < RHS.To());
+  }
+
 public:
-  typedef PrimRangeSet::Factory Factory;
-  typedef PrimRangeSet::iterator iterator;
+  class Factory {
+    llvm::BumpPtrAllocator Allocator;
+    llvm::FoldingSet<RangeList> Cache;
+
+  public:
+    RangeSet getEmptySet() { return RangeSet(nullptr); }
+
+    /// Return the set of the given ranges, which must be sorted.
+    RangeSet getRangeSet(ArrayRef<Range> SortedRanges) {
+      if (SortedRanges.empty())
+        return getEmptySet();
+
+      llvm::FoldingSetNodeID ID;
+      RangeList::Profile(ID, SortedRanges);
+      void *InsertPos;
+      if (RangeList *L = Cache.FindNodeOrInsertPos(ID, InsertPos))
+        return RangeSet(L);
+
+      Range *Storage = Allocator.Allocate<Range>(SortedRanges.size());
+      std::uninitialized_copy(SortedRanges.begin(), SortedRanges.end(),
+                              Storage);
+      RangeList *L = new (Allocator.Allocate<RangeList>())
+          RangeList(llvm::makeArrayRef(Storage, SortedRanges.size()));
+      Cache.InsertNode(L, InsertPos);
+      return RangeSet(L);
+    }
+  };
 
-  RangeSet(PrimRangeSet RS) : ranges(RS) {}
+  typedef const Range *iterator;
 
   /// Create a new set with all ranges of this set and RS.
   /// Possible intersections are not checked here.
   RangeSet addRange(Factory &F, const RangeSet &RS) {
-    PrimRangeSet Ranges(RS.ranges);
-    for (const auto &range : ranges)
-      Ranges = F.add(Ranges, range);
-    return RangeSet(Ranges);
+    if (isEmpty())
+      return RS;
+    if (RS.isEmpty())
+      return *this;
+
+    SmallVector<Range, 4> Merged;
+    std::merge(begin(), end(), RS.begin(), RS.end(),
+               std::back_inserter(Merged), isLess);
+    Merged.erase(std::unique(Merged.begin(), Merged.end(),
+                             [](const Range &LHS, const Range &RHS) {
+                               return !isLess(LHS, RHS) && !isLess(RHS, LHS);
+                             }),
+                 Merged.end());
+    return F.getRangeSet(Merged);
   }
 
-  iterator begin() const { return ranges.begin(); }
-  iterator end() const { return ranges.end(); }
+  iterator begin() const {
+    return Ranges ? Ranges->getRanges().begin() : nullptr;
+  }
+  iterator end() const { return Ranges ? Ranges->getRanges().end() : nullptr; }
 
-  bool isEmpty() const { return ranges.isEmpty(); }
+  bool isEmpty() const { return !Ranges; }
 
   /// Construct a new RangeSet representing '{ [from, to] }'.
   RangeSet(Factory &F, const llvm::APSInt &from, const llvm::APSInt &to)
-      : ranges(F.add(F.getEmptySet(), Range(from, to))) {}
+      : RangeSet(F.getRangeSet(Range(from, to))) {}
 
   /// Profile - Generates a hash profile of this RangeSet for use
   ///  by FoldingSet.
-  void Profile(llvm::FoldingSetNodeID &ID) const { ranges.Profile(ID); }
+  void Profile(llvm::FoldingSetNodeID &ID) const { ID.AddPointer(Ranges); }
 
   /// getConcreteValue - If a symbol is contrained to equal a specific integer
   ///  constant then this method returns that value.  Otherwise, it returns
   ///  NULL.
   const llvm::APSInt *getConcreteValue() const {
-    return ranges.isSingleton() ? ranges.begin()->getConcreteValue() : nullptr;
+    return Ranges && Ranges->getRanges().size() == 1
+               ? begin()->getConcreteValue()
+               : nullptr;
   }
 
 private:
-  void IntersectInRange(BasicValueFactory &BV, Factory &F,
-                        const llvm::APSInt &Lower, const llvm::APSInt &Upper,
-                        PrimRangeSet &newRanges, PrimRangeSet::iterator &i,
-                        PrimRangeSet::iterator &e) const {
+  void IntersectInRange(BasicValueFactory &BV, const llvm::APSInt &Lower,
+                        const llvm::APSInt &Upper,
+                        SmallVectorImpl<Range> &newRanges, iterator &i,
+                        iterator &e) const {
     // There are six cases for each range R in the set:
     //   1. R is entirely before the intersection range.
     //   2. R is entirely after the intersection range.
@@ -126,24 +187,23 @@ private:
 
       if (i->Includes(Lower)) {
         if (i->Includes(Upper)) {
-          newRanges =
-              F.add(newRanges, Range(BV.getValue(Lower), BV.getValue(Upper)));
+          newRanges.push_back(Range(BV.getValue(Lower), BV.getValue(Upper)));
           break;
         } else
-          newRanges = F.add(newRanges, Range(BV.getValue(Lower), i->To()));
+          newRanges.push_back(Range(BV.getValue(Lower), i->To()));
       } else {
         if (i->Includes(Upper)) {
-          newRanges = F.add(newRanges, Range(i->From(), BV.getValue(Upper)));
+          newRanges.push_back(Range(i->From(), BV.getValue(Upper)));
           break;
         } else
-          newRanges = F.add(newRanges, *i);
+          newRanges.push_back(*i);
       }
     }
   }
 
   const llvm::APSInt &getMinValue() const {
     assert(!isEmpty());
-    return ranges.begin()->From();
+    return begin()->From();
   }
 
   bool pin(llvm::APSInt &Lower, llvm::APSInt &Upper) const {
@@ -240,20 +300,21 @@ public:
     if (!pin(Lower, Upper))
       return F.getEmptySet();
 
-    PrimRangeSet newRanges = F.getEmptySet();
+    // Intersecting with the ranges in ascending order keeps newRanges sorted.
+    SmallVector<Range, 4> newRanges;
 
-    PrimRangeSet::iterator i = begin(), e = end();
+    iterator i = begin(), e = end();
     if (Lower <= Upper)
-      IntersectInRange(BV, F, Lower, Upper, newRanges, i, e);
+      IntersectInRange(BV, Lower, Upper, newRanges, i, e);
     else {
       // The order of the next two statements is important!
       // IntersectInRange() does not reset the iteration state for i and e.
       // Therefore, the lower range most be handled first.
-      IntersectInRange(BV, F, BV.getMinValue(Upper), Upper, newRanges, i, e);
-      IntersectInRange(BV, F, Lower, BV.getMaxValue(Lower), newRanges, i, e);
+      IntersectInRange(BV, BV.getMinValue(Upper), Upper, newRanges, i, e);
+      IntersectInRange(BV, Lower, BV.getMaxValue(Lower), newRanges, i, e);
     }
 
-    return newRanges;
+    return F.getRangeSet(newRanges);
   }
 
   void print(raw_ostream &os) const {
@@ -272,7 +333,7 @@ public:
   }
 
   bool operator==(const RangeSet &other) const {
-    return ranges == other.ranges;
+    return Ranges == other.Ranges;
   }
 };
 } // end anonymous namespace
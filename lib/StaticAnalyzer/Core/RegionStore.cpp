@@ -26,14 +26,21 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramState.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramStateTrait.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/SubEngine.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/ImmutableMap.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Support/raw_ostream.h"
 #include <utility>
 
 using namespace clang;
 using namespace ento;
 
+#define DEBUG_TYPE "RegionStore"
+
+STATISTIC(NumBindingCacheHits,
+          "The # of loads answered from the binding lookup cache");
+
 //===----------------------------------------------------------------------===//
 // Representation of binding keys.
 //===----------------------------------------------------------------------===//
@@ -336,6 +343,28 @@ private:
   /// To disable all small-struct-dependent behavior, set the option to "0".
   unsigned SmallStructLimit;
 
+  /// A load from a given store version always yields the same value, so the
+  /// results of the most recent loads are kept in a direct-mapped cache.
+  ///
+  /// Each entry retains its store, so that the memory of the store cannot be
+  /// recycled into another version while the entry refers to it.
+  struct BindingCacheEntry {
+    Store S;
+    const MemRegion *R;
+    QualType T;
+    SVal V;
+
+    BindingCacheEntry() : S(nullptr), R(nullptr), V(UnknownVal()) {}
+  };
+  enum { BindingCacheSize = 256 };
+  BindingCacheEntry BindingCache[BindingCacheSize];
+
+  BindingCacheEntry &getBindingCacheEntry(Store S, const MemRegion *R,
+                                          QualType T) {
+    unsigned Hash = llvm::hash_combine(S, R, T.getAsOpaquePtr());
+    return BindingCache[Hash % BindingCacheSize];
+  }
+
   /// \brief A helper used to populate the work list with the given set of
   /// regions.
   void populateWorkList(invalidateRegionsWorker &W,
@@ -354,6 +383,12 @@ public:
     }
   }
 
+  ~RegionStoreManager() override {
+    for (BindingCacheEntry &Entry : BindingCache)
+      if (Entry.S)
+        decrementReferenceCount(Entry.S);
+  }
+
 
   /// setImplicitDefaultValue - Set the default binding for the provided
   ///  MemRegion to the value implicitly defined for compound literals when
@@ -491,7 +526,27 @@ public: // Part of public interface to class.
   ///     else
   ///       return symbolic
   SVal getBinding(Store S, Loc L, QualType T) override {
-    return getBinding(getRegionBindings(S), L, T);
+    Optional<loc::MemRegionVal> MRV = L.getAs<loc::MemRegionVal>();
+    if (!MRV)
+      return getBinding(getRegionBindings(S), L, T);
+
+    const MemRegion *R = MRV->getRegion();
+    BindingCacheEntry &Entry = getBindingCacheEntry(S, R, T);
+    if (Entry.S == S && Entry.R == R && Entry.T == T) {
+      ++NumBindingCacheHits;
+      return Entry.V;
+    }
+
+    SVal V = getBinding(getRegionBindings(S), L, T);
+    if (S)
+      incrementReferenceCount(S);
+    if (Entry.S)
+      decrementReferenceCount(Entry.S);
+    Entry.S = S;
+    Entry.R = R;
+    Entry.T = T;
+    Entry.V = V;
+    return V;
   }
 
   SVal getBinding(RegionBindingsConstRef B, Loc L, QualType T = QualType());
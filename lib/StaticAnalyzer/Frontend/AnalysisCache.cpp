@@ -0,0 +1,311 @@
+//===-- AnalysisCache.cpp ---------------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "AnalysisCache.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Attr.h"
+#include "clang/AST/DeclCXX.h"
+#include "clang/AST/DeclObjC.h"
+#include "clang/AST/ExprCXX.h"
+#include "clang/AST/ExprObjC.h"
+#include "clang/AST/RecursiveASTVisitor.h"
+#include "clang/Basic/Version.h"
+#include "clang/StaticAnalyzer/Core/AnalyzerOptions.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace clang;
+using namespace ento;
+
+/// Decls from the CallGraph are canonical, except for ObjC methods, whose
+/// canonical declaration has no body.
+static const Decl *canonicalize(const Decl *D) {
+  return isa<ObjCMethodDecl>(D) ? D : D->getCanonicalDecl();
+}
+
+static const Stmt *getBodyOrInit(const Decl *D) {
+  if (const auto *FD = dyn_cast<FunctionDecl>(D)) {
+    const FunctionDecl *Def;
+    return FD->hasBody(Def) ? Def->getBody() : nullptr;
+  }
+  if (const auto *VD = dyn_cast<VarDecl>(D))
+    return VD->getAnyInitializer();
+  return D->getBody();
+}
+
+static void updateHash(llvm::MD5 &Hash, const llvm::FoldingSetNodeID &ID) {
+  llvm::BumpPtrAllocator Allocator;
+  llvm::FoldingSetNodeIDRef Ref = ID.Intern(Allocator);
+  Hash.update(
+      ArrayRef<uint8_t>(reinterpret_cast<const uint8_t *>(Ref.getData()),
+                        Ref.getSize() * sizeof(unsigned)));
+}
+
+static std::string finishHash(llvm::MD5 &Hash) {
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Str;
+  llvm::MD5::stringifyResult(Result, Str);
+  return std::string(Str.begin(), Str.end());
+}
+
+AnalysisCache::AnalysisCache(ASTContext &Ctx, AnalyzerOptions &Opts)
+    : Ctx(Ctx) {
+  llvm::FoldingSetNodeID ID;
+  ID.AddString(getClangFullVersion());
+  ID.AddInteger(unsigned(Opts.AnalysisStoreOpt));
+  ID.AddInteger(unsigned(Opts.AnalysisConstraintsOpt));
+  ID.AddInteger(Opts.InlineMaxStackDepth);
+  ID.AddInteger(unsigned(Opts.InliningMode));
+  ID.AddBoolean(Opts.eagerlyAssumeBinOpBifurcation);
+  ID.AddBoolean(Opts.AnalyzeNestedBlocks);
+  for (const auto &Checker : Opts.CheckersControlList) {
+    ID.AddString(Checker.first);
+    ID.AddBoolean(Checker.second);
+  }
+
+  // The options are not kept in order.
+  std::vector<std::pair<StringRef, StringRef>> Config;
+  for (const auto &Entry : Opts.Config)
+    Config.push_back(std::make_pair(Entry.getKey(), Entry.getValue()));
+  std::sort(Config.begin(), Config.end());
+  for (const auto &Entry : Config) {
+    ID.AddString(Entry.first);
+    ID.AddString(Entry.second);
+  }
+
+  llvm::MD5 Hash;
+  updateHash(Hash, ID);
+  ConfigHash = finishHash(Hash);
+}
+
+static void collectStmtDependencies(const Stmt *S,
+                                    llvm::SetVector<const Decl *> &Deps) {
+  if (!S)
+    return;
+
+  auto Add = [&](const Decl *D) {
+    if (D)
+      Deps.insert(canonicalize(D));
+  };
+
+  if (const auto *DRE = dyn_cast<DeclRefExpr>(S)) {
+    const ValueDecl *VD = DRE->getDecl();
+    if (isa<FunctionDecl>(VD))
+      Add(VD);
+    else if (const auto *Var = dyn_cast<VarDecl>(VD))
+      if (Var->hasGlobalStorage())
+        Add(Var);
+  } else if (const auto *ME = dyn_cast<MemberExpr>(S)) {
+    if (isa<CXXMethodDecl>(ME->getMemberDecl()))
+      Add(ME->getMemberDecl());
+  } else if (const auto *CE = dyn_cast<CXXConstructExpr>(S)) {
+    const CXXConstructorDecl *Ctor = CE->getConstructor();
+    Add(Ctor);
+    Add(Ctor->getParent()->getDestructor());
+  } else if (const auto *NE = dyn_cast<CXXNewExpr>(S)) {
+    Add(NE->getOperatorNew());
+  } else if (const auto *DE = dyn_cast<CXXDeleteExpr>(S)) {
+    Add(DE->getOperatorDelete());
+    if (const CXXRecordDecl *RD = DE->getDestroyedType()->getAsCXXRecordDecl())
+      Add(RD->getDestructor());
+  } else if (const auto *OME = dyn_cast<ObjCMessageExpr>(S)) {
+    Add(OME->getMethodDecl());
+  } else if (const auto *BE = dyn_cast<BlockExpr>(S)) {
+    collectStmtDependencies(BE->getBody(), Deps);
+  } else if (const auto *LE = dyn_cast<LambdaExpr>(S)) {
+    Add(LE->getCallOperator());
+  }
+
+  for (const Stmt *Child : S->children())
+    collectStmtDependencies(Child, Deps);
+}
+
+namespace {
+class OverriderCollector : public RecursiveASTVisitor<OverriderCollector> {
+  llvm::DenseMap<const Decl *, SmallVector<const Decl *, 2>> &Overriders;
+
+public:
+  explicit OverriderCollector(
+      llvm::DenseMap<const Decl *, SmallVector<const Decl *, 2>> &Overriders)
+      : Overriders(Overriders) {}
+
+  bool shouldVisitTemplateInstantiations() const { return true; }
+
+  bool VisitCXXMethodDecl(CXXMethodDecl *MD) {
+    for (const CXXMethodDecl *Overridden : MD->overridden_methods()) {
+      SmallVectorImpl<const Decl *> &List =
+          Overriders[canonicalize(Overridden)];
+      if (!llvm::is_contained(List, canonicalize(MD)))
+        List.push_back(canonicalize(MD));
+    }
+    return true;
+  }
+};
+}
+
+void AnalysisCache::collectOverriders() {
+  OverriderCollector(Overriders).TraverseDecl(Ctx.getTranslationUnitDecl());
+  HasOverriders = true;
+}
+
+void AnalysisCache::collectDependencies(const Decl *D,
+                                        llvm::SetVector<const Decl *> &Deps) {
+  collectStmtDependencies(getBodyOrInit(D), Deps);
+
+  // A virtual call may be inlined as a call to any overrider, and these are
+  // walked in turn for their own overriders.
+  const auto *MD = dyn_cast<CXXMethodDecl>(D);
+  if (!MD || !MD->isVirtual())
+    return;
+  if (!HasOverriders)
+    collectOverriders();
+  auto I = Overriders.find(D);
+  if (I != Overriders.end())
+    Deps.insert(I->second.begin(), I->second.end());
+}
+
+/// Add the attributes of \p D, and those of its parameters, which change
+/// what the analysis assumes of its calls, to \p ID.
+static void profileAttributes(const Decl *D, llvm::FoldingSetNodeID &ID) {
+  // The attributes are inherited by the later redeclarations.
+  D = D->getMostRecentDecl();
+  for (const Attr *A : D->attrs()) {
+    ID.AddInteger(unsigned(A->getKind()));
+    if (const auto *NonNull = dyn_cast<NonNullAttr>(A))
+      for (unsigned Idx : NonNull->args())
+        ID.AddInteger(Idx);
+  }
+  if (const auto *FD = dyn_cast<FunctionDecl>(D))
+    for (const ParmVarDecl *Param : FD->parameters()) {
+      ID.AddInteger(Param->getFunctionScopeIndex());
+      for (const Attr *A : Param->attrs())
+        ID.AddInteger(unsigned(A->getKind()));
+    }
+}
+
+StringRef AnalysisCache::getKey(const Decl *D) {
+  D = canonicalize(D);
+  auto I = Keys.find(D);
+  if (I != Keys.end())
+    return I->second;
+
+  // Deps grows while it is walked, until it holds everything reachable.
+  llvm::SetVector<const Decl *> Deps;
+  Deps.insert(D);
+  for (unsigned Idx = 0; Idx != Deps.size(); ++Idx)
+    collectDependencies(Deps[Idx], Deps);
+
+  llvm::MD5 Hash;
+  Hash.update(ConfigHash);
+  for (const Decl *Dep : Deps) {
+    llvm::FoldingSetNodeID ID;
+    ID.AddInteger(unsigned(Dep->getKind()));
+    if (const auto *ND = dyn_cast<NamedDecl>(Dep))
+      ID.AddString(ND->getQualifiedNameAsString());
+    if (const auto *VD = dyn_cast<ValueDecl>(Dep))
+      ID.AddString(VD->getType().getCanonicalType().getAsString());
+    profileAttributes(Dep, ID);
+    if (const Stmt *Body = getBodyOrInit(Dep))
+      Body->ProfileStable(ID, Ctx);
+    updateHash(Hash, ID);
+  }
+
+  std::string &Key = Keys[D];
+  Key = finishHash(Hash);
+  return Key;
+}
+
+bool AnalysisCache::read(StringRef File, std::string &Error) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+      llvm::MemoryBuffer::getFile(File);
+  if (!Buffer) {
+    if (Buffer.getError() == std::errc::no_such_file_or_directory)
+      return true;
+    Error = Buffer.getError().message();
+    return false;
+  }
+
+  SmallVector<StringRef, 16> Lines;
+  (*Buffer)->getBuffer().split(Lines, '\n', /*MaxSplit=*/-1,
+                               /*KeepEmpty=*/false);
+  for (StringRef Line : Lines) {
+    SmallVector<StringRef, 8> Fields;
+    Line.split(Fields, ' ', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+    if (Fields.empty())
+      continue;
+    std::vector<std::string> &Callees = OldEntries[Fields[0]];
+    for (StringRef Callee : makeArrayRef(Fields).slice(1))
+      Callees.push_back(Callee.str());
+  }
+  return true;
+}
+
+bool AnalysisCache::write(StringRef File, std::string &Error) const {
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(File, EC, llvm::sys::fs::F_Text);
+  if (EC) {
+    Error = EC.message();
+    return false;
+  }
+
+  // Keep the file the same when nothing changed.
+  std::vector<StringRef> Keys;
+  for (const auto &Entry : NewEntries)
+    Keys.push_back(Entry.getKey());
+  std::sort(Keys.begin(), Keys.end());
+  for (StringRef Key : Keys) {
+    OS << Key;
+    for (const std::string &Callee : NewEntries.lookup(Key))
+      OS << ' ' << Callee;
+    OS << '\n';
+  }
+  return true;
+}
+
+bool AnalysisCache::lookup(const Decl *D, SetOfConstDecls &VisitedCallees) {
+  std::string Key = getKey(D);
+  auto I = OldEntries.find(Key);
+  if (I == OldEntries.end())
+    return false;
+
+  // Any function that was inlined into D is one of its dependencies.
+  llvm::SetVector<const Decl *> Deps;
+  collectDependencies(canonicalize(D), Deps);
+  for (unsigned Idx = 0; Idx != Deps.size(); ++Idx)
+    collectDependencies(Deps[Idx], Deps);
+
+  const std::vector<std::string> &Callees = I->second;
+  for (const Decl *Dep : Deps) {
+    if (isa<VarDecl>(Dep))
+      continue;
+    if (std::find(Callees.begin(), Callees.end(), getKey(Dep)) !=
+        Callees.end())
+      VisitedCallees.insert(Dep);
+  }
+
+  NewEntries[Key] = Callees;
+  return true;
+}
+
+void AnalysisCache::insert(const Decl *D,
+                           const SetOfConstDecls &VisitedCallees) {
+  std::string Key = getKey(D);
+  std::vector<std::string> Callees;
+  for (const Decl *Callee : VisitedCallees)
+    Callees.push_back(getKey(Callee));
+  std::sort(Callees.begin(), Callees.end());
+  Callees.erase(std::unique(Callees.begin(), Callees.end()), Callees.end());
+  NewEntries[Key] = std::move(Callees);
+}
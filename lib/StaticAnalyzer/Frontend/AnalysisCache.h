@@ -0,0 +1,96 @@
+//===-- AnalysisCache.h -----------------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief This file defines the clang::ento::AnalysisCache class, which
+/// remembers the functions whose path-sensitive analysis found no bugs, so
+/// that a later analysis of the same code can skip them.
+///
+/// A function is identified by a hash of its body, of the bodies of the
+/// functions it may inline and of the initializers of the globals they use,
+/// and of the analyzer configuration. As its analysis found no bugs, skipping
+/// it does not change what is reported.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SA_FRONTEND_ANALYSISCACHE_H
+#define LLVM_CLANG_SA_FRONTEND_ANALYSISCACHE_H
+
+#include "clang/Basic/LLVM.h"
+#include "clang/StaticAnalyzer/Core/PathSensitive/FunctionSummary.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include <string>
+#include <vector>
+
+namespace clang {
+
+class AnalyzerOptions;
+class ASTContext;
+class Decl;
+
+namespace ento {
+class AnalysisCache {
+  ASTContext &Ctx;
+
+  /// The hash of the analyzer configuration and of the compiler version.
+  std::string ConfigHash;
+
+  /// The hash of each function, and of the functions it calls.
+  llvm::DenseMap<const Decl *, std::string> Keys;
+
+  /// The functions analyzed without bugs by the previous analysis, and the
+  /// keys of the functions they inlined.
+  llvm::StringMap<std::vector<std::string>> OldEntries;
+
+  /// The functions analyzed without bugs by this analysis.
+  llvm::StringMap<std::vector<std::string>> NewEntries;
+
+  /// The methods of the translation unit that override each virtual method,
+  /// which its virtual calls may inline.
+  llvm::DenseMap<const Decl *, SmallVector<const Decl *, 2>> Overriders;
+  bool HasOverriders = false;
+
+  /// Fill \c Overriders.
+  void collectOverriders();
+
+  /// Add the functions that \p D may call, and the globals it reads, to
+  /// \p Deps.
+  void collectDependencies(const Decl *D, llvm::SetVector<const Decl *> &Deps);
+
+  /// Return the key of \p D, which covers everything its analysis depends on.
+  StringRef getKey(const Decl *D);
+
+public:
+  AnalysisCache(ASTContext &Ctx, AnalyzerOptions &Opts);
+
+  /// \brief Read the entries of a previous analysis.
+  ///
+  /// A missing file is an empty cache.
+  bool read(StringRef File, std::string &Error);
+
+  /// \brief Write the entries of this analysis, dropping those of the
+  /// functions that were not analyzed or looked up.
+  bool write(StringRef File, std::string &Error) const;
+
+  /// \brief Check whether a previous analysis of \p D found no bugs.
+  ///
+  /// If so, the functions that were inlined into \p D are added to
+  /// \p VisitedCallees, as if \p D had been analyzed.
+  bool lookup(const Decl *D, SetOfConstDecls &VisitedCallees);
+
+  /// \brief Record that the analysis of \p D found no bugs.
+  void insert(const Decl *D, const SetOfConstDecls &VisitedCallees);
+};
+}
+}
+
+#endif
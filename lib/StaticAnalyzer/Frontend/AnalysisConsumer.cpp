@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/StaticAnalyzer/Frontend/AnalysisConsumer.h"
+#include "AnalysisCache.h"
 #include "ModelInjector.h"
 #include "clang/AST/Decl.h"
 #include "clang/AST/DeclCXX.h"
@@ -23,7 +24,10 @@
 #include "clang/Analysis/CodeInjector.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/FrontendDiagnostic.h"
+#include "clang/Index/USRGeneration.h"
 #include "clang/Lex/Preprocessor.h"
+#include "clang/Sema/Sema.h"
 #include "clang/StaticAnalyzer/Checkers/LocalCheckers.h"
 #include "clang/StaticAnalyzer/Core/AnalyzerOptions.h"
 #include "clang/StaticAnalyzer/Core/BugReporter/BugReporter.h"
@@ -34,8 +38,10 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/ExprEngine.h"
 #include "clang/StaticAnalyzer/Frontend/CheckerRegistration.h"
 #include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/Timer.h"
@@ -59,6 +65,17 @@ STATISTIC(NumBlocksInAnalyzedFunctions,
                       "The # of basic blocks in the analyzed functions.");
 STATISTIC(PercentReachableBlocks, "The % of reachable basic blocks.");
 STATISTIC(MaxCFGSize, "The maximum number of basic blocks in a function.");
+STATISTIC(MaxGraphMemoryKB,
+          "The maximum KB allocated for the exploded graph of a function.");
+STATISTIC(MaxGraphNodesKB,
+          "The maximum KB of exploded nodes alive at the end of the analysis "
+          "of a function.");
+STATISTIC(MaxGraphStatesKB,
+          "The maximum KB of program states alive at the end of the analysis "
+          "of a function.");
+STATISTIC(NumFunctionsCached,
+          "The # of functions not analyzed because the analysis cache showed "
+          "they have no bugs.");
 
 //===----------------------------------------------------------------------===//
 // Special PathDiagnosticConsumers.
@@ -192,12 +209,22 @@ public:
   /// translation unit.
   FunctionSummariesTy FunctionSummaries;
 
+  /// The functions that a previous analysis found no bugs in, if the
+  /// 'analysis-cache' option is set.
+  std::unique_ptr<AnalysisCache> Cache;
+
+  /// Whether the last path-sensitive analysis found bugs.
+  bool FoundPathBugs;
+
+  /// The Sema instance that hands its CFGs to the analyzer, if any.
+  Sema *SemaRef;
+
   AnalysisConsumer(const Preprocessor &pp, const std::string &outdir,
                    AnalyzerOptionsRef opts, ArrayRef<std::string> plugins,
                    CodeInjector *injector)
       : RecVisitorMode(0), RecVisitorBR(nullptr), Ctx(nullptr), PP(pp),
         OutDir(outdir), Opts(std::move(opts)), Plugins(plugins),
-        Injector(injector) {
+        Injector(injector), FoundPathBugs(false), SemaRef(nullptr) {
     DigestAnalyzerOptions();
     if (Opts->PrintStats) {
       llvm::EnableStatistics(false);
@@ -294,6 +321,18 @@ public:
         CreateStoreMgr, CreateConstraintMgr, checkerMgr.get(), *Opts, Injector);
   }
 
+  void InitializeSema(Sema &S) override {
+    SemaRef = &S;
+    S.AnalysisWarnings.setCFGCache(
+        &Mgr->getAnalysisDeclContextManager().getCFGCache());
+  }
+
+  void ForgetSema() override {
+    if (SemaRef)
+      SemaRef->AnalysisWarnings.setCFGCache(nullptr);
+    SemaRef = nullptr;
+  }
+
   /// \brief Store the top level decls in the set to be processed later on.
   /// (Doing this pre-processing avoids deserialization of data from PCH.)
   bool HandleTopLevelDecl(DeclGroupRef D) override;
@@ -382,6 +421,14 @@ private:
   void storeTopLevelDecls(DeclGroupRef DG);
   std::string getFunctionName(const Decl *D);
 
+  /// \brief Attach the summaries of the 'call-summaries' file to the
+  /// functions declared, but not defined, in this translation unit.
+  void loadCallSummaries(ASTContext &C);
+
+  /// \brief Write the summaries of the functions defined in this translation
+  /// unit to the 'call-summaries-output' file.
+  void writeCallSummaries(ASTContext &C);
+
   /// \brief Check if we should skip (not analyze) the given function.
   AnalysisMode getModeForDecl(Decl *D, AnalysisMode Mode);
 
@@ -394,6 +441,77 @@ private:
 //===----------------------------------------------------------------------===//
 llvm::Timer* AnalysisConsumer::TUTotalTimer = nullptr;
 
+namespace {
+/// Visits the functions that may be defined and called in different
+/// translation units.
+class ExternalFunctionVisitor
+    : public RecursiveASTVisitor<ExternalFunctionVisitor> {
+  llvm::function_ref<void(const FunctionDecl *)> Callback;
+
+public:
+  explicit ExternalFunctionVisitor(
+      llvm::function_ref<void(const FunctionDecl *)> Callback)
+      : Callback(Callback) {}
+
+  bool shouldWalkTypesOfTypeLocs() const { return false; }
+
+  bool VisitFunctionDecl(FunctionDecl *FD) {
+    // The summaries don't describe the effects of methods on their object.
+    if (!isa<CXXMethodDecl>(FD) && !FD->isDependentContext() &&
+        FD->isExternallyVisible())
+      Callback(FD);
+    return true;
+  }
+};
+} // end anonymous namespace
+
+void AnalysisConsumer::loadCallSummaries(ASTContext &C) {
+  StringRef File = Opts->getCallSummariesFile();
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+      llvm::MemoryBuffer::getFile(File);
+  if (!Buffer) {
+    PP.getDiagnostics().Report(diag::err_analyzer_call_summaries)
+        << 0 << File << Buffer.getError().message();
+    return;
+  }
+
+  llvm::StringMap<CallSummary> Summaries;
+  if (!CallSummary::parse((*Buffer)->getBuffer(), Summaries)) {
+    PP.getDiagnostics().Report(diag::err_analyzer_call_summaries)
+        << 0 << File << "malformed summary";
+    return;
+  }
+
+  CallSummaryMap &Map = Mgr->getCallSummaries();
+  ExternalFunctionVisitor([&](const FunctionDecl *FD) {
+    // Prefer the body of the function when there is one.
+    SmallString<128> USR;
+    if (FD->hasBody() || index::generateUSRForDecl(FD, USR))
+      return;
+    auto I = Summaries.find(USR);
+    if (I != Summaries.end())
+      Map.add(FD, I->second);
+  }).TraverseDecl(C.getTranslationUnitDecl());
+}
+
+void AnalysisConsumer::writeCallSummaries(ASTContext &C) {
+  StringRef File = Opts->getCallSummariesOutputFile();
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(File, EC, llvm::sys::fs::F_Text);
+  if (EC) {
+    PP.getDiagnostics().Report(diag::err_analyzer_call_summaries)
+        << 1 << File << EC.message();
+    return;
+  }
+
+  ExternalFunctionVisitor([&](const FunctionDecl *FD) {
+    SmallString<128> USR;
+    if (FD->isThisDeclarationADefinition() &&
+        !index::generateUSRForDecl(FD, USR))
+      CallSummary::compute(FD).print(OS, USR);
+  }).TraverseDecl(C.getTranslationUnitDecl());
+}
+
 bool AnalysisConsumer::HandleTopLevelDecl(DeclGroupRef DG) {
   storeTopLevelDecls(DG);
   return true;
@@ -492,11 +610,18 @@ void AnalysisConsumer::HandleDeclsCallGraph(const unsigned LocalTUDeclsSize) {
     if (shouldSkipFunction(D, Visited, VisitedAsTopLevel))
       continue;
 
-    // Analyze the function.
+    // Analyze the function, unless a previous analysis found no bugs in it.
     SetOfConstDecls VisitedCallees;
 
-    HandleCode(D, AM_Path, getInliningModeForFunction(D, Visited),
-               (Mgr->options.InliningMode == All ? nullptr : &VisitedCallees));
+    if (Cache && Cache->lookup(D, VisitedCallees)) {
+      NumFunctionsCached++;
+    } else {
+      FoundPathBugs = false;
+      HandleCode(D, AM_Path, getInliningModeForFunction(D, Visited),
+                 (Mgr->options.InliningMode == All ? nullptr : &VisitedCallees));
+      if (Cache && !FoundPathBugs)
+        Cache->insert(D, VisitedCallees);
+    }
 
     // Add the visited callees to the global visited set.
     for (const Decl *Callee : VisitedCallees)
@@ -519,6 +644,21 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
   if (Opts->DisableAllChecks)
     return;
 
+  if (!Opts->getCallSummariesOutputFile().empty())
+    writeCallSummaries(C);
+  if (!Opts->getCallSummariesFile().empty())
+    loadCallSummaries(C);
+
+  StringRef CacheFile = Opts->getAnalysisCacheFile();
+  if (!CacheFile.empty()) {
+    Cache = llvm::make_unique<AnalysisCache>(C, *Opts);
+    std::string Error;
+    if (!Cache->read(CacheFile, Error)) {
+      Diags.Report(diag::err_analyzer_cache) << 0 << CacheFile << Error;
+      Cache.reset();
+    }
+  }
+
   {
     if (TUTotalTimer) TUTotalTimer->startTimer();
 
@@ -559,10 +699,21 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
   // FIXME: This should be replaced with something that doesn't rely on
   // side-effects in PathDiagnosticConsumer's destructor. This is required when
   // used with option -disable-free.
+  // The CFG cache goes away with the AnalysisManager.
+  if (SemaRef)
+    SemaRef->AnalysisWarnings.setCFGCache(nullptr);
   Mgr.reset();
 
+  if (Cache) {
+    std::string Error;
+    if (!Cache->write(CacheFile, Error))
+      Diags.Report(diag::err_analyzer_cache) << 1 << CacheFile << Error;
+  }
+
   if (TUTotalTimer) TUTotalTimer->stopTimer();
 
+  checkerMgr->printProfile(llvm::errs());
+
   // Count how many basic blocks we have not covered.
   NumBlocksInAnalyzedFunctions = FunctionSummaries.getTotalNumBasicBlocks();
   if (NumBlocksInAnalyzedFunctions > 0)
@@ -638,16 +789,32 @@ AnalysisConsumer::getModeForDecl(Decl *D, AnalysisMode Mode) {
       getFunctionName(D) != Opts->AnalyzeSpecificFunction)
     return AM_None;
 
-  // Unless -analyze-all is specified, treat decls differently depending on
-  // where they came from:
-  // - Main source file: run both path-sensitive and non-path-sensitive checks.
-  // - Header files: run non-path-sensitive checks only.
-  // - System headers: don't run any checks.
+  // When the analysis of the translation unit is split into shards, only
+  // analyze the declarations of this shard. They are assigned by the location
+  // of their body, so that every process of the analysis agrees on the shard
+  // of each declaration.
   SourceManager &SM = Ctx->getSourceManager();
   const Stmt *Body = D->getBody();
   SourceLocation SL = Body ? Body->getLocStart() : D->getLocation();
   SL = SM.getExpansionLoc(SL);
 
+  unsigned ShardCount = Opts->getShardCount();
+  if (ShardCount > 1) {
+    PresumedLoc PLoc = SM.getPresumedLoc(SL);
+    unsigned Hash = 0;
+    if (PLoc.isValid())
+      Hash = llvm::HashString((Twine(PLoc.getFilename()) + ":" +
+                               Twine(PLoc.getLine()) + ":" +
+                               Twine(PLoc.getColumn())).str());
+    if (Hash % ShardCount != Opts->getShardIndex())
+      return AM_None;
+  }
+
+  // Unless -analyze-all is specified, treat decls differently depending on
+  // where they came from:
+  // - Main source file: run both path-sensitive and non-path-sensitive checks.
+  // - Header files: run non-path-sensitive checks only.
+  // - System headers: don't run any checks.
   if (!Opts->AnalyzeAll && !SM.isWrittenInMainFile(SL)) {
     if (SL.isInvalid() || SM.isInSystemHeader(SL))
       return AM_None;
@@ -723,12 +890,28 @@ void AnalysisConsumer::ActionExprEngine(Decl *D, bool ObjCGCEnabled,
   // created BugReporter.
   ExplodedNode::SetAuditor(nullptr);
 
+  // Record how the memory of the analysis was used. The allocator of the
+  // graph also holds the states, environments, stores, symbols, and regions.
+  auto UpdateMax = [](llvm::Statistic &Stat, size_t Bytes) {
+    unsigned KB = Bytes / 1024;
+    if (KB > Stat)
+      Stat = KB;
+  };
+  ExplodedGraph &G = Eng.getGraph();
+  UpdateMax(MaxGraphMemoryKB, G.getAllocator().getTotalMemory());
+  UpdateMax(MaxGraphNodesKB, G.size() * sizeof(ExplodedNode));
+  UpdateMax(MaxGraphStatesKB,
+            Eng.getStateManager().getNumStates() * sizeof(ProgramState));
+
   // Visualize the exploded graph.
   if (Mgr->options.visualizeExplodedGraphWithGraphViz)
     Eng.ViewGraph(Mgr->options.TrimGraph);
 
   // Display warnings.
-  Eng.getBugReporter().FlushReports();
+  BugReporter &BR = Eng.getBugReporter();
+  if (BR.EQClasses_begin() != BR.EQClasses_end())
+    FoundPathBugs = true;
+  BR.FlushReports();
 }
 
 void AnalysisConsumer::RunPathSensitiveChecks(Decl *D,
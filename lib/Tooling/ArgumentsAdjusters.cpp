@@ -51,6 +51,12 @@ ArgumentsAdjuster getClangStripOutputAdjuster() {
   };
 }
 
+ArgumentsAdjuster getSkipFunctionBodiesOutsideMainFileAdjuster() {
+  return getInsertArgumentAdjuster(
+      {"-Xclang", "-skip-function-bodies-outside-main-file"},
+      ArgumentInsertPosition::END);
+}
+
 ArgumentsAdjuster getInsertArgumentAdjuster(const CommandLineArguments &Extra,
                                             ArgumentInsertPosition Pos) {
   return [Extra, Pos](const CommandLineArguments &Args, StringRef /*unused*/) {
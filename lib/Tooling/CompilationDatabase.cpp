@@ -26,8 +26,11 @@
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Option/Arg.h"
 #include "llvm/Support/Host.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
+#include <algorithm>
 #include <sstream>
+#include <tuple>
 #include <system_error>
 using namespace clang;
 using namespace tooling;
@@ -322,6 +325,80 @@ FixedCompilationDatabase::getAllCompileCommands() const {
   return std::vector<CompileCommand>();
 }
 
+/// \brief Returns the include paths and forced includes of \p Command, made
+/// absolute.
+static std::string getIncludeKey(const CompileCommand &Command) {
+  static const char *const IncludeFlags[] = {
+      "-I",       "-isystem", "-iquote",     "-idirafter", "-include",
+      "-imacros", "-F",       "-iframework", "-isysroot",  "--sysroot"};
+  std::string Key;
+  const std::vector<std::string> &Args = Command.CommandLine;
+  for (unsigned I = 0, E = Args.size(); I != E; ++I) {
+    StringRef Arg = Args[I];
+    StringRef Value;
+    for (const char *Flag : IncludeFlags) {
+      if (!Arg.startswith(Flag))
+        continue;
+      Value = Arg.substr(strlen(Flag));
+      if (Value.empty() && I + 1 != E)
+        Value = Args[++I];
+      else if (Value.startswith("="))
+        Value = Value.substr(1);
+      Key += Flag;
+      break;
+    }
+    if (Value.empty())
+      continue;
+    SmallString<128> Path(Value);
+    if (llvm::sys::path::is_relative(Path))
+      llvm::sys::fs::make_absolute(Command.Directory, Path);
+    Key.append(Path.begin(), Path.end());
+    Key += '\0';
+  }
+  return Key;
+}
+
+std::vector<std::string>
+tooling::getShardFiles(const CompilationDatabase &Compilations,
+                       unsigned ShardCount, unsigned ShardIndex) {
+  assert(ShardIndex < ShardCount && "Invalid shard");
+  struct ShardFile {
+    std::string IncludeKey;
+    std::string File;
+    unsigned NumCommands;
+
+    bool operator<(const ShardFile &Other) const {
+      return std::tie(IncludeKey, File) <
+             std::tie(Other.IncludeKey, Other.File);
+    }
+  };
+
+  std::vector<ShardFile> Files;
+  uint64_t NumCommands = 0;
+  for (std::string &File : Compilations.getAllFiles()) {
+    std::vector<CompileCommand> Commands =
+        Compilations.getCompileCommands(File);
+    ShardFile SF;
+    SF.IncludeKey = Commands.empty() ? "" : getIncludeKey(Commands.front());
+    SF.File = std::move(File);
+    SF.NumCommands = std::max<unsigned>(Commands.size(), 1);
+    NumCommands += SF.NumCommands;
+    Files.push_back(std::move(SF));
+  }
+  std::sort(Files.begin(), Files.end());
+
+  // Cut the sorted files into ShardCount runs of about the same number of
+  // commands. A file goes to the shard in which its first command falls.
+  std::vector<std::string> Result;
+  uint64_t CommandsBefore = 0;
+  for (ShardFile &SF : Files) {
+    if (CommandsBefore * ShardCount / NumCommands == ShardIndex)
+      Result.push_back(std::move(SF.File));
+    CommandsBefore += SF.NumCommands;
+  }
+  return Result;
+}
+
 namespace clang {
 namespace tooling {
 
@@ -13,9 +13,6 @@
 
 #include "clang/Tooling/Core/Replacement.h"
 
-#include "clang/Basic/Diagnostic.h"
-#include "clang/Basic/DiagnosticIDs.h"
-#include "clang/Basic/DiagnosticOptions.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Lex/Lexer.h"
@@ -366,16 +363,16 @@ public:
         Length += REnd - End;
         MergeSecond = false;
       }
-      StringRef TextRef = Text;
-      StringRef Head = TextRef.substr(0, R.getOffset() + Delta - Offset);
-      StringRef Tail = TextRef.substr(REnd - Offset);
-      Text = (Head + R.getReplacementText() + Tail).str();
+      // Replace the text in place rather than reallocating it, which is
+      // quadratic in the number of merged replacements.
+      Text.replace(R.getOffset() + Delta - Offset, R.getLength(),
+                   R.getReplacementText());
       Delta += R.getReplacementText().size() - R.getLength();
     } else {
       unsigned End = Offset + Length;
       StringRef RText = R.getReplacementText();
       StringRef Tail = RText.substr(End - R.getOffset());
-      Text = (Text + Tail).str();
+      Text.append(Tail.data(), Tail.size());
       if (R.getOffset() + RText.size() > End) {
         Length = R.getOffset() + R.getLength() - Offset;
         MergeSecond = true;
@@ -454,7 +451,8 @@ Replacements Replacements::merge(const Replacements &ReplacesToMerge) const {
       ++I;
     }
     Delta -= Merged.deltaFirst();
-    Result.insert(Merged.asReplacement());
+    // The merged replacements are produced in order.
+    Result.insert(Result.end(), Merged.asReplacement());
   }
   return Replacements(Result.begin(), Result.end());
 }
@@ -539,13 +537,26 @@ unsigned Replacements::getShiftedCodePosition(unsigned Position) const {
 }
 
 bool applyAllReplacements(const Replacements &Replaces, Rewriter &Rewrite) {
+  if (Replaces.empty())
+    return true;
+
+  // All the replacements are in the same file, which is only looked up once.
+  const Replacement &First = *Replaces.begin();
+  if (!First.isApplicable())
+    return false;
+  SourceManager &SM = Rewrite.getSourceMgr();
+  const FileEntry *Entry = SM.getFileManager().getFile(First.getFilePath());
+  if (!Entry)
+    return false;
+  SourceLocation Start =
+      SM.getLocForStartOfFile(SM.getOrCreateFileID(Entry, SrcMgr::C_User));
+
   bool Result = true;
   for (auto I = Replaces.rbegin(), E = Replaces.rend(); I != E; ++I) {
-    if (I->isApplicable()) {
-      Result = I->apply(Rewrite) && Result;
-    } else {
-      Result = false;
-    }
+    // ReplaceText returns false on success.
+    Result = !Rewrite.ReplaceText(Start.getLocWithOffset(I->getOffset()),
+                                  I->getLength(), I->getReplacementText()) &&
+             Result;
   }
   return Result;
 }
@@ -555,29 +566,29 @@ llvm::Expected<std::string> applyAllReplacements(StringRef Code,
   if (Replaces.empty())
     return Code.str();
 
-  IntrusiveRefCntPtr<vfs::InMemoryFileSystem> InMemoryFileSystem(
-      new vfs::InMemoryFileSystem);
-  FileManager Files(FileSystemOptions(), InMemoryFileSystem);
-  DiagnosticsEngine Diagnostics(
-      IntrusiveRefCntPtr<DiagnosticIDs>(new DiagnosticIDs),
-      new DiagnosticOptions);
-  SourceManager SourceMgr(Diagnostics, Files);
-  Rewriter Rewrite(SourceMgr, LangOptions());
-  InMemoryFileSystem->addFile(
-      "<stdin>", 0, llvm::MemoryBuffer::getMemBuffer(Code, "<stdin>"));
-  FileID ID = SourceMgr.createFileID(Files.getFile("<stdin>"), SourceLocation(),
-                                     clang::SrcMgr::C_User);
-  for (auto I = Replaces.rbegin(), E = Replaces.rend(); I != E; ++I) {
-    Replacement Replace("<stdin>", I->getOffset(), I->getLength(),
-                        I->getReplacementText());
-    if (!Replace.apply(Rewrite))
+  // The replacements are sorted and do not overlap, so that the result is
+  // built in one pass over the code.
+  size_t ResultSize = Code.size();
+  unsigned End = 0;
+  for (const Replacement &R : Replaces) {
+    if (R.getOffset() < End || R.getOffset() > Code.size() ||
+        R.getLength() > Code.size() - R.getOffset())
       return llvm::make_error<ReplacementError>(
-          replacement_error::fail_to_apply, Replace);
+          replacement_error::fail_to_apply, R);
+    End = R.getOffset() + R.getLength();
+    ResultSize += R.getReplacementText().size() - R.getLength();
   }
+
   std::string Result;
-  llvm::raw_string_ostream OS(Result);
-  Rewrite.getEditBuffer(ID).write(OS);
-  OS.flush();
+  Result.reserve(ResultSize);
+  End = 0;
+  for (const Replacement &R : Replaces) {
+    Result.append(Code.data() + End, R.getOffset() - End);
+    Result.append(R.getReplacementText().data(),
+                  R.getReplacementText().size());
+    End = R.getOffset() + R.getLength();
+  }
+  Result.append(Code.data() + End, Code.size() - End);
   return Result;
 }
 
@@ -148,7 +148,8 @@ class JSONCompilationDatabasePlugin : public CompilationDatabasePlugin {
     llvm::sys::path::append(JSONDatabasePath, "compile_commands.json");
     std::unique_ptr<CompilationDatabase> Database(
         JSONCompilationDatabase::loadFromFile(
-            JSONDatabasePath, ErrorMessage, JSONCommandLineSyntax::AutoDetect));
+            JSONDatabasePath, ErrorMessage, JSONCommandLineSyntax::AutoDetect,
+            JSONDatabaseLoading::Lazy));
     if (!Database)
       return nullptr;
     return Database;
@@ -169,7 +170,10 @@ volatile int JSONAnchorSource = 0;
 std::unique_ptr<JSONCompilationDatabase>
 JSONCompilationDatabase::loadFromFile(StringRef FilePath,
                                       std::string &ErrorMessage,
-                                      JSONCommandLineSyntax Syntax) {
+                                      JSONCommandLineSyntax Syntax,
+                                      JSONDatabaseLoading Loading) {
+  // Large databases are memory mapped, so that the lazy loading only reads
+  // the parts of the file it needs.
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> DatabaseBuffer =
       llvm::MemoryBuffer::getFile(FilePath);
   if (std::error_code Result = DatabaseBuffer.getError()) {
@@ -178,6 +182,8 @@ JSONCompilationDatabase::loadFromFile(StringRef FilePath,
   }
   std::unique_ptr<JSONCompilationDatabase> Database(
       new JSONCompilationDatabase(std::move(*DatabaseBuffer), Syntax));
+  if (Loading == JSONDatabaseLoading::Lazy && Database->scan())
+    return Database;
   if (!Database->parse(ErrorMessage))
     return nullptr;
   return Database;
@@ -186,11 +192,14 @@ JSONCompilationDatabase::loadFromFile(StringRef FilePath,
 std::unique_ptr<JSONCompilationDatabase>
 JSONCompilationDatabase::loadFromBuffer(StringRef DatabaseString,
                                         std::string &ErrorMessage,
-                                        JSONCommandLineSyntax Syntax) {
+                                        JSONCommandLineSyntax Syntax,
+                                        JSONDatabaseLoading Loading) {
   std::unique_ptr<llvm::MemoryBuffer> DatabaseBuffer(
       llvm::MemoryBuffer::getMemBuffer(DatabaseString));
   std::unique_ptr<JSONCompilationDatabase> Database(
       new JSONCompilationDatabase(std::move(DatabaseBuffer), Syntax));
+  if (Loading == JSONDatabaseLoading::Lazy && Database->scan())
+    return Database;
   if (!Database->parse(ErrorMessage))
     return nullptr;
   return Database;
@@ -206,6 +215,14 @@ JSONCompilationDatabase::getCompileCommands(StringRef FilePath) const {
   StringRef Match = MatchTrie.findEquivalent(NativeFilePath, ES);
   if (Match.empty())
     return std::vector<CompileCommand>();
+  if (IsLazy) {
+    auto ObjectsI = LazyIndexByFile.find(Match);
+    if (ObjectsI == LazyIndexByFile.end())
+      return std::vector<CompileCommand>();
+    std::vector<CompileCommand> Commands;
+    getLazyCommands(ObjectsI->getValue(), Commands);
+    return Commands;
+  }
   llvm::StringMap< std::vector<CompileCommandRef> >::const_iterator
     CommandsRefI = IndexByFile.find(Match);
   if (CommandsRefI == IndexByFile.end())
@@ -219,6 +236,12 @@ std::vector<std::string>
 JSONCompilationDatabase::getAllFiles() const {
   std::vector<std::string> Result;
 
+  if (IsLazy) {
+    for (const auto &Entry : LazyIndexByFile)
+      Result.push_back(Entry.first().str());
+    return Result;
+  }
+
   llvm::StringMap< std::vector<CompileCommandRef> >::const_iterator
     CommandsRefI = IndexByFile.begin();
   const llvm::StringMap< std::vector<CompileCommandRef> >::const_iterator
@@ -233,7 +256,10 @@ JSONCompilationDatabase::getAllFiles() const {
 std::vector<CompileCommand>
 JSONCompilationDatabase::getAllCompileCommands() const {
   std::vector<CompileCommand> Commands;
-  getCommands(AllCommands, Commands);
+  if (IsLazy)
+    getLazyCommands(AllLazyCommands, Commands);
+  else
+    getCommands(AllCommands, Commands);
   return Commands;
 }
 
@@ -267,6 +293,104 @@ void JSONCompilationDatabase::getCommands(
   }
 }
 
+namespace {
+
+/// \brief The values of a JSON object of a compile command.
+struct CommandObject {
+  llvm::yaml::ScalarNode *Directory = nullptr;
+  llvm::Optional<std::vector<llvm::yaml::ScalarNode *>> Command;
+  llvm::yaml::ScalarNode *File = nullptr;
+  llvm::yaml::ScalarNode *Output = nullptr;
+};
+
+} // end namespace
+
+static bool parseCommandObject(llvm::yaml::Node *Node, CommandObject &Result,
+                               std::string &ErrorMessage) {
+  llvm::yaml::MappingNode *Object =
+      dyn_cast_or_null<llvm::yaml::MappingNode>(Node);
+  if (!Object) {
+    ErrorMessage = "Expected object.";
+    return false;
+  }
+  for (auto& NextKeyValue : *Object) {
+    llvm::yaml::ScalarNode *KeyString =
+        dyn_cast<llvm::yaml::ScalarNode>(NextKeyValue.getKey());
+    if (!KeyString) {
+      ErrorMessage = "Expected strings as key.";
+      return false;
+    }
+    SmallString<10> KeyStorage;
+    StringRef KeyValue = KeyString->getValue(KeyStorage);
+    llvm::yaml::Node *Value = NextKeyValue.getValue();
+    if (!Value) {
+      ErrorMessage = "Expected value.";
+      return false;
+    }
+    llvm::yaml::ScalarNode *ValueString =
+        dyn_cast<llvm::yaml::ScalarNode>(Value);
+    llvm::yaml::SequenceNode *SequenceString =
+        dyn_cast<llvm::yaml::SequenceNode>(Value);
+    if (KeyValue == "arguments" && !SequenceString) {
+      ErrorMessage = "Expected sequence as value.";
+      return false;
+    } else if (KeyValue != "arguments" && !ValueString) {
+      ErrorMessage = "Expected string as value.";
+      return false;
+    }
+    if (KeyValue == "directory") {
+      Result.Directory = ValueString;
+    } else if (KeyValue == "arguments") {
+      Result.Command = std::vector<llvm::yaml::ScalarNode *>();
+      for (auto &Argument : *SequenceString) {
+        auto Scalar = dyn_cast<llvm::yaml::ScalarNode>(&Argument);
+        if (!Scalar) {
+          ErrorMessage = "Only strings are allowed in 'arguments'.";
+          return false;
+        }
+        Result.Command->push_back(Scalar);
+      }
+    } else if (KeyValue == "command") {
+      if (!Result.Command)
+        Result.Command =
+            std::vector<llvm::yaml::ScalarNode *>(1, ValueString);
+    } else if (KeyValue == "file") {
+      Result.File = ValueString;
+    } else if (KeyValue == "output") {
+      Result.Output = ValueString;
+    } else {
+      ErrorMessage = ("Unknown key: \"" +
+                      KeyString->getRawValue() + "\"").str();
+      return false;
+    }
+  }
+  if (!Result.File) {
+    ErrorMessage = "Missing key: \"file\".";
+    return false;
+  }
+  if (!Result.Command) {
+    ErrorMessage = "Missing key: \"command\" or \"arguments\".";
+    return false;
+  }
+  if (!Result.Directory) {
+    ErrorMessage = "Missing key: \"directory\".";
+    return false;
+  }
+  return true;
+}
+
+/// \brief Returns the native absolute path of the file of a compile command.
+static void getNativeFilePath(StringRef Directory, StringRef FileName,
+                              SmallVectorImpl<char> &NativeFilePath) {
+  if (llvm::sys::path::is_relative(FileName)) {
+    SmallString<128> AbsolutePath(Directory);
+    llvm::sys::path::append(AbsolutePath, FileName);
+    llvm::sys::path::native(AbsolutePath, NativeFilePath);
+  } else {
+    llvm::sys::path::native(FileName, NativeFilePath);
+  }
+}
+
 bool JSONCompilationDatabase::parse(std::string &ErrorMessage) {
   llvm::yaml::document_iterator I = YAMLStream.begin();
   if (I == YAMLStream.end()) {
@@ -284,96 +408,248 @@ bool JSONCompilationDatabase::parse(std::string &ErrorMessage) {
     return false;
   }
   for (auto& NextObject : *Array) {
-    llvm::yaml::MappingNode *Object = dyn_cast<llvm::yaml::MappingNode>(&NextObject);
-    if (!Object) {
-      ErrorMessage = "Expected object.";
+    CommandObject Object;
+    if (!parseCommandObject(&NextObject, Object, ErrorMessage))
       return false;
-    }
-    llvm::yaml::ScalarNode *Directory = nullptr;
-    llvm::Optional<std::vector<llvm::yaml::ScalarNode *>> Command;
-    llvm::yaml::ScalarNode *File = nullptr;
-    llvm::yaml::ScalarNode *Output = nullptr;
-    for (auto& NextKeyValue : *Object) {
-      llvm::yaml::ScalarNode *KeyString =
-          dyn_cast<llvm::yaml::ScalarNode>(NextKeyValue.getKey());
-      if (!KeyString) {
-        ErrorMessage = "Expected strings as key.";
-        return false;
-      }
-      SmallString<10> KeyStorage;
-      StringRef KeyValue = KeyString->getValue(KeyStorage);
-      llvm::yaml::Node *Value = NextKeyValue.getValue();
-      if (!Value) {
-        ErrorMessage = "Expected value.";
+    SmallString<8> DirectoryStorage;
+    SmallString<8> FileStorage;
+    SmallString<128> NativeFilePath;
+    getNativeFilePath(Object.Directory->getValue(DirectoryStorage),
+                      Object.File->getValue(FileStorage), NativeFilePath);
+    auto Cmd = CompileCommandRef(Object.Directory, Object.File,
+                                 *Object.Command, Object.Output);
+    IndexByFile[NativeFilePath].push_back(Cmd);
+    AllCommands.push_back(Cmd);
+    MatchTrie.insert(NativeFilePath);
+  }
+  return true;
+}
+
+namespace {
+
+/// \brief Finds the JSON objects of the compile commands of a database and
+/// the files they compile, without building the nodes of their command
+/// lines.
+///
+/// Only plain JSON is accepted, and the values of the keys other than
+/// 'directory' and 'file' are checked but not decoded.
+class CommandObjectScanner {
+public:
+  struct Entry {
+    StringRef Object;
+    std::string Directory;
+    std::string File;
+  };
+
+  explicit CommandObjectScanner(StringRef Input) : Input(Input), Pos(0) {}
+
+  /// \brief Returns false if the input is not a JSON array of compile
+  /// command objects.
+  bool scan(std::vector<Entry> &Entries) {
+    skipSpace();
+    if (!consume('['))
+      return false;
+    skipSpace();
+    if (!consume(']')) {
+      do {
+        skipSpace();
+        Entries.emplace_back();
+        if (!scanObject(Entries.back()))
+          return false;
+        skipSpace();
+      } while (consume(','));
+      if (!consume(']'))
         return false;
-      }
-      llvm::yaml::ScalarNode *ValueString =
-          dyn_cast<llvm::yaml::ScalarNode>(Value);
-      llvm::yaml::SequenceNode *SequenceString =
-          dyn_cast<llvm::yaml::SequenceNode>(Value);
-      if (KeyValue == "arguments" && !SequenceString) {
-        ErrorMessage = "Expected sequence as value.";
+    }
+    skipSpace();
+    return Pos == Input.size();
+  }
+
+private:
+  bool consume(char C) {
+    if (Pos == Input.size() || Input[Pos] != C)
+      return false;
+    ++Pos;
+    return true;
+  }
+
+  void skipSpace() {
+    while (Pos != Input.size() && (Input[Pos] == ' ' || Input[Pos] == '\n' ||
+                                   Input[Pos] == '\r' || Input[Pos] == '\t'))
+      ++Pos;
+  }
+
+  bool scanObject(Entry &Result) {
+    size_t Begin = Pos;
+    if (!consume('{'))
+      return false;
+    bool HasDirectory = false, HasCommand = false, HasFile = false;
+    do {
+      skipSpace();
+      std::string Key;
+      if (!scanString(&Key))
         return false;
-      } else if (KeyValue != "arguments" && !ValueString) {
-        ErrorMessage = "Expected string as value.";
+      skipSpace();
+      if (!consume(':'))
         return false;
-      }
-      if (KeyValue == "directory") {
-        Directory = ValueString;
-      } else if (KeyValue == "arguments") {
-        Command = std::vector<llvm::yaml::ScalarNode *>();
-        for (auto &Argument : *SequenceString) {
-          auto Scalar = dyn_cast<llvm::yaml::ScalarNode>(&Argument);
-          if (!Scalar) {
-            ErrorMessage = "Only strings are allowed in 'arguments'.";
-            return false;
-          }
-          Command->push_back(Scalar);
-        }
-      } else if (KeyValue == "command") {
-        if (!Command)
-          Command = std::vector<llvm::yaml::ScalarNode *>(1, ValueString);
-      } else if (KeyValue == "file") {
-        File = ValueString;
-      } else if (KeyValue == "output") {
-        Output = ValueString;
+      skipSpace();
+      if (Key == "arguments") {
+        if (!scanStringArray())
+          return false;
+        HasCommand = true;
+      } else if (Key == "command" || Key == "output") {
+        if (!scanString(nullptr))
+          return false;
+        HasCommand |= Key == "command";
+      } else if (Key == "directory") {
+        Result.Directory.clear();
+        if (!scanString(&Result.Directory))
+          return false;
+        HasDirectory = true;
+      } else if (Key == "file") {
+        Result.File.clear();
+        if (!scanString(&Result.File))
+          return false;
+        HasFile = true;
       } else {
-        ErrorMessage = ("Unknown key: \"" +
-                        KeyString->getRawValue() + "\"").str();
         return false;
       }
-    }
-    if (!File) {
-      ErrorMessage = "Missing key: \"file\".";
+      skipSpace();
+    } while (consume(','));
+    if (!consume('}'))
       return false;
-    }
-    if (!Command) {
-      ErrorMessage = "Missing key: \"command\" or \"arguments\".";
+    Result.Object = Input.slice(Begin, Pos);
+    return HasDirectory && HasCommand && HasFile;
+  }
+
+  bool scanStringArray() {
+    if (!consume('['))
       return false;
-    }
-    if (!Directory) {
-      ErrorMessage = "Missing key: \"directory\".";
+    skipSpace();
+    if (consume(']'))
+      return true;
+    do {
+      skipSpace();
+      if (!scanString(nullptr))
+        return false;
+      skipSpace();
+    } while (consume(','));
+    return consume(']');
+  }
+
+  /// \brief Scans a string, appending its decoded value to \p Value unless
+  /// it is null.
+  bool scanString(std::string *Value) {
+    if (!consume('"'))
       return false;
+    while (Pos != Input.size()) {
+      char C = Input[Pos++];
+      if (C == '"')
+        return true;
+      // YAML folds the line breaks in strings, so leave those to the parser.
+      if (static_cast<unsigned char>(C) < 0x20)
+        return false;
+      if (C != '\\') {
+        if (Value)
+          Value->push_back(C);
+        continue;
+      }
+      if (Pos == Input.size())
+        return false;
+      C = Input[Pos++];
+      switch (C) {
+      case '"':
+      case '\\':
+      case '/':
+        break;
+      case 'b':
+        C = '\b';
+        break;
+      case 'f':
+        C = '\f';
+        break;
+      case 'n':
+        C = '\n';
+        break;
+      case 'r':
+        C = '\r';
+        break;
+      case 't':
+        C = '\t';
+        break;
+      case 'u': {
+        unsigned CodePoint;
+        if (Pos + 4 > Input.size() ||
+            Input.substr(Pos, 4).getAsInteger(16, CodePoint))
+          return false;
+        Pos += 4;
+        // Leave the surrogate pairs to the parser.
+        if (CodePoint >= 0xD800 && CodePoint <= 0xDFFF)
+          return false;
+        if (Value)
+          appendUTF8(CodePoint, *Value);
+        continue;
+      }
+      default:
+        return false;
+      }
+      if (Value)
+        Value->push_back(C);
     }
-    SmallString<8> FileStorage;
-    StringRef FileName = File->getValue(FileStorage);
-    SmallString<128> NativeFilePath;
-    if (llvm::sys::path::is_relative(FileName)) {
-      SmallString<8> DirectoryStorage;
-      SmallString<128> AbsolutePath(
-          Directory->getValue(DirectoryStorage));
-      llvm::sys::path::append(AbsolutePath, FileName);
-      llvm::sys::path::native(AbsolutePath, NativeFilePath);
+    return false;
+  }
+
+  static void appendUTF8(unsigned CodePoint, std::string &Value) {
+    if (CodePoint < 0x80) {
+      Value.push_back(CodePoint);
+    } else if (CodePoint < 0x800) {
+      Value.push_back(0xC0 | (CodePoint >> 6));
+      Value.push_back(0x80 | (CodePoint & 0x3F));
     } else {
-      llvm::sys::path::native(FileName, NativeFilePath);
+      Value.push_back(0xE0 | (CodePoint >> 12));
+      Value.push_back(0x80 | ((CodePoint >> 6) & 0x3F));
+      Value.push_back(0x80 | (CodePoint & 0x3F));
     }
-    auto Cmd = CompileCommandRef(Directory, File, *Command, Output);
-    IndexByFile[NativeFilePath].push_back(Cmd);
-    AllCommands.push_back(Cmd);
+  }
+
+  StringRef Input;
+  size_t Pos;
+};
+
+} // end namespace
+
+bool JSONCompilationDatabase::scan() {
+  std::vector<CommandObjectScanner::Entry> Entries;
+  if (!CommandObjectScanner(Database->getBuffer()).scan(Entries))
+    return false;
+  for (const auto &Entry : Entries) {
+    SmallString<128> NativeFilePath;
+    getNativeFilePath(Entry.Directory, Entry.File, NativeFilePath);
+    LazyIndexByFile[NativeFilePath].push_back(Entry.Object);
+    AllLazyCommands.push_back(Entry.Object);
     MatchTrie.insert(NativeFilePath);
   }
+  IsLazy = true;
   return true;
 }
 
+void JSONCompilationDatabase::getLazyCommands(
+    ArrayRef<StringRef> Objects, std::vector<CompileCommand> &Commands) const {
+  for (StringRef Text : Objects) {
+    llvm::SourceMgr ObjectSM;
+    llvm::yaml::Stream ObjectStream(Text, ObjectSM);
+    llvm::yaml::document_iterator I = ObjectStream.begin();
+    CommandObject Object;
+    std::string ErrorMessage;
+    // The object was checked when the database was scanned.
+    if (I == ObjectStream.end() ||
+        !parseCommandObject(I->getRoot(), Object, ErrorMessage))
+      continue;
+    getCommands(CompileCommandRef(Object.Directory, Object.File,
+                                  *Object.Command, Object.Output),
+                Commands);
+  }
+}
+
 } // end namespace tooling
 } // end namespace clang
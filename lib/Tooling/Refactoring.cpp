@@ -19,8 +19,12 @@
 #include "clang/Frontend/TextDiagnosticPrinter.h"
 #include "clang/Lex/Lexer.h"
 #include "clang/Rewrite/Core/Rewriter.h"
+#include "clang/Tooling/ReplacementsYaml.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_os_ostream.h"
+#include <mutex>
 
 namespace clang {
 namespace tooling {
@@ -34,11 +38,17 @@ std::map<std::string, Replacements> &RefactoringTool::getReplacements() {
   return FileToReplaces;
 }
 
-int RefactoringTool::runAndSave(FrontendActionFactory *ActionFactory) {
-  if (int Result = run(ActionFactory)) {
+int RefactoringTool::runAndSave(FrontendActionFactory *ActionFactory,
+                                unsigned Threads) {
+  if (int Result = run(ActionFactory, Threads)) {
     return Result;
   }
 
+  if (Threads > 1)
+    return applyAllReplacementsToFiles(getFiles(), FileToReplaces, Threads)
+               ? 0
+               : 1;
+
   LangOptions DefaultLangOptions;
   IntrusiveRefCntPtr<DiagnosticOptions> DiagOpts = new DiagnosticOptions();
   TextDiagnosticPrinter DiagnosticPrinter(llvm::errs(), &*DiagOpts);
@@ -95,5 +105,129 @@ bool formatAndApplyAllReplacements(
   return Result;
 }
 
+bool applyAllReplacementsToFiles(
+    FileManager &Files,
+    const std::map<std::string, Replacements> &FileToReplaces,
+    unsigned Threads) {
+  struct FileJob {
+    StringRef Path;
+    const Replacements *Replaces;
+    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  };
+
+  // The FileManager is not thread-safe, so the files are read first.
+  std::map<std::string, Replacements> Grouped =
+      groupReplacementsByFile(Files, FileToReplaces);
+  std::vector<FileJob> Jobs;
+  bool Result = true;
+  for (const auto &FileAndReplaces : Grouped) {
+    if (FileAndReplaces.second.empty())
+      continue;
+    const FileEntry *Entry = Files.getFile(FileAndReplaces.first);
+    auto Buffer = Files.getBufferForFile(Entry);
+    if (!Buffer) {
+      llvm::errs() << "Cannot read " << FileAndReplaces.first << ": "
+                   << Buffer.getError().message() << "\n";
+      Result = false;
+      continue;
+    }
+    Jobs.push_back(
+        {Entry->getName(), &FileAndReplaces.second, std::move(*Buffer)});
+  }
+
+  // Each file is built in one pass from its contents and its sorted
+  // replacements, and written to a temporary file that is moved over it.
+  std::mutex OutputMutex;
+  auto RunJob = [&](FileJob &Job) {
+    std::string Error;
+    llvm::Expected<std::string> Code =
+        tooling::applyAllReplacements(Job.Buffer->getBuffer(), *Job.Replaces);
+    if (!Code) {
+      Error = llvm::toString(Code.takeError());
+    } else {
+      SmallString<128> TempPath(Job.Path);
+      TempPath += "-%%%%%%%%";
+      int FD;
+      if (std::error_code EC =
+              llvm::sys::fs::createUniqueFile(TempPath, FD, TempPath)) {
+        Error = "cannot create " + TempPath.str().str() + ": " + EC.message();
+      } else {
+        {
+          llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+          OS << *Code;
+        }
+        if (std::error_code EC = llvm::sys::fs::rename(TempPath, Job.Path)) {
+          Error = "cannot rename " + TempPath.str().str() + " to " +
+                  Job.Path.str() + ": " + EC.message();
+          llvm::sys::fs::remove(TempPath);
+        }
+      }
+    }
+
+    if (Error.empty())
+      return;
+    std::lock_guard<std::mutex> Lock(OutputMutex);
+    llvm::errs() << Job.Path << ": " << Error << "\n";
+    Result = false;
+  };
+
+  if (Threads <= 1 || Jobs.size() <= 1) {
+    for (FileJob &Job : Jobs)
+      RunJob(Job);
+    return Result;
+  }
+
+  llvm::ThreadPool Pool(std::min<size_t>(Threads, Jobs.size()));
+  for (FileJob &Job : Jobs)
+    Pool.async([&RunJob, &Job] { RunJob(Job); });
+  Pool.wait();
+  return Result;
+}
+
+llvm::Error
+mergeReplacements(std::map<std::string, Replacements> &FileToReplaces,
+                  const std::map<std::string, Replacements> &Other) {
+  for (const auto &FileAndReplaces : Other) {
+    Replacements &Replaces = FileToReplaces[FileAndReplaces.first];
+    for (const Replacement &R : FileAndReplaces.second) {
+      // Adding a replacement twice only keeps it once, except for insertions,
+      // whose texts are concatenated.
+      if (R.getLength() == 0 && Replaces.contains(R))
+        continue;
+      if (auto Err = Replaces.add(R))
+        return Err;
+    }
+  }
+  return llvm::Error::success();
+}
+
+void writeReplacements(
+    llvm::raw_ostream &OS,
+    const std::map<std::string, Replacements> &FileToReplaces) {
+  TranslationUnitReplacements Doc;
+  for (const auto &FileAndReplaces : FileToReplaces)
+    Doc.Replacements.insert(Doc.Replacements.end(),
+                            FileAndReplaces.second.begin(),
+                            FileAndReplaces.second.end());
+  llvm::yaml::Output YAML(OS);
+  YAML << Doc;
+}
+
+llvm::Error
+readReplacements(StringRef YAML,
+                 std::map<std::string, Replacements> &FileToReplaces) {
+  TranslationUnitReplacements Doc;
+  llvm::yaml::Input YIn(YAML);
+  YIn >> Doc;
+  if (YIn.error())
+    return llvm::errorCodeToError(YIn.error());
+  std::map<std::string, Replacements> Other;
+  for (const Replacement &R : Doc.Replacements) {
+    if (auto Err = Other[R.getFilePath()].add(R))
+      return Err;
+  }
+  return mergeReplacements(FileToReplaces, Other);
+}
+
 } // end namespace tooling
 } // end namespace clang
@@ -33,7 +33,9 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
+#include <mutex>
 #include <utility>
 
 #define DEBUG_TYPE "clang-tooling"
@@ -323,10 +325,11 @@ bool FrontendActionFactory::runInvocation(
 
 ClangTool::ClangTool(const CompilationDatabase &Compilations,
                      ArrayRef<std::string> SourcePaths,
-                     std::shared_ptr<PCHContainerOperations> PCHContainerOps)
+                     std::shared_ptr<PCHContainerOperations> PCHContainerOps,
+                     IntrusiveRefCntPtr<vfs::FileSystem> BaseFS)
     : Compilations(Compilations), SourcePaths(SourcePaths),
       PCHContainerOps(std::move(PCHContainerOps)),
-      OverlayFileSystem(new vfs::OverlayFileSystem(vfs::getRealFileSystem())),
+      OverlayFileSystem(new vfs::OverlayFileSystem(std::move(BaseFS))),
       InMemoryFileSystem(new vfs::InMemoryFileSystem),
       Files(new FileManager(FileSystemOptions(), OverlayFileSystem)),
       DiagConsumer(nullptr) {
@@ -365,10 +368,13 @@ static void injectResourceDir(CommandLineArguments &Args, const char *Argv0,
                  CompilerInvocation::GetResourcesPath(Argv0, MainAddr));
 }
 
-int ClangTool::run(ToolAction *Action) {
-  // Exists solely for the purpose of lookup of the resource path.
-  // This just needs to be some symbol in the binary.
-  static int StaticSymbol;
+// Exists solely for the purpose of lookup of the resource path.
+// This just needs to be some symbol in the binary.
+static int StaticSymbol;
+
+int ClangTool::run(ToolAction *Action, unsigned Threads) {
+  if (Threads > 1)
+    return runConcurrently([Action] { return Action; }, Threads);
 
   llvm::SmallString<128> InitialDirectory;
   if (std::error_code EC = llvm::sys::fs::current_path(InitialDirectory))
@@ -468,6 +474,168 @@ int ClangTool::run(ToolAction *Action) {
 
 namespace {
 
+/// \brief Forwards the diagnostics of translation units run on several
+/// threads to one consumer, one call at a time.
+class LockingDiagnosticConsumer : public DiagnosticConsumer {
+  DiagnosticConsumer &Target;
+  std::mutex &Mutex;
+
+public:
+  LockingDiagnosticConsumer(DiagnosticConsumer &Target, std::mutex &Mutex)
+      : Target(Target), Mutex(Mutex) {}
+
+  void BeginSourceFile(const LangOptions &LangOpts,
+                       const Preprocessor *PP) override {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    Target.BeginSourceFile(LangOpts, PP);
+  }
+
+  void EndSourceFile() override {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    Target.EndSourceFile();
+  }
+
+  void finish() override {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    Target.finish();
+  }
+
+  bool IncludeInDiagnosticCounts() const override {
+    return Target.IncludeInDiagnosticCounts();
+  }
+
+  void HandleDiagnostic(DiagnosticsEngine::Level DiagLevel,
+                        const Diagnostic &Info) override {
+    DiagnosticConsumer::HandleDiagnostic(DiagLevel, Info);
+    std::lock_guard<std::mutex> Lock(Mutex);
+    Target.HandleDiagnostic(DiagLevel, Info);
+  }
+};
+
+/// \brief A compile command run by ClangTool::runConcurrently().
+struct ToolJob {
+  std::string File;
+  std::string Directory;
+  std::vector<std::string> CommandLine;
+  ToolAction *Action;
+};
+
+} // end anonymous namespace
+
+int ClangTool::runConcurrently(const std::function<ToolAction *()> &NextAction,
+                               unsigned Threads) {
+  llvm::SmallString<128> InitialDirectory;
+  if (std::error_code EC = llvm::sys::fs::current_path(InitialDirectory))
+    llvm::report_fatal_error("Cannot detect current path: " +
+                             Twine(EC.message()));
+
+  // The file system must not change once the threads start, so all the
+  // compile commands are computed and all the files are mapped here.
+  if (SeenWorkingDirectories.insert("/").second)
+    for (const auto &MappedFile : MappedFileContents)
+      if (llvm::sys::path::is_absolute(MappedFile.first))
+        InMemoryFileSystem->addFile(
+            MappedFile.first, 0,
+            llvm::MemoryBuffer::getMemBuffer(MappedFile.second));
+
+  std::vector<ToolJob> Jobs;
+  for (const auto &SourcePath : SourcePaths) {
+    std::string File(getAbsolutePath(SourcePath));
+    std::vector<CompileCommand> CompileCommandsForFile =
+        Compilations.getCompileCommands(File);
+    if (CompileCommandsForFile.empty()) {
+      llvm::errs() << "Skipping " << File << ". Compile command not found.\n";
+      continue;
+    }
+    for (CompileCommand &CompileCommand : CompileCommandsForFile) {
+      // The relative file mappings are resolved against the directory of the
+      // command, as in run().
+      if (SeenWorkingDirectories.insert(CompileCommand.Directory).second) {
+        if (OverlayFileSystem->setCurrentWorkingDirectory(
+                CompileCommand.Directory))
+          llvm::report_fatal_error("Cannot chdir into \"" +
+                                   Twine(CompileCommand.Directory) + "\n!");
+        for (const auto &MappedFile : MappedFileContents)
+          if (!llvm::sys::path::is_absolute(MappedFile.first))
+            InMemoryFileSystem->addFile(
+                MappedFile.first, 0,
+                llvm::MemoryBuffer::getMemBuffer(MappedFile.second));
+      }
+
+      ToolJob Job;
+      Job.File = File;
+      Job.Directory = CompileCommand.Directory;
+      Job.CommandLine = CompileCommand.CommandLine;
+      if (ArgsAdjuster)
+        Job.CommandLine =
+            ArgsAdjuster(Job.CommandLine, CompileCommand.Filename);
+      assert(!Job.CommandLine.empty());
+      injectResourceDir(Job.CommandLine, "clang_tool", &StaticSymbol);
+      Job.Action = NextAction();
+      Jobs.push_back(std::move(Job));
+    }
+  }
+  if (OverlayFileSystem->setCurrentWorkingDirectory(InitialDirectory.c_str()))
+    llvm::report_fatal_error("Cannot chdir into \"" +
+                             Twine(InitialDirectory) + "\n!");
+  if (Jobs.empty())
+    return 0;
+
+  // Each translation unit has its own file manager and working directory,
+  // over a cache that reads every file once for all of them.
+  IntrusiveRefCntPtr<vfs::SharedFileCache> Cache(new vfs::SharedFileCache);
+  // Guards the output, the diagnostic consumer and ProcessingFailed.
+  std::mutex OutputMutex;
+  bool ProcessingFailed = false;
+  auto RunJob = [&](ToolJob &Job) {
+    IntrusiveRefCntPtr<vfs::FileSystem> FS(
+        new vfs::SharedCacheFileSystem(Cache, OverlayFileSystem));
+    if (FS->setCurrentWorkingDirectory(Job.Directory))
+      llvm::report_fatal_error("Cannot chdir into \"" + Twine(Job.Directory) +
+                               "\n!");
+    IntrusiveRefCntPtr<FileManager> JobFiles(
+        new FileManager(FileSystemOptions(), FS));
+
+    // Without a consumer, the diagnostics of the translation unit are printed
+    // together once it is done.
+    std::string Output;
+    llvm::raw_string_ostream OS(Output);
+    IntrusiveRefCntPtr<DiagnosticOptions> DiagOpts(new DiagnosticOptions);
+    TextDiagnosticPrinter DiagnosticPrinter(OS, DiagOpts.get());
+    std::unique_ptr<LockingDiagnosticConsumer> Forwarder;
+    if (DiagConsumer)
+      Forwarder = llvm::make_unique<LockingDiagnosticConsumer>(*DiagConsumer,
+                                                               OutputMutex);
+
+    DEBUG({
+      std::lock_guard<std::mutex> Lock(OutputMutex);
+      llvm::dbgs() << "Processing: " << Job.File << ".\n";
+    });
+    ToolInvocation Invocation(std::move(Job.CommandLine), Job.Action,
+                              JobFiles.get(), PCHContainerOps);
+    if (Forwarder)
+      Invocation.setDiagnosticConsumer(Forwarder.get());
+    else
+      Invocation.setDiagnosticConsumer(&DiagnosticPrinter);
+    bool Success = Invocation.run();
+    if (!Success)
+      OS << "Error while processing " << Job.File << ".\n";
+
+    std::lock_guard<std::mutex> Lock(OutputMutex);
+    llvm::errs() << OS.str();
+    if (!Success)
+      ProcessingFailed = true;
+  };
+
+  llvm::ThreadPool Pool(std::min<size_t>(Threads, Jobs.size()));
+  for (ToolJob &Job : Jobs)
+    Pool.async([&RunJob, &Job] { RunJob(Job); });
+  Pool.wait();
+  return ProcessingFailed ? 1 : 0;
+}
+
+namespace {
+
 class ASTBuilderAction : public ToolAction {
   std::vector<std::unique_ptr<ASTUnit>> &ASTs;
 
@@ -492,9 +660,29 @@ public:
 };
 }
 
-int ClangTool::buildASTs(std::vector<std::unique_ptr<ASTUnit>> &ASTs) {
-  ASTBuilderAction Action(ASTs);
-  return run(&Action);
+int ClangTool::buildASTs(std::vector<std::unique_ptr<ASTUnit>> &ASTs,
+                         unsigned Threads) {
+  if (Threads <= 1) {
+    ASTBuilderAction Action(ASTs);
+    return run(&Action);
+  }
+
+  // Each translation unit builds its ASTs into its own vector, so that they
+  // can be appended in order.
+  std::vector<std::unique_ptr<std::vector<std::unique_ptr<ASTUnit>>>> JobASTs;
+  std::vector<std::unique_ptr<ASTBuilderAction>> Actions;
+  int Result = runConcurrently(
+      [&] {
+        JobASTs.push_back(
+            llvm::make_unique<std::vector<std::unique_ptr<ASTUnit>>>());
+        Actions.push_back(llvm::make_unique<ASTBuilderAction>(*JobASTs.back()));
+        return Actions.back().get();
+      },
+      Threads);
+  for (auto &Units : JobASTs)
+    for (auto &AST : *Units)
+      ASTs.push_back(std::move(AST));
+  return Result;
 }
 
 std::unique_ptr<ASTUnit>
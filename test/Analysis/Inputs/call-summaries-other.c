@@ -0,0 +1,15 @@
+int counter;
+
+int peek(int *p) { return *p; }
+
+void poke(int *p) { *p = 0; }
+
+void bump(void) { counter++; }
+
+int get_flag(int x) {
+  if (x)
+    return 1;
+  return 0;
+}
+
+const char *name(void) { return "name"; }
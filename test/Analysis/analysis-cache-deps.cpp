@@ -0,0 +1,62 @@
+// RUN: rm -f %t.cache
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-display-progress -analyzer-config analysis-cache=%t.cache -verify %s 2>&1 | grep Path | FileCheck -check-prefix=FIRST %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-display-progress -analyzer-config analysis-cache=%t.cache -verify -DCHANGED %s 2>&1 | grep Path | FileCheck -check-prefix=CHANGED %s
+// expected-no-diagnostics
+
+// The functions are analyzed again when the value of an enumerator, the
+// attributes of a callee or an overrider of a virtual method they call
+// change, even if their names and types do not.
+
+enum Kind {
+#ifdef CHANGED
+  Zero = 1
+#else
+  Zero = 0
+#endif
+};
+
+int uses_enumerator() {
+  return 1 / (Zero + 1);
+}
+
+#ifdef CHANGED
+void stop() __attribute__((noreturn));
+#else
+void stop();
+#endif
+
+void uses_attribute(int *p) {
+  if (!p)
+    stop();
+}
+
+struct Base {
+  virtual int get() { return 1; }
+};
+
+struct Derived : Base {
+#ifdef CHANGED
+  int get() override { return 2; }
+#else
+  int get() override { return 3; }
+#endif
+};
+
+int uses_virtual(Base *b) {
+  return b->get();
+}
+
+int unchanged(int x) {
+  return x + 1;
+}
+
+// FIRST-DAG: uses_enumerator
+// FIRST-DAG: uses_attribute
+// FIRST-DAG: uses_virtual
+// FIRST-DAG: unchanged
+
+// CHANGED-NOT: unchanged
+// CHANGED-DAG: uses_enumerator
+// CHANGED-DAG: uses_attribute
+// CHANGED-DAG: uses_virtual
+// CHANGED-NOT: unchanged
@@ -0,0 +1,34 @@
+// RUN: rm -f %t.cache
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-display-progress -analyzer-config analysis-cache=%t.cache -verify %s 2>&1 | grep Path | FileCheck -check-prefix=FIRST %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-display-progress -analyzer-config analysis-cache=%t.cache -verify %s 2>&1 | grep Path | FileCheck -check-prefix=CACHED %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-display-progress -analyzer-config analysis-cache=%t.cache -verify -DCHANGED %s 2>&1 | grep Path | FileCheck -check-prefix=CHANGED %s
+
+// The functions in which no bugs were found are only analyzed again when
+// they, or the functions they inline, change.
+
+int helper(int x) {
+#ifdef CHANGED
+  return x + 2;
+#else
+  return x + 1;
+#endif
+}
+
+int clean(int x) {
+  return helper(x);
+}
+
+void buggy() {
+  int *p = 0;
+  *p = 1; // expected-warning{{Dereference of null pointer}}
+}
+
+// FIRST-DAG: clean
+// FIRST-DAG: buggy
+
+// CACHED-NOT: {{clean|helper}}
+// CACHED: buggy
+// CACHED-NOT: {{clean|helper}}
+
+// CHANGED-DAG: clean
+// CHANGED-DAG: buggy
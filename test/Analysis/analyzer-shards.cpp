@@ -0,0 +1,23 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-display-progress -analyzer-config shard-count=2,shard-index=0 %s 2> %t.0
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-display-progress -analyzer-config shard-count=2,shard-index=1 %s 2> %t.1
+// RUN: cat %t.0 %t.1 | grep Syntax | sort | FileCheck %s
+// RUN: cat %t.0 %t.1 | grep Path | sort | FileCheck %s
+
+// A shard index out of range analyzes nothing.
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-display-progress -analyzer-config shard-count=2,shard-index=2 %s 2>&1 | count 0
+
+// Every function is analyzed by exactly one of the shards.
+
+void f1() {}
+void f2() {}
+void f3() {}
+void f4() {}
+void f5() {}
+void f6() {}
+
+// CHECK: analyzer-shards.cpp f1()
+// CHECK-NEXT: analyzer-shards.cpp f2()
+// CHECK-NEXT: analyzer-shards.cpp f3()
+// CHECK-NEXT: analyzer-shards.cpp f4()
+// CHECK-NEXT: analyzer-shards.cpp f5()
+// CHECK-NEXT: analyzer-shards.cpp f6()
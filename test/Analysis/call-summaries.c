@@ -0,0 +1,60 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config call-summaries-output=%t.summaries %S/Inputs/call-summaries-other.c
+// RUN: FileCheck -check-prefix=SUMMARY -input-file=%t.summaries %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -analyzer-config call-summaries=%t.summaries -verify %s
+// RUN: not %clang_cc1 -analyze -analyzer-checker=core -analyzer-config call-summaries=%t.missing %s 2>&1 | FileCheck -check-prefix=MISSING %s
+
+// SUMMARY: c:@F@peek{{.}}0{{.}}--{{$}}
+// SUMMARY-NEXT: c:@F@poke{{.}}1{{.}}--{{$}}
+// SUMMARY-NEXT: c:@F@bump{{.}}0{{.}}g-{{$}}
+// SUMMARY-NEXT: c:@F@get_flag{{.}}0{{.}}--{{.}}0{{.}}1{{$}}
+// SUMMARY-NEXT: c:@F@name{{.}}0{{.}}-n{{$}}
+
+// MISSING: error: unable to read analyzer call summaries '{{.*}}.missing'
+
+void clang_analyzer_eval(int);
+
+int peek(int *p);
+void poke(int *p);
+void bump(void);
+int get_flag(int x);
+const char *name(void);
+void unknown(int *p);
+
+int global;
+
+void testPreservedArgument() {
+  int x = 1;
+  peek(&x);
+  clang_analyzer_eval(x == 1); // expected-warning{{TRUE}}
+}
+
+void testModifiedArgument() {
+  int x = 1;
+  poke(&x);
+  clang_analyzer_eval(x == 1); // expected-warning{{UNKNOWN}}
+}
+
+void testGlobals() {
+  global = 1;
+  peek(&global);
+  clang_analyzer_eval(global == 1); // expected-warning{{TRUE}}
+  bump();
+  clang_analyzer_eval(global == 1); // expected-warning{{UNKNOWN}}
+}
+
+void testReturnRange(int x) {
+  int flag = get_flag(x);
+  clang_analyzer_eval(flag >= 0); // expected-warning{{TRUE}}
+  clang_analyzer_eval(flag <= 1); // expected-warning{{TRUE}}
+  clang_analyzer_eval(flag == 1); // expected-warning{{UNKNOWN}}
+}
+
+void testNonNullReturn() {
+  clang_analyzer_eval(name() != 0); // expected-warning{{TRUE}}
+}
+
+void testNoSummary() {
+  int x = 1;
+  unknown(&x);
+  clang_analyzer_eval(x == 1); // expected-warning{{UNKNOWN}}
+}
@@ -0,0 +1,17 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config checker-profile=true %s 2>&1 | FileCheck %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core %s 2>&1 | FileCheck -check-prefix=DISABLED %s
+
+int divide(int x) {
+  return 100 / x;
+}
+
+int load(int *p) {
+  return *p;
+}
+
+// CHECK: Checker callback profile
+// CHECK: Time (s) Calls Callback Checker
+// CHECK-DAG: {{[0-9]+\.[0-9]+ +[0-9]+ +PreStmt +core.DivideZero}}
+// CHECK-DAG: {{[0-9]+\.[0-9]+ +[0-9]+ +Location +core.NullDereference}}
+
+// DISABLED-NOT: Checker callback profile
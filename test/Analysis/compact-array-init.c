@@ -0,0 +1,34 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -verify %s
+
+void clang_analyzer_eval(int);
+
+#define X4(x) x, x, x, x
+#define X16(x) X4(x), X4(x), X4(x), X4(x)
+#define X256(x) X16(x), X16(x), X16(x), X16(x), X16(x), X16(x), X16(x), \
+                X16(x), X16(x), X16(x), X16(x), X16(x), X16(x), X16(x), \
+                X16(x), X16(x)
+#define X1024(x) X256(x), X256(x), X256(x), X256(x)
+
+void integers() {
+  short table[2048] = { -1, 2, X1024(3) };
+  clang_analyzer_eval(table[0] == -1); // expected-warning{{TRUE}}
+  clang_analyzer_eval(table[1] == 2); // expected-warning{{TRUE}}
+  clang_analyzer_eval(table[1025] == 3); // expected-warning{{TRUE}}
+  clang_analyzer_eval(table[1026] == 0); // expected-warning{{TRUE}}
+}
+
+void unsigned_bytes() {
+  unsigned char table[] = { 0x12, 0xff, X1024(0x80) };
+  clang_analyzer_eval(table[1] == 255); // expected-warning{{TRUE}}
+  clang_analyzer_eval(table[512] == 128); // expected-warning{{TRUE}}
+}
+
+void floats() {
+  float table[] = { 1.5, X1024(0.25f) };
+  clang_analyzer_eval(table[0] == 1.5); // expected-warning{{UNKNOWN}}
+}
+
+int divide(int i) {
+  int table[] = { 0, X1024(1) };
+  return 1 / table[i ? 1 : 0]; // expected-warning{{Division by zero}}
+}
@@ -0,0 +1,25 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-max-loop 100 -analyzer-config max-nodes=300,exploration_strategy=unexplored_first -verify %s
+
+// With a node budget that a long loop exhausts, exploring the blocks that
+// were not entered yet first still reaches the other branch, whichever of
+// them the loop is in.
+
+void loopInThenBranch(int a, int n) {
+  if (a) {
+    for (int i = 0; i < n; ++i)
+      a += i;
+  } else {
+    int *p = 0;
+    *p = a; // expected-warning{{Dereference of null pointer}}
+  }
+}
+
+void loopInElseBranch(int a, int n) {
+  if (a) {
+    int *p = 0;
+    *p = a; // expected-warning{{Dereference of null pointer}}
+  } else {
+    for (int i = 0; i < n; ++i)
+      a += i;
+  }
+}
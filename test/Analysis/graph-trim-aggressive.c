@@ -0,0 +1,13 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config graph-trim-interval=1,graph-trim-aggressive=true -analyzer-output=text -verify %s
+
+// Reclaiming the nodes of lvalue and non-consumed expressions keeps the
+// bugs and the essential events of their paths.
+
+int deref(int *p, int flag) {
+  int *q = p;
+  if (flag) // expected-note {{Assuming 'flag' is not equal to 0}}
+            // expected-note@-1 {{Taking true branch}}
+    q = 0; // expected-note {{Null pointer value stored to 'q'}}
+  return *q; // expected-warning {{Dereference of null pointer (loaded from variable 'q')}}
+             // expected-note@-1 {{Dereference of null pointer (loaded from variable 'q')}}
+}
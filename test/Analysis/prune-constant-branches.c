@@ -0,0 +1,51 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -analyzer-max-loop 4 -analyzer-config widen-loops=true -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -analyzer-max-loop 4 -analyzer-config widen-loops=true,prune-constant-branches=true -DPRUNE -verify %s
+
+void clang_analyzer_warnIfReached();
+
+void debug_flag_after_widened_loop(int n) {
+  int debug = 0;
+  int i;
+  // Widening the loop invalidates 'debug' along with the other locals.
+  for (i = 0; i < n; ++i) {}
+  if (debug) {
+#ifndef PRUNE
+    // expected-warning@+2 {{REACHABLE}}
+#endif
+    clang_analyzer_warnIfReached();
+  }
+}
+
+void flag_set_on_every_path(int n) {
+  int trace;
+  if (n)
+    trace = 0;
+  else
+    trace = 2 - 2;
+  for (int i = 0; i < n; ++i) {}
+  if (trace || n == 12345) {
+    clang_analyzer_warnIfReached(); // expected-warning {{REACHABLE}}
+  }
+  if (!trace) {
+    clang_analyzer_warnIfReached(); // expected-warning {{REACHABLE}}
+  }
+}
+
+void flag_changed_in_loop(int n) {
+  int changed = 0;
+  for (int i = 0; i < n; ++i)
+    changed = 1;
+  if (changed) {
+    clang_analyzer_warnIfReached(); // expected-warning {{REACHABLE}}
+  }
+}
+
+void escape(int *);
+
+void flag_escaped(int n) {
+  int flag = 0;
+  escape(&flag);
+  if (flag) {
+    clang_analyzer_warnIfReached(); // expected-warning {{REACHABLE}}
+  }
+}
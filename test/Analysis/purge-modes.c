@@ -0,0 +1,18 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,unix.Malloc -analyzer-purge=statement -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,unix.Malloc -analyzer-purge=statement -analyzer-config purge-statement-interval=4 -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,unix.Malloc -analyzer-purge=block -verify %s
+
+typedef __typeof(sizeof(int)) size_t;
+void *malloc(size_t);
+void free(void *);
+
+// Each function is on a single line, so that the leaks are reported on the
+// same line whether the pointer is found dead right away or later.
+
+void leak_overwritten(void) { int *p = malloc(4); p = 0; } // expected-warning {{leak}}
+
+void leak_in_branch(int c) { int *p = malloc(4); if (c) { p = 0; return; } free(p); } // expected-warning {{leak}}
+
+void no_leak(int c) { int *p = malloc(4); int x = c + 1; int y = x * 2; *p = y; free(p); }
+
+void use_after_free(void) { int *p = malloc(4); free(p); int x = 1; int y = x + 1; *p = y; } // expected-warning {{Use of memory after it is freed}}
@@ -0,0 +1,33 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-llvm -fcold-unlikely-calls %s -o - | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-llvm %s -o - | FileCheck %s --check-prefix=DEFAULT
+
+void log_error(const char *);
+void handle(int);
+__attribute__((cold)) void report(void) { log_error("report"); }
+
+// CHECK: define void @report() [[REPORT:#[0-9]+]] !section_prefix [[PREFIX:![0-9]+]] {
+// DEFAULT: define void @report() {{#[0-9]+}} {
+
+// CHECK-LABEL: define void @process(
+void process(int *p, int n) {
+  // CHECK: call void @log_error({{.*}}) [[COLD:#[0-9]+]]
+  // CHECK: call void @handle({{.*}}) [[WARM:#[0-9]+]]
+  if (__builtin_expect(p == 0, 0))
+    log_error("null");
+  else
+    handle(*p);
+
+  // CHECK: call void @handle({{.*}}) [[WARM]]
+  // CHECK: call void @report() [[COLD]]
+  if (__builtin_expect(n > 0, 1))
+    handle(n);
+  else
+    report();
+}
+
+// CHECK-DAG: attributes [[REPORT]] = { {{.*}}cold
+// CHECK-DAG: attributes [[COLD]] = { cold nounwind }
+// CHECK-DAG: attributes [[WARM]] = { nounwind }
+// CHECK: [[PREFIX]] = !{!"function_section_prefix", !".unlikely"}
+
+// DEFAULT-NOT: = { cold nounwind }
@@ -0,0 +1,58 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -verify -emit-llvm %s -o - | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -verify -ast-dump %s | FileCheck %s --check-prefix AST
+
+#define X4(x) x, x, x, x
+#define X16(x) X4(x), X4(x), X4(x), X4(x)
+#define X256(x) X16(x), X16(x), X16(x), X16(x), X16(x), X16(x), X16(x), \
+                X16(x), X16(x), X16(x), X16(x), X16(x), X16(x), X16(x), \
+                X16(x), X16(x)
+#define X1024(x) X256(x), X256(x), X256(x), X256(x)
+
+// CHECK: @table = global [1026 x i8] c"\124\FF\FF
+// AST:      VarDecl {{.*}} table 'unsigned char [1026]' cinit
+// AST-NEXT: CompactArrayInitExpr {{.*}} 'unsigned char [1026]' 1026 elements of 1 bytes
+// AST-NEXT: syntactic form
+// AST-NEXT: InitListExpr {{.*}} 'unsigned char [1026]'
+unsigned char table[] = { 0x12, 0x34, X1024(0xff) };
+
+// The elements past the initialized ones are zero.
+// CHECK: @shorts = global [2048 x i16] [i16 -1, i16 2, i16 3, i16 3,
+// CHECK-SAME: i16 3, i16 0, i16 0,
+// AST:      VarDecl {{.*}} shorts 'short [2048]' cinit
+// AST-NEXT: CompactArrayInitExpr {{.*}} 'short [2048]' 1026 elements of 2 bytes
+short shorts[2048] = { -1, (2), X1024(+3) };
+
+// CHECK: @floats = global [1026 x float] [float 1.500000e+00, float -2.000000e+00, float 2.500000e-01,
+// AST:      VarDecl {{.*}} floats 'float [1026]' cinit
+// AST-NEXT: CompactArrayInitExpr {{.*}} 'float [1026]' 1026 elements of 4 bytes
+float floats[] = { 1.5, -2.0, X1024(0.25f) };
+
+// CHECK: @longs = global [1025 x i64] [i64 -9223372036854775807, i64 -1,
+// AST:      VarDecl {{.*}} longs 'long [1025]' cinit
+// AST-NEXT: CompactArrayInitExpr {{.*}} 'long [1025]' 1025 elements of 8 bytes
+long longs[] = { -9223372036854775807L, X1024(-1) };
+
+// Values that are converted, and lists that are too short, are checked
+// element by element.
+// AST:      VarDecl {{.*}} truncated 'unsigned char [1025]' cinit
+// AST-NEXT: InitListExpr {{.*}} 'unsigned char [1025]'
+unsigned char truncated[] = { 256, X1024(0) }; // expected-warning {{implicit conversion from 'int' to 'unsigned char' changes value from 256 to 0}}
+// AST:      VarDecl {{.*}} inexact 'float [1025]' cinit
+// AST-NEXT: InitListExpr {{.*}} 'float [1025]'
+float inexact[] = { 0.1, X1024(0.0) };
+// AST:      VarDecl {{.*}} converted 'double [1025]' cinit
+// AST-NEXT: InitListExpr {{.*}} 'double [1025]'
+double converted[] = { 1, X1024(0.0) };
+// AST:      VarDecl {{.*}} short_list 'int [256]' cinit
+// AST-NEXT: InitListExpr {{.*}} 'int [256]'
+int short_list[] = { X256(1) };
+
+// A local array is copied from a constant.
+// CHECK: @local.l = private unnamed_addr constant [1025 x i32] [i32 7, i32 8,
+// CHECK-LABEL: define void @local(
+// CHECK: call void @llvm.memcpy{{.*}}@local.l
+void use(int *);
+void local(void) {
+  int l[] = { 7, X1024(8) };
+  use(l);
+}
@@ -0,0 +1,34 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O1 -disable-llvm-optzns -emit-llvm %s -o - | FileCheck %s --check-prefix=NOPASSES
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O1 -fearly-function-passes -emit-llvm %s -o - | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O1 -fearly-function-passes -emit-obj %s -o /dev/null
+
+// The functions optimized while the rest of the file was generated, and those
+// whose definitions only came later, all go through the per-function passes
+// once.
+
+// NOPASSES: alloca
+
+int later(int x);
+
+// CHECK-LABEL: define i32 @early(
+// CHECK-NOT: alloca
+// CHECK: ret i32
+int early(int x) {
+  int y = x + 1;
+  return later(y);
+}
+
+// CHECK-LABEL: define i32 @later(
+// CHECK-NOT: alloca
+// CHECK: ret i32
+int later(int x) {
+  int y = x * 2;
+  return y;
+}
+
+static int helper(int x) { return x - 1; }
+
+// CHECK-LABEL: define i32 @uses_helper(
+// CHECK-NOT: alloca
+// CHECK: ret i32
+int uses_helper(int x) { return helper(x); }
@@ -7,6 +7,14 @@
 // RUN:     | FileCheck -check-prefix=CHECK-NO-BC -check-prefix=CHECK-NO-BC2 %s
 // RUN: not %clang_cc1 -triple i386-pc-linux-gnu -DBITCODE -O3 -emit-llvm -o - \
 // RUN:     -mlink-bitcode-file %t.bc %s 2>&1 | FileCheck -check-prefix=CHECK-BC %s
+// Jobs that run in the same process share the bitcode they link in.
+// RUN: rm -rf %t.dir && mkdir %t.dir
+// RUN: cp %s %t.dir/first.c && cp %s %t.dir/second.c
+// RUN: cd %t.dir && %clang -fintegrated-cc1 -target i386-pc-linux-gnu -O3 \
+// RUN:     -S -emit-llvm -Xclang -mlink-bitcode-file -Xclang %t.bc \
+// RUN:     first.c second.c
+// RUN: FileCheck -check-prefix=CHECK-NO-BC %s < %t.dir/first.ll
+// RUN: FileCheck -check-prefix=CHECK-NO-BC %s < %t.dir/second.ll
 // Make sure we deal with failure to load the file.
 // RUN: not %clang_cc1 -triple i386-pc-linux-gnu -mlink-bitcode-file no-such-file.bc \
 // RUN:    -emit-llvm -o - %s 2>&1 | FileCheck -check-prefix=CHECK-NO-FILE %s
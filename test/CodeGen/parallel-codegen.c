@@ -0,0 +1,18 @@
+// REQUIRES: x86-registered-target
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-obj \
+// RUN:   -parallel-codegen-output %t.1.o -o %t.0.o %s
+// RUN: llvm-nm %t.0.o %t.1.o | FileCheck %s
+
+// The definitions are generated in either partition, and the internal ones
+// stay local.
+// CHECK-DAG: .0.o:
+// CHECK-DAG: .1.o:
+// CHECK-DAG: T f
+// CHECK-DAG: T g
+// CHECK-DAG: t helper
+
+static int helper(int x) { return x + 1; }
+
+int f(int x) { return helper(x); }
+
+int g(int x) { return x * 2; }
@@ -0,0 +1,17 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -emit-llvm -print-stats %s -o /dev/null 2>&1 | FileCheck %s
+
+// The function type that refers to the incomplete struct is converted to a
+// placeholder, so the type cache is flushed when the struct is completed, but
+// not again by the layouts done afterwards.
+
+// CHECK: *** CodeGen Type Stats:
+// CHECK-NEXT: 4 record types converted, 4 laid out, with 2 bit-fields
+// CHECK-NEXT: {{[0-9]+}} cached types, 1 flushes of the type cache for skipped layouts
+
+struct S;
+void (*fp)(struct S);
+struct S { int a : 3, b : 5; };
+
+struct T { struct S s; int x; } t;
+struct U { int y; } u;
+struct V { struct U u; } v;
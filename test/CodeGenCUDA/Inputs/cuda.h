@@ -18,5 +18,11 @@ typedef struct cudaStream *cudaStream_t;
 
 int cudaConfigureCall(dim3 gridSize, dim3 blockSize, size_t sharedSize = 0,
                       cudaStream_t stream = 0);
+extern "C" int __cudaPushCallConfiguration(dim3 gridSize, dim3 blockSize,
+                                           size_t sharedSize = 0,
+                                           cudaStream_t stream = 0);
+extern "C" int cudaLaunchKernel(const void *func, dim3 gridDim, dim3 blockDim,
+                                void **args, size_t sharedMem,
+                                cudaStream_t stream);
 
 extern "C" __device__ int printf(const char*, ...);
@@ -0,0 +1,38 @@
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -fcuda-launch-kernel -emit-llvm %s -o - | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -emit-llvm %s -o - | FileCheck %s --check-prefix LEGACY
+
+#include "Inputs/cuda.h"
+
+// LEGACY-NOT: cudaLaunchKernel
+// LEGACY-NOT: CallConfiguration
+
+// The stub passes the addresses of all of its arguments at once.
+// CHECK-LABEL: define void @_Z6kernelifPc(
+// CHECK-NOT: cudaSetupArgument
+// CHECK: [[ARGS:%kernel_args]] = alloca [3 x i8*],
+// CHECK: [[GRID:%grid_dim]] = alloca %struct.dim3,
+// CHECK: [[BLOCK:%block_dim]] = alloca %struct.dim3,
+// CHECK: [[SHMEM:%shared_mem]] = alloca i64,
+// CHECK: [[STREAM:%stream]] = alloca i8*,
+// CHECK: [[ARG0:%.+]] = getelementptr inbounds [3 x i8*], [3 x i8*]* [[ARGS]], i64 0, i64 0
+// CHECK: store i8* %{{.+}}, i8** [[ARG0]],
+// CHECK: [[ARG1:%.+]] = getelementptr inbounds [3 x i8*], [3 x i8*]* [[ARGS]], i64 0, i64 1
+// CHECK: store i8* %{{.+}}, i8** [[ARG1]],
+// CHECK: [[ARG2:%.+]] = getelementptr inbounds [3 x i8*], [3 x i8*]* [[ARGS]], i64 0, i64 2
+// CHECK: store i8* %{{.+}}, i8** [[ARG2]],
+// CHECK: call i32 @__cudaPopCallConfiguration(%struct.dim3* [[GRID]], %struct.dim3* [[BLOCK]], i64* [[SHMEM]], i8** [[STREAM]])
+// CHECK: [[ARGSPTR:%.+]] = bitcast [3 x i8*]* [[ARGS]] to i8**
+// CHECK: call i32 @cudaLaunchKernel(i8* bitcast ({{.+}}@_Z6kernelifPc to i8*), {{.+}}, i8** [[ARGSPTR]], i64 %{{.+}}, %struct.cudaStream* %{{.+}})
+// CHECK-NOT: cudaLaunch(
+// CHECK: ret void
+// LEGACY-LABEL: define void @_Z6kernelifPc(
+// LEGACY: call i32 @cudaSetupArgument(
+// LEGACY: call i32 @cudaLaunch(
+__global__ void kernel(int x, float y, char *z) {}
+
+// CHECK-LABEL: define void @_Z4hostv(
+// CHECK: call i32 @__cudaPushCallConfiguration(
+// CHECK: call void @_Z6kernelifPc(
+// LEGACY-LABEL: define void @_Z4hostv(
+// LEGACY: call i32 @_Z17cudaConfigureCall4dim3S_mP10cudaStream(
+void host() { kernel<<<1, 1>>>(1, 2.0f, 0); }
@@ -0,0 +1,55 @@
+// RUN: echo "GPU binary would be here" > %t
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -emit-llvm %s -fcuda-include-gpubinary %t -fcuda-lazy-registration -o - | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -emit-llvm %s -fcuda-include-gpubinary %t -fcuda-lazy-registration -o - -DNOKERNELS \
+// RUN:   | FileCheck %s -check-prefix=NOKERNELS
+
+#include "Inputs/cuda.h"
+
+__device__ int device_var;
+
+// The module is not registered at startup, only unregistered at exit.
+// CHECK: @__cuda_registration_state = internal global i32 0
+// CHECK-NOT: @llvm.global_ctors
+// CHECK: @llvm.global_dtors = appending global {{.*}}@__cuda_module_dtor
+
+// NOKERNELS-NOT: __cuda_registration_state
+// NOKERNELS: @llvm.global_ctors = appending global {{.*}}@__cuda_module_ctor
+// NOKERNELS-NOT: __cuda_register_lazily
+
+#ifndef NOKERNELS
+// Each stub registers the module before its first launch.
+// CHECK-LABEL: define void @_Z10kernelfunciii(
+// CHECK: [[STATE:%.+]] = load atomic i32, i32* @__cuda_registration_state acquire, align 4
+// CHECK: [[DONE:%.+]] = icmp eq i32 [[STATE]], 2
+// CHECK: br i1 [[DONE]], label %[[END:.+]], label %[[REGISTER:.+]]
+// CHECK: [[REGISTER]]:
+// CHECK: call void @__cuda_register_lazily()
+// CHECK: [[END]]:
+// CHECK: call{{.*}}cudaSetupArgument
+// CHECK: call{{.*}}cudaLaunch
+__global__ void kernelfunc(int i, int j, int k) {}
+
+// CHECK: define internal void @__cuda_module_ctor
+// CHECK: call{{.*}}cudaRegisterFatBinary{{.*}}__cuda_fatbin_wrapper
+// CHECK: call void @__cuda_register_globals
+
+// Only one thread registers the module, the other ones wait.
+// CHECK: define internal void @__cuda_register_lazily() [[ATTRS:#[0-9]+]]
+// CHECK: [[PAIR:%.+]] = cmpxchg i32* @__cuda_registration_state, i32 0, i32 1 acquire acquire
+// CHECK: [[STARTED:%.+]] = extractvalue { i32, i1 } [[PAIR]], 1
+// CHECK: br i1 [[STARTED]], label %register, label %wait
+// CHECK: register:
+// CHECK: call void @__cuda_module_ctor(i8* null)
+// CHECK: store atomic i32 2, i32* @__cuda_registration_state release, align 4
+// CHECK: wait:
+// CHECK: load atomic i32, i32* @__cuda_registration_state acquire, align 4
+
+// CHECK: define internal void @__cuda_module_dtor
+// CHECK: [[HANDLE:%.+]] = load i8**, i8*** @__cuda_gpubin_handle
+// CHECK: [[NULL:%.+]] = icmp eq i8** [[HANDLE]], null
+// CHECK: br i1 [[NULL]], label %unregister.next, label %unregister
+// CHECK: unregister:
+// CHECK: call void @__cudaUnregisterFatBinary(i8** [[HANDLE]])
+
+// CHECK: attributes [[ATTRS]] = { noinline nounwind }
+#endif
@@ -0,0 +1,55 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -std=c++11 -emit-llvm-only -Rpass-analysis=clang-copy -verify %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -std=c++11 -emit-llvm-only -Rpass-analysis=clang-copy -faggregate-copy-remark-threshold=256 %s 2>&1 | count 0
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -std=c++11 -emit-llvm-only -Rpass-analysis=loop-vectorize %s 2>&1 | count 0
+
+struct Big { char buf[128]; };
+struct Small { int i; };
+struct Counted {
+  Counted();
+  Counted(const Counted &);
+  char buf[100];
+};
+
+Big global;
+
+Big returnGlobal() {
+  return global; // expected-remark {{copying 128 bytes of 'Big' to return it by value}}
+}
+
+Big returnEither(bool b) {
+  Big x, y;
+  if (b)
+    return x; // expected-remark {{copying 128 bytes of 'Big' to return it, the named return value optimization does not apply}}
+  return y; // expected-remark {{copying 128 bytes of 'Big' to return it, the named return value optimization does not apply}}
+}
+
+// The object is constructed in the return slot.
+Big returnNamed() {
+  Big x;
+  return x;
+}
+
+Big returnTemporary() {
+  return Big();
+}
+
+void takeBig(Big);
+void takeSmall(Small);
+void takeCounted(Counted);
+
+void passByValue(Big &b, Small &s, Counted &c) {
+  takeBig(b); // expected-remark {{copying 128 bytes of 'Big' to pass it by value}}
+  takeSmall(s);
+  takeCounted(c); // expected-remark {{copying 100 bytes of 'Counted' to pass it by value}}
+  takeBig(Big());
+  takeBig(returnGlobal());
+}
+
+int capture() {
+  Big b;
+  Big arr[1];
+  auto byCopy = [b] { return b.buf[0]; }; // expected-remark {{copying 128 bytes of 'Big' to capture it by copy in a lambda}}
+  auto array = [arr] { return arr[0].buf[0]; }; // expected-remark {{copying 128 bytes of 'Big [1]' to capture it by copy in a lambda}}
+  auto byRef = [&b] { return b.buf[0]; };
+  return byCopy() + array() + byRef();
+}
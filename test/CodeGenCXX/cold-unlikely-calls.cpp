@@ -0,0 +1,21 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-llvm -fcxx-exceptions -fexceptions -fcold-unlikely-calls %s -o - | FileCheck %s
+
+struct Error {
+  Error(const char *);
+};
+int compute(int);
+
+// The calls that build the exception are cold, the others are not.
+// CHECK-LABEL: define i32 @_Z5checki(
+// CHECK: call i32 @_Z7computei(i32 {{.*}}){{$}}
+// CHECK: call i8* @__cxa_allocate_exception(i64 1)
+// CHECK: invoke void @_ZN5ErrorC1EPKc({{.*}}) [[COLD:#[0-9]+]]
+// CHECK: call void @__cxa_throw(
+int check(int x) {
+  int y = compute(x);
+  if (y < 0)
+    throw Error("negative");
+  return y;
+}
+
+// CHECK: attributes [[COLD]] = { cold }
@@ -0,0 +1,70 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -std=c++11 -flazy-dynamic-init -emit-llvm -o - %s | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -std=c++11 -emit-llvm -o - %s | FileCheck --check-prefix=EAGER %s
+
+int f();
+struct S {
+  S();
+  ~S();
+  int x;
+};
+
+// CHECK-LABEL: define internal void @_ZL1a.lazy_init()
+// CHECK:       call i32 @__cxa_guard_acquire(i64* @_ZGV{{.*}}1a)
+// CHECK:       call i32 @_Z1fv()
+// CHECK:       call void @__cxa_guard_release(i64* @_ZGV{{.*}}1a)
+// CHECK:       ret void
+
+// CHECK-LABEL: define internal void @_ZN12_GLOBAL__N_11sE.lazy_init()
+// CHECK:       call void @_ZN1SC1Ev(%struct.S* @_ZN12_GLOBAL__N_11sE)
+// CHECK:       call i32 @__cxa_atexit(
+// CHECK:       ret void
+
+static int a = f();
+namespace {
+S s;
+}
+static int c = 42;
+int external = f();
+[[clang::lazy_init]] extern int attributed;
+[[clang::lazy_init]] int defined = f();
+
+// CHECK-LABEL: define void @defined.lazy_init()
+// CHECK:       load atomic i8, i8* bitcast (i64* @_ZGV7defined to i8*) acquire
+// CHECK:       call i32 @__cxa_guard_acquire(i64* @_ZGV7defined)
+// CHECK:       [[CALL:%.+]] = call i32 @_Z1fv()
+// CHECK:       store i32 [[CALL]], i32* @defined
+// CHECK:       call void @__cxa_guard_release(i64* @_ZGV7defined)
+
+// Every use by name of a lazily initialized variable calls its
+// initialization function first.
+// CHECK-LABEL: define i32 @_Z3usev()
+// CHECK:       call void @_ZL1a.lazy_init()
+// CHECK-NEXT:  load i32, i32* @_ZL1a
+// CHECK:       call void @_ZN12_GLOBAL__N_11sE.lazy_init()
+// CHECK-NOT:   call
+// CHECK:       load i32, i32* @_ZL1c
+// CHECK-NOT:   call
+// CHECK:       load i32, i32* @external
+// CHECK:       call void @attributed.lazy_init()
+// CHECK-NEXT:  load i32, i32* @attributed
+// CHECK:       call void @defined.lazy_init()
+// CHECK-NEXT:  load i32, i32* @defined
+// CHECK:       ret i32
+// EAGER-LABEL: define i32 @_Z3usev()
+// EAGER-NOT:   @_ZL1a.lazy_init
+// EAGER:       call void @attributed.lazy_init()
+// EAGER:       call void @defined.lazy_init()
+int use() { return a + s.x + c + external + attributed + defined; }
+
+// CHECK: declare void @attributed.lazy_init()
+
+// Only the variable that isn't lazily initialized is initialized at startup.
+// CHECK-LABEL: define internal void @_GLOBAL__sub_I_lazy_dynamic_init.cpp()
+// CHECK-NEXT:  entry:
+// CHECK-NEXT:  call void @__cxx_global_var_init()
+// CHECK-NEXT:  ret void
+// EAGER-LABEL: define internal void @_GLOBAL__sub_I_lazy_dynamic_init.cpp()
+// EAGER:       call void @__cxx_global_var_init()
+// EAGER:       call void @__cxx_global_var_init.1()
+// EAGER:       call void @__cxx_global_var_init.2()
+// EAGER:       ret void
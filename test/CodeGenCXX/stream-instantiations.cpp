@@ -0,0 +1,21 @@
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -emit-llvm %s -o - | FileCheck %s --check-prefix=DEFERRED
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -emit-llvm -fstream-instantiations %s -o - | FileCheck %s --check-prefix=STREAMED
+
+template <typename T> T helper(T x) { return x; }
+template <typename T> T thrice(T x) { return helper(x) * 3; }
+template <typename T> T twice(T x) { return x * 2; }
+
+int use(int x) { return thrice(x) + twice(x); }
+
+// Without the flag, the instantiations are emitted after all of them have
+// been performed, depth first from the functions that use them.
+// DEFERRED-LABEL: define i32 @_Z3usei(
+// DEFERRED: define linkonce_odr i32 @_Z6thriceIiET_S0_(
+// DEFERRED: define linkonce_odr i32 @_Z6helperIiET_S0_(
+// DEFERRED: define linkonce_odr i32 @_Z5twiceIiET_S0_(
+
+// With it, each one is emitted as soon as it is instantiated.
+// STREAMED-LABEL: define i32 @_Z3usei(
+// STREAMED: define linkonce_odr i32 @_Z6thriceIiET_S0_(
+// STREAMED: define linkonce_odr i32 @_Z5twiceIiET_S0_(
+// STREAMED: define linkonce_odr i32 @_Z6helperIiET_S0_(
@@ -0,0 +1,3 @@
+inline void used_inline() {}
+inline void unused_inline() {}
+static void unused_static() {}
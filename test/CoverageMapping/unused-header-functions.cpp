@@ -0,0 +1,23 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -fprofile-instrument=clang -fcoverage-mapping -dump-coverage-mapping -emit-llvm-only -main-file-name unused-header-functions.cpp %s | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -fprofile-instrument=clang -fcoverage-mapping -fno-coverage-unused-header-functions -dump-coverage-mapping -emit-llvm-only -main-file-name unused-header-functions.cpp %s | FileCheck %s --check-prefix=SKIP --implicit-check-not=_Z13unused_inlinev:
+
+#include "Inputs/unused-header-functions.h"
+
+// CHECK-DAG: _Z11used_inlinev:
+// CHECK-DAG: _Z13unused_inlinev:
+// CHECK-DAG: _ZL13unused_staticv:
+// CHECK-DAG: _Z12unused_localv:
+
+// The translation units that use an inline function describe it, so the
+// others can leave it out. Static functions and those of the main file are
+// still described.
+// SKIP-DAG: _Z11used_inlinev:
+// SKIP-DAG: _ZL13unused_staticv:
+// SKIP-DAG: _Z12unused_localv:
+
+inline void unused_local() {}
+
+int main() {
+  used_inline();
+  return 0;
+}
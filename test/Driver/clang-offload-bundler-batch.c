@@ -0,0 +1,51 @@
+// REQUIRES: x86-registered-target
+// REQUIRES: powerpc-registered-target
+
+//
+// Generate the files to bundle.
+//
+// RUN: %clang -O0 -target powerpc64le-ibm-linux-gnu %s -E -o %t.i
+// RUN: %clang -O0 -target powerpc64le-ibm-linux-gnu %s -c -emit-llvm -o %t.bc
+// RUN: echo 'Content of device file 1' > %t.tgt1
+// RUN: echo 'Content of device file 2' > %t.tgt2
+
+//
+// Check that the operations of a batch give the same files as separate
+// invocations would.
+//
+// RUN: echo '-type=i -targets=host-powerpc64le-ibm-linux-gnu,openmp-x86_64-pc-linux-gnu -inputs=%t.i,%t.tgt1 -outputs=%t.bundle.i' > %t.batch1
+// RUN: echo '-type=bc -targets=host-powerpc64le-ibm-linux-gnu,openmp-x86_64-pc-linux-gnu -inputs=%t.bc,%t.tgt2 -outputs=%t.bundle.bc' >> %t.batch1
+// RUN: clang-offload-bundler -batch=%t.batch1 -batch-jobs=2
+// RUN: clang-offload-bundler -type=i -targets=host-powerpc64le-ibm-linux-gnu,openmp-x86_64-pc-linux-gnu -inputs=%t.i,%t.tgt1 -outputs=%t.single.i
+// RUN: clang-offload-bundler -type=bc -targets=host-powerpc64le-ibm-linux-gnu,openmp-x86_64-pc-linux-gnu -inputs=%t.bc,%t.tgt2 -outputs=%t.single.bc
+// RUN: diff %t.single.i %t.bundle.i
+// RUN: diff %t.single.bc %t.bundle.bc
+//
+// RUN: echo '-type=i -targets=host-powerpc64le-ibm-linux-gnu,openmp-x86_64-pc-linux-gnu -outputs=%t.res.i,%t.res.tgt1 -inputs=%t.bundle.i -unbundle' > %t.batch2
+// RUN: echo '-type=bc -targets=host-powerpc64le-ibm-linux-gnu,openmp-x86_64-pc-linux-gnu -outputs=%t.res.bc,%t.res.tgt2 -inputs=%t.bundle.bc -unbundle' >> %t.batch2
+// RUN: clang-offload-bundler -batch=%t.batch2
+// RUN: diff %t.i %t.res.i
+// RUN: diff %t.tgt1 %t.res.tgt1
+// RUN: diff %t.bc %t.res.bc
+// RUN: diff %t.tgt2 %t.res.tgt2
+
+//
+// Check that a failing operation is reported, and does not prevent the others
+// from being performed.
+//
+// RUN: rm -f %t.res.i
+// RUN: echo '-type=i -targets=host-powerpc64le-ibm-linux-gnu -outputs=%t.res.i -inputs=%t.notexist -unbundle' > %t.batch3
+// RUN: echo '-type=i -targets=host-powerpc64le-ibm-linux-gnu,openmp-x86_64-pc-linux-gnu -outputs=%t.res.i,%t.res.tgt1 -inputs=%t.bundle.i -unbundle' >> %t.batch3
+// RUN: echo '-type=a -targets=host-powerpc64le-ibm-linux-gnu -outputs=%t.res.a -inputs=%t.a -unbundle' >> %t.batch3
+// RUN: echo '-type=i -bogus' >> %t.batch3
+// RUN: not clang-offload-bundler -batch=%t.batch3 2>&1 | FileCheck %s --check-prefix CK-ERR
+// RUN: diff %t.i %t.res.i
+// CK-ERR: error: Can't open file {{.+}}.notexist: {{N|n}}o such file or directory
+// CK-ERR: error: archives cannot be unbundled in batch mode.
+// CK-ERR: error: unknown option '-bogus' in batch file.
+
+// Some code so that we can create a binary out of this file.
+int A = 0;
+void test_func(void) {
+  ++A;
+}
@@ -0,0 +1,68 @@
+// REQUIRES: zlib
+// REQUIRES: x86-registered-target
+// REQUIRES: powerpc-registered-target
+
+//
+// Generate the files to bundle.
+//
+// RUN: %clang -O0 -target powerpc64le-ibm-linux-gnu %s -c -emit-llvm -o %t.bc
+// RUN: %clang -O0 -target powerpc64le-ibm-linux-gnu %s -c -o %t.o
+// RUN: echo 'Content of device file 1' > %t.tgt1
+// RUN: echo 'Content of device file 2' > %t.tgt2
+
+//
+// Check compressed binary bundle/unbundle. The content that we have before
+// bundling must be the same we have after unbundling.
+//
+// RUN: clang-offload-bundler -type=bc -compress -targets=host-powerpc64le-ibm-linux-gnu,openmp-powerpc64le-ibm-linux-gnu,openmp-x86_64-pc-linux-gnu -inputs=%t.bc,%t.tgt1,%t.tgt2 -outputs=%t.bundle.bc
+// RUN: grep -q __CLANG_OFFLOAD_BUNDLE_ZLIB__ %t.bundle.bc
+// RUN: not grep -q 'Content of device file' %t.bundle.bc
+// RUN: clang-offload-bundler -type=bc -targets=host-powerpc64le-ibm-linux-gnu,openmp-powerpc64le-ibm-linux-gnu,openmp-x86_64-pc-linux-gnu -outputs=%t.res.bc,%t.res.tgt1,%t.res.tgt2 -inputs=%t.bundle.bc -unbundle
+// RUN: diff %t.bc %t.res.bc
+// RUN: diff %t.tgt1 %t.res.tgt1
+// RUN: diff %t.tgt2 %t.res.tgt2
+
+//
+// Check the device bundles of objects are compressed. The host bundle is a
+// place-holder and stays as is.
+//
+// RUN: clang-offload-bundler -type=o -compress -targets=host-powerpc64le-ibm-linux-gnu,openmp-powerpc64le-ibm-linux-gnu,openmp-x86_64-pc-linux-gnu -inputs=%t.o,%t.tgt1,%t.tgt2 -outputs=%t.bundle.o -### -dump-temporary-files 2>&1 \
+// RUN: | FileCheck %s --check-prefix CK-OBJ-CMD
+// CK-OBJ-CMD: private constant [1 x i8] zeroinitializer, section "__CLANG_OFFLOAD_BUNDLE__host-powerpc64le-ibm-linux-gnu"
+// CK-OBJ-CMD: private constant [{{[0-9]+}} x i8] c"__CLANG_OFFLOAD_BUNDLE_ZLIB__{{.+}}", section "__CLANG_OFFLOAD_BUNDLE__openmp-powerpc64le-ibm-linux-gnu"
+// CK-OBJ-CMD: private constant [{{[0-9]+}} x i8] c"__CLANG_OFFLOAD_BUNDLE_ZLIB__{{.+}}", section "__CLANG_OFFLOAD_BUNDLE__openmp-x86_64-pc-linux-gnu"
+
+//
+// Check the compressed device bundles of objects are decompressed when
+// unbundling. We have an already bundled file, as the bundling cannot be
+// tested in all host platforms that will run these tests.
+//
+// RUN: clang-offload-bundler -type=o -targets=host-powerpc64le-ibm-linux-gnu,openmp-powerpc64le-ibm-linux-gnu,openmp-x86_64-pc-linux-gnu -outputs=%t.res.o,%t.res.tgt1,%t.res.tgt2 -inputs=%s.o -unbundle
+// RUN: diff %s.o %t.res.o
+// RUN: diff %t.tgt1 %t.res.tgt1
+// RUN: diff %t.tgt2 %t.res.tgt2
+
+//
+// Check the device images of a static library are only extracted once when
+// several of its members hold identical ones. Host objects are all kept.
+//
+// RUN: rm -rf %t.dir && mkdir %t.dir
+// RUN: cp %s.o %t.dir/first.o
+// RUN: cp %s.o %t.dir/second.o
+// RUN: cd %t.dir && ar rcs lib.a first.o second.o
+// RUN: cd %t.dir && clang-offload-bundler -type=a -targets=host-powerpc64le-ibm-linux-gnu,openmp-powerpc64le-ibm-linux-gnu,openmp-x86_64-pc-linux-gnu -outputs=libhost.a,libtgt1.a,libtgt2.a -inputs=lib.a -unbundle
+// RUN: ar t %t.dir/libhost.a | FileCheck %s --check-prefix CK-AR-HOST
+// RUN: ar t %t.dir/libtgt1.a | FileCheck %s --check-prefix CK-AR-TGT1
+// RUN: ar t %t.dir/libtgt2.a | FileCheck %s --check-prefix CK-AR-TGT2
+// CK-AR-HOST: first-host-powerpc64le-ibm-linux-gnu.o
+// CK-AR-HOST: second-host-powerpc64le-ibm-linux-gnu.o
+// CK-AR-TGT1: first-openmp-powerpc64le-ibm-linux-gnu.o
+// CK-AR-TGT1-NOT: second-
+// CK-AR-TGT2: first-openmp-x86_64-pc-linux-gnu.o
+// CK-AR-TGT2-NOT: second-
+
+// Some code so that we can create a binary out of this file.
+int A = 0;
+void test_func(void) {
+  ++A;
+}
@@ -107,6 +107,9 @@
 // RUN: %clang -### -S -fcoverage-mapping %s 2>&1 | FileCheck -check-prefix=CHECK-COVERAGE-AND-GEN %s
 // RUN: %clang -### -S -fcoverage-mapping -fno-coverage-mapping %s 2>&1 | FileCheck -check-prefix=CHECK-DISABLE-COVERAGE %s
 // RUN: %clang -### -S -fprofile-instr-generate -fcoverage-mapping -fno-coverage-mapping %s 2>&1 | FileCheck -check-prefix=CHECK-DISABLE-COVERAGE %s
+// RUN: %clang -### -S -fprofile-instr-generate -fcoverage-mapping -fno-coverage-unused-header-functions %s 2>&1 | FileCheck -check-prefix=CHECK-NO-UNUSED-HEADER-FUNCTIONS %s
+// RUN: %clang -### -S -fprofile-instr-generate -fcoverage-mapping -fno-coverage-unused-header-functions -fcoverage-unused-header-functions %s 2>&1 | FileCheck -check-prefix=CHECK-UNUSED-HEADER-FUNCTIONS %s
+// RUN: %clang -### -S -fprofile-instr-generate -fprofile-instr-sample-period=1000 %s 2>&1 | FileCheck -check-prefix=CHECK-SAMPLE-PERIOD %s
 // CHECK-PROFILE-GENERATE: "-fprofile-instrument=clang"
 // CHECK-PROFILE-GENERATE-LLVM: "-fprofile-instrument=llvm"
 // CHECK-PROFILE-GENERATE-DIR: "-fprofile-instrument-path=/some/dir{{/|\\\\}}{{.*}}"
@@ -117,6 +120,9 @@
 // CHECK-DISABLE-USE-NOT: "-fprofile-instr-use"
 // CHECK-COVERAGE-AND-GEN: '-fcoverage-mapping' only allowed with '-fprofile-instr-generate'
 // CHECK-DISABLE-COVERAGE-NOT: "-fcoverage-mapping"
+// CHECK-NO-UNUSED-HEADER-FUNCTIONS: "-fcoverage-mapping" "-fno-coverage-unused-header-functions"
+// CHECK-UNUSED-HEADER-FUNCTIONS-NOT: "-fno-coverage-unused-header-functions"
+// CHECK-SAMPLE-PERIOD: "-fprofile-instrument=clang" "-fprofile-instr-sample-period=1000"
 
 // RUN: %clang -### -S -fprofile-use %s 2>&1 | FileCheck -check-prefix=CHECK-PROFILE-USE %s
 // RUN: %clang -### -S -fprofile-instr-use %s 2>&1 | FileCheck -check-prefix=CHECK-PROFILE-USE %s
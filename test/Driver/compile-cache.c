@@ -0,0 +1,37 @@
+// REQUIRES: clang-driver
+// REQUIRES: x86-registered-target
+
+// The second compilation copies the bundled object out of the cache entry
+// that the first one stores, without running any of the jobs.
+//
+// RUN: rm -rf %t.cache %t.o %t.first.o
+// RUN: env CLANG_COMPILE_CACHE=%t.cache %clang -v -fopenmp=libomp \
+// RUN:   -target x86_64-unknown-linux -fopenmp-targets=x86_64-pc-linux-gnu \
+// RUN:   -c %s -o %t.o 2>&1 | FileCheck -check-prefix=MISS %s
+// RUN: mv %t.o %t.first.o
+// RUN: env CLANG_COMPILE_CACHE=%t.cache %clang -v -fopenmp=libomp \
+// RUN:   -target x86_64-unknown-linux -fopenmp-targets=x86_64-pc-linux-gnu \
+// RUN:   -c %s -o %t.o 2>&1 | FileCheck -check-prefix=HIT %s
+// RUN: cmp %t.o %t.first.o
+//
+// A different preprocessed source misses.
+// RUN: env CLANG_COMPILE_CACHE=%t.cache %clang -v -fopenmp=libomp \
+// RUN:   -target x86_64-unknown-linux -fopenmp-targets=x86_64-pc-linux-gnu \
+// RUN:   -c %s -o %t.o -DVALUE=2 2>&1 | FileCheck -check-prefix=MISS %s
+
+// MISS: "-cc1"
+// MISS: "-fopenmp-is-device"
+// MISS: clang-offload-bundler
+// HIT-NOT: "-cc1"
+// HIT-NOT: clang-offload-bundler
+
+#ifndef VALUE
+#define VALUE 1
+#endif
+
+int foo() {
+  int x = 0;
+#pragma omp target map(tofrom : x)
+  x = VALUE;
+  return x;
+}
@@ -0,0 +1,13 @@
+// RUN: %clang -target x86_64-apple-darwin -ftime-trace -c %s -### 2>&1 | FileCheck %s
+// CHECK: "-time-trace-file=ftime-trace.json"
+// CHECK: "{{.*}}ftime-trace.c"
+
+// RUN: %clang -target x86_64-apple-darwin -ftime-trace -c -o obj/dir/ftime-trace.o %s -### 2>&1 | FileCheck %s -check-prefix=CHECK-OBJ
+// CHECK-OBJ: "-time-trace-file=obj/dir{{/|\\\\}}ftime-trace.json"
+// CHECK-OBJ: "-o" "obj/dir{{/|\\\\}}ftime-trace.o"
+
+// RUN: %clang -target x86_64-apple-darwin -ftime-trace -ftime-trace-top=3 -c %s -### 2>&1 | FileCheck %s -check-prefix=CHECK-TOP
+// CHECK-TOP: "-time-trace-file=ftime-trace.json" "-ftime-trace-top=3"
+
+// RUN: %clang -target x86_64-apple-darwin -c %s -### 2>&1 | FileCheck %s -check-prefix=NO-TRACE
+// NO-TRACE-NOT: -time-trace-file
@@ -0,0 +1,17 @@
+// The second run finds the same installation through the cache entry that the
+// first one stores.
+//
+// RUN: rm -rf %t.cache
+// RUN: env CLANG_DETECTION_CACHE=%t.cache %clang -v --target=i386-unknown-linux \
+// RUN:           --gcc-toolchain="" \
+// RUN:           --sysroot=%S/Inputs/debian_multiarch_tree 2>&1 | FileCheck %s
+// RUN: ls %t.cache | FileCheck -check-prefix=ENTRY %s
+// RUN: env CLANG_DETECTION_CACHE=%t.cache %clang -v --target=i386-unknown-linux \
+// RUN:           --gcc-toolchain="" \
+// RUN:           --sysroot=%S/Inputs/debian_multiarch_tree 2>&1 | FileCheck %s
+
+// CHECK: Found candidate GCC installation: {{.*}}Inputs{{.}}debian_multiarch_tree{{.}}usr{{.}}lib{{.}}gcc{{.}}i686-linux-gnu{{.}}4.5
+// CHECK-NEXT: Found candidate GCC installation: {{.*}}Inputs{{.}}debian_multiarch_tree{{.}}usr{{.}}lib{{.}}gcc{{.}}x86_64-linux-gnu{{.}}4.5
+// CHECK-NEXT: Selected GCC installation: {{.*}}Inputs{{.}}debian_multiarch_tree{{.}}usr{{.}}lib{{.}}gcc{{.}}i686-linux-gnu{{.}}4.5
+
+// ENTRY: {{^[0-9a-f]+$}}
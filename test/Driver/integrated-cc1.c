@@ -0,0 +1,17 @@
+// RUN: %clang -fintegrated-cc1 -fsyntax-only %s
+// RUN: not %clang -fintegrated-cc1 -fsyntax-only -DERROR %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=ERROR %s
+// RUN: %clang -fintegrated-cc1 -c %s -o %t.o
+// RUN: %clang -fintegrated-cc1 -fno-integrated-cc1 -fsyntax-only %s
+
+// RUN: %clang -### -fintegrated-cc1 -c %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=ARGS %s
+// ARGS: "-cc1"
+// ARGS-NOT: integrated-cc1
+
+#ifdef ERROR
+#error reported by the in-process job
+// ERROR: error: reported by the in-process job
+#endif
+
+int f(void) { return 0; }
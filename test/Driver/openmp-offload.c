@@ -781,3 +781,73 @@
 
 // STATIC-LIB-LINKING:  ptxas"{{.*}}"--output-file" "{{.*}}openmp-offload-{{.*}}.o" "{{.*}}openmp-offload-{{.*}}.s" "-c"
 // STATIC-LIB-LINKING:  nvcc"{{.*}}"{{.*}}libtest-{{.*}}.o" "{{.*}}openmp-offload-{{.*}}.cubin"
+
+/// =========
+/// Check the number of concurrent device jobs is only used by the driver.
+// RUN:   %clang -### -fopenmp=libomp -target powerpc64le-ibm-linux-gnu -fopenmp-targets=nvptx64-nvidia-cuda,x86_64-pc-linux-gnu -fopenmp-device-jobs=2 %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=CHK-DEVICE-JOBS %s
+// CHK-DEVICE-JOBS-NOT: warning: argument unused
+// CHK-DEVICE-JOBS-NOT: "-fopenmp-device-jobs=2"
+
+// RUN:   %clang -### -fopenmp=libomp -target powerpc64le-ibm-linux-gnu -fopenmp-targets=nvptx64-nvidia-cuda,x86_64-pc-linux-gnu -fopenmp-device-jobs=0 %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=CHK-DEVICE-JOBS-INVALID %s
+// CHK-DEVICE-JOBS-INVALID: error: invalid integral value '0' in '-fopenmp-device-jobs=0'
+
+/// =========
+/// Check the device images can be embedded with wrapper objects instead of a
+/// linker script.
+// RUN:   %clang -### -fopenmp=libomp -o %t.out -target powerpc64le-linux -fopenmp-targets=powerpc64le-ibm-linux-gnu,x86_64-pc-linux-gnu %s -fopenmp-offload-wrapper-objects -fopenmp-dump-offload-linker-script -no-canonical-prefixes 2>&1 \
+// RUN:   | FileCheck -check-prefix=CHK-WRAPPER %s
+
+// CHK-WRAPPER-NOT: OpenMP Offload Linker Script
+// CHK-WRAPPER: # OpenMP offload wrapper, automatically generated by Clang.
+// CHK-WRAPPER:   .section .omp_offloading.entries,"a",@progbits
+// CHK-WRAPPER: ".omp_offloading.entries_begin":
+// CHK-WRAPPER: # OpenMP offload wrapper, automatically generated by Clang.
+// CHK-WRAPPER: ".omp_offloading.entries_end":
+// CHK-WRAPPER:   .section ".omp_offloading.powerpc64le-ibm-linux-gnu","a",@progbits
+// CHK-WRAPPER: ".omp_offloading.img_start.powerpc64le-ibm-linux-gnu":
+// CHK-WRAPPER:   .incbin "[[T1BIN:.+\.out]]"
+// CHK-WRAPPER: ".omp_offloading.img_end.powerpc64le-ibm-linux-gnu":
+// CHK-WRAPPER:   .section ".omp_offloading.x86_64-pc-linux-gnu","a",@progbits
+// CHK-WRAPPER: ".omp_offloading.img_start.x86_64-pc-linux-gnu":
+// CHK-WRAPPER:   .incbin "[[T2BIN:.+\.out]]"
+// CHK-WRAPPER: ".omp_offloading.img_end.x86_64-pc-linux-gnu":
+// CHK-WRAPPER: clang{{.*}}" "-cc1as" "-triple" "powerpc64le-unknown-linux" "-filetype" "obj" "-o" "[[BEGIN:.+-omp-wrapper-begin.+\.o]]" "{{.+}}.s"
+// CHK-WRAPPER: clang{{.*}}" "-cc1as" "-triple" "powerpc64le-unknown-linux" "-filetype" "obj" "-o" "[[END:.+-omp-wrapper-end.+\.o]]" "{{.+}}.s"
+// CHK-WRAPPER: ld{{(\.exe)?}}"
+// CHK-WRAPPER-NOT: "-T"
+// CHK-WRAPPER-SAME: "[[BEGIN]]"
+// CHK-WRAPPER-SAME: "[[END]]"
+
+/// Check the host compilation is told to protect the offload entries.
+// RUN:   %clang -### -fopenmp=libomp -o %t.out -target powerpc64le-linux -fopenmp-targets=powerpc64le-ibm-linux-gnu %s -fopenmp-offload-wrapper-objects -no-canonical-prefixes 2>&1 \
+// RUN:   | FileCheck -check-prefix=CHK-WRAPPER-CC1 %s
+
+// CHK-WRAPPER-CC1: clang{{.*}}" "-cc1" "-triple" "powerpc64le--linux"
+// CHK-WRAPPER-CC1-SAME: "-fopenmp-offload-wrapper-objects"
+
+/// =========
+/// Check the host compile phase writes the offload entries info that the device
+/// compile phases read.
+// RUN:   %clang -### -fopenmp=libomp -o %t.out -target powerpc64le-linux -fopenmp-targets=powerpc64le-ibm-linux-gnu %s -no-canonical-prefixes 2>&1 \
+// RUN:   | FileCheck -check-prefix=CHK-OFFLOAD-INFO %s
+
+// CHK-OFFLOAD-INFO: clang{{.*}}" "-cc1" "-triple" "powerpc64le--linux" "-emit-llvm-bc" {{.*}}"-o" "[[HOSTBC:[^"]+\.bc]]"
+// CHK-OFFLOAD-INFO-SAME: "-fopenmp-offload-info-output" "[[HOSTBC]].ompinfo"
+// CHK-OFFLOAD-INFO: clang{{.*}}" "-cc1" "-triple" "powerpc64le-ibm-linux-gnu"
+// CHK-OFFLOAD-INFO-SAME: "-fopenmp-host-ir-file-path" "[[HOSTBC]]" "-fopenmp-host-offload-info-file-path" "[[HOSTBC]].ompinfo"
+
+/// =========
+/// Check the bitcode of the NVPTX device code is kept and embedded next to the
+/// device image.
+// RUN:   %clang -### -fopenmp=libomp -o %t.out -target powerpc64le-linux -fopenmp-targets=nvptx64-nvidia-cuda -nocudalib %s -fopenmp-nvptx-embed-bitcode -fopenmp-dump-offload-linker-script -no-canonical-prefixes 2>&1 \
+// RUN:   | FileCheck -check-prefix=CHK-EMBED-BC %s
+
+// CHK-EMBED-BC: INPUT([[BC:.+\.jit\.bc]])
+// CHK-EMBED-BC: .omp_offloading.bitcode.nvptx64-nvidia-cuda :
+// CHK-EMBED-BC: PROVIDE_HIDDEN(.omp_offloading.bitcode_start.nvptx64-nvidia-cuda = .);
+// CHK-EMBED-BC-NEXT: [[BC]]
+// CHK-EMBED-BC-NEXT: PROVIDE_HIDDEN(.omp_offloading.bitcode_end.nvptx64-nvidia-cuda = .);
+// CHK-EMBED-BC: clang{{.*}}" "-cc1" "-triple" "nvptx64-nvidia-cuda"
+// CHK-EMBED-BC-SAME: "-fopenmp-device-bitcode-output" "[[BC]]"
@@ -0,0 +1,37 @@
+// Check that -fparallel-codegen generates the partitions of the object file
+// and links them into the output.
+//
+// RUN: %clang -target x86_64-unknown-linux-gnu -fparallel-codegen=3 -c -o %t.o -### %s 2> %t
+// RUN: FileCheck -check-prefix=CHECK-ACTIONS < %t %s
+//
+// CHECK-ACTIONS: "-cc1"
+// CHECK-ACTIONS-SAME: "-o" "[[OUT:.*]].o.part0.o"
+// CHECK-ACTIONS-SAME: "-parallel-codegen-output" "[[OUT]].o.part1.o"
+// CHECK-ACTIONS-SAME: "-parallel-codegen-output" "[[OUT]].o.part2.o"
+// CHECK-ACTIONS: ld{{(.exe)?}}" "-r" "[[OUT]].o.part0.o" "[[OUT]].o.part1.o" "[[OUT]].o.part2.o" "-o" "[[OUT]].o"
+
+
+// A single partition, assembly output, and other object formats are generated
+// as usual.
+//
+// RUN: %clang -target x86_64-unknown-linux-gnu -fparallel-codegen=1 -c -### %s 2> %t
+// RUN: FileCheck -check-prefix=CHECK-NO-ACTIONS < %t %s
+// RUN: %clang -target x86_64-unknown-linux-gnu -fparallel-codegen=4 -S -### %s 2> %t
+// RUN: FileCheck -check-prefix=CHECK-NO-ACTIONS < %t %s
+// RUN: %clang -target x86_64-apple-macosx -fparallel-codegen=4 -c -### %s 2> %t
+// RUN: FileCheck -check-prefix=CHECK-NO-ACTIONS < %t %s
+//
+// CHECK-NO-ACTIONS-NOT: -parallel-codegen-output
+// CHECK-NO-ACTIONS-NOT: "-r"
+
+
+// RUN: %clang -target x86_64-unknown-linux-gnu -fparallel-codegen=x -c -### %s 2> %t
+// RUN: FileCheck -check-prefix=CHECK-BAD < %t %s
+//
+// CHECK-BAD: invalid integral value 'x' in '-fparallel-codegen=x'
+
+
+// RUN: %clang -target x86_64-unknown-linux-gnu -fparallel-codegen=2 -gsplit-dwarf -c -### %s 2> %t
+// RUN: FileCheck -check-prefix=CHECK-SPLIT-DWARF < %t %s
+//
+// CHECK-SPLIT-DWARF: invalid argument '-fparallel-codegen=2' not allowed with '-gsplit-dwarf'
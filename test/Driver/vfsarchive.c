@@ -0,0 +1,8 @@
+// RUN: %clang -ivfsarchive foo.vfa -### %s 2>&1 | FileCheck %s
+// CHECK: "-ivfsarchive" "foo.vfa"
+
+// RUN: not %clang -ivfsarchive foo.vfa %s 2>&1 | FileCheck -check-prefix=CHECK-MISSING %s
+// CHECK-MISSING: virtual filesystem archive 'foo.vfa' not found
+
+// RUN: not %clang -ivfsarchive %s %s 2>&1 | FileCheck -check-prefix=CHECK-INVALID %s
+// CHECK-INVALID: invalid virtual filesystem archive '{{.*}}vfsarchive.c'
@@ -0,0 +1 @@
+inline long traced_header_function() { return 42; }
@@ -0,0 +1,31 @@
+// RUN: rm -rf %t.dir
+// RUN: mkdir -p %t.dir
+// RUN: echo '#define HAVE_B 1' > %t.dir/a.h
+// RUN: echo 'int b;' > %t.dir/b.h
+// RUN: echo 'int c;' > %t.dir/c.h
+// RUN: %clang_cc1 -std=c++14 -Eonly-directives -I %t.dir -dependency-file - -MT out %s | FileCheck %s
+// RUN: %clang -std=c++14 -fminimize-dependency-scan -M -I %t.dir %s | FileCheck %s
+// RUN: %clang -### -fminimize-dependency-scan -M %s 2>&1 | FileCheck %s --check-prefix DRIVER
+
+// Only the directives are preprocessed, so the '#'s and quotes of comments
+// and literals do not start directives or hide them.
+// CHECK: a.h
+// CHECK-NOT: {{[/\\]}}c.h
+// CHECK: b.h
+// CHECK-NOT: {{[/\\]}}c.h
+// DRIVER: "-Eonly-directives"
+
+#include "a.h"
+/* #include "c.h" */
+const char *s = "#include \"c.h\"";
+const char *r = R"delim(
+#include "missing.h"
+)delim";
+char q = '"';
+int n = 1'000'000; // A continued comment \
+#include "missing.h"
+#if HAVE_B
+#include "b.h"
+#else
+#include "missing.h"
+#endif
@@ -0,0 +1,34 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -emit-llvm -o /dev/null -I %S/Inputs -time-trace-file=%t %s
+// RUN: FileCheck -input-file=%t %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -emit-llvm -o /dev/null -I %S/Inputs -time-trace-file=%t -ftime-trace-top=1 %s
+// RUN: FileCheck -input-file=%t -check-prefix=TOP1 %s
+
+#include "time-trace.h"
+
+template <typename T> struct Wrapper {
+  T Value;
+  T get() const { return Value; }
+};
+
+template <typename T> T twice(T X) { return Wrapper<T>{X}.get() * 2; }
+
+long use() { return twice(1) + twice(2L) + traced_header_function(); }
+
+// CHECK: {"traceEvents":[
+// CHECK-DAG: "name":"Source","args":{"detail":"{{.*}}time-trace.h"}
+// CHECK-DAG: "name":"ParseTopLevelDecl","args":{"detail":"{{.*}}time-trace.cpp:15"}
+// CHECK-DAG: "name":"InstantiateClass","args":{"detail":"Wrapper<int>"}
+// CHECK-DAG: "name":"InstantiateFunction","args":{"detail":"twice<long>"}
+// CHECK-DAG: "name":"CodeGenFunction","args":{"detail":"use"}
+// CHECK-DAG: "name":"Backend"
+// CHECK: "summary":[
+// CHECK-DAG: {"name":"InstantiateFunction","dur":{{[0-9]+}},"count":4,"top":[
+// CHECK-DAG: {"name":"Backend","dur":{{[0-9]+}},"count":1}
+// CHECK: ]}
+
+// Only the most expensive detail of each kind of event is summarized.
+// TOP1: {"name":"InstantiateClass","dur":{{[0-9]+}},"count":2,"top":[
+// TOP1-NEXT: {"detail":"Wrapper<{{int|long}}>","dur":{{[0-9]+}},"count":1}]}
+
+// RUN: %clang_cc1 -emit-llvm -o /dev/null -I %S/Inputs -time-trace-file=%S/doesnotexist/bla %s 2>&1 | FileCheck -check-prefix=OUTPUTFAIL %s
+// OUTPUTFAIL: warning: unable to open time trace output file '{{.*}}doesnotexist{{.}}bla': '{{[Nn]}}o such file or directory'
@@ -0,0 +1,30 @@
+// Note: the run lines follow their respective tests, since line/column
+// matter in this test.
+
+struct Point {
+  int x;
+  int y;
+  int xy;
+  int longer_x_name;
+  int Xeno;
+  int other;
+};
+
+void f(struct Point p) {
+  p.x;
+}
+
+// RUN: env CINDEXTEST_COMPLETION_FILTER=x c-index-test -code-completion-at=%s:14:5 %s | FileCheck -check-prefix=CHECK-FILTER %s
+// CHECK-FILTER-NOT: {TypedText y}
+// CHECK-FILTER-NOT: {TypedText other}
+// CHECK-FILTER: FieldDecl:{ResultType int}{TypedText x} (35)
+// CHECK-FILTER-NEXT: FieldDecl:{ResultType int}{TypedText xy} (35)
+// CHECK-FILTER-NEXT: FieldDecl:{ResultType int}{TypedText Xeno} (35)
+// CHECK-FILTER-NEXT: FieldDecl:{ResultType int}{TypedText longer_x_name} (35)
+// CHECK-FILTER-NOT: {TypedText y}
+// CHECK-FILTER-NOT: {TypedText other}
+
+// RUN: env CINDEXTEST_COMPLETION_FILTER=x CINDEXTEST_COMPLETION_MAX_RESULTS=2 c-index-test -code-completion-at=%s:14:5 %s | FileCheck -check-prefix=CHECK-MAX %s
+// CHECK-MAX: FieldDecl:{ResultType int}{TypedText x} (35)
+// CHECK-MAX-NEXT: FieldDecl:{ResultType int}{TypedText xy} (35)
+// CHECK-MAX-NOT: FieldDecl
@@ -0,0 +1,28 @@
+#define INC(v) ++v;
+
+void many(int a, int b) {
+  int c = 0;
+  c += a;
+  INC(c)
+  c += b;
+  {
+    int d = c;
+    d += a;
+  }
+  b = c;
+}
+
+// RUN: c-index-test -cursor-at=%s:5:8 \
+// RUN:              -cursor-at=%s:6:7 \
+// RUN:              -cursor-at=%s:7:8 \
+// RUN:              -cursor-at=%s:9:13 \
+// RUN:              -cursor-at=%s:10:10 \
+// RUN:              -cursor-at=%s:12:3 \
+// RUN:       %s | FileCheck %s
+
+// CHECK: DeclRefExpr=a:3:15
+// CHECK: DeclRefExpr=c:4:7
+// CHECK: DeclRefExpr=b:3:22
+// CHECK: DeclRefExpr=c:4:7
+// CHECK: DeclRefExpr=a:3:15
+// CHECK: DeclRefExpr=b:3:22
@@ -0,0 +1,32 @@
+// RUN: rm -rf %t.cache
+// RUN: env CINDEXTEST_EDITING=1 CINDEXTEST_PREAMBLE_CACHE_DIR=%t.cache LIBCLANG_TIMING=1 \
+// RUN:   c-index-test -test-load-source-reparse 1 local -I%S/Inputs %s 2>&1 | FileCheck -check-prefix=BUILD %s
+// RUN: ls %t.cache | FileCheck -check-prefix=ENTRY %s
+// RUN: env CINDEXTEST_EDITING=1 CINDEXTEST_PREAMBLE_CACHE_DIR=%t.cache LIBCLANG_TIMING=1 \
+// RUN:   c-index-test -test-load-source-reparse 1 local -I%S/Inputs %s 2>&1 | FileCheck -check-prefix=REUSE %s
+
+// Without a cache directory, the preamble is not looked up.
+// RUN: env CINDEXTEST_EDITING=1 LIBCLANG_TIMING=1 \
+// RUN:   c-index-test -test-load-source-reparse 1 local -I%S/Inputs %s 2>&1 | FileCheck -check-prefix=NOCACHE %s
+
+#include "a.h"
+#include "b.h"
+
+A a;
+B b;
+
+// BUILD: Looking up the precompiled preamble in the cache
+// BUILD: Precompiling preamble
+// BUILD: preamble-cache.c:15:3: VarDecl=a:15:3
+
+// ENTRY: {{^[0-9a-f]+}}.deps
+// ENTRY: {{^[0-9a-f]+}}.pch
+
+// REUSE-NOT: Precompiling preamble
+// REUSE: Looking up the precompiled preamble in the cache
+// REUSE-NOT: Precompiling preamble
+// REUSE: preamble-cache.c:15:3: VarDecl=a:15:3
+// REUSE: preamble-cache.c:16:3: VarDecl=b:16:3
+
+// NOCACHE-NOT: Looking up the precompiled preamble in the cache
+// NOCACHE: Precompiling preamble
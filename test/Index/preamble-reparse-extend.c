@@ -0,0 +1,23 @@
+// RUN: env CINDEXTEST_EDITING=1 CINDEXTEST_REMAP_AFTER_TRIAL=1 CINDEXTEST_FAILONERROR=1 c-index-test -test-load-source-reparse 3 local \
+// RUN:           "-remap-file=%s,%s.remap" -I%S/Inputs %s 2>&1 | FileCheck %s
+// RUN: env CINDEXTEST_EDITING=1 CINDEXTEST_REMAP_AFTER_TRIAL=1 c-index-test -test-load-source-reparse 3 all \
+// RUN:           "-remap-file=%s,%s.remap" -I%S/Inputs %s 2>&1 | FileCheck -check-prefix=ALL %s
+#include "a.h"
+#define IN_FIRST_PREAMBLE 1
+
+A a;
+
+// The remapped file appends an #include to the preamble, which extends the
+// precompiled preamble instead of rebuilding it. The declarations and macros
+// of the first preamble are still available.
+
+// CHECK-NOT: error:
+// CHECK: preamble-reparse-extend.c:10:3: VarDecl=a:10:3 Extent=[10:1 - 10:4]
+// CHECK: preamble-reparse-extend.c:11:3: VarDecl=b:11:3 Extent=[11:1 - 11:4]
+
+// The preprocessing entities of both preambles are in the main file.
+// ALL-DAG: preamble-reparse-extend.c:5:1: inclusion directive=a.h
+// ALL-DAG: preamble-reparse-extend.c:6:9: macro definition=IN_FIRST_PREAMBLE Extent=[6:9 - 6:28]
+// ALL-DAG: preamble-reparse-extend.c:8:1: inclusion directive=b.h
+// ALL-DAG: a.h:3:13: TypedefDecl=A:3:13 (Definition) Extent=[3:1 - 3:14]
+// ALL-DAG: b.h:1:15: TypedefDecl=B:1:15 (Definition) Extent=[1:1 - 1:16]
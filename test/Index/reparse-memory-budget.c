@@ -0,0 +1,30 @@
+int visible(int x) {
+  return x + 1;
+}
+
+int evicted(int x) {
+  return x * 2;
+}
+
+// Once the AST is over its memory budget, reparsing skips the bodies of the
+// functions declared outside the visible range [0, 40), which ends before
+// 'evicted'.
+
+// RUN: env CINDEXTEST_MEMORY_BUDGET=1:0:40 c-index-test -test-load-source-reparse 1 local %s | FileCheck -check-prefix=EVICT %s
+// EVICT: reparse-memory-budget.c:1:5: FunctionDecl=visible:1:5 (Definition)
+// EVICT: reparse-memory-budget.c:1:19: CompoundStmt=
+// EVICT: reparse-memory-budget.c:5:5: FunctionDecl=evicted:5:5
+// EVICT-NOT: CompoundStmt=
+
+// Moving the visible range over 'evicted' parses its body again.
+
+// RUN: env CINDEXTEST_MEMORY_BUDGET=1:40:80 c-index-test -test-load-source-reparse 1 local %s | FileCheck -check-prefix=MOVED %s
+// MOVED: reparse-memory-budget.c:1:5: FunctionDecl=visible:1:5
+// MOVED-NOT: CompoundStmt=
+// MOVED: reparse-memory-budget.c:5:5: FunctionDecl=evicted:5:5 (Definition)
+// MOVED: reparse-memory-budget.c:5:19: CompoundStmt=
+
+// RUN: env CINDEXTEST_MEMORY_BUDGET=0:0:40 c-index-test -test-load-source-reparse 1 local %s | FileCheck -check-prefix=NOBUDGET %s
+// NOBUDGET: reparse-memory-budget.c:1:19: CompoundStmt=
+// NOBUDGET: reparse-memory-budget.c:5:5: FunctionDecl=evicted:5:5 (Definition)
+// NOBUDGET: reparse-memory-budget.c:5:19: CompoundStmt=
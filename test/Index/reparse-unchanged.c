@@ -0,0 +1,12 @@
+// RUN: env LIBCLANG_TIMING=1 CINDEXTEST_REMAP_AFTER_TRIAL=2 c-index-test -test-load-source-reparse 4 local \
+// RUN:           "-remap-file=%s,%s.remap" %s 2>&1 | FileCheck %s
+
+int x;
+
+// Reparsing without changes to the sources keeps the last AST; only the
+// reparse that remaps the file parses it again.
+
+// CHECK: Reparsing {{.*}}reparse-unchanged.c
+// CHECK-NOT: Reparsing
+// CHECK: reparse-unchanged.c:4:5: VarDecl=x:4:5
+// CHECK: reparse-unchanged.c:5:5: VarDecl=y:5:5
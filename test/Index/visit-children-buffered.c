@@ -0,0 +1,15 @@
+// RUN: c-index-test -test-visit-buffered 2 %s | FileCheck %s
+// RUN: c-index-test -test-visit-buffered 1000 %s | FileCheck %s
+
+struct S { int x; };
+int f(int a) { return a + 1; }
+
+// CHECK: StructDecl=S:4:8 (Definition) Extent=[4:1 - 4:20]{{$}}
+// CHECK-NEXT: FieldDecl=x:4:16 (Definition) Extent=[4:12 - 4:17] Parent=-1
+// CHECK-NEXT: FunctionDecl=f:5:5 (Definition) Extent=[5:1 - 5:31]{{$}}
+// CHECK-NEXT: ParmDecl=a:5:11 (Definition) Extent=[5:7 - 5:12] Parent=-1
+// CHECK-NEXT: CompoundStmt= Extent=[5:14 - 5:31] Parent=-2
+// CHECK-NEXT: ReturnStmt= Extent=[5:16 - 5:28] Parent=-1
+// CHECK-NEXT: BinaryOperator= Extent=[5:23 - 5:28] Parent=-1
+// CHECK-NEXT: DeclRefExpr=a:5:11 Extent=[5:23 - 5:24] Parent=-1
+// CHECK-NEXT: IntegerLiteral= Extent=[5:27 - 5:28] Parent=-2
@@ -0,0 +1,12 @@
+// RUN: %clang_cc1 -fsyntax-only -print-stats %s 2>&1 | FileCheck %s
+
+// CHECK: *** Stmt/Expr Stats:
+// CHECK-NEXT: {{[0-9]+}} stmts/exprs total.
+// CHECK-NEXT: 3 MemberExpr, {{[0-9]+}} each ({{[0-9]+}} bytes, {{[0-9]+\.[0-9]}}%)
+// CHECK: Total bytes =
+
+struct S { int a, b, c; };
+
+int sum(S *s) {
+  return s->a + s->b + s->c;
+}
@@ -0,0 +1,31 @@
+// Test that the serialized diagnostics of separate compilations can be
+// concatenated into one file, and that every diagnostic keeps its own file
+// names and flags even though each input numbers them from scratch.
+
+// RUN: rm -f %t.first.dia %t.second.dia %t.empty.dia %t.dia
+// RUN: %clang -Wall -fsyntax-only --serialize-diagnostics %t.first.dia -DFIRST %s
+// RUN: %clang -Wall -fsyntax-only --serialize-diagnostics %t.second.dia -DSECOND %s
+// RUN: %clang -Wall -fsyntax-only --serialize-diagnostics %t.empty.dia %s
+// RUN: diagtool merge-serialized -o %t.dia %t.first.dia %t.empty.dia %t.second.dia
+// RUN: c-index-test -read-diagnostics %t.dia 2>&1 | FileCheck %s
+
+// CHECK: serialized-diags-merge.c:{{[0-9]+}}:{{[0-9]+}}: warning: variable 'voodoo' is uninitialized when used here [-Wuninitialized]
+// CHECK: note: initialize the variable 'voodoo' to silence this warning []
+// CHECK: serialized-diags-merge.c:{{[0-9]+}}:{{[0-9]+}}: warning: unused variable 'unused' [-Wunused-variable]
+// CHECK: Number of diagnostics: 2
+
+// RUN: not diagtool merge-serialized -o %t.bad.dia %s 2>&1 | FileCheck -check-prefix=INVALID %s
+// INVALID: error: {{.*}}serialized-diags-merge.c: Invalid diagnostics signature
+
+#ifdef FIRST
+void foo() {
+  int voodoo;
+  voodoo = voodoo + 1;
+}
+#endif
+
+#ifdef SECOND
+void bar() {
+  int unused;
+}
+#endif
@@ -0,0 +1,5 @@
+inline int foo(int x) { return x + 1; }
+
+template <typename T> inline T bar(T x) { return x; }
+
+static inline int baz(int x) { return x * 2; }
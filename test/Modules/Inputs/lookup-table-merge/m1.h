@@ -0,0 +1,4 @@
+namespace N {
+int a();
+int b();
+}
@@ -0,0 +1,4 @@
+namespace N {
+int c();
+int d();
+}
@@ -0,0 +1,4 @@
+namespace N {
+int e();
+int f();
+}
@@ -0,0 +1,4 @@
+namespace N {
+int i();
+int j();
+}
@@ -0,0 +1,8 @@
+struct Foo {
+  int x;
+  int get() const { return x; }
+};
+
+template <typename T> struct Bar {
+  T y;
+};
@@ -0,0 +1,16 @@
+struct S {
+  int n;
+  float f;
+  int get() const { return n; }
+};
+
+struct T {
+  int n;
+  double f;
+};
+
+inline int fb() {
+  S s = {1, 2};
+  T t = {3, 4};
+  return s.get() + t.n + t.f;
+}
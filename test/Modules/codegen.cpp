@@ -0,0 +1,32 @@
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -x c++ -triple x86_64-linux-gnu -fmodules -fmodules-codegen \
+// RUN:     -fmodule-name=foo -emit-module %S/Inputs/codegen/foo.modulemap \
+// RUN:     -o %t/foo.pcm
+
+// The object file of the module provides the inline functions it can emit.
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -emit-llvm %t/foo.pcm -o - \
+// RUN:     | FileCheck %s --check-prefix=FOO
+
+// FOO: define weak_odr i32 @_Z3fooi(
+// FOO-NOT: bar
+// FOO-NOT: baz
+
+// Importers do not emit them again.
+// RUN: %clang_cc1 -x c++ -triple x86_64-linux-gnu -fmodules \
+// RUN:     -fmodule-file=%t/foo.pcm \
+// RUN:     -fmodule-map-file=%S/Inputs/codegen/foo.modulemap \
+// RUN:     -I %S/Inputs/codegen -emit-llvm %s -o - | FileCheck %s
+
+// When optimizing, they are still available for inlining.
+// RUN: %clang_cc1 -x c++ -triple x86_64-linux-gnu -fmodules \
+// RUN:     -fmodule-file=%t/foo.pcm \
+// RUN:     -fmodule-map-file=%S/Inputs/codegen/foo.modulemap \
+// RUN:     -I %S/Inputs/codegen -O1 -disable-llvm-passes -emit-llvm %s -o - \
+// RUN:     | FileCheck %s --check-prefix=OPT
+
+#include "foo.h"
+
+// CHECK-DAG: declare i32 @_Z3fooi(
+// CHECK-DAG: define linkonce_odr i32 @_Z3barIiET_S0_(
+// OPT: define available_externally i32 @_Z3fooi(
+int use(int x) { return foo(x) + bar(x) + baz(x); }
@@ -0,0 +1,22 @@
+// REQUIRES: shell
+//
+// RUN: rm -rf %t
+// RUN: mkdir %t
+// RUN: echo 'module a { header "a.h" }' > %t/modulemap
+// RUN: echo 'X(v)' > %t/x.def
+// RUN: echo '#define X(n) extern int n##_1;' > %t/a.h
+// RUN: echo '#include "x.def"' >> %t/a.h
+// RUN: echo '#undef X' >> %t/a.h
+// RUN: echo '#define X(n) extern int n##_2;' >> %t/a.h
+// RUN: echo '#include "x.def"' >> %t/a.h
+// RUN: echo '#undef X' >> %t/a.h
+//
+// The contents of x.def are embedded once, with its first entry, and the
+// diagnostics that point into its second entry find them there.
+// RUN: %clang_cc1 -fmodules -I%t -fmodules-embed-all-files %t/modulemap -fmodule-name=a -x c++ -emit-module -o %t/a.pcm
+// RUN: %clang_cc1 -fmodules -I%t -fmodule-map-file=%t/modulemap -fmodule-file=%t/a.pcm %s -verify
+#include "a.h"
+char v_2; // expected-error {{different type}}
+// expected-note@x.def:1 {{here}}
+char v_1; // expected-error {{different type}}
+// expected-note@x.def:1 {{here}}
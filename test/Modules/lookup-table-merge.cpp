@@ -0,0 +1,22 @@
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t \
+// RUN:     -I %S/Inputs/lookup-table-merge -fsyntax-only -verify -print-stats \
+// RUN:     %s 2>&1 | FileCheck %s
+
+// Each module extends N with a lookup table of its own. The tables are only
+// merged once the lookups into N have probed them about as many times as
+// they have entries.
+// CHECK: {{[0-9]+}} lookup tables for {{[0-9]+}} declcontexts
+// CHECK: {{[1-9][0-9]*}} lookup table merges of {{[0-9]+}} tables and {{[0-9]+}} entries
+
+// expected-no-diagnostics
+#include "m1.h"
+#include "m2.h"
+#include "m3.h"
+#include "m4.h"
+#include "m5.h"
+
+int use() {
+  return N::a() + N::b() + N::c() + N::d() + N::e() + N::f() + N::g() +
+         N::h() + N::i() + N::j();
+}
@@ -0,0 +1,32 @@
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -x c++ -triple x86_64-linux-gnu -fmodules -fmodules-debuginfo \
+// RUN:     -fmodule-name=foo -emit-module \
+// RUN:     %S/Inputs/modules-debuginfo/foo.modulemap -o %t/foo.pcm
+
+// The object file of the module describes its classes, used or not.
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -debug-info-kind=limited \
+// RUN:     -emit-llvm %t/foo.pcm -o - | FileCheck %s --check-prefix=FOO
+
+// FOO: !DICompositeType(tag: DW_TAG_structure_type, name: "Foo",
+// FOO-SAME: elements:
+// FOO-SAME: identifier: "_ZTS3Foo"
+// FOO-NOT: name: "Bar
+
+// Importers only declare them.
+// RUN: %clang_cc1 -x c++ -triple x86_64-linux-gnu -fmodules \
+// RUN:     -fmodule-file=%t/foo.pcm \
+// RUN:     -fmodule-map-file=%S/Inputs/modules-debuginfo/foo.modulemap \
+// RUN:     -I %S/Inputs/modules-debuginfo -debug-info-kind=limited \
+// RUN:     -emit-llvm %s -o - | FileCheck %s
+
+#include "foo.h"
+
+// CHECK: !DICompositeType(tag: DW_TAG_structure_type, name: "Foo",
+// CHECK-SAME: flags: DIFlagFwdDecl, identifier: "_ZTS3Foo"
+// CHECK: !DICompositeType(tag: DW_TAG_structure_type, name: "Bar<int>",
+// CHECK-SAME: elements:
+int use() {
+  Foo f = {1};
+  Bar<int> b = {2};
+  return f.get() + b.y;
+}
@@ -0,0 +1,13 @@
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -x objective-c++ -fmodules -fimplicit-module-maps -fmodules-cache-path=%t -I %S/Inputs/odr-hash-merge %s -verify -std=c++11
+
+// The definitions of S in a and b have the same members, so they are merged
+// without checking each member. Those of T differ and are still checked.
+
+@import a;
+@import b;
+
+int x = fa() + fb() + S{5, 6}.get();
+
+// expected-note@a.h:9 {{declaration of 'f' does not match}}
+// expected-error@b.h:9 {{'T::f' from module 'b' is not present in definition of 'T' in module 'a'}}
@@ -0,0 +1,80 @@
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple x86_64-unknown-unknown -fopenmp-split-complex-atomics -emit-llvm %s -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple x86_64-unknown-unknown -emit-llvm %s -o - | FileCheck %s --check-prefix NOSPLIT
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -fopenmp-split-complex-atomics -o - | FileCheck %s --check-prefix DEVICE
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// NOSPLIT-LABEL: define {{.*}}void @{{.+}}accumulate
+// NOSPLIT: call {{.*}}@__atomic_compare_exchange(i64 16,
+
+// CHECK-LABEL: define {{.*}}void @{{.+}}accumulate
+void accumulate(_Complex double &acc, _Complex double v, double r) {
+  // The real and imaginary parts are updated by separate 64-bit loops.
+  // CHECK-NOT: __atomic_compare_exchange
+  // CHECK: [[RE:%.+]] = getelementptr inbounds { double, double }, { double, double }* [[ACC:%.+]], i32 0, i32 0
+  // CHECK: bitcast double* [[RE]] to i64*
+  // CHECK: fadd double
+  // CHECK: cmpxchg i64*
+  // CHECK: [[IM:%.+]] = getelementptr inbounds { double, double }, { double, double }* [[ACC]], i32 0, i32 1
+  // CHECK: bitcast double* [[IM]] to i64*
+  // CHECK: fadd double
+  // CHECK: cmpxchg i64*
+#pragma omp atomic
+  acc += v;
+  // CHECK: fsub double
+  // CHECK: cmpxchg i64*
+  // CHECK: fsub double
+  // CHECK: cmpxchg i64*
+#pragma omp atomic
+  acc = acc - v;
+  // A real operand only updates the real part.
+  // CHECK: getelementptr inbounds { double, double }, { double, double }* %{{.+}}, i32 0, i32 0
+  // CHECK: fadd double
+  // CHECK: cmpxchg i64*
+  // CHECK-NOT: cmpxchg
+  // CHECK-NOT: __atomic_compare_exchange
+  // CHECK: ret void
+#pragma omp atomic
+  acc += r;
+}
+
+// CHECK-LABEL: define {{.*}}void @{{.+}}narrow
+void narrow(_Complex float &acc, _Complex float v) {
+  // The parts of underaligned complex values fit the native atomics even
+  // where the whole value does not.
+  // CHECK-NOT: __atomic_compare_exchange
+  // CHECK: fadd float
+  // CHECK: cmpxchg i32*
+  // CHECK: fadd float
+  // CHECK: cmpxchg i32*
+  // CHECK: ret void
+#pragma omp atomic
+  acc += v;
+}
+
+// CHECK-LABEL: define {{.*}}void @{{.+}}whole
+void whole(_Complex double &acc, _Complex double v) {
+  // Other operations are still performed on the value as a whole.
+  // CHECK: call {{.*}}@__atomic_compare_exchange(i64 16,
+  // CHECK: ret void
+#pragma omp atomic
+  acc *= v;
+}
+
+// DEVICE-LABEL: define {{.*}}void {{@__omp_offloading_.+amplitudes.+}}(
+// DEVICE-NOT: __atomic_compare_exchange
+// DEVICE: fadd double
+// DEVICE: cmpxchg i64*
+// DEVICE: fadd double
+// DEVICE: cmpxchg i64*
+void amplitudes(_Complex double *amp, const _Complex double *v, int n) {
+#pragma omp target teams distribute parallel for map(tofrom: amp[:1]) map(to: v[:n])
+  for (int i = 0; i < n; ++i) {
+#pragma omp atomic
+    amp[0] += v[i];
+  }
+}
+
+#endif
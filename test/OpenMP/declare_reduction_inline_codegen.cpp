@@ -0,0 +1,46 @@
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple x86_64-unknown-unknown -fopenmp-inline-reduction-combiners -emit-llvm %s -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple x86_64-unknown-unknown -emit-llvm %s -o - | FileCheck %s --check-prefix OUTLINED
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// CHECK-NOT: .omp_combiner.
+// CHECK-NOT: .omp_initializer.
+// OUTLINED: define internal void @.omp_combiner.(
+// OUTLINED: define internal void @.omp_initializer.(
+
+struct MinLoc {
+  double v;
+  int i;
+};
+MinLoc first(MinLoc a, MinLoc b) { return b.v < a.v ? b : a; }
+#pragma omp declare reduction(minloc : MinLoc : omp_out = first(omp_out, omp_in)) initializer(omp_priv = {1e30, -1})
+
+// The private copy is initialized in place, and the combiner is called
+// directly where the copies are combined.
+// CHECK-LABEL: define {{.*}}void @{{.+}}argmin
+// CHECK: define internal void @.omp_outlined.(
+// CHECK: alloca %struct.MinLoc,
+// CHECK: store double 1.000000e+30, double*
+// CHECK: store i32 -1, i32*
+// CHECK: call i32 @__kmpc_reduce_nowait(
+// CHECK: .omp.reduction.case1:
+// CHECK: call {{.+}} @{{.+}}first
+// CHECK: .omp.reduction.case2:
+// CHECK: call {{.+}} @{{.+}}first
+// CHECK: define internal void @.omp.reduction.reduction_func(
+// CHECK: call {{.+}} @{{.+}}first
+// CHECK: ret void
+
+// OUTLINED-LABEL: define {{.*}}void @{{.+}}argmin
+// OUTLINED: call void @.omp_initializer.(
+// OUTLINED: call void @.omp_combiner.(
+MinLoc argmin(const double *a, int n) {
+  MinLoc m = {1e30, -1};
+#pragma omp parallel for reduction(minloc : m)
+  for (int i = 0; i < n; ++i)
+    m = first(m, MinLoc{a[i], i});
+  return m;
+}
+
+#endif
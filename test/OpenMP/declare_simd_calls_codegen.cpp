@@ -0,0 +1,50 @@
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple x86_64-unknown-unknown -target-feature +avx512f -fopenmp-declare-simd-calls -emit-llvm %s -o - | FileCheck %s --check-prefix AVX512
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple x86_64-unknown-unknown -fopenmp-declare-simd-calls -emit-llvm %s -o - | FileCheck %s --check-prefix SSE
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple x86_64-unknown-unknown -emit-llvm %s -o - | FileCheck %s --check-prefix NOCALLS
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple x86_64-unknown-unknown -target-feature +avx512f -fopenmp-declare-simd-calls -O2 -emit-llvm %s -o - | FileCheck %s --check-prefix VECTORIZED
+// REQUIRES: x86-registered-target
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// Provided by a vector math library.
+#pragma omp declare simd notinbranch
+double vsin(double x);
+#pragma omp declare simd uniform(n)
+double vpow(double x, int n);
+
+// Defined here, no vector variant exists.
+#pragma omp declare simd notinbranch
+double twice(double x) { return 2 * x; }
+
+void apply(double *out, const double *in, int n) {
+#pragma omp simd
+  for (int i = 0; i < n; ++i)
+    out[i] = vsin(in[i]) + twice(in[i]);
+}
+
+double power(double x) { return vpow(x, 3); }
+
+// AVX512-DAG: declare {{.*}}double @_Z4vsind(double) [[VSIN_ATTRS:#[0-9]+]]
+// AVX512-DAG: attributes [[VSIN_ATTRS]] = {{.*}}"_ZGVbN2v__Z4vsind"{{.*}}"_ZGVcN4v__Z4vsind"{{.*}}"_ZGVdN4v__Z4vsind"{{.*}}"_ZGVeN8v__Z4vsind"
+// AVX512-DAG: !omp.declare_simd.calls = !{
+// AVX512-DAG: !{double (double)* @_Z4vsind, !"_Z4vsind", !"_ZGVeN8v__Z4vsind", i32 8}
+// AVX512-DAG: !{double (double)* @_Z4vsind, !"_Z4vsind", !"_ZGVdN4v__Z4vsind", i32 4}
+// AVX512-DAG: !{double (double)* @_Z4vsind, !"_Z4vsind", !"_ZGVbN2v__Z4vsind", i32 2}
+// AVX512-NOT: !"_ZGVcN4v__Z4vsind"
+// AVX512-NOT: !"_ZGV{{.+}}__Z4vpowdi"
+
+// Only the SSE variant is available without AVX.
+// SSE: !{double (double)* @_Z4vsind, !"_Z4vsind", !"_ZGVbN2v__Z4vsind", i32 2}
+// SSE-NOT: !"_ZGV{{[cde]}}N{{[0-9]+}}v__Z4vsind"
+
+// NOCALLS-NOT: omp.declare_simd.calls
+// NOCALLS-NOT: _ZGVbN2v__Z4vsind
+
+// The variants of the external function are called, not the ones of the
+// function defined in this module.
+// VECTORIZED-LABEL: define {{.*}}void @_Z5applyPdPKdi(
+// VECTORIZED: call {{.*}}<{{[0-9]+}} x double> @_ZGV{{[bde]}}N{{[248]}}v__Z4vsind(<{{[0-9]+}} x double>
+// VECTORIZED-NOT: @_ZGV{{.+}}__Z5twiced(
+
+#endif
@@ -0,0 +1,43 @@
+// Test the entries that run the structors of declare target globals - host bc file has to be created first.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -o - | FileCheck %s --check-prefix HOST
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -o - | FileCheck %s --check-prefix DEVICE
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// The host registers one initializer and one destructor entry for all the
+// globals of the compilation unit.
+// HOST-DAG: @{{__omp_offloading_[0-9a-f]+_[0-9a-f]+_init}} = private constant i8 0
+// HOST-DAG: @{{__omp_offloading_[0-9a-f]+_[0-9a-f]+_dtor}} = private constant i8 0
+// HOST-NOT: _l{{[0-9]+}}_init = private constant
+// HOST-NOT: _l{{[0-9]+}}_dtor = private constant
+
+#pragma omp declare target
+struct S {
+  int a;
+  S(int a) : a(a) {}
+  ~S() { a = 0; }
+};
+
+S s1(1);
+S s2 __attribute__((init_priority(200)))(2);
+S s3(3);
+#pragma omp end declare target
+
+// The device runs the initializers in the order of their priorities, and the
+// destructors in the reverse order.
+// DEVICE-DAG: define internal void @{{__omp_offloading_.+s1_l[0-9]+}}_init()
+// DEVICE-DAG: define internal void @{{__omp_offloading_.+s1_l[0-9]+}}_dtor()
+// DEVICE-LABEL: define void @{{__omp_offloading_[0-9a-f]+_[0-9a-f]+}}_init()
+// DEVICE: call void @{{__omp_offloading_.+s2_l[0-9]+}}_init()
+// DEVICE-NEXT: call void @{{__omp_offloading_.+s1_l[0-9]+}}_init()
+// DEVICE-NEXT: call void @{{__omp_offloading_.+s3_l[0-9]+}}_init()
+// DEVICE-NEXT: ret void
+// DEVICE-LABEL: define void @{{__omp_offloading_[0-9a-f]+_[0-9a-f]+}}_dtor()
+// DEVICE: call void @{{__omp_offloading_.+s3_l[0-9]+}}_dtor()
+// DEVICE-NEXT: call void @{{__omp_offloading_.+s1_l[0-9]+}}_dtor()
+// DEVICE-NEXT: call void @{{__omp_offloading_.+s2_l[0-9]+}}_dtor()
+// DEVICE-NEXT: ret void
+
+#endif
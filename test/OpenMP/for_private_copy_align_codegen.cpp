@@ -0,0 +1,33 @@
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple x86_64-unknown-unknown -fopenmp-private-copy-align=64 -emit-llvm %s -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple x86_64-unknown-unknown -emit-llvm %s -o - | FileCheck %s --check-prefix NOPAD
+// RUN: not %clang_cc1 -fopenmp -x c++ -triple x86_64-unknown-unknown -fopenmp-private-copy-align=48 -emit-llvm %s -o - 2>&1 | FileCheck %s --check-prefix BADALIGN
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// BADALIGN: error: invalid value '48' in '-fopenmp-private-copy-align=48'
+
+// NOPAD-NOT: align 64
+
+// CHECK-LABEL: define {{.*}}void @{{.+}}hist
+void hist(const int *a, int n, double &sum, long (&bins)[16], int &last) {
+#pragma omp parallel for reduction(+ : sum, bins) lastprivate(last)
+  for (int i = 0; i < n; ++i) {
+    sum += a[i];
+    bins[a[i] & 15]++;
+    last = a[i];
+  }
+}
+
+// The private copies get whole cache lines, the rest of the frame is not
+// affected.
+// CHECK: define internal void @.omp_outlined.(
+// CHECK-DAG: [[LAST:%.+]] = alloca [64 x i8], align 64
+// CHECK-DAG: [[SUM:%.+]] = alloca [64 x i8], align 64
+// CHECK-DAG: [[BINS:%.+]] = alloca [16 x i64], align 64
+// CHECK-DAG: %.omp.reduction.red_list = alloca [2 x i8*], align 8
+// CHECK-DAG: bitcast [64 x i8]* [[SUM]] to double*
+// CHECK-DAG: bitcast [64 x i8]* [[LAST]] to i32*
+// CHECK: ret void
+
+#endif
@@ -0,0 +1,55 @@
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple x86_64-unknown-unknown -fopenmp-inline-static-schedule -emit-llvm %s -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple x86_64-unknown-unknown -emit-llvm %s -o - | FileCheck %s --check-prefix NOINLINE
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// NOINLINE-NOT: __kmpc_bound_thread_num
+// NOINLINE: call void @__kmpc_for_static_init_4(
+// NOINLINE: call void @__kmpc_for_static_fini(
+
+// CHECK-LABEL: define {{.*}}void @{{.+}}two_loops
+void two_loops(float *a, float *b, int n) {
+#pragma omp parallel
+  {
+// The thread number and the team size are queried once for both loops.
+// CHECK: define internal void @.omp_outlined.(
+// CHECK: [[TID:%.+]] = call i32 @__kmpc_bound_thread_num(
+// CHECK: [[NTH:%.+]] = call i32 @__kmpc_bound_num_threads(
+// CHECK-NOT: __kmpc_bound_thread_num
+// CHECK-NOT: __kmpc_for_static_init
+// CHECK: [[GLB:%.+]] = load i32, i32* [[LB:%.omp.lb]],
+// CHECK: [[GUB:%.+]] = load i32, i32* [[UB:%.omp.ub]],
+// CHECK: [[DIFF:%.+]] = sub i32 [[GUB]], [[GLB]]
+// CHECK: [[TRIP:%.+]] = add i32 [[DIFF]], 1
+// CHECK: urem i32 [[TRIP]], [[NTH]]
+// CHECK: udiv i32 [[TRIP]], [[NTH]]
+// CHECK: [[CHUNK:%.+]] = add i32
+// CHECK: [[OFF:%.+]] = mul i32 [[TID]], [[CHUNK]]
+// CHECK: [[NEWLB:%.+]] = add i32 [[GLB]], [[OFF]]
+// CHECK: store i32 [[NEWLB]], i32* [[LB]],
+// CHECK: store i32 %{{.+}}, i32* [[UB]],
+// CHECK: store i32 [[TRIP]], i32* %.omp.stride,
+// CHECK: omp.loop.exit:
+// CHECK-NOT: __kmpc_for_static_fini
+#pragma omp for nowait
+    for (int i = 0; i < n; ++i)
+      a[i] = 2 * b[i];
+// CHECK-NOT: __kmpc_bound_thread_num
+// CHECK: mul i32 [[TID]], %
+// CHECK: omp.loop.exit
+// CHECK-NOT: __kmpc_for_static_fini
+// CHECK: call void @__kmpc_barrier(
+#pragma omp for schedule(static)
+    for (int i = 0; i < n; ++i)
+      b[i] += a[i];
+// Chunked schedules still call the runtime.
+// CHECK: call void @__kmpc_for_static_init_4(
+// CHECK: call void @__kmpc_for_static_fini(
+#pragma omp for schedule(static, 4)
+    for (int i = 0; i < n; ++i)
+      b[i] += a[i];
+  }
+}
+
+#endif
@@ -0,0 +1,51 @@
+// Test pruning of the implicitly declare target functions that the target
+// regions emitted for the host do not reach.
+// RUN: %clang_cc1 -verify -fopenmp -fopenmp-implicit-declare-target -fopenmp-prune-implicit-declare-target -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -o %t-prune.ll
+// RUN: FileCheck %s < %t-prune.ll
+// RUN: FileCheck %s --check-prefix PRUNE < %t-prune.ll
+// RUN: %clang_cc1 -verify -fopenmp -fopenmp-implicit-declare-target -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -o - | FileCheck %s --check-prefix NOPRUNE
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+struct S {
+  int V;
+  S(int V);
+  ~S();
+};
+S::S(int V) : V(V) {}
+S::~S() {}
+
+int leaf(int i) { return i + 1; }
+int reached(int i) { return leaf(i); }
+int dead_leaf(int i) { return i - 1; }
+
+// The target region of this function is never emitted, so nothing it calls is
+// needed by the device.
+inline int unused(int *a) {
+#pragma omp target map(a[0:1])
+  a[0] = dead_leaf(a[0]);
+  return a[0];
+}
+
+void used(int *a) {
+#pragma omp target map(a[0:1])
+  {
+    S s(a[0]);
+    a[0] = reached(s.V);
+  }
+}
+
+// CHECK: !omp_offload.info = !{
+// CHECK-DAG: !{i32 2, !"_Z7reachedi"}
+// CHECK-DAG: !{i32 2, !"_Z4leafi"}
+// CHECK-DAG: !{i32 2, !"_ZN1SC1Ei"}
+// CHECK-DAG: !{i32 2, !"_ZN1SD1Ev"}
+
+// PRUNE: !omp_offload.info = !{
+// PRUNE-NOT: !"_Z9dead_leafi"
+
+// NOPRUNE: !omp_offload.info = !{
+// NOPRUNE: !{i32 2, !"_Z9dead_leafi"}
+
+#endif
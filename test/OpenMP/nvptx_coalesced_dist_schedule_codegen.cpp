@@ -0,0 +1,67 @@
+// Test coalesced scheduling of distribute parallel loops - host bc file has to be created first.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -o - | FileCheck %s
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+void team_sized_chunk(int *a, int n) {
+#pragma omp target teams distribute parallel for thread_limit(128) dist_schedule(static, 128)
+  for (int i = 0; i < n; ++i)
+    a[i] = i;
+}
+
+void other_chunk(int *a, int n) {
+#pragma omp target teams distribute parallel for thread_limit(128) dist_schedule(static, 64)
+  for (int i = 0; i < n; ++i)
+    a[i] = i;
+}
+
+void collapsed(int *a, int n, int m) {
+#pragma omp target teams distribute parallel for collapse(2)
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < m; ++j)
+      a[i * m + j] = i + j;
+}
+
+void nested_in_target_teams(int *a, int n) {
+#pragma omp target teams
+#pragma omp distribute parallel for
+  for (int i = 0; i < n; ++i)
+    a[i] = i;
+}
+
+void with_serial_code(int *a, int n) {
+#pragma omp target teams
+  {
+    int m = n / 2;
+#pragma omp distribute parallel for
+    for (int i = 0; i < m; ++i)
+      a[i] = i;
+  }
+}
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+team_sized_chunk.+}}(
+// CHECK: call void @__kmpc_for_static_init_4_simple_spmd({{.+}}, i32 93,
+// CHECK-NOT: call void @__kmpc_for_static_init_4_simple_spmd({{.+}}, i32 91,
+// CHECK: ret void
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+other_chunk.+}}(
+// CHECK: call void @__kmpc_for_static_init_4_simple_spmd({{.+}}, i32 91,
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+collapsed.+}}(
+// CHECK: call void @__kmpc_for_static_init_8_simple_spmd({{.+}}, i32 93,
+
+// A 'distribute parallel for' that is the whole teams region gets the same
+// schedule as the combined construct.
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+nested_in_target_teams.+}}(
+// CHECK: call void @__kmpc_spmd_kernel_init(
+// CHECK: call void @__kmpc_for_static_init_4_simple_spmd({{.+}}, i32 93,
+// CHECK-NOT: call void @__kmpc_for_static_init_4_simple_spmd(
+// CHECK: ret void
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+with_serial_code.+}}(
+// CHECK-NOT: call void @__kmpc_spmd_kernel_init(
+// CHECK: call void @__kmpc_kernel_init(
+
+#endif
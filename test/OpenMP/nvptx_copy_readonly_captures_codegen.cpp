@@ -0,0 +1,40 @@
+// Test sharing copies of read-only captures - host bc file has to be created first.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -fopenmp-nvptx-copy-readonly-captures -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -o - | FileCheck %s --check-prefix NOCOPY
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// 'a' is only read in the parallel region and keeps its own storage; its value
+// is copied to the shared address before the region is forked.  'b' is written
+// in the region and is still moved to shared memory.
+// CHECK-LABEL: define void {{@__omp_offloading_.+readonly.+}}(
+// CHECK: call void {{@__omp_offloading_.+readonly.+}}.data_share(
+// CHECK-SAME: i32** %a.shared, i32* %a,
+// CHECK: store i32 1, i32* %a,
+// CHECK: [[AVAL:%.+]] = load i32, i32* %a,
+// CHECK: [[AADDR:%.+]] = load i32*, i32** %a.shared,
+// CHECK: store i32 [[AVAL]], i32* [[AADDR]],
+// CHECK: call void @__kmpc_kernel_prepare_parallel(
+
+// NOCOPY-LABEL: define void {{@__omp_offloading_.+readonly.+}}(
+// NOCOPY: [[AREPL:%.+]] = load i32*, i32** %a.shared,
+// NOCOPY: store i32 1, i32* [[AREPL]],
+// NOCOPY-NOT: load i32*, i32** %a.shared,
+// NOCOPY: call void @__kmpc_kernel_prepare_parallel(
+void readonly(int *arr) {
+#pragma omp target map(arr[0:10])
+  {
+    int a;
+    int b = 0;
+    a = 1;
+#pragma omp parallel
+    {
+      arr[0] = a;
+      b = a;
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,104 @@
+// Test lowering of critical regions to atomic updates - host bc file has to be created first.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -o - | FileCheck %s
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+void int_sum(int *a, int n) {
+  int sum = 0;
+#pragma omp target teams distribute parallel for map(tofrom: sum)
+  for (int i = 0; i < n; ++i) {
+    int v = i * 2;
+#pragma omp critical(isum)
+    sum += v;
+  }
+}
+
+void float_sum(float *a, int n) {
+  float sum = 0;
+#pragma omp target teams distribute parallel for map(tofrom: sum)
+  for (int i = 0; i < n; ++i) {
+    float v = i;
+#pragma omp critical(fsum)
+    sum = sum + v;
+  }
+}
+
+void wide_count(int n) {
+  long count = 0;
+#pragma omp target teams distribute parallel for map(tofrom: count)
+  for (int i = 0; i < n; ++i) {
+#pragma omp critical(count)
+    ++count;
+  }
+}
+
+void general_body(int *a, int n) {
+  int sum = 0;
+#pragma omp target teams distribute parallel for map(tofrom: sum)
+  for (int i = 0; i < n; ++i) {
+#pragma omp critical
+    sum += a[i];
+  }
+}
+
+// An unnamed region that is a single update must still exclude the unnamed
+// region of general_body.
+void mixed_unnamed(int n) {
+  int sum = 0;
+#pragma omp target teams distribute parallel for map(tofrom: sum)
+  for (int i = 0; i < n; ++i) {
+#pragma omp critical
+    sum += i;
+  }
+}
+
+// CHECK-DAG: @.omp.critical.atomic.isum = internal constant i1 true
+// CHECK-DAG: @.omp.critical.atomic.fsum = internal constant i1 true
+// CHECK-DAG: @.omp.critical.atomic.count = internal constant i1 true
+// CHECK-DAG: @.omp.critical.atomic. = internal constant i1 false
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+int_sum.+}}(
+// CHECK: load i1, i1* @.omp.critical.atomic.isum
+// CHECK: omp.critical.atomic:
+// CHECK: [[MASK:%.+]] = call i32 @__kmpc_warp_active_thread_mask()
+// CHECK: icmp eq i32 [[MASK]], -1
+// CHECK: omp.critical.check:
+// CHECK: call i32 @llvm.nvvm.shfl.idx.i32(
+// CHECK: call i32 @llvm.nvvm.shfl.bfly.i32(
+// CHECK: omp.critical.aggregate:
+// CHECK: call i32 @llvm.nvvm.shfl.bfly.i32(
+// CHECK: add nsw i32
+// CHECK: omp.critical.leader:
+// CHECK: atomicrmw add i32* {{.+}} monotonic
+// CHECK: omp.critical.lane:
+// CHECK: atomicrmw add i32* {{.+}} monotonic
+// CHECK: omp.critical.serial:
+// CHECK: omp.critical.loop:
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+float_sum.+}}(
+// CHECK: omp.critical.aggregate:
+// CHECK: call float @llvm.nvvm.shfl.bfly.f32(
+// CHECK: fadd float
+// CHECK: omp.critical.leader:
+// CHECK: cmpxchg i32*
+// CHECK: omp.critical.lane:
+// CHECK: cmpxchg i32*
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+wide_count.+}}(
+// CHECK-NOT: omp.critical.aggregate
+// CHECK: atomicrmw add i64* {{.+}}, i64 1 monotonic
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+general_body.+}}(
+// CHECK-NOT: omp.critical.atomic
+// CHECK: omp.critical.loop:
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+mixed_unnamed.+}}(
+// CHECK: load i1, i1* @.omp.critical.atomic.,
+// CHECK: omp.critical.atomic:
+// CHECK: atomicrmw add i32* {{.+}} monotonic
+// CHECK: omp.critical.serial:
+// CHECK: omp.critical.loop:
+
+#endif
@@ -0,0 +1,62 @@
+// Test cycle counters of NVPTX kernels - host bc file has to be created first.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -fopenmp-nvptx-cycle-counters -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -o - | FileCheck %s --check-prefix NOCOUNT
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// NOCOUNT-NOT: _cycles
+// NOCOUNT-NOT: clock64
+
+// The counters are named after their kernel so that the host can fetch them.
+// CHECK-DAG: [[GEN_CYCLES:@__omp_offloading_.+two_regions.+_cycles]] = weak global [4 x i64] zeroinitializer
+// CHECK-DAG: [[PAR_CYCLES:@__omp_offloading_.+two_regions.+_parallel_cycles]] = weak global [2 x i64] zeroinitializer
+// CHECK-DAG: [[SPMD_CYCLES:@__omp_offloading_.+spmd_loop.+_cycles]] = weak global [4 x i64] zeroinitializer
+
+void two_regions(int *a) {
+#pragma omp target map(tofrom: a[:2])
+  {
+#pragma omp parallel
+    a[0] = 1;
+#pragma omp parallel
+    a[1] = 2;
+  }
+}
+
+// The state machine, each parallel region and the barrier after it are
+// counted separately.
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+two_regions.+}}_worker()
+// CHECK: [[AWAIT:%.+]] = call i64 @llvm.nvvm.read.ptx.sreg.clock64()
+// CHECK: call void @llvm.nvvm.barrier0()
+// CHECK: [[AWAITED:%.+]] = call i64 @llvm.nvvm.read.ptx.sreg.clock64()
+// CHECK: [[WAIT:%.+]] = sub i64 [[AWAITED]], [[AWAIT]]
+// CHECK: atomicrmw add i64* getelementptr inbounds ([4 x i64], [4 x i64]* [[GEN_CYCLES]], i32 0, i32 1), i64 [[WAIT]] monotonic
+// CHECK: [[EXEC:%.+]] = call i64 @llvm.nvvm.read.ptx.sreg.clock64()
+// CHECK: switch i64
+// CHECK: call void {{@__omp_outlined.+_wrapper}}(
+// CHECK: [[DONE:%.+]] = call i64 @llvm.nvvm.read.ptx.sreg.clock64()
+// CHECK: [[PAR:%.+]] = sub i64 [[DONE]], [[EXEC]]
+// CHECK: atomicrmw add i64* getelementptr inbounds ([2 x i64], [2 x i64]* [[PAR_CYCLES]], i32 0, i32 0), i64 [[PAR]] monotonic
+// CHECK: call void {{@__omp_outlined.+_wrapper}}(
+// CHECK: atomicrmw add i64* getelementptr inbounds ([2 x i64], [2 x i64]* [[PAR_CYCLES]], i32 0, i32 1),
+// CHECK: call void @llvm.nvvm.barrier0()
+// CHECK: atomicrmw add i64* getelementptr inbounds ([4 x i64], [4 x i64]* [[GEN_CYCLES]], i32 0, i32 2),
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+two_regions.+}}(
+// CHECK: atomicrmw add i64* getelementptr inbounds ([4 x i64], [4 x i64]* [[GEN_CYCLES]], i32 0, i32 0),
+// CHECK-NEXT: call void @__kmpc_kernel_deinit(
+
+void spmd_loop(int *a, int n) {
+#pragma omp target teams distribute parallel for map(tofrom: a[:n])
+  for (int i = 0; i < n; ++i)
+    a[i] += i;
+}
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+spmd_loop.+}}(
+// CHECK: call void @__kmpc_spmd_kernel_init(
+// CHECK: [[START:%.+]] = call i64 @llvm.nvvm.read.ptx.sreg.clock64()
+// CHECK: [[KERNEL:%.+]] = sub i64 %{{.+}}, [[START]]
+// CHECK-NEXT: atomicrmw add i64* getelementptr inbounds ([4 x i64], [4 x i64]* [[SPMD_CYCLES]], i32 0, i32 0), i64 [[KERNEL]] monotonic
+
+#endif
@@ -0,0 +1,41 @@
+// Test the per-team data sharing pool - host bc file has to be created first.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -fopenmp-nvptx-data-sharing-pool -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -o - | FileCheck %s --check-prefix NOPOOL
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// The shared array and the reference to 'arr' take 1608 bytes, which is
+// rounded up to a multiple of the slot size. The pool has a master slot of
+// that size for each team, which is the root slot of the master thread.
+// CHECK: [[POOL:@__omp_offloading_.+large_frame.+_data_sharing_pool]] = internal global [1024 x %struct.__openmp_nvptx_data_sharing_pool_slot_ty] zeroinitializer
+// CHECK-NOT: small_frame{{.*}}_data_sharing_pool =
+// NOPOOL-NOT: _data_sharing_pool =
+// CHECK: [[SLOT:%.+]] = getelementptr inbounds [1024 x %struct.__openmp_nvptx_data_sharing_pool_slot_ty], [1024 x %struct.__openmp_nvptx_data_sharing_pool_slot_ty]* [[POOL]], i32 0, i32 %{{.+}}
+// CHECK: [[CAST:%.+]] = bitcast %struct.__openmp_nvptx_data_sharing_pool_slot_ty* [[SLOT]] to %struct.__kmpc_data_sharing_slot*
+// CHECK: call void @__kmpc_initialize_data_sharing_environment(%struct.__kmpc_data_sharing_slot* [[CAST]], i64 1792)
+void large_frame(double *arr) {
+#pragma omp target map(arr[0:10])
+  {
+    double a[200];
+    for (int i = 0; i < 200; i++)
+      a[i] = i;
+#pragma omp parallel for
+    for (int i = 0; i < 10; i++)
+      arr[i] += a[i];
+  }
+}
+
+// A frame that fits the initial slot does not need a pool.
+void small_frame(double *arr) {
+#pragma omp target map(arr[0:10])
+  {
+    double a = 1.0;
+#pragma omp parallel for
+    for (int i = 0; i < 10; i++)
+      arr[i] += a;
+  }
+}
+
+#endif
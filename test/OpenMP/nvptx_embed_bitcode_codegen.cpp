@@ -0,0 +1,22 @@
+// Test that the device compilation writes the bitcode of the device code
+// behind a wrapper header, for the host link to embed it.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -fopenmp-device-bitcode-output %t.jit.bc -o %t.ll
+// RUN: head -c 4 %t.jit.bc | od -An -tx1 | FileCheck %s --check-prefix MAGIC
+// RUN: llvm-dis %t.jit.bc -o - | FileCheck %s
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// MAGIC: de c0 17 0b
+
+// CHECK: define {{.*}}void @__omp_offloading_{{.+}}_Z3fooi_l{{[0-9]+}}(
+
+int foo(int n) {
+  int a = 0;
+#pragma omp target map(tofrom : a)
+  a = n;
+  return a;
+}
+
+#endif
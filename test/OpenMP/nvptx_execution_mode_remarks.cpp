@@ -0,0 +1,39 @@
+// Test the remarks on the NVPTX execution mode - host bc file has to be created first.
+// RUN: %clang_cc1 -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -Rpass-analysis -o /dev/null 2>&1 | FileCheck %s
+#ifndef HEADER
+#define HEADER
+
+void serial(int *a, int n) {
+#pragma omp target map(tofrom: a[:n])
+  {
+    // CHECK-DAG: nvptx_execution_mode_remarks.cpp:[[@LINE+1]]:5: remark: Target region executed in generic mode: this statement is executed outside of a 'teams' region
+    a[0] = n;
+    // CHECK-DAG: nvptx_execution_mode_remarks.cpp:[[@LINE+2]]:{{[0-9]+}}: remark: Variable 'n' shared with the 'parallel for' region is moved to the data sharing stack of the team
+#pragma omp parallel for
+    for (int i = 1; i < n; ++i)
+      a[i] = i;
+  }
+}
+
+int reduce(int *a, int n) {
+  int s = 0;
+  // CHECK-DAG: nvptx_execution_mode_remarks.cpp:[[@LINE+1]]:{{[0-9]+}}: remark: Target region executed in generic mode: the teams reduction is combined by the team master
+#pragma omp target teams map(to: a[:n]) reduction(+: s)
+#pragma omp distribute parallel for reduction(+: s)
+  for (int i = 0; i < n; ++i)
+    s += a[i];
+  return s;
+}
+
+void dynamic(int *a, int n) {
+  // CHECK-DAG: nvptx_execution_mode_remarks.cpp:[[@LINE+1]]:{{[0-9]+}}: remark: Loop iterations are not distributed to adjacent threads: only 'schedule(static, 1)' and 'schedule(auto)' can be coalesced
+#pragma omp target teams distribute parallel for map(tofrom: a[:n]) schedule(dynamic)
+  for (int i = 0; i < n; ++i)
+    a[i] += i;
+}
+
+// An SPMD kernel is not explained.
+// CHECK-NOT: executed in generic mode
+
+#endif
@@ -0,0 +1,48 @@
+// Test kernel launch bounds annotations - host bc file has to be created first.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -fopenmp-nvptx-min-teams-per-sm=4 -o - | FileCheck %s --check-prefix MINTEAMS
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+void spmd_num_threads(int *a) {
+#pragma omp target parallel for num_threads(128)
+  for (int i = 0; i < 1024; ++i)
+    a[i] = i;
+}
+
+void spmd_both(int *a) {
+#pragma omp target teams distribute parallel for thread_limit(256) num_threads(64)
+  for (int i = 0; i < 1024; ++i)
+    a[i] = i;
+}
+
+void generic_thread_limit(int *a) {
+#pragma omp target teams thread_limit(96)
+  a[0] = 1;
+}
+
+void nested_teams(int *a) {
+#pragma omp target
+#pragma omp teams thread_limit(160)
+  a[0] = 1;
+}
+
+void unknown(int *a, int n) {
+#pragma omp target teams thread_limit(n)
+  a[0] = 1;
+}
+
+// CHECK-DAG: !{void ({{.+}})* [[SPMD_NT:@__omp_offloading_.+spmd_num_threads.+]], !"maxntidx", i32 128}
+// CHECK-DAG: !{void ({{.+}})* [[SPMD_BOTH:@__omp_offloading_.+spmd_both.+]], !"maxntidx", i32 64}
+// CHECK-DAG: !{void ({{.+}})* [[GENERIC:@__omp_offloading_.+generic_thread_limit.+]], !"maxntidx", i32 128}
+// CHECK-DAG: !{void ({{.+}})* [[NESTED:@__omp_offloading_.+nested_teams.+]], !"maxntidx", i32 192}
+// CHECK-NOT: {{@__omp_offloading_.+unknown.+}}, !"maxntidx"
+// CHECK-NOT: !"minctasm"
+
+// MINTEAMS-DAG: !{void ({{.+}})* {{@__omp_offloading_.+spmd_num_threads.+}}, !"minctasm", i32 4}
+// MINTEAMS-DAG: !{void ({{.+}})* {{@__omp_offloading_.+generic_thread_limit.+}}, !"minctasm", i32 4}
+// MINTEAMS-NOT: {{@__omp_offloading_.+unknown.+}}, !"minctasm"
+
+#endif
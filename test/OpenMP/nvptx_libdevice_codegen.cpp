@@ -0,0 +1,34 @@
+// Test the math library calls of the NVPTX device code - host bc file has to be created first.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -o - | FileCheck %s --check-prefix CHECK --check-prefix PRECISE
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -ffast-math -o - | FileCheck %s --check-prefix CHECK --check-prefix FAST
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+extern "C" {
+double cos(double);
+float cosf(float);
+float expf(float);
+float atan2f(float, float);
+}
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+math.+}}(
+void math(double *a, float *b) {
+#pragma omp target map(tofrom: a[:1], b[:3])
+  {
+    // The double precision functions have no fast variant.
+    // CHECK: call double @__nv_cos(
+    a[0] = cos(a[0]);
+    // PRECISE: call float @__nv_cosf(
+    // FAST: call {{.*}}float @__nv_fast_cosf(
+    b[0] = cosf(b[0]);
+    // PRECISE: call float @__nv_expf(
+    // FAST: call {{.*}}float @__nv_fast_expf(
+    b[1] = __builtin_expf(b[1]);
+    // CHECK: call {{.*}}float @__nv_atan2f(
+    b[2] = atan2f(b[1], b[2]);
+  }
+}
+
+#endif
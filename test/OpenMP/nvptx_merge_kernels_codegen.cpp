@@ -0,0 +1,49 @@
+// Test merging of identical NVPTX kernels - host bc file has to be created first.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -fopenmp-merge-identical-kernels -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -o - | FileCheck %s --check-prefix NOMERGE
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// NOMERGE-NOT: _merged
+
+struct A {};
+struct B {};
+
+template <typename Tag>
+void scale(int *a, int n) {
+#pragma omp target teams distribute parallel for map(tofrom: a[:n])
+  for (int i = 0; i < n; ++i)
+    a[i] *= 2;
+}
+
+template void scale<A>(int *, int);
+template void scale<B>(int *, int);
+
+void shift(int *a, int n) {
+#pragma omp target teams distribute parallel for map(tofrom: a[:n])
+  for (int i = 0; i < n; ++i)
+    a[i] += 2;
+}
+
+// Both instantiations keep their kernel, which calls the body of the first.
+// CHECK-LABEL: define {{.*}}void @__omp_offloading_{{.+}}_Z5scaleI1AEvPii_l{{[0-9]+}}(
+// CHECK-NEXT: entry:
+// CHECK-NEXT: call void @__omp_offloading_{{.+}}_Z5scaleI1AEvPii_l{{[0-9]+}}_merged(
+// CHECK-NEXT: ret void
+
+// CHECK-LABEL: define {{.*}}void @__omp_offloading_{{.+}}_Z5scaleI1BEvPii_l{{[0-9]+}}(
+// CHECK-NEXT: entry:
+// CHECK-NEXT: call void @__omp_offloading_{{.+}}_Z5scaleI1AEvPii_l{{[0-9]+}}_merged(
+// CHECK-NEXT: ret void
+
+// A different target region is left alone.
+// CHECK-LABEL: define {{.*}}void @__omp_offloading_{{.+}}_Z5shiftPii_l{{[0-9]+}}(
+// CHECK-NOT: _merged
+// CHECK: call void @__kmpc_spmd_kernel_init(
+
+// CHECK: define internal void @__omp_offloading_{{.+}}_Z5scaleI1AEvPii_l{{[0-9]+}}_merged(
+// CHECK: call void @__kmpc_spmd_kernel_init(
+
+#endif
@@ -0,0 +1,88 @@
+// Test native dispatch of dynamic and guided loops - host bc file has to be created first.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -fopenmp-nvptx-native-dynamic-schedule -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -o - | FileCheck %s --check-prefix RUNTIME
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+void spmv(int n, const int *rows, const int *cols, const double *vals,
+          const double *x, double *y) {
+#pragma omp target teams distribute parallel for schedule(dynamic, 4)
+  for (int i = 0; i < n; ++i) {
+    double sum = 0;
+    for (int j = rows[i]; j < rows[i + 1]; ++j)
+      sum += vals[j] * x[cols[j]];
+    y[i] = sum;
+  }
+}
+
+void guided(long n, int *a) {
+#pragma omp target parallel for schedule(guided)
+  for (long i = 0; i < n; ++i)
+    a[i] += i;
+}
+
+void ordered(int n, int *a) {
+#pragma omp target teams distribute parallel for schedule(dynamic) ordered
+  for (int i = 0; i < n; ++i) {
+#pragma omp ordered
+    a[i] += i;
+  }
+}
+
+// CHECK-DAG: [[SPMV_COUNTER:@.+spmv.+\.dispatch_counter]] = internal addrspace(3) global i32 undef, align 4
+// CHECK-DAG: [[GUIDED_COUNTER:@.+guided.+\.dispatch_counter]] = internal addrspace(3) global i64 undef, align 8
+
+// The kernels do not need the runtime. The counter is reset between two
+// barriers, and the chunks of a full warp are taken by lane 0 and broadcast
+// to the other lanes.
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+spmv.+}}(
+// CHECK: call void @__kmpc_spmd_kernel_init(i32 {{.+}}, i16 0,
+// CHECK: call void @__kmpc_barrier_simple_spmd(
+// CHECK: store i32 0, i32 addrspace(3)* [[SPMV_COUNTER]], align 4
+// CHECK: call void @__kmpc_barrier_simple_spmd(
+// CHECK: omp.dispatch.cond:
+// CHECK: [[MASK:%.+]] = call i32 @__kmpc_warp_active_thread_mask()
+// CHECK: icmp eq i32 [[MASK]], -1
+// CHECK: omp.dispatch.leader:
+// CHECK: atomicrmw add i32 addrspace(3)* [[SPMV_COUNTER]], i32 {{.+}} monotonic
+// CHECK: omp.dispatch.broadcast:
+// CHECK: call i32 @llvm.nvvm.shfl.idx.i32(i32 {{%.+}}, i32 0, i32 31)
+// CHECK: omp.dispatch.lane:
+// CHECK: atomicrmw add i32 addrspace(3)* [[SPMV_COUNTER]], i32 {{.+}} monotonic
+// CHECK: omp.dispatch.fetched:
+// CHECK: [[BEGIN:%.+]] = phi i32
+// CHECK: [[HAS_CHUNK:%.+]] = icmp sle i32 [[BEGIN]],
+// CHECK: br i1 [[HAS_CHUNK]], label %omp.dispatch.body,
+// CHECK-NOT: __kmpc_dispatch
+// CHECK: ret void
+
+// The guided chunks are claimed with a compare and swap.
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+guided.+}}(
+// CHECK: omp.dispatch.guided:
+// CHECK: [[CUR:%.+]] = phi i64
+// CHECK: icmp sgt i64 [[CUR]],
+// CHECK: omp.dispatch.claim:
+// CHECK: sdiv i64
+// CHECK: cmpxchg i64 addrspace(3)* [[GUIDED_COUNTER]], i64 [[CUR]], i64 {{%.+}} monotonic monotonic
+// CHECK: omp.dispatch.fetched:
+// CHECK-NOT: __kmpc_dispatch
+// CHECK: ret void
+
+// Ordered loops still call the runtime.
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+ordered.+}}(
+// CHECK: call void @__kmpc_dispatch_init_4(
+// CHECK: call i32 @__kmpc_dispatch_next_4(
+// CHECK: ret void
+
+// RUNTIME-NOT: dispatch_counter
+// RUNTIME-LABEL: define {{.*}}void {{@__omp_offloading_.+spmv.+}}(
+// RUNTIME: call void @__kmpc_spmd_kernel_init(i32 {{.+}}, i16 1,
+// RUNTIME: call void @__kmpc_dispatch_init_4(
+// RUNTIME: call i32 @__kmpc_dispatch_next_4(
+// RUNTIME-LABEL: define {{.*}}void {{@__omp_offloading_.+guided.+}}(
+// RUNTIME: call void @__kmpc_dispatch_init_8(
+// RUNTIME: call i32 @__kmpc_dispatch_next_8(
+
+#endif
@@ -0,0 +1,74 @@
+// Performance regression test for reductions: every reduction clause, however
+// many variables it has, costs one runtime call per level, and none of them
+// goes through the full runtime when the kernel does not need it.  Host bc
+// file has to be created first.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -o %t.ll
+// RUN: FileCheck %s < %t.ll
+// RUN: FileCheck %s --check-prefix NORUNTIME < %t.ll
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// No reduction calls the full runtime, and none waits at a full barrier.
+// NORUNTIME-NOT: call {{.*}}@__kmpc_nvptx_parallel_reduce_nowait(
+// NORUNTIME-NOT: call {{.*}}@__kmpc_nvptx_teams_reduce_nowait(
+// NORUNTIME-NOT: call void @__kmpc_barrier(
+
+double dot(double *x, double *y, int n) {
+  double sum = 0;
+#pragma omp target teams distribute parallel for reduction(+: sum) map(to: x[:n], y[:n])
+  for (int i = 0; i < n; ++i)
+    sum += x[i] * y[i];
+  return sum;
+}
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+dot.+_l[0-9]+}}(
+// CHECK-NOT: call {{.*}}@__kmpc_nvptx_{{parallel|teams}}_reduce
+// CHECK: call i32 @__kmpc_nvptx_parallel_reduce_nowait_simple_spmd(i32 %{{.+}}, i32 1, i64 8,
+// CHECK-NOT: call {{.*}}@__kmpc_nvptx_{{parallel|teams}}_reduce
+// CHECK: call i32 @__kmpc_nvptx_teams_reduce_nowait_simple_spmd(i32 %{{.+}}, i32 1, i64 8,
+// CHECK-NOT: call {{.*}}@__kmpc_nvptx_{{parallel|teams}}_reduce
+
+// The variables of all the reduction clauses are reduced together.
+void stats(float *v, int n, float *lo, double *sq, int *count) {
+  float l = v[0];
+  double s = 0;
+  int c = 0;
+#pragma omp target teams distribute parallel for reduction(min: l) reduction(+: s, c) map(to: v[:n]) map(tofrom: l, s, c)
+  for (int i = 0; i < n; ++i) {
+    l = v[i] < l ? v[i] : l;
+    s += (double)v[i] * v[i];
+    c += v[i] != 0;
+  }
+  *lo = l;
+  *sq = s;
+  *count = c;
+}
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+stats.+_l[0-9]+}}(
+// CHECK-NOT: call {{.*}}@__kmpc_nvptx_{{parallel|teams}}_reduce
+// CHECK: call i32 @__kmpc_nvptx_parallel_reduce_nowait_simple_spmd(i32 %{{.+}}, i32 3, i64 24,
+// CHECK-NOT: call {{.*}}@__kmpc_nvptx_{{parallel|teams}}_reduce
+// CHECK: call i32 @__kmpc_nvptx_teams_reduce_nowait_simple_spmd(i32 %{{.+}}, i32 3, i64 24,
+// CHECK-NOT: call {{.*}}@__kmpc_nvptx_{{parallel|teams}}_reduce
+
+// A reduction in a parallel region of a generic-mode kernel is only reduced
+// across the threads of the team.
+void generic_sum(double *a, int n, double *out) {
+#pragma omp target map(to: a[:n]) map(from: out[:1])
+  {
+    double s = 0;
+#pragma omp parallel for reduction(+: s)
+    for (int i = 0; i < n; ++i)
+      s += a[i];
+    out[0] = s;
+  }
+}
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+generic_sum.+_l[0-9]+}}(
+// CHECK-NOT: call {{.*}}@__kmpc_nvptx_{{parallel|teams}}_reduce
+// CHECK: call i32 @__kmpc_nvptx_parallel_reduce_nowait_simple_generic(i32 %{{.+}}, i32 1, i64 8,
+// CHECK-NOT: call {{.*}}@__kmpc_nvptx_{{parallel|teams}}_reduce
+
+#endif
@@ -0,0 +1,61 @@
+// Performance regression test for SPMD-mode loops: a combined construct with
+// the coalesced schedule initializes the runtime state it does not use, and
+// splits its iterations with a single call outside of the loop.  Host bc file
+// has to be created first.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -o %t.ll
+// RUN: FileCheck %s < %t.ll
+// RUN: FileCheck %s --check-prefix NORUNTIME < %t.ll
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// None of the kernels needs the full runtime, a full barrier, a dynamic
+// schedule or the data sharing stack.
+// NORUNTIME-NOT: call void @__kmpc_spmd_kernel_deinit(
+// NORUNTIME-NOT: call void @__kmpc_barrier(
+// NORUNTIME-NOT: call {{.*}}@__kmpc_dispatch_
+// NORUNTIME-NOT: call {{.*}}@__kmpc_data_sharing_
+
+void saxpy(float a, float *x, float *y, int n) {
+#pragma omp target teams distribute parallel for map(to: x[:n]) map(tofrom: y[:n])
+  for (int i = 0; i < n; ++i)
+    y[i] = a * x[i] + y[i];
+}
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+saxpy.+_l[0-9]+}}(
+// CHECK: call void @__kmpc_spmd_kernel_init(i32 %{{.+}}, i16 0, i16 0)
+// CHECK-NOT: call {{.*}}@__kmpc_for_static_init
+// CHECK: call void @__kmpc_for_static_init_4_simple_spmd({{.+}}, i32 93,
+// CHECK-NOT: call {{.*}}@__kmpc_for_static_init
+// CHECK: call void @__kmpc_for_static_fini(
+// CHECK-NOT: call {{.*}}@__kmpc_for_static_init
+
+// A 64-bit loop keeps the single call.
+void fill(double *a, long n) {
+#pragma omp target teams distribute parallel for map(from: a[:n])
+  for (long i = 0; i < n; ++i)
+    a[i] = i;
+}
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+fill.+_l[0-9]+}}(
+// CHECK: call void @__kmpc_spmd_kernel_init(i32 %{{.+}}, i16 0, i16 0)
+// CHECK-NOT: call {{.*}}@__kmpc_for_static_init
+// CHECK: call void @__kmpc_for_static_init_8_simple_spmd({{.+}}, i32 93,
+// CHECK-NOT: call {{.*}}@__kmpc_for_static_init
+// CHECK: call void @__kmpc_for_static_fini(
+
+// A distribute chunk that differs from the team size cannot be coalesced, so
+// the loop is split across the teams first.
+void chunked(float *x, int n) {
+#pragma omp target teams distribute parallel for thread_limit(128) dist_schedule(static, 64) map(tofrom: x[:n])
+  for (int i = 0; i < n; ++i)
+    x[i] *= 2;
+}
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+chunked.+_l[0-9]+}}(
+// CHECK: call void @__kmpc_spmd_kernel_init(i32 %{{.+}}, i16 0, i16 0)
+// CHECK-NOT: call {{.*}}@__kmpc_for_static_init
+// CHECK: call void @__kmpc_for_static_init_4_simple_spmd({{.+}}, i32 91,
+
+#endif
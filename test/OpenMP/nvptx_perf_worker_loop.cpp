@@ -0,0 +1,67 @@
+// Performance regression test for the state machine of generic-mode kernels:
+// the loop the workers wait in, and the code the master runs to start a
+// parallel region, must not gain runtime calls or barriers.  Host bc file has
+// to be created first.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -fopenmp-nvptx-requireruntime -o - | FileCheck %s --check-prefix RUNTIME
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+void one_region(int *a, int n) {
+#pragma omp target map(tofrom: a[:2])
+  {
+    a[0] = n;
+#pragma omp parallel
+    a[1] = n;
+  }
+}
+
+// Each iteration of the worker loop waits at two barriers and makes a single
+// runtime call.  With one parallel region the work function is called
+// directly instead of through a switch.
+// CHECK-LABEL: define internal void {{@__omp_offloading_.+one_region.+}}_worker()
+// CHECK: .await.work:
+// CHECK-NEXT: call void @llvm.nvvm.barrier0()
+// CHECK-NEXT: call i1 @__kmpc_kernel_parallel(i8** %work_fn, i16 0)
+// CHECK-NOT: call {{.*}}@__kmpc_
+// CHECK-NOT: switch
+// CHECK: .execute.parallel:
+// CHECK-NOT: call {{.*}}@__kmpc_
+// CHECK: call void {{@__omp_outlined.+}}_wrapper(i16 0, i32 %
+// CHECK-NOT: call {{.*}}@__kmpc_
+// CHECK: .barrier.parallel:
+// CHECK-NEXT: call void @llvm.nvvm.barrier0()
+// CHECK-NEXT: br label %.await.work
+// CHECK-NOT: call
+// CHECK: ret void
+// CHECK-NEXT: }
+
+// The master starts the region with one runtime call and two barriers, and
+// does not ask the runtime for the parallelism level it runs at.
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+one_region.+_l[0-9]+}}(
+// CHECK-NOT: call {{.*}}@__kmpc_parallel_level(
+// CHECK: call void @__kmpc_kernel_prepare_parallel(i8* inttoptr (i64 1 to i8*), i16 0)
+// CHECK-NEXT: call void @llvm.nvvm.barrier0()
+// CHECK-NEXT: call void @llvm.nvvm.barrier0()
+// CHECK-NOT: call {{.*}}@__kmpc_parallel_level(
+// CHECK: call void @__kmpc_kernel_deinit(i16 0)
+
+// With the runtime, the workers also tell it that the region has ended.
+// RUNTIME-LABEL: define internal void {{@__omp_offloading_.+one_region.+}}_worker()
+// RUNTIME: call i1 @__kmpc_kernel_parallel(i8** %work_fn, i16 1)
+// RUNTIME-NOT: call {{.*}}@__kmpc_
+// RUNTIME: .terminate.parallel:
+// RUNTIME-NEXT: call void @__kmpc_kernel_end_parallel()
+// RUNTIME-NEXT: br label %.barrier.parallel
+// RUNTIME-NOT: call {{.*}}@__kmpc_
+// RUNTIME: ret void
+// RUNTIME-NEXT: }
+
+// RUNTIME-LABEL: define {{.*}}void {{@__omp_offloading_.+one_region.+_l[0-9]+}}(
+// RUNTIME: call void @__kmpc_kernel_prepare_parallel(i8* inttoptr (i64 1 to i8*), i16 1)
+// RUNTIME-NEXT: call void @llvm.nvvm.barrier0()
+// RUNTIME-NEXT: call void @llvm.nvvm.barrier0()
+
+#endif
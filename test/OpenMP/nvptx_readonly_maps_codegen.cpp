@@ -0,0 +1,48 @@
+// Test read-only map parameters of NVPTX kernels - host bc file has to be created first.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -o - | FileCheck %s
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// Const data that is only mapped 'to' is not written by the kernel.
+// CHECK: define {{.*}}void {{@__omp_offloading_.+scale.+}}(double* readonly %in, double* %out,
+void scale(const double *in, double *out, int n) {
+#pragma omp target teams distribute parallel for map(to: in[:n]) map(from: out[:n])
+  for (int i = 0; i < n; ++i)
+    out[i] = 2 * in[i];
+}
+
+// CHECK: define {{.*}}void {{@__omp_offloading_.+table.+}}([16 x double]* readonly{{.*}} %t, double* %out)
+void table(double *out) {
+  const double t[16] = {1};
+#pragma omp target map(to: t) map(tofrom: out[:16])
+  for (int i = 0; i < 16; ++i)
+    out[i] += t[i];
+}
+
+// Non-const data, other map types and casts that drop the constness keep
+// the parameters writable.
+// CHECK-NOT: readonly
+// CHECK: define {{.*}}void {{@__omp_offloading_.+writable.+}}(double* %in, double* %out,
+// CHECK: define {{.*}}void {{@__omp_offloading_.+tofrom.+}}(double* %in, double* %out,
+// CHECK: define {{.*}}void {{@__omp_offloading_.+casted.+}}(double* %in, double* %out,
+void writable(double *in, double *out, int n) {
+#pragma omp target map(to: in[:n]) map(from: out[:n])
+  for (int i = 0; i < n; ++i)
+    out[i] = in[i];
+}
+
+void tofrom(const double *in, double *out, int n) {
+#pragma omp target map(in[:n]) map(from: out[:n])
+  for (int i = 0; i < n; ++i)
+    out[i] = in[i];
+}
+
+void casted(const double *in, double *out, int n) {
+#pragma omp target map(to: in[:n]) map(from: out[:n])
+  for (int i = 0; i < n; ++i)
+    out[i] = ((double *)in)[i]++;
+}
+
+#endif
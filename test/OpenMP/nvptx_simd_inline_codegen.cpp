@@ -0,0 +1,42 @@
+// Test inline simd loops in NVPTX SPMD kernels - host bc file has to be created first.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -o - | FileCheck %s
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+void spmd(double *a, int n, int m) {
+#pragma omp target teams distribute parallel for map(tofrom: a[:n * m])
+  for (int i = 0; i < n; ++i)
+#pragma omp simd simdlen(4)
+    for (int j = 0; j < m; ++j)
+      a[i * m + j] *= 2;
+}
+
+// The simd loop of an SPMD kernel runs as a single lane, its accesses are
+// marked parallel for the loop vectorizer.
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+spmd.+}}(
+// CHECK-NOT: __kmpc_kernel_convergent_simd
+// CHECK: store i32 0, i32* [[LANE:%.omp.lane.init]],
+// CHECK: store i32 1, i32* [[LANES:%.omp.num.lanes]],
+// CHECK: load i32, i32* [[LANE]],
+// CHECK: load double, double* %{{.+}}, !llvm.mem.parallel_loop_access
+// CHECK: load i32, i32* [[LANES]],
+// CHECK: br label %{{.+}}, !llvm.loop [[LOOP:![0-9]+]]
+
+void generic(double *a, int m) {
+#pragma omp target map(tofrom: a[:m])
+#pragma omp parallel
+#pragma omp simd
+  for (int j = 0; j < m; ++j)
+    a[j] *= 2;
+}
+
+// The simd loops of generic kernels are still executed by the lanes.
+// CHECK: call {{.+}} @__kmpc_kernel_convergent_simd(
+
+// CHECK: [[LOOP]] = distinct !{[[LOOP]], [[WIDTH:![0-9]+]], [[ENABLE:![0-9]+]]}
+// CHECK: [[WIDTH]] = !{!"llvm.loop.vectorize.width", i32 4}
+// CHECK: [[ENABLE]] = !{!"llvm.loop.vectorize.enable", i1 true}
+
+#endif
@@ -0,0 +1,74 @@
+// Test SPMD mode for teams regions with nested parallel regions - host bc file has to be created first.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -fopenmp-combine-dirs -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -o - | FileCheck %s --check-prefix GENERIC
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+int foo(int);
+
+void analyzable(int *a, int *b, int n) {
+#pragma omp target teams map(tofrom: a[:n], b[:n])
+  {
+    int half = n / 2;
+#pragma omp parallel for
+    for (int i = 0; i < half; ++i)
+      a[i] += half;
+#pragma omp parallel for
+    for (int i = half; i < n; ++i)
+      b[i] = a[i - half];
+  }
+}
+
+void nested_teams(int *a, int n) {
+#pragma omp target map(tofrom: a[:n])
+#pragma omp teams
+  {
+    int m = n;
+#pragma omp parallel
+    a[0] = m;
+  }
+}
+
+void side_effect(int *a, int n) {
+#pragma omp target teams map(tofrom: a[:n])
+  {
+    int m = foo(n);
+#pragma omp parallel for
+    for (int i = 0; i < m; ++i)
+      a[i] = i;
+  }
+}
+
+void written_in_parallel(int *a, int n) {
+#pragma omp target teams map(tofrom: a[:n])
+  {
+    int m = n;
+#pragma omp parallel
+    m = a[0];
+  }
+}
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+analyzable.+}}(
+// CHECK: call void @__kmpc_spmd_kernel_init(
+// CHECK: call void {{@__omp_outlined.+}}(
+// CHECK: call void @__kmpc_barrier(
+// CHECK: call void {{@__omp_outlined.+}}(
+// CHECK: call void @__kmpc_barrier(
+// CHECK: call void @__kmpc_spmd_kernel_deinit(
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+nested_teams.+}}(
+// CHECK: call void @__kmpc_spmd_kernel_init(
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+side_effect.+}}(
+// CHECK-NOT: call void @__kmpc_spmd_kernel_init(
+// CHECK: call void @__kmpc_kernel_init(
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+written_in_parallel.+}}(
+// CHECK-NOT: call void @__kmpc_spmd_kernel_init(
+// CHECK: call void @__kmpc_kernel_init(
+
+// GENERIC-NOT: call void @__kmpc_spmd_kernel_init(
+
+#endif
@@ -0,0 +1,57 @@
+// Test static data sharing frames - host bc file has to be created first.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -fopenmp-nvptx-static-data-sharing -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -fopenmp-nvptx-static-data-sharing -o - | FileCheck %s --check-prefix CLOSE
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -o - | FileCheck %s --check-prefix RUNTIME
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// CHECK-DAG: [[FRAME:@__omp_offloading_.+fixed_size.+\.static_data_share]] = internal addrspace(3) global %struct.__openmp_nvptx_data_sharing_master_record{{.*}} undef
+// CHECK-NOT: {{@__omp_offloading_.+vla_size.+\.static_data_share}}
+
+void fixed_size(int *arr) {
+#pragma omp target teams map(arr[0:10])
+  {
+    int a = 1;
+    double b = 2.0;
+#pragma omp parallel for
+    for (int i = 0; i < 10; i++)
+      arr[i] += a + b;
+  }
+}
+
+// CHECK-LABEL: define internal void {{@__omp_offloading_.+fixed_size.+}}.data_share(
+// CHECK: .master:
+// CHECK-NOT: call i8* @__kmpc_data_sharing_environment_begin(
+// The fields are addressed in the shared address space, only the addresses
+// published to the region are generic.
+// CHECK: store {{.+}} addrspacecast ({{.+}} addrspace(3)* getelementptr inbounds (%struct.__openmp_nvptx_data_sharing_master_record{{.*}} addrspace(3)* [[FRAME]], i32 0, i32 {{[0-9]+}}) to
+
+void vla_size(int *arr, int n) {
+#pragma omp target teams map(arr[0:10])
+  {
+    int a[n];
+    a[0] = 1;
+#pragma omp parallel for
+    for (int i = 0; i < 10; i++)
+      arr[i] += a[0];
+  }
+}
+
+// CHECK-LABEL: define internal void {{@__omp_offloading_.+vla_size.+}}.data_share(
+// CHECK: call i8* @__kmpc_data_sharing_environment_begin(
+
+// A static frame opens no data sharing environment, so the kernel must not
+// close one.
+// CLOSE-LABEL: define {{.*}}void @__omp_offloading_{{.+}}_Z10fixed_sizePi_l{{[0-9]+}}(
+// CLOSE-NOT:   call void @__kmpc_data_sharing_environment_end(
+// CLOSE:       ret void
+// CLOSE-LABEL: define {{.*}}void @__omp_offloading_{{.+}}_Z8vla_sizePii_l{{[0-9]+}}(
+// CLOSE:       call void @__kmpc_data_sharing_environment_end(
+// CLOSE:       ret void
+
+// RUNTIME-NOT: static_data_share
+// RUNTIME: call i8* @__kmpc_data_sharing_environment_begin(
+
+#endif
@@ -0,0 +1,69 @@
+// Test staging of the arrays of stencil loops in shared memory - host bc file has to be created first.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -fopenmp-nvptx-stencil-tiling -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -o - | FileCheck %s --check-prefix NOTILE
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+#define N 64
+double A[N][N], B[N][N];
+
+// The tile holds the elements read by a team of 128 threads, widened by the
+// offsets of the reads, -N to N, and by a row.
+// CHECK: @{{__omp_offloading_.+jacobi.+}}.stencil_tile = internal addrspace(3) global [320 x double] undef, align 8
+// CHECK-NOT: .stencil_tile =
+
+// NOTILE-NOT: .stencil_tile
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+jacobi.+}}(
+// The team copies its window of A to the tile.
+// CHECK: [[SRC:%.+]] = load double, double* %{{.+}}, align 8
+// CHECK: store double [[SRC]], double addrspace(3)* %{{.+}}, align 8
+// CHECK: call void @__kmpc_barrier_simple_spmd(
+// Reads in the window come from the tile, the others from A.
+// CHECK: [[TILE:%.+]] = addrspacecast double addrspace(3)* %{{.+}} to double*
+// CHECK: [[ELT:%.+]] = select i1 %{{.+}}, double* [[TILE]], double* %{{.+}}
+// CHECK: load double, double* [[ELT]], align 8
+// CHECK: call void @__kmpc_barrier_simple_spmd(
+// CHECK: ret void
+void jacobi() {
+#pragma omp target teams distribute parallel for collapse(2) thread_limit(128) map(to: A) map(from: B)
+  for (int i = 1; i < N - 1; ++i)
+    for (int j = 1; j < N - 1; ++j)
+      B[i][j] = 0.25 * (A[i - 1][j] + A[i + 1][j] + A[i][j - 1] + A[i][j + 1]);
+}
+
+// Arrays that are written, read at a single offset, or read by teams of
+// unknown size are not staged.
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+inplace.+}}(
+// CHECK-NOT: select i1 %{{.+}}, double* %{{.+}}, double* %{{.+}}
+// CHECK: ret void
+void inplace() {
+#pragma omp target teams distribute parallel for collapse(2) thread_limit(128) map(tofrom: A)
+  for (int i = 1; i < N - 1; ++i)
+    for (int j = 1; j < N - 1; ++j)
+      A[i][j] = 0.5 * (A[i][j - 1] + A[i][j + 1]);
+}
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+pointwise.+}}(
+// CHECK-NOT: select i1 %{{.+}}, double* %{{.+}}, double* %{{.+}}
+// CHECK: ret void
+void pointwise() {
+#pragma omp target teams distribute parallel for collapse(2) thread_limit(128) map(to: A) map(from: B)
+  for (int i = 0; i < N; ++i)
+    for (int j = 0; j < N; ++j)
+      B[i][j] = 2 * A[i][j];
+}
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+unbounded.+}}(
+// CHECK-NOT: select i1 %{{.+}}, double* %{{.+}}, double* %{{.+}}
+// CHECK: ret void
+void unbounded() {
+#pragma omp target teams distribute parallel for collapse(2) map(to: A) map(from: B)
+  for (int i = 1; i < N - 1; ++i)
+    for (int j = 1; j < N - 1; ++j)
+      B[i][j] = A[i - 1][j] + A[i + 1][j];
+}
+
+#endif
@@ -0,0 +1,40 @@
+// Test inlined teams reduction codegen - host bc file has to be created first.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -fopenmp-nvptx-inline-teams-reduction -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -o - | FileCheck %s --check-prefix RUNTIME
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// CHECK-DAG: [[SCRATCHPAD:@.omp.reduction.teams_scratchpad[.0-9]*]] = internal global [8192 x i8] zeroinitializer, align 256
+// CHECK-DAG: [[COUNTER:@.omp.reduction.teams_counter[.0-9]*]] = internal global i32 0
+
+double sum(double *a, int n) {
+  double s = 0;
+#pragma omp target teams distribute parallel for reduction(+: s) map(to: a[0:n])
+  for (int i = 0; i < n; ++i)
+    s += a[i];
+  return s;
+}
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+sum.+}}_worker()
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+sum.+}}(
+// CHECK: call i32 @__kmpc_nvptx_parallel_reduce_nowait_simple_spmd(
+// CHECK-NOT: call i32 @__kmpc_nvptx_teams_reduce_nowait
+// CHECK: .omp.reduction.team_master:
+// CHECK: call void @.omp.reduction.copy_to_scratchpad(i8* {{.+}}, i8* getelementptr inbounds ([8192 x i8], [8192 x i8]* [[SCRATCHPAD]], i32 0, i32 0), i32 {{.+}}, i32 {{.+}})
+// CHECK: call void @llvm.nvvm.membar.gl()
+// CHECK: atomicrmw add i32* [[COUNTER]], i32 1 monotonic
+// CHECK: .omp.reduction.last_team:
+// CHECK: call void @llvm.nvvm.membar.gl()
+// CHECK: store i32 0, i32* [[COUNTER]]
+// CHECK: .omp.reduction.teams_reduce:
+// CHECK: call void @.omp.reduction.load_and_reduce(i8* {{.+}}, i8* getelementptr inbounds ([8192 x i8], [8192 x i8]* [[SCRATCHPAD]], i32 0, i32 0), i32 {{.+}}, i32 {{.+}}, i32 1)
+// CHECK: .omp.reduction.teams_done:
+// CHECK: phi i32 [ 0, {{.+}} ], [ 0, {{.+}} ], [ 1, {{.+}} ]
+// CHECK: call void @__kmpc_nvptx_end_reduce_nowait(
+
+// RUNTIME-NOT: teams_scratchpad
+// RUNTIME: call i32 @__kmpc_nvptx_teams_reduce_nowait
+
+#endif
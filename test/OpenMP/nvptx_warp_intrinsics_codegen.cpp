@@ -0,0 +1,42 @@
+// Test the warp primitives of the OpenMP device code - host bc file has to be created first.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -o - | FileCheck %s --check-prefix HOST
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -o - | FileCheck %s --check-prefix DEVICE
+#ifndef HEADER
+#define HEADER
+
+#include <omp_nvptx_intrinsics.h>
+
+// The host fallback runs warps of a single lane.
+// HOST-NOT: llvm.nvvm
+
+// DEVICE: call i32 @llvm.nvvm.read.ptx.sreg.laneid()
+// DEVICE: call i32 @llvm.nvvm.shfl.down.i32(i32 %{{.+}}, i32 %{{.+}}, i32 31)
+// DEVICE: call i32 @llvm.nvvm.vote.ballot(
+int warp_sum(int *a) {
+  int s = 0;
+#pragma omp target map(tofrom: s) map(to: a[:32])
+#pragma omp parallel num_threads(32) reduction(+: s)
+  {
+    int v = a[__omp_lane_id()];
+    for (int d = __omp_warp_size() / 2; d > 0; d /= 2)
+      v += __omp_shfl_down_i32(v, d, __omp_warp_size());
+    if (__omp_ballot(v > 0) && __omp_lane_id() == 0)
+      s += v;
+  }
+  return s;
+}
+
+#ifdef __NVPTX__
+int not_offloaded(int v) {
+  return __nvvm_shfl_down_i32(v, 1, 31); // expected-warning {{warp primitive '__nvvm_shfl_down_i32' used outside of a target region or a declare target function}}
+}
+
+#pragma omp declare target
+int offloaded(int v) { return __nvvm_vote_ballot(v); }
+#pragma omp end declare target
+#else
+// expected-no-diagnostics
+#endif
+
+#endif
@@ -0,0 +1,37 @@
+// Test worker loop dispatch of parallel regions - host bc file has to be created first.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple nvptx64-unknown-unknown -fopenmp-targets=nvptx64-nvidia-cuda -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -o - | FileCheck %s
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+void two_regions(int *a) {
+#pragma omp target map(tofrom: a[:2])
+  {
+#pragma omp parallel
+    a[0] = 1;
+#pragma omp parallel
+    a[1] = 2;
+  }
+}
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+two_regions.+}}_worker()
+// CHECK: [[WORK:%.+]] = load volatile i8*, i8** %work_fn
+// CHECK: [[ID:%.+]] = ptrtoint i8* [[WORK]] to i64
+// CHECK: switch i64 [[ID]], label %[[DEFAULT:.+]] [
+// CHECK-NEXT: i64 1, label %[[FN1:.+]]
+// CHECK-NEXT: i64 2, label %[[FN2:.+]]
+// CHECK-NEXT: ]
+// CHECK: [[FN1]]:
+// CHECK: call void {{@__omp_outlined.+_wrapper}}(
+// CHECK: [[FN2]]:
+// CHECK: call void {{@__omp_outlined.+_wrapper}}(
+// CHECK: [[DEFAULT]]:
+// CHECK-NOT: call void %
+// CHECK: br label
+
+// CHECK-LABEL: define {{.*}}void {{@__omp_offloading_.+two_regions.+}}(
+// CHECK: call void @__kmpc_kernel_prepare_parallel(i8* inttoptr (i64 1 to i8*),
+// CHECK: call void @__kmpc_kernel_prepare_parallel(i8* inttoptr (i64 2 to i8*),
+
+#endif
@@ -0,0 +1,67 @@
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple x86_64-unknown-unknown -fopenmp-doacross-tile-size=16 -emit-llvm %s -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple x86_64-unknown-unknown -emit-llvm %s -o - | FileCheck %s --check-prefix UNTILED
+// expected-no-diagnostics
+
+#ifndef HEADER
+#define HEADER
+
+// UNTILED-LABEL: define {{.*}}void @{{.+}}wavefront
+// UNTILED-NOT: omp.doacross.wait
+// UNTILED: call void @__kmpc_doacross_wait(
+// UNTILED: call void @__kmpc_doacross_post(
+
+// CHECK-LABEL: define {{.*}}void @{{.+}}wavefront
+void wavefront(int n, int m, double *a) {
+// The runtime tracks the tiles of the iterations.
+// CHECK: [[NUMTILES:%.+]] = sdiv i64 %{{.+}}, 16
+// CHECK: store i64 [[NUMTILES]], i64* %
+// CHECK: call void @__kmpc_doacross_init(
+#pragma omp for ordered(2) schedule(dynamic, 64)
+  for (int i = 1; i < n; ++i)
+    for (int j = 1; j < m; ++j) {
+      // A sink in the current tile is not waited for.
+      // CHECK: [[SINKTILE:%.+]] = sdiv i64 %{{.+}}, 16
+      // CHECK: store i64 [[SINKTILE]], i64* [[SINKADDR:%.+]],
+      // CHECK: [[CURTILE:%.+]] = sdiv i64 %{{.+}}, 16
+      // CHECK: icmp eq i64 [[SINKTILE]], [[CURTILE]]
+      // CHECK: br i1 %{{.+}}, label %[[CONT:.+]], label %[[WAIT:.+]]
+      // CHECK: [[WAIT]]:
+      // CHECK: call void @__kmpc_doacross_wait({{.+}}, i64* [[SINKADDR]])
+      // CHECK: [[CONT]]:
+#pragma omp ordered depend(sink : i, j - 1)
+      // CHECK: call void @__kmpc_doacross_wait(
+#pragma omp ordered depend(sink : i - 1, j)
+      a[i * m + j] += a[(i - 1) * m + j] + a[i * m + j - 1];
+      // The tile is posted after its last iteration or the last iteration of
+      // the chunk.
+      // CHECK: [[TILE:%.+]] = sdiv i64 [[CNT:%.+]], 16
+      // CHECK: store i64 [[TILE]], i64* [[TILEADDR:%.+]],
+      // CHECK: [[REM:%.+]] = srem i64 [[CNT]], 16
+      // CHECK: icmp eq i64 [[REM]], 15
+      // CHECK: icmp sge i64 [[CNT]], %
+      // CHECK: br i1 %{{.+}}, label %[[POST:.+]], label %[[CONT2:.+]]
+      // CHECK: [[POST]]:
+      // CHECK: call void @__kmpc_doacross_post({{.+}}, i64* [[TILEADDR]])
+      // CHECK: [[CONT2]]:
+#pragma omp ordered depend(source)
+    }
+// CHECK: call void @__kmpc_doacross_fini(
+}
+
+// A tile may be split between two threads without a chunk size that is a
+// multiple of the tile size, so the iterations are posted one by one.
+// CHECK-LABEL: define {{.*}}void @{{.+}}unaligned
+// CHECK-NOT: sdiv i64 {{.+}}, 16
+// CHECK: call void @__kmpc_doacross_wait(
+// CHECK-NOT: omp.doacross.post
+// CHECK: call void @__kmpc_doacross_post(
+void unaligned(int n, double *a) {
+#pragma omp for ordered(1) schedule(static, 24)
+  for (int i = 1; i < n; ++i) {
+#pragma omp ordered depend(sink : i - 1)
+    a[i] += a[i - 1];
+#pragma omp ordered depend(source)
+  }
+}
+
+#endif
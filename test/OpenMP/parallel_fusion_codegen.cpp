@@ -0,0 +1,51 @@
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple x86_64-unknown-unknown -fopenmp-fuse-parallel-regions -emit-llvm %s -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple x86_64-unknown-unknown -emit-llvm %s -o - | FileCheck %s --check-prefix NOFUSE
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// NOFUSE-NOT: omp_fused_outlined
+
+void fn(int);
+
+// CHECK-LABEL: define {{.*}}void @{{.+}}adjacent
+void adjacent(double *a, double *b, int n) {
+  // The first two regions share a fork, the third one follows serial code.
+  // CHECK: call void {{.*}}@__kmpc_fork_call({{.+}}[[FUSED:@.omp_fused_outlined.]] to
+  // CHECK-NOT: __kmpc_fork_call
+  // CHECK: call void @{{.+}}fn
+  // CHECK: call void {{.*}}@__kmpc_fork_call({{.+}}@.omp_outlined..2 to
+  // CHECK: ret void
+#pragma omp parallel for
+  for (int i = 0; i < n; ++i)
+    a[i] = i;
+#pragma omp parallel for
+  for (int i = 0; i < n; ++i)
+    b[i] = a[i] * 2;
+  fn(n);
+#pragma omp parallel for
+  for (int i = 0; i < n; ++i)
+    a[i] += b[i];
+}
+
+// CHECK: define internal void [[FUSED]](
+// CHECK: call void @.omp_outlined.(i32* [[GTID:%.+]], i32* [[BTID:%.+]],
+// CHECK: [[TID:%.+]] = load i32, i32* [[GTID]],
+// CHECK-NEXT: call void @__kmpc_barrier(%{{.+}}* @{{.+}}, i32 [[TID]])
+// CHECK: call void @.omp_outlined..1(i32* [[GTID]], i32* [[BTID]],
+// CHECK-NOT: __kmpc_barrier
+// CHECK: ret void
+
+// CHECK-LABEL: define {{.*}}void @{{.+}}not_fused
+void not_fused(int n) {
+  // A region with its own team size forks separately.
+  // CHECK-NOT: omp_fused_outlined
+  // CHECK: call void @__kmpc_push_num_threads(
+  // CHECK: ret void
+#pragma omp parallel
+  fn(n);
+#pragma omp parallel num_threads(4)
+  fn(n);
+}
+
+#endif
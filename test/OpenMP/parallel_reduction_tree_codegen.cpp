@@ -0,0 +1,76 @@
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple x86_64-unknown-unknown -fopenmp-tree-reduction -emit-llvm %s -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple x86_64-unknown-unknown -emit-llvm %s -o - | FileCheck %s --check-prefix NOTREE
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// NOTREE-NOT: .omp.reduction.tree
+// NOTREE: call i32 @__kmpc_reduce_nowait(
+
+struct Acc {
+  double v[4];
+};
+#pragma omp declare reduction(acc : Acc : omp_out.v[0] += omp_in.v[0], omp_out.v[1] += omp_in.v[1]) initializer(omp_priv = Acc())
+
+// CHECK-LABEL: define {{.*}}void @{{.+}}sum
+void sum(const double *a, int n, _Complex double &z, Acc &acc) {
+#pragma omp parallel for reduction(+ : z) reduction(acc : acc)
+  for (int i = 0; i < n; ++i) {
+    z += a[i];
+    acc.v[i % 2] += a[i];
+  }
+}
+
+// CHECK: define internal void @.omp_outlined.(
+// CHECK: [[SLOTS_ADDR:%.omp.reduction.tree.slots]] = alloca i8*,
+// CHECK: [[STEP:%.omp.reduction.tree.step]] = alloca i32,
+// CHECK: [[TID:%.+]] = call i32 @__kmpc_bound_thread_num(
+// CHECK: [[NTH:%.+]] = call i32 @__kmpc_bound_num_threads(
+// CHECK-NOT: call i32 @__kmpc_reduce
+// The slots are on the stack of the master, which broadcasts their address.
+// CHECK: [[SP:%.+]] = call i8* @llvm.stacksave()
+// CHECK: [[NUM:%.+]] = mul i32 [[NTH]], 8
+// CHECK: [[BUF:%.omp.reduction.tree.buf]] = alloca i8*, i32 [[NUM]], align 64
+// CHECK: [[BUF_CAST:%.+]] = bitcast i8** [[BUF]] to i8*
+// CHECK: store i8* [[BUF_CAST]], i8** [[SLOTS_ADDR]],
+// CHECK: [[IS_MASTER:%.+]] = icmp eq i32 [[TID]], 0
+// CHECK: [[DIDIT:%.+]] = zext i1 [[IS_MASTER]] to i32
+// CHECK: call void @__kmpc_copyprivate(%{{.+}}, i32 %{{.+}}, i64 8, i8* %{{.+}}, void (i8*, i8*)* @.omp.reduction.tree.copy_func, i32 [[DIDIT]])
+// CHECK: [[BUF:%.+]] = load i8*, i8** [[SLOTS_ADDR]],
+// CHECK: [[SLOTS:%.+]] = bitcast i8* [[BUF]] to i8**
+// CHECK: [[OWN:%.+]] = mul i32 [[TID]], 8
+// CHECK: [[OWN_SLOT:%.+]] = getelementptr inbounds i8*, i8** [[SLOTS]], i32 [[OWN]]
+// CHECK: store i8* [[RL:%.+]], i8** [[OWN_SLOT]],
+// CHECK: call void @__kmpc_barrier(
+// CHECK: store i32 1, i32* [[STEP]],
+// CHECK: .omp.reduction.tree.cond:
+// CHECK: [[S:%.+]] = load i32, i32* [[STEP]],
+// CHECK: icmp ult i32 [[S]], [[NTH]]
+// CHECK: .omp.reduction.tree.body:
+// CHECK: [[PARTNER:%.+]] = add i32 [[TID]], [[S]]
+// CHECK: icmp ult i32 [[PARTNER]], [[NTH]]
+// CHECK: .omp.reduction.tree.combine:
+// CHECK: [[IDX:%.+]] = mul i32 [[PARTNER]], 8
+// CHECK: [[PARTNER_SLOT:%.+]] = getelementptr inbounds i8*, i8** [[SLOTS]], i32 [[IDX]]
+// CHECK: [[PARTNER_RL:%.+]] = load i8*, i8** [[PARTNER_SLOT]],
+// CHECK: call void @.omp.reduction.reduction_func(i8* [[RL]], i8* [[PARTNER_RL]])
+// CHECK: .omp.reduction.tree.next:
+// CHECK: call void @__kmpc_barrier(
+// CHECK: shl i32 [[S]], 1
+// CHECK: .omp.reduction.tree.exit:
+// CHECK: icmp eq i32 [[TID]], 0
+// CHECK: .omp.reduction.tree.master:
+// CHECK-NOT: __kmpc_critical
+// CHECK: call void @.omp_combiner.(
+// CHECK: .omp.reduction.tree.done:
+// CHECK-NOT: __kmpc_end_reduce
+// CHECK: call void @llvm.stackrestore(i8* [[SP]])
+// CHECK: ret void
+
+// CHECK: define internal void @.omp.reduction.tree.copy_func(i8*, i8*)
+// CHECK: [[DST:%.+]] = bitcast i8* %{{.+}} to i8**
+// CHECK: [[SRC:%.+]] = bitcast i8* %{{.+}} to i8**
+// CHECK: [[VAL:%.+]] = load i8*, i8** [[SRC]],
+// CHECK: store i8* [[VAL]], i8** [[DST]],
+
+#endif
@@ -0,0 +1,74 @@
+// RUN: %clang_cc1 -verify -fopenmp -fopenmp-targets=powerpc64le-ibm-linux-gnu -x c++ -triple powerpc64le-unknown-unknown -fopenmp-hoist-target-data -Rpass-analysis -emit-llvm %s -o - | FileCheck %s
+// RUN: %clang_cc1 -fopenmp -fopenmp-targets=powerpc64le-ibm-linux-gnu -x c++ -triple powerpc64le-unknown-unknown -emit-llvm %s -o - | FileCheck %s --check-prefix NOHOIST
+
+// Without a target device, there is nothing to hoist.
+// RUN: %clang_cc1 -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-hoist-target-data -emit-llvm %s -o - | FileCheck %s --check-prefix NOHOIST
+
+// NOHOIST-NOT: __tgt_target_data_begin
+
+// The arrays of the target regions of the time step loop are mapped once
+// around it.
+// CHECK-LABEL: define {{.*}}void @{{.*}}time_steps
+// CHECK:       call void @__tgt_target_data_begin(i64 -1, i32 2,
+// CHECK:       for.cond:
+// CHECK:       call i32 @__tgt_target(
+// CHECK:       call i32 @__tgt_target(
+// CHECK:       for.end:
+// CHECK:       call void @__tgt_target_data_end(i64 -1, i32 2,
+// CHECK:       ret void
+void time_steps(int steps) {
+  double a[100], b[100];
+  for (int t = 0; t < steps; ++t) {
+#pragma omp target map(tofrom: a) // expected-remark {{map of 'a' hoisted into a target data region around the loop}}
+    for (int i = 0; i < 100; ++i)
+      a[i] += 1;
+#pragma omp target map(a) map(from: b) // expected-remark {{map of 'b' hoisted into a target data region around the loop}}
+    for (int i = 0; i < 100; ++i)
+      b[i] = a[i];
+  }
+}
+
+// The host reads the array between the target regions.
+// CHECK-LABEL: define {{.*}}void @{{.*}}host_access
+// CHECK-NOT:   __tgt_target_data_begin
+// CHECK:       ret void
+double host_access(int steps) {
+  double a[100], sum = 0;
+  for (int t = 0; t < steps; ++t) {
+#pragma omp target map(a)
+    for (int i = 0; i < 100; ++i)
+      a[i] += 1;
+    sum += a[0];
+  }
+  return sum;
+}
+
+// Consecutive target regions share the map of 'a'. The writes to 'c' must be
+// discarded at the end of each region, so it isn't hoisted.
+// CHECK-LABEL: define {{.*}}void @{{.*}}consecutive
+// CHECK:       call void @__tgt_target_data_begin(i64 -1, i32 1,
+// CHECK:       call i32 @__tgt_target(
+// CHECK:       call i32 @__tgt_target(
+// CHECK:       call void @__tgt_target_data_end(i64 -1, i32 1,
+// CHECK:       ret void
+void consecutive() {
+  double a[100], c[100];
+#pragma omp target map(a) map(to: c) // expected-remark {{map of 'a' hoisted into a target data region around the 2 consecutive target regions}}
+  for (int i = 0; i < 100; ++i)
+    a[i] = c[i]++;
+#pragma omp target map(a) map(to: c)
+  for (int i = 0; i < 100; ++i)
+    a[i] += c[i];
+}
+
+// The section bound changes in the loop.
+// CHECK-LABEL: define {{.*}}void @{{.*}}changing_bound
+// CHECK-NOT:   __tgt_target_data_begin
+// CHECK:       ret void
+void changing_bound(double *p, int n) {
+  for (int t = 0; t < n; ++t) {
+#pragma omp target map(p[0:t])
+    for (int i = 0; i < t; ++i)
+      p[i] += 1;
+  }
+}
@@ -0,0 +1,41 @@
+// Test host codegen of hashed offload entry tables.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -fopenmp-hashed-offload-entries -emit-llvm %s -o - | FileCheck %s --check-prefix CHECK --check-prefix NOUSED
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -fopenmp-hashed-offload-entries -fopenmp-offload-wrapper-objects -emit-llvm %s -o - | FileCheck %s --check-prefix CHECK --check-prefix USED
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -emit-llvm %s -o - | FileCheck %s --check-prefix NOHASH
+
+// Test target codegen - host bc file has to be created first.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -fopenmp-hashed-offload-entries -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -fopenmp-hashed-offload-entries -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -o - | FileCheck %s --check-prefix CHECK --check-prefix NOUSED
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+#pragma omp declare target
+int zz;
+int b;
+int a;
+#pragma omp end declare target
+
+// The entries are sorted by the hash of their names ('a' is 97, 'b' is 98 and
+// 'zz' is 4148) and carry version 1 in the top byte of their flags.
+// CHECK: @.omp_offloading.entry.a = weak constant %struct.__tgt_offload_entry { i8* bitcast (i32* @a to i8*), {{.+}}, i64 4, i32 16777216, i32 97 }, section ".omp_offloading.entries", align 1
+// CHECK: @.omp_offloading.entry.b = weak constant %struct.__tgt_offload_entry { i8* bitcast (i32* @b to i8*), {{.+}}, i64 4, i32 16777216, i32 98 }, section ".omp_offloading.entries", align 1
+// CHECK: @.omp_offloading.entry.zz = weak constant %struct.__tgt_offload_entry { i8* bitcast (i32* @zz to i8*), {{.+}}, i64 4, i32 16777216, i32 4148 }, section ".omp_offloading.entries", align 1
+
+// The entries are not referenced, so they are marked as used when there is no
+// linker script to keep their section.
+// NOUSED-NOT: @llvm.used
+// USED: @llvm.used = appending global {{.+}}@.omp_offloading.entry.a{{.+}}@.omp_offloading.entry.b{{.+}}@.omp_offloading.entry.zz{{.+}}, section "llvm.metadata"
+
+// NOHASH-DAG: @.omp_offloading.entry.zz = weak constant %struct.__tgt_offload_entry { {{.+}}, i64 4, i32 0, i32 0 }
+// NOHASH-DAG: @.omp_offloading.entry.b = weak constant %struct.__tgt_offload_entry { {{.+}}, i64 4, i32 0, i32 0 }
+// NOHASH-DAG: @.omp_offloading.entry.a = weak constant %struct.__tgt_offload_entry { {{.+}}, i64 4, i32 0, i32 0 }
+
+int foo() {
+  int r;
+#pragma omp target map(from:r)
+  r = a + b + zz;
+  return r;
+}
+
+#endif
@@ -0,0 +1,40 @@
+// RUN: %clang_cc1 -verify -Ropenmp-implicit-maps -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -fopenmp-narrow-implicit-maps -emit-llvm %s -o - | FileCheck %s
+// RUN: %clang_cc1 -DNONARROW -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -emit-llvm %s -o - | FileCheck %s --check-prefix NONARROW
+#ifdef NONARROW
+// expected-no-diagnostics
+#endif
+#ifndef HEADER
+#define HEADER
+
+struct Pair {
+  double x, y;
+};
+
+// 'q' is mapped 'from' (0x222), 'p' and 'in' 'to' (0x221), the other arrays
+// 'tofrom' (0x223), together with the target parameter and implicit flags.
+// CHECK: @.offload_maptypes{{.*}} = private unnamed_addr constant [5 x i64] [i64 546, i64 545, i64 547, i64 545, i64 547]
+// NONARROW: @.offload_maptypes{{.*}} = private unnamed_addr constant [5 x i64] [i64 547, i64 547, i64 547, i64 547, i64 547]
+
+void narrow(Pair p) {
+  double in[64], out[64], acc[64];
+  Pair q;
+  for (int i = 0; i < 64; ++i)
+    in[i] = acc[i] = i;
+#pragma omp target
+  {
+#ifndef NONARROW
+    // expected-remark@+3 {{implicit map of 'q' narrowed to 'from' since the target region overwrites it before reading it}}
+    // expected-remark@+2 {{implicit map of 'p' narrowed to 'to' since the target region only reads it}}
+#endif
+    q = p;
+    for (int i = 0; i < 64; ++i) {
+#ifndef NONARROW
+      // expected-remark@+2 {{implicit map of 'in' narrowed to 'to' since the target region only reads it}}
+#endif
+      out[i] = in[i] * q.x;
+      acc[i] += in[i];
+    }
+  }
+}
+
+#endif
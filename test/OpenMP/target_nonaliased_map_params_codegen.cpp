@@ -0,0 +1,62 @@
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -emit-llvm %s -o - | FileCheck %s
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+double fn(double);
+
+// Distinct local arrays are only reachable through their own parameter.
+// CHECK: define {{.*}}void {{@__omp_offloading_.+distinct.+}}([8 x double]* {{[^,%]*}}noalias{{[^,%]*}}readonly{{[^,%]*}} %in, [8 x double]* {{[^,%]*}}noalias{{[^,%]*}} %out)
+void distinct() {
+  double in[8], out[8];
+  for (int i = 0; i < 8; ++i)
+    in[i] = i;
+#pragma omp target map(to: in) map(from: out)
+  for (int i = 0; i < 8; ++i) {
+    double v = in[i];
+    out[i] = fn(v);
+  }
+}
+
+// Disjoint sections of a variable are still only reachable through it, but
+// it is written.
+// CHECK-NOT: readonly
+// CHECK: define {{.*}}void {{@__omp_offloading_.+sections.+}}([16 x double]* {{[^,%]*}}noalias{{[^,%]*}} %x)
+void sections() {
+  double x[16] = {0};
+#pragma omp target map(to: x[0:8]) map(from: x[8:8])
+  for (int i = 0; i < 8; ++i)
+    x[i + 8] = x[i];
+}
+
+// A captured pointer may point to any list item.
+// CHECK-NOT: noalias
+// CHECK: define {{.*}}void {{@__omp_offloading_.+pointer.+}}(double* %p, [8 x double]* {{[^,%]*}} %in)
+void pointer(double *p) {
+  double in[8] = {0};
+#pragma omp target map(to: in) map(tofrom: p[:8])
+  for (int i = 0; i < 8; ++i)
+    p[i] += in[i];
+}
+
+// The bounds of the sections are not known, or the list item may hold
+// addresses.
+// CHECK-NOT: noalias
+// CHECK: define {{.*}}void {{@__omp_offloading_.+unknown.+}}([16 x double]* {{[^,%]*}} %x
+// CHECK-NOT: noalias
+// CHECK: define {{.*}}void {{@__omp_offloading_.+addresses.+}}([8 x double*]* {{[^,%]*}} %ps)
+void unknown(int n) {
+  double x[16] = {0};
+#pragma omp target map(to: x[0:n]) map(from: x[8:8])
+  for (int i = 0; i < 8; ++i)
+    x[i + 8] = x[i];
+}
+
+void addresses() {
+  double *ps[8] = {0};
+#pragma omp target map(tofrom: ps)
+  for (int i = 0; i < 8; ++i)
+    ps[i] = 0;
+}
+
+#endif
@@ -0,0 +1,57 @@
+// Test host codegen of 'target nowait depend' regions whose dependences are
+// resolved by the offloading runtime.
+// RUN: %clang_cc1 -verify -fopenmp -fopenmp-target-nowait-depend -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -emit-llvm %s -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -emit-llvm %s -o - | FileCheck %s --check-prefix TASK
+// RUN: %clang_cc1 -verify -fopenmp -fopenmp-target-nowait-depend -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -emit-llvm %s -o - | FileCheck %s --check-prefix NOPROFILE
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// The profiling hooks are only emitted with -fopenmp-offload-profile.
+// NOPROFILE-NOT: __tgt_profile
+
+// CHECK-LABEL: define {{.*}}void @{{.*}}pipeline{{.*}}(
+void pipeline(int *a, int *b, int n) {
+  for (int i = 0; i < n; ++i) {
+    // The data is mapped after the dependences, then the kernel is launched
+    // and the data released without a host task.
+    // CHECK-NOT: call i8* @__kmpc_omp_task_alloc(
+    // CHECK: call void @__tgt_target_data_begin_nowait_depend(i64 -1, i32 [[NUM:[0-9]+]], i8** [[BP:%[^,]+]], i8** [[P:%[^,]+]], i64* [[S:[^,]+]], i64* [[T:[^,]+]], i32 1, i8* [[DEPS:%[^,]+]], i32 0, i8* null)
+    // CHECK: [[RET:%.+]] = call i32 @__tgt_target_nowait(i64 -1, i8* @{{[^,]+}}, i32 [[NUM]], i8** [[BP]], i8** [[P]], i64* [[S]], i64* [[T]])
+    // CHECK: [[FAILED:%.+]] = icmp ne i32 [[RET]], 0
+    // CHECK: br i1 [[FAILED]], label %[[FAIL:[^,]+]], label %[[DONE:[^,]+]]
+    // CHECK: [[DONE]]:
+    // CHECK: call void @__tgt_target_data_end_nowait(i64 -1, i32 [[NUM]], i8** [[BP]], i8** [[P]], i64* [[S]], i64* [[T]])
+    // CHECK: br label %[[CONT:[^,]+]]
+    // CHECK: [[FAIL]]:
+    // CHECK: call void @__kmpc_omp_wait_deps(%{{.+}}* @{{.+}}, i32 {{%.+}}, i32 1, i8* [[DEPS]], i32 0, i8* null)
+    // CHECK: call void @__tgt_target_data_end(i64 -1, i32 [[NUM]], i8** [[BP]], i8** [[P]], i64* [[S]], i64* [[T]])
+    // CHECK: call void @{{.+}}pipeline{{.+}}(
+    // CHECK: br label %[[CONT]]
+    // TASK: call i8* @__kmpc_omp_task_alloc(
+    // TASK: call i32 @__kmpc_omp_task_with_deps(
+#pragma omp target nowait depend(inout: a[0]) map(tofrom: a[0:1])
+    a[0] += i;
+
+    // CHECK-NOT: call i8* @__kmpc_omp_task_alloc(
+    // CHECK: call void @__tgt_target_data_begin_nowait_depend(i64 -1, i32 {{[0-9]+}}, i8** {{%[^,]+}}, i8** {{%[^,]+}}, i64* {{[^,]+}}, i64* {{[^,]+}}, i32 2, i8* {{%[^,]+}}, i32 0, i8* null)
+    // CHECK: call i32 @__tgt_target_teams_nowait(i64 -1, i8* @{{[^,]+}}, i32 {{[0-9]+}}, i8** {{%[^,]+}}, i8** {{%[^,]+}}, i64* {{[^,]+}}, i64* {{[^,]+}}, i32 0, i32 0)
+    // CHECK: call void @__tgt_target_data_end_nowait(
+    // CHECK: call void @__kmpc_omp_wait_deps(%{{.+}}* @{{.+}}, i32 {{%.+}}, i32 2, i8* {{%[^,]+}}, i32 0, i8* null)
+    // CHECK: call void @__tgt_target_data_end(
+#pragma omp target teams nowait depend(in: a[0]) depend(out: b[0]) map(to: a[0:1]) map(from: b[0:1])
+    b[0] = a[0];
+  }
+}
+
+// Without 'nowait' the region still goes through a target task.
+// CHECK-LABEL: define {{.*}}void @{{.*}}blocking{{.*}}(
+void blocking(int *a) {
+  // CHECK: call i8* @__kmpc_omp_task_alloc(
+  // CHECK-NOT: @__tgt_target_data_begin_nowait_depend(
+  // CHECK: call i32 @__kmpc_omp_taskwait(
+#pragma omp target depend(inout: a[0]) map(tofrom: a[0:1])
+  a[0]++;
+}
+
+#endif
@@ -0,0 +1,31 @@
+// Test that the device compilation reads the offload entries info written by
+// the host compilation instead of the host IR.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -emit-llvm-bc %s -o %t-ppc-host.bc -fopenmp-offload-info-output %t-ppc-host.bc.ompinfo
+// RUN: llvm-dis %t-ppc-host.bc.ompinfo -o - | FileCheck %s --check-prefix INFO
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -emit-llvm-bc %s -DNO_TARGET -o %t-ppc-host-empty.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host-empty.bc -fopenmp-host-offload-info-file-path %t-ppc-host.bc.ompinfo -o - | FileCheck %s --check-prefix DEVICE
+
+// Without the info file the device compilation falls back to the host IR.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -fopenmp-host-offload-info-file-path %t-ppc-host.bc.notexist -o - | FileCheck %s --check-prefix DEVICE
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host-empty.bc -o - | FileCheck %s --check-prefix NODEVICE
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// INFO-NOT: define
+// INFO: !omp_offload.info = !{![[ENTRY:[0-9]+]]}
+// INFO: ![[ENTRY]] = !{i32 0, i32 {{-?[0-9]+}}, i32 {{-?[0-9]+}}, !"_Z3fooi", i32 {{[0-9]+}}, i32 0}
+
+// DEVICE: define weak void @__omp_offloading_{{.+}}_Z3fooi_l{{[0-9]+}}(
+// NODEVICE-NOT: define weak void @__omp_offloading_
+
+int foo(int n) {
+  int a = 0;
+#ifndef NO_TARGET
+#pragma omp target map(tofrom:a)
+#endif
+  a += n;
+  return a;
+}
+
+#endif
@@ -0,0 +1,64 @@
+// Test host codegen of the offloading profiling hooks.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -fopenmp-offload-profile -emit-llvm %s -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -emit-llvm %s -o - | FileCheck %s --check-prefix NOPROFILE
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// NOPROFILE-NOT: __tgt_profile
+// NOPROFILE-NOT: offload_profile_site
+
+// The sites are described by their offload entry or directive name and their
+// location, whether or not debug info is emitted.
+// CHECK-DAG: c"__omp_offloading_{{.+}}_Z7computePdi_l{{[0-9]+}}\00"
+// CHECK-DAG: c";{{.*}}target_offload_profile_codegen.cpp;compute;{{[0-9]+}};{{[0-9]+}};;\00"
+// CHECK-DAG: c"target enter data\00"
+// CHECK-DAG: c"target exit data\00"
+// CHECK-DAG: c"target update\00"
+// CHECK-DAG: c"target data\00"
+// CHECK-DAG: = private unnamed_addr constant { i8*, i8*, i32 } { i8* {{.+}}, i8* {{.+}}, i32 0 }
+// CHECK-DAG: = private unnamed_addr constant { i8*, i8*, i32 } { i8* {{.+}}, i8* {{.+}}, i32 1 }
+// CHECK-DAG: = private unnamed_addr constant { i8*, i8*, i32 } { i8* {{.+}}, i8* {{.+}}, i32 2 }
+// CHECK-DAG: = private unnamed_addr constant { i8*, i8*, i32 } { i8* {{.+}}, i8* {{.+}}, i32 3 }
+
+void fn();
+
+// CHECK-LABEL: define {{.*}}void @{{.+}}compute
+void compute(double *a, int n) {
+  // CHECK: call void @__tgt_profile_begin(i8* bitcast ({{.+}}* [[ENTER:@.offload_profile_site[.0-9]*]] to i8*), i64 -1)
+  // CHECK-NEXT: call void @__tgt_target_data_begin(i64 -1,
+  // CHECK-NEXT: call void @__tgt_profile_end(i8* bitcast ({{.+}}* [[ENTER]] to i8*), i64 -1, i32 0)
+#pragma omp target enter data map(to: a[0:n])
+
+  // The hooks bracket the launch and receive its return code.
+  // CHECK: call void @__tgt_profile_begin(i8* bitcast ({{.+}}* [[TGT:@.offload_profile_site[.0-9]*]] to i8*), i64 -1)
+  // CHECK-NEXT: [[RET:%.+]] = call i32 @__tgt_target(i64 -1,
+  // CHECK-NEXT: call void @__tgt_profile_end(i8* bitcast ({{.+}}* [[TGT]] to i8*), i64 -1, i32 [[RET]])
+#pragma omp target map(tofrom: a[0:n])
+  for (int i = 0; i < n; ++i)
+    a[i] *= 2;
+
+  // CHECK: call void @__tgt_profile_begin(i8* bitcast ({{.+}}* [[UPDATE:@.offload_profile_site[.0-9]*]] to i8*), i64 -1)
+  // CHECK-NEXT: call void @__tgt_target_data_update(i64 -1,
+  // CHECK-NEXT: call void @__tgt_profile_end(i8* bitcast ({{.+}}* [[UPDATE]] to i8*), i64 -1, i32 0)
+#pragma omp target update from(a[0:n])
+
+  // The opening and the closing of a data region are reported separately.
+  // CHECK: call void @__tgt_profile_begin(i8* bitcast ({{.+}}* [[BEGIN:@.offload_profile_site[.0-9]*]] to i8*), i64 4)
+  // CHECK-NEXT: call void @__tgt_target_data_begin(i64 4,
+  // CHECK-NEXT: call void @__tgt_profile_end(i8* bitcast ({{.+}}* [[BEGIN]] to i8*), i64 4, i32 0)
+  // CHECK: call void @{{.+}}fn
+  // CHECK: call void @__tgt_profile_begin(i8* bitcast ({{.+}}* [[END:@.offload_profile_site[.0-9]*]] to i8*), i64 4)
+  // CHECK-NEXT: call void @__tgt_target_data_end(i64 4,
+  // CHECK-NEXT: call void @__tgt_profile_end(i8* bitcast ({{.+}}* [[END]] to i8*), i64 4, i32 0)
+#pragma omp target data map(to: n) device(4)
+  { fn(); }
+
+  // CHECK: call void @__tgt_profile_begin(i8* bitcast ({{.+}}* [[EXIT:@.offload_profile_site[.0-9]*]] to i8*), i64 -1)
+  // CHECK-NEXT: call void @__tgt_target_data_end(i64 -1,
+  // CHECK-NEXT: call void @__tgt_profile_end(i8* bitcast ({{.+}}* [[EXIT]] to i8*), i64 -1, i32 0)
+#pragma omp target exit data map(release: a[0:n])
+  // CHECK: ret void
+}
+
+#endif
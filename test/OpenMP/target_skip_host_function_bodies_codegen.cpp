@@ -0,0 +1,58 @@
+// Test that the device compilation skips the bodies of the functions that
+// neither contain target regions nor are declare target.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -emit-llvm-bc %s -o %t-ppc-host.bc
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -fopenmp-skip-host-function-bodies -DHOST_ONLY_ERRORS -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -o - | FileCheck %s
+
+// A function that is only declared target after its definition was skipped.
+// RUN: not %clang_cc1 -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -fopenmp-skip-host-function-bodies -DLATE_DECLARE_TARGET -o - 2>&1 | FileCheck %s --check-prefix LATE
+// A skipped function used in a declare target function.
+// RUN: not %clang_cc1 -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -emit-llvm %s -fopenmp-is-device -fopenmp-host-ir-file-path %t-ppc-host.bc -fopenmp-skip-host-function-bodies -DUSED_IN_DECLARE_TARGET -o - 2>&1 | FileCheck %s --check-prefix USED
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// CHECK-DAG: define {{.*}}i32 @_Z3devi(
+// CHECK-DAG: define {{.*}}i32 @_Z11predeclaredi(
+// CHECK-DAG: define weak void @__omp_offloading_{{.+}}_Z3fooi_l{{[0-9]+}}(
+// CHECK-NOT: @_Z9host_onlyi
+
+#pragma omp declare target
+int dev(int n) { return n + 1; }
+#pragma omp end declare target
+
+// Declared target before its definition.
+#pragma omp declare target
+int predeclared(int n);
+#pragma omp end declare target
+int predeclared(int n) { return n * 2; }
+
+int host_only(int n) {
+#ifdef HOST_ONLY_ERRORS
+  // Only diagnosed if the body is parsed.
+  return undeclared_in_host_only_code(n);
+#else
+  return n - 1;
+#endif
+}
+
+int foo(int n) {
+  int a = 0;
+#pragma omp target map(tofrom:a)
+  a += dev(n) + predeclared(n);
+  return a + host_only(n);
+}
+
+#ifdef USED_IN_DECLARE_TARGET
+#pragma omp declare target
+// USED: error: the body of 'host_only' was skipped in this device compilation
+int uses_host_only(int n) { return host_only(n); }
+#pragma omp end declare target
+#endif
+
+#ifdef LATE_DECLARE_TARGET
+// LATE: error: the body of 'host_only' was skipped in this device compilation
+#pragma omp declare target(host_only)
+#endif
+
+#endif
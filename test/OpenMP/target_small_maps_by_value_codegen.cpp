@@ -0,0 +1,90 @@
+// Test host codegen of scalars that are only mapped 'to' a target region.
+// RUN: %clang_cc1 -verify -fopenmp -fopenmp-small-maps-by-value -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -emit-llvm %s -o - | FileCheck %s --check-prefix CHECK --check-prefix BYVAL
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -emit-llvm %s -o - | FileCheck %s --check-prefix CHECK --check-prefix BYREF
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// CHECK-DAG: [[SIZES:@.+]] = {{.+}}constant [3 x i64] [i64 4, i64 4, i64 4]
+// Map types: OMP_MAP_LITERAL | OMP_MAP_TARGET_PARAM = 288
+//            OMP_MAP_TO | OMP_MAP_TARGET_PARAM = 33
+//            OMP_MAP_TO | OMP_MAP_FROM | OMP_MAP_TARGET_PARAM = 35
+// BYVAL-DAG: [[TYPES:@.+]] = {{.+}}constant [3 x i64] [i64 288, i64 288, i64 35]
+// BYREF-DAG: [[TYPES:@.+]] = {{.+}}constant [3 x i64] [i64 33, i64 33, i64 35]
+
+// CHECK-LABEL: define {{.*}}void @{{.*}}scalars{{.*}}(
+void scalars(int a, float b) {
+  int c = 0;
+
+  // CHECK: call i32 @__tgt_target(i64 {{.+}}, i8* {{.+}}, i32 3, i8** {{.+}}, i8** {{.+}}, {{.+}}[[SIZES]]{{.+}}, {{.+}}[[TYPES]]{{.+}})
+  // BYVAL: call void [[KERNEL:@.+]](i64 {{%.+}}, i64 {{%.+}}, i32* {{%.+}})
+  // BYREF: call void [[KERNEL:@.+]](i32* {{%.+}}, float* {{%.+}}, i32* {{%.+}})
+#pragma omp target map(to: a, b) map(tofrom: c)
+  {
+    c = a + b;
+  }
+}
+
+// Aggregates stay mapped by reference.
+// CHECK-DAG: [[SIZES2:@.+]] = {{.+}}constant [1 x i64] [i64 8]
+// CHECK-DAG: [[TYPES2:@.+]] = {{.+}}constant [1 x i64] [i64 33]
+struct S {
+  int x, y;
+};
+
+// CHECK-LABEL: define {{.*}}void @{{.*}}aggregate{{.*}}(
+void aggregate(S s) {
+  // CHECK: call i32 @__tgt_target(i64 {{.+}}, i8* {{.+}}, i32 1, i8** {{.+}}, i8** {{.+}}, {{.+}}[[SIZES2]]{{.+}}, {{.+}}[[TYPES2]]{{.+}})
+  // CHECK: call void {{@.+}}(%struct.S* {{%.+}})
+#pragma omp target map(to: s)
+  {
+    S t = s;
+    t.x += t.y;
+  }
+}
+
+// Scalars that may already have a device copy keep the reference, so that
+// the region reads that copy instead of the host value.
+int g;
+
+// CHECK-LABEL: define {{.*}}void @{{.*}}present{{.*}}(
+void present(int a, int b) {
+  // CHECK: call void @__tgt_target_data_begin(
+  // CHECK: call i32 @__tgt_target(i64 {{.+}}, i8* {{.+}}, i32 1, i8** {{.+}}, i8** {{.+}}, {{.+}})
+  // CHECK: call void {{@.+}}(i32* {{%.+}})
+#pragma omp target data map(tofrom: a)
+  {
+#pragma omp target map(to: a)
+    {
+      int t = a;
+      t++;
+    }
+  }
+
+  // CHECK: call void @__tgt_target_data_begin(
+  // CHECK: call i32 @__tgt_target(i64 {{.+}}, i8* {{.+}}, i32 1, i8** {{.+}}, i8** {{.+}}, {{.+}})
+  // CHECK: call void {{@.+}}(i32* {{%.+}})
+#pragma omp target enter data map(to: b)
+#pragma omp target map(to: b)
+  {
+    int t = b;
+    t++;
+  }
+
+  // Globals may have been mapped by a caller.
+  // CHECK: call i32 @__tgt_target(i64 {{.+}}, i8* {{.+}}, i32 1, i8** {{.+}}, i8** {{.+}}, {{.+}})
+  // CHECK: call void {{@.+}}(i32* {{%.+}})
+#pragma omp target map(to: g)
+  {
+    int t = g;
+    t++;
+  }
+}
+
+// BYVAL: define internal void [[KERNEL]](i64 [[A:%.+]], i64 [[B:%.+]], i32* {{.+}})
+// BYVAL: store i64 [[A]], i64* [[AADDR:%.+]],
+// BYVAL: store i64 [[B]], i64* [[BADDR:%.+]],
+// BYVAL-DAG: bitcast i64* [[AADDR]] to i32*
+// BYVAL-DAG: bitcast i64* [[BADDR]] to float*
+
+#endif
@@ -0,0 +1,94 @@
+// RUN: %clang_cc1 -verify -fopenmp -fopenmp-targets=powerpc64le-ibm-linux-gnu -x c++ -triple powerpc64le-unknown-unknown -fopenmp-split-target-devices -Rpass-analysis -emit-llvm %s -o - | FileCheck %s
+// RUN: %clang_cc1 -fopenmp -fopenmp-targets=powerpc64le-ibm-linux-gnu -x c++ -triple powerpc64le-unknown-unknown -emit-llvm %s -o - | FileCheck %s --check-prefix NOSPLIT
+
+// Without a target device, there is nothing to split.
+// RUN: %clang_cc1 -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-split-target-devices -emit-llvm %s -o - | FileCheck %s --check-prefix NOSPLIT
+
+// NOSPLIT-NOT: omp_get_num_devices
+
+// With a single device the region is launched as usual. Otherwise, each
+// device is launched on a slice of the iterations from its own target task.
+// CHECK-LABEL: define {{.*}}void @{{.*}}saxpy
+// CHECK:       [[NUM:%.+]] = call i32 @omp_get_num_devices()
+// CHECK:       icmp sgt i32 [[NUM]], 1
+// CHECK:       omp_split.else:
+// CHECK:       call i32 @__tgt_target_teams(i64 -1,
+// CHECK:       omp_split.then:
+// CHECK:       omp_split.cond:
+// CHECK-NEXT:  [[DEV:%.+]] = load i64, i64* %omp_split.device
+// CHECK:       omp_split.body:
+// CHECK:       [[TASK:%.+]] = call i8* @__kmpc_omp_target_task_alloc({{.+}}, i32 1, {{.+}} [[ENTRY:@[^ ]+]] to {{.+}}, i64 [[DEV]])
+// CHECK:       call i32 @__kmpc_omp_task({{.+}}, i8* [[TASK]])
+// CHECK:       omp_split.wait:
+// CHECK:       call i32 @__kmpc_omp_taskwait(
+// CHECK:       omp_split.end:
+// CHECK:       ret void
+
+// The task launches the slice and runs the host version if the launch fails.
+// CHECK:       define internal {{.*}}i32 [[ENTRY]](i32
+// CHECK:       [[TDEV:%.+]] = load i64, i64*
+// CHECK:       call void @__kmpc_push_target_tripcount(i64 [[TDEV]],
+// CHECK:       [[RET:%.+]] = call i32 @__tgt_target_teams_nowait(i64 [[TDEV]],
+// CHECK:       icmp ne i32 [[RET]], 0
+// CHECK:       omp_offload.failed:
+// CHECK:       call void @__omp_offloading_
+void saxpy(int lb, int ub, float a, float *x, float *y) {
+#pragma omp target teams distribute parallel for map(to: x[lb:ub - lb]) map(tofrom: y[lb:ub - lb]) // expected-remark {{loop of the target region split across the available devices}}
+  for (int i = lb; i < ub; ++i)
+    y[i] += a * x[i];
+}
+
+// CHECK-LABEL: define {{.*}}void @{{.*}}zero_lb
+// CHECK-NOT:   omp_get_num_devices
+// CHECK:       ret void
+void zero_lb(int n, float *y) {
+#pragma omp target teams distribute parallel for map(tofrom: y[0:n]) // expected-remark {{loop of the target region not split across devices: it is not of the form 'for (i = lb; i < ub; ++i)' with 'lb' and 'ub' passed by value}}
+  for (int i = 0; i < n; ++i)
+    y[i] *= 2;
+}
+
+// CHECK-LABEL: define {{.*}}void @{{.*}}whole_array
+// CHECK-NOT:   omp_get_num_devices
+// CHECK:       ret void
+void whole_array(int lb, int ub) {
+  float a[100], b[100];
+#pragma omp target teams distribute map(tofrom: a) // expected-remark {{loop of the target region not split across devices: 'a' is copied back but is not mapped as the array section '[lb:ub - lb]'}}
+  for (int i = lb; i < ub; ++i)
+    a[i] = 0;
+#pragma omp target teams distribute parallel for // expected-remark {{loop of the target region not split across devices: 'b' is copied back but is not mapped as the array section '[lb:ub - lb]'}}
+  for (int i = lb; i < ub; ++i)
+    b[i] = 0;
+}
+
+// Halos around the slice may only be mapped 'to'.
+// CHECK-LABEL: define {{.*}}void @{{.*}}stencil
+// CHECK:       call i32 @omp_get_num_devices()
+// CHECK:       ret void
+void stencil(int lb, int ub, float *x, float *y) {
+#pragma omp target teams distribute parallel for map(to: x[lb - 1:ub - lb + 2]) map(from: y[lb:ub - lb]) // expected-remark {{loop of the target region split across the available devices}}
+  for (int i = lb; i < ub; ++i)
+    y[i] = x[i - 1] + x[i] + x[i + 1];
+}
+
+// CHECK-LABEL: define {{.*}}void @{{.*}}overlapping
+// CHECK-NOT:   omp_get_num_devices
+// CHECK:       ret void
+void overlapping(int lb, int ub, float *x) {
+#pragma omp target teams distribute parallel for map(tofrom: x[lb - 1:ub - lb + 2]) // expected-remark {{loop of the target region not split across devices: 'x' is copied back but is not mapped as the array section '[lb:ub - lb]'}}
+  for (int i = lb; i < ub; ++i)
+    x[i] = x[i - 1] + x[i + 1];
+#pragma omp target teams distribute parallel for map(tofrom: x[0:ub]) // expected-remark {{loop of the target region not split across devices: 'x' is copied back but is not mapped as the array section '[lb:ub - lb]'}}
+  for (int i = lb; i < ub; ++i)
+    x[i] = 0;
+}
+
+// CHECK-LABEL: define {{.*}}void @{{.*}}reduction
+// CHECK-NOT:   omp_get_num_devices
+// CHECK:       ret void
+float reduction(int lb, int ub, float *x) {
+  float sum = 0;
+#pragma omp target teams distribute parallel for map(to: x[lb:ub - lb]) reduction(+: sum) // expected-remark {{loop of the target region not split across devices: the 'reduction' clause is not supported}}
+  for (int i = lb; i < ub; ++i)
+    sum += x[i];
+  return sum;
+}
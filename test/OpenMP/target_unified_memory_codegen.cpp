@@ -0,0 +1,51 @@
+// RUN: %clang_cc1 -fopenmp -fopenmp-targets=powerpc64le-ibm-linux-gnu -x c++ -triple powerpc64le-unknown-unknown -fopenmp-unified-memory -emit-llvm %s -o - | FileCheck %s
+// RUN: %clang_cc1 -fopenmp -fopenmp-targets=powerpc64le-ibm-linux-gnu -x c++ -triple powerpc64le-unknown-unknown -emit-llvm %s -o - | FileCheck %s --check-prefix MAP
+
+// Every kernel argument is passed as a literal, with no pointee entries.
+// CHECK-DAG: [[SIZET:@.+]] = private unnamed_addr constant [4 x i64] zeroinitializer
+// CHECK-DAG: [[MAPT:@.+]] = private unnamed_addr constant [4 x i64] [i64 288, i64 288, i64 288, i64 288]
+
+// CHECK-LABEL: define {{.*}}void @{{.*}}saxpy
+// CHECK:       call i32 @__tgt_target(i64 -1, i8* @{{[^,]+}}, i32 4, i8** {{%[^,]+}}, i8** {{%[^,]+}}, i64* getelementptr inbounds ([4 x i64], [4 x i64]* [[SIZET]], i32 0, i32 0), i64* getelementptr inbounds ([4 x i64], [4 x i64]* [[MAPT]], i32 0, i32 0))
+// CHECK:       ret void
+void saxpy(int n, float a, float *x, float *y) {
+#pragma omp target map(to: x[0:n]) map(tofrom: y[0:n])
+  for (int i = 0; i < n; ++i)
+    y[i] += a * x[i];
+}
+
+// The data regions only emit their body, and the standalone data directives
+// emit nothing.
+// CHECK-LABEL: define {{.*}}void @{{.*}}data
+// CHECK-NOT:   __tgt_target_data
+// CHECK:       call i32 @__tgt_target(
+// CHECK-NOT:   __tgt_target_data
+// CHECK:       ret void
+// MAP-LABEL:   define {{.*}}void @{{.*}}data
+// MAP:         call void @__tgt_target_data_begin(
+// MAP:         call void @__tgt_target_data_update(
+// MAP:         call void @__tgt_target_data_end(
+// MAP:         call void @__tgt_target_data_end(
+// MAP:         ret void
+void data(int n, float *x) {
+#pragma omp target data map(tofrom: x[0:n])
+  {
+#pragma omp target enter data map(to: x[0:n])
+#pragma omp target
+    for (int i = 0; i < n; ++i)
+      x[i] *= 2;
+#pragma omp target update from(x[0:n])
+#pragma omp target exit data map(release: x[0:n])
+  }
+}
+
+// The device has its own copy of a global variable, which is still mapped.
+double g[10];
+// CHECK-LABEL: define {{.*}}void @{{.*}}global
+// CHECK:       call void @__tgt_target_data_begin(
+// CHECK:       call void @__tgt_target_data_end(
+// CHECK:       ret void
+void global() {
+#pragma omp target enter data map(to: g)
+#pragma omp target exit data map(from: g)
+}
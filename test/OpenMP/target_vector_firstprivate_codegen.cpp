@@ -0,0 +1,44 @@
+// Test host codegen of vector values captured by a target region.
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple powerpc64le-unknown-unknown -fopenmp-targets=powerpc64le-ibm-linux-gnu -emit-llvm %s -o - | FileCheck %s
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+typedef float float2 __attribute__((ext_vector_type(2)));
+typedef float float4 __attribute__((ext_vector_type(4)));
+
+// A vector that fits a uintptr is passed by value, like a scalar.
+// CHECK-DAG: [[SIZES:@.+]] = {{.+}}constant [2 x i64] [i64 8, i64 4]
+// Map types: OMP_MAP_LITERAL | OMP_MAP_TARGET_PARAM | OMP_MAP_IMPLICIT = 800
+//            OMP_MAP_TO | OMP_MAP_FROM | OMP_MAP_TARGET_PARAM = 35
+// CHECK-DAG: [[TYPES:@.+]] = {{.+}}constant [2 x i64] [i64 800, i64 35]
+
+// CHECK-LABEL: define {{.*}}void @{{.*}}small_vector{{.*}}(
+void small_vector(float2 v) {
+  float r = 0;
+  // CHECK: [[VAL:%.+]] = load <2 x float>, <2 x float>* {{%.+}},
+  // CHECK: [[CADDR:%.+]] = bitcast i64* [[CASTED:%.+]] to <2 x float>*
+  // CHECK: store <2 x float> [[VAL]], <2 x float>* [[CADDR]],
+  // CHECK: load i64, i64* [[CASTED]],
+  // CHECK: call i32 @__tgt_target(i64 {{.+}}, i8* {{.+}}, i32 2, i8** {{.+}}, i8** {{.+}}, {{.+}}[[SIZES]]{{.+}}, {{.+}}[[TYPES]]{{.+}})
+  // CHECK: call void {{@.+}}(i64 {{%.+}}, float* {{%.+}})
+#pragma omp target map(tofrom: r)
+  r = v.x + v.y;
+}
+
+// A vector that does not fit a uintptr keeps the implicit map(tofrom).
+// CHECK-DAG: [[SIZES2:@.+]] = {{.+}}constant [2 x i64] [i64 16, i64 4]
+// Map types: OMP_MAP_TO | OMP_MAP_FROM | OMP_MAP_TARGET_PARAM |
+//            OMP_MAP_IMPLICIT = 547
+// CHECK-DAG: [[TYPES2:@.+]] = {{.+}}constant [2 x i64] [i64 547, i64 35]
+
+// CHECK-LABEL: define {{.*}}void @{{.*}}large_vector{{.*}}(
+void large_vector(float4 v) {
+  float r = 0;
+  // CHECK: call i32 @__tgt_target(i64 {{.+}}, i8* {{.+}}, i32 2, i8** {{.+}}, i8** {{.+}}, {{.+}}[[SIZES2]]{{.+}}, {{.+}}[[TYPES2]]{{.+}})
+  // CHECK: call void {{@.+}}(<4 x float>* {{%.+}}, float* {{%.+}})
+#pragma omp target map(tofrom: r)
+  r = v.x + v.w;
+}
+
+#endif
@@ -0,0 +1,61 @@
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple x86_64-unknown-unknown -fopenmp-task-serial-cutoff -emit-llvm %s -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple x86_64-unknown-unknown -emit-llvm %s -o - | FileCheck %s --check-prefix NOCUTOFF
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// NOCUTOFF-NOT: omp.task.serial
+
+int bar(int);
+
+// CHECK-LABEL: define {{.*}}i32 @{{.+}}fib
+int fib(int n) {
+  int x, y;
+  if (n < 2)
+    return n;
+  // CHECK: [[IF:%.+]] = icmp sge i32 %{{.+}}, 20
+  // CHECK: [[UNDEFERRED:%.+]] = xor i1 [[IF]], true
+  // CHECK: br i1 [[UNDEFERRED]], label %[[SERIAL:.+]], label %[[DEFERRED:.+]]
+  // CHECK: [[SERIAL]]:
+  // CHECK-NOT: call {{.*}}@__kmpc_omp_task
+  // CHECK: call {{.*}}i32 @{{.+}}fib
+  // CHECK: br label %[[CONT:.+]]
+  // CHECK: [[DEFERRED]]:
+  // CHECK: call i8* @__kmpc_omp_task_alloc(
+  // CHECK: call i32 @__kmpc_omp_task(
+  // CHECK: br label %[[CONT]]
+  // CHECK: [[CONT]]:
+#pragma omp task shared(x) if(n >= 20)
+  x = fib(n - 1);
+#pragma omp task shared(y) if(n >= 20)
+  y = fib(n - 2);
+#pragma omp taskwait
+  return x + y;
+}
+
+// CHECK-LABEL: define {{.*}}void @{{.+}}final_tasks
+void final_tasks(int n) {
+  int a = n;
+  // Final tasks are created through the runtime, so that omp_in_final() holds
+  // in them and in the tasks they include.
+  // CHECK-NOT: omp.task.serial
+  // CHECK: call i8* @__kmpc_omp_task_alloc(
+  // CHECK: call i8* @__kmpc_omp_task_alloc(
+#pragma omp task firstprivate(a) final(n < 20)
+  bar(a);
+#pragma omp task firstprivate(a) final(n < 20) if(n > 100)
+  bar(a);
+  // A constant false 'if' clause only emits the serial version.
+  // CHECK-NOT: call i8* @__kmpc_omp_task_alloc(
+  // CHECK: call {{.*}}i32 @{{.+}}bar
+#pragma omp task if(0)
+  bar(a);
+  // A condition with side effects keeps the runtime path.
+  // CHECK: call i8* @__kmpc_omp_task_alloc(
+  // CHECK-NOT: omp.task.serial
+#pragma omp task if(bar(n))
+  bar(a);
+  // CHECK: ret void
+}
+
+#endif
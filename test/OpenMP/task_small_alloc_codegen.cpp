@@ -0,0 +1,46 @@
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple x86_64-unknown-unknown -fopenmp-small-task-alloc -emit-llvm %s -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple x86_64-unknown-unknown -emit-llvm %s -o - | FileCheck %s --check-prefix NOSMALL
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// NOSMALL-NOT: __kmpc_omp_small_task_alloc
+
+void fn(int);
+
+// CHECK-LABEL: define {{.*}}void @{{.+}}small_tasks
+void small_tasks(int n) {
+  int a = n, b[4] = {0};
+  // CHECK: call i8* @__kmpc_omp_small_task_alloc(
+  // CHECK: call i32 @__kmpc_omp_task(
+#pragma omp task firstprivate(a)
+  fn(a);
+  // CHECK: call i8* @__kmpc_omp_small_task_alloc(
+  // CHECK: call i32 @__kmpc_omp_task(
+#pragma omp task shared(b)
+  fn(b[0]);
+  // Untied tasks take the general path.
+  // CHECK: call i8* @__kmpc_omp_task_alloc(
+#pragma omp task untied firstprivate(a)
+  fn(a);
+  // So do tasks with dependences.
+  // CHECK: call i8* @__kmpc_omp_task_alloc(
+  // CHECK: call i32 @__kmpc_omp_task_with_deps(
+#pragma omp task depend(in: a)
+  fn(a);
+  // CHECK: ret void
+}
+
+// CHECK-LABEL: define {{.*}}void @{{.+}}large_task
+void large_task() {
+  int c[32];
+  c[0] = 0;
+  // The privates do not fit in a cache line.
+  // CHECK: call i8* @__kmpc_omp_task_alloc(
+  // CHECK-NOT: __kmpc_omp_small_task_alloc
+#pragma omp task firstprivate(c)
+  fn(c[0]);
+  // CHECK: ret void
+}
+
+#endif
@@ -0,0 +1,52 @@
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple x86_64-unknown-unknown -fopenmp-taskloop-shared-firstprivates -emit-llvm %s -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -x c++ -triple x86_64-unknown-unknown -emit-llvm %s -o - | FileCheck %s --check-prefix NOSHARED
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+// NOSHARED-NOT: firstpriv.shared
+
+struct Coeffs {
+  double c[64];
+};
+
+// CHECK-LABEL: define {{.*}}void @{{.+}}readonly
+void readonly(double *out, int n) {
+  // The arrays are copied once and referenced through the shareds, 'scale'
+  // is too small to be worth it.
+  double table[256];
+  Coeffs co;
+  int scale = 2;
+  for (int i = 0; i < 256; ++i)
+    table[i] = i;
+  // CHECK: [[TABLE_COPY:%table.firstpriv.shared]] = alloca [256 x double],
+  // CHECK: [[CO_COPY:%co.firstpriv.shared]] = alloca %struct.Coeffs,
+  // CHECK: call void @__kmpc_taskgroup(
+  // CHECK: call void @llvm.memcpy{{.+}}(i8* {{.+}}, i8* {{.+}}, i64 2048,
+  // CHECK: store [256 x double]* [[TABLE_COPY]], [256 x double]** %
+  // CHECK: call void @llvm.memcpy{{.+}}(i8* {{.+}}, i8* {{.+}}, i64 512,
+  // CHECK: store %struct.Coeffs* [[CO_COPY]], %struct.Coeffs** %
+  // CHECK-NOT: scale.firstpriv.shared
+  // CHECK: call void @__kmpc_taskloop(
+#pragma omp taskloop firstprivate(table, co, scale) grainsize(64)
+  for (int i = 0; i < n; ++i)
+    out[i] = table[i % 256] * co.c[i % 64] * scale;
+}
+
+// CHECK-LABEL: define {{.*}}void @{{.+}}written
+void written(double *out, int n) {
+  double table[256] = {0};
+  // Written by the loop, or not grouped with the encountering task.
+  // CHECK-NOT: firstpriv.shared
+  // CHECK: ret void
+#pragma omp taskloop firstprivate(table)
+  for (int i = 0; i < n; ++i) {
+    table[i % 256] += 1;
+    out[i] = table[i % 256];
+  }
+#pragma omp taskloop firstprivate(table) nogroup
+  for (int i = 0; i < n; ++i)
+    out[i] = table[i % 256];
+}
+
+#endif
@@ -0,0 +1,53 @@
+// RUN: %clang_cc1 -verify -fopenmp -fnoopenmp-use-tls -fopenmp-hoist-threadprivate-lookups -x c++ -triple x86_64-unknown-unknown -emit-llvm %s -o - | FileCheck %s
+// RUN: %clang_cc1 -verify -fopenmp -fnoopenmp-use-tls -x c++ -triple x86_64-unknown-unknown -emit-llvm %s -o - | FileCheck %s --check-prefix NOHOIST
+// expected-no-diagnostics
+#ifndef HEADER
+#define HEADER
+
+int counter;
+double acc[16];
+#pragma omp threadprivate(counter, acc)
+
+// Without hoisting, the address is looked up at each access in the loop.
+// NOHOIST-LABEL: define {{.*}}void @{{.+}}accumulate
+// NOHOIST: for.body:
+// NOHOIST: call i8* @__kmpc_threadprivate_cached(
+// NOHOIST: call i8* @__kmpc_threadprivate_cached(
+
+// CHECK-LABEL: define {{.*}}void @{{.+}}accumulate
+void accumulate(const double *a, int n) {
+  // CHECK-NOT: for.body:
+  // CHECK: [[ACC:%.+]] = call i8* @__kmpc_threadprivate_cached({{.+}}, i8* bitcast ([16 x double]* @acc to i8*), i64 128, i8*** @acc.cache.)
+  // CHECK-NEXT: [[COUNTER:%.+]] = call i8* @__kmpc_threadprivate_cached({{.+}}, i8* bitcast (i32* @counter to i8*), i64 4, i8*** @counter.cache.)
+  // CHECK-NEXT: br label %for.cond
+  // CHECK: for.body:
+  // CHECK-NOT: __kmpc_threadprivate_cached
+  // CHECK: bitcast i8* [[ACC]] to [16 x double]*
+  // CHECK-NOT: __kmpc_threadprivate_cached
+  // CHECK: bitcast i8* [[COUNTER]] to i32*
+  // CHECK-NOT: __kmpc_threadprivate_cached
+  // CHECK: ret void
+  for (int i = 0; i < n; ++i) {
+    acc[i % 16] += a[i];
+    ++counter;
+  }
+}
+
+// The lookup in the outlined region reads the thread id after it is stored.
+// CHECK-LABEL: define {{.*}}void @{{.+}}in_parallel
+void in_parallel(int n) {
+#pragma omp parallel
+  for (int i = 0; i < n; ++i)
+    ++counter;
+}
+// CHECK: define internal void @.omp_outlined.(i32* noalias [[GTID:%.+]], i32* noalias
+// CHECK: store i32* [[GTID]], i32** [[GTID_ADDR:%.+]],
+// CHECK: [[GTID_PTR:%.+]] = load i32*, i32** [[GTID_ADDR]],
+// CHECK: [[GTID_VAL:%.+]] = load i32, i32* [[GTID_PTR]],
+// CHECK: call i8* @__kmpc_threadprivate_cached({{.+}}, i32 [[GTID_VAL]], i8* bitcast (i32* @counter to i8*)
+// CHECK-NEXT: br label %for.cond
+// CHECK: for.body:
+// CHECK-NOT: __kmpc_threadprivate_cached
+// CHECK: ret void
+
+#endif
@@ -0,0 +1,39 @@
+// Test this without pch.
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -include %s -verify -std=c++11 -emit-llvm -o - %s | FileCheck %s
+
+// Test with pch.
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -std=c++11 -emit-pch -o %t %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -include-pch %t -verify -std=c++11 -emit-llvm -o - %s | FileCheck %s
+
+// expected-no-diagnostics
+
+#ifndef HEADER
+#define HEADER
+
+#define X4(x) x, x, x, x
+#define X16(x) X4(x), X4(x), X4(x), X4(x)
+#define X256(x) X16(x), X16(x), X16(x), X16(x), X16(x), X16(x), X16(x), \
+                X16(x), X16(x), X16(x), X16(x), X16(x), X16(x), X16(x), \
+                X16(x), X16(x)
+#define X1024(x) X256(x), X256(x), X256(x), X256(x)
+
+constexpr int table[] = { 10, -20, X1024(5) };
+
+template <typename T> T lookup(int i) {
+  static const T values[] = { 1, 2, X1024(3) };
+  return values[i];
+}
+
+#else
+
+static_assert(sizeof(table) == 1026 * sizeof(int), "");
+static_assert(table[0] == 10 && table[1] == -20 && table[1025] == 5, "");
+
+// CHECK: @_ZL5table = internal constant [1026 x i32] [i32 10, i32 -20, i32 5,
+int get(int i) { return table[i]; }
+
+// The initializer is compacted when the template is instantiated.
+// CHECK: @_ZZ6lookupIhET_iE6values = linkonce_odr constant [1026 x i8] c"\01\02\03
+unsigned char lookup_char(int i) { return lookup<unsigned char>(i); }
+
+#endif
@@ -0,0 +1,27 @@
+// Test with pch.
+// RUN: %clang_cc1 -fdelayed-template-parsing -fpch-instantiate-templates -x c++-header -emit-pch -o %t.pch %s
+// RUN: %clang_cc1 -fdelayed-template-parsing -include-pch %t.pch -triple x86_64-unknown-unknown -emit-llvm -o - %s | FileCheck %s
+
+// Late parsed templates whose bodies were parsed while building the PCH are
+// read back with the rest of the AST; the others are still parsed on use.
+
+#ifndef HEADER
+#define HEADER
+
+template <typename T> T twice(T t) { return t + t; }
+template <typename T> T thrice(T t) { return t + t + t; }
+
+inline int useTwice() { return twice(1); }
+
+#else
+
+// CHECK-LABEL: define {{.*}}@_Z4testv(
+// CHECK: call {{.*}}@_Z8useTwicev()
+// CHECK: call {{.*}}@_Z6thriceIiET_S0_(i32 2)
+int test() { return useTwice() + thrice(2); }
+
+// CHECK-LABEL: define linkonce_odr {{.*}}@_Z6thriceIiET_S0_(
+// CHECK: add nsw i32
+// CHECK: add nsw i32
+
+#endif
@@ -0,0 +1,24 @@
+// Test with pch.
+// RUN: %clang_cc1 -emit-pch -o %t.pch %s
+// RUN: %clang_cc1 -include-pch %t.pch -fsyntax-only -verify -print-stats %s 2>&1 | FileCheck %s
+
+// The identifiers of the main file that the PCH does not contain are ruled
+// out without looking them up in its identifier table.
+// CHECK: {{[1-9][0-9]*}} identifier table lookups ruled out by the identifier filter
+
+#ifndef HEADER
+#define HEADER
+
+int header_variable;
+int header_function(int header_parameter);
+#define HEADER_MACRO(x) ((x) + 1)
+
+#else
+
+// expected-no-diagnostics
+int main_file_function(int main_file_parameter) {
+  int main_file_local = HEADER_MACRO(main_file_parameter);
+  return header_function(main_file_local) + header_variable;
+}
+
+#endif
@@ -0,0 +1,37 @@
+// Test with pch.
+// RUN: %clang_cc1 -fpch-instantiate-templates -x c++-header -emit-pch -o %t.pch %s
+// RUN: %clang_cc1 -include-pch %t.pch -triple x86_64-unknown-unknown -emit-llvm -o - %s | FileCheck %s
+
+// The instantiations are performed while building the PCH.
+// RUN: %clang_cc1 -x c++-header -emit-pch -o %t.error.pch -DERROR %s
+// RUN: not %clang_cc1 -fpch-instantiate-templates -x c++-header -emit-pch -o %t.error.pch -DERROR %s 2>&1 | FileCheck %s --check-prefix ERROR
+
+#ifndef HEADER
+#define HEADER
+
+template <typename T> struct Box {
+  T get() const { return Value; }
+  T Value;
+};
+
+inline int unbox(const Box<int> &B) { return B.get(); }
+
+#ifdef ERROR
+template <typename T> struct Bad {
+  // ERROR: error: member reference base type 'int' is not a structure or union
+  int get() const { return Value.x; }
+  T Value;
+};
+
+inline int unbad(const Bad<int> &B) { return B.get(); }
+#endif
+
+#else
+
+// CHECK: define linkonce_odr i32 @_ZNK3BoxIiE3getEv(
+int main() {
+  Box<int> B = {42};
+  return unbox(B);
+}
+
+#endif
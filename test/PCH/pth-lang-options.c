@@ -0,0 +1,7 @@
+// Cached tokens are only used with language options that lex the same way.
+// RUN: %clang_cc1 -triple i386-unknown-unknown -emit-pth -o %t %S/pth.h
+// RUN: %clang_cc1 -triple i386-unknown-unknown -include-pth %t -fsyntax-only -verify %s
+// RUN: not %clang_cc1 -triple i386-unknown-unknown -x c++ -include-pth %t -fsyntax-only %s 2>&1 | FileCheck %s
+
+// CHECK: PTH file was generated with language options that lex differently from the current ones
+// expected-no-diagnostics
@@ -0,0 +1,9 @@
+inline int skipped() { return undeclared_in_skipped; }
+
+struct S {
+  int method() { return undeclared_in_method; }
+};
+
+constexpr int kept() { return 42; }
+
+template <typename T> int instantiated(T t) { return t.member; }
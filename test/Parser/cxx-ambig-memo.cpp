@@ -0,0 +1,34 @@
+// RUN: %clang_cc1 -fsyntax-only -std=c++11 -verify %s
+// expected-no-diagnostics
+
+// The results of disambiguations are reused by the enclosing tentative parses
+// and by the parse that follows them; check that they are the same results.
+
+struct S {
+  S(int);
+  S(S (*)(int));
+};
+typedef int T;
+int x;
+
+template <bool B> struct C { static const bool value = B; };
+
+void f() {
+  T(a);
+  a = 1;
+
+  // A constructor-style initializer, because 'x' is not a type.
+  S(b)(x);
+  S c = b;
+
+  // The parameter of a function declarator, because 'T' is a type.
+  S d(S(T));
+  S (*e)(S (*)(T)) = &d;
+
+  S g((S(x)));
+  C<(1 > 2)> h;
+  static_assert(!decltype(h)::value, "");
+
+  int (((((((((((((((((((((((((((((((i)))))))))))))))))))))))))))))));
+  i = a;
+}
@@ -0,0 +1,23 @@
+// RUN: %clang_cc1 -std=c++11 -fsyntax-only -skip-function-bodies-outside-main-file -verify %s
+// RUN: not %clang_cc1 -std=c++11 -fsyntax-only %s 2>&1 | FileCheck %s
+// RUN: env CINDEXTEST_SKIP_FUNCTION_BODIES_OUTSIDE_MAIN_FILE=1 c-index-test -test-load-source all -std=c++11 %s 2>&1 | FileCheck %s --check-prefix INDEX
+
+// Without the option, the bodies in the header are checked.
+// CHECK: use of undeclared identifier 'undeclared_in_skipped'
+// CHECK: use of undeclared identifier 'undeclared_in_method'
+
+#include "Inputs/skip-function-bodies-outside-main-file.h"
+
+// The bodies of constexpr functions and templates are still parsed.
+static_assert(kept() == 42, "");
+
+// expected-error@Inputs/skip-function-bodies-outside-main-file.h:9 {{member reference base type 'int' is not a structure or union}}
+int a = instantiated(1); // expected-note {{in instantiation of}}
+
+int main_body() {
+  return undeclared_in_main; // expected-error {{use of undeclared identifier 'undeclared_in_main'}}
+}
+
+// INDEX-NOT: undeclared_in_skipped
+// INDEX-NOT: undeclared_in_method
+// INDEX: use of undeclared identifier 'undeclared_in_main'
@@ -0,0 +1,26 @@
+// RUN: rm -rf %t && mkdir -p %t/a %t/b
+// RUN: echo '#ifndef GUARDED_H' > %t/b/guarded.h
+// RUN: echo '#define GUARDED_H' >> %t/b/guarded.h
+// RUN: echo 'int guarded;' >> %t/b/guarded.h
+// RUN: echo '#endif' >> %t/b/guarded.h
+// RUN: %clang_cc1 -E -I %t/a -I %t/b -fheader-info-cache=%t/cache %s | FileCheck %s
+// RUN: FileCheck %s --check-prefix CACHE < %t/cache
+// RUN: %clang_cc1 -E -I %t/a -I %t/b -fheader-info-cache=%t/cache %s | FileCheck %s
+// RUN: FileCheck %s --check-prefix CACHE < %t/cache
+//
+// The lookups do not carry over to other search directories.
+// RUN: %clang_cc1 -E -I %t/b -fheader-info-cache=%t/cache %s | FileCheck %s
+// RUN: FileCheck %s --check-prefix OTHER < %t/cache
+
+// CACHE: header-info-cache 1
+// CACHE-DAG: lookup 0 1 guarded.h
+// CACHE-DAG: file {{[0-9]+}} 56 GUARDED_H {{.*}}guarded.h
+
+// OTHER: header-info-cache 1
+// OTHER-DAG: lookup 0 0 guarded.h
+// OTHER-DAG: file {{[0-9]+}} 56 GUARDED_H {{.*}}guarded.h
+
+// CHECK: int guarded;
+// CHECK-NOT: int guarded;
+#include "guarded.h"
+#include "guarded.h"
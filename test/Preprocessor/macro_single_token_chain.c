@@ -0,0 +1,31 @@
+// RUN: %clang_cc1 %s -E | FileCheck -strict-whitespace %s
+// RUN: %clang_cc1 %s -fsyntax-only -Wdisabled-macro-expansion -verify
+// Chains of object-like macros that each expand to one token.
+
+#define VALUE ALIAS
+#define ALIAS 42
+int a = VALUE;
+// CHECK: int a = 42;
+
+// The macros of the chain are disabled at its end.
+#define PING PONG
+#define PONG PING
+int PING; // expected-warning {{disabled expansion of recursive macro}}
+// CHECK: int PING;
+
+#define SELF_ALIAS SELF
+#define SELF SELF
+int SELF_ALIAS;
+// CHECK: int SELF;
+
+// Chains that end in several tokens or a function-like macro are expanded
+// the usual way.
+#define LONG PAIR
+#define PAIR 1 + 2
+int b = LONG;
+// CHECK: int b = 1 + 2;
+
+#define CALL fn
+#define fn(x) x
+int c = CALL(3);
+// CHECK: int c = 3;
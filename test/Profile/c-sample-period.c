@@ -0,0 +1,26 @@
+// Test sampled instrumentation, which only counts one in N calls.
+
+// RUN: %clang_cc1 -triple x86_64-apple-macosx10.9 -main-file-name c-sample-period.c %s -o - -emit-llvm -fprofile-instrument=clang -fprofile-instr-sample-period=100 | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-apple-macosx10.9 -main-file-name c-sample-period.c %s -o - -emit-llvm -fprofile-instrument=clang | FileCheck -check-prefix=NOSAMPLE %s
+
+// CHECK: @[[SAMPLE:__profsample_loop]] = private global i32 0
+// NOSAMPLE-NOT: __profsample_
+
+// CHECK-LABEL: define void @loop(
+// CHECK: [[LEFT:%.*]] = load i32, i32* @[[SAMPLE]]
+// CHECK: [[SAMPLED:%.*]] = icmp eq i32 [[LEFT]], 0
+// CHECK: [[DEC:%.*]] = sub i32 [[LEFT]], 1
+// CHECK: [[NEXT:%.*]] = select i1 [[SAMPLED]], i32 99, i32 [[DEC]]
+// CHECK: store i32 [[NEXT]], i32* @[[SAMPLE]]
+// CHECK: br i1 [[SAMPLED]], label %[[ENTRYSAMPLE:.*]], label %[[ENTRYCONT:.*]]
+// CHECK: [[ENTRYSAMPLE]]:
+// CHECK: load i64, i64* getelementptr inbounds ([2 x i64], [2 x i64]* @__profc_loop, i64 0, i64 0)
+// CHECK: br label %[[ENTRYCONT]]
+void loop(int n) {
+  // CHECK: br i1 [[SAMPLED]], label %[[BODYSAMPLE:.*]], label %[[BODYCONT:.*]]
+  // CHECK: [[BODYSAMPLE]]:
+  // CHECK: load i64, i64* getelementptr inbounds ([2 x i64], [2 x i64]* @__profc_loop, i64 0, i64 1)
+  // CHECK: br label %[[BODYCONT]]
+  for (int i = 0; i < n; ++i)
+    ;
+}
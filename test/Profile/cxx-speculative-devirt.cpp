@@ -0,0 +1,55 @@
+// Check that profiled virtual calls are speculated on their dominant target.
+
+// RUN: llvm-profdata merge %S/Inputs/cxx-speculative-devirt.proftext -o %t.profdata
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -main-file-name cxx-speculative-devirt.cpp %s -o - -emit-llvm -fprofile-instrument-use-path=%t.profdata -mllvm -enable-value-profiling -fspeculative-devirtualization | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -main-file-name cxx-speculative-devirt.cpp %s -o - -emit-llvm -fprofile-instrument-use-path=%t.profdata -mllvm -enable-value-profiling | FileCheck --check-prefix=NOSPEC %s
+
+// NOSPEC-NOT: vtable.speculated
+
+struct Base {
+  virtual int f();
+};
+int Base::f() { return 1; }
+
+struct Derived : Base {
+  int f() override { return 2; }
+};
+
+struct Other {
+  virtual void g();
+  int x;
+};
+
+struct Offset : Other, Base {
+  int f() override;
+};
+
+// CHECK-LABEL: define i32 @_Z4callP4Base(
+// CHECK:       [[VTABLE:%.+]] = load i32 (%struct.Base*)**, i32 (%struct.Base*)***
+// CHECK:       [[CMP:%.+]] = icmp eq i32 (%struct.Base*)** [[VTABLE]], {{.*}}@_ZTV7Derived
+// CHECK-NEXT:  br i1 [[CMP]], label %vcall.direct, label %vcall.indirect, !prof [[WEIGHTS:![0-9]+]]
+// CHECK:       vcall.direct:
+// CHECK-NEXT:  [[DIRECT:%.+]] = call i32 bitcast (i32 (%struct.Derived*)* @_ZN7Derived1fEv to i32 (%struct.Base*)*)(
+// CHECK-NOT:   !prof
+// CHECK-NEXT:  br label %vcall.cont
+// CHECK:       vcall.indirect:
+// CHECK-NEXT:  [[INDIRECT:%.+]] = call i32 %{{.+}}(%struct.Base* {{.*}}), !prof [[VP:![0-9]+]]
+// CHECK-NEXT:  br label %vcall.cont
+// CHECK:       vcall.cont:
+// CHECK-NEXT:  phi i32 [ [[DIRECT]], %vcall.direct ], [ [[INDIRECT]], %vcall.indirect ]
+int call(Base *B) {
+  return B->f();
+}
+
+// The dominant target is not called with the same 'this' pointer.
+// CHECK-LABEL: define i32 @_Z11call_offsetP4Base(
+// CHECK-NOT:   vtable.speculated
+// CHECK:       ret i32
+int call_offset(Base *B) {
+  return B->f();
+}
+
+// CHECK: define linkonce_odr i32 @_ZN7Derived1fEv(
+
+// CHECK-DAG: [[WEIGHTS]] = !{!"branch_weights", i32 9001, i32 1001}
+// CHECK-DAG: [[VP]] = !{!"VP", i32 0, i64 10000,
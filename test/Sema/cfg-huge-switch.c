@@ -0,0 +1,49 @@
+// RUN: %clang_cc1 -fsyntax-only -Wall -Wunreachable-code -verify %s
+// expected-no-diagnostics
+
+// Generated state machines have switches with tens of thousands of cases, and
+// functions with as many statements. Building the CFGs for the analysis-based
+// warnings on them must stay linear: this builds a switch with 16384 cases and
+// a function with 16384 statements.
+
+#define CASE1(n) case (n): return (n) + 1;
+#define CASE2(n) CASE1(2 * (n)) CASE1(2 * (n) + 1)
+#define CASE3(n) CASE2(2 * (n)) CASE2(2 * (n) + 1)
+#define CASE4(n) CASE3(2 * (n)) CASE3(2 * (n) + 1)
+#define CASE5(n) CASE4(2 * (n)) CASE4(2 * (n) + 1)
+#define CASE6(n) CASE5(2 * (n)) CASE5(2 * (n) + 1)
+#define CASE7(n) CASE6(2 * (n)) CASE6(2 * (n) + 1)
+#define CASE8(n) CASE7(2 * (n)) CASE7(2 * (n) + 1)
+#define CASE9(n) CASE8(2 * (n)) CASE8(2 * (n) + 1)
+#define CASE10(n) CASE9(2 * (n)) CASE9(2 * (n) + 1)
+#define CASE11(n) CASE10(2 * (n)) CASE10(2 * (n) + 1)
+#define CASE12(n) CASE11(2 * (n)) CASE11(2 * (n) + 1)
+#define CASE13(n) CASE12(2 * (n)) CASE12(2 * (n) + 1)
+#define CASE14(n) CASE13(2 * (n)) CASE13(2 * (n) + 1)
+
+#define STMT1(n) x = x * 3 + (n);
+#define STMT2(n) STMT1(2 * (n)) STMT1(2 * (n) + 1)
+#define STMT3(n) STMT2(2 * (n)) STMT2(2 * (n) + 1)
+#define STMT4(n) STMT3(2 * (n)) STMT3(2 * (n) + 1)
+#define STMT5(n) STMT4(2 * (n)) STMT4(2 * (n) + 1)
+#define STMT6(n) STMT5(2 * (n)) STMT5(2 * (n) + 1)
+#define STMT7(n) STMT6(2 * (n)) STMT6(2 * (n) + 1)
+#define STMT8(n) STMT7(2 * (n)) STMT7(2 * (n) + 1)
+#define STMT9(n) STMT8(2 * (n)) STMT8(2 * (n) + 1)
+#define STMT10(n) STMT9(2 * (n)) STMT9(2 * (n) + 1)
+#define STMT11(n) STMT10(2 * (n)) STMT10(2 * (n) + 1)
+#define STMT12(n) STMT11(2 * (n)) STMT11(2 * (n) + 1)
+#define STMT13(n) STMT12(2 * (n)) STMT12(2 * (n) + 1)
+#define STMT14(n) STMT13(2 * (n)) STMT13(2 * (n) + 1)
+
+int state_machine(int state) {
+  switch (state) {
+    CASE14(0)
+  }
+  return 0;
+}
+
+int long_function(int x) {
+  STMT14(0)
+  return x;
+}
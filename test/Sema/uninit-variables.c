@@ -531,3 +531,14 @@ void test_analyzer_noreturn_2(int y) {
   }
   ++x; // no-warning
 }
+
+int jump_past_initialized_decl(int a) {
+  switch (a) {
+  case 0:
+    ;
+    int k = 1; // expected-note {{variable}}
+  case 1: // expected-warning {{whenever switch case is taken}}
+    return k; // expected-note {{uninitialized use}}
+  }
+  return 0;
+}
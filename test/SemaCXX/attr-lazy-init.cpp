@@ -0,0 +1,20 @@
+// RUN: %clang_cc1 -fsyntax-only -verify -std=c++11 %s
+
+int f();
+
+[[clang::lazy_init]] int a = f();
+__attribute__((lazy_init)) static int b = f();
+[[clang::lazy_init]] extern int c;
+
+struct S {
+  [[clang::lazy_init]] static int m;
+  [[clang::lazy_init]] int n; // expected-error {{only applies to variables with static or thread}}
+};
+
+void g([[clang::lazy_init]] int p) { // expected-error {{only applies to variables with static or thread}}
+  [[clang::lazy_init]] static int d = f();
+  [[clang::lazy_init]] int e = f(); // expected-error {{only applies to variables with static or thread}}
+}
+
+[[clang::lazy_init]] void h(); // expected-error {{only applies to variables with static or thread}}
+[[clang::lazy_init(1)]] int i; // expected-error {{'lazy_init' attribute takes no arguments}}
@@ -0,0 +1,25 @@
+// RUN: %clang_cc1 -std=c++14 -fsyntax-only -verify %s -fconstexpr-depth 16 -fconstexpr-backtrace-limit 0
+// RUN: not %clang_cc1 -std=c++14 -fsyntax-only -print-stats %s -fconstexpr-depth 16 2>&1 | FileCheck %s
+
+// Calls whose result only depends on their arguments are evaluated once.
+// CHECK: {{[1-9][0-9]*}}/{{[0-9]+}} constexpr calls found in the call cache
+
+constexpr long fib(int n) { return n < 2 ? n : fib(n - 1) + fib(n - 2); }
+static_assert(fib(20) == 6765, "");
+static_assert(fib(20) + fib(19) == fib(21), "");
+
+constexpr double half(double d) { return d / 2; }
+static_assert(half(3.0) == 1.5, "");
+static_assert(half(3.0) + half(3.0) == 3.0, "");
+
+// Reusing a result must not let a call exceed the limits of the evaluation.
+constexpr int depth(int n) { return n ? depth(n - 1) : 0; } // expected-note {{exceeded maximum depth of 16}} expected-note +{{in call to}}
+static_assert(depth(10) == 0, "");
+constexpr int deeper(int n) { return n ? deeper(n - 1) : depth(10); } // expected-note +{{in call to}}
+static_assert(deeper(8) == 0, ""); // expected-error {{constant expression}} expected-note {{in call to 'deeper(8)'}}
+
+// Calls with arguments other than numbers are evaluated every time.
+struct S { int n; };
+constexpr int get(const S &s) { return s.n; }
+constexpr S s1{1}, s2{2};
+static_assert(get(s1) == 1 && get(s2) == 2, "");
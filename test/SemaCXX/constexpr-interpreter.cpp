@@ -0,0 +1,75 @@
+// RUN: %clang_cc1 -std=c++14 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -std=c++14 -fsyntax-only -verify %s -fexperimental-constexpr-interpreter
+// RUN: not %clang_cc1 -std=c++14 -fsyntax-only %s -fexperimental-constexpr-interpreter -print-stats 2>&1 | FileCheck %s
+
+// CHECK: {{[1-9][0-9]*}}/{{[0-9]+}} constexpr functions compiled to bytecode
+// CHECK: {{[1-9][0-9]*}}/{{[0-9]+}} constexpr calls evaluated by the bytecode interpreter
+
+constexpr int sum(int n) {
+  int s = 0;
+  for (int i = 0; i < n; ++i) {
+    if (i % 3 == 0)
+      continue;
+    s += i;
+  }
+  return s;
+}
+static_assert(sum(10) == 27, "");
+
+constexpr unsigned collatz(unsigned long long n) {
+  unsigned steps = 0;
+  while (n != 1) {
+    n = n % 2 ? 3 * n + 1 : n / 2;
+    ++steps;
+  }
+  return steps;
+}
+static_assert(collatz(27) == 111, "");
+
+constexpr int bits(unsigned x) {
+  int n = 0;
+  do
+    n += x & 1;
+  while (x >>= 1);
+  return n;
+}
+static_assert(bits(0xF0F0u) == 8, "");
+
+// Signed types narrower than int wrap around.
+constexpr signed char next(signed char c) { return ++c; }
+static_assert(next(127) == -128, "");
+
+enum E { A = 1, B = 4 };
+constexpr int shifts(int n) { return (A << n) | (B >> 1); }
+static_assert(shifts(3) == 10, "");
+
+// Calls are left to the AST evaluator, which uses the bytecode for the callee.
+constexpr bool isPrime(int n) {
+  if (n < 2)
+    return false;
+  for (int d = 2; d * d <= n; ++d)
+    if (n % d == 0)
+      return false;
+  return true;
+}
+constexpr int countPrimes(int n) {
+  int c = 0;
+  for (int i = 0; i < n; i++)
+    c += isPrime(i);
+  return c;
+}
+static_assert(countPrimes(100) == 25, "");
+
+// Evaluations that the AST evaluator diagnoses are diagnosed the same way.
+constexpr int power(int b, int e) {
+  int r = 1;
+  for (int i = 0; i < e; ++i)
+    r *= b; // expected-note {{value 2147483648 is outside the range of representable values of type 'int'}}
+  return r;
+}
+static_assert(power(3, 4) == 81, "");
+static_assert(power(2, 32) == 0, ""); // expected-error {{constant expression}} expected-note {{in call to 'power(2, 32)'}}
+
+constexpr int divide(int a, int b) { return a / b; } // expected-note {{division by zero}}
+static_assert(divide(7, 2) == 3, "");
+static_assert(divide(7, 0) == 0, ""); // expected-error {{constant expression}} expected-note {{in call to 'divide(7, 0)'}}
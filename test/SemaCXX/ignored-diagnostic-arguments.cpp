@@ -0,0 +1,23 @@
+// RUN: %clang_cc1 -fsyntax-only -std=c++11 -verify %s
+
+// Diagnostics that are ignored where they are reported drop their arguments;
+// check that the ones around them, and the ones SFINAE keeps, are unaffected.
+
+void f(int i) {
+  char a{300}; // expected-error {{constant expression evaluates to 300 which cannot be narrowed to type 'char'}} expected-note {{insert an explicit cast to silence this issue}}
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wc++11-narrowing"
+  char b{300};
+  char c{i};
+#pragma clang diagnostic pop
+  char d{i}; // expected-error {{non-constant-expression cannot be narrowed from type 'int' to 'char' in initializer list}} expected-note {{insert an explicit cast to silence this issue}}
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wc++11-narrowing"
+template <typename T> auto g(T t) -> decltype(char{t}); // expected-note {{substitution failure [with T = int]: non-constant-expression cannot be narrowed from type 'int' to 'char' in initializer list}}
+#pragma clang diagnostic pop
+
+void h(int i) {
+  g(i); // expected-error {{no matching function for call to 'g'}}
+}
@@ -0,0 +1,16 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -fsyntax-only -print-stats %s 2>&1 | FileCheck %s
+// expected-no-diagnostics
+
+// The first 16 conversion sequences of a candidate set are stored inline; the
+// second and third candidates of each call do not fit.
+// CHECK: 36 overload candidate conversion sequences allocated out of line ({{[0-9]+}} bytes)
+
+void f(int, int, int, int, int, int, int, int, int);
+void f(int, int, int, int, int, int, int, int, long);
+void f(int, int, int, int, int, int, int, int, char);
+
+void g() {
+  f(1, 2, 3, 4, 5, 6, 7, 8, 9);
+  f(1, 2, 3, 4, 5, 6, 7, 8, 9L);
+}
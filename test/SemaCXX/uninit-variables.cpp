@@ -150,3 +150,11 @@ int test_const_ref() {
 
 // Don't crash here.
 auto PR19996 = [a=0]{int t; return a;};
+
+int initialized_at_decl(int a) {
+  int n = a; // no-warning
+  for (int i = 0; i < a; ++i)
+    n += i;
+  int m = m + n; // expected-warning {{uninitialized when used within its own initialization}}
+  return n + m;
+}
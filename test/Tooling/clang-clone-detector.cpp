@@ -0,0 +1,22 @@
+// RUN: clang-clone-detector %s %S/Inputs/clang-clone-detector-other.cpp -- | FileCheck %s
+// RUN: clang-clone-detector %s -- | FileCheck -check-prefix=SINGLE %s
+
+// CHECK: clone group 1: 2 sequences, complexity {{[0-9]+}}, in 2 translation units
+// CHECK-NEXT: clang-clone-detector.cpp:13:37
+// CHECK-NEXT: clang-clone-detector-other.cpp:1:37
+// CHECK-NEXT: 1 clone groups, 1 across translation units
+
+// SINGLE: 0 clone groups, 0 across translation units
+
+int g(int);
+
+int accumulate(const int *v, int n) {
+  int sum = 0;
+  for (int i = 0; i < n; ++i)
+    sum += v[i];
+  return sum;
+}
+
+int other(int a) {
+  return g(a) + 1;
+}
@@ -0,0 +1,27 @@
+// RUN: echo 'ifStmt()' > %t.matchers
+// RUN: echo '# Calls to f.' >> %t.matchers
+// RUN: echo 'callExpr(callee(functionDecl(hasName("f"))))' >> %t.matchers
+// RUN: clang-matcher-bench -matchers=%t.matchers -iterations=2 -parse-iterations=3 -profile-matchers %s -- | FileCheck %s
+// RUN: clang-matcher-bench %s -- | FileCheck -check-prefix=DEFAULT %s
+// RUN: echo 'notAMatcher()' > %t.bad
+// RUN: not clang-matcher-bench -matchers=%t.bad %s -- 2>&1 | FileCheck -check-prefix=ERROR %s
+
+// CHECK: matchers: 2 expressions, parsed 6 times in
+// CHECK: clang-matcher-bench.cpp: {{[0-9]+}} nodes, 6 matches, parsed in
+// CHECK: total: {{[0-9]+}} nodes, 6 matches, parsed in {{.*}} nodes/s, {{.*}} matches/s)
+// CHECK: peak heap: {{.*}} MB
+// CHECK-DAG: 4 matches  ifStmt()
+// CHECK-DAG: 2 matches  callExpr(callee(functionDecl(hasName("f"))))
+
+// DEFAULT: matchers: {{[0-9]+}} expressions
+// DEFAULT: total: {{[0-9]+}} nodes, {{[0-9]+}} matches
+
+// ERROR: error: invalid matcher 'notAMatcher()':
+
+void f();
+void g(bool b) {
+  if (b)
+    f();
+  if (!b) {
+  }
+}
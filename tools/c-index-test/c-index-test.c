@@ -76,6 +76,8 @@ static unsigned getDefaultParsingOptions() {
     options &= ~CXTranslationUnit_CacheCompletionResults;
   if (getenv("CINDEXTEST_SKIP_FUNCTION_BODIES"))
     options |= CXTranslationUnit_SkipFunctionBodies;
+  if (getenv("CINDEXTEST_SKIP_FUNCTION_BODIES_OUTSIDE_MAIN_FILE"))
+    options |= CXTranslationUnit_SkipFunctionBodiesOutsideMainFile;
   if (getenv("CINDEXTEST_COMPLETION_BRIEF_COMMENTS"))
     options |= CXTranslationUnit_IncludeBriefCommentsInCodeCompletion;
   if (getenv("CINDEXTEST_CREATE_PREAMBLE_ON_FIRST_PARSE"))
@@ -1709,6 +1711,9 @@ int perform_test_reparse_source(int argc, const char **argv, int trials,
   Idx = clang_createIndex(/* excludeDeclsFromPCH */
                           !strcmp(filter, "local") ? 1 : 0,
                           /* displayDiagnostics=*/1);
+  if (getenv("CINDEXTEST_PREAMBLE_CACHE_DIR"))
+    clang_CXIndex_setPreambleCacheDirectory(
+        Idx, getenv("CINDEXTEST_PREAMBLE_CACHE_DIR"));
   
   if (parse_remapped_files(argc, argv, 0, &unsaved_files, &num_unsaved_files)) {
     clang_disposeIndex(Idx);
@@ -1746,6 +1751,22 @@ int perform_test_reparse_source(int argc, const char **argv, int trials,
         strtol(getenv("CINDEXTEST_REMAP_AFTER_TRIAL"), &endptr, 10);
   }
 
+  /* CINDEXTEST_MEMORY_BUDGET=<budget>:<visible begin>:<visible end> */
+  if (getenv("CINDEXTEST_MEMORY_BUDGET")) {
+    unsigned long long budget;
+    unsigned visible_begin, visible_end;
+    if (sscanf(getenv("CINDEXTEST_MEMORY_BUDGET"), "%llu:%u:%u", &budget,
+               &visible_begin, &visible_end) != 3 ||
+        clang_setTranslationUnitMemoryBudget(TU, budget, visible_begin,
+                                             visible_end)) {
+      fprintf(stderr, "invalid CINDEXTEST_MEMORY_BUDGET\n");
+      clang_disposeTranslationUnit(TU);
+      free_remapped_files(unsaved_files, num_unsaved_files);
+      clang_disposeIndex(Idx);
+      return -1;
+    }
+  }
+
   for (trial = 0; trial < trials; ++trial) {
     free_remapped_files(unsaved_files, num_unsaved_files);
     if (parse_remapped_files_with_try(trial, argc, argv, 0,
@@ -1780,6 +1801,67 @@ int perform_test_reparse_source(int argc, const char **argv, int trials,
   return result;
 }
 
+/******************************************************************************/
+/* Logic for testing clang_visitChildrenBuffered().                           */
+/******************************************************************************/
+
+static unsigned PrintCursorRecords(const CXCursorRecord *records,
+                                   unsigned num_records,
+                                   CXClientData client_data) {
+  unsigned *position = (unsigned *)client_data;
+  unsigned i;
+
+  for (i = 0; i != num_records; ++i, ++*position) {
+    const CXCursorRecord *R = &records[i];
+    if (!clang_Location_isFromMainFile(clang_getRangeStart(R->extent)))
+      continue;
+
+    printf("// %s: ", FileCheckPrefix);
+    PrintCursor(R->cursor, NULL);
+    PrintRange(R->extent, "Extent");
+    /* Print the distance to the parent, which does not depend on the number
+       of cursors outside of the main file. */
+    if (R->parent != ~0U)
+      printf(" Parent=-%u", *position - R->parent);
+    printf("\n");
+  }
+  return 0;
+}
+
+static int perform_test_visit_buffered(int argc, const char **argv) {
+  CXIndex Idx;
+  CXTranslationUnit TU;
+  CXCursorRecord *records;
+  unsigned num_records, position = 0;
+  enum CXErrorCode Err;
+
+  num_records = atoi(argv[0]);
+  if (num_records == 0) {
+    fprintf(stderr, "invalid number of records\n");
+    return 1;
+  }
+
+  Idx = clang_createIndex(/* excludeDeclsFromPCH */ 1,
+                          /* displayDiagnostics=*/1);
+  Err = clang_parseTranslationUnit2(Idx, 0, argv + 1, argc - 1, 0, 0,
+                                    getDefaultParsingOptions(), &TU);
+  if (Err != CXError_Success) {
+    fprintf(stderr, "Unable to load translation unit!\n");
+    describeLibclangFailure(Err);
+    clang_disposeIndex(Idx);
+    return 1;
+  }
+
+  records = (CXCursorRecord *)malloc(num_records * sizeof(CXCursorRecord));
+  clang_visitChildrenBuffered(clang_getTranslationUnitCursor(TU), records,
+                              num_records, PrintCursorRecords, &position);
+  free(records);
+
+  clang_disposeTranslationUnit(TU);
+  clang_disposeIndex(Idx);
+  return 0;
+}
+
 /******************************************************************************/
 /* Logic for testing clang_getCursor().                                       */
 /******************************************************************************/
@@ -2172,7 +2254,11 @@ int perform_code_completion(int argc, const char **argv, int timing_only) {
   CXTranslationUnit TU;
   unsigned I, Repeats = 1;
   unsigned completionOptions = clang_defaultCodeCompleteOptions();
+  const char *completionFilter = getenv("CINDEXTEST_COMPLETION_FILTER");
+  unsigned maxResults = 0;
   
+  if (getenv("CINDEXTEST_COMPLETION_MAX_RESULTS"))
+    maxResults = atoi(getenv("CINDEXTEST_COMPLETION_MAX_RESULTS"));
   if (getenv("CINDEXTEST_CODE_COMPLETE_PATTERNS"))
     completionOptions |= CXCodeComplete_IncludeCodePatterns;
   if (getenv("CINDEXTEST_COMPLETION_BRIEF_COMMENTS"))
@@ -2216,9 +2302,15 @@ int perform_code_completion(int argc, const char **argv, int timing_only) {
   }
 
   for (I = 0; I != Repeats; ++I) {
-    results = clang_codeCompleteAt(TU, filename, line, column,
-                                   unsaved_files, num_unsaved_files,
-                                   completionOptions);
+    if (completionFilter || maxResults)
+      results = clang_codeCompleteAtWithFilter(TU, filename, line, column,
+                                               unsaved_files, num_unsaved_files,
+                                               completionOptions,
+                                               completionFilter, maxResults);
+    else
+      results = clang_codeCompleteAt(TU, filename, line, column,
+                                     unsaved_files, num_unsaved_files,
+                                     completionOptions);
     if (!results) {
       fprintf(stderr, "Unable to perform code completion!\n");
       return 1;
@@ -2234,8 +2326,10 @@ int perform_code_completion(int argc, const char **argv, int timing_only) {
     CXString objCSelector;
     const char *selectorString;
     if (!timing_only) {      
-      /* Sort the code-completion results based on the typed text. */
-      clang_sortCodeCompletionResults(results->Results, results->NumResults);
+      /* Sort the code-completion results based on the typed text, unless
+         they were ranked while filtering them. */
+      if (!completionFilter && !maxResults)
+        clang_sortCodeCompletionResults(results->Results, results->NumResults);
 
       for (i = 0; i != n; ++i)
         print_completion_result(results->Results + i, stdout);
@@ -3466,6 +3560,85 @@ static int index_tu(int argc, const char **argv) {
   return result;
 }
 
+/* Index all the commands of the compilation database with one call to
+   clang_indexSourceFiles. The commands need to share their directory. */
+static int index_compile_commands_in_batch(CXCompileCommands CCmds,
+                                           CXIndexAction idxAction,
+                                           const char *check_prefix,
+                                           unsigned num_threads) {
+  unsigned numCmds = clang_CompileCommands_getSize(CCmds);
+  IndexData *index_data = (IndexData *)calloc(numCmds, sizeof(IndexData));
+  CXClientData *client_data =
+      (CXClientData *)malloc(numCmds * sizeof(CXClientData));
+  CXString *cxargs = 0;
+  const char **args = 0;
+  const char ***command_lines =
+      (const char ***)malloc(numCmds * sizeof(const char **));
+  int *num_args = (int *)malloc(numCmds * sizeof(int));
+  unsigned i, a, totalArgs = 0, argIdx = 0;
+  CXString dir =
+      clang_CompileCommand_getDirectory(clang_CompileCommands_getCommand(CCmds, 0));
+  int result = 0;
+
+  if (chdir(clang_getCString(dir)) != 0) {
+    printf("Could not chdir to %s\n", clang_getCString(dir));
+    result = -1;
+  }
+
+  for (i = 0; i < numCmds; ++i)
+    totalArgs +=
+        clang_CompileCommand_getNumArgs(clang_CompileCommands_getCommand(CCmds, i));
+  cxargs = (CXString *)malloc(totalArgs * sizeof(CXString));
+  args = (const char **)malloc(totalArgs * sizeof(const char *));
+
+  for (i = 0; i < numCmds; ++i) {
+    CXCompileCommand CCmd = clang_CompileCommands_getCommand(CCmds, i);
+    CXString wd = clang_CompileCommand_getDirectory(CCmd);
+    if (strcmp(clang_getCString(dir), clang_getCString(wd)) != 0) {
+      fprintf(stderr, "batch indexing needs the commands to share their "
+                      "directory\n");
+      result = -1;
+    }
+    clang_disposeString(wd);
+
+    num_args[i] = clang_CompileCommand_getNumArgs(CCmd);
+    command_lines[i] = args + argIdx;
+    for (a = 0; a < (unsigned)num_args[i]; ++a, ++argIdx) {
+      cxargs[argIdx] = clang_CompileCommand_getArg(CCmd, a);
+      args[argIdx] = clang_getCString(cxargs[argIdx]);
+    }
+
+    index_data[i].check_prefix = check_prefix;
+    index_data[i].main_filename = "";
+    client_data[i] = &index_data[i];
+  }
+
+  if (result == 0) {
+    result = clang_indexSourceFiles(
+        idxAction, client_data, &IndexCB, sizeof(IndexCB), getIndexOptions(),
+        (const char *const *const *)command_lines, num_args, numCmds,
+        num_threads, getDefaultParsingOptions(), /*results=*/0);
+    if (result != CXError_Success)
+      describeLibclangFailure(result);
+  }
+
+  for (i = 0; i < numCmds; ++i) {
+    if (index_data[i].fail_for_error)
+      result = -1;
+    free_client_data(&index_data[i]);
+  }
+  for (a = 0; a < argIdx; ++a)
+    clang_disposeString(cxargs[a]);
+  clang_disposeString(dir);
+  free(args);
+  free(cxargs);
+  free(num_args);
+  free(command_lines);
+  free(client_data);
+  free(index_data);
+  return result;
+}
+
 static int index_compile_db(int argc, const char **argv) {
   const char *check_prefix;
   CXIndex Idx;
@@ -3492,6 +3665,9 @@ static int index_compile_db(int argc, const char **argv) {
     return 1;
   }
   idxAction = clang_IndexAction_create(Idx);
+  if (getenv("CINDEXTEST_PARSED_BODIES_FILE"))
+    clang_IndexAction_setParsedBodiesFile(
+        idxAction, getenv("CINDEXTEST_PARSED_BODIES_FILE"));
 
   {
     const char *database = argv[0];
@@ -3544,6 +3720,13 @@ static int index_compile_db(int argc, const char **argv) {
         goto cdb_end;
       }
 
+      if (getenv("CINDEXTEST_INDEX_THREADS")) {
+        errorCode = index_compile_commands_in_batch(
+            CCmds, idxAction, check_prefix,
+            atoi(getenv("CINDEXTEST_INDEX_THREADS")));
+        goto cdb_end;
+      }
+
       for (i=0; i<numCmds && errorCode == 0; ++i) {
         CCmd = clang_CompileCommands_getCommand(CCmds, i);
 
@@ -4278,6 +4461,7 @@ static void print_usage(void) {
     "       c-index-test -test-load-source-usrs <symbol filter> {<args>}*\n"
     "       c-index-test -test-load-source-usrs-memory-usage "
           "<symbol filter> {<args>}*\n"
+    "       c-index-test -test-visit-buffered <records> {<args>}*\n"
     "       c-index-test -test-annotate-tokens=<range> {<args>}*\n"
     "       c-index-test -test-inclusion-stack-source {<args>}*\n"
     "       c-index-test -test-inclusion-stack-tu <AST file>\n");
@@ -4364,6 +4548,8 @@ int cindextest_main(int argc, const char **argv) {
       return perform_test_load_source(argc - 3, argv + 3, argv[2], I,
                                       postVisit);
   }
+  else if (argc >= 4 && strcmp(argv[1], "-test-visit-buffered") == 0)
+    return perform_test_visit_buffered(argc - 2, argv + 2);
   else if (argc >= 4 && strcmp(argv[1], "-test-file-scan") == 0)
     return perform_file_scan(argv[2], argv[3],
                              argc >= 5 ? argv[4] : 0);
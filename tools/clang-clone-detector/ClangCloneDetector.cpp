@@ -0,0 +1,134 @@
+//===--- tools/clang-clone-detector/ClangCloneDetector.cpp ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements clang-clone-detector, a tool that searches the code
+//  of many translation units for clones with the CloneDetector. Unlike the
+//  alpha.clone.CloneChecker, which only sees one translation unit at a time,
+//  it keeps the ASTs of all the given files and reports the clones between
+//  them as well.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/RecursiveASTVisitor.h"
+#include "clang/Analysis/CloneDetection.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Tooling/CommonOptionsParser.h"
+#include "clang/Tooling/Tooling.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Support/Signals.h"
+
+using namespace clang;
+using namespace clang::tooling;
+using namespace llvm;
+
+static cl::extrahelp CommonHelp(CommonOptionsParser::HelpMessage);
+static cl::extrahelp MoreHelp(
+    "\tFor example, to find the clones between the files of a project that\n"
+    "\thas a compilation database, use:\n"
+    "\n"
+    "\t  clang-clone-detector -p build src/*.cpp\n"
+    "\n");
+
+static cl::OptionCategory DetectorCategory("clang-clone-detector options");
+
+static cl::opt<unsigned> MinComplexity(
+    "min-complexity",
+    cl::desc("Only report the clones that have at least this complexity."),
+    cl::init(10), cl::cat(DetectorCategory));
+
+static cl::opt<bool> CrossTUOnly(
+    "cross-tu-only",
+    cl::desc("Only report the clones found in more than one file."),
+    cl::cat(DetectorCategory));
+
+namespace {
+/// \brief Passes the body of each function and method defined in the main
+/// file to the CloneDetector.
+class CodeBodyCollector : public RecursiveASTVisitor<CodeBodyCollector> {
+  CloneDetector &Detector;
+  const SourceManager &SM;
+
+  void analyze(const Decl *D) {
+    if (D->hasBody() && SM.isInMainFile(SM.getExpansionLoc(D->getLocation())))
+      Detector.analyzeCodeBody(D);
+  }
+
+public:
+  CodeBodyCollector(CloneDetector &Detector, const SourceManager &SM)
+      : Detector(Detector), SM(SM) {}
+
+  bool VisitFunctionDecl(FunctionDecl *D) {
+    if (D->doesThisDeclarationHaveABody())
+      analyze(D);
+    return true;
+  }
+
+  bool VisitObjCMethodDecl(ObjCMethodDecl *D) {
+    if (D->hasBody())
+      analyze(D);
+    return true;
+  }
+};
+} // end anonymous namespace
+
+static void printLocation(const StmtSequence &Seq) {
+  const SourceManager &SM = Seq.getASTContext().getSourceManager();
+  PresumedLoc Loc = SM.getPresumedLoc(SM.getExpansionLoc(Seq.getStartLoc()));
+  outs() << "  " << Loc.getFilename() << ":" << Loc.getLine() << ":"
+         << Loc.getColumn() << "\n";
+}
+
+int main(int argc, const char **argv) {
+  llvm::sys::PrintStackTraceOnErrorSignal(argv[0]);
+
+  CommonOptionsParser OptionsParser(argc, argv, DetectorCategory);
+  ClangTool Tool(OptionsParser.getCompilations(),
+                 OptionsParser.getSourcePathList());
+
+  // The sequences found by the detector point into the ASTs, so all of them
+  // are kept until the clones have been reported.
+  std::vector<std::unique_ptr<ASTUnit>> ASTs;
+  int Status = Tool.buildASTs(ASTs);
+
+  CloneDetector Detector;
+  for (const auto &AST : ASTs) {
+    ASTContext &Context = AST->getASTContext();
+    CodeBodyCollector(Detector, Context.getSourceManager())
+        .TraverseDecl(Context.getTranslationUnitDecl());
+  }
+
+  std::vector<CloneDetector::CloneGroup> Groups;
+  Detector.findClones(Groups, MinComplexity);
+
+  unsigned NumReported = 0, NumCrossTU = 0;
+  for (const CloneDetector::CloneGroup &Group : Groups) {
+    SmallPtrSet<const ASTContext *, 4> Contexts;
+    for (const StmtSequence &Seq : Group.Sequences)
+      Contexts.insert(&Seq.getASTContext());
+    bool IsCrossTU = Contexts.size() > 1;
+    if (IsCrossTU)
+      ++NumCrossTU;
+    else if (CrossTUOnly)
+      continue;
+
+    outs() << "clone group " << ++NumReported << ": "
+           << Group.Sequences.size() << " sequences, complexity "
+           << Group.Signature.Complexity;
+    if (IsCrossTU)
+      outs() << ", in " << Contexts.size() << " translation units";
+    outs() << "\n";
+    for (const StmtSequence &Seq : Group.Sequences)
+      printLocation(Seq);
+  }
+
+  outs() << Groups.size() << " clone groups, " << NumCrossTU
+         << " across translation units\n";
+  return Status;
+}
@@ -23,6 +23,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/ThreadPool.h"
 
 using namespace llvm;
 using clang::tooling::Replacements;
@@ -96,6 +97,16 @@ static cl::opt<unsigned>
                     "clang-format from an editor integration"),
            cl::init(0), cl::cat(ClangFormatCategory));
 
+static cl::opt<unsigned>
+    Jobs("jobs",
+         cl::desc("The number of files formatted at the same time, or\n"
+                  "the number of threads formatting the lines of the\n"
+                  "file if there is only one.\n"
+                  "The output does not depend on it."),
+         cl::init(1), cl::cat(ClangFormatCategory));
+static cl::alias JobsShort("j", cl::desc("Alias for -jobs"),
+                           cl::aliasopt(Jobs));
+
 static cl::opt<bool> SortIncludes(
     "sort-includes",
     cl::desc("If set, overrides the include sorting behavior determined by the "
@@ -126,7 +137,8 @@ static bool parseLineRange(StringRef Input, unsigned &FromLine,
 }
 
 static bool fillRanges(MemoryBuffer *Code,
-                       std::vector<tooling::Range> &Ranges) {
+                       std::vector<tooling::Range> &Ranges,
+                       raw_ostream &ErrOS) {
   IntrusiveRefCntPtr<vfs::InMemoryFileSystem> InMemoryFileSystem(
       new vfs::InMemoryFileSystem);
   FileManager Files(FileSystemOptions(), InMemoryFileSystem);
@@ -138,18 +150,18 @@ static bool fillRanges(MemoryBuffer *Code,
                                  InMemoryFileSystem.get());
   if (!LineRanges.empty()) {
     if (!Offsets.empty() || !Lengths.empty()) {
-      errs() << "error: cannot use -lines with -offset/-length\n";
+      ErrOS << "error: cannot use -lines with -offset/-length\n";
       return true;
     }
 
     for (unsigned i = 0, e = LineRanges.size(); i < e; ++i) {
       unsigned FromLine, ToLine;
       if (parseLineRange(LineRanges[i], FromLine, ToLine)) {
-        errs() << "error: invalid <start line>:<end line> pair\n";
+        ErrOS << "error: invalid <start line>:<end line> pair\n";
         return true;
       }
       if (FromLine > ToLine) {
-        errs() << "error: start line should be less than end line\n";
+        ErrOS << "error: start line should be less than end line\n";
         return true;
       }
       SourceLocation Start = Sources.translateLineCol(ID, FromLine, 1);
@@ -163,16 +175,18 @@ static bool fillRanges(MemoryBuffer *Code,
     return false;
   }
 
+  // Files may be formatted concurrently, so leave -offset alone.
+  std::vector<unsigned> Offsets(::Offsets.begin(), ::Offsets.end());
   if (Offsets.empty())
     Offsets.push_back(0);
   if (Offsets.size() != Lengths.size() &&
       !(Offsets.size() == 1 && Lengths.empty())) {
-    errs() << "error: number of -offset and -length arguments must match.\n";
+    ErrOS << "error: number of -offset and -length arguments must match.\n";
     return true;
   }
   for (unsigned i = 0, e = Offsets.size(); i != e; ++i) {
     if (Offsets[i] >= Code->getBufferSize()) {
-      errs() << "error: offset " << Offsets[i] << " is outside the file\n";
+      ErrOS << "error: offset " << Offsets[i] << " is outside the file\n";
       return true;
     }
     SourceLocation Start =
@@ -180,7 +194,7 @@ static bool fillRanges(MemoryBuffer *Code,
     SourceLocation End;
     if (i < Lengths.size()) {
       if (Offsets[i] + Lengths[i] > Code->getBufferSize()) {
-        errs() << "error: invalid length " << Lengths[i]
+        ErrOS << "error: invalid length " << Lengths[i]
                << ", offset + length (" << Offsets[i] + Lengths[i]
                << ") is outside the file.\n";
         return true;
@@ -196,61 +210,64 @@ static bool fillRanges(MemoryBuffer *Code,
   return false;
 }
 
-static void outputReplacementXML(StringRef Text) {
+static void outputReplacementXML(StringRef Text, raw_ostream &OS) {
   // FIXME: When we sort includes, we need to make sure the stream is correct
   // utf-8.
   size_t From = 0;
   size_t Index;
   while ((Index = Text.find_first_of("\n\r<&", From)) != StringRef::npos) {
-    outs() << Text.substr(From, Index - From);
+    OS << Text.substr(From, Index - From);
     switch (Text[Index]) {
     case '\n':
-      outs() << "&#10;";
+      OS << "&#10;";
       break;
     case '\r':
-      outs() << "&#13;";
+      OS << "&#13;";
       break;
     case '<':
-      outs() << "&lt;";
+      OS << "&lt;";
       break;
     case '&':
-      outs() << "&amp;";
+      OS << "&amp;";
       break;
     default:
       llvm_unreachable("Unexpected character encountered!");
     }
     From = Index + 1;
   }
-  outs() << Text.substr(From);
+  OS << Text.substr(From);
 }
 
-static void outputReplacementsXML(const Replacements &Replaces) {
+static void outputReplacementsXML(const Replacements &Replaces,
+                                  raw_ostream &OS) {
   for (const auto &R : Replaces) {
-    outs() << "<replacement "
+    OS << "<replacement "
            << "offset='" << R.getOffset() << "' "
            << "length='" << R.getLength() << "'>";
-    outputReplacementXML(R.getReplacementText());
-    outs() << "</replacement>\n";
+    outputReplacementXML(R.getReplacementText(), OS);
+    OS << "</replacement>\n";
   }
 }
 
-// Returns true on error.
-static bool format(StringRef FileName) {
+// Formats the file, computing its style with \p Styles and its replacements
+// with \p Threads threads, and writes the result to \p OS and the errors to
+// \p ErrOS. Returns true on error.
+static bool format(StringRef FileName, StyleCache &Styles, unsigned Threads,
+                   raw_ostream &OS, raw_ostream &ErrOS) {
   ErrorOr<std::unique_ptr<MemoryBuffer>> CodeOrErr =
       MemoryBuffer::getFileOrSTDIN(FileName);
   if (std::error_code EC = CodeOrErr.getError()) {
-    errs() << EC.message() << "\n";
+    ErrOS << EC.message() << "\n";
     return true;
   }
   std::unique_ptr<llvm::MemoryBuffer> Code = std::move(CodeOrErr.get());
   if (Code->getBufferSize() == 0)
     return false; // Empty files are formatted correctly.
   std::vector<tooling::Range> Ranges;
-  if (fillRanges(Code.get(), Ranges))
+  if (fillRanges(Code.get(), Ranges, ErrOS))
     return true;
   StringRef AssumedFileName = (FileName == "-") ? AssumeFileName : FileName;
-  FormatStyle FormatStyle =
-      getStyle(Style, AssumedFileName, FallbackStyle, Code->getBuffer());
+  FormatStyle FormatStyle = Styles.getStyle(AssumedFileName, Code->getBuffer());
   if (SortIncludes.getNumOccurrences() != 0)
     FormatStyle.SortIncludes = SortIncludes;
   unsigned CursorPosition = Cursor;
@@ -258,26 +275,27 @@ static bool format(StringRef FileName) {
                                        AssumedFileName, &CursorPosition);
   auto ChangedCode = tooling::applyAllReplacements(Code->getBuffer(), Replaces);
   if (!ChangedCode) {
-    llvm::errs() << llvm::toString(ChangedCode.takeError()) << "\n";
+    ErrOS << llvm::toString(ChangedCode.takeError()) << "\n";
     return true;
   }
   // Get new affected ranges after sorting `#includes`.
   Ranges = tooling::calculateRangesAfterReplacements(Replaces, Ranges);
   bool IncompleteFormat = false;
-  Replacements FormatChanges = reformat(FormatStyle, *ChangedCode, Ranges,
-                                        AssumedFileName, &IncompleteFormat);
+  Replacements FormatChanges =
+      reformat(FormatStyle, *ChangedCode, Ranges, AssumedFileName,
+               &IncompleteFormat, Threads);
   Replaces = Replaces.merge(FormatChanges);
   if (OutputXML) {
-    outs() << "<?xml version='1.0'?>\n<replacements "
+    OS << "<?xml version='1.0'?>\n<replacements "
               "xml:space='preserve' incomplete_format='"
            << (IncompleteFormat ? "true" : "false") << "'>\n";
     if (Cursor.getNumOccurrences() != 0)
-      outs() << "<cursor>"
+      OS << "<cursor>"
              << FormatChanges.getShiftedCodePosition(CursorPosition)
              << "</cursor>\n";
 
-    outputReplacementsXML(Replaces);
-    outs() << "</replacements>\n";
+    outputReplacementsXML(Replaces, OS);
+    OS << "</replacements>\n";
   } else {
     IntrusiveRefCntPtr<vfs::InMemoryFileSystem> InMemoryFileSystem(
         new vfs::InMemoryFileSystem);
@@ -292,16 +310,16 @@ static bool format(StringRef FileName) {
     tooling::applyAllReplacements(Replaces, Rewrite);
     if (Inplace) {
       if (FileName == "-")
-        errs() << "error: cannot use -i when reading from stdin.\n";
+        ErrOS << "error: cannot use -i when reading from stdin.\n";
       else if (Rewrite.overwriteChangedFiles())
         return true;
     } else {
       if (Cursor.getNumOccurrences() != 0)
-        outs() << "{ \"Cursor\": "
+        OS << "{ \"Cursor\": "
                << FormatChanges.getShiftedCodePosition(CursorPosition)
                << ", \"IncompleteFormat\": "
                << (IncompleteFormat ? "true" : "false") << " }\n";
-      Rewrite.getEditBuffer(ID).write(outs());
+      Rewrite.getEditBuffer(ID).write(OS);
     }
   }
   return false;
@@ -342,13 +360,15 @@ int main(int argc, const char **argv) {
     return 0;
   }
 
+  // Configuration files shared by the files are only read once.
+  clang::format::StyleCache Styles(Style, FallbackStyle);
   bool Error = false;
   switch (FileNames.size()) {
   case 0:
-    Error = clang::format::format("-");
+    Error = clang::format::format("-", Styles, Jobs, outs(), errs());
     break;
   case 1:
-    Error = clang::format::format(FileNames[0]);
+    Error = clang::format::format(FileNames[0], Styles, Jobs, outs(), errs());
     break;
   default:
     if (!Offsets.empty() || !Lengths.empty() || !LineRanges.empty()) {
@@ -356,8 +376,36 @@ int main(int argc, const char **argv) {
                 "single file.\n";
       return 1;
     }
-    for (unsigned i = 0; i < FileNames.size(); ++i)
-      Error |= clang::format::format(FileNames[i]);
+    if (Jobs <= 1) {
+      for (unsigned i = 0; i < FileNames.size(); ++i)
+        Error |= clang::format::format(FileNames[i], Styles, 1, outs(), errs());
+      break;
+    }
+
+    // Format the files concurrently, buffering their output so that it is
+    // written in the order of the files.
+    struct FileResult {
+      std::string Output;
+      std::string Errors;
+      bool Error;
+    };
+    std::vector<FileResult> Results(FileNames.size());
+    std::vector<std::shared_future<void>> Done;
+    llvm::ThreadPool Pool(std::min<unsigned>(Jobs, FileNames.size()));
+    for (unsigned i = 0; i < FileNames.size(); ++i) {
+      Done.push_back(Pool.async([&Styles, &Results, i] {
+        raw_string_ostream OS(Results[i].Output);
+        raw_string_ostream ErrOS(Results[i].Errors);
+        Results[i].Error =
+            clang::format::format(FileNames[i], Styles, 1, OS, ErrOS);
+      }));
+    }
+    for (unsigned i = 0; i < FileNames.size(); ++i) {
+      Done[i].wait();
+      outs() << Results[i].Output;
+      errs() << Results[i].Errors;
+      Error |= Results[i].Error;
+    }
     break;
   }
   return Error ? 1 : 0;
@@ -0,0 +1,406 @@
+//===-- ClangOpenMPFuzzer.cpp - Fuzz Clang with OpenMP programs -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief This file implements a function that builds a valid OpenMP program
+///  from a single input and runs Clang on it through code generation. This
+///  function is then linked into the Fuzzer library.
+///
+///  The input selects a loop nest and the directives and clauses around it,
+///  so every input exercises Sema and CodeGen for OpenMP instead of being
+///  rejected by the parser. Besides crashes, the inputs whose compilation
+///  takes longer or allocates more than the limits below are reported by
+///  aborting, so that the Fuzzer library saves them:
+///
+///    -omp-time-limit-ms=<N>    compilation time limit, default 1000
+///    -omp-memory-limit-mb=<N>  heap growth limit, default 512
+///    -omp-print                print every program that is compiled
+///
+///  The programs that take the longest to compile for their size are printed
+///  as they are found, to point at superlinear behavior.
+///
+//===----------------------------------------------------------------------===//
+
+#include "clang/CodeGen/CodeGenAction.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Lex/PreprocessorOptions.h"
+#include "clang/Tooling/Tooling.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Option/Option.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstdlib>
+
+using namespace clang;
+
+namespace {
+
+/// Reads the choices of the program generator from the fuzzer input. Once
+/// the input is exhausted every choice is the first one, so that every input
+/// makes a program.
+class ChoiceStream {
+  const uint8_t *Data;
+  size_t Size;
+
+public:
+  ChoiceStream(const uint8_t *Data, size_t Size) : Data(Data), Size(Size) {}
+
+  /// Returns a choice in [0, N).
+  unsigned pick(unsigned N) {
+    if (Size == 0 || N <= 1)
+      return 0;
+    --Size;
+    return *Data++ % N;
+  }
+
+  /// Returns a choice in [Min, Max].
+  unsigned pickRange(unsigned Min, unsigned Max) {
+    return Min + pick(Max - Min + 1);
+  }
+
+  bool flip() { return pick(2) == 1; }
+};
+
+enum DirectiveFlags : unsigned {
+  DF_Loop = 1 << 0,
+  DF_For = 1 << 1,
+  DF_Distribute = 1 << 2,
+  DF_Simd = 1 << 3,
+  DF_Parallel = 1 << 4,
+  DF_Teams = 1 << 5,
+  DF_Target = 1 << 6,
+  DF_Taskloop = 1 << 7,
+};
+
+struct DirectiveInfo {
+  const char *Name;
+  unsigned Flags;
+};
+
+const DirectiveInfo Directives[] = {
+    {"parallel", DF_Parallel},
+    {"parallel for", DF_Parallel | DF_For | DF_Loop},
+    {"parallel for simd", DF_Parallel | DF_For | DF_Simd | DF_Loop},
+    {"simd", DF_Simd | DF_Loop},
+    {"taskloop", DF_Taskloop | DF_Loop},
+    {"target", DF_Target},
+    {"target parallel", DF_Target | DF_Parallel},
+    {"target parallel for", DF_Target | DF_Parallel | DF_For | DF_Loop},
+    {"target simd", DF_Target | DF_Simd | DF_Loop},
+    {"target teams", DF_Target | DF_Teams},
+    {"target teams distribute", DF_Target | DF_Teams | DF_Distribute | DF_Loop},
+    {"target teams distribute simd",
+     DF_Target | DF_Teams | DF_Distribute | DF_Simd | DF_Loop},
+    {"target teams distribute parallel for",
+     DF_Target | DF_Teams | DF_Distribute | DF_Parallel | DF_For | DF_Loop},
+    {"target teams distribute parallel for simd",
+     DF_Target | DF_Teams | DF_Distribute | DF_Parallel | DF_For | DF_Simd |
+         DF_Loop},
+};
+
+/// The loop directives that can be nested in a directive that is not a loop
+/// directive, by the name of the enclosing directive.
+struct NestedDirectiveInfo {
+  const char *Outer;
+  DirectiveInfo Inner;
+};
+
+const NestedDirectiveInfo NestedDirectives[] = {
+    {"parallel", {"for", DF_For | DF_Loop}},
+    {"parallel", {"for simd", DF_For | DF_Simd | DF_Loop}},
+    {"parallel", {"simd", DF_Simd | DF_Loop}},
+    {"target", {"parallel for", DF_Parallel | DF_For | DF_Loop}},
+    {"target",
+     {"teams distribute parallel for",
+      DF_Teams | DF_Distribute | DF_Parallel | DF_For | DF_Loop}},
+    {"target", {"simd", DF_Simd | DF_Loop}},
+    {"target parallel", {"for", DF_For | DF_Loop}},
+    {"target teams", {"distribute", DF_Distribute | DF_Loop}},
+    {"target teams",
+     {"distribute parallel for", DF_Distribute | DF_Parallel | DF_For |
+                                     DF_Loop}},
+    {"target teams", {"distribute simd", DF_Distribute | DF_Simd | DF_Loop}},
+};
+
+const char *const ReductionOps[] = {"+", "*", "max", "min"};
+const char *const ScheduleKinds[] = {"static", "dynamic", "guided"};
+
+const unsigned MaxDepth = 6;
+const unsigned MaxArrays = 64;
+const unsigned MaxScalars = 8;
+const unsigned MaxRegions = 4;
+
+/// Builds an OpenMP program from the choices of the input: a function that
+/// takes some arrays and executes a few loop nests in OpenMP regions.
+class ProgramGenerator {
+  ChoiceStream &Choices;
+  llvm::raw_svector_ostream OS;
+  unsigned NumArrays = 0;
+  unsigned NumScalars = 0;
+
+  /// The number of loops, directives and clause items, as a measure of the
+  /// size of the program.
+  unsigned Size = 0;
+
+  /// Writes the clauses of a directive. The scalars in \p Reduced are
+  /// already reduced by the enclosing directive and must stay shared.
+  void emitClauses(unsigned Flags, unsigned Depth, ArrayRef<unsigned> Reduced,
+                   SmallVectorImpl<unsigned> &Reductions,
+                   SmallVectorImpl<unsigned> &Arrays) {
+    if ((Flags & DF_Loop) && Depth > 1 && Choices.flip()) {
+      OS << " collapse(" << Choices.pickRange(1, Depth) << ")";
+      ++Size;
+    }
+    if ((Flags & DF_For) && Choices.flip()) {
+      OS << " schedule(" << ScheduleKinds[Choices.pick(3)];
+      if (Choices.flip())
+        OS << ", " << Choices.pickRange(1, 128);
+      OS << ")";
+      ++Size;
+    }
+    if ((Flags & DF_Distribute) && Choices.flip()) {
+      OS << " dist_schedule(static";
+      if (Choices.flip())
+        OS << ", " << Choices.pickRange(1, 256);
+      OS << ")";
+      ++Size;
+    }
+    if ((Flags & DF_Simd) && Choices.flip()) {
+      OS << " simdlen(" << (1u << Choices.pick(4)) << ")";
+      ++Size;
+    }
+    if ((Flags & DF_Taskloop) && Choices.flip()) {
+      OS << " grainsize(" << Choices.pickRange(1, 64) << ")";
+      ++Size;
+    }
+    if ((Flags & DF_Parallel) && Choices.flip()) {
+      OS << " num_threads(" << Choices.pickRange(1, 1024) << ")";
+      ++Size;
+    }
+    if ((Flags & DF_Teams) && Choices.flip()) {
+      OS << " num_teams(" << Choices.pickRange(1, 1024)
+         << ") thread_limit(" << Choices.pickRange(1, 1024) << ")";
+      Size += 2;
+    }
+    // Each scalar is reduced at most once, and the reductions come before
+    // the maps.
+    if (Flags & (DF_For | DF_Simd | DF_Parallel | DF_Teams)) {
+      for (unsigned I = 0; I < NumScalars; ++I) {
+        if (llvm::is_contained(Reduced, I) || !Choices.flip())
+          continue;
+        OS << " reduction(" << ReductionOps[Choices.pick(4)] << ": s" << I
+           << ")";
+        Reductions.push_back(I);
+        ++Size;
+      }
+    }
+    if (Flags & DF_Target) {
+      // Every array is mapped by its own clause, or not at all.
+      for (unsigned I = 0; I < NumArrays; ++I) {
+        if (!Choices.flip())
+          continue;
+        const char *Type = Choices.flip() ? "tofrom" : "to";
+        OS << " map(" << Type << ": a" << I << "[0:n])";
+        ++Size;
+      }
+    }
+    // The body updates a few arrays and the reduction variables.
+    for (unsigned I = 0, E = Choices.pickRange(1, 4); I < E; ++I)
+      Arrays.push_back(Choices.pick(NumArrays));
+  }
+
+  void emitLoopNest(unsigned Depth, ArrayRef<unsigned> Reductions,
+                    ArrayRef<unsigned> Arrays, unsigned Indent) {
+    SmallString<64> Index;
+    for (unsigned I = 0; I < Depth; ++I) {
+      OS.indent(Indent + 2 * I) << "for (int i" << I << " = 0; i" << I
+                                << " < n; ++i" << I << ")\n";
+      Index += I == 0 ? "" : " + ";
+      Index += "i" + std::to_string(I);
+      ++Size;
+    }
+    unsigned BodyIndent = Indent + 2 * Depth;
+    OS.indent(BodyIndent) << "{\n";
+    for (unsigned A : Arrays)
+      OS.indent(BodyIndent + 2) << "a" << A << "[(" << Index << ") % n] = a"
+                                << A << "[(" << Index << ") % n] * 0.5 + 1;\n";
+    for (unsigned S : Reductions)
+      OS.indent(BodyIndent + 2) << "s" << S << " += a" << Arrays[0] << "[("
+                                << Index << ") % n];\n";
+    OS.indent(BodyIndent) << "}\n";
+  }
+
+  void emitRegion() {
+    const DirectiveInfo &D =
+        Directives[Choices.pick(llvm::array_lengthof(Directives))];
+    unsigned Depth = Choices.pickRange(1, MaxDepth);
+    SmallVector<unsigned, 8> Reductions;
+    SmallVector<unsigned, 8> Arrays;
+    OS << "#pragma omp " << D.Name;
+    emitClauses(D.Flags, Depth, None, Reductions, Arrays);
+    OS << "\n";
+    ++Size;
+
+    if (D.Flags & DF_Loop) {
+      emitLoopNest(Depth, Reductions, Arrays, 2);
+      return;
+    }
+
+    // The loop nest of a directive that is not a loop directive may be
+    // under a nested loop directive.
+    SmallVector<const DirectiveInfo *, 4> Nested;
+    for (const auto &N : NestedDirectives)
+      if (StringRef(N.Outer) == D.Name)
+        Nested.push_back(&N.Inner);
+    if (Nested.empty() || !Choices.flip()) {
+      emitLoopNest(Depth, Reductions, Arrays, 2);
+      return;
+    }
+    const DirectiveInfo &Inner = *Nested[Choices.pick(Nested.size())];
+    SmallVector<unsigned, 8> InnerReductions;
+    SmallVector<unsigned, 8> InnerArrays;
+    OS << "#pragma omp " << Inner.Name;
+    emitClauses(Inner.Flags, Depth, Reductions, InnerReductions, InnerArrays);
+    OS << "\n";
+    ++Size;
+    InnerReductions.append(Reductions.begin(), Reductions.end());
+    InnerArrays.append(Arrays.begin(), Arrays.end());
+    emitLoopNest(Depth, InnerReductions, InnerArrays, 2);
+  }
+
+public:
+  ProgramGenerator(ChoiceStream &Choices, SmallVectorImpl<char> &Out)
+      : Choices(Choices), OS(Out) {}
+
+  /// Writes the program and returns its size.
+  unsigned generate() {
+    NumArrays = Choices.pickRange(1, MaxArrays);
+    NumScalars = Choices.pick(MaxScalars + 1);
+    OS << "void kernel(int n";
+    for (unsigned I = 0; I < NumArrays; ++I)
+      OS << ", double *a" << I;
+    OS << ") {\n";
+    for (unsigned I = 0; I < NumScalars; ++I)
+      OS << "  double s" << I << " = 1;\n";
+    for (unsigned I = 0, E = Choices.pickRange(1, MaxRegions); I < E; ++I)
+      emitRegion();
+    for (unsigned I = 0; I < NumScalars; ++I)
+      OS << "  a0[" << I << "] = s" << I << ";\n";
+    OS << "}\n";
+    return Size;
+  }
+};
+
+unsigned TimeLimitMs = 1000;
+unsigned MemoryLimitMB = 512;
+bool PrintPrograms = false;
+
+/// The slowest compilation found so far, in milliseconds for each unit of
+/// program size.
+double SlowestPerUnit = 0;
+
+/// The heap in use at the end of the last compilation, while its AST and IR
+/// are still alive.
+size_t HeapAtEnd = 0;
+
+/// Runs code generation and records the heap it leaves in use.
+class MeasuredCodeGenAction : public EmitLLVMOnlyAction {
+protected:
+  void EndSourceFileAction() override {
+    HeapAtEnd = llvm::sys::Process::GetMallocUsage();
+    EmitLLVMOnlyAction::EndSourceFileAction();
+  }
+};
+
+bool parseLimit(StringRef Arg, StringRef Name, unsigned &Value) {
+  if (!Arg.consume_front(Name))
+    return false;
+  unsigned V;
+  if (!Arg.getAsInteger(10, V))
+    Value = V;
+  return true;
+}
+
+} // end anonymous namespace
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv) {
+  for (int I = 1; I < *argc; ++I) {
+    StringRef Arg = (*argv)[I];
+    if (parseLimit(Arg, "-omp-time-limit-ms=", TimeLimitMs) ||
+        parseLimit(Arg, "-omp-memory-limit-mb=", MemoryLimitMB))
+      continue;
+    if (Arg == "-omp-print")
+      PrintPrograms = true;
+  }
+  return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(uint8_t *data, size_t size) {
+  ChoiceStream Choices(data, size);
+  SmallString<4096> Program;
+  unsigned ProgramSize = ProgramGenerator(Choices, Program).generate();
+  if (PrintPrograms)
+    llvm::errs() << Program << "\n";
+
+  llvm::opt::ArgStringList CC1Args;
+  CC1Args.push_back("-cc1");
+  CC1Args.push_back("-fopenmp");
+  CC1Args.push_back("-fopenmp-targets=nvptx64-nvidia-cuda");
+  CC1Args.push_back("./test.cc");
+  llvm::IntrusiveRefCntPtr<FileManager> Files(
+      new FileManager(FileSystemOptions()));
+  IgnoringDiagConsumer Diags;
+  IntrusiveRefCntPtr<DiagnosticOptions> DiagOpts = new DiagnosticOptions();
+  DiagnosticsEngine Diagnostics(
+      IntrusiveRefCntPtr<clang::DiagnosticIDs>(new DiagnosticIDs()), &*DiagOpts,
+      &Diags, false);
+  std::unique_ptr<clang::CompilerInvocation> Invocation(
+      tooling::newInvocation(&Diagnostics, CC1Args));
+  std::unique_ptr<llvm::MemoryBuffer> Input =
+      llvm::MemoryBuffer::getMemBufferCopy(Program);
+  Invocation->getPreprocessorOpts().addRemappedFile("./test.cc", Input.release());
+  std::unique_ptr<tooling::ToolAction> action(
+      tooling::newFrontendActionFactory<MeasuredCodeGenAction>());
+  std::shared_ptr<PCHContainerOperations> PCHContainerOps =
+      std::make_shared<PCHContainerOperations>();
+
+  size_t HeapAtStart = llvm::sys::Process::GetMallocUsage();
+  HeapAtEnd = HeapAtStart;
+  llvm::TimeRecord Start = llvm::TimeRecord::getCurrentTime(/*Start=*/true);
+  action->runInvocation(Invocation.release(), Files.get(), PCHContainerOps,
+                        &Diags);
+  llvm::TimeRecord End = llvm::TimeRecord::getCurrentTime(/*Start=*/false);
+
+  double Ms = (End.getWallTime() - Start.getWallTime()) * 1000;
+  double HeapMB = HeapAtEnd > HeapAtStart
+                      ? double(HeapAtEnd - HeapAtStart) / (1024 * 1024)
+                      : 0;
+  double PerUnit = Ms / (ProgramSize ? ProgramSize : 1);
+  if (PerUnit > SlowestPerUnit) {
+    SlowestPerUnit = PerUnit;
+    llvm::errs() << "slowest program so far: " << llvm::format("%.1f", Ms)
+                 << " ms, " << llvm::format("%.1f", HeapMB) << " MB, size "
+                 << ProgramSize << "\n"
+                 << Program << "\n";
+  }
+
+  if (Ms > TimeLimitMs || HeapMB > MemoryLimitMB) {
+    llvm::errs() << "ERROR: compilation took " << llvm::format("%.1f", Ms)
+                 << " ms and " << llvm::format("%.1f", HeapMB)
+                 << " MB, beyond the limits of " << TimeLimitMs << " ms and "
+                 << MemoryLimitMB << " MB\n"
+                 << Program << "\n";
+    std::abort();
+  }
+  return 0;
+}
@@ -0,0 +1,315 @@
+//===--- tools/clang-matcher-bench/ClangMatcherBench.cpp ------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements clang-matcher-bench, a tool that measures how fast
+//  the AST matchers run. It parses a corpus of matcher expressions with the
+//  dynamic matcher parser, runs all of them over each translation unit in a
+//  single MatchFinder pass, and reports the throughput in AST nodes and
+//  matches per second along with the peak heap usage, so that performance
+//  can be tracked across releases.
+//
+//  Large preprocessed files (.i or .ii) make the most stable inputs, as they
+//  do not depend on the headers installed on the machine.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/RecursiveASTVisitor.h"
+#include "clang/ASTMatchers/ASTMatchFinder.h"
+#include "clang/ASTMatchers/Dynamic/Parser.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Tooling/CommonOptionsParser.h"
+#include "clang/Tooling/Tooling.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/Timer.h"
+#include <algorithm>
+
+using namespace clang;
+using namespace clang::ast_matchers;
+using namespace clang::tooling;
+using namespace llvm;
+
+static cl::extrahelp CommonHelp(CommonOptionsParser::HelpMessage);
+static cl::extrahelp MoreHelp(
+    "\tFor example, to benchmark the default matchers on a preprocessed\n"
+    "\tfile, use:\n"
+    "\n"
+    "\t  clang-matcher-bench -iterations=5 big.ii -- -std=c++11\n"
+    "\n");
+
+static cl::OptionCategory BenchCategory("clang-matcher-bench options");
+
+static cl::opt<std::string> MatchersFile(
+    "matchers",
+    cl::desc("File with the matcher expressions to run, one per line.\n"
+             "Lines starting with '#' are ignored. Defaults to a built-in\n"
+             "corpus."),
+    cl::value_desc("filename"), cl::cat(BenchCategory));
+
+static cl::opt<unsigned>
+    Iterations("iterations",
+               cl::desc("Number of times to match each translation unit."),
+               cl::init(1), cl::cat(BenchCategory));
+
+static cl::opt<unsigned> ParseIterations(
+    "parse-iterations",
+    cl::desc("Number of times to parse the matcher expressions."),
+    cl::init(100), cl::cat(BenchCategory));
+
+static cl::opt<bool>
+    ProfileMatchers("profile-matchers",
+                    cl::desc("Report the time spent in each matcher."),
+                    cl::cat(BenchCategory));
+
+// Matchers in the style of the checks people write. They cover node and
+// narrowing matchers as well as the traversal matchers that walk down
+// (hasDescendant) and up (hasAncestor) the AST.
+static const char *const DefaultMatchers[] = {
+    "callExpr(callee(functionDecl(hasName(\"malloc\"))))",
+    "cxxMemberCallExpr(callee(cxxMethodDecl(hasName(\"size\"))),"
+    " on(hasType(cxxRecordDecl(hasName(\"::std::vector\")))))",
+    "ifStmt(hasCondition(expr(hasType(booleanType()))))",
+    "varDecl(hasLocalStorage(), unless(hasInitializer(expr())))",
+    "varDecl(hasType(pointerType(pointee(isConstQualified()))))",
+    "declRefExpr(to(functionDecl()), hasAncestor(lambdaExpr()))",
+    "cxxRecordDecl(isDefinition(), hasMethod(cxxMethodDecl(isVirtual())))",
+    "binaryOperator(hasOperatorName(\"==\"), hasEitherOperand(floatLiteral()))",
+    "returnStmt(hasDescendant(cxxConstructExpr()))",
+    "forStmt(hasBody(stmt(hasDescendant(callExpr()))))",
+    "namedDecl(matchesName(\"::detail::\"))",
+};
+
+namespace {
+
+/// \brief Counts the matches of one matcher.
+class CountingCallback : public MatchFinder::MatchCallback {
+public:
+  explicit CountingCallback(StringRef Expression) : Expression(Expression) {}
+
+  void run(const MatchFinder::MatchResult &) override { ++Matches; }
+
+  StringRef getID() const override { return Expression; }
+
+  std::string Expression;
+  uint64_t Matches = 0;
+};
+
+/// \brief Counts the nodes that a MatchFinder visits.
+class NodeCounter : public RecursiveASTVisitor<NodeCounter> {
+  typedef RecursiveASTVisitor<NodeCounter> VisitorBase;
+
+public:
+  bool shouldVisitTemplateInstantiations() const { return true; }
+  bool shouldVisitImplicitCode() const { return true; }
+
+  bool TraverseDecl(Decl *DeclNode) {
+    if (DeclNode)
+      ++Nodes;
+    return VisitorBase::TraverseDecl(DeclNode);
+  }
+  bool TraverseStmt(Stmt *StmtNode) {
+    if (StmtNode)
+      ++Nodes;
+    return VisitorBase::TraverseStmt(StmtNode);
+  }
+  bool TraverseType(QualType TypeNode) {
+    ++Nodes;
+    return VisitorBase::TraverseType(TypeNode);
+  }
+  bool TraverseTypeLoc(TypeLoc TypeLocNode) {
+    ++Nodes;
+    return VisitorBase::TraverseTypeLoc(TypeLocNode);
+  }
+  bool TraverseNestedNameSpecifier(NestedNameSpecifier *NNS) {
+    if (NNS)
+      ++Nodes;
+    return VisitorBase::TraverseNestedNameSpecifier(NNS);
+  }
+  bool TraverseNestedNameSpecifierLoc(NestedNameSpecifierLoc NNS) {
+    if (NNS)
+      ++Nodes;
+    return VisitorBase::TraverseNestedNameSpecifierLoc(NNS);
+  }
+
+  uint64_t Nodes = 0;
+};
+
+} // namespace
+
+static bool loadMatchers(std::vector<std::string> &Expressions) {
+  if (MatchersFile.empty()) {
+    Expressions.assign(std::begin(DefaultMatchers), std::end(DefaultMatchers));
+    return true;
+  }
+  ErrorOr<std::unique_ptr<MemoryBuffer>> Buffer =
+      MemoryBuffer::getFile(MatchersFile);
+  if (!Buffer) {
+    errs() << "error: cannot read '" << MatchersFile
+           << "': " << Buffer.getError().message() << "\n";
+    return false;
+  }
+  SmallVector<StringRef, 16> Lines;
+  (*Buffer)->getBuffer().split(Lines, '\n');
+  for (StringRef Line : Lines) {
+    Line = Line.trim();
+    if (!Line.empty() && !Line.startswith("#"))
+      Expressions.push_back(Line);
+  }
+  return true;
+}
+
+static double secondsSince(const TimeRecord &Start) {
+  TimeRecord Elapsed = TimeRecord::getCurrentTime(false);
+  Elapsed -= Start;
+  return Elapsed.getWallTime();
+}
+
+static double perSecond(uint64_t Count, double Seconds) {
+  return Seconds > 0 ? Count / Seconds : 0;
+}
+
+static uint64_t
+countMatches(const std::vector<std::unique_ptr<CountingCallback>> &Callbacks) {
+  uint64_t Matches = 0;
+  for (const auto &Callback : Callbacks)
+    Matches += Callback->Matches;
+  return Matches;
+}
+
+static void printThroughput(StringRef Name, uint64_t Nodes, uint64_t Matches,
+                            double ParseSeconds, double MatchSeconds) {
+  outs() << Name
+         << format(": %llu nodes, %llu matches, parsed in %.3fs, matched in "
+                   "%.3fs (%.0f nodes/s, %.0f matches/s)\n",
+                   (unsigned long long)Nodes, (unsigned long long)Matches,
+                   ParseSeconds, MatchSeconds, perSecond(Nodes, MatchSeconds),
+                   perSecond(Matches, MatchSeconds));
+}
+
+int main(int argc, const char **argv) {
+  llvm::sys::PrintStackTraceOnErrorSignal(argv[0]);
+
+  CommonOptionsParser OptionsParser(argc, argv, BenchCategory);
+
+  std::vector<std::string> Expressions;
+  if (!loadMatchers(Expressions))
+    return 1;
+
+  StringMap<TimeRecord> Records;
+  MatchFinder::MatchFinderOptions FinderOptions;
+  if (ProfileMatchers)
+    FinderOptions.CheckProfiling.emplace(Records);
+  MatchFinder Finder(std::move(FinderOptions));
+
+  std::vector<std::unique_ptr<CountingCallback>> Callbacks;
+  for (const std::string &Expression : Expressions) {
+    dynamic::Diagnostics Diag;
+    auto Matcher = dynamic::Parser::parseMatcherExpression(Expression, &Diag);
+    if (!Matcher) {
+      errs() << "error: invalid matcher '" << Expression << "':\n";
+      Diag.printToStreamFull(errs());
+      errs() << "\n";
+      return 1;
+    }
+    Callbacks.push_back(llvm::make_unique<CountingCallback>(Expression));
+    if (!Finder.addDynamicMatcher(*Matcher, Callbacks.back().get())) {
+      errs() << "error: matcher '" << Expression
+             << "' cannot be used at the top level\n";
+      return 1;
+    }
+  }
+
+  // Time the dynamic matcher parser on the corpus.
+  TimeRecord Start = TimeRecord::getCurrentTime(true);
+  for (unsigned I = 0; I < ParseIterations; ++I) {
+    for (const std::string &Expression : Expressions) {
+      dynamic::Diagnostics Diag;
+      dynamic::Parser::parseMatcherExpression(Expression, &Diag);
+    }
+  }
+  double MatcherParseSeconds = secondsSince(Start);
+  uint64_t Parsed = uint64_t(ParseIterations) * Expressions.size();
+  outs() << format("matchers: %u expressions, parsed %llu times in %.3fs "
+                   "(%.0f expressions/s)\n",
+                   unsigned(Expressions.size()), (unsigned long long)Parsed,
+                   MatcherParseSeconds,
+                   perSecond(Parsed, MatcherParseSeconds));
+
+  StringMap<TimeRecord> MatcherTimes;
+  uint64_t TotalNodes = 0, TotalMatches = 0;
+  double TotalParseSeconds = 0, TotalMatchSeconds = 0;
+  size_t PeakHeap = sys::Process::GetMallocUsage();
+  int Status = 0;
+  // Build one translation unit at a time so that the peak heap usage is the
+  // one of the largest, not of all of them together.
+  for (const std::string &File : OptionsParser.getSourcePathList()) {
+    ClangTool Tool(OptionsParser.getCompilations(), File);
+    std::vector<std::unique_ptr<ASTUnit>> ASTs;
+    Start = TimeRecord::getCurrentTime(true);
+    if (Tool.buildASTs(ASTs) != 0)
+      Status = 1;
+    double ParseSeconds = secondsSince(Start);
+    PeakHeap = std::max(PeakHeap, sys::Process::GetMallocUsage());
+    if (ASTs.empty()) {
+      errs() << "error: cannot build the AST of '" << File << "'\n";
+      continue;
+    }
+
+    uint64_t Nodes = 0;
+    uint64_t MatchesBefore = countMatches(Callbacks);
+    double MatchSeconds = 0;
+    for (const auto &AST : ASTs) {
+      ASTContext &Context = AST->getASTContext();
+      NodeCounter Counter;
+      Counter.TraverseDecl(Context.getTranslationUnitDecl());
+      Nodes += Counter.Nodes * Iterations;
+
+      Start = TimeRecord::getCurrentTime(true);
+      for (unsigned I = 0; I < Iterations; ++I) {
+        Finder.matchAST(Context);
+        for (const auto &Record : Records)
+          MatcherTimes[Record.getKey()] += Record.getValue();
+      }
+      MatchSeconds += secondsSince(Start);
+      PeakHeap = std::max(PeakHeap, sys::Process::GetMallocUsage());
+    }
+    uint64_t Matches = countMatches(Callbacks) - MatchesBefore;
+    printThroughput(File, Nodes, Matches, ParseSeconds, MatchSeconds);
+
+    TotalNodes += Nodes;
+    TotalMatches += Matches;
+    TotalParseSeconds += ParseSeconds;
+    TotalMatchSeconds += MatchSeconds;
+  }
+
+  printThroughput("total", TotalNodes, TotalMatches, TotalParseSeconds,
+                  TotalMatchSeconds);
+  outs() << format("peak heap: %.1f MB\n", PeakHeap / (1024.0 * 1024.0));
+
+  if (ProfileMatchers) {
+    // Slowest matchers first.
+    std::sort(Callbacks.begin(), Callbacks.end(),
+              [&](const std::unique_ptr<CountingCallback> &LHS,
+                  const std::unique_ptr<CountingCallback> &RHS) {
+                return MatcherTimes[LHS->Expression].getWallTime() >
+                       MatcherTimes[RHS->Expression].getWallTime();
+              });
+    for (const auto &Callback : Callbacks)
+      outs() << format("%10.3fs %10llu matches  ",
+                       MatcherTimes[Callback->Expression].getWallTime(),
+                       (unsigned long long)Callback->Matches)
+             << Callback->Expression << "\n";
+  }
+
+  return Status;
+}
@@ -20,6 +20,7 @@
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
@@ -33,21 +34,27 @@
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Compression.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/StringSaver.h"
+#include "llvm/Support/ThreadPool.h"
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <initializer_list>
 #include <memory>
 #include <string>
 #include <system_error>
+#include <thread>
 #include <vector>
 
 using namespace llvm;
@@ -85,19 +92,19 @@ static cl::OptionCategory
     ClangOffloadBundlerCategory("clang-offload-bundler options");
 
 static cl::list<std::string>
-    InputFileNames("inputs", cl::CommaSeparated, cl::OneOrMore,
+    InputFileNames("inputs", cl::CommaSeparated, cl::ZeroOrMore,
                    cl::desc("[<input file>,...]"),
                    cl::cat(ClangOffloadBundlerCategory));
 static cl::list<std::string>
-    OutputFileNames("outputs", cl::CommaSeparated, cl::OneOrMore,
+    OutputFileNames("outputs", cl::CommaSeparated, cl::ZeroOrMore,
                     cl::desc("[<output file>,...]"),
                     cl::cat(ClangOffloadBundlerCategory));
 static cl::list<std::string>
-    TargetNames("targets", cl::CommaSeparated, cl::OneOrMore,
+    TargetNames("targets", cl::CommaSeparated, cl::ZeroOrMore,
                 cl::desc("[<offload kind>-<target triple>,...]"),
                 cl::cat(ClangOffloadBundlerCategory));
 static cl::opt<std::string>
-    FilesType("type", cl::Required,
+    FilesType("type",
               cl::desc("Type of the files to be bundled/unbundled.\n"
                        "Current supported types are:\n"
                        "  i   - cpp-output\n"
@@ -126,20 +133,66 @@ static cl::opt<bool> DumpTemporaryFiles(
     cl::desc("Dumps any temporary files created - for testing purposes.\n"),
     cl::init(false), cl::cat(ClangOffloadBundlerCategory));
 
+static cl::opt<bool> Compress(
+    "compress",
+    cl::desc("Compress the bundles of binary and object files and record "
+             "the hash of their contents.\n"),
+    cl::init(false), cl::cat(ClangOffloadBundlerCategory));
+
 static cl::opt<std::string>
     GPUArch("arch",
             cl::desc("GPU compute capability: sm_30, sm_35, etc.\n"),
             cl::cat(ClangOffloadBundlerCategory));
 
+static cl::opt<std::string> BatchFile(
+    "batch",
+    cl::desc("Perform the bundling and unbundling operations listed in a "
+             "file instead, one per line, as the -type, -targets, -inputs, "
+             "-outputs and -unbundle options that describe it.\n"),
+    cl::cat(ClangOffloadBundlerCategory));
+
+static cl::opt<unsigned> BatchJobs(
+    "batch-jobs",
+    cl::desc("Number of operations of the batch to perform in parallel "
+             "(default: the number of hardware threads).\n"),
+    cl::init(0), cl::cat(ClangOffloadBundlerCategory));
+
 /// Magic string that marks the existence of offloading data.
 #define OFFLOAD_BUNDLER_MAGIC_STR "__CLANG_OFFLOAD_BUNDLE__"
 
-/// The index of the host input in the list of inputs.
-static unsigned HostInputIndex = ~0u;
+/// Magic string that marks a compressed bundle.
+#define OFFLOAD_BUNDLER_COMPRESSED_MAGIC_STR "__CLANG_OFFLOAD_BUNDLE_ZLIB__"
 
 /// Path to the current binary.
 static std::string BundlerExecutable;
 
+/// A bundling or unbundling operation. The operations of a batch are
+/// performed in parallel, so each one reports its errors to a stream of its
+/// own.
+struct BundlerConfig {
+  std::vector<std::string> InputFileNames;
+  std::vector<std::string> OutputFileNames;
+  std::vector<std::string> TargetNames;
+  std::string FilesType;
+  bool Unbundle = false;
+
+  /// The index of the host input in the list of inputs.
+  unsigned HostInputIndex = ~0u;
+
+  /// The stream the errors are reported to.
+  raw_ostream *ErrorStream = &llvm::errs();
+
+  raw_ostream &errs() const { return *ErrorStream; }
+};
+
+/// Find the clang used to link the bundles of object files. It is looked up
+/// once for all the operations.
+static const ErrorOr<std::string> &getClangBinary() {
+  static const ErrorOr<std::string> ClangBinary = sys::findProgramByName(
+      "clang", sys::path::parent_path(BundlerExecutable));
+  return ClangBinary;
+}
+
 /// Obtain the offload kind and real machine triple out of the target
 /// information specified by the user.
 static void getOffloadKindAndTriple(StringRef Target, StringRef &OffloadKind,
@@ -163,8 +216,12 @@ static bool hasHostKind(StringRef Target) {
 
 /// Generic file handler interface.
 class FileHandler {
+protected:
+  /// The operation the handler is used for.
+  const BundlerConfig &Cfg;
+
 public:
-  FileHandler() {}
+  FileHandler(const BundlerConfig &Cfg) : Cfg(Cfg) {}
 
   virtual ~FileHandler() {}
 
@@ -183,6 +240,12 @@ public:
   /// Read the current bundle and write the result into the stream \a OS.
   virtual void ReadBundle(raw_fd_ostream &OS, MemoryBuffer &Input) = 0;
 
+  /// Compute the hash of the contents of the current bundle into \a Hash.
+  /// Return false if the handler cannot identify the bundle contents.
+  virtual bool ReadBundleHash(MemoryBuffer &Input, MD5::MD5Result &Hash) {
+    return false;
+  }
+
   /// Write the header of the bundled file to \a OS based on the information
   /// gathered from \a Inputs.
   virtual void WriteHeader(raw_fd_ostream &OS,
@@ -238,7 +301,7 @@ static uint64_t Read8byteIntegerFromBuffer(StringRef Buffer, size_t pos) {
 }
 
 /// Write 8-byte integers to a buffer in little-endian format.
-static void Write8byteIntegerToBuffer(raw_fd_ostream &OS, uint64_t Val) {
+static void Write8byteIntegerToBuffer(raw_ostream &OS, uint64_t Val) {
   for (unsigned i = 0; i < 8; ++i) {
     char Char = (char)(Val & 0xffu);
     OS.write(&Char, 1);
@@ -246,6 +309,80 @@ static void Write8byteIntegerToBuffer(raw_fd_ostream &OS, uint64_t Val) {
   }
 }
 
+/// The bundles of the binary and object file handlers are compressed if
+/// -compress is provided. A compressed bundle has the following format (all
+/// integers are stored in little-endian format):
+///
+/// "OFFLOAD_BUNDLER_COMPRESSED_MAGIC_STR" (ASCII encoding of the string)
+/// SizeOfUncompressedBundle (8-byte integer)
+/// HashOfUncompressedBundle (16-byte MD5 hash)
+/// CompressedBundle (zlib stream)
+///
+/// The hash lets the unbundler recognize identical bundles without
+/// decompressing them.
+static const size_t CompressedBundleHeaderSize =
+    sizeof(OFFLOAD_BUNDLER_COMPRESSED_MAGIC_STR) - 1 + 8 +
+    sizeof(MD5::MD5Result);
+
+/// Return true if \a Bundle is stored in compressed form.
+static bool IsCompressedBundle(StringRef Bundle) {
+  return Bundle.size() >= CompressedBundleHeaderSize &&
+         Bundle.startswith(OFFLOAD_BUNDLER_COMPRESSED_MAGIC_STR);
+}
+
+/// Compute the hash of the uncompressed contents of \a Bundle.
+static void GetBundleHash(StringRef Bundle, MD5::MD5Result &Hash) {
+  if (IsCompressedBundle(Bundle)) {
+    memcpy(Hash, Bundle.data() + CompressedBundleHeaderSize - sizeof(Hash),
+           sizeof(Hash));
+    return;
+  }
+  MD5 Hasher;
+  Hasher.update(Bundle);
+  Hasher.final(Hash);
+}
+
+/// Return the contents of \a Input as they should be stored in the bundled
+/// file, in \a Storage if they have to be compressed.
+static StringRef EncodeBundle(StringRef Input, SmallVectorImpl<char> &Storage) {
+  if (!Compress || !zlib::isAvailable())
+    return Input;
+
+  SmallVector<char, 0> Compressed;
+  if (zlib::compress(Input, Compressed) != zlib::StatusOK)
+    return Input;
+
+  MD5::MD5Result Hash;
+  GetBundleHash(Input, Hash);
+
+  raw_svector_ostream OS(Storage);
+  OS << OFFLOAD_BUNDLER_COMPRESSED_MAGIC_STR;
+  Write8byteIntegerToBuffer(OS, Input.size());
+  OS.write(reinterpret_cast<const char *>(Hash), sizeof(Hash));
+  OS.write(Compressed.data(), Compressed.size());
+  return OS.str();
+}
+
+/// Write the uncompressed contents of \a Bundle into \a OS.
+static void WriteDecodedBundle(raw_fd_ostream &OS, StringRef Bundle,
+                               const BundlerConfig &Cfg) {
+  if (!IsCompressedBundle(Bundle)) {
+    OS.write(Bundle.data(), Bundle.size());
+    return;
+  }
+
+  uint64_t Size = Read8byteIntegerFromBuffer(
+      Bundle, sizeof(OFFLOAD_BUNDLER_COMPRESSED_MAGIC_STR) - 1);
+  SmallVector<char, 0> Uncompressed;
+  if (!zlib::isAvailable())
+    reportError(Cfg.InputFileNames.front(),
+                "compressed bundles are not supported by this build.");
+  if (zlib::uncompress(Bundle.substr(CompressedBundleHeaderSize),
+                       Uncompressed, Size) != zlib::StatusOK)
+    reportError(Cfg.InputFileNames.front(), "Cannot decompress bundle.");
+  OS.write(Uncompressed.data(), Uncompressed.size());
+}
+
 class BinaryFileHandler final : public FileHandler {
   /// Information about the bundles extracted from the header.
   struct BundleInfo final {
@@ -264,8 +401,16 @@ class BinaryFileHandler final : public FileHandler {
   /// Iterator for the bundle information that is being read.
   StringMap<BundleInfo>::iterator CurBundleInfo;
 
+  /// Contents of the bundles to be written, in the order of the inputs, and
+  /// the storage of the ones that are compressed.
+  SmallVector<StringRef, 4> EncodedBundles;
+  SmallVector<SmallVector<char, 0>, 4> EncodedBundlesStorage;
+
+  /// Number of bundles written so far.
+  unsigned NumberOfWrittenBundles = 0;
+
 public:
-  BinaryFileHandler() : FileHandler() {}
+  BinaryFileHandler(const BundlerConfig &Cfg) : FileHandler(Cfg) {}
 
   ~BinaryFileHandler() final {}
 
@@ -347,11 +492,20 @@ public:
     ++CurBundleInfo;
   }
 
-  void ReadBundle(raw_fd_ostream &OS, MemoryBuffer &Input) final {
+  /// Return the current bundle as stored in \a Input.
+  StringRef getCurrentBundle(MemoryBuffer &Input) const {
     assert(CurBundleInfo != BundlesInfo.end() && "Invalid reader info!");
-    StringRef FC = Input.getBuffer();
-    OS.write(FC.data() + CurBundleInfo->second.Offset,
-             CurBundleInfo->second.Size);
+    return Input.getBuffer().substr(CurBundleInfo->second.Offset,
+                                    CurBundleInfo->second.Size);
+  }
+
+  void ReadBundle(raw_fd_ostream &OS, MemoryBuffer &Input) final {
+    WriteDecodedBundle(OS, getCurrentBundle(Input), Cfg);
+  }
+
+  bool ReadBundleHash(MemoryBuffer &Input, MD5::MD5Result &Hash) final {
+    GetBundleHash(getCurrentBundle(Input), Hash);
+    return true;
   }
 
   void WriteHeader(raw_fd_ostream &OS,
@@ -362,7 +516,13 @@ public:
     HeaderSize += sizeof(OFFLOAD_BUNDLER_MAGIC_STR) - 1;
     HeaderSize += 8; // Number of Bundles
 
-    for (auto &T : TargetNames) {
+    // Encode the bundles now, as their sizes are part of the header.
+    EncodedBundlesStorage.resize(Inputs.size());
+    for (unsigned I = 0, E = Inputs.size(); I < E; ++I)
+      EncodedBundles.push_back(
+          EncodeBundle(Inputs[I]->getBuffer(), EncodedBundlesStorage[I]));
+
+    for (auto &T : Cfg.TargetNames) {
       HeaderSize += 3 * 8; // Bundle offset, Size of bundle and size of triple.
       HeaderSize += T.size(); // The triple.
     }
@@ -370,16 +530,16 @@ public:
     // Write to the buffer the header.
     OS << OFFLOAD_BUNDLER_MAGIC_STR;
 
-    Write8byteIntegerToBuffer(OS, TargetNames.size());
+    Write8byteIntegerToBuffer(OS, Cfg.TargetNames.size());
 
     unsigned Idx = 0;
-    for (auto &T : TargetNames) {
-      MemoryBuffer &MB = *Inputs[Idx++].get();
+    for (auto &T : Cfg.TargetNames) {
+      StringRef Bundle = EncodedBundles[Idx++];
       // Bundle offset.
       Write8byteIntegerToBuffer(OS, HeaderSize);
       // Size of the bundle (adds to the next bundle's offset)
-      Write8byteIntegerToBuffer(OS, MB.getBufferSize());
-      HeaderSize += MB.getBufferSize();
+      Write8byteIntegerToBuffer(OS, Bundle.size());
+      HeaderSize += Bundle.size();
       // Size of the triple
       Write8byteIntegerToBuffer(OS, T.size());
       // Triple
@@ -394,7 +554,8 @@ public:
   }
 
   void WriteBundle(raw_fd_ostream &OS, MemoryBuffer &Input) final {
-    OS.write(Input.getBufferStart(), Input.getBufferSize());
+    StringRef Bundle = EncodedBundles[NumberOfWrittenBundles++];
+    OS.write(Bundle.data(), Bundle.size());
   }
 };
 
@@ -461,8 +622,8 @@ class ObjectFileHandler final : public FileHandler {
   section_iterator NextSection;
 
 public:
-  ObjectFileHandler(std::unique_ptr<ObjectFile> ObjIn)
-      : FileHandler(), Obj(std::move(ObjIn)),
+  ObjectFileHandler(const BundlerConfig &Cfg, std::unique_ptr<ObjectFile> ObjIn)
+      : FileHandler(Cfg), Obj(std::move(ObjIn)),
         CurrentSection(Obj->section_begin()),
         NextSection(Obj->section_begin()) {}
 
@@ -500,19 +661,27 @@ public:
     if (Content.size() < 2)
       OS.write(Input.getBufferStart(), Input.getBufferSize());
     else
-      OS.write(Content.data(), Content.size());
+      WriteDecodedBundle(OS, Content, Cfg);
+  }
+
+  bool ReadBundleHash(MemoryBuffer &Input, MD5::MD5Result &Hash) final {
+    StringRef Content;
+    CurrentSection->getContents(Content);
+
+    GetBundleHash(Content.size() < 2 ? Input.getBuffer() : Content, Hash);
+    return true;
   }
 
   void WriteHeader(raw_fd_ostream &OS,
                    ArrayRef<std::unique_ptr<MemoryBuffer>> Inputs) final {
-    assert(HostInputIndex != ~0u && "Host input index not defined.");
+    assert(Cfg.HostInputIndex != ~0u && "Host input index not defined.");
 
     // Record number of inputs.
     NumberOfInputs = Inputs.size();
 
     // Create an LLVM module to have the content we need to bundle.
     auto *M = new Module("clang-offload-bundle", VMContext);
-    M->setTargetTriple(getTriple(TargetNames[HostInputIndex]));
+    M->setTargetTriple(getTriple(Cfg.TargetNames[Cfg.HostInputIndex]));
     AuxModule.reset(M);
   }
 
@@ -527,7 +696,7 @@ public:
   bool WriteBundleEnd(raw_fd_ostream &OS, StringRef TargetTriple) final {
     assert(NumberOfProcessedInputs <= NumberOfInputs &&
            "Processing more inputs that actually exist!");
-    assert(HostInputIndex != ~0u && "Host input index not defined.");
+    assert(Cfg.HostInputIndex != ~0u && "Host input index not defined.");
 
     // If this is not the last output, we don't have to do anything.
     if (NumberOfProcessedInputs != NumberOfInputs)
@@ -538,39 +707,38 @@ public:
     SmallString<128> BitcodeFileName;
     if (sys::fs::createTemporaryFile("clang-offload-bundler", "bc",
                                      BitcodeFileName)) {
-      errs() << "error: unable to create temporary file.\n";
+      Cfg.errs() << "error: unable to create temporary file.\n";
       return true;
     }
 
     // Dump the contents of the temporary file if that was requested.
     if (DumpTemporaryFiles) {
-      errs() << ";\n; Object file bundler IR file.\n;\n";
+      Cfg.errs() << ";\n; Object file bundler IR file.\n;\n";
       AuxModule.get()->dump();
     }
 
     // Find clang in order to create the bundle binary.
-    StringRef Dir = sys::path::parent_path(BundlerExecutable);
-
-    auto ClangBinary = sys::findProgramByName("clang", Dir);
+    const ErrorOr<std::string> &ClangBinary = getClangBinary();
     if (ClangBinary.getError()) {
       // Remove bitcode file.
       sys::fs::remove(BitcodeFileName);
 
-      errs() << "error: unable to find 'clang' in path.\n";
+      Cfg.errs() << "error: unable to find 'clang' in path.\n";
       return true;
     }
 
     // Do the incremental linking. We write to the output file directly. So, we
     // close it and use the name to pass down to clang.
     OS.close();
-    SmallString<128> TargetName = getTriple(TargetNames[HostInputIndex]);
+    SmallString<128> TargetName =
+        getTriple(Cfg.TargetNames[Cfg.HostInputIndex]);
     const char *ClangArgs[] = {"clang",
                                "-r",
                                "-target",
                                TargetName.c_str(),
                                "-o",
-                               OutputFileNames.front().c_str(),
-                               InputFileNames[HostInputIndex].c_str(),
+                               Cfg.OutputFileNames.front().c_str(),
+                               Cfg.InputFileNames[Cfg.HostInputIndex].c_str(),
                                BitcodeFileName.c_str(),
                                "-nostdlib",
                                nullptr};
@@ -578,17 +746,17 @@ public:
     // If the user asked for the commands to be printed out, we do that instead
     // of executing it.
     if (PrintExternalCommands) {
-      errs() << "\"" << ClangBinary.get() << "\"";
+      Cfg.errs() << "\"" << ClangBinary.get() << "\"";
       for (unsigned I = 1; ClangArgs[I]; ++I)
-        errs() << " \"" << ClangArgs[I] << "\"";
-      errs() << "\n";
+        Cfg.errs() << " \"" << ClangArgs[I] << "\"";
+      Cfg.errs() << "\n";
     } else {
       // Write the bitcode contents to the temporary file.
       {
         std::error_code EC;
         raw_fd_ostream BitcodeFile(BitcodeFileName, EC, sys::fs::F_None);
         if (EC) {
-          errs() << "error: unable to open temporary file.\n";
+          Cfg.errs() << "error: unable to open temporary file.\n";
           return true;
         }
         WriteBitcodeToFile(AuxModule.get(), BitcodeFile);
@@ -600,7 +768,7 @@ public:
       sys::fs::remove(BitcodeFileName);
 
       if (Failed) {
-        errs() << "error: incremental linking by external tool failed.\n";
+        Cfg.errs() << "error: incremental linking by external tool failed.\n";
         return true;
       }
     }
@@ -619,16 +787,19 @@ public:
     // Create the constant with the content of the section. For the input we are
     // bundling into (the host input), this is just a place-holder, so a single
     // byte is sufficient.
-    assert(HostInputIndex != ~0u && "Host input index undefined??");
+    assert(Cfg.HostInputIndex != ~0u && "Host input index undefined??");
     Constant *Content;
-    if (NumberOfProcessedInputs == HostInputIndex + 1) {
+    if (NumberOfProcessedInputs == Cfg.HostInputIndex + 1) {
       uint8_t Byte[] = {0};
       Content = ConstantDataArray::get(VMContext, Byte);
-    } else
+    } else {
+      SmallVector<char, 0> Storage;
+      StringRef Bundle = EncodeBundle(Input.getBuffer(), Storage);
       Content = ConstantDataArray::get(
-          VMContext, ArrayRef<uint8_t>(reinterpret_cast<const uint8_t *>(
-                                           Input.getBufferStart()),
-                                       Input.getBufferSize()));
+          VMContext,
+          ArrayRef<uint8_t>(reinterpret_cast<const uint8_t *>(Bundle.data()),
+                            Bundle.size()));
+    }
 
     // Create the global in the desired section. We don't want these globals in
     // the symbol table, so we mark them private.
@@ -727,8 +898,8 @@ protected:
   }
 
 public:
-  TextFileHandler(StringRef Comment)
-      : FileHandler(), Comment(Comment), ReadChars(0) {
+  TextFileHandler(const BundlerConfig &Cfg, StringRef Comment)
+      : FileHandler(Cfg), Comment(Comment), ReadChars(0) {
     BundleStartString =
         "\n" + Comment.str() + " " OFFLOAD_BUNDLER_MAGIC_STR "__START__ ";
     BundleEndString =
@@ -739,7 +910,8 @@ public:
 /// Return an appropriate object file handler. We use the specific object
 /// handler if we know how to deal with that format, otherwise we use a default
 /// binary file handler.
-static FileHandler *CreateObjectFileHandler(MemoryBuffer &FirstInput) {
+static FileHandler *CreateObjectFileHandler(const BundlerConfig &Cfg,
+                                           MemoryBuffer &FirstInput) {
   // Check if the input file format is one that we know how to deal with.
   Expected<std::unique_ptr<Binary>> BinaryOrErr = createBinary(FirstInput);
 
@@ -748,7 +920,7 @@ static FileHandler *CreateObjectFileHandler(MemoryBuffer &FirstInput) {
     // We don't really care about the error (we just consume it), if we could
     // not get a valid device binary object we use the default binary handler.
     consumeError(BinaryOrErr.takeError());
-    return new BinaryFileHandler();
+    return new BinaryFileHandler(Cfg);
   }
 
   // We only support regular object files. If this is not an object file,
@@ -758,75 +930,80 @@ static FileHandler *CreateObjectFileHandler(MemoryBuffer &FirstInput) {
       dyn_cast<ObjectFile>(BinaryOrErr.get().release()));
 
   if (!Obj)
-    return new BinaryFileHandler();
+    return new BinaryFileHandler(Cfg);
 
-  return new ObjectFileHandler(std::move(Obj));
+  return new ObjectFileHandler(Cfg, std::move(Obj));
 }
 
-static FileHandler *GetObjectFileHandler(MemoryBuffer &FirstInput) {
+static FileHandler *GetObjectFileHandler(const BundlerConfig &Cfg,
+                                         MemoryBuffer &FirstInput) {
   // Check if the input file format is one that we know how to deal with.
   Expected<std::unique_ptr<Binary>> BinaryOrErr = createBinary(FirstInput);
   assert(BinaryOrErr && "error: Failed to open the input as a known binary");
   std::unique_ptr<ObjectFile> Obj(
       dyn_cast<ObjectFile>(BinaryOrErr.get().release()));
   assert(Obj && "error: Cannot create object file from binary.");
-  return new ObjectFileHandler(std::move(Obj));
+  return new ObjectFileHandler(Cfg, std::move(Obj));
 }
 
 /// Return an appropriate handler given the input files and options.
-static FileHandler *CreateFileHandler(MemoryBuffer &FirstInput) {
-  if (FilesType == "i")
-    return new TextFileHandler(/*Comment=*/"//");
-  if (FilesType == "ii")
-    return new TextFileHandler(/*Comment=*/"//");
-  if (FilesType == "ll")
-    return new TextFileHandler(/*Comment=*/";");
-  if (FilesType == "bc")
-    return new BinaryFileHandler();
-  if (FilesType == "s")
-    return new TextFileHandler(/*Comment=*/"#");
-  if (FilesType == "o")
-    return CreateObjectFileHandler(FirstInput);
-  if (FilesType == "gch")
-    return new BinaryFileHandler();
-  if (FilesType == "ast")
-    return new BinaryFileHandler();
-
-  errs() << "error: invalid file type specified.\n";
+static FileHandler *CreateFileHandler(const BundlerConfig &Cfg,
+                                      MemoryBuffer &FirstInput) {
+  if (Cfg.FilesType == "i")
+    return new TextFileHandler(Cfg, /*Comment=*/"//");
+  if (Cfg.FilesType == "ii")
+    return new TextFileHandler(Cfg, /*Comment=*/"//");
+  if (Cfg.FilesType == "ll")
+    return new TextFileHandler(Cfg, /*Comment=*/";");
+  if (Cfg.FilesType == "bc")
+    return new BinaryFileHandler(Cfg);
+  if (Cfg.FilesType == "s")
+    return new TextFileHandler(Cfg, /*Comment=*/"#");
+  if (Cfg.FilesType == "o")
+    return CreateObjectFileHandler(Cfg, FirstInput);
+  if (Cfg.FilesType == "gch")
+    return new BinaryFileHandler(Cfg);
+  if (Cfg.FilesType == "ast")
+    return new BinaryFileHandler(Cfg);
+
+  Cfg.errs() << "error: invalid file type specified.\n";
   return nullptr;
 }
 
 /// Bundle the files. Return true if an error was found.
-static bool BundleFiles() {
+static bool BundleFiles(const BundlerConfig &Cfg) {
   std::error_code EC;
 
   // Create output file.
-  raw_fd_ostream OutputFile(OutputFileNames.front(), EC, sys::fs::F_None);
+  raw_fd_ostream OutputFile(Cfg.OutputFileNames.front(), EC,
+                            sys::fs::F_None);
 
   if (EC) {
-    errs() << "error: Can't open file " << OutputFileNames.front() << ".\n";
+    Cfg.errs() << "error: Can't open file " << Cfg.OutputFileNames.front()
+               << ".\n";
     return true;
   }
 
   // Open input files.
   std::vector<std::unique_ptr<MemoryBuffer>> InputBuffers(
-      InputFileNames.size());
+      Cfg.InputFileNames.size());
 
   unsigned Idx = 0;
-  for (auto &I : InputFileNames) {
+  for (auto &I : Cfg.InputFileNames) {
     ErrorOr<std::unique_ptr<MemoryBuffer>> CodeOrErr =
         MemoryBuffer::getFileOrSTDIN(I);
     if (std::error_code EC = CodeOrErr.getError()) {
-      errs() << "error: Can't open file " << I << ": " << EC.message() << "\n";
+      Cfg.errs() << "error: Can't open file " << I << ": " << EC.message()
+                 << "\n";
       return true;
     }
     InputBuffers[Idx++] = std::move(CodeOrErr.get());
   }
 
   // Get the file handler. We use the host buffer as reference.
-  assert(HostInputIndex != ~0u && "Host input index undefined??");
+  assert(Cfg.HostInputIndex != ~0u && "Host input index undefined??");
   std::unique_ptr<FileHandler> FH;
-  FH.reset(CreateFileHandler(*InputBuffers[HostInputIndex].get()));
+  FH.reset(CreateFileHandler(Cfg, *InputBuffers[Cfg.HostInputIndex].get()));
 
   // Quit if we don't have a handler.
   if (!FH.get())
@@ -838,7 +1015,7 @@ static bool BundleFiles() {
   // Write all bundles along with the start/end markers. If an error was found
   // writing the end of the bundle component, abort the bundle writing.
   auto Input = InputBuffers.begin();
-  for (auto &Triple : TargetNames) {
+  for (auto &Triple : Cfg.TargetNames) {
     FH.get()->WriteBundleStart(OutputFile, Triple);
     FH.get()->WriteBundle(OutputFile, *Input->get());
     if (FH.get()->WriteBundleEnd(OutputFile, Triple))
@@ -848,31 +1025,46 @@ static bool BundleFiles() {
   return false;
 }
 
-// Unbundle the files. Return true if an error was found.
-static bool UnbundleFiles(StringRef ArchiveFileName="",
-      std::vector<std::string> *NewOutputFileNames=nullptr) {
-  // Get input file name
-  StringRef InputFile = InputFileNames.front();
-  if (ArchiveFileName != "")
-    InputFile = ArchiveFileName;
+/// Device bundles found so far in the members of an archive, used to skip
+/// identical device images.
+struct DuplicateBundlesInfo {
+  /// The target and hash of each of the bundles seen so far.
+  StringSet<> SeenBundles;
+  /// Output files that were not written because their bundle was seen before.
+  StringSet<> SkippedOutputs;
+};
 
-  // Open Input file.
-  ErrorOr<std::unique_ptr<MemoryBuffer>> CodeOrErr =
-      MemoryBuffer::getFileOrSTDIN(InputFile);
-  if (std::error_code EC = CodeOrErr.getError()) {
-    errs() << "error: Can't open file " << InputFile << ": "
-           << EC.message() << "\n";
-    return true;
+// Unbundle the files. If \p ArchiveMember is provided, the bundles are read
+// from that member of the input archive instead of the input file. If
+// \p Duplicates is provided, device bundles identical to one recorded there
+// are not written out. Return true if an error was found.
+static bool UnbundleFiles(const BundlerConfig &Cfg,
+      MemoryBuffer *ArchiveMember=nullptr,
+      DuplicateBundlesInfo *Duplicates=nullptr) {
+  // Open Input file. The bundles are copied straight from the mapped file, so
+  // there is no need for a null terminator that could prevent the mapping.
+  std::unique_ptr<MemoryBuffer> InputBuffer;
+  if (!ArchiveMember) {
+    StringRef InputFile = Cfg.InputFileNames.front();
+    ErrorOr<std::unique_ptr<MemoryBuffer>> CodeOrErr =
+        MemoryBuffer::getFileOrSTDIN(InputFile, /*FileSize=*/-1,
+                                     /*RequiresNullTerminator=*/false);
+    if (std::error_code EC = CodeOrErr.getError()) {
+      Cfg.errs() << "error: Can't open file " << InputFile << ": "
+                 << EC.message() << "\n";
+      return true;
+    }
+    InputBuffer = std::move(CodeOrErr.get());
   }
 
-  MemoryBuffer &Input = *CodeOrErr.get();
+  MemoryBuffer &Input = ArchiveMember ? *ArchiveMember : *InputBuffer;
 
   // Select the right files handler.
   std::unique_ptr<FileHandler> FH;
-  if (ArchiveFileName != "")
-    FH.reset(GetObjectFileHandler(Input));
+  if (ArchiveMember)
+    FH.reset(GetObjectFileHandler(Cfg, Input));
   else
-    FH.reset(CreateFileHandler(Input));
+    FH.reset(CreateFileHandler(Cfg, Input));
 
   // Quit if we don't have a handler.
   if (!FH.get())
@@ -883,19 +1075,8 @@ static bool UnbundleFiles(StringRef ArchiveFileName="",
 
   // Create a work list that consist of the map triple/output file.
   StringMap<StringRef> Worklist;
-  if (NewOutputFileNames) {
-    auto Output = NewOutputFileNames->begin();
-    for (auto &Triple : TargetNames) {
-      Worklist[Triple] = *Output;
-      ++Output;
-    }
-  } else {
-    auto Output = OutputFileNames.begin();
-    for (auto &Triple : TargetNames) {
-      Worklist[Triple] = *Output;
-      ++Output;
-    }
-  }
+  for (unsigned I = 0, E = Cfg.TargetNames.size(); I != E; ++I)
+    Worklist[Cfg.TargetNames[I]] = Cfg.OutputFileNames[I];
 
   // Read all the bundles that are in the work list. If we find no bundles we
   // assume the file is meant for the host target.
@@ -914,12 +1095,27 @@ static bool UnbundleFiles(StringRef ArchiveFileName="",
       continue;
     }
 
+    // Skip device bundles whose contents were already extracted.
+    MD5::MD5Result Hash;
+    if (Duplicates && !hasHostKind(CurTriple) &&
+        FH.get()->ReadBundleHash(Input, Hash)) {
+      SmallString<32> Key;
+      MD5::stringifyResult(Hash, Key);
+      Key += CurTriple;
+      if (!Duplicates->SeenBundles.insert(Key).second) {
+        Duplicates->SkippedOutputs.insert(Output->second);
+        FH.get()->ReadBundleEnd(Input);
+        Worklist.erase(Output);
+        continue;
+      }
+    }
+
     // Check if the output file can be opened and copy the bundle to it.
     std::error_code EC;
     raw_fd_ostream OutputFile(Output->second, EC, sys::fs::F_None);
     if (EC) {
-      errs() << "error: Can't open file " << Output->second << ": "
-             << EC.message() << "\n";
+      Cfg.errs() << "error: Can't open file " << Output->second << ": "
+                 << EC.message() << "\n";
       return true;
     }
     FH.get()->ReadBundle(OutputFile, Input);
@@ -933,13 +1129,13 @@ static bool UnbundleFiles(StringRef ArchiveFileName="",
 
   // If no bundles were found, assume the input file is the host bundle and
   // create empty files for the remaining targets.
-  if (Worklist.size() == TargetNames.size()) {
+  if (Worklist.size() == Cfg.TargetNames.size()) {
     for (auto &E : Worklist) {
       std::error_code EC;
       raw_fd_ostream OutputFile(E.second, EC, sys::fs::F_None);
       if (EC) {
-        errs() << "error: Can't open file " << E.second << ": " << EC.message()
-               << "\n";
+        Cfg.errs() << "error: Can't open file " << E.second << ": "
+                   << EC.message() << "\n";
         return true;
       }
 
@@ -952,7 +1148,7 @@ static bool UnbundleFiles(StringRef ArchiveFileName="",
 
   // If we found elements, we emit an error if none of those were for the host.
   if (!FoundHostBundle) {
-    errs() << "error: Can't find bundle for the host target\n";
+    Cfg.errs() << "error: Can't find bundle for the host target\n";
     return true;
   }
 
@@ -961,8 +1157,8 @@ static bool UnbundleFiles(StringRef ArchiveFileName="",
     std::error_code EC;
     raw_fd_ostream OutputFile(E.second, EC, sys::fs::F_None);
     if (EC) {
-      errs() << "error: Can't open file " << E.second << ": "  << EC.message()
-             << "\n";
+      Cfg.errs() << "error: Can't open file " << E.second << ": "
+                 << EC.message() << "\n";
       return true;
     }
   }
@@ -981,55 +1177,48 @@ std::string AssembleArgString(
 }
 
 // Unbundle the files. Return true if archive was handled.
-static bool HandleArchiveFiles() {
+static bool HandleArchiveFiles(const BundlerConfig &Cfg) {
   // Only handle archives, nothing else.
-  if (FilesType != "a") {
+  if (Cfg.FilesType != "a") {
     return false;
   }
 
   // Get input file name, in this case an archive.
-  StringRef InputFileName = InputFileNames.front();
+  StringRef InputFileName = Cfg.InputFileNames.front();
   bool Failed;
 
-  // Create a folder that is library specific, where the library
-  // is extracted. When linking with nvlink use all the cubin files
-  // in the folder of the static library the user is trying to link
-  // against.
-
-  // Extract object files from archive
-  const char *ExtractArchiveArgs[] = {"ar", "x",
-                                      InputFileName.str().c_str(),
-                                      nullptr};
+  // The archive is mapped once and its members are unbundled in place, so
+  // there is no need to extract them to the file system first.
   auto ArBinary = sys::findProgramByName("ar");
-  Failed = sys::ExecuteAndWait(ArBinary.get(), ExtractArchiveArgs);
-  if (Failed) {
-    errs() << "error: 1 extracting the archived object files failed.\n";
-    return true;
-  }
 
   // Open Input file.
   ErrorOr<std::unique_ptr<MemoryBuffer>> CodeOrErr =
-      MemoryBuffer::getFileOrSTDIN(InputFileName);
+      MemoryBuffer::getFileOrSTDIN(InputFileName, /*FileSize=*/-1,
+                                   /*RequiresNullTerminator=*/false);
   if (std::error_code EC = CodeOrErr.getError()) {
-    errs() << "error: Can't open file " << InputFileName << ": "
-           << EC.message() << "\n";
+    Cfg.errs() << "error: Can't open file " << InputFileName << ": "
+               << EC.message() << "\n";
     return true;
   }
 
-  Expected<OwningBinary<Binary>> BinaryOrErr = createBinary(InputFileName);
+  Expected<std::unique_ptr<Binary>> BinaryOrErr =
+      createBinary(CodeOrErr.get()->getMemBufferRef());
   if (!BinaryOrErr) {
     auto EC = errorToErrorCode(BinaryOrErr.takeError());
     reportError(InputFileName, EC);
     return false;
   }
-  Binary &ArchiveBinary = *BinaryOrErr.get().getBinary();
+  Binary &ArchiveBinary = *BinaryOrErr.get();
   const Archive *Arc = dyn_cast<Archive>(&ArchiveBinary);
   if (!Arc) {
     reportError(InputFileName, "Cannot retrieve archive from provided Binary file.");
     return false;
   }
 
+  // The name and contents of each object file in the archive. The contents
+  // refer to the mapped archive.
   std::vector<std::string> *ArchiveObjectNames = new std::vector<std::string>();
+  std::vector<MemoryBufferRef> ArchiveObjects;
   Error Err = Error::success();
   for (auto &ObjFile : Arc->children(Err)) {
     Expected<std::unique_ptr<Binary>> ChildOrErr = ObjFile.getAsBinary();
@@ -1046,15 +1235,20 @@ static bool HandleArchiveFiles() {
       continue;
     }
 
-    if (ObjectFile *Obj = dyn_cast<ObjectFile>(&*ChildOrErr.get()))
+    if (ObjectFile *Obj = dyn_cast<ObjectFile>(&*ChildOrErr.get())) {
       ArchiveObjectNames->push_back(Obj->getFileName().split(".").first.str());
+      ArchiveObjects.push_back(Obj->getMemoryBufferRef());
+    }
   }
   error(std::move(Err));
 
+  // Identical device images are only added once to the device libraries.
+  DuplicateBundlesInfo Duplicates;
+
   for(unsigned i=0; i<ArchiveObjectNames->size(); i++) {
     std::vector<std::string> *NewOutputFileNames =
         new std::vector<std::string>();
-    for (StringRef Target : TargetNames) {
+    for (StringRef Target : Cfg.TargetNames) {
       SmallString<256> Buffer;
       llvm::raw_svector_ostream OutFileName(Buffer);
       OutFileName << (*ArchiveObjectNames)[i] << "-" << Target;
@@ -1074,11 +1268,11 @@ static bool HandleArchiveFiles() {
     //   ++Output;
     // }
 
-    SmallString<256> Buffer;
-    llvm::raw_svector_ostream InputFileName(Buffer);
-    InputFileName << (*ArchiveObjectNames)[i] << ".o";
-    UnbundleFiles(InputFileName.str(),
-                  NewOutputFileNames);
+    std::unique_ptr<MemoryBuffer> ArchiveMember = MemoryBuffer::getMemBuffer(
+        ArchiveObjects[i], /*RequiresNullTerminator=*/false);
+    BundlerConfig MemberCfg = Cfg;
+    MemberCfg.OutputFileNames = *NewOutputFileNames;
+    UnbundleFiles(MemberCfg, ArchiveMember.get(), &Duplicates);
 
     // Find fatbinary binary
     auto FatBinary = sys::findProgramByName("fatbinary");
@@ -1087,6 +1281,11 @@ static bool HandleArchiveFiles() {
     unsigned count = 0;
     // Copy unbundled files to temp lib folder.
     for(StringRef OutputFileName: *NewOutputFileNames) {
+      if (Duplicates.SkippedOutputs.count(OutputFileName)) {
+        count++;
+        continue;
+      }
+
       // cubin files need to handled differently: we need to
       // invoke the fatbinary executable for each cubin and create
       // a fatbin file which needs to be wrapped in a C wrapper.
@@ -1114,7 +1313,7 @@ static bool HandleArchiveFiles() {
             nullptr};
         Failed = sys::ExecuteAndWait(FatBinary.get(), GenAndWrapFatbinArgs);
         if (Failed) {
-          errs() << "error: generating and wrapping fatbin.\n";
+          Cfg.errs() << "error: generating and wrapping fatbin.\n";
         }
 
         // Create fatbin object file (.fatbin.o).
@@ -1129,16 +1328,16 @@ static bool HandleArchiveFiles() {
             ObjectFileName.c_str(), nullptr};
         Failed = sys::ExecuteAndWait(ClangBinary.get(), WrapFatbinObjArgs);
         if (Failed) {
-          errs() << "error: generating fatbin object.\n";
+          Cfg.errs() << "error: generating fatbin object.\n";
         }
 
         // Add newly formed fatbin object to target specific archive
         const char *AddToArchiveArgs[] = {"ar", "rcs",
-            OutputFileNames[count].c_str(),
+            Cfg.OutputFileNames[count].c_str(),
             ObjectFileName.c_str(), nullptr};
         Failed = sys::ExecuteAndWait(ArBinary.get(), AddToArchiveArgs);
         if (Failed) {
-          errs() << "error: adding object to static library.\n";
+          Cfg.errs() << "error: adding object to static library.\n";
         }
 
         llvm::sys::fs::remove(ObjectFileName);
@@ -1147,12 +1346,12 @@ static bool HandleArchiveFiles() {
       } else {
         // Add unbundled object to static library
         const char *AddToArchiveArgs[] = {"ar", "rcs",
-            OutputFileNames[count].c_str(),
+            Cfg.OutputFileNames[count].c_str(),
             OutputFileName.str().c_str(),
             nullptr};
         Failed = sys::ExecuteAndWait(ArBinary.get(), AddToArchiveArgs);
         if (Failed) {
-          errs() << "error: adding object to static library.\n";
+          Cfg.errs() << "error: adding object to static library.\n";
         }
       }
 
@@ -1161,55 +1360,37 @@ static bool HandleArchiveFiles() {
 
       count++;
     }
-
-    // Remove original object file.
-    llvm::sys::fs::remove(InputFileName.str());
   }
 
   // Return true to say we are all done!
   return true;
 }
 
-static void PrintVersion() {
-  raw_ostream &OS = outs();
-  OS << clang::getClangToolFullVersion("clang-offload-bundler") << '\n';
-}
-
-int main(int argc, const char **argv) {
-  sys::PrintStackTraceOnErrorSignal(argv[0]);
-
-  cl::HideUnrelatedOptions(ClangOffloadBundlerCategory);
-  cl::SetVersionPrinter(PrintVersion);
-  cl::ParseCommandLineOptions(
-      argc, argv,
-      "A tool to bundle several input files of the specified type <type> \n"
-      "referring to the same source file but different targets into a single \n"
-      "one. The resulting file can also be unbundled into different files by \n"
-      "this tool if -unbundle is provided.\n");
-
-  if (Help)
-    cl::PrintHelpMessage();
-
+/// Check that the operation \p Cfg is well formed, and find its host input.
+/// Return true if an error was found.
+static bool CheckConfig(BundlerConfig &Cfg) {
   bool Error = false;
-  if (Unbundle) {
-    if (InputFileNames.size() != 1) {
+  if (Cfg.Unbundle) {
+    if (Cfg.InputFileNames.size() != 1) {
       Error = true;
-      errs() << "error: only one input file supported in unbundling mode.\n";
+      Cfg.errs()
+          << "error: only one input file supported in unbundling mode.\n";
     }
-    if (OutputFileNames.size() != TargetNames.size()) {
+    if (Cfg.OutputFileNames.size() != Cfg.TargetNames.size()) {
       Error = true;
-      errs() << "error: number of output files and targets should match in "
-                "unbundling mode.\n";
+      Cfg.errs() << "error: number of output files and targets should match "
+                    "in unbundling mode.\n";
     }
   } else {
-    if (OutputFileNames.size() != 1) {
+    if (Cfg.OutputFileNames.size() != 1) {
       Error = true;
-      errs() << "error: only one output file supported in bundling mode.\n";
+      Cfg.errs()
+          << "error: only one output file supported in bundling mode.\n";
     }
-    if (InputFileNames.size() != TargetNames.size()) {
+    if (Cfg.InputFileNames.size() != Cfg.TargetNames.size()) {
       Error = true;
-      errs() << "error: number of input files and targets should match in "
-                "bundling mode.\n";
+      Cfg.errs() << "error: number of input files and targets should match "
+                    "in bundling mode.\n";
     }
   }
 
@@ -1217,7 +1398,7 @@ int main(int argc, const char **argv) {
   // have exactly one host target.
   unsigned Index = 0u;
   unsigned HostTargetNum = 0u;
-  for (StringRef Target : TargetNames) {
+  for (StringRef Target : Cfg.TargetNames) {
     StringRef Kind;
     StringRef Triple;
     getOffloadKindAndTriple(Target, Kind, Triple);
@@ -1235,19 +1416,19 @@ int main(int argc, const char **argv) {
 
     if (!KindIsValid || !TripleIsValid) {
       Error = true;
-      errs() << "error: invalid target '" << Target << "'";
+      Cfg.errs() << "error: invalid target '" << Target << "'";
 
       if (!KindIsValid)
-        errs() << ", unknown offloading kind '" << Kind << "'";
+        Cfg.errs() << ", unknown offloading kind '" << Kind << "'";
       if (!TripleIsValid)
-        errs() << ", unknown target triple '" << Triple << "'";
-      errs() << ".\n";
+        Cfg.errs() << ", unknown target triple '" << Triple << "'";
+      Cfg.errs() << ".\n";
     }
 
     if (KindIsValid && Kind == "host") {
       ++HostTargetNum;
       // Save the index of the input that refers to the host.
-      HostInputIndex = Index;
+      Cfg.HostInputIndex = Index;
     }
 
     ++Index;
@@ -1255,19 +1436,167 @@ int main(int argc, const char **argv) {
 
   if (HostTargetNum != 1) {
     Error = true;
-    errs() << "error: expecting exactly one host target but got "
-           << HostTargetNum << ".\n";
+    Cfg.errs() << "error: expecting exactly one host target but got "
+               << HostTargetNum << ".\n";
   }
 
-  if (Error)
-    return 1;
+  return Error;
+}
+
+/// Perform the operation \p Cfg. Return true if an error was found.
+static bool RunOperation(const BundlerConfig &Cfg) {
+  if (Cfg.Unbundle && HandleArchiveFiles(Cfg))
+    return false;
+
+  return Cfg.Unbundle ? UnbundleFiles(Cfg) : BundleFiles(Cfg);
+}
+
+/// Read the operation described by a line of the batch file into \p Cfg.
+/// Return true if an error was found.
+static bool ParseBatchLine(StringRef Line, BundlerConfig &Cfg) {
+  BumpPtrAllocator Alloc;
+  StringSaver Saver(Alloc);
+  SmallVector<const char *, 8> Args;
+  cl::TokenizeGNUCommandLine(Line, Saver, Args);
+
+  auto SplitList = [](StringRef Value, std::vector<std::string> &List) {
+    SmallVector<StringRef, 4> Items;
+    Value.split(Items, ',');
+    List.assign(Items.begin(), Items.end());
+  };
+
+  for (StringRef Arg : Args) {
+    StringRef Option = Arg;
+    Option.consume_front("-");
+    Option.consume_front("-");
+    StringRef Name, Value;
+    std::tie(Name, Value) = Option.split('=');
+
+    if (Name == "type")
+      Cfg.FilesType = Value;
+    else if (Name == "inputs")
+      SplitList(Value, Cfg.InputFileNames);
+    else if (Name == "outputs")
+      SplitList(Value, Cfg.OutputFileNames);
+    else if (Name == "targets")
+      SplitList(Value, Cfg.TargetNames);
+    else if (Option == "unbundle")
+      Cfg.Unbundle = true;
+    else {
+      Cfg.errs() << "error: unknown option '" << Arg << "' in batch file.\n";
+      return true;
+    }
+  }
+
+  // Archives are unbundled with external tools, which are not run in batch
+  // mode.
+  if (Cfg.FilesType == "a") {
+    Cfg.errs() << "error: archives cannot be unbundled in batch mode.\n";
+    return true;
+  }
+
+  return CheckConfig(Cfg);
+}
+
+/// Perform the operations listed in \p BatchFileName, in parallel. Return
+/// true if an error was found.
+static bool RunBatch(StringRef BatchFileName) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> BatchOrErr =
+      MemoryBuffer::getFileOrSTDIN(BatchFileName);
+  if (std::error_code EC = BatchOrErr.getError()) {
+    errs() << "error: Can't open file " << BatchFileName << ": "
+           << EC.message() << "\n";
+    return true;
+  }
+
+  SmallVector<StringRef, 16> AllLines, Lines;
+  (*BatchOrErr)->getBuffer().split(AllLines, '\n');
+  for (StringRef Line : AllLines)
+    if (!Line.trim().empty())
+      Lines.push_back(Line);
+
+  // Each operation reports its errors to a string of its own. They are
+  // printed in the order of the batch once all the operations are done.
+  unsigned NumOperations = Lines.size();
+  std::vector<BundlerConfig> Operations(NumOperations);
+  std::vector<std::string> Messages(NumOperations);
+  std::vector<std::unique_ptr<raw_string_ostream>> Streams;
+  std::vector<char> Failed(NumOperations);
+  for (unsigned I = 0; I < NumOperations; ++I) {
+    Streams.emplace_back(new raw_string_ostream(Messages[I]));
+    Operations[I].ErrorStream = Streams[I].get();
+    Failed[I] = ParseBatchLine(Lines[I], Operations[I]);
+  }
+
+  {
+    unsigned NumThreads = BatchJobs;
+    if (!NumThreads)
+      NumThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    ThreadPool Pool(NumThreads);
+    for (unsigned I = 0; I < NumOperations; ++I)
+      if (!Failed[I])
+        Pool.async([&, I]() { Failed[I] = RunOperation(Operations[I]); });
+    Pool.wait();
+  }
+
+  bool Error = false;
+  for (unsigned I = 0; I < NumOperations; ++I) {
+    errs() << Streams[I]->str();
+    Error |= Failed[I];
+  }
+  return Error;
+}
+
+static void PrintVersion() {
+  raw_ostream &OS = outs();
+  OS << clang::getClangToolFullVersion("clang-offload-bundler") << '\n';
+}
+
+int main(int argc, const char **argv) {
+  sys::PrintStackTraceOnErrorSignal(argv[0]);
+
+  cl::HideUnrelatedOptions(ClangOffloadBundlerCategory);
+  cl::SetVersionPrinter(PrintVersion);
+  cl::ParseCommandLineOptions(
+      argc, argv,
+      "A tool to bundle several input files of the specified type <type> \n"
+      "referring to the same source file but different targets into a single \n"
+      "one. The resulting file can also be unbundled into different files by \n"
+      "this tool if -unbundle is provided.\n");
+
+  if (Help)
+    cl::PrintHelpMessage();
 
   // Save the current executable directory as it will be useful to find other
   // tools.
   BundlerExecutable = sys::fs::getMainExecutable(argv[0], &BundlerExecutable);
 
-  if (Unbundle && HandleArchiveFiles())
-    return 0; // return false
+  if (!BatchFile.empty())
+    return RunBatch(BatchFile);
+
+  // The options that describe the operation are only optional in batch mode,
+  // so check for them here instead of in the option parser.
+  bool Error = false;
+  StringRef ProgramName = sys::path::filename(argv[0]);
+  for (cl::Option *O : std::initializer_list<cl::Option *>{
+           &FilesType, &InputFileNames, &OutputFileNames, &TargetNames}) {
+    if (O->getNumOccurrences())
+      continue;
+    Error = true;
+    errs() << ProgramName << ": for the -" << O->ArgStr
+           << " option: must be specified at least once!\n";
+  }
+  if (Error)
+    return 1;
+
+  BundlerConfig Cfg;
+  Cfg.InputFileNames.assign(InputFileNames.begin(), InputFileNames.end());
+  Cfg.OutputFileNames.assign(OutputFileNames.begin(), OutputFileNames.end());
+  Cfg.TargetNames.assign(TargetNames.begin(), TargetNames.end());
+  Cfg.FilesType = FilesType;
+  Cfg.Unbundle = Unbundle;
+  if (CheckConfig(Cfg))
+    return 1;
 
-  return Unbundle ? UnbundleFiles() : BundleFiles();
+  return RunOperation(Cfg);
 }
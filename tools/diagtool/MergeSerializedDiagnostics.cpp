@@ -0,0 +1,65 @@
+//===- MergeSerializedDiagnostics.cpp - diagtool tool for merging .dia ----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file provides a diagtool tool that concatenates serialized diagnostics
+// files, such as those written by the jobs of a parallel build, into one.
+//
+//===----------------------------------------------------------------------===//
+
+#include "DiagTool.h"
+#include "clang/Basic/LLVM.h"
+#include "clang/Frontend/SerializedDiagnosticReader.h"
+#include "llvm/Support/FileSystem.h"
+
+DEF_DIAGTOOL("merge-serialized",
+             "Concatenate serialized diagnostics files into one",
+             MergeSerializedDiagnostics)
+
+using namespace clang;
+
+static void printUsage() {
+  llvm::errs() << "Usage: diagtool merge-serialized [-o <output>] "
+                  "<input.dia>...\n";
+}
+
+int MergeSerializedDiagnostics::run(unsigned int argc, char **argv,
+                                    llvm::raw_ostream &out) {
+  StringRef OutputFile;
+  if (argc >= 2 && StringRef(*argv) == "-o") {
+    OutputFile = argv[1];
+    argc -= 2;
+    argv += 2;
+  }
+
+  if (argc == 0) {
+    printUsage();
+    return -1;
+  }
+
+  std::unique_ptr<llvm::raw_fd_ostream> FileOS;
+  if (!OutputFile.empty()) {
+    std::error_code EC;
+    FileOS = llvm::make_unique<llvm::raw_fd_ostream>(OutputFile, EC,
+                                                     llvm::sys::fs::F_None);
+    if (EC) {
+      llvm::errs() << "error: " << OutputFile << ": " << EC.message() << '\n';
+      return 1;
+    }
+  }
+
+  serialized_diags::SerializedDiagnosticConcatenator Concatenator(
+      FileOS ? *FileOS : out);
+  for (unsigned I = 0; I != argc; ++I) {
+    if (std::error_code EC = Concatenator.append(argv[I])) {
+      llvm::errs() << "error: " << argv[I] << ": " << EC.message() << '\n';
+      return 1;
+    }
+  }
+  return 0;
+}
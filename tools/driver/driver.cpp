@@ -305,6 +305,13 @@ static int ExecuteCC1Tool(ArrayRef<const char *> argv, StringRef Tool) {
   return 1;
 }
 
+static int ExecuteCC1ToolInProcess(ArrayRef<const char *> Argv) {
+  // Forget the -mllvm options an earlier job in this process gave, so that
+  // they can be given again.
+  llvm::cl::ResetAllOptionOccurrences();
+  return ExecuteCC1Tool(Argv, Argv[1] + 4);
+}
+
 int main(int argc_, const char **argv_) {
   llvm::sys::PrintStackTraceOnErrorSignal(argv_[0]);
   llvm::PrettyStackTraceProgram X(argc_, argv_);
@@ -447,6 +454,7 @@ int main(int argc_, const char **argv_) {
 
   Driver TheDriver(Path, llvm::sys::getDefaultTargetTriple(), Diags);
   SetInstallDir(argv, TheDriver, CanonicalPrefixes);
+  TheDriver.CC1Main = &ExecuteCC1ToolInProcess;
 
   insertTargetAndModeArgs(TargetAndMode.first, TargetAndMode.second, argv,
                           SavedStrings);
@@ -1909,9 +1909,12 @@ class EnqueueVisitor : public ConstStmtVisitor<EnqueueVisitor, void> {
   friend class OMPClauseEnqueue;
   VisitorWorkList &WL;
   CXCursor Parent;
+  SourceManager &SM;
+  SourceRange RegionOfInterest;
 public:
-  EnqueueVisitor(VisitorWorkList &wl, CXCursor parent)
-    : WL(wl), Parent(parent) {}
+  EnqueueVisitor(VisitorWorkList &wl, CXCursor parent, SourceManager &SM,
+                 SourceRange RegionOfInterest)
+    : WL(wl), Parent(parent), SM(SM), RegionOfInterest(RegionOfInterest) {}
 
   void VisitAddrLabelExpr(const AddrLabelExpr *E);
   void VisitBlockExpr(const BlockExpr *B);
@@ -2401,8 +2404,27 @@ void EnqueueVisitor::VisitCompoundLiteralExpr(const CompoundLiteralExpr *E) {
   AddTypeLoc(E->getTypeSourceInfo());
 }
 void EnqueueVisitor::VisitCompoundStmt(const CompoundStmt *S) {
-  for (auto &I : llvm::reverse(S->body()))
-    AddStmt(I);
+  CompoundStmt::const_body_iterator Begin = S->body_begin(),
+                                    End = S->body_end();
+
+  // The statements are in source order, so binary search for the ones that
+  // overlap the region of interest rather than enqueue all of them. Looking
+  // up a cursor in a large function then stays logarithmic in its size.
+  if (RegionOfInterest.isValid()) {
+    Begin = std::partition_point(Begin, End, [&](const Stmt *Child) {
+      SourceRange R = Child->getSourceRange();
+      return R.isValid() &&
+             RangeCompare(SM, R, RegionOfInterest) == RangeBefore;
+    });
+    End = std::partition_point(Begin, End, [&](const Stmt *Child) {
+      SourceRange R = Child->getSourceRange();
+      return R.isInvalid() ||
+             RangeCompare(SM, R, RegionOfInterest) != RangeAfter;
+    });
+  }
+
+  for (auto I = End; I != Begin;)
+    AddStmt(*--I);
 }
 void EnqueueVisitor::
 VisitMSDependentExistsStmt(const MSDependentExistsStmt *S) {
@@ -2907,7 +2929,8 @@ void EnqueueVisitor::VisitOMPTargetTeamsDistributeSimdDirective(
 }
 
 void CursorVisitor::EnqueueWorkList(VisitorWorkList &WL, const Stmt *S) {
-  EnqueueVisitor(WL, MakeCXCursor(S, StmtParent, TU,RegionOfInterest)).Visit(S);
+  EnqueueVisitor(WL, MakeCXCursor(S, StmtParent, TU, RegionOfInterest),
+                 AU->getSourceManager(), RegionOfInterest).Visit(S);
 }
 
 bool CursorVisitor::IsInRegionOfInterest(CXCursor C) {
@@ -3255,6 +3278,11 @@ unsigned clang_CXIndex_getGlobalOptions(CXIndex CIdx) {
   return 0;
 }
 
+void clang_CXIndex_setPreambleCacheDirectory(CXIndex CIdx, const char *Path) {
+  if (CIdx)
+    static_cast<CIndexer *>(CIdx)->setPreambleCacheDirectory(Path ? Path : "");
+}
+
 void clang_toggleCrashRecovery(unsigned isEnabled) {
   if (isEnabled)
     llvm::CrashRecoveryContext::Enable();
@@ -3417,6 +3445,11 @@ clang_parseTranslationUnit_Impl(CXIndex CIdx, const char *source_filename,
     Args->push_back("-Xclang");
     Args->push_back("-detailed-preprocessing-record");
   }
+
+  if (options & CXTranslationUnit_SkipFunctionBodiesOutsideMainFile) {
+    Args->push_back("-Xclang");
+    Args->push_back("-skip-function-bodies-outside-main-file");
+  }
   
   unsigned NumErrors = Diags->getClient()->getNumErrors();
   std::unique_ptr<ASTUnit> ErrUnit;
@@ -3435,7 +3468,7 @@ clang_parseTranslationUnit_Impl(CXIndex CIdx, const char *source_filename,
       /*AllowPCHWithCompilerErrors=*/true, SkipFunctionBodies,
       /*UserFilesAreVolatile=*/true, ForSerialization,
       CXXIdx->getPCHContainerOperations()->getRawReader().getFormat(),
-      &ErrUnit));
+      CXXIdx->getPreambleCacheDirectory(), &ErrUnit));
 
   // Early failures in LoadFromCommandLine may return with ErrUnit unset.
   if (!Unit && !ErrUnit)
@@ -4040,6 +4073,25 @@ int clang_reparseTranslationUnit(CXTranslationUnit TU,
   return result;
 }
 
+int clang_setTranslationUnitMemoryBudget(CXTranslationUnit TU,
+                                         unsigned long long budget,
+                                         unsigned visible_begin,
+                                         unsigned visible_end) {
+  LOG_FUNC_SECTION {
+    *Log << TU << ' ' << budget << ' ' << visible_begin << '-' << visible_end;
+  }
+
+  if (isNotUsableTU(TU)) {
+    LOG_BAD_TU(TU);
+    return CXError_InvalidArguments;
+  }
+  if (visible_begin >= visible_end)
+    return CXError_InvalidArguments;
+
+  cxtu::getASTUnit(TU)->setMemoryBudget(budget, visible_begin, visible_end);
+  return CXError_Success;
+}
+
 
 CXString clang_getTranslationUnitSpelling(CXTranslationUnit CTUnit) {
   if (isNotUsableTU(CTUnit)) {
@@ -4208,6 +4260,60 @@ static SourceLocation getLocationFromExpr(const Expr *E) {
   return E->getLocStart();
 }
 
+namespace {
+/// The state of a traversal by clang_visitChildrenBuffered().
+struct CursorRecordBuffer {
+  CXCursorRecord *Records;
+  unsigned Capacity;
+  unsigned Size;
+  CXCursorRecordsVisitor Visitor;
+  CXClientData ClientData;
+
+  /// The number of records found so far.
+  unsigned NumRecords;
+
+  /// The cursors of the path from the visited cursor to the current one, with
+  /// the positions of their records.
+  SmallVector<std::pair<CXCursor, unsigned>, 16> Ancestors;
+
+  /// Whether the visitor ended the traversal.
+  bool Ended;
+
+  CursorRecordBuffer(CXCursorRecord *Records, unsigned Capacity,
+                     CXCursorRecordsVisitor Visitor, CXClientData ClientData)
+      : Records(Records), Capacity(Capacity), Size(0), Visitor(Visitor),
+        ClientData(ClientData), NumRecords(0), Ended(false) {}
+
+  bool flush() {
+    if (Size && Visitor(Records, Size, ClientData))
+      Ended = true;
+    Size = 0;
+    return !Ended;
+  }
+};
+} // end anonymous namespace
+
+static enum CXChildVisitResult visitIntoBuffer(CXCursor C, CXCursor Parent,
+                                               CXClientData Data) {
+  CursorRecordBuffer &Buffer = *static_cast<CursorRecordBuffer *>(Data);
+  if (Buffer.Size == Buffer.Capacity && !Buffer.flush())
+    return CXChildVisit_Break;
+
+  // The traversal is depth-first, so the parent is on the path to the
+  // previous cursor.
+  while (!Buffer.Ancestors.empty() &&
+         !clang_equalCursors(Buffer.Ancestors.back().first, Parent))
+    Buffer.Ancestors.pop_back();
+
+  CXCursorRecord &Record = Buffer.Records[Buffer.Size++];
+  Record.cursor = C;
+  Record.parent =
+      Buffer.Ancestors.empty() ? ~0U : Buffer.Ancestors.back().second;
+  Record.extent = clang_getCursorExtent(C);
+  Buffer.Ancestors.push_back(std::make_pair(C, Buffer.NumRecords++));
+  return CXChildVisit_Recurse;
+}
+
 extern "C" {
 
 unsigned clang_visitChildren(CXCursor parent,
@@ -4255,6 +4361,22 @@ unsigned clang_visitChildrenWithBlock(CXCursor parent,
   return clang_visitChildren(parent, visitWithBlock, block);
 }
 
+unsigned clang_visitChildrenBuffered(CXCursor parent, CXCursorRecord *records,
+                                     unsigned num_records,
+                                     CXCursorRecordsVisitor visitor,
+                                     CXClientData client_data) {
+  if (!records || !num_records || !visitor)
+    return 0;
+
+  CursorRecordBuffer Buffer(records, num_records, visitor, client_data);
+  CursorVisitor CursorVis(getCursorTU(parent), visitIntoBuffer, &Buffer,
+                          /*VisitPreprocessorLast=*/false);
+  CursorVis.VisitChildren(parent);
+  if (!Buffer.Ended)
+    Buffer.flush();
+  return Buffer.Ended;
+}
+
 static CXString getDeclSpelling(const Decl *D) {
   if (!D)
     return cxstring::createEmpty();
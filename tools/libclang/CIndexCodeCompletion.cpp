@@ -21,6 +21,7 @@
 #include "clang/AST/Decl.h"
 #include "clang/AST/DeclObjC.h"
 #include "clang/AST/Type.h"
+#include "clang/Basic/CharInfo.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Frontend/ASTUnit.h"
@@ -516,36 +517,89 @@ static unsigned long long getContextsForContextKind(
   return contexts;
 }
 
+/// \brief How well the typed text of a completion result matches the filter
+/// of the completion request, from worst to best.
+enum CompletionFilterMatch {
+  CFM_None,
+  CFM_Fuzzy,
+  CFM_CaseInsensitivePrefix,
+  CFM_Prefix
+};
+
+static CompletionFilterMatch matchCompletionFilter(StringRef TypedText,
+                                                   StringRef Filter) {
+  if (TypedText.startswith(Filter))
+    return CFM_Prefix;
+  if (TypedText.startswith_lower(Filter))
+    return CFM_CaseInsensitivePrefix;
+
+  // The characters of the filter appear in order in the typed text.
+  StringRef Rest = TypedText;
+  for (char C : Filter) {
+    while (!Rest.empty() && toLowercase(Rest.front()) != toLowercase(C))
+      Rest = Rest.drop_front();
+    if (Rest.empty())
+      return CFM_None;
+    Rest = Rest.drop_front();
+  }
+  return CFM_Fuzzy;
+}
+
+/// \brief Retrieve the typed text of a completion result without creating its
+/// completion string, or an empty string if it is only known once the
+/// completion string has been created.
+static StringRef getTypedText(const CodeCompletionResult &R) {
+  switch (R.Kind) {
+  case CodeCompletionResult::RK_Declaration:
+    if (const IdentifierInfo *II = R.Declaration->getIdentifier())
+      return II->getName();
+    return StringRef();
+  case CodeCompletionResult::RK_Keyword:
+    return R.Keyword;
+  case CodeCompletionResult::RK_Macro:
+    return R.Macro->getName();
+  case CodeCompletionResult::RK_Pattern:
+    if (const char *Text = R.Pattern->getTypedText())
+      return Text;
+    return StringRef();
+  }
+  llvm_unreachable("Unhandled completion result kind");
+}
+
 namespace {
   class CaptureCompletionResults : public CodeCompleteConsumer {
     AllocatedCXCodeCompleteResults &AllocatedResults;
     CodeCompletionTUInfo CCTUInfo;
     SmallVector<CXCompletionResult, 16> StoredResults;
     CXTranslationUnit *TU;
+
+    /// The text the typed text of the results has to match, if any.
+    std::string Filter;
+
+    /// The maximum number of results to keep, or 0 to keep all of them.
+    unsigned MaxResults;
+
   public:
     CaptureCompletionResults(const CodeCompleteOptions &Opts,
                              AllocatedCXCodeCompleteResults &Results,
-                             CXTranslationUnit *TranslationUnit)
+                             CXTranslationUnit *TranslationUnit,
+                             StringRef Filter = StringRef(),
+                             unsigned MaxResults = 0)
       : CodeCompleteConsumer(Opts, false), 
         AllocatedResults(Results), CCTUInfo(Results.CodeCompletionAllocator),
-        TU(TranslationUnit) { }
+        TU(TranslationUnit), Filter(Filter), MaxResults(MaxResults) { }
     ~CaptureCompletionResults() override { Finish(); }
 
     void ProcessCodeCompleteResults(Sema &S, 
                                     CodeCompletionContext Context,
                                     CodeCompletionResult *Results,
                                     unsigned NumResults) override {
-      StoredResults.reserve(StoredResults.size() + NumResults);
-      for (unsigned I = 0; I != NumResults; ++I) {
-        CodeCompletionString *StoredCompletion        
-          = Results[I].CreateCodeCompletionString(S, Context, getAllocator(),
-                                                  getCodeCompletionTUInfo(),
-                                                  includeBriefComments());
-        
-        CXCompletionResult R;
-        R.CursorKind = Results[I].CursorKind;
-        R.CompletionString = StoredCompletion;
-        StoredResults.push_back(R);
+      if (!Filter.empty() || MaxResults) {
+        addFilteredResults(S, Context, Results, NumResults);
+      } else {
+        StoredResults.reserve(StoredResults.size() + NumResults);
+        for (unsigned I = 0; I != NumResults; ++I)
+          addResult(Results[I], createCompletionString(S, Context, Results[I]));
       }
       
       enum CodeCompletionContext::Kind contextKind = Context.getKind();
@@ -632,6 +686,78 @@ namespace {
     CodeCompletionTUInfo &getCodeCompletionTUInfo() override { return CCTUInfo;}
 
   private:
+    CodeCompletionString *createCompletionString(Sema &S,
+                                                 CodeCompletionContext Context,
+                                                 CodeCompletionResult &R) {
+      return R.CreateCodeCompletionString(S, Context, getAllocator(),
+                                          getCodeCompletionTUInfo(),
+                                          includeBriefComments());
+    }
+
+    void addResult(const CodeCompletionResult &Result,
+                   CodeCompletionString *Completion) {
+      CXCompletionResult R;
+      R.CursorKind = Result.CursorKind;
+      R.CompletionString = Completion;
+      StoredResults.push_back(R);
+    }
+
+    /// \brief Add the best \c MaxResults results that match the filter, best
+    /// first, creating the completion strings of only the results that are
+    /// kept when their typed text is known without them.
+    void addFilteredResults(Sema &S, CodeCompletionContext Context,
+                            CodeCompletionResult *Results,
+                            unsigned NumResults) {
+      struct Candidate {
+        CodeCompletionResult *Result;
+        CodeCompletionString *Completion;
+        StringRef TypedText;
+        CompletionFilterMatch Match;
+      };
+      SmallVector<Candidate, 16> Candidates;
+      for (unsigned I = 0; I != NumResults; ++I) {
+        CodeCompletionString *Completion = nullptr;
+        StringRef TypedText = getTypedText(Results[I]);
+        if (TypedText.empty()) {
+          Completion = createCompletionString(S, Context, Results[I]);
+          if (const char *Text = Completion->getTypedText())
+            TypedText = Text;
+        }
+
+        CompletionFilterMatch Match = matchCompletionFilter(TypedText, Filter);
+        if (Match == CFM_None)
+          continue;
+        Candidate C = { &Results[I], Completion, TypedText, Match };
+        Candidates.push_back(C);
+      }
+
+      // Rank the results by how well they match the filter, then by priority
+      // and by typed text, keeping the order of the results that tie.
+      auto IsBetter = [](const Candidate &LHS, const Candidate &RHS) {
+        if (LHS.Match != RHS.Match)
+          return LHS.Match > RHS.Match;
+        if (LHS.Result->Priority != RHS.Result->Priority)
+          return LHS.Result->Priority < RHS.Result->Priority;
+        if (int Cmp = LHS.TypedText.compare_lower(RHS.TypedText))
+          return Cmp < 0;
+        return LHS.Result < RHS.Result;
+      };
+      unsigned NumKept = Candidates.size();
+      if (MaxResults && MaxResults < NumKept) {
+        NumKept = MaxResults;
+        std::partial_sort(Candidates.begin(), Candidates.begin() + NumKept,
+                          Candidates.end(), IsBetter);
+      } else {
+        std::sort(Candidates.begin(), Candidates.end(), IsBetter);
+      }
+
+      StoredResults.reserve(StoredResults.size() + NumKept);
+      for (const Candidate &C : makeArrayRef(Candidates).slice(0, NumKept))
+        addResult(*C.Result,
+                  C.Completion ? C.Completion
+                               : createCompletionString(S, Context, *C.Result));
+    }
+
     void Finish() {
       AllocatedResults.Results = new CXCompletionResult [StoredResults.size()];
       AllocatedResults.NumResults = StoredResults.size();
@@ -646,7 +772,8 @@ static CXCodeCompleteResults *
 clang_codeCompleteAt_Impl(CXTranslationUnit TU, const char *complete_filename,
                           unsigned complete_line, unsigned complete_column,
                           ArrayRef<CXUnsavedFile> unsaved_files,
-                          unsigned options) {
+                          unsigned options, StringRef filter,
+                          unsigned max_results) {
   bool IncludeBriefComments = options & CXCodeComplete_IncludeBriefComments;
 
 #ifdef UDP_CODE_COMPLETION_LOGGER
@@ -694,7 +821,7 @@ clang_codeCompleteAt_Impl(CXTranslationUnit TU, const char *complete_filename,
   // Create a code-completion consumer to capture the results.
   CodeCompleteOptions Opts;
   Opts.IncludeBriefComments = IncludeBriefComments;
-  CaptureCompletionResults Capture(Opts, *Results, &TU);
+  CaptureCompletionResults Capture(Opts, *Results, &TU, filter, max_results);
 
   // Perform completion.
   AST->CodeComplete(complete_filename, complete_line, complete_column,
@@ -797,9 +924,27 @@ CXCodeCompleteResults *clang_codeCompleteAt(CXTranslationUnit TU,
                                             struct CXUnsavedFile *unsaved_files,
                                             unsigned num_unsaved_files,
                                             unsigned options) {
+  return clang_codeCompleteAtWithFilter(TU, complete_filename, complete_line,
+                                        complete_column, unsaved_files,
+                                        num_unsaved_files, options,
+                                        /*filter=*/nullptr,
+                                        /*max_results=*/0);
+}
+
+CXCodeCompleteResults *
+clang_codeCompleteAtWithFilter(CXTranslationUnit TU,
+                               const char *complete_filename,
+                               unsigned complete_line, unsigned complete_column,
+                               struct CXUnsavedFile *unsaved_files,
+                               unsigned num_unsaved_files, unsigned options,
+                               const char *filter, unsigned max_results) {
   LOG_FUNC_SECTION {
     *Log << TU << ' '
          << complete_filename << ':' << complete_line << ':' << complete_column;
+    if (filter)
+      *Log << " filter: " << filter;
+    if (max_results)
+      *Log << " max results: " << max_results;
   }
 
   if (num_unsaved_files && !unsaved_files)
@@ -809,7 +954,8 @@ CXCodeCompleteResults *clang_codeCompleteAt(CXTranslationUnit TU,
   auto CodeCompleteAtImpl = [=, &result]() {
     result = clang_codeCompleteAt_Impl(
         TU, complete_filename, complete_line, complete_column,
-        llvm::makeArrayRef(unsaved_files, num_unsaved_files), options);
+        llvm::makeArrayRef(unsaved_files, num_unsaved_files), options,
+        filter ? StringRef(filter) : StringRef(), max_results);
   };
 
   if (getenv("LIBCLANG_NOTHREADS")) {
@@ -41,9 +41,14 @@ static void getInclusions(const SrcMgr::SLocEntry &(SourceManager::*Getter)(unsi
       continue;
 
     // If this is the main file, and there is a preamble, skip this SLoc. The
-    // inclusions of the preamble already showed it.
+    // inclusions of the preamble already showed it. The same goes for the
+    // copies of the main file in the preambles that the preamble extends,
+    // which are "included" at the start of the preamble.
     SourceLocation L = FI.getIncludeLoc();
-    if (HasPreamble && CXXUnit->isInMainFileID(L))
+    if (HasPreamble && (CXXUnit->isInMainFileID(L) ||
+                        (CXXUnit->isInPreambleFileID(L) &&
+                         FI.getContentCache()->OrigEntry ==
+                             SM.getFileEntryForID(SM.getMainFileID()))))
       continue;
 
     // Build the inclusion stack.
@@ -52,6 +57,12 @@ static void getInclusions(const SrcMgr::SLocEntry &(SourceManager::*Getter)(unsi
       PresumedLoc PLoc = SM.getPresumedLoc(L);
       InclusionStack.push_back(cxloc::translateSourceLocation(Ctx, L));
       L = PLoc.isValid()? PLoc.getIncludeLoc() : SourceLocation();
+
+      // Skip the inclusion of an extended preamble into the preamble, and go
+      // to the inclusion of the preamble into the main file.
+      if (HasPreamble && CXXUnit->isInPreambleFileID(L) &&
+          SM.getFileOffset(L) == 0)
+        L = SM.getIncludeLoc(SM.getPreambleFileID());
     }
 
     // If there is a preamble, the last entry is the "inclusion" of that
@@ -16,6 +16,7 @@
 #define LLVM_CLANG_TOOLS_LIBCLANG_CINDEXER_H
 
 #include "clang-c/Index.h"
+#include "clang/Basic/LLVM.h"
 #include "clang/Frontend/PCHContainerOperations.h"
 #include "llvm/ADT/STLExtras.h"
 #include <utility>
@@ -40,6 +41,8 @@ class CIndexer {
   std::string ResourcesPath;
   std::shared_ptr<PCHContainerOperations> PCHContainerOps;
 
+  std::string PreambleCacheDirectory;
+
 public:
   CIndexer(std::shared_ptr<PCHContainerOperations> PCHContainerOps =
                std::make_shared<PCHContainerOperations>())
@@ -71,6 +74,15 @@ public:
 
   /// \brief Get the path of the clang resource files.
   const std::string &getClangResourcesPath();
+
+  /// \brief The directory in which the precompiled preambles of the
+  /// translation units are shared, or empty if they are not shared.
+  StringRef getPreambleCacheDirectory() const {
+    return PreambleCacheDirectory;
+  }
+  void setPreambleCacheDirectory(StringRef Dir) {
+    PreambleCacheDirectory = Dir.str();
+  }
 };
 
   /// \brief Return the current size to request for "safety".
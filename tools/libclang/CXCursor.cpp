@@ -245,6 +245,7 @@ CXCursor cxcursor::MakeCXCursor(const Stmt *S, const Decl *Parent,
   case Stmt::DesignatedInitUpdateExprClass:
   case Stmt::ArrayInitLoopExprClass:
   case Stmt::ArrayInitIndexExprClass:
+  case Stmt::CompactArrayInitExprClass:
   case Stmt::ExprWithCleanupsClass:
   case Stmt::ExpressionTraitExprClass:
   case Stmt::ExtVectorElementExprClass:
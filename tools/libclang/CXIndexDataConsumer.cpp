@@ -407,6 +407,7 @@ const char *ScratchAlloc::copyCStr(StringRef Str) {
 
 void CXIndexDataConsumer::setASTContext(ASTContext &ctx) {
   Ctx = &ctx;
+  USRs.clear();
   cxtu::getASTUnit(CXTU)->setASTContext(&ctx);
 }
 
@@ -1185,15 +1186,12 @@ void CXIndexDataConsumer::getEntityInfo(const NamedDecl *D,
     EntityInfo.name = SA.copyCStr(StrBuf.str());
   }
 
-  {
-    SmallString<512> StrBuf;
-    bool Ignore = getDeclCursorUSR(D, StrBuf);
-    if (Ignore) {
-      EntityInfo.USR = nullptr;
-    } else {
-      EntityInfo.USR = SA.copyCStr(StrBuf.str());
-    }
-  }
+  // The cached USRs are null-terminated and outlive the callbacks.
+  StringRef USR;
+  if (USRs.getUSR(D, USR))
+    EntityInfo.USR = nullptr;
+  else
+    EntityInfo.USR = USR.data();
 }
 
 void CXIndexDataConsumer::getContainerInfo(const DeclContext *DC,
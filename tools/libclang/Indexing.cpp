@@ -28,10 +28,16 @@
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Lex/PreprocessorOptions.h"
 #include "llvm/Support/CrashRecoveryContext.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Mutex.h"
 #include "llvm/Support/MutexGuard.h"
+#include "llvm/Support/ThreadPool.h"
+#include <algorithm>
 #include <cstdio>
+#include <thread>
 #include <utility>
 
 using namespace clang;
@@ -144,8 +150,82 @@ public:
     llvm::MutexGuard MG(Mux);
     ParsedRegions.insert(Regions.begin(), Regions.end());
   }
+
+  /// Add the regions recorded in the file at \p Path, if it is a file of
+  /// parsed regions.
+  void load(StringRef Path);
+
+  /// Write the regions to the file at \p Path, together with the regions
+  /// that other sessions recorded there.
+  bool save(StringRef Path);
 };
 
+/// The file of parsed regions starts with this signature, followed by the
+/// regions, each as its file's device and file IDs, offset, and
+/// modification time.
+static const char ParsedRegionsSignature[] = "CXPARSEDREGIONS1";
+enum { ParsedRegionRecordSize = 8 + 8 + 4 + 8 };
+
+void SessionSkipBodyData::load(StringRef Path) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+      llvm::MemoryBuffer::getFile(Path);
+  if (!Buffer)
+    return;
+
+  StringRef Data = (*Buffer)->getBuffer();
+  if (!Data.startswith(ParsedRegionsSignature))
+    return;
+  Data = Data.drop_front(sizeof(ParsedRegionsSignature) - 1);
+
+  using namespace llvm::support;
+  const unsigned char *Ptr =
+      reinterpret_cast<const unsigned char *>(Data.data());
+  llvm::MutexGuard MG(Mux);
+  for (size_t N = Data.size() / ParsedRegionRecordSize; N; --N) {
+    uint64_t Device = endian::readNext<uint64_t, little, unaligned>(Ptr);
+    uint64_t File = endian::readNext<uint64_t, little, unaligned>(Ptr);
+    uint32_t Offset = endian::readNext<uint32_t, little, unaligned>(Ptr);
+    uint64_t ModTime = endian::readNext<uint64_t, little, unaligned>(Ptr);
+    ParsedRegions.insert(PPRegion(llvm::sys::fs::UniqueID(Device, File),
+                                  Offset, time_t(ModTime)));
+  }
+}
+
+bool SessionSkipBodyData::save(StringRef Path) {
+  // Keep the regions that other sessions saved since this one was loaded.
+  load(Path);
+
+  // Write to a temporary file and rename it, so that sessions running
+  // concurrently never read a partial file.
+  SmallString<128> TempPath;
+  int FD;
+  if (llvm::sys::fs::createUniqueFile(Path + "-%%%%%%%%", FD, TempPath))
+    return false;
+
+  bool Failed;
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << ParsedRegionsSignature;
+    llvm::support::endian::Writer<llvm::support::little> LE(OS);
+    llvm::MutexGuard MG(Mux);
+    for (const PPRegion &R : ParsedRegions) {
+      LE.write<uint64_t>(R.getUniqueID().getDevice());
+      LE.write<uint64_t>(R.getUniqueID().getFile());
+      LE.write<uint32_t>(R.getOffset());
+      LE.write<uint64_t>(uint64_t(R.getModTime()));
+    }
+    OS.close();
+    Failed = OS.has_error();
+    OS.clear_error();
+  }
+
+  if (Failed || llvm::sys::fs::rename(TempPath, Path)) {
+    llvm::sys::fs::remove(TempPath);
+    return false;
+  }
+  return true;
+}
+
 class TUSkipBodyControl {
   SessionSkipBodyData &SessionData;
   PPConditionalDirectiveRecord &PPRec;
@@ -406,8 +486,17 @@ struct IndexSessionData {
   CXIndex CIdx;
   std::unique_ptr<SessionSkipBodyData> SkipBodyData;
 
+  /// The file in which the parsed regions are saved for later sessions, if
+  /// any.
+  std::string ParsedBodiesFile;
+
   explicit IndexSessionData(CXIndex cIdx)
     : CIdx(cIdx), SkipBodyData(new SessionSkipBodyData) {}
+
+  ~IndexSessionData() {
+    if (!ParsedBodiesFile.empty())
+      SkipBodyData->save(ParsedBodiesFile);
+  }
 };
 
 } // anonymous namespace
@@ -828,6 +917,17 @@ void clang_IndexAction_dispose(CXIndexAction idxAction) {
     delete static_cast<IndexSessionData *>(idxAction);
 }
 
+int clang_IndexAction_setParsedBodiesFile(CXIndexAction idxAction,
+                                          const char *path) {
+  if (!idxAction || !path)
+    return CXError_InvalidArguments;
+
+  IndexSessionData *IdxSession = static_cast<IndexSessionData *>(idxAction);
+  IdxSession->ParsedBodiesFile = path;
+  IdxSession->SkipBodyData->load(path);
+  return CXError_Success;
+}
+
 int clang_indexSourceFile(CXIndexAction idxAction,
                           CXClientData client_data,
                           IndexerCallbacks *index_callbacks,
@@ -912,6 +1012,55 @@ int clang_indexSourceFileFullArgv(
   return result;
 }
 
+int clang_indexSourceFiles(CXIndexAction idxAction, CXClientData *client_data,
+                           IndexerCallbacks *index_callbacks,
+                           unsigned index_callbacks_size,
+                           unsigned index_options,
+                           const char *const *const *command_lines,
+                           const int *num_command_line_args,
+                           unsigned num_files, unsigned num_threads,
+                           unsigned TU_options, int *results) {
+  LOG_FUNC_SECTION {
+    *Log << num_files << " files, " << num_threads << " threads";
+  }
+
+  if (!idxAction ||
+      (num_files && (!client_data || !command_lines || !num_command_line_args)))
+    return CXError_InvalidArguments;
+
+  std::vector<int> Results(num_files, CXError_Failure);
+  auto IndexSourceFile = [=, &Results](unsigned I) {
+    Results[I] = clang_indexSourceFileFullArgv(
+        idxAction, client_data[I], index_callbacks, index_callbacks_size,
+        index_options, /*source_filename=*/nullptr, command_lines[I],
+        num_command_line_args[I], /*unsaved_files=*/nullptr,
+        /*num_unsaved_files=*/0, /*out_TU=*/nullptr, TU_options);
+  };
+
+  if (getenv("LIBCLANG_NOTHREADS") || num_files < 2) {
+    for (unsigned I = 0; I != num_files; ++I)
+      IndexSourceFile(I);
+  } else {
+    // The files share the session of the index action, and with it the set of
+    // the bodies that were already parsed.
+    if (!num_threads)
+      num_threads = std::thread::hardware_concurrency();
+    llvm::ThreadPool Pool(std::min(std::max(num_threads, 1u), num_files));
+    for (unsigned I = 0; I != num_files; ++I)
+      Pool.async(IndexSourceFile, I);
+    Pool.wait();
+  }
+
+  int Result = 0;
+  for (unsigned I = 0; I != num_files; ++I) {
+    if (results)
+      results[I] = Results[I];
+    if (!Result)
+      Result = Results[I];
+  }
+  return Result;
+}
+
 int clang_indexTranslationUnit(CXIndexAction idxAction,
                                CXClientData client_data,
                                IndexerCallbacks *index_callbacks,
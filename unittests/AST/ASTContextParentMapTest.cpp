@@ -78,5 +78,67 @@ TEST(GetParents, ReturnsMultipleParentsInTemplateInstantiations) {
           hasAncestor(cxxRecordDecl(unless(isTemplateInstantiation())))))));
 }
 
+TEST(GetParents, ScopesParentMapToADeclaration) {
+  std::unique_ptr<ASTUnit> AST = tooling::buildASTFromCode(
+      "void f() { if (true) {} }"
+      "namespace n { void g() { while (true) {} } }");
+  ASTContext &Ctx = AST->getASTContext();
+  const auto *N = selectFirst<NamespaceDecl>("n", match(
+      namespaceDecl().bind("n"), Ctx));
+  const auto *G = selectFirst<FunctionDecl>("g", match(
+      functionDecl(hasName("g")).bind("g"), Ctx));
+  const auto *If = selectFirst<IfStmt>("if", match(
+      ifStmt().bind("if"), Ctx));
+  ASSERT_TRUE(N && G && If);
+
+  Ctx.setParentMapScope(N);
+  auto Parents = Ctx.getParents(*N);
+  ASSERT_EQ(1u, Parents.size());
+  EXPECT_EQ(Ctx.getTranslationUnitDecl(),
+            Parents[0].get<TranslationUnitDecl>());
+  Parents = Ctx.getParents(*G);
+  ASSERT_EQ(1u, Parents.size());
+  EXPECT_EQ(N, Parents[0].get<NamespaceDecl>());
+  EXPECT_TRUE(Ctx.getParents(*Ctx.getTranslationUnitDecl()).empty());
+
+  // Nodes outside the scope still find their parents.
+  Parents = Ctx.getParents(*If);
+  ASSERT_EQ(1u, Parents.size());
+  EXPECT_TRUE(Parents[0].get<CompoundStmt>() != nullptr);
+
+  Ctx.setParentMapScope(nullptr);
+  Parents = Ctx.getParents(*G);
+  ASSERT_EQ(1u, Parents.size());
+  EXPECT_EQ(N, Parents[0].get<NamespaceDecl>());
+}
+
+TEST(GetParents, ScopesParentMapToTopLevelDeclsInMatchFinder) {
+  MatchFinder::MatchFinderOptions Options;
+  Options.ScopeParentMaps = true;
+  MatchFinder Finder(std::move(Options));
+  struct CountingCallback : public MatchFinder::MatchCallback {
+    void run(const MatchFinder::MatchResult &) override { ++Count; }
+    unsigned Count = 0;
+  } Callback;
+  Finder.addMatcher(
+      compoundStmt(hasParent(functionDecl()),
+                   hasAncestor(namespaceDecl(hasName("n")))),
+      &Callback);
+  Finder.addMatcher(
+      cxxMethodDecl(hasName("f"),
+                    hasParent(cxxRecordDecl(isTemplateInstantiation()))),
+      &Callback);
+  std::unique_ptr<tooling::FrontendActionFactory> Factory(
+      tooling::newFrontendActionFactory(&Finder));
+  ASSERT_TRUE(tooling::runToolOnCode(
+      Factory->create(),
+      "void f() {}"
+      "namespace n { void g() {} void h() {} }"
+      "template<typename T> struct C { void f() {} };"
+      "void i() { C<int> c; c.f(); }"));
+  // The bodies of g and h, and C<int>::f.
+  EXPECT_EQ(3u, Callback.Count);
+}
+
 } // end namespace ast_matchers
 } // end namespace clang
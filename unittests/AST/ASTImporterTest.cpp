@@ -488,6 +488,41 @@ TEST(ImportType, ImportAtomicType) {
                                        has(atomicType()))))))))));
 }
 
+TEST(ImportDecl, ImportFunctionBodyLazily) {
+  const char *const FromCode = "void declToImport() { int x = 0; }";
+  std::unique_ptr<ASTUnit>
+      FromAST = tooling::buildASTFromCodeWithArgs(FromCode, {"-std=c++98"},
+                                                  "input.cc"),
+      ToAST = tooling::buildASTFromCodeWithArgs("", {"-std=c++98"},
+                                                "output.cc");
+  ASTContext &FromCtx = FromAST->getASTContext(),
+      &ToCtx = ToAST->getASTContext();
+
+  vfs::OverlayFileSystem *OFS = static_cast<vfs::OverlayFileSystem *>(
+        ToCtx.getSourceManager().getFileManager().getVirtualFileSystem().get());
+  vfs::InMemoryFileSystem *MFS = static_cast<vfs::InMemoryFileSystem *>(
+        OFS->overlays_begin()->get());
+  MFS->addFile("input.cc", 0, llvm::MemoryBuffer::getMemBuffer(FromCode));
+
+  ASTImporter Importer(ToCtx, ToAST->getFileManager(),
+                       FromCtx, FromAST->getFileManager(), false);
+  Importer.setLazyFunctionBodies(true);
+
+  SmallVector<NamedDecl *, 1> FoundDecls;
+  FromCtx.getTranslationUnitDecl()->localUncachedLookup(
+        &FromCtx.Idents.get("declToImport"), FoundDecls);
+  ASSERT_EQ(1u, FoundDecls.size());
+
+  auto *Imported = cast_or_null<FunctionDecl>(Importer.Import(FoundDecls[0]));
+  ASSERT_TRUE(Imported);
+  EXPECT_FALSE(Imported->hasBody());
+
+  Stmt *Body = Importer.ImportFunctionBody(Imported);
+  ASSERT_TRUE(Body);
+  EXPECT_TRUE(isa<CompoundStmt>(Body));
+  EXPECT_EQ(Body, Imported->getBody());
+  EXPECT_EQ(Body, Importer.ImportFunctionBody(Imported));
+}
 
 } // end namespace ast_matchers
 } // end namespace clang
@@ -234,6 +234,38 @@ TEST(Matcher, IsExpansionInFileMatching) {
       "-isystem/", M));
 }
 
+TEST(MatchFinder, IgnoresSystemHeaders) {
+  struct CountingCallback : public MatchFinder::MatchCallback {
+    void run(const MatchFinder::MatchResult &Result) override {
+      ++Count;
+      const auto *Record = Result.Nodes.getNodeAs<CXXRecordDecl>("r");
+      EXPECT_FALSE(
+          Result.SourceManager->isInSystemHeader(Record->getLocation()));
+    }
+    unsigned Count = 0;
+  } Callback;
+  MatchFinder::MatchFinderOptions Options;
+  Options.IgnoreSystemHeaders = true;
+  MatchFinder Finder(std::move(Options));
+  Finder.addMatcher(cxxRecordDecl(isDefinition()).bind("r"), &Callback);
+  std::unique_ptr<FrontendActionFactory> Factory(
+      newFrontendActionFactory(&Finder));
+
+  FileContentMappings M;
+  M.push_back(std::make_pair(
+      "/other", "namespace std { template <typename T> struct box { T t; };"
+                "void f() { struct Local {}; } }"));
+  ASSERT_TRUE(tooling::runToolOnCodeWithArgs(
+      Factory->create(),
+      "#include <other>\n"
+      "namespace std { struct Mine {}; }\n"
+      "struct X { std::box<int> B; };",
+      {"-isystem/"}, "input.cc", "clang-tool",
+      std::make_shared<PCHContainerOperations>(), M));
+  // Mine and X, but not box, box<int> or Local.
+  EXPECT_EQ(2u, Callback.Count);
+}
+
 #endif // LLVM_ON_WIN32
 
 } // end namespace ast_matchers
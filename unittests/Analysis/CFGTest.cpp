@@ -8,7 +8,10 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/ASTMatchers/ASTMatchFinder.h"
+#include "clang/ASTMatchers/ASTMatchers.h"
+#include "clang/Analysis/AnalysisContext.h"
 #include "clang/Analysis/CFG.h"
+#include "clang/Frontend/ASTUnit.h"
 #include "clang/Tooling/Tooling.h"
 #include "gtest/gtest.h"
 #include <string>
@@ -75,6 +78,48 @@ TEST(CFG, DeleteExpressionOnDependentType) {
   EXPECT_EQ(BuiltCFG, BuildCFG(Code));
 }
 
+TEST(CFG, ContextsShareCachedCFGs) {
+  std::unique_ptr<ASTUnit> AST =
+      tooling::buildASTFromCode("void f(int x) { if (x) x = 1; }");
+  const auto *F = ast_matchers::selectFirst<FunctionDecl>(
+      "f", ast_matchers::match(
+               ast_matchers::functionDecl(ast_matchers::hasName("f")).bind("f"),
+               AST->getASTContext()));
+  ASSERT_TRUE(F);
+
+  AnalysisDeclContextManager Mgr;
+  CFG *Cached = Mgr.getContext(F)->getCFG();
+  ASSERT_TRUE(Cached);
+  // The CFG outlives the contexts of the manager.
+  Mgr.clear();
+  EXPECT_EQ(Cached, Mgr.getContext(F)->getCFG());
+
+  // A CFG that always adds fewer statements than asked for is built again.
+  AnalysisDeclContext Linearized(nullptr, F, Mgr.getCFGBuildOptions());
+  Linearized.getCFGBuildOptions().setAllAlwaysAdd();
+  Linearized.setCFGCache(&Mgr.getCFGCache());
+  CFG *LinearizedCFG = Linearized.getCFG();
+  ASSERT_TRUE(LinearizedCFG);
+  EXPECT_NE(Cached, LinearizedCFG);
+
+  // A CFG built with other flags is neither reused nor kept.
+  AnalysisDeclContext WithDtors(nullptr, F, Mgr.getCFGBuildOptions());
+  WithDtors.getCFGBuildOptions().AddImplicitDtors = true;
+  WithDtors.setCFGCache(&Mgr.getCFGCache());
+  CFG *WithDtorsCFG = WithDtors.getCFG();
+  ASSERT_TRUE(WithDtorsCFG);
+  EXPECT_NE(Cached, WithDtorsCFG);
+  EXPECT_EQ(nullptr, Mgr.getCFGCache().lookup(F, F->getBody(),
+                                              WithDtors.getCFGBuildOptions()));
+
+  // The unoptimized CFG is cached separately.
+  CFG *Unoptimized = Mgr.getContext(F)->getUnoptimizedCFG();
+  ASSERT_TRUE(Unoptimized);
+  EXPECT_NE(Cached, Unoptimized);
+  Mgr.clear();
+  EXPECT_EQ(Unoptimized, Mgr.getContext(F)->getUnoptimizedCFG());
+}
+
 } // namespace
 } // namespace analysis
 } // namespace clang
@@ -10,6 +10,7 @@
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/FileSystemOptions.h"
 #include "clang/Basic/FileSystemStatCache.h"
+#include "clang/Basic/VirtualFileSystem.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Config/llvm-config.h"
 #include "gtest/gtest.h"
@@ -246,6 +247,39 @@ TEST_F(FileManagerTest, addRemoveStatCache) {
   manager.removeStatCache(statCache);
 }
 
+// Prefetched lookups find the same files, and the missing paths are shared
+// with the other file managers given the same set.
+TEST_F(FileManagerTest, prefetchFilesSharesMissingPaths) {
+  IntrusiveRefCntPtr<vfs::InMemoryFileSystem> FS(
+      new vfs::InMemoryFileSystem);
+  FS->addFile("/a/bar.h", 0, llvm::MemoryBuffer::getMemBuffer(""));
+  FS->addFile("/b/foo.h", 0, llvm::MemoryBuffer::getMemBuffer(""));
+  FS->addFile("/c/bar.h", 0, llvm::MemoryBuffer::getMemBuffer(""));
+  IntrusiveRefCntPtr<MissingPathSet> Missing(new MissingPathSet);
+
+  FileSystemOptions Opts;
+  Opts.StatPrefetchThreads = 2;
+  FileManager First(Opts, FS);
+  First.setSharedMissingPaths(Missing);
+  ASSERT_TRUE(First.canPrefetchFiles());
+  First.prefetchFiles({"/a/foo.h", "/b/foo.h", "/c/foo.h"});
+  EXPECT_EQ(nullptr, First.getFile("/a/foo.h"));
+  const FileEntry *File = First.getFile("/b/foo.h");
+  ASSERT_TRUE(File != nullptr);
+  EXPECT_EQ("/b/foo.h", StringRef(File->getName()));
+  EXPECT_EQ(nullptr, First.getFile("/c/foo.h"));
+  EXPECT_TRUE(Missing->contains("/a/foo.h"));
+  EXPECT_FALSE(Missing->contains("/b/foo.h"));
+
+  // The second manager does not look up the missing path again, even though
+  // it now exists.
+  FS->addFile("/a/foo.h", 0, llvm::MemoryBuffer::getMemBuffer(""));
+  FileManager Second(FileSystemOptions(), FS);
+  Second.setSharedMissingPaths(Missing);
+  EXPECT_EQ(nullptr, Second.getFile("/a/foo.h"));
+  EXPECT_NE(nullptr, Second.getFile("/b/foo.h"));
+}
+
 #endif  // !LLVM_ON_WIN32
 
 } // anonymous namespace
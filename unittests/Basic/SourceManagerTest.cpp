@@ -171,6 +171,32 @@ TEST_F(SourceManagerTest, getColumnNumber) {
   EXPECT_EQ(1U, SourceMgr.getColumnNumber(MainFileID, 0, nullptr));
 }
 
+TEST_F(SourceManagerTest, getColumnNumberFromLineOffsets) {
+  std::string Source = "int x;\r\n" + std::string(100, ' ') + "int y;\n" +
+                       std::string(50, ' ') + "int z;";
+
+  std::unique_ptr<llvm::MemoryBuffer> Buf =
+      llvm::MemoryBuffer::getMemBufferCopy(Source);
+  FileID MainFileID = SourceMgr.createFileID(std::move(Buf));
+  SourceMgr.setMainFileID(MainFileID);
+
+  // Computing a line number computes the line offsets of the file, which the
+  // columns of all the lines are then found from.
+  EXPECT_EQ(2U, SourceMgr.getLineNumber(MainFileID, 8));
+
+  unsigned Y = Source.find("y");
+  unsigned Z = Source.find("z");
+  EXPECT_EQ(105U, SourceMgr.getColumnNumber(MainFileID, Y));
+  EXPECT_EQ(55U, SourceMgr.getColumnNumber(MainFileID, Z));
+  EXPECT_EQ(5U, SourceMgr.getColumnNumber(MainFileID, 4));
+  EXPECT_EQ(57U, SourceMgr.getColumnNumber(MainFileID, Source.size()));
+
+  // The last line extends to the end of the file.
+  EXPECT_EQ(3U, SourceMgr.getLineNumber(MainFileID, Z));
+  EXPECT_EQ(55U, SourceMgr.getColumnNumber(MainFileID, Z));
+  EXPECT_EQ(57U, SourceMgr.getColumnNumber(MainFileID, Source.size()));
+}
+
 #if defined(LLVM_ON_UNIX)
 
 TEST_F(SourceManagerTest, getMacroArgExpandedLocation) {
@@ -656,6 +656,171 @@ TEST_F(InMemoryFileSystemTest, WorkingDirectory) {
                       NormalizedFS.getCurrentWorkingDirectory().get()));
 }
 
+TEST(SharedCacheFileSystemTest, SharesStatusAndContents) {
+  IntrusiveRefCntPtr<vfs::InMemoryFileSystem> External(
+      new vfs::InMemoryFileSystem);
+  External->addFile("/a/x.h", 0, MemoryBuffer::getMemBuffer("int x;"));
+  External->addFile("/b/y.h", 0, MemoryBuffer::getMemBuffer("int y;"));
+  IntrusiveRefCntPtr<vfs::SharedFileCache> Cache(new vfs::SharedFileCache);
+
+  // Each file system resolves relative paths against its own directory.
+  vfs::SharedCacheFileSystem First(Cache, External);
+  vfs::SharedCacheFileSystem Second(Cache, External);
+  ASSERT_FALSE(First.setCurrentWorkingDirectory("/a"));
+  ASSERT_FALSE(Second.setCurrentWorkingDirectory("/b"));
+  ASSERT_EQ("/b", *Second.getCurrentWorkingDirectory());
+
+  auto Stat = First.status("x.h");
+  ASSERT_FALSE(Stat.getError());
+  EXPECT_EQ("x.h", Stat->getName());
+  EXPECT_TRUE(First.status("y.h").getError());
+  EXPECT_FALSE(Second.status("y.h").getError());
+
+  auto FirstBuffer = First.getBufferForFile("x.h");
+  auto SecondBuffer = Second.getBufferForFile("/a/x.h");
+  ASSERT_FALSE(FirstBuffer.getError());
+  ASSERT_FALSE(SecondBuffer.getError());
+  EXPECT_EQ("int x;", (*FirstBuffer)->getBuffer());
+  EXPECT_EQ((*FirstBuffer)->getBufferStart(),
+            (*SecondBuffer)->getBufferStart());
+
+  // The results are not looked up again.
+  External->addFile("/a/y.h", 0, MemoryBuffer::getMemBuffer("int z;"));
+  EXPECT_TRUE(Second.status("/a/y.h").getError());
+}
+
+static IntrusiveRefCntPtr<vfs::FileSystem>
+getArchiveFS(vfs::ArchiveFileSystemWriter &Writer) {
+  std::string Archive;
+  raw_string_ostream OS(Archive);
+  Writer.write(OS);
+  return vfs::getVFSFromArchive(MemoryBuffer::getMemBufferCopy(OS.str()));
+}
+
+TEST(ArchiveFileSystemTest, StatusAndContents) {
+  vfs::ArchiveFileSystemWriter Writer;
+  Writer.addFile("/a/b/c.h", "int c;", 10);
+  Writer.addFile("/a/d.h", "int d;");
+  Writer.addFile("/a.h", "");
+  IntrusiveRefCntPtr<vfs::FileSystem> FS = getArchiveFS(Writer);
+  ASSERT_TRUE(FS);
+
+  auto Stat = FS->status("/a/b/c.h");
+  ASSERT_FALSE(Stat.getError());
+  EXPECT_EQ("/a/b/c.h", Stat->getName());
+  EXPECT_TRUE(Stat->isRegularFile());
+  EXPECT_EQ(6u, Stat->getSize());
+  EXPECT_EQ(sys::toTimePoint(10), Stat->getLastModificationTime());
+  EXPECT_EQ(FS->status("/a/./b/c.h")->getUniqueID(), Stat->getUniqueID());
+  EXPECT_NE(FS->status("/a/d.h")->getUniqueID(), Stat->getUniqueID());
+
+  for (const char *Dir : {"/", "/a", "/a/b", "/a/b/"}) {
+    Stat = FS->status(Dir);
+    ASSERT_FALSE(Stat.getError()) << Dir;
+    EXPECT_TRUE(Stat->isDirectory()) << Dir;
+  }
+  EXPECT_EQ(errc::no_such_file_or_directory, FS->status("/a/b/c").getError());
+  EXPECT_EQ(errc::no_such_file_or_directory,
+            FS->status("/a/b/c.h/e").getError());
+  EXPECT_EQ(errc::no_such_file_or_directory, FS->status("/b").getError());
+
+  // The buffers point into the archive, and are null terminated.
+  auto File = FS->openFileForRead("/a/d.h");
+  ASSERT_FALSE(File.getError());
+  auto Buffer = (*File)->getBuffer("d.h", -1, /*RequiresNullTerminator=*/true);
+  ASSERT_FALSE(Buffer.getError());
+  EXPECT_EQ("int d;", (*Buffer)->getBuffer());
+  EXPECT_EQ(*(*Buffer)->getBufferEnd(), '\0');
+  auto Again = FS->getBufferForFile("/a/d.h");
+  ASSERT_FALSE(Again.getError());
+  EXPECT_EQ((*Buffer)->getBufferStart(), (*Again)->getBufferStart());
+  EXPECT_EQ("", (*FS->getBufferForFile("/a.h"))->getBuffer());
+
+  EXPECT_EQ(errc::invalid_argument, FS->openFileForRead("/a").getError());
+}
+
+TEST(ArchiveFileSystemTest, DirectoryIteration) {
+  vfs::ArchiveFileSystemWriter Writer;
+  Writer.addFile("/a/b/c.h", "");
+  Writer.addFile("/a/b/d/e.h", "");
+  Writer.addFile("/a/f.h", "");
+  Writer.addFile("/a.h", "");
+  IntrusiveRefCntPtr<vfs::FileSystem> FS = getArchiveFS(Writer);
+  ASSERT_TRUE(FS);
+
+  std::error_code EC;
+  vfs::directory_iterator I = FS->dir_begin("/a", EC);
+  ASSERT_FALSE(EC);
+  ASSERT_EQ("/a/b", I->getName());
+  ASSERT_TRUE(I->isDirectory());
+  I.increment(EC);
+  ASSERT_FALSE(EC);
+  ASSERT_EQ("/a/f.h", I->getName());
+  ASSERT_TRUE(I->isRegularFile());
+  I.increment(EC);
+  ASSERT_FALSE(EC);
+  ASSERT_EQ(vfs::directory_iterator(), I);
+
+  std::vector<std::string> Names;
+  for (vfs::recursive_directory_iterator R(*FS, "/", EC), E; !EC && R != E;
+       R.increment(EC))
+    Names.push_back(R->getName());
+  ASSERT_FALSE(EC);
+  EXPECT_EQ((std::vector<std::string>{"/a.h", "/a", "/a/b", "/a/b/c.h",
+                                      "/a/b/d", "/a/b/d/e.h", "/a/f.h"}),
+            Names);
+
+  FS->dir_begin("/a/f.h", EC);
+  EXPECT_EQ(errc::not_a_directory, EC);
+  FS->dir_begin("/b", EC);
+  EXPECT_EQ(errc::no_such_file_or_directory, EC);
+}
+
+TEST(ArchiveFileSystemTest, WorkingDirectory) {
+  vfs::ArchiveFileSystemWriter Writer;
+  Writer.addFile("/a/b.h", "int b;");
+  IntrusiveRefCntPtr<vfs::FileSystem> FS = getArchiveFS(Writer);
+  ASSERT_TRUE(FS);
+
+  ASSERT_FALSE(FS->setCurrentWorkingDirectory("/a"));
+  ASSERT_EQ("/a", *FS->getCurrentWorkingDirectory());
+  auto Stat = FS->status("b.h");
+  ASSERT_FALSE(Stat.getError());
+  EXPECT_EQ("b.h", Stat->getName());
+  EXPECT_EQ("int b;", (*FS->getBufferForFile("../a/b.h"))->getBuffer());
+
+  // The working directory of an overlay may not be in the archive.
+  ASSERT_FALSE(FS->setCurrentWorkingDirectory("/c"));
+  EXPECT_TRUE(FS->status("b.h").getError());
+}
+
+TEST(ArchiveFileSystemTest, InvalidArchive) {
+  vfs::ArchiveFileSystemWriter Writer;
+  Writer.addFile("/a.h", "int a;");
+  std::string Archive;
+  raw_string_ostream OS(Archive);
+  Writer.write(OS);
+  OS.flush();
+
+  EXPECT_TRUE(vfs::getVFSFromArchive(MemoryBuffer::getMemBufferCopy(Archive)));
+  EXPECT_FALSE(vfs::getVFSFromArchive(MemoryBuffer::getMemBufferCopy("")));
+  EXPECT_FALSE(vfs::getVFSFromArchive(
+      MemoryBuffer::getMemBufferCopy("int a;\n")));
+  // The archive is cut before the end of the file.
+  EXPECT_FALSE(vfs::getVFSFromArchive(
+      MemoryBuffer::getMemBufferCopy(StringRef(Archive).drop_back(2))));
+  // The file is not followed by a null byte.
+  Archive.back() = 'x';
+  EXPECT_FALSE(vfs::getVFSFromArchive(MemoryBuffer::getMemBufferCopy(Archive)));
+
+  // A file cannot be the directory of another.
+  vfs::ArchiveFileSystemWriter Nested;
+  Nested.addFile("/a", "");
+  Nested.addFile("/a.h", "");
+  Nested.addFile("/a/b.h", "");
+  EXPECT_FALSE(getArchiveFS(Nested));
+}
+
 // NOTE: in the tests below, we use '//root/' as our root directory, since it is
 // a legal *absolute* path on Windows as well as *nix.
 class VFSFromYAMLTest : public ::testing::Test {
@@ -0,0 +1,97 @@
+//===- unittest/Format/FormatSessionTest.cpp - Incremental formatting -----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Format/Format.h"
+
+#include "llvm/Support/Error.h"
+#include "gtest/gtest.h"
+
+namespace clang {
+namespace format {
+namespace {
+
+class FormatSessionTest : public ::testing::Test {
+protected:
+  // Formats \p Length characters at \p Offset of the session's code and checks
+  // that the result is the same as the one of reformat().
+  void verifyFormat(FormatSession &Session, unsigned Offset, unsigned Length,
+                    const FormatStyle &Style = getLLVMStyle()) {
+    StringRef Code = Session.getCode();
+    std::vector<tooling::Range> Ranges(1, tooling::Range(Offset, Length));
+    auto Expected = applyAllReplacements(Code, reformat(Style, Code, Ranges));
+    auto Actual = applyAllReplacements(Code, Session.format(Ranges));
+    ASSERT_TRUE(static_cast<bool>(Expected));
+    ASSERT_TRUE(static_cast<bool>(Actual));
+    EXPECT_EQ(*Expected, *Actual);
+  }
+
+  void applyEdit(FormatSession &Session, unsigned Offset, unsigned Length,
+                 StringRef Text) {
+    tooling::Replacements Edits(
+        tooling::Replacement("<stdin>", Offset, Length, Text));
+    EXPECT_FALSE(static_cast<bool>(Session.applyEdits(Edits)));
+  }
+
+  const std::string Code = "int  a;\n"
+                           "\n"
+                           "void f(int *x) {\n"
+                           "  g(  x);\n"
+                           "}\n"
+                           "\n"
+                           "namespace n {\n"
+                           "\n"
+                           "int  b;\n"
+                           "\n"
+                           "}\n"
+                           "\n"
+                           "#if A\n"
+                           "\n"
+                           "int  c;\n"
+                           "#endif\n"
+                           "\n"
+                           "int  d = 1; // comment\n";
+};
+
+TEST_F(FormatSessionTest, FormatsLikeReformat) {
+  FormatSession Session(getLLVMStyle(), Code);
+  verifyFormat(Session, 0, Code.size());
+  for (unsigned Offset = 0; Offset < Code.size(); Offset += 5)
+    verifyFormat(Session, Offset, 0);
+}
+
+TEST_F(FormatSessionTest, FormatsAfterEdits) {
+  FormatSession Session(getLLVMStyle(), Code);
+  applyEdit(Session, Code.find("g("), 0, "h( x ); ");
+  verifyFormat(Session, 0, Session.getCode().size());
+  verifyFormat(Session, Session.getCode().find("h("), 1);
+
+  // Opening a brace joins the chunks after it.
+  applyEdit(Session, 0, 0, "struct S {\n");
+  verifyFormat(Session, 0, Session.getCode().size());
+  verifyFormat(Session, Session.getCode().find("int  d"), 0);
+
+  applyEdit(Session, 0, 11, "");
+  EXPECT_EQ(Code.size() + 8, Session.getCode().size());
+  verifyFormat(Session, Session.getCode().find("int  b"), 0);
+}
+
+TEST_F(FormatSessionTest, DerivesStyleFromWholeFile) {
+  FormatStyle Style = getLLVMStyle();
+  Style.DerivePointerAlignment = true;
+  FormatSession Session(Style, "int* a;\n"
+                               "\n"
+                               "int* b;\n"
+                               "\n"
+                               "int *c;\n");
+  verifyFormat(Session, Session.getCode().find("*c"), 0, Style);
+}
+
+} // end namespace
+} // end namespace format
+} // end namespace clang
@@ -128,6 +128,27 @@ TEST_F(FormatTest, FormatsNestedBlockStatements) {
   EXPECT_EQ("{\n  {\n    {}\n  }\n}", format("{{{}}}"));
 }
 
+TEST_F(FormatTest, FormatsConcurrently) {
+  std::string Code;
+  for (unsigned i = 0; i != 50; ++i)
+    Code += "int a" + std::to_string(i) + " = 1;\n"
+            "int  bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb = 2; // comment\n"
+            "void f" + std::to_string(i) +
+            "(int aaaaaaaaaaaaaaaaaaaaa, int bbbbbbbbbbbbbbbbbbbbbbbbbbb) {\n"
+            "  g(aaaaaaaaaaaaaaaaaaaaa, bbbbbbbbbbbbbbbbbbbbbbbbbbb, [] { h(); "
+            "});\n}\n";
+  FormatStyle Style = getLLVMStyle();
+  Style.AlignConsecutiveAssignments = true;
+  std::vector<tooling::Range> Ranges(1, tooling::Range(0, Code.size()));
+  auto Sequential =
+      applyAllReplacements(Code, reformat(Style, Code, Ranges, "<stdin>"));
+  auto Concurrent = applyAllReplacements(
+      Code, reformat(Style, Code, Ranges, "<stdin>", nullptr, /*Threads=*/4));
+  ASSERT_TRUE(static_cast<bool>(Sequential));
+  ASSERT_TRUE(static_cast<bool>(Concurrent));
+  EXPECT_EQ(*Sequential, *Concurrent);
+}
+
 TEST_F(FormatTest, FormatsNestedCall) {
   verifyFormat("Method(f1, f2(f3));");
   verifyFormat("Method(f1(f2, f3()));");
@@ -10967,6 +10988,32 @@ TEST(FormatStyle, GetStyleOfFile) {
   ASSERT_EQ(Style3, getGoogleStyle());
 }
 
+TEST(FormatStyle, GetStyleFromCache) {
+  vfs::InMemoryFileSystem FS;
+  ASSERT_TRUE(
+      FS.addFile("/a/.clang-format", 0,
+                 llvm::MemoryBuffer::getMemBuffer("BasedOnStyle: Google")));
+  ASSERT_TRUE(FS.addFile("/a/sub/test.cpp", 0,
+                         llvm::MemoryBuffer::getMemBuffer("int i;")));
+  ASSERT_TRUE(FS.addFile("/a/sub/test.js", 0,
+                         llvm::MemoryBuffer::getMemBuffer("var i;")));
+  ASSERT_TRUE(
+      FS.addFile("/b/test.cpp", 0, llvm::MemoryBuffer::getMemBuffer("int i;")));
+
+  StyleCache Styles("file", "Mozilla", &FS);
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ(getStyle("file", "/a/sub/test.cpp", "Mozilla", "", &FS),
+              Styles.getStyle("/a/sub/test.cpp"));
+    EXPECT_EQ(getStyle("file", "/a/sub/test.js", "Mozilla", "", &FS),
+              Styles.getStyle("/a/sub/test.js"));
+    EXPECT_EQ(getMozillaStyle(), Styles.getStyle("/b/test.cpp"));
+  }
+  // The ObjC detection of headers still looks at the code.
+  EXPECT_EQ(FormatStyle::LK_ObjC,
+            Styles.getStyle("/a/sub/test.h", "\n- (void)f;").Language);
+  EXPECT_EQ(FormatStyle::LK_Cpp, Styles.getStyle("/a/sub/test.h").Language);
+}
+
 TEST_F(ReplacementTest, FormatCodeAfterReplacements) {
   // Column limit is 20.
   std::string Code = "Type *a =\n"
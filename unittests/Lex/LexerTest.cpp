@@ -380,4 +380,31 @@ TEST_F(LexerTest, DontMergeMacroArgsFromDifferentMacroFiles) {
   EXPECT_EQ(SourceMgr.getFileIDSize(SourceMgr.getFileID(helper1ArgLoc)), 8U);
 }
 
+TEST_F(LexerTest, LongTokensAndWhitespace) {
+  // Identifiers, whitespace and literals spanning several 16 byte blocks, that
+  // end in each kind of character that stops them.
+  std::vector<tok::TokenKind> ExpectedTokens;
+  ExpectedTokens.push_back(tok::identifier);
+  ExpectedTokens.push_back(tok::identifier);
+  ExpectedTokens.push_back(tok::string_literal);
+  ExpectedTokens.push_back(tok::comma);
+  ExpectedTokens.push_back(tok::char_constant);
+  ExpectedTokens.push_back(tok::identifier);
+  ExpectedTokens.push_back(tok::string_literal);
+  ExpectedTokens.push_back(tok::semi);
+  std::vector<Token> toks = CheckLex(
+      "abcdefghijklmnopqrstuvwxyz_ABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789\t\f"
+      "                                    \v  x\n"
+      "\"a string literal that is longer than a vector\\\" with \\n escapes\","
+      "'abcdefghijklmnopqrstuvwxyz' "
+      "identifier_with_a_long_name_that_ends_in$"
+      "\"??/\";",
+      ExpectedTokens);
+  EXPECT_EQ(64U, toks[0].getLength());
+  EXPECT_EQ(1U, toks[1].getLength());
+  EXPECT_EQ(65U, toks[2].getLength());
+  EXPECT_EQ(28U, toks[4].getLength());
+  EXPECT_EQ(41U, toks[5].getLength());
+}
+
 } // anonymous namespace
@@ -0,0 +1,138 @@
+//===- unittests/Lex/PreprocessingRecordTest.cpp - PP record tests --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Lex/PreprocessingRecord.h"
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/DiagnosticOptions.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/LangOptions.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Basic/TargetInfo.h"
+#include "clang/Basic/TargetOptions.h"
+#include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/HeaderSearchOptions.h"
+#include "clang/Lex/ModuleLoader.h"
+#include "clang/Lex/Preprocessor.h"
+#include "clang/Lex/PreprocessorOptions.h"
+#include "gtest/gtest.h"
+
+using namespace clang;
+
+namespace {
+
+// The test fixture.
+class PreprocessingRecordTest : public ::testing::Test {
+protected:
+  PreprocessingRecordTest()
+    : FileMgr(FileMgrOpts),
+      DiagID(new DiagnosticIDs()),
+      Diags(DiagID, new DiagnosticOptions, new IgnoringDiagConsumer()),
+      SourceMgr(Diags, FileMgr),
+      TargetOpts(new TargetOptions)
+  {
+    TargetOpts->Triple = "x86_64-apple-darwin11.1.0";
+    Target = TargetInfo::CreateTargetInfo(Diags, TargetOpts);
+  }
+
+  FileSystemOptions FileMgrOpts;
+  FileManager FileMgr;
+  IntrusiveRefCntPtr<DiagnosticIDs> DiagID;
+  DiagnosticsEngine Diags;
+  SourceManager SourceMgr;
+  LangOptions LangOpts;
+  std::shared_ptr<TargetOptions> TargetOpts;
+  IntrusiveRefCntPtr<TargetInfo> Target;
+};
+
+class VoidModuleLoader : public ModuleLoader {
+  ModuleLoadResult loadModule(SourceLocation ImportLoc, 
+                              ModuleIdPath Path,
+                              Module::NameVisibilityKind Visibility,
+                              bool IsInclusionDirective) override {
+    return ModuleLoadResult();
+  }
+
+  void makeModuleVisible(Module *Mod,
+                         Module::NameVisibilityKind Visibility,
+                         SourceLocation ImportLoc) override { }
+
+  GlobalModuleIndex *loadGlobalModuleIndex(SourceLocation TriggerLoc) override
+    { return nullptr; }
+  bool lookupMissingImports(StringRef Name, SourceLocation TriggerLoc) override
+    { return 0; }
+};
+
+// Macro expansions are stored compactly until they are retrieved, and are
+// still found in source order, including those recorded out of order.
+TEST_F(PreprocessingRecordTest, MacroExpansionsInRange) {
+  const char *source =
+      "#define M1 1\n"
+      "#define M2 2\n"
+      "#define FM(x, y) y x\n"
+      "FM(M1, M2) M1 __LINE__\n";
+
+  std::unique_ptr<llvm::MemoryBuffer> Buf =
+      llvm::MemoryBuffer::getMemBuffer(source);
+  FileID MainFID = SourceMgr.createFileID(std::move(Buf));
+  SourceMgr.setMainFileID(MainFID);
+
+  VoidModuleLoader ModLoader;
+  HeaderSearch HeaderInfo(new HeaderSearchOptions, SourceMgr, Diags, LangOpts,
+                          Target.get());
+  Preprocessor PP(new PreprocessorOptions(), Diags, LangOpts, SourceMgr,
+                  HeaderInfo, ModLoader,
+                  /*IILookup =*/nullptr,
+                  /*OwnsHeaderSearch =*/false);
+  PP.Initialize(*Target);
+  PP.createPreprocessingRecord();
+  PP.EnterMainSourceFile();
+
+  std::vector<Token> toks;
+  while (1) {
+    Token tok;
+    PP.Lex(tok);
+    if (tok.is(tok::eof))
+      break;
+    toks.push_back(tok);
+  }
+  ASSERT_EQ(4U, toks.size());
+
+  PreprocessingRecord &PPRec = *PP.getPreprocessingRecord();
+  SourceRange MainRange(SourceMgr.getLocForStartOfFile(MainFID),
+                        SourceMgr.getLocForEndOfFile(MainFID));
+  std::vector<std::string> Expanded;
+  SourceLocation Last;
+  for (PreprocessedEntity *PPE :
+       PPRec.getPreprocessedEntitiesInRange(MainRange)) {
+    SourceLocation Begin = PPE->getSourceRange().getBegin();
+    EXPECT_FALSE(Last.isValid() &&
+                 SourceMgr.isBeforeInTranslationUnit(Begin, Last));
+    Last = Begin;
+    if (auto *Expansion = dyn_cast<MacroExpansion>(PPE))
+      Expanded.push_back(Expansion->getName()->getName());
+  }
+  ASSERT_EQ(5U, Expanded.size());
+  EXPECT_EQ("FM", Expanded[0]);
+  EXPECT_EQ("M1", Expanded[1]);
+  EXPECT_EQ("M2", Expanded[2]);
+  EXPECT_EQ("M1", Expanded[3]);
+  EXPECT_EQ("__LINE__", Expanded[4]);
+
+  // The definition of an expansion is the one of the expanded macro.
+  auto Entities = PPRec.getPreprocessedEntitiesInRange(MainRange);
+  for (auto I = Entities.begin(), E = Entities.end(); I != E; ++I) {
+    EXPECT_TRUE(PPRec.isEntityInFileID(I, MainFID));
+    if (auto *Expansion = dyn_cast<MacroExpansion>(*I))
+      if (!Expansion->isBuiltinMacro())
+        EXPECT_EQ(Expansion->getName(),
+                  Expansion->getDefinition()->getName());
+  }
+}
+
+} // anonymous namespace
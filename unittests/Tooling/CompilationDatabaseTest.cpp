@@ -15,6 +15,7 @@
 #include "clang/Tooling/Tooling.h"
 #include "llvm/Support/Path.h"
 #include "gtest/gtest.h"
+#include <algorithm>
 
 namespace clang {
 namespace tooling {
@@ -25,6 +26,10 @@ static void expectFailure(StringRef JSONDatabase, StringRef Explanation) {
             JSONCompilationDatabase::loadFromBuffer(JSONDatabase, ErrorMessage,
                                                     JSONCommandLineSyntax::Gnu))
       << "Expected an error because of: " << Explanation.str();
+  EXPECT_EQ(nullptr, JSONCompilationDatabase::loadFromBuffer(
+                         JSONDatabase, ErrorMessage, JSONCommandLineSyntax::Gnu,
+                         JSONDatabaseLoading::Lazy))
+      << "Expected a lazy error because of: " << Explanation.str();
 }
 
 TEST(JSONCompilationDatabase, ErrsOnInvalidFormat) {
@@ -195,6 +200,84 @@ TEST(JSONCompilationDatabase, ArgumentsPreferredOverCommand) {
    EXPECT_EQ(Arguments, FoundCommand.CommandLine[0]) << ErrorMessage;
 }
 
+TEST(JSONCompilationDatabase, LazyLoadingFindsTheSameCommands) {
+  std::string Database =
+      "[{\"directory\":\"//net/dir\",\"command\":\"cc -c a.cc\","
+      "\"file\":\"a.cc\",\"output\":\"a.o\"},\n"
+      " {\"directory\":\"//net/dir\","
+      "\"arguments\":[\"cc\", \"-DX=\\\"\\u00e9\\\"\"],"
+      "\"file\":\"//net/dir/b\\/b.cc\"},\n"
+      " {\"directory\":\"//net/d\\u00edr\",\"command\":\"cc\\tc.cc\","
+      "\"file\":\"c.cc\"},\n"
+      " {\"directory\":\"//net/dir\",\"command\":\"cc -DY a.cc\","
+      "\"file\":\"a.cc\"}]";
+  std::string ErrorMessage;
+  std::unique_ptr<JSONCompilationDatabase> Eager(
+      JSONCompilationDatabase::loadFromBuffer(Database, ErrorMessage,
+                                              JSONCommandLineSyntax::Gnu));
+  ASSERT_TRUE(Eager) << ErrorMessage;
+  std::unique_ptr<JSONCompilationDatabase> Lazy(
+      JSONCompilationDatabase::loadFromBuffer(Database, ErrorMessage,
+                                              JSONCommandLineSyntax::Gnu,
+                                              JSONDatabaseLoading::Lazy));
+  ASSERT_TRUE(Lazy) << ErrorMessage;
+
+  std::vector<std::string> Files = Eager->getAllFiles();
+  std::sort(Files.begin(), Files.end());
+  std::vector<std::string> LazyFiles = Lazy->getAllFiles();
+  std::sort(LazyFiles.begin(), LazyFiles.end());
+  EXPECT_EQ(Files, LazyFiles);
+  EXPECT_EQ(3u, Files.size());
+
+  auto ExpectSameCommands = [](const std::vector<CompileCommand> &Expected,
+                               const std::vector<CompileCommand> &Actual) {
+    ASSERT_EQ(Expected.size(), Actual.size());
+    for (unsigned I = 0, E = Expected.size(); I != E; ++I) {
+      EXPECT_EQ(Expected[I].Directory, Actual[I].Directory);
+      EXPECT_EQ(Expected[I].Filename, Actual[I].Filename);
+      EXPECT_EQ(Expected[I].CommandLine, Actual[I].CommandLine);
+      EXPECT_EQ(Expected[I].Output, Actual[I].Output);
+    }
+  };
+  for (const std::string &File : Files)
+    ExpectSameCommands(Eager->getCompileCommands(File),
+                       Lazy->getCompileCommands(File));
+  ExpectSameCommands(Eager->getAllCompileCommands(),
+                     Lazy->getAllCompileCommands());
+  EXPECT_EQ(2u, Lazy->getCompileCommands("//net/dir/a.cc").size());
+}
+
+TEST(JSONCompilationDatabase, ShardsFiles) {
+  std::string Database = "[";
+  for (int I = 0; I < 10; ++I) {
+    std::string N = std::to_string(I);
+    Database += "{\"directory\":\"//net/dir\","
+                "\"command\":\"cc -I" + std::string(I % 2 ? "odd" : "even") +
+                " f" + N + ".cc\",\"file\":\"f" + N + ".cc\"},";
+  }
+  Database.back() = ']';
+  std::string ErrorMessage;
+  std::unique_ptr<JSONCompilationDatabase> Compilations(
+      JSONCompilationDatabase::loadFromBuffer(Database, ErrorMessage,
+                                              JSONCommandLineSyntax::Gnu));
+  ASSERT_TRUE(Compilations) << ErrorMessage;
+
+  std::vector<std::string> AllFiles;
+  for (unsigned Shard = 0; Shard < 2; ++Shard) {
+    std::vector<std::string> Files = getShardFiles(*Compilations, 2, Shard);
+    EXPECT_EQ(5u, Files.size());
+    // The files with the same include paths are on the same shard.
+    auto Parity = [](StringRef File) { return (File.end()[-4] - '0') % 2; };
+    for (const std::string &File : Files)
+      EXPECT_EQ(Parity(Files.front()), Parity(File)) << File;
+    AllFiles.insert(AllFiles.end(), Files.begin(), Files.end());
+  }
+  std::vector<std::string> Expected = Compilations->getAllFiles();
+  std::sort(Expected.begin(), Expected.end());
+  std::sort(AllFiles.begin(), AllFiles.end());
+  EXPECT_EQ(Expected, AllFiles);
+}
+
 struct FakeComparator : public PathComparator {
   ~FakeComparator() override {}
   bool equivalent(StringRef FileA, StringRef FileB) const override {
@@ -464,6 +464,27 @@ TEST_F(ReplacementTest, AdjacentReplacements) {
   EXPECT_EQ("xy", Context.getRewrittenText(ID));
 }
 
+TEST(ApplyReplacementsToCodeTest, AppliesAllReplacements) {
+  Replacements Replaces = toReplacements(
+      {Replacement("x.cc", 0, 0, "// "), Replacement("x.cc", 6, 6, ""),
+       Replacement("x.cc", 6, 0, "other\n"),
+       Replacement("x.cc", 18, 5, "last")});
+  auto Code = applyAllReplacements("line1\nline2\nline3\nline4", Replaces);
+  EXPECT_TRUE(static_cast<bool>(Code));
+  EXPECT_EQ("// line1\nother\nline3\nlast", *Code);
+}
+
+TEST(ApplyReplacementsToCodeTest, FailsOutOfRange) {
+  auto Code = applyAllReplacements(
+      "line1", toReplacements({Replacement("x.cc", 3, 3, "")}));
+  EXPECT_FALSE(static_cast<bool>(Code));
+  llvm::consumeError(Code.takeError());
+  Code = applyAllReplacements(
+      "line1", toReplacements({Replacement("x.cc", 5, 0, "\n")}));
+  EXPECT_TRUE(static_cast<bool>(Code));
+  EXPECT_EQ("line1\n", *Code);
+}
+
 TEST_F(ReplacementTest, AddDuplicateReplacements) {
   FileID ID = Context.createInMemoryFile("input.cpp",
                                          "line1\nline2\nline3\nline4");
@@ -644,6 +665,23 @@ TEST_F(FlushRewrittenFilesTest, StoresChangesOnDisk) {
             getFileContentFromDisk("input.cpp"));
 }
 
+TEST_F(FlushRewrittenFilesTest, AppliesReplacementsToFiles) {
+  std::map<std::string, Replacements> FileToReplaces;
+  for (unsigned I = 0; I != 8; ++I) {
+    std::string Name = "input" + std::to_string(I) + ".cpp";
+    createFile(Name, "line1\nline2\nline3\nline4");
+    std::string Path = TemporaryFiles.lookup(Name);
+    FileToReplaces[Path] =
+        toReplacements({Replacement(Path, 6, 5, "replaced"),
+                        Replacement(Path, 18, 5, std::to_string(I))});
+  }
+  EXPECT_TRUE(applyAllReplacementsToFiles(Context.Files, FileToReplaces,
+                                          /*Threads=*/4));
+  for (unsigned I = 0; I != 8; ++I)
+    EXPECT_EQ("line1\nreplaced\nline3\n" + std::to_string(I),
+              getFileContentFromDisk("input" + std::to_string(I) + ".cpp"));
+}
+
 namespace {
 template <typename T>
 class TestVisitor : public clang::RecursiveASTVisitor<T> {
@@ -1089,5 +1127,38 @@ TEST(DeduplicateByFileTest, NonExistingFilePath) {
   EXPECT_TRUE(FileToReplaces.empty());
 }
 
+TEST(MergeShardReplacementsTest, KeepsSharedReplacementsOnce) {
+  std::map<std::string, Replacements> Shard1;
+  std::map<std::string, Replacements> Shard2;
+  auto Err = Shard1["a.cc"].add(Replacement("a.cc", 0, 1, "x"));
+  EXPECT_TRUE(!Err);
+  Err = Shard1["c.h"].add(Replacement("c.h", 3, 0, "y"));
+  EXPECT_TRUE(!Err);
+  Err = Shard2["b.cc"].add(Replacement("b.cc", 0, 1, "z"));
+  EXPECT_TRUE(!Err);
+  Err = Shard2["c.h"].add(Replacement("c.h", 3, 0, "y"));
+  EXPECT_TRUE(!Err);
+  Err = Shard2["c.h"].add(Replacement("c.h", 5, 2, "w"));
+  EXPECT_TRUE(!Err);
+
+  std::string Text;
+  llvm::raw_string_ostream OS(Text);
+  writeReplacements(OS, Shard2);
+  std::map<std::string, Replacements> Merged = Shard1;
+  Err = readReplacements(OS.str(), Merged);
+  EXPECT_TRUE(!Err);
+  EXPECT_EQ(3u, Merged.size());
+  EXPECT_EQ(Shard1["a.cc"], Merged["a.cc"]);
+  EXPECT_EQ(Shard2["b.cc"], Merged["b.cc"]);
+  EXPECT_EQ(Shard2["c.h"], Merged["c.h"]);
+
+  std::map<std::string, Replacements> Conflicting;
+  Err = Conflicting["c.h"].add(Replacement("c.h", 3, 0, "v"));
+  EXPECT_TRUE(!Err);
+  Err = mergeReplacements(Merged, Conflicting);
+  EXPECT_TRUE((bool)Err);
+  llvm::consumeError(std::move(Err));
+}
+
 } // end namespace tooling
 } // end namespace clang
@@ -499,6 +499,26 @@ TEST(ClangToolTest, BuildASTs) {
   EXPECT_EQ(2u, ASTs.size());
 }
 
+TEST(ClangToolTest, BuildASTsConcurrently) {
+  FixedCompilationDatabase Compilations("/", std::vector<std::string>());
+
+  std::vector<std::string> Sources;
+  for (char C = 'a'; C <= 'h'; ++C) {
+    std::string Name = std::string("/") + C + ".cc";
+    Sources.push_back(Name);
+  }
+  ClangTool Tool(Compilations, Sources);
+  Tool.mapVirtualFile("/common.h", "int common();");
+  for (const std::string &Source : Sources)
+    Tool.mapVirtualFile(Source, "#include \"common.h\"\nvoid f() {}");
+
+  std::vector<std::unique_ptr<ASTUnit>> ASTs;
+  EXPECT_EQ(0, Tool.buildASTs(ASTs, 4));
+  ASSERT_EQ(Sources.size(), ASTs.size());
+  for (unsigned I = 0, E = Sources.size(); I != E; ++I)
+    EXPECT_EQ(Sources[I], ASTs[I]->getMainFileName());
+}
+
 struct TestDiagnosticConsumer : public DiagnosticConsumer {
   TestDiagnosticConsumer() : NumDiagnosticsSeen(0) {}
   void HandleDiagnostic(DiagnosticsEngine::Level DiagLevel,
@@ -520,6 +540,24 @@ TEST(ClangToolTest, InjectDiagnosticConsumer) {
   EXPECT_EQ(1u, Consumer.NumDiagnosticsSeen);
 }
 
+TEST(ClangToolTest, InjectDiagnosticConsumerConcurrently) {
+  FixedCompilationDatabase Compilations("/", std::vector<std::string>());
+  std::vector<std::string> Sources;
+  Sources.push_back("/a.cc");
+  Sources.push_back("/b.cc");
+  Sources.push_back("/c.cc");
+  ClangTool Tool(Compilations, Sources);
+  Tool.mapVirtualFile("/a.cc", "int x = undeclared;");
+  Tool.mapVirtualFile("/b.cc", "int y = undeclared;");
+  Tool.mapVirtualFile("/c.cc", "int z = 0;");
+  TestDiagnosticConsumer Consumer;
+  Tool.setDiagnosticConsumer(&Consumer);
+  std::unique_ptr<FrontendActionFactory> Action(
+      newFrontendActionFactory<SyntaxOnlyAction>());
+  EXPECT_EQ(1, Tool.run(Action.get(), 3));
+  EXPECT_EQ(2u, Consumer.NumDiagnosticsSeen);
+}
+
 TEST(ClangToolTest, InjectDiagnosticConsumerInBuildASTs) {
   FixedCompilationDatabase Compilations("/", std::vector<std::string>());
   ClangTool Tool(Compilations, std::vector<std::string>(1, "/a.cc"));
@@ -531,6 +569,24 @@ TEST(ClangToolTest, InjectDiagnosticConsumerInBuildASTs) {
   EXPECT_EQ(1u, ASTs.size());
   EXPECT_EQ(1u, Consumer.NumDiagnosticsSeen);
 }
+
+TEST(ClangToolTest, SkipFunctionBodiesOutsideMainFile) {
+  FixedCompilationDatabase Compilations("/", std::vector<std::string>());
+  ClangTool Tool(Compilations, std::vector<std::string>(1, "/a.cc"));
+  Tool.mapVirtualFile("/a.cc", "#include \"b.h\"\nint a() { return b(); }");
+  Tool.mapVirtualFile("/b.h", "inline int b() { return undeclared; }");
+  TestDiagnosticConsumer Consumer;
+  Tool.setDiagnosticConsumer(&Consumer);
+  std::unique_ptr<FrontendActionFactory> Action(
+      newFrontendActionFactory<SyntaxOnlyAction>());
+  Tool.run(Action.get());
+  EXPECT_EQ(1u, Consumer.NumDiagnosticsSeen);
+
+  Consumer.NumDiagnosticsSeen = 0;
+  Tool.appendArgumentsAdjuster(getSkipFunctionBodiesOutsideMainFileAdjuster());
+  EXPECT_EQ(0, Tool.run(Action.get()));
+  EXPECT_EQ(0u, Consumer.NumDiagnosticsSeen);
+}
 #endif
 
 } // end namespace tooling
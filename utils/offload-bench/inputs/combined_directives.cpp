@@ -0,0 +1,45 @@
+// Combined target directives in SPMD mode, with the schedules and clauses
+// that change the code generated for the loop.
+
+void saxpy(int n, float a, float *x, float *y) {
+#pragma omp target teams distribute parallel for map(to : x[:n]) map(tofrom : y[:n])
+  for (int i = 0; i < n; ++i)
+    y[i] = a * x[i] + y[i];
+}
+
+void saxpy_simd(int n, float a, float *x, float *y) {
+#pragma omp target teams distribute parallel for simd map(to : x[:n]) map(tofrom : y[:n])
+  for (int i = 0; i < n; ++i)
+    y[i] = a * x[i] + y[i];
+}
+
+void copy_static_chunked(int n, double *dst, double *src) {
+#pragma omp target teams distribute parallel for dist_schedule(static, 128) schedule(static, 1) map(to : src[:n]) map(from : dst[:n])
+  for (int i = 0; i < n; ++i)
+    dst[i] = src[i];
+}
+
+void matmul(int n, double *a, double *b, double *c) {
+#pragma omp target teams distribute parallel for collapse(2) map(to : a[:n * n], b[:n * n]) map(from : c[:n * n])
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j) {
+      double sum = 0;
+      for (int k = 0; k < n; ++k)
+        sum += a[i * n + k] * b[k * n + j];
+      c[i * n + j] = sum;
+    }
+}
+
+void stencil(int n, int m, float *in, float *out) {
+#pragma omp target teams distribute parallel for collapse(2) num_teams(256) thread_limit(128) map(to : in[:n * m]) map(from : out[:n * m])
+  for (int i = 1; i < n - 1; ++i)
+    for (int j = 1; j < m - 1; ++j)
+      out[i * m + j] = 0.25f * (in[(i - 1) * m + j] + in[(i + 1) * m + j] +
+                                in[i * m + j - 1] + in[i * m + j + 1]);
+}
+
+void scale_parallel(int n, float s, float *x) {
+#pragma omp target parallel for map(tofrom : x[:n])
+  for (int i = 0; i < n; ++i)
+    x[i] *= s;
+}
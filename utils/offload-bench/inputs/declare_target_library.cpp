@@ -0,0 +1,84 @@
+// A small device library in declare target regions, with the global
+// variables, templates and call chains that device-side Sema and codegen
+// have to follow from the target regions that use them.
+
+#pragma omp declare target
+int nsteps = 16;
+double coefficients[8] = {1, 0.5, 0.25, 0.125, 0.0625, 0.03125, 0.015625,
+                          0.0078125};
+
+template <typename T> T clamp(T x, T lo, T hi) {
+  return x < lo ? lo : (x > hi ? hi : x);
+}
+
+template <typename T> T horner(T x) {
+  T r = 0;
+  for (int i = 7; i >= 0; --i)
+    r = r * x + (T)coefficients[i];
+  return r;
+}
+
+template <typename T, int N> struct Vec {
+  T v[N];
+  T dot(const Vec &o) const {
+    T s = 0;
+    for (int i = 0; i < N; ++i)
+      s += v[i] * o.v[i];
+    return s;
+  }
+  Vec scaled(T f) const {
+    Vec r;
+    for (int i = 0; i < N; ++i)
+      r.v[i] = v[i] * f;
+    return r;
+  }
+};
+
+double integrate(double x0, double x1) {
+  double h = (x1 - x0) / nsteps, s = 0;
+  for (int i = 0; i < nsteps; ++i)
+    s += horner(x0 + (i + 0.5) * h) * h;
+  return s;
+}
+
+float smooth(float x) { return clamp(horner(x), 0.0f, 1.0f); }
+
+int collatz(int x) {
+  int steps = 0;
+  while (x > 1 && steps < 1000) {
+    x = x & 1 ? 3 * x + 1 : x / 2;
+    ++steps;
+  }
+  return steps;
+}
+#pragma omp end declare target
+
+void integrate_all(int n, double *lo, double *hi, double *out) {
+#pragma omp target teams distribute parallel for map(to : lo[:n], hi[:n]) map(from : out[:n])
+  for (int i = 0; i < n; ++i)
+    out[i] = integrate(lo[i], hi[i]);
+}
+
+void smooth_all(int n, float *x) {
+#pragma omp target teams distribute parallel for map(tofrom : x[:n])
+  for (int i = 0; i < n; ++i)
+    x[i] = smooth(x[i]);
+}
+
+float project(int n, Vec<float, 4> *v, Vec<float, 4> axis) {
+  float total = 0;
+#pragma omp target teams distribute parallel for reduction(+ : total) map(to : v[:n]) map(tofrom : total)
+  for (int i = 0; i < n; ++i)
+    total += v[i].scaled(2.0f).dot(axis);
+  return total;
+}
+
+int longest_chain(int n) {
+  int best = 0;
+#pragma omp target teams distribute parallel for reduction(max : best) map(tofrom : best)
+  for (int i = 1; i < n; ++i) {
+    int s = collatz(i);
+    best = s > best ? s : best;
+  }
+  return best;
+}
@@ -0,0 +1,80 @@
+// Target regions in generic mode: sequential code around nested parallel
+// regions, which needs the worker state machine and data sharing between
+// the master and the workers.
+
+void update_rows(int n, int m, float *a, float *norms) {
+#pragma omp target teams distribute map(tofrom : a[:n * m]) map(from : norms[:n])
+  for (int i = 0; i < n; ++i) {
+    float norm = 0;
+    float *row = &a[i * m];
+#pragma omp parallel for reduction(+ : norm)
+    for (int j = 0; j < m; ++j)
+      norm += row[j] * row[j];
+    norms[i] = norm;
+    if (norm > 0) {
+#pragma omp parallel for
+      for (int j = 0; j < m; ++j)
+        row[j] /= norm;
+    }
+  }
+}
+
+int count_positive(int n, int *v) {
+  int total = 0;
+#pragma omp target map(to : v[:n]) map(tofrom : total)
+  {
+    int local[4] = {0, 0, 0, 0};
+#pragma omp parallel num_threads(4)
+    {
+#pragma omp for
+      for (int i = 0; i < n; ++i)
+        if (v[i] > 0)
+          local[i % 4]++;
+    }
+    total = local[0] + local[1] + local[2] + local[3];
+  }
+  return total;
+}
+
+void phases(int n, double *x, double *y) {
+#pragma omp target map(tofrom : x[:n], y[:n])
+  {
+    double shift = x[0];
+#pragma omp parallel for
+    for (int i = 0; i < n; ++i)
+      x[i] -= shift;
+#pragma omp parallel for firstprivate(shift)
+    for (int i = 0; i < n; ++i)
+      y[i] += x[i] * shift;
+#pragma omp parallel
+    {
+#pragma omp single
+      y[0] = shift;
+    }
+  }
+}
+
+struct Particle {
+  double x, y, z;
+  double vx, vy, vz;
+};
+
+void advance(int n, Particle *p, double dt) {
+#pragma omp target teams map(tofrom : p[:n])
+  {
+    double scale = dt;
+#pragma omp distribute
+    for (int i = 0; i < n; ++i) {
+      Particle q = p[i];
+#pragma omp parallel sections firstprivate(q)
+      {
+#pragma omp section
+        p[i].x = q.x + scale * q.vx;
+#pragma omp section
+        p[i].y = q.y + scale * q.vy;
+#pragma omp section
+        p[i].z = q.z + scale * q.vz;
+      }
+    }
+  }
+}
@@ -0,0 +1,81 @@
+// Reductions across threads and teams, over several variables and types
+// at once, which are the most expensive constructs to generate on the
+// device.
+
+double dot(int n, double *x, double *y) {
+  double sum = 0;
+#pragma omp target teams distribute parallel for reduction(+ : sum) map(to : x[:n], y[:n]) map(tofrom : sum)
+  for (int i = 0; i < n; ++i)
+    sum += x[i] * y[i];
+  return sum;
+}
+
+void stats(int n, float *v, float *out) {
+  float lo = v[0], hi = v[0], sum = 0;
+  double sq = 0;
+  int count = 0;
+  long neg = 0;
+#pragma omp target teams distribute parallel for map(to : v[:n]) map(tofrom : lo, hi, sum, sq, count, neg) \
+    reduction(min : lo) reduction(max : hi) reduction(+ : sum, sq, count) reduction(+ : neg)
+  for (int i = 0; i < n; ++i) {
+    float x = v[i];
+    lo = x < lo ? x : lo;
+    hi = x > hi ? x : hi;
+    sum += x;
+    sq += (double)x * x;
+    count += x != 0;
+    neg += x < 0;
+  }
+  out[0] = lo;
+  out[1] = hi;
+  out[2] = sum;
+  out[3] = sq;
+  out[4] = count;
+  out[5] = neg;
+}
+
+int all_and_any(int n, int *v) {
+  int all = 1, any = 0, bits = 0, mask = ~0, parity = 0;
+#pragma omp target teams distribute parallel for map(to : v[:n]) map(tofrom : all, any, bits, mask, parity) \
+    reduction(&& : all) reduction(|| : any) reduction(| : bits) reduction(& : mask) reduction(^ : parity)
+  for (int i = 0; i < n; ++i) {
+    all = all && v[i];
+    any = any || v[i];
+    bits |= v[i];
+    mask &= v[i];
+    parity ^= v[i];
+  }
+  return all + any + bits + mask + parity;
+}
+
+double nested(int n, int m, double *a) {
+  double total = 0;
+#pragma omp target teams distribute reduction(+ : total) map(to : a[:n * m]) map(tofrom : total)
+  for (int i = 0; i < n; ++i) {
+    double row = 0;
+#pragma omp parallel for reduction(+ : row)
+    for (int j = 0; j < m; ++j)
+      row += a[i * m + j];
+    total += row;
+  }
+  return total;
+}
+
+void histogram(int n, int *keys, int *bins) {
+#pragma omp target teams distribute parallel for map(to : keys[:n]) map(tofrom : bins[:16])
+  for (int i = 0; i < n; ++i) {
+#pragma omp atomic
+    bins[keys[i] & 15]++;
+  }
+}
+
+double guarded(int n, double *x) {
+  double maxv = 0;
+#pragma omp target parallel for map(to : x[:n]) map(tofrom : maxv)
+  for (int i = 0; i < n; ++i) {
+#pragma omp critical
+    if (x[i] > maxv)
+      maxv = x[i];
+  }
+  return maxv;
+}
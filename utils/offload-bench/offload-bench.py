@@ -0,0 +1,281 @@
+#!/usr/bin/env python
+#===- offload-bench.py - OpenMP offloading compile benchmarks -*- python -*-===#
+#
+#                     The LLVM Compiler Infrastructure
+#
+# This file is distributed under the University of Illinois Open Source
+# License. See LICENSE.TXT for details.
+#
+#===------------------------------------------------------------------------===#
+
+"""Measures how long clang takes to compile OpenMP offloading code.
+
+Every input is compiled in the three steps the driver runs for it: the host
+frontend, which writes the host IR; the nvptx64 device compilation, which
+reads the host IR and writes PTX; and the host backend. Each step runs
+-cc1 directly, so that the driver and the tools it would run afterwards
+are not measured, and reports the phases of the frontend timers.
+
+The results are printed as a table and, with --output, written in JSON so
+that a later run can compare against them with --baseline.
+"""
+
+from __future__ import print_function
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+
+DEVICE_TRIPLE = 'nvptx64-nvidia-cuda'
+
+# A row of a timer report: the times with their percentages, the memory
+# used when it is tracked, and the name of the timer.
+TIMER_ROW = re.compile(r'^\s*((?:\d+\.\d+\s+\(\s*\d+\.\d+%\)\s+)+)'
+                       r'(?:\d+\s+)?(\S.*?)\s*$')
+TIMER_TOTAL = re.compile(r'Total Execution Time: .*\((\d+\.\d+) wall clock\)')
+TIMER_SEPARATOR = re.compile(r'^===-+===$')
+
+PTXAS_ENTRY = re.compile(r"Compiling entry function '([^']+)'")
+PTXAS_USAGE = re.compile(r'Used (\d+) registers(?:, (\d+) bytes smem)?')
+
+
+def parse_timers(report):
+  """Returns the wall time of every timer in a -ftime-report output, by
+  '<group>: <timer>', and the wall time of every group, by '<group>'."""
+  timers = {}
+  group = None
+  lines = report.splitlines()
+  for i, line in enumerate(lines):
+    if TIMER_SEPARATOR.match(line.strip()):
+      # The title of a group is between two separators.
+      if i + 2 < len(lines) and TIMER_SEPARATOR.match(lines[i + 2].strip()):
+        group = lines[i + 1].strip()
+      continue
+    if group is None:
+      continue
+    m = TIMER_TOTAL.search(line)
+    if m:
+      timers[group] = timers.get(group, 0.0) + float(m.group(1))
+      continue
+    m = TIMER_ROW.match(line)
+    if m and m.group(2) != 'Total':
+      # The wall time is always the last of the times.
+      wall = float(re.findall(r'(\d+\.\d+)\s+\(', m.group(1))[-1])
+      key = '%s: %s' % (group, m.group(2))
+      timers[key] = timers.get(key, 0.0) + wall
+  return timers
+
+
+def ptx_stats(path):
+  """Returns the size of a PTX file, its number of instructions and its
+  kernels."""
+  instructions = 0
+  kernels = []
+  with open(path) as f:
+    for line in f:
+      line = line.strip()
+      if line.startswith('.visible .entry') or line.startswith('.entry') or \
+         line.startswith('.weak .entry'):
+        kernels.append(re.split(r'[\s(]+', line.split('.entry', 1)[1])[1])
+      elif line.endswith(';') and not line.startswith('.') and \
+           not line.startswith('//'):
+        instructions += 1
+  return {'bytes': os.path.getsize(path), 'instructions': instructions,
+          'kernels': dict((k, {}) for k in kernels)}
+
+
+def run(cmd, verbose):
+  if verbose:
+    print(' '.join(cmd), file=sys.stderr)
+  p = subprocess.Popen(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                       universal_newlines=True)
+  out, err = p.communicate()
+  if p.returncode != 0:
+    raise RuntimeError('command failed: %s\n%s%s' % (' '.join(cmd), out, err))
+  return err
+
+
+def compile_input(opts, path):
+  """Compiles one input and returns its steps with their timers, and the
+  statistics of its PTX."""
+  name = os.path.splitext(os.path.basename(path))[0]
+  host_bc = os.path.join(opts.work_dir, name + '-host.bc')
+  device_s = os.path.join(opts.work_dir, name + '-' + DEVICE_TRIPLE + '.s')
+  host_o = os.path.join(opts.work_dir, name + '-host.o')
+
+  common = [opts.clang, '-cc1', '-fopenmp',
+            '-fopenmp-targets=' + DEVICE_TRIPLE, '-x', 'c++', '-std=c++11',
+            '-O%s' % opts.opt_level, '-ftime-report'] + opts.cc1_args
+  steps = [
+      ('host', common + ['-triple', opts.host_triple, '-emit-llvm-bc',
+                         '-o', host_bc, path]),
+      ('device', common + ['-triple', DEVICE_TRIPLE,
+                           '-aux-triple', opts.host_triple,
+                           '-target-cpu', opts.gpu_arch,
+                           '-fopenmp-is-device',
+                           '-fopenmp-host-ir-file-path', host_bc, '-S',
+                           '-o', device_s, path] + opts.device_cc1_args),
+      ('host-backend', [opts.clang, '-cc1', '-triple', opts.host_triple,
+                        '-x', 'ir', '-O%s' % opts.opt_level,
+                        '-ftime-report', '-emit-obj', '-o', host_o, host_bc]),
+  ]
+
+  result = {}
+  for step, cmd in steps:
+    best = None
+    for _ in range(opts.repeat):
+      timers = parse_timers(run(cmd, opts.verbose))
+      if best is None:
+        best = timers
+      else:
+        for key, value in timers.items():
+          best[key] = min(best.get(key, value), value)
+    result[step] = best
+
+  ptx = ptx_stats(device_s)
+  if opts.ptxas:
+    report = run([opts.ptxas, '-c', '-v', '-arch', opts.gpu_arch,
+                  '-o', os.path.join(opts.work_dir, name + '.cubin'),
+                  device_s], opts.verbose)
+    kernel = None
+    for line in report.splitlines():
+      m = PTXAS_ENTRY.search(line)
+      if m:
+        kernel = m.group(1)
+        continue
+      m = PTXAS_USAGE.search(line)
+      if m and kernel is not None:
+        ptx['kernels'].setdefault(kernel, {})['registers'] = int(m.group(1))
+        ptx['kernels'][kernel]['smem'] = int(m.group(2) or 0)
+        kernel = None
+  result['ptx'] = ptx
+  return result
+
+
+def step_time(step):
+  # The front-end timer runs for the whole action, so the other timers are
+  # nested in it.
+  return step.get('Clang front-end time report', 0.0)
+
+
+def print_results(results, baseline):
+  def change(new, old):
+    if old is None:
+      return ''
+    if old == 0:
+      return '      n/a'
+    return '%+8.1f%%' % ((new - old) * 100.0 / old)
+
+  def lookup(*keys):
+    value = baseline
+    for key in keys:
+      if not isinstance(value, dict) or key not in value:
+        return None
+      value = value[key]
+    return value
+
+  for name in sorted(results):
+    print('%s:' % name)
+    result = results[name]
+    for step in ('host', 'device', 'host-backend'):
+      old = lookup(name, step)
+      print('  %-14s %10.4fs%s' % (step, step_time(result[step]),
+                                   change(step_time(result[step]),
+                                          None if old is None else
+                                          step_time(old))))
+      for key in sorted(result[step]):
+        if ': ' in key:
+          print('    %-58s %10.4fs%s' % (key[:58], result[step][key],
+                                         change(result[step][key],
+                                                lookup(name, step, key))))
+    ptx = result['ptx']
+    print('  %-14s %10d bytes%s' % ('ptx', ptx['bytes'],
+                                    change(ptx['bytes'],
+                                           lookup(name, 'ptx', 'bytes'))))
+    print('  %-14s %10d%s' % ('instructions', ptx['instructions'],
+                              change(ptx['instructions'],
+                                     lookup(name, 'ptx', 'instructions'))))
+    for kernel in sorted(ptx['kernels']):
+      usage = ptx['kernels'][kernel]
+      if 'registers' in usage:
+        print('    %-58s %4d regs %6d smem%s' % (
+            kernel[:58], usage['registers'], usage['smem'],
+            change(usage['registers'],
+                   lookup(name, 'ptx', 'kernels', kernel, 'registers'))))
+      else:
+        print('    %s' % kernel)
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__,
+      formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('--clang', required=True, help='clang to benchmark')
+  parser.add_argument('--host-triple', default='x86_64-unknown-linux-gnu',
+                      help='triple of the host compilations')
+  parser.add_argument('--gpu-arch', default='sm_35',
+                      help='GPU the device code is compiled for')
+  parser.add_argument('-O', dest='opt_level', default='2',
+                      help='optimization level (default 2)')
+  parser.add_argument('--repeat', type=int, default=3,
+                      help='number of runs of every step; the fastest time '
+                           'of every timer is kept (default 3)')
+  parser.add_argument('--cc1-arg', dest='cc1_args', action='append',
+                      default=[], help='extra argument of every frontend '
+                                       'compilation')
+  parser.add_argument('--device-cc1-arg', dest='device_cc1_args',
+                      action='append', default=[],
+                      help='extra argument of the device compilations, '
+                           'such as the device runtime to link')
+  parser.add_argument('--ptxas', help='ptxas to read the register and '
+                                      'shared memory usage of the kernels')
+  parser.add_argument('--work-dir', default='.',
+                      help='directory of the compiled files')
+  parser.add_argument('--output', help='file to write the results to')
+  parser.add_argument('--baseline', help='results of an earlier run to '
+                                         'compare against')
+  parser.add_argument('-v', '--verbose', action='store_true',
+                      help='print the commands that are run')
+  parser.add_argument('inputs', nargs='+',
+                      help='inputs, or directories of inputs')
+  opts = parser.parse_args()
+
+  if opts.repeat < 1:
+    parser.error('--repeat must be at least 1')
+
+  inputs = []
+  for path in opts.inputs:
+    if os.path.isdir(path):
+      inputs.extend(os.path.join(path, f) for f in sorted(os.listdir(path))
+                    if f.endswith(('.c', '.cpp')))
+    else:
+      inputs.append(path)
+
+  baseline = None
+  if opts.baseline:
+    with open(opts.baseline) as f:
+      baseline = json.load(f)
+
+  if not os.path.isdir(opts.work_dir):
+    os.makedirs(opts.work_dir)
+
+  results = {}
+  try:
+    for path in inputs:
+      results[os.path.splitext(os.path.basename(path))[0]] = \
+          compile_input(opts, path)
+  except RuntimeError as e:
+    print('error: %s' % e, file=sys.stderr)
+    return 1
+
+  print_results(results, baseline)
+  if opts.output:
+    with open(opts.output, 'w') as f:
+      json.dump(results, f, indent=2, sort_keys=True)
+  return 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())